@@ -28,12 +28,21 @@
 # Path to SimConnect SDK. SimConnect support will be omitted in build if not set.
 # Example: "C:\Program Files (x86)\Microsoft Games\Microsoft Flight Simulator X SDK\SDK\Core Utilities Kit\SimConnect SDK"
 #
+# ATOOLS_SQLITE_PATH
+# Optional. Path to SQLite containing "include" and "lib" folders. Enables native SQLite access in SqlNativeQuery.
+# Has to be the same SQLite library as used by the Qt SQLite driver, i.e. Qt has to be built with system SQLite.
+# Example: "/usr"
+#
 # DEPLOY_BASE
 # Optional. Target folder for "make deploy". Default is "../deploy" plus project name ($$TARGET_NAME).
 #
 # ATOOLS_QUIET
 # Optional. Set this to "true" to avoid qmake messages.
 #
+# ATOOLS_TRACING
+# Optional. Set this to "true" to compile in span tracing which can be exported as Chrome trace JSON.
+# Recording has to be enabled at runtime too. See src/util/tracing.h.
+#
 # ATOOLS_NO_FS
 # Optional. Set this to "true" to omit all flight simulator code except "weather" and "sc" if not needed.
 # Reduces compilation time.
@@ -89,6 +98,8 @@ ATOOLS_NO_WEB=$$(ATOOLS_NO_WEB)
 ATOOLS_NO_FS=$$(ATOOLS_NO_FS)
 ATOOLS_NO_GRIB=$$(ATOOLS_NO_GRIB)
 ATOOLS_NO_WMM=$$(ATOOLS_NO_WMM)
+ATOOLS_SQLITE_PATH=$$(ATOOLS_SQLITE_PATH)
+ATOOLS_TRACING=$$(ATOOLS_TRACING)
 
 !isEqual(ATOOLS_NO_GUI, "true"): QT += svg widgets
 isEqual(ATOOLS_NO_GUI, "true"): QT -= gui
@@ -141,6 +152,14 @@ isEmpty(GIT_PATH) {
   GIT_REVISION_FULL=$$system('$$GIT_PATH' rev-parse HEAD)
 }
 
+!isEmpty(ATOOLS_SQLITE_PATH) {
+  DEFINES += ATOOLS_SQLITE_NATIVE
+  INCLUDEPATH += $$ATOOLS_SQLITE_PATH/include
+  LIBS += -L$$ATOOLS_SQLITE_PATH/lib -lsqlite3
+}
+
+isEqual(ATOOLS_TRACING, "true"): DEFINES += ATOOLS_TRACING
+
 DEFINES += VERSION_NUMBER_ATOOLS='\\"$$VERSION_NUMBER\\"'
 DEFINES += GIT_REVISION_ATOOLS='\\"$$GIT_REVISION\\"'
 DEFINES += QT_NO_CAST_FROM_BYTEARRAY
@@ -181,6 +200,8 @@ message(ATOOLS_NO_WEB: $$ATOOLS_NO_WEB)
 message(ATOOLS_NO_FS: $$ATOOLS_NO_FS)
 message(ATOOLS_NO_GRIB: $$ATOOLS_NO_GRIB)
 message(ATOOLS_NO_WMM: $$ATOOLS_NO_WMM)
+message(ATOOLS_SQLITE_PATH: $$ATOOLS_SQLITE_PATH)
+message(ATOOLS_TRACING: $$ATOOLS_TRACING)
 message(SIMCONNECT_PATH_WIN32: $$SIMCONNECT_PATH_WIN32)
 message(SIMCONNECT_PATH_WIN64: $$SIMCONNECT_PATH_WIN64)
 message(DEFINES: $$DEFINES)
@@ -207,9 +228,11 @@ HEADERS += \
   src/fs/navdatabaseflags.h \
   src/fs/sc/connecthandler.h \
   src/fs/sc/datareaderthread.h \
+  src/fs/sc/replayfile.h \
   src/fs/sc/simconnectaircraft.h \
   src/fs/sc/simconnectapi.h \
   src/fs/sc/simconnectdata.h \
+  src/fs/sc/simconnectdatabuffer.h \
   src/fs/sc/simconnectdatabase.h \
   src/fs/sc/simconnectdummy.h \
   src/fs/sc/simconnecthandler.h \
@@ -217,52 +240,80 @@ HEADERS += \
   src/fs/sc/simconnecttypes.h \
   src/fs/sc/simconnectuseraircraft.h \
   src/fs/sc/weatherrequest.h \
+  src/fs/sc/weatherrequestbroker.h \
   src/fs/sc/xpconnecthandler.h \
+  src/fs/sc/xpconnectring.h \
   src/fs/scenery/aircraftindex.h \
   src/fs/util/coordinates.h \
   src/fs/util/fsutil.h \
   src/fs/util/morsecode.h \
   src/fs/util/tacanfrequencies.h \
   src/geo/calculations.h \
+  src/geo/cartesianpos.h \
+  src/geo/fastmath.h \
   src/geo/line.h \
   src/geo/linestring.h \
   src/geo/nanoflann.h \
   src/geo/point3d.h \
   src/geo/pos.h \
   src/geo/rect.h \
+  src/geo/rtree.h \
+  src/geo/spatialgrid.h \
   src/geo/spatialindex.h \
   src/gui/consoleapplication.h \
   src/io/abstractinireader.h \
   src/io/binarystream.h \
   src/io/binaryutil.h \
+  src/io/fastinireader.h \
+  src/io/filereadahead.h \
   src/io/fileroller.h \
   src/io/inireader.h \
+  src/io/linereader.h \
   src/io/tempfile.h \
   src/json/nlohmann/json.hpp \
   src/logging/loggingconfig.h \
   src/logging/loggingguiabort.h \
   src/logging/logginghandler.h \
+  src/logging/loggingratelimiter.h \
   src/logging/loggingtypes.h \
   src/logging/loggingutil.h \
+  src/logging/loggingwriter.h \
   src/settings/settings.h \
+  src/settings/settingswriter.h \
+  src/util/arena.h \
+  src/util/asyncpipeline.h \
   src/util/average.h \
   src/util/contextsaver.h \
+  src/util/csvbulkreader.h \
   src/util/csvreader.h \
+  src/util/downloadscheduler.h \
   src/util/filechecker.h \
   src/util/filesystemwatcher.h \
   src/util/flags.h \
   src/util/heap.h \
+  src/util/hotswap.h \
   src/util/httpdownloader.h \
+  src/util/identkey.h \
+  src/util/jsonstreamreader.h \
+  src/util/memoryaccounting.h \
+  src/util/metrics.h \
+  src/util/microbenchmark.h \
+  src/util/openhash.h \
+  src/util/parallel.h \
   src/util/properties.h \
   src/util/props.h \
   src/util/simplecrypt.h \
+  src/util/startupscheduler.h \
   src/util/str.h \
+  src/util/stringinterner.h \
   src/util/timedcache.h \
+  src/util/tracing.h \
   src/util/updatecheck.h \
   src/util/version.h \
   src/util/xmlstream.h \
   src/win/activationcontext.h \
   src/zip/gzip.h \
+  src/zip/gzipdevice.h \
   src/zip/zipreader.h \
   src/zip/zipwriter.h \
   src/zlib/crc32.h \
@@ -286,9 +337,11 @@ SOURCES += \
   src/fs/navdatabaseflags.cpp \
   src/fs/sc/connecthandler.cpp \
   src/fs/sc/datareaderthread.cpp \
+  src/fs/sc/replayfile.cpp \
   src/fs/sc/simconnectaircraft.cpp \
   src/fs/sc/simconnectapi.cpp \
   src/fs/sc/simconnectdata.cpp \
+  src/fs/sc/simconnectdatabuffer.cpp \
   src/fs/sc/simconnectdatabase.cpp \
   src/fs/sc/simconnectdummy.cpp \
   src/fs/sc/simconnecthandler.cpp \
@@ -296,49 +349,74 @@ SOURCES += \
   src/fs/sc/simconnecttypes.cpp \
   src/fs/sc/simconnectuseraircraft.cpp \
   src/fs/sc/weatherrequest.cpp \
+  src/fs/sc/weatherrequestbroker.cpp \
   src/fs/sc/xpconnecthandler.cpp \
+  src/fs/sc/xpconnectring.cpp \
   src/fs/scenery/aircraftindex.cpp \
   src/fs/util/coordinates.cpp \
   src/fs/util/fsutil.cpp \
   src/fs/util/morsecode.cpp \
   src/fs/util/tacanfrequencies.cpp \
   src/geo/calculations.cpp \
+  src/geo/cartesianpos.cpp \
   src/geo/line.cpp \
   src/geo/linestring.cpp \
   src/geo/point3d.cpp \
   src/geo/pos.cpp \
   src/geo/rect.cpp \
+  src/geo/rtree.cpp \
+  src/geo/spatialgrid.cpp \
   src/geo/spatialindex.cpp \
   src/gui/consoleapplication.cpp \
   src/io/abstractinireader.cpp \
   src/io/binarystream.cpp \
   src/io/binaryutil.cpp \
+  src/io/fastinireader.cpp \
+  src/io/filereadahead.cpp \
   src/io/fileroller.cpp \
   src/io/inireader.cpp \
+  src/io/linereader.cpp \
   src/io/tempfile.cpp \
   src/logging/loggingconfig.cpp \
   src/logging/loggingguiabort.cpp \
   src/logging/logginghandler.cpp \
+  src/logging/loggingratelimiter.cpp \
   src/logging/loggingutil.cpp \
+  src/logging/loggingwriter.cpp \
   src/settings/settings.cpp \
+  src/settings/settingswriter.cpp \
+  src/util/arena.cpp \
   src/util/average.cpp \
   src/util/contextsaver.cpp \
+  src/util/csvbulkreader.cpp \
   src/util/csvreader.cpp \
+  src/util/downloadscheduler.cpp \
   src/util/filechecker.cpp \
   src/util/filesystemwatcher.cpp \
   src/util/flags.cpp \
   src/util/heap.cpp \
   src/util/httpdownloader.cpp \
+  src/util/identkey.cpp \
+  src/util/jsonstreamreader.cpp \
+  src/util/memoryaccounting.cpp \
+  src/util/metrics.cpp \
+  src/util/microbenchmark.cpp \
+  src/util/openhash.cpp \
+  src/util/parallel.cpp \
   src/util/properties.cpp \
   src/util/props.cpp \
   src/util/simplecrypt.cpp \
+  src/util/startupscheduler.cpp \
   src/util/str.cpp \
+  src/util/stringinterner.cpp \
   src/util/timedcache.cpp \
+  src/util/tracing.cpp \
   src/util/updatecheck.cpp \
   src/util/version.cpp \
   src/util/xmlstream.cpp \
   src/win/activationcontext.cpp \
   src/zip/gzip.cpp \
+  src/zip/gzipdevice.cpp \
   src/zip/zip.cpp \
   src/zlib/adler32.c \
   src/zlib/compress.c \
@@ -376,25 +454,45 @@ SOURCES += \
 
 !isEqual(ATOOLS_NO_SQL, "true") {
 HEADERS += \
+  src/sql/databaseswap.h \
+  src/sql/sqlbulkinsert.h \
   src/sql/sqlcolumn.h \
   src/sql/sqldatabase.h \
+  src/sql/sqldatabasepool.h \
   src/sql/sqlexception.h \
   src/sql/sqlexport.h \
+  src/sql/sqlexportstream.h \
+  src/sql/sqlnativequery.h \
+  src/sql/sqlpagecompression.h \
+  src/sql/sqlprofiler.h \
   src/sql/sqlquery.h \
   src/sql/sqlrecord.h \
+  src/sql/sqlreportrunner.h \
+  src/sql/sqlresultset.h \
   src/sql/sqlscript.h \
+  src/sql/sqlstatementcache.h \
   src/sql/sqltransaction.h \
   src/sql/sqltypes.h \
   src/sql/sqlutil.h
 
 SOURCES += \
+  src/sql/databaseswap.cpp \
+  src/sql/sqlbulkinsert.cpp \
   src/sql/sqlcolumn.cpp \
   src/sql/sqldatabase.cpp \
+  src/sql/sqldatabasepool.cpp \
   src/sql/sqlexception.cpp \
   src/sql/sqlexport.cpp \
+  src/sql/sqlexportstream.cpp \
+  src/sql/sqlnativequery.cpp \
+  src/sql/sqlpagecompression.cpp \
+  src/sql/sqlprofiler.cpp \
   src/sql/sqlquery.cpp \
   src/sql/sqlrecord.cpp \
+  src/sql/sqlreportrunner.cpp \
+  src/sql/sqlresultset.cpp \
   src/sql/sqlscript.cpp \
+  src/sql/sqlstatementcache.cpp \
   src/sql/sqltransaction.cpp \
   src/sql/sqlutil.cpp
 } # ATOOLS_NO_SQL
@@ -527,14 +625,18 @@ SOURCES += \
 
 !isEqual(ATOOLS_NO_ROUTING, "true") {
 HEADERS += \
+src/routing/routelandmarks.h \
 src/routing/routenetwork.h \
 src/routing/routenetworkloader.h \
-src/routing/routenetworktypes.h
+src/routing/routenetworktypes.h \
+src/routing/routewindcosts.h
 
 SOURCES += \
+src/routing/routelandmarks.cpp \
 src/routing/routenetwork.cpp \
 src/routing/routenetworkloader.cpp \
-src/routing/routenetworktypes.cpp
+src/routing/routenetworktypes.cpp \
+src/routing/routewindcosts.cpp
 } # ATOOLS_NO_ROUTING
 
 # =====================================================================
@@ -545,6 +647,7 @@ HEADERS += \
   src/httpserver/httpconnectionhandler.h \
   src/httpserver/httpconnectionhandlerpool.h \
   src/httpserver/httpcookie.h \
+  src/httpserver/httpeventstream.h \
   src/httpserver/httpglobal.h \
   src/httpserver/httplistener.h \
   src/httpserver/httprequest.h \
@@ -552,7 +655,11 @@ HEADERS += \
   src/httpserver/httpresponse.h \
   src/httpserver/httpsession.h \
   src/httpserver/httpsessionstore.h \
+  src/httpserver/metricscontroller.h \
+  src/httpserver/sharedcache.h \
   src/httpserver/staticfilecontroller.h \
+  src/httpserver/timerwheel.h \
+  src/templateengine/compiledtemplate.h \
   src/templateengine/template.h \
   src/templateengine/templatecache.h \
   src/templateengine/templateglobal.h \
@@ -562,6 +669,7 @@ SOURCES += \
   src/httpserver/httpconnectionhandler.cpp \
   src/httpserver/httpconnectionhandlerpool.cpp \
   src/httpserver/httpcookie.cpp \
+  src/httpserver/httpeventstream.cpp \
   src/httpserver/httpglobal.cpp \
   src/httpserver/httplistener.cpp \
   src/httpserver/httprequest.cpp \
@@ -569,7 +677,9 @@ SOURCES += \
   src/httpserver/httpresponse.cpp \
   src/httpserver/httpsession.cpp \
   src/httpserver/httpsessionstore.cpp \
+  src/httpserver/metricscontroller.cpp \
   src/httpserver/staticfilecontroller.cpp \
+  src/templateengine/compiledtemplate.cpp \
   src/templateengine/template.cpp \
   src/templateengine/templatecache.cpp \
   src/templateengine/templateloader.cpp
@@ -625,6 +735,7 @@ HEADERS += \
   src/fs/bgl/nav/waypoint.h \
   src/fs/bgl/nl/namelist.h \
   src/fs/bgl/nl/namelistentry.h \
+  src/fs/bgl/nl/namelistpool.h \
   src/fs/bgl/record.h \
   src/fs/bgl/recordtypes.h \
   src/fs/bgl/section.h \
@@ -632,15 +743,25 @@ HEADERS += \
   src/fs/bgl/subsection.h \
   src/fs/bgl/surface.h \
   src/fs/bgl/util.h \
+  src/fs/common/airportgroundindex.h \
   src/fs/common/airportindex.h \
+  src/fs/common/airspaceindex.h \
   src/fs/common/binarygeometry.h \
   src/fs/common/binarymsageometry.h \
   src/fs/common/globereader.h \
   src/fs/common/magdecreader.h \
   src/fs/common/metadatawriter.h \
   src/fs/common/morareader.h \
+  src/fs/common/navdatafile.h \
+  src/fs/common/navdatafilewriter.h \
+  src/fs/common/navsearchindex.h \
+  src/fs/common/pavementmesh.h \
   src/fs/common/procedurewriter.h \
+  src/fs/common/routeprofileengine.h \
+  src/fs/common/taxigraph.h \
   src/fs/common/xpgeometry.h \
+  src/fs/compilebenchmark.h \
+  src/fs/compileprofiler.h \
   src/fs/db/airwayresolver.h \
   src/fs/db/ap/airportfilewriter.h \
   src/fs/db/ap/airportwriter.h \
@@ -662,6 +783,8 @@ HEADERS += \
   src/fs/db/ap/taxipathwriter.h \
   src/fs/db/ap/transitionlegwriter.h \
   src/fs/db/ap/transitionwriter.h \
+  src/fs/db/apronmeshwriter.h \
+  src/fs/db/bglreadahead.h \
   src/fs/db/databasemeta.h \
   src/fs/db/datawriter.h \
   src/fs/db/meta/bglfilewriter.h \
@@ -674,19 +797,27 @@ HEADERS += \
   src/fs/db/nav/tacanwriter.h \
   src/fs/db/nav/vorwriter.h \
   src/fs/db/nav/waypointwriter.h \
+  src/fs/db/navdatabasedelta.h \
+  src/fs/db/navdatacache.h \
+  src/fs/db/postloadupdater.h \
+  src/fs/db/proceduregeometrywriter.h \
   src/fs/db/routeedgewriter.h \
   src/fs/db/runwayindex.h \
+  src/fs/db/spatialorderwriter.h \
+  src/fs/db/taxigraphwriter.h \
   src/fs/db/writerbase.h \
   src/fs/db/writerbasebasic.h \
   src/fs/dfd/dfdcompiler.h \
   src/fs/fspaths.h \
   src/fs/navdatabase.h \
+  src/fs/navdatabasebatch.h \
   src/fs/navdatabaseerrors.h \
   src/fs/navdatabaseoptions.h \
   src/fs/navdatabaseprogress.h \
   src/fs/ns/navserver.h \
   src/fs/ns/navservercommon.h \
   src/fs/ns/navserverworker.h \
+  src/fs/online/onlineclientstore.h \
   src/fs/online/onlinedatamanager.h \
   src/fs/online/onlinetypes.h \
   src/fs/online/statustextparser.h \
@@ -694,25 +825,30 @@ HEADERS += \
   src/fs/perf/aircraftperf.h \
   src/fs/perf/aircraftperfconstants.h \
   src/fs/perf/aircraftperfhandler.h \
+  src/fs/perf/aircraftperfprofile.h \
   src/fs/pln/flightplan.h \
   src/fs/pln/flightplanconstants.h \
   src/fs/pln/flightplanentry.h \
   src/fs/pln/flightplanio.h \
+  src/fs/primitivebenchmark.h \
   src/fs/progresshandler.h \
   src/fs/scenery/addoncfg.h \
   src/fs/scenery/addoncomponent.h \
   src/fs/scenery/addonpackage.h \
   src/fs/scenery/contentxml.h \
   src/fs/scenery/fileresolver.h \
+  src/fs/scenery/fileresolvercache.h \
   src/fs/scenery/languagejson.h \
   src/fs/scenery/layoutjson.h \
   src/fs/scenery/manifestjson.h \
   src/fs/scenery/materiallib.h \
+  src/fs/scenery/parsecache.h \
   src/fs/scenery/sceneryarea.h \
   src/fs/scenery/scenerycfg.h \
   src/fs/userdata/airspacereaderbase.h \
   src/fs/userdata/airspacereaderivao.h \
   src/fs/userdata/airspacereaderopenair.h \
+  src/fs/userdata/airspacereaderparallel.h \
   src/fs/userdata/airspacereadervatsim.h \
   src/fs/xp/airwaypostprocess.h \
   src/fs/xp/scenerypacks.h \
@@ -725,12 +861,17 @@ HEADERS += \
   src/fs/xp/xpdatacompiler.h \
   src/fs/xp/xpfixwriter.h \
   src/fs/xp/xpholdingwriter.h \
+  src/fs/xp/xplinetokenizer.h \
   src/fs/xp/xpmorawriter.h \
   src/fs/xp/xpnavwriter.h \
   src/fs/xp/xpwriter.h \
+  src/grib/windforecast.h \
+  src/grib/windgrid.h \
   src/grib/windquery.h \
   src/grib/windtypes.h \
-  src/routing/routefinder.h
+  src/routing/routebenchmark.h \
+  src/routing/routefinder.h \
+  src/routing/routematrix.h
 
 SOURCES += \
   src/fs/bgl/ap/airport.cpp \
@@ -778,6 +919,7 @@ SOURCES += \
   src/fs/bgl/nav/waypoint.cpp \
   src/fs/bgl/nl/namelist.cpp \
   src/fs/bgl/nl/namelistentry.cpp \
+  src/fs/bgl/nl/namelistpool.cpp \
   src/fs/bgl/record.cpp \
   src/fs/bgl/recordtypes.cpp \
   src/fs/bgl/section.cpp \
@@ -785,15 +927,25 @@ SOURCES += \
   src/fs/bgl/subsection.cpp \
   src/fs/bgl/surface.cpp \
   src/fs/bgl/util.cpp \
+  src/fs/common/airportgroundindex.cpp \
   src/fs/common/airportindex.cpp \
+  src/fs/common/airspaceindex.cpp \
   src/fs/common/binarygeometry.cpp \
   src/fs/common/binarymsageometry.cpp \
   src/fs/common/globereader.cpp \
   src/fs/common/magdecreader.cpp \
   src/fs/common/metadatawriter.cpp \
   src/fs/common/morareader.cpp \
+  src/fs/common/navdatafile.cpp \
+  src/fs/common/navdatafilewriter.cpp \
+  src/fs/common/navsearchindex.cpp \
+  src/fs/common/pavementmesh.cpp \
   src/fs/common/procedurewriter.cpp \
+  src/fs/common/routeprofileengine.cpp \
+  src/fs/common/taxigraph.cpp \
   src/fs/common/xpgeometry.cpp \
+  src/fs/compilebenchmark.cpp \
+  src/fs/compileprofiler.cpp \
   src/fs/db/airwayresolver.cpp \
   src/fs/db/ap/airportfilewriter.cpp \
   src/fs/db/ap/airportwriter.cpp \
@@ -815,6 +967,8 @@ SOURCES += \
   src/fs/db/ap/taxipathwriter.cpp \
   src/fs/db/ap/transitionlegwriter.cpp \
   src/fs/db/ap/transitionwriter.cpp \
+  src/fs/db/apronmeshwriter.cpp \
+  src/fs/db/bglreadahead.cpp \
   src/fs/db/databasemeta.cpp \
   src/fs/db/datawriter.cpp \
   src/fs/db/meta/bglfilewriter.cpp \
@@ -827,18 +981,26 @@ SOURCES += \
   src/fs/db/nav/tacanwriter.cpp \
   src/fs/db/nav/vorwriter.cpp \
   src/fs/db/nav/waypointwriter.cpp \
+  src/fs/db/navdatabasedelta.cpp \
+  src/fs/db/navdatacache.cpp \
+  src/fs/db/postloadupdater.cpp \
+  src/fs/db/proceduregeometrywriter.cpp \
   src/fs/db/routeedgewriter.cpp \
   src/fs/db/runwayindex.cpp \
+  src/fs/db/spatialorderwriter.cpp \
+  src/fs/db/taxigraphwriter.cpp \
   src/fs/db/writerbasebasic.cpp \
   src/fs/dfd/dfdcompiler.cpp \
   src/fs/fspaths.cpp \
   src/fs/navdatabase.cpp \
+  src/fs/navdatabasebatch.cpp \
   src/fs/navdatabaseerrors.cpp \
   src/fs/navdatabaseoptions.cpp \
   src/fs/navdatabaseprogress.cpp \
   src/fs/ns/navserver.cpp \
   src/fs/ns/navservercommon.cpp \
   src/fs/ns/navserverworker.cpp \
+  src/fs/online/onlineclientstore.cpp \
   src/fs/online/onlinedatamanager.cpp \
   src/fs/online/onlinetypes.cpp \
   src/fs/online/statustextparser.cpp \
@@ -846,25 +1008,30 @@ SOURCES += \
   src/fs/perf/aircraftperf.cpp \
   src/fs/perf/aircraftperfconstants.cpp \
   src/fs/perf/aircraftperfhandler.cpp \
+  src/fs/perf/aircraftperfprofile.cpp \
   src/fs/pln/flightplan.cpp \
   src/fs/pln/flightplanconstants.cpp \
   src/fs/pln/flightplanentry.cpp \
   src/fs/pln/flightplanio.cpp \
+  src/fs/primitivebenchmark.cpp \
   src/fs/progresshandler.cpp \
   src/fs/scenery/addoncfg.cpp \
   src/fs/scenery/addoncomponent.cpp \
   src/fs/scenery/addonpackage.cpp \
   src/fs/scenery/contentxml.cpp \
   src/fs/scenery/fileresolver.cpp \
+  src/fs/scenery/fileresolvercache.cpp \
   src/fs/scenery/languagejson.cpp \
   src/fs/scenery/layoutjson.cpp \
   src/fs/scenery/manifestjson.cpp \
   src/fs/scenery/materiallib.cpp \
+  src/fs/scenery/parsecache.cpp \
   src/fs/scenery/sceneryarea.cpp \
   src/fs/scenery/scenerycfg.cpp \
   src/fs/userdata/airspacereaderbase.cpp \
   src/fs/userdata/airspacereaderivao.cpp \
   src/fs/userdata/airspacereaderopenair.cpp \
+  src/fs/userdata/airspacereaderparallel.cpp \
   src/fs/userdata/airspacereadervatsim.cpp \
   src/fs/xp/airwaypostprocess.cpp \
   src/fs/xp/scenerypacks.cpp \
@@ -877,12 +1044,17 @@ SOURCES += \
   src/fs/xp/xpdatacompiler.cpp \
   src/fs/xp/xpfixwriter.cpp \
   src/fs/xp/xpholdingwriter.cpp \
+  src/fs/xp/xplinetokenizer.cpp \
   src/fs/xp/xpmorawriter.cpp \
   src/fs/xp/xpnavwriter.cpp \
   src/fs/xp/xpwriter.cpp \
+  src/grib/windforecast.cpp \
+  src/grib/windgrid.cpp \
   src/grib/windquery.cpp \
   src/grib/windtypes.cpp \
-  src/routing/routefinder.cpp
+  src/routing/routebenchmark.cpp \
+  src/routing/routefinder.cpp \
+  src/routing/routematrix.cpp
 } # ATOOLS_NO_FS
 
 
@@ -338,6 +338,45 @@ create index if not exists idx_taxi_path_airport_id on taxi_path(airport_id);
 
 -- **************************************************
 
+drop table if exists taxi_graph;
+
+-- Ground routing graph built from taxi paths. Only filled if enabled in the compiler options.
+-- See atools::fs::db::TaxiGraphWriter
+create table taxi_graph
+(
+  taxi_graph_id integer primary key,
+  airport_id integer not null,
+  num_nodes integer not null,
+  num_edges integer not null,       -- Number of directed edges. Each taxi path results in two edges.
+  graph blob not null,              -- atools::fs::common::TaxiGraph
+foreign key(airport_id) references airport(airport_id)
+);
+
+create index if not exists idx_taxi_graph_airport_id on taxi_graph(airport_id);
+
+-- **************************************************
+
+drop table if exists apron_mesh;
+
+-- Triangulated aprons and X-Plane pavements. Only filled if enabled in the compiler options.
+-- See atools::fs::db::ApronMeshWriter
+create table apron_mesh
+(
+  apron_mesh_id integer primary key,
+  apron_id integer not null,
+  airport_id integer not null,
+  num_vertices integer not null,
+  num_triangles integer not null,
+  mesh blob not null,               -- atools::fs::common::PavementMesh
+foreign key(apron_id) references apron(apron_id),
+foreign key(airport_id) references airport(airport_id)
+);
+
+create index if not exists idx_apron_mesh_airport_id on apron_mesh(airport_id);
+create index if not exists idx_apron_mesh_apron_id on apron_mesh(apron_id);
+
+-- **************************************************
+
 drop table if exists runway;
 
 -- Airport runway
@@ -600,6 +639,30 @@ create index if not exists idx_transition_leg_transition_id on transition_leg(tr
 
 -- **************************************************
 
+drop table if exists procedure_geometry;
+
+-- Precalculated geometry for approaches and transitions. Only filled if enabled in the compiler options.
+-- See atools::fs::db::ProcedureGeometryWriter
+create table procedure_geometry
+(
+  procedure_geometry_id integer primary key,
+  airport_id integer not null,
+  approach_id integer,              -- Either approach_id or transition_id is set
+  transition_id integer,            -- "
+  distance double not null,         -- Length of all legs excluding missed approach in NM
+  missed_distance double not null,  -- Length of missed approach legs in NM
+  geometry blob not null,           -- Points of all legs as packed atools::fs::common::BinaryGeometry
+  leg_info blob not null,           -- Leg id, index of first point and distance for each leg
+foreign key(airport_id) references airport(airport_id),
+foreign key(approach_id) references approach(approach_id),
+foreign key(transition_id) references transition(transition_id)
+);
+
+create index if not exists idx_procedure_geometry_approach_id on procedure_geometry(approach_id);
+create index if not exists idx_procedure_geometry_transition_id on procedure_geometry(transition_id);
+
+-- **************************************************
+
 drop table if exists parking;
 
 -- Parking spot. Includes fuel and vehicle parking.
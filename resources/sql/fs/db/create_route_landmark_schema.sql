@@ -0,0 +1,35 @@
+-- *****************************************************************************
+-- Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+-- ****************************************************************************/
+
+-- *************************************************************
+-- Precomputed landmark distances for the airway network as loaded
+-- by RouteNetworkLoader. Used by the route finder to get better
+-- cost estimates (ALT heuristic).
+-- *************************************************************
+
+drop table if exists route_landmark;
+
+create table route_landmark
+(
+  landmark_id integer primary key,
+  node_id integer not null,        -- Database id of the landmark node (waypoint.waypoint_id or trackpoint id)
+  node_index integer not null,     -- Index of the landmark node in the loaded network
+  num_nodes integer not null,      -- Number of nodes in the network when created
+  checksum integer not null,       -- Checksum over all node ids in network order
+  distances_from blob not null,    -- Compressed array of 32 bit distances in meter from landmark to each node
+  distances_to blob not null       -- Compressed array of 32 bit distances in meter from each node to landmark
+);
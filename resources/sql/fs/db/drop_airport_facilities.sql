@@ -24,6 +24,8 @@
 -- drop airport facilities
 drop table if exists parking;
 drop table if exists taxi_path;
+drop table if exists taxi_graph;
+drop table if exists apron_mesh;
 drop table if exists apron;
 drop table if exists start;
 drop table if exists helipad;
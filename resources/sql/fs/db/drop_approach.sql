@@ -22,6 +22,7 @@
 -- Order is important to avoid fk conflicts
 
 -- drop approach
+drop table if exists procedure_geometry;
 drop table if exists transition_leg;
 drop table if exists approach_leg;
 drop table if exists transition;
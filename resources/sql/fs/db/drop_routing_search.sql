@@ -26,5 +26,6 @@ drop table if exists route_edge_radio;
 drop table if exists route_edge_airway;
 drop table if exists route_node_radio;
 drop table if exists route_node_airway;
+drop table if exists route_landmark;
 drop table if exists nav_search;
 
@@ -41,6 +41,7 @@ CREATE TABLE undo_data
   undo_data_id integer primary key,
   undo_group_id integer not null,        -- Id for one undo changeset covering one or more updates, deletions or inserts
   undo_type varchar(1) not null,         -- U for update, I for insert and D for deletion
+  undo_columns varchar(1024),            -- Comma separated changed columns for partial updates. Null if all columns are copied
 
   -- Copy of all columns from table "logbook"
   logbook_id integer not null,
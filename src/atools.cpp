@@ -87,6 +87,33 @@ QTextCodec *codecForFile(QIODevice& file, QTextCodec *defaultCodec)
   return codec;
 }
 
+/* Read first non empty lines from stream */
+static QStringList probeStream(QTextStream& stream, int numLinesRead)
+{
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  stream.setCodec("UTF-8");
+#endif
+  stream.setAutoDetectUnicode(true);
+
+  QStringList lines;
+  int numLines = 0, numLinesTotal = 0;
+  while(!stream.atEnd() && numLines < numLinesRead && numLinesTotal < numLinesRead * 2)
+  {
+    QString line = stream.readLine(256).trimmed();
+    if(!line.isEmpty())
+    {
+      lines.append(line.toLower().simplified());
+      numLines++;
+    }
+    numLinesTotal++;
+  }
+
+  // Fill missing entries with empty strings to ease checking.
+  for(int i = lines.size(); i < 6; i++)
+    lines.append(QString());
+  return lines;
+}
+
 QStringList probeFile(const QString& file, int numLinesRead)
 {
   QFile testFile(file);
@@ -95,26 +122,7 @@ QStringList probeFile(const QString& file, int numLinesRead)
   if(testFile.open(QIODevice::ReadOnly))
   {
     QTextStream stream(&testFile);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    stream.setCodec("UTF-8");
-#endif
-    stream.setAutoDetectUnicode(true);
-
-    int numLines = 0, numLinesTotal = 0;
-    while(!stream.atEnd() && numLines < numLinesRead && numLinesTotal < numLinesRead * 2)
-    {
-      QString line = stream.readLine(256).trimmed();
-      if(!line.isEmpty())
-      {
-        lines.append(line.toLower().simplified());
-        numLines++;
-      }
-      numLinesTotal++;
-    }
-
-    // Fill missing entries with empty strings to ease checking.
-    for(int i = lines.size(); i < 6; i++)
-      lines.append(QString());
+    lines = probeStream(stream, numLinesRead);
     testFile.close();
   }
   else
@@ -123,6 +131,13 @@ QStringList probeFile(const QString& file, int numLinesRead)
   return lines;
 }
 
+QStringList probeBytes(const QByteArray& bytes, int numLinesRead)
+{
+  // Stream reads only the needed prefix of the buffer
+  QTextStream stream(bytes, QIODevice::ReadOnly);
+  return probeStream(stream, numLinesRead);
+}
+
 QString capWord(QString str)
 {
   if(!str.isEmpty())
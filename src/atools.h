@@ -243,6 +243,9 @@ QTextCodec *codecForFile(QIODevice& file, QTextCodec *defaultCodec = nullptr);
  *  All trimmed and converted to lower case. */
 QStringList probeFile(const QString& file, int numLinesRead = 6);
 
+/* Same as probeFile() but reads from the beginning of an already loaded file */
+QStringList probeBytes(const QByteArray& bytes, int numLinesRead = 6);
+
 /* Calculate the step size for an axis along a range for number of steps.
  * Steps will stick to the 1, 2, and 5 range */
 float calculateSteps(float range, float numSteps);
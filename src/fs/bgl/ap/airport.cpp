@@ -706,20 +706,20 @@ void Airport::updateSummaryFields()
   for(const Apron& a : qAsConst(aprons))
   {
     // reportFarCoordinate(s.getPosition().getPos(), "start"); // Too CPU intense
-    for(const BglPosition& p : a.getVertices())
+    for(const atools::geo::Pos& p : a.getVertices())
     {
-      reportFarCoordinate(p.getPos(), "apron");
-      boundingRect.extend(p.getPos());
+      reportFarCoordinate(p, "apron");
+      boundingRect.extend(p);
     }
   }
 
   for(const Apron2& a : qAsConst(aprons2))
   {
     // reportFarCoordinate(s.getPosition().getPos(), "start"); // Too CPU intense
-    for(const BglPosition& p : a.getVertices())
+    for(const atools::geo::Pos& p : a.getVertices())
     {
-      reportFarCoordinate(p.getPos(), "apron2");
-      boundingRect.extend(p.getPos());
+      reportFarCoordinate(p, "apron2");
+      boundingRect.extend(p);
     }
   }
 
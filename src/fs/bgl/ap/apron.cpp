@@ -54,8 +54,7 @@ Apron::Apron(const atools::fs::NavDatabaseOptions *options, atools::io::BinarySt
     bs->skip(2);
 
   if(options->isIncludedNavDbObject(type::GEOMETRY))
-    for(int i = 0; i < numVertices; i++)
-      vertices.append(BglPosition(bs));
+    BglPosition::readPositions(vertices, bs, numVertices);
 }
 
 Apron::~Apron()
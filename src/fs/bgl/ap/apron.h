@@ -21,6 +21,7 @@
 #include "fs/bgl/record.h"
 #include "fs/bgl/ap/rw/runway.h"
 #include "fs/bgl/bglposition.h"
+#include "geo/linestring.h"
 #include "fs/bgl/recordtypes.h"
 
 namespace atools {
@@ -46,7 +47,7 @@ public:
   /*
    * @return Apron boundary vertices
    */
-  const QList<atools::fs::bgl::BglPosition>& getVertices() const
+  const atools::geo::LineString& getVertices() const
   {
     return vertices;
   }
@@ -60,7 +61,7 @@ private:
   friend QDebug operator<<(QDebug out, const atools::fs::bgl::Apron& record);
 
   atools::fs::bgl::Surface surface = atools::fs::bgl::UNKNOWN;
-  QList<atools::fs::bgl::BglPosition> vertices;
+  atools::geo::LineString vertices;
   QUuid materialUuid;
 
 };
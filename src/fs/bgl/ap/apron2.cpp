@@ -49,8 +49,7 @@ Apron2::Apron2(const atools::fs::NavDatabaseOptions *options, atools::io::Binary
 
   if(options->isIncludedNavDbObject(type::GEOMETRY))
   {
-    for(int i = 0; i < numVertices; i++)
-      vertices.append(BglPosition(bs));
+    BglPosition::readPositions(vertices, bs, numVertices);
 
     for(int i = 0; i < numTriangles; i++)
     {
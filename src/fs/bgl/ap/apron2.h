@@ -21,6 +21,7 @@
 #include "fs/bgl/record.h"
 #include "fs/bgl/ap/rw/runway.h"
 #include "fs/bgl/bglposition.h"
+#include "geo/linestring.h"
 
 namespace atools {
 namespace fs {
@@ -45,7 +46,7 @@ public:
   /*
    * @return coordinate list that is used with the triangle index list
    */
-  const QList<atools::fs::bgl::BglPosition>& getVertices() const
+  const atools::geo::LineString& getVertices() const
   {
     return vertices;
   }
@@ -78,7 +79,7 @@ private:
   friend QDebug operator<<(QDebug out, const atools::fs::bgl::Apron2& record);
 
   atools::fs::bgl::Surface surface = atools::fs::bgl::UNKNOWN;
-  QList<atools::fs::bgl::BglPosition> vertices;
+  atools::geo::LineString vertices;
   QList<int> triangles;
 
   bool drawSurface = false, drawDetail = false;
@@ -76,7 +76,7 @@ void BglFile::readFile(const QString& filenameParam, const atools::fs::scenery::
 
   if(file.open(QIODevice::ReadOnly))
   {
-    BinaryStream stream(&file);
+    BinaryStream stream(&file, QDataStream::LittleEndian, atools::io::READ_MAPPED);
 
     size = stream.getFileSize();
 
@@ -85,7 +85,7 @@ void BglFile::readFile(const QString& filenameParam, const atools::fs::scenery::
       // Skip any obscure BGL files that do not contain a section structure or are too small
       return;
 
-    readSections(&stream);
+    readSections(&stream, area);
 
     if(options->isIncludedNavDbObject(type::BOUNDARY) && !area.isMsfsNavigraphNavdata())
       readBoundaryRecords(&stream);
@@ -186,7 +186,7 @@ void BglFile::readHeader(BinaryStream *bs)
     qDebug() << header;
 }
 
-void BglFile::readSections(BinaryStream *bs)
+void BglFile::readSections(BinaryStream *bs, const atools::fs::scenery::SceneryArea& area)
 {
   // Read sections after header
   for(unsigned int i = 0; i < header.getNumSections(); i++)
@@ -194,7 +194,9 @@ void BglFile::readSections(BinaryStream *bs)
     Section s = Section(options, bs);
 
     // Add only supported sections to the list
-    if(supportedSectionTypes.isEmpty() || supportedSectionTypes.contains(s.getType()))
+    // Also omit sections where all records would be filtered out by options to avoid reading subsections
+    if((supportedSectionTypes.isEmpty() || supportedSectionTypes.contains(s.getType())) &&
+       isSectionIncluded(s.getType(), area))
     {
       if(options->isVerbose())
         qDebug() << "Section" << s;
@@ -224,6 +226,44 @@ void BglFile::readSections(BinaryStream *bs)
   }
 }
 
+bool BglFile::isSectionIncluded(section::SectionType type, const atools::fs::scenery::SceneryArea& area) const
+{
+  // Has to match the conditions in readRecords()
+  switch(type)
+  {
+    case section::AIRPORT:
+    case section::AIRPORT_ALT:
+      return options->isIncludedNavDbObject(type::AIRPORT);
+
+    case section::ILS_VOR:
+      return (options->isIncludedNavDbObject(type::VOR) || options->isIncludedNavDbObject(type::ILS)) &&
+             !area.isMsfsNavigraphNavdata();
+
+    case section::NDB:
+      return options->isIncludedNavDbObject(type::NDB) && !area.isMsfsNavigraphNavdata();
+
+    case section::MARKER:
+      return options->isIncludedNavDbObject(type::MARKER) && !area.isMsfsNavigraphNavdata();
+
+    case section::WAYPOINT:
+      return options->isIncludedNavDbObject(type::WAYPOINT) && !area.isMsfsNavigraphNavdata();
+
+    default:
+      // Boundaries are read separately and other sections are filtered by supportedSectionTypes
+      return true;
+  }
+}
+
+void BglFile::seekToRecordEnd(BinaryStream *bs, const Record& rec) const
+{
+  if(rec.getSize() < bs->getFileSize())
+    rec.seekToEnd();
+  else
+    qWarning().nospace().noquote() << "Invalid record size " << rec.getSize()
+                                   << " offset " << bs->tellg()
+                                   << hex << " type 0x" << rec.getId() << dec;
+}
+
 const Record *BglFile::handleIlsVor(BinaryStream *bs)
 {
   // Read only type before creating concrete object
@@ -302,7 +342,7 @@ void BglFile::readRecords(BinaryStream *bs, const atools::fs::scenery::SceneryAr
           break;
 
         case section::NAME_LIST:
-          rec = createRecord<Namelist>(bs, &namelists);
+          rec = createRecord<Namelist>(bs, &namelists, namelistPool);
           break;
 
         case section::P3D_TACAN:
@@ -389,16 +429,21 @@ void BglFile::readRecords(BinaryStream *bs, const atools::fs::scenery::SceneryAr
           qWarning().nospace().noquote() << "Unknown section type at offset " << bs->tellg() << ": " << type;
 
       }
-      if(rec == nullptr)
-        // Create empty record, just to skip it
-        rec = createRecord<Record>(bs, nullptr);
-
-      if(rec->getSize() < bs->getFileSize())
-        rec->seekToEnd();
+      if(rec != nullptr)
+        seekToRecordEnd(bs, *rec);
       else
-        qWarning().nospace().noquote() << "Invalid record size " << rec->getSize()
-                                       << " offset " << bs->tellg()
-                                       << hex << " type 0x" << rec->getId() << dec;
+      {
+        // Read only id and size of the record on the stack to skip it - not needed later
+        Record skipRecord(options, bs);
+
+        if(options->isVerbose())
+        {
+          qDebug() << "----";
+          qDebug() << skipRecord;
+        }
+
+        seekToRecordEnd(bs, skipRecord);
+      }
     }
   }
 }
@@ -416,9 +461,13 @@ void BglFile::deleteAllObjects()
   boundaries.clear();
   sections.clear();
   subsections.clear();
+  header = Header();
 
-  qDeleteAll(allRecords);
+  // Records are created in the arena - call destructors only and release all memory at once
+  for(const Record *rec : qAsConst(allRecords))
+    rec->~Record();
   allRecords.clear();
+  arena.reset();
 
   filename.clear();
   size = 0;
@@ -24,6 +24,7 @@
 #include "fs/bgl/subsection.h"
 #include "fs/navdatabaseoptions.h"
 #include "io/binarystream.h"
+#include "util/arena.h"
 
 #include <QString>
 #include <QList>
@@ -48,6 +49,7 @@ class Marker;
 class Waypoint;
 class Airport;
 class Namelist;
+class NamelistPool;
 class Record;
 class Boundary;
 
@@ -82,6 +84,12 @@ public:
     supportedSectionTypes = sects;
   }
 
+  /* Compile wide pool for namelist strings. Namelists keep their own strings if null. */
+  void setNamelistPool(atools::fs::bgl::NamelistPool *pool)
+  {
+    namelistPool = pool;
+  }
+
   /*
    * Reads the full content of the BGL file into the internal lists including header, sections,
    * airports and so on.
@@ -165,7 +173,15 @@ public:
 private:
   void deleteAllObjects();
   void readHeader(atools::io::BinaryStream *bs);
-  void readSections(atools::io::BinaryStream *bs);
+  void readSections(atools::io::BinaryStream *bs, const atools::fs::scenery::SceneryArea& area);
+
+  /* false if no record will be created for the section type due to options or scenery area.
+   * Allows to skip these sections without looking at each record. */
+  bool isSectionIncluded(atools::fs::bgl::section::SectionType type,
+                         const atools::fs::scenery::SceneryArea& area) const;
+
+  /* Seek to the record following rec and check record size */
+  void seekToRecordEnd(atools::io::BinaryStream *bs, const atools::fs::bgl::Record& rec) const;
 
   void readRecords(atools::io::BinaryStream *bs, const atools::fs::scenery::SceneryArea& area);
   const Record *handleIlsVor(atools::io::BinaryStream *bs);
@@ -174,20 +190,30 @@ private:
   void readBoundaryRecords(atools::io::BinaryStream *bs);
   void handleBoundaries(atools::io::BinaryStream *bs);
 
+  /* Destroy a record which was just created and give the memory back to the arena */
   template<typename TYPE>
-  const TYPE *createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list);
+  void discardRecord(TYPE *rec)
+  {
+    rec->~TYPE();
+    arena.freeLast(rec);
+  }
 
-  template<typename TYPE>
-  const TYPE *createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list,
-                           atools::fs::bgl::flags::CreateFlags flags);
+  /* Create record in the arena. Additional arguments are passed to the constructor after options and stream. */
+  template<typename TYPE, typename ... ARGS>
+  const TYPE *createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list, ARGS&& ... args);
 
   QString filename;
   qint64 size;
   const NavDatabaseOptions *options = nullptr;
+  atools::fs::bgl::NamelistPool *namelistPool = nullptr;
 
   /* Keep a list of all records to make object deletion easier */
   QList<const atools::fs::bgl::Record *> allRecords;
 
+  /* Records are allocated here and released at once when reading the next file or on deletion.
+   * Blocks are kept and reused if the object is used for more than one file. */
+  atools::util::Arena arena;
+
   QList<const atools::fs::bgl::Airport *> airports;
   QList<const atools::fs::bgl::Namelist *> namelists;
   QList<const atools::fs::bgl::Vor *> vors;
@@ -208,48 +234,14 @@ private:
 
 // -------------------------------------------------------------------
 
-template<typename TYPE>
-const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list)
-{
-  TYPE *rec = new TYPE(options, bs);
-
-  if(rec->isExcluded())
-  {
-    delete rec;
-    return nullptr;
-  }
-
-  if(!rec->isValid())
-  {
-    // Print warning only for navaids that are not disabled
-    if(!rec->isDisabled())
-      qWarning() << "Found invalid record: " << rec->getObjectName();
-    rec->seekToStart();
-    delete rec;
-    return nullptr;
-  }
-
-  if(options->isVerbose())
-  {
-    qDebug() << "----";
-    qDebug() << *rec;
-  }
-
-  if(list != nullptr)
-    list->append(rec);
-  allRecords.append(rec);
-  return rec;
-}
-
-template<typename TYPE>
-const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list,
-                                  atools::fs::bgl::flags::CreateFlags flags)
+template<typename TYPE, typename ... ARGS>
+const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list, ARGS&& ... args)
 {
-  TYPE *rec = new TYPE(options, bs, flags);
+  TYPE *rec = arena.create<TYPE>(options, bs, std::forward<ARGS>(args)...);
 
   if(rec->isExcluded())
   {
-    delete rec;
+    discardRecord(rec);
     return nullptr;
   }
 
@@ -259,7 +251,7 @@ const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE
     if(!rec->isDisabled())
       qWarning() << "Found invalid record: " << rec->getObjectName();
     rec->seekToStart();
-    delete rec;
+    discardRecord(rec);
     return nullptr;
   }
 
@@ -18,8 +18,11 @@
 #include "fs/bgl/bglposition.h"
 
 #include "fs/bgl/converter.h"
+#include "geo/linestring.h"
 #include "io/binarystream.h"
 
+#include <QVarLengthArray>
+
 namespace atools {
 namespace fs {
 namespace bgl {
@@ -48,6 +51,25 @@ BglPosition::BglPosition(BinaryStream *bs, bool hasAltitude, float altitudeDivis
   pos = atools::geo::Pos(lonX, latY, altitude);
 }
 
+void BglPosition::readPositions(atools::geo::LineString& positions, atools::io::BinaryStream *bs, int numPoints)
+{
+  if(numPoints <= 0)
+    return;
+
+  // Raw pairs and converted coordinates as separate arrays
+  QVarLengthArray<qint32, 512> raw(numPoints * 2);
+  QVarLengthArray<float, 256> lonX(numPoints), latY(numPoints);
+
+  bs->readInts(raw.data(), numPoints * 2);
+  converter::intToLonXLatY(raw.constData(), numPoints, lonX.data(), latY.data());
+
+  int offset = positions.size();
+  positions.resize(offset + numPoints);
+  atools::geo::Pos *pos = positions.data() + offset;
+  for(int i = 0; i < numPoints; i++)
+    pos[i] = atools::geo::Pos(lonX.at(i), latY.at(i));
+}
+
 QDebug operator<<(QDebug out, const atools::fs::bgl::BglPosition& record)
 {
   out << record.pos;
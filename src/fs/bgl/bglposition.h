@@ -26,6 +26,9 @@ namespace atools {
 namespace io {
 class BinaryStream;
 }
+namespace geo {
+class LineString;
+}
 namespace fs {
 namespace bgl {
 
@@ -48,6 +51,12 @@ public:
    */
   BglPosition(atools::io::BinaryStream *bs, bool hasAltitude = false, float altitudeDivisor = 1.f);
 
+  /*
+   * Reads a list of numPoints positions without altitude from the stream and appends them to positions.
+   * Coordinates are read and converted in one batch instead of point by point.
+   */
+  static void readPositions(atools::geo::LineString& positions, atools::io::BinaryStream *bs, int numPoints);
+
   float getLonX() const
   {
     return pos.getLonX();
@@ -20,6 +20,11 @@
 #include <QVarLengthArray>
 #include <QDebug>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ATOOLS_CONVERTER_SSE2
+#endif
+
 namespace atools {
 namespace fs {
 namespace bgl {
@@ -27,6 +32,35 @@ namespace converter {
 
 static const char *RUNWAY_DESIGNATORS[] = {"", "L", "R", "C", "W", "A", "B"};
 
+void intToLonXLatY(const qint32 *lonXLatY, int numPoints, float *lonX, float *latY)
+{
+  int i = 0;
+#ifdef ATOOLS_CONVERTER_SSE2
+  // Same operations as intToLonX() and intToLatY() for four points at once
+  const __m128 lonScale = _mm_set1_ps(360.0f / (3.f * 0x10000000)), lonOffset = _mm_set1_ps(180.0f);
+  const __m128 latScale = _mm_set1_ps(180.0f / (2.f * 0x10000000)), latOffset = _mm_set1_ps(90.0f);
+
+  for(; i + 4 <= numPoints; i += 4)
+  {
+    // Two pairs in each register
+    __m128 pairs1 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lonXLatY + i * 2)));
+    __m128 pairs2 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lonXLatY + i * 2 + 4)));
+
+    __m128 lon = _mm_shuffle_ps(pairs1, pairs2, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 lat = _mm_shuffle_ps(pairs1, pairs2, _MM_SHUFFLE(3, 1, 3, 1));
+
+    _mm_storeu_ps(lonX + i, _mm_sub_ps(_mm_mul_ps(lon, lonScale), lonOffset));
+    _mm_storeu_ps(latY + i, _mm_sub_ps(latOffset, _mm_mul_ps(lat, latScale)));
+  }
+#endif
+
+  for(; i < numPoints; i++)
+  {
+    lonX[i] = intToLonX(lonXLatY[i * 2]);
+    latY[i] = intToLatY(lonXLatY[i * 2 + 1]);
+  }
+}
+
 QString intToIcao(unsigned int icao, bool noBitShift)
 {
   QString icaoStr;
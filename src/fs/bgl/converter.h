@@ -44,6 +44,12 @@ inline float intToLatY(int latY)
   return 90.0f - latY * (180.0f / (2.f * 0x10000000));
 }
 
+/*
+ * Converts numPoints interleaved longitude and latitude pairs in BGL format to degrees in separate arrays.
+ * Gives the same results as intToLonX() and intToLatY(). Uses SSE2 if available.
+ */
+void intToLonXLatY(const qint32 *lonXLatY, int numPoints, float *lonX, float *latY);
+
 /* Get the time in seconds since epoch from the BGL header specific format */
 time_t filetime(unsigned int lowDateTime, unsigned int highDateTime);
 
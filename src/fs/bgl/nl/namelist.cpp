@@ -17,6 +17,8 @@
 
 #include "fs/bgl/nl/namelist.h"
 
+#include "fs/bgl/nl/namelistpool.h"
+
 #include "io/binarystream.h"
 #include "fs/bgl/converter.h"
 #include "fs/navdatabaseoptions.h"
@@ -31,7 +33,7 @@ using Qt::endl;
 
 using atools::io::BinaryStream;
 
-Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs)
+Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs, NamelistPool *pool)
   : Record(options, bs)
 {
   int numRegionNames = bs->readShort();
@@ -53,19 +55,24 @@ Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs)
 
   // Read all names from the different offsets
   QStringList regions;
-  readList(regions, bs, numRegionNames, regionListOffset, encoding);
+  QVector<int> regionIds;
+  readList(regions, regionIds, bs, numRegionNames, regionListOffset, encoding, pool);
 
   QStringList countries;
-  readList(countries, bs, numCountryNames, countryListOffset, encoding);
+  QVector<int> countryIds;
+  readList(countries, countryIds, bs, numCountryNames, countryListOffset, encoding, pool);
 
   QStringList states;
-  readList(states, bs, numStateNames, stateListOffset, encoding);
+  QVector<int> stateIds;
+  readList(states, stateIds, bs, numStateNames, stateListOffset, encoding, pool);
 
   QStringList cities;
-  readList(cities, bs, numCityNames, cityListOffset, encoding);
+  QVector<int> cityIds;
+  readList(cities, cityIds, bs, numCityNames, cityListOffset, encoding, pool);
 
   QStringList airports;
-  readList(airports, bs, numAirportNames, airportListOffset, encoding);
+  QVector<int> airportIds;
+  readList(airports, airportIds, bs, numAirportNames, airportListOffset, encoding, pool);
 
   // Goto to the offset that contains the name indexes
   bs->seekg(startOffset + icaoListOffset);
@@ -74,11 +81,21 @@ Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs)
   for(int i = 0; i < numICAO; i++)
   {
     NamelistEntry icaoRec;
-    icaoRec.regionName = regions.value(bs->readUByte());
-    icaoRec.countryName = countries.value(bs->readUByte());
-    icaoRec.stateName = states.value(bs->readShort() >> 4);
-    icaoRec.cityName = cities.value(bs->readShort());
-    icaoRec.airportName = airports.value(bs->readShort());
+    int regionIdx = bs->readUByte(), countryIdx = bs->readUByte(), stateIdx = bs->readShort() >> 4,
+        cityIdx = bs->readShort(), airportIdx = bs->readShort();
+
+    icaoRec.regionName = regions.value(regionIdx);
+    icaoRec.countryName = countries.value(countryIdx);
+    icaoRec.stateName = states.value(stateIdx);
+    icaoRec.cityName = cities.value(cityIdx);
+    icaoRec.airportName = airports.value(airportIdx);
+
+    icaoRec.regionNameId = regionIds.value(regionIdx, atools::util::StringInterner::INVALID_ID);
+    icaoRec.countryNameId = countryIds.value(countryIdx, atools::util::StringInterner::INVALID_ID);
+    icaoRec.stateNameId = stateIds.value(stateIdx, atools::util::StringInterner::INVALID_ID);
+    icaoRec.cityNameId = cityIds.value(cityIdx, atools::util::StringInterner::INVALID_ID);
+    icaoRec.airportNameId = airportIds.value(airportIdx, atools::util::StringInterner::INVALID_ID);
+
     icaoRec.airportIdent = converter::intToIcao(bs->readUInt());
     icaoRec.regionIdent = converter::intToIcao(bs->readUInt());
 
@@ -92,8 +109,8 @@ Namelist::~Namelist()
 {
 }
 
-void Namelist::readList(QStringList& names, BinaryStream *bs, int numNames, int listOffset,
-                        atools::io::Encoding encoding)
+void Namelist::readList(QStringList& names, QVector<int>& ids, BinaryStream *bs, int numNames, int listOffset,
+                        atools::io::Encoding encoding, NamelistPool *pool)
 {
   bs->seekg(startOffset + listOffset);
 
@@ -108,6 +125,9 @@ void Namelist::readList(QStringList& names, BinaryStream *bs, int numNames, int
     names.append(bs->readString(encoding));
   }
   delete[] indexes;
+
+  if(pool != nullptr)
+    pool->intern(names, ids);
 }
 
 QDebug operator<<(QDebug out, const Namelist& record)
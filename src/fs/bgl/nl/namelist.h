@@ -24,6 +24,7 @@
 
 #include <QString>
 #include <QList>
+#include <QVector>
 
 namespace atools {
 namespace io {
@@ -35,6 +36,8 @@ namespace atools {
 namespace fs {
 namespace bgl {
 
+class NamelistPool;
+
 /*
  * Namelist contains all airport names, city, state/province and country names for the
  * airports in one BGL file
@@ -43,8 +46,9 @@ class Namelist :
   public atools::fs::bgl::Record
 {
 public:
-  /* read nameslist from BGL */
-  Namelist(const atools::fs::NavDatabaseOptions *options, atools::io::BinaryStream *bs);
+  /* read nameslist from BGL. Names are taken from the pool if not null. */
+  Namelist(const atools::fs::NavDatabaseOptions *options, atools::io::BinaryStream *bs,
+           atools::fs::bgl::NamelistPool *pool = nullptr);
   virtual ~Namelist() override;
 
   const QList<atools::fs::bgl::NamelistEntry>& getNameList() const
@@ -57,8 +61,9 @@ private:
 
   QList<atools::fs::bgl::NamelistEntry> entries;
 
-  void readList(QStringList& names, atools::io::BinaryStream *bs, int numRegionNames, int regionListOffset,
-                atools::io::Encoding encoding);
+  /* Read names and replace them with pooled strings if pool is not null. ids are empty if pool is null. */
+  void readList(QStringList& names, QVector<int>& ids, atools::io::BinaryStream *bs, int numNames, int listOffset,
+                atools::io::Encoding encoding, atools::fs::bgl::NamelistPool *pool);
 
 };
 
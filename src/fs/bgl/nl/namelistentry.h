@@ -18,6 +18,8 @@
 #ifndef ATOOLS_BGL_NAMELISTICAOIDENT_H
 #define ATOOLS_BGL_NAMELISTICAOIDENT_H
 
+#include "util/stringinterner.h"
+
 #include <QString>
 
 namespace atools {
@@ -76,11 +78,40 @@ public:
     return stateName;
   }
 
+  /* Ids of the names in the compile wide NamelistPool. StringInterner::INVALID_ID if read without pool. */
+  int getAirportNameId() const
+  {
+    return airportNameId;
+  }
+
+  int getCityNameId() const
+  {
+    return cityNameId;
+  }
+
+  int getCountryNameId() const
+  {
+    return countryNameId;
+  }
+
+  int getRegionNameId() const
+  {
+    return regionNameId;
+  }
+
+  int getStateNameId() const
+  {
+    return stateNameId;
+  }
+
 private:
   friend class Namelist;
   friend QDebug operator<<(QDebug out, const atools::fs::bgl::NamelistEntry& record);
 
   QString regionName, countryName, stateName, cityName, airportName, airportIdent, regionIdent;
+  int regionNameId = atools::util::StringInterner::INVALID_ID, countryNameId = atools::util::StringInterner::INVALID_ID,
+      stateNameId = atools::util::StringInterner::INVALID_ID, cityNameId = atools::util::StringInterner::INVALID_ID,
+      airportNameId = atools::util::StringInterner::INVALID_ID;
 };
 
 } // namespace bgl
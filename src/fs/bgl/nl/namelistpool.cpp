@@ -0,0 +1,58 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/bgl/nl/namelistpool.h"
+
+namespace atools {
+namespace fs {
+namespace bgl {
+
+NamelistPool::NamelistPool()
+{
+}
+
+void NamelistPool::intern(QStringList& names, QVector<int>& ids)
+{
+  ids.clear();
+  ids.reserve(names.size());
+
+  QMutexLocker locker(&mutex);
+  for(QString& name : names)
+  {
+    int id = interner.intern(name);
+    ids.append(id);
+
+    // Drop the decoded copy and share the data of the pooled string
+    name = interner.getString(id);
+  }
+}
+
+int NamelistPool::size() const
+{
+  QMutexLocker locker(&mutex);
+  return interner.size();
+}
+
+void NamelistPool::clear()
+{
+  QMutexLocker locker(&mutex);
+  interner.clear();
+}
+
+} // namespace bgl
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,66 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_BGL_NAMELISTPOOL_H
+#define ATOOLS_BGL_NAMELISTPOOL_H
+
+#include "util/stringinterner.h"
+
+#include <QMutex>
+#include <QStringList>
+
+namespace atools {
+namespace fs {
+namespace bgl {
+
+/*
+ * Compile wide pool for the region, country, state, city and airport name strings of all namelists.
+ * The same names appear in thousands of BGL files. Namelists replace their decoded strings with the
+ * pooled instances which share the string data and keep the pool id for each name.
+ *
+ * Ids can be used by writers as keys to cache values derived from names.
+ *
+ * Thread safe since namelists are read in the read ahead threads.
+ */
+class NamelistPool
+{
+public:
+  NamelistPool();
+
+  NamelistPool(const NamelistPool& other) = delete;
+  NamelistPool& operator=(const NamelistPool& other) = delete;
+
+  /* Replace all strings in names with the pooled instances and fill ids with the respective pool ids.
+   * Locks only once for the whole list. */
+  void intern(QStringList& names, QVector<int>& ids);
+
+  /* Number of distinct names including the empty string */
+  int size() const;
+
+  /* Removes all strings. All ids handed out before are invalid afterwards. */
+  void clear();
+
+private:
+  atools::util::StringInterner interner;
+  mutable QMutex mutex;
+};
+
+} // namespace bgl
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_BGL_NAMELISTPOOL_H
@@ -0,0 +1,349 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/airportgroundindex.h"
+
+#include "geo/calculations.h"
+#include "geo/rect.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QElapsedTimer>
+
+#include <cmath>
+
+using atools::geo::Pos;
+using atools::geo::Rect;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/* Meters per degree latitude */
+static const float METERS_PER_DEG = atools::geo::nmToMeter(60.f);
+
+/* Default number of airports kept in memory */
+static const int DEFAULT_CACHE_SIZE = 20;
+
+/* true if local position (x, y) is inside of a rectangle around center with given heading and dimensions */
+inline static bool insideRect(float x, float y, float centerX, float centerY, float headingTrue, float lengthMeter,
+                              float widthMeter)
+{
+  float headingRad = atools::geo::toRadians(headingTrue);
+
+  // Unit vector along heading - x is east and y is north
+  float dirX = std::sin(headingRad), dirY = std::cos(headingRad);
+  float dx = x - centerX, dy = y - centerY;
+
+  float along = dx * dirX + dy * dirY;
+  float across = dx * dirY - dy * dirX;
+  return std::abs(along) <= lengthMeter / 2.f && std::abs(across) <= widthMeter / 2.f;
+}
+
+AirportGroundIndex::AirportGroundIndex(sql::SqlDatabase *sqlDb)
+  : db(sqlDb), groundCache(DEFAULT_CACHE_SIZE)
+{
+}
+
+AirportGroundIndex::~AirportGroundIndex()
+{
+}
+
+void AirportGroundIndex::clear()
+{
+  QMutexLocker locker(&mutex);
+  airportsLoaded = false;
+  airportIds.clear();
+  airportCenters.clear();
+  airportTree.clear();
+  groundCache.clear();
+}
+
+void AirportGroundIndex::setMaxCachedAirports(int value)
+{
+  QMutexLocker locker(&mutex);
+  groundCache.setMaxCost(value);
+}
+
+AirportGroundIndex::LocalPos AirportGroundIndex::Ground::toLocal(const Pos& pos) const
+{
+  return LocalPos({atools::geo::normalizeLonXDeg(pos.getLonX() - center.getLonX()) * metersPerDegLonX,
+                   (pos.getLatY() - center.getLatY()) * METERS_PER_DEG});
+}
+
+int AirportGroundIndex::getAirportIdAt(const Pos& pos)
+{
+  QMutexLocker locker(&mutex);
+  const Ground *ground = groundAt(pos);
+  return ground != nullptr ? ground->airportId : -1;
+}
+
+bool AirportGroundIndex::getNearestParking(GroundParking& parking, const Pos& pos, float maxDistanceMeter)
+{
+  QMutexLocker locker(&mutex);
+  const Ground *ground = groundAt(pos);
+  if(ground == nullptr)
+    return false;
+
+  LocalPos local = ground->toLocal(pos);
+  int nearest = -1;
+  float nearestDistSq = std::numeric_limits<float>::max();
+  for(int i = 0; i < ground->parkingPos.size(); i++)
+  {
+    float dx = local.x - ground->parkingPos.at(i).x, dy = local.y - ground->parkingPos.at(i).y;
+    float distSq = dx * dx + dy * dy;
+
+    float maxDist = maxDistanceMeter < 0.f ?
+                    atools::geo::feetToMeter(ground->parkings.at(i).radiusFt) : maxDistanceMeter;
+    if(distSq <= maxDist * maxDist && distSq < nearestDistSq)
+    {
+      nearest = i;
+      nearestDistSq = distSq;
+    }
+  }
+
+  if(nearest != -1)
+  {
+    parking = ground->parkings.at(nearest);
+    return true;
+  }
+  return false;
+}
+
+bool AirportGroundIndex::getRunwayAtPos(GroundRunway& runway, QString& endName, const Pos& pos, float headingTrue)
+{
+  QMutexLocker locker(&mutex);
+  const Ground *ground = groundAt(pos);
+  if(ground == nullptr)
+    return false;
+
+  LocalPos local = ground->toLocal(pos);
+  for(int i = 0; i < ground->runways.size(); i++)
+  {
+    const LocalPos& prim = ground->runwayPrimary.at(i), & sec = ground->runwaySecondary.at(i);
+    const GroundRunway& rw = ground->runways.at(i);
+
+    // Use the end positions for length and heading since these are more precise than the stored values
+    float dx = prim.x - sec.x, dy = prim.y - sec.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if(length < 1.f)
+      continue;
+
+    float heading = atools::geo::normalizeCourse(atools::geo::toDegree(std::atan2(-dx, -dy)));
+    if(insideRect(local.x, local.y, (prim.x + sec.x) / 2.f, (prim.y + sec.y) / 2.f, heading, length,
+                  atools::geo::feetToMeter(rw.widthFt)))
+    {
+      runway = rw;
+
+      bool primary;
+      if(headingTrue < Pos::INVALID_VALUE / 2.f)
+        primary = atools::geo::angleAbsDiff(heading, atools::geo::normalizeCourse(headingTrue)) <= 90.f;
+      else
+      {
+        float px = local.x - prim.x, py = local.y - prim.y, sx = local.x - sec.x, sy = local.y - sec.y;
+        primary = px * px + py * py <= sx * sx + sy * sy;
+      }
+      endName = primary ? rw.primaryName : rw.secondaryName;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AirportGroundIndex::getHelipadAtPos(GroundHelipad& helipad, const Pos& pos)
+{
+  QMutexLocker locker(&mutex);
+  const Ground *ground = groundAt(pos);
+  if(ground == nullptr)
+    return false;
+
+  LocalPos local = ground->toLocal(pos);
+  for(int i = 0; i < ground->helipads.size(); i++)
+  {
+    const GroundHelipad& pad = ground->helipads.at(i);
+    if(insideRect(local.x, local.y, ground->helipadPos.at(i).x, ground->helipadPos.at(i).y, pad.headingTrue,
+                  atools::geo::feetToMeter(pad.lengthFt), atools::geo::feetToMeter(pad.widthFt)))
+    {
+      helipad = pad;
+      return true;
+    }
+  }
+  return false;
+}
+
+void AirportGroundIndex::loadAirports()
+{
+  if(airportsLoaded)
+    return;
+
+  QElapsedTimer timer;
+  timer.start();
+  airportsLoaded = true;
+
+  if(!SqlUtil(db).hasTableAndRows("airport"))
+    return;
+
+  SqlQuery query("select airport_id, left_lonx, top_laty, right_lonx, bottom_laty, lonx, laty from airport", db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+  {
+    airportTree.add(airportIds.size(), Rect(query.valueFloat("left_lonx"), query.valueFloat("top_laty"),
+                                            query.valueFloat("right_lonx"), query.valueFloat("bottom_laty")));
+    airportIds.append(query.valueInt("airport_id"));
+    airportCenters.append(Pos(query.valueFloat("lonx"), query.valueFloat("laty")));
+  }
+  airportTree.build();
+
+  qDebug() << Q_FUNC_INFO << "airports" << airportIds.size() << timer.elapsed() << "ms";
+}
+
+const AirportGroundIndex::Ground *AirportGroundIndex::groundAt(const Pos& pos)
+{
+  if(!pos.isValid())
+    return nullptr;
+
+  loadAirports();
+
+  QVector<int> indexes;
+  airportTree.getContaining(indexes, pos);
+  if(indexes.isEmpty())
+    return nullptr;
+
+  // Use nearest airport center if bounding rectangles overlap
+  int index = indexes.constFirst();
+  if(indexes.size() > 1)
+  {
+    float nearestDist = std::numeric_limits<float>::max();
+    for(int idx : indexes)
+    {
+      float dist = pos.distanceMeterTo(airportCenters.at(idx));
+      if(dist < nearestDist)
+      {
+        nearestDist = dist;
+        index = idx;
+      }
+    }
+  }
+
+  int airportId = airportIds.at(index);
+  Ground *ground = groundCache.object(airportId);
+  if(ground == nullptr)
+  {
+    ground = loadGround(airportId);
+    ground->airportId = airportId;
+    ground->center = airportCenters.at(index);
+    ground->metersPerDegLonX = METERS_PER_DEG * std::cos(atools::geo::toRadians(ground->center.getLatY()));
+
+    for(const GroundParking& parking : ground->parkings)
+      ground->parkingPos.append(ground->toLocal(parking.pos));
+    for(const GroundRunway& runway : ground->runways)
+    {
+      ground->runwayPrimary.append(ground->toLocal(runway.primaryPos));
+      ground->runwaySecondary.append(ground->toLocal(runway.secondaryPos));
+    }
+    for(const GroundHelipad& helipad : ground->helipads)
+      ground->helipadPos.append(ground->toLocal(helipad.pos));
+
+    groundCache.insert(airportId, ground);
+  }
+  return ground;
+}
+
+AirportGroundIndex::Ground *AirportGroundIndex::loadGround(int airportId)
+{
+  Ground *ground = new Ground;
+  SqlUtil util(db);
+
+  if(util.hasTableAndRows("parking"))
+  {
+    SqlQuery query("select parking_id, type, name, number, suffix, radius, heading, lonx, laty "
+                   "from parking where airport_id = :id", db);
+    query.setForwardOnly(true);
+    query.bindValue(":id", airportId);
+    query.exec();
+    while(query.next())
+    {
+      GroundParking parking;
+      parking.id = query.valueInt("parking_id");
+      parking.airportId = airportId;
+      parking.type = query.valueStr("type");
+      parking.name = query.valueStr("name");
+      parking.number = query.valueInt("number");
+      parking.suffix = query.valueStr("suffix");
+      parking.radiusFt = query.valueFloat("radius");
+      parking.headingTrue = query.valueFloat("heading");
+      parking.pos = Pos(query.valueFloat("lonx"), query.valueFloat("laty"));
+      ground->parkings.append(parking);
+    }
+  }
+
+  if(util.hasTableAndRows("runway"))
+  {
+    SqlQuery query("select r.runway_id, p.name as primary_name, s.name as secondary_name, r.length, r.width, "
+                   "r.heading, r.primary_lonx, r.primary_laty, r.secondary_lonx, r.secondary_laty "
+                   "from runway r join runway_end p on r.primary_end_id = p.runway_end_id "
+                   "join runway_end s on r.secondary_end_id = s.runway_end_id "
+                   "where r.airport_id = :id", db);
+    query.setForwardOnly(true);
+    query.bindValue(":id", airportId);
+    query.exec();
+    while(query.next())
+    {
+      GroundRunway runway;
+      runway.id = query.valueInt("runway_id");
+      runway.airportId = airportId;
+      runway.primaryName = query.valueStr("primary_name");
+      runway.secondaryName = query.valueStr("secondary_name");
+      runway.lengthFt = query.valueFloat("length");
+      runway.widthFt = query.valueFloat("width");
+      runway.headingTrue = query.valueFloat("heading");
+      runway.primaryPos = Pos(query.valueFloat("primary_lonx"), query.valueFloat("primary_laty"));
+      runway.secondaryPos = Pos(query.valueFloat("secondary_lonx"), query.valueFloat("secondary_laty"));
+      ground->runways.append(runway);
+    }
+  }
+
+  if(util.hasTableAndRows("helipad"))
+  {
+    SqlQuery query("select helipad_id, type, length, width, heading, lonx, laty "
+                   "from helipad where airport_id = :id", db);
+    query.setForwardOnly(true);
+    query.bindValue(":id", airportId);
+    query.exec();
+    while(query.next())
+    {
+      GroundHelipad helipad;
+      helipad.id = query.valueInt("helipad_id");
+      helipad.airportId = airportId;
+      helipad.type = query.valueStr("type");
+      helipad.lengthFt = query.valueFloat("length");
+      helipad.widthFt = query.valueFloat("width");
+      helipad.headingTrue = query.valueFloat("heading");
+      helipad.pos = Pos(query.valueFloat("lonx"), query.valueFloat("laty"));
+      ground->helipads.append(helipad);
+    }
+  }
+  return ground;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,177 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_AIRPORTGROUNDINDEX_H
+#define ATOOLS_FS_COMMON_AIRPORTGROUNDINDEX_H
+
+#include "geo/pos.h"
+#include "geo/rtree.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/* Parking spot as loaded from table "parking" */
+struct GroundParking
+{
+  int id = -1, airportId = -1, number = -1;
+  QString type, name, suffix;
+  float radiusFt = 0.f, headingTrue = 0.f;
+  atools::geo::Pos pos;
+
+  bool isValid() const
+  {
+    return id != -1;
+  }
+
+};
+
+/* Runway as loaded from tables "runway" and "runway_end" */
+struct GroundRunway
+{
+  int id = -1, airportId = -1;
+  QString primaryName, secondaryName;
+  float lengthFt = 0.f, widthFt = 0.f, headingTrue = 0.f; /* Heading of primary end */
+  atools::geo::Pos primaryPos, secondaryPos;
+
+  bool isValid() const
+  {
+    return id != -1;
+  }
+
+};
+
+/* Helipad as loaded from table "helipad" */
+struct GroundHelipad
+{
+  int id = -1, airportId = -1;
+  QString type;
+  float lengthFt = 0.f, widthFt = 0.f, headingTrue = 0.f;
+  atools::geo::Pos pos;
+
+  bool isValid() const
+  {
+    return id != -1;
+  }
+
+};
+
+/*
+ * In-memory index of parking spots, runways and helipads to detect where an aircraft is on the ground.
+ * Meant for checks on each simulator update like logbook start and stop detection or flight segment detection
+ * which would otherwise need several SQL queries for each tick.
+ *
+ * Airports are found by their bounding rectangle in an R-tree which is loaded once on first use.
+ * Ground objects of an airport are loaded on first access and kept in a small LRU cache.
+ * All positions of an airport are converted into a local plane in meters around the airport center, so
+ * checks are simple point in rectangle or distance tests.
+ *
+ * Query methods are thread safe. The database is only accessed when loading the airport list or
+ * the ground objects of an airport. Call clear() if the database changes.
+ */
+class AirportGroundIndex
+{
+public:
+  explicit AirportGroundIndex(atools::sql::SqlDatabase *sqlDb);
+  ~AirportGroundIndex();
+
+  AirportGroundIndex(const AirportGroundIndex& other) = delete;
+  AirportGroundIndex& operator=(const AirportGroundIndex& other) = delete;
+
+  /* Drop all loaded airports. Airport list and ground objects are reloaded on next query. */
+  void clear();
+
+  /* Get airport id which bounding rectangle contains pos or -1 if none.
+   * Uses the airport with the nearest center if more than one matches. */
+  int getAirportIdAt(const atools::geo::Pos& pos);
+
+  /* Get nearest parking spot within maxDistanceMeter of pos. Uses the radius of the parking spot
+   * as maximum distance if maxDistanceMeter is negative. Returns false if nothing was found. */
+  bool getNearestParking(atools::fs::common::GroundParking& parking, const atools::geo::Pos& pos,
+                         float maxDistanceMeter = -1.f);
+
+  /* Get runway which rectangle contains pos. endName is the name of the end which matches headingTrue best
+   * or the nearest end if heading is not valid. This is the departure end when lining up.
+   * Returns false if pos is not on a runway. */
+  bool getRunwayAtPos(atools::fs::common::GroundRunway& runway, QString& endName, const atools::geo::Pos& pos,
+                      float headingTrue = atools::geo::Pos::INVALID_VALUE);
+
+  /* Get helipad which rectangle contains pos. Returns false if none. */
+  bool getHelipadAtPos(atools::fs::common::GroundHelipad& helipad, const atools::geo::Pos& pos);
+
+  /* Number of airports kept in memory */
+  void setMaxCachedAirports(int value);
+
+private:
+  /* Position in meter relative to the airport center */
+  struct LocalPos
+  {
+    float x, y;
+  };
+
+  /* All ground objects of an airport with positions in the local plane */
+  struct Ground
+  {
+    int airportId;
+    atools::geo::Pos center;
+    float metersPerDegLonX;
+
+    QVector<atools::fs::common::GroundParking> parkings;
+    QVector<LocalPos> parkingPos;
+
+    QVector<atools::fs::common::GroundRunway> runways;
+    QVector<LocalPos> runwayPrimary, runwaySecondary;
+
+    QVector<atools::fs::common::GroundHelipad> helipads;
+    QVector<LocalPos> helipadPos;
+
+    LocalPos toLocal(const atools::geo::Pos& pos) const;
+  };
+
+  /* Load airport list into R-tree if not done yet. Caller has to hold mutex. */
+  void loadAirports();
+
+  /* Get ground objects for airport at pos from cache or load them. Caller has to hold mutex. Null if none. */
+  const Ground *groundAt(const atools::geo::Pos& pos);
+  Ground *loadGround(int airportId);
+
+  atools::sql::SqlDatabase *db;
+  bool airportsLoaded = false;
+
+  /* Airport ids and centers for R-tree indexes */
+  QVector<int> airportIds;
+  QVector<atools::geo::Pos> airportCenters;
+  atools::geo::RTree airportTree;
+
+  /* Ground objects by airport id */
+  QCache<int, Ground> groundCache;
+  QMutex mutex;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_AIRPORTGROUNDINDEX_H
@@ -18,17 +18,14 @@
 #ifndef ATOOLS_XPAIRPORTINDEX_H
 #define ATOOLS_XPAIRPORTINDEX_H
 
-#include "util/str.h"
+#include "geo/pos.h"
+#include "util/identkey.h"
+#include "util/openhash.h"
 
-#include <QHash>
 #include <QSet>
 #include <QVariant>
 
 namespace atools {
-namespace geo {
-class Pos;
-}
-
 namespace fs {
 namespace common {
 
@@ -88,28 +85,28 @@ public:
 
   void clear();
 
-  typedef atools::util::Str<8> Name;
-  typedef atools::util::StrPair<8> Name2;
-  typedef atools::util::StrTriple<8> Name3;
+  typedef atools::util::IdentKey Name;
+  typedef atools::util::IdentKeyPair Name2;
+  typedef atools::util::IdentKeyTriple Name3;
 
 private:
   // Airport ICAO to airport_id
-  QHash<Name, int> identToIdMap;
+  atools::util::OpenHash<Name, int> identToIdMap;
 
   // Airport idents
   QSet<Name> airportIdents;
 
   // Maps airport idents to ICAO
-  QHash<Name, Name> identToIcaoMap;
-  QHash<Name, atools::geo::Pos> identToPosMap;
+  atools::util::OpenHash<Name, Name> identToIcaoMap;
+  atools::util::OpenHash<Name, atools::geo::Pos> identToPosMap;
 
   // Airport ICAO and runway name to runway_end_id
-  QHash<Name2, int> identRunwayNameToEndId;
+  atools::util::OpenHash<Name2, int> identRunwayNameToEndId;
 
-  QHash<Name2, atools::geo::Pos> identRunwayNameToEndPos;
+  atools::util::OpenHash<Name2, atools::geo::Pos> identRunwayNameToEndPos;
 
   // Airport ICAO, airport region and ILS ident to ils_id
-  QHash<Name3, int> airportIlsIdMap;
+  atools::util::OpenHash<Name3, int> airportIlsIdMap;
   QSet<Name3> skippedIlsSet;
 
 };
@@ -118,8 +115,4 @@ private:
 } // namespace fs
 } // namespace atools
 
-Q_DECLARE_TYPEINFO(atools::fs::common::AirportIndex::Name, Q_PRIMITIVE_TYPE);
-Q_DECLARE_TYPEINFO(atools::fs::common::AirportIndex::Name2, Q_PRIMITIVE_TYPE);
-Q_DECLARE_TYPEINFO(atools::fs::common::AirportIndex::Name3, Q_PRIMITIVE_TYPE);
-
 #endif // ATOOLS_XPAIRPORTINDEX_H
@@ -0,0 +1,427 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/airspaceindex.h"
+
+#include "fs/common/binarygeometry.h"
+#include "geo/calculations.h"
+#include "geo/rect.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QElapsedTimer>
+
+#include <cmath>
+
+using atools::geo::Pos;
+using atools::geo::Rect;
+using atools::geo::LineString;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/* Longitude of pos relative to reference in range -180 to 180 to get a continuous plane around the reference */
+inline static float relativeLonX(const Pos& pos, float refLonX)
+{
+  return atools::geo::normalizeLonXDeg(pos.getLonX() - refLonX);
+}
+
+/* Parameter along segment a-b where it crosses edge c-d or -1 if there is no crossing.
+ * Edge end point d is excluded to avoid counting vertices shared by two edges twice. */
+inline static float crossingParameter(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy)
+{
+  float rx = bx - ax, ry = by - ay, sx = dx - cx, sy = dy - cy;
+  float denom = rx * sy - ry * sx;
+  if(denom == 0.f)
+    // Parallel or degenerated
+    return -1.f;
+
+  float qx = cx - ax, qy = cy - ay;
+  float t = (qx * sy - qy * sx) / denom;
+  float u = (qx * ry - qy * rx) / denom;
+  return t >= 0.f && t <= 1.f && u >= 0.f && u < 1.f ? t : -1.f;
+}
+
+Q_DECL_CONSTEXPR int AirspaceIndex::EDGES_PER_CELL;
+Q_DECL_CONSTEXPR int AirspaceIndex::MAX_GRID_SIZE;
+
+AirspaceIndex::AirspaceIndex()
+{
+}
+
+AirspaceIndex::~AirspaceIndex()
+{
+}
+
+void AirspaceIndex::clear()
+{
+  airspaces.clear();
+  tree.clear();
+}
+
+void AirspaceIndex::loadFromDatabase(sql::SqlDatabase *db, const QString& table)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+
+  if(!SqlUtil(db).hasTableAndRows(table))
+    return;
+
+  SqlQuery query("select boundary_id, min_altitude, max_altitude, geometry from " + table, db);
+  query.exec();
+  while(query.next())
+  {
+    BinaryGeometry geometry(query.value("geometry").toByteArray());
+    LineString polygon;
+    geometry.swapGeometry(polygon);
+
+    addAirspace(query.valueInt("boundary_id"), polygon,
+                query.isNull("min_altitude") ? std::numeric_limits<float>::lowest() : query.valueFloat("min_altitude"),
+                query.isNull("max_altitude") ? std::numeric_limits<float>::max() : query.valueFloat("max_altitude"));
+  }
+
+  build();
+
+  qDebug() << Q_FUNC_INFO << table << "airspaces" << airspaces.size() << timer.elapsed() << "ms";
+}
+
+void AirspaceIndex::addAirspace(int id, const LineString& polygon, float minAltitudeFt, float maxAltitudeFt)
+{
+  if(polygon.size() < 3)
+    return;
+
+  Airspace airspace;
+  airspace.id = id;
+  airspace.minAltitudeFt = minAltitudeFt;
+  airspace.maxAltitudeFt = maxAltitudeFt;
+  buildGrid(airspace, polygon);
+
+  tree.add(airspaces.size(), polygon.boundingRect());
+  airspaces.append(airspace);
+}
+
+void AirspaceIndex::build()
+{
+  tree.build();
+}
+
+void AirspaceIndex::getAirspacesAtPos(QVector<int>& ids, const Pos& pos, float altitudeFt) const
+{
+  ids.clear();
+
+  QVector<int> candidates;
+  tree.getContaining(candidates, pos);
+
+  bool checkAltitude = altitudeFt < std::numeric_limits<float>::max();
+  for(int index : candidates)
+  {
+    const Airspace& airspace = airspaces.at(index);
+    if(checkAltitude && (altitudeFt < airspace.minAltitudeFt || altitudeFt > airspace.maxAltitudeFt))
+      continue;
+
+    if(containsPos(airspace, pos))
+      ids.append(airspace.id);
+  }
+  std::sort(ids.begin(), ids.end());
+}
+
+void AirspaceIndex::getAirspacesForLine(QVector<int>& ids, const LineString& line, float minAltitudeFt,
+                                        float maxAltitudeFt) const
+{
+  ids.clear();
+  if(line.isEmpty())
+    return;
+
+  if(line.size() == 1)
+  {
+    getAirspacesAtPos(ids, line.constFirst());
+    return;
+  }
+
+  // Airspace index to found flag to avoid testing airspaces again which are already hit by previous segments
+  QVector<bool> found(airspaces.size(), false);
+  QVector<int> candidates;
+  QVector<float> fractions;
+  for(int i = 1; i < line.size(); i++)
+  {
+    const Pos& p1 = line.at(i - 1);
+    const Pos& p2 = line.at(i);
+
+    // Query R-tree per segment to avoid huge candidate lists for long routes
+    tree.getOverlapping(candidates, LineString({p1, p2}).boundingRect());
+
+    for(int index : candidates)
+    {
+      if(found.at(index))
+        continue;
+
+      const Airspace& airspace = airspaces.at(index);
+      if(maxAltitudeFt < airspace.minAltitudeFt || minAltitudeFt > airspace.maxAltitudeFt)
+        continue;
+
+      // Completely inside or crosses boundary
+      bool hit = containsPos(airspace, p1);
+      if(!hit)
+      {
+        fractions.clear();
+        segmentCrossings(fractions, airspace, p1, p2, true /* firstOnly */);
+        hit = !fractions.isEmpty();
+      }
+
+      if(hit)
+      {
+        found[index] = true;
+        ids.append(airspace.id);
+      }
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+}
+
+void AirspaceIndex::getCrossings(QVector<AirspaceCrossing>& crossings, const Pos& p1, const Pos& p2,
+                                 float minAltitudeFt, float maxAltitudeFt) const
+{
+  crossings.clear();
+
+  QVector<int> candidates;
+  tree.getOverlapping(candidates, LineString({p1, p2}).boundingRect());
+
+  float deltaLonX = atools::geo::normalizeLonXDeg(p2.getLonX() - p1.getLonX());
+  float deltaLatY = p2.getLatY() - p1.getLatY();
+
+  QVector<float> fractions;
+  for(int index : candidates)
+  {
+    const Airspace& airspace = airspaces.at(index);
+    if(maxAltitudeFt < airspace.minAltitudeFt || minAltitudeFt > airspace.maxAltitudeFt)
+      continue;
+
+    fractions.clear();
+    segmentCrossings(fractions, airspace, p1, p2, false /* firstOnly */);
+    bool inside = containsPos(airspace, p1);
+
+    if(fractions.isEmpty() && !inside)
+      continue;
+
+    std::sort(fractions.begin(), fractions.end());
+
+    if(inside)
+      crossings.append({airspace.id, 0.f, p1, true});
+
+    // Toggle state for each crossing which keeps entry and exit paired even for crossings through vertices
+    for(float fraction : fractions)
+    {
+      inside = !inside;
+      Pos pos(atools::geo::normalizeLonXDeg(p1.getLonX() + deltaLonX * fraction), p1.getLatY() + deltaLatY * fraction);
+      crossings.append({airspace.id, fraction, pos, inside});
+    }
+
+    if(inside)
+      crossings.append({airspace.id, 1.f, p2, false});
+  }
+
+  std::sort(crossings.begin(), crossings.end(), [](const AirspaceCrossing& c1, const AirspaceCrossing& c2) -> bool {
+              return c1.fraction < c2.fraction || (c1.fraction == c2.fraction && c1.id < c2.id);
+            });
+}
+
+void AirspaceIndex::buildGrid(Airspace& airspace, const LineString& polygon)
+{
+  // Use first point as reference to get a continuous plane for polygons crossing the anti-meridian too
+  airspace.refLonX = polygon.constFirst().getLonX();
+
+  int size = polygon.size();
+  airspace.xs.resize(size);
+  airspace.ys.resize(size);
+
+  float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest();
+  float minY = std::numeric_limits<float>::max(), maxY = std::numeric_limits<float>::lowest();
+  for(int i = 0; i < size; i++)
+  {
+    float x = relativeLonX(polygon.at(i), airspace.refLonX), y = polygon.at(i).getLatY();
+    airspace.xs[i] = x;
+    airspace.ys[i] = y;
+    minX = std::min(minX, x);
+    maxX = std::max(maxX, x);
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+  }
+
+  int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(size) / EDGES_PER_CELL)));
+  gridSize = std::max(1, std::min(gridSize, MAX_GRID_SIZE));
+
+  airspace.minX = minX;
+  airspace.minY = minY;
+  airspace.columns = airspace.rows = gridSize;
+  airspace.cellWidth = std::max((maxX - minX) / gridSize, 1.e-6f);
+  airspace.cellHeight = std::max((maxY - minY) / gridSize, 1.e-6f);
+
+  const QVector<float>& xs = airspace.xs;
+  const QVector<float>& ys = airspace.ys;
+  int numCells = gridSize * gridSize;
+
+  // Count edges per cell in first pass and fill the edge lists in second pass
+  // Cells are selected by the edge bounding rectangle which adds a few more edges than needed
+  airspace.cellStart.fill(0, numCells + 1);
+  QVector<int> fillPos;
+  for(int pass = 0; pass < 2; pass++)
+  {
+    for(int i = 0; i < size; i++)
+    {
+      int j = i < size - 1 ? i + 1 : 0;
+      int col1 = cellColumn(airspace, std::min(xs.at(i), xs.at(j)));
+      int col2 = cellColumn(airspace, std::max(xs.at(i), xs.at(j)));
+      int row1 = cellRow(airspace, std::min(ys.at(i), ys.at(j)));
+      int row2 = cellRow(airspace, std::max(ys.at(i), ys.at(j)));
+
+      for(int row = row1; row <= row2; row++)
+      {
+        for(int col = col1; col <= col2; col++)
+        {
+          int cell = row * gridSize + col;
+          if(pass == 0)
+            airspace.cellStart[cell + 1]++;
+          else
+            airspace.cellEdges[fillPos[cell]++] = i;
+        }
+      }
+    }
+
+    if(pass == 0)
+    {
+      for(int cell = 0; cell < numCells; cell++)
+        airspace.cellStart[cell + 1] += airspace.cellStart.at(cell);
+      airspace.cellEdges.resize(airspace.cellStart.at(numCells));
+      fillPos = airspace.cellStart.mid(0, numCells);
+    }
+  }
+
+  // Get inside state for cell centers by casting a ray towards east for each row
+  airspace.cellCenterInside.fill(false, numCells);
+  QVector<float> crossingsX;
+  for(int row = 0; row < gridSize; row++)
+  {
+    float y = minY + (row + 0.5f) * airspace.cellHeight;
+
+    crossingsX.clear();
+    for(int i = 0, j = size - 1; i < size; j = i++)
+    {
+      if((ys.at(i) > y) != (ys.at(j) > y))
+        crossingsX.append(xs.at(i) + (y - ys.at(i)) * (xs.at(j) - xs.at(i)) / (ys.at(j) - ys.at(i)));
+    }
+    std::sort(crossingsX.begin(), crossingsX.end());
+
+    for(int col = 0; col < gridSize; col++)
+    {
+      float x = minX + (col + 0.5f) * airspace.cellWidth;
+      long numEast = crossingsX.constEnd() - std::upper_bound(crossingsX.constBegin(), crossingsX.constEnd(), x);
+      airspace.cellCenterInside[row * gridSize + col] = numEast % 2 == 1;
+    }
+  }
+}
+
+bool AirspaceIndex::containsPos(const Airspace& airspace, const Pos& pos)
+{
+  float x = relativeLonX(pos, airspace.refLonX), y = pos.getLatY();
+  if(x < airspace.minX || x > airspace.minX + airspace.columns * airspace.cellWidth ||
+     y < airspace.minY || y > airspace.minY + airspace.rows * airspace.cellHeight)
+    return false;
+
+  int col = cellColumn(airspace, x), row = cellRow(airspace, y);
+  int cell = row * airspace.columns + col;
+  float centerX = airspace.minX + (col + 0.5f) * airspace.cellWidth;
+  float centerY = airspace.minY + (row + 0.5f) * airspace.cellHeight;
+
+  // Start with the state of the cell center and toggle it for each edge crossed on the way to pos
+  bool inside = airspace.cellCenterInside.at(cell);
+  const QVector<float>& xs = airspace.xs;
+  const QVector<float>& ys = airspace.ys;
+  int size = xs.size();
+  for(int k = airspace.cellStart.at(cell); k < airspace.cellStart.at(cell + 1); k++)
+  {
+    int i = airspace.cellEdges.at(k), j = i < size - 1 ? i + 1 : 0;
+    if(crossingParameter(centerX, centerY, x, y, xs.at(i), ys.at(i), xs.at(j), ys.at(j)) >= 0.f)
+      inside = !inside;
+  }
+  return inside;
+}
+
+void AirspaceIndex::segmentCrossings(QVector<float>& fractions, const Airspace& airspace, const Pos& p1, const Pos& p2,
+                                     bool firstOnly)
+{
+  // Plane of the polygon - end point is relative to start to avoid jumps at the anti-meridian
+  float ax = relativeLonX(p1, airspace.refLonX), ay = p1.getLatY();
+  float bx = ax + atools::geo::normalizeLonXDeg(p2.getLonX() - p1.getLonX()), by = p2.getLatY();
+
+  float segMinY = std::min(ay, by), segMaxY = std::max(ay, by);
+  if(std::max(ax, bx) < airspace.minX || std::min(ax, bx) > airspace.minX + airspace.columns * airspace.cellWidth ||
+     segMaxY < airspace.minY || segMinY > airspace.minY + airspace.rows * airspace.cellHeight)
+    return;
+
+  // Collect edges of all cells along the segment row by row
+  QVector<int> edges;
+  int row1 = cellRow(airspace, segMinY), row2 = cellRow(airspace, segMaxY);
+  for(int row = row1; row <= row2; row++)
+  {
+    // Part of the segment within the row
+    float rowMinY = std::max(segMinY, airspace.minY + row * airspace.cellHeight);
+    float rowMaxY = std::min(segMaxY, airspace.minY + (row + 1) * airspace.cellHeight);
+    float x1 = ax, x2 = bx;
+    if(by != ay)
+    {
+      x1 = ax + (rowMinY - ay) / (by - ay) * (bx - ax);
+      x2 = ax + (rowMaxY - ay) / (by - ay) * (bx - ax);
+    }
+
+    int col1 = cellColumn(airspace, std::min(x1, x2)), col2 = cellColumn(airspace, std::max(x1, x2));
+    for(int col = col1; col <= col2; col++)
+    {
+      int cell = row * airspace.columns + col;
+      for(int k = airspace.cellStart.at(cell); k < airspace.cellStart.at(cell + 1); k++)
+        edges.append(airspace.cellEdges.at(k));
+    }
+  }
+
+  // Edges can be in more than one cell
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  const QVector<float>& xs = airspace.xs;
+  const QVector<float>& ys = airspace.ys;
+  int size = xs.size();
+  for(int i : edges)
+  {
+    int j = i < size - 1 ? i + 1 : 0;
+    float fraction = crossingParameter(ax, ay, bx, by, xs.at(i), ys.at(i), xs.at(j), ys.at(j));
+    if(fraction >= 0.f)
+    {
+      fractions.append(fraction);
+      if(firstOnly)
+        return;
+    }
+  }
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,172 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_AIRSPACEINDEX_H
+#define ATOOLS_FS_COMMON_AIRSPACEINDEX_H
+
+#include "geo/linestring.h"
+#include "geo/rtree.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/* Crossing of an airspace boundary by a line segment */
+struct AirspaceCrossing
+{
+  /* Airspace id as given in addAirspace() */
+  int id;
+
+  /* Position along the segment from 0 (start) to 1 (end) */
+  float fraction;
+
+  /* Crossing position in the lon/lat plane */
+  atools::geo::Pos pos;
+
+  /* true if segment enters the airspace here */
+  bool entering;
+};
+
+/*
+ * In-memory index for airspace boundaries to avoid the bounding rectangle SQL queries and
+ * polygon tests one by one when checking routes for airspace crossings.
+ *
+ * Bounding rectangles are kept in an R-tree. Candidates are tested against the exact polygon afterwards.
+ * Polygon tests use the plain lon/lat plane like the map display. Anti-meridian crossing polygons are supported.
+ *
+ * Each polygon is converted into a uniform grid over its bounding rectangle which keeps the edges touching
+ * each cell and whether the cell center is inside. A position test only has to check the edges of one cell and
+ * a segment test only the edges of the cells along the segment. This keeps queries fast for detailed
+ * polygons with thousands of points.
+ *
+ * Results contain the ids given in addAirspace() which is boundary_id when loaded from the database.
+ *
+ * Query methods are const and can be called from several threads once the index is built.
+ */
+class AirspaceIndex
+{
+public:
+  AirspaceIndex();
+  ~AirspaceIndex();
+
+  /* Read all airspaces from the given table with the layout of "boundary" and build the index.
+   * Null altitudes are treated as unlimited. */
+  void loadFromDatabase(atools::sql::SqlDatabase *db, const QString& table = "boundary");
+
+  /* Add airspace polygon. Call build() when done. Altitudes in feet. */
+  void addAirspace(int id, const atools::geo::LineString& polygon,
+                   float minAltitudeFt = std::numeric_limits<float>::lowest(),
+                   float maxAltitudeFt = std::numeric_limits<float>::max());
+
+  /* Build the R-tree after adding airspaces */
+  void build();
+
+  void clear();
+
+  int size() const
+  {
+    return airspaces.size();
+  }
+
+  bool isEmpty() const
+  {
+    return airspaces.isEmpty();
+  }
+
+  /* Get all airspaces which contain the position and where altitude is within the vertical limits.
+   * Altitude is ignored if not given. Ids are sorted. */
+  void getAirspacesAtPos(QVector<int>& ids, const atools::geo::Pos& pos,
+                         float altitudeFt = std::numeric_limits<float>::max()) const;
+
+  /* Get all airspaces which are crossed or touched by line or contain it
+   * and have an overlapping altitude range. Ids are sorted. */
+  void getAirspacesForLine(QVector<int>& ids, const atools::geo::LineString& line,
+                           float minAltitudeFt = std::numeric_limits<float>::lowest(),
+                           float maxAltitudeFt = std::numeric_limits<float>::max()) const;
+
+  /* Get all boundary crossings of the segment from p1 to p2 for airspaces having an overlapping altitude range.
+   * Airspaces containing p1 get an entering crossing at fraction 0 and airspaces containing p2 an exit at
+   * fraction 1. This way each airspace always has pairs of entry and exit. Sorted by fraction and id. */
+  void getCrossings(QVector<atools::fs::common::AirspaceCrossing>& crossings, const atools::geo::Pos& p1,
+                    const atools::geo::Pos& p2, float minAltitudeFt = std::numeric_limits<float>::lowest(),
+                    float maxAltitudeFt = std::numeric_limits<float>::max()) const;
+
+private:
+  /* Polygon in a plane with longitudes relative to refLonX with edge grid */
+  struct Airspace
+  {
+    int id;
+    float minAltitudeFt, maxAltitudeFt;
+
+    float refLonX;
+    QVector<float> xs, ys;
+
+    /* Grid origin, cell size and number of cells */
+    float minX, minY, cellWidth, cellHeight;
+    int columns, rows;
+
+    /* Edge indexes for each cell. Edges for cell i are cellEdges[cellStart[i]] to cellEdges[cellStart[i + 1] - 1].
+     * Edge i goes from vertex i to vertex i + 1. */
+    QVector<int> cellStart, cellEdges;
+
+    /* Cell center is inside of polygon */
+    QVector<bool> cellCenterInside;
+  };
+
+  /* Grid cell for plane coordinate. Clamped to grid bounds. */
+  static int cellColumn(const Airspace& airspace, float x)
+  {
+    return std::max(0, std::min(static_cast<int>((x - airspace.minX) / airspace.cellWidth), airspace.columns - 1));
+  }
+
+  static int cellRow(const Airspace& airspace, float y)
+  {
+    return std::max(0, std::min(static_cast<int>((y - airspace.minY) / airspace.cellHeight), airspace.rows - 1));
+  }
+
+  /* Fills plane coordinates and the edge grid */
+  static void buildGrid(Airspace& airspace, const atools::geo::LineString& polygon);
+
+  /* Point in polygon test using the grid */
+  static bool containsPos(const Airspace& airspace, const atools::geo::Pos& pos);
+
+  /* Collect segment parameters of all crossings from p1 to p2 into fractions. Returns fractions unsorted.
+   * Stops after the first crossing if firstOnly is true. */
+  static void segmentCrossings(QVector<float>& fractions, const Airspace& airspace, const atools::geo::Pos& p1,
+                               const atools::geo::Pos& p2, bool firstOnly);
+
+  /* Average number of edges per grid cell and maximum number of cells in one direction */
+  static Q_DECL_CONSTEXPR int EDGES_PER_CELL = 4;
+  static Q_DECL_CONSTEXPR int MAX_GRID_SIZE = 64;
+
+  /* Index into R-tree is index of vector */
+  QVector<Airspace> airspaces;
+  atools::geo::RTree tree;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_AIRSPACEINDEX_H
@@ -18,6 +18,9 @@
 #include "fs/common/binarygeometry.h"
 
 #include <QDataStream>
+#include <QtEndian>
+
+#include <cstring>
 
 namespace atools {
 namespace fs {
@@ -39,37 +42,393 @@ BinaryGeometry::BinaryGeometry()
 
 }
 
-void BinaryGeometry::readFromByteArray(const QByteArray& bytes)
+Q_DECL_CONSTEXPR quint32 BinaryGeometry::LOD_MAGIC_NUMBER;
+Q_DECL_CONSTEXPR int BinaryGeometry::LOD_MIN_POINTS;
+Q_DECL_CONSTEXPR quint32 BinaryGeometry::PACKED_MAGIC_NUMBER;
+Q_DECL_CONSTEXPR quint8 BinaryGeometry::PACKED_VERSION;
+Q_DECL_CONSTEXPR quint8 BinaryGeometry::PACKED_FLAG_BOUNDING;
+Q_DECL_CONSTEXPR int BinaryGeometry::PACKED_HEADER_SIZE;
+Q_DECL_CONSTEXPR int BinaryGeometry::PACKED_LEVEL_HEADER_SIZE;
+Q_DECL_CONSTEXPR int BinaryGeometry::PACKED_POINT_SIZE;
+
+/* Little endian float helpers for the packed format. memcpy avoids alignment and aliasing issues. */
+static inline float readFloatLe(const char *data)
 {
-  geometry.clear();
+  quint32 bits = qFromLittleEndian<quint32>(data);
+  float value;
+  std::memcpy(&value, &bits, sizeof(float));
+  return value;
+}
 
-  QDataStream in(bytes);
-  in.setVersion(QDataStream::Qt_5_5);
-  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+static inline void writeFloatLe(float value, char *data)
+{
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  qToLittleEndian<quint32>(bits, data);
+}
+
+/* Bounding rectangle from packed header or invalid if not set */
+static atools::geo::Rect packedBoundingRect(const char *header, quint8 flagBounding)
+{
+  if(static_cast<quint8>(header[5]) & flagBounding)
+    return atools::geo::Rect(readFloatLe(header + 12), readFloatLe(header + 16),
+                             readFloatLe(header + 20), readFloatLe(header + 24));
+  else
+    return atools::geo::Rect();
+}
 
+void BinaryGeometry::readPositions(QDataStream& in, atools::geo::LineString& positions)
+{
   quint32 size;
   float lonx, laty;
   in >> size;
+
+  // Fill contiguous storage allocated once
+  positions.resize(static_cast<int>(size));
+  atools::geo::Pos *data = positions.data();
   for(unsigned int i = 0; i < size; i++)
   {
     in >> lonx >> laty;
-    geometry.append(lonx, laty);
+    data[i] = atools::geo::Pos(lonx, laty);
+  }
+}
+
+void BinaryGeometry::writePositions(QDataStream& out, const atools::geo::LineString& positions)
+{
+  out << static_cast<quint32>(positions.size());
+  for(const atools::geo::Pos& pos : positions)
+    out << pos.getLonX() << pos.getLatY();
+}
+
+bool BinaryGeometry::readPackedPositions(const char *& data, const char *end, int numPoints,
+                                         atools::geo::LineString& positions)
+{
+  if(numPoints < 0 || (end - data) / PACKED_POINT_SIZE < numPoints)
+    return false;
+
+  positions.resize(numPoints);
+  atools::geo::Pos *posData = positions.data();
+  for(int i = 0; i < numPoints; i++, data += PACKED_POINT_SIZE)
+    posData[i] = atools::geo::Pos(readFloatLe(data), readFloatLe(data + 4));
+  return true;
+}
+
+void BinaryGeometry::writePackedPositions(char *data, const atools::geo::LineString& positions)
+{
+  for(const atools::geo::Pos& pos : positions)
+  {
+    writeFloatLe(pos.getLonX(), data);
+    writeFloatLe(pos.getLatY(), data + 4);
+    data += PACKED_POINT_SIZE;
+  }
+}
+
+int BinaryGeometry::packedNumPoints(const QByteArray& bytes)
+{
+  if(bytes.size() < PACKED_HEADER_SIZE)
+    return -1;
+
+  const char *data = bytes.constData();
+  if(qFromLittleEndian<quint32>(data) != PACKED_MAGIC_NUMBER || static_cast<quint8>(data[4]) != PACKED_VERSION)
+    return -1;
+
+  qint64 numPoints = qFromLittleEndian<quint32>(data + 8);
+  if(PACKED_HEADER_SIZE + numPoints * PACKED_POINT_SIZE > bytes.size())
+    return -1;
+
+  return static_cast<int>(numPoints);
+}
+
+bool BinaryGeometry::isPacked(const QByteArray& bytes)
+{
+  return packedNumPoints(bytes) != -1;
+}
+
+atools::geo::Rect BinaryGeometry::readBoundingRectFromByteArray(const QByteArray& bytes)
+{
+  if(isPacked(bytes))
+    return packedBoundingRect(bytes.constData(), PACKED_FLAG_BOUNDING);
+  else
+    return BinaryGeometry(bytes).getGeometry().boundingRect();
+}
+
+void BinaryGeometry::readPacked(const QByteArray& bytes)
+{
+  const char *data = bytes.constData() + PACKED_HEADER_SIZE, *end = bytes.constData() + bytes.size();
+  readPackedPositions(data, end, packedNumPoints(bytes), geometry);
+
+  int numLevels = qFromLittleEndian<quint16>(bytes.constData() + 6);
+  levels.resize(numLevels);
+  for(int i = 0; i < numLevels; i++)
+  {
+    if(end - data < PACKED_LEVEL_HEADER_SIZE)
+    {
+      levels.clear();
+      break;
+    }
+
+    int numPoints = static_cast<int>(qFromLittleEndian<quint32>(data));
+    data += PACKED_LEVEL_HEADER_SIZE;
+    if(!readPackedPositions(data, end, numPoints, levels[i]))
+    {
+      levels.clear();
+      break;
+    }
+  }
+}
+
+QByteArray BinaryGeometry::writePacked() const
+{
+  int size = PACKED_HEADER_SIZE + geometry.size() * PACKED_POINT_SIZE;
+  for(const atools::geo::LineString& level : levels)
+    size += PACKED_LEVEL_HEADER_SIZE + level.size() * PACKED_POINT_SIZE;
+
+  // Reserved header fields and padding are zero
+  QByteArray bytes(size, '\0');
+  char *data = bytes.data();
+
+  atools::geo::Rect rect = geometry.boundingRect();
+  qToLittleEndian<quint32>(PACKED_MAGIC_NUMBER, data);
+  data[4] = static_cast<char>(PACKED_VERSION);
+  data[5] = static_cast<char>(rect.isValid() ? PACKED_FLAG_BOUNDING : 0);
+  qToLittleEndian<quint16>(static_cast<quint16>(levels.size()), data + 6);
+  qToLittleEndian<quint32>(static_cast<quint32>(geometry.size()), data + 8);
+
+  if(rect.isValid())
+  {
+    writeFloatLe(rect.getWest(), data + 12);
+    writeFloatLe(rect.getNorth(), data + 16);
+    writeFloatLe(rect.getEast(), data + 20);
+    writeFloatLe(rect.getSouth(), data + 24);
+  }
+
+  data += PACKED_HEADER_SIZE;
+  writePackedPositions(data, geometry);
+  data += geometry.size() * PACKED_POINT_SIZE;
+
+  for(const atools::geo::LineString& level : levels)
+  {
+    qToLittleEndian<quint32>(static_cast<quint32>(level.size()), data);
+    data += PACKED_LEVEL_HEADER_SIZE;
+    writePackedPositions(data, level);
+    data += level.size() * PACKED_POINT_SIZE;
+  }
+  return bytes;
+}
+
+atools::geo::LineString BinaryGeometry::readPackedLevel(const QByteArray& bytes, int level)
+{
+  atools::geo::LineString positions;
+  int numPoints = packedNumPoints(bytes);
+  const char *data = bytes.constData() + PACKED_HEADER_SIZE, *end = bytes.constData() + bytes.size();
+
+  int numLevels = qFromLittleEndian<quint16>(bytes.constData() + 6);
+  if(level > 0 && numLevels > 0)
+  {
+    // Skip full geometry and finer levels
+    const char *levelData = data + numPoints * PACKED_POINT_SIZE;
+    int readLevel = std::min(level, numLevels);
+    bool ok = true;
+    for(int i = 1; i <= readLevel && ok; i++)
+    {
+      if(end - levelData < PACKED_LEVEL_HEADER_SIZE)
+      {
+        ok = false;
+        break;
+      }
+
+      int num = static_cast<int>(qFromLittleEndian<quint32>(levelData));
+      levelData += PACKED_LEVEL_HEADER_SIZE;
+
+      if(i < readLevel)
+      {
+        if((end - levelData) / PACKED_POINT_SIZE < num)
+          ok = false;
+        else
+          levelData += num * PACKED_POINT_SIZE;
+      }
+      else
+        ok = readPackedPositions(levelData, end, num, positions);
+    }
+
+    if(ok)
+      return positions;
+
+    // Fall back to full geometry
+    positions.clear();
   }
+
+  readPackedPositions(data, end, numPoints, positions);
+  return positions;
 }
 
-QByteArray BinaryGeometry::writeToByteArray() const
+void BinaryGeometry::readFromByteArray(const QByteArray& bytes)
 {
+  geometry.clear();
+  levels.clear();
+
+  if(isPacked(bytes))
+  {
+    readPacked(bytes);
+    return;
+  }
+
+  QDataStream in(bytes);
+  in.setVersion(QDataStream::Qt_5_5);
+  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  readPositions(in, geometry);
+
+  if(in.status() != QDataStream::Ok)
+    geometry.clear();
+  else if(!in.atEnd())
+  {
+    // Read optional levels of detail
+    quint32 magic;
+    quint8 numLevels;
+    in >> magic >> numLevels;
+    if(magic == LOD_MAGIC_NUMBER)
+    {
+      levels.resize(numLevels);
+      for(atools::geo::LineString& level : levels)
+        readPositions(in, level);
+    }
+
+    if(in.status() != QDataStream::Ok)
+      levels.clear();
+  }
+}
+
+QByteArray BinaryGeometry::writeToByteArray(Format format) const
+{
+  if(format == FORMAT_PACKED)
+    return writePacked();
+
   QByteArray bytes;
   QDataStream out(&bytes, QIODevice::WriteOnly);
   out.setVersion(QDataStream::Qt_5_5);
   out.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-  out << static_cast<quint32>(geometry.size());
-  for(const atools::geo::Pos& pos : qAsConst(geometry))
-    out << pos.getLonX() << pos.getLatY();
+  writePositions(out, geometry);
+
+  if(!levels.isEmpty())
+  {
+    out << LOD_MAGIC_NUMBER << static_cast<quint8>(levels.size());
+    for(const atools::geo::LineString& level : levels)
+      writePositions(out, level);
+  }
   return bytes;
 }
 
+void BinaryGeometry::buildLevelsOfDetail(const QVector<float>& tolerancesMeter)
+{
+  levels.clear();
+  if(geometry.size() < LOD_MIN_POINTS)
+    return;
+
+  atools::geo::LineString simplified = geometry;
+  for(float tolerance : tolerancesMeter)
+  {
+    int lastSize = simplified.size();
+    simplified.simplifyDouglasPeucker(tolerance);
+
+    if(simplified.size() < 3)
+      break;
+
+    if(simplified.size() <= lastSize / 2)
+      levels.append(simplified);
+    else if(!levels.isEmpty())
+      // Keep base of next level
+      simplified = levels.constLast();
+    else
+      simplified = geometry;
+  }
+}
+
+atools::geo::LineString BinaryGeometry::readLevelFromByteArray(const QByteArray& bytes, int level)
+{
+  if(isPacked(bytes))
+    return readPackedLevel(bytes, level);
+
+  atools::geo::LineString positions;
+  QDataStream in(bytes);
+  in.setVersion(QDataStream::Qt_5_5);
+  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  if(level > 0)
+  {
+    // Skip full geometry
+    quint32 size;
+    in >> size;
+    in.skipRawData(static_cast<int>(size * 2 * sizeof(float)));
+
+    quint32 magic = 0;
+    quint8 numLevels = 0;
+    if(!in.atEnd())
+      in >> magic >> numLevels;
+
+    if(in.status() == QDataStream::Ok && magic == LOD_MAGIC_NUMBER && numLevels > 0)
+    {
+      // Skip finer levels and read the requested one
+      int readLevel = std::min(level, static_cast<int>(numLevels));
+      for(int i = 1; i < readLevel; i++)
+      {
+        in >> size;
+        in.skipRawData(static_cast<int>(size * 2 * sizeof(float)));
+      }
+      readPositions(in, positions);
+
+      if(in.status() == QDataStream::Ok)
+        return positions;
+    }
+
+    // No levels of detail - read full geometry from start
+    in.device()->seek(0);
+    in.resetStatus();
+  }
+
+  readPositions(in, positions);
+  if(in.status() != QDataStream::Ok)
+    positions.clear();
+  return positions;
+}
+
+// ====================================================================================================
+BinaryGeometryView::BinaryGeometryView(const QByteArray& bytes)
+  : data(bytes)
+{
+  int num = BinaryGeometry::packedNumPoints(data);
+  if(num != -1)
+  {
+    // Shallow copy - pointer stays valid as long as data is not modified
+    numPoints = num;
+    points = data.constData() + BinaryGeometry::PACKED_HEADER_SIZE;
+    bounding = packedBoundingRect(data.constData(), BinaryGeometry::PACKED_FLAG_BOUNDING);
+  }
+}
+
+float BinaryGeometryView::getLonX(int index) const
+{
+  return readFloatLe(points + index * BinaryGeometry::PACKED_POINT_SIZE);
+}
+
+float BinaryGeometryView::getLatY(int index) const
+{
+  return readFloatLe(points + index * BinaryGeometry::PACKED_POINT_SIZE + 4);
+}
+
+atools::geo::LineString BinaryGeometryView::toLineString() const
+{
+  atools::geo::LineString positions;
+  if(points != nullptr)
+  {
+    const char *pointData = points;
+    BinaryGeometry::readPackedPositions(pointData, pointData + numPoints * BinaryGeometry::PACKED_POINT_SIZE,
+                                        numPoints, positions);
+  }
+  return positions;
+}
+
 } // namespace common
 } // namespace fs
 } // namespace atools
@@ -19,8 +19,11 @@
 #define ATOOLS_BINARYGEOMETRY_H
 
 #include "geo/linestring.h"
+#include "geo/rect.h"
 
-class QByteArray;
+#include <QByteArray>
+
+class QDataStream;
 
 namespace atools {
 namespace fs {
@@ -31,10 +34,30 @@ namespace common {
  *
  * Writes a simple lat/long (not altitude) list in single floating point precision into a byte array which can be used
  * to write and read it into and from a database BLOB.
+ *
+ * Optional coarser levels of detail are appended after the full geometry. Readers not knowing about these
+ * ignore the trailing data. Level 0 is always the full geometry.
+ *
+ * Two formats are supported and detected when reading:
+ *
+ * FORMAT_STREAM: QDataStream big endian. Readable by all versions.
+ *
+ * FORMAT_PACKED: Fixed 32 byte header followed by little endian float32 lon/lat pairs. Each level of detail has
+ * an eight byte header. All parts are aligned to eight bytes.
+ * Header: quint32 magic, quint8 version, quint8 flags, quint16 number of levels, quint32 number of points,
+ * float32 west, north, east, south of the bounding rectangle, quint32 reserved.
+ * Can be accessed using BinaryGeometryView without decoding and the bounding rectangle can be read without
+ * touching the coordinates.
  */
 class BinaryGeometry
 {
 public:
+  enum Format
+  {
+    FORMAT_STREAM,
+    FORMAT_PACKED
+  };
+
   BinaryGeometry();
 
   /* Sets line string geometry and does nothing else */
@@ -44,7 +67,15 @@ public:
   BinaryGeometry(const QByteArray& bytes);
 
   void readFromByteArray(const QByteArray& bytes);
-  QByteArray writeToByteArray() const;
+
+  /* Use FORMAT_STREAM for databases which might be read by older versions */
+  QByteArray writeToByteArray(atools::fs::common::BinaryGeometry::Format format = FORMAT_STREAM) const;
+
+  /* true if bytes contain the packed format */
+  static bool isPacked(const QByteArray& bytes);
+
+  /* Bounding rectangle of full geometry. Read from the header for the packed format. Stream format needs decoding. */
+  static atools::geo::Rect readBoundingRectFromByteArray(const QByteArray& bytes);
 
   const atools::geo::LineString& getGeometry() const
   {
@@ -59,10 +90,116 @@ public:
   void setGeometry(const atools::geo::LineString& value)
   {
     geometry = value;
+    levels.clear();
+  }
+
+  /* Build simplified levels of detail with increasing Douglas-Peucker tolerances in meter.
+   * Nothing is done for small geometries and levels not reducing the number of points by half are omitted. */
+  void buildLevelsOfDetail(const QVector<float>& tolerancesMeter = {1000.f, 5000.f, 20000.f});
+
+  /* Number of levels including full geometry at level 0 */
+  int getNumLevels() const
+  {
+    return levels.size() + 1;
   }
 
+  /* Level 0 is the full geometry */
+  const atools::geo::LineString& getLevel(int level) const
+  {
+    return level <= 0 || levels.isEmpty() ? geometry : levels.at(std::min(level, levels.size()) - 1);
+  }
+
+  /* Read only the given level of detail from byte array and skip the full geometry if possible.
+   * Returns the coarsest level if level is larger than available levels and the full geometry for level 0. */
+  static atools::geo::LineString readLevelFromByteArray(const QByteArray& bytes, int level);
+
 private:
+  friend class BinaryGeometryView;
+
+  /* Identifies the level of detail block after the full geometry */
+  static Q_DECL_CONSTEXPR quint32 LOD_MAGIC_NUMBER = 0x4C4F4431;
+
+  /* Geometries with less points do not get levels of detail */
+  static Q_DECL_CONSTEXPR int LOD_MIN_POINTS = 256;
+
+  /* Packed format. Magic is "GEO2" in little endian which can never be a valid point count in stream format. */
+  static Q_DECL_CONSTEXPR quint32 PACKED_MAGIC_NUMBER = 0x324F4547;
+  static Q_DECL_CONSTEXPR quint8 PACKED_VERSION = 1;
+  static Q_DECL_CONSTEXPR quint8 PACKED_FLAG_BOUNDING = 0x01;
+  static Q_DECL_CONSTEXPR int PACKED_HEADER_SIZE = 32;
+  static Q_DECL_CONSTEXPR int PACKED_LEVEL_HEADER_SIZE = 8;
+  static Q_DECL_CONSTEXPR int PACKED_POINT_SIZE = 8;
+
+  static void readPositions(QDataStream& in, atools::geo::LineString& positions);
+  static void writePositions(QDataStream& out, const atools::geo::LineString& positions);
+
+  /* Read points from packed data. Returns false if the data is too short. */
+  static bool readPackedPositions(const char *& data, const char *end, int numPoints,
+                                  atools::geo::LineString& positions);
+  static void writePackedPositions(char *data, const atools::geo::LineString& positions);
+
+  /* Checks header and returns the number of points of the full geometry or -1 if bytes are not packed or too short */
+  static int packedNumPoints(const QByteArray& bytes);
+
+  void readPacked(const QByteArray& bytes);
+  QByteArray writePacked() const;
+  static atools::geo::LineString readPackedLevel(const QByteArray& bytes, int level);
+
   atools::geo::LineString geometry;
+
+  /* Coarser levels of detail with level 1 at index 0 */
+  QVector<atools::geo::LineString> levels;
+};
+
+/*
+ * Read only view on the full geometry of a packed BinaryGeometry blob. Does not copy or decode coordinates and
+ * keeps a shallow copy of the byte array. Positions are converted on access.
+ *
+ * isValid() is false for stream format blobs which have to be read using BinaryGeometry.
+ */
+class BinaryGeometryView
+{
+public:
+  explicit BinaryGeometryView(const QByteArray& bytes);
+
+  bool isValid() const
+  {
+    return points != nullptr;
+  }
+
+  /* Number of positions in the full geometry */
+  int size() const
+  {
+    return numPoints;
+  }
+
+  bool isEmpty() const
+  {
+    return numPoints == 0;
+  }
+
+  float getLonX(int index) const;
+  float getLatY(int index) const;
+
+  atools::geo::Pos at(int index) const
+  {
+    return atools::geo::Pos(getLonX(index), getLatY(index));
+  }
+
+  /* Bounding rectangle from header */
+  const atools::geo::Rect& getBoundingRect() const
+  {
+    return bounding;
+  }
+
+  /* Decode into a line string */
+  atools::geo::LineString toLineString() const;
+
+private:
+  QByteArray data;
+  const char *points = nullptr;
+  int numPoints = 0;
+  atools::geo::Rect bounding;
 };
 
 } // namespace common
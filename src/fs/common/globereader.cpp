@@ -22,11 +22,16 @@
 #include "geo/pos.h"
 #include "geo/linestring.h"
 #include "geo/line.h"
+#include "geo/rect.h"
 
+#include <algorithm>
 #include <cmath>
 #include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QHash>
+#include <QSaveFile>
+#include <QtEndian>
 
 using atools::geo::Pos;
 using atools::geo::Line;
@@ -36,12 +41,54 @@ namespace atools {
 namespace fs {
 namespace common {
 
+/* File index and byte offset of a sample for batch reads */
+struct GlobeSample
+{
+  int fileIndex;
+  qint64 offset;
+
+  /* Index in result vector */
+  int resultIndex;
+};
+
+/* Pyramid file header. All values little endian:
+ * quint32 magic, quint32 version, quint32 tile columns, quint32 tile rows, quint32 levels, quint32 minimum factor,
+ * qint64 tile file size, qint64 tile last modified milliseconds since epoch */
+static const quint32 PYRAMID_MAGIC = 0x58504C47;
+static const quint32 PYRAMID_VERSION = 1;
+static const int PYRAMID_HEADER_SIZE = 40;
+
+/* Downsample by two using the maximum. Getter returns the value for column and row of the source. */
+template<typename GETTER>
+static QVector<qint16> reduceMax(const GETTER& getter, int cols, int rows, int& newCols, int& newRows)
+{
+  newCols = (cols + 1) / 2;
+  newRows = (rows + 1) / 2;
+  QVector<qint16> result(newCols * newRows);
+
+  for(int row = 0; row < newRows; row++)
+  {
+    int row0 = row * 2, row1 = std::min(row0 + 1, rows - 1);
+    for(int col = 0; col < newCols; col++)
+    {
+      int col0 = col * 2, col1 = std::min(col0 + 1, cols - 1);
+      result[row * newCols + col] = std::max(std::max(getter(col0, row0), getter(col1, row0)),
+                                             std::max(getter(col0, row1), getter(col1, row1)));
+    }
+  }
+  return result;
+}
+
 GlobeReader::GlobeReader(const QString& dataDirParam)
   : dataDir(dataDirParam)
 {
   dataFiles.fill(nullptr, NUM_DATAFILES);
   dataStreams.fill(nullptr, NUM_DATAFILES);
+  dataMaps.fill(nullptr, NUM_DATAFILES);
   dataFilenames.fill(QString(), NUM_DATAFILES);
+  pyramidFiles.fill(nullptr, NUM_DATAFILES);
+  pyramidMaps.fill(nullptr, NUM_DATAFILES);
+  pyramidChecked.fill(false, NUM_DATAFILES);
 }
 
 GlobeReader::~GlobeReader()
@@ -105,6 +152,11 @@ void GlobeReader::openFile(int i)
     dataFiles[i] = new QFile(name);
     if(dataFiles[i]->open(QIODevice::ReadOnly))
     {
+      // Map whole file if possible - reading elevations is a pointer access then
+      dataMaps[i] = dataFiles[i]->map(0, dataFiles[i]->size());
+      if(dataMaps[i] == nullptr)
+        qWarning() << Q_FUNC_INFO << "Cannot map file" << name << dataFiles[i]->errorString();
+
       dataStreams[i] = new QDataStream(dataFiles[i]);
       dataStreams[i]->setByteOrder(QDataStream::LittleEndian);
     }
@@ -128,6 +180,10 @@ void GlobeReader::closeFile(int i)
 
   if(dataFiles[i] != nullptr)
   {
+    if(dataMaps[i] != nullptr)
+      dataFiles[i]->unmap(const_cast<uchar *>(dataMaps[i]));
+    dataMaps[i] = nullptr;
+
     dataFiles[i]->close();
     delete dataFiles[i];
     dataFiles[i] = nullptr;
@@ -137,7 +193,240 @@ void GlobeReader::closeFile(int i)
 void GlobeReader::closeFiles()
 {
   for(int i = 0; i < NUM_DATAFILES; i++)
+  {
     closeFile(i);
+    closePyramid(i);
+    pyramidChecked[i] = false;
+  }
+}
+
+void GlobeReader::closePyramid(int i)
+{
+  if(pyramidFiles[i] != nullptr)
+  {
+    if(pyramidMaps[i] != nullptr)
+      pyramidFiles[i]->unmap(const_cast<uchar *>(pyramidMaps[i]));
+    pyramidMaps[i] = nullptr;
+
+    pyramidFiles[i]->close();
+    delete pyramidFiles[i];
+    pyramidFiles[i] = nullptr;
+  }
+}
+
+void GlobeReader::setPyramidDir(const QString& dir)
+{
+  for(int i = 0; i < NUM_DATAFILES; i++)
+  {
+    closePyramid(i);
+    pyramidChecked[i] = false;
+  }
+  pyramidDir = dir;
+}
+
+QString GlobeReader::pyramidFilename(const QString& dir, int i) const
+{
+  return QDir(dir).filePath(QFileInfo(dataFilenames.at(i)).fileName() + ".max");
+}
+
+int GlobeReader::tileRows(int fileIndex)
+{
+  int fileRow = fileIndex / 4;
+  return fileRow == 0 || fileRow == 3 ? TILE_ROWS_SMALL : TILE_ROWS_LARGE;
+}
+
+void GlobeReader::pyramidLevelGeometry(int fileIndex, int level, int& levelCols, int& levelRows, qint64& offset)
+{
+  offset = PYRAMID_HEADER_SIZE;
+  for(int l = 0; l <= level; l++)
+  {
+    int factor = PYRAMID_MIN_FACTOR << l;
+    levelCols = (TILE_COLUMNS + factor - 1) / factor;
+    levelRows = (tileRows(fileIndex) + factor - 1) / factor;
+
+    if(l < level)
+      offset += static_cast<qint64>(levelCols) * levelRows * 2;
+  }
+}
+
+int GlobeReader::pyramidLevelForSpan(int span)
+{
+  int factor = span / PYRAMID_CELLS_ACROSS;
+  if(factor < PYRAMID_MIN_FACTOR)
+    return -1;
+
+  for(int level = 0; level < PYRAMID_LEVELS; level++)
+  {
+    if((PYRAMID_MIN_FACTOR << level) >= factor)
+      return level;
+  }
+  return PYRAMID_LEVELS - 1;
+}
+
+bool GlobeReader::pyramidValid(const uchar *header, qint64 fileSize, int i) const
+{
+  if(fileSize < PYRAMID_HEADER_SIZE)
+    return false;
+
+  int levelCols, levelRows;
+  qint64 offset;
+  pyramidLevelGeometry(i, PYRAMID_LEVELS - 1, levelCols, levelRows, offset);
+
+  QFileInfo tileInfo(dataFilenames.at(i));
+  return qFromLittleEndian<quint32>(header) == PYRAMID_MAGIC &&
+         qFromLittleEndian<quint32>(header + 4) == PYRAMID_VERSION &&
+         qFromLittleEndian<quint32>(header + 8) == static_cast<quint32>(TILE_COLUMNS) &&
+         qFromLittleEndian<quint32>(header + 12) == static_cast<quint32>(tileRows(i)) &&
+         qFromLittleEndian<quint32>(header + 16) == static_cast<quint32>(PYRAMID_LEVELS) &&
+         qFromLittleEndian<quint32>(header + 20) == static_cast<quint32>(PYRAMID_MIN_FACTOR) &&
+         qFromLittleEndian<qint64>(header + 24) == tileInfo.size() &&
+         qFromLittleEndian<qint64>(header + 32) == tileInfo.lastModified().toMSecsSinceEpoch() &&
+         fileSize == offset + static_cast<qint64>(levelCols) * levelRows * 2;
+}
+
+void GlobeReader::openPyramid(int i)
+{
+  if(pyramidChecked.at(i) || pyramidDir.isEmpty() || dataFilenames.at(i).isEmpty())
+    return;
+
+  pyramidChecked[i] = true;
+
+  QString filename = pyramidFilename(pyramidDir, i);
+  if(!QFile::exists(filename))
+    return;
+
+  QFile *file = new QFile(filename);
+  if(file->open(QIODevice::ReadOnly))
+  {
+    uchar *map = file->map(0, file->size());
+    if(map != nullptr && pyramidValid(map, file->size(), i))
+    {
+      qDebug() << Q_FUNC_INFO << filename;
+      pyramidFiles[i] = file;
+      pyramidMaps[i] = map;
+      return;
+    }
+  }
+
+  qWarning() << Q_FUNC_INFO << "Cannot use pyramid file" << filename << file->errorString();
+  file->close();
+  delete file;
+}
+
+bool GlobeReader::buildPyramid(const QString& dir)
+{
+  if(!valid)
+    return false;
+
+  if(!QDir().mkpath(dir))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot create" << dir;
+    return false;
+  }
+
+  bool ok = true;
+  for(int i = 0; i < NUM_DATAFILES; i++)
+  {
+    if(dataFilenames.at(i).isEmpty())
+      continue;
+
+    // Release mapping before replacing the file
+    closePyramid(i);
+
+    QString filename = pyramidFilename(dir, i);
+
+    // Check if file is up to date
+    QFile file(filename);
+    if(file.open(QIODevice::ReadOnly))
+    {
+      QByteArray header = file.read(PYRAMID_HEADER_SIZE);
+      qint64 size = file.size();
+      file.close();
+
+      if(header.size() == PYRAMID_HEADER_SIZE &&
+         pyramidValid(reinterpret_cast<const uchar *>(header.constData()), size, i))
+        continue;
+    }
+
+    ok &= buildPyramidFile(i, filename);
+  }
+
+  setPyramidDir(dir);
+  return ok;
+}
+
+bool GlobeReader::buildPyramidFile(int i, const QString& filename)
+{
+  qDebug() << Q_FUNC_INFO << filename;
+
+  openFile(i);
+  if(dataFiles.at(i) == nullptr)
+    return false;
+
+  int cols = TILE_COLUMNS, rows = tileRows(i);
+
+  // Use mapped tile or read whole file
+  QByteArray tileData;
+  const uchar *tile = dataMaps.at(i);
+  if(tile == nullptr)
+  {
+    dataFiles.at(i)->seek(0);
+    tileData = dataFiles.at(i)->readAll();
+    if(tileData.size() != cols * rows * 2)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot read" << dataFilenames.at(i);
+      return false;
+    }
+    tile = reinterpret_cast<const uchar *>(tileData.constData());
+  }
+
+  QSaveFile file(filename);
+  if(!file.open(QIODevice::WriteOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+
+  QFileInfo tileInfo(dataFilenames.at(i));
+  QByteArray header(PYRAMID_HEADER_SIZE, '\0');
+  uchar *headerData = reinterpret_cast<uchar *>(header.data());
+  qToLittleEndian<quint32>(PYRAMID_MAGIC, headerData);
+  qToLittleEndian<quint32>(PYRAMID_VERSION, headerData + 4);
+  qToLittleEndian<quint32>(static_cast<quint32>(cols), headerData + 8);
+  qToLittleEndian<quint32>(static_cast<quint32>(rows), headerData + 12);
+  qToLittleEndian<quint32>(static_cast<quint32>(PYRAMID_LEVELS), headerData + 16);
+  qToLittleEndian<quint32>(static_cast<quint32>(PYRAMID_MIN_FACTOR), headerData + 20);
+  qToLittleEndian<qint64>(tileInfo.size(), headerData + 24);
+  qToLittleEndian<qint64>(tileInfo.lastModified().toMSecsSinceEpoch(), headerData + 32);
+  file.write(header);
+
+  // First level downsampled by two is not saved
+  int levelCols, levelRows;
+  QVector<qint16> level = reduceMax([tile, cols](int col, int row) -> qint16 {
+    return qFromLittleEndian<qint16>(tile + (static_cast<qint64>(row) * cols + col) * 2);
+  }, cols, rows, levelCols, levelRows);
+
+  for(int l = 0; l < PYRAMID_LEVELS; l++)
+  {
+    const qint16 *prev = level.constData();
+    int prevCols = levelCols, prevRows = levelRows;
+    level = reduceMax([prev, prevCols](int col, int row) -> qint16 {
+      return prev[row * prevCols + col];
+    }, prevCols, prevRows, levelCols, levelRows);
+
+    QByteArray bytes(level.size() * 2, '\0');
+    uchar *levelData = reinterpret_cast<uchar *>(bytes.data());
+    for(int k = 0; k < level.size(); k++)
+      qToLittleEndian<qint16>(level.at(k), levelData + k * 2);
+    file.write(bytes);
+  }
+
+  if(!file.commit())
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << file.errorString();
+    return false;
+  }
+  return true;
 }
 
 float GlobeReader::getElevation(const atools::geo::Pos& pos, float sampleRadiusMeter)
@@ -156,8 +445,85 @@ float GlobeReader::getElevation(const atools::geo::Pos& pos, float sampleRadiusM
   }
 }
 
+bool GlobeReader::elevationMaxPyramid(const geo::Pos& pos, float sampleRadiusMeter, float& maxAlt)
+{
+  maxAlt = 0.f;
+  if(pyramidDir.isEmpty())
+    return false;
+
+  atools::geo::Rect rect(pos, sampleRadiusMeter, true /* fast */);
+
+  // Get split if crossing anti-meridian
+  for(const atools::geo::Rect& r : rect.splitAtAntiMeridian())
+  {
+    // Rectangle in global grid coordinates
+    int col0 = std::max(static_cast<int>(GRID_COLUMNS * (r.getWest() + 180.) / 360.), 0);
+    int col1 = std::min(static_cast<int>(GRID_COLUMNS * (r.getEast() + 180.) / 360.), GRID_COLUMNS - 1);
+    int row0 = std::max(static_cast<int>(GRID_ROWS * (90. - r.getNorth()) / 180.), 0);
+    int row1 = std::min(static_cast<int>(GRID_ROWS * (90. - r.getSouth()) / 180.), GRID_ROWS - 1);
+
+    int level = pyramidLevelForSpan(std::max(col1 - col0, row1 - row0) + 1);
+    if(level == -1)
+      // Too small for pyramid
+      return false;
+
+    int factor = PYRAMID_MIN_FACTOR << level;
+
+    int tileRow0 = 0;
+    for(int fileRow = 0; fileRow < 4; fileRow++)
+    {
+      int rows = tileRows(fileRow * 4);
+      int firstRow = std::max(row0, tileRow0), lastRow = std::min(row1, tileRow0 + rows - 1);
+
+      if(firstRow <= lastRow)
+      {
+        for(int fileCol = 0; fileCol < 4; fileCol++)
+        {
+          int tileCol0 = fileCol * TILE_COLUMNS;
+          int firstCol = std::max(col0, tileCol0), lastCol = std::min(col1, tileCol0 + TILE_COLUMNS - 1);
+          if(firstCol > lastCol)
+            continue;
+
+          int fileIndex = fileRow * 4 + fileCol;
+          if(dataFilenames.at(fileIndex).isEmpty())
+            // No data for tile
+            continue;
+
+          openPyramid(fileIndex);
+          const uchar *pyramid = pyramidMaps.at(fileIndex);
+          if(pyramid == nullptr)
+            return false;
+
+          int levelCols, levelRows;
+          qint64 offset;
+          pyramidLevelGeometry(fileIndex, level, levelCols, levelRows, offset);
+
+          // Scan all coarse cells covering the rectangle in this tile
+          for(int row = (firstRow - tileRow0) / factor; row <= (lastRow - tileRow0) / factor; row++)
+          {
+            const uchar *rowData = pyramid + offset + static_cast<qint64>(row) * levelCols * 2;
+            for(int col = (firstCol - tileCol0) / factor; col <= (lastCol - tileCol0) / factor; col++)
+            {
+              float elevation = qFromLittleEndian<qint16>(rowData + col * 2);
+              if(elevation > atools::fs::common::OCEAN)
+                maxAlt = std::max(elevation, maxAlt);
+            }
+          }
+        }
+      }
+      tileRow0 += rows;
+    }
+  }
+  return true;
+}
+
 float GlobeReader::elevationMax(const geo::Pos& pos, float sampleRadiusMeter)
 {
+  // Use the true maximum from the pyramid for large rectangles if available
+  float pyramidMaxAlt;
+  if(elevationMaxPyramid(pos, sampleRadiusMeter, pyramidMaxAlt))
+    return pyramidMaxAlt;
+
   // Collect file indexes and offsets - use set to remove duplicates
   QSet<std::pair<int, qint64> > indexes;
   // Center point
@@ -204,7 +570,9 @@ float GlobeReader::elevationFromIndexAndOffset(int fileIndex, qint64 fileOffset)
   openFile(fileIndex);
   QFile *dataFile = dataFiles[fileIndex];
 
-  if(dataFile != nullptr)
+  if(dataMaps.at(fileIndex) != nullptr)
+    return qFromLittleEndian<qint16>(dataMaps.at(fileIndex) + fileOffset);
+  else if(dataFile != nullptr)
   {
     dataFile->seek(fileOffset);
     QDataStream *dataStream = dataStreams[fileIndex];
@@ -226,45 +594,184 @@ void GlobeReader::getElevations(atools::geo::LineString& elevations, const atool
     elevations.append(linestring.constFirst().alt(getElevation(linestring.constFirst(), sampleRadiusMeter)));
   else
   {
-    LineString positions;
+    // Collect all points first to read elevations in one batch
+    LineString positions, linePositions;
     for(int i = 0; i < linestring.size() - 1; i++)
     {
       Line line = Line(linestring.at(i), linestring.at(i + 1));
 
       float length = line.lengthMeter();
 
-      positions.clear();
-      line.interpolatePoints(length, static_cast<int>(length / INTERPOLATION_SEGMENT_LENGTH_M), positions);
+      linePositions.clear();
+      line.interpolatePoints(length, static_cast<int>(length / INTERPOLATION_SEGMENT_LENGTH_M), linePositions);
+      positions.append(linePositions);
+    }
+    positions.append(linestring.constLast());
 
-      Pos lastDropped;
-      for(const Pos& pos : qAsConst(positions))
-      {
-        float elevation = getElevation(pos, sampleRadiusMeter);
+    QVector<float> positionElevations;
+    getElevations(positionElevations, positions, sampleRadiusMeter);
 
-        if(!elevations.isEmpty())
+    Pos lastDropped;
+    for(int i = 0; i < positions.size() - 1; i++)
+    {
+      const Pos& pos = positions.at(i);
+      float elevation = positionElevations.at(i);
+
+      if(!elevations.isEmpty())
+      {
+        if(atools::almostEqual(elevations.constLast().getAltitude(), elevation, SAME_ELEVATION_EPSILON_M))
         {
-          if(atools::almostEqual(elevations.constLast().getAltitude(), elevation, SAME_ELEVATION_EPSILON_M))
-          {
-            // Drop points with similar altitude
-            lastDropped = pos;
-            lastDropped.setAltitude(elevation);
-            continue;
-          }
-          else if(lastDropped.isValid())
-          {
-            // Add last point of a stretch with similar altitude
-            elevations.append(lastDropped);
-            lastDropped = Pos();
-          }
+          // Drop points with similar altitude
+          lastDropped = pos;
+          lastDropped.setAltitude(elevation);
+          continue;
+        }
+        else if(lastDropped.isValid())
+        {
+          // Add last point of a stretch with similar altitude
+          elevations.append(lastDropped);
+          lastDropped = Pos();
         }
+      }
 
-        elevations.append(pos.alt(elevation));
+      elevations.append(pos.alt(elevation));
+    }
+
+    elevations.append(linestring.constLast().alt(positionElevations.constLast()));
+  }
+}
+
+void GlobeReader::getElevations(QVector<float>& elevations, const QVector<atools::geo::Pos>& positions,
+                                float sampleRadiusMeter)
+{
+  bool maximum = sampleRadiusMeter > 0.f;
+
+  // Maximum starts with zero like elevationMax()
+  elevations.fill(atools::fs::common::INVALID, positions.size());
+
+  if(!valid)
+    return;
+
+  QVector<GlobeSample> samples;
+  samples.reserve(positions.size() * (maximum ? 5 : 1));
+  for(int i = 0; i < positions.size(); i++)
+  {
+    const Pos& pos = positions.at(i);
+    if(pos.isValid())
+    {
+      if(maximum)
+      {
+        // Read maximum directly from pyramid if usable
+        if(elevationMaxPyramid(pos, sampleRadiusMeter, elevations[i]))
+          continue;
+        elevations[i] = 0.f;
+      }
+      addSamples(samples, pos, sampleRadiusMeter, i);
+    }
+  }
+
+  elevationsForSamples(elevations, samples, maximum);
+}
+
+void GlobeReader::getElevationGrid(QVector<float>& elevations, const atools::geo::Rect& rect, int columns, int rows,
+                                   float sampleRadiusMeter)
+{
+  elevations.clear();
+  if(!valid || !rect.isValid() || columns < 1 || rows < 1)
+    return;
+
+  float west = rect.getWest(), north = rect.getNorth();
+  float stepX = columns > 1 ? rect.getWidthDegree() / (columns - 1) : 0.f;
+  float stepY = rows > 1 ? rect.getHeightDegree() / (rows - 1) : 0.f;
+
+  // Longitude crossing the anti-meridian is rolled over in calcFileOffset()
+  QVector<Pos> positions;
+  positions.reserve(columns * rows);
+  for(int row = 0; row < rows; row++)
+  {
+    for(int col = 0; col < columns; col++)
+      positions.append(Pos(west + col * stepX, north - row * stepY));
+  }
+
+  getElevations(elevations, positions, sampleRadiusMeter);
+}
+
+void GlobeReader::addSamples(QVector<GlobeSample>& samples, const geo::Pos& pos, float sampleRadiusMeter,
+                             int resultIndex)
+{
+  int fileIndex;
+  qint64 fileOffset = calcFileOffset(pos.getLonX(), pos.getLatY(), fileIndex);
+  samples.append({fileIndex, fileOffset, resultIndex});
+
+  if(sampleRadiusMeter > 0.f)
+  {
+    // Build a rectangle around the position - duplicates do not change the maximum
+    atools::geo::Rect rect(pos, sampleRadiusMeter, true /* fast */);
+
+    // Get split if crossing anti-meridian
+    for(const atools::geo::Rect& r : rect.splitAtAntiMeridian())
+    {
+      const Pos corners[4] = {r.getTopLeft(), r.getTopRight(), r.getBottomRight(), r.getBottomLeft()};
+      for(const Pos& corner : corners)
+      {
+        fileOffset = calcFileOffset(corner.getLonX(), corner.getLatY(), fileIndex);
+        samples.append({fileIndex, fileOffset, resultIndex});
+      }
+    }
+  }
+}
+
+void GlobeReader::elevationsForSamples(QVector<float>& elevations, QVector<GlobeSample>& samples, bool maximum)
+{
+  // Order by file and position in file
+  std::sort(samples.begin(), samples.end(), [](const GlobeSample& sample1, const GlobeSample& sample2) -> bool {
+    return sample1.fileIndex == sample2.fileIndex ? sample1.offset < sample2.offset :
+           sample1.fileIndex < sample2.fileIndex;
+  });
+
+  QByteArray buffer;
+  int first = 0;
+  while(first < samples.size())
+  {
+    // Collect a run of samples in the same file which are close to each other
+    int fileIndex = samples.at(first).fileIndex;
+    qint64 start = samples.at(first).offset;
+    int last = first + 1;
+    while(last < samples.size() && samples.at(last).fileIndex == fileIndex &&
+          samples.at(last).offset - samples.at(last - 1).offset <= MAX_READ_GAP_BYTES &&
+          samples.at(last).offset + 2 - start <= MAX_READ_BYTES)
+      last++;
+
+    // Read whole block at once or use mapped file
+    qint64 length = samples.at(last - 1).offset + 2 - start;
+    openFile(fileIndex);
+    QFile *dataFile = dataFiles.at(fileIndex);
+
+    const char *data = nullptr;
+    if(dataMaps.at(fileIndex) != nullptr)
+      data = reinterpret_cast<const char *>(dataMaps.at(fileIndex)) + start;
+    else if(dataFile != nullptr && dataFile->seek(start))
+    {
+      buffer.resize(static_cast<int>(length));
+      if(dataFile->read(buffer.data(), length) == length)
+        data = buffer.constData();
+    }
+
+    for(int i = first; i < last; i++)
+    {
+      const GlobeSample& sample = samples.at(i);
+      float elevation = data != nullptr ? qFromLittleEndian<qint16>(data + (sample.offset - start)) : INVALID;
+
+      if(maximum)
+      {
+        if(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID)
+          elevations[sample.resultIndex] = std::max(elevation, elevations.at(sample.resultIndex));
       }
+      else
+        elevations[sample.resultIndex] = elevation;
     }
 
-    elevations.append(linestring.constLast());
-    if(!elevations.isEmpty())
-      elevations.last().setAltitude(getElevation(elevations.constLast(), sampleRadiusMeter));
+    first = last;
   }
 }
 
@@ -28,16 +28,24 @@ namespace atools {
 namespace geo {
 class Pos;
 class LineString;
+class Rect;
 }
 
 namespace fs {
 namespace common {
 
+struct GlobeSample;
+
 static Q_DECL_CONSTEXPR float INVALID = std::numeric_limits<float>::max();
 static Q_DECL_CONSTEXPR float OCEAN = -500.f;
 
 /*
  * DTM reader class for the GLOBE data which can be get at https://www.ngdc.noaa.gov/mgg/topo/globeget.html
+ *
+ * Tiles are memory mapped if possible. Falls back to file reads otherwise.
+ *
+ * An optional pyramid of maximum elevations can be built with buildPyramid(). It contains 4x, 8x, ... 256x
+ * downsampled maximum values for each tile and is used for elevationMax() with large sample radius.
  */
 class GlobeReader
 {
@@ -64,6 +72,25 @@ public:
    * "sampleRadiusMeter" defines a rectangle where five points are sampled and the maximum is used.*/
   void getElevations(geo::LineString& elevations, const atools::geo::LineString& linestring, float sampleRadiusMeter = 0.f);
 
+  /* Get elevations in meter for all positions in one pass. Samples are sorted by file and offset and nearby
+   * values are read in one block. Result has the same size as positions and contains INVALID for invalid positions.
+   * "sampleRadiusMeter" defines a rectangle where five points are sampled and the maximum is used.*/
+  void getElevations(QVector<float>& elevations, const QVector<atools::geo::Pos>& positions,
+                     float sampleRadiusMeter = 0.f);
+
+  /* Get a dense grid of elevations in meter for the bounding rectangle. Grid has columns * rows points
+   * including all corners of the rectangle. Result is sorted by row from north to south and by column from
+   * west to east. Index is row * columns + column. */
+  void getElevationGrid(QVector<float>& elevations, const atools::geo::Rect& rect, int columns, int rows,
+                        float sampleRadiusMeter = 0.f);
+
+  /* Set folder for pyramid files and use them if available and up to date. Empty disables pyramid usage. */
+  void setPyramidDir(const QString& dir);
+
+  /* Build pyramid files in the given folder for all GLOBE tiles. Files are only rebuilt if the tile changed.
+   * Needs openFiles() before. Also calls setPyramidDir(). Returns false on error. */
+  bool buildPyramid(const QString& dir);
+
   /* true if folder exists and files were found */
   bool isValid() const
   {
@@ -89,6 +116,19 @@ private:
   /* Points are considered equal if they are equal within this range in meter */
   static Q_DECL_CONSTEXPR float SAME_ELEVATION_EPSILON_M = 1.f;
 
+  /* Samples in the same file are read in one block if the gap between them is not larger */
+  static Q_DECL_CONSTEXPR qint64 MAX_READ_GAP_BYTES = 16384;
+
+  /* Maximum size of one block read */
+  static Q_DECL_CONSTEXPR qint64 MAX_READ_BYTES = 1024 * 1024;
+
+  /* Pyramid levels are downsampled by 4, 8, 16, 32, 64, 128 and 256 */
+  static Q_DECL_CONSTEXPR int PYRAMID_MIN_FACTOR = 4;
+  static Q_DECL_CONSTEXPR int PYRAMID_LEVELS = 7;
+
+  /* Pyramid level is selected to get not more than this number of cells across a sample rectangle */
+  static Q_DECL_CONSTEXPR int PYRAMID_CELLS_ACROSS = 8;
+
   /* Calculate file index and byte offset within file */
   qint64 calcFileOffset(int gridCol, int gridRow, int& fileIndex);
   qint64 calcFileOffset(const atools::geo::Pos& pos, int& fileIndex);
@@ -99,11 +139,50 @@ private:
   float elevationFromIndexAndOffset(int fileIndex, qint64 fileOffset);
   float elevationMax(const atools::geo::Pos& pos, float sampleRadiusMeter);
 
+  /* Get maximum for the rectangle from the pyramid. Returns false if not usable for this rectangle size or tiles. */
+  bool elevationMaxPyramid(const atools::geo::Pos& pos, float sampleRadiusMeter, float& maxAlt);
+
+  /* Index of pyramid level for a span of grid columns or rows. -1 if finer than the first level. */
+  static int pyramidLevelForSpan(int span);
+
+  /* Number of rows for tile at index */
+  static int tileRows(int fileIndex);
+
+  /* Open and map the pyramid file for tile if valid */
+  void openPyramid(int i);
+  void closePyramid(int i);
+  bool buildPyramidFile(int i, const QString& filename);
+
+  /* Check pyramid header against tile at index i */
+  bool pyramidValid(const uchar *header, qint64 fileSize, int i) const;
+
+  /* Size and byte offset of a level in the pyramid file */
+  static void pyramidLevelGeometry(int fileIndex, int level, int& levelCols, int& levelRows, qint64& offset);
+  QString pyramidFilename(const QString& dir, int i) const;
+
+  /* Add file offsets for position. Adds center and four corners of a rectangle if sampleRadiusMeter > 0 */
+  void addSamples(QVector<GlobeSample>& samples, const atools::geo::Pos& pos, float sampleRadiusMeter,
+                  int resultIndex);
+
+  /* Sort samples, read them in blocks and write values into elevations at the sample result index.
+   * Uses maximum of valid values if maximum is true. */
+  void elevationsForSamples(QVector<float>& elevations, QVector<GlobeSample>& samples, bool maximum);
+
   QString dataDir;
   QVector<QString> dataFilenames;
   QVector<QFile *> dataFiles;
   QVector<QDataStream *> dataStreams;
 
+  /* Memory mapped tiles. Null if not mapped. */
+  QVector<const uchar *> dataMaps;
+
+  QString pyramidDir;
+  QVector<QFile *> pyramidFiles;
+
+  /* Mapped pyramid files or null if not available */
+  QVector<const uchar *> pyramidMaps;
+  QVector<bool> pyramidChecked;
+
   bool valid = false;
 };
 
@@ -27,6 +27,7 @@
 
 #include <QFile>
 #include <QDebug>
+#include <QtEndian>
 #include <cmath>
 
 using atools::geo::Pos;
@@ -40,6 +41,62 @@ using Qt::hex;
 using Qt::dec;
 #endif
 
+Q_DECL_CONSTEXPR float MagDecReader::WMM_GRID_STEP;
+
+/* Header for the grid blob in table magdecl. Old format without header starts with the number of values. */
+static const quint32 MAGDEC_MAGIC = 0x4D414756; // "MAGV"
+static const quint32 MAGDEC_VERSION = 1;
+
+// Latitude/Longitude table is 130,320 bytes length and starts at offset 0x88.
+// Magnetic variations for all entire degree latitude/longitude values are stored as a WORD list starting at E000-S90.
+// For each longitude value from E000 to W179, the list tabulates magnetic variations by increasing latitude from S90 to N90.
+// This organization can be sumarized as follows:
+// E000 (S90->S89->S88...->S01->N00->N01->...->N90), then
+// E001 (S90->S89->S88...->S01->N00->N01->...->N90), followed by E002, E003 lines
+// ...
+// E180 (S90->S89->S88...->S01->N00->N01->...->N90), then
+// W179 (S90->S89->S88...->S01->N00->N01->...->N90), followed by W178, W177 lines
+// ...
+// W001 (S90->S89->S88...->S01->N00->N01->...->N90) that is the last line
+// Therefore, for each of the 360 longitude values, there is 181 latitude values for a total of 65,160 consecutive WORD values.
+// First value of this table is at offset 0x88 (E000/S90) and last is at offset 0x1FD96 (W001/N90).
+// File offset for a given Lat/Long can be obtained using the following formula
+// For positive (East) longitudes (from 0 to 180):
+// Offset = (Long*362)+(Lat*2)+316
+// For negative (West) longitudes (from -1 to -179):
+// Offset =((Long+360)*362)+(Lat*2)+316
+// Note that North latitudes should be entered as positive values (0 to 90) and South latitudes as negative values (-1 to -90)
+static int bglOffset(int lonX, int latY)
+{
+  if(lonX == -180)
+    // Wrap around - other values should not appear on normalized coordinates
+    lonX = 180;
+
+  if(lonX >= 0 && lonX <= 180)
+    // For positive (East) longitudes (from 0 to 180):
+    // East: Offset = (Long*362)+(Lat*2)+180
+    return ((lonX * 362) + (latY * 2) + 180) / 2;
+  else if(lonX <= -1 && lonX >= -179)
+    // For negative (West) longitudes (from -1 to -179):
+    // West: Offset =((Long+360)*362)+(Lat*2)+180
+    return (((lonX + 360) * 362) + (latY * 2) + 180) / 2;
+  else
+    qWarning() << "MagDecReader invalid coordinates in offset calculation" << lonX << latY;
+  return 0;
+}
+
+/* Grid values are stored as little endian floats */
+static void swapGridBytes(QVector<float>& values)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+  quint32 *data = reinterpret_cast<quint32 *>(values.data());
+  for(int i = 0; i < values.size(); i++)
+    data[i] = qbswap(data[i]);
+#else
+  Q_UNUSED(values)
+#endif
+}
+
 MagDecReader::MagDecReader()
 {
 }
@@ -54,28 +111,47 @@ void MagDecReader::readFromWmm()
   readFromWmm(QDate::currentDate());
 }
 
+void MagDecReader::copyFrom(const MagDecReader& other)
+{
+  grid = other.grid;
+  columns = other.columns;
+  rows = other.rows;
+  gridStep = other.gridStep;
+  referenceDate = other.referenceDate;
+  wmmVersion = other.wmmVersion;
+}
+
 void MagDecReader::readFromWmm(const QDate& date)
 {
   readFromWmm(date.year(), date.month());
 }
 
-void MagDecReader::readFromWmm(int year, int month)
+void MagDecReader::readFromWmm(int year, int month, float stepDegree)
 {
   clear();
 
   // Create WMM model data
   atools::wmm::MagDecTool magDecTool;
-  magDecTool.init(year, month);
+  magDecTool.init(year, month, stepDegree);
 
   referenceDate = magDecTool.getReferenceDate();
-  numValues = 360 * 181;
+  wmmVersion = magDecTool.getVersion();
 
-  // Copy to internal representation that allows saving and loading
-  magDecValues = new float[numValues];
-  for(int latY = -90; latY <= 90; latY++)
+  // Copy to internal representation and add the wrap around column at 180
+  int toolColumns = magDecTool.getGridColumns();
+  const float *toolGrid = magDecTool.getGrid();
+
+  gridStep = magDecTool.getGridStep();
+  columns = toolColumns + 1;
+  rows = magDecTool.getGridRows();
+  grid.resize(columns * rows);
+
+  for(int row = 0; row < rows; row++)
   {
-    for(int lonX = -180; lonX < 180; lonX++)
-      magDecValues[offset(lonX, latY)] = magDecTool.getMagVar(lonX, latY);
+    const float *src = toolGrid + row * toolColumns;
+    float *dest = grid.data() + row * columns;
+    std::copy(src, src + toolColumns, dest);
+    dest[toolColumns] = src[0];
   }
 }
 
@@ -96,7 +172,7 @@ void MagDecReader::readFromBgl(const QString& filename)
     // 0x85	1 - BYTE	Reference date month (?)	0x01 (FS2004) - 0x11 (FSX/P3D)
     // 0x86	2 - WORD	Reference date year (?)	0x1993 (FS2004) - 0x2006 (FSX/P3D)
 
-    atools::io::BinaryStream stream(&file);
+    atools::io::BinaryStream stream(&file, QDataStream::LittleEndian, atools::io::READ_MAPPED);
     int worldSet = stream.readByte();
 
     // skip unknown bytes
@@ -129,25 +205,40 @@ void MagDecReader::readFromBgl(const QString& filename)
                               arg(numLatValues));
     }
 
-    numValues = numLongValues * numLatValues;
-
-    magDecValues = new float[numValues];
+    QVector<float> values(static_cast<int>(numLongValues * numLatValues));
 
     // Decode all values
-    for(quint32 i = 0; i < numValues; i++)
+    for(int i = 0; i < values.size(); i++)
       // East values are positive while West values are negative
       // As an example a E03.4° value will be coded as:
       // MV (E03.4°) = 65536*3.4/360 = 619 (0x26B)
       // A W01.1° value will be coded as:
       // MV (W01.1°) = 65536 - (65536*1.1/360) = 65336 (0xFF38)
-      magDecValues[i] = static_cast<float>(stream.readShort()) / 65536.f * 360.f;
+      values[i] = static_cast<float>(stream.readShort()) / 65536.f * 360.f;
 
     file.close();
+
+    fromBglValues(values);
   }
   else
     throw atools::Exception(tr("Cannot read %1. Reason: %2").arg(file.fileName()).arg(file.errorString()));
 }
 
+void MagDecReader::fromBglValues(const QVector<float>& values)
+{
+  gridStep = 1.f;
+  columns = 361;
+  rows = 181;
+  grid.resize(columns * rows);
+
+  for(int latY = -90; latY <= 90; latY++)
+  {
+    float *dest = grid.data() + (latY + 90) * columns;
+    for(int lonX = -180; lonX <= 180; lonX++)
+      dest[lonX + 180] = values.value(bglOffset(lonX, latY));
+  }
+}
+
 void MagDecReader::readFromBytes(const QByteArray& bytes)
 {
   clear();
@@ -156,11 +247,39 @@ void MagDecReader::readFromBytes(const QByteArray& bytes)
   in.setVersion(QDataStream::Qt_5_5);
   in.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-  in >> numValues;
-  magDecValues = new float[numValues];
+  quint32 magic;
+  in >> magic;
 
-  for(unsigned int i = 0; i < numValues; i++)
-    in >> magDecValues[i];
+  if(magic == MAGDEC_MAGIC)
+  {
+    // Header and raw grid
+    quint32 version, numColumns, numRows;
+    float step;
+    in >> version >> numColumns >> numRows >> step;
+
+    if(version != MAGDEC_VERSION || numColumns < 2 || numRows < 2 || !(step > 0.f))
+      throw atools::Exception(tr("Invalid magnetic declination grid: version %1, columns %2, rows %3.").
+                              arg(version).arg(numColumns).arg(numRows));
+
+    QVector<float> values(static_cast<int>(numColumns * numRows));
+    int size = values.size() * static_cast<int>(sizeof(float));
+    if(in.readRawData(reinterpret_cast<char *>(values.data()), size) != size)
+      throw atools::Exception(tr("Magnetic declination grid is truncated."));
+
+    swapGridBytes(values);
+    grid.swap(values);
+    columns = static_cast<int>(numColumns);
+    rows = static_cast<int>(numRows);
+    gridStep = step;
+  }
+  else
+  {
+    // Old format - number of values followed by floats in magdec.bgl order
+    QVector<float> values(static_cast<int>(magic));
+    for(int i = 0; i < values.size(); i++)
+      in >> values[i];
+    fromBglValues(values);
+  }
 }
 
 void MagDecReader::writeToTable(sql::SqlDatabase& db) const
@@ -205,17 +324,24 @@ bool MagDecReader::readFromTable(sql::SqlDatabase& db)
   return false;
 }
 
+void MagDecReader::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  bytes += atools::util::MemoryAccounting::vectorBytes(grid);
+  elements += grid.size();
+}
+
 void MagDecReader::clear()
 {
-  delete[] magDecValues;
-  magDecValues = nullptr;
+  grid.clear();
+  columns = rows = 0;
+  gridStep = 0.f;
   referenceDate = QDate();
   wmmVersion.clear();
 }
 
 bool MagDecReader::isValid() const
 {
-  return magDecValues != nullptr;
+  return !grid.isEmpty();
 }
 
 QByteArray MagDecReader::writeToBytes() const
@@ -228,9 +354,13 @@ QByteArray MagDecReader::writeToBytes() const
   out.setVersion(QDataStream::Qt_5_5);
   out.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-  out << numValues;
-  for(quint32 i = 0; i < numValues; i++)
-    out << magDecValues[i];
+  out << MAGDEC_MAGIC << MAGDEC_VERSION << static_cast<quint32>(columns) << static_cast<quint32>(rows) << gridStep;
+
+  // Write grid as one block
+  QVector<float> values(grid);
+  swapGridBytes(values);
+  out.writeRawData(reinterpret_cast<const char *>(values.constData()),
+                   values.size() * static_cast<int>(sizeof(float)));
 
   return bytes;
 }
@@ -244,91 +374,45 @@ float MagDecReader::getMagVar(const geo::Pos& pos) const
     return 0.f;
 
   Pos posNorm(pos.normalized());
-  float lonX = posNorm.getLonX();
-  float latY = posNorm.getLatY();
+  return interpolate(posNorm.getLonX(), posNorm.getLatY());
+}
 
-  int minLonX1 = static_cast<int>(std::floor(lonX)), maxLonX2 = static_cast<int>(std::ceil(lonX)),
-      minLatY1 = static_cast<int>(std::floor(latY)), maxLatY2 = static_cast<int>(std::ceil(latY));
+void MagDecReader::getMagVars(QVector<float>& magvars, const QVector<geo::Pos>& positions) const
+{
+  if(!isValid())
+    throw Exception("MagDecReader is invalid");
 
-  if(pos.nearGrid(1.f, atools::geo::Pos::POS_EPSILON_500M))
-    // Exact or near degree - nothing to interpolate
-    return magvar(offset(atools::roundToInt(pos.getLonX()), atools::roundToInt(pos.getLatY())));
-  else
+  magvars.resize(positions.size());
+  for(int i = 0; i < positions.size(); i++)
   {
-    // Get four exact degree points around the coordinate
-    int topRightOffsetQ12 = offset(minLonX1, maxLatY2), topLeftOffsetQ22 = offset(maxLonX2, maxLatY2),
-        bottomRightOffsetQ11 = offset(maxLonX2, minLatY1), bottomLeftOffsetQ21 = offset(minLonX1, minLatY1);
-
-    // Calculate magvar values for the four points
-    float fQ12 = magvar(topRightOffsetQ12), fQ22 = magvar(topLeftOffsetQ22),
-          fQ11 = magvar(bottomRightOffsetQ11), fQ21 = magvar(bottomLeftOffsetQ21);
-
-    // Do a bilinear interpolation between the four points
-    float fR1, fR2;
-    float diffX = maxLonX2 - minLonX1;
-    if(std::abs(diffX) > 0.f)
+    const Pos& pos = positions.at(i);
+    if(pos.isValid())
     {
-      fR1 = (maxLonX2 - lonX) / diffX * fQ11 + (lonX - minLonX1) / diffX * fQ21;
-      fR2 = (maxLonX2 - lonX) / diffX * fQ12 + (lonX - minLonX1) / diffX * fQ22;
+      Pos posNorm(pos.normalized());
+      magvars[i] = interpolate(posNorm.getLonX(), posNorm.getLatY());
     }
     else
-    {
-      fR1 = (fQ11 + fQ21) / 2.f;
-      fR2 = (fQ12 + fQ22) / 2.f;
-    }
-
-    float diffY = maxLatY2 - minLatY1;
-    if(std::abs(diffY) > 0.f)
-      return (maxLatY2 - latY) / diffY * fR1 + (latY - minLatY1) / diffY * fR2;
-    else
-      return (fR1 + fR2) / 2.f;
+      magvars[i] = 0.f;
   }
 }
 
-float MagDecReader::magvar(int offset) const
+float MagDecReader::interpolate(float lonX, float latY) const
 {
-  if(offset >= 0 && offset < static_cast<int>(numValues))
-    return magDecValues[offset];
-  else
-    throw Exception(QString("Wrong offset into magnetic declination %1").arg(offset));
-}
+  // Fractional grid coordinates
+  float x = (lonX + 180.f) / gridStep, y = (latY + 90.f) / gridStep;
 
-// Latitude/Longitude table is 130,320 bytes length and starts at offset 0x88.
-// Magnetic variations for all entire degree latitude/longitude values are stored as a WORD list starting at E000-S90.
-// For each longitude value from E000 to W179, the list tabulates magnetic variations by increasing latitude from S90 to N90.
-// This organization can be sumarized as follows:
-// E000 (S90->S89->S88...->S01->N00->N01->...->N90), then
-// E001 (S90->S89->S88...->S01->N00->N01->...->N90), followed by E002, E003 lines
-// ...
-// E180 (S90->S89->S88...->S01->N00->N01->...->N90), then
-// W179 (S90->S89->S88...->S01->N00->N01->...->N90), followed by W178, W177 lines
-// ...
-// W001 (S90->S89->S88...->S01->N00->N01->...->N90) that is the last line
-// Therefore, for each of the 360 longitude values, there is 181 latitude values for a total of 65,160 consecutive WORD values.
-// First value of this table is at offset 0x88 (E000/S90) and last is at offset 0x1FD96 (W001/N90).
-// File offset for a given Lat/Long can be obtained using the following formula
-// For positive (East) longitudes (from 0 to 180):
-// Offset = (Long*362)+(Lat*2)+316
-// For negative (West) longitudes (from -1 to -179):
-// Offset =((Long+360)*362)+(Lat*2)+316
-// Note that North latitudes should be entered as positive values (0 to 90) and South latitudes as negative values (-1 to -90)
-int MagDecReader::offset(int lonX, int latY) const
-{
-  if(lonX == -180)
-    // Wrap around - other values should not appear on normalized coordinates
-    lonX = 180;
+  // Cell of the lower left corner - clamp to have the upper and right neighbors always inside the grid
+  int col = atools::minmax(0, columns - 2, static_cast<int>(std::floor(x)));
+  int row = atools::minmax(0, rows - 2, static_cast<int>(std::floor(y)));
+  float fx = atools::minmax(0.f, 1.f, x - col), fy = atools::minmax(0.f, 1.f, y - row);
 
-  if(lonX >= 0 && lonX <= 180)
-    // For positive (East) longitudes (from 0 to 180):
-    // East: Offset = (Long*362)+(Lat*2)+180
-    return ((lonX * 362) + (latY * 2) + 180) / 2;
-  else if(lonX <= -1 && lonX >= -179)
-    // For negative (West) longitudes (from -1 to -179):
-    // West: Offset =((Long+360)*362)+(Lat*2)+180
-    return (((lonX + 360) * 362) + (latY * 2) + 180) / 2;
-  else
-    qWarning() << "MagDecReader invalid coordinates in offset calculation" << lonX << latY;
-  return 0;
+  // Bottom row and top row of the cell are adjacent in memory
+  const float *bottom = grid.constData() + row * columns + col;
+  const float *top = bottom + columns;
+
+  float valBottom = bottom[0] + (bottom[1] - bottom[0]) * fx;
+  float valTop = top[0] + (top[1] - top[0]) * fx;
+  return valBottom + (valTop - valBottom) * fy;
 }
 
 } // namespace common
@@ -18,8 +18,11 @@
 #ifndef ATOOLS_FS_COMMON_MAGDECREADER_H
 #define ATOOLS_FS_COMMON_MAGDECREADER_H
 
+#include "util/memoryaccounting.h"
+
 #include <QDate>
 #include <QCoreApplication>
+#include <QVector>
 
 namespace atools {
 namespace geo {
@@ -35,14 +38,20 @@ namespace common {
 
 /*
  * Loads and parses the magdec.bgl file. Allows to store declination into the magdecl table in a database.
+ *
+ * Values are kept in a regular grid ordered by latitude rows from -90 to 90 and longitude columns from -180 to 180
+ * including a duplicated wrap around column at 180. The WMM grid uses 0.5 degree steps while BGL files
+ * and old database tables use one degree steps.
+ * The grid is not modified after loading and all query methods are thread safe without locking.
  */
-class MagDecReader
+class MagDecReader :
+  public atools::util::MemoryAccountable
 {
   Q_DECLARE_TR_FUNCTIONS(MagDecReader)
 
 public:
   MagDecReader();
-  virtual ~MagDecReader();
+  virtual ~MagDecReader() override;
 
   MagDecReader(const MagDecReader& other) = delete;
   MagDecReader& operator=(const MagDecReader& other) = delete;
@@ -50,13 +59,17 @@ public:
   /* Calculate values from world magnetic model based on current year and month or current date if not given.
    * Values can be saved to database. Result is always valid.
    *  January = 1 */
-  void readFromWmm(int year, int month = 1);
+  void readFromWmm(int year, int month = 1, float stepDegree = WMM_GRID_STEP);
   void readFromWmm(const QDate& date);
   void readFromWmm();
 
   /* Read values from magdec.bgl file */
   void readFromBgl(const QString& filename);
 
+  /* Copy values from another reader, e.g. a grid calculated once and shared by several compilations.
+   * Grid data is implicitly shared and not copied. */
+  void copyFrom(const atools::fs::common::MagDecReader& other);
+
   /* Read values from table "magdecl" returns true if successfull and table exists. */
   bool readFromTable(atools::sql::SqlDatabase& db);
 
@@ -66,6 +79,9 @@ public:
   /* Frees memory and sets state to invalid */
   void clear();
 
+  /* Declination grid. Elements are grid values. Nothing can be released. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
   /* true if loaded */
   bool isValid() const;
 
@@ -74,6 +90,16 @@ public:
    */
   float getMagVar(const atools::geo::Pos& pos) const;
 
+  /* Get declination for all positions at once. magvars is resized and contains one value for each position.
+   * Invalid positions give 0. Throws exception if object is not valid. */
+  void getMagVars(QVector<float>& magvars, const QVector<atools::geo::Pos>& positions) const;
+
+  /* Grid spacing in degree. 0 if not valid. */
+  float getGridStep() const
+  {
+    return gridStep;
+  }
+
   const QDate& getReferenceDate() const
   {
     return referenceDate;
@@ -85,18 +111,25 @@ public:
     return wmmVersion;
   }
 
+  /* Default grid spacing for values calculated from the world magnetic model */
+  static Q_DECL_CONSTEXPR float WMM_GRID_STEP = 0.5f;
+
 private:
   QByteArray writeToBytes() const;
   void readFromBytes(const QByteArray& bytes);
 
-  int offset(int lonX, int latY) const;
-  float magvar(int offset) const;
+  /* Fill a one degree grid from values in magdec.bgl order */
+  void fromBglValues(const QVector<float>& values);
+
+  /* Bilinear interpolation for normalized coordinates */
+  float interpolate(float lonX, float latY) const;
 
   QDate referenceDate;
-  quint32 numValues = 0;
 
-  /* https://www.fsdeveloper.com/wiki/index.php?title=Magdec_BGL_File */
-  float *magDecValues = nullptr;
+  /* Row major grid with columns * rows values */
+  QVector<float> grid;
+  int columns = 0, rows = 0;
+  float gridStep = 0.f;
 
   QString wmmVersion;
 };
@@ -20,9 +20,14 @@
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 #include "geo/pos.h"
+#include "geo/rect.h"
+#include "geo/line.h"
+#include "geo/linestring.h"
+#include "geo/calculations.h"
 #include "exception.h"
 
 #include <QDataStream>
+#include <QtEndian>
 
 using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
@@ -100,16 +105,25 @@ bool MoraReader::readFromTable()
 
     if(magicNumber != MAGIC_NUMBER_DATA)
       throw Exception("Invalid magic number in MORA data");
-    if(dataVersion != DATA_VERSION)
-      throw Exception("Invalid data version in MORA data");
-
-    // Read blob into vector
-    quint16 value;
-    while(!in.atEnd())
+    if(dataVersion == 1)
+    {
+      // Read big endian values from blob into vector
+      quint16 value;
+      while(!in.atEnd())
+      {
+        in >> value;
+        datagrid.append(value);
+      }
+    }
+    else if(dataVersion == DATA_VERSION)
     {
-      in >> value;
-      datagrid.append(value);
+      // Copy little endian block at once
+      int headerSize = static_cast<int>(sizeof(magicNumber) + sizeof(dataVersion));
+      datagrid.resize((bytes.size() - headerSize) / static_cast<int>(sizeof(quint16)));
+      qFromLittleEndian<quint16>(bytes.constData() + headerSize, datagrid.size(), datagrid.data());
     }
+    else
+      throw Exception("Invalid data version in MORA data");
 
     // Check size
     if(datagrid.size() != lonxColums * latyRows)
@@ -118,6 +132,7 @@ bool MoraReader::readFromTable()
     qInfo() << Q_FUNC_INFO << db->databaseName() << "MORA data loaded"
             << lonxColums << "x *" << latyRows << "y" << bytes.size() << "bytes";
 
+    buildMaxPyramid();
     dataAvailable = true;
     return true;
   }
@@ -280,6 +295,7 @@ void MoraReader::writeToTable(const QVector<quint16>& grid, int columns, int row
   datagrid = grid;
   lonxColums = columns;
   latyRows = rows;
+  buildMaxPyramid();
   dataAvailable = true;
 
   SqlQuery moraWriteQuery(db);
@@ -293,9 +309,10 @@ void MoraReader::writeToTable(const QVector<quint16>& grid, int columns, int row
   // Write header
   out << MAGIC_NUMBER_DATA << DATA_VERSION;
 
-  // Write data as 16 bit values
-  for(quint16 value : datagrid)
-    out << value;
+  // Write data as one block of little endian 16 bit values
+  QByteArray data(datagrid.size() * static_cast<int>(sizeof(quint16)), '\0');
+  qToLittleEndian<quint16>(datagrid.constData(), datagrid.size(), data.data());
+  out.writeRawData(data.constData(), data.size());
 
   // mora_grid_id integer primary key,
   // version integer not null,
@@ -316,9 +333,20 @@ bool MoraReader::isDataAvailable()
   return dataAvailable;
 }
 
+void MoraReader::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  using atools::util::MemoryAccounting;
+
+  bytes += MemoryAccounting::vectorBytes(datagrid) + MemoryAccounting::vectorBytes(maxLevels);
+  for(const QVector<quint16>& level : maxLevels)
+    bytes += MemoryAccounting::vectorBytes(level);
+  elements += datagrid.size();
+}
+
 void MoraReader::clear()
 {
   datagrid.clear();
+  maxLevels.clear();
   lonxColums = latyRows = 0;
   dataAvailable = false;
 }
@@ -365,6 +393,216 @@ int MoraReader::getMoraFt(int lonx, int laty) const
   return datagrid.at(pos);
 }
 
+quint16 MoraReader::valueToKey(quint16 value)
+{
+  if(value == UNKNOWN || value == ERROR)
+    return 0;
+  else
+    // Ocean is 1 and known values are above
+    return value + 1;
+}
+
+int MoraReader::keyToValue(quint16 key)
+{
+  if(key == 0)
+    return UNKNOWN;
+  else
+    return key - 1;
+}
+
+void MoraReader::buildMaxPyramid()
+{
+  maxLevels.clear();
+
+  if(datagrid.size() != lonxColums * latyRows || datagrid.isEmpty())
+    return;
+
+  // Level 0 - keys for all cells. Apply polar limits as in getMoraFt()
+  QVector<quint16> keys(datagrid.size());
+  for(int row = 0; row < latyRows; row++)
+  {
+    int laty = 90 - row;
+    for(int col = 0; col < lonxColums; col++)
+    {
+      int idx = row * lonxColums + col;
+      if(laty > 85)
+        keys[idx] = valueToKey(OCEAN);
+      else if(laty < -85)
+        keys[idx] = valueToKey(UNKNOWN);
+      else
+        keys[idx] = valueToKey(datagrid.at(idx));
+    }
+  }
+  maxLevels.append(keys);
+
+  // Build levels until the square is larger than the grid height
+  for(int size = 2; size <= std::min(lonxColums, latyRows); size *= 2)
+  {
+    const QVector<quint16>& last = maxLevels.constLast();
+    int half = size / 2;
+    QVector<quint16> level(datagrid.size());
+
+    for(int row = 0; row < latyRows; row++)
+    {
+      // Clip at the bottom - these are not used by queries
+      int row2 = std::min(row + half, latyRows - 1);
+
+      for(int col = 0; col < lonxColums; col++)
+      {
+        // Wrap around at anti-meridian
+        int col2 = (col + half) % lonxColums;
+
+        level[row * lonxColums + col] = std::max(std::max(last.at(row * lonxColums + col),
+                                                          last.at(row * lonxColums + col2)),
+                                                 std::max(last.at(row2 * lonxColums + col),
+                                                          last.at(row2 * lonxColums + col2)));
+      }
+    }
+    maxLevels.append(level);
+  }
+}
+
+quint16 MoraReader::maxKeyForCells(int row0, int row1, int col0, int width) const
+{
+  int height = row1 - row0 + 1;
+  if(height <= 0 || width <= 0 || maxLevels.isEmpty())
+    return 0;
+
+  // Use largest square fitting into the smaller side and cover the range with overlapping squares
+  int levelIdx = 0;
+  while(levelIdx + 1 < maxLevels.size() && (2 << levelIdx) <= std::min(width, height))
+    levelIdx++;
+
+  const QVector<quint16>& level = maxLevels.at(levelIdx);
+  int size = 1 << levelIdx;
+
+  quint16 key = 0;
+  for(int row = row0;; row += size)
+  {
+    // Align last square to the bottom
+    int r = std::min(row, row1 - size + 1);
+
+    for(int col = 0;; col += size)
+    {
+      // Align last square to the right
+      int c = (col0 + std::min(col, width - size)) % lonxColums;
+      key = std::max(key, level.at(r * lonxColums + c));
+
+      if(col + size >= width)
+        break;
+    }
+
+    if(row + size > row1)
+      break;
+  }
+  return key;
+}
+
+quint16 MoraReader::maxKeyForBounds(float west, float north, float east, float south) const
+{
+  // Rows from top latitude 90 (row 0) to -89 (row 179). A cell covers one degree below its top latitude.
+  north = atools::minmax(-90.f, 90.f, north);
+  south = atools::minmax(-90.f, 90.f, south);
+  int row0 = atools::minmax(0, latyRows - 1, 90 - static_cast<int>(std::ceil(north)));
+  int row1 = atools::minmax(row0, latyRows - 1, 90 - (static_cast<int>(std::floor(south)) + 1));
+
+  // Columns from left longitude -180 (column 0) to 179 (column 359)
+  int colWest = static_cast<int>(std::floor(west)) + 180;
+  int colEast = static_cast<int>(std::ceil(east)) - 1 + 180;
+  if(colEast < colWest && !(west > east))
+    // Point or zero width at integer longitude
+    colEast = colWest;
+
+  colWest = ((colWest % lonxColums) + lonxColums) % lonxColums;
+  colEast = ((colEast % lonxColums) + lonxColums) % lonxColums;
+
+  int width = (west > east && colEast == colWest) ? lonxColums :
+              ((colEast - colWest + lonxColums) % lonxColums) + 1;
+
+  return maxKeyForCells(row0, row1, colWest, std::min(width, lonxColums));
+}
+
+quint16 MoraReader::maxKeyForLine(const geo::Line& line, float corridorNm) const
+{
+  if(!line.isValid())
+    return 0;
+
+  // Sample line in steps of half a degree to keep the bounding rectangles of the segments small
+  float distanceMeter = line.lengthMeter();
+  int numPoints = std::max(2, static_cast<int>(std::ceil(atools::geo::meterToNm(distanceMeter) / 30.f)) + 1);
+  atools::geo::LineString positions;
+  line.interpolatePoints(distanceMeter, numPoints, positions);
+
+  // Corridor as latitude degrees
+  float corridorDeg = corridorNm / 60.f;
+
+  quint16 key = 0;
+  for(int i = 0; i < positions.size() - 1; i++)
+  {
+    geo::Pos p1 = positions.at(i).normalized(), p2 = positions.at(i + 1).normalized();
+
+    float north = std::max(p1.getLatY(), p2.getLatY()) + corridorDeg;
+    float south = std::min(p1.getLatY(), p2.getLatY()) - corridorDeg;
+
+    // Widen longitude by corridor at the latitude farthest away from the equator
+    float cosLat = std::cos(atools::geo::toRadians(std::min(std::max(std::abs(north), std::abs(south)), 89.f)));
+    float corridorLonDeg = std::min(corridorDeg / cosLat, 180.f);
+
+    float west, east;
+    if(std::abs(p1.getLonX() - p2.getLonX()) > 180.f)
+    {
+      // Segment crosses the anti-meridian - west is the larger value
+      west = std::max(p1.getLonX(), p2.getLonX());
+      east = std::min(p1.getLonX(), p2.getLonX());
+    }
+    else
+    {
+      west = std::min(p1.getLonX(), p2.getLonX());
+      east = std::max(p1.getLonX(), p2.getLonX());
+    }
+
+    west -= corridorLonDeg;
+    east += corridorLonDeg;
+    if(west < -180.f)
+      west += 360.f;
+    if(east > 180.f)
+      east -= 360.f;
+
+    key = std::max(key, maxKeyForBounds(west, north, east, south));
+  }
+  return key;
+}
+
+int MoraReader::getMaxMoraFt(const geo::Rect& rect) const
+{
+  if(!dataAvailable)
+    throw Exception("MORA data not available");
+
+  if(!rect.isValid())
+    return UNKNOWN;
+
+  return keyToValue(maxKeyForBounds(rect.getWest(), rect.getNorth(), rect.getEast(), rect.getSouth()));
+}
+
+int MoraReader::getMaxMoraFt(const geo::Line& line, float corridorNm) const
+{
+  if(!dataAvailable)
+    throw Exception("MORA data not available");
+
+  return keyToValue(maxKeyForLine(line, corridorNm));
+}
+
+int MoraReader::getMaxMoraFt(const geo::LineString& linestring, float corridorNm) const
+{
+  if(!dataAvailable)
+    throw Exception("MORA data not available");
+
+  quint16 key = 0;
+  for(int i = 0; i < linestring.size() - 1; i++)
+    key = std::max(key, maxKeyForLine(geo::Line(linestring.at(i), linestring.at(i + 1)), corridorNm));
+  return keyToValue(key);
+}
+
 void MoraReader::assignDatabase(sql::SqlDatabase *sqlDb1, sql::SqlDatabase *sqlDb2)
 {
   db = SqlUtil::getDbWithTableAndRows("mora_grid", {sqlDb1, sqlDb2});
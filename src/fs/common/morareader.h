@@ -18,6 +18,8 @@
 #ifndef ATOOLS_FS_COMMON_MORAREADER_H
 #define ATOOLS_FS_COMMON_MORAREADER_H
 
+#include "util/memoryaccounting.h"
+
 #include <limits>
 
 #include <QString>
@@ -26,6 +28,9 @@
 namespace atools {
 namespace geo {
 class Pos;
+class Rect;
+class Line;
+class LineString;
 }
 namespace sql {
 class SqlDatabase;
@@ -44,13 +49,14 @@ namespace common {
  *
  * The field will contain values expressed in hundreds of feet, for example, the value of 6000 feet is expressed as 060 and the value of 7100 feet is expressed as 071. For geographical sections that are not surveyed, the field will contain the alpha characters UNK for Unknown.
  */
-class MoraReader
+class MoraReader :
+  public atools::util::MemoryAccountable
 {
 public:
   MoraReader(atools::sql::SqlDatabase *sqlDb1, atools::sql::SqlDatabase *sqlDb2);
   MoraReader(atools::sql::SqlDatabase *sqlDb);
   MoraReader(atools::sql::SqlDatabase& sqlDb);
-  virtual ~MoraReader();
+  virtual ~MoraReader() override;
 
   /* Read values from table "mora_grid". returns true if successfull and table exists. */
   bool readFromTable();
@@ -67,6 +73,9 @@ public:
   /* Frees memory and sets state to invalid */
   void clear();
 
+  /* MORA grid and maximum pyramid. Elements are grid cells. Nothing can be released. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
   /* true if loaded */
   bool isValid() const
   {
@@ -87,6 +96,17 @@ public:
   int getMoraFt(const atools::geo::Pos& pos) const;
   int getMoraFt(int lonx, int laty) const;
 
+  /* Returns the maximum MORA in feet * 100 of all grid cells touched by the rectangle.
+   * Cells with known values take precedence. Returns OCEAN if all other cells are ocean and UNKNOWN
+   * if no cell has a known value or ocean. Uses a precalculated max pyramid and needs only a few lookups.
+   * Throws exception if object is not valid. */
+  int getMaxMoraFt(const atools::geo::Rect& rect) const;
+
+  /* Maximum MORA as above for all cells touched by the great circle line or line string and an
+   * optional corridor of corridorNm to each side. */
+  int getMaxMoraFt(const atools::geo::Line& line, float corridorNm = 0.f) const;
+  int getMaxMoraFt(const atools::geo::LineString& linestring, float corridorNm = 0.f) const;
+
   /* Print world map to log */
   void debugPrint(const QVector<quint16>& grid);
 
@@ -114,13 +134,35 @@ public:
 private:
   void assignDatabase(sql::SqlDatabase *sqlDb1, sql::SqlDatabase *sqlDb2);
 
+  /* Build maxLevels from datagrid */
+  void buildMaxPyramid();
+
+  /* Maximum key for the inclusive cell range. col0 plus width can wrap around the anti-meridian. */
+  quint16 maxKeyForCells(int row0, int row1, int col0, int width) const;
+
+  /* Maximum key for rectangle. west > east denotes a rectangle crossing the anti-meridian. */
+  quint16 maxKeyForBounds(float west, float north, float east, float south) const;
+
+  /* Maximum key for line including corridor */
+  quint16 maxKeyForLine(const atools::geo::Line& line, float corridorNm) const;
+
+  /* Convert between MORA values and keys for max queries. Keys sort UNKNOWN < OCEAN < known values. */
+  static quint16 valueToKey(quint16 value);
+  static int keyToValue(quint16 key);
+
   atools::sql::SqlDatabase *db;
   bool dataAvailable = false, navdata = false;
   QVector<quint16> datagrid;
   int lonxColums = 0, latyRows = 0;
 
+  /* Level n contains the maximum key for the square of 2^n by 2^n cells starting at the top left cell.
+   * Columns wrap around at the anti-meridian. Level 0 is the key grid. */
+  QVector<QVector<quint16> > maxLevels;
+
   const static quint32 MAGIC_NUMBER_DATA = 0xA5B44CDB;
-  const static quint32 DATA_VERSION = 1;
+
+  /* Version 1 contains big endian values. Version 2 stores the grid as one little endian block. */
+  const static quint32 DATA_VERSION = 2;
 
 };
 
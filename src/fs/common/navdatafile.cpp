@@ -0,0 +1,273 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/navdatafile.h"
+
+#include "geo/pos.h"
+#include "geo/rect.h"
+#include "util/identkey.h"
+
+#include <QDebug>
+#include <QSysInfo>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using namespace navfile;
+using atools::geo::Pos;
+using atools::geo::Rect;
+using atools::geo::IndexDistance;
+using atools::util::IdentKey;
+
+static inline int gridColumn(float lonX)
+{
+  return std::max(0, std::min(static_cast<int>(lonX + 180.f), GRID_COLUMNS - 1));
+}
+
+static inline int gridRow(float latY)
+{
+  return std::max(0, std::min(static_cast<int>(latY + 90.f), GRID_ROWS - 1));
+}
+
+NavDataFile::NavDataFile()
+{
+  std::fill(std::begin(sections), std::end(sections), nullptr);
+}
+
+NavDataFile::~NavDataFile()
+{
+  close();
+}
+
+void NavDataFile::close()
+{
+  if(data != nullptr)
+    file.unmap(const_cast<uchar *>(data));
+  data = nullptr;
+  dataSize = 0;
+  file.close();
+  std::fill(std::begin(sections), std::end(sections), nullptr);
+}
+
+bool NavDataFile::open(const QString& filename)
+{
+  close();
+  errorString.clear();
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    errorString = file.errorString();
+    return false;
+  }
+
+  dataSize = file.size();
+  if(dataSize < static_cast<qint64>(sizeof(FileHeader)))
+  {
+    errorString = tr("File too small");
+    close();
+    return false;
+  }
+
+  // Read only mapping which allows the system to share pages between processes
+  const uchar *mapped = file.map(0, dataSize);
+  if(mapped == nullptr)
+  {
+    errorString = file.errorString();
+    close();
+    return false;
+  }
+  data = mapped;
+
+  const FileHeader& header = getHeader();
+  if(header.magic != MAGIC_NUMBER || header.byteOrder != static_cast<qint32>(QSysInfo::ByteOrder))
+    errorString = tr("Invalid file or wrong byte order");
+  else if(header.version != FILE_VERSION)
+    errorString = tr("Unsupported file version %1").arg(header.version);
+  else if(sizeof(FileHeader) + header.numSections * sizeof(SectionEntry) > static_cast<quint64>(dataSize))
+    errorString = tr("Invalid section table");
+  else
+  {
+    const SectionEntry *entries = reinterpret_cast<const SectionEntry *>(data + sizeof(FileHeader));
+    for(quint32 i = 0; i < header.numSections && errorString.isEmpty(); i++)
+    {
+      const SectionEntry& entry = entries[i];
+      if(entry.offset + entry.size > static_cast<quint64>(dataSize) || entry.offset % 8 != 0 ||
+         static_cast<quint64>(entry.count) * entry.elementSize > entry.size)
+        errorString = tr("Invalid section %1").arg(entry.type);
+      else if(entry.type > 0 && entry.type < NUM_SECTION_TYPES)
+        // Unknown sections are ignored to allow adding data later
+        sections[entry.type] = &entry;
+    }
+  }
+
+  if(!errorString.isEmpty())
+  {
+    qWarning() << Q_FUNC_INFO << filename << errorString;
+    close();
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << filename << "airports" << getNumAirports() << "navaids" << getNumNavaids()
+           << "airways" << getNumAirways();
+  return true;
+}
+
+const char *NavDataFile::getStringUtf8(quint32 offset) const
+{
+  if(sections[STRINGS] == nullptr || offset >= sections[STRINGS]->size)
+    return "";
+
+  return reinterpret_cast<const char *>(data + sections[STRINGS]->offset + offset);
+}
+
+QString NavDataFile::getString(quint32 offset) const
+{
+  return QString::fromUtf8(getStringUtf8(offset));
+}
+
+bool NavDataFile::findHash(SectionType type, quint64 key, int& first, int& count) const
+{
+  int size = getCount(type);
+  if(size == 0 || key == 0)
+    return false;
+
+  // Size is a power of two and table has at least one free slot
+  const HashEntry *entries = getArray<HashEntry>(type);
+  quint64 mask = static_cast<quint64>(size) - 1;
+  for(quint64 index = IdentKey::mix(key) & mask;; index = (index + 1) & mask)
+  {
+    const HashEntry& entry = entries[index];
+    if(entry.count == 0)
+      return false;
+
+    if(entry.key == key)
+    {
+      first = entry.first;
+      count = entry.count;
+      return true;
+    }
+  }
+}
+
+int NavDataFile::findId(SectionType type, qint64 key) const
+{
+  const IdIndexEntry *begin = getArray<IdIndexEntry>(type);
+  const IdIndexEntry *end = begin + getCount(type);
+  const IdIndexEntry *it = std::lower_bound(begin, end, key, [](const IdIndexEntry& entry, qint64 k) -> bool {
+            return entry.key < k;
+          });
+  return it != end && it->key == key ? it->index : -1;
+}
+
+int NavDataFile::findAirportIndex(const QString& ident) const
+{
+  int first, count;
+  return findHash(AIRPORT_IDENT_HASH, IdentKey::encode(ident), first, count) ? first : -1;
+}
+
+int NavDataFile::findAirportIndexById(int id) const
+{
+  return findId(AIRPORT_ID_INDEX, id);
+}
+
+void NavDataFile::findNavaidIndexes(QVector<int>& indexes, const QString& ident) const
+{
+  indexes.clear();
+  int first, count;
+  if(findHash(NAVAID_IDENT_HASH, IdentKey::encode(ident), first, count))
+  {
+    for(int i = first; i < first + count; i++)
+      indexes.append(i);
+  }
+}
+
+int NavDataFile::findNavaidIndexById(NavaidType type, int id) const
+{
+  return findId(NAVAID_ID_INDEX, (static_cast<qint64>(type) << 32) | static_cast<quint32>(id));
+}
+
+void NavDataFile::findAirwayIndexes(QVector<int>& indexes, const QString& name) const
+{
+  indexes.clear();
+  int first, count;
+  if(findHash(AIRWAY_NAME_HASH, IdentKey::encode(name), first, count))
+  {
+    for(int i = first; i < first + count; i++)
+      indexes.append(i);
+  }
+}
+
+template<typename TYPE>
+void NavDataFile::getInRadius(QVector<IndexDistance>& result, SectionType gridType, SectionType recordType,
+                              const Pos& pos, float radiusMeter) const
+{
+  result.clear();
+  if(getCount(gridType) <= GRID_COLUMNS * GRID_ROWS)
+    return;
+
+  const quint32 *cellStart = getArray<quint32>(gridType);
+  const quint32 *items = cellStart + GRID_COLUMNS * GRID_ROWS + 1;
+  const TYPE *records = getArray<TYPE>(recordType);
+
+  for(const Rect& rect : Rect(pos, radiusMeter, true /* fast */).splitAtAntiMeridian())
+  {
+    for(int row = gridRow(rect.getSouth()); row <= gridRow(rect.getNorth()); row++)
+    {
+      for(int col = gridColumn(rect.getWest()); col <= gridColumn(rect.getEast()); col++)
+      {
+        int cell = row * GRID_COLUMNS + col;
+        for(quint32 i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+        {
+          const TYPE& record = records[items[i]];
+          float distanceMeter = pos.distanceMeterTo(Pos(record.lonX, record.latY));
+          if(distanceMeter <= radiusMeter)
+            result.append({static_cast<int>(items[i]), distanceMeter});
+        }
+      }
+    }
+  }
+
+  std::sort(result.begin(), result.end(), [](const IndexDistance& d1, const IndexDistance& d2) -> bool {
+              if(d1.distanceMeter == d2.distanceMeter)
+                return d1.index < d2.index;
+              else
+                return d1.distanceMeter < d2.distanceMeter;
+            });
+
+  // Split rectangles can share cells at the poles
+  result.erase(std::unique(result.begin(), result.end(), [](const IndexDistance& d1, const IndexDistance& d2) -> bool {
+                             return d1.index == d2.index;
+                           }), result.end());
+}
+
+void NavDataFile::getAirportsInRadius(QVector<IndexDistance>& result, const Pos& pos, float radiusMeter) const
+{
+  getInRadius<Airport>(result, AIRPORT_GRID, AIRPORTS, pos, radiusMeter);
+}
+
+void NavDataFile::getNavaidsInRadius(QVector<IndexDistance>& result, const Pos& pos, float radiusMeter) const
+{
+  getInRadius<Navaid>(result, NAVAID_GRID, NAVAIDS, pos, radiusMeter);
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,329 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_NAVDATAFILE_H
+#define ATOOLS_FS_COMMON_NAVDATAFILE_H
+
+#include "geo/spatialindex.h"
+
+#include <QCoreApplication>
+#include <QFile>
+
+namespace atools {
+namespace geo {
+class Pos;
+}
+
+namespace fs {
+namespace common {
+
+/*
+ * Layout of the read-only navdata file written by NavDataFileWriter.
+ *
+ * The file starts with a FileHeader followed by numSections SectionEntry records. Each section is a flat array of
+ * one of the structures below and starts at an offset aligned to eight bytes. All values are stored in host byte
+ * order which is checked when opening.
+ *
+ * Strings are referenced by their byte offset in the STRINGS section and are null terminated UTF-8.
+ * Offset 0 is always the empty string.
+ *
+ * Record arrays are sorted to allow ranges: airports and navaids by ident, runway ends and procedures by airport
+ * and airways by name. Hash sections map a packed IdentKey to a range in the sorted array. Id index sections are
+ * sorted by key for binary search. Grid sections contain the start offsets of GRID_COLUMNS * GRID_ROWS one
+ * degree cells followed by the record indexes of all cells.
+ */
+namespace navfile {
+
+/* "ATNV" */
+static Q_DECL_CONSTEXPR quint32 MAGIC_NUMBER = 0x564E5441;
+static Q_DECL_CONSTEXPR quint32 FILE_VERSION = 1;
+
+static Q_DECL_CONSTEXPR int GRID_COLUMNS = 360;
+static Q_DECL_CONSTEXPR int GRID_ROWS = 180;
+
+enum SectionType : quint32
+{
+  STRINGS = 1,
+  AIRPORTS,
+  RUNWAY_ENDS,
+  NAVAIDS,
+  AIRWAYS,
+  PROCEDURES,
+  PROCEDURE_POINTS,
+  ROUTE_NODES_RADIO,
+  ROUTE_EDGES_RADIO,
+  ROUTE_NODES_AIRWAY,
+  ROUTE_EDGES_AIRWAY,
+  AIRPORT_IDENT_HASH,
+  NAVAID_IDENT_HASH,
+  AIRWAY_NAME_HASH,
+  AIRPORT_ID_INDEX,
+  NAVAID_ID_INDEX,
+  AIRPORT_GRID,
+  NAVAID_GRID,
+  NUM_SECTION_TYPES
+};
+
+enum NavaidType : quint32
+{
+  VOR = 1,
+  NDB = 2,
+  WAYPOINT = 3
+};
+
+struct FileHeader
+{
+  quint32 magic, version;
+  qint32 byteOrder; // QSysInfo::ByteOrder
+  quint32 numSections;
+  qint64 createdMs; // Milliseconds since epoch UTC
+  quint32 airacCycle, validThrough; // String offsets
+};
+
+struct SectionEntry
+{
+  quint32 type, elementSize, count, reserved;
+  quint64 offset, size;
+};
+
+struct Airport
+{
+  qint32 id;
+  quint32 ident, icao, name, region;
+  float lonX, latY, altitudeFt, magVar;
+  qint32 longestRunwayLengthFt;
+  qint32 firstRunwayEnd, numRunwayEnds, firstProcedure, numProcedures;
+};
+
+struct RunwayEnd
+{
+  qint32 id, airportIndex;
+  quint32 name;
+  float lonX, latY, headingTrue, altitudeFt;
+};
+
+struct Navaid
+{
+  qint32 id;
+  quint32 type; // NavaidType
+  quint32 ident, region, name;
+  float lonX, latY, magVar;
+  qint32 frequency; // MHz * 1000 for VOR, kHz * 100 for NDB, 0 for waypoints
+};
+
+struct Airway
+{
+  qint32 id;
+  quint32 name;
+  qint32 fromWaypointId, toWaypointId;
+  qint32 fromNavaidIndex, toNavaidIndex; // Index into NAVAIDS or -1
+  qint32 fragment, sequence, minAltitudeFt, maxAltitudeFt;
+  char type, direction, routeType, reserved;
+  float fromLonX, fromLatY, toLonX, toLatY;
+};
+
+struct Procedure
+{
+  qint32 approachId, transitionId; // transitionId is -1 for approaches
+  qint32 airportIndex;
+  quint32 arincName, type, fixIdent;
+  qint32 firstPoint, numPoints; // Range in PROCEDURE_POINTS - empty if geometry was not calculated
+  float distanceNm, missedDistanceNm;
+};
+
+struct Point
+{
+  float lonX, latY;
+};
+
+/* Node of the routing network. Outgoing edges are in the range firstEdge to firstEdge + numEdges - 1. */
+struct RouteNode
+{
+  qint32 nodeId, navId, type;
+  float lonX, latY;
+  qint32 firstEdge, numEdges;
+};
+
+struct RouteEdge
+{
+  qint32 fromNodeIndex, toNodeIndex;
+  qint32 airwayId; // -1 for radio network
+  qint32 distanceMeter, minAltitudeFt, maxAltitudeFt;
+  quint32 airwayName;
+  qint8 type, direction, reserved1, reserved2;
+};
+
+/* Hash slot for an IdentKey. Empty if count is 0. */
+struct HashEntry
+{
+  quint64 key;
+  qint32 first, count;
+};
+
+/* Key is id for airports and type << 32 | id for navaids */
+struct IdIndexEntry
+{
+  qint64 key;
+  qint32 index, reserved;
+};
+
+} // namespace navfile
+
+/*
+ * Reader for the read-only navdata file.
+ *
+ * The file is memory mapped and not read or copied. Opening only validates the header and section table.
+ * Pages are loaded on demand by the operating system and shared between all processes mapping the same file.
+ *
+ * All methods are const and thread safe after open().
+ */
+class NavDataFile
+{
+  Q_DECLARE_TR_FUNCTIONS(NavDataFile)
+
+public:
+  NavDataFile();
+  ~NavDataFile();
+
+  NavDataFile(const NavDataFile& other) = delete;
+  NavDataFile& operator=(const NavDataFile& other) = delete;
+
+  /* Open and map file. Returns false if file cannot be opened or is invalid. See getErrorString(). */
+  bool open(const QString& filename);
+  void close();
+
+  bool isOpen() const
+  {
+    return data != nullptr;
+  }
+
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+  const navfile::FileHeader& getHeader() const
+  {
+    return *reinterpret_cast<const navfile::FileHeader *>(data);
+  }
+
+  /* String from table or empty if offset is invalid */
+  QString getString(quint32 offset) const;
+
+  /* Raw null terminated UTF-8 string from table */
+  const char *getStringUtf8(quint32 offset) const;
+
+  /* Generic access to section arrays. Returns null and 0 for missing sections. */
+  template<typename TYPE>
+  const TYPE *getArray(navfile::SectionType type) const
+  {
+    return sections[type] != nullptr ? reinterpret_cast<const TYPE *>(data + sections[type]->offset) : nullptr;
+  }
+
+  int getCount(navfile::SectionType type) const
+  {
+    return sections[type] != nullptr ? static_cast<int>(sections[type]->count) : 0;
+  }
+
+  /* Typed access ====================================================== */
+  int getNumAirports() const
+  {
+    return getCount(navfile::AIRPORTS);
+  }
+
+  const navfile::Airport& getAirport(int index) const
+  {
+    return getArray<navfile::Airport>(navfile::AIRPORTS)[index];
+  }
+
+  const navfile::RunwayEnd& getRunwayEnd(int index) const
+  {
+    return getArray<navfile::RunwayEnd>(navfile::RUNWAY_ENDS)[index];
+  }
+
+  int getNumNavaids() const
+  {
+    return getCount(navfile::NAVAIDS);
+  }
+
+  const navfile::Navaid& getNavaid(int index) const
+  {
+    return getArray<navfile::Navaid>(navfile::NAVAIDS)[index];
+  }
+
+  int getNumAirways() const
+  {
+    return getCount(navfile::AIRWAYS);
+  }
+
+  const navfile::Airway& getAirway(int index) const
+  {
+    return getArray<navfile::Airway>(navfile::AIRWAYS)[index];
+  }
+
+  const navfile::Procedure& getProcedure(int index) const
+  {
+    return getArray<navfile::Procedure>(navfile::PROCEDURES)[index];
+  }
+
+  /* Points of procedure geometry. Number of points is in procedure. */
+  const navfile::Point *getProcedurePoints(const navfile::Procedure& procedure) const
+  {
+    return getArray<navfile::Point>(navfile::PROCEDURE_POINTS) + procedure.firstPoint;
+  }
+
+  /* Lookups ====================================================== */
+  /* Index of airport by ident or -1 if not found */
+  int findAirportIndex(const QString& ident) const;
+  int findAirportIndexById(int id) const;
+
+  /* Indexes of all navaids with ident */
+  void findNavaidIndexes(QVector<int>& indexes, const QString& ident) const;
+  int findNavaidIndexById(navfile::NavaidType type, int id) const;
+
+  /* Indexes of all airway segments with name sorted by fragment and sequence */
+  void findAirwayIndexes(QVector<int>& indexes, const QString& name) const;
+
+  /* Spatial queries. Result is sorted by distance and index refers to the airport or navaid arrays. */
+  void getAirportsInRadius(QVector<atools::geo::IndexDistance>& result, const atools::geo::Pos& pos,
+                           float radiusMeter) const;
+  void getNavaidsInRadius(QVector<atools::geo::IndexDistance>& result, const atools::geo::Pos& pos,
+                          float radiusMeter) const;
+
+private:
+  /* Get first and count of range from hash section or false if not found */
+  bool findHash(navfile::SectionType type, quint64 key, int& first, int& count) const;
+  int findId(navfile::SectionType type, qint64 key) const;
+
+  template<typename TYPE>
+  void getInRadius(QVector<atools::geo::IndexDistance>& result, navfile::SectionType gridType,
+                   navfile::SectionType recordType, const atools::geo::Pos& pos, float radiusMeter) const;
+
+  QFile file;
+  const uchar *data = nullptr;
+  qint64 dataSize = 0;
+  QString errorString;
+
+  /* Section table entries by type or null if not present */
+  const navfile::SectionEntry *sections[navfile::NUM_SECTION_TYPES];
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_NAVDATAFILE_H
@@ -0,0 +1,573 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/navdatafilewriter.h"
+
+#include "fs/common/binarygeometry.h"
+#include "fs/common/navdatafile.h"
+#include "fs/db/databasemeta.h"
+#include "geo/pos.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+#include "util/identkey.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSaveFile>
+#include <QSysInfo>
+
+#include <algorithm>
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using namespace navfile;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+using atools::geo::Pos;
+using atools::util::IdentKey;
+
+/* Deduplicated null terminated UTF-8 strings. Offset 0 is the empty string. */
+struct StringTable
+{
+  StringTable()
+  {
+    bytes.append('\0');
+  }
+
+  quint32 add(const QString& str)
+  {
+    if(str.isEmpty())
+      return 0;
+
+    auto it = offsets.constFind(str);
+    if(it != offsets.constEnd())
+      return it.value();
+
+    quint32 offset = static_cast<quint32>(bytes.size());
+    bytes.append(str.toUtf8());
+    bytes.append('\0');
+    offsets.insert(str, offset);
+    return offset;
+  }
+
+  QByteArray bytes;
+  QHash<QString, quint32> offsets;
+};
+
+/* Section data before writing */
+struct Section
+{
+  quint32 type, elementSize, count;
+  QByteArray bytes;
+};
+
+template<typename TYPE>
+static void addSection(QVector<Section>& sections, SectionType type, const QVector<TYPE>& array)
+{
+  sections.append({type, static_cast<quint32>(sizeof(TYPE)), static_cast<quint32>(array.size()),
+                   QByteArray(reinterpret_cast<const char *>(array.constData()),
+                              array.size() * static_cast<int>(sizeof(TYPE)))});
+}
+
+/* Build open addressing hash table for sorted keys. Each entry points to the range of equal keys. */
+static QVector<HashEntry> buildHash(const QVector<quint64>& sortedKeys)
+{
+  int numUnique = 0;
+  for(int i = 0; i < sortedKeys.size(); i++)
+  {
+    if(sortedKeys.at(i) != 0 && (i == 0 || sortedKeys.at(i) != sortedKeys.at(i - 1)))
+      numUnique++;
+  }
+
+  // Load factor of 0.5 at most
+  int capacity = 16;
+  while(capacity < numUnique * 2)
+    capacity *= 2;
+
+  QVector<HashEntry> table(capacity, {0, 0, 0});
+  quint64 mask = static_cast<quint64>(capacity) - 1;
+  for(int i = 0; i < sortedKeys.size();)
+  {
+    quint64 key = sortedKeys.at(i);
+    int first = i;
+    while(i < sortedKeys.size() && sortedKeys.at(i) == key)
+      i++;
+
+    if(key == 0)
+      // Empty idents are not indexed
+      continue;
+
+    quint64 index = IdentKey::mix(key) & mask;
+    while(table.at(static_cast<int>(index)).count != 0)
+      index = (index + 1) & mask;
+    table[static_cast<int>(index)] = {key, first, i - first};
+  }
+  return table;
+}
+
+/* Cell start offsets followed by record indexes */
+template<typename TYPE>
+static QVector<quint32> buildGrid(const QVector<TYPE>& records)
+{
+  const int numCells = GRID_COLUMNS * GRID_ROWS;
+  QVector<quint32> grid(numCells + 1 + records.size(), 0);
+  QVector<int> cells(records.size());
+
+  for(int i = 0; i < records.size(); i++)
+  {
+    int col = std::max(0, std::min(static_cast<int>(records.at(i).lonX + 180.f), GRID_COLUMNS - 1));
+    int row = std::max(0, std::min(static_cast<int>(records.at(i).latY + 90.f), GRID_ROWS - 1));
+    cells[i] = row * GRID_COLUMNS + col;
+    grid[cells.at(i) + 1]++;
+  }
+
+  for(int cell = 0; cell < numCells; cell++)
+    grid[cell + 1] += grid.at(cell);
+
+  QVector<quint32> fillPos = grid.mid(0, numCells);
+  for(int i = 0; i < records.size(); i++)
+    grid[numCells + 1 + static_cast<int>(fillPos[cells.at(i)]++)] = static_cast<quint32>(i);
+
+  return grid;
+}
+
+/* Load nodes and edges of a routing network. Edges are sorted by from node. */
+static void loadRouteNetwork(QVector<RouteNode>& nodes, QVector<RouteEdge>& edges, atools::sql::SqlDatabase *db,
+                             StringTable& strings, bool airway)
+{
+  QString nodeTable(airway ? "route_node_airway" : "route_node_radio");
+  QString edgeTable(airway ? "route_edge_airway" : "route_edge_radio");
+
+  SqlUtil util(db);
+  if(!util.hasTableAndRows(nodeTable) || !util.hasTableAndRows(edgeTable))
+    return;
+
+  QHash<int, int> nodeIdToIndex;
+  SqlQuery nodeQuery("select node_id, nav_id, type, lonx, laty from " + nodeTable + " order by node_id", db);
+  nodeQuery.exec();
+  while(nodeQuery.next())
+  {
+    nodeIdToIndex.insert(nodeQuery.valueInt(0), nodes.size());
+    nodes.append({nodeQuery.valueInt(0), nodeQuery.valueInt(1), nodeQuery.valueInt(2), nodeQuery.valueFloat(3),
+                  nodeQuery.valueFloat(4), 0, 0});
+  }
+
+  QString edgeQueryStr;
+  if(airway)
+    edgeQueryStr = "select from_node_id, to_node_id, airway_id, type, direction, minimum_altitude, maximum_altitude, "
+                   "airway_name from route_edge_airway order by from_node_id, edge_id";
+  else
+    edgeQueryStr = "select from_node_id, to_node_id, distance from route_edge_radio order by from_node_id, edge_id";
+
+  SqlQuery edgeQuery(edgeQueryStr, db);
+  edgeQuery.exec();
+  while(edgeQuery.next())
+  {
+    int from = nodeIdToIndex.value(edgeQuery.valueInt(0), -1), to = nodeIdToIndex.value(edgeQuery.valueInt(1), -1);
+    if(from == -1 || to == -1)
+      continue;
+
+    RouteEdge edge;
+    std::memset(&edge, 0, sizeof(RouteEdge));
+    edge.fromNodeIndex = from;
+    edge.toNodeIndex = to;
+    if(airway)
+    {
+      const RouteNode& fromNode = nodes.at(from), & toNode = nodes.at(to);
+      edge.airwayId = edgeQuery.valueInt(2);
+      edge.type = static_cast<qint8>(edgeQuery.valueInt(3));
+      edge.direction = static_cast<qint8>(edgeQuery.valueInt(4));
+      edge.minAltitudeFt = edgeQuery.valueInt(5);
+      edge.maxAltitudeFt = edgeQuery.valueInt(6);
+      edge.airwayName = strings.add(edgeQuery.valueStr(7));
+      edge.distanceMeter = static_cast<qint32>(Pos(fromNode.lonX, fromNode.latY).
+                                               distanceMeterTo(Pos(toNode.lonX, toNode.latY)) + 0.5f);
+    }
+    else
+    {
+      edge.airwayId = -1;
+      edge.distanceMeter = edgeQuery.valueInt(2);
+    }
+
+    if(nodes.at(from).numEdges == 0)
+      nodes[from].firstEdge = edges.size();
+    nodes[from].numEdges++;
+    edges.append(edge);
+  }
+}
+
+NavDataFileWriter::NavDataFileWriter(atools::sql::SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+bool NavDataFileWriter::write(const QString& filename)
+{
+  QElapsedTimer timer;
+  timer.start();
+  errorString.clear();
+
+  StringTable strings;
+  SqlUtil util(db);
+
+  // Airports ====================================================================
+  QVector<Airport> airports;
+  QVector<quint64> airportKeys;
+  {
+    QVector<std::pair<quint64, Airport> > tmp;
+    SqlQuery query("select airport_id, ident, icao, name, region, lonx, laty, altitude, mag_var, "
+                   "longest_runway_length from airport", db);
+    query.exec();
+    while(query.next())
+    {
+      Airport airport;
+      std::memset(&airport, 0, sizeof(Airport));
+      airport.id = query.valueInt(0);
+      airport.ident = strings.add(query.valueStr(1));
+      airport.icao = strings.add(query.valueStr(2));
+      airport.name = strings.add(query.valueStr(3));
+      airport.region = strings.add(query.valueStr(4));
+      airport.lonX = query.valueFloat(5);
+      airport.latY = query.valueFloat(6);
+      airport.altitudeFt = query.valueFloat(7);
+      airport.magVar = query.valueFloat(8);
+      airport.longestRunwayLengthFt = query.valueInt(9);
+      tmp.append(std::make_pair(IdentKey::encode(query.valueStr(1)), airport));
+    }
+
+    std::sort(tmp.begin(), tmp.end(), [](const std::pair<quint64, Airport>& a1,
+                                         const std::pair<quint64, Airport>& a2) -> bool {
+                return a1.first < a2.first || (a1.first == a2.first && a1.second.id < a2.second.id);
+              });
+
+    for(const std::pair<quint64, Airport>& airport : tmp)
+    {
+      airportKeys.append(airport.first);
+      airports.append(airport.second);
+    }
+  }
+
+  QVector<IdIndexEntry> airportIds;
+  QHash<int, int> airportIdToIndex;
+  for(int i = 0; i < airports.size(); i++)
+  {
+    airportIds.append({airports.at(i).id, i, 0});
+    airportIdToIndex.insert(airports.at(i).id, i);
+  }
+  std::sort(airportIds.begin(), airportIds.end(), [](const IdIndexEntry& e1, const IdIndexEntry& e2) -> bool {
+              return e1.key < e2.key;
+            });
+
+  // Runway ends ====================================================================
+  QVector<RunwayEnd> runwayEnds;
+  {
+    SqlQuery query("select e.runway_end_id, r.airport_id, e.name, e.lonx, e.laty, e.heading, "
+                   "coalesce(e.altitude, r.altitude) "
+                   "from runway r join runway_end e on e.runway_end_id = r.primary_end_id "
+                   "union all "
+                   "select e.runway_end_id, r.airport_id, e.name, e.lonx, e.laty, e.heading, "
+                   "coalesce(e.altitude, r.altitude) "
+                   "from runway r join runway_end e on e.runway_end_id = r.secondary_end_id", db);
+    query.exec();
+    while(query.next())
+    {
+      int airportIndex = airportIdToIndex.value(query.valueInt(1), -1);
+      if(airportIndex != -1)
+        runwayEnds.append({query.valueInt(0), airportIndex, strings.add(query.valueStr(2)), query.valueFloat(3),
+                           query.valueFloat(4), query.valueFloat(5), query.valueFloat(6)});
+    }
+
+    std::sort(runwayEnds.begin(), runwayEnds.end(), [](const RunwayEnd& e1, const RunwayEnd& e2) -> bool {
+                return e1.airportIndex < e2.airportIndex || (e1.airportIndex == e2.airportIndex && e1.id < e2.id);
+              });
+
+    for(int i = 0; i < runwayEnds.size(); i++)
+    {
+      Airport& airport = airports[runwayEnds.at(i).airportIndex];
+      if(airport.numRunwayEnds == 0)
+        airport.firstRunwayEnd = i;
+      airport.numRunwayEnds++;
+    }
+  }
+
+  // Navaids ====================================================================
+  QVector<Navaid> navaids;
+  QVector<quint64> navaidKeys;
+  {
+    QVector<std::pair<quint64, Navaid> > tmp;
+    const QVector<std::pair<NavaidType, QString> > queries({
+      {VOR, "select vor_id, ident, region, name, lonx, laty, mag_var, frequency from vor"},
+      {NDB, "select ndb_id, ident, region, name, lonx, laty, mag_var, frequency from ndb"},
+      {WAYPOINT, "select waypoint_id, ident, region, null, lonx, laty, mag_var, 0 from waypoint"}
+    });
+
+    for(const std::pair<NavaidType, QString>& queryPair : queries)
+    {
+      SqlQuery query(queryPair.second, db);
+      query.exec();
+      while(query.next())
+      {
+        Navaid navaid = {query.valueInt(0), queryPair.first, strings.add(query.valueStr(1)),
+                         strings.add(query.valueStr(2)), strings.add(query.valueStr(3)), query.valueFloat(4),
+                         query.valueFloat(5), query.valueFloat(6), query.valueInt(7)};
+        tmp.append(std::make_pair(IdentKey::encode(query.valueStr(1)), navaid));
+      }
+    }
+
+    std::sort(tmp.begin(), tmp.end(), [](const std::pair<quint64, Navaid>& n1,
+                                         const std::pair<quint64, Navaid>& n2) -> bool {
+                if(n1.first != n2.first)
+                  return n1.first < n2.first;
+                else if(n1.second.type != n2.second.type)
+                  return n1.second.type < n2.second.type;
+                else
+                  return n1.second.id < n2.second.id;
+              });
+
+    for(const std::pair<quint64, Navaid>& navaid : tmp)
+    {
+      navaidKeys.append(navaid.first);
+      navaids.append(navaid.second);
+    }
+  }
+
+  QVector<IdIndexEntry> navaidIds;
+  QHash<qint64, int> navaidIdToIndex;
+  for(int i = 0; i < navaids.size(); i++)
+  {
+    qint64 key = (static_cast<qint64>(navaids.at(i).type) << 32) | static_cast<quint32>(navaids.at(i).id);
+    navaidIds.append({key, i, 0});
+    navaidIdToIndex.insert(key, i);
+  }
+  std::sort(navaidIds.begin(), navaidIds.end(), [](const IdIndexEntry& e1, const IdIndexEntry& e2) -> bool {
+              return e1.key < e2.key;
+            });
+
+  // Airways ====================================================================
+  QVector<Airway> airways;
+  QVector<quint64> airwayKeys;
+  if(util.hasTableAndRows("airway"))
+  {
+    QVector<std::pair<quint64, Airway> > tmp;
+    SqlQuery query("select airway_id, airway_name, airway_type, route_type, airway_fragment_no, sequence_no, "
+                   "from_waypoint_id, to_waypoint_id, direction, minimum_altitude, maximum_altitude, "
+                   "from_lonx, from_laty, to_lonx, to_laty from airway", db);
+    query.exec();
+    while(query.next())
+    {
+      Airway airway;
+      std::memset(&airway, 0, sizeof(Airway));
+      airway.id = query.valueInt(0);
+      airway.name = strings.add(query.valueStr(1));
+      airway.type = query.valueStr(2).isEmpty() ? '\0' : query.valueStr(2).at(0).toLatin1();
+      airway.routeType = query.valueStr(3).isEmpty() ? '\0' : query.valueStr(3).at(0).toLatin1();
+      airway.fragment = query.valueInt(4);
+      airway.sequence = query.valueInt(5);
+      airway.fromWaypointId = query.valueInt(6);
+      airway.toWaypointId = query.valueInt(7);
+      airway.direction = query.valueStr(8).isEmpty() ? '\0' : query.valueStr(8).at(0).toLatin1();
+      airway.minAltitudeFt = query.valueInt(9);
+      airway.maxAltitudeFt = query.valueInt(10);
+      airway.fromLonX = query.valueFloat(11);
+      airway.fromLatY = query.valueFloat(12);
+      airway.toLonX = query.valueFloat(13);
+      airway.toLatY = query.valueFloat(14);
+      airway.fromNavaidIndex = navaidIdToIndex.value((static_cast<qint64>(WAYPOINT) << 32) |
+                                                     static_cast<quint32>(airway.fromWaypointId), -1);
+      airway.toNavaidIndex = navaidIdToIndex.value((static_cast<qint64>(WAYPOINT) << 32) |
+                                                   static_cast<quint32>(airway.toWaypointId), -1);
+      tmp.append(std::make_pair(IdentKey::encode(query.valueStr(1)), airway));
+    }
+
+    std::sort(tmp.begin(), tmp.end(), [](const std::pair<quint64, Airway>& a1,
+                                         const std::pair<quint64, Airway>& a2) -> bool {
+                if(a1.first != a2.first)
+                  return a1.first < a2.first;
+                else if(a1.second.fragment != a2.second.fragment)
+                  return a1.second.fragment < a2.second.fragment;
+                else
+                  return a1.second.sequence < a2.second.sequence;
+              });
+
+    for(const std::pair<quint64, Airway>& airway : tmp)
+    {
+      airwayKeys.append(airway.first);
+      airways.append(airway.second);
+    }
+  }
+
+  // Procedures ====================================================================
+  QVector<Procedure> procedures;
+  QVector<Point> points;
+  if(util.hasTableAndRows("approach"))
+  {
+    // Optional precalculated geometry
+    QHash<qint64, QByteArray> geometries;
+    QHash<qint64, std::pair<float, float> > distances;
+    if(util.hasTableAndRows("procedure_geometry"))
+    {
+      SqlQuery query("select coalesce(p.approach_id, t.approach_id), coalesce(p.transition_id, -1), "
+                     "p.distance, p.missed_distance, p.geometry "
+                     "from procedure_geometry p left outer join transition t on t.transition_id = p.transition_id",
+                     db);
+      query.exec();
+      while(query.next())
+      {
+        qint64 key = (static_cast<qint64>(query.valueInt(0)) << 32) | static_cast<quint32>(query.valueInt(1));
+        distances.insert(key, std::make_pair(query.valueFloat(2), query.valueFloat(3)));
+        geometries.insert(key, query.value(4).toByteArray());
+      }
+    }
+
+    SqlQuery query("select a.approach_id, -1, a.airport_id, a.arinc_name, a.type, a.fix_ident from approach a "
+                   "union all "
+                   "select t.approach_id, t.transition_id, a.airport_id, null, t.type, t.fix_ident "
+                   "from transition t join approach a on a.approach_id = t.approach_id", db);
+    query.exec();
+    while(query.next())
+    {
+      int airportIndex = airportIdToIndex.value(query.valueInt(2), -1);
+      if(airportIndex != -1)
+        procedures.append({query.valueInt(0), query.valueInt(1), airportIndex, strings.add(query.valueStr(3)),
+                           strings.add(query.valueStr(4)), strings.add(query.valueStr(5)), 0, 0, 0.f, 0.f});
+    }
+
+    std::sort(procedures.begin(), procedures.end(), [](const Procedure& p1, const Procedure& p2) -> bool {
+                if(p1.airportIndex != p2.airportIndex)
+                  return p1.airportIndex < p2.airportIndex;
+                else if(p1.approachId != p2.approachId)
+                  return p1.approachId < p2.approachId;
+                else
+                  return p1.transitionId < p2.transitionId;
+              });
+
+    for(int i = 0; i < procedures.size(); i++)
+    {
+      Procedure& procedure = procedures[i];
+      Airport& airport = airports[procedure.airportIndex];
+      if(airport.numProcedures == 0)
+        airport.firstProcedure = i;
+      airport.numProcedures++;
+
+      qint64 key = (static_cast<qint64>(procedure.approachId) << 32) | static_cast<quint32>(procedure.transitionId);
+      auto it = geometries.constFind(key);
+      if(it != geometries.constEnd())
+      {
+        const atools::geo::LineString line = BinaryGeometry(it.value()).getGeometry();
+        procedure.firstPoint = points.size();
+        procedure.numPoints = line.size();
+        for(const Pos& pos : line)
+          points.append({pos.getLonX(), pos.getLatY()});
+        procedure.distanceNm = distances.value(key).first;
+        procedure.missedDistanceNm = distances.value(key).second;
+      }
+    }
+  }
+
+  // Routing networks ====================================================================
+  QVector<RouteNode> radioNodes, airwayNodes;
+  QVector<RouteEdge> radioEdges, airwayEdges;
+  loadRouteNetwork(radioNodes, radioEdges, db, strings, false /* airway */);
+  loadRouteNetwork(airwayNodes, airwayEdges, db, strings, true /* airway */);
+
+  // Header strings ====================================================================
+  atools::fs::db::DatabaseMeta meta(db);
+  FileHeader header;
+  std::memset(&header, 0, sizeof(FileHeader));
+  header.magic = MAGIC_NUMBER;
+  header.version = FILE_VERSION;
+  header.byteOrder = static_cast<qint32>(QSysInfo::ByteOrder);
+  header.createdMs = QDateTime::currentMSecsSinceEpoch();
+  header.airacCycle = strings.add(meta.getAiracCycle());
+  header.validThrough = strings.add(meta.getValidThrough());
+
+  // Collect sections ====================================================================
+  QVector<Section> sections;
+  sections.append({STRINGS, 1, static_cast<quint32>(strings.bytes.size()), strings.bytes});
+  addSection(sections, AIRPORTS, airports);
+  addSection(sections, RUNWAY_ENDS, runwayEnds);
+  addSection(sections, NAVAIDS, navaids);
+  addSection(sections, AIRWAYS, airways);
+  addSection(sections, PROCEDURES, procedures);
+  addSection(sections, PROCEDURE_POINTS, points);
+  addSection(sections, ROUTE_NODES_RADIO, radioNodes);
+  addSection(sections, ROUTE_EDGES_RADIO, radioEdges);
+  addSection(sections, ROUTE_NODES_AIRWAY, airwayNodes);
+  addSection(sections, ROUTE_EDGES_AIRWAY, airwayEdges);
+  addSection(sections, AIRPORT_IDENT_HASH, buildHash(airportKeys));
+  addSection(sections, NAVAID_IDENT_HASH, buildHash(navaidKeys));
+  addSection(sections, AIRWAY_NAME_HASH, buildHash(airwayKeys));
+  addSection(sections, AIRPORT_ID_INDEX, airportIds);
+  addSection(sections, NAVAID_ID_INDEX, navaidIds);
+  addSection(sections, AIRPORT_GRID, buildGrid(airports));
+  addSection(sections, NAVAID_GRID, buildGrid(navaids));
+  header.numSections = static_cast<quint32>(sections.size());
+
+  // Calculate offsets aligned to eight bytes
+  QVector<SectionEntry> entries;
+  quint64 offset = sizeof(FileHeader) + sections.size() * sizeof(SectionEntry);
+  for(const Section& section : sections)
+  {
+    offset = (offset + 7) & ~static_cast<quint64>(7);
+    entries.append({section.type, section.elementSize, section.count, 0, offset,
+                    static_cast<quint64>(section.bytes.size())});
+    offset += static_cast<quint64>(section.bytes.size());
+  }
+
+  // Write file ====================================================================
+  QSaveFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+    file.write(reinterpret_cast<const char *>(entries.constData()),
+               entries.size() * static_cast<int>(sizeof(SectionEntry)));
+
+    for(int i = 0; i < sections.size(); i++)
+    {
+      // Padding
+      file.write(QByteArray(static_cast<int>(entries.at(i).offset - static_cast<quint64>(file.pos())), '\0'));
+      file.write(sections.at(i).bytes);
+    }
+
+    if(!file.commit())
+      errorString = file.errorString();
+  }
+  else
+    errorString = file.errorString();
+
+  if(!errorString.isEmpty())
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << errorString;
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << filename << "airports" << airports.size() << "runway ends" << runwayEnds.size()
+           << "navaids" << navaids.size() << "airways" << airways.size() << "procedures" << procedures.size()
+           << "strings" << strings.bytes.size() << "bytes" << offset << timer.elapsed() << "ms";
+  return true;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,64 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_NAVDATAFILEWRITER_H
+#define ATOOLS_FS_COMMON_NAVDATAFILEWRITER_H
+
+#include <QCoreApplication>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/*
+ * Exports a compiled navdata database into the memory mappable read-only file format described in navdatafile.h.
+ *
+ * Writes airports, runway ends, VOR, NDB, waypoints, airways, procedures and the routing networks if available.
+ * Procedure geometry is added if the table procedure_geometry was filled during compilation.
+ * String tables, ident hash tables, id indexes and spatial grids are built while writing.
+ *
+ * Use NavDataFile to read the result.
+ */
+class NavDataFileWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(NavDataFileWriter)
+
+public:
+  NavDataFileWriter(atools::sql::SqlDatabase *sqlDb);
+
+  /* Write file atomically. Returns false on error. See getErrorString(). */
+  bool write(const QString& filename);
+
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+private:
+  atools::sql::SqlDatabase *db;
+  QString errorString;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_NAVDATAFILEWRITER_H
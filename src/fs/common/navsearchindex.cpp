@@ -0,0 +1,414 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/navsearchindex.h"
+
+#include "atools.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using atools::geo::Pos;
+using atools::geo::Point3D;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+Q_DECL_CONSTEXPR int NavSearchIndex::IDENT_SIZE;
+Q_DECL_CONSTEXPR float NavSearchIndex::FUZZY_RATIO;
+
+NavSearchIndex::NavSearchIndex()
+{
+}
+
+NavSearchIndex::~NavSearchIndex()
+{
+}
+
+void NavSearchIndex::clear()
+{
+  objects.clear();
+  idents.clear();
+  trigrams.clear();
+  namePool.clear();
+}
+
+void NavSearchIndex::loadFromDatabase(sql::SqlDatabase *db, int numThreads)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+
+  SqlUtil util(db);
+  if(util.hasTableAndRows("airport"))
+  {
+    SqlQuery query("select airport_id, ident, icao, iata, faa, local, name, city, lonx, laty from airport", db);
+    query.exec();
+    while(query.next())
+      addObject(NAVSEARCH_AIRPORT, query.valueInt("airport_id"),
+                {query.valueStr("ident"), query.valueStr("icao"), query.valueStr("iata"), query.valueStr("faa"),
+                 query.valueStr("local")},
+                {query.valueStr("name"), query.valueStr("city")},
+                Pos(query.valueFloat("lonx"), query.valueFloat("laty")));
+  }
+
+  if(util.hasTableAndRows("nav_search"))
+  {
+    SqlQuery query("select vor_id, ndb_id, waypoint_id, ident, name, lonx, laty from nav_search", db);
+    query.exec();
+    while(query.next())
+    {
+      NavSearchType type;
+      int id;
+      if(!query.isNull("vor_id"))
+      {
+        type = NAVSEARCH_VOR;
+        id = query.valueInt("vor_id");
+      }
+      else if(!query.isNull("ndb_id"))
+      {
+        type = NAVSEARCH_NDB;
+        id = query.valueInt("ndb_id");
+      }
+      else
+      {
+        type = NAVSEARCH_WAYPOINT;
+        id = query.valueInt("waypoint_id");
+      }
+
+      addObject(type, id, {query.valueStr("ident")}, {query.valueStr("name")},
+                Pos(query.valueFloat("lonx"), query.valueFloat("laty")));
+    }
+  }
+
+  build(numThreads);
+
+  qDebug() << Q_FUNC_INFO << "objects" << objects.size() << "idents" << idents.size() << "trigrams" << trigrams.size()
+           << timer.elapsed() << "ms";
+}
+
+void NavSearchIndex::addObject(NavSearchType type, int id, const QStringList& identList, const QStringList& names,
+                               const Pos& pos)
+{
+  int index = objects.size();
+
+  // Names are prefixed by a space to allow matching word starts with trigrams
+  QString text;
+  for(const QString& name : names)
+  {
+    QString normalized = normalize(name);
+    if(!normalized.isEmpty())
+    {
+      if(!text.isEmpty())
+        text.append('\n');
+      text.append(' ').append(normalized);
+    }
+  }
+
+  Object object;
+  object.pos = pos;
+  object.id = id;
+  object.type = type;
+  object.nameOffset = namePool.size();
+  object.nameLength = text.size();
+  namePool.append(text);
+  objects.append(object);
+
+  QVector<QByteArray> added;
+  for(const QString& ident : identList)
+  {
+    QByteArray key = normalize(ident).remove(' ').toLatin1().left(IDENT_SIZE);
+    if(key.isEmpty() || added.contains(key))
+      continue;
+    added.append(key);
+
+    IdentKey identKey;
+    std::memset(identKey.ident, 0, IDENT_SIZE);
+    std::memcpy(identKey.ident, key.constData(), static_cast<size_t>(key.size()));
+    identKey.index = index;
+    idents.append(identKey);
+  }
+}
+
+void NavSearchIndex::build(int numThreads)
+{
+  std::sort(idents.begin(), idents.end(), [](const IdentKey& key1, const IdentKey& key2) -> bool {
+    int cmp = std::memcmp(key1.ident, key2.ident, IDENT_SIZE);
+    return cmp == 0 ? key1.index < key2.index : cmp < 0;
+  });
+  idents.squeeze();
+  namePool.squeeze();
+
+  // Objects are visited in order which keeps the posting lists sorted
+  trigrams.clear();
+  const QChar *pool = namePool.constData();
+  for(int index = 0; index < objects.size(); index++)
+  {
+    const Object& object = objects.at(index);
+    for(int i = object.nameOffset; i + 3 <= object.nameOffset + object.nameLength; i++)
+    {
+      if(pool[i] == '\n' || pool[i + 1] == '\n' || pool[i + 2] == '\n')
+        continue;
+
+      QVector<int>& postings = trigrams[trigramKey(pool + i)];
+      if(postings.isEmpty() || postings.constLast() != index)
+        postings.append(index);
+    }
+  }
+
+  for(auto it = trigrams.begin(); it != trigrams.end(); ++it)
+    it.value().squeeze();
+
+  objects.updateIndex(numThreads);
+}
+
+QString NavSearchIndex::normalize(const QString& text)
+{
+  QString normalized = atools::normalizeStr(text).toUpper();
+
+  QString retval;
+  retval.reserve(normalized.size());
+  for(QChar c : normalized)
+  {
+    if(c.isLetterOrNumber())
+      retval.append(c);
+    else if(!retval.isEmpty() && retval.at(retval.size() - 1) != ' ')
+      retval.append(' ');
+  }
+
+  if(retval.endsWith(' '))
+    retval.chop(1);
+  return retval;
+}
+
+int NavSearchIndex::compareIdent(const IdentKey& key, const QByteArray& prefix)
+{
+  return std::strncmp(key.ident, prefix.constData(), static_cast<size_t>(prefix.size()));
+}
+
+void NavSearchIndex::searchIdents(QVector<Candidate>& candidates, const QString& query, NavSearchTypes types) const
+{
+  if(query.contains(' '))
+    return;
+
+  QByteArray prefix = query.toLatin1().left(IDENT_SIZE);
+  auto it = std::lower_bound(idents.constBegin(), idents.constEnd(), prefix,
+                             [](const IdentKey& key, const QByteArray& value) -> bool {
+    return compareIdent(key, value) < 0;
+  });
+
+  for(; it != idents.constEnd() && compareIdent(*it, prefix) == 0; ++it)
+  {
+    if(types.testFlag(objects.at(it->index).type))
+    {
+      bool exact = prefix.size() == IDENT_SIZE || it->ident[prefix.size()] == '\0';
+      candidates.append({it->index, exact ? NAVSEARCH_IDENT_EXACT : NAVSEARCH_IDENT_PREFIX, 0, 0.f});
+    }
+  }
+}
+
+void NavSearchIndex::searchNames(QVector<Candidate>& candidates, const QString& query, NavSearchTypes types,
+                                 bool fuzzy, int maxResults) const
+{
+  if(query.size() < 2)
+    return;
+
+  // Two characters can only match word starts
+  QString word = ' ' + query;
+  const QString& pattern = query.size() == 2 ? word : query;
+
+  // Collect posting lists of all distinct trigrams
+  QVector<const QVector<int> *> lists;
+  QVector<quint64> keys;
+  int numTrigrams = 0;
+  for(int i = 0; i + 3 <= pattern.size(); i++)
+  {
+    quint64 key = trigramKey(pattern.constData() + i);
+    if(keys.contains(key))
+      continue;
+    keys.append(key);
+    numTrigrams++;
+
+    auto it = trigrams.constFind(key);
+    if(it != trigrams.constEnd())
+      lists.append(&it.value());
+  }
+
+  if(lists.isEmpty())
+    return;
+
+  const QChar *pool = namePool.constData();
+  int numCandidates = candidates.size();
+
+  if(lists.size() == numTrigrams)
+  {
+    // All trigrams exist - intersect posting lists starting with the shortest one
+    std::sort(lists.begin(), lists.end(), [](const QVector<int> *list1, const QVector<int> *list2) -> bool {
+      return list1->size() < list2->size();
+    });
+
+    for(int index : *lists.constFirst())
+    {
+      bool found = true;
+      for(int i = 1; i < lists.size() && found; i++)
+        found = std::binary_search(lists.at(i)->constBegin(), lists.at(i)->constEnd(), index);
+
+      const Object& object = objects.at(index);
+      if(found && types.testFlag(object.type))
+      {
+        // Verify since trigrams can appear in any order
+        const QChar *begin = pool + object.nameOffset, *end = begin + object.nameLength;
+        if(std::search(begin, end, word.constBegin(), word.constEnd()) != end)
+          candidates.append({index, NAVSEARCH_NAME_WORD, 0, 0.f});
+        else if(std::search(begin, end, query.constBegin(), query.constEnd()) != end)
+          candidates.append({index, NAVSEARCH_NAME_INFIX, 0, 0.f});
+      }
+    }
+  }
+
+  if(fuzzy && numTrigrams >= 2 && candidates.size() < maxResults)
+  {
+    // Count trigram hits for each object - objects already found get a zero count
+    int minHits = std::max(2, static_cast<int>(std::ceil(numTrigrams * FUZZY_RATIO)));
+    QVector<quint8> hits(objects.size(), 0);
+    for(int i = numCandidates; i < candidates.size(); i++)
+      hits[candidates.at(i).index] = std::numeric_limits<quint8>::max();
+
+    QVector<int> touched;
+    for(const QVector<int> *list : lists)
+    {
+      for(int index : *list)
+      {
+        quint8& count = hits[index];
+        if(count == 0)
+          touched.append(index);
+        if(count < std::numeric_limits<quint8>::max() - 1)
+          count++;
+      }
+    }
+
+    for(int index : touched)
+    {
+      if(hits.at(index) >= minHits && hits.at(index) < std::numeric_limits<quint8>::max() &&
+         types.testFlag(objects.at(index).type))
+        candidates.append({index, NAVSEARCH_NAME_FUZZY, hits.at(index), 0.f});
+    }
+  }
+}
+
+void NavSearchIndex::search(QVector<NavSearchResult>& results, const QString& text, const Pos& refPos,
+                            int maxResults, NavSearchTypes types, bool fuzzy) const
+{
+  results.clear();
+  if(objects.isEmpty() || maxResults <= 0)
+    return;
+
+  QString query = normalize(text);
+  if(query.isEmpty())
+  {
+    // Nearest objects only - fetch more until enough objects of the requested types are found
+    if(!refPos.isValid())
+      return;
+
+    QVector<atools::geo::IndexDistance> nearest;
+    int number = maxResults;
+    while(results.size() < maxResults)
+    {
+      results.clear();
+      objects.getNearestSorted(nearest, refPos, number);
+      for(const atools::geo::IndexDistance& indexDist : nearest)
+      {
+        const Object& object = objects.at(indexDist.index);
+        if(types.testFlag(object.type) && results.size() < maxResults)
+          results.append({object.id, object.type, NAVSEARCH_NEAREST, indexDist.distanceMeter});
+      }
+
+      if(number >= objects.size())
+        break;
+      number = std::min(number * 4, objects.size());
+    }
+    return;
+  }
+
+  QVector<Candidate> candidates;
+  searchIdents(candidates, query, types);
+  searchNames(candidates, query, types, fuzzy, maxResults);
+
+  // Keep only the best match for each object
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate& c1, const Candidate& c2) -> bool {
+    return c1.index == c2.index ? c1.rank < c2.rank : c1.index < c2.index;
+  });
+  candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const Candidate& c1, const Candidate& c2) -> bool {
+    return c1.index == c2.index;
+  }), candidates.end());
+
+  bool hasRef = refPos.isValid();
+  if(hasRef)
+  {
+    Point3D refPoint = refPos.toCartesian();
+    for(Candidate& candidate : candidates)
+      candidate.distance = refPoint.comparableDistance(objects.atPoint3D(candidate.index));
+  }
+
+  // Sort by rank, fuzzy hits and distance
+  int num = std::min(maxResults, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + num, candidates.end(),
+                    [](const Candidate& c1, const Candidate& c2) -> bool {
+    if(c1.rank != c2.rank)
+      return c1.rank < c2.rank;
+    else if(c1.hits != c2.hits)
+      return c1.hits > c2.hits;
+    else if(c1.distance < c2.distance || c1.distance > c2.distance)
+      return c1.distance < c2.distance;
+    else
+      return c1.index < c2.index;
+  });
+
+  results.reserve(num);
+  for(int i = 0; i < num; i++)
+  {
+    const Object& object = objects.at(candidates.at(i).index);
+    results.append({object.id, object.type, candidates.at(i).rank,
+                    hasRef ? refPos.distanceMeterTo(object.pos) : 0.f});
+  }
+}
+
+void NavSearchIndex::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  using atools::util::MemoryAccounting;
+
+  bytes += objects.getMemoryBytes() + MemoryAccounting::vectorBytes(idents) + MemoryAccounting::stringBytes(namePool) +
+           MemoryAccounting::hashBytes(trigrams);
+  for(const QVector<int>& postings : trigrams)
+    bytes += MemoryAccounting::vectorBytes(postings);
+  elements += objects.size();
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,206 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_NAVSEARCHINDEX_H
+#define ATOOLS_FS_COMMON_NAVSEARCHINDEX_H
+
+#include "geo/pos.h"
+#include "geo/spatialindex.h"
+#include "util/memoryaccounting.h"
+
+#include <QHash>
+#include <QStringList>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/* Object types in the search index. Can be combined to filter results. */
+enum NavSearchType : quint8
+{
+  NAVSEARCH_NONE = 0,
+  NAVSEARCH_AIRPORT = 1 << 0,
+  NAVSEARCH_VOR = 1 << 1, /* Also VORTAC, TACAN and DME */
+  NAVSEARCH_NDB = 1 << 2,
+  NAVSEARCH_WAYPOINT = 1 << 3,
+  NAVSEARCH_ALL = NAVSEARCH_AIRPORT | NAVSEARCH_VOR | NAVSEARCH_NDB | NAVSEARCH_WAYPOINT
+};
+
+Q_DECLARE_FLAGS(NavSearchTypes, NavSearchType);
+Q_DECLARE_OPERATORS_FOR_FLAGS(atools::fs::common::NavSearchTypes);
+
+/* How a result matched the query. Lower values are better. */
+enum NavSearchRank : quint8
+{
+  NAVSEARCH_IDENT_EXACT, /* One of the idents is equal to the query */
+  NAVSEARCH_IDENT_PREFIX, /* One of the idents starts with the query */
+  NAVSEARCH_NAME_WORD, /* A word in the name starts with the query */
+  NAVSEARCH_NAME_INFIX, /* Name contains the query */
+  NAVSEARCH_NAME_FUZZY, /* Name contains most of the character triples of the query */
+  NAVSEARCH_NEAREST /* Empty query */
+};
+
+/* Search result */
+struct NavSearchResult
+{
+  /* airport_id, vor_id, ndb_id or waypoint_id */
+  int id;
+  atools::fs::common::NavSearchType type;
+  atools::fs::common::NavSearchRank rank;
+
+  /* Great circle distance to the reference position or 0 if not given */
+  float distanceMeter;
+};
+
+/*
+ * In-memory index for type-ahead search of airports, navaids and waypoints by ident and name.
+ * Replaces the LIKE queries on "nav_search" and "airport" which cannot use indexes for infix and
+ * case-insensitive matching.
+ *
+ * Idents (airport ident, ICAO, IATA, FAA and local codes) are kept in a sorted array of fixed size keys.
+ * A prefix query is a binary search for the range of keys which is the same as walking a trie but more compact.
+ * Names are normalized (upper case, no diacritics, only letters and digits) and split into character triples
+ * (trigrams). Infix queries intersect the posting lists of the query trigrams and verify the candidates.
+ * Fuzzy results contain most of the query trigrams and are only added if not enough exact results were found.
+ *
+ * Results are sorted by rank and then by distance to the reference position using the points of the
+ * spatial index.
+ *
+ * Loading from a database with about 300000 objects takes less than a second. Queries are const and can be
+ * called from several threads once the index is built.
+ */
+class NavSearchIndex :
+  public atools::util::MemoryAccountable
+{
+public:
+  NavSearchIndex();
+  virtual ~NavSearchIndex() override;
+
+  NavSearchIndex(const NavSearchIndex& other) = delete;
+  NavSearchIndex& operator=(const NavSearchIndex& other) = delete;
+
+  /* Read from tables "airport" and "nav_search" if present and build the index. Clears index before. */
+  void loadFromDatabase(atools::sql::SqlDatabase *db, int numThreads = 1);
+
+  /* Add an object. identList can contain empty strings which are ignored. Call build() when done. */
+  void addObject(atools::fs::common::NavSearchType type, int id, const QStringList& identList, const QStringList& names,
+                 const atools::geo::Pos& pos);
+
+  /* Sort idents, build trigram lists and spatial index */
+  void build(int numThreads = 1);
+
+  void clear();
+
+  int size() const
+  {
+    return objects.size();
+  }
+
+  bool isEmpty() const
+  {
+    return objects.isEmpty();
+  }
+
+  /*
+   * Search for text which is matched against idents by prefix and against names by infix or fuzzy.
+   * Case and diacritics are ignored.
+   * An empty text returns the nearest objects to refPos.
+   *
+   * refPos: Results of the same rank are sorted by distance to this position. Optional.
+   * maxResults: Number of results to return.
+   * types: Return only objects of these types.
+   * fuzzy: Add fuzzy name matches if less than maxResults were found otherwise.
+   */
+  void search(QVector<atools::fs::common::NavSearchResult>& results, const QString& text,
+              const atools::geo::Pos& refPos = atools::geo::EMPTY_POS, int maxResults = 20,
+              atools::fs::common::NavSearchTypes types = NAVSEARCH_ALL, bool fuzzy = true) const;
+
+  /* Key arrays, trigram lists and spatial index. Elements are objects. Nothing can be released. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
+  /* Upper case letters and digits only. Diacritics are removed and other characters replaced by a space.
+   * Consecutive spaces are collapsed and the string is trimmed. */
+  static QString normalize(const QString& text);
+
+private:
+  static Q_DECL_CONSTEXPR int IDENT_SIZE = 12;
+
+  /* Minimum portion of query trigrams for fuzzy results */
+  static Q_DECL_CONSTEXPR float FUZZY_RATIO = 0.6f;
+
+  /* Object in spatial index */
+  struct Object
+  {
+    atools::geo::Pos pos;
+    int id;
+    atools::fs::common::NavSearchType type;
+
+    /* Normalized names in namePool separated by a line feed */
+    int nameOffset, nameLength;
+
+    const atools::geo::Pos& getPosition() const
+    {
+      return pos;
+    }
+  };
+
+  /* Ident of an object. Longer idents are truncated. */
+  struct IdentKey
+  {
+    char ident[IDENT_SIZE];
+    int index;
+  };
+
+  /* Candidate for results before sorting */
+  struct Candidate
+  {
+    int index;
+    atools::fs::common::NavSearchRank rank;
+    int hits; /* Trigram hits for fuzzy matches */
+    float distance; /* Comparable distance */
+  };
+
+  static quint64 trigramKey(const QChar *chars)
+  {
+    return (static_cast<quint64>(chars[0].unicode()) << 32) | (static_cast<quint64>(chars[1].unicode()) << 16) |
+           static_cast<quint64>(chars[2].unicode());
+  }
+
+  /* Compare ident key with query prefix */
+  static int compareIdent(const IdentKey& key, const QByteArray& prefix);
+
+  void searchIdents(QVector<Candidate>& candidates, const QString& query, NavSearchTypes types) const;
+  void searchNames(QVector<Candidate>& candidates, const QString& query, NavSearchTypes types, bool fuzzy,
+                   int maxResults) const;
+
+  atools::geo::SpatialIndex<Object> objects;
+  QVector<IdentKey> idents;
+
+  /* Trigram to sorted object indexes */
+  QHash<quint64, QVector<int> > trigrams;
+  QString namePool;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_NAVSEARCHINDEX_H
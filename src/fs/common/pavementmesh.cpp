@@ -0,0 +1,469 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/pavementmesh.h"
+
+#include "geo/calculations.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using atools::geo::Pos;
+using atools::geo::LineString;
+
+/* "PVM1" */
+static const quint32 MAGIC_NUMBER = 0x314D5650;
+static const int HEADER_SIZE = 12;
+
+/* Approximate length of a line segment when flattening bezier curves */
+static const float BEZIER_SEGMENT_LENGTH_METER = 10.f;
+static const int MAX_BEZIER_SEGMENTS = 16;
+
+namespace {
+
+/* Point in a plane with longitude relative to the first boundary point */
+struct Point
+{
+  double x, y;
+};
+
+/* > 0 if c is left of line a-b */
+inline double cross(const Point& a, const Point& b, const Point& c)
+{
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+inline bool equal(const Point& p1, const Point& p2)
+{
+  return p1.x == p2.x && p1.y == p2.y;
+}
+
+/* p is inside or on the border of counter clockwise triangle a, b, c */
+inline bool pointInTriangle(const Point& a, const Point& b, const Point& c, const Point& p)
+{
+  return cross(a, b, p) >= 0. && cross(b, c, p) >= 0. && cross(c, a, p) >= 0.;
+}
+
+/* Segments cross each other. Touching end points or collinear overlaps are not counted. */
+inline bool segmentsCross(const Point& p1, const Point& p2, const Point& q1, const Point& q2)
+{
+  double d1 = cross(q1, q2, p1), d2 = cross(q1, q2, p2), d3 = cross(p1, p2, q1), d4 = cross(p1, p2, q2);
+  return ((d1 > 0. && d2 < 0.) || (d1 < 0. && d2 > 0.)) && ((d3 > 0. && d4 < 0.) || (d3 < 0. && d4 > 0.));
+}
+
+double signedArea(const QVector<Point>& points, const QVector<int>& ring)
+{
+  double area = 0.;
+  for(int i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+    area += (points.at(ring.at(j)).x - points.at(ring.at(i)).x) * (points.at(ring.at(j)).y + points.at(ring.at(i)).y);
+  return area / 2.;
+}
+
+/* true if no edge of ring crosses segment p1-p2 */
+bool segmentClear(const QVector<Point>& points, const QVector<int>& ring, const Point& p1, const Point& p2)
+{
+  for(int i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+  {
+    if(segmentsCross(p1, p2, points.at(ring.at(j)), points.at(ring.at(i))))
+      return false;
+  }
+  return true;
+}
+
+/* Connect each hole to the counter clockwise outline by a bridge to get one ring. Holes have to be clockwise. */
+void eliminateHoles(QVector<int>& ring, QVector<QVector<int> >& holes, const QVector<Point>& points)
+{
+  // Start with the hole extending most to the right to avoid bridges crossing holes not yet connected
+  QVector<int> maxIndexes;
+  for(const QVector<int>& hole : holes)
+  {
+    int maxIndex = 0;
+    for(int i = 1; i < hole.size(); i++)
+    {
+      if(points.at(hole.at(i)).x > points.at(hole.at(maxIndex)).x)
+        maxIndex = i;
+    }
+    maxIndexes.append(maxIndex);
+  }
+
+  QVector<int> order;
+  for(int i = 0; i < holes.size(); i++)
+    order.append(i);
+  std::sort(order.begin(), order.end(), [&](int h1, int h2) -> bool {
+    return points.at(holes.at(h1).at(maxIndexes.at(h1))).x > points.at(holes.at(h2).at(maxIndexes.at(h2))).x;
+  });
+
+  for(int o = 0; o < order.size(); o++)
+  {
+    const QVector<int>& hole = holes.at(order.at(o));
+    int holeStart = maxIndexes.at(order.at(o));
+    const Point& m = points.at(hole.at(holeStart));
+
+    // Check ring vertices sorted by distance
+    QVector<int> candidates;
+    for(int i = 0; i < ring.size(); i++)
+      candidates.append(i);
+    std::sort(candidates.begin(), candidates.end(), [&](int i1, int i2) -> bool {
+      const Point& p1 = points.at(ring.at(i1)), & p2 = points.at(ring.at(i2));
+      return (p1.x - m.x) * (p1.x - m.x) + (p1.y - m.y) * (p1.y - m.y) <
+             (p2.x - m.x) * (p2.x - m.x) + (p2.y - m.y) * (p2.y - m.y);
+    });
+
+    int bridge = -1;
+    for(int candidate : candidates)
+    {
+      const Point& a = points.at(ring.at((candidate + ring.size() - 1) % ring.size()));
+      const Point& p = points.at(ring.at(candidate));
+      const Point& b = points.at(ring.at((candidate + 1) % ring.size()));
+
+      // Bridge has to leave the vertex into the polygon interior
+      bool inside = cross(a, p, b) >= 0. ? cross(a, p, m) >= 0. && cross(p, b, m) >= 0. :
+                    cross(a, p, m) >= 0. || cross(p, b, m) >= 0.;
+      if(!inside || !segmentClear(points, ring, m, p))
+        continue;
+
+      bool clear = true;
+      for(int other = o; other < order.size() && clear; other++)
+        clear = segmentClear(points, holes.at(order.at(other)), m, p);
+
+      if(clear)
+      {
+        bridge = candidate;
+        break;
+      }
+    }
+
+    if(bridge == -1)
+    {
+      qWarning() << Q_FUNC_INFO << "No bridge found for hole";
+      continue;
+    }
+
+    // Insert hole after bridge vertex and return to the bridge vertex
+    QVector<int> inserted;
+    for(int i = 0; i <= hole.size(); i++)
+      inserted.append(hole.at((holeStart + i) % hole.size()));
+    inserted.append(ring.at(bridge));
+
+    QVector<int> newRing;
+    newRing.reserve(ring.size() + inserted.size());
+    newRing.append(ring.mid(0, bridge + 1));
+    newRing.append(inserted);
+    newRing.append(ring.mid(bridge + 1));
+    ring.swap(newRing);
+  }
+}
+
+/* Ear clipping for a counter clockwise ring. Appends triangles as point indexes. */
+void clipEars(QVector<quint32>& triangles, const QVector<int>& ring, const QVector<Point>& points)
+{
+  int size = ring.size();
+  QVector<int> prev(size), next(size);
+  for(int i = 0; i < size; i++)
+  {
+    prev[i] = (i + size - 1) % size;
+    next[i] = (i + 1) % size;
+  }
+
+  // 0: proper ears, 1: any convex vertex, 2: any vertex to get out of degenerated or self intersecting rings
+  int mode = 0, count = size, current = 0, stop = 0;
+  while(count > 2)
+  {
+    int a = prev[current], c = next[current];
+    const Point& pa = points.at(ring.at(a)), & pb = points.at(ring.at(current)), & pc = points.at(ring.at(c));
+    double area = cross(pa, pb, pc);
+
+    bool ear = false;
+    if(mode == 2 || count == 3)
+      ear = true;
+    else if(area > 0.)
+    {
+      ear = true;
+      if(mode == 0)
+      {
+        // No other vertex may be inside the triangle
+        for(int i = next[c]; i != a && ear; i = next[i])
+        {
+          const Point& p = points.at(ring.at(i));
+          if(!equal(p, pa) && !equal(p, pb) && !equal(p, pc) && pointInTriangle(pa, pb, pc, p))
+            ear = false;
+        }
+      }
+    }
+
+    if(ear)
+    {
+      if(area > 0.)
+        triangles << static_cast<quint32>(ring.at(a)) << static_cast<quint32>(ring.at(current))
+                  << static_cast<quint32>(ring.at(c));
+
+      next[a] = c;
+      prev[c] = a;
+      count--;
+      current = stop = c;
+      mode = 0;
+    }
+    else
+    {
+      current = c;
+      if(current == stop)
+        mode++;
+    }
+  }
+}
+
+/* Copy line string into plane points and return ring of indexes. Skips consecutive duplicates. */
+QVector<int> addRing(QVector<Point>& points, QVector<float>& vertices, const LineString& line, const Pos& ref)
+{
+  QVector<int> ring;
+  for(const Pos& pos : line)
+  {
+    Point point = {atools::geo::normalizeLonXDeg(static_cast<double>(pos.getLonX()) - ref.getLonX()),
+                   static_cast<double>(pos.getLatY())};
+
+    if(!ring.isEmpty() && equal(points.at(ring.constLast()), point))
+      continue;
+
+    ring.append(points.size());
+    points.append(point);
+    vertices << pos.getLonX() << pos.getLatY();
+  }
+
+  if(ring.size() > 1 && equal(points.at(ring.constFirst()), points.at(ring.constLast())))
+    ring.removeLast();
+
+  return ring;
+}
+
+/* Cubic bezier with controls c1 and c2 - quadratic if c2 is equal to c1 */
+inline Pos bezier(const Pos& p0, const Pos& c1, const Pos& c2, const Pos& p1, float t)
+{
+  float u = 1.f - t;
+  float w0 = u * u * u, w1 = 3.f * u * u * t, w2 = 3.f * u * t * t, w3 = t * t * t;
+  return Pos(w0 * p0.getLonX() + w1 * c1.getLonX() + w2 * c2.getLonX() + w3 * p1.getLonX(),
+             w0 * p0.getLatY() + w1 * c1.getLatY() + w2 * c2.getLatY() + w3 * p1.getLatY());
+}
+
+} // namespace
+
+/* Little endian float helpers. memcpy avoids alignment and aliasing issues. */
+static inline float readFloatLe(const char *data)
+{
+  quint32 bits = qFromLittleEndian<quint32>(data);
+  float value;
+  std::memcpy(&value, &bits, sizeof(float));
+  return value;
+}
+
+static inline void writeFloatLe(float value, char *data)
+{
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  qToLittleEndian<quint32>(bits, data);
+}
+
+PavementMesh::PavementMesh()
+{
+
+}
+
+PavementMesh::PavementMesh(const QByteArray& bytes)
+{
+  readFromByteArray(bytes);
+}
+
+void PavementMesh::clear()
+{
+  vertices.clear();
+  indices.clear();
+}
+
+void PavementMesh::flatten(LineString& line, const Boundary& nodes)
+{
+  line.clear();
+  for(int i = 0; i < nodes.size(); i++)
+  {
+    const Node& from = nodes.at(i), & to = nodes.at((i + 1) % nodes.size());
+    line.append(from.node);
+
+    // Control of the from node is outgoing and the one of the to node is mirrored to get the incoming control
+    bool fromCurve = from.control.isValid(), toCurve = to.control.isValid();
+    if(!fromCurve && !toCurve)
+      continue;
+
+    Pos c2 = toCurve ? Pos(2.f * to.node.getLonX() - to.control.getLonX(),
+                           2.f * to.node.getLatY() - to.control.getLatY()) : from.control;
+    Pos c1 = fromCurve ? from.control : c2;
+
+    if(!fromCurve || !toCurve)
+    {
+      // Quadratic curve - raise degree to cubic
+      const Pos& c = fromCurve ? c1 : c2;
+      c1 = Pos(from.node.getLonX() + 2.f / 3.f * (c.getLonX() - from.node.getLonX()),
+               from.node.getLatY() + 2.f / 3.f * (c.getLatY() - from.node.getLatY()));
+      c2 = Pos(to.node.getLonX() + 2.f / 3.f * (c.getLonX() - to.node.getLonX()),
+               to.node.getLatY() + 2.f / 3.f * (c.getLatY() - to.node.getLatY()));
+    }
+
+    // Length of control polygon is an upper limit for the curve length
+    float length = from.node.distanceMeterTo(c1) + c1.distanceMeterTo(c2) + c2.distanceMeterTo(to.node);
+    int segments = std::max(2, std::min(static_cast<int>(std::ceil(length / BEZIER_SEGMENT_LENGTH_METER)),
+                                        MAX_BEZIER_SEGMENTS));
+    for(int s = 1; s < segments; s++)
+      line.append(bezier(from.node, c1, c2, to.node, static_cast<float>(s) / segments));
+  }
+}
+
+bool PavementMesh::build(const XpGeo& geometry)
+{
+  LineString boundary;
+  flatten(boundary, geometry.boundary);
+
+  QVector<LineString> holes;
+  for(const Boundary& hole : geometry.holes)
+  {
+    holes.append(LineString());
+    flatten(holes.last(), hole);
+  }
+
+  return build(boundary, holes);
+}
+
+bool PavementMesh::build(const LineString& boundary, const QVector<LineString>& holes)
+{
+  clear();
+
+  if(boundary.size() < 3)
+    return false;
+
+  QVector<Point> points;
+  Pos ref = boundary.constFirst();
+
+  QVector<int> ring = addRing(points, vertices, boundary, ref);
+  if(ring.size() < 3)
+  {
+    clear();
+    return false;
+  }
+
+  // Outline counter clockwise and holes clockwise
+  if(signedArea(points, ring) < 0.)
+    std::reverse(ring.begin(), ring.end());
+
+  QVector<QVector<int> > holeRings;
+  for(const LineString& hole : holes)
+  {
+    QVector<int> holeRing = addRing(points, vertices, hole, ref);
+    if(holeRing.size() >= 3)
+    {
+      if(signedArea(points, holeRing) > 0.)
+        std::reverse(holeRing.begin(), holeRing.end());
+      holeRings.append(holeRing);
+    }
+  }
+
+  if(!holeRings.isEmpty())
+    eliminateHoles(ring, holeRings, points);
+
+  clipEars(indices, ring, points);
+
+  if(indices.isEmpty())
+  {
+    clear();
+    return false;
+  }
+
+  vertices.squeeze();
+  indices.squeeze();
+  return true;
+}
+
+QByteArray PavementMesh::writeToByteArray() const
+{
+  int numVertices = getNumVertices(), numIndices = indices.size();
+
+  QByteArray bytes;
+  bytes.resize(HEADER_SIZE + numVertices * 8 + numIndices * 4);
+  char *data = bytes.data();
+
+  qToLittleEndian<quint32>(MAGIC_NUMBER, data);
+  qToLittleEndian<quint32>(static_cast<quint32>(numVertices), data + 4);
+  qToLittleEndian<quint32>(static_cast<quint32>(numIndices), data + 8);
+  data += HEADER_SIZE;
+
+  for(float value : vertices)
+  {
+    writeFloatLe(value, data);
+    data += 4;
+  }
+
+  for(quint32 index : indices)
+  {
+    qToLittleEndian<quint32>(index, data);
+    data += 4;
+  }
+
+  return bytes;
+}
+
+void PavementMesh::readFromByteArray(const QByteArray& bytes)
+{
+  clear();
+
+  const char *data = bytes.constData();
+  if(bytes.size() < HEADER_SIZE || qFromLittleEndian<quint32>(data) != MAGIC_NUMBER)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid pavement mesh";
+    return;
+  }
+
+  qint64 numVertices = qFromLittleEndian<quint32>(data + 4), numIndices = qFromLittleEndian<quint32>(data + 8);
+  if(static_cast<qint64>(bytes.size()) != HEADER_SIZE + numVertices * 8 + numIndices * 4 || numIndices % 3 != 0)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid pavement mesh size";
+    return;
+  }
+  data += HEADER_SIZE;
+
+  vertices.resize(static_cast<int>(numVertices * 2));
+  for(int i = 0; i < vertices.size(); i++, data += 4)
+    vertices[i] = readFloatLe(data);
+
+  indices.resize(static_cast<int>(numIndices));
+  for(int i = 0; i < indices.size(); i++, data += 4)
+  {
+    indices[i] = qFromLittleEndian<quint32>(data);
+    if(indices.at(i) >= numVertices)
+    {
+      qWarning() << Q_FUNC_INFO << "Invalid pavement mesh index";
+      clear();
+      return;
+    }
+  }
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,106 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_PAVEMENTMESH_H
+#define ATOOLS_PAVEMENTMESH_H
+
+#include "fs/common/xpgeometry.h"
+#include "geo/linestring.h"
+
+#include <QByteArray>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/*
+ * Triangle mesh of an apron or X-Plane pavement polygon. Stored in table apron_mesh.
+ *
+ * Built at compile time from the apron outline or from the X-Plane bezier boundary and holes. Bezier curves are
+ * flattened and the polygon including holes is triangulated by ear clipping after connecting each hole to the
+ * outline by a bridge. Clients can draw the vertex and index arrays directly without flattening or triangulating.
+ *
+ * Vertices are interleaved lon/lat pairs in degree. Indices refer to vertices, three for each counter clockwise
+ * triangle. The byte array format uses a twelve byte header (quint32 magic "PVM1", number of vertices, number of
+ * indices) followed by little endian float32 vertices and quint32 indices.
+ */
+class PavementMesh
+{
+public:
+  PavementMesh();
+  explicit PavementMesh(const QByteArray& bytes);
+
+  /* Flatten and triangulate X-Plane pavement. Returns false if nothing could be triangulated. */
+  bool build(const atools::fs::common::XpGeo& geometry);
+
+  /* Triangulate polygon with optional holes. A duplicate closing point is ignored.
+   * Returns false if nothing could be triangulated. */
+  bool build(const atools::geo::LineString& boundary,
+             const QVector<atools::geo::LineString>& holes = QVector<atools::geo::LineString>());
+
+  /* Convert X-Plane nodes with optional bezier control points into a line string without closing point */
+  static void flatten(atools::geo::LineString& line, const atools::fs::common::Boundary& nodes);
+
+  void clear();
+
+  /* Empty mesh if bytes are invalid */
+  void readFromByteArray(const QByteArray& bytes);
+  QByteArray writeToByteArray() const;
+
+  bool isEmpty() const
+  {
+    return indices.isEmpty();
+  }
+
+  int getNumVertices() const
+  {
+    return vertices.size() / 2;
+  }
+
+  int getNumTriangles() const
+  {
+    return indices.size() / 3;
+  }
+
+  /* Interleaved lon/lat pairs */
+  const QVector<float>& getVertices() const
+  {
+    return vertices;
+  }
+
+  /* Three vertex indices for each triangle */
+  const QVector<quint32>& getIndices() const
+  {
+    return indices;
+  }
+
+  atools::geo::Pos getVertex(int index) const
+  {
+    return atools::geo::Pos(vertices.at(index * 2), vertices.at(index * 2 + 1));
+  }
+
+private:
+  QVector<float> vertices;
+  QVector<quint32> indices;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_PAVEMENTMESH_H
@@ -18,12 +18,16 @@
 #include "fs/common/procedurewriter.h"
 
 #include "atools.h"
+#include "exception.h"
 #include "fs/common/airportindex.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
-
 #include "sql/sqlutil.h"
+#include "util/parallel.h"
+
+#include <QElapsedTimer>
+#include <QHash>
 
 #pragma GCC diagnostic ignored "-Wswitch-enum"
 
@@ -267,6 +271,102 @@ enum WaypointDescriptionCode4
 
 }
 
+/* Waypoints and ILS in memory replacing the find queries when converting airports in parallel */
+class ProcedureFixIndex
+{
+public:
+  void load(atools::sql::SqlDatabase& db);
+
+  /* Same as findFix() on waypoint and ILS tables. Returns true if found and fills type and region. */
+  bool findWaypoint(const QString& ident, const QString& region, const atools::geo::PosD& pos, bool exact,
+                    QString& type, QString& foundRegion) const
+  {
+    return find(waypoints, ident, region, pos, exact, type, foundRegion);
+  }
+
+  bool findIls(const QString& ident, const QString& region, const atools::geo::PosD& pos, bool exact,
+               QString& foundRegion) const
+  {
+    QString type;
+    return find(ils, ident, region, pos, exact, type, foundRegion);
+  }
+
+private:
+  struct Fix
+  {
+    QString type, region;
+    double lonx, laty;
+  };
+
+  typedef QHash<QString, QVector<Fix> > FixHash;
+
+  static void loadTable(atools::sql::SqlDatabase& db, const QString& table, FixHash& hash);
+  static bool find(const FixHash& hash, const QString& ident, const QString& region, const atools::geo::PosD& pos,
+                   bool exact, QString& type, QString& foundRegion);
+
+  FixHash waypoints, ils;
+};
+
+void ProcedureFixIndex::load(sql::SqlDatabase& db)
+{
+  waypoints.clear();
+  ils.clear();
+  loadTable(db, "waypoint", waypoints);
+  loadTable(db, "ils", ils);
+}
+
+void ProcedureFixIndex::loadTable(sql::SqlDatabase& db, const QString& table, FixHash& hash)
+{
+  SqlQuery query("select ident, type, region, lonx, laty from " + table, &db);
+  query.exec();
+  while(query.next())
+    hash[query.valueStr(0)].append({query.valueStr(1), query.valueStr(2),
+                                    query.valueDouble(3), query.valueDouble(4)});
+}
+
+bool ProcedureFixIndex::find(const FixHash& hash, const QString& ident, const QString& region, const geo::PosD& pos,
+                             bool exact, QString& type, QString& foundRegion)
+{
+  auto it = hash.constFind(ident);
+  if(it == hash.constEnd())
+    return false;
+
+  // Same as "region like :region" with "%" for empty region and "order by" distance
+  const Fix *best = nullptr;
+  double bestDist = std::numeric_limits<double>::max();
+  for(const Fix& fix : it.value())
+  {
+    if(!region.isEmpty() && fix.region.compare(region, Qt::CaseInsensitive) != 0)
+      continue;
+
+    if(exact)
+    {
+      if(fix.lonx == pos.getLonX() && fix.laty == pos.getLatY())
+      {
+        best = &fix;
+        break;
+      }
+    }
+    else
+    {
+      double dist = std::abs(fix.lonx - pos.getLonX()) + std::abs(fix.laty - pos.getLatY());
+      if(dist < 0.1 && dist < bestDist)
+      {
+        bestDist = dist;
+        best = &fix;
+      }
+    }
+  }
+
+  if(best != nullptr)
+  {
+    type = best->type;
+    foundRegion = best->region;
+    return true;
+  }
+  return false;
+}
+
 ProcedureWriter::ProcedureWriter(atools::sql::SqlDatabase& sqlDb, atools::fs::common::AirportIndex *airportIndexParam)
   : db(sqlDb), airportIndex(airportIndexParam),
   // Create SqlRecords for tables that can be cloned before filling with data
@@ -276,9 +376,20 @@ ProcedureWriter::ProcedureWriter(atools::sql::SqlDatabase& sqlDb, atools::fs::co
   initQueries();
 }
 
+ProcedureWriter::ProcedureWriter(const ProcedureWriter *parent)
+  : db(parent->db), airportIndex(parent->airportIndex), fixIndex(parent->fixIndex), worker(true),
+  APPROACH_RECORD(parent->APPROACH_RECORD), APPROACH_LEG_RECORD(parent->APPROACH_LEG_RECORD),
+  TRANSITION_RECORD(parent->TRANSITION_RECORD), TRANSITION_LEG_RECORD(parent->TRANSITION_LEG_RECORD)
+{
+  // No queries - fix index is used instead
+}
+
 ProcedureWriter::~ProcedureWriter()
 {
   deInitQueries();
+
+  if(!worker)
+    delete fixIndex;
 }
 
 void ProcedureWriter::write(const ProcedureInput& line)
@@ -369,11 +480,6 @@ void ProcedureWriter::writeProcedureLeg(const ProcedureInput& line)
   }
 }
 
-void ProcedureWriter::assignApproachIds(ProcedureWriter::Procedure& proc)
-{
-  proc.record.setValue(":approach_id", ++curApproachId);
-}
-
 void ProcedureWriter::assignApproachLegIds(sql::SqlRecordList& records)
 {
   for(SqlRecord& rec : records)
@@ -383,23 +489,112 @@ void ProcedureWriter::assignApproachLegIds(sql::SqlRecordList& records)
   }
 }
 
-void ProcedureWriter::assignTransitionIds(ProcedureWriter::Procedure& proc)
+void ProcedureWriter::assignTransitionLegIds(sql::SqlRecordList& records)
 {
-  proc.record.setValue(":transition_id", ++curTransitionId);
-  proc.record.setValue(":approach_id", curApproachId);
-
-  for(SqlRecord& rec : proc.legRecords)
+  for(SqlRecord& rec : records)
   {
     rec.setValue(":transition_leg_id", ++curTransitionLegId);
     rec.setValue(":transition_id", curTransitionId);
   }
 }
 
+void ProcedureWriter::writeRecords(const ProcedureRecords& records)
+{
+  for(const ProcedureRecordGroup& group : records.groups)
+  {
+    // Write approach, SID or STAR
+    SqlRecord approach(group.approach);
+    approach.setValue(":approach_id", ++curApproachId);
+    insertApproachQuery->bindAndExecRecord(approach);
+
+    SqlRecordList approachLegs(group.approachLegs);
+    assignApproachLegIds(approachLegs);
+    insertApproachLegQuery->bindAndExecRecords(approachLegs);
+
+    // Write transitions for this approach
+    for(int i = 0; i < group.transitions.size(); i++)
+    {
+      SqlRecord transition(group.transitions.at(i));
+      transition.setValue(":transition_id", ++curTransitionId);
+      transition.setValue(":approach_id", curApproachId);
+      insertTransitionQuery->bindAndExecRecord(transition);
+
+      SqlRecordList transitionLegs(group.transitionLegs.at(i));
+      assignTransitionLegIds(transitionLegs);
+      insertTransitionLegQuery->bindAndExecRecords(transitionLegs);
+    }
+  }
+
+  updateAirportQuery->bindValue(":num", records.numProcedures);
+  updateAirportQuery->bindValue(":id", records.airportId);
+  updateAirportQuery->exec();
+}
+
+void ProcedureWriter::loadFixIndex()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  if(fixIndex == nullptr)
+    fixIndex = new ProcedureFixIndex;
+  fixIndex->load(db);
+
+  qDebug() << Q_FUNC_INFO << timer.elapsed() << "ms";
+}
+
+ProcedureRecords ProcedureWriter::convertAirport(const QVector<ProcedureInput>& lines) const
+{
+  ProcedureWriter converter(this);
+  for(const ProcedureInput& line : lines)
+    converter.write(line);
+
+  if(!lines.isEmpty())
+  {
+    converter.finishProcedure(lines.constLast());
+    converter.airportRecords.airportId = lines.constLast().airportId;
+  }
+  return converter.airportRecords;
+}
+
+void ProcedureWriter::convertAirports(const QVector<QVector<ProcedureInput> >& airports,
+                                      QVector<ProcedureRecords>& records, int numThreads)
+{
+  if(fixIndex == nullptr)
+    loadFixIndex();
+
+  records.clear();
+  records.resize(airports.size());
+
+  // Keep error message for each chunk to rethrow in this thread
+  QVector<QString> errors(atools::util::parallelChunks(airports.size(), numThreads, 10));
+
+  ProcedureRecords *recordsData = records.data();
+  QString *errorsData = errors.data();
+  atools::util::parallelFor(airports.size(), numThreads,
+                            [this, &airports, recordsData, errorsData](int begin, int end, int chunk) {
+    try
+    {
+      for(int i = begin; i < end; i++)
+        recordsData[i] = convertAirport(airports.at(i));
+    }
+    catch(std::exception& e)
+    {
+      errorsData[chunk] = e.what();
+    }
+  }, 10);
+
+  for(const QString& error : qAsConst(errors))
+  {
+    if(!error.isEmpty())
+      throw atools::Exception(error);
+  }
+}
+
 void ProcedureWriter::finishProcedure(const ProcedureInput& line)
 {
   if(curRowCode == rc::APPROACH)
   {
-    numProcedures += approaches.size() + transitions.size();
+    airportRecords.numProcedures += approaches.size() + transitions.size();
     if(approaches.size() > 1)
       qWarning() << line.context << "Found more than one approach" << approaches.size();
 
@@ -419,18 +614,17 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
           appr.record.setValue(":has_rnp", 1);
       }
 
-      assignApproachIds(appr);
-      assignApproachLegIds(appr.legRecords);
-      insertApproachQuery->bindAndExecRecord(appr.record);
-      insertApproachLegQuery->bindAndExecRecords(appr.legRecords);
+      ProcedureRecordGroup group;
+      group.approach = appr.record;
+      group.approachLegs = appr.legRecords;
 
-      // Write transitions for one approach
-      for(Procedure& trans : transitions)
+      // Add transitions for one approach
+      for(const Procedure& trans : qAsConst(transitions))
       {
-        assignTransitionIds(trans);
-        insertTransitionQuery->bindAndExecRecord(trans.record);
-        insertTransitionLegQuery->bindAndExecRecords(trans.legRecords);
+        group.transitions.append(trans.record);
+        group.transitionLegs.append(trans.legRecords);
       }
+      airportRecords.groups.append(group);
     }
   }
   else if(curRowCode == rc::STAR || curRowCode == rc::SID)
@@ -449,7 +643,7 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
     // SID: First in file are approaches then multiple transitions
     // duplicate all approachs for each  transition before writing
 
-    numProcedures += approaches.size() + transitions.size();
+    airportRecords.numProcedures += approaches.size() + transitions.size();
 
     if(approaches.isEmpty())
       qWarning() << line.context << "No SID/STAR found. Invalid state.";
@@ -500,48 +694,41 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
         }
       }
 
-      // Write all procedures - get a copy of the object since it is modified
+      // Add all procedures - get a copy of the object since it is modified
       for(Procedure appr : qAsConst(approaches))
       {
-        assignApproachIds(appr);
-        // qDebug() << appr.legRecords;
-        insertApproachQuery->bindAndExecRecord(appr.record);
+        ProcedureRecordGroup group;
+        group.approach = appr.record;
 
         if(starCommon.isValid())
         {
           // Prefix the common route legs to the STAR
-          assignApproachLegIds(starCommon.legRecords);
-          insertApproachLegQuery->bindAndExecRecords(starCommon.legRecords);
+          group.approachLegs.append(starCommon.legRecords);
 
           // Remove the IF of the STAR which will be replaced by the TF of the common route
           if(appr.legRecords.constFirst().value(":type") == "IF")
             appr.legRecords.removeFirst();
         }
 
-        // Write SID or STAR legs
-        assignApproachLegIds(appr.legRecords);
-        insertApproachLegQuery->bindAndExecRecords(appr.legRecords);
+        // Add SID or STAR legs
+        group.approachLegs.append(appr.legRecords);
 
         if(sidCommon.isValid())
-        {
           // Append the common route legs to the SID
-          assignApproachLegIds(sidCommon.legRecords);
-          insertApproachLegQuery->bindAndExecRecords(sidCommon.legRecords);
-        }
+          group.approachLegs.append(sidCommon.legRecords);
 
-        // Assign a new set of ids and write a duplicate of all transitions for the current approach
-        for(Procedure& trans : transitions)
+        // Add a duplicate of all transitions for the current approach - ids are assigned when writing
+        for(const Procedure& trans : qAsConst(transitions))
         {
-          assignTransitionIds(trans);
-          // qDebug() << trans.legRecords;
-          insertTransitionQuery->bindAndExecRecord(trans.record);
-          insertTransitionLegQuery->bindAndExecRecords(trans.legRecords);
+          group.transitions.append(trans.record);
+          group.transitionLegs.append(trans.legRecords);
         }
+        airportRecords.groups.append(group);
       }
     }
   }
 
-  reset();
+  resetProcedure();
 }
 
 void ProcedureWriter::writeApproach(const ProcedureInput& line)
@@ -946,13 +1133,18 @@ void ProcedureWriter::finish(const ProcedureInput& line)
 {
   finishProcedure(line);
 
-  updateAirportQuery->bindValue(":num", numProcedures);
-  updateAirportQuery->bindValue(":id", line.airportId);
-  updateAirportQuery->exec();
-  numProcedures = 0;
+  airportRecords.airportId = line.airportId;
+  writeRecords(airportRecords);
+  airportRecords.clear();
 }
 
 void ProcedureWriter::reset()
+{
+  resetProcedure();
+  airportRecords.clear();
+}
+
+void ProcedureWriter::resetProcedure()
 {
   approaches.clear();
   transitions.clear();
@@ -1130,37 +1322,48 @@ ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, c
     {
       NavIdInfo inf;
 
-      // Try an exact and faster coordinate search first
-      // For that we need double coordinate values
-      findFix(findWaypointExactQuery, ident, region, searchPos);
-      if(findWaypointExactQuery->next())
+      if(fixIndex != nullptr)
       {
-        inf.type = findWaypointExactQuery->valueStr("type");
-        inf.region = findWaypointExactQuery->valueStr("region");
+        // Same order as below but using the index in memory
+        if(!fixIndex->findWaypoint(ident, region, searchPos, true /* exact */, inf.type, inf.region) &&
+           !fixIndex->findWaypoint(ident, region, searchPos, false /* exact */, inf.type, inf.region) &&
+           !fixIndex->findIls(ident, region, searchPos, true /* exact */, inf.region))
+          fixIndex->findIls(ident, region, searchPos, false /* exact */, inf.region);
       }
       else
       {
-        // Nothing found at position - look in vicinity for waypoints
-        findFix(findWaypointQuery, ident, region, searchPos);
-        if(findWaypointQuery->next())
+        // Try an exact and faster coordinate search first
+        // For that we need double coordinate values
+        findFix(findWaypointExactQuery, ident, region, searchPos);
+        if(findWaypointExactQuery->next())
         {
-          inf.type = findWaypointQuery->valueStr("type");
-          inf.region = findWaypointQuery->valueStr("region");
+          inf.type = findWaypointExactQuery->valueStr("type");
+          inf.region = findWaypointExactQuery->valueStr("region");
         }
         else
         {
-          // Nothing found at position - look at position for ILS
-          findFix(findIlsExactQuery, ident, region, searchPos);
-          if(findIlsExactQuery->next())
-            // Do not set type for ILS
-            inf.region = findIlsExactQuery->valueStr("region");
+          // Nothing found at position - look in vicinity for waypoints
+          findFix(findWaypointQuery, ident, region, searchPos);
+          if(findWaypointQuery->next())
+          {
+            inf.type = findWaypointQuery->valueStr("type");
+            inf.region = findWaypointQuery->valueStr("region");
+          }
           else
           {
-            // Nothing found at position - look in vicinity for ILS
-            findFix(findIlsQuery, ident, region, searchPos);
-            if(findIlsQuery->next())
+            // Nothing found at position - look at position for ILS
+            findFix(findIlsExactQuery, ident, region, searchPos);
+            if(findIlsExactQuery->next())
               // Do not set type for ILS
-              inf.region = findIlsQuery->valueStr("region");
+              inf.region = findIlsExactQuery->valueStr("region");
+            else
+            {
+              // Nothing found at position - look in vicinity for ILS
+              findFix(findIlsQuery, ident, region, searchPos);
+              if(findIlsQuery->next())
+                // Do not set type for ILS
+                inf.region = findIlsQuery->valueStr("region");
+            }
           }
         }
       }
@@ -22,6 +22,8 @@
 #include "geo/pos.h"
 #include "sql/sqltypes.h"
 
+#include <QVector>
+
 namespace atools {
 
 namespace sql {
@@ -113,12 +115,52 @@ struct ProcedureInput
 
 const float INVALID_FLOAT = std::numeric_limits<float>::max();
 
+/* One approach, SID or STAR with legs and all transitions ready to insert.
+ * Transitions are duplicated for each SID/STAR. */
+struct ProcedureRecordGroup
+{
+  atools::sql::SqlRecord approach;
+  atools::sql::SqlRecordList approachLegs;
+
+  /* Transition records and legs at the same index */
+  QVector<atools::sql::SqlRecord> transitions;
+  QVector<atools::sql::SqlRecordList> transitionLegs;
+};
+
+/* All records for one airport. Database ids are assigned when writing. */
+struct ProcedureRecords
+{
+  int airportId = -1;
+
+  /* Number of approaches and transitions as written to column airport.num_approach */
+  int numProcedures = 0;
+
+  QVector<atools::fs::common::ProcedureRecordGroup> groups;
+
+  bool isEmpty() const
+  {
+    return groups.isEmpty();
+  }
+
+  void clear()
+  {
+    airportId = -1;
+    numProcedures = 0;
+    groups.clear();
+  }
+};
+
+class ProcedureFixIndex;
+
 /*
  * Write SIDs, STARs, approaches and transitions to the database tables approach, approach_leg,
  * transition and transition_leg.
  *
  * Consumes one ProcedureInput struct for each line in a text file or each row in a database table
  * and writes all approaches,transitons, SIDs and STARs into the database.
+ *
+ * Alternatively all rows of an airport can be converted at once using convertAirport() or convertAirports()
+ * which do not access the database and can run in parallel. The result is written by writeRecords().
  */
 class ProcedureWriter
 {
@@ -138,7 +180,27 @@ public:
   /* Reset after writing procedures for one airport */
   void reset();
 
+  /* Load all waypoints and ILS into memory which are needed to resolve fix types.
+   * Has to be called after waypoints and ILS are written and before convertAirport().
+   * Called by convertAirports() if not done yet. */
+  void loadFixIndex();
+
+  /* Convert all rows of one airport into records. Rows have to be ordered like for write().
+   * Does not access the database and is thread safe. Requires loadFixIndex(). */
+  atools::fs::common::ProcedureRecords convertAirport(const QVector<atools::fs::common::ProcedureInput>& lines) const;
+
+  /* Convert all airports using numThreads threads (0 = number of cores). Result has the same order as airports.
+   * Loads the fix index if needed. */
+  void convertAirports(const QVector<QVector<atools::fs::common::ProcedureInput> >& airports,
+                       QVector<atools::fs::common::ProcedureRecords>& records, int numThreads);
+
+  /* Assign ids and write records of one airport into the database. Updates the airport procedure count. */
+  void writeRecords(const atools::fs::common::ProcedureRecords& records);
+
 private:
+  /* Creates a worker for convertAirport() sharing the fix index and airport index with parent. No queries. */
+  explicit ProcedureWriter(const ProcedureWriter *parent);
+
   /* Used to store a procedure before writing to the database */
   struct Procedure
   {
@@ -213,12 +275,14 @@ private:
   /* Calculate a database procedure type based on route type */
   QString procedureType(const ProcedureInput& line);
 
-  /* Assigns new ids to the currently stored approaches */
-  void assignApproachIds(ProcedureWriter::Procedure& proc);
+  /* Reset state after finishing a procedure */
+  void resetProcedure();
+
+  /* Assigns new ids to approach legs */
   void assignApproachLegIds(atools::sql::SqlRecordList& records);
 
-  /* Assigns new ids to the currently stored transitions */
-  void assignTransitionIds(ProcedureWriter::Procedure& proc);
+  /* Assigns new ids to transition legs */
+  void assignTransitionLegIds(atools::sql::SqlRecordList& records);
 
   /* Extract runway names */
   void apprRunwayNameAndSuffix(const ProcedureInput& line, QString& runway, QString& suffix);
@@ -233,8 +297,8 @@ private:
   /* Database ids */
   int curApproachId = 0, curTransitionId = 0, curApproachLegId = 0, curTransitionLegId = 0;
 
-  /* Count number */
-  int numProcedures = 0;
+  /* Finished procedures of the current airport */
+  atools::fs::common::ProcedureRecords airportRecords;
 
   atools::sql::SqlDatabase& db;
   atools::sql::SqlQuery *insertApproachQuery = nullptr, *insertTransitionQuery = nullptr,
@@ -245,6 +309,11 @@ private:
 
   /* Index to look up airport and runway ids */
   atools::fs::common::AirportIndex *airportIndex;
+
+  /* Replaces the find queries if not null. Owned if not a worker. */
+  atools::fs::common::ProcedureFixIndex *fixIndex = nullptr;
+  bool worker = false;
+
   const atools::sql::SqlRecord APPROACH_RECORD, APPROACH_LEG_RECORD, TRANSITION_RECORD, TRANSITION_LEG_RECORD;
 
   /* Temporary storage before writing to database keeps one approach/SID/STAR and respective transitions
@@ -252,7 +321,7 @@ private:
   QVector<Procedure> approaches;
   QVector<Procedure> transitions;
 
-  rc::RowCode curRowCode;
+  rc::RowCode curRowCode = rc::NONE;
   int curSeqNo = std::numeric_limits<int>::max();
   char curRouteType = ' ';
   QString curRouteIdent, curTransIdent;
@@ -0,0 +1,238 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/routeprofileengine.h"
+
+#include "atools.h"
+#include "fs/common/globereader.h"
+#include "fs/common/morareader.h"
+#include "geo/linestring.h"
+#include "grib/windquery.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+using atools::geo::Pos;
+using atools::geo::LineString;
+using atools::grib::Wind;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+RouteProfileEngine::RouteProfileEngine(GlobeReader *globeReaderParam, const MoraReader *moraReaderParam,
+                                       const atools::grib::WindQuery *windQueryParam)
+  : globeReader(globeReaderParam), moraReader(moraReaderParam), windQuery(windQueryParam)
+{
+
+}
+
+RouteProfileEngine::~RouteProfileEngine()
+{
+
+}
+
+void RouteProfileEngine::clearCache()
+{
+  legCache.clear();
+}
+
+void RouteProfileEngine::clear()
+{
+  legs.clear();
+  legCache.clear();
+  numCalculatedLegs = 0;
+}
+
+void RouteProfileEngine::setSampleDistanceMeter(float value)
+{
+  if(!atools::almostEqual(sampleDistanceMeter, value))
+  {
+    sampleDistanceMeter = std::max(value, 1.f);
+    clearCache();
+  }
+}
+
+void RouteProfileEngine::setElevationSampleRadiusMeter(float value)
+{
+  if(!atools::almostEqual(elevationSampleRadiusMeter, value))
+  {
+    elevationSampleRadiusMeter = value;
+    clearCache();
+  }
+}
+
+RouteProfileEngine::LegKey RouteProfileEngine::legKey(const Pos& pos1, const Pos& pos2)
+{
+  return LegKey({pos1.getLonX(), pos1.getLatY(), pos1.getAltitude(),
+                 pos2.getLonX(), pos2.getLatY(), pos2.getAltitude()});
+}
+
+void RouteProfileEngine::initLeg(RouteProfileLeg& leg, const Pos& pos1, const Pos& pos2) const
+{
+  leg.lengthMeter = pos1.distanceMeterTo(pos2);
+
+  LineString positions;
+  int numPoints = static_cast<int>(leg.lengthMeter / sampleDistanceMeter);
+  if(numPoints > 0)
+    // Includes start but not end
+    pos1.interpolatePointsAlt(pos2, leg.lengthMeter, numPoints, positions);
+  else
+    positions.append(pos1);
+  positions.append(pos2);
+
+  leg.positions = positions;
+
+  // Points are evenly spaced
+  leg.distancesMeter.resize(positions.size());
+  float step = numPoints > 0 ? leg.lengthMeter / numPoints : 0.f;
+  for(int i = 0; i < positions.size() - 1; i++)
+    leg.distancesMeter[i] = step * i;
+  leg.distancesMeter.last() = leg.lengthMeter;
+}
+
+void RouteProfileEngine::update(const LineString& route, int numThreads)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  legs.clear();
+  numCalculatedLegs = 0;
+
+  if(route.size() < 2)
+  {
+    legCache.clear();
+    return;
+  }
+
+  // Take legs from cache or collect samples of missing legs in one array ===========================
+  QHash<LegKey, RouteProfileLeg> newCache;
+  QVector<int> missingLegs;
+  QVector<Pos> positions;
+
+  legs.resize(route.size() - 1);
+  for(int i = 0; i < legs.size(); i++)
+  {
+    LegKey key = legKey(route.at(i), route.at(i + 1));
+    auto it = legCache.constFind(key);
+    if(it != legCache.constEnd())
+      // Shares arrays with cache
+      legs[i] = it.value();
+    else
+    {
+      initLeg(legs[i], route.at(i), route.at(i + 1));
+      positions.append(legs.at(i).positions);
+      missingLegs.append(i);
+    }
+  }
+
+  // Calculate all missing samples at once ===========================
+  QVector<float> elevations;
+  QVector<int> moras;
+  QVector<Wind> winds;
+  calculateSamples(elevations, moras, winds, positions, numThreads);
+
+  // Distribute results to legs ===========================
+  int offset = 0;
+  for(int legIndex : qAsConst(missingLegs))
+  {
+    RouteProfileLeg& leg = legs[legIndex];
+    int size = leg.positions.size();
+
+    leg.elevationsMeter = elevations.mid(offset, size);
+    leg.morasFt = moras.mid(offset, size);
+    leg.winds = winds.mid(offset, size);
+    offset += size;
+
+    leg.maxElevationMeter = 0.f;
+    for(float elevation : qAsConst(leg.elevationsMeter))
+    {
+      if(elevation < INVALID)
+        leg.maxElevationMeter = std::max(leg.maxElevationMeter, elevation);
+    }
+
+    leg.maxMoraFt = 0;
+    for(int mora : qAsConst(leg.morasFt))
+    {
+      if(mora < MoraReader::ERROR)
+        leg.maxMoraFt = std::max(leg.maxMoraFt, mora);
+    }
+  }
+  numCalculatedLegs = missingLegs.size();
+
+  // Keep only legs of the current route in cache to free removed ones
+  for(int i = 0; i < legs.size(); i++)
+    newCache.insert(legKey(route.at(i), route.at(i + 1)), legs.at(i));
+  legCache.swap(newCache);
+
+  qDebug() << Q_FUNC_INFO << "legs" << legs.size() << "calculated" << numCalculatedLegs
+           << "samples" << positions.size() << "elapsed" << timer.elapsed() << "ms";
+}
+
+void RouteProfileEngine::calculateSamples(QVector<float>& elevations, QVector<int>& moras, QVector<Wind>& winds,
+                                          const QVector<Pos>& positions, int numThreads)
+{
+  int size = positions.size();
+  elevations.fill(INVALID, size);
+  moras.fill(static_cast<int>(MoraReader::UNKNOWN), size);
+  winds.fill(atools::grib::EMPTY_WIND, size);
+
+  if(size == 0)
+    return;
+
+  bool useGlobe = globeReader != nullptr && globeReader->isValid();
+  bool useMora = moraReader != nullptr && moraReader->isValid();
+  bool useWind = windQuery != nullptr && windQuery->hasWindData();
+
+  // One task for the elevation batch since GlobeReader is not thread safe and sorts reads by file offset.
+  // Remaining tasks fill MORA and wind for consecutive ranges of samples.
+  const int MIN_CHUNK_SIZE = 500;
+  int chunks = useMora || useWind ? atools::util::parallelChunks(size, numThreads, MIN_CHUNK_SIZE) : 0;
+  int chunkSize = chunks > 0 ? (size + chunks - 1) / chunks : 0;
+  int tasks = chunks + (useGlobe ? 1 : 0);
+
+  // Detach before starting threads
+  int *moraData = moras.data();
+  Wind *windData = winds.data();
+
+  atools::util::parallelFor(tasks, tasks, [&, this](int begin, int, int) -> void {
+    if(begin == chunks)
+      globeReader->getElevations(elevations, positions, elevationSampleRadiusMeter);
+    else
+    {
+      int first = begin * chunkSize, last = std::min(first + chunkSize, size);
+
+      if(useMora)
+      {
+        for(int i = first; i < last; i++)
+          moraData[i] = moraReader->getMoraFt(positions.at(i));
+      }
+
+      if(useWind)
+      {
+        QVector<Wind> chunkWinds;
+        windQuery->getWindForPosList(chunkWinds, positions.mid(first, last - first));
+        std::copy(chunkWinds.constBegin(), chunkWinds.constEnd(), windData + first);
+      }
+    }
+  }, 1);
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
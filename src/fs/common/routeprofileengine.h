@@ -0,0 +1,159 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_ROUTEPROFILEENGINE_H
+#define ATOOLS_FS_COMMON_ROUTEPROFILEENGINE_H
+
+#include "grib/windtypes.h"
+#include "geo/pos.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace grib {
+class WindQuery;
+}
+
+namespace fs {
+namespace common {
+
+class GlobeReader;
+class MoraReader;
+
+/* Profile data for one leg of a route. All arrays have the same size as positions.
+ * First sample is the leg start and last one the leg end. */
+struct RouteProfileLeg
+{
+  /* Sample positions along the great circle. Altitude in feet is interpolated between leg start and end. */
+  QVector<atools::geo::Pos> positions;
+
+  /* Distance from leg start in meter for each sample */
+  QVector<float> distancesMeter;
+
+  /* Ground elevation in meter. atools::fs::common::INVALID if not available. */
+  QVector<float> elevationsMeter;
+
+  /* Grid MORA in feet as returned by MoraReader::getMoraFt(). MoraReader::UNKNOWN if not available. */
+  QVector<int> morasFt;
+
+  /* Wind at sample position and altitude. EMPTY_WIND if not available. */
+  QVector<atools::grib::Wind> winds;
+
+  float lengthMeter = 0.f, maxElevationMeter = 0.f;
+  int maxMoraFt = 0;
+};
+
+/*
+ * Calculates elevation, MORA and wind along a route in one pass.
+ *
+ * Sample positions are generated once per leg and shared by all three sources. Elevations are read with one batch
+ * query while MORA and winds are filled by other threads at the same time.
+ *
+ * Results are cached by leg start and end position including altitude. Changing one leg of a route recalculates only
+ * this leg. Call clearCache() if wind, elevation or MORA data changes, e.g. on WindQuery::windDataUpdated().
+ *
+ * Readers are not owned and can be null to skip the respective values. GlobeReader is only used by one thread at
+ * a time. Not thread safe.
+ */
+class RouteProfileEngine
+{
+public:
+  RouteProfileEngine(atools::fs::common::GlobeReader *globeReaderParam,
+                     const atools::fs::common::MoraReader *moraReaderParam,
+                     const atools::grib::WindQuery *windQueryParam);
+  ~RouteProfileEngine();
+
+  RouteProfileEngine(const RouteProfileEngine& other) = delete;
+  RouteProfileEngine& operator=(const RouteProfileEngine& other) = delete;
+
+  /* Calculate legs between all consecutive points of route. Altitude of route points is used for wind in feet.
+   * Legs not found in cache are calculated in parallel. numThreads: 0 uses the number of cores. */
+  void update(const atools::geo::LineString& route, int numThreads = 0);
+
+  /* One entry for each leg of the last route passed to update() */
+  const QVector<atools::fs::common::RouteProfileLeg>& getLegs() const
+  {
+    return legs;
+  }
+
+  /* Number of legs which were not found in cache in the last call to update() */
+  int getNumCalculatedLegs() const
+  {
+    return numCalculatedLegs;
+  }
+
+  /* Drop all cached legs. Next update() recalculates the whole route. */
+  void clearCache();
+
+  /* Clear legs and cache */
+  void clear();
+
+  /* Distance between samples. Default is 500 meter. Clears cache if changed. */
+  void setSampleDistanceMeter(float value);
+
+  /* Passed to GlobeReader::getElevations(). Default is 0. Clears cache if changed. */
+  void setElevationSampleRadiusMeter(float value);
+
+private:
+  /* Leg start and end coordinates including altitude. Compared exactly since positions are copied from the route. */
+  struct LegKey
+  {
+    float lonX1, latY1, alt1, lonX2, latY2, alt2;
+
+    bool operator==(const LegKey& other) const
+    {
+      return lonX1 == other.lonX1 && latY1 == other.latY1 && alt1 == other.alt1 &&
+             lonX2 == other.lonX2 && latY2 == other.latY2 && alt2 == other.alt2;
+    }
+
+    friend uint qHash(const LegKey& key)
+    {
+      return qHashBits(&key, sizeof(LegKey));
+    }
+
+  };
+
+  static LegKey legKey(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2);
+
+  /* Create sample positions and distances for leg */
+  void initLeg(atools::fs::common::RouteProfileLeg& leg, const atools::geo::Pos& pos1,
+               const atools::geo::Pos& pos2) const;
+
+  /* Fill elevation, MORA and wind for all samples in one parallel pass */
+  void calculateSamples(QVector<float>& elevations, QVector<int>& moras, QVector<atools::grib::Wind>& winds,
+                        const QVector<atools::geo::Pos>& positions, int numThreads);
+
+  atools::fs::common::GlobeReader *globeReader;
+  const atools::fs::common::MoraReader *moraReader;
+  const atools::grib::WindQuery *windQuery;
+
+  QVector<atools::fs::common::RouteProfileLeg> legs;
+  QHash<LegKey, atools::fs::common::RouteProfileLeg> legCache;
+  int numCalculatedLegs = 0;
+
+  float sampleDistanceMeter = 500.f, elevationSampleRadiusMeter = 0.f;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_ROUTEPROFILEENGINE_H
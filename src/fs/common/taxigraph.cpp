@@ -0,0 +1,357 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/taxigraph.h"
+
+#include "util/heap.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using atools::geo::Pos;
+
+/* "TXG1" */
+static const quint32 MAGIC_NUMBER = 0x31475854;
+static const int HEADER_SIZE = 12;
+
+/* Coordinates are rounded to this fraction of a degree for node merging which is about 10 cm */
+static const double NODE_KEY_SCALE = 1000000.;
+
+static const float INVALID_COST = std::numeric_limits<float>::max();
+
+/* Little endian float helpers. memcpy avoids alignment and aliasing issues. */
+static inline float readFloatLe(const char *data)
+{
+  quint32 bits = qFromLittleEndian<quint32>(data);
+  float value;
+  std::memcpy(&value, &bits, sizeof(float));
+  return value;
+}
+
+static inline void writeFloatLe(float value, char *data)
+{
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  qToLittleEndian<quint32>(bits, data);
+}
+
+TaxiGraph::TaxiGraph()
+{
+
+}
+
+TaxiGraph::TaxiGraph(const QByteArray& bytes)
+{
+  readFromByteArray(bytes);
+}
+
+void TaxiGraph::clear()
+{
+  lonX.clear();
+  latY.clear();
+  nodeFlags.clear();
+  offsets.clear();
+  targets.clear();
+  lengths.clear();
+  widths.clear();
+  edgeFlags.clear();
+  nodeIndex.clear();
+  pathEdges.clear();
+}
+
+int TaxiGraph::addNode(const Pos& pos, quint8 flags)
+{
+  qint64 key = (static_cast<qint64>(std::lround(pos.getLonX() * NODE_KEY_SCALE)) << 32) |
+               static_cast<quint32>(std::lround(pos.getLatY() * NODE_KEY_SCALE));
+
+  auto it = nodeIndex.constFind(key);
+  if(it != nodeIndex.constEnd())
+  {
+    nodeFlags[it.value()] |= flags;
+    return it.value();
+  }
+
+  int node = lonX.size();
+  lonX.append(pos.getLonX());
+  latY.append(pos.getLatY());
+  nodeFlags.append(flags);
+  nodeIndex.insert(key, node);
+  return node;
+}
+
+void TaxiGraph::addPath(const Pos& from, const Pos& to, float widthFt, quint8 edgeFlags,
+                        quint8 fromNodeFlags, quint8 toNodeFlags)
+{
+  if(!from.isValid() || !to.isValid())
+    return;
+
+  int fromNode = addNode(from, fromNodeFlags);
+  int toNode = addNode(to, toNodeFlags);
+
+  if(fromNode != toNode)
+    pathEdges.append({fromNode, toNode, widthFt, edgeFlags});
+}
+
+void TaxiGraph::finish()
+{
+  int numNodes = lonX.size();
+
+  // Count outgoing edges for each node - each path is used in both directions
+  offsets.fill(0, numNodes + 1);
+  for(const PathEdge& edge : qAsConst(pathEdges))
+  {
+    offsets[edge.from + 1]++;
+    offsets[edge.to + 1]++;
+  }
+
+  for(int i = 0; i < numNodes; i++)
+    offsets[i + 1] += offsets.at(i);
+
+  int numEdges = offsets.at(numNodes);
+  targets.resize(numEdges);
+  lengths.resize(numEdges);
+  widths.resize(numEdges);
+  edgeFlags.resize(numEdges);
+
+  // Fill using a running insert position for each node
+  QVector<int> insertPos(offsets);
+  for(const PathEdge& edge : qAsConst(pathEdges))
+  {
+    float length = getNodePos(edge.from).distanceMeterTo(getNodePos(edge.to));
+
+    int idx = insertPos[edge.from]++;
+    targets[idx] = edge.to;
+    lengths[idx] = length;
+    widths[idx] = edge.width;
+    edgeFlags[idx] = edge.flags;
+
+    idx = insertPos[edge.to]++;
+    targets[idx] = edge.from;
+    lengths[idx] = length;
+    widths[idx] = edge.width;
+    edgeFlags[idx] = edge.flags;
+  }
+
+  nodeIndex.clear();
+  pathEdges.clear();
+  pathEdges.squeeze();
+}
+
+QByteArray TaxiGraph::writeToByteArray() const
+{
+  int numNodes = lonX.size(), numEdges = targets.size();
+
+  QByteArray bytes;
+  bytes.resize(HEADER_SIZE + numNodes * 8 + (numNodes + 1) * 4 + numEdges * 12 + numNodes + numEdges);
+  char *data = bytes.data();
+
+  qToLittleEndian<quint32>(MAGIC_NUMBER, data);
+  qToLittleEndian<quint32>(static_cast<quint32>(numNodes), data + 4);
+  qToLittleEndian<quint32>(static_cast<quint32>(numEdges), data + 8);
+  data += HEADER_SIZE;
+
+  for(int i = 0; i < numNodes; i++, data += 8)
+  {
+    writeFloatLe(lonX.at(i), data);
+    writeFloatLe(latY.at(i), data + 4);
+  }
+
+  for(int i = 0; i < numNodes + 1; i++, data += 4)
+    qToLittleEndian<qint32>(offsets.value(i), data);
+
+  for(int i = 0; i < numEdges; i++, data += 12)
+  {
+    qToLittleEndian<qint32>(targets.at(i), data);
+    writeFloatLe(lengths.at(i), data + 4);
+    writeFloatLe(widths.at(i), data + 8);
+  }
+
+  std::memcpy(data, nodeFlags.constData(), static_cast<size_t>(numNodes));
+  data += numNodes;
+  std::memcpy(data, edgeFlags.constData(), static_cast<size_t>(numEdges));
+
+  return bytes;
+}
+
+void TaxiGraph::readFromByteArray(const QByteArray& bytes)
+{
+  clear();
+
+  const char *data = bytes.constData();
+  if(bytes.size() < HEADER_SIZE || qFromLittleEndian<quint32>(data) != MAGIC_NUMBER)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid taxi graph";
+    return;
+  }
+
+  int numNodes = static_cast<int>(qFromLittleEndian<quint32>(data + 4));
+  int numEdges = static_cast<int>(qFromLittleEndian<quint32>(data + 8));
+  if(numNodes < 0 || numEdges < 0 ||
+     static_cast<qint64>(bytes.size()) != HEADER_SIZE + static_cast<qint64>(numNodes) * 13 + 4 +
+     static_cast<qint64>(numEdges) * 13)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid taxi graph size" << bytes.size();
+    return;
+  }
+  data += HEADER_SIZE;
+
+  lonX.resize(numNodes);
+  latY.resize(numNodes);
+  for(int i = 0; i < numNodes; i++, data += 8)
+  {
+    lonX[i] = readFloatLe(data);
+    latY[i] = readFloatLe(data + 4);
+  }
+
+  offsets.resize(numNodes + 1);
+  for(int i = 0; i < numNodes + 1; i++, data += 4)
+    offsets[i] = qFromLittleEndian<qint32>(data);
+
+  targets.resize(numEdges);
+  lengths.resize(numEdges);
+  widths.resize(numEdges);
+  for(int i = 0; i < numEdges; i++, data += 12)
+  {
+    targets[i] = qFromLittleEndian<qint32>(data);
+    lengths[i] = readFloatLe(data + 4);
+    widths[i] = readFloatLe(data + 8);
+  }
+
+  nodeFlags.resize(numNodes);
+  std::memcpy(nodeFlags.data(), data, static_cast<size_t>(numNodes));
+  data += numNodes;
+  edgeFlags.resize(numEdges);
+  std::memcpy(edgeFlags.data(), data, static_cast<size_t>(numEdges));
+}
+
+int TaxiGraph::nearestNode(const Pos& pos, quint8 requiredFlags) const
+{
+  int nearest = -1;
+  float nearestDist = INVALID_COST;
+  for(int i = 0; i < lonX.size(); i++)
+  {
+    if((nodeFlags.at(i) & requiredFlags) == requiredFlags)
+    {
+      float dist = pos.distanceMeterTo(getNodePos(i));
+      if(dist < nearestDist)
+      {
+        nearestDist = dist;
+        nearest = i;
+      }
+    }
+  }
+  return nearest;
+}
+
+bool TaxiGraph::findPath(QVector<int>& path, float& distanceMeter, int from, int to, float minWidthFt,
+                         bool avoidRunways) const
+{
+  return search(path, distanceMeter, from, to, 0, minWidthFt, avoidRunways);
+}
+
+bool TaxiGraph::findPathToFlags(QVector<int>& path, float& distanceMeter, int from, quint8 targetFlags,
+                                float minWidthFt, bool avoidRunways) const
+{
+  return search(path, distanceMeter, from, -1, targetFlags, minWidthFt, avoidRunways);
+}
+
+bool TaxiGraph::search(QVector<int>& path, float& distanceMeter, int from, int to, quint8 targetFlags,
+                       float minWidthFt, bool avoidRunways) const
+{
+  path.clear();
+  distanceMeter = 0.f;
+
+  int numNodes = lonX.size();
+  if(from < 0 || from >= numNodes || to >= numNodes || (to < 0 && targetFlags == 0))
+    return false;
+
+  Pos toPos = to >= 0 ? getNodePos(to) : Pos();
+  QVector<float> costs(numNodes, INVALID_COST);
+  QVector<int> predecessors(numNodes, -1);
+  QVector<bool> closed(numNodes, false);
+
+  atools::util::IndexedHeap<float> openHeap;
+  openHeap.resize(numNodes);
+  costs[from] = 0.f;
+  openHeap.push(from, 0.f);
+
+  int found = -1;
+  while(!openHeap.isEmpty())
+  {
+    int node = openHeap.popData();
+    closed[node] = true;
+
+    if(node == to || (to < 0 && (nodeFlags.at(node) & targetFlags) != 0))
+    {
+      found = node;
+      break;
+    }
+
+    for(int edge = offsets.at(node); edge < offsets.at(node + 1); edge++)
+    {
+      int target = targets.at(edge);
+      if(closed.at(target))
+        continue;
+
+      float width = widths.at(edge);
+      if((width > 0.f && width < minWidthFt) || (avoidRunways && (edgeFlags.at(edge) & EDGE_RUNWAY)))
+        continue;
+
+      float cost = costs.at(node) + lengths.at(edge);
+      if(cost < costs.at(target))
+      {
+        costs[target] = cost;
+        predecessors[target] = node;
+
+        // Great circle distance never overestimates the remaining path length
+        float estimate = to >= 0 ? cost + getNodePos(target).distanceMeterTo(toPos) : cost;
+        openHeap.changeOrPush(target, estimate);
+      }
+    }
+  }
+
+  if(found == -1)
+    return false;
+
+  distanceMeter = costs.at(found);
+  for(int node = found; node != -1; node = predecessors.at(node))
+    path.append(node);
+  std::reverse(path.begin(), path.end());
+  return true;
+}
+
+atools::geo::LineString TaxiGraph::pathToLineString(const QVector<int>& path) const
+{
+  atools::geo::LineString line;
+  line.reserve(path.size());
+  for(int node : path)
+    line.append(getNodePos(node));
+  return line;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,185 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_TAXIGRAPH_H
+#define ATOOLS_TAXIGRAPH_H
+
+#include "geo/linestring.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/*
+ * Compact ground routing graph for one airport built from the taxi paths. Stored in table taxi_graph.
+ *
+ * Nodes are the distinct end points of taxi paths. Edges are kept in compressed sparse row (CSR) layout where the
+ * edges leaving node n are at indexes getEdgeBegin(n) to getEdgeEnd(n) - 1. Each taxi path gives one edge in each
+ * direction. Vehicle and closed paths are not included.
+ *
+ * Build the graph by calling addPath() for each taxi path followed by finish(). A finished graph is immutable and
+ * can be searched by several threads at the same time.
+ *
+ * The byte array format uses little endian arrays of all node and edge values. See writeToByteArray().
+ */
+class TaxiGraph
+{
+public:
+  /* Node flags */
+  static Q_DECL_CONSTEXPR quint8 NODE_HOLD_SHORT = 0x01;
+  static Q_DECL_CONSTEXPR quint8 NODE_ILS_HOLD_SHORT = 0x02;
+  static Q_DECL_CONSTEXPR quint8 NODE_RUNWAY = 0x04; /* Node is end of a runway path */
+  static Q_DECL_CONSTEXPR quint8 NODE_PARKING = 0x08; /* Node is at a parking spot */
+
+  /* Edge flags */
+  static Q_DECL_CONSTEXPR quint8 EDGE_RUNWAY = 0x01;
+  static Q_DECL_CONSTEXPR quint8 EDGE_PARKING = 0x02;
+
+  TaxiGraph();
+  explicit TaxiGraph(const QByteArray& bytes);
+
+  /* Add a taxi path between two positions. Positions closer than about 10 cm are merged into one node.
+   * widthFt is 0 if unknown. */
+  void addPath(const atools::geo::Pos& from, const atools::geo::Pos& to, float widthFt, quint8 edgeFlags,
+               quint8 fromNodeFlags, quint8 toNodeFlags);
+
+  /* Build the CSR arrays from all added paths and release temporary data */
+  void finish();
+
+  void clear();
+
+  /* Empty graph if bytes are invalid */
+  void readFromByteArray(const QByteArray& bytes);
+  QByteArray writeToByteArray() const;
+
+  bool isEmpty() const
+  {
+    return lonX.isEmpty();
+  }
+
+  int getNumNodes() const
+  {
+    return lonX.size();
+  }
+
+  /* Number of directed edges */
+  int getNumEdges() const
+  {
+    return targets.size();
+  }
+
+  atools::geo::Pos getNodePos(int node) const
+  {
+    return atools::geo::Pos(lonX.at(node), latY.at(node));
+  }
+
+  quint8 getNodeFlags(int node) const
+  {
+    return nodeFlags.at(node);
+  }
+
+  int getEdgeBegin(int node) const
+  {
+    return offsets.at(node);
+  }
+
+  int getEdgeEnd(int node) const
+  {
+    return offsets.at(node + 1);
+  }
+
+  int getEdgeTarget(int edge) const
+  {
+    return targets.at(edge);
+  }
+
+  float getEdgeLengthMeter(int edge) const
+  {
+    return lengths.at(edge);
+  }
+
+  float getEdgeWidthFt(int edge) const
+  {
+    return widths.at(edge);
+  }
+
+  quint8 getEdgeFlags(int edge) const
+  {
+    return edgeFlags.at(edge);
+  }
+
+  /* Nearest node having all of the given flags. -1 if none found. */
+  int nearestNode(const atools::geo::Pos& pos, quint8 requiredFlags = 0) const;
+
+  /*
+   * Find the shortest path between two nodes using A*. path contains all nodes including from and to.
+   * Edges narrower than minWidthFt are not used. Edges with unknown width are always used.
+   * Runway edges are not used if avoidRunways is true.
+   * @return false if no path was found
+   */
+  bool findPath(QVector<int>& path, float& distanceMeter, int from, int to, float minWidthFt = 0.f,
+                bool avoidRunways = false) const;
+
+  /* Same as above but stops at the nearest node having any of the given flags like NODE_HOLD_SHORT or
+   * NODE_RUNWAY. Allows gate to runway queries. */
+  bool findPathToFlags(QVector<int>& path, float& distanceMeter, int from, quint8 targetFlags,
+                       float minWidthFt = 0.f, bool avoidRunways = false) const;
+
+  /* Positions of path nodes */
+  atools::geo::LineString pathToLineString(const QVector<int>& path) const;
+
+private:
+  /* Path added by addPath() before finish() */
+  struct PathEdge
+  {
+    int from, to;
+    float width;
+    quint8 flags;
+  };
+
+  /* A* if to is a node or Dijkstra to nearest node with targetFlags if to is -1 */
+  bool search(QVector<int>& path, float& distanceMeter, int from, int to, quint8 targetFlags, float minWidthFt,
+              bool avoidRunways) const;
+
+  int addNode(const atools::geo::Pos& pos, quint8 flags);
+
+  /* Node values */
+  QVector<float> lonX, latY;
+  QVector<quint8> nodeFlags;
+
+  /* CSR offsets with getNumNodes() + 1 entries */
+  QVector<int> offsets;
+
+  /* Edge values */
+  QVector<int> targets;
+  QVector<float> lengths, widths;
+  QVector<quint8> edgeFlags;
+
+  /* Only used while building */
+  QHash<qint64, int> nodeIndex;
+  QVector<PathEdge> pathEdges;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_TAXIGRAPH_H
@@ -56,9 +56,13 @@ void XpGeometry::readFromByteArray(const QByteArray& bytes)
   in.setVersion(QDataStream::Qt_5_5);
   in.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
+  // Smallest node is type and one position - limits allocation for broken data
+  const int maxNodes = bytes.size() / static_cast<int>(sizeof(qint8) + 2 * sizeof(float));
+
   quint32 numNodes;
   quint16 numHoles;
   in >> numNodes;
+  geometry.boundary.reserve(std::min(static_cast<int>(numNodes), maxNodes));
   for(quint32 i = 0; i < numNodes; i++)
   {
     Node node;
@@ -67,10 +71,12 @@ void XpGeometry::readFromByteArray(const QByteArray& bytes)
   }
 
   in >> numHoles;
+  geometry.holes.reserve(std::min(static_cast<int>(numHoles), maxNodes));
   for(quint16 i = 0; i < numHoles; i++)
   {
     geometry.holes.append(Boundary());
     in >> numNodes;
+    geometry.holes.last().reserve(std::min(static_cast<int>(numNodes), maxNodes));
     for(quint32 j = 0; j < numNodes; j++)
     {
       Node node;
@@ -0,0 +1,401 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/compilebenchmark.h"
+
+#include "exception.h"
+#include "fs/bgl/bglfile.h"
+#include "fs/db/postloadupdater.h"
+#include "fs/db/routeedgewriter.h"
+#include "fs/navdatabase.h"
+#include "fs/navdatabaseerrors.h"
+#include "fs/navdatabaseoptions.h"
+#include "fs/navdatabaseprogress.h"
+#include "fs/scenery/sceneryarea.h"
+#include "fs/xp/xplinetokenizer.h"
+#include "geo/pos.h"
+#include "io/linereader.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlscript.h"
+#include "sql/sqlutil.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QStringBuilder>
+
+#include <algorithm>
+#include <limits>
+
+namespace atools {
+namespace fs {
+
+using atools::geo::Pos;
+
+/* Same as used by DataWriter */
+static const QSet<atools::fs::bgl::section::SectionType> BGL_SECTION_TYPES =
+{
+  bgl::section::AIRPORT, bgl::section::AIRPORT_ALT, bgl::section::ILS_VOR, bgl::section::NDB,
+  bgl::section::MARKER, bgl::section::WAYPOINT, bgl::section::NAME_LIST, bgl::section::BOUNDARY,
+  bgl::section::P3D_TACAN
+};
+
+/* Synthetic navaid with ident and region */
+struct BenchmarkNavaid
+{
+  QByteArray ident, region;
+  Pos pos;
+};
+
+/* Unique ident of uppercase letters for number */
+static QByteArray letterIdent(int number, int length)
+{
+  QByteArray ident(length, 'A');
+  for(int i = length - 1; i >= 0 && number > 0; i--)
+  {
+    ident[i] = static_cast<char>('A' + number % 26);
+    number /= 26;
+  }
+  return ident;
+}
+
+/* Region is derived from a coarse grid to keep neighbours in the same region */
+static QByteArray region(const Pos& pos)
+{
+  return letterIdent(static_cast<int>((pos.getLonX() + 180.f) / 20.f) * 10 +
+                     static_cast<int>((pos.getLatY() + 90.f) / 20.f), 2);
+}
+
+static Pos randomPos(QRandomGenerator& random)
+{
+  return Pos(static_cast<float>(random.generateDouble() * 360. - 180.),
+             static_cast<float>(random.generateDouble() * 130. - 60.));
+}
+
+static QByteArray coords(const Pos& pos)
+{
+  return QByteArray::number(pos.getLatY(), 'f', 8) % ' ' % QByteArray::number(pos.getLonX(), 'f', 8);
+}
+
+static QByteArray header(const QByteArray& metadata)
+{
+  return "I\n1100 Version - data cycle 2301, build 20230101, metadata " % metadata %
+         ". Synthetic benchmark data.\n\n";
+}
+
+static void writeFile(const QString& filepath, const QByteArray& content)
+{
+  QDir().mkpath(QFileInfo(filepath).path());
+
+  QFile file(filepath);
+  if(!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+    throw atools::Exception(QString("Cannot write file \"%1\". Reason: %2").arg(filepath).arg(file.errorString()));
+}
+
+CompileBenchmark::CompileBenchmark(sql::SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+}
+
+void CompileBenchmark::generateXplaneScenery(const QString& basePath, const CompileBenchmarkConfig& config)
+{
+  QRandomGenerator random(config.seed);
+  QString dataPath = QDir(basePath).filePath("Resources/default data");
+
+  // earth_fix.dat ==================================================
+  QVector<BenchmarkNavaid> fixes;
+  QByteArray content = header("FixXP1100");
+  for(int i = 0; i < config.numFixes; i++)
+  {
+    Pos pos = randomPos(random);
+    fixes.append({letterIdent(i, 5), region(pos), pos});
+    content.append(coords(pos) % ' ' % fixes.constLast().ident % " ENRT " % fixes.constLast().region % '\n');
+  }
+  content.append("99\n");
+  writeFile(QDir(dataPath).filePath("earth_fix.dat"), content);
+
+  // earth_nav.dat ==================================================
+  content = header("NavXP1150");
+  for(int i = 0; i < config.numVors; i++)
+  {
+    Pos pos = randomPos(random);
+    content.append("3 " % coords(pos) % ' ' % QByteArray::number(random.bounded(0, 5000)) % ' ' %
+                   QByteArray::number(10800 + random.bounded(0, 200) * 5) % " 130 0.0 " % letterIdent(i, 3) %
+                   " ENRT " % region(pos) % " SYNTHETIC VOR/DME\n");
+  }
+
+  for(int i = 0; i < config.numNdbs; i++)
+  {
+    Pos pos = randomPos(random);
+    content.append("2 " % coords(pos) % ' ' % QByteArray::number(random.bounded(0, 5000)) % ' ' %
+                   QByteArray::number(200 + random.bounded(0, 1500)) % " 50 0.0 " % letterIdent(i, 2) %
+                   " ENRT " % region(pos) % " SYNTHETIC NDB\n");
+  }
+  content.append("99\n");
+  writeFile(QDir(dataPath).filePath("earth_nav.dat"), content);
+
+  // earth_awy.dat ==================================================
+  // Sort fixes in bands of latitude and longitude so that airways connect neighbours
+  QVector<int> order(fixes.size());
+  for(int i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&fixes](int i1, int i2) -> bool {
+              int band1 = static_cast<int>(fixes.at(i1).pos.getLatY() + 90.f) / 2;
+              int band2 = static_cast<int>(fixes.at(i2).pos.getLatY() + 90.f) / 2;
+              if(band1 != band2)
+                return band1 < band2;
+              else
+                return fixes.at(i1).pos.getLonX() < fixes.at(i2).pos.getLonX();
+            });
+
+  content = header("AwyXP1100");
+  for(int i = 0; !order.isEmpty() && i < config.numAirways; i++)
+  {
+    QByteArray name = (random.bounded(2) == 0 ? "V" : "J") + QByteArray::number(i + 1);
+    QByteArray typeAlt = random.bounded(2) == 0 ? " 1 10 180 " : " 2 180 450 ";
+    int index = random.bounded(order.size());
+    for(int j = 0; j < config.fixesPerAirway - 1 && index + 1 < order.size(); j++)
+    {
+      int next = std::min(index + 1 + random.bounded(3), order.size() - 1);
+      const BenchmarkNavaid& from = fixes.at(order.at(index)), & to = fixes.at(order.at(next));
+      content.append(from.ident % ' ' % from.region % " 11 " % to.ident % ' ' % to.region % " 11 N" % typeAlt %
+                     name % '\n');
+      index = next;
+    }
+  }
+  content.append("99\n");
+  writeFile(QDir(dataPath).filePath("earth_awy.dat"), content);
+
+  // apt.dat ==================================================
+  content = header("AptXP1100");
+  for(int i = 0; i < config.numAirports; i++)
+  {
+    Pos pos = randomPos(random);
+    content.append("1 " % QByteArray::number(random.bounded(0, 8000)) % " 0 0 X" %
+                   QByteArray::number(i).rightJustified(5, '0') % " Synthetic Airport " %
+                   QByteArray::number(i + 1) % '\n');
+
+    for(int j = 0; j < config.runwaysPerAirport; j++)
+    {
+      // Runways are offset perpendicular to avoid overlapping
+      int number = random.bounded(1, 19);
+      float heading = number * 10.f, lengthMeter = 1500.f + random.bounded(2500);
+      Pos center = pos.endpoint(j * 400.f, heading + 90.f);
+      Pos primary = center.endpoint(lengthMeter / 2.f, heading + 180.f);
+      Pos secondary = center.endpoint(lengthMeter / 2.f, heading);
+      content.append("100 45.00 1 0 0.25 0 2 0 " % QByteArray::number(number).rightJustified(2, '0') % ' ' %
+                     coords(primary) % " 0 0 3 0 0 0 " % QByteArray::number(number + 18).rightJustified(2, '0') %
+                     ' ' % coords(secondary) % " 0 0 3 0 0 0\n");
+    }
+  }
+  content.append("99\n");
+  writeFile(QDir(basePath).filePath("Resources/default scenery/default apt dat/Earth nav data/apt.dat"), content);
+
+  qInfo() << Q_FUNC_INFO << "Generated scenery in" << basePath;
+}
+
+QVector<CompileBenchmarkResult> CompileBenchmark::runCompile(const QString& basePath, int readerThreads)
+{
+  NavDatabaseOptions options;
+  options.setSimulatorType(FsPaths::XPLANE_11);
+  options.setBasepath(basePath);
+  options.setReaderThreads(readerThreads);
+  options.setResolveAirways(true);
+  options.setCreateRouteTables(true);
+  options.setCallDefaultCallback(false);
+
+  // Do not throttle to get all steps
+  options.setProgressCallbackIntervalMs(0);
+
+  // Accumulate time between progress messages
+  QVector<CompileBenchmarkResult> results;
+  QHash<QString, int> resultIndex;
+  QString step;
+  QElapsedTimer stepTimer, totalTimer;
+  options.setProgressCallback([&](const NavDatabaseProgress& progress) -> bool {
+    if(progress.isNewOther() || progress.isNewFile() || progress.isLastCall())
+    {
+      if(!step.isEmpty())
+      {
+        int index = resultIndex.value(step, -1);
+        if(index == -1)
+        {
+          resultIndex.insert(step, results.size());
+          results.append({step, 0, 0});
+          index = results.size() - 1;
+        }
+        results[index].nanoseconds += stepTimer.nsecsElapsed();
+        results[index].count++;
+      }
+
+      step = progress.isNewFile() ? tr("Reading BGL files") : progress.getOtherAction();
+      stepTimer.start();
+    }
+    return false;
+  });
+
+  NavDatabaseErrors errors;
+  NavDatabase navDatabase(&options, db, &errors, "benchmark");
+
+  totalTimer.start();
+  navDatabase.compileDatabase();
+  results.prepend({tr("Compile total"), totalTimer.nsecsElapsed(), 0});
+
+  qInfo() << Q_FUNC_INFO << "Compiled" << basePath << "in" << totalTimer.elapsed() << "ms";
+  return results;
+}
+
+CompileBenchmarkResult CompileBenchmark::benchmarkXpTokenizer(const QString& filepath, int repetitions)
+{
+  QFile file(filepath);
+  if(!file.open(QIODevice::ReadOnly))
+    throw atools::Exception(QString("Cannot open file \"%1\". Reason: %2").arg(filepath).arg(file.errorString()));
+  QByteArray content = file.readAll();
+
+  CompileBenchmarkResult result = {tr("X-Plane tokenizer"), std::numeric_limits<qint64>::max(), 0};
+  for(int i = 0; i < repetitions; i++)
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    atools::io::LineReader reader;
+    reader.setData(content);
+    atools::fs::xp::XpLineTokenizer tokenizer;
+    QString line;
+    int lines = 0;
+    while(reader.readLine(line))
+    {
+      tokenizer.tokenize(line);
+      lines++;
+    }
+
+    result.nanoseconds = std::min(result.nanoseconds, timer.nsecsElapsed());
+    result.count = lines;
+  }
+  return result;
+}
+
+CompileBenchmarkResult CompileBenchmark::benchmarkRouteEdgeWriter(int repetitions, int numThreads)
+{
+  CompileBenchmarkResult result = {tr("Route edge writer"), std::numeric_limits<qint64>::max(), 0};
+  for(int i = 0; i < repetitions; i++)
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    atools::fs::db::RouteEdgeWriter writer(db, numThreads);
+    writer.run();
+    db->commit();
+
+    result.nanoseconds = std::min(result.nanoseconds, timer.nsecsElapsed());
+  }
+  result.count = atools::sql::SqlUtil(db).rowCount("route_edge_radio");
+  return result;
+}
+
+QVector<CompileBenchmarkResult> CompileBenchmark::benchmarkPostLoadUpdates(int repetitions, int numThreads)
+{
+  struct Update
+  {
+    QString script, table, resetSql;
+    void (atools::fs::db::PostLoadUpdater::*update)();
+  };
+
+  const QVector<Update> updates({
+    {"fs/db/update_wp_ids.sql", "waypoint",
+     "update waypoint set nav_id = null, num_victor_airway = 0, num_jet_airway = 0",
+     &atools::fs::db::PostLoadUpdater::updateWaypointIds},
+    {"fs/db/update_nav_ids.sql", "waypoint",
+     "update waypoint set airport_id = null",
+     &atools::fs::db::PostLoadUpdater::updateNavaidAirportIds},
+    {"fs/db/update_airport_ils.sql", "ils",
+     "update ils set loc_runway_end_id = null, loc_airport_ident = null, loc_runway_name = null",
+     &atools::fs::db::PostLoadUpdater::updateAirportIls}
+  });
+
+  QVector<CompileBenchmarkResult> results;
+  for(const Update& update : updates)
+  {
+    int count = atools::sql::SqlUtil(db).rowCount(update.table);
+    CompileBenchmarkResult scriptResult = {update.script, std::numeric_limits<qint64>::max(), count};
+    CompileBenchmarkResult nativeResult = {update.script % tr(" native"), std::numeric_limits<qint64>::max(), count};
+
+    for(int i = 0; i < repetitions; i++)
+    {
+      for(bool native : {false, true})
+      {
+        db->exec(update.resetSql);
+
+        QElapsedTimer timer;
+        timer.start();
+        if(native)
+        {
+          atools::fs::db::PostLoadUpdater updater(db, numThreads);
+          (updater.*update.update)();
+        }
+        else
+          atools::sql::SqlScript(db, false /* verbose */).executeScript(":/atools/resources/sql/" % update.script);
+
+        CompileBenchmarkResult& result = native ? nativeResult : scriptResult;
+        result.nanoseconds = std::min(result.nanoseconds, timer.nsecsElapsed());
+        db->rollback();
+      }
+    }
+    results.append(scriptResult);
+    results.append(nativeResult);
+  }
+  return results;
+}
+
+CompileBenchmarkResult CompileBenchmark::benchmarkBglFiles(const QStringList& filepaths, int repetitions)
+{
+  NavDatabaseOptions options;
+  atools::fs::scenery::SceneryArea area(1, tr("Benchmark"), QString());
+
+  CompileBenchmarkResult result = {tr("BGL file reader"), std::numeric_limits<qint64>::max(),
+                                   static_cast<int>(filepaths.size())};
+  for(int i = 0; i < repetitions; i++)
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    for(const QString& filepath : filepaths)
+    {
+      atools::fs::bgl::BglFile bglFile(&options);
+      bglFile.setSupportedSectionTypes(BGL_SECTION_TYPES);
+      bglFile.readFile(filepath, area);
+    }
+
+    result.nanoseconds = std::min(result.nanoseconds, timer.nsecsElapsed());
+  }
+  return result;
+}
+
+QString CompileBenchmark::toCsv(const QVector<CompileBenchmarkResult>& results)
+{
+  QString csv("name;milliseconds;count\n");
+  for(const CompileBenchmarkResult& result : results)
+    csv.append(result.name % ';' % QString::number(result.nanoseconds / 1000000.) % ';' %
+               QString::number(result.count) % '\n');
+  return csv;
+}
+
+} // namespace fs
+} // namespace atools
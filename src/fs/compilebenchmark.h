@@ -0,0 +1,112 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMPILEBENCHMARK_H
+#define ATOOLS_FS_COMPILEBENCHMARK_H
+
+#include <QCoreApplication>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+
+/* Size of the synthetic X-Plane scenery */
+struct CompileBenchmarkConfig
+{
+  int numAirports = 5000;
+  int runwaysPerAirport = 2;
+  int numFixes = 50000;
+  int numVors = 2000;
+  int numNdbs = 2000;
+  int numAirways = 1000;
+  int fixesPerAirway = 20;
+
+  /* Same seed produces the same files */
+  quint32 seed = 1;
+};
+
+/* Fastest wall time of a micro benchmark or accumulated time of a compilation step */
+struct CompileBenchmarkResult
+{
+  QString name;
+  qint64 nanoseconds = 0;
+
+  /* Number of processed items like lines, files or rows. 0 if not applicable. */
+  int count = 0;
+};
+
+/*
+ * Measures navdata compilation without a simulator installation.
+ *
+ * generateXplaneScenery() writes a synthetic X-Plane 11 installation with apt.dat, earth_fix.dat, earth_nav.dat
+ * and earth_awy.dat which is compiled by runCompile() using the full NavDatabase pipeline including
+ * airway resolution and routing tables. Step timings are taken from the progress callback.
+ *
+ * The micro benchmarks run isolated parts repetitions times and keep the fastest run.
+ * BGL files cannot be generated and have to be passed from an existing installation.
+ *
+ * Ships as a library class like atools::routing::RouteBenchmark and can be called from a command line tool.
+ */
+class CompileBenchmark
+{
+  Q_DECLARE_TR_FUNCTIONS(CompileBenchmark)
+
+public:
+  /* Database is used by runCompile() and benchmarkRouteEdgeWriter(). Has to be opened by the caller. */
+  CompileBenchmark(atools::sql::SqlDatabase *sqlDb);
+
+  /* Create directory structure and files below basePath. Existing files are overwritten. */
+  static void generateXplaneScenery(const QString& basePath, const atools::fs::CompileBenchmarkConfig& config);
+
+  /*
+   * Compile the X-Plane scenery at basePath into the database.
+   * Returns the total time followed by the accumulated time of each progress step in order of appearance.
+   * atools::Exception is thrown in case of error.
+   */
+  QVector<atools::fs::CompileBenchmarkResult> runCompile(const QString& basePath, int readerThreads = 0);
+
+  /* Decode and tokenize all lines of an X-Plane dat file. Count is the number of lines. */
+  atools::fs::CompileBenchmarkResult benchmarkXpTokenizer(const QString& filepath, int repetitions = 1);
+
+  /* Create route_edge_radio from route_node_radio. Needs a compiled database. Count is the number of edges. */
+  atools::fs::CompileBenchmarkResult benchmarkRouteEdgeWriter(int repetitions = 1, int numThreads = 0);
+
+  /*
+   * Compare post-load SQL scripts with the native atools::fs::db::PostLoadUpdater on a compiled database.
+   * Returns script and native result for each update. Updated columns are cleared untimed before each run
+   * and all changes are rolled back afterwards. Count is the number of updated table rows.
+   */
+  QVector<atools::fs::CompileBenchmarkResult> benchmarkPostLoadUpdates(int repetitions = 1, int numThreads = 0);
+
+  /* Read BGL files with the sections used by the compiler. Count is the number of files. */
+  atools::fs::CompileBenchmarkResult benchmarkBglFiles(const QStringList& filepaths, int repetitions = 1);
+
+  /* Convert results to CSV with header line for simple comparison */
+  static QString toCsv(const QVector<atools::fs::CompileBenchmarkResult>& results);
+
+private:
+  atools::sql::SqlDatabase *db;
+};
+
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMPILEBENCHMARK_H
@@ -0,0 +1,247 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/compileprofiler.h"
+
+#include "exception.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "util/tracing.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QStringBuilder>
+#include <QTextStream>
+
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <time.h>
+#endif
+
+namespace atools {
+namespace fs {
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+CompileProfiler::CompileProfiler(sql::SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+CompileProfiler::~CompileProfiler()
+{
+
+}
+
+void CompileProfiler::clear()
+{
+  phases.clear();
+  phaseOrder.clear();
+  running.clear();
+}
+
+void CompileProfiler::begin(const QString& phaseName)
+{
+  beginInternal(phaseName, false /* sequential */);
+}
+
+void CompileProfiler::next(const QString& phaseName)
+{
+  beginInternal(phaseName, true /* sequential */);
+}
+
+bool CompileProfiler::isActive() const
+{
+#ifdef ATOOLS_TRACING
+  return enabled || atools::util::Tracing::isEnabled();
+#else
+  return enabled;
+#endif
+}
+
+void CompileProfiler::end()
+{
+  if(!isActive())
+    return;
+
+  // Close open phases of a sequence first
+  while(!running.isEmpty() && running.constLast().sequential)
+    endInternal();
+
+  if(!running.isEmpty())
+    endInternal();
+  else
+    qWarning() << Q_FUNC_INFO << "No phase running";
+}
+
+void CompileProfiler::beginInternal(const QString& phaseName, bool sequential)
+{
+  if(!isActive())
+    return;
+
+  // Phases of a sequence cannot have children - end previous one
+  if(!running.isEmpty() && running.constLast().sequential)
+    endInternal();
+
+  Running run;
+  run.name = running.isEmpty() ? phaseName : QString(running.constLast().name % "/" % phaseName);
+  run.sequential = sequential;
+  run.cpuNs = processCpuNs();
+  run.rows = totalChanges();
+  run.timer.start();
+
+#ifdef ATOOLS_TRACING
+  if(atools::util::Tracing::isEnabled())
+    run.traceStartNs = atools::util::Tracing::nowNs();
+#endif
+
+  // Create entry now to keep the order of start
+  phase(run.name);
+  running.append(run);
+}
+
+void CompileProfiler::endInternal()
+{
+  Running run = running.takeLast();
+
+#ifdef ATOOLS_TRACING
+  if(run.traceStartNs >= 0)
+    atools::util::Tracing::addSpan("compile", atools::util::Tracing::internName(run.name), run.traceStartNs,
+                                   atools::util::Tracing::nowNs() - run.traceStartNs);
+#endif
+
+  Phase& p = phase(run.name);
+  p.calls++;
+  p.wallNs += run.timer.nsecsElapsed();
+
+  qint64 cpuNs = processCpuNs();
+  if(cpuNs >= 0 && run.cpuNs >= 0)
+    p.cpuNs = std::max(p.cpuNs, Q_INT64_C(0)) + cpuNs - run.cpuNs;
+
+  qint64 rows = totalChanges();
+  if(rows >= 0 && run.rows >= 0)
+    p.rows = std::max(p.rows, Q_INT64_C(0)) + rows - run.rows;
+
+  p.bytesRead += run.bytesRead;
+}
+
+void CompileProfiler::addTime(const QString& phaseName, qint64 nanoseconds)
+{
+  if(!enabled)
+    return;
+
+  Phase& p = phase(running.isEmpty() ? phaseName : QString(running.constLast().name % "/" % phaseName));
+  p.calls++;
+  p.wallNs += nanoseconds;
+}
+
+void CompileProfiler::addBytesRead(qint64 bytes)
+{
+  if(!enabled)
+    return;
+
+  for(Running& run : running)
+    run.bytesRead += bytes;
+}
+
+CompileProfiler::Phase& CompileProfiler::phase(const QString& name)
+{
+  if(!phases.contains(name))
+    phaseOrder.append(name);
+  return phases[name];
+}
+
+QString CompileProfiler::getReport() const
+{
+  QString report;
+  QTextStream stream(&report);
+  stream << "phase;calls;wall_ms;cpu_ms;rows;bytes_read" << endl;
+
+  for(const QString& name : phaseOrder)
+  {
+    const Phase& p = phases.value(name);
+    stream << name << ";" << p.calls << ";" << p.wallNs / 1000000 << ";"
+           << (p.cpuNs >= 0 ? p.cpuNs / 1000000 : -1) << ";" << p.rows << ";" << p.bytesRead << endl;
+  }
+  stream.flush();
+  return report;
+}
+
+void CompileProfiler::writeReport(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly | QIODevice::Text))
+  {
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << getReport();
+    stream.flush();
+    file.close();
+    qInfo() << Q_FUNC_INFO << "Wrote compile profile to" << filename;
+  }
+  else
+    throw atools::Exception(QString("Cannot write compile profile \"%1\". Reason: %2.").
+                            arg(filename).arg(file.errorString()));
+}
+
+qint64 CompileProfiler::totalChanges() const
+{
+  if(db == nullptr || !db->isOpen())
+    return -1;
+
+  atools::sql::SqlQuery query("select total_changes()", db);
+  query.exec();
+  return query.next() ? query.value(0).toLongLong() : -1;
+}
+
+qint64 CompileProfiler::processCpuNs()
+{
+#if defined(Q_OS_WIN)
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if(GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+  {
+    // Units of 100 ns
+    quint64 kernel = (static_cast<quint64>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    quint64 user = (static_cast<quint64>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return static_cast<qint64>(kernel + user) * 100;
+  }
+  return -1;
+
+#elif defined(Q_OS_UNIX)
+  struct timespec time;
+  if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) == 0)
+    return static_cast<qint64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+  return -1;
+
+#else
+  return -1;
+
+#endif
+}
+
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,158 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_COMPILEPROFILER_H
+#define ATOOLS_FS_COMPILEPROFILER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+
+/*
+ * Records wall time, process CPU time, rows inserted and bytes read for the phases of a database compilation.
+ *
+ * Phases are measured with begin() and end() or with the Scope helper and can be nested. Row counts are taken
+ * from the SQLite total_changes() of the database. Bytes read are reported by the readers using addBytesRead()
+ * since memory mapped files do not show up in the I/O counters of the operating system.
+ * Fine grained phases inside loops can add only wall time with addTime().
+ *
+ * Phases with the same name are accumulated. The report keeps the order of first appearance so reports of two
+ * builds can be compared with a plain diff.
+ *
+ * All methods do nothing if the profiler is disabled. Not thread safe. Use only from the compiling thread.
+ *
+ * Phases are also recorded as spans by atools::util::Tracing if built with ATOOLS_TRACING and tracing is enabled
+ * at runtime. The profiler does not have to be enabled for this.
+ */
+class CompileProfiler
+{
+public:
+  explicit CompileProfiler(atools::sql::SqlDatabase *sqlDb = nullptr);
+  ~CompileProfiler();
+
+  CompileProfiler(const CompileProfiler& other) = delete;
+  CompileProfiler& operator=(const CompileProfiler& other) = delete;
+
+  /* Start a phase. Nested phases get the name of the parent as prefix separated by "/". */
+  void begin(const QString& phase);
+
+  /* End the last phase started with begin() and all phases started with next() below it */
+  void end();
+
+  /* Start a phase which ends automatically when the next phase on the same level starts or the parent ends.
+   * Allows to simply mark the steps of a sequence. Cannot have nested phases. */
+  void next(const QString& phase);
+
+  /* Add wall time in nanoseconds to a phase below the currently running one. Counts one call. */
+  void addTime(const QString& phase, qint64 nanoseconds);
+
+  /* Add bytes of read files to all running phases */
+  void addBytesRead(qint64 bytes);
+
+  /* Returns a semicolon separated report with header line. Times in milliseconds. -1 if not available.
+   * Columns: phase;calls;wall_ms;cpu_ms;rows;bytes_read. CPU time includes all threads of the process. */
+  QString getReport() const;
+
+  /* Write report into file. Throws atools::Exception if the file cannot be written. */
+  void writeReport(const QString& filename) const;
+
+  void clear();
+
+  bool isEnabled() const
+  {
+    return enabled;
+  }
+
+  void setEnabled(bool value)
+  {
+    enabled = value;
+  }
+
+  /* Calls begin() in the constructor and end() in the destructor. profiler can be null. */
+  class Scope
+  {
+  public:
+    Scope(CompileProfiler *profilerParam, const QString& phase)
+      : profiler(profilerParam)
+    {
+      if(profiler != nullptr)
+        profiler->begin(phase);
+    }
+
+    ~Scope()
+    {
+      if(profiler != nullptr)
+        profiler->end();
+    }
+
+    Scope(const Scope& other) = delete;
+    Scope& operator=(const Scope& other) = delete;
+
+  private:
+    CompileProfiler *profiler;
+  };
+
+private:
+  /* Accumulated values of a phase */
+  struct Phase
+  {
+    int calls = 0;
+    qint64 wallNs = 0, cpuNs = -1, rows = -1, bytesRead = 0;
+  };
+
+  /* Values taken when starting a phase */
+  struct Running
+  {
+    QString name;
+    QElapsedTimer timer;
+    qint64 cpuNs, rows, bytesRead = 0, traceStartNs = -1;
+    bool sequential;
+  };
+
+  /* true if enabled or if tracing is enabled */
+  bool isActive() const;
+
+  void beginInternal(const QString& phaseName, bool sequential);
+  void endInternal();
+
+  Phase& phase(const QString& name);
+  qint64 totalChanges() const;
+
+  /* Process CPU time of all threads in nanoseconds. -1 if not available. */
+  static qint64 processCpuNs();
+
+  atools::sql::SqlDatabase *db;
+  bool enabled = false;
+
+  QHash<QString, Phase> phases;
+  QStringList phaseOrder;
+  QVector<Running> running;
+};
+
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMPILEPROFILER_H
@@ -24,6 +24,8 @@
 #include "geo/rect.h"
 #include "geo/calculations.h"
 #include "fs/progresshandler.h"
+#include "util/parallel.h"
+#include "util/stringinterner.h"
 
 #include <QDebug>
 #include <QString>
@@ -45,34 +47,60 @@ using atools::sql::SqlUtil;
 using atools::geo::Pos;
 using atools::geo::Rect;
 
-// Get all tmp_airway_point rows and join previous and next waypoints to the result by ident, region and type
-static const QString WAYPOINT_QUERY_TYPE(
-  "select r.name, r.type, "
-  "  prev.waypoint_id as prev_waypoint_id, "
-  "  r.previous_minimum_altitude, "
-  "  r.previous_maximum_altitude, "
-  "  r.previous_direction, "
-  "  prev.lonx as prev_lonx, "
-  "  prev.laty as prev_laty, "
-  "  r.waypoint_id, "
-  "  w.lonx as lonx, "
-  "  w.laty as laty, "
-  "  next.waypoint_id as next_waypoint_id, "
-  "  r.next_minimum_altitude, "
-  "  r.next_maximum_altitude, "
-  "  r.next_direction, "
-  "  next.lonx as next_lonx, "
-  "  next.laty as next_laty "
-  "from tmp_airway_point r join tmp_waypoint w on r.waypoint_id = w.waypoint_id "
-  "  left outer join tmp_waypoint prev on "
-  "    r.previous_ident = prev.ident and "
-  "    r.previous_region = prev.region and "
-  "    r.previous_type = prev.type "
-  "  left outer join tmp_waypoint next on "
-  "    r.next_ident = next.ident and "
-  "    r.next_region = next.region and "
-  "    r.next_type = next.type "
-  "order by r.name");
+// All waypoints used to resolve airway points in memory
+static const QString WAYPOINT_QUERY("select waypoint_id, type, ident, region, lonx, laty from tmp_waypoint");
+
+// Get all tmp_airway_point rows having a valid waypoint ordered by name
+static const QString AIRWAY_POINT_QUERY(
+  "select name, type, waypoint_id, "
+  "  previous_type, previous_ident, previous_region, "
+  "  previous_minimum_altitude, previous_maximum_altitude, previous_direction, "
+  "  next_type, next_ident, next_region, "
+  "  next_minimum_altitude, next_maximum_altitude, next_direction "
+  "from tmp_airway_point where waypoint_id is not null "
+  "order by name");
+
+/* Number of airways per thread chunk */
+const static int MIN_AIRWAYS_PER_CHUNK = 100;
+
+/* Waypoint as loaded from tmp_waypoint */
+struct ResolverWaypoint
+{
+  int id;
+  Pos pos;
+};
+
+/* Key to find waypoints as referenced by airway points. Same as the former SQL join columns.
+ * Contains interned ids of ident, region and type. */
+struct WaypointKey
+{
+  int ident, region, type;
+
+  bool operator==(const WaypointKey& other) const
+  {
+    return ident == other.ident && region == other.region && type == other.type;
+  }
+
+};
+
+inline uint qHash(const WaypointKey& key)
+{
+  return (static_cast<uint>(key.ident) * 31u + static_cast<uint>(key.region)) * 31u + static_cast<uint>(key.type);
+}
+
+/* Index of waypoints by key. Key is not unique. Value is the index in the waypoint vector. */
+typedef QMultiHash<WaypointKey, int> WaypointIndex;
+
+/* One row from tmp_airway_point */
+struct ResolverAirwayPoint
+{
+  QString name, type;
+  int waypointIndex;
+  WaypointKey prevKey, nextKey;
+  int prevMinAlt, prevMaxAlt, nextMinAlt, nextMaxAlt;
+  char prevDir, nextDir;
+  bool hasPrev, hasNext;
+};
 
 /* Airway segment with from/to position and IDs */
 struct AirwayResolver::AirwaySegment
@@ -117,8 +145,8 @@ uint qHash(const AirwayResolver::AirwaySegment& segment)
          qHash(segment.type);
 }
 
-AirwayResolver::AirwayResolver(sql::SqlDatabase *sqlDb, atools::fs::ProgressHandler& progress)
-  : progressHandler(progress), curAirwayId(1), numAirways(0), airwayInsertStmt(sqlDb), db(sqlDb)
+AirwayResolver::AirwayResolver(sql::SqlDatabase *sqlDb, atools::fs::ProgressHandler& progress, int threads)
+  : progressHandler(progress), curAirwayId(1), numAirways(0), numThreads(threads), airwayInsertStmt(sqlDb), db(sqlDb)
 {
   SqlUtil util(sqlDb);
   airwayInsertStmt.prepare(util.buildInsertStatement("airway"));
@@ -158,100 +186,172 @@ bool AirwayResolver::run(int numReportSteps)
   int deleted = query.numRowsAffected();
   qInfo() << "Removed" << deleted << "from airway table";
 
-  // Use set to
-  QSet<AirwaySegment> airway;
-  QString currentAirway;
+  QElapsedTimer timer;
+  timer.start();
 
-  int totalRowCount = SqlUtil(db).rowCount("tmp_airway_point");
+  // Load all waypoints and build index by ident, region and type =====================
+  QVector<ResolverWaypoint> waypoints;
+  WaypointIndex waypointIndex;
+  QHash<int, int> waypointIndexById;
 
-  int rowsPerStep =
-    static_cast<int>(std::ceil(static_cast<float>(totalRowCount) / static_cast<float>(numReportSteps)));
-  int row = 0, steps = 0;
+  // Strings are only interned for waypoints since airway point references not found will never match
+  atools::util::StringInterner interner;
 
-  QElapsedTimer timer;
-  timer.start();
-  qint64 elapsed = timer.elapsed();
+  query.exec(WAYPOINT_QUERY);
+  while(query.next())
+  {
+    ResolverWaypoint wp;
+    wp.id = query.valueInt("waypoint_id");
+    wp.pos = Pos(query.valueFloat("lonx"), query.valueFloat("laty"));
+
+    waypointIndex.insert({interner.intern(query.valueStr("ident")), interner.intern(query.valueStr("region")),
+                          interner.intern(query.valueStr("type"))}, waypoints.size());
+    waypointIndexById.insert(wp.id, waypoints.size());
+    waypoints.append(wp);
+  }
 
-  // Get all tmp_airway_point rows and join previous and next waypoints to the result by ident and region
+  // Load all airway points and get airway ranges =====================
   // Result is ordered by airway name
-  query.exec(WAYPOINT_QUERY_TYPE);
+  QVector<ResolverAirwayPoint> points;
+  QVector<std::pair<int, int> > airwayRanges; // Airway range in points vector [begin, end)
+  query.exec(AIRWAY_POINT_QUERY);
   while(query.next())
   {
-    QString awName = query.value("name").toString();
-    QString awType = query.value("type").toString();
-
-    if((row++ % rowsPerStep) == 0)
+    auto it = waypointIndexById.constFind(query.valueInt("waypoint_id"));
+    if(it == waypointIndexById.constEnd())
+      continue;
+
+    ResolverAirwayPoint point;
+    point.name = query.valueStr("name");
+    point.type = query.valueStr("type");
+    point.waypointIndex = it.value();
+
+    // Null values do not match like in a SQL join
+    point.hasPrev = !query.isNull("previous_ident") && !query.isNull("previous_region") &&
+                    !query.isNull("previous_type");
+    point.prevKey = {interner.find(query.valueStr("previous_ident")), interner.find(query.valueStr("previous_region")),
+                     interner.find(query.valueStr("previous_type"))};
+    point.prevMinAlt = query.valueInt("previous_minimum_altitude");
+    point.prevMaxAlt = query.valueInt("previous_maximum_altitude");
+    point.prevDir = atools::strToChar(query.valueStr("previous_direction"));
+
+    point.hasNext = !query.isNull("next_ident") && !query.isNull("next_region") && !query.isNull("next_type");
+    point.nextKey = {interner.find(query.valueStr("next_ident")), interner.find(query.valueStr("next_region")),
+                     interner.find(query.valueStr("next_type"))};
+    point.nextMinAlt = query.valueInt("next_minimum_altitude");
+    point.nextMaxAlt = query.valueInt("next_maximum_altitude");
+    point.nextDir = atools::strToChar(query.valueStr("next_direction"));
+
+    if(airwayRanges.isEmpty() || points.constLast().name != point.name)
+      airwayRanges.append(std::make_pair(points.size(), points.size()));
+    points.append(point);
+    airwayRanges.last().second = points.size();
+  }
+  query.finish();
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << waypoints.size() << "waypoints" << points.size() << "airway points"
+           << airwayRanges.size() << "airways" << timer.restart() << "ms";
+
+  // Resolve previous and next waypoints and build fragments for each airway name in parallel ==========
+  // Each thread writes only to the fragment lists of its airways
+  QVector<QVector<Fragment> > airwayFragments(airwayRanges.size());
+  QVector<Fragment> *fragmentsData = airwayFragments.data();
+  float maxSegmentLengthMeter = atools::geo::nmToMeter(maxAirwaySegmentLengthNm);
+
+  atools::util::parallelFor(airwayRanges.size(), numThreads,
+                            [&points, &airwayRanges, &waypoints, &waypointIndex, fragmentsData,
+                             maxSegmentLengthMeter](int begin, int end, int) {
+    // Use set to remove duplicate segments
+    QSet<AirwaySegment> airway;
+    for(int i = begin; i < end; i++)
     {
-      qint64 elapsed2 = timer.elapsed();
-
-      // Update only every 500 ms - otherwise update only progress count
-      bool silent = !(elapsed + MIN_PROGRESS_REPORT_MS < elapsed2);
-      if(!silent)
-        elapsed = elapsed2;
-      steps++;
-      if((aborted = progressHandler.reportOther(tr("Creating airways: %1...").arg(awName), -1, silent)) == true)
-        break;
-    }
+      const std::pair<int, int>& range = airwayRanges.at(i);
+      airway.clear();
 
-    if(awName != currentAirway)
-    {
-      // A new airway comes from from the query save the current one to the database
-      if(!airway.empty())
+      for(int p = range.first; p < range.second; p++)
       {
-        // Build airway fragments
-        QVector<Fragment> fragments;
-        buildAirway(currentAirway, airway, fragments);
+        const ResolverAirwayPoint& point = points.at(p);
+        const ResolverWaypoint& current = waypoints.at(point.waypointIndex);
 
-        // Remove all fragments that are contained by others
-        cleanFragments(fragments);
+        // Add segments for all previous waypoints found by ident, region and type
+        for(auto it = point.hasPrev ? waypointIndex.constFind(point.prevKey) : waypointIndex.constEnd();
+            it != waypointIndex.constEnd() && it.key() == point.prevKey; ++it)
+        {
+          const ResolverWaypoint& prev = waypoints.at(it.value());
+          if(current.pos.distanceMeterTo(prev.pos) < maxSegmentLengthMeter)
+            airway.insert(AirwaySegment(prev.id, current.id, point.prevDir, point.prevMinAlt, point.prevMaxAlt,
+                                        point.type, prev.pos, current.pos));
+        }
 
-        for(const Fragment& fragment : qAsConst(fragments))
+        // Add segments for all next waypoints
+        for(auto it = point.hasNext ? waypointIndex.constFind(point.nextKey) : waypointIndex.constEnd();
+            it != waypointIndex.constEnd() && it.key() == point.nextKey; ++it)
         {
-          for(const TypeRowValueVector& bindRow : fragment.boundValues)
-          {
-            airwayInsertStmt.bindValues(bindRow);
-            airwayInsertStmt.exec();
-            numAirways += airwayInsertStmt.numRowsAffected();
-          }
+          const ResolverWaypoint& next = waypoints.at(it.value());
+          if(current.pos.distanceMeterTo(next.pos) < maxSegmentLengthMeter)
+            airway.insert(AirwaySegment(current.id, next.id, point.nextDir, point.nextMinAlt, point.nextMaxAlt,
+                                        point.type, current.pos, next.pos));
         }
-        airway.clear();
       }
-      currentAirway = awName;
+
+      if(!airway.empty())
+      {
+        // Build airway fragments
+        buildAirway(points.at(range.first).name, airway, fragmentsData[i]);
+
+        // Remove all fragments that are contained by others
+        cleanFragments(fragmentsData[i]);
+      }
     }
+  }, MIN_AIRWAYS_PER_CHUNK);
 
-    int currentWpId = query.value("waypoint_id").toInt();
-    Pos currentWpPos(query.value("lonx").toFloat(), query.value("laty").toFloat());
+  qDebug() << Q_FUNC_INFO << "Built airways" << timer.restart() << "ms";
 
-    QVariant prevWpIdColVal = query.value("prev_waypoint_id");
-    int prevMinAlt = query.value("previous_minimum_altitude").toInt();
-    int prevMaxAlt = query.value("previous_maximum_altitude").toInt();
-    char prevDir = atools::strToChar(query.value("previous_direction").toString());
+  // Write all fragments in order of airway name ================================
+  int rowsPerStep =
+    std::max(1, static_cast<int>(std::ceil(static_cast<float>(points.size()) / static_cast<float>(numReportSteps))));
+  int row = 0, steps = 0;
+  qint64 elapsed = timer.elapsed();
 
-    QVariant nextWpIdColVal = query.value("next_waypoint_id");
-    int nextMinAlt = query.value("next_minimum_altitude").toInt();
-    int nextMaxAlt = query.value("next_maximum_altitude").toInt();
-    char nextDir = atools::strToChar(query.value("next_direction").toString());
+  for(int i = 0; i < airwayRanges.size() && !aborted; i++)
+  {
+    const std::pair<int, int>& range = airwayRanges.at(i);
 
-    if(!prevWpIdColVal.isNull())
+    for(int p = range.first; p < range.second; p++)
     {
-      // Previous waypoint found - add segment
-      Pos prevPos(query.value("prev_lonx").toFloat(), query.value("prev_laty").toFloat());
-
-      if(currentWpPos.distanceMeterTo(prevPos) < atools::geo::nmToMeter(maxAirwaySegmentLengthNm))
-        airway.insert(AirwaySegment(prevWpIdColVal.toInt(), currentWpId, prevDir, prevMinAlt, prevMaxAlt, awType,
-                                    prevPos, currentWpPos));
+      if((row++ % rowsPerStep) == 0)
+      {
+        qint64 elapsed2 = timer.elapsed();
+
+        // Update only every 500 ms - otherwise update only progress count
+        bool silent = !(elapsed + MIN_PROGRESS_REPORT_MS < elapsed2);
+        if(!silent)
+          elapsed = elapsed2;
+        steps++;
+        if((aborted = progressHandler.reportOther(tr("Creating airways: %1...").arg(points.at(p).name), -1,
+                                                  silent)) == true)
+          break;
+      }
     }
 
-    if(!nextWpIdColVal.isNull())
-    {
-      // Next waypoint found - add segment
-      Pos nextPos(query.value("next_lonx").toFloat(), query.value("next_laty").toFloat());
+    if(aborted)
+      break;
 
-      if(currentWpPos.distanceMeterTo(nextPos) < atools::geo::nmToMeter(maxAirwaySegmentLengthNm))
-        airway.insert(AirwaySegment(currentWpId, nextWpIdColVal.toInt(), nextDir, nextMinAlt, nextMaxAlt, awType,
-                                    currentWpPos, nextPos));
+    for(Fragment& fragment : airwayFragments[i])
+    {
+      for(TypeRowValueVector& bindRow : fragment.boundValues)
+      {
+        // First column is the airway ID
+        bindRow.first().second = curAirwayId++;
+        airwayInsertStmt.bindValues(bindRow);
+        airwayInsertStmt.exec();
+        numAirways += airwayInsertStmt.numRowsAffected();
+      }
     }
-  } // while(query.next())
+
+    // Free memory early
+    airwayFragments[i].clear();
+  }
 
   // Eat up any remaining progress steps
   progressHandler.increaseCurrent(numReportSteps - steps);
@@ -349,7 +449,8 @@ void AirwayResolver::buildAirway(const QString& airwayName, QSet<AirwaySegment>&
 
       TypeRowValueVector row;
 
-      row.append(std::make_pair(":airway_id", curAirwayId));
+      // Airway ID is assigned when writing
+      row.append(std::make_pair(":airway_id", 0));
       row.append(std::make_pair(":airway_name", airwayName));
       row.append(std::make_pair(":airway_type", newSegment.type));
       row.append(std::make_pair(":airway_fragment_no", fragmentNum));
@@ -375,7 +476,6 @@ void AirwayResolver::buildAirway(const QString& airwayName, QSet<AirwaySegment>&
       fragment.boundValues.append(row);
 
       seqNo++;
-      curAirwayId++;
     }
     fragments.append(fragment);
 
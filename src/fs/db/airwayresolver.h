@@ -39,14 +39,17 @@ class AirwayResolver
   Q_DECLARE_TR_FUNCTIONS(AirwayResolver)
 
 public:
-  AirwayResolver(atools::sql::SqlDatabase *sqlDb, atools::fs::ProgressHandler& progress);
+  /* numThreads is used for chaining airways. 0 uses the number of cores. */
+  AirwayResolver(atools::sql::SqlDatabase *sqlDb, atools::fs::ProgressHandler& progress, int numThreads = 0);
   virtual ~AirwayResolver();
 
   /*
    * Build airways from tmp_airway_point table that uses only idents and region codes to connect waypoints to a chain.
    * This process has to run after all BGL files are loaded since the airways cross multiple
    * scenery areas and BGL files.
-   * Reads from "tmp_airway_point" joined with "waypoint" and writes to table "airway".
+   * Reads "tmp_airway_point" and "tmp_waypoint" into memory, resolves previous and next waypoints by
+   * ident, region and type using a hash and chains airways per name in parallel.
+   * Result is written to table "airway".
    * @return true if the process was aborted
    */
   bool run(int numReportSteps);
@@ -76,12 +79,13 @@ private:
     QVector<TypeRowValueVector> boundValues;
   };
 
-  void buildAirway(const QString& airwayName, QSet<atools::fs::db::AirwayResolver::AirwaySegment>& airway,
-                   QVector<Fragment>& fragments);
-  void cleanFragments(QVector<Fragment>& fragments);
+  /* Connects the unordered segments of an airway to fragments. Column airway_id is filled later when writing. */
+  static void buildAirway(const QString& airwayName, QSet<atools::fs::db::AirwayResolver::AirwaySegment>& airway,
+                          QVector<Fragment>& fragments);
+  static void cleanFragments(QVector<Fragment>& fragments);
 
   atools::fs::ProgressHandler& progressHandler;
-  int curAirwayId, numAirways;
+  int curAirwayId, numAirways, numThreads;
   atools::sql::SqlQuery airwayInsertStmt;
   atools::sql::SqlDatabase *db;
 };
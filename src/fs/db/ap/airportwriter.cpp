@@ -104,6 +104,10 @@ void AirportWriter::writeObject(const Airport *type)
   bool msfsNavdata = currentArea.isNavdata();
   bool msfs = options.getSimulatorType() == atools::fs::FsPaths::MSFS;
 
+  if(msfsNavdata)
+    // Apply pending replacements first since previous airports with the same ident might still exist
+    deleteProcessor.flushBatch();
+
   int predId = airportIdByIdent(ident, msfsNavdata /* warn */);
 
   if(ident.isEmpty())
@@ -370,8 +374,13 @@ void AirportWriter::writeObject(const Airport *type)
     taxiWriter->write(type->getTaxiPaths());
 
     if(options.isDeletes() && (delAp != nullptr || realAddon))
+    {
+      // Delete processor updates airport ids in navaid tables - write buffered rows first
+      dw.flushBulkInserts();
+
       // Now delete the stock/default/prev airport if there is any
       deleteProcessor.postProcessDelete();
+    }
   }
 }
 
@@ -460,14 +469,12 @@ void AirportWriter::updateMsfsAirport(const Airport *type, int predId)
 
 void AirportWriter::fetchAdmin(const Airport *type, QString& city, QString& state, QString& country, QString& region)
 {
-  const static QSet<QString> TOLOWER({"of", "and"});
-
   const NamelistEntry *nl = nameListIndex.value(type->getIdent(), nullptr);
   if(nl != nullptr)
   {
-    city = atools::capString(getDataWriter().getLanguage(nl->getCityName()), {}, TOLOWER).simplified();
-    state = atools::capString(getDataWriter().getLanguage(nl->getStateName()), {}, TOLOWER).simplified();
-    country = atools::capString(getDataWriter().getLanguage(nl->getCountryName()), {}, TOLOWER).simplified();
+    city = adminName(nl->getCityNameId(), nl->getCityName());
+    state = adminName(nl->getStateNameId(), nl->getStateName());
+    country = adminName(nl->getCountryNameId(), nl->getCountryName());
 
     if(!type->getRegion().isEmpty())
       region = type->getRegion().simplified();
@@ -476,6 +483,23 @@ void AirportWriter::fetchAdmin(const Airport *type, QString& city, QString& stat
   }
 }
 
+QString AirportWriter::adminName(int nameId, const QString& name)
+{
+  const static QSet<QString> TOLOWER({"of", "and"});
+
+  if(nameId == atools::util::StringInterner::INVALID_ID)
+    // Not pooled
+    return atools::capString(getDataWriter().getLanguage(name), {}, TOLOWER).simplified();
+
+  auto it = adminNameCache.constFind(nameId);
+  if(it != adminNameCache.constEnd())
+    return it.value();
+
+  QString formatted = atools::capString(getDataWriter().getLanguage(name), {}, TOLOWER).simplified();
+  adminNameCache.insert(nameId, formatted);
+  return formatted;
+}
+
 } // namespace writer
 } // namespace fs
 } // namespace atools
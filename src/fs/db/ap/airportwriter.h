@@ -59,6 +59,13 @@ public:
     return currentPos;
   }
 
+  /* Apply airport replacements collected by the delete processor in batch mode. Called at the end of each
+   * scenery area. */
+  void flushDeletes()
+  {
+    deleteProcessor.flushBatch();
+  }
+
 private:
   virtual void writeObject(const atools::fs::bgl::Airport *type) override;
 
@@ -69,11 +76,17 @@ private:
   void updateMsfsAirport(const bgl::Airport *type, int predId);
   void fetchAdmin(const bgl::Airport *type, QString& city, QString& state, QString& country, QString& region);
 
+  /* Translated and capitalized city, state or country name. Cached by namelist pool id. */
+  QString adminName(int nameId, const QString& name);
+
   typedef QHash<QString, const atools::fs::bgl::NamelistEntry *> NameListMapType;
   typedef NameListMapType::const_iterator NameListMapConstIterType;
   /* Maps airport ICAO idents to NamelistEntrys */
   NameListMapType nameListIndex;
 
+  /* Maps NamelistPool ids to formatted names. Valid for the whole compilation since the pool is shared. */
+  QHash<int, QString> adminNameCache;
+
   QString currentIdent;
   atools::geo::Pos currentPos;
   atools::fs::db::DeleteProcessor deleteProcessor;
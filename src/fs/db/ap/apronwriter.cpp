@@ -53,20 +53,12 @@ void ApronWriter::writeObject(const std::pair<const bgl::Apron *, const bgl::Apr
   bindBool(":is_draw_surface", type->second != nullptr ? type->second->isDrawSurface() : true);
   bindBool(":is_draw_detail", type->second != nullptr ? type->second->isDrawDetail() : true);
 
-  atools::geo::LineString positions;
-  for(const bgl::BglPosition& pos : type->first->getVertices())
-    positions.append(pos.getPos());
-
-  atools::fs::common::BinaryGeometry geo(positions);
+  atools::fs::common::BinaryGeometry geo(type->first->getVertices());
   bind(":vertices", geo.writeToByteArray());
 
   if(getOptions().isIncludedNavDbObject(type::APRON2) && type->second != nullptr)
   {
-    positions.clear();
-    for(const bgl::BglPosition& pos : type->first->getVertices())
-      positions.append(pos.getPos());
-
-    geo.setGeometry(positions);
+    geo.setGeometry(type->first->getVertices());
 
     bind(":vertices2", geo.writeToByteArray());
 
@@ -219,6 +219,14 @@ void DeleteProcessor::preProcessDelete()
   // Get facility counts for current airport
   extractPreviousAirportFeatures();
 
+  if(options.isBatchDeletes() && prevAirportId != -1 &&
+     (batchPrevToCurIds.contains(prevAirportId) || batchCurIds.contains(prevAirportId)))
+  {
+    // Previous airport is already part of a pending replacement - apply changes and fetch again
+    flushBatch();
+    extractPreviousAirportFeatures();
+  }
+
   // Delete the whole tree of approaches, transitions and legs on the old airport later in
   // ":/atools/resources/sql/fs/db/delete_duplicates.sql"
 
@@ -253,6 +261,12 @@ void DeleteProcessor::postProcessDelete()
   if(prevAirportId == -1)
     return;
 
+  if(options.isBatchDeletes())
+  {
+    batchPrevToCurIds.insert(prevAirportId, curAirportId);
+    batchCurIds.insert(curAirportId);
+  }
+
   // Collects all columns that will be copied from the previous airport to this new one
   QStringList copyAirportColumns;
 
@@ -303,7 +317,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasApproach)
   {
-    removeOrUpdate(deleteApproachStmt, updateApproachStmt, bgl::del::APPROACHES);
+    removeOrUpdate(deleteApproachStmt, updateApproachStmt, "approach", bgl::del::APPROACHES);
 
     if(hasPrevious && !isFlagSet(deleteFlags, bgl::del::APPROACHES))
       // Relink the approaches to the new airport and update the count on the airport
@@ -314,7 +328,7 @@ void DeleteProcessor::postProcessDelete()
   // Work on facilities that will be either removed or attached to the new airport depending on flags
   if(prevHasApron)
   {
-    removeOrUpdate(deleteApronStmt, updateApronStmt, bgl::del::APRONS);
+    removeOrUpdate(deleteApronStmt, updateApronStmt, "apron", bgl::del::APRONS);
 
     if(!isFlagSet(deleteFlags, bgl::del::APRONS) && hasPrevious)
       // Update apron count in new airport
@@ -323,7 +337,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasCom)
   {
-    removeOrUpdate(deleteComStmt, updateComStmt, bgl::del::COMS);
+    removeOrUpdate(deleteComStmt, updateComStmt, "com", bgl::del::COMS);
 
     if(!isFlagSet(deleteFlags, bgl::del::COMS) && hasPrevious)
       // Copy all frequencies to the new airport
@@ -332,7 +346,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasHelipad)
   {
-    removeOrUpdate(deleteHelipadStmt, updateHelipadStmt, bgl::del::HELIPADS);
+    removeOrUpdate(deleteHelipadStmt, updateHelipadStmt, "helipad", bgl::del::HELIPADS);
 
     if(!isFlagSet(deleteFlags, bgl::del::HELIPADS) && hasPrevious)
       // Update helipad count in new airport
@@ -341,7 +355,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasTaxi)
   {
-    removeOrUpdate(deleteTaxiPathStmt, updateTaxiPathStmt, bgl::del::TAXIWAYS);
+    removeOrUpdate(deleteTaxiPathStmt, updateTaxiPathStmt, "taxi_path", bgl::del::TAXIWAYS);
 
     if(!isFlagSet(deleteFlags, bgl::del::TAXIWAYS) && hasPrevious)
       // Update taxi count in new airport
@@ -350,7 +364,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasStart)
   {
-    removeOrUpdate(deleteStartStmt, updateStartStmt, bgl::del::STARTS);
+    removeOrUpdate(deleteStartStmt, updateStartStmt, "start", bgl::del::STARTS);
 
     if(!isFlagSet(deleteFlags, bgl::del::STARTS) && hasPrevious)
       // Update start count in new airport
@@ -364,18 +378,18 @@ void DeleteProcessor::postProcessDelete()
     else if(hasPrevious)
     {
       // Relink runways
-      bindAndExecute(updateRunwayStmt, "runways updated");
+      deleteOrUpdateFeature(updateRunwayStmt, "runway", false /* remove */, "runways updated");
       copyAirportColumns.append(RUNWAY_COLUMNS);
     }
   }
 
   if(!curAirport->getParkings().isEmpty())
     // New airport has parking - delete the previous ones
-    bindAndExecute(deleteParkingStmt, "parking spots deleted");
+    deleteOrUpdateFeature(deleteParkingStmt, "parking", true /* remove */, "parking spots deleted");
   else if(hasPrevious)
   {
     // New airport has no parking - transfer previous ones and update counts
-    bindAndExecute(updateParkingStmt, "parking spots updated");
+    deleteOrUpdateFeature(updateParkingStmt, "parking", false /* remove */, "parking spots updated");
     copyAirportColumns.append(AIRPORT_COLUMNS);
   }
 
@@ -407,11 +421,16 @@ void DeleteProcessor::postProcessDelete()
 
     // Get the best rating
     int currentRating = std::max(curAirport->calculateRating(isAddon), previousRating);
-    SqlQuery update(db);
-    update.prepare("update airport set rating = :rating where airport_id = :apid");
-    update.bindValue(":rating", currentRating);
-    update.bindValue(":apid", curAirportId);
-    update.exec();
+    if(options.isBatchDeletes())
+      batchRatings.append(std::make_pair(curAirportId, currentRating));
+    else
+    {
+      SqlQuery update(db);
+      update.prepare("update airport set rating = :rating where airport_id = :apid");
+      update.bindValue(":rating", currentRating);
+      update.bindValue(":apid", curAirportId);
+      update.exec();
+    }
 
     if(isAddon)
       // Previous was an addon - keep this state here, even if this airport is excluded
@@ -424,16 +443,21 @@ void DeleteProcessor::postProcessDelete()
 
   // Airport has moved more than 500 meter from previous or has moved to a far position - update bounding rectangle for current airport
   if(hasPrevious && (curAirport->getPos().distanceMeterTo(prevPos) > 500.f || movedFar))
-    updateBoundingRect();
+  {
+    if(options.isBatchDeletes())
+      batchBounding.append({curAirportId, curIdent, curAirport->getPos()});
+    else
+      updateBoundingRect(curAirportId, curIdent, curAirport->getPos());
+  }
 
   // Remove previous airport "delete from airport where airport_id = :prevApId"
   removePrevAirport();
 }
 
-void DeleteProcessor::updateBoundingRect()
+void DeleteProcessor::updateBoundingRect(int airportId, const QString& ident, const atools::geo::Pos& pos)
 {
   // Fetch min/max runway, taxipath, parking and other coordinates from current airport
-  fetchBoundingStmt->bindValue(":apid", curAirportId);
+  fetchBoundingStmt->bindValue(":apid", airportId);
   executeStatement(fetchBoundingStmt, "Fetch bounding");
   if(fetchBoundingStmt->next())
   {
@@ -447,21 +471,21 @@ void DeleteProcessor::updateBoundingRect()
 
       if(bounding.isValid())
       {
-        bounding.extend(curAirport->getPos());
+        bounding.extend(pos);
 
         // Check if rectangle exceeds 20 NM and convert to 500 meter rect if needed
         if(bounding.getHeightMeter() > atools::geo::nmToMeter(10) || bounding.getWidthMeter() > atools::geo::nmToMeter(10))
         {
-          qDebug() << Q_FUNC_INFO << "Correcting bounding rectangle of" << curIdent << "bounding" << bounding;
-          bounding = geo::Rect(curAirport->getPos(), 500.f, false /* fast */);
+          qDebug() << Q_FUNC_INFO << "Correcting bounding rectangle of" << ident << "bounding" << bounding;
+          bounding = geo::Rect(pos, 500.f, false /* fast */);
         }
 
 #ifdef DEBUG_INFORMATION
-        qDebug() << Q_FUNC_INFO << "ident" << curIdent << "currentAirportId" << curAirportId << "bounding" << bounding;
+        qDebug() << Q_FUNC_INFO << "ident" << ident << "airportId" << airportId << "bounding" << bounding;
 #endif
 
         // Update current airport
-        updateBoundingStmt->bindValue(":apid", curAirportId);
+        updateBoundingStmt->bindValue(":apid", airportId);
         updateBoundingStmt->bindValue(":leftlonx", bounding.getWest());
         updateBoundingStmt->bindValue(":toplaty", bounding.getNorth());
         updateBoundingStmt->bindValue(":rightlonx", bounding.getEast());
@@ -475,6 +499,12 @@ void DeleteProcessor::updateBoundingRect()
 
 void DeleteProcessor::removeRunways()
 {
+  if(options.isBatchDeletes())
+  {
+    batchDeleteIds["runway"].append(prevAirportId);
+    return;
+  }
+
   QList<int> runwayEndIds;
   fetchRunwayEndIdStmt->bindValue(":prevApId", prevAirportId);
   fetchIds(fetchRunwayEndIdStmt, runwayEndIds, " runway ends to delete");
@@ -492,6 +522,10 @@ void DeleteProcessor::removeRunways()
 
 void DeleteProcessor::removePrevAirport()
 {
+  if(options.isBatchDeletes())
+    // Done for all airports in flushBatch()
+    return;
+
   // Unlink navigation - will be updated later in "update_nav_ids.sql" script
   // we accecpt duplicates here - these will be deleted later
   bindAndExecute(updateWpStmt, "waypoints updated");
@@ -526,14 +560,23 @@ void DeleteProcessor::fetchIds(SqlQuery *stmt, QList<int>& ids, const QString& w
 }
 
 /* use the remove of update query for a feture depending on the delete flag */
-void DeleteProcessor::removeOrUpdate(SqlQuery *deleteStmt, SqlQuery *updateStmt, bgl::del::DeleteAllFlags flag)
+void DeleteProcessor::removeOrUpdate(SqlQuery *deleteStmt, SqlQuery *updateStmt, const QString& table,
+                                     bgl::del::DeleteAllFlags flag)
 {
   QString delTypeStr = bgl::DeleteAirport::deleteAllFlagsToStr(flag).toLower();
 
   if(isFlagSet(deleteFlags, flag))
-    bindAndExecute(deleteStmt, delTypeStr + " deleted");
+    deleteOrUpdateFeature(deleteStmt, table, true /* remove */, delTypeStr + " deleted");
+  else
+    deleteOrUpdateFeature(updateStmt, table, false /* remove */, delTypeStr + " updated");
+}
+
+void DeleteProcessor::deleteOrUpdateFeature(SqlQuery *stmt, const QString& table, bool remove, const QString& msg)
+{
+  if(options.isBatchDeletes())
+    (remove ? batchDeleteIds : batchUpdateIds)[table].append(prevAirportId);
   else
-    bindAndExecute(updateStmt, delTypeStr + " updated");
+    bindAndExecute(stmt, msg);
 }
 
 /* Create a statement that sets all airport_id columns to null in the given table that have
@@ -693,7 +736,12 @@ void DeleteProcessor::extractPreviousAirportFeatures()
 
 void DeleteProcessor::copyAirportValues(const QStringList& copyAirportColumns)
 {
-  if(!copyAirportColumns.isEmpty())
+  if(options.isBatchDeletes())
+  {
+    for(const QString& column : copyAirportColumns)
+      batchCopyColumnIds[column].append(curAirportId);
+  }
+  else if(!copyAirportColumns.isEmpty())
   {
     // Select values from previous/old airport
     SqlQuery query(db), insert(db);
@@ -719,6 +767,154 @@ void DeleteProcessor::copyAirportValues(const QStringList& copyAirportColumns)
   }
 }
 
+void DeleteProcessor::fillBatchIds(const QVector<int>& ids)
+{
+  SqlQuery query(db);
+  query.exec("delete from tmp_delete_id");
+
+  QVariantList idVars;
+  for(int id : ids)
+    idVars.append(id);
+
+  query.prepare("insert or ignore into tmp_delete_id (id) values(?)");
+  query.addBindValue(idVars);
+  query.execBatch();
+}
+
+void DeleteProcessor::flushBatch()
+{
+  if(batchPrevToCurIds.isEmpty())
+    return;
+
+  // Tables in the same order as in postProcessDelete()
+  static const QStringList FEATURE_TABLES({"approach", "apron", "com", "helipad", "taxi_path", "start", "runway",
+                                           "parking"});
+
+  if(options.isVerbose())
+    qInfo() << Q_FUNC_INFO << "Applying" << batchPrevToCurIds.size() << "airport replacements";
+
+  SqlQuery query(db);
+  query.exec("create temp table if not exists tmp_delete_airport "
+             "(prev_airport_id integer primary key, cur_airport_id integer not null, rating integer)");
+  query.exec("create temp table if not exists tmp_delete_id (id integer primary key)");
+  query.exec("create temp table if not exists tmp_delete_runway_end (runway_end_id integer primary key)");
+
+  // Fill mapping of previous to current airport ids
+  QVariantList prevIdVars, curIdVars;
+  for(auto it = batchPrevToCurIds.constBegin(); it != batchPrevToCurIds.constEnd(); ++it)
+  {
+    prevIdVars.append(it.key());
+    curIdVars.append(it.value());
+  }
+  query.prepare("insert into tmp_delete_airport (prev_airport_id, cur_airport_id) values(?, ?)");
+  query.addBindValue(prevIdVars);
+  query.addBindValue(curIdVars);
+  query.execBatch();
+  query.exec("create unique index if not exists idx_tmp_delete_airport_cur on tmp_delete_airport(cur_airport_id)");
+
+  // Delete or relink airport features ==============================
+  for(const QString& table : FEATURE_TABLES)
+  {
+    const QVector<int> deleteIds = batchDeleteIds.value(table);
+    if(!deleteIds.isEmpty())
+    {
+      fillBatchIds(deleteIds);
+
+      if(table == "runway")
+      {
+        // Remember runway ends and delete runway first due to foreign key from rw -> rw end
+        query.exec("delete from tmp_delete_runway_end");
+        query.prepare("insert or ignore into tmp_delete_runway_end "
+                   "select primary_end_id from runway where airport_id in (select id from tmp_delete_id) "
+                   "union "
+                   "select secondary_end_id from runway where airport_id in (select id from tmp_delete_id)");
+        executeStatement(&query, "runway ends to delete");
+
+        query.prepare("delete from runway where airport_id in (select id from tmp_delete_id)");
+        executeStatement(&query, "runways deleted");
+        query.prepare("delete from runway_end where runway_end_id in "
+                      "(select runway_end_id from tmp_delete_runway_end)");
+        executeStatement(&query, "runway ends deleted");
+      }
+      else
+      {
+        query.prepare("delete from " + table + " where airport_id in (select id from tmp_delete_id)");
+        executeStatement(&query, table + " deleted");
+      }
+    }
+
+    const QVector<int> updateIds = batchUpdateIds.value(table);
+    if(!updateIds.isEmpty())
+    {
+      fillBatchIds(updateIds);
+      query.prepare("update " + table + " set airport_id = "
+                 "(select t.cur_airport_id from tmp_delete_airport t where t.prev_airport_id = " + table + ".airport_id) "
+                 "where airport_id in (select id from tmp_delete_id)");
+      executeStatement(&query, table + " updated");
+    }
+  }
+
+  // Copy columns from previous airports to current airports - one statement per column ==============
+  for(auto it = batchCopyColumnIds.constBegin(); it != batchCopyColumnIds.constEnd(); ++it)
+  {
+    fillBatchIds(it.value());
+    query.prepare("update airport set " + it.key() + " = "
+               "(select p." + it.key() + " from airport p join tmp_delete_airport t on p.airport_id = t.prev_airport_id "
+               "where t.cur_airport_id = airport.airport_id) "
+               "where airport_id in (select id from tmp_delete_id)");
+    executeStatement(&query, it.key() + " copied");
+  }
+
+  // Update ratings ==============================
+  if(!batchRatings.isEmpty())
+  {
+    QVariantList ratingVars;
+    curIdVars.clear();
+    for(const std::pair<int, int>& rating : qAsConst(batchRatings))
+    {
+      ratingVars.append(rating.second);
+      curIdVars.append(rating.first);
+    }
+    query.prepare("update tmp_delete_airport set rating = ? where cur_airport_id = ?");
+    query.addBindValue(ratingVars);
+    query.addBindValue(curIdVars);
+    query.execBatch();
+
+    query.prepare("update airport set rating = "
+               "(select t.rating from tmp_delete_airport t where t.cur_airport_id = airport.airport_id) "
+               "where airport_id in (select cur_airport_id from tmp_delete_airport where rating is not null)");
+    executeStatement(&query, "ratings updated");
+  }
+
+  // Bounding rectangles need the relinked features
+  for(const BatchBounding& bounding : qAsConst(batchBounding))
+    updateBoundingRect(bounding.airportId, bounding.ident, bounding.pos);
+
+  // Unlink navigation and remove previous airports ==============================
+  for(const QString& table : {QString("waypoint"), QString("vor"), QString("ndb")})
+  {
+    query.prepare("update " + table + " set airport_id = "
+               "(select t.cur_airport_id from tmp_delete_airport t where t.prev_airport_id = " + table + ".airport_id) "
+               "where airport_id in (select prev_airport_id from tmp_delete_airport)");
+    executeStatement(&query, table + " updated");
+  }
+
+  query.prepare("delete from airport where airport_id in (select prev_airport_id from tmp_delete_airport)");
+  executeStatement(&query, "airports deleted");
+
+  query.exec("delete from tmp_delete_airport");
+  query.exec("delete from tmp_delete_id");
+  query.exec("delete from tmp_delete_runway_end");
+
+  batchPrevToCurIds.clear();
+  batchCurIds.clear();
+  batchDeleteIds.clear();
+  batchUpdateIds.clear();
+  batchCopyColumnIds.clear();
+  batchRatings.clear();
+  batchBounding.clear();
+}
+
 } // namespace writer
 } // namespace fs
 } // namespace atools
@@ -19,6 +19,11 @@
 #define ATOOLS_FS_DB_AP_DELETEPROCESSOR_H
 
 #include "fs/bgl/ap/del/deleteairport.h"
+#include "geo/pos.h"
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
 
 namespace atools {
 namespace sql {
@@ -44,6 +49,9 @@ class ApproachWriter;
  * old airports and their facilities.
  *
  * Copies values from previous airport to new and current airport. The previous airport is then deleted.
+ *
+ * Batch mode (NavDatabaseOptions::isBatchDeletes()) only collects the changes in postProcessDelete() and applies them
+ * for all airports at once in flushBatch() using set based statements over temporary id tables.
  */
 class DeleteProcessor
 {
@@ -68,10 +76,16 @@ public:
 
   /*
    * Start the update of the current and removal process of the previous airport. The current/new airport has to
-   * be stored in the database already.
+   * be stored in the database already. Changes are only collected in batch mode.
    */
   void postProcessDelete();
 
+  /*
+   * Apply all changes collected in batch mode. Has to be called at the end of each scenery area and
+   * before airports are looked up by ident. Does nothing if nothing is pending.
+   */
+  void flushBatch();
+
   const QString& getBglFilename() const
   {
     return bglFilename;
@@ -89,9 +103,16 @@ private:
   void removeRunways();
   void removePrevAirport();
 
+  /* Delete or relink rows of table for previous airport. Only collects the previous airport id in batch mode. */
+  void deleteOrUpdateFeature(sql::SqlQuery *stmt, const QString& table, bool remove, const QString& msg);
+
+  /* Fill temporary table tmp_delete_id with ids */
+  void fillBatchIds(const QVector<int>& ids);
+
   QString updateAptFeatureStmt(const QString& table);
   QString delAptFeatureStmt(const QString& table);
-  void removeOrUpdate(sql::SqlQuery *deleteStmt, sql::SqlQuery *updateStmt, atools::fs::bgl::del::DeleteAllFlags flag);
+  void removeOrUpdate(sql::SqlQuery *deleteStmt, sql::SqlQuery *updateStmt, const QString& table,
+                      atools::fs::bgl::del::DeleteAllFlags flag);
   QString updateAptFeatureToNullStmt(const QString& table);
   void removeApproachesAndTransitions(const QList<int>& ids);
   void extractDeleteFlags();
@@ -100,7 +121,7 @@ private:
   int bindAndExecute(const QString& sql, const QString& msg);
   void extractPreviousAirportFeatures();
   void copyAirportValues(const QStringList& copyAirportColumns);
-  void updateBoundingRect();
+  void updateBoundingRect(int airportId, const QString& ident, const atools::geo::Pos& pos);
 
   const atools::fs::NavDatabaseOptions& options;
 
@@ -141,6 +162,29 @@ private:
   int prevAirportId = 0;
   atools::geo::Pos prevPos;
 
+  /* Current airport which needs a bounding rectangle update in batch mode */
+  struct BatchBounding
+  {
+    int airportId;
+    QString ident;
+    atools::geo::Pos pos;
+  };
+
+  /* Batch mode data ====================================== */
+  /* Previous to current airport id for all collected replacements */
+  QHash<int, int> batchPrevToCurIds;
+  QSet<int> batchCurIds;
+
+  /* Table name to previous airport ids for deleting or relinking rows */
+  QHash<QString, QVector<int> > batchDeleteIds, batchUpdateIds;
+
+  /* Column name to current airport ids for copying values from the previous airport */
+  QHash<QString, QVector<int> > batchCopyColumnIds;
+
+  /* Current airport id and new rating */
+  QVector<std::pair<int, int> > batchRatings;
+  QVector<BatchBounding> batchBounding;
+
 };
 
 } // namespace writer
@@ -0,0 +1,133 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/apronmeshwriter.h"
+
+#include "fs/common/binarygeometry.h"
+#include "fs/common/pavementmesh.h"
+#include "fs/common/xpgeometry.h"
+#include "sql/sqlbulkinsert.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlQuery;
+using atools::fs::common::PavementMesh;
+
+namespace {
+
+// Query result column indexes
+enum ColumnIndex
+{
+  APRON_ID, AIRPORT_ID, VERTICES, GEOMETRY
+};
+
+/* Outline as loaded from table apron and the resulting mesh */
+struct Apron
+{
+  int apronId, airportId;
+  QByteArray vertices, geometry, mesh;
+  int numVertices = 0, numTriangles = 0;
+};
+
+} // namespace
+
+static void buildMesh(Apron& apron)
+{
+  PavementMesh mesh;
+
+  // X-Plane pavement with bezier curves and holes or plain FSX, P3D or MSFS outline
+  if(!apron.geometry.isEmpty())
+    mesh.build(atools::fs::common::XpGeometry(apron.geometry).getGeometry());
+  else if(!apron.vertices.isEmpty())
+    mesh.build(atools::fs::common::BinaryGeometry(apron.vertices).getGeometry());
+
+  apron.numVertices = mesh.getNumVertices();
+  apron.numTriangles = mesh.getNumTriangles();
+  if(!mesh.isEmpty())
+    apron.mesh = mesh.writeToByteArray();
+
+  // Not needed anymore
+  apron.vertices.clear();
+  apron.geometry.clear();
+}
+
+ApronMeshWriter::ApronMeshWriter(atools::sql::SqlDatabase *sqlDb, int numThreads)
+  : db(sqlDb), threads(numThreads)
+{
+
+}
+
+void ApronMeshWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Load all outlines which are drawn ==========================
+  QVector<Apron> aprons;
+  SqlQuery query("select apron_id, airport_id, vertices, geometry from apron where is_draw_surface = 1 "
+                 "order by airport_id", db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+  {
+    Apron apron;
+    apron.apronId = query.valueInt(APRON_ID);
+    apron.airportId = query.valueInt(AIRPORT_ID);
+    apron.vertices = query.value(VERTICES).toByteArray();
+    apron.geometry = query.value(GEOMETRY).toByteArray();
+    aprons.append(apron);
+  }
+
+  // Clean the result table
+  SqlQuery stmt(db);
+  stmt.exec("delete from apron_mesh");
+
+  // Triangulate - each thread writes only to its aprons ==========================
+  Apron *apronsData = aprons.data();
+  atools::util::parallelFor(aprons.size(), threads, [apronsData](int begin, int end, int) {
+    for(int i = begin; i < end; i++)
+      buildMesh(apronsData[i]);
+  }, 50);
+
+  // Write all in one batch ==========================
+  int numTriangles = 0;
+  atools::sql::SqlBulkInsert insert(db, "apron_mesh", {"apron_id", "airport_id", "num_vertices", "num_triangles",
+                                                       "mesh"});
+  for(const Apron& apron : qAsConst(aprons))
+  {
+    if(apron.numTriangles > 0)
+    {
+      insert.addRow({apron.apronId, apron.airportId, apron.numVertices, apron.numTriangles, apron.mesh});
+      numTriangles += apron.numTriangles;
+    }
+  }
+  insert.flush();
+
+  qDebug() << Q_FUNC_INFO << "aprons" << aprons.size() << "triangles" << numTriangles << timer.elapsed() << "ms";
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
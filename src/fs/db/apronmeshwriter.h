@@ -0,0 +1,60 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_APRONMESHWRITER_H
+#define ATOOLS_FS_DB_APRONMESHWRITER_H
+
+#include <QCoreApplication>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Optional compilation step which triangulates all aprons and X-Plane pavements and fills the table apron_mesh.
+ * Runs after all airports are loaded.
+ *
+ * The mesh is stored as atools::fs::common::PavementMesh blob with flattened bezier curves and holes resolved.
+ * Clients can draw it directly instead of triangulating the outline each time an airport diagram is drawn.
+ *
+ * Meshes are built in parallel and written in one batch.
+ */
+class ApronMeshWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(ApronMeshWriter)
+
+public:
+  /* numThreads: Threads used for building. 0 uses all cores. */
+  ApronMeshWriter(atools::sql::SqlDatabase *sqlDb, int numThreads = 0);
+
+  /* Clear and fill table apron_mesh */
+  void run();
+
+private:
+  atools::sql::SqlDatabase *db;
+  int threads;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_APRONMESHWRITER_H
@@ -0,0 +1,172 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/db/bglreadahead.h"
+
+#include "fs/bgl/bglfile.h"
+#include "fs/navdatabaseoptions.h"
+
+#include <QDebug>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+#include <exception>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::fs::bgl::BglFile;
+
+/* Number of files read ahead for each thread */
+static Q_DECL_CONSTEXPR int FILES_PER_THREAD = 2;
+
+struct BglReadAhead::ReadResult
+{
+  explicit ReadResult(const NavDatabaseOptions& optionsParam)
+    : options(optionsParam)
+  {
+  }
+
+  /* Private copy for this file since records keep a pointer to the options */
+  NavDatabaseOptions options;
+  std::unique_ptr<BglFile> file;
+  std::exception_ptr exception;
+  bool done = false;
+};
+
+/* Reads one file in the thread pool */
+class BglReadAheadTask :
+  public QRunnable
+{
+public:
+  BglReadAheadTask(BglReadAhead *readAheadParam, BglReadAhead::ReadResult *resultParam, const QString& filepathParam)
+    : readAhead(readAheadParam), result(resultParam), filepath(filepathParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    if(!readAhead->canceled)
+    {
+      try
+      {
+        result->file.reset(new BglFile(&result->options));
+        result->file->setSupportedSectionTypes(readAhead->supportedSectionTypes);
+        result->file->setNamelistPool(readAhead->namelistPool);
+        result->file->readFile(filepath, readAhead->sceneryArea);
+      }
+      catch(...)
+      {
+        // Passed to the writer thread which reports the error for this file
+        result->exception = std::current_exception();
+      }
+    }
+
+    QMutexLocker locker(&readAhead->mutex);
+    result->done = true;
+    readAhead->doneCondition.wakeAll();
+  }
+
+private:
+  BglReadAhead *readAhead;
+  BglReadAhead::ReadResult *result;
+  QString filepath;
+};
+
+BglReadAhead::BglReadAhead(const NavDatabaseOptions *options, const scenery::SceneryArea& area,
+                           const QStringList& filepaths, const QSet<bgl::section::SectionType>& sectionTypes,
+                           int numThreads, bgl::NamelistPool *namelists)
+  : navOptions(options), sceneryArea(area), files(filepaths), supportedSectionTypes(sectionTypes),
+  namelistPool(namelists), canceled(false)
+{
+  if(numThreads <= 0)
+    numThreads = QThread::idealThreadCount();
+
+  numReaderThreads = std::max(std::min(numThreads, static_cast<int>(files.size())), 1);
+
+  if(numReaderThreads > 1)
+  {
+    pool.setMaxThreadCount(numReaderThreads);
+    results.resize(static_cast<size_t>(files.size()));
+  }
+}
+
+BglReadAhead::~BglReadAhead()
+{
+  // Remove tasks which are not started yet and wait for the running ones before the results are deleted
+  canceled = true;
+  pool.clear();
+  pool.waitForDone();
+}
+
+BglFile *BglReadAhead::next(int index)
+{
+  if(numReaderThreads == 1)
+  {
+    // Read in calling thread ================================
+    // Reuse the file object to keep the memory blocks of its record arena
+    if(currentFile == nullptr)
+    {
+      currentFile.reset(new BglFile(navOptions));
+      currentFile->setSupportedSectionTypes(supportedSectionTypes);
+      currentFile->setNamelistPool(namelistPool);
+    }
+    currentFile->readFile(files.at(index), sceneryArea);
+    return currentFile.get();
+  }
+  else
+  {
+    // Release previous file and options copy since indexes are requested in order
+    if(index > 0)
+      results[static_cast<size_t>(index - 1)].reset();
+
+    schedule(index);
+
+    ReadResult *result = results.at(static_cast<size_t>(index)).get();
+    {
+      QMutexLocker locker(&mutex);
+      while(!result->done)
+        doneCondition.wait(&mutex);
+    }
+
+    if(result->exception)
+      std::rethrow_exception(result->exception);
+
+    return result->file.get();
+  }
+}
+
+void BglReadAhead::schedule(int index)
+{
+  int last = std::min(index + numReaderThreads * FILES_PER_THREAD, static_cast<int>(files.size()) - 1);
+
+  // Results are only read by the worker threads after start()
+  for(; numScheduled <= last; numScheduled++)
+  {
+    ReadResult *result = new ReadResult(*navOptions);
+    results[static_cast<size_t>(numScheduled)].reset(result);
+    pool.start(new BglReadAheadTask(this, result, files.at(numScheduled)));
+  }
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,121 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_DB_BGLREADAHEAD_H
+#define ATOOLS_FS_DB_BGLREADAHEAD_H
+
+#include "fs/bgl/sectiontype.h"
+
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace atools {
+namespace fs {
+class NavDatabaseOptions;
+
+namespace bgl {
+class BglFile;
+class NamelistPool;
+}
+namespace scenery {
+class SceneryArea;
+}
+
+namespace db {
+
+/*
+ * Reads BGL files of a scenery area ahead in a local thread pool while the caller writes the previous
+ * files to the database. Files are returned in the original order of the list to keep the scenery
+ * order and the delete processing intact.
+ *
+ * Each reader task uses its own copy of the options since the filters in NavDatabaseOptions
+ * are not safe for concurrent use. The copy is kept alive together with the file since all
+ * records refer to it.
+ *
+ * Reads all files sequentially in the calling thread if only one thread is requested.
+ */
+class BglReadAhead
+{
+public:
+  /*
+   * @param numThreads Number of reader threads. 0 uses the number of cores.
+   * @param namelists Shared pool for namelist strings or null.
+   * options, area, filepaths and namelists have to stay valid for the lifetime of this object.
+   */
+  BglReadAhead(const atools::fs::NavDatabaseOptions *options, const atools::fs::scenery::SceneryArea& area,
+               const QStringList& filepaths, const QSet<atools::fs::bgl::section::SectionType>& sectionTypes,
+               int numThreads, atools::fs::bgl::NamelistPool *namelists = nullptr);
+
+  /* Cancels all tasks not started yet and waits for the running ones */
+  ~BglReadAhead();
+
+  BglReadAhead(const BglReadAhead& other) = delete;
+  BglReadAhead& operator=(const BglReadAhead& other) = delete;
+
+  /*
+   * Get the file for index in filepaths. Indexes have to be requested in ascending order.
+   * Blocks until the file is read and throws the exception of the reader if reading failed.
+   * The returned file is owned by this object and is deleted on the next call.
+   */
+  atools::fs::bgl::BglFile *next(int index);
+
+  /* Number of reader threads or 1 if files are read in the calling thread */
+  int getNumThreads() const
+  {
+    return numReaderThreads;
+  }
+
+private:
+  friend class BglReadAheadTask;
+
+  /* Result of one reader task */
+  struct ReadResult;
+
+  /* Start tasks for all files up to index plus the read ahead window */
+  void schedule(int index);
+
+  const atools::fs::NavDatabaseOptions *navOptions;
+  const atools::fs::scenery::SceneryArea& sceneryArea;
+  const QStringList& files;
+  QSet<atools::fs::bgl::section::SectionType> supportedSectionTypes;
+  atools::fs::bgl::NamelistPool *namelistPool;
+
+  /* Sequential mode */
+  std::unique_ptr<atools::fs::bgl::BglFile> currentFile;
+
+  /* Read ahead mode */
+  std::vector<std::unique_ptr<ReadResult> > results;
+  int numReaderThreads = 1, numScheduled = 0;
+  std::atomic_bool canceled;
+  QMutex mutex;
+  QWaitCondition doneCondition;
+  QThreadPool pool;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_BGLREADAHEAD_H
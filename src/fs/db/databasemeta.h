@@ -33,6 +33,9 @@ namespace fs {
 namespace db {
 
 const static QLatin1String PROPERTYNAME_MSFS_NAVIGRAPH_FOUND("NavigraphUpdate");
+
+/* Hash over all scenery files, their sizes and modification times plus options. Used for incremental compilation. */
+const static QLatin1String PROPERTYNAME_SCENERY_FINGERPRINT("SceneryFingerprint");
 /*
  * Maintains versions and load time for a navdatabases
  */
@@ -18,6 +18,9 @@
 #include "fs/db/datawriter.h"
 
 #include "fs/bgl/bglfile.h"
+#include "fs/bgl/nl/namelistpool.h"
+#include "fs/compileprofiler.h"
+#include "fs/db/bglreadahead.h"
 #include "fs/scenery/fileresolver.h"
 #include "fs/scenery/languagejson.h"
 #include "fs/scenery/materiallib.h"
@@ -57,6 +60,7 @@
 #include "atools.h"
 #include "fs/common/magdecreader.h"
 #include "settings/settings.h"
+#include "util/tracing.h"
 #include "exception.h"
 
 #include <QDebug>
@@ -67,6 +71,7 @@ namespace fs {
 namespace db {
 
 using bgl::BglFile;
+using bgl::NamelistPool;
 using atools::fs::common::MagDecReader;
 using atools::sql::SqlDatabase;
 using scenery::SceneryArea;
@@ -112,7 +117,16 @@ DataWriter::DataWriter(SqlDatabase& sqlDb, const NavDatabaseOptions& opts, atool
 
   boundaryWriter = new BoundaryWriter(db, *this);
 
+  // Navaid tables are not read while loading - buffer rows and flush after each file
+  waypointWriter->setBulkInsert(BULK_INSERT_ROWS);
+  airwaySegmentWriter->setBulkInsert(BULK_INSERT_ROWS);
+  vorWriter->setBulkInsert(BULK_INSERT_ROWS);
+  tacanWriter->setBulkInsert(BULK_INSERT_ROWS);
+  ndbWriter->setBulkInsert(BULK_INSERT_ROWS);
+  markerWriter->setBulkInsert(BULK_INSERT_ROWS);
+
   runwayIndex = new RunwayIndex();
+  namelistPool = new NamelistPool();
   magDecReader = new MagDecReader();
 }
 
@@ -181,6 +195,8 @@ void DataWriter::close()
   boundaryWriter = nullptr;
   delete runwayIndex;
   runwayIndex = nullptr;
+  delete namelistPool;
+  namelistPool = nullptr;
   delete magDecReader;
   magDecReader = nullptr;
 }
@@ -223,10 +239,13 @@ QString DataWriter::getLanguage(const QString& key)
 
 void DataWriter::writeSceneryArea(const SceneryArea& area)
 {
+  ATOOLS_TRACE_SPAN("compile", "DataWriter::writeSceneryArea");
+
   QStringList filepaths, filenames;
 
   // Get all BGL files in this scenery area
   atools::fs::scenery::FileResolver resolver(options);
+  resolver.setCache(fileResolverCache);
   resolver.getFiles(area, &filepaths, &filenames);
 
   if(sceneryErrors != nullptr)
@@ -238,6 +257,10 @@ void DataWriter::writeSceneryArea(const SceneryArea& area)
     // Write the scenery area metadata
     sceneryAreaWriter->writeOne(area);
 
+    // Read files ahead in background threads while writing to the database in this thread
+    BglReadAhead readAhead(&options, area, filepaths, SUPPORTED_SECTION_TYPES, options.getReaderThreads(),
+                           namelistPool);
+
     for(int i = 0; i < filepaths.size(); i++)
     {
       progressHandler->setNumFiles(numFiles);
@@ -259,10 +282,14 @@ void DataWriter::writeSceneryArea(const SceneryArea& area)
       try
       {
         // ================================================================================
-        // Read all records into a internal object tree (atools::fs::bgl namespace)
-        BglFile bglFile(&options);
-        bglFile.setSupportedSectionTypes(SUPPORTED_SECTION_TYPES);
-        bglFile.readFile(currentBglFilePath, area);
+        // Get all records read into a internal object tree (atools::fs::bgl namespace)
+        // Throws the exception caught while reading in the background
+        QElapsedTimer profileTimer;
+        profileTimer.start();
+        BglFile& bglFile = *readAhead.next(i);
+        profileTime("bgl read", profileTimer);
+        if(profiler != nullptr)
+          profiler->addBytesRead(bglFile.getFilesize());
 
         if(bglFile.hasContent() && bglFile.isValid())
         {
@@ -286,9 +313,11 @@ void DataWriter::writeSceneryArea(const SceneryArea& area)
           airportWriter->setNameLists(bglFile.getNamelists());
 
           // Write airport and all subrecords like runways, approaches, parking and so on
+          profileTimer.start();
           airportWriter->write(bglFile.getAirports());
 
           airportFileWriter->write(bglFile.getAirports());
+          profileTime("airport writer", profileTimer);
 
           // Ignore navaids from the Navigraph update
           if(!area.isMsfsNavigraphNavdata())
@@ -299,13 +328,19 @@ void DataWriter::writeSceneryArea(const SceneryArea& area)
             tacanWriter->write(bglFile.getTacans());
             ndbWriter->write(bglFile.getNdbs());
             markerWriter->write(bglFile.getMarker());
+            flushBulkInserts();
+            profileTime("navaid writer", profileTimer);
           }
 
           ilsWriter->write(bglFile.getIls());
+          profileTime("ils writer", profileTimer);
 
           if(!area.isMsfsNavigraphNavdata())
+          {
             // Ignore boundaries from the Navigraph update
             boundaryWriter->write(bglFile.getBoundaries());
+            profileTime("boundary writer", profileTimer);
+          }
 
           for(const atools::fs::bgl::Airport *ap : bglFile.getAirports())
             airportIdents.insert(ap->getIdent());
@@ -363,10 +398,34 @@ void DataWriter::writeSceneryArea(const SceneryArea& area)
           sceneryErrors->fileErrors.append({currentBglFilePath, QString(), 0});
       }
     }
+    // Rows might be left over if reading a file failed
+    flushBulkInserts();
+
+    // Apply all airport replacements of this area if delete processor runs in batch mode
+    airportWriter->flushDeletes();
     db.commit();
   }
 }
 
+void DataWriter::profileTime(const QString& phase, QElapsedTimer& timer)
+{
+  if(profiler != nullptr && profiler->isEnabled())
+  {
+    profiler->addTime(phase, timer.nsecsElapsed());
+    timer.start();
+  }
+}
+
+void DataWriter::flushBulkInserts()
+{
+  waypointWriter->flush();
+  airwaySegmentWriter->flush();
+  vorWriter->flush();
+  tacanWriter->flush();
+  ndbWriter->flush();
+  markerWriter->flush();
+}
+
 void DataWriter::readMagDeclBgl(const QString& fileScenery)
 {
   QString fileSettings = atools::buildPath({atools::settings::Settings::getPath(), "magdec.bgl"});
@@ -430,7 +489,10 @@ void DataWriter::readMagDeclBgl(const QString& fileScenery)
 
   if(!loaded)
   {
-    magDecReader->readFromWmm();
+    if(options.getSharedMagDecReader() != nullptr)
+      magDecReader->copyFrom(*options.getSharedMagDecReader());
+    else
+      magDecReader->readFromWmm();
     magDecReader->writeToTable(db);
     db.commit();
   }
@@ -449,6 +511,9 @@ void DataWriter::logResults()
                     << numBoundaries << " boundaries and "
                     << numWaypoints << " waypoints.";
   qInfo().nospace() << "Wrote " << numObjectsWritten << " objects.";
+
+  if(namelistPool != nullptr)
+    qInfo().nospace() << "Namelist pool " << namelistPool->size() << " distinct names.";
 }
 
 } // namespace writer
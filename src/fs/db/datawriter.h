@@ -24,6 +24,7 @@
 #include <QSet>
 #include <QString>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 namespace atools {
 namespace sql {
@@ -35,13 +36,18 @@ class Pos;
 namespace fs {
 class NavDatabaseOptions;
 class NavDatabaseErrors;
+class CompileProfiler;
 namespace common {
 class MagDecReader;
 }
+namespace bgl {
+class NamelistPool;
+}
 namespace scenery {
 class SceneryArea;
 class LanguageJson;
 class MaterialLib;
+class FileResolverCache;
 }
 class ProgressHandler;
 
@@ -133,6 +139,9 @@ public:
     return options;
   }
 
+  /* Write all rows buffered by navaid writers using bulk insert */
+  void flushBulkInserts();
+
   atools::fs::db::BglFileWriter *getBglFileWriter()
   {
     return bglFileWriter;
@@ -290,7 +299,22 @@ public:
     return db;
   }
 
+  /* Adds time for reading BGL files and for each writer to the current profiler phase if not null */
+  void setProfiler(atools::fs::CompileProfiler *value)
+  {
+    profiler = value;
+  }
+
+  /* Reuse directory listings from the counting pass if not null */
+  void setFileResolverCache(atools::fs::scenery::FileResolverCache *value)
+  {
+    fileResolverCache = value;
+  }
+
 private:
+  /* Add elapsed time to profiler phase and restart timer */
+  void profileTime(const QString& phase, QElapsedTimer& timer);
+
   int numFiles = 0, numNamelists = 0, numVors = 0, numIls = 0,
       numNdbs = 0, numMarker = 0, numWaypoints = 0, numBoundaries = 0, numObjectsWritten = 0;
   bool aborted = false;
@@ -337,11 +361,16 @@ private:
   atools::fs::db::BoundaryWriter *boundaryWriter = nullptr;
 
   atools::fs::db::RunwayIndex *runwayIndex = nullptr;
+
+  /* Namelist strings shared by all BGL files of the compilation */
+  atools::fs::bgl::NamelistPool *namelistPool = nullptr;
   atools::fs::common::MagDecReader *magDecReader = nullptr;
 
   const atools::fs::NavDatabaseOptions& options;
   const atools::fs::scenery::LanguageJson *languageIndex = nullptr;
   const atools::fs::scenery::MaterialLib *materialLib = nullptr, *materialLibScenery = nullptr;
+  atools::fs::CompileProfiler *profiler = nullptr;
+  atools::fs::scenery::FileResolverCache *fileResolverCache = nullptr;
 };
 
 } // namespace writer
@@ -79,15 +79,15 @@ void BoundaryWriter::writeObject(const Boundary *type)
   bind(":min_lonx", type->getMinPosition().getLonX());
   bind(":min_laty", type->getMinPosition().getLatY());
 
-  bind(":geometry", atools::fs::common::BinaryGeometry(fetchAirspaceLines(type)).writeToByteArray());
+  // Add simplified geometry for large airspaces to allow fast overview drawing
+  atools::fs::common::BinaryGeometry geometry(fetchAirspaceLines(type));
+  geometry.buildLevelsOfDetail();
+  bind(":geometry", geometry.writeToByteArray());
   executeStatement();
 }
 
 atools::geo::LineString BoundaryWriter::fetchAirspaceLines(const Boundary *type)
 {
-  // Related to full circle - 7.5° - number is checked in MapPainterAirspace::render()
-  const static int CIRCLE_SEGMENTS = 48;
-
   const QList<bgl::BoundarySegment>& segments = type->getSegments();
   LineString processedLines;
 
@@ -99,14 +99,14 @@ atools::geo::LineString BoundaryWriter::fetchAirspaceLines(const Boundary *type)
       // Origin needed later
       continue;
     else if(segment.getType() == bl::CIRCLE)
-      // Append line string build from circle parameters - one point every 5 degrees
-      processedLines.append(LineString(segments.at(i - 1).getPosition(), segment.getRadius(), CIRCLE_SEGMENTS));
+      // Append line string build from circle parameters - number of points depends on radius
+      processedLines.append(LineString::circle(segments.at(i - 1).getPosition(), segment.getRadius()));
     else if(segment.getType() == bl::ARC_CCW || segment.getType() == bl::ARC_CW)
       // Build an arc
-      processedLines.append(LineString(segments.at(i - 1).getPosition(),
-                                       segments.at(i - 2).getPosition(),
-                                       segments.at(i).getPosition(),
-                                       segment.getType() == bl::ARC_CW, CIRCLE_SEGMENTS));
+      processedLines.append(LineString::arc(segments.at(i - 1).getPosition(),
+                                            segments.at(i - 2).getPosition(),
+                                            segments.at(i).getPosition(),
+                                            segment.getType() == bl::ARC_CW));
     else
       processedLines.append(segment.getPosition());
   }
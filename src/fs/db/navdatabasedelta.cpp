@@ -0,0 +1,968 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/navdatabasedelta.h"
+
+#include "exception.h"
+#include "fs/db/apronmeshwriter.h"
+#include "fs/db/databasemeta.h"
+#include "fs/db/proceduregeometrywriter.h"
+#include "fs/db/routeedgewriter.h"
+#include "fs/db/taxigraphwriter.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "sql/sqlscript.h"
+#include "sql/sqltransaction.h"
+#include "sql/sqlutil.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSet>
+
+#include <functional>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlRecord;
+using atools::sql::SqlScript;
+using atools::sql::SqlTransaction;
+using atools::sql::SqlUtil;
+
+namespace {
+
+const quint32 MAGIC_NUMBER = 0x4E444C54; // "NDLT"
+const quint16 FILE_VERSION = 1;
+
+/* Column added by group queries which contains the group key */
+const QLatin1String GROUP_COLUMN("delta_group");
+
+/* Table matched row by row using natural key columns */
+struct KeyedTableSpec
+{
+  QString table;
+  QStringList keyColumns;
+};
+
+/* Order matters - referenced tables have to come first */
+const QVector<KeyedTableSpec> KEYED_TABLES({
+  {"airport", {"ident"}},
+  {"vor", {"ident", "region", "type"}},
+  {"ndb", {"ident", "region", "type"}},
+  {"waypoint", {"ident", "region", "type", "airport_ident"}},
+  {"marker", {"ident", "region", "type"}}
+});
+
+/* Member of a group. Query has to select all columns of the table first and the group key as delta_group. */
+struct GroupMemberSpec
+{
+  QString table, query;
+};
+
+struct GroupSpec
+{
+  QString name;
+  QVector<GroupMemberSpec> members;
+};
+
+/* Select all columns and the ident of the related airport or empty string */
+QString airportMemberQuery(const QString& table)
+{
+  return "select m.*, coalesce(a.ident, '') as delta_group from " + table + " m "
+         "left outer join airport a on m.airport_id = a.airport_id";
+}
+
+/* Order matters - tables referenced by internal references have to come first */
+const QVector<GroupSpec> GROUPS({
+  {"airport", {
+     {"runway_end", "select m.*, coalesce((select a.ident from runway r join airport a on r.airport_id = a.airport_id "
+                    "where r.primary_end_id = m.runway_end_id or r.secondary_end_id = m.runway_end_id), '') "
+                    "as delta_group from runway_end m"},
+     {"runway", airportMemberQuery("runway")},
+     {"ils", "select m.*, coalesce(m.loc_airport_ident, '') as delta_group from ils m"},
+     {"com", airportMemberQuery("com")},
+     {"start", airportMemberQuery("start")},
+     {"helipad", airportMemberQuery("helipad")},
+     {"parking", airportMemberQuery("parking")},
+     {"apron", airportMemberQuery("apron")},
+     {"taxi_path", airportMemberQuery("taxi_path")},
+     {"approach", airportMemberQuery("approach")},
+     {"transition", "select m.*, coalesce(a.ident, '') as delta_group from transition m "
+                    "join approach p on m.approach_id = p.approach_id "
+                    "left outer join airport a on p.airport_id = a.airport_id"},
+     {"approach_leg", "select m.*, coalesce(a.ident, '') as delta_group from approach_leg m "
+                      "join approach p on m.approach_id = p.approach_id "
+                      "left outer join airport a on p.airport_id = a.airport_id"},
+     {"transition_leg", "select m.*, coalesce(a.ident, '') as delta_group from transition_leg m "
+                        "join transition t on m.transition_id = t.transition_id "
+                        "join approach p on t.approach_id = p.approach_id "
+                        "left outer join airport a on p.airport_id = a.airport_id"},
+     {"airport_msa", airportMemberQuery("airport_msa")},
+     {"holding", airportMemberQuery("holding")}
+   }},
+  {"airway", {
+     {"airway", "select m.*, m.airway_name || '|' || coalesce(m.airway_type, '') as delta_group from airway m"}
+   }}
+});
+
+/* Small tables which are replaced as a whole including ids */
+const QStringList REPLACED_TABLES({"metadata", "bgl_file", "scenery_area", "boundary", "mora_grid", "magdecl"});
+
+/* Columns referring to keyed tables */
+const QHash<QString, QString> KEYED_REFS({
+  {"airport_id", "airport"},
+  {"from_waypoint_id", "waypoint"},
+  {"to_waypoint_id", "waypoint"}
+});
+
+/* Columns referring to tables in the same group */
+const QHash<QString, QString> INTERNAL_REFS({
+  {"primary_end_id", "runway_end"},
+  {"secondary_end_id", "runway_end"},
+  {"loc_runway_end_id", "runway_end"},
+  {"runway_end_id", "runway_end"},
+  {"approach_id", "approach"},
+  {"transition_id", "transition"},
+  {"start_id", "start"}
+});
+
+/* Type column values of nav_id to table. Others like runway end are not resolved. */
+const QHash<QString, QString> NAV_TYPE_TABLES({
+  {"V", "vor"},
+  {"N", "ndb"},
+  {"W", "waypoint"},
+  {"A", "airport"}
+});
+
+enum RefType
+{
+  REF_NONE,
+  REF_KEYED, /* Natural key of a keyed table */
+  REF_INTERNAL, /* Ordinal of the row in the same group */
+  REF_NAV /* Natural key of a keyed table given by type column */
+};
+
+struct ColumnRef
+{
+  RefType type = REF_NONE;
+  QString table;
+  int typeIndex = -1;
+};
+
+typedef QHash<QString, QHash<int, QString> > IdKeyMap;
+typedef QHash<QString, QHash<QString, int> > KeyIdMap;
+typedef QHash<QString, QHash<int, int> > OrdinalMap;
+
+QVector<ColumnRef> columnRefs(const QString& table, const QStringList& columns)
+{
+  QVector<ColumnRef> refs(columns.size());
+  for(int i = 0; i < columns.size(); i++)
+  {
+    const QString& col = columns.at(i);
+    ColumnRef& ref = refs[i];
+    if(KEYED_REFS.contains(col))
+    {
+      ref.type = REF_KEYED;
+      ref.table = KEYED_REFS.value(col);
+    }
+    else if(INTERNAL_REFS.contains(col))
+    {
+      ref.type = REF_INTERNAL;
+      ref.table = INTERNAL_REFS.value(col);
+    }
+    else if(col == "nav_id")
+    {
+      ref.type = REF_NAV;
+      ref.typeIndex = columns.indexOf(table == "waypoint" ? "type" : "nav_type");
+    }
+  }
+  return refs;
+}
+
+QString navRefTable(const ColumnRef& ref, const QVariantList& values)
+{
+  return ref.typeIndex != -1 ? NAV_TYPE_TABLES.value(values.at(ref.typeIndex).toString()) : QString();
+}
+
+/* Replace database ids in references with natural keys or group ordinals */
+QVariantList encodeRow(const QVariantList& values, const QVector<ColumnRef>& refs, const IdKeyMap& idToKey,
+                       const OrdinalMap& ordinals)
+{
+  QVariantList encoded(values);
+  for(int i = 0; i < refs.size(); i++)
+  {
+    const ColumnRef& ref = refs.at(i);
+    if(ref.type == REF_NONE || values.at(i).isNull())
+      continue;
+
+    QString table = ref.type == REF_NAV ? navRefTable(ref, values) : ref.table;
+    int id = values.at(i).toInt();
+    if(ref.type == REF_INTERNAL)
+    {
+      auto tableIt = ordinals.constFind(table);
+      int ordinal = tableIt != ordinals.constEnd() ? tableIt.value().value(id, -1) : -1;
+      encoded[i] = ordinal != -1 ? QVariant(ordinal) : QVariant();
+    }
+    else
+    {
+      QString key = idToKey.value(table).value(id);
+      encoded[i] = key.isEmpty() ? QVariant() : QVariant(key);
+    }
+  }
+  return encoded;
+}
+
+/* Replace natural keys and group ordinals with client database ids */
+QVariantList decodeRow(const QVariantList& values, const QVector<ColumnRef>& refs, const KeyIdMap& keyToId,
+                       const QHash<QString, QVector<int> >& groupIds)
+{
+  QVariantList decoded(values);
+  for(int i = 0; i < refs.size(); i++)
+  {
+    const ColumnRef& ref = refs.at(i);
+    if(ref.type == REF_NONE || values.at(i).isNull())
+      continue;
+
+    QString table = ref.type == REF_NAV ? navRefTable(ref, values) : ref.table;
+    int id = -1;
+    if(ref.type == REF_INTERNAL)
+      id = groupIds.value(table).value(values.at(i).toInt(), -1);
+    else
+      id = keyToId.value(table).value(values.at(i).toString(), -1);
+    decoded[i] = id != -1 ? QVariant(id) : QVariant();
+  }
+  return decoded;
+}
+
+QByteArray hashBytes(const QByteArray& bytes)
+{
+  return QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+}
+
+QByteArray rowHash(const QVariantList& values)
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  out << values;
+  return hashBytes(bytes);
+}
+
+/*
+ * Read all rows of a query where the first column is the primary key. Column delta_group is passed separately
+ * if present. columns is filled with all other column names.
+ */
+void readRows(const SqlDatabase *db, const QString& queryStr, QStringList& columns,
+              const std::function<void(int id, const QString& group, const QVariantList& values)>& func)
+{
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec(queryStr);
+
+  SqlRecord rec = query.record();
+  int groupIndex = rec.indexOf(GROUP_COLUMN);
+  QVector<int> valueIndexes;
+  columns.clear();
+  for(int i = 1; i < rec.count(); i++)
+  {
+    if(i != groupIndex)
+    {
+      columns.append(rec.fieldName(i));
+      valueIndexes.append(i);
+    }
+  }
+
+  QVariantList values;
+  while(query.next())
+  {
+    values.clear();
+    for(int index : valueIndexes)
+      values.append(query.value(index));
+    func(query.valueInt(0), groupIndex != -1 ? query.valueStr(groupIndex) : QString(), values);
+  }
+}
+
+/* Natural keys with ordinal suffix for duplicates in id order */
+QVector<std::pair<int, QString> > readKeys(const SqlDatabase *db, const KeyedTableSpec& spec)
+{
+  QVector<std::pair<int, QString> > keys;
+  QHash<QString, int> counts;
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec("select " + spec.table + "_id, " + spec.keyColumns.join(", ") + " from " + spec.table +
+             " order by " + spec.table + "_id");
+  while(query.next())
+  {
+    QStringList parts;
+    for(int i = 1; i <= spec.keyColumns.size(); i++)
+      parts.append(query.valueStr(i));
+    QString key = parts.join('|');
+
+    int& count = counts[key];
+    if(count > 0)
+      key += '#' + QString::number(count);
+    count++;
+    keys.append(std::make_pair(query.valueInt(0), key));
+  }
+  return keys;
+}
+
+IdKeyMap readIdToKeys(const SqlDatabase *db)
+{
+  IdKeyMap idToKey;
+  SqlUtil util(db);
+  for(const KeyedTableSpec& spec : KEYED_TABLES)
+  {
+    if(util.hasTable(spec.table))
+    {
+      QHash<int, QString>& map = idToKey[spec.table];
+      for(const std::pair<int, QString>& key : readKeys(db, spec))
+        map.insert(key.first, key.second);
+    }
+  }
+  return idToKey;
+}
+
+/* Rows of one group member table collected while scanning */
+struct MemberRows
+{
+  QString table;
+  QStringList columns, groupKeys;
+  QVector<QVariantList> rows;
+};
+
+/*
+ * Scan all member tables of a group. Fills hashes per group key if hashes is not null and collects the rows
+ * of the groups in collect if members is not null.
+ */
+void scanGroups(const SqlDatabase *db, const GroupSpec& spec, const QStringList& tables, const IdKeyMap& idToKey,
+                QHash<QString, QByteArray> *hashes, const QSet<QString>& collect, QVector<MemberRows> *members)
+{
+  OrdinalMap ordinals;
+  QHash<QString, int> counters;
+
+  for(const GroupMemberSpec& member : spec.members)
+  {
+    if(!tables.contains(member.table))
+      continue;
+
+    MemberRows memberRows;
+    memberRows.table = member.table;
+    QVector<ColumnRef> refs;
+    QHash<int, int>& tableOrdinals = ordinals[member.table];
+    char tableIndex = static_cast<char>(tables.indexOf(member.table));
+
+    readRows(db, member.query, memberRows.columns, [&](int id, const QString& group, const QVariantList& values) {
+      if(refs.isEmpty())
+        refs = columnRefs(member.table, memberRows.columns);
+
+      int& counter = counters[group + '\n' + member.table];
+      tableOrdinals.insert(id, counter++);
+
+      QVariantList encoded = encodeRow(values, refs, idToKey, ordinals);
+      if(hashes != nullptr)
+      {
+        QByteArray& hash = (*hashes)[group];
+        hash = hashBytes(hash + tableIndex + rowHash(encoded));
+      }
+
+      if(members != nullptr && collect.contains(group))
+      {
+        memberRows.rows.append(encoded);
+        memberRows.groupKeys.append(group);
+      }
+    });
+
+    if(members != nullptr)
+      members->append(memberRows);
+  }
+}
+
+QByteArray tableHash(const SqlDatabase *db, const QString& table, QStringList *columns,
+                     QVector<QVariantList> *rows)
+{
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec("select * from " + table);
+  SqlRecord rec = query.record();
+  if(columns != nullptr)
+  {
+    for(int i = 0; i < rec.count(); i++)
+      columns->append(rec.fieldName(i));
+  }
+
+  QByteArray hash;
+  while(query.next())
+  {
+    QVariantList values;
+    for(int i = 0; i < rec.count(); i++)
+      values.append(query.value(i));
+    hash = hashBytes(hash + rowHash(values));
+    if(rows != nullptr)
+      rows->append(values);
+  }
+  return hash;
+}
+
+QString insertStatement(const QString& table, const QStringList& columns)
+{
+  return "insert into " + table + " (" + columns.join(", ") + ") values (" +
+         QString("?, ").repeated(columns.size() - 1) + "?)";
+}
+
+void bindValues(SqlQuery& query, const QVariantList& values)
+{
+  for(int i = 0; i < values.size(); i++)
+    query.bindValue(i, values.at(i));
+}
+
+} // namespace
+
+NavDatabaseDelta::NavDatabaseDelta()
+{
+
+}
+
+NavDatabaseDelta::~NavDatabaseDelta()
+{
+
+}
+
+void NavDatabaseDelta::create(SqlDatabase *oldDb, SqlDatabase *newDb)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+  fromCycle = DatabaseMeta(oldDb).getAiracCycle();
+  toCycle = DatabaseMeta(newDb).getAiracCycle();
+
+  SqlUtil oldUtil(oldDb), newUtil(newDb);
+  IdKeyMap oldIdToKey = readIdToKeys(oldDb), newIdToKey = readIdToKeys(newDb);
+  OrdinalMap noOrdinals;
+
+  // Keyed tables ========================================================
+  for(const KeyedTableSpec& spec : KEYED_TABLES)
+  {
+    if(!oldUtil.hasTable(spec.table) || !newUtil.hasTable(spec.table))
+      continue;
+
+    QString queryStr = "select * from " + spec.table + " order by " + spec.table + "_id";
+    QStringList columns;
+    QVector<ColumnRef> refs;
+
+    // Hash for each old row by key
+    QHash<QString, QByteArray> oldHashes;
+    const QHash<int, QString>& oldKeys = oldIdToKey.value(spec.table);
+    readRows(oldDb, queryStr, columns, [&](int id, const QString&, const QVariantList& values) {
+      if(refs.isEmpty())
+        refs = columnRefs(spec.table, columns);
+      oldHashes.insert(oldKeys.value(id), rowHash(encodeRow(values, refs, oldIdToKey, noOrdinals)));
+    });
+
+    TableDelta delta;
+    delta.table = spec.table;
+    refs.clear();
+    const QHash<int, QString>& newKeys = newIdToKey.value(spec.table);
+    readRows(newDb, queryStr, delta.columns, [&](int id, const QString&, const QVariantList& values) {
+      if(refs.isEmpty())
+        refs = columnRefs(spec.table, delta.columns);
+
+      QString key = newKeys.value(id);
+      QVariantList encoded = encodeRow(values, refs, newIdToKey, noOrdinals);
+      auto it = oldHashes.find(key);
+      if(it == oldHashes.end() || it.value() != rowHash(encoded))
+      {
+        delta.upsertKeys.append(key);
+        delta.upsertRows.append(encoded);
+        if(it == oldHashes.end())
+          stats.rowsInserted++;
+        else
+          stats.rowsUpdated++;
+      }
+
+      if(it != oldHashes.end())
+        oldHashes.erase(it);
+    });
+
+    // Remaining are not present in new database
+    delta.deletedKeys = oldHashes.keys();
+    stats.rowsDeleted += delta.deletedKeys.size();
+
+    if(!delta.upsertKeys.isEmpty() || !delta.deletedKeys.isEmpty())
+      tableDeltas.append(delta);
+  }
+
+  // Groups ========================================================
+  for(const GroupSpec& spec : GROUPS)
+  {
+    QStringList tables;
+    for(const GroupMemberSpec& member : spec.members)
+    {
+      if(oldUtil.hasTable(member.table) && newUtil.hasTable(member.table))
+        tables.append(member.table);
+    }
+
+    if(tables.isEmpty())
+      continue;
+
+    QHash<QString, QByteArray> oldHashes, newHashes;
+    scanGroups(oldDb, spec, tables, oldIdToKey, &oldHashes, QSet<QString>(), nullptr);
+    scanGroups(newDb, spec, tables, newIdToKey, &newHashes, QSet<QString>(), nullptr);
+
+    GroupDelta delta;
+    delta.name = spec.name;
+    QSet<QString> changed;
+    for(auto it = newHashes.constBegin(); it != newHashes.constEnd(); ++it)
+    {
+      auto oldIt = oldHashes.constFind(it.key());
+      if(oldIt == oldHashes.constEnd() || oldIt.value() != it.value())
+      {
+        changed.insert(it.key());
+        if(oldIt != oldHashes.constEnd())
+          delta.deletedGroups.append(it.key());
+      }
+    }
+
+    for(auto it = oldHashes.constBegin(); it != oldHashes.constEnd(); ++it)
+    {
+      if(!newHashes.contains(it.key()))
+      {
+        delta.deletedGroups.append(it.key());
+        stats.groupsDeleted++;
+      }
+    }
+    stats.groupsReplaced += changed.size();
+
+    if(changed.isEmpty() && delta.deletedGroups.isEmpty())
+      continue;
+
+    // Second pass to collect rows of changed groups only
+    if(!changed.isEmpty())
+    {
+      QVector<MemberRows> members;
+      scanGroups(newDb, spec, tables, newIdToKey, nullptr, changed, &members);
+      for(const MemberRows& member : members)
+      {
+        GroupTableDelta table;
+        table.table = member.table;
+        table.columns = member.columns;
+        table.groupKeys = member.groupKeys;
+        table.rows = member.rows;
+        delta.tables.append(table);
+      }
+    }
+    groupDeltas.append(delta);
+  }
+
+  // Replaced tables ========================================================
+  for(const QString& table : REPLACED_TABLES)
+  {
+    if(!oldUtil.hasTable(table) || !newUtil.hasTable(table))
+      continue;
+
+    ReplacedTable replaced;
+    replaced.table = table;
+    if(tableHash(oldDb, table, nullptr, nullptr) != tableHash(newDb, table, &replaced.columns, &replaced.rows))
+    {
+      replacedTables.append(replaced);
+      stats.tablesReplaced++;
+    }
+  }
+
+  qInfo() << Q_FUNC_INFO << "Delta from" << fromCycle << "to" << toCycle
+          << "inserted" << stats.rowsInserted << "updated" << stats.rowsUpdated << "deleted" << stats.rowsDeleted
+          << "groups replaced" << stats.groupsReplaced << "groups deleted" << stats.groupsDeleted
+          << "tables replaced" << stats.tablesReplaced << "in" << timer.elapsed() << "ms";
+}
+
+void NavDatabaseDelta::apply(SqlDatabase *db, int numThreads) const
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QString clientCycle = DatabaseMeta(db).getAiracCycle();
+  if(!fromCycle.isEmpty() && clientCycle != fromCycle)
+    throw atools::Exception(tr("Delta is for AIRAC cycle %1 but database has cycle %2.").
+                            arg(fromCycle).arg(clientCycle));
+
+  stats = Stats();
+  SqlUtil util(db);
+
+  // Rolls back on exception
+  SqlTransaction transaction(db);
+
+  // Client ids for all keyed tables
+  KeyIdMap keyToId;
+  for(const KeyedTableSpec& spec : KEYED_TABLES)
+  {
+    if(util.hasTable(spec.table))
+    {
+      QHash<QString, int>& map = keyToId[spec.table];
+      for(const std::pair<int, QString>& key : readKeys(db, spec))
+        map.insert(key.second, key.first);
+    }
+  }
+
+  // Delete groups in reverse order of members to avoid dangling references ==========================
+  for(const GroupDelta& delta : groupDeltas)
+  {
+    const GroupSpec *spec = nullptr;
+    for(const GroupSpec& group : GROUPS)
+    {
+      if(group.name == delta.name)
+        spec = &group;
+    }
+
+    if(spec == nullptr || delta.deletedGroups.isEmpty())
+      continue;
+
+    QSet<QString> deleted;
+    for(const QString& group : delta.deletedGroups)
+      deleted.insert(group);
+
+    for(auto it = spec->members.crbegin(); it != spec->members.crend(); ++it)
+    {
+      if(!util.hasTable(it->table))
+        continue;
+
+      QVector<int> ids;
+      QStringList columns;
+      readRows(db, it->query, columns, [&](int id, const QString& group, const QVariantList&) {
+        if(deleted.contains(group))
+          ids.append(id);
+      });
+
+      SqlQuery deleteQuery(db);
+      deleteQuery.prepare("delete from " + it->table + " where " + it->table + "_id = ?");
+      for(int id : ids)
+      {
+        deleteQuery.bindValue(0, id);
+        deleteQuery.exec();
+      }
+    }
+  }
+
+  // Delete keyed rows in reverse order ==========================
+  for(auto it = tableDeltas.crbegin(); it != tableDeltas.crend(); ++it)
+  {
+    SqlQuery deleteQuery(db);
+    deleteQuery.prepare("delete from " + it->table + " where " + it->table + "_id = ?");
+    QHash<QString, int>& map = keyToId[it->table];
+    for(const QString& key : it->deletedKeys)
+    {
+      int id = map.take(key);
+      if(id > 0)
+      {
+        deleteQuery.bindValue(0, id);
+        deleteQuery.exec();
+        stats.rowsDeleted++;
+      }
+    }
+  }
+
+  // Update or insert keyed rows ==========================
+  const QHash<QString, QVector<int> > noGroupIds;
+  for(const TableDelta& delta : tableDeltas)
+  {
+    QVector<ColumnRef> refs = columnRefs(delta.table, delta.columns);
+    QStringList assignments;
+    for(const QString& col : delta.columns)
+      assignments.append(col + " = ?");
+
+    SqlQuery updateQuery(db), insertQuery(db);
+    updateQuery.prepare("update " + delta.table + " set " + assignments.join(", ") +
+                        " where " + delta.table + "_id = ?");
+    insertQuery.prepare(insertStatement(delta.table, delta.columns));
+
+    QHash<QString, int>& map = keyToId[delta.table];
+    for(int i = 0; i < delta.upsertKeys.size(); i++)
+    {
+      QVariantList values = decodeRow(delta.upsertRows.at(i), refs, keyToId, noGroupIds);
+      int id = map.value(delta.upsertKeys.at(i), -1);
+      if(id != -1)
+      {
+        bindValues(updateQuery, values);
+        updateQuery.bindValue(values.size(), id);
+        updateQuery.exec();
+        stats.rowsUpdated++;
+      }
+      else
+      {
+        bindValues(insertQuery, values);
+        insertQuery.exec();
+        map.insert(delta.upsertKeys.at(i), insertQuery.lastInsertId().toInt());
+        stats.rowsInserted++;
+      }
+    }
+  }
+
+  // Insert rows of replaced groups in member order ==========================
+  for(const GroupDelta& delta : groupDeltas)
+  {
+    // Client ids by group, table and ordinal
+    QHash<QString, QHash<QString, QVector<int> > > groupIds;
+    QSet<QString> groups;
+    for(const GroupTableDelta& table : delta.tables)
+    {
+      QVector<ColumnRef> refs = columnRefs(table.table, table.columns);
+      SqlQuery insertQuery(db);
+      insertQuery.prepare(insertStatement(table.table, table.columns));
+
+      for(int i = 0; i < table.rows.size(); i++)
+      {
+        const QString& group = table.groupKeys.at(i);
+        QHash<QString, QVector<int> >& ids = groupIds[group];
+        bindValues(insertQuery, decodeRow(table.rows.at(i), refs, keyToId, ids));
+        insertQuery.exec();
+        ids[table.table].append(insertQuery.lastInsertId().toInt());
+        groups.insert(group);
+      }
+    }
+    stats.groupsReplaced += groups.size();
+    for(const QString& group : delta.deletedGroups)
+    {
+      if(!groups.contains(group))
+        stats.groupsDeleted++;
+    }
+  }
+
+  // Replace small tables ==========================
+  for(const ReplacedTable& table : replacedTables)
+  {
+    if(!util.hasTable(table.table))
+      continue;
+
+    SqlQuery(db).exec("delete from " + table.table);
+    SqlQuery insertQuery(db);
+    insertQuery.prepare(insertStatement(table.table, table.columns));
+    for(const QVariantList& row : table.rows)
+    {
+      bindValues(insertQuery, row);
+      insertQuery.exec();
+    }
+    stats.tablesReplaced++;
+  }
+
+  recalculate(db, numThreads);
+  transaction.commit();
+
+  qInfo() << Q_FUNC_INFO << "Applied delta from" << fromCycle << "to" << toCycle
+          << "inserted" << stats.rowsInserted << "updated" << stats.rowsUpdated << "deleted" << stats.rowsDeleted
+          << "groups replaced" << stats.groupsReplaced << "groups deleted" << stats.groupsDeleted
+          << "tables replaced" << stats.tablesReplaced << "in" << timer.elapsed() << "ms";
+}
+
+void NavDatabaseDelta::recalculate(SqlDatabase *db, int numThreads) const
+{
+  QSet<QString> changed;
+  for(const TableDelta& delta : tableDeltas)
+    changed.insert(delta.table);
+  for(const GroupDelta& delta : groupDeltas)
+    changed.insert(delta.name);
+
+  bool navaids = changed.contains("vor") || changed.contains("ndb") || changed.contains("waypoint");
+  // Airport table or any airport related table like runways or procedures
+  bool airports = changed.contains("airport");
+  bool airways = changed.contains("airway");
+
+  SqlUtil util(db);
+  SqlScript script(db, true /* verbose */);
+
+  // Airway counts and nav ids of waypoints
+  if(navaids || airways || airports)
+    script.executeScript(":/atools/resources/sql/fs/db/update_wp_ids.sql");
+
+  if(navaids || airports)
+  {
+    script.executeScript(":/atools/resources/sql/fs/db/update_nav_ids.sql");
+    script.executeScript(":/atools/resources/sql/fs/db/populate_nav_search.sql");
+  }
+
+  // Route network is only present if enabled in the compiler options
+  if((navaids || airways) && util.hasTableAndRows("route_node_radio"))
+  {
+    script.executeScript(":/atools/resources/sql/fs/db/populate_route_node.sql");
+    RouteEdgeWriter(db, numThreads).run();
+    script.executeScript(":/atools/resources/sql/fs/db/populate_route_edge.sql");
+  }
+
+  if(airports && util.hasTable("procedure_geometry"))
+    ProcedureGeometryWriter(db, numThreads).run();
+
+  // Taxi graphs are only present if enabled in the compiler options
+  if(airports && util.hasTableAndRows("taxi_graph"))
+    TaxiGraphWriter(db, numThreads).run();
+
+  // Apron meshes are only present if enabled in the compiler options
+  if(airports && util.hasTableAndRows("apron_mesh"))
+    ApronMeshWriter(db, numThreads).run();
+
+  if(airports && util.hasTable("airport_medium"))
+    script.executeScript(":/atools/resources/sql/fs/db/finish_schema_airport.sql");
+}
+
+void NavDatabaseDelta::writeToFile(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(writeToBytes());
+    file.close();
+  }
+  else
+    throw atools::Exception(tr("Cannot write file \"%1\". Reason: %2").arg(filename).arg(file.errorString()));
+}
+
+void NavDatabaseDelta::readFromFile(const QString& filename)
+{
+  QFile file(filename);
+  if(file.open(QIODevice::ReadOnly))
+  {
+    readFromBytes(file.readAll());
+    file.close();
+  }
+  else
+    throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2").arg(filename).arg(file.errorString()));
+}
+
+QByteArray NavDatabaseDelta::writeToBytes() const
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  write(out);
+
+  QByteArray compressed;
+  QDataStream header(&compressed, QIODevice::WriteOnly);
+  header.setVersion(QDataStream::Qt_5_5);
+  header << MAGIC_NUMBER << FILE_VERSION << qCompress(bytes);
+  return compressed;
+}
+
+void NavDatabaseDelta::readFromBytes(const QByteArray& bytes)
+{
+  clear();
+
+  quint32 magic;
+  quint16 version;
+  QByteArray compressed;
+  QDataStream header(bytes);
+  header.setVersion(QDataStream::Qt_5_5);
+  header >> magic >> version;
+
+  if(magic != MAGIC_NUMBER)
+    throw atools::Exception(tr("Invalid magic number. Not a navdata delta file."));
+  if(version != FILE_VERSION)
+    throw atools::Exception(tr("Invalid version %1 of navdata delta file. Expected %2.").
+                            arg(version).arg(FILE_VERSION));
+
+  header >> compressed;
+  QByteArray uncompressed = qUncompress(compressed);
+  if(header.status() != QDataStream::Ok || uncompressed.isEmpty())
+    throw atools::Exception(tr("Navdata delta file is truncated or corrupt."));
+
+  QDataStream in(uncompressed);
+  in.setVersion(QDataStream::Qt_5_5);
+  read(in);
+
+  if(in.status() != QDataStream::Ok)
+    throw atools::Exception(tr("Navdata delta file is truncated or corrupt."));
+}
+
+void NavDatabaseDelta::write(QDataStream& out) const
+{
+  out << fromCycle << toCycle;
+
+  out << static_cast<quint32>(tableDeltas.size());
+  for(const TableDelta& delta : tableDeltas)
+    out << delta.table << delta.columns << delta.deletedKeys << delta.upsertKeys << delta.upsertRows;
+
+  out << static_cast<quint32>(groupDeltas.size());
+  for(const GroupDelta& delta : groupDeltas)
+  {
+    out << delta.name << delta.deletedGroups << static_cast<quint32>(delta.tables.size());
+    for(const GroupTableDelta& table : delta.tables)
+      out << table.table << table.columns << table.groupKeys << table.rows;
+  }
+
+  out << static_cast<quint32>(replacedTables.size());
+  for(const ReplacedTable& table : replacedTables)
+    out << table.table << table.columns << table.rows;
+}
+
+void NavDatabaseDelta::read(QDataStream& in)
+{
+  quint32 num;
+  in >> fromCycle >> toCycle;
+
+  in >> num;
+  for(quint32 i = 0; i < num && in.status() == QDataStream::Ok; i++)
+  {
+    TableDelta delta;
+    in >> delta.table >> delta.columns >> delta.deletedKeys >> delta.upsertKeys >> delta.upsertRows;
+    tableDeltas.append(delta);
+  }
+
+  in >> num;
+  for(quint32 i = 0; i < num && in.status() == QDataStream::Ok; i++)
+  {
+    GroupDelta delta;
+    quint32 numTables;
+    in >> delta.name >> delta.deletedGroups >> numTables;
+    for(quint32 j = 0; j < numTables && in.status() == QDataStream::Ok; j++)
+    {
+      GroupTableDelta table;
+      in >> table.table >> table.columns >> table.groupKeys >> table.rows;
+      delta.tables.append(table);
+    }
+    groupDeltas.append(delta);
+  }
+
+  in >> num;
+  for(quint32 i = 0; i < num && in.status() == QDataStream::Ok; i++)
+  {
+    ReplacedTable table;
+    in >> table.table >> table.columns >> table.rows;
+    replacedTables.append(table);
+  }
+}
+
+bool NavDatabaseDelta::isEmpty() const
+{
+  return tableDeltas.isEmpty() && groupDeltas.isEmpty() && replacedTables.isEmpty();
+}
+
+void NavDatabaseDelta::clear()
+{
+  fromCycle.clear();
+  toCycle.clear();
+  tableDeltas.clear();
+  groupDeltas.clear();
+  replacedTables.clear();
+  stats = Stats();
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
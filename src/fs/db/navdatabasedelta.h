@@ -0,0 +1,157 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_NAVDATABASEDELTA_H
+#define ATOOLS_FS_DB_NAVDATABASEDELTA_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QStringList>
+#include <QVariantList>
+#include <QVector>
+
+class QDataStream;
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Difference between two compiled navdata databases of consecutive AIRAC cycles which can be applied to a
+ * client database of the older cycle instead of downloading or compiling the full new database.
+ *
+ * Rows are matched by natural keys instead of database ids which change with every compilation:
+ * airport by ident, navaids and waypoints by ident, region and type. Duplicate keys get an ordinal suffix.
+ * References to other tables are stored as natural keys and resolved to client ids when applying.
+ *
+ * Airport related tables (runways, ILS, procedures, holdings, MSA, etc.) and airways are handled as groups
+ * by airport ident or airway name. A group is replaced as a whole if any of its rows changed which keeps
+ * internal references like runway ends or procedure legs consistent.
+ * Small tables like boundary, MORA grid and metadata are replaced completely if changed.
+ *
+ * Dependent data like waypoint airway counts, search tables, the route network and procedure geometry is
+ * recalculated after applying only if affected.
+ *
+ * Procedure and holding references to runway ends (nav_type "R") are not resolved and stored as null.
+ */
+class NavDatabaseDelta
+{
+  Q_DECLARE_TR_FUNCTIONS(NavDatabaseDelta)
+
+public:
+  struct Stats
+  {
+    int rowsInserted = 0, rowsUpdated = 0, rowsDeleted = 0, groupsReplaced = 0, groupsDeleted = 0,
+        tablesReplaced = 0;
+  };
+
+  NavDatabaseDelta();
+  ~NavDatabaseDelta();
+
+  /* Compare old and new database and fill this delta. Clears all previous content. */
+  void create(atools::sql::SqlDatabase *oldDb, atools::sql::SqlDatabase *newDb);
+
+  /*
+   * Apply delta to a database of the old cycle and recalculate dependent data.
+   * Runs in one transaction which is rolled back on error.
+   * numThreads: Used for route network and procedure geometry. 0 uses all cores.
+   * Throws atools::Exception if the client cycle does not match or on SQL errors.
+   */
+  void apply(atools::sql::SqlDatabase *db, int numThreads = 0) const;
+
+  /* Compressed binary format. Throws atools::Exception on error. */
+  void writeToFile(const QString& filename) const;
+  void readFromFile(const QString& filename);
+  QByteArray writeToBytes() const;
+  void readFromBytes(const QByteArray& bytes);
+
+  /* true if databases are equal */
+  bool isEmpty() const;
+  void clear();
+
+  /* AIRAC cycles from table metadata. Empty if not available. */
+  const QString& getFromCycle() const
+  {
+    return fromCycle;
+  }
+
+  const QString& getToCycle() const
+  {
+    return toCycle;
+  }
+
+  /* Number of changes for create() or, after apply(), changes done in the client database */
+  const Stats& getStats() const
+  {
+    return stats;
+  }
+
+private:
+  /* Changes for one table matched by natural key */
+  struct TableDelta
+  {
+    QString table;
+    QStringList columns;
+    QStringList deletedKeys, upsertKeys;
+    QVector<QVariantList> upsertRows;
+  };
+
+  /* Changed rows of one member table of a group */
+  struct GroupTableDelta
+  {
+    QString table;
+    QStringList columns;
+    QStringList groupKeys;
+    QVector<QVariantList> rows;
+  };
+
+  /* Groups which are deleted or replaced and all rows of replaced groups */
+  struct GroupDelta
+  {
+    QString name;
+    QStringList deletedGroups;
+    QVector<GroupTableDelta> tables;
+  };
+
+  /* Tables which are replaced as a whole including ids */
+  struct ReplacedTable
+  {
+    QString table;
+    QStringList columns;
+    QVector<QVariantList> rows;
+  };
+
+  void write(QDataStream& out) const;
+  void read(QDataStream& in);
+  void recalculate(atools::sql::SqlDatabase *db, int numThreads) const;
+
+  QString fromCycle, toCycle;
+  QVector<TableDelta> tableDeltas;
+  QVector<GroupDelta> groupDeltas;
+  QVector<ReplacedTable> replacedTables;
+  mutable Stats stats;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_NAVDATABASEDELTA_H
@@ -0,0 +1,360 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/navdatacache.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+using atools::util::IdentKey;
+using atools::util::IdentKeyPair;
+
+namespace atools {
+namespace fs {
+namespace db {
+
+template<typename TYPE>
+void NavDataCache::Table<TYPE>::build()
+{
+  std::sort(records.begin(), records.end(), [](const TYPE& rec1, const TYPE& rec2) -> bool {
+              return rec1.id < rec2.id;
+            });
+
+  identOrder.resize(records.size());
+  for(int i = 0; i < records.size(); i++)
+    identOrder[i] = i;
+
+  // Stable sort keeps id order for equal idents
+  std::stable_sort(identOrder.begin(), identOrder.end(), [this](int i1, int i2) -> bool {
+                     return records.at(i1).ident < records.at(i2).ident;
+                   });
+
+  identFirst.clear();
+  identFirst.reserve(records.size());
+  for(int i = 0; i < identOrder.size(); i++)
+  {
+    const IdentKey& ident = records.at(identOrder.at(i)).ident;
+    if(i == 0 || !(records.at(identOrder.at(i - 1)).ident == ident))
+      identFirst.insert(ident, i);
+  }
+}
+
+template<typename TYPE>
+void NavDataCache::Table<TYPE>::clear()
+{
+  records.clear();
+  identOrder.clear();
+  identFirst.clear();
+}
+
+NavDataCache::NavDataCache()
+{
+}
+
+NavDataCache::~NavDataCache()
+{
+}
+
+void NavDataCache::clear()
+{
+  airports.clear();
+  runwayEnds.clear();
+  ils.clear();
+  vors.clear();
+  ndbs.clear();
+  waypoints.clear();
+  airportIcaoIndex.clear();
+  runwayEndNameIndex.clear();
+  ilsRunwayIndex.clear();
+  runwayEndAirportOrder.clear();
+  loadedTypes = NAVCACHE_NONE;
+}
+
+qint64 NavDataCache::getMemoryUsage() const
+{
+  return airports.records.size() * Table<NavCacheAirport>::bytesPerRecord() +
+         runwayEnds.records.size() * Table<NavCacheRunwayEnd>::bytesPerRecord() +
+         ils.records.size() * Table<NavCacheIls>::bytesPerRecord() +
+         (vors.records.size() + ndbs.records.size() + waypoints.records.size()) *
+         Table<NavCacheNavaid>::bytesPerRecord();
+}
+
+void NavDataCache::preload(sql::SqlDatabase *db, NavCacheTypes types, qint64 memoryBudgetBytes)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+
+  int numRows = 0;
+  if(types.testFlag(NAVCACHE_AIRPORT) &&
+     checkBudget(db, "airport", Table<NavCacheAirport>::bytesPerRecord(), memoryBudgetBytes, numRows))
+    loadAirports(db, numRows);
+
+  if(types.testFlag(NAVCACHE_RUNWAY_END) &&
+     checkBudget(db, "runway_end", Table<NavCacheRunwayEnd>::bytesPerRecord(), memoryBudgetBytes, numRows))
+    loadRunwayEnds(db, numRows);
+
+  if(types.testFlag(NAVCACHE_ILS) &&
+     checkBudget(db, "ils", Table<NavCacheIls>::bytesPerRecord(), memoryBudgetBytes, numRows))
+    loadIls(db, numRows);
+
+  if(types.testFlag(NAVCACHE_VOR) &&
+     checkBudget(db, "vor", Table<NavCacheNavaid>::bytesPerRecord(), memoryBudgetBytes, numRows))
+    loadNavaids(db, vors, NAVCACHE_VOR, numRows);
+
+  if(types.testFlag(NAVCACHE_NDB) &&
+     checkBudget(db, "ndb", Table<NavCacheNavaid>::bytesPerRecord(), memoryBudgetBytes, numRows))
+    loadNavaids(db, ndbs, NAVCACHE_NDB, numRows);
+
+  if(types.testFlag(NAVCACHE_WAYPOINT) &&
+     checkBudget(db, "waypoint", Table<NavCacheNavaid>::bytesPerRecord(), memoryBudgetBytes, numRows))
+    loadNavaids(db, waypoints, NAVCACHE_WAYPOINT, numRows);
+
+  qDebug() << Q_FUNC_INFO << "airports" << airports.records.size() << "runway ends" << runwayEnds.records.size()
+           << "ils" << ils.records.size() << "vor" << vors.records.size() << "ndb" << ndbs.records.size()
+           << "waypoints" << waypoints.records.size() << "memory" << getMemoryUsage() / 1024 << "kB"
+           << timer.elapsed() << "ms";
+}
+
+bool NavDataCache::checkBudget(sql::SqlDatabase *db, const QString& table, qint64 bytesPerRecord,
+                               qint64 memoryBudgetBytes, int& numRows) const
+{
+  numRows = 0;
+  SqlUtil util(db);
+  if(!util.hasTable(table))
+    return false;
+
+  numRows = util.rowCount(table);
+  if(memoryBudgetBytes > 0 && getMemoryUsage() + numRows * bytesPerRecord > memoryBudgetBytes)
+  {
+    qWarning() << Q_FUNC_INFO << "Skipping" << table << "rows" << numRows << "due to memory budget"
+               << memoryBudgetBytes;
+    return false;
+  }
+  return true;
+}
+
+void NavDataCache::loadAirports(sql::SqlDatabase *db, int numRows)
+{
+  airports.records.reserve(numRows);
+
+  SqlQuery query("select airport_id, ident, icao, region, lonx, laty, altitude, mag_var, longest_runway_length "
+                 "from airport", db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+    airports.records.append({query.valueInt(0), IdentKey(query.valueStr(1)), IdentKey(query.valueStr(2)),
+                             IdentKey(query.valueStr(3)), query.valueFloat(4), query.valueFloat(5),
+                             query.valueFloat(6), query.valueFloat(7), query.valueInt(8)});
+  airports.build();
+
+  airportIcaoIndex.reserve(airports.records.size());
+  for(int i = 0; i < airports.records.size(); i++)
+  {
+    const NavCacheAirport& airport = airports.records.at(i);
+    if(!airport.icao.isEmpty() && !airportIcaoIndex.contains(airport.icao))
+      airportIcaoIndex.insert(airport.icao, i);
+  }
+  loadedTypes |= NAVCACHE_AIRPORT;
+}
+
+void NavDataCache::loadRunwayEnds(sql::SqlDatabase *db, int numRows)
+{
+  runwayEnds.records.reserve(numRows);
+
+  // Primary and secondary ends in one scan of runway
+  SqlQuery query("select p.runway_end_id, r.airport_id, p.name, a.ident, p.lonx, p.laty, "
+                 "coalesce(p.altitude, r.altitude), p.heading, "
+                 "s.runway_end_id, s.name, s.lonx, s.laty, coalesce(s.altitude, r.altitude), s.heading "
+                 "from runway r "
+                 "join airport a on a.airport_id = r.airport_id "
+                 "join runway_end p on p.runway_end_id = r.primary_end_id "
+                 "join runway_end s on s.runway_end_id = r.secondary_end_id", db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+  {
+    int airportId = query.valueInt(1);
+    IdentKey airportIdent(query.valueStr(3));
+    runwayEnds.records.append({query.valueInt(0), airportId, IdentKey(query.valueStr(2)), airportIdent,
+                               query.valueFloat(4), query.valueFloat(5), query.valueFloat(6), query.valueFloat(7)});
+    runwayEnds.records.append({query.valueInt(8), airportId, IdentKey(query.valueStr(9)), airportIdent,
+                               query.valueFloat(10), query.valueFloat(11), query.valueFloat(12),
+                               query.valueFloat(13)});
+  }
+  runwayEnds.build();
+
+  runwayEndNameIndex.reserve(runwayEnds.records.size());
+  runwayEndAirportOrder.resize(runwayEnds.records.size());
+  for(int i = 0; i < runwayEnds.records.size(); i++)
+  {
+    const NavCacheRunwayEnd& end = runwayEnds.records.at(i);
+    runwayEndNameIndex.insert(IdentKeyPair(end.airportIdent, end.ident), i);
+    runwayEndAirportOrder[i] = i;
+  }
+
+  // Stable sort keeps id order for each airport
+  std::stable_sort(runwayEndAirportOrder.begin(), runwayEndAirportOrder.end(), [this](int i1, int i2) -> bool {
+                     return runwayEnds.records.at(i1).airportId < runwayEnds.records.at(i2).airportId;
+                   });
+  loadedTypes |= NAVCACHE_RUNWAY_END;
+}
+
+void NavDataCache::loadIls(sql::SqlDatabase *db, int numRows)
+{
+  ils.records.reserve(numRows);
+
+  SqlQuery query("select ils_id, loc_runway_end_id, ident, region, loc_airport_ident, loc_runway_name, "
+                 "lonx, laty, altitude, loc_heading, gs_pitch, mag_var, frequency from ils", db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+    ils.records.append({query.valueInt(0), query.isNull(1) ? -1 : query.valueInt(1), IdentKey(query.valueStr(2)),
+                        IdentKey(query.valueStr(3)), IdentKey(query.valueStr(4)), IdentKey(query.valueStr(5)),
+                        query.valueFloat(6), query.valueFloat(7), query.valueFloat(8), query.valueFloat(9),
+                        query.valueFloat(10), query.valueFloat(11), query.valueInt(12)});
+  ils.build();
+
+  ilsRunwayIndex.reserve(ils.records.size());
+  for(int i = 0; i < ils.records.size(); i++)
+  {
+    const NavCacheIls& rec = ils.records.at(i);
+    IdentKeyPair key(rec.airportIdent, rec.runwayName);
+    if(!rec.runwayName.isEmpty() && !ilsRunwayIndex.contains(key))
+      ilsRunwayIndex.insert(key, i);
+  }
+  loadedTypes |= NAVCACHE_ILS;
+}
+
+void NavDataCache::loadNavaids(sql::SqlDatabase *db, Table<NavCacheNavaid>& table, NavCacheType type, int numRows)
+{
+  table.records.reserve(numRows);
+
+  QString queryStr;
+  if(type == NAVCACHE_VOR)
+    queryStr = "select vor_id, ident, region, lonx, laty, mag_var, frequency from vor";
+  else if(type == NAVCACHE_NDB)
+    queryStr = "select ndb_id, ident, region, lonx, laty, mag_var, frequency from ndb";
+  else
+    queryStr = "select waypoint_id, ident, region, lonx, laty, mag_var, 0 from waypoint";
+
+  SqlQuery query(queryStr, db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+    table.records.append({query.valueInt(0), type, IdentKey(query.valueStr(1)), IdentKey(query.valueStr(2)),
+                          query.valueFloat(3), query.valueFloat(4), query.valueFloat(5), query.valueInt(6)});
+  table.build();
+  loadedTypes |= type;
+}
+
+const NavCacheAirport *NavDataCache::getAirportByIdent(const QString& ident) const
+{
+  IdentKey key(ident);
+  const NavCacheAirport *airport = airports.firstByIdent(key);
+  if(airport == nullptr)
+  {
+    const int *index = airportIcaoIndex.find(key);
+    if(index != nullptr)
+      airport = &airports.records.at(*index);
+  }
+  return airport;
+}
+
+geo::Pos NavDataCache::getAirportPos(const QString& ident) const
+{
+  const NavCacheAirport *airport = getAirportByIdent(ident);
+  return airport != nullptr ? airport->getPosition() : atools::geo::EMPTY_POS;
+}
+
+std::function<geo::Pos(const QString&)> NavDataCache::getAirportCoordsFunc() const
+{
+  return [this](const QString& ident) -> atools::geo::Pos {
+           return getAirportPos(ident);
+         };
+}
+
+const NavCacheRunwayEnd *NavDataCache::getRunwayEnd(const QString& airportIdent, const QString& runwayName) const
+{
+  const int *index = runwayEndNameIndex.find(IdentKeyPair(airportIdent, runwayName));
+  return index != nullptr ? &runwayEnds.records.at(*index) : nullptr;
+}
+
+void NavDataCache::getRunwayEnds(QVector<const NavCacheRunwayEnd *>& ends, int airportId) const
+{
+  ends.clear();
+  auto it = std::lower_bound(runwayEndAirportOrder.constBegin(), runwayEndAirportOrder.constEnd(), airportId,
+                             [this](int index, int id) -> bool {
+                return runwayEnds.records.at(index).airportId < id;
+              });
+
+  for(; it != runwayEndAirportOrder.constEnd() && runwayEnds.records.at(*it).airportId == airportId; ++it)
+    ends.append(&runwayEnds.records.at(*it));
+}
+
+void NavDataCache::getIls(QVector<const NavCacheIls *>& result, const QString& ident, const QString& region) const
+{
+  result.clear();
+  ils.byIdent(result, IdentKey(ident));
+
+  if(!region.isEmpty())
+  {
+    IdentKey regionKey(region);
+    result.erase(std::remove_if(result.begin(), result.end(), [&regionKey](const NavCacheIls *rec) -> bool {
+                                  return !(rec->region == regionKey);
+                                }), result.end());
+  }
+}
+
+const NavCacheIls *NavDataCache::getIlsForRunway(const QString& airportIdent, const QString& runwayName) const
+{
+  const int *index = ilsRunwayIndex.find(IdentKeyPair(airportIdent, runwayName));
+  return index != nullptr ? &ils.records.at(*index) : nullptr;
+}
+
+void NavDataCache::getNavaids(QVector<const NavCacheNavaid *>& result, const QString& ident, const QString& region,
+                              NavCacheTypes types) const
+{
+  result.clear();
+  IdentKey identKey(ident);
+
+  if(types.testFlag(NAVCACHE_VOR))
+    vors.byIdent(result, identKey);
+  if(types.testFlag(NAVCACHE_NDB))
+    ndbs.byIdent(result, identKey);
+  if(types.testFlag(NAVCACHE_WAYPOINT))
+    waypoints.byIdent(result, identKey);
+
+  if(!region.isEmpty())
+  {
+    IdentKey regionKey(region);
+    result.erase(std::remove_if(result.begin(), result.end(), [&regionKey](const NavCacheNavaid *rec) -> bool {
+                                  return !(rec->region == regionKey);
+                                }), result.end());
+  }
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
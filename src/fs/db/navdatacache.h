@@ -0,0 +1,302 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_NAVDATACACHE_H
+#define ATOOLS_FS_DB_NAVDATACACHE_H
+
+#include "geo/pos.h"
+#include "util/identkey.h"
+#include "util/openhash.h"
+
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/* Types of records in the navdata cache */
+enum NavCacheType
+{
+  NAVCACHE_NONE = 0,
+  NAVCACHE_AIRPORT = 1 << 0,
+  NAVCACHE_RUNWAY_END = 1 << 1,
+  NAVCACHE_ILS = 1 << 2,
+  NAVCACHE_VOR = 1 << 3,
+  NAVCACHE_NDB = 1 << 4,
+  NAVCACHE_WAYPOINT = 1 << 5,
+  NAVCACHE_NAVAIDS = NAVCACHE_VOR | NAVCACHE_NDB | NAVCACHE_WAYPOINT,
+  NAVCACHE_ALL = NAVCACHE_AIRPORT | NAVCACHE_RUNWAY_END | NAVCACHE_ILS | NAVCACHE_NAVAIDS
+};
+
+Q_DECLARE_FLAGS(NavCacheTypes, NavCacheType);
+Q_DECLARE_OPERATORS_FOR_FLAGS(atools::fs::db::NavCacheTypes);
+
+/* Airport from table airport. Ident is the internal ident which can differ from ICAO for X-Plane. */
+struct NavCacheAirport
+{
+  int id;
+  atools::util::IdentKey ident, icao, region;
+  float lonX, latY, altitudeFt, magVar;
+  int longestRunwayLengthFt;
+
+  atools::geo::Pos getPosition() const
+  {
+    return atools::geo::Pos(lonX, latY, altitudeFt);
+  }
+
+};
+
+/* Runway end with airport reference. ident is the runway name like "24L". */
+struct NavCacheRunwayEnd
+{
+  int id, airportId;
+  atools::util::IdentKey ident, airportIdent;
+  float lonX, latY, altitudeFt, headingTrue;
+
+  atools::geo::Pos getPosition() const
+  {
+    return atools::geo::Pos(lonX, latY, altitudeFt);
+  }
+
+};
+
+/* VOR, NDB or waypoint. Frequency is MHz * 1000 for VOR, kHz * 100 for NDB and 0 for waypoints. */
+struct NavCacheNavaid
+{
+  int id;
+  NavCacheType type;
+  atools::util::IdentKey ident, region;
+  float lonX, latY, magVar;
+  int frequency;
+
+  atools::geo::Pos getPosition() const
+  {
+    return atools::geo::Pos(lonX, latY);
+  }
+
+};
+
+/* ILS, localizer and similar approach aids from table ils */
+struct NavCacheIls
+{
+  int id, runwayEndId;
+  atools::util::IdentKey ident, region, airportIdent, runwayName;
+  float lonX, latY, altitudeFt, headingTrue, gsPitch, magVar;
+  int frequency;
+
+  atools::geo::Pos getPosition() const
+  {
+    return atools::geo::Pos(lonX, latY, altitudeFt);
+  }
+
+};
+
+/*
+ * Read-only in-memory cache for the most frequently used records of a compiled navdata database.
+ *
+ * All records are loaded at once by preload() using one full table scan each and are immutable afterwards.
+ * This avoids the many small SqlQuery lookups by id and ident done by flight plan loaders, routing and
+ * weather station lookups.
+ *
+ * Records are kept in flat vectors sorted by id. Lookups by id use binary search and lookups by ident
+ * an OpenHash keyed by packed IdentKey. Idents longer than IdentKey::MAX_LENGTH characters are truncated.
+ *
+ * A memory budget can be given to preload(). Types are loaded in the order airports, runway ends, ILS, VOR, NDB
+ * and waypoints and a type is skipped if it would exceed the budget. Use isLoaded() to check if a type is
+ * available and fall back to SQL queries if not.
+ *
+ * Query methods are const and can be called from several threads after preload() is done.
+ * Returned pointers are valid until the next call of preload() or clear().
+ */
+class NavDataCache
+{
+public:
+  NavDataCache();
+  ~NavDataCache();
+
+  NavDataCache(const NavDataCache& other) = delete;
+  NavDataCache& operator=(const NavDataCache& other) = delete;
+
+  /* Clear cache and load the given types from database.
+   * memoryBudgetBytes: Maximum estimated memory for all records and indexes. 0 means unlimited. */
+  void preload(atools::sql::SqlDatabase *db, atools::fs::db::NavCacheTypes types = NAVCACHE_ALL,
+               qint64 memoryBudgetBytes = 0);
+
+  void clear();
+
+  /* true if the records of the given type are in the cache */
+  bool isLoaded(atools::fs::db::NavCacheType type) const
+  {
+    return loadedTypes.testFlag(type);
+  }
+
+  atools::fs::db::NavCacheTypes getLoadedTypes() const
+  {
+    return loadedTypes;
+  }
+
+  /* Estimated memory used by records and indexes in bytes */
+  qint64 getMemoryUsage() const;
+
+  /* Airports ============================================================ */
+  /* Null if not found */
+  const NavCacheAirport *getAirportById(int id) const
+  {
+    return airports.byId(id);
+  }
+
+  /* Lookup by internal ident and then ICAO. Null if not found. */
+  const NavCacheAirport *getAirportByIdent(const QString& ident) const;
+
+  /* Airport position or invalid position if not found */
+  atools::geo::Pos getAirportPos(const QString& ident) const;
+
+  /* Function for the fetchAirportCoords callbacks of readers. Cache has to stay alive while using the function. */
+  std::function<atools::geo::Pos(const QString&)> getAirportCoordsFunc() const;
+
+  /* Runway ends ============================================================ */
+  const NavCacheRunwayEnd *getRunwayEndById(int id) const
+  {
+    return runwayEnds.byId(id);
+  }
+
+  /* Null if not found */
+  const NavCacheRunwayEnd *getRunwayEnd(const QString& airportIdent, const QString& runwayName) const;
+
+  /* All runway ends of airport */
+  void getRunwayEnds(QVector<const NavCacheRunwayEnd *>& ends, int airportId) const;
+
+  /* ILS ============================================================ */
+  const NavCacheIls *getIlsById(int id) const
+  {
+    return ils.byId(id);
+  }
+
+  /* All ILS with ident. Optionally filtered by region if not empty. */
+  void getIls(QVector<const NavCacheIls *>& result, const QString& ident, const QString& region = QString()) const;
+
+  /* ILS for runway end or null if not found */
+  const NavCacheIls *getIlsForRunway(const QString& airportIdent, const QString& runwayName) const;
+
+  /* VOR, NDB and waypoints ============================================================ */
+  const NavCacheNavaid *getVorById(int id) const
+  {
+    return vors.byId(id);
+  }
+
+  const NavCacheNavaid *getNdbById(int id) const
+  {
+    return ndbs.byId(id);
+  }
+
+  const NavCacheNavaid *getWaypointById(int id) const
+  {
+    return waypoints.byId(id);
+  }
+
+  /* Get all navaids with ident and optionally matching region. Result is sorted by type and id. */
+  void getNavaids(QVector<const NavCacheNavaid *>& result, const QString& ident, const QString& region = QString(),
+                  atools::fs::db::NavCacheTypes types = NAVCACHE_NAVAIDS) const;
+
+private:
+  /* Records sorted by id with an index for ident. TYPE needs the members id and ident. */
+  template<typename TYPE>
+  struct Table
+  {
+    const TYPE *byId(int id) const
+    {
+      auto it = std::lower_bound(records.constBegin(), records.constEnd(), id,
+                                 [](const TYPE& rec, int recId) -> bool {
+                return rec.id < recId;
+              });
+      return it != records.constEnd() && it->id == id ? &(*it) : nullptr;
+    }
+
+    /* Append all records with ident to result */
+    void byIdent(QVector<const TYPE *>& result, const atools::util::IdentKey& ident) const
+    {
+      const int *first = identFirst.find(ident);
+      if(first != nullptr)
+      {
+        for(int i = *first; i < identOrder.size() && records.at(identOrder.at(i)).ident == ident; i++)
+          result.append(&records.at(identOrder.at(i)));
+      }
+    }
+
+    /* First record with ident or null */
+    const TYPE *firstByIdent(const atools::util::IdentKey& ident) const
+    {
+      const int *first = identFirst.find(ident);
+      return first != nullptr ? &records.at(identOrder.at(*first)) : nullptr;
+    }
+
+    /* Sort records by id and build ident index */
+    void build();
+    void clear();
+
+    /* Estimated bytes per record including indexes */
+    static qint64 bytesPerRecord()
+    {
+      return static_cast<qint64>(sizeof(TYPE)) + 4 + 2 * (8 + 4 + 1);
+    }
+
+    QVector<TYPE> records;
+
+    /* Record indexes sorted by ident and id */
+    QVector<int> identOrder;
+
+    /* Ident to first position in identOrder */
+    atools::util::OpenHash<atools::util::IdentKey, int> identFirst;
+  };
+
+  /* Check remaining budget and get number of rows. Returns false if the table should be skipped. */
+  bool checkBudget(atools::sql::SqlDatabase *db, const QString& table, qint64 bytesPerRecord, qint64 memoryBudgetBytes,
+                   int& numRows) const;
+
+  void loadAirports(atools::sql::SqlDatabase *db, int numRows);
+  void loadRunwayEnds(atools::sql::SqlDatabase *db, int numRows);
+  void loadIls(atools::sql::SqlDatabase *db, int numRows);
+  void loadNavaids(atools::sql::SqlDatabase *db, Table<NavCacheNavaid>& table, atools::fs::db::NavCacheType type,
+                   int numRows);
+
+  Table<NavCacheAirport> airports;
+  Table<NavCacheRunwayEnd> runwayEnds;
+  Table<NavCacheIls> ils;
+  Table<NavCacheNavaid> vors, ndbs, waypoints;
+
+  /* Secondary indexes */
+  atools::util::OpenHash<atools::util::IdentKey, int> airportIcaoIndex;
+  atools::util::OpenHash<atools::util::IdentKeyPair, int> runwayEndNameIndex, ilsRunwayIndex;
+
+  /* Runway end indexes sorted by airport id and id */
+  QVector<int> runwayEndAirportOrder;
+
+  atools::fs::db::NavCacheTypes loadedTypes = NAVCACHE_NONE;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_NAVDATACACHE_H
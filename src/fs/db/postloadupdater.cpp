@@ -0,0 +1,317 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/postloadupdater.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+#include "util/parallel.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+
+#include <cmath>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+
+/* Same tolerances as in the scripts using manhattan distance in degree */
+const double MAX_WAYPOINT_NAVAID_DIST_DEG = 0.01;
+const double MAX_ILS_RUNWAY_END_DIST_DEG = 0.5;
+
+namespace {
+
+/* VOR, NDB or runway end candidate for a hash join */
+struct Candidate
+{
+  int id;
+  double lonx, laty;
+};
+
+typedef QHash<QString, QVector<Candidate> > CandidateHash;
+
+/* Load candidates by key column expression in id order so the first match has the lowest id */
+CandidateHash loadCandidates(SqlDatabase *db, const QString& queryStr)
+{
+  CandidateHash candidates;
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec(queryStr);
+  while(query.next())
+  {
+    if(!query.isNull(1))
+      candidates[query.valueStr(1)].append(Candidate({query.valueInt(0), query.valueDouble(2), query.valueDouble(3)}));
+  }
+  return candidates;
+}
+
+/* Lowest id of all candidates closer than maxDist or -1 */
+int findCandidate(const CandidateHash& candidates, const QString& key, double lonx, double laty, double maxDist)
+{
+  auto it = candidates.constFind(key);
+  if(it != candidates.constEnd())
+  {
+    for(const Candidate& candidate : it.value())
+    {
+      if(std::abs(candidate.lonx - lonx) + std::abs(candidate.laty - laty) < maxDist)
+        return candidate.id;
+    }
+  }
+  return -1;
+}
+
+QVariant idOrNull(int id)
+{
+  return id != -1 ? QVariant(id) : QVariant();
+}
+
+/* Compare as text to avoid false changes between integer types */
+bool changed(const QVariant& oldValue, const QVariant& newValue)
+{
+  return oldValue.isNull() != newValue.isNull() || oldValue.toString() != newValue.toString();
+}
+
+} // namespace
+
+PostLoadUpdater::PostLoadUpdater(SqlDatabase *sqlDb, int numThreads)
+  : db(sqlDb), threads(numThreads)
+{
+
+}
+
+void PostLoadUpdater::updateWaypointIds()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  CandidateHash vors = loadCandidates(db, "select vor_id, ident || '|' || region, lonx, laty from vor order by vor_id");
+  CandidateHash ndbs = loadCandidates(db, "select ndb_id, ident || '|' || region, lonx, laty from ndb order by ndb_id");
+
+  // Count airways per waypoint - segments starting and ending at the same waypoint are counted once
+  QHash<int, std::pair<int, int> > airwayCounts;
+  SqlQuery airwayQuery(db);
+  airwayQuery.setForwardOnly(true);
+  airwayQuery.exec("select from_waypoint_id, to_waypoint_id, airway_type from airway");
+  while(airwayQuery.next())
+  {
+    QString type = airwayQuery.valueStr(2);
+    bool victor = type == "V" || type == "B", jet = type == "J" || type == "B";
+    int fromId = airwayQuery.valueInt(0), toId = airwayQuery.valueInt(1);
+    for(int id : {fromId, toId})
+    {
+      std::pair<int, int>& counts = airwayCounts[id];
+      counts.first += victor;
+      counts.second += jet;
+
+      if(fromId == toId)
+        break;
+    }
+  }
+
+  struct Waypoint
+  {
+    int id;
+    QString type, key;
+    double lonx, laty;
+    QVariant navId;
+    int numVictor, numJet;
+  };
+
+  QVector<Waypoint> waypoints;
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec("select waypoint_id, type, ident || '|' || region, lonx, laty, nav_id, "
+             "num_victor_airway, num_jet_airway from waypoint");
+  while(query.next())
+    waypoints.append(Waypoint({query.valueInt(0), query.valueStr(1), query.valueStr(2), query.valueDouble(3),
+                               query.valueDouble(4), query.value(5), query.valueInt(6), query.valueInt(7)}));
+  query.finish();
+
+  // Match VOR and NDB waypoints in parallel - hashes are read only
+  QVector<int> navIds(waypoints.size(), -1);
+  int *navIdsData = navIds.data();
+  atools::util::parallelFor(waypoints.size(), threads, [&waypoints, &vors, &ndbs, navIdsData](int begin, int end, int) {
+    for(int i = begin; i < end; i++)
+    {
+      const Waypoint& wp = waypoints.at(i);
+      if(wp.type == "V")
+        navIdsData[i] = findCandidate(vors, wp.key, wp.lonx, wp.laty, MAX_WAYPOINT_NAVAID_DIST_DEG);
+      else if(wp.type == "N")
+        navIdsData[i] = findCandidate(ndbs, wp.key, wp.lonx, wp.laty, MAX_WAYPOINT_NAVAID_DIST_DEG);
+    }
+  });
+
+  // Write back changed rows only
+  SqlQuery update(db);
+  update.prepare("update waypoint set nav_id = ?, num_victor_airway = ?, num_jet_airway = ? where waypoint_id = ?");
+  int updated = 0;
+  for(int i = 0; i < waypoints.size(); i++)
+  {
+    const Waypoint& wp = waypoints.at(i);
+    QVariant navId = wp.type == "V" || wp.type == "N" ? idOrNull(navIds.at(i)) : wp.navId;
+    std::pair<int, int> counts = airwayCounts.value(wp.id, std::make_pair(0, 0));
+
+    if(changed(wp.navId, navId) || wp.numVictor != counts.first || wp.numJet != counts.second)
+    {
+      update.bindValue(0, navId);
+      update.bindValue(1, counts.first);
+      update.bindValue(2, counts.second);
+      update.bindValue(3, wp.id);
+      update.exec();
+      updated++;
+    }
+  }
+
+  qDebug() << Q_FUNC_INFO << "Updated" << updated << "of" << waypoints.size() << "waypoints in"
+           << timer.elapsed() << "ms";
+}
+
+void PostLoadUpdater::updateNavaidAirportIds()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Lowest airport id for each ident
+  QHash<QString, int> airportIds;
+  SqlQuery airportQuery(db);
+  airportQuery.setForwardOnly(true);
+  airportQuery.exec("select airport_id, ident from airport order by airport_id");
+  while(airportQuery.next())
+  {
+    QString ident = airportQuery.valueStr(1);
+    if(!airportIds.contains(ident))
+      airportIds.insert(ident, airportQuery.valueInt(0));
+  }
+
+  for(const QString& table : {QString("waypoint"), QString("ndb"), QString("vor")})
+  {
+    SqlQuery update(db);
+    update.prepare("update " + table + " set airport_id = ? where " + table + "_id = ?");
+
+    SqlQuery query(db);
+    query.setForwardOnly(true);
+    query.exec("select " + table + "_id, airport_ident, airport_id from " + table);
+
+    // Collect first since SQLite does not allow to modify a table while reading
+    QVector<std::pair<int, QVariant> > changes;
+    while(query.next())
+    {
+      QVariant airportId = query.isNull(1) ? QVariant() : idOrNull(airportIds.value(query.valueStr(1), -1));
+      if(changed(query.value(2), airportId))
+        changes.append(std::make_pair(query.valueInt(0), airportId));
+    }
+    query.finish();
+
+    for(const std::pair<int, QVariant>& change : changes)
+    {
+      update.bindValue(0, change.second);
+      update.bindValue(1, change.first);
+      update.exec();
+    }
+    qDebug() << Q_FUNC_INFO << "Updated" << changes.size() << "in" << table;
+  }
+
+  qDebug() << Q_FUNC_INFO << timer.elapsed() << "ms";
+}
+
+void PostLoadUpdater::updateAirportIls()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  CandidateHash runwayEnds = loadCandidates(db, "select runway_end_id, ils_ident, lonx, laty "
+                                                "from runway_end order by runway_end_id");
+
+  QHash<int, QString> runwayEndNames;
+  SqlQuery endQuery(db);
+  endQuery.setForwardOnly(true);
+  endQuery.exec("select runway_end_id, name from runway_end");
+  while(endQuery.next())
+    runwayEndNames.insert(endQuery.valueInt(0), endQuery.valueStr(1));
+
+  // Airport ident for each runway end - the script uses a union which returns the lowest ident for duplicates
+  QHash<int, QString> runwayEndAirportIdents;
+  SqlQuery runwayQuery(db);
+  runwayQuery.setForwardOnly(true);
+  runwayQuery.exec("select r.primary_end_id, r.secondary_end_id, a.ident "
+                   "from runway r join airport a on a.airport_id = r.airport_id");
+  while(runwayQuery.next())
+  {
+    QString ident = runwayQuery.valueStr(2);
+    for(int endId : {runwayQuery.valueInt(0), runwayQuery.valueInt(1)})
+    {
+      auto it = runwayEndAirportIdents.find(endId);
+      if(it == runwayEndAirportIdents.end())
+        runwayEndAirportIdents.insert(endId, ident);
+      else if(ident < it.value())
+        it.value() = ident;
+    }
+  }
+
+  struct IlsUpdate
+  {
+    int id;
+    QVariant runwayEndId, airportIdent, runwayName;
+  };
+
+  QVector<IlsUpdate> changes;
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec("select ils_id, ident, lonx, laty, loc_runway_end_id, loc_airport_ident, loc_runway_name from ils");
+  while(query.next())
+  {
+    int endId = query.isNull(1) ? -1 : findCandidate(runwayEnds, query.valueStr(1), query.valueDouble(2),
+                                                     query.valueDouble(3), MAX_ILS_RUNWAY_END_DIST_DEG);
+    IlsUpdate ils;
+    ils.id = query.valueInt(0);
+    ils.runwayEndId = idOrNull(endId);
+    if(endId != -1)
+    {
+      if(runwayEndAirportIdents.contains(endId))
+        ils.airportIdent = runwayEndAirportIdents.value(endId);
+      ils.runwayName = runwayEndNames.value(endId);
+    }
+
+    if(changed(query.value(4), ils.runwayEndId) || changed(query.value(5), ils.airportIdent) ||
+       changed(query.value(6), ils.runwayName))
+      changes.append(ils);
+  }
+  query.finish();
+
+  SqlQuery update(db);
+  update.prepare("update ils set loc_runway_end_id = ?, loc_airport_ident = ?, loc_runway_name = ? where ils_id = ?");
+  for(const IlsUpdate& ils : changes)
+  {
+    update.bindValue(0, ils.runwayEndId);
+    update.bindValue(1, ils.airportIdent);
+    update.bindValue(2, ils.runwayName);
+    update.bindValue(3, ils.id);
+    update.exec();
+  }
+
+  qDebug() << Q_FUNC_INFO << "Updated" << changes.size() << "ILS in" << timer.elapsed() << "ms";
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,67 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_POSTLOADUPDATER_H
+#define ATOOLS_FS_DB_POSTLOADUPDATER_H
+
+#include <QCoreApplication>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Native replacements for the most expensive post-load SQL scripts which consist of correlated subqueries
+ * executed row by row by SQLite.
+ *
+ * Each method loads the involved tables once, joins them using hash tables in memory and writes back only
+ * rows which changed. Results are the same as for the scripts which are still used if the option
+ * NavDatabaseOptions::isSqlPostProcess() is set.
+ *
+ * Does not commit.
+ */
+class PostLoadUpdater
+{
+  Q_DECLARE_TR_FUNCTIONS(PostLoadUpdater)
+
+public:
+  /* numThreads: Threads used for matching waypoints. 0 uses all cores. */
+  PostLoadUpdater(atools::sql::SqlDatabase *sqlDb, int numThreads = 0);
+
+  /* Same as fs/db/update_wp_ids.sql. Sets VOR and NDB ids for waypoints and the airway counts. */
+  void updateWaypointIds();
+
+  /* Same as fs/db/update_nav_ids.sql. Sets airport ids for waypoints, NDB and VOR from the airport ident. */
+  void updateNavaidAirportIds();
+
+  /* Same as fs/db/update_airport_ils.sql. Sets runway end, airport ident and runway name for ILS. */
+  void updateAirportIls();
+
+private:
+  atools::sql::SqlDatabase *db;
+  int threads;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_POSTLOADUPDATER_H
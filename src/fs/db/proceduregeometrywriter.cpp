@@ -0,0 +1,356 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/proceduregeometrywriter.h"
+
+#include "fs/common/binarygeometry.h"
+#include "geo/calculations.h"
+#include "geo/linestring.h"
+#include "sql/sqlbulkinsert.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlQuery;
+using atools::geo::Pos;
+using atools::geo::LineString;
+using atools::geo::nmToMeter;
+using atools::geo::meterToNm;
+
+/* Length of legs which end at an altitude, intercept or manual termination */
+const float DEFAULT_LEG_DISTANCE_NM = 2.f;
+
+/* Speed used to convert hold leg time to distance and for the turn radius */
+const float HOLD_SPEED_KTS = 210.f;
+
+/* Hold leg time if neither distance nor time is given */
+const float DEFAULT_HOLD_TIME_MIN = 1.f;
+
+/* Size of one record in the leg_info blob */
+const int LEG_INFO_SIZE = 12;
+
+// Query result column indexes
+enum ColumnIndex
+{
+  LEG_ID, PROCEDURE_ID, AIRPORT_ID, MAG_VAR, IS_MISSED, TYPE, TURN_DIRECTION, FIX_LONX, FIX_LATY,
+  REC_FIX_LONX, REC_FIX_LATY, IS_TRUE_COURSE, COURSE, DISTANCE, TIME
+};
+
+/* Leg as loaded from approach_leg or transition_leg */
+struct Leg
+{
+  int id;
+  bool missed;
+  QString type, turnDirection;
+  Pos fix, recFix;
+  float courseTrue; // -1 if not available
+  float distanceNm, timeMin;
+};
+
+/* Approach or transition with legs */
+struct Procedure
+{
+  int airportId, approachId, transitionId;
+  QVector<Leg> legs;
+};
+
+/* Calculated geometry for one procedure */
+struct ProcedureResult
+{
+  float distanceNm = 0.f, missedDistanceNm = 0.f;
+  LineString geometry;
+  QByteArray legInfo;
+};
+
+/* Little endian float helpers for leg_info. memcpy avoids alignment and aliasing issues. */
+static inline float readFloatLe(const char *data)
+{
+  quint32 bits = qFromLittleEndian<quint32>(data);
+  float value;
+  std::memcpy(&value, &bits, sizeof(float));
+  return value;
+}
+
+static inline void writeFloatLe(float value, char *data)
+{
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  qToLittleEndian<quint32>(bits, data);
+}
+
+/* Append points and skip the first if it is equal to the last point */
+static void appendPoints(LineString& points, const LineString& line)
+{
+  for(const Pos& pos : line)
+  {
+    if(points.isEmpty() || !points.constLast().almostEqual(pos))
+      points.append(pos);
+  }
+}
+
+/* Racetrack pattern with inbound course towards fix */
+static void buildHold(LineString& points, const Pos& fix, float inboundCourse, bool right, float legDistMeter)
+{
+  float radiusMeter = nmToMeter(HOLD_SPEED_KTS / (60.f * static_cast<float>(M_PI)));
+  float side = right ? 90.f : -90.f;
+  float outboundCourse = atools::geo::opposedCourseDeg(inboundCourse);
+
+  Pos outboundStart = fix.endpoint(2.f * radiusMeter, inboundCourse + side).normalize();
+  Pos outboundEnd = outboundStart.endpoint(legDistMeter, outboundCourse).normalize();
+  Pos inboundStart = fix.endpoint(legDistMeter, outboundCourse).normalize();
+
+  appendPoints(points, LineString::arc(fix.endpoint(radiusMeter, inboundCourse + side).normalize(),
+                                       fix, outboundStart, right));
+  appendPoints(points, LineString::arc(inboundStart.endpoint(radiusMeter, inboundCourse + side).normalize(),
+                                       outboundEnd, inboundStart, right));
+  appendPoints(points, LineString(fix));
+}
+
+/* Append geometry for one leg and update lastPos */
+static void buildLeg(LineString& points, Pos& lastPos, const Leg& leg)
+{
+  const QString& type = leg.type;
+  bool hasCourse = leg.courseTrue >= 0.f;
+  float legDistMeter = nmToMeter(leg.distanceNm > 0.f ? leg.distanceNm : DEFAULT_LEG_DISTANCE_NM);
+
+  if(type == "AF" || type == "RF")
+  {
+    // Arc around navaid or center point - falls back to a straight line if center is missing
+    if(leg.recFix.isValid() && lastPos.isValid() && leg.fix.isValid())
+      appendPoints(points, LineString::arc(leg.recFix, lastPos, leg.fix, leg.turnDirection != "L"));
+    else if(leg.fix.isValid())
+      appendPoints(points, LineString(leg.fix));
+  }
+  else if(type == "HA" || type == "HF" || type == "HM")
+  {
+    Pos fix = leg.fix.isValid() ? leg.fix : lastPos;
+    if(fix.isValid() && hasCourse)
+    {
+      float holdTimeMin = leg.timeMin > 0.f ? leg.timeMin : DEFAULT_HOLD_TIME_MIN;
+      float holdDistMeter = nmToMeter(leg.distanceNm > 0.f ? leg.distanceNm : holdTimeMin * HOLD_SPEED_KTS / 60.f);
+      appendPoints(points, LineString(fix));
+      buildHold(points, fix, leg.courseTrue, leg.turnDirection != "L", holdDistMeter);
+    }
+    else if(fix.isValid())
+      appendPoints(points, LineString(fix));
+  }
+  else if(type == "PI")
+  {
+    // Procedure turn - approximated by flying outbound and back to the fix
+    if(leg.fix.isValid() && hasCourse)
+      appendPoints(points, LineString({leg.fix, leg.fix.endpoint(legDistMeter, leg.courseTrue).normalize(), leg.fix}));
+    else if(leg.fix.isValid())
+      appendPoints(points, LineString(leg.fix));
+  }
+  else if(type.startsWith('F'))
+  {
+    // From fix legs FA, FC, FD, FM
+    Pos start = leg.fix.isValid() ? leg.fix : lastPos;
+    if(start.isValid() && hasCourse)
+      appendPoints(points, LineString({start, start.endpoint(legDistMeter, leg.courseTrue).normalize()}));
+    else if(start.isValid())
+      appendPoints(points, LineString(start));
+  }
+  else if(leg.fix.isValid())
+    // IF, TF, CF, DF and all others having a fix
+    appendPoints(points, LineString(leg.fix));
+  else if(lastPos.isValid() && hasCourse)
+    // Course or heading legs without fix like CA, CI, CR, VA, VI, VM
+    appendPoints(points, LineString(lastPos.endpoint(legDistMeter, leg.courseTrue).normalize()));
+
+  if(!points.isEmpty())
+    lastPos = points.constLast();
+}
+
+/* Calculate geometry, distances and leg info for a procedure */
+static void buildProcedure(ProcedureResult& result, const Procedure& procedure)
+{
+  Pos lastPos;
+  result.legInfo.resize(procedure.legs.size() * LEG_INFO_SIZE);
+  char *data = result.legInfo.data();
+
+  for(const Leg& leg : procedure.legs)
+  {
+    // Leg starts at the last point of the previous leg
+    int firstPoint = std::max(result.geometry.size() - 1, 0);
+    buildLeg(result.geometry, lastPos, leg);
+
+    double distMeter = 0.;
+    for(int i = firstPoint + 1; i < result.geometry.size(); i++)
+      distMeter += static_cast<double>(result.geometry.at(i - 1).distanceMeterTo(result.geometry.at(i)));
+    float distNm = meterToNm(static_cast<float>(distMeter));
+
+    if(leg.missed)
+      result.missedDistanceNm += distNm;
+    else
+      result.distanceNm += distNm;
+
+    qToLittleEndian<qint32>(leg.id, data);
+    qToLittleEndian<qint32>(firstPoint, data + 4);
+    writeFloatLe(distNm, data + 8);
+    data += LEG_INFO_SIZE;
+  }
+}
+
+/* Load legs of all procedures sorted by airport */
+static void loadProcedures(QVector<Procedure>& procedures, atools::sql::SqlDatabase *db, bool transitions)
+{
+  QString queryStr;
+  if(transitions)
+    queryStr = "select l.transition_leg_id, l.transition_id, a.airport_id, p.mag_var, 0, l.type, l.turn_direction, "
+               "l.fix_lonx, l.fix_laty, l.recommended_fix_lonx, l.recommended_fix_laty, "
+               "l.is_true_course, l.course, l.distance, l.time "
+               "from transition_leg l "
+               "join transition t on t.transition_id = l.transition_id "
+               "join approach a on a.approach_id = t.approach_id "
+               "join airport p on p.airport_id = a.airport_id "
+               "order by a.airport_id, l.transition_id, l.transition_leg_id";
+  else
+    queryStr = "select l.approach_leg_id, l.approach_id, a.airport_id, p.mag_var, l.is_missed, l.type, "
+               "l.turn_direction, l.fix_lonx, l.fix_laty, l.recommended_fix_lonx, l.recommended_fix_laty, "
+               "l.is_true_course, l.course, l.distance, l.time "
+               "from approach_leg l "
+               "join approach a on a.approach_id = l.approach_id "
+               "join airport p on p.airport_id = a.airport_id "
+               "order by a.airport_id, l.approach_id, l.approach_leg_id";
+
+  SqlQuery query(queryStr, db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+  {
+    int procedureId = query.valueInt(PROCEDURE_ID);
+    int currentId = procedures.isEmpty() ? -1 :
+                    (transitions ? procedures.constLast().transitionId : procedures.constLast().approachId);
+
+    if(currentId != procedureId)
+      procedures.append({query.valueInt(AIRPORT_ID), transitions ? -1 : procedureId, transitions ? procedureId : -1,
+                         QVector<Leg>()});
+
+    Leg leg;
+    leg.id = query.valueInt(LEG_ID);
+    leg.missed = query.valueBool(IS_MISSED);
+    leg.type = query.valueStr(TYPE);
+    leg.turnDirection = query.valueStr(TURN_DIRECTION);
+
+    if(!query.isNull(FIX_LONX) && !query.isNull(FIX_LATY))
+      leg.fix = Pos(query.valueFloat(FIX_LONX), query.valueFloat(FIX_LATY));
+    if(!query.isNull(REC_FIX_LONX) && !query.isNull(REC_FIX_LATY))
+      leg.recFix = Pos(query.valueFloat(REC_FIX_LONX), query.valueFloat(REC_FIX_LATY));
+
+    leg.courseTrue = -1.f;
+    if(!query.isNull(COURSE))
+    {
+      float course = query.valueFloat(COURSE);
+      leg.courseTrue = query.valueBool(IS_TRUE_COURSE) ? course :
+                       atools::geo::normalizeCourse(course + query.valueFloat(MAG_VAR));
+    }
+    leg.distanceNm = query.valueFloat(DISTANCE);
+    leg.timeMin = query.valueFloat(TIME);
+
+    procedures.last().legs.append(leg);
+  }
+}
+
+ProcedureGeometryWriter::ProcedureGeometryWriter(atools::sql::SqlDatabase *sqlDb, int numThreads)
+  : db(sqlDb), threads(numThreads)
+{
+
+}
+
+void ProcedureGeometryWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QVector<Procedure> procedures;
+  loadProcedures(procedures, db, false /* transitions */);
+  loadProcedures(procedures, db, true /* transitions */);
+
+  // Clean the result table
+  SqlQuery stmt(db);
+  stmt.exec("delete from procedure_geometry");
+
+  // Index of first procedure for each airport to keep all procedures of an airport in one thread
+  QVector<int> airportStart;
+  for(int i = 0; i < procedures.size(); i++)
+  {
+    if(i == 0 || procedures.at(i).airportId != procedures.at(i - 1).airportId)
+      airportStart.append(i);
+  }
+  airportStart.append(procedures.size());
+
+  // Each thread writes only to the results of its airports
+  QVector<ProcedureResult> results(procedures.size());
+  ProcedureResult *resultsData = results.data();
+  atools::util::parallelFor(airportStart.size() - 1, threads,
+                            [&procedures, &airportStart, resultsData](int begin, int end, int) {
+    for(int airport = begin; airport < end; airport++)
+    {
+      for(int i = airportStart.at(airport); i < airportStart.at(airport + 1); i++)
+        buildProcedure(resultsData[i], procedures.at(i));
+    }
+  }, 100);
+
+  // Write all in one batch ==========================
+  atools::sql::SqlBulkInsert insert(db, "procedure_geometry",
+                                    {"airport_id", "approach_id", "transition_id", "distance", "missed_distance",
+                                     "geometry", "leg_info"});
+  for(int i = 0; i < procedures.size(); i++)
+  {
+    const Procedure& procedure = procedures.at(i);
+    const ProcedureResult& result = results.at(i);
+
+    insert.addRow({procedure.airportId,
+                   procedure.approachId != -1 ? QVariant(procedure.approachId) : QVariant(QVariant::Int),
+                   procedure.transitionId != -1 ? QVariant(procedure.transitionId) : QVariant(QVariant::Int),
+                   result.distanceNm, result.missedDistanceNm,
+                   atools::fs::common::BinaryGeometry(result.geometry).
+                   writeToByteArray(atools::fs::common::BinaryGeometry::FORMAT_PACKED),
+                   result.legInfo});
+  }
+  insert.flush();
+
+  qDebug() << Q_FUNC_INFO << "procedures" << procedures.size() << "airports" << airportStart.size() - 1
+           << timer.elapsed() << "ms";
+}
+
+QVector<ProcedureLegGeometry> ProcedureGeometryWriter::readLegInfo(const QByteArray& bytes)
+{
+  QVector<ProcedureLegGeometry> legs;
+  const char *data = bytes.constData();
+  int num = bytes.size() / LEG_INFO_SIZE;
+  legs.reserve(num);
+  for(int i = 0; i < num; i++, data += LEG_INFO_SIZE)
+    legs.append({qFromLittleEndian<qint32>(data), qFromLittleEndian<qint32>(data + 4),
+                 readFloatLe(data + 8)});
+  return legs;
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,82 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_PROCEDUREGEOMETRYWRITER_H
+#define ATOOLS_FS_DB_PROCEDUREGEOMETRYWRITER_H
+
+#include <QCoreApplication>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/* Leg entry in the leg_info blob of table procedure_geometry */
+struct ProcedureLegGeometry
+{
+  /* approach_leg_id or transition_leg_id */
+  int legId;
+
+  /* Index of the first point of this leg in the geometry */
+  int firstPoint;
+
+  /* Leg length in NM */
+  float distanceNm;
+};
+
+/*
+ * Optional compilation step which precomputes the geometry of all approaches and transitions and fills the table
+ * procedure_geometry. Runs after all procedures are loaded and resolved.
+ *
+ * Legs are converted into a line string using the fix positions. Arcs (AF and RF) are calculated around the
+ * recommended fix, holds are converted into a racetrack and legs without fix like course to altitude get a
+ * default length. The result is an approximation for display and distance calculation and does not replace the
+ * exact calculation based on aircraft performance.
+ *
+ * Geometry is stored as packed BinaryGeometry. leg_info contains one little endian record of
+ * qint32 leg id, qint32 first point index and float32 distance per leg. Use readLegInfo() to decode it.
+ *
+ * Procedures are calculated in parallel per airport and written in one batch.
+ */
+class ProcedureGeometryWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(ProcedureGeometryWriter)
+
+public:
+  /* numThreads: Threads used for calculation. 0 uses all cores. */
+  ProcedureGeometryWriter(atools::sql::SqlDatabase *sqlDb, int numThreads = 0);
+
+  /* Clear and fill table procedure_geometry */
+  void run();
+
+  /* Decode column leg_info */
+  static QVector<atools::fs::db::ProcedureLegGeometry> readLegInfo(const QByteArray& bytes);
+
+private:
+  atools::sql::SqlDatabase *db;
+  int threads;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_PROCEDUREGEOMETRYWRITER_H
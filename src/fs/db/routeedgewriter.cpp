@@ -19,10 +19,11 @@
 
 #include "sql/sqldatabase.h"
 #include "geo/pos.h"
-#include "geo/rect.h"
 #include "geo/calculations.h"
+#include "geo/spatialindex.h"
 #include "sql/sqlutil.h"
 #include "sql/sqlquery.h"
+#include "util/parallel.h"
 
 #include <QElapsedTimer>
 
@@ -34,7 +35,7 @@ using atools::sql::SqlDatabase;
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
 using atools::geo::Pos;
-using atools::geo::Rect;
+using atools::geo::IndexDistance;
 
 /* Added to range of current radio id */
 const int MAX_RADIO_RANGE_METER = atools::geo::nmToMeter(200);
@@ -51,15 +52,14 @@ const int MAX_EDGES_PER_SECTOR = 2;
 /* Increase search radius around a navaid and search again until we find at least this amount of neigbours s  */
 const int MIN_EDGES_PER_SECTOR = 1;
 
-/* Increase rectangle at a maximum of this number */
+/* Increase radius at a maximum of this number */
 const int MAX_ITERATIONS = 2;
 
 /* Prioritize navaids by type - Index VOR=0, VORDME=1, DME=2, NDB=3 */
 const int PRIORITY_BY_TYPE[] = {0 /* None */, 2 /* VOR */, 3 /* VORDME */, 0 /* DME */, 1 /* NDB */};
 
-/* Inflate seach rectangle for each iteration.  */
-const float INFLATE_RECT_LON_DEGREES = 6.f;
-const float INFLATE_RECT_LAT_DEGREES = 4.f;
+/* Inflate search radius for each iteration. About four degrees latitude as used for the former search rectangle. */
+const float INFLATE_RADIUS_METER = atools::geo::nmToMeter(240);
 
 // Query result column indexes
 enum ColumnIndex
@@ -67,124 +67,38 @@ enum ColumnIndex
   NODE_ID, RANGE, TYPE, LONX, LATY
 };
 
-enum BindColumnIndex
+/* Radio navaid node loaded from table route_node_radio */
+struct RadioNode
 {
-  LEFTX,
-  RIGHTX,
-  BOTTOMY,
-  TOPY
-};
-
-RouteEdgeWriter::RouteEdgeWriter(atools::sql::SqlDatabase *sqlDb)
-  : db(sqlDb)
-{
-
-}
-
-void RouteEdgeWriter::run()
-{
-  // Iterate over all radio navaids
-  SqlQuery selectNodesQuery("select node_id, range, type, lonx, laty from route_node_radio", db);
-
-  // Get all nodes nearby this navaids
-  SqlQuery nearestNodesQuery(db);
-  nearestNodesQuery.prepare("select node_id, range, type, lonx, laty from route_node_radio "
-                            "where lonx between ? and ? and laty between ? and ?");
-
-  // Insert edges into databases
-  SqlQuery insertEdgesQuery(db);
-  insertEdgesQuery.prepare("insert into route_edge_radio "
-                           "(from_node_id, from_node_type, to_node_id, to_node_type, distance) "
-                           "values(?, ?, ?, ?, ?)");
-
-  // Clean the result table
-  SqlQuery stmt(db);
-  stmt.exec("delete from route_edge_radio");
-  int deleted = stmt.numRowsAffected();
-  qInfo() << "Removed" << deleted << "from route_edge_radio table";
+  int nodeId;
+  int range;
+  int type; // VOR=1, VORDME=2, DME=3, NDB=4,
+  Pos pos;
 
-  QVariantList toNodeIdVars, toNodeTypeVars, toNodeDistanceVars, fromNodeIdVars, fromNodeTypeVars;
-
-  int average = 0, total = 0, maximum = 0, numEmpty = 0;
-
-  selectNodesQuery.exec();
-  while(selectNodesQuery.next())
+  const Pos& getPosition() const
   {
-    // Look at each node
-    int fromRangeMeter = selectNodesQuery.value(RANGE).toInt();
-    int fromNodeId = selectNodesQuery.value(NODE_ID).toInt();
-    int fromNodeType = selectNodesQuery.value(TYPE).toInt();
-
-    Pos pos(selectNodesQuery.value(LONX).toFloat(), selectNodesQuery.value(LATY).toFloat());
-
-    // Clear result lists
-    toNodeIdVars.clear();
-    toNodeTypeVars.clear();
-    toNodeDistanceVars.clear();
-
-    // Get all navaids in bounding rectangle - first iterations
-    Rect queryRect(pos, MAX_RADIO_RANGE_METER, true /* fast */);
-    bool nearestSatisfied = nearest(nearestNodesQuery, fromNodeId, pos, queryRect, fromRangeMeter,
-                                    toNodeIdVars, toNodeTypeVars, toNodeDistanceVars);
-
-    // If not all sectors have an edge increase rectangle and try again for MAX_ITERATIONS
-    int maxIter = 0;
-    while(!nearestSatisfied)
-    {
-      toNodeIdVars.clear();
-      toNodeTypeVars.clear();
-      toNodeDistanceVars.clear();
-      queryRect.inflate(INFLATE_RECT_LON_DEGREES, INFLATE_RECT_LAT_DEGREES);
-      nearestSatisfied = nearest(nearestNodesQuery, fromNodeId, pos, queryRect, fromRangeMeter,
-                                 toNodeIdVars, toNodeTypeVars, toNodeDistanceVars);
-      if(maxIter++ > MAX_ITERATIONS)
-        break;
-    }
-
-    // Update from value arrays with values for bind
-    fromNodeIdVars.clear();
-    fromNodeTypeVars.clear();
-    for(int i = 0; i < toNodeIdVars.size(); i++)
-    {
-      fromNodeIdVars.append(fromNodeId);
-      fromNodeTypeVars.append(fromNodeType);
-    }
-
-    // Use batch update to insert values into edge table
-    insertEdgesQuery.addBindValue(fromNodeIdVars);
-    insertEdgesQuery.addBindValue(fromNodeTypeVars);
-    insertEdgesQuery.addBindValue(toNodeIdVars);
-    insertEdgesQuery.addBindValue(toNodeTypeVars);
-    insertEdgesQuery.addBindValue(toNodeDistanceVars);
-    insertEdgesQuery.execBatch();
-
-    total += toNodeIdVars.size();
-    average = (average + toNodeIdVars.size()) / 2;
-    maximum = std::max(maximum, toNodeIdVars.size());
-
-    if(toNodeIdVars.size() == 0)
-      numEmpty++;
+    return pos;
   }
 
-  qDebug() << "Edge writer: total" << total << "average" << average
-           << "max" << maximum << "numEmpty" << numEmpty;
-}
+};
+
+/* Edge to neighbour node */
+struct RadioEdge
+{
+  int toNodeId, toNodeType, distance;
+};
 
 /*
  * Get nearest neighbours for a navaid
- * @param nearestStmt
- * @param fromNodeId node ID for current navaid
- * @param pos position of current navaid
- * @param queryRect current query rectangle
- * @param fromRangeMeter range for current navaid
- * @param toNodeIds result list
- * @param toNodeTypes result list
- * @param toNodeDistances result list
- * @return
+ * @param nodes all nodes with spatial index
+ * @param from current navaid
+ * @param radiusMeter current search radius
+ * @param neighbours buffer for query
+ * @param edges result list
+ * @return true if all sectors have enough edges
  */
-bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos& pos, const Rect& queryRect,
-                              int fromRangeMeter, QVariantList& toNodeIds,
-                              QVariantList& toNodeTypes, QVariantList& toNodeDistances)
+static bool nearest(const atools::geo::SpatialIndex<RadioNode>& nodes, const RadioNode& from, float radiusMeter,
+                    QVector<IndexDistance>& neighbours, QVector<RadioEdge>& edges)
 {
   struct TempNodeTo
   {
@@ -196,80 +110,67 @@ bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos&
   };
 
   // Nodes with reachable navaids - one list of nodes per sector
-  QVector<QVector<TempNodeTo> > sectorsReachable;
-  for(int i = 0; i < NUM_SECTORS; i++)
-    sectorsReachable.append(QVector<TempNodeTo>());
+  QVector<TempNodeTo> sectorsReachable[NUM_SECTORS];
 
   // Nodes with unreachable navaids - one list of nodes per sector
-  QVector<QVector<TempNodeTo> > sectorsOther;
-  for(int i = 0; i < NUM_SECTORS; i++)
-    sectorsOther.append(QVector<TempNodeTo>());
-
-  for(const Rect& rect : queryRect.splitAtAntiMeridian())
-  {
-    bindCoordinatePointInRect(rect, &nearestStmt);
+  QVector<TempNodeTo> sectorsOther[NUM_SECTORS];
 
-    nearestStmt.exec();
+  nodes.getRadiusSorted(neighbours, from.pos, radiusMeter);
 
-    while(nearestStmt.next())
-    {
-      int toNodeId = nearestStmt.value(NODE_ID).toInt();
-      if(toNodeId == fromNodeId)
-        continue;
-
-      int toRangeMeter = nearestStmt.value(RANGE).toInt();
-      Pos toPos(nearestStmt.value(LONX).toFloat(), nearestStmt.value(LATY).toFloat());
-      int distanceMeter = static_cast<int>(pos.distanceMeterTo(toPos) + 0.5f);
+  for(const IndexDistance& neighbour : qAsConst(neighbours))
+  {
+    const RadioNode& to = nodes.at(neighbour.index);
+    if(to.nodeId == from.nodeId)
+      continue;
 
-      if(distanceMeter < MIN_DISTANCE_METER)
-        // Navaid is too close
-        continue;
+    int distanceMeter = static_cast<int>(neighbour.distanceMeter + 0.5f);
 
-      int courseDeg = static_cast<int>(pos.angleDegTo(toPos) + 0.5f);
-      if(courseDeg >= 360)
-        courseDeg -= 360;
+    if(distanceMeter < MIN_DISTANCE_METER)
+      // Navaid is too close
+      continue;
 
-      // Calculate sector number for this node
-      int sectorNum = courseDeg / (360 / NUM_SECTORS);
+    int courseDeg = static_cast<int>(from.pos.angleDegTo(to.pos) + 0.5f);
+    if(courseDeg >= 360)
+      courseDeg -= 360;
 
-      int toNodeType = nearestStmt.value(TYPE).toInt();
+    // Calculate sector number for this node
+    int sectorNum = courseDeg / (360 / NUM_SECTORS);
 
-      TempNodeTo tmp = {toNodeId, toNodeType, toRangeMeter, distanceMeter, PRIORITY_BY_TYPE[toNodeType]};
+    TempNodeTo tmp = {to.nodeId, to.type, to.range, distanceMeter, PRIORITY_BY_TYPE[to.type]};
 
-      bool reachable = fromRangeMeter + toRangeMeter > distanceMeter;
+    bool reachable = from.range + to.range > distanceMeter;
 
-      QVector<TempNodeTo>::iterator it;
+    QVector<TempNodeTo>::iterator it;
 
-      if(reachable)
-      {
-        QVector<TempNodeTo>& sector = sectorsReachable[sectorNum];
-
-        // farthest at beginning of list
-        it = std::lower_bound(sector.begin(), sector.end(), tmp,
-                              [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
-              {
-                if(n1.priority == n2.priority)
-                  return n1.distance > n2.distance;
-                else
-                  return n1.priority > n2.priority;
-              });
-        sector.insert(it, tmp);
-      }
-      else
-      {
-        QVector<TempNodeTo>& sector = sectorsOther[sectorNum];
-
-        // nearest at beginning of list
-        it = std::lower_bound(sector.begin(), sector.end(), tmp,
-                              [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
-              {
-                if(n1.priority == n2.priority)
-                  return n1.distance < n2.distance;
-                else
-                  return n1.priority > n2.priority;
-              });
-        sector.insert(it, tmp);
-      }
+    if(reachable)
+    {
+      QVector<TempNodeTo>& sector = sectorsReachable[sectorNum];
+
+      // farthest at beginning of list
+      it = std::lower_bound(sector.begin(), sector.end(), tmp,
+                            [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
+            {
+              if(n1.priority == n2.priority)
+                return n1.distance > n2.distance;
+              else
+                return n1.priority > n2.priority;
+            });
+      sector.insert(it, tmp);
+    }
+    else
+    {
+      QVector<TempNodeTo>& sector = sectorsOther[sectorNum];
+
+      // nearest at beginning of list
+      it = std::lower_bound(sector.begin(), sector.end(), tmp,
+                            [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
+            {
+              if(n1.priority == n2.priority)
+                return n1.distance < n2.distance;
+              else
+                return n1.priority > n2.priority;
+            });
+      sector.insert(it, tmp);
     }
   }
 
@@ -278,8 +179,8 @@ bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos&
   // Now check for each sector if conditions are met
   for(int sectorNum = 0; sectorNum < NUM_SECTORS; sectorNum++)
   {
-    const QVector<TempNodeTo> sectorReachable = sectorsReachable.value(sectorNum);
-    const QVector<TempNodeTo> sectorOther = sectorsOther.value(sectorNum);
+    const QVector<TempNodeTo>& sectorReachable = sectorsReachable[sectorNum];
+    const QVector<TempNodeTo>& sectorOther = sectorsOther[sectorNum];
     int numOtherEntries = std::min(sectorOther.size(), MAX_EDGES_PER_SECTOR);
     int numReachableEntries = std::min(sectorReachable.size(), MAX_EDGES_PER_SECTOR);
 
@@ -291,29 +192,117 @@ bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos&
     for(int i = 0; i < numReachableEntries; i++)
     {
       const TempNodeTo& tn = sectorReachable.at(i);
-      toNodeIds.append(tn.nodeId);
-      toNodeTypes.append(tn.type);
-      toNodeDistances.append(tn.distance);
+      edges.append({tn.nodeId, tn.type, tn.distance});
     }
 
     // Then add the unreachable
     for(int i = 0; i < numOtherEntries; i++)
     {
       const TempNodeTo& tn = sectorOther.at(i);
-      toNodeIds.append(tn.nodeId);
-      toNodeTypes.append(tn.type);
-      toNodeDistances.append(tn.distance);
+      edges.append({tn.nodeId, tn.type, tn.distance});
     }
   }
   return retval;
 }
 
-void RouteEdgeWriter::bindCoordinatePointInRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query)
+RouteEdgeWriter::RouteEdgeWriter(atools::sql::SqlDatabase *sqlDb, int numThreads)
+  : db(sqlDb), threads(numThreads)
 {
-  query->bindValue(LEFTX, rect.getWest());
-  query->bindValue(RIGHTX, rect.getEast());
-  query->bindValue(BOTTOMY, rect.getSouth());
-  query->bindValue(TOPY, rect.getNorth());
+
+}
+
+void RouteEdgeWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Load all radio navaids into memory and build spatial index
+  atools::geo::SpatialIndex<RadioNode> nodes;
+  SqlQuery selectNodesQuery("select node_id, range, type, lonx, laty from route_node_radio", db);
+  selectNodesQuery.exec();
+  while(selectNodesQuery.next())
+  {
+    nodes.append({selectNodesQuery.value(NODE_ID).toInt(), selectNodesQuery.value(RANGE).toInt(),
+                  selectNodesQuery.value(TYPE).toInt(),
+                  Pos(selectNodesQuery.value(LONX).toFloat(), selectNodesQuery.value(LATY).toFloat())});
+  }
+  nodes.updateIndex(threads);
+
+  // Clean the result table
+  SqlQuery stmt(db);
+  stmt.exec("delete from route_edge_radio");
+  int deleted = stmt.numRowsAffected();
+  qInfo() << "Removed" << deleted << "from route_edge_radio table";
+
+  // Find edges for each node in parallel - each thread writes only to the edge lists of its nodes
+  QVector<QVector<RadioEdge> > edges(nodes.size());
+  QVector<RadioEdge> *edgesData = edges.data();
+  atools::util::parallelFor(nodes.size(), threads, [&nodes, edgesData](int begin, int end, int) {
+    QVector<IndexDistance> neighbours;
+    for(int i = begin; i < end; i++)
+    {
+      const RadioNode& from = nodes.at(i);
+      QVector<RadioEdge>& nodeEdges = edgesData[i];
+
+      // Get all navaids in radius - first iteration
+      float radius = MAX_RADIO_RANGE_METER;
+      bool nearestSatisfied = nearest(nodes, from, radius, neighbours, nodeEdges);
+
+      // If not all sectors have an edge increase radius and try again for MAX_ITERATIONS
+      int maxIter = 0;
+      while(!nearestSatisfied)
+      {
+        nodeEdges.clear();
+        radius += INFLATE_RADIUS_METER;
+        nearestSatisfied = nearest(nodes, from, radius, neighbours, nodeEdges);
+        if(maxIter++ > MAX_ITERATIONS)
+          break;
+      }
+    }
+  }, 100);
+
+  // Collect all edges and write them in one batch insert ==========================
+  QVariantList toNodeIdVars, toNodeTypeVars, toNodeDistanceVars, fromNodeIdVars, fromNodeTypeVars;
+  int average = 0, total = 0, maximum = 0, numEmpty = 0;
+
+  for(int i = 0; i < nodes.size(); i++)
+  {
+    const RadioNode& from = nodes.at(i);
+    const QVector<RadioEdge>& nodeEdges = edges.at(i);
+
+    for(const RadioEdge& edge : nodeEdges)
+    {
+      fromNodeIdVars.append(from.nodeId);
+      fromNodeTypeVars.append(from.type);
+      toNodeIdVars.append(edge.toNodeId);
+      toNodeTypeVars.append(edge.toNodeType);
+      toNodeDistanceVars.append(edge.distance);
+    }
+
+    total += nodeEdges.size();
+    average = (average + nodeEdges.size()) / 2;
+    maximum = std::max(maximum, nodeEdges.size());
+
+    if(nodeEdges.isEmpty())
+      numEmpty++;
+  }
+
+  if(!fromNodeIdVars.isEmpty())
+  {
+    SqlQuery insertEdgesQuery(db);
+    insertEdgesQuery.prepare("insert into route_edge_radio "
+                             "(from_node_id, from_node_type, to_node_id, to_node_type, distance) "
+                             "values(?, ?, ?, ?, ?)");
+    insertEdgesQuery.addBindValue(fromNodeIdVars);
+    insertEdgesQuery.addBindValue(fromNodeTypeVars);
+    insertEdgesQuery.addBindValue(toNodeIdVars);
+    insertEdgesQuery.addBindValue(toNodeTypeVars);
+    insertEdgesQuery.addBindValue(toNodeDistanceVars);
+    insertEdgesQuery.execBatch();
+  }
+
+  qDebug() << "Edge writer: total" << total << "average" << average
+           << "max" << maximum << "numEmpty" << numEmpty << "nodes" << nodes.size() << timer.elapsed() << "ms";
 }
 
 } // namespace writer
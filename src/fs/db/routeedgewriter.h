@@ -18,19 +18,11 @@
 #ifndef ATOOLS_ROUTEEDGEWRITER_H
 #define ATOOLS_ROUTEEDGEWRITER_H
 
-#include <QVariantList>
 #include <QCoreApplication>
 
-class QString;
-
 namespace atools {
-namespace geo {
-class Rect;
-class Pos;
-}
 namespace sql {
 class SqlDatabase;
-class SqlQuery;
 }
 
 namespace fs {
@@ -40,13 +32,17 @@ namespace db {
 /*
  * Creates a routing network from VOR and NDB stations that are reachable from each other.
  * Fills table route_edge_radio and reads from table route_node_radio.
+ *
+ * All nodes are loaded into a spatial index. Neighbours are searched and selected per sector in parallel
+ * and all edges are written in one batch insert.
  */
 class RouteEdgeWriter
 {
   Q_DECLARE_TR_FUNCTIONS(AirwayResolver)
 
 public:
-  RouteEdgeWriter(atools::sql::SqlDatabase *sqlDb);
+  /* numThreads: Threads used for neighbour search. 0 uses all cores. */
+  RouteEdgeWriter(atools::sql::SqlDatabase *sqlDb, int numThreads = 0);
 
   /*
    * Run the process and fill the route_edge_radio table. Reports process every 500 ms.
@@ -57,13 +53,8 @@ public:
   void run();
 
 private:
-  void bindCoordinatePointInRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query);
-  bool nearest(atools::sql::SqlQuery& nearestStmt, int fromNodeId, const geo::Pos& pos,
-               const geo::Rect& queryRect,
-               int fromRangeMeter, QVariantList& toNodeIds, QVariantList& toNodeTypes,
-               QVariantList& toNodeDistances);
-
   atools::sql::SqlDatabase *db;
+  int threads;
 };
 
 } // namespace writer
@@ -29,7 +29,7 @@ using std::make_pair;
 
 void RunwayIndex::add(const QString& airportIdent, const QString& runwayName, int runwayEndId)
 {
-  runwayIndexMap[RunwayIndexKeyType(airportIdent, runwayName)] = runwayEndId;
+  runwayIndexMap.insert(RunwayIndexKeyType(airportIdent, runwayName), runwayEndId);
 }
 
 int RunwayIndex::getRunwayEndId(const QString& airportIdent,
@@ -39,11 +39,9 @@ int RunwayIndex::getRunwayEndId(const QString& airportIdent,
   if(runwayName == NO_RWY)
     return -1;
 
-  RunwayIndexKeyType key(airportIdent, runwayName);
-
-  auto it = runwayIndexMap.find(key);
-  if(it != runwayIndexMap.end())
-    return it.value();
+  const int *id = runwayIndexMap.find(RunwayIndexKeyType(airportIdent, runwayName));
+  if(id != nullptr)
+    return *id;
   else
   {
     qWarning().nospace().noquote() << "Runway end ID for airport " << airportIdent << " and runway " <<
@@ -18,7 +18,8 @@
 #ifndef ATOOLS_FS_DB_RUNWAYINDEX_H
 #define ATOOLS_FS_DB_RUNWAYINDEX_H
 
-#include <QHash>
+#include "util/identkey.h"
+#include "util/openhash.h"
 
 namespace atools {
 namespace fs {
@@ -60,11 +61,10 @@ public:
   }
 
 private:
-  /* key of airport ident and runway name. Use QPair since it has a hash function */
-  typedef QPair<QString, QString> RunwayIndexKeyType;
+  /* key of packed airport ident and runway name */
+  typedef atools::util::IdentKeyPair RunwayIndexKeyType;
 
-  typedef QHash<atools::fs::db::RunwayIndex::RunwayIndexKeyType, int> RunwayIndexType;
-  typedef atools::fs::db::RunwayIndex::RunwayIndexType::const_iterator RunwayIndexTypeConstIter;
+  typedef atools::util::OpenHash<atools::fs::db::RunwayIndex::RunwayIndexKeyType, int> RunwayIndexType;
 
   atools::fs::db::RunwayIndex::RunwayIndexType runwayIndexMap;
 };
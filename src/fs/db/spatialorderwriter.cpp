@@ -0,0 +1,223 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/spatialorderwriter.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+namespace {
+
+/* Column referring to a renumbered table. Condition selects the rows for columns referring to several tables. */
+struct Reference
+{
+  QString table, column, condition;
+};
+
+const QVector<Reference> AIRPORT_REFERENCES({
+  {"airport_medium", "airport_id", QString()},
+  {"airport_large", "airport_id", QString()},
+  {"runway", "airport_id", QString()},
+  {"com", "airport_id", QString()},
+  {"helipad", "airport_id", QString()},
+  {"start", "airport_id", QString()},
+  {"apron", "airport_id", QString()},
+  {"apron_mesh", "airport_id", QString()},
+  {"taxi_path", "airport_id", QString()},
+  {"taxi_graph", "airport_id", QString()},
+  {"parking", "airport_id", QString()},
+  {"approach", "airport_id", QString()},
+  {"procedure_geometry", "airport_id", QString()},
+  {"waypoint", "airport_id", QString()},
+  {"vor", "airport_id", QString()},
+  {"ndb", "airport_id", QString()},
+  {"nav_search", "airport_id", QString()},
+  {"holding", "airport_id", QString()},
+  {"airport_msa", "airport_id", QString()},
+  {"airport_msa", "nav_id", "nav_type = 'A'"}
+});
+
+const QVector<Reference> VOR_REFERENCES({
+  {"waypoint", "nav_id", "type = 'V'"},
+  {"nav_search", "vor_id", QString()},
+  {"nav_search", "waypoint_nav_id", "nav_type = 'W' and type = 'V'"},
+  {"holding", "nav_id", "nav_type = 'V'"},
+  {"airport_msa", "nav_id", "nav_type = 'V'"},
+  {"route_node_radio", "nav_id", "type <> 4"}
+});
+
+const QVector<Reference> NDB_REFERENCES({
+  {"waypoint", "nav_id", "type = 'N'"},
+  {"nav_search", "ndb_id", QString()},
+  {"nav_search", "waypoint_nav_id", "nav_type = 'W' and type = 'N'"},
+  {"holding", "nav_id", "nav_type = 'N'"},
+  {"airport_msa", "nav_id", "nav_type = 'N'"},
+  {"route_node_radio", "nav_id", "type = 4"}
+});
+
+const QVector<Reference> WAYPOINT_REFERENCES({
+  {"airway", "from_waypoint_id", QString()},
+  {"airway", "to_waypoint_id", QString()},
+  {"nav_search", "waypoint_id", QString()},
+  {"holding", "nav_id", "nav_type = 'W'"},
+  {"airport_msa", "nav_id", "nav_type = 'W'"},
+  {"route_node_airway", "nav_id", QString()}
+});
+
+/* Order 16 curve giving 65536 cells per axis */
+const quint32 HILBERT_SIZE = 1 << 16;
+
+} // namespace
+
+SpatialOrderWriter::SpatialOrderWriter(SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+quint32 SpatialOrderWriter::hilbertIndex(double lonx, double laty)
+{
+  quint32 x = static_cast<quint32>(std::max(0., std::min((lonx + 180.) / 360., 1.)) * (HILBERT_SIZE - 1));
+  quint32 y = static_cast<quint32>(std::max(0., std::min((laty + 90.) / 180., 1.)) * (HILBERT_SIZE - 1));
+
+  // Rotate quadrants while descending from the largest cell size
+  quint32 index = 0;
+  for(quint32 size = HILBERT_SIZE / 2; size > 0; size /= 2)
+  {
+    quint32 rx = (x & size) > 0, ry = (y & size) > 0;
+    index += size * size * ((3 * rx) ^ ry);
+
+    if(ry == 0)
+    {
+      if(rx == 1)
+      {
+        x = HILBERT_SIZE - 1 - x;
+        y = HILBERT_SIZE - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return index;
+}
+
+void SpatialOrderWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  renumber("airport", "lonx, laty");
+  renumber("vor", "lonx, laty");
+  renumber("ndb", "lonx, laty");
+  renumber("waypoint", "lonx, laty");
+  renumber("boundary", "(min_lonx + max_lonx) / 2., (min_laty + max_laty) / 2.");
+
+  // Landmarks store node ids and indexes of the routing network
+  if(SqlUtil(db).hasTable("route_landmark"))
+    db->exec("delete from route_landmark");
+
+  qDebug() << Q_FUNC_INFO << timer.elapsed() << "ms";
+}
+
+void SpatialOrderWriter::renumber(const QString& table, const QString& coordinates)
+{
+  SqlUtil util(db);
+  if(!util.hasTableAndRows(table))
+    return;
+
+  QString idColumn = table + "_id";
+
+  // Sort by curve position and old id to keep order stable for equal positions
+  QVector<std::pair<quint32, int> > order;
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec("select " + idColumn + ", " + coordinates + " from " + table);
+  while(query.next())
+    order.append(std::make_pair(hilbertIndex(query.valueDouble(1), query.valueDouble(2)), query.valueInt(0)));
+  query.finish();
+  std::sort(order.begin(), order.end());
+
+  db->exec("drop table if exists temp.tmp_spatial_id");
+  db->exec("create temp table tmp_spatial_id (old_id integer primary key, new_id integer not null)");
+
+  SqlQuery insert(db);
+  insert.prepare("insert into tmp_spatial_id (old_id, new_id) values(?, ?)");
+  for(int i = 0; i < order.size(); i++)
+  {
+    insert.bindValue(0, order.at(i).second);
+    insert.bindValue(1, i + 1);
+    insert.exec();
+  }
+
+  // Go through negative ids to avoid collisions with existing rows
+  QString newId = "(select new_id from tmp_spatial_id where old_id = %1)";
+  QStringList primaryTables({table});
+  if(table == "airport")
+    primaryTables << "airport_medium" << "airport_large";
+  for(const QString& primaryTable : primaryTables)
+  {
+    if(util.hasTable(primaryTable))
+    {
+      db->exec("update " + primaryTable + " set " + idColumn + " = -" + newId.arg(primaryTable + "." + idColumn));
+      db->exec("update " + primaryTable + " set " + idColumn + " = -" + idColumn);
+    }
+  }
+
+  const QVector<Reference> *references = nullptr;
+  if(table == "airport")
+    references = &AIRPORT_REFERENCES;
+  else if(table == "vor")
+    references = &VOR_REFERENCES;
+  else if(table == "ndb")
+    references = &NDB_REFERENCES;
+  else if(table == "waypoint")
+    references = &WAYPOINT_REFERENCES;
+
+  if(references != nullptr)
+  {
+    for(const Reference& ref : *references)
+    {
+      // Airport id is primary key in the airport copies which are already renumbered above
+      if(primaryTables.contains(ref.table) || !util.hasTableAndColumn(ref.table, ref.column))
+        continue;
+
+      db->exec("update " + ref.table + " set " + ref.column + " = " + newId.arg(ref.table + "." + ref.column) +
+               " where " + ref.column + " is not null" +
+               (ref.condition.isEmpty() ? QString() : " and " + ref.condition));
+    }
+  }
+
+  db->exec("drop table temp.tmp_spatial_id");
+  qDebug() << Q_FUNC_INFO << "Renumbered" << order.size() << "rows in" << table;
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
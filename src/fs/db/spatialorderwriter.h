@@ -0,0 +1,65 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_SPATIALORDERWRITER_H
+#define ATOOLS_FS_DB_SPATIALORDERWRITER_H
+
+#include <QCoreApplication>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Renumbers the rows of the tables airport, vor, ndb, waypoint and boundary in Hilbert curve order of their
+ * coordinates. All references in other tables like runways, airways, search and routing tables are updated.
+ *
+ * SQLite stores rows in id order, so a map viewport or nearest search touches fewer pages after renumbering.
+ * The physical order is only established by a following VACUUM which copies all tables in rowid order.
+ *
+ * Has to run as the last step after all tables are filled. Route landmarks are deleted since they depend on
+ * node ids. Does not commit.
+ */
+class SpatialOrderWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(SpatialOrderWriter)
+
+public:
+  SpatialOrderWriter(atools::sql::SqlDatabase *sqlDb);
+
+  /* Renumber all tables and update references */
+  void run();
+
+  /* Position on a Hilbert curve of order 16 covering the whole world */
+  static quint32 hilbertIndex(double lonx, double laty);
+
+private:
+  /* Renumber one table and all references. coordinates is an SQL expression for lonx and laty. */
+  void renumber(const QString& table, const QString& coordinates);
+
+  atools::sql::SqlDatabase *db;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_SPATIALORDERWRITER_H
@@ -0,0 +1,163 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/taxigraphwriter.h"
+
+#include "fs/common/taxigraph.h"
+#include "sql/sqlbulkinsert.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlQuery;
+using atools::geo::Pos;
+using atools::fs::common::TaxiGraph;
+
+namespace {
+
+// Query result column indexes
+enum ColumnIndex
+{
+  AIRPORT_ID, TYPE, WIDTH, START_TYPE, START_LONX, START_LATY, END_TYPE, END_LONX, END_LATY
+};
+
+/* Taxi path as loaded from table taxi_path */
+struct Path
+{
+  Pos start, end;
+  float width;
+  quint8 flags, startFlags, endFlags;
+};
+
+/* All paths of one airport and the resulting graph */
+struct Airport
+{
+  int airportId;
+  QVector<Path> paths;
+  QByteArray graph;
+  int numNodes = 0, numEdges = 0;
+};
+
+} // namespace
+
+/* Node flags for start_type and end_type - see atools::fs::bgl::TaxiPoint::pointTypeToString() */
+static quint8 nodeFlags(const QString& type)
+{
+  if(type == QLatin1String("HS") || type == QLatin1String("HSND"))
+    return TaxiGraph::NODE_HOLD_SHORT;
+  else if(type == QLatin1String("IHS") || type == QLatin1String("IHSND"))
+    return TaxiGraph::NODE_ILS_HOLD_SHORT;
+  else if(type == QLatin1String("P"))
+    return TaxiGraph::NODE_PARKING;
+  else
+    return 0;
+}
+
+static void buildGraph(Airport& airport)
+{
+  TaxiGraph graph;
+  for(const Path& path : qAsConst(airport.paths))
+    graph.addPath(path.start, path.end, path.width, path.flags, path.startFlags, path.endFlags);
+  graph.finish();
+
+  airport.numNodes = graph.getNumNodes();
+  airport.numEdges = graph.getNumEdges();
+  airport.graph = graph.writeToByteArray();
+
+  // Not needed anymore
+  airport.paths = QVector<Path>();
+}
+
+TaxiGraphWriter::TaxiGraphWriter(atools::sql::SqlDatabase *sqlDb, int numThreads)
+  : db(sqlDb), threads(numThreads)
+{
+
+}
+
+void TaxiGraphWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Load all paths usable by aircraft - vehicle and closed paths are excluded ==========================
+  QVector<Airport> airports;
+  SqlQuery query("select airport_id, type, width, start_type, start_lonx, start_laty, end_type, end_lonx, end_laty "
+                 "from taxi_path where type is null or type not in ('V', 'C') order by airport_id", db);
+  query.setForwardOnly(true);
+  query.exec();
+  while(query.next())
+  {
+    int airportId = query.valueInt(AIRPORT_ID);
+    if(airports.isEmpty() || airports.constLast().airportId != airportId)
+    {
+      Airport airport;
+      airport.airportId = airportId;
+      airports.append(airport);
+    }
+
+    QString type = query.valueStr(TYPE);
+    quint8 flags = 0;
+    if(type == QLatin1String("R"))
+      flags = TaxiGraph::EDGE_RUNWAY;
+    else if(type == QLatin1String("P"))
+      flags = TaxiGraph::EDGE_PARKING;
+
+    quint8 startFlags = nodeFlags(query.valueStr(START_TYPE)), endFlags = nodeFlags(query.valueStr(END_TYPE));
+    if(flags & TaxiGraph::EDGE_RUNWAY)
+    {
+      startFlags |= TaxiGraph::NODE_RUNWAY;
+      endFlags |= TaxiGraph::NODE_RUNWAY;
+    }
+
+    airports.last().paths.append({Pos(query.valueFloat(START_LONX), query.valueFloat(START_LATY)),
+                                  Pos(query.valueFloat(END_LONX), query.valueFloat(END_LATY)),
+                                  query.valueFloat(WIDTH), flags, startFlags, endFlags});
+  }
+
+  // Clean the result table
+  SqlQuery stmt(db);
+  stmt.exec("delete from taxi_graph");
+
+  // Build graphs - each thread writes only to its airports ==========================
+  Airport *airportsData = airports.data();
+  atools::util::parallelFor(airports.size(), threads, [airportsData](int begin, int end, int) {
+    for(int i = begin; i < end; i++)
+      buildGraph(airportsData[i]);
+  }, 50);
+
+  // Write all in one batch ==========================
+  atools::sql::SqlBulkInsert insert(db, "taxi_graph", {"airport_id", "num_nodes", "num_edges", "graph"});
+  for(const Airport& airport : qAsConst(airports))
+  {
+    if(airport.numEdges > 0)
+      insert.addRow({airport.airportId, airport.numNodes, airport.numEdges, airport.graph});
+  }
+  insert.flush();
+
+  qDebug() << Q_FUNC_INFO << "airports" << airports.size() << timer.elapsed() << "ms";
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -17,11 +17,13 @@
 
 #include "fs/db/writerbasebasic.h"
 #include "fs/db/datawriter.h"
+#include "sql/sqlbulkinsert.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 #include "sql/sqlexception.h"
 
 #include <QDataStream>
+#include <QDebug>
 
 namespace atools {
 namespace fs {
@@ -29,6 +31,7 @@ namespace db {
 
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
+using atools::sql::SqlBulkInsert;
 
 WriterBaseBasic::WriterBaseBasic(atools::sql::SqlDatabase& sqlDb,
                                  DataWriter& writer,
@@ -39,7 +42,10 @@ WriterBaseBasic::WriterBaseBasic(atools::sql::SqlDatabase& sqlDb,
   if(sqlParam.isEmpty())
     sqlStatement = SqlUtil(&db).buildInsertStatement(tablename);
   else
+  {
     sqlStatement = sqlParam;
+    customStatement = true;
+  }
   sqlQuery = SqlQuery(db);
 
   sqlQuery.prepare(sqlStatement);
@@ -47,6 +53,33 @@ WriterBaseBasic::WriterBaseBasic(atools::sql::SqlDatabase& sqlDb,
 
 WriterBaseBasic::~WriterBaseBasic()
 {
+  delete bulkInsert;
+}
+
+void WriterBaseBasic::setBulkInsert(int rowsPerStatement)
+{
+  flush();
+  delete bulkInsert;
+  bulkInsert = nullptr;
+  bulkPlaceholders.clear();
+
+  if(rowsPerStatement > 0)
+  {
+    if(customStatement)
+      qWarning() << Q_FUNC_INFO << "Bulk insert not possible for custom statement" << sqlStatement;
+    else
+    {
+      bulkInsert = new SqlBulkInsert(&db, tablename, QStringList(), rowsPerStatement);
+      for(const QString& column : bulkInsert->getColumns())
+        bulkPlaceholders.append(":" + column);
+    }
+  }
+}
+
+void WriterBaseBasic::flush()
+{
+  if(bulkInsert != nullptr)
+    bulkInsert->flush();
 }
 
 const NavDatabaseOptions& WriterBaseBasic::getOptions()
@@ -102,6 +135,19 @@ void WriterBaseBasic::bindNullString(const QString& placeholder)
 
 void WriterBaseBasic::executeStatement()
 {
+  if(bulkInsert != nullptr)
+  {
+    // Collect values in column order - values stay bound for the next row as for the normal statement
+    QVariantList row;
+    row.reserve(bulkPlaceholders.size());
+    for(const QString& placeholder : bulkPlaceholders)
+      row.append(sqlQuery.boundValue(placeholder, true /* ignoreInvalid */));
+
+    bulkInsert->addRow(row);
+    dataWriter.increaseNumObjects();
+    return;
+  }
+
   sqlQuery.exec();
   int numUpdated = sqlQuery.numRowsAffected();
   if(numUpdated == 0)
@@ -26,6 +26,7 @@
 namespace atools {
 namespace sql {
 class SqlDatabase;
+class SqlBulkInsert;
 }
 
 namespace fs {
@@ -55,6 +56,14 @@ public:
 
   virtual ~WriterBaseBasic();
 
+  /* Buffer rows and insert them using multi-row statements with up to rowsPerStatement rows.
+   * Only possible if the insert statement is generated from the table name. 0 disables bulk inserts.
+   * flush() has to be called before the table is read or changed by others. */
+  void setBulkInsert(int rowsPerStatement);
+
+  /* Write all rows buffered for bulk insert. Does nothing if bulk insert is disabled. */
+  void flush();
+
 protected:
   atools::fs::db::DataWriter& getDataWriter()
   {
@@ -89,7 +98,8 @@ protected:
   template<typename TYPE>
   void bindNumberList(const QString& placeholder, const QList<TYPE>& list);
 
-  /* Execute the insert and throw an exception if nothing was inserted */
+  /* Execute the insert and throw an exception if nothing was inserted.
+   * Only buffers the bound values if bulk insert is enabled. */
   void executeStatement();
 
 private:
@@ -98,6 +108,10 @@ private:
   atools::sql::SqlDatabase& db;
   atools::fs::db::DataWriter& dataWriter;
 
+  /* Not null if bulk insert is enabled. Uses column names from the table. */
+  atools::sql::SqlBulkInsert *bulkInsert = nullptr;
+  QStringList bulkPlaceholders;
+  bool customStatement = false;
 };
 
 template<typename TYPE>
@@ -34,6 +34,7 @@
 #include "sql/sqlquery.h"
 #include "sql/sqlscript.h"
 #include "sql/sqlutil.h"
+#include "util/parallel.h"
 
 #include <QCoreApplication>
 #include <QDataStream>
@@ -58,6 +59,9 @@ namespace atools {
 namespace fs {
 namespace ng {
 
+Q_DECL_CONSTEXPR int DfdCompiler::AIRSPACE_JOB_BATCH_SIZE;
+Q_DECL_CONSTEXPR int DfdCompiler::PROCEDURE_AIRPORT_BATCH_SIZE;
+
 static const float RNV_FEATHER_WIDTH_DEG = 8.f;
 
 DfdCompiler::DfdCompiler(sql::SqlDatabase& sqlDb, const NavDatabaseOptions& opts,
@@ -725,6 +729,9 @@ void DfdCompiler::writeAirspaces()
   writeAirspace(uir2, &DfdCompiler::beginFirUirAirspaceCenter); // Old center
   writeAirspace(uir2, &DfdCompiler::beginFirUirAirspaceNew); // new FIR/UIR type
 
+  // Write remaining airspaces if using worker threads
+  writeAirspaceJobs();
+
   db.commit();
 }
 
@@ -1053,63 +1060,114 @@ int DfdCompiler::airspaceAlt(const QString& altStr)
 
 void DfdCompiler::finishAirspace()
 {
-  // Related to full circle - 7.5° - number is checked in MapPainterAirspace::render()
-  const int CIRCLE_SEGMENTS = 48;
-
   // Do not write if type was not found
   if(!airspaceWriteQuery->boundValue(":type").isNull())
   {
-    // Create geometry
-    LineString curAirspaceLine;
+    airspaceWriteQuery->bindValue(":file_id", FILE_ID);
 
-    for(int i = 0; i < airspaceSegments.size(); i++)
+    if(options.getReaderThreads() != 1)
     {
-      const AirspaceSeg& seg = airspaceSegments.at(i);
-      Pos nextPos = i < airspaceSegments.size() - 1 ? airspaceSegments.at(i + 1).pos : airspaceSegments.constFirst().pos;
+      // Collect bound values and segments and leave geometry to worker threads
+      AirspaceJob job;
+      const QMap<QString, QVariant> bindings = airspaceWriteQuery->boundPlaceholderAndValueMap();
+      for(auto it = bindings.constBegin(); it != bindings.constEnd(); ++it)
+        job.bindings.append(std::make_pair(it.key(), it.value()));
+      job.segments = airspaceSegments;
+      airspaceJobs.append(job);
+
+      if(airspaceJobs.size() >= AIRSPACE_JOB_BATCH_SIZE)
+        writeAirspaceJobs();
+    }
+    else
+    {
+      Rect bounding;
+      QByteArray geometry;
+      buildAirspaceGeometry(airspaceSegments, bounding, geometry);
+      bindAirspaceGeometry(bounding, geometry);
+      airspaceWriteQuery->exec();
+    }
+  }
+
+  airspaceWriteQuery->clearBoundValues();
+  airspaceSegments.clear();
+}
+
+void DfdCompiler::writeAirspaceJobs()
+{
+  if(airspaceJobs.isEmpty())
+    return;
 
-      if(seg.pos.isNull() && !seg.center.isNull())
-        // Create a circular polygon
-        curAirspaceLine.append(LineString(seg.center, ageo::nmToMeter(seg.distance), CIRCLE_SEGMENTS));
+  // Build geometry in worker threads
+  AirspaceJob *jobs = airspaceJobs.data();
+  atools::util::parallelFor(airspaceJobs.size(), options.getReaderThreads(), [jobs](int begin, int end, int) {
+    for(int i = begin; i < end; i++)
+      buildAirspaceGeometry(jobs[i].segments, jobs[i].bounding, jobs[i].geometry);
+  }, 100);
+
+  // Write all in original order using the single insert query
+  for(const AirspaceJob& job : qAsConst(airspaceJobs))
+  {
+    airspaceWriteQuery->bindValues(job.bindings);
+    bindAirspaceGeometry(job.bounding, job.geometry);
+    airspaceWriteQuery->exec();
+    airspaceWriteQuery->clearBoundValues();
+  }
+  airspaceJobs.clear();
+}
+
+void DfdCompiler::buildAirspaceGeometry(const QVector<AirspaceSeg>& segments, Rect& bounding, QByteArray& geometry)
+{
+  // Create geometry
+  LineString curAirspaceLine;
+
+  for(int i = 0; i < segments.size(); i++)
+  {
+    const AirspaceSeg& seg = segments.at(i);
+    Pos nextPos = i < segments.size() - 1 ? segments.at(i + 1).pos : segments.constFirst().pos;
+
+    if(seg.pos.isNull() && !seg.center.isNull())
+      // Create a circular polygon
+      curAirspaceLine.append(LineString::circle(seg.center, ageo::nmToMeter(seg.distance)));
+    else
+    {
+      if(seg.center.isNull())
+        curAirspaceLine.append(seg.pos);
       else
       {
-        if(seg.center.isNull())
-          curAirspaceLine.append(seg.pos);
-        else
-        {
-          // Create an arc
-          bool clockwise = seg.via.isEmpty() ? true : seg.via.at(0) == "R";
-          LineString arc(seg.center, seg.pos, nextPos, clockwise, CIRCLE_SEGMENTS);
+        // Create an arc
+        bool clockwise = seg.via.isEmpty() ? true : seg.via.at(0) == "R";
+        LineString arc = LineString::arc(seg.center, seg.pos, nextPos, clockwise);
 
-          if(!arc.isEmpty())
-            arc.removeLast();
-          curAirspaceLine.append(arc);
-        }
+        if(!arc.isEmpty())
+          arc.removeLast();
+        curAirspaceLine.append(arc);
       }
     }
+  }
 
-    // Move points away from the poles to avoid display artifacts
-    for(Pos& pos : curAirspaceLine)
-    {
-      if(pos.getLatY() > 89.f)
-        pos.setLatY(89.f);
-      if(pos.getLatY() < -89.)
-        pos.setLatY(-89.f);
-    }
-    airspaceWriteQuery->bindValue(":file_id", FILE_ID);
+  // Move points away from the poles to avoid display artifacts
+  for(Pos& pos : curAirspaceLine)
+  {
+    if(pos.getLatY() > 89.f)
+      pos.setLatY(89.f);
+    if(pos.getLatY() < -89.)
+      pos.setLatY(-89.f);
+  }
 
-    Rect bounding = curAirspaceLine.boundingRect();
-    airspaceWriteQuery->bindValue(":max_lonx", bounding.getEast());
-    airspaceWriteQuery->bindValue(":max_laty", bounding.getNorth());
-    airspaceWriteQuery->bindValue(":min_lonx", bounding.getWest());
-    airspaceWriteQuery->bindValue(":min_laty", bounding.getSouth());
+  bounding = curAirspaceLine.boundingRect();
 
-    atools::fs::common::BinaryGeometry geo(curAirspaceLine);
-    airspaceWriteQuery->bindValue(":geometry", geo.writeToByteArray());
-    airspaceWriteQuery->exec();
-  }
+  atools::fs::common::BinaryGeometry geo(curAirspaceLine);
+  geo.buildLevelsOfDetail();
+  geometry = geo.writeToByteArray();
+}
 
-  airspaceWriteQuery->clearBoundValues();
-  airspaceSegments.clear();
+void DfdCompiler::bindAirspaceGeometry(const Rect& bounding, const QByteArray& geometry)
+{
+  airspaceWriteQuery->bindValue(":max_lonx", bounding.getEast());
+  airspaceWriteQuery->bindValue(":max_laty", bounding.getNorth());
+  airspaceWriteQuery->bindValue(":min_lonx", bounding.getWest());
+  airspaceWriteQuery->bindValue(":min_laty", bounding.getSouth());
+  airspaceWriteQuery->bindValue(":geometry", geometry);
 }
 
 void DfdCompiler::writeAirways()
@@ -1255,6 +1313,10 @@ void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
   query.exec();
   atools::fs::common::ProcedureInput procInput;
 
+  // Convert airports in parallel and write in this thread if enabled - otherwise write row by row
+  bool parallel = options.getReaderThreads() != 1;
+  QVector<QVector<atools::fs::common::ProcedureInput> > airports;
+
   QString curAirport;
   procInput.rowCode = rowCode;
   int num = 0;
@@ -1275,9 +1337,17 @@ void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
 
     if(!curAirport.isEmpty() && airportIdent != curAirport)
     {
-      // Write all procedures of this airport
-      procWriter->finish(procInput);
-      procWriter->reset();
+      if(parallel)
+      {
+        if(airports.size() >= PROCEDURE_AIRPORT_BATCH_SIZE)
+          writeProcedureAirports(airports);
+      }
+      else
+      {
+        // Write all procedures of this airport
+        procWriter->finish(procInput);
+        procWriter->reset();
+      }
     }
 
     // qDebug() << query.record();
@@ -1295,13 +1365,43 @@ void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
     // Fill data for procedure writer
     fillProcedureInput(procInput, query);
 
-    // Leave the complicated states to the procedure writer
-    procWriter->write(procInput);
+    if(parallel)
+    {
+      // Start a new row list for each airport
+      if(airportIdent != curAirport)
+        airports.append(QVector<atools::fs::common::ProcedureInput>());
+      airports.last().append(procInput);
+    }
+    else
+      // Leave the complicated states to the procedure writer
+      procWriter->write(procInput);
 
     curAirport = procInput.airportIdent;
   }
-  procWriter->finish(procInput);
-  procWriter->reset();
+
+  if(parallel)
+    writeProcedureAirports(airports);
+  else
+  {
+    procWriter->finish(procInput);
+    procWriter->reset();
+  }
+}
+
+void DfdCompiler::writeProcedureAirports(QVector<QVector<atools::fs::common::ProcedureInput> >& airports)
+{
+  if(airports.isEmpty())
+    return;
+
+  // Convert rows to records in worker threads - fix types are resolved from an index in memory
+  QVector<atools::fs::common::ProcedureRecords> records;
+  procWriter->convertAirports(airports, records, options.getReaderThreads());
+
+  // Write all in original order
+  for(const atools::fs::common::ProcedureRecords& rec : qAsConst(records))
+    procWriter->writeRecords(rec);
+
+  airports.clear();
 }
 
 void DfdCompiler::fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query)
@@ -1425,7 +1525,10 @@ void DfdCompiler::readHeader()
 
 void DfdCompiler::compileMagDeclBgl()
 {
-  magDecReader->readFromWmm();
+  if(options.getSharedMagDecReader() != nullptr)
+    magDecReader->copyFrom(*options.getSharedMagDecReader());
+  else
+    magDecReader->readFromWmm();
   magDecReader->writeToTable(db);
   db.commit();
 }
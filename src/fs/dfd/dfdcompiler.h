@@ -23,6 +23,7 @@
 #include "sql/sqltypes.h"
 
 #include <QString>
+#include <QVariant>
 
 namespace atools {
 namespace sql {
@@ -154,6 +155,9 @@ private:
   /* Write on procedure type - SID, STAR, approaches */
   void writeProcedure(const QString& table, const QString& rowCode);
 
+  /* Convert collected airport procedure rows in worker threads and write them in order */
+  void writeProcedureAirports(QVector<QVector<atools::fs::common::ProcedureInput> >& airports);
+
   /* Start airspace and fill insert query with general airspace data like limits and name from the first source column */
   void beginAirspace(const sql::SqlQuery& query);
 
@@ -174,9 +178,15 @@ private:
   /* Reads all rows of source airspace table */
   void writeAirspace(atools::sql::SqlQuery& query, void (DfdCompiler::*beginFunc)(atools::sql::SqlQuery&));
 
-  /* Finalize and execute insert query */
+  /* Finalize and execute insert query. Collects airspace for writeAirspaceJobs() if worker threads are enabled. */
   void finishAirspace();
 
+  /* Build geometry for all collected airspaces in worker threads and write them in order */
+  void writeAirspaceJobs();
+
+  /* Bind bounding rectangle and geometry blob to insert query */
+  void bindAirspaceGeometry(const atools::geo::Rect& bounding, const QByteArray& geometry);
+
   /* Get aispace altitude restriction which can start with FL and is converted into feet in this case */
   int airspaceAlt(const QString& altStr);
 
@@ -194,6 +204,27 @@ private:
 
   QVector<AirspaceSeg> airspaceSegments;
 
+  /* Airspace collected in finishAirspace() waiting for geometry creation in worker threads */
+  struct AirspaceJob
+  {
+    QVector<std::pair<QString, QVariant> > bindings;
+    QVector<AirspaceSeg> segments;
+    atools::geo::Rect bounding;
+    QByteArray geometry;
+  };
+
+  /* Create airspace polygon and geometry blob from segments. Thread safe. */
+  static void buildAirspaceGeometry(const QVector<AirspaceSeg>& segments, atools::geo::Rect& bounding,
+                                    QByteArray& geometry);
+
+  /* Number of airspaces collected before geometry is built and written */
+  static Q_DECL_CONSTEXPR int AIRSPACE_JOB_BATCH_SIZE = 2000;
+
+  QVector<AirspaceJob> airspaceJobs;
+
+  /* Number of airports collected before procedures are converted and written */
+  static Q_DECL_CONSTEXPR int PROCEDURE_AIRPORT_BATCH_SIZE = 500;
+
   /* Maps concatenated FIR and UIR airspace key columns to boundary_id in database */
   QHash<QString, int> airspaceIdentIdMap;
 
@@ -20,16 +20,23 @@
 #include "exception.h"
 #include "geo/pos.h"
 #include "geo/calculations.h"
+#include "geo/linestring.h"
 #include "atools.h"
 #include "gpxtypes.h"
 #include "fs/pln/flightplan.h"
 #include "util/xmlstream.h"
 #include "zip/gzip.h"
+#include "zip/gzipdevice.h"
 
+#include <QBuffer>
+#include <QtEndian>
 #include <QDateTime>
 #include <QRegularExpression>
 #include <QXmlStreamReader>
 
+#include <cmath>
+
+using atools::geo::LineString;
 using atools::geo::Pos;
 using atools::geo::PosD;
 using atools::fs::pln::Flightplan;
@@ -43,6 +50,317 @@ namespace gpx {
 using Qt::endl;
 #endif
 
+/* Binary format "LTRK" */
+static const quint32 BINARY_MAGIC = 0x4C54524B;
+static const quint8 BINARY_VERSION = 1;
+
+/* Degrees and feet to integer */
+static const double BINARY_COORD_SCALE = 1.e6;
+static const double BINARY_ALT_SCALE = 10.;
+
+static void writeVarUInt(QByteArray& bytes, quint64 value)
+{
+  while(value >= 0x80)
+  {
+    bytes.append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  bytes.append(static_cast<char>(value));
+}
+
+/* Zigzag encoding to keep small negative values short */
+static void writeVarInt(QByteArray& bytes, qint64 value)
+{
+  writeVarUInt(bytes, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+/* Reads variable length values from binary data and stops at the end */
+struct GpxBinaryReader
+{
+  GpxBinaryReader(const QByteArray& bytes)
+    : data(reinterpret_cast<const uchar *>(bytes.constData())), size(bytes.size())
+  {
+  }
+
+  quint64 readVarUInt()
+  {
+    quint64 value = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+      if(pos >= size)
+      {
+        ok = false;
+        return 0;
+      }
+
+      uchar byte = data[pos++];
+      value |= static_cast<quint64>(byte & 0x7f) << shift;
+      if((byte & 0x80) == 0)
+        return value;
+    }
+    ok = false;
+    return 0;
+  }
+
+  qint64 readVarInt()
+  {
+    quint64 value = readVarUInt();
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+  }
+
+  /* Number of elements which is limited by the remaining bytes to avoid huge allocations for corrupted data */
+  int readCount()
+  {
+    quint64 count = readVarUInt();
+    if(count > static_cast<quint64>(size - pos))
+    {
+      ok = false;
+      return 0;
+    }
+    return static_cast<int>(count);
+  }
+
+  QByteArray readBytes()
+  {
+    int length = readCount();
+    QByteArray bytes(reinterpret_cast<const char *>(data + pos), length);
+    pos += length;
+    return bytes;
+  }
+
+  /* Read magic number, version and source key */
+  QByteArray readHeader()
+  {
+    if(size < 5 || qFromLittleEndian<quint32>(data) != BINARY_MAGIC || data[4] != BINARY_VERSION)
+    {
+      ok = false;
+      return QByteArray();
+    }
+    pos = 5;
+    return readBytes();
+  }
+
+  const uchar *data;
+  int size, pos = 0;
+  bool ok = true;
+};
+
+/* Read one position delta to the last one */
+static void readPosBinary(GpxBinaryReader& reader, qint64& lonX, qint64& latY, qint64& alt)
+{
+  lonX += reader.readVarInt();
+  latY += reader.readVarInt();
+  alt += reader.readVarInt();
+}
+
+static void writePosBinary(QByteArray& bytes, double lonX, double latY, double alt, qint64& lastLonX, qint64& lastLatY,
+                           qint64& lastAlt)
+{
+  qint64 lonXInt = std::llround(lonX * BINARY_COORD_SCALE), latYInt = std::llround(latY * BINARY_COORD_SCALE),
+         altInt = std::llround(alt * BINARY_ALT_SCALE);
+  writeVarInt(bytes, lonXInt - lastLonX);
+  writeVarInt(bytes, latYInt - lastLatY);
+  writeVarInt(bytes, altInt - lastAlt);
+  lastLonX = lonXInt;
+  lastLatY = latYInt;
+  lastAlt = altInt;
+}
+
+/*
+ * Writes GPX XML directly into an UTF-8 buffer using the same layout as QXmlStreamWriter with auto formatting.
+ * Numbers are converted using a fixed precision integer path. The date part of timestamps is reused as long as
+ * the day does not change which is the normal case for increasing trail timestamps.
+ */
+struct GpxXmlWriter
+{
+  GpxXmlWriter(int reserveSize)
+  {
+    bytes.reserve(reserveSize);
+    bytes.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+  }
+
+  /* <name> on a new line */
+  void startElement(const char *name)
+  {
+    newline();
+    bytes.append('<').append(name).append('>');
+    depth++;
+  }
+
+  /* <name followed by attributes - close with endStartElement() */
+  void startElementAttr(const char *name)
+  {
+    newline();
+    bytes.append('<').append(name);
+    depth++;
+  }
+
+  void endStartElement()
+  {
+    bytes.append('>');
+  }
+
+  void endElement(const char *name)
+  {
+    depth--;
+    newline();
+    bytes.append("</").append(name).append('>');
+  }
+
+  /* name="value" with value in fixed precision */
+  void attributeFixed(const char *name, double value, int decimals)
+  {
+    bytes.append(' ').append(name).append("=\"");
+    appendFixed(value, decimals);
+    bytes.append('"');
+  }
+
+  void attribute(const char *name, const char *value)
+  {
+    bytes.append(' ').append(name).append("=\"").append(value).append('"');
+  }
+
+  void textElement(const char *name, const QString& text)
+  {
+    newline();
+    bytes.append('<').append(name).append('>');
+    appendEscaped(text);
+    bytes.append("</").append(name).append('>');
+  }
+
+  void textElementFixed(const char *name, double value, int decimals)
+  {
+    newline();
+    bytes.append('<').append(name).append('>');
+    appendFixed(value, decimals);
+    bytes.append("</").append(name).append('>');
+  }
+
+  /* ISO 8601 UTC with milliseconds like "2011-01-16T23:59:01.000Z" */
+  void textElementTime(const char *name, qint64 timestampMs)
+  {
+    newline();
+    bytes.append('<').append(name).append('>');
+
+    qint64 day = timestampMs / MS_PER_DAY;
+    if(day != lastDay)
+    {
+      // Day changed - build "yyyy-MM-ddT" again
+      lastDay = day;
+      datePrefix = QDateTime::fromMSecsSinceEpoch(day * MS_PER_DAY, Qt::UTC).date().toString(Qt::ISODate).toLatin1();
+      datePrefix.append('T');
+    }
+    bytes.append(datePrefix);
+
+    int msOfDay = static_cast<int>(timestampMs - day * MS_PER_DAY);
+    appendDigits(msOfDay / 3600000, 2);
+    bytes.append(':');
+    appendDigits(msOfDay / 60000 % 60, 2);
+    bytes.append(':');
+    appendDigits(msOfDay / 1000 % 60, 2);
+    bytes.append('.');
+    appendDigits(msOfDay % 1000, 3);
+    bytes.append('Z');
+
+    bytes.append("</").append(name).append('>');
+  }
+
+  /* Write closing newline */
+  QByteArray& finish()
+  {
+    bytes.append('\n');
+    return bytes;
+  }
+
+private:
+  static Q_DECL_CONSTEXPR qint64 MS_PER_DAY = 24LL * 3600LL * 1000LL;
+  static Q_DECL_CONSTEXPR int MAX_DECIMALS = 9;
+
+  void newline()
+  {
+    bytes.append('\n');
+    bytes.append(depth * 2, ' ');
+  }
+
+  /* Append number with leading zeros */
+  void appendDigits(int value, int numDigits)
+  {
+    char buffer[16];
+    for(int i = numDigits - 1; i >= 0; i--)
+    {
+      buffer[i] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    }
+    bytes.append(buffer, numDigits);
+  }
+
+  void appendFixed(double value, int decimals)
+  {
+    static const qint64 SCALES[MAX_DECIMALS + 1] =
+    {1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL};
+
+    if(!std::isfinite(value) || std::abs(value) > 1.e9 || decimals < 0 || decimals > MAX_DECIMALS)
+    {
+      // Rare case which does not fit into the integer path
+      bytes.append(QByteArray::number(value, 'f', decimals));
+      return;
+    }
+
+    qint64 scale = SCALES[decimals];
+    qint64 scaled = std::llround(value * static_cast<double>(scale));
+    if(scaled < 0)
+    {
+      bytes.append('-');
+      scaled = -scaled;
+    }
+
+    // Fill buffer backwards
+    char buffer[32];
+    int pos = sizeof(buffer);
+    qint64 integer = scaled / scale, fraction = scaled % scale;
+    for(int i = 0; i < decimals; i++)
+    {
+      buffer[--pos] = static_cast<char>('0' + fraction % 10);
+      fraction /= 10;
+    }
+
+    if(decimals > 0)
+      buffer[--pos] = '.';
+
+    do
+    {
+      buffer[--pos] = static_cast<char>('0' + integer % 10);
+      integer /= 10;
+    } while(integer > 0);
+
+    bytes.append(buffer + pos, static_cast<int>(sizeof(buffer)) - pos);
+  }
+
+  /* Escape characters not allowed in XML text */
+  void appendEscaped(const QString& text)
+  {
+    const QByteArray utf8 = text.toUtf8();
+    for(char c : utf8)
+    {
+      if(c == '<')
+        bytes.append("&lt;");
+      else if(c == '>')
+        bytes.append("&gt;");
+      else if(c == '&')
+        bytes.append("&amp;");
+      else
+        bytes.append(c);
+    }
+  }
+
+  QByteArray bytes, datePrefix;
+  qint64 lastDay = -1;
+  int depth = 0;
+};
+
+Q_DECL_CONSTEXPR qint64 GpxXmlWriter::MS_PER_DAY;
+Q_DECL_CONSTEXPR int GpxXmlWriter::MAX_DECIMALS;
+
 GpxIO::GpxIO()
 {
   errorMsg = tr("Cannot open file %1. Reason: %2");
@@ -112,16 +430,14 @@ void GpxIO::readPosGpx(atools::geo::PosD& pos, QString& name, atools::util::XmlS
 
 QString GpxIO::saveGpxStr(const atools::fs::gpx::GpxData& gpxData)
 {
-  QString gpxString;
-  QXmlStreamWriter writer(&gpxString);
-  saveGpxInternal(writer, gpxData);
-  return gpxString;
+  return QString::fromUtf8(saveGpxInternal(gpxData));
 }
 
 QByteArray GpxIO::saveGpxGz(const atools::fs::gpx::GpxData& gpxData)
 {
+  // Compress UTF-8 directly without converting to string
   QByteArray retval;
-  atools::zip::gzipCompress(saveGpxStr(gpxData).toUtf8(), retval);
+  atools::zip::gzipCompress(saveGpxInternal(gpxData), retval);
   return retval;
 }
 
@@ -130,24 +446,20 @@ void GpxIO::saveGpx(const QString& filename, const atools::fs::gpx::GpxData& gpx
   QFile gpxFile(filename);
   if(gpxFile.open(QIODevice::WriteOnly | QIODevice::Text))
   {
-    QXmlStreamWriter writer(&gpxFile);
-    saveGpxInternal(writer, gpxData);
+    gpxFile.write(saveGpxInternal(gpxData));
     gpxFile.close();
   }
   else
     throw Exception(errorMsg.arg(filename).arg(gpxFile.errorString()));
 }
 
-void GpxIO::saveGpxInternal(QXmlStreamWriter& writer, const atools::fs::gpx::GpxData& gpxData)
+QByteArray GpxIO::saveGpxInternal(const atools::fs::gpx::GpxData& gpxData)
 {
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-  writer.setCodec("UTF-8");
-#endif
-  writer.setAutoFormatting(true);
-  writer.setAutoFormattingIndent(2);
-
-  // <?xml version="1.0" encoding="UTF-8"?>
-  writer.writeStartDocument("1.0");
+  // Estimate about 120 bytes per trail point
+  int numPoints = 0;
+  for(const TrailPoints& track : gpxData.trails)
+    numPoints += track.size();
+  GpxXmlWriter writer(4096 + numPoints * 120 + gpxData.flightplan.size() * 160);
 
   // <gpx
   // xmlns="http://www.topografix.com/GPX/1/1"
@@ -155,16 +467,13 @@ void GpxIO::saveGpxInternal(QXmlStreamWriter& writer, const atools::fs::gpx::Gpx
   // creator="Program"
   // xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance"
   // xsi:schemaLocation="http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd">
-
-  writer.writeStartElement("gpx");
-
-  writer.writeDefaultNamespace("http://www.topografix.com/GPX/1/1");
-  writer.writeAttribute("version", "1.1");
-  writer.writeAttribute("creator", "Little Navmap");
-  writer.writeNamespace("http://www.w3.org/2001/XMLSchema-instance", "xsi");
-  writer.writeAttribute("xsi:schemaLocation", "http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd");
-
-  // writer.writeComment(programFileInfo());
+  writer.startElementAttr("gpx");
+  writer.attribute("xmlns", "http://www.topografix.com/GPX/1/1");
+  writer.attribute("version", "1.1");
+  writer.attribute("creator", "Little Navmap");
+  writer.attribute("xmlns:xsi", "http://www.w3.org/2001/XMLSchema-instance");
+  writer.attribute("xsi:schemaLocation", "http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd");
+  writer.endStartElement();
 
   // <metadata>
   // <link href="http://www.garmin.com">
@@ -172,18 +481,19 @@ void GpxIO::saveGpxInternal(QXmlStreamWriter& writer, const atools::fs::gpx::Gpx
   // </link>
   // <time>2009-10-17T22:58:43Z</time>
   // </metadata>
-  writer.writeStartElement("metadata");
-  writer.writeStartElement("link");
-  writer.writeAttribute("href", "https://www.littlenavmap.org");
-  writer.writeTextElement("text", atools::programFileInfo());
-  writer.writeEndElement(); // link
-  writer.writeEndElement(); // metadata
+  writer.startElement("metadata");
+  writer.startElementAttr("link");
+  writer.attribute("href", "https://www.littlenavmap.org");
+  writer.endStartElement();
+  writer.textElement("text", atools::programFileInfo());
+  writer.endElement("link");
+  writer.endElement("metadata");
 
   if(!gpxData.flightplan.isEmpty())
   {
-    writer.writeStartElement("rte");
-    writer.writeTextElement("name", gpxData.flightplan.getTitle() + tr(" - Flight Plan"));
-    writer.writeTextElement("desc", gpxData.flightplan.getDescription());
+    writer.startElement("rte");
+    writer.textElement("name", gpxData.flightplan.getTitle() + tr(" - Flight Plan"));
+    writer.textElement("desc", gpxData.flightplan.getDescription());
 
     // Write route ========================================================
     for(int i = 0; i < gpxData.flightplan.size(); i++)
@@ -212,60 +522,58 @@ void GpxIO::saveGpxInternal(QXmlStreamWriter& writer, const atools::fs::gpx::Gpx
       }
 
       // Write route point ===========
-      writer.writeStartElement("rtept");
-      writer.writeAttribute("lon", QString::number(entry.getPosition().getLonX(), 'f', 7));
-      writer.writeAttribute("lat", QString::number(entry.getPosition().getLatY(), 'f', 7));
-      writer.writeTextElement("ele", QString::number(atools::geo::feetToMeter(entry.getAltitude())));
+      writer.startElementAttr("rtept");
+      writer.attributeFixed("lon", entry.getPosition().getLonX(), 7);
+      writer.attributeFixed("lat", entry.getPosition().getLatY(), 7);
+      writer.endStartElement();
+      writer.textElementFixed("ele", atools::geo::feetToMeter(entry.getAltitude()), 2);
 
-      writer.writeTextElement("name", entry.getIdent());
-      writer.writeTextElement("desc", entry.getWaypointTypeAsFsxString());
+      writer.textElement("name", entry.getIdent());
+      writer.textElement("desc", entry.getWaypointTypeAsFsxString());
 
-      writer.writeEndElement(); // rtept
+      writer.endElement("rtept");
     }
 
-    writer.writeEndElement(); // rte
+    writer.endElement("rte");
   }
 
   // Write track ========================================================
   if(!gpxData.trails.isEmpty())
   {
-    writer.writeStartElement("trk");
+    writer.startElement("trk");
 
     if(!gpxData.flightplan.isEmpty())
-      writer.writeTextElement("name", QCoreApplication::applicationName() + tr(" - Track"));
+      writer.textElement("name", QCoreApplication::applicationName() + tr(" - Track"));
 
     for(const TrailPoints& track : gpxData.trails)
     {
       if(track.isEmpty())
         continue;
 
-      writer.writeStartElement("trkseg");
+      writer.startElement("trkseg");
 
       for(const TrailPoint& pos : track)
       {
-        writer.writeStartElement("trkpt");
-
-        writer.writeAttribute("lon", QString::number(pos.pos.getLonX(), 'f', 6));
-        writer.writeAttribute("lat", QString::number(pos.pos.getLatY(), 'f', 6));
-        writer.writeTextElement("ele", QString::number(atools::geo::feetToMeter(pos.pos.getAltitude())));
+        writer.startElementAttr("trkpt");
+        writer.attributeFixed("lon", pos.pos.getLonX(), 6);
+        writer.attributeFixed("lat", pos.pos.getLatY(), 6);
+        writer.endStartElement();
+        writer.textElementFixed("ele", atools::geo::feetToMeter(pos.pos.getAltitude()), 2);
 
         if(pos.timestampMs > 0)
-        {
-          // (UTC/Zulu) in ISO 8601 format: "yyyy-mm-ddThh:mm:ssZ" or "yyyy-MM-ddTHH:mm:ss.zzzZ"
-          // <time>2011-01-16T23:59:01Z</time>
-          // Changes time number to local if Qt::UTC is omitted
-          writer.writeTextElement("time", QDateTime::fromMSecsSinceEpoch(pos.timestampMs, Qt::UTC).toString(Qt::ISODateWithMs));
-        }
+          // (UTC/Zulu) in ISO 8601 format: "yyyy-MM-ddTHH:mm:ss.zzzZ"
+          // <time>2011-01-16T23:59:01.000Z</time>
+          writer.textElementTime("time", pos.timestampMs);
 
-        writer.writeEndElement(); // trkpt
+        writer.endElement("trkpt");
       }
-      writer.writeEndElement(); // trkseg
+      writer.endElement("trkseg");
     }
-    writer.writeEndElement(); // trk
+    writer.endElement("trk");
   }
 
-  writer.writeEndElement(); // gpx
-  writer.writeEndDocument();
+  writer.endElement("gpx");
+  return writer.finish();
 }
 
 void GpxIO::loadGpxStr(atools::fs::gpx::GpxData& gpxData, const QString& string)
@@ -279,8 +587,19 @@ void GpxIO::loadGpxStr(atools::fs::gpx::GpxData& gpxData, const QString& string)
 
 void GpxIO::loadGpxGz(atools::fs::gpx::GpxData& gpxData, const QByteArray& bytes)
 {
-  if(!bytes.isEmpty())
-    loadGpxStr(gpxData, atools::zip::gzipDecompress(bytes));
+  if(atools::zip::isGzipCompressed(bytes))
+  {
+    // Inflate while parsing instead of decompressing into a string first
+    QBuffer buffer;
+    buffer.setData(bytes);
+    buffer.open(QIODevice::ReadOnly);
+    atools::zip::GzipDevice gzipDevice(&buffer, atools::zip::GzipDevice::GZIP);
+    if(gzipDevice.open(QIODevice::ReadOnly))
+    {
+      atools::util::XmlStream xmlStream(&gzipDevice);
+      loadGpxInternal(gpxData, xmlStream);
+    }
+  }
 }
 
 void GpxIO::loadGpx(atools::fs::gpx::GpxData& gpxData, const QString& filename)
@@ -296,6 +615,148 @@ void GpxIO::loadGpx(atools::fs::gpx::GpxData& gpxData, const QString& filename)
     throw Exception(errorMsg.arg(filename).arg(gpxFile.errorString()));
 }
 
+QByteArray GpxIO::saveGpxBinary(const GpxData& gpxData, const QByteArray& sourceKey)
+{
+  QByteArray bytes;
+  int numPoints = 0;
+  for(const TrailPoints& trail : gpxData.trails)
+    numPoints += trail.size();
+  bytes.reserve(32 + sourceKey.size() + gpxData.flightplan.size() * 16 + numPoints * 8);
+
+  uchar magic[4];
+  qToLittleEndian<quint32>(BINARY_MAGIC, magic);
+  bytes.append(reinterpret_cast<const char *>(magic), 4);
+  bytes.append(static_cast<char>(BINARY_VERSION));
+  writeVarUInt(bytes, static_cast<quint64>(sourceKey.size()));
+  bytes.append(sourceKey);
+
+  // Route ==============================================
+  qint64 lonX = 0, latY = 0, alt = 0, time = 0;
+  writeVarUInt(bytes, static_cast<quint64>(gpxData.flightplan.size()));
+  for(const atools::fs::pln::FlightplanEntry& entry : gpxData.flightplan)
+  {
+    QByteArray ident = entry.getIdent().toUtf8();
+    writeVarUInt(bytes, static_cast<quint64>(ident.size()));
+    bytes.append(ident);
+
+    const Pos& pos = entry.getPosition();
+    writePosBinary(bytes, pos.getLonX(), pos.getLatY(), pos.getAltitude(), lonX, latY, alt);
+  }
+
+  // Trails ==============================================
+  writeVarUInt(bytes, static_cast<quint64>(gpxData.trails.size()));
+  for(const TrailPoints& trail : gpxData.trails)
+  {
+    writeVarUInt(bytes, static_cast<quint64>(trail.size()));
+    for(const TrailPoint& point : trail)
+    {
+      writePosBinary(bytes, point.pos.getLonX(), point.pos.getLatY(), point.pos.getAltitude(), lonX, latY, alt);
+      writeVarInt(bytes, point.timestampMs - time);
+      time = point.timestampMs;
+    }
+  }
+  return bytes;
+}
+
+bool GpxIO::loadGpxBinary(GpxData& gpxData, const QByteArray& bytes)
+{
+  gpxData.clear();
+
+  GpxBinaryReader reader(bytes);
+  reader.readHeader();
+
+  // Route ==============================================
+  qint64 lonX = 0, latY = 0, alt = 0, time = 0;
+  int numEntries = reader.readCount();
+  for(int i = 0; i < numEntries && reader.ok; i++)
+  {
+    atools::fs::pln::FlightplanEntry entry;
+    entry.setIdent(QString::fromUtf8(reader.readBytes()));
+    readPosBinary(reader, lonX, latY, alt);
+    entry.setPosition(Pos(lonX / BINARY_COORD_SCALE, latY / BINARY_COORD_SCALE, alt / BINARY_ALT_SCALE));
+    gpxData.flightplan.append(entry);
+    gpxData.flightplanRect.extend(entry.getPosition());
+  }
+
+  // Trails ==============================================
+  int numTrails = reader.readCount();
+  gpxData.trails.reserve(numTrails);
+  for(int i = 0; i < numTrails && reader.ok; i++)
+  {
+    TrailPoints trail;
+    int numPoints = reader.readCount();
+    trail.reserve(numPoints);
+    for(int j = 0; j < numPoints && reader.ok; j++)
+    {
+      readPosBinary(reader, lonX, latY, alt);
+      time += reader.readVarInt();
+
+      PosD pos(lonX / BINARY_COORD_SCALE, latY / BINARY_COORD_SCALE, alt / BINARY_ALT_SCALE);
+      trail.append(TrailPoint(pos, time));
+      gpxData.updateBoundaries(pos.asPos());
+    }
+    gpxData.trails.append(trail);
+  }
+
+  if(!reader.ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid binary trail data";
+    gpxData.clear();
+    return false;
+  }
+
+  gpxData.flightplan.adjustDepartureAndDestination(true);
+  return true;
+}
+
+bool GpxIO::loadGpxBinaryTrails(QVector<LineString>& trails, const QByteArray& bytes)
+{
+  trails.clear();
+
+  GpxBinaryReader reader(bytes);
+  reader.readHeader();
+
+  // Skip route
+  qint64 lonX = 0, latY = 0, alt = 0;
+  int numEntries = reader.readCount();
+  for(int i = 0; i < numEntries && reader.ok; i++)
+  {
+    reader.readBytes();
+    readPosBinary(reader, lonX, latY, alt);
+  }
+
+  int numTrails = reader.readCount();
+  trails.reserve(numTrails);
+  for(int i = 0; i < numTrails && reader.ok; i++)
+  {
+    LineString line;
+    int numPoints = reader.readCount();
+    line.reserve(numPoints);
+    for(int j = 0; j < numPoints && reader.ok; j++)
+    {
+      readPosBinary(reader, lonX, latY, alt);
+      reader.readVarInt(); // Timestamp
+      line.append(Pos(lonX / BINARY_COORD_SCALE, latY / BINARY_COORD_SCALE, alt / BINARY_ALT_SCALE));
+    }
+    trails.append(line);
+  }
+
+  if(!reader.ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid binary trail data";
+    trails.clear();
+    return false;
+  }
+  return true;
+}
+
+QByteArray GpxIO::getGpxBinarySourceKey(const QByteArray& bytes)
+{
+  GpxBinaryReader reader(bytes);
+  QByteArray key = reader.readHeader();
+  return reader.ok ? key : QByteArray();
+}
+
 void GpxIO::loadGpxInternal(atools::fs::gpx::GpxData& gpxData, atools::util::XmlStream& xmlStream)
 {
   QXmlStreamReader& reader = xmlStream.getReader();
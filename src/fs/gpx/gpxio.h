@@ -19,9 +19,9 @@
 #define ATOOLS_GPXIO_H
 
 #include <QCoreApplication>
+#include <QVector>
 
 class QXmlStreamReader;
-class QXmlStreamWriter;
 class QTextStream;
 
 namespace atools {
@@ -74,8 +74,25 @@ public:
   void loadGpxGz(atools::fs::gpx::GpxData& gpxData, const QByteArray& bytes);
   void loadGpx(atools::fs::gpx::GpxData& gpxData, const QString& filename);
 
+  /* Compact binary format for route and trail points. Coordinates are quantized to 1e-6 degree like in GPX,
+   * altitude to 0.1 ft and all values are stored as variable length deltas to the previous point.
+   * Needs about five to eight bytes per trail point.
+   * sourceKey is an optional key stored in the header which can be used to detect outdated data. */
+  QByteArray saveGpxBinary(const atools::fs::gpx::GpxData& gpxData, const QByteArray& sourceKey = QByteArray());
+
+  /* Load route and trail from binary format. Returns false if data is not valid. */
+  bool loadGpxBinary(atools::fs::gpx::GpxData& gpxData, const QByteArray& bytes);
+
+  /* Load only trail geometry from binary format without timestamps into one line string per trail segment.
+   * Returns false if data is not valid. */
+  bool loadGpxBinaryTrails(QVector<atools::geo::LineString>& trails, const QByteArray& bytes);
+
+  /* Get source key from header of binary data or empty if not valid */
+  static QByteArray getGpxBinarySourceKey(const QByteArray& bytes);
+
 private:
-  void saveGpxInternal(QXmlStreamWriter& writer, const atools::fs::gpx::GpxData& gpxData);
+  /* Build UTF-8 GPX document */
+  QByteArray saveGpxInternal(const atools::fs::gpx::GpxData& gpxData);
   void loadGpxInternal(atools::fs::gpx::GpxData& gpxData, util::XmlStream& xmlStream);
   void readPosGpx(atools::geo::PosD& pos, QString& name, util::XmlStream& xmlStream, QDateTime *timestamp = nullptr);
 
@@ -17,6 +17,9 @@
 
 #include "fs/navdatabase.h"
 #include "sql/sqldatabase.h"
+#include "sql/databaseswap.h"
+#include "sql/sqlpagecompression.h"
+#include "sql/sqlreportrunner.h"
 #include "sql/sqlscript.h"
 #include "fs/db/datawriter.h"
 #include "sql/sqlutil.h"
@@ -25,6 +28,11 @@
 #include "fs/scenery/addoncfg.h"
 #include "fs/db/airwayresolver.h"
 #include "fs/db/routeedgewriter.h"
+#include "fs/db/proceduregeometrywriter.h"
+#include "fs/db/postloadupdater.h"
+#include "fs/db/spatialorderwriter.h"
+#include "fs/db/taxigraphwriter.h"
+#include "fs/db/apronmeshwriter.h"
 #include "fs/progresshandler.h"
 #include "fs/scenery/fileresolver.h"
 #include "fs/scenery/addonpackage.h"
@@ -38,13 +46,18 @@
 #include "fs/scenery/languagejson.h"
 #include "fs/scenery/materiallib.h"
 #include "fs/scenery/contentxml.h"
+#include "util/parallel.h"
 
+#include <QCryptographicHash>
 #include <QDir>
 #include <QElapsedTimer>
 #include <QProcessEnvironment>
 #include <QQueue>
 #include <QStandardPaths>
 #include <QStringBuilder>
+#include <QThread>
+
+#include <atomic>
 
 namespace atools {
 namespace fs {
@@ -62,15 +75,30 @@ static const int PROGRESS_NUM_TASK_STEPS = 10;
 // runScript()
 static const int PROGRESS_NUM_SCRIPT_STEPS = PROGRESS_NUM_TASK_STEPS;
 
+/* Page size used for vacuum if tables are ordered spatially */
+static const int SPATIAL_ORDER_PAGE_SIZE = 8192;
+
 // AirwayResolver steps - larger number makes task take more time of progress bar
 static const int PROGRESS_NUM_RESOLVE_AIRWAY_STEPS = 1000;
 
 // createSchemaInternal()
 static const int PROGRESS_NUM_SCHEMA_STEPS = 8;
 
+// Maximum number of SQLite sorter worker threads for index creation (SQLITE_MAX_WORKER_THREADS)
+static const int MAX_INDEX_THREADS = 8;
+
+// Pragmas changed by the bulk load profile. Values are saved before and restored after loading.
+static const QStringList BULK_LOAD_PRAGMA_NAMES = {"journal_mode", "synchronous", "cache_size", "temp_store", "mmap_size"};
+
+// Fast but not crash safe settings while loading. Cache is 256 MB (negative is KiB) and mmap is 1 GB.
+static const QStringList BULK_LOAD_PRAGMAS = {"pragma journal_mode=off", "pragma synchronous=off",
+                                              "pragma cache_size=-262144", "pragma temp_store=memory",
+                                              "pragma mmap_size=1073741824"};
+
 using atools::sql::SqlScript;
 using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
+using atools::sql::SqlReportRunner;
 using atools::sql::SqlTransaction;
 using atools::fs::scenery::SceneryCfg;
 using atools::fs::scenery::AddOnCfg;
@@ -81,9 +109,34 @@ using atools::fs::scenery::AddOnPackage;
 using atools::fs::FsPaths;
 using atools::buildPathNoCase;
 
+/* Restores durable database settings on any exit of createInternal() if bulk load profile was enabled */
+class BulkLoadProfileRestore
+{
+public:
+  explicit BulkLoadProfileRestore(NavDatabase *navDatabase)
+    : navdb(navDatabase)
+  {
+  }
+
+  ~BulkLoadProfileRestore()
+  {
+    try
+    {
+      navdb->restoreBulkLoadProfile();
+    }
+    catch(atools::Exception& e)
+    {
+      qCritical() << Q_FUNC_INFO << "Caught exception" << e.what();
+    }
+  }
+
+private:
+  NavDatabase *navdb;
+};
+
 NavDatabase::NavDatabase(const NavDatabaseOptions *readerOptions, sql::SqlDatabase *sqlDb, NavDatabaseErrors *databaseErrors,
                          const QString& revision)
-  : db(sqlDb), errors(databaseErrors), options(readerOptions), gitRevision(revision)
+  : db(sqlDb), errors(databaseErrors), options(readerOptions), gitRevision(revision), profiler(sqlDb)
 {
 
 }
@@ -107,8 +160,23 @@ atools::fs::ResultFlags NavDatabase::compileDatabase()
     db->rollback();
   }
   else
+  {
     createDatabaseReportShort();
 
+    if(profiler.isEnabled())
+    {
+      qInfo().noquote().nospace() << "Compile profile" << endl << profiler.getReport();
+      try
+      {
+        profiler.writeReport(options->getProfileReportFile());
+      }
+      catch(atools::Exception& e)
+      {
+        qWarning() << Q_FUNC_INFO << e.what();
+      }
+    }
+  }
+
   if(result.testFlag(atools::fs::COMPILE_BASIC_VALIDATION_ERROR))
   {
     qWarning() << endl;
@@ -307,9 +375,11 @@ int NavDatabase::countXplaneSteps(ProgressHandler *progress)
   total += PROGRESS_NUM_TASK_STEPS; // "Collecting navaids for search"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for airport"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for search"
-  if(options->isVacuumDatabase())
+  if(options->isSpatialOrder())
+    total += PROGRESS_NUM_TASK_STEPS; // "Ordering tables by position"
+  if(options->isVacuumDatabase() || options->isSpatialOrder())
     total += PROGRESS_NUM_TASK_STEPS; // "Vacuum Database"
-  if(options->isAnalyzeDatabase())
+  if(options->isAnalyzeDatabase() || options->isSpatialOrder())
     total += PROGRESS_NUM_TASK_STEPS; // "Analyze Database"
 
   // Not used in production
@@ -420,6 +490,13 @@ int NavDatabase::countDfdSteps()
     total += PROGRESS_NUM_TASK_STEPS; // "Creating route edges for VOR and NDB"
     total += PROGRESS_NUM_TASK_STEPS; // "Creating route edges waypoints"
   }
+
+  if(options->isCreateProcedureGeometry())
+    total += PROGRESS_NUM_TASK_STEPS; // "Calculating procedure geometry"
+  if(options->isCreateTaxiGraph())
+    total += PROGRESS_NUM_TASK_STEPS; // "Building taxi graphs"
+  if(options->isCreateApronMesh())
+    total += PROGRESS_NUM_TASK_STEPS; // "Triangulating aprons"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for airport"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for search"
   total++; // "Creating indexes for route"
@@ -435,12 +512,16 @@ int NavDatabase::countDfdSteps()
     total++; // "Dropping All Indexes"
   }
 
+  // "Ordering tables by position"
+  if(options->isSpatialOrder())
+    total += PROGRESS_NUM_TASK_STEPS;
+
   // "Vacuum Database"
-  if(options->isVacuumDatabase())
+  if(options->isVacuumDatabase() || options->isSpatialOrder())
     total += PROGRESS_NUM_TASK_STEPS;
 
   // "Analyze Database"
-  if(options->isAnalyzeDatabase())
+  if(options->isAnalyzeDatabase() || options->isSpatialOrder())
     total += PROGRESS_NUM_TASK_STEPS;
 
   total += 4; // Correction value
@@ -538,9 +619,11 @@ int NavDatabase::countMsSimSteps()
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for airport"
   total += PROGRESS_NUM_TASK_STEPS; // "Clean up runways"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for search"
-  if(options->isVacuumDatabase())
+  if(options->isSpatialOrder())
+    total += PROGRESS_NUM_TASK_STEPS; // "Ordering tables by position"
+  if(options->isVacuumDatabase() || options->isSpatialOrder())
     total += PROGRESS_NUM_TASK_STEPS; // "Vacuum Database"
-  if(options->isAnalyzeDatabase())
+  if(options->isAnalyzeDatabase() || options->isSpatialOrder())
     total += PROGRESS_NUM_TASK_STEPS; // "Analyze Database"
 
   // Not used in production
@@ -560,14 +643,38 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   ProgressHandler progress;
   progress.setProgressCallback(options->getProgressCallback());
   progress.setCallDefaultCallback(options->isCallDefaultCallback());
+  progress.setCallbackIntervalMs(options->getProgressCallbackIntervalMs());
 
   progress.setTotal(1000000000);
 
+  // Record time and rows for each phase if requested
+  profiler.clear();
+  profiler.setEnabled(!options->getProfileReportFile().isEmpty());
+  CompileProfiler::Scope profileScope(&profiler, "compile");
+
   if(options->isAutocommit())
     db->setAutocommit(true);
 
+  // Switch to fast loading settings - restored when leaving this method
+  startBulkLoadProfile();
+  BulkLoadProfileRestore bulkLoadRestore(this);
+  QElapsedTimer phaseTimer;
+  phaseTimer.start();
+
+  // Directory listings are filled while counting and reused when loading
+  // Use listings from last run if requested - these are validated against directory modification times
+  fileResolverCache.clear();
+  if(!options->getScanCacheFile().isEmpty())
+    fileResolverCache.load(options->getScanCacheFile());
+
+  // Parsed material libraries and translations from last run
+  parseCache.clear();
+  if(!options->getParseCacheFile().isEmpty())
+    parseCache.load(options->getParseCacheFile());
+
   // ==============================================================================
   // Calculate the total number of progress steps
+  profiler.next("count files");
   FsPaths::SimulatorType sim = options->getSimulatorType();
   int total = 0;
   if(FsPaths::isAnyXplane(sim))
@@ -605,15 +712,25 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   if(aborted)
     return result;
 
+  if(options->isIncrementalCompile() && isSceneryUpToDate())
+  {
+    // Nothing to do - keep database as is
+    result |= atools::fs::COMPILE_UP_TO_DATE;
+    return result;
+  }
+
   qDebug() << "=P=== Total Progress" << total;
 
   progress.reset();
   progress.setTotal(total);
 
+  profiler.next("schema");
   createSchemaInternal(&progress);
   if(aborted)
     return result;
 
+  qDebug() << Q_FUNC_INFO << "Phase schema" << phaseTimer.restart() << "ms";
+
   // -----------------------------------------------------------------------
   // Create empty data writer pointers which will read all files and fill the database
   // Pointers will be initialized on demand/compilation type and be delete on exit (like thrown exception)
@@ -627,6 +744,7 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
 
   // ================================================================================================
   // Start compilation
+  profiler.begin("load");
   if(sim == FsPaths::NAVIGRAPH)
   {
     // Create a single Navigraph scenery area
@@ -638,6 +756,7 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
 
     // Load Navigraph from source database ======================================================
     dfdCompiler.reset(new atools::fs::ng::DfdCompiler(*db, *options, &progress));
+    profiler.addBytesRead(QFileInfo(options->getSourceDatabase()).size());
     loadDfd(&progress, dfdCompiler.data(), area);
     dfdCompiler->close();
   }
@@ -652,6 +771,7 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
 
     // Load X-Plane scenery database ======================================================
     xpDataCompiler.reset(new atools::fs::xp::XpDataCompiler(*db, *options, &progress, errors));
+    xpDataCompiler->setProfiler(&profiler);
     loadXplane(&progress, xpDataCompiler.data(), area);
     xpDataCompiler->close();
   }
@@ -659,35 +779,33 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   {
     // Load FSX / P3D scenery database ======================================================
     fsDataWriter.reset(new atools::fs::db::DataWriter(*db, *options, &progress));
-
-    // Base is
-    // C:\Users\alex\AppData\Local\Packages\Microsoft.FlightSimulator_8wekyb3d8bbwe\LocalCache\Packages
-    // C:\Users\alex\AppData\Local\Packages\Microsoft.FlightSimulator_8wekyb3d8bbwe\LocalCache\Packages\Official\OneStore\fs-base\en-US.locPak
-
-    // Load the language index for lookup for airport names and more - first from fs-base
-    QString packageBase = options->getMsfsOfficialPath();
-    QFileInfo langFile = buildPathNoCase({packageBase, "fs-base", options->getLanguage() % ".locPak"});
-    if(!atools::checkFile(Q_FUNC_INFO, langFile, true /* warn */))
-      langFile = buildPathNoCase({packageBase, "fs-base", "en-US.locPak"});
-
-    // Load the language index for lookup for airport names from fs-base-genericairports
-    QFileInfo langFileGeneric = buildPathNoCase({packageBase, "fs-base-genericairports", options->getLanguage() % ".locPak"});
-    if(!atools::checkFile(Q_FUNC_INFO, langFileGeneric, true /* warn */))
-      langFileGeneric = buildPathNoCase({packageBase, "fs-base-genericairports", "en-US.locPak"});
+    fsDataWriter->setProfiler(&profiler);
+    fsDataWriter->setFileResolverCache(&fileResolverCache);
 
     // Load translation file in current language for airport names ====================================
-    languageIndex.reset(new scenery::LanguageJson());
-    languageIndex->clear();
-    if(langFile.exists() && langFile.isFile())
-      languageIndex->readFromFile(langFile.filePath(), {"AIRPORT"});
-    if(langFileGeneric.exists() && langFileGeneric.isFile())
-      languageIndex->readFromFile(langFileGeneric.filePath(), {"AIRPORT"});
-    fsDataWriter->setLanguageIndex(languageIndex.data());
+    if(options->getSharedLanguageIndex() != nullptr)
+      // Loaded once by the caller for several compilations
+      fsDataWriter->setLanguageIndex(options->getSharedLanguageIndex());
+    else
+    {
+      languageIndex.reset(new scenery::LanguageJson());
+      languageIndex->setCache(parseCacheOrNull());
+      languageIndex->setLazy(options->isMsfsLazyLoad());
+      readLanguageIndex(*languageIndex, *options);
+      fsDataWriter->setLanguageIndex(languageIndex.data());
+    }
 
     // Load the two official material libraries ================================
-    materialLib.reset(new scenery::MaterialLib(options));
-    materialLib->readOfficial(packageBase);
-    fsDataWriter->setMaterialLib(materialLib.data());
+    if(options->getSharedMaterialLib() != nullptr)
+      fsDataWriter->setMaterialLib(options->getSharedMaterialLib());
+    else
+    {
+      materialLib.reset(new scenery::MaterialLib(options));
+      materialLib->setCache(parseCacheOrNull());
+      materialLib->setLazy(options->isMsfsLazyLoad());
+      materialLib->readOfficial(options->getMsfsOfficialPath());
+      fsDataWriter->setMaterialLib(materialLib.data());
+    }
 
     // Load all community and official scenery/BGL files  =====================================
     loadMsfs(&progress, fsDataWriter.data(), sceneryCfg);
@@ -697,13 +815,22 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   {
     // Load FSX / P3D scenery database ======================================================
     fsDataWriter.reset(new atools::fs::db::DataWriter(*db, *options, &progress));
+    fsDataWriter->setProfiler(&profiler);
+    fsDataWriter->setFileResolverCache(&fileResolverCache);
     loadFsxP3d(&progress, fsDataWriter.data(), sceneryCfg);
     fsDataWriter->close();
   }
+  profiler.end();
 
   if(aborted)
     return result;
 
+  if(!options->getScanCacheFile().isEmpty() && !fileResolverCache.isEmpty())
+    fileResolverCache.save(options->getScanCacheFile());
+  fileResolverCache.clear();
+
+  qDebug() << Q_FUNC_INFO << "Phase loading" << phaseTimer.restart() << "ms";
+
   // ===========================================================================
   // Loading is done here - now continue with the post process steps
 
@@ -711,7 +838,8 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   {
     // All simulators ====================
     // Read tmp_airway_point table, connect all waypoints and write the ordered result into the airway table
-    atools::fs::db::AirwayResolver resolver(db, progress);
+    profiler.next("airway resolver");
+    atools::fs::db::AirwayResolver resolver(db, progress, options->getReaderThreads());
 
     if(sim != FsPaths::NAVIGRAPH && !FsPaths::isAnyXplane(sim))
       // Drop large segments only for the borked data of FSX/P3D/MSFS - default is 8000 nm
@@ -731,13 +859,15 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   }
 
   // Set the nav_ids (VOR, NDB) in the waypoint table and update the airway counts
-  if((aborted = runScript(&progress, "fs/db/update_wp_ids.sql", tr("Updating waypoints"))))
+  if((aborted = runPostLoadUpdate(&progress, "fs/db/update_wp_ids.sql", tr("Updating waypoints"),
+                                  &atools::fs::db::PostLoadUpdater::updateWaypointIds)))
     return result;
 
   if(!FsPaths::isAnyXplane(sim) && sim != FsPaths::NAVIGRAPH)
   {
     // Assign airport ids based on stored idents for waypoint and ndb
-    if((aborted = runScript(&progress, "fs/db/update_nav_ids.sql", tr("Updating Navaids"))))
+    if((aborted = runPostLoadUpdate(&progress, "fs/db/update_nav_ids.sql", tr("Updating Navaids"),
+                                    &atools::fs::db::PostLoadUpdater::updateNavaidAirportIds)))
       return result;
   }
 
@@ -765,7 +895,8 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   {
     // The ids are already updated when reading the X-Plane data
     // Set runway end ids into the ILS
-    if((aborted = runScript(&progress, "fs/db/update_airport_ils.sql", tr("Updating ILS"))))
+    if((aborted = runPostLoadUpdate(&progress, "fs/db/update_airport_ils.sql", tr("Updating ILS"),
+                                    &atools::fs::db::PostLoadUpdater::updateAirportIls)))
       return result;
   }
 
@@ -787,14 +918,48 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
       return result;
 
     // Create a network of VOR and NDB stations that allow radio navaid routing
-    atools::fs::db::RouteEdgeWriter edgeWriter(db);
+    profiler.next("route edges");
+    atools::fs::db::RouteEdgeWriter edgeWriter(db, options->getReaderThreads());
     edgeWriter.run();
 
     if((aborted = runScript(&progress, "fs/db/populate_route_edge.sql", tr("Creating route edges waypoints"))))
       return result;
   }
 
-  if((aborted = runScript(&progress, "fs/db/finish_airport_schema.sql", tr("Creating indexes for airport"))))
+  if(options->isCreateProcedureGeometry())
+  {
+    if((aborted = progress.reportOther(tr("Calculating procedure geometry"))))
+      return result;
+
+    // Precalculate leg geometry for approaches and transitions
+    profiler.next("procedure geometry");
+    atools::fs::db::ProcedureGeometryWriter procedureGeometryWriter(db, options->getReaderThreads());
+    procedureGeometryWriter.run();
+  }
+
+  if(options->isCreateTaxiGraph())
+  {
+    if((aborted = progress.reportOther(tr("Building taxi graphs"))))
+      return result;
+
+    // Ground routing graph for each airport from taxi paths
+    profiler.next("taxi graph");
+    atools::fs::db::TaxiGraphWriter taxiGraphWriter(db, options->getReaderThreads());
+    taxiGraphWriter.run();
+  }
+
+  if(options->isCreateApronMesh())
+  {
+    if((aborted = progress.reportOther(tr("Triangulating aprons"))))
+      return result;
+
+    // Flattened and triangulated pavement for airport diagrams
+    profiler.next("apron mesh");
+    atools::fs::db::ApronMeshWriter apronMeshWriter(db, options->getReaderThreads());
+    apronMeshWriter.run();
+  }
+
+  if((aborted = runIndexScript(&progress, "fs/db/finish_airport_schema.sql", tr("Creating indexes for airport"))))
     return result;
 
   if(!FsPaths::isAnyXplane(sim) && sim != FsPaths::NAVIGRAPH)
@@ -803,18 +968,18 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
       return result;
   }
 
-  if((aborted = runScript(&progress, "fs/db/finish_schema.sql", tr("Creating indexes for search"))))
+  if((aborted = runIndexScript(&progress, "fs/db/finish_schema.sql", tr("Creating indexes for search"))))
     return result;
 
   if(options->isCreateAirportTables())
   {
-    if((aborted = runScript(&progress, "fs/db/finish_schema_airport.sql", tr("Creating medium and large airport tables"))))
+    if((aborted = runIndexScript(&progress, "fs/db/finish_schema_airport.sql", tr("Creating medium and large airport tables"))))
       return result;
   }
 
   if(options->isCreateRouteTables())
   {
-    if((aborted = runScript(&progress, "fs/db/finish_schema_route.sql", tr("Creating indexes for route"))))
+    if((aborted = runIndexScript(&progress, "fs/db/finish_schema_route.sql", tr("Creating indexes for route"))))
       return result;
   }
 
@@ -824,18 +989,28 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
       return result;
 
     // Load translation files with all languages into the database to allow translating the aircraft names
+    profiler.next("translations");
     scenery::LanguageJson language;
+    language.setCache(parseCacheOrNull());
     language.readFromDirToDb(db, buildPathNoCase({options->getMsfsOfficialPath(), "fs-base"}),
                              "*.locPak", {"ATCCOM.AC_MODEL", "ATCCOM.ATC_NAME"});
+
+    if(!options->getParseCacheFile().isEmpty() && parseCache.size() > 0)
+      parseCache.save(options->getParseCacheFile());
+    parseCache.clear();
   }
 
   // =====================================================================
   // Update the metadata in the database
+  profiler.next("metadata");
   atools::fs::db::DatabaseMeta databaseMetadata(db);
 
   if(sim == FsPaths::MSFS && result.testFlag(atools::fs::COMPILE_MSFS_NAVIGRAPH_FOUND))
     databaseMetadata.addProperty(atools::fs::db::PROPERTYNAME_MSFS_NAVIGRAPH_FOUND);
 
+  if(!sceneryFingerprint.isEmpty())
+    databaseMetadata.addProperty(atools::fs::db::PROPERTYNAME_SCENERY_FINGERPRINT, sceneryFingerprint);
+
   if(!xpDataCompiler.isNull())
     databaseMetadata.setAiracCycle(xpDataCompiler->getAiracCycle());
   if(!dfdCompiler.isNull())
@@ -856,6 +1031,8 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
     // database is kept locked by queries - need to close this late to avoid statistics generation for attached
     dfdCompiler->detachDatabase();
 
+  qDebug() << Q_FUNC_INFO << "Phase post process" << phaseTimer.restart() << "ms";
+
   // ================================================================================================
   // Done here - now only some options statistics and reports are left
 
@@ -864,11 +1041,13 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
     if((aborted = progress.reportOther(tr("Creating Database preparation Script"))))
       return result;
 
+    profiler.next("preparation script");
     createPreparationScript();
   }
 
   if(options->isBasicValidation())
   {
+    profiler.next("basic validation");
     bool foundBasicValidationError = false;
     basicValidation(&progress, foundBasicValidationError);
     if(foundBasicValidationError)
@@ -878,6 +1057,7 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   if(options->isDatabaseReport())
   {
     // Do a report of problems rather than failing totally during loading
+    profiler.next("database report");
     if(!fsDataWriter.isNull())
       fsDataWriter->logResults();
     createDatabaseReport(&progress);
@@ -888,24 +1068,56 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
     if((aborted = progress.reportOther(tr("Dropping All Indexes"))))
       return result;
 
+    profiler.next("drop indexes");
     dropAllIndexes();
   }
-  if(options->isVacuumDatabase())
+
+  if(options->isSpatialOrder())
+  {
+    if((aborted = progress.reportOtherInc(tr("Ordering tables by position"), PROGRESS_NUM_TASK_STEPS)))
+      return result;
+
+    // Renumber rows in Hilbert curve order - vacuum below rewrites the pages in the new order
+    profiler.next("spatial order");
+    atools::fs::db::SpatialOrderWriter(db).run();
+    db->commit();
+
+    // Larger pages reduce tree depth and the number of reads for the read only database
+    // Page size is changed by vacuum
+    db->exec("pragma page_size=" % QString::number(SPATIAL_ORDER_PAGE_SIZE));
+  }
+
+  if(options->isVacuumDatabase() || options->isSpatialOrder())
   {
     if((aborted = progress.reportOtherInc(tr("Vacuum Database"), PROGRESS_NUM_TASK_STEPS)))
       return result;
 
+    profiler.next("vacuum");
     db->vacuum();
   }
 
-  if(options->isAnalyzeDatabase())
+  if(options->isAnalyzeDatabase() || options->isSpatialOrder())
   {
     if((aborted = progress.reportOtherInc(tr("Analyze Database"), PROGRESS_NUM_TASK_STEPS)))
       return result;
 
+    profiler.next("analyze");
     db->analyze();
   }
 
+  if(options->isBulkLoadProfile())
+  {
+    // Restore durable settings now to include them in the timing
+    profiler.next("restore bulk load profile");
+    restoreBulkLoadProfile();
+
+    // Let SQLite update statistics where needed if not done above
+    if(!options->isAnalyzeDatabase())
+      db->exec("pragma optimize");
+  }
+
+  qDebug() << Q_FUNC_INFO << "Phase finish" << phaseTimer.restart() << "ms";
+
   // Send the final progress report
   progress.reportFinish();
 
@@ -925,17 +1137,25 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
   dfdCompiler->initQueries();
   dfdCompiler->compileMagDeclBgl();
   dfdCompiler->readHeader();
+  profiler.next("write mora");
   dfdCompiler->writeMora();
 
   if(options->isIncludedNavDbObject(atools::fs::type::AIRPORT))
   {
+    profiler.next("write airports");
     dfdCompiler->writeAirports();
 
     if(options->isIncludedNavDbObject(atools::fs::type::RUNWAY))
+    {
+      profiler.next("write runways");
       dfdCompiler->writeRunways();
+    }
 
     if(options->isIncludedNavDbObject(atools::fs::type::PARKING))
+    {
+      profiler.next("write parking");
       dfdCompiler->writeParking();
+    }
   }
 
   if(options->isIncludedNavDbObject(atools::fs::type::WAYPOINT) ||
@@ -944,22 +1164,27 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
      options->isIncludedNavDbObject(atools::fs::type::MARKER) ||
      options->isIncludedNavDbObject(atools::fs::type::ILS))
   {
+    profiler.next("write navaids");
     dfdCompiler->writeNavaids();
+    profiler.next("write pathpoints");
     dfdCompiler->writePathpoints();
   }
 
   if(options->isIncludedNavDbObject(atools::fs::type::BOUNDARY))
   {
+    profiler.next("write airspaces");
     dfdCompiler->writeAirspaces();
+    profiler.next("write airspace com");
     dfdCompiler->writeAirspaceCom();
   }
 
+  profiler.next("write com");
   dfdCompiler->writeCom();
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
     return true;
 
   if(options->isDeduplicate())
@@ -970,26 +1195,35 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
   }
 
   if(options->isIncludedNavDbObject(atools::fs::type::AIRWAY))
+  {
+    profiler.next("write airways");
     dfdCompiler->writeAirways();
+  }
 
   // Create waypoints for fix resolution in procedures - has to be done after airway processing
   if((aborted = runScript(progress, "fs/db/dfd/populate_navaids_proc.sql", tr("Creating waypoints for procedures"))))
     return true;
 
+  profiler.next("update magvar");
   dfdCompiler->updateMagvar();
+  profiler.next("update tacan channel");
   dfdCompiler->updateTacanChannel();
+  profiler.next("update ils geometry");
   dfdCompiler->updateIlsGeometry();
 
   if(options->isIncludedNavDbObject(atools::fs::type::APPROACH))
+  {
+    profiler.next("write procedures");
     dfdCompiler->writeProcedures();
+  }
   db->commit();
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
   db->commit();
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
     return true;
 
   db->commit();
@@ -1000,8 +1234,10 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
 
   db->commit();
 
+  profiler.next("write airport msa");
   dfdCompiler->writeAirportMsa();
 
+  profiler.next("update tree letter airport codes");
   dfdCompiler->updateTreeLetterAirportCodes();
 
   db->commit();
@@ -1022,6 +1258,7 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
   if((aborted = xpDataCompiler->writeBasepathScenery()))
     return true;
 
+  profiler.next("compile mag decl bgl");
   if((aborted = xpDataCompiler->compileMagDeclBgl()))
     return true;
 
@@ -1030,25 +1267,30 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
     // Airports are overloaded by ident - first coming in overload the rest
 
     // X-Plane 11/Custom Scenery/KSEA Demo Area/Earth nav data/apt.dat
+    profiler.next("compile user include apt");
     if((aborted = xpDataCompiler->compileUserIncludeApt())) // Add-on
       return true;
 
     // X-Plane 11/Custom Scenery/KSEA Demo Area/Earth nav data/apt.dat
+    profiler.next("compile custom apt");
     if((aborted = xpDataCompiler->compileCustomApt())) // Add-on
       return true;
 
     if(options->getSimulatorType() == FsPaths::XPLANE_11)
     {
       // X-Plane 11/Custom Scenery/Global Airports/Earth nav data/apt.dat
+      profiler.next("compile custom global apt");
       if((aborted = xpDataCompiler->compileCustomGlobalApt()))
         return true;
 
       // X-Plane 11/Resources/default scenery/default apt dat/Earth nav data/apt.dat
       // Mandatory
+      profiler.next("compile default apt");
       if((aborted = xpDataCompiler->compileDefaultApt()))
         return true;
     }
 
+    profiler.next("compile earth mora");
     if((aborted = xpDataCompiler->compileEarthMora()))
       return true;
   }
@@ -1056,6 +1298,7 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
   if(options->getSimulatorType() == FsPaths::XPLANE_12)
   {
     // X-Plane 12/Global Scenery/Global Airports/Earth nav data/apt.dat
+    profiler.next("compile global apt12");
     if((aborted = xpDataCompiler->compileGlobalApt12()))
       return true;
   }
@@ -1063,6 +1306,7 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
   if(options->isIncludedNavDbObject(atools::fs::type::ILS))
   {
     // ILS corrections - "X-PLane/Custom Scenery/Global Airports/Earth nav data/earth_nav.dat"
+    profiler.next("compile localizers");
     if((aborted = xpDataCompiler->compileLocalizers()))
       return true;
   }
@@ -1070,10 +1314,12 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
   if(options->isIncludedNavDbObject(atools::fs::type::WAYPOINT))
   {
     // In resources or Custom Data - mandatory
+    profiler.next("compile earth fix");
     if((aborted = xpDataCompiler->compileEarthFix()))
       return true;
 
     // Optional user data
+    profiler.next("compile user fix");
     if((aborted = xpDataCompiler->compileUserFix()))
       return true;
   }
@@ -1084,23 +1330,26 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
      options->isIncludedNavDbObject(atools::fs::type::ILS))
   {
     // In resources or Custom Data - mandatory
+    profiler.next("compile earth nav");
     if((aborted = xpDataCompiler->compileEarthNav()))
       return true;
 
     // Optional user data
+    profiler.next("compile user nav");
     if((aborted = xpDataCompiler->compileUserNav()))
       return true;
   }
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
     return true;
 
   if(options->isIncludedNavDbObject(atools::fs::type::BOUNDARY))
   {
     // Airspaces
+    profiler.next("compile airspaces");
     if((aborted = xpDataCompiler->compileAirspaces()))
       return true;
   }
@@ -1115,23 +1364,27 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
   if(options->isIncludedNavDbObject(atools::fs::type::AIRWAY))
   {
     // In resources or Custom Data - mandatory
+    profiler.next("compile earth airway");
     if((aborted = xpDataCompiler->compileEarthAirway()))
       return true;
 
     if((aborted = runScript(progress, "fs/db/xplane/prepare_airway.sql", tr("Preparing Airways"))))
       return true;
 
+    profiler.next("post process earth airway");
     if((aborted = xpDataCompiler->postProcessEarthAirway()))
       return true;
   }
 
   if(options->isIncludedNavDbObject(atools::fs::type::AIRPORT))
   {
+    profiler.next("compile earth airport msa");
     if((aborted = xpDataCompiler->compileEarthAirportMsa()))
       return true;
   }
   db->commit();
 
+  profiler.next("compile earth holding");
   if((aborted = xpDataCompiler->compileEarthHolding()))
     return true;
 
@@ -1139,6 +1392,7 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
 
   if(options->isIncludedNavDbObject(atools::fs::type::APPROACH))
   {
+    profiler.next("compile cifp");
     if((aborted = xpDataCompiler->compileCifp()))
       return true;
   }
@@ -1189,6 +1443,8 @@ bool NavDatabase::loadFsxP3dMsfsSimulator(ProgressHandler *progress, db::DataWri
                                           const QList<atools::fs::scenery::SceneryArea>& areas)
 {
   scenery::MaterialLib materialLib(options);
+  materialLib.setCache(parseCacheOrNull());
+  materialLib.setLazy(options->isMsfsLazyLoad());
   for(const SceneryArea& area : areas)
   {
     if((area.isActive() || options->isReadInactive()) && options->isIncludedLocalPath(area.getLocalPath()))
@@ -1241,10 +1497,10 @@ bool NavDatabase::loadFsxP3dMsfsSimulator(ProgressHandler *progress, db::DataWri
 
 bool NavDatabase::loadFsxP3dMsfsPost(ProgressHandler *progress)
 {
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
-  if((aborted = runScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
+  if((aborted = runIndexScript(progress, "fs/db/create_indexes_post_load_boundary.sql", tr("Creating boundary indexes"))))
     return true;
 
   if(options->isDeduplicate())
@@ -1261,27 +1517,46 @@ bool NavDatabase::basicValidation(ProgressHandler *progress, bool& foundBasicVal
   if((aborted = progress->reportOther(tr("Basic Validation"))))
     return true;
 
+  // Read-only connections see committed data only
+  db->commit();
+
+  // Count rows of all tables concurrently
+  std::atomic_bool error(false);
+  SqlReportRunner runner(db, options->getReaderThreads());
   const QMap<QString, int>& basicValidationTables = options->getBasicValidationTables();
   for(auto it = basicValidationTables.constBegin(); it != basicValidationTables.constEnd(); ++it)
-    basicValidateTable(it.key(), it.value(), foundBasicValidationError);
+  {
+    QString table = it.key();
+    int minCount = it.value();
+    runner.addJob([table, minCount, &error](QDebug& out, const SqlUtil& util) -> void {
+      if(basicValidateTable(out, util, table, minCount))
+        error = true;
+    });
+  }
+
+  QDebug info(qInfo());
+  runner.run(info);
+
+  if(error)
+    foundBasicValidationError = true;
 
   return false;
 }
 
-void NavDatabase::basicValidateTable(const QString& table, int minCount, bool& foundBasicValidationError)
+bool NavDatabase::basicValidateTable(QDebug& out, const SqlUtil& util, const QString& table, int minCount)
 {
-  SqlUtil util(db);
   if(!util.hasTable(table))
     throw Exception("Table \"" % table % "\" not found.");
 
-  int count = 0;
-  if((count = util.rowCount(table)) < minCount)
+  int count = util.rowCount(table);
+  if(count < minCount)
   {
     qWarning() << "*** Table" << table << "has only" << count << "rows. Minimum required is" << minCount << "***";
-    foundBasicValidationError = true;
+    return true;
   }
   else
-    qInfo() << "Table" << table << "is OK. Has" << count << "rows. Minimum required is" << minCount;
+    out << "Table" << table << "is OK. Has" << count << "rows. Minimum required is" << minCount << endl;
+  return false;
 }
 
 void NavDatabase::runPreparationPost245(atools::sql::SqlDatabase& db)
@@ -1311,6 +1586,88 @@ void NavDatabase::runPreparationPost245(atools::sql::SqlDatabase& db)
   db.commit();
 }
 
+atools::fs::ResultFlags NavDatabase::compileDatabaseSwap(const QString& filename,
+                                                         const NavDatabaseOptions *readerOptions,
+                                                         NavDatabaseErrors *databaseErrors, const QString& revision,
+                                                         const QStringList& pragmas)
+{
+  qDebug() << Q_FUNC_INFO << filename;
+
+  QString temporaryFile = atools::sql::DatabaseSwap::temporaryFilename(filename);
+  atools::sql::DatabaseSwap::removeTemporary(filename);
+
+  // Connection is local to this thread and call
+  QString connectionName = QString("NavDatabaseSwap%1").arg(reinterpret_cast<quintptr>(QThread::currentThread()));
+  atools::fs::ResultFlags result;
+  try
+  {
+    atools::sql::SqlDatabase tempDb(atools::sql::SqlDatabase::addDatabase("QSQLITE", connectionName));
+    tempDb.setDatabaseName(temporaryFile);
+    tempDb.open(pragmas);
+
+    result = NavDatabase(readerOptions, &tempDb, databaseErrors, revision).compileDatabase();
+
+    if(!result.testFlag(atools::fs::COMPILE_CANCELED))
+    {
+      // Clean single file which can be renamed
+      tempDb.commit();
+      tempDb.executePragmas({"pragma journal_mode=delete"});
+      tempDb.commit();
+    }
+    tempDb.close();
+  }
+  catch(...)
+  {
+    atools::sql::SqlDatabase::removeDatabase(connectionName);
+    atools::sql::DatabaseSwap::removeTemporary(filename);
+    throw;
+  }
+  atools::sql::SqlDatabase::removeDatabase(connectionName);
+
+  if(result.testFlag(atools::fs::COMPILE_CANCELED))
+    atools::sql::DatabaseSwap::removeTemporary(filename);
+  else
+    atools::sql::DatabaseSwap::instance().publish(temporaryFile, filename);
+
+  return result;
+}
+
+void NavDatabase::compactForDistribution(atools::sql::SqlDatabase& db, const QString& targetFile)
+{
+  qDebug() << Q_FUNC_INFO << db.databaseName() << "to" << targetFile;
+
+  // The compressed file is read only and cannot use WAL
+  db.commit();
+  db.executePragmas({"pragma journal_mode=delete"});
+  db.vacuum();
+
+  atools::sql::SqlPageCompression::compress(db.databaseName(), targetFile);
+}
+
+void NavDatabase::readLanguageIndex(scenery::LanguageJson& languageIndex, const NavDatabaseOptions& opts)
+{
+  // Base is
+  // C:\Users\alex\AppData\Local\Packages\Microsoft.FlightSimulator_8wekyb3d8bbwe\LocalCache\Packages
+  // C:\Users\alex\AppData\Local\Packages\Microsoft.FlightSimulator_8wekyb3d8bbwe\LocalCache\Packages\Official\OneStore\fs-base\en-US.locPak
+
+  // Load the language index for lookup for airport names and more - first from fs-base
+  QString packageBase = opts.getMsfsOfficialPath();
+  QFileInfo langFile = buildPathNoCase({packageBase, "fs-base", opts.getLanguage() % ".locPak"});
+  if(!atools::checkFile(Q_FUNC_INFO, langFile, true /* warn */))
+    langFile = buildPathNoCase({packageBase, "fs-base", "en-US.locPak"});
+
+  // Load the language index for lookup for airport names from fs-base-genericairports
+  QFileInfo langFileGeneric = buildPathNoCase({packageBase, "fs-base-genericairports", opts.getLanguage() % ".locPak"});
+  if(!atools::checkFile(Q_FUNC_INFO, langFileGeneric, true /* warn */))
+    langFileGeneric = buildPathNoCase({packageBase, "fs-base-genericairports", "en-US.locPak"});
+
+  languageIndex.clear();
+  if(langFile.exists() && langFile.isFile())
+    languageIndex.readFromFile(langFile.filePath(), {"AIRPORT"});
+  if(langFileGeneric.exists() && langFileGeneric.isFile())
+    languageIndex.readFromFile(langFileGeneric.filePath(), {"AIRPORT"});
+}
+
 void NavDatabase::runPreparationScript(atools::sql::SqlDatabase& db)
 {
   qDebug() << Q_FUNC_INFO;
@@ -1377,6 +1734,12 @@ bool NavDatabase::createDatabaseReport(ProgressHandler *progress)
   QDebug info(qInfo());
   atools::sql::SqlUtil util(db);
 
+  // Read-only connections of the runner see committed data only
+  db->commit();
+
+  // Each section runs its queries concurrently and prints the results in order
+  SqlReportRunner runner(db, options->getReaderThreads());
+
   if((aborted = progress->reportOther(tr("Creating table statistics"))))
     return true;
 
@@ -1387,67 +1750,178 @@ bool NavDatabase::createDatabaseReport(ProgressHandler *progress)
     return true;
 
   info << endl;
-  util.createColumnReport(info);
+  {
+    QDebugStateSaver saver(info);
+    info.noquote().nospace() << "Column value report for database:" << endl;
+  }
+
+  QStringList tables = db->tables();
+  tables.sort();
+  for(const QString& table : qAsConst(tables))
+  {
+    runner.addJob([table](QDebug& out, const SqlUtil& tableUtil) -> void {
+      tableUtil.createColumnReportTable(out, table);
+    });
+  }
+  runner.run(info);
 
   if((aborted = progress->reportOther(tr("Creating report on duplicates"))))
     return true;
 
   info << endl;
 
-  util.reportDuplicates(info, "airport", "airport_id", {"ident"});
-  info << endl;
-
-  util.reportDuplicates(info, "vor", "vor_id", {"ident", "region", "lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "ndb", "ndb_id", {"ident", "type", "frequency", "region", "lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "waypoint", "waypoint_id", {"ident", "type", "region", "lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "ils", "ils_id", {"ident", "lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "marker", "marker_id", {"type", "heading", "lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "helipad", "helipad_id", {"lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "parking", "parking_id", {"lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "start", "start_id", {"lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "runway", "runway_id", {"heading", "lonx", "laty"});
-  info << endl;
-
-  util.reportDuplicates(info, "bgl_file", "bgl_file_id", {"filename"});
-  info << endl;
+  static const QVector<std::pair<QString, QStringList> > DUPLICATES = {
+    std::make_pair(QString("airport"), QStringList({"ident"})),
+    std::make_pair(QString("vor"), QStringList({"ident", "region", "lonx", "laty"})),
+    std::make_pair(QString("ndb"), QStringList({"ident", "type", "frequency", "region", "lonx", "laty"})),
+    std::make_pair(QString("waypoint"), QStringList({"ident", "type", "region", "lonx", "laty"})),
+    std::make_pair(QString("ils"), QStringList({"ident", "lonx", "laty"})),
+    std::make_pair(QString("marker"), QStringList({"type", "heading", "lonx", "laty"})),
+    std::make_pair(QString("helipad"), QStringList({"lonx", "laty"})),
+    std::make_pair(QString("parking"), QStringList({"lonx", "laty"})),
+    std::make_pair(QString("start"), QStringList({"lonx", "laty"})),
+    std::make_pair(QString("runway"), QStringList({"heading", "lonx", "laty"})),
+    std::make_pair(QString("bgl_file"), QStringList({"filename"}))
+  };
+
+  for(const std::pair<QString, QStringList>& duplicate : DUPLICATES)
+  {
+    runner.addJob([duplicate](QDebug& out, const SqlUtil& tableUtil) -> void {
+      tableUtil.reportDuplicates(out, duplicate.first, duplicate.first % "_id", duplicate.second);
+      out << endl;
+    });
+  }
+  runner.run(info);
 
   if((aborted = progress->reportOther(tr("Creating report on coordinate duplicates"))))
     return true;
 
-  reportCoordinateViolations(info, util, {"airport", "vor", "ndb", "marker", "waypoint"});
+  reportCoordinateViolations(runner, {"airport", "vor", "ndb", "marker", "waypoint"});
+  runner.run(info);
 
   return false;
 }
 
-bool NavDatabase::runScript(ProgressHandler *progress, const QString& scriptFile, const QString& message)
+bool NavDatabase::runScript(ProgressHandler *progress, const QString& scriptFile, const QString& message,
+                            bool statementTimings)
 {
   SqlScript script(db, true /*options->isVerbose()*/);
+  script.setLogTimings(statementTimings);
 
   if(progress != nullptr)
     if((aborted = progress->reportOtherInc(message, PROGRESS_NUM_SCRIPT_STEPS)))
       return true;
 
+  profiler.next(scriptFile);
+
+  QElapsedTimer timer;
+  timer.start();
   script.executeScript(":/atools/resources/sql/" % scriptFile);
   db->commit();
+  qDebug() << Q_FUNC_INFO << scriptFile << timer.elapsed() << "ms";
+  return false;
+}
+
+bool NavDatabase::runPostLoadUpdate(ProgressHandler *progress, const QString& scriptFile, const QString& message,
+                                    void (atools::fs::db::PostLoadUpdater::*update)())
+{
+  if(options->isSqlPostProcess())
+    return runScript(progress, scriptFile, message);
+
+  if(progress != nullptr)
+    if((aborted = progress->reportOtherInc(message, PROGRESS_NUM_SCRIPT_STEPS)))
+      return true;
+
+  profiler.next(scriptFile);
+
+  QElapsedTimer timer;
+  timer.start();
+  atools::fs::db::PostLoadUpdater updater(db, options->getReaderThreads());
+  (updater.*update)();
+  db->commit();
+  qDebug() << Q_FUNC_INFO << scriptFile << "native" << timer.elapsed() << "ms";
   return false;
 }
 
+bool NavDatabase::runIndexScript(ProgressHandler *progress, const QString& scriptFile, const QString& message)
+{
+  // SQLite cannot build indexes concurrently in one database since each needs the write lock.
+  // Allow SQLite to use worker threads for the external sort of "create index" instead.
+  // Reader thread limit also caps sort threads if set, e.g. when several databases are compiled concurrently
+  int threads = options->getReaderThreads() > 0 ? options->getReaderThreads() : QThread::idealThreadCount();
+  db->exec("pragma threads=" % QString::number(std::max(1, std::min(threads, MAX_INDEX_THREADS))));
+  bool retval = runScript(progress, scriptFile, message, true /* statementTimings */);
+  db->exec("pragma threads=0");
+  return retval;
+}
+
+void NavDatabase::startBulkLoadProfile()
+{
+  if(options->isBulkLoadProfile() && bulkLoadRestorePragmas.isEmpty())
+  {
+    // Commit since executePragmas() rolls back the current transaction
+    db->commit();
+    bulkLoadRestorePragmas = db->readPragmas(BULK_LOAD_PRAGMA_NAMES);
+
+    QStringList pragmas(BULK_LOAD_PRAGMAS);
+    if(options->getMemoryLimitMb() > 0)
+    {
+      // Split limit between page cache and memory map - pragmas are applied in order and the last one wins
+      qint64 limitKb = options->getMemoryLimitMb() * 1024LL;
+      pragmas.append("pragma cache_size=-" % QString::number(std::min(limitKb / 2, 262144LL)));
+      pragmas.append("pragma mmap_size=" % QString::number(std::min(limitKb / 2 * 1024LL, 1073741824LL)));
+    }
+
+    db->executePragmas(pragmas);
+    qInfo() << Q_FUNC_INFO << "Bulk load profile" << pragmas << "restore" << bulkLoadRestorePragmas;
+  }
+}
+
+void NavDatabase::restoreBulkLoadProfile()
+{
+  if(!bulkLoadRestorePragmas.isEmpty())
+  {
+    db->commit();
+    db->executePragmas(bulkLoadRestorePragmas);
+    bulkLoadRestorePragmas.clear();
+    qInfo() << Q_FUNC_INFO << "Restored database settings";
+  }
+}
+
+/* MSFS package directory with manifest and layout */
+struct MsfsPackage
+{
+  QString name;
+  QFileInfo fileinfo;
+  atools::fs::scenery::ManifestJson manifest;
+  atools::fs::scenery::LayoutJson layout;
+  bool skipped = false;
+};
+
+/* Read manifest and layout files of all packages in parallel. Layout is read only for scenery packages.
+ * Packages marked as skipped are not touched. Order is kept. */
+static void readMsfsPackages(QVector<MsfsPackage>& packages, int numThreads)
+{
+  MsfsPackage *packagesData = packages.data();
+  atools::util::parallelFor(packages.size(), numThreads, [packagesData](int begin, int end, int) {
+    for(int i = begin; i < end; i++)
+    {
+      MsfsPackage& package = packagesData[i];
+      if(package.skipped)
+        continue;
+
+      package.fileinfo.setFile(atools::canonicalFilePath(package.fileinfo));
+
+      // Read manifest to check type
+      package.manifest.read(package.fileinfo.filePath() % atools::SEP % "manifest.json");
+
+      if(package.manifest.isAnyScenery())
+        // Read BGL and material file locations from layout file
+        package.layout.read(package.fileinfo.filePath() % atools::SEP % "layout.json");
+    }
+  }, 10);
+}
+
 void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
 {
   // Force well known layer piority to avoid mess up due to not documented "Content.xml"
@@ -1523,52 +1997,51 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   areaNav.setNavdata(); // Set flag to allow dummy airport handling
   cfg.appendArea(areaNav);
 
-  scenery::LayoutJson layout;
-
   // Read add-on packages in official ===============================
+  // Manifest and layout files of all packages are read in parallel - areas are added in directory order
   const QDir dirOfficial(options->getMsfsOfficialPath(), QString(),
                          QDir::Name | QDir::IgnoreCase, QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
   QString baseName = dirOfficial.dirName();
+  QVector<MsfsPackage> packages;
   const QFileInfoList entriesOfficial = dirOfficial.entryInfoList();
-  for(QFileInfo fileinfo : entriesOfficial)
+  for(const QFileInfo& fileinfo : entriesOfficial)
   {
-    QString name = fileinfo.fileName();
-    fileinfo.setFile(atools::canonicalFilePath(fileinfo));
+    MsfsPackage package;
+    package.name = fileinfo.fileName();
+    package.fileinfo = fileinfo;
 
-    if(contentXml.isDisabled(name))
+    if(contentXml.isDisabled(package.name))
     {
       // Entry is present in Content.xml and has has active="false"
-      qDebug() << Q_FUNC_INFO << "Skipping disabled" << name;
-      continue;
+      qDebug() << Q_FUNC_INFO << "Skipping disabled" << package.name;
+      package.skipped = true;
     }
-
-    if(name == "fs-base-nav" || name == "fs-base" || name == "fs-base-genericairports")
+    else if(package.name == "fs-base-nav" || package.name == "fs-base" || package.name == "fs-base-genericairports")
       // Already read before - do not touch name or priority
-      continue;
+      package.skipped = true;
 
-    // Read manifest to check type
-    manifest.clear();
-    manifest.read(fileinfo.filePath() % SEP % "manifest.json");
+    packages.append(package);
+  }
 
-    if(manifest.isAnyScenery())
-    {
-      // Read BGL and material file locations from layout file
-      layout.clear();
-      layout.read(fileinfo.filePath() % SEP % "layout.json");
+  readMsfsPackages(packages, options->getReaderThreads());
 
-      SceneryArea addonArea(contentXml.getPriority(name, LAYER_NUM_DEFAULT), baseName, atools::canonicalFilePath(fileinfo));
-      if(manifest.isScenery() && layout.hasFsArchive() && errors != nullptr)
+  for(const MsfsPackage& package : qAsConst(packages))
+  {
+    if(!package.skipped && package.manifest.isAnyScenery())
+    {
+      SceneryArea addonArea(contentXml.getPriority(package.name, LAYER_NUM_DEFAULT), baseName, package.fileinfo.filePath());
+      if(package.manifest.isScenery() && package.layout.hasFsArchive() && errors != nullptr)
         errors->sceneryErrors.append(
-          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").arg(name),
-                                           true /* isWarning */));
+          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").
+                                           arg(package.name), true /* isWarning */));
 
-      if(!layout.getBglPaths().isEmpty())
+      if(!package.layout.getBglPaths().isEmpty())
       {
         // Indicate add-on in official path
         addonArea.setAddOn(true);
 
         // Detect Navigraph navdata update packages for special handling
-        addonArea.setNavigraphNavdata(isNavigraphNavdata(manifest));
+        addonArea.setNavigraphNavdata(isNavigraphNavdata(package.manifest));
 
         cfg.getAreas().append(addonArea);
       }
@@ -1580,39 +2053,41 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   const QDir dirCommunity(options->getMsfsCommunityPath(), QString(),
                           QDir::Name | QDir::IgnoreCase, QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
 
+  packages.clear();
   const QFileInfoList entriesCommunity = dirCommunity.entryInfoList();
-  for(QFileInfo fileinfo : entriesCommunity)
+  for(const QFileInfo& fileinfo : entriesCommunity)
   {
-    QString name = fileinfo.fileName();
-    fileinfo.setFile(atools::canonicalFilePath(fileinfo));
+    MsfsPackage package;
+    package.name = fileinfo.fileName();
+    package.fileinfo = fileinfo;
 
-    if(contentXml.isDisabled(name))
+    if(contentXml.isDisabled(package.name))
     {
       // Entry is present in Content.xml and has has active="false"
-      qDebug() << Q_FUNC_INFO << "Skipping disabled" << name;
-      continue;
+      qDebug() << Q_FUNC_INFO << "Skipping disabled" << package.name;
+      package.skipped = true;
     }
 
-    manifest.clear();
-    manifest.read(fileinfo.filePath() % SEP % "manifest.json");
+    packages.append(package);
+  }
 
-    if(manifest.isAnyScenery())
-    {
-      // Read BGL and material file locations from layout file
-      layout.clear();
-      layout.read(fileinfo.filePath() % SEP % "layout.json");
+  readMsfsPackages(packages, options->getReaderThreads());
 
-      SceneryArea addonArea(contentXml.getPriority(name, LAYER_NUM_DEFAULT), tr("Community"), atools::canonicalFilePath(fileinfo));
+  for(const MsfsPackage& package : qAsConst(packages))
+  {
+    if(!package.skipped && package.manifest.isAnyScenery())
+    {
+      SceneryArea addonArea(contentXml.getPriority(package.name, LAYER_NUM_DEFAULT), tr("Community"), package.fileinfo.filePath());
       addonArea.setCommunity(true);
-      if(manifest.isScenery() && layout.hasFsArchive() && errors != nullptr)
+      if(package.manifest.isScenery() && package.layout.hasFsArchive() && errors != nullptr)
         errors->sceneryErrors.append(
-          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").arg(name),
-                                           true /* isWarning */));
+          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").
+                                           arg(package.name), true /* isWarning */));
 
-      if(!layout.getBglPaths().isEmpty())
+      if(!package.layout.getBglPaths().isEmpty())
       {
         // Detect Navigraph navdata update packages for special handling
-        addonArea.setNavigraphNavdata(isNavigraphNavdata(manifest));
+        addonArea.setNavigraphNavdata(isNavigraphNavdata(package.manifest));
 
         cfg.getAreas().append(addonArea);
       }
@@ -1623,7 +2098,7 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   cfg.sortAreas();
 }
 
-bool NavDatabase::isNavigraphNavdata(atools::fs::scenery::ManifestJson& manifest)
+bool NavDatabase::isNavigraphNavdata(const atools::fs::scenery::ManifestJson& manifest)
 {
   // navigraph-navdata
   // Procedures and airport centers
@@ -1994,14 +2469,15 @@ void NavDatabase::readAddOnComponents(int& areaNum, atools::fs::scenery::Scenery
     qWarning() << Q_FUNC_INFO << addonFile.filePath() << "does not exist or is not a directory";
 }
 
-void NavDatabase::reportCoordinateViolations(QDebug& out, atools::sql::SqlUtil& util,
-                                             const QStringList& tables)
+void NavDatabase::reportCoordinateViolations(atools::sql::SqlReportRunner& runner, const QStringList& tables)
 {
-  for(const QString& table : qAsConst(tables))
+  for(const QString& table : tables)
   {
-    out << "==================================================================" << endl;
-    util.reportRangeViolations(out, table, {table % "_id", "ident"}, "lonx", -180.f, 180.f);
-    util.reportRangeViolations(out, table, {table % "_id", "ident"}, "laty", -90.f, 90.f);
+    runner.addJob([table](QDebug& out, const SqlUtil& util) -> void {
+      out << "==================================================================" << endl;
+      util.reportRangeViolations(out, table, {table % "_id", "ident"}, "lonx", -180.f, 180.f);
+      util.reportRangeViolations(out, table, {table % "_id", "ident"}, "laty", -90.f, 90.f);
+    });
   }
 }
 
@@ -2019,22 +2495,102 @@ void NavDatabase::countFiles(ProgressHandler *progress, const QList<atools::fs::
 {
   qDebug() << Q_FUNC_INFO << "Entry";
   atools::fs::scenery::FileResolver resolver(*options, true);
+  resolver.setCache(&fileResolverCache);
+
+  bool incremental = options->isIncrementalCompile();
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  QStringList filepaths;
 
   for(const SceneryArea& area : areas)
   {
     if((aborted = progress->reportOtherMsg(tr("Counting files for %1 ...").arg(area.getTitle()))))
       return;
 
-    int num = resolver.getFiles(area);
+    filepaths.clear();
+    int num = resolver.getFiles(area, incremental ? &filepaths : nullptr);
 
     if(num > 0)
     {
       numFiles += num;
       numSceneryAreas++;
     }
+
+    if(incremental)
+    {
+      // Area order and layer define which files override others
+      hash.addData((QString::number(area.getLayer()) % '|' % area.getLocalPath() % '\n').toUtf8());
+
+      for(const QString& filepath : qAsConst(filepaths))
+      {
+        QFileInfo fileinfo(filepath);
+        hash.addData((filepath % '|' % QString::number(fileinfo.size()) % '|' %
+                      QString::number(fileinfo.lastModified().toMSecsSinceEpoch()) % '\n').toUtf8());
+      }
+    }
+  }
+
+  if(incremental)
+  {
+    // Filters, flags and compiler version change the result too
+    QString optionsStr;
+    QDebug(&optionsStr) << *options;
+    hash.addData((optionsStr % '|' % atools::version() % '|' % atools::gitRevision()).toUtf8());
+    sceneryFingerprint = QString::fromLatin1(hash.result().toHex());
+    qDebug() << Q_FUNC_INFO << "Scenery fingerprint" << sceneryFingerprint;
   }
   qDebug() << Q_FUNC_INFO << "Exit";
 }
 
+bool NavDatabase::isSceneryUpToDate()
+{
+  if(sceneryFingerprint.isEmpty())
+    // Not FSX, P3D or MSFS
+    return false;
+
+  atools::fs::db::DatabaseMeta meta(db);
+  if(!meta.isValid() || !meta.hasData() || !meta.isDatabaseCompatible())
+  {
+    qInfo() << Q_FUNC_INFO << "No previous database found or incompatible";
+    return false;
+  }
+
+  if(meta.getPropertyValue(atools::fs::db::PROPERTYNAME_SCENERY_FINGERPRINT) == sceneryFingerprint)
+  {
+    qInfo() << Q_FUNC_INFO << "No scenery changes since" << meta.getLastLoadTime() << "- keeping database";
+    return true;
+  }
+
+  logChangedFiles();
+  return false;
+}
+
+void NavDatabase::logChangedFiles()
+{
+  if(!SqlUtil(db).hasTableAndRows("bgl_file"))
+    return;
+
+  // Table bgl_file contains only files which had content - new files cannot be detected here
+  int numChanged = 0, numRemoved = 0;
+  SqlQuery query("select filepath, size, file_modification_time from bgl_file", db);
+  query.exec();
+  while(query.next())
+  {
+    QFileInfo fileinfo(QDir::fromNativeSeparators(query.valueStr("filepath")));
+    if(!fileinfo.exists())
+    {
+      if(numRemoved++ < 20)
+        qInfo() << Q_FUNC_INFO << "Removed" << fileinfo.filePath();
+    }
+    else if(fileinfo.size() != query.value("size").toLongLong() ||
+            fileinfo.lastModified().toTime_t() != query.value("file_modification_time").toUInt())
+    {
+      if(numChanged++ < 20)
+        qInfo() << Q_FUNC_INFO << "Changed" << fileinfo.filePath();
+    }
+  }
+  qInfo() << Q_FUNC_INFO << "Scenery changed. Files changed" << numChanged << "removed" << numRemoved
+          << "- full compilation needed";
+}
+
 } // namespace fs
 } // namespace atools
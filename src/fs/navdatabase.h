@@ -18,8 +18,11 @@
 #ifndef ATOOLS_FS_NAVDATABASE_H
 #define ATOOLS_FS_NAVDATABASE_H
 
+#include "fs/compileprofiler.h"
 #include "fs/fspaths.h"
 #include "fs/navdatabaseflags.h"
+#include "fs/scenery/fileresolvercache.h"
+#include "fs/scenery/parsecache.h"
 
 #include <QDebug>
 #include <QCoreApplication>
@@ -28,6 +31,7 @@
 namespace atools {
 namespace sql {
 class SqlDatabase;
+class SqlReportRunner;
 class SqlUtil;
 }
 
@@ -40,10 +44,12 @@ class SceneryCfg;
 class AddOnComponent;
 class SceneryArea;
 class ManifestJson;
+class LanguageJson;
 }
 
 namespace db {
 class DataWriter;
+class PostLoadUpdater;
 }
 
 namespace xp {
@@ -63,6 +69,8 @@ class ProgressHandler;
  */
 class NavDatabase
 {
+  friend class BulkLoadProfileRestore;
+
   Q_DECLARE_TR_FUNCTIONS(Navdatabase)
 
 public:
@@ -78,6 +86,19 @@ public:
    * @param codec Scenery.cfg codec only applies to FSX/P3D */
   atools::fs::ResultFlags compileDatabase();
 
+  /*
+   * Build-then-swap mode. Compiles into a temporary file next to filename using an own SQLite connection and
+   * replaces filename by an atomic rename when done. Connections to filename are not touched and can be used
+   * for queries while compiling. Listeners of atools::sql::DatabaseSwap are notified about the new file.
+   * Nothing is published if compilation is canceled. atools::Exception is thrown in case of error.
+   * @param pragmas SQLite pragmas for the temporary connection
+   */
+  static atools::fs::ResultFlags compileDatabaseSwap(const QString& filename,
+                                                     const atools::fs::NavDatabaseOptions *readerOptions,
+                                                     atools::fs::NavDatabaseErrors *databaseErrors,
+                                                     const QString& revision,
+                                                     const QStringList& pragmas = QStringList());
+
   /* Does not load anything and only creates the empty database schema.
    * Configuration is not used and can be null. atools::Exception is thrown in case of error.
    * Opens own transaction and commits if successfull */
@@ -113,6 +134,22 @@ public:
   /* Delete all tables that are not used in versions > 2.4.5 */
   static void runPreparationPost245(atools::sql::SqlDatabase& db);
 
+  /* Switch to rollback journal, vacuum and write a page compressed copy of the database to targetFile which
+   * can be opened with SqlDatabase::setCompressedDatabaseName(). Database has to be open and writeable.
+   * Throws atools::Exception on error. */
+  static void compactForDistribution(atools::sql::SqlDatabase& db, const QString& targetFile);
+
+  /* Read MSFS airport name translations for the language in options from fs-base and fs-base-genericairports.
+   * Falls back to en-US if not found. Clears index before. Cache and lazy mode have to be set by the caller. */
+  static void readLanguageIndex(atools::fs::scenery::LanguageJson& languageIndex,
+                                const atools::fs::NavDatabaseOptions& opts);
+
+  /* Phase timings of the last compilation. Only filled if a profile report file is set in options. */
+  const atools::fs::CompileProfiler& getProfiler() const
+  {
+    return profiler;
+  }
+
 private:
   /* Creates database schema only */
   void createSchemaInternal(atools::fs::ProgressHandler *progress = nullptr);
@@ -159,18 +196,48 @@ private:
   void createDatabaseReportShort();
 
   bool basicValidation(ProgressHandler *progress, bool& foundBasicValidationError);
-  void basicValidateTable(const QString& table, int minCount, bool& foundBasicValidationError);
-  void reportCoordinateViolations(QDebug& out, atools::sql::SqlUtil& util, const QStringList& tables);
+  /* Returns true if the table has less than minCount rows. Thread safe. */
+  static bool basicValidateTable(QDebug& out, const atools::sql::SqlUtil& util, const QString& table, int minCount);
+
+  /* Adds range check jobs for coordinates of all tables to the runner */
+  void reportCoordinateViolations(atools::sql::SqlReportRunner& runner, const QStringList& tables);
 
-  /* Count files in FSX/P3D scenery configuration */
+  /* Count files in FSX/P3D scenery configuration.
+   * Also calculates sceneryFingerprint if incremental compilation is enabled. */
   void countFiles(ProgressHandler *progress, const QList<scenery::SceneryArea>& areas, int& numFiles,
                   int& numSceneryAreas);
 
+  /* true if the database was compiled from the same files and options as given by sceneryFingerprint */
+  bool isSceneryUpToDate();
+
+  /* Print changed and removed files compared to table bgl_file into the log */
+  void logChangedFiles();
+
+  /* Pointer to parseCache or null if no cache file is set in options */
+  atools::fs::scenery::ParseCache *parseCacheOrNull()
+  {
+    return options->getParseCacheFile().isEmpty() ? nullptr : &parseCache;
+  }
+
   /* Search for highest area number */
   int nextAreaNum(const QList<atools::fs::scenery::SceneryArea>& areas);
 
-  /* Run and report SQL script */
-  bool runScript(atools::fs::ProgressHandler *progress, const QString& scriptFile, const QString& message);
+  /* Save current pragmas and switch to fast unsafe settings if bulk load profile is enabled in options */
+  void startBulkLoadProfile();
+
+  /* Restore durable settings saved by startBulkLoadProfile(). Does nothing if not started. */
+  void restoreBulkLoadProfile();
+
+  /* Run and report SQL script. Logs execution time and optionally the execution time for each statement. */
+  bool runScript(atools::fs::ProgressHandler *progress, const QString& scriptFile, const QString& message,
+                 bool statementTimings = false);
+
+  /* Run script creating indexes using SQLite sorter worker threads and log time for each index */
+  bool runIndexScript(atools::fs::ProgressHandler *progress, const QString& scriptFile, const QString& message);
+
+  /* Run the native update or the equivalent SQL script if NavDatabaseOptions::isSqlPostProcess() is set */
+  bool runPostLoadUpdate(atools::fs::ProgressHandler *progress, const QString& scriptFile, const QString& message,
+                         void (atools::fs::db::PostLoadUpdater::*update)());
 
   void createPreparationScript();
   void dropAllIndexes();
@@ -188,7 +255,7 @@ private:
   int countMsSimSteps();
 
   /* Detect Navigraph navdata update packages for special handling. */
-  bool isNavigraphNavdata(atools::fs::scenery::ManifestJson& manifest);
+  bool isNavigraphNavdata(const atools::fs::scenery::ManifestJson& manifest);
 
   atools::sql::SqlDatabase *db;
   atools::fs::NavDatabaseErrors *errors = nullptr;
@@ -196,6 +263,21 @@ private:
   bool aborted = false;
   QString gitRevision;
 
+  /* Hash over scenery files and options for incremental compilation. Empty if not used. */
+  QString sceneryFingerprint;
+
+  /* Pragma statements to restore settings after a bulk load */
+  QStringList bulkLoadRestorePragmas;
+
+  /* Collects time, rows and bytes for each phase of createInternal() */
+  atools::fs::CompileProfiler profiler;
+
+  /* BGL file lists filled while counting files and reused while loading */
+  atools::fs::scenery::FileResolverCache fileResolverCache;
+
+  /* Parsed MSFS material libraries and language files. Only used if a parse cache file is set in options. */
+  atools::fs::scenery::ParseCache parseCache;
+
 };
 
 } // namespace fs
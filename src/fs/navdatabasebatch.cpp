@@ -0,0 +1,225 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/navdatabasebatch.h"
+
+#include "exception.h"
+#include "fs/navdatabase.h"
+#include "fs/scenery/languagejson.h"
+#include "fs/scenery/materiallib.h"
+#include "sql/sqldatabase.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+namespace atools {
+namespace fs {
+
+using atools::sql::SqlDatabase;
+
+/* Runs the compilation of one target in the thread pool */
+class NavDatabaseBatchRunnable :
+  public QRunnable
+{
+public:
+  NavDatabaseBatchRunnable(const std::function<void()>& funcParam)
+    : func(funcParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    func();
+  }
+
+private:
+  std::function<void()> func;
+};
+
+NavDatabaseBatch::NavDatabaseBatch(const QString& revisionParam)
+  : revision(revisionParam)
+{
+
+}
+
+NavDatabaseBatch::~NavDatabaseBatch()
+{
+  clear();
+}
+
+void NavDatabaseBatch::addTarget(const NavDatabaseOptions& options, const QString& databaseFile)
+{
+  NavDatabaseBatchTarget target;
+  target.options = options;
+  target.databaseFile = databaseFile;
+  targets.append(target);
+}
+
+void NavDatabaseBatch::clear()
+{
+  targets.clear();
+  magDecReader.clear();
+  qDeleteAll(languageIndexes);
+  languageIndexes.clear();
+  qDeleteAll(materialLibs);
+  materialLibs.clear();
+}
+
+void NavDatabaseBatch::prepareSharedInputs()
+{
+  // Declination grid is the same for all simulators ==========================
+  if(!magDecReader.isValid())
+    magDecReader.readFromWmm();
+
+  for(NavDatabaseBatchTarget& target : targets)
+  {
+    NavDatabaseOptions& options = target.options;
+    options.setSharedMagDecReader(&magDecReader);
+
+    if(options.getSimulatorType() == FsPaths::MSFS)
+    {
+      // MSFS language index and material library for each installation ==========================
+      // Not lazy since accessed from several threads
+      QString path = options.getMsfsOfficialPath();
+      QString languageKey = path + '|' + options.getLanguage();
+
+      scenery::LanguageJson *languageIndex = languageIndexes.value(languageKey);
+      if(languageIndex == nullptr)
+      {
+        languageIndex = new scenery::LanguageJson();
+        NavDatabase::readLanguageIndex(*languageIndex, options);
+        languageIndexes.insert(languageKey, languageIndex);
+      }
+      options.setSharedLanguageIndex(languageIndex);
+
+      scenery::MaterialLib *materialLib = materialLibs.value(path);
+      if(materialLib == nullptr)
+      {
+        // Options are only used for file filters - first target stays valid while compiling
+        materialLib = new scenery::MaterialLib(&options);
+        materialLib->readOfficial(path);
+        materialLibs.insert(path, materialLib);
+      }
+      options.setSharedMaterialLib(materialLib);
+    }
+  }
+}
+
+bool NavDatabaseBatch::compile()
+{
+  if(targets.isEmpty())
+    return true;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  prepareSharedInputs();
+  qDebug() << Q_FUNC_INFO << "Shared inputs prepared in" << timer.restart() << "ms";
+
+  // Divide threads and memory between concurrent compilations ==========================
+  int threads = maxThreads > 0 ? maxThreads : QThread::idealThreadCount();
+  int concurrent = std::min(targets.size(), maxConcurrent > 0 ? maxConcurrent : QThread::idealThreadCount());
+  concurrent = std::max(1, std::min(concurrent, threads));
+  int threadsPerTarget = std::max(1, threads / concurrent);
+  int memoryPerTarget = maxMemoryMb > 0 ? std::max(1, maxMemoryMb / concurrent) : 0;
+
+  for(NavDatabaseBatchTarget& target : targets)
+  {
+    if(target.options.getReaderThreads() == 0)
+      target.options.setReaderThreads(threadsPerTarget);
+    if(target.options.getMemoryLimitMb() == 0)
+      target.options.setMemoryLimitMb(memoryPerTarget);
+  }
+
+  qInfo() << Q_FUNC_INFO << "Compiling" << targets.size() << "databases" << concurrent << "at a time"
+          << "threads per database" << threadsPerTarget << "memory per database" << memoryPerTarget << "MB";
+
+  // Start all - pool runs the configured number at a time ==========================
+  // Detach before starting threads
+  NavDatabaseBatchTarget *targetData = targets.data();
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(concurrent);
+  for(int i = 0; i < targets.size(); i++)
+    pool.start(new NavDatabaseBatchRunnable([this, targetData, i]() -> void {
+      compileTarget(targetData[i], i);
+    }));
+  pool.waitForDone();
+
+  bool success = true;
+  for(const NavDatabaseBatchTarget& target : qAsConst(targets))
+  {
+    if(target.result.testFlag(COMPILE_FAILED) || target.result.testFlag(COMPILE_CANCELED) ||
+       target.result.testFlag(COMPILE_BASIC_VALIDATION_ERROR))
+      success = false;
+  }
+
+  qInfo() << Q_FUNC_INFO << "Done in" << timer.elapsed() << "ms" << "success" << success;
+  return success;
+}
+
+void NavDatabaseBatch::compileTarget(NavDatabaseBatchTarget& target, int index)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Connections can only be used in the thread which created them
+  QString connectionName = "navdatabasebatch_" + QString::number(index);
+  {
+    SqlDatabase db = SqlDatabase::addDatabase("QSQLITE", connectionName);
+    try
+    {
+      db.setDatabaseName(target.databaseFile);
+      db.open();
+
+      NavDatabase navDatabase(&target.options, &db, &target.errors, revision);
+      target.result = navDatabase.compileDatabase();
+    }
+    catch(atools::Exception& e)
+    {
+      qCritical() << Q_FUNC_INFO << "Caught exception compiling" << target.databaseFile << e.what();
+      target.exceptionMessage = e.what();
+      target.result |= COMPILE_FAILED;
+    }
+    catch(std::exception& e)
+    {
+      qCritical() << Q_FUNC_INFO << "Caught exception compiling" << target.databaseFile << e.what();
+      target.exceptionMessage = e.what();
+      target.result |= COMPILE_FAILED;
+    }
+    catch(...)
+    {
+      qCritical() << Q_FUNC_INFO << "Caught unknown exception compiling" << target.databaseFile;
+      target.exceptionMessage = tr("Unknown exception");
+      target.result |= COMPILE_FAILED;
+    }
+
+    if(db.isOpen())
+      db.close();
+  }
+  SqlDatabase::removeDatabase(connectionName);
+
+  target.elapsedMs = timer.elapsed();
+  qInfo() << Q_FUNC_INFO << target.databaseFile << "done in" << target.elapsedMs << "ms result" << target.result;
+}
+
+} // namespace fs
+} // namespace atools
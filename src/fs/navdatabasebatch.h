@@ -0,0 +1,132 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_NAVDATABASEBATCH_H
+#define ATOOLS_FS_NAVDATABASEBATCH_H
+
+#include "fs/common/magdecreader.h"
+#include "fs/navdatabaseerrors.h"
+#include "fs/navdatabaseflags.h"
+#include "fs/navdatabaseoptions.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+
+namespace scenery {
+class LanguageJson;
+class MaterialLib;
+}
+
+/* One database to compile by NavDatabaseBatch */
+struct NavDatabaseBatchTarget
+{
+  atools::fs::NavDatabaseOptions options;
+
+  /* SQLite file which is created or overwritten */
+  QString databaseFile;
+
+  /* Filled by NavDatabaseBatch::compile() */
+  atools::fs::ResultFlags result = atools::fs::COMPILE_NONE;
+  atools::fs::NavDatabaseErrors errors;
+  QString exceptionMessage; /* Not empty if compilation failed with an exception */
+  qint64 elapsedMs = 0;
+};
+
+/*
+ * Compiles several navdata databases like FSX, P3D, MSFS, X-Plane and Navigraph concurrently into separate
+ * SQLite files. Each target runs a full NavDatabase compilation with its own database connection in a pool thread.
+ *
+ * Read only inputs are prepared once before starting and shared by all targets:
+ * the declination grid of the world magnetic model and the MSFS language index and material library for each
+ * MSFS installation and language.
+ *
+ * Total threads and memory are divided between the concurrently running targets. Reader threads and memory limit
+ * of targets are only changed if not set in their options.
+ *
+ * Progress callbacks of the options are called from the worker threads and have to be thread safe.
+ */
+class NavDatabaseBatch
+{
+  Q_DECLARE_TR_FUNCTIONS(NavDatabaseBatch)
+
+public:
+  explicit NavDatabaseBatch(const QString& revisionParam);
+  ~NavDatabaseBatch();
+
+  NavDatabaseBatch(const NavDatabaseBatch& other) = delete;
+  NavDatabaseBatch& operator=(const NavDatabaseBatch& other) = delete;
+
+  /* Add database to compile. Options are copied. */
+  void addTarget(const atools::fs::NavDatabaseOptions& options, const QString& databaseFile);
+
+  /* Compile all targets and wait until all are done. Exceptions are caught and stored in the target.
+   * Returns true if all targets were compiled without error and were not canceled. */
+  bool compile();
+
+  /* Targets with results */
+  const QVector<atools::fs::NavDatabaseBatchTarget>& getTargets() const
+  {
+    return targets;
+  }
+
+  /* Remove targets and free shared inputs */
+  void clear();
+
+  /* Maximum number of databases compiled at the same time. 0 uses the number of CPU cores. */
+  void setMaxConcurrent(int value)
+  {
+    maxConcurrent = value;
+  }
+
+  /* Total number of threads for all concurrent compilations. 0 uses the number of CPU cores. */
+  void setMaxThreads(int value)
+  {
+    maxThreads = value;
+  }
+
+  /* Total SQLite cache and memory map in MiB for all concurrent compilations. 0 uses the bulk load defaults. */
+  void setMaxMemoryMb(int value)
+  {
+    maxMemoryMb = value;
+  }
+
+private:
+  /* Calculate declination and load MSFS indexes once and set them in the target options */
+  void prepareSharedInputs();
+
+  /* Compile one target in the current thread using a new database connection */
+  void compileTarget(atools::fs::NavDatabaseBatchTarget& target, int index);
+
+  QString revision;
+  QVector<atools::fs::NavDatabaseBatchTarget> targets;
+
+  /* Shared read only inputs */
+  atools::fs::common::MagDecReader magDecReader;
+  QHash<QString, atools::fs::scenery::LanguageJson *> languageIndexes; /* Key is MSFS path and language */
+  QHash<QString, atools::fs::scenery::MaterialLib *> materialLibs; /* Key is MSFS path */
+
+  int maxConcurrent = 0, maxThreads = 0, maxMemoryMb = 0;
+};
+
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_NAVDATABASEBATCH_H
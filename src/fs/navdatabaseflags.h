@@ -31,6 +31,7 @@ enum ResultFlag
   COMPILE_MSFS_NAVIGRAPH_FOUND = 1 << 1, /* Found MSFS Navigraph installation during compilation */
   COMPILE_CANCELED = 1 << 2, /* User clicked cancel on progress */
   COMPILE_FAILED = 1 << 3, /* Caught exception */
+  COMPILE_UP_TO_DATE = 1 << 4, /* Incremental compilation found no changes. Database was not modified. */
 };
 
 Q_DECLARE_FLAGS(ResultFlags, ResultFlag);
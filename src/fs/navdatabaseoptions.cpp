@@ -237,6 +237,9 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   setLanguage(settings.value("Options/MsfsAirportLanguage", "en-US").toString());
   setCreateRouteTables(settings.value("Options/CreateRouteTables", false).toBool());
   setCreateAirportTables(settings.value("Options/CreateAirportTables", false).toBool());
+  setCreateProcedureGeometry(settings.value("Options/CreateProcedureGeometry", false).toBool());
+  setCreateTaxiGraph(settings.value("Options/CreateTaxiGraph", false).toBool());
+  setCreateApronMesh(settings.value("Options/CreateApronMesh", false).toBool());
   setDatabaseReport(settings.value("Options/DatabaseReport", true).toBool());
   setDeletes(settings.value("Options/ProcessDelete", true).toBool());
   setDeduplicate(settings.value("Options/Deduplicate", true).toBool());
@@ -248,6 +251,16 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   setFlag(type::VACUUM_DATABASE, settings.value("Options/VacuumDatabase", true).toBool());
   setFlag(type::ANALYZE_DATABASE, settings.value("Options/AnalyzeDatabase", true).toBool());
   setFlag(type::DROP_INDEXES, settings.value("Options/DropAllIndexes", false).toBool());
+  setFlag(type::BULK_LOAD_PROFILE, settings.value("Options/BulkLoadProfile", false).toBool());
+  setFlag(type::INCREMENTAL_COMPILE, settings.value("Options/IncrementalCompile", false).toBool());
+  setFlag(type::BATCH_DELETES, settings.value("Options/BatchDeletes", false).toBool());
+  setFlag(type::MSFS_LAZY_LOAD, settings.value("Options/MsfsLazyLoad", false).toBool());
+  setFlag(type::SQL_POST_PROCESS, settings.value("Options/SqlPostProcess", false).toBool());
+  setFlag(type::SPATIAL_ORDER, settings.value("Options/SpatialOrder", false).toBool());
+  setReaderThreads(settings.value("Options/ReaderThreads", 0).toInt());
+  setProfileReportFile(settings.value("Options/ProfileReportFile").toString());
+  setScanCacheFile(settings.value("Options/ScanCacheFile").toString());
+  setParseCacheFile(settings.value("Options/ParseCacheFile").toString());
 
   addToHighPriorityFiltersInc(settings.value("Filter/IncludeHighPriorityFilter").toStringList());
 
@@ -358,6 +371,7 @@ QDebug operator<<(QDebug out, const NavDatabaseOptions& opts)
 {
   QDebugStateSaver saver(out);
   out.nospace().noquote() << "NavDatabaseOptions[flags " << opts.flags;
+  out << ", readerThreads " << opts.readerThreads;
 
   out << ", fileFiltersInc [" << patternStr(opts.fileFiltersInc) << "]";
   out << ", fileFiltersExcl [" << patternStr(opts.fileFiltersExcl) << "]";
@@ -36,6 +36,15 @@ namespace fs {
 
 class NavDatabaseProgress;
 
+namespace common {
+class MagDecReader;
+}
+
+namespace scenery {
+class LanguageJson;
+class MaterialLib;
+}
+
 namespace type {
 
 /* Used to enable/disable loading of BGL objects/records and files for X-Plane. */
@@ -141,7 +150,35 @@ enum OptionFlag
   AIRPORT_VALIDATION = 1 << 15,
 
   /* * Create airport large and medium tables */
-  CREATE_AIRPORT_TABLES = 1 << 16
+  CREATE_AIRPORT_TABLES = 1 << 16,
+
+  /* Use fast but not crash safe SQLite settings like journal_mode=OFF and synchronous=OFF while loading.
+   * Durable settings are restored and the database is optimized at the end. */
+  BULK_LOAD_PROFILE = 1 << 17,
+
+  /* Keep the database if no scenery file and no option changed since the last compilation */
+  INCREMENTAL_COMPILE = 1 << 18,
+
+  /* Collect all airport replacements of a scenery area and apply deletes and updates set based at the end */
+  BATCH_DELETES = 1 << 19,
+
+  /* Parse MSFS material libraries and airport name translations only when first used by a scenery area */
+  MSFS_LAZY_LOAD = 1 << 20,
+
+  /* Precalculate approach and transition geometry into table procedure_geometry */
+  CREATE_PROCEDURE_GEOMETRY = 1 << 21,
+
+  /* Use the SQL scripts instead of atools::fs::db::PostLoadUpdater for waypoint, navaid and ILS updates */
+  SQL_POST_PROCESS = 1 << 22,
+
+  /* Renumber spatial tables in Hilbert curve order and vacuum with a larger page size for read performance */
+  SPATIAL_ORDER = 1 << 23,
+
+  /* Build a ground routing graph for each airport into table taxi_graph */
+  CREATE_TAXI_GRAPH = 1 << 24,
+
+  /* Triangulate aprons and pavements into table apron_mesh */
+  CREATE_APRON_MESH = 1 << 25
 };
 
 Q_DECLARE_FLAGS(OptionFlags, OptionFlag);
@@ -280,6 +317,30 @@ public:
     flags.setFlag(type::CREATE_AIRPORT_TABLES, value);
   }
 
+  /*
+   * If true fill table procedure_geometry with precalculated approach and transition geometry
+   */
+  void setCreateProcedureGeometry(bool value)
+  {
+    flags.setFlag(type::CREATE_PROCEDURE_GEOMETRY, value);
+  }
+
+  /*
+   * If true fill table taxi_graph with a ground routing graph for each airport
+   */
+  void setCreateTaxiGraph(bool value)
+  {
+    flags.setFlag(type::CREATE_TAXI_GRAPH, value);
+  }
+
+  /*
+   * If true fill table apron_mesh with triangulated aprons and pavements
+   */
+  void setCreateApronMesh(bool value)
+  {
+    flags.setFlag(type::CREATE_APRON_MESH, value);
+  }
+
   /* Reads all inactive scenery regions if set to true */
   void setReadInactive(bool value)
   {
@@ -315,6 +376,18 @@ public:
     callDefaultCallback = value;
   }
 
+  /* Minimum time between two calls of the progress callback for frequent reports like BGL files.
+   * 0 calls the callback on each report. */
+  int getProgressCallbackIntervalMs() const
+  {
+    return progressCallbackIntervalMs;
+  }
+
+  void setProgressCallbackIntervalMs(int value)
+  {
+    progressCallbackIntervalMs = value;
+  }
+
   /* Include absolute directories paths. Used by the GUI options dialog. Not saved. */
   void addIncludeGui(const QFileInfo& path);
 
@@ -408,6 +481,131 @@ public:
     return flags.testFlag(type::DROP_INDEXES);
   }
 
+  bool isBulkLoadProfile() const
+  {
+    return flags.testFlag(type::BULK_LOAD_PROFILE);
+  }
+
+  bool isIncrementalCompile() const
+  {
+    return flags.testFlag(type::INCREMENTAL_COMPILE);
+  }
+
+  bool isBatchDeletes() const
+  {
+    return flags.testFlag(type::BATCH_DELETES);
+  }
+
+  bool isMsfsLazyLoad() const
+  {
+    return flags.testFlag(type::MSFS_LAZY_LOAD);
+  }
+
+  bool isSqlPostProcess() const
+  {
+    return flags.testFlag(type::SQL_POST_PROCESS);
+  }
+
+  bool isSpatialOrder() const
+  {
+    return flags.testFlag(type::SPATIAL_ORDER);
+  }
+
+  /* Number of threads reading BGL or X-Plane files ahead of the database writer.
+   * Also used for building DFD airspace geometry.
+   * 0 uses the number of CPU cores and 1 reads all files sequentially in the writer thread. */
+  int getReaderThreads() const
+  {
+    return readerThreads;
+  }
+
+  void setReaderThreads(int value)
+  {
+    readerThreads = value;
+  }
+
+  /* Write a report with time, rows and bytes read for each compilation phase into this file if not empty.
+   * See CompileProfiler. */
+  const QString& getProfileReportFile() const
+  {
+    return profileReportFile;
+  }
+
+  void setProfileReportFile(const QString& value)
+  {
+    profileReportFile = value;
+  }
+
+  /* Save BGL directory listings into this file after loading and reuse them in the next compilation if not empty.
+   * Listings are validated against the modification time of directories and MSFS layout files. See FileResolverCache. */
+  const QString& getScanCacheFile() const
+  {
+    return scanCacheFile;
+  }
+
+  void setScanCacheFile(const QString& value)
+  {
+    scanCacheFile = value;
+  }
+
+  /* Save parsed MSFS material libraries and language files into this file and reuse them in the next compilation
+   * if not empty. Entries are validated against file size and modification time. See ParseCache. */
+  const QString& getParseCacheFile() const
+  {
+    return parseCacheFile;
+  }
+
+  void setParseCacheFile(const QString& value)
+  {
+    parseCacheFile = value;
+  }
+
+  /* Upper limit in MiB for the SQLite page cache and memory map used by the bulk load profile.
+   * 0 uses the defaults of the profile. */
+  int getMemoryLimitMb() const
+  {
+    return memoryLimitMb;
+  }
+
+  void setMemoryLimitMb(int value)
+  {
+    memoryLimitMb = value;
+  }
+
+  /* Read only inputs shared by several concurrent compilations. See NavDatabaseBatch. Not owned and null by default.
+   * Declination grid is used instead of calculating the world magnetic model.
+   * Language index and material library are used for MSFS instead of loading them. Have to be loaded
+   * for the same language and MSFS path and must not be lazy since they are accessed by several threads. */
+  const atools::fs::common::MagDecReader *getSharedMagDecReader() const
+  {
+    return sharedMagDecReader;
+  }
+
+  void setSharedMagDecReader(const atools::fs::common::MagDecReader *value)
+  {
+    sharedMagDecReader = value;
+  }
+
+  const atools::fs::scenery::LanguageJson *getSharedLanguageIndex() const
+  {
+    return sharedLanguageIndex;
+  }
+
+  void setSharedLanguageIndex(const atools::fs::scenery::LanguageJson *value)
+  {
+    sharedLanguageIndex = value;
+  }
+
+  const atools::fs::scenery::MaterialLib *getSharedMaterialLib() const
+  {
+    return sharedMaterialLib;
+  }
+
+  void setSharedMaterialLib(const atools::fs::scenery::MaterialLib *value)
+  {
+    sharedMaterialLib = value;
+  }
+
   bool isBasicValidation() const
   {
     return flags.testFlag(type::BASIC_VALIDATION);
@@ -433,6 +631,21 @@ public:
     return flags.testFlag(type::CREATE_AIRPORT_TABLES);
   }
 
+  bool isCreateProcedureGeometry() const
+  {
+    return flags.testFlag(type::CREATE_PROCEDURE_GEOMETRY);
+  }
+
+  bool isCreateTaxiGraph() const
+  {
+    return flags.testFlag(type::CREATE_TAXI_GRAPH);
+  }
+
+  bool isCreateApronMesh() const
+  {
+    return flags.testFlag(type::CREATE_APRON_MESH);
+  }
+
   bool isReadInactive() const
   {
     return flags.testFlag(type::READ_INACTIVE);
@@ -550,6 +763,15 @@ private:
 
   ProgressCallbackType progressCallback;
   bool callDefaultCallback = true;
+  int progressCallbackIntervalMs = 100;
+  int readerThreads = 0;
+
+  /* Not included in the debug output since these do not change the compiled data */
+  QString profileReportFile, scanCacheFile, parseCacheFile;
+  int memoryLimitMb = 0;
+  const atools::fs::common::MagDecReader *sharedMagDecReader = nullptr;
+  const atools::fs::scenery::LanguageJson *sharedLanguageIndex = nullptr;
+  const atools::fs::scenery::MaterialLib *sharedMaterialLib = nullptr;
 
   atools::fs::FsPaths::SimulatorType simulatorType = atools::fs::FsPaths::FSX;
 };
@@ -20,8 +20,10 @@
 #include "fs/ns/navservercommon.h"
 #include "fs/ns/navserverworker.h"
 #include "fs/sc/datareaderthread.h"
+#include "fs/sc/simconnectdata.h"
 #include "util/htmlbuilder.h"
 
+#include <QBuffer>
 #include <QNetworkInterface>
 #include <QHostInfo>
 
@@ -33,11 +35,13 @@ NavServer::NavServer(QObject *parent, atools::fs::ns::NavServerOptions optionFla
   : QTcpServer(parent), options(optionFlags), port(inetPort)
 {
   qDebug("NavServer created");
+  qRegisterMetaType<atools::fs::ns::NavServerPacket>();
 }
 
 NavServer::~NavServer()
 {
   stopServer();
+  delete lastData;
 }
 
 void NavServer::stopServer()
@@ -48,6 +52,10 @@ void NavServer::stopServer()
   if(isListening())
     close();
 
+  if(dataReader != nullptr)
+    disconnect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, this,
+               &NavServer::broadcastSimConnectData);
+
   // Stop all worker threads
   QSet<NavServerWorker *> workersCopy(workers);
   for(NavServerWorker *worker : workersCopy)
@@ -64,6 +72,10 @@ bool NavServer::startServer(atools::fs::sc::DataReaderThread *dataReaderThread)
   dataReader = dataReaderThread;
   qDebug() << "Navserver starting";
 
+  // Serialize in the reader thread once for all clients
+  connect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, this,
+          &NavServer::broadcastSimConnectData, Qt::UniqueConnection | Qt::DirectConnection);
+
   // hostname/ip/v6
   struct Host
   {
@@ -197,18 +209,69 @@ void NavServer::incomingConnection(qintptr socketDescriptor)
           threadFinished(worker);
         });
 
-  // Data reader will send simconnect packages through this connection
-  connect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, worker,
-          &NavServerWorker::postSimConnectData);
+  // Serialized simconnect packages are sent through this connection
+  connect(this, &NavServer::postPacket, worker, &NavServerWorker::postPacket);
   connect(worker, &NavServerWorker::postWeatherRequest,
           dataReader, &atools::fs::sc::DataReaderThread::setWeatherRequest);
 
   qDebug() << "Thread" << worker->objectName();
   workerThread->start();
 
+  QMutexLocker locker(&threadsMutex);
   workers.insert(worker);
 }
 
+void NavServer::broadcastSimConnectData(const atools::fs::sc::SimConnectData& dataPacket)
+{
+  if(!hasConnections())
+    return;
+
+  if(!dataPacket.getMetars().isEmpty() && dataPacket.getUserAircraftConst().isValid())
+    qWarning() << "Aircraft and metar mixed";
+
+  NavServerPacket packet;
+  packet.bytes = dataPacket.writeToBytes();
+  packet.packetId = dataPacket.getPacketId();
+
+  if(packet.packetId > 0)
+  {
+    // Build delta for clients supporting it. Weather replies are not used as base.
+    if(lastData != nullptr && numDeltaPackets < KEYFRAME_INTERVAL)
+    {
+      packet.deltaBytes = dataPacket.writeDeltaToBytes(*lastData);
+      packet.deltaBaseId = lastData->getPacketId();
+
+      // Decode delta to get the exact state as seen by clients including quantization
+      QBuffer buffer(&packet.deltaBytes);
+      buffer.open(QIODevice::ReadOnly);
+      atools::fs::sc::SimConnectData *decoded = new atools::fs::sc::SimConnectData;
+      if(decoded->read(&buffer, lastData))
+      {
+        delete lastData;
+        lastData = decoded;
+        numDeltaPackets++;
+      }
+      else
+      {
+        qWarning() << Q_FUNC_INFO << "Cannot decode delta" << decoded->getStatusText();
+        delete decoded;
+        packet.deltaBytes.clear();
+        packet.deltaBaseId = 0;
+      }
+    }
+
+    if(packet.deltaBytes.isEmpty())
+    {
+      // Keyframe
+      delete lastData;
+      lastData = new atools::fs::sc::SimConnectData(dataPacket);
+      numDeltaPackets = 0;
+    }
+  }
+
+  emit postPacket(packet);
+}
+
 void NavServer::threadFinished(NavServerWorker *worker)
 {
   qDebug() << "Thread" << worker->objectName() << "finished";
@@ -216,8 +279,7 @@ void NavServer::threadFinished(NavServerWorker *worker)
   // A thread has finished - lock the list so the thread can be removed from the list
   QMutexLocker locker(&threadsMutex);
 
-  disconnect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, worker,
-             &NavServerWorker::postSimConnectData);
+  disconnect(this, &NavServer::postPacket, worker, &NavServerWorker::postPacket);
 
   // TODO crashes when connected
   // disconnect(worker, &NavServerWorker::postCommand,
@@ -18,7 +18,9 @@
 #ifndef ATOOLS_NS_COMMON_H
 #define ATOOLS_NS_COMMON_H
 
+#include <QByteArray>
 #include <QLoggingCategory>
+#include <QMetaType>
 
 namespace atools {
 namespace fs {
@@ -37,8 +39,24 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(atools::fs::ns::NavServerOptions);
 /* Declare a own logging category to append in the text edit */
 Q_DECLARE_LOGGING_CATEGORY(gui);
 
+/* Serialized SimConnectData packet which is sent to all workers.
+ * The byte array is implicitly shared and never modified after creation. */
+struct NavServerPacket
+{
+  /* Full packet */
+  QByteArray bytes;
+
+  /* Optional delta packet relative to the packet with id deltaBaseId. Empty for keyframes. */
+  QByteArray deltaBytes;
+
+  /* Packet id of the data which has to be confirmed by the client. 0 for weather replies which are always sent. */
+  int packetId = 0, deltaBaseId = 0;
+};
+
 } // namespace ns
 } // namespace fs
 } // namespace atools
 
+Q_DECLARE_METATYPE(atools::fs::ns::NavServerPacket);
+
 #endif // ATOOLS_NS_COMMON_H
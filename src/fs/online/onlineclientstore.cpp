@@ -0,0 +1,434 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/online/onlineclientstore.h"
+
+#include "atools.h"
+#include "fs/sc/simconnectaircraft.h"
+#include "geo/rect.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "sql/sqlutil.h"
+#include "util/memoryaccounting.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+#include <cmath>
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlRecord;
+using atools::sql::SqlUtil;
+using atools::geo::Pos;
+using atools::geo::Rect;
+
+namespace atools {
+namespace fs {
+namespace online {
+
+OnlineClientStore::OnlineClientStore(const QString& tableName, const QString& idColumnName)
+  : tableName(tableName), idColumn(idColumnName)
+{
+
+}
+
+void OnlineClientStore::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  using atools::util::MemoryAccounting;
+
+  bytes += MemoryAccounting::vectorBytes(columns);
+  for(const QVector<QVariant>& column : columns)
+  {
+    bytes += MemoryAccounting::vectorBytes(column);
+    for(const QVariant& value : column)
+    {
+      if(value.userType() == QMetaType::QString)
+        bytes += MemoryAccounting::stringBytes(*static_cast<const QString *>(value.constData()));
+    }
+  }
+
+  for(const QVector<QString> *strings : {&callsigns, &vids})
+  {
+    bytes += MemoryAccounting::vectorBytes(*strings);
+    for(const QString& str : *strings)
+      bytes += MemoryAccounting::stringBytes(str);
+  }
+
+  bytes += MemoryAccounting::vectorBytes(ids) + MemoryAccounting::vectorBytes(positions) +
+           MemoryAccounting::vectorBytes(groundSpeeds) + MemoryAccounting::vectorBytes(headings) +
+           MemoryAccounting::hashBytes(idIndex) + MemoryAccounting::hashBytes(gridIndex);
+
+  // Callsign strings are shared with callsigns
+  bytes += static_cast<qint64>(callsignIndex.size()) *
+           static_cast<qint64>(sizeof(void *) + sizeof(QString) + sizeof(int));
+  for(const QVector<int>& cell : gridIndex)
+    bytes += MemoryAccounting::vectorBytes(cell);
+
+  elements += ids.size();
+}
+
+void OnlineClientStore::clear()
+{
+  for(QVector<QVariant>& column : columns)
+    column.clear();
+
+  ids.clear();
+  callsigns.clear();
+  vids.clear();
+  positions.clear();
+  groundSpeeds.clear();
+  headings.clear();
+  idIndex.clear();
+  callsignIndex.clear();
+  gridIndex.clear();
+  gridIndexValid = false;
+  updated = true;
+}
+
+void OnlineClientStore::reset()
+{
+  clear();
+  updated = false;
+}
+
+void OnlineClientStore::initColumns(const SqlQuery& query)
+{
+  columnNames.clear();
+  for(QString name : query.getPlaceholderList())
+  {
+    if(name.startsWith(':'))
+      name.remove(0, 1);
+    columnNames.append(name);
+  }
+
+  columns.clear();
+  columns.resize(columnNames.size());
+  initColumnIndexes();
+}
+
+void OnlineClientStore::initColumnIndexes()
+{
+  callsignColumn = columnNames.indexOf("callsign");
+  vidColumn = columnNames.indexOf("vid");
+  lonXColumn = columnNames.indexOf("lonx");
+  latYColumn = columnNames.indexOf("laty");
+  altitudeColumn = columnNames.indexOf("altitude");
+  groundSpeedColumn = columnNames.indexOf("groundspeed");
+  headingColumn = columnNames.indexOf("heading");
+}
+
+void OnlineClientStore::addFromQuery(const SqlQuery& query, int id)
+{
+  if(columnNames.isEmpty())
+    initColumns(query);
+
+  int index = idIndex.value(id, -1);
+  if(index == -1)
+  {
+    // Append new row ====================
+    index = ids.size();
+    for(QVector<QVariant>& column : columns)
+      column.append(QVariant());
+
+    ids.append(id);
+    callsigns.append(QString());
+    vids.append(QString());
+    positions.append(Pos());
+    groundSpeeds.append(0.f);
+    headings.append(0.f);
+    idIndex.insert(id, index);
+  }
+  else
+    // Replace row like "insert or replace" ====================
+    callsignIndex.remove(callsigns.at(index), index);
+
+  // Copy all bound values in placeholder order - id is bound last by the parser
+  for(int col = 0; col < columns.size(); col++)
+    columns[col][index] = query.boundValue(col, true /* ignoreInvalid */);
+
+  updateTypedColumns(index);
+  gridIndexValid = false;
+}
+
+void OnlineClientStore::updateTypedColumns(int index)
+{
+  auto valueAt = [this, index](int col) -> QVariant {
+                   return col != -1 ? columns.at(col).at(index) : QVariant();
+                 };
+
+  callsigns[index] = valueAt(callsignColumn).toString();
+  vids[index] = valueAt(vidColumn).toString();
+  groundSpeeds[index] = valueAt(groundSpeedColumn).toFloat();
+  headings[index] = valueAt(headingColumn).toFloat();
+
+  QVariant lonX = valueAt(lonXColumn), latY = valueAt(latYColumn);
+  if(!lonX.isNull() && !latY.isNull())
+    positions[index] = Pos(lonX.toFloat(), latY.toFloat(), valueAt(altitudeColumn).toFloat());
+  else
+    positions[index] = Pos();
+
+  callsignIndex.insert(callsigns.at(index), index);
+}
+
+void OnlineClientStore::writeToStream(QDataStream& out) const
+{
+  out << tableName << idColumn << columnNames << ids;
+  for(const QVector<QVariant>& column : columns)
+    out << column;
+}
+
+void OnlineClientStore::readFromStream(QDataStream& in)
+{
+  QString table, id;
+  in >> table >> id;
+  if(table != tableName || id != idColumn)
+  {
+    in.setStatus(QDataStream::ReadCorruptData);
+    return;
+  }
+
+  clear();
+  in >> columnNames >> ids;
+
+  columns.resize(columnNames.size());
+  for(QVector<QVariant>& column : columns)
+  {
+    in >> column;
+    if(column.size() != ids.size())
+      in.setStatus(QDataStream::ReadCorruptData);
+  }
+
+  if(in.status() != QDataStream::Ok)
+  {
+    clear();
+    return;
+  }
+
+  initColumnIndexes();
+
+  // Rebuild typed columns and indexes
+  int num = ids.size();
+  callsigns.resize(num);
+  vids.resize(num);
+  positions.resize(num);
+  groundSpeeds.resize(num);
+  headings.resize(num);
+  for(int i = 0; i < num; i++)
+  {
+    idIndex.insert(ids.at(i), i);
+    updateTypedColumns(i);
+  }
+}
+
+SqlRecord OnlineClientStore::getRecord(int index) const
+{
+  SqlRecord rec;
+  if(index >= 0 && index < ids.size())
+  {
+    for(int col = 0; col < columns.size(); col++)
+    {
+      const QString& name = columnNames.at(col);
+      if(name == idColumn)
+        rec.appendFieldAndValue(name, ids.at(index));
+      else
+        rec.appendFieldAndValue(name, columns.at(col).at(index));
+    }
+  }
+  return rec;
+}
+
+QVariant OnlineClientStore::value(int index, const QString& columnName) const
+{
+  if(columnName == idColumn)
+    return ids.at(index);
+
+  int col = columnNames.indexOf(columnName);
+  return col != -1 ? columns.at(col).at(index) : QVariant();
+}
+
+QVector<OnlineAircraft> OnlineClientStore::getOnlineAircraft() const
+{
+  QVector<OnlineAircraft> aircraft;
+  aircraft.reserve(ids.size());
+  for(int i = 0; i < ids.size(); i++)
+    aircraft.append(OnlineAircraft(ids.at(i), vids.at(i), callsigns.at(i),
+                                   atools::fs::sc::SimConnectAircraft::airplaneRegistrationToKey(callsigns.at(i)),
+                                   groundSpeeds.at(i), headings.at(i), positions.at(i)));
+  return aircraft;
+}
+
+int OnlineClientStore::cellForPos(float lonX, float latY)
+{
+  int x = std::max(0, std::min(359, static_cast<int>(std::floor(lonX + 180.f))));
+  int y = std::max(0, std::min(179, static_cast<int>(std::floor(latY + 90.f))));
+  return y * 360 + x;
+}
+
+void OnlineClientStore::buildSpatialIndex() const
+{
+  if(gridIndexValid)
+    return;
+
+  gridIndex.clear();
+  for(int i = 0; i < positions.size(); i++)
+  {
+    const Pos& pos = positions.at(i);
+    if(pos.isValid())
+      gridIndex[cellForPos(pos.getLonX(), pos.getLatY())].append(i);
+  }
+  gridIndexValid = true;
+}
+
+QVector<int> OnlineClientStore::indexesInRect(const Rect& rect) const
+{
+  QVector<int> indexes;
+  if(!rect.isValid() || ids.isEmpty())
+    return indexes;
+
+  buildSpatialIndex();
+
+  for(const Rect& r : rect.splitAtAntiMeridian())
+  {
+    int west = cellForPos(r.getWest(), 0.f) % 360, east = cellForPos(r.getEast(), 0.f) % 360;
+    int south = cellForPos(0.f, r.getSouth()) / 360, north = cellForPos(0.f, r.getNorth()) / 360;
+
+    if((east - west + 1) * (north - south + 1) > gridIndex.size())
+    {
+      // Less filled cells than cells to check - iterate over filled cells
+      for(auto it = gridIndex.constBegin(); it != gridIndex.constEnd(); ++it)
+      {
+        int x = it.key() % 360, y = it.key() / 360;
+        if(x >= west && x <= east && y >= south && y <= north)
+        {
+          for(int i : it.value())
+          {
+            if(r.contains(positions.at(i)))
+              indexes.append(i);
+          }
+        }
+      }
+    }
+    else
+    {
+      for(int y = south; y <= north; y++)
+      {
+        for(int x = west; x <= east; x++)
+        {
+          auto it = gridIndex.constFind(y * 360 + x);
+          if(it != gridIndex.constEnd())
+          {
+            for(int i : it.value())
+            {
+              if(r.contains(positions.at(i)))
+                indexes.append(i);
+            }
+          }
+        }
+      }
+    }
+  }
+  return indexes;
+}
+
+OnlineChanges OnlineClientStore::diff(const OnlineClientStore& oldStore, const OnlineClientStore& newStore)
+{
+  OnlineChanges changes;
+
+  // Columns can only be compared if both are filled from the same query
+  bool sameColumns = oldStore.columnNames == newStore.columnNames;
+
+  // Position related columns which are covered by moved
+  QVector<bool> positionColumn(newStore.columns.size(), false);
+  for(int col : {newStore.lonXColumn, newStore.latYColumn, newStore.altitudeColumn, newStore.headingColumn,
+                 newStore.groundSpeedColumn})
+  {
+    if(col != -1)
+      positionColumn[col] = true;
+  }
+
+  for(int newIndex = 0; newIndex < newStore.ids.size(); newIndex++)
+  {
+    int id = newStore.ids.at(newIndex);
+    int oldIndex = oldStore.indexOfId(id);
+
+    if(oldIndex == -1)
+      changes.added.append(id);
+    else
+    {
+      const Pos& oldPos = oldStore.positions.at(oldIndex);
+      const Pos& newPos = newStore.positions.at(newIndex);
+
+      if(oldPos.isValid() != newPos.isValid() || !oldPos.almostEqual(newPos) ||
+         atools::almostNotEqual(oldPos.getAltitude(), newPos.getAltitude()) ||
+         atools::almostNotEqual(oldStore.headings.at(oldIndex), newStore.headings.at(newIndex)) ||
+         atools::almostNotEqual(oldStore.groundSpeeds.at(oldIndex), newStore.groundSpeeds.at(newIndex)))
+        changes.moved.append(id);
+
+      bool changed = !sameColumns;
+      for(int col = 0; col < newStore.columns.size() && !changed; col++)
+      {
+        if(!positionColumn.at(col) && oldStore.columns.at(col).at(oldIndex) != newStore.columns.at(col).at(newIndex))
+          changed = true;
+      }
+
+      if(changed)
+        changes.changed.append(id);
+    }
+  }
+
+  for(int oldIndex = 0; oldIndex < oldStore.ids.size(); oldIndex++)
+  {
+    int id = oldStore.ids.at(oldIndex);
+    if(newStore.indexOfId(id) == -1)
+      changes.removed.append(id);
+  }
+
+  return changes;
+}
+
+void OnlineClientStore::writeToDatabase(sql::SqlDatabase *db) const
+{
+  db->exec("delete from " + tableName);
+
+  if(ids.isEmpty())
+    return;
+
+  SqlQuery insertQuery(db);
+  insertQuery.prepare(SqlUtil(db).buildInsertStatement(tableName, "or replace"));
+
+  for(int i = 0; i < ids.size(); i++)
+  {
+    insertQuery.clearBoundValues();
+    for(int col = 0; col < columns.size(); col++)
+    {
+      const QString& name = columnNames.at(col);
+      if(name == idColumn)
+        insertQuery.bindValue(':' + name, ids.at(i));
+      else if(insertQuery.hasPlaceholder(':' + name))
+        insertQuery.bindValue(':' + name, columns.at(col).at(i));
+    }
+    insertQuery.exec();
+  }
+
+  qDebug() << Q_FUNC_INFO << tableName << ids.size();
+}
+
+} // namespace online
+} // namespace fs
+} // namespace atools
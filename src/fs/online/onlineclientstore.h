@@ -0,0 +1,215 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_ONLINECLIENTSTORE_H
+#define ATOOLS_ONLINECLIENTSTORE_H
+
+#include "fs/online/onlinetypes.h"
+#include "geo/pos.h"
+#include "sql/sqltypes.h"
+
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+class QDataStream;
+
+namespace atools {
+namespace geo {
+class Rect;
+}
+
+namespace sql {
+class SqlDatabase;
+class SqlQuery;
+class SqlRecord;
+}
+
+namespace fs {
+namespace online {
+
+/*
+ * In-memory column store for the rows of the online tables "client" or "atc".
+ *
+ * Rows are taken from the bound values of the parser insert queries. All values are kept column by column and
+ * the frequently used ones like id, callsign and position additionally in typed columns.
+ * Provides lookup by id, by callsign and a lazily built grid index for spatial queries.
+ *
+ * Rows can be written into the respective database table if SQL access is needed.
+ *
+ * Copying is cheap since all columns are implicitly shared.
+ */
+class OnlineClientStore
+{
+public:
+  /* Table is only used for materialization. idColumn is the primary key like "client_id". */
+  OnlineClientStore(const QString& tableName, const QString& idColumnName);
+
+  /* Remove all rows and set the updated flag. Called by parser instead of deleting the table. */
+  void clear();
+
+  /* Remove all rows and the updated flag */
+  void reset();
+
+  /* true if clear() was called since last reset. Means the file contained the section. */
+  bool isUpdated() const
+  {
+    return updated;
+  }
+
+  /* Add a row from the currently bound values of the insert query. Replaces any row with the same id. */
+  void addFromQuery(const atools::sql::SqlQuery& query, int id);
+
+  int size() const
+  {
+    return ids.size();
+  }
+
+  /* Add approximate heap bytes of all rows and indexes */
+  void getMemoryUsage(qint64& bytes, qint64& elements) const;
+
+  bool isEmpty() const
+  {
+    return ids.isEmpty();
+  }
+
+  /* Row index for id or -1 if not found */
+  int indexOfId(int id) const
+  {
+    return idIndex.value(id, -1);
+  }
+
+  /* Row indexes for callsign. Normally only one. */
+  QVector<int> indexesOfCallsign(const QString& callsign) const
+  {
+    return callsignIndex.values(callsign).toVector();
+  }
+
+  /* Row indexes having a valid position inside rect */
+  QVector<int> indexesInRect(const atools::geo::Rect& rect) const;
+
+  /* Full row as record with column names like the database table */
+  atools::sql::SqlRecord getRecord(int index) const;
+
+  /* Value for row and column. Invalid if column does not exist. */
+  QVariant value(int index, const QString& columnName) const;
+
+  /* Typed columns for row index ==========================================*/
+  int getId(int index) const
+  {
+    return ids.at(index);
+  }
+
+  const QString& getCallsign(int index) const
+  {
+    return callsigns.at(index);
+  }
+
+  const QString& getVid(int index) const
+  {
+    return vids.at(index);
+  }
+
+  /* Position including altitude in ft. Invalid if not given in file. */
+  const atools::geo::Pos& getPosition(int index) const
+  {
+    return positions.at(index);
+  }
+
+  float getGroundSpeed(int index) const
+  {
+    return groundSpeeds.at(index);
+  }
+
+  float getHeading(int index) const
+  {
+    return headings.at(index);
+  }
+
+  /* Get aircraft information for all rows. Used for online/simulator deduplication. */
+  QVector<atools::fs::online::OnlineAircraft> getOnlineAircraft() const;
+
+  /* Compare rows by id and collect added, removed, moved and changed ids from oldStore to newStore */
+  static atools::fs::online::OnlineChanges diff(const atools::fs::online::OnlineClientStore& oldStore,
+                                                const atools::fs::online::OnlineClientStore& newStore);
+
+  /* Delete table and write all rows. Does not commit. */
+  void writeToDatabase(atools::sql::SqlDatabase *db) const;
+
+  /* Write all rows into stream or read them back. Sets ReadCorruptData on the stream if data does not match
+   * this table. Reading sets the updated flag. */
+  void writeToStream(QDataStream& out) const;
+  void readFromStream(QDataStream& in);
+
+  const QString& getTableName() const
+  {
+    return tableName;
+  }
+
+  const QStringList& getColumnNames() const
+  {
+    return columnNames;
+  }
+
+private:
+  /* Get column names from query and column numbers for typed columns */
+  void initColumns(const atools::sql::SqlQuery& query);
+  void initColumnIndexes();
+
+  /* Copy values from generic columns into typed columns and callsign index for row index */
+  void updateTypedColumns(int index);
+
+  /* Cell number for grid index */
+  static int cellForPos(float lonX, float latY);
+
+  /* Build grid index if not done already */
+  void buildSpatialIndex() const;
+
+  QString tableName, idColumn;
+  bool updated = false;
+
+  /* All columns from query placeholders without colon */
+  QStringList columnNames;
+  int callsignColumn = -1, vidColumn = -1, lonXColumn = -1, latYColumn = -1, altitudeColumn = -1,
+      groundSpeedColumn = -1, headingColumn = -1;
+
+  /* Values for each column. Outer index is column and inner is row. */
+  QVector<QVector<QVariant> > columns;
+
+  /* Typed columns */
+  QVector<int> ids;
+  QVector<QString> callsigns, vids;
+  QVector<atools::geo::Pos> positions;
+  QVector<float> groundSpeeds, headings;
+
+  /* Id to row index */
+  QHash<int, int> idIndex;
+
+  /* Callsign to row index */
+  QMultiHash<QString, int> callsignIndex;
+
+  /* One degree grid cell to row indexes. Built on first spatial query. */
+  mutable QHash<int, QVector<int> > gridIndex;
+  mutable bool gridIndexValid = false;
+};
+
+} // namespace online
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_ONLINECLIENTSTORE_H
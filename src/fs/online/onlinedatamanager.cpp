@@ -17,6 +17,7 @@
 
 #include "fs/online/onlinedatamanager.h"
 
+#include "fs/online/onlineclientstore.h"
 #include "fs/online/statustextparser.h"
 #include "fs/online/whazzuptextparser.h"
 
@@ -27,8 +28,11 @@
 #include "sql/sqlrecord.h"
 #include "sql/sqlscript.h"
 #include "fs/sc/simconnectaircraft.h"
+#include "exception.h"
 
+#include <QDataStream>
 #include <QDebug>
+#include <QFile>
 
 using atools::sql::SqlDatabase;
 using atools::sql::SqlQuery;
@@ -41,12 +45,21 @@ namespace atools {
 namespace fs {
 namespace online {
 
+static const quint32 ONLINE_SNAPSHOT_MAGIC_NUMBER = 0x4E4C4E4F;
+static const quint32 ONLINE_SNAPSHOT_VERSION = 1;
+
 OnlinedataManager::OnlinedataManager(sql::SqlDatabase *sqlDb, bool verboseErrorReporting)
   : db(sqlDb)
 {
   status = new StatusTextParser;
   whazzup = new WhazzupTextParser(db, verboseErrorReporting);
   whazzupServers = new WhazzupTextParser(db, verboseErrorReporting);
+
+  clientStore = new OnlineClientStore("client", "client_id");
+  atcStore = new OnlineClientStore("atc", "atc_id");
+  clientStoreRead = new OnlineClientStore("client", "client_id");
+  atcStoreRead = new OnlineClientStore("atc", "atc_id");
+  whazzup->setStores(clientStoreRead, atcStoreRead);
 }
 
 OnlinedataManager::~OnlinedataManager()
@@ -54,25 +67,237 @@ OnlinedataManager::~OnlinedataManager()
   delete status;
   delete whazzup;
   delete whazzupServers;
+  delete clientStore;
+  delete atcStore;
+  delete clientStoreRead;
+  delete atcStoreRead;
 }
 
 bool OnlinedataManager::readFromWhazzup(const QString& whazzupTxt, atools::fs::online::Format format, const QDateTime& lastUpdate)
 {
   SqlTransaction transaction(db);
 
+  clientStoreRead->reset();
+  atcStoreRead->reset();
+
   bool retval = whazzup->read(whazzupTxt, format, lastUpdate);
   if(retval)
     transaction.commit();
   else
     transaction.rollback();
+
+  swapStores(retval);
   return retval;
 }
 
+bool OnlinedataManager::readFromWhazzup(const QByteArray& whazzupBytes, Format format, const QDateTime& lastUpdate)
+{
+  SqlTransaction transaction(db);
+
+  clientStoreRead->reset();
+  atcStoreRead->reset();
+
+  bool retval = whazzup->read(whazzupBytes, format, lastUpdate);
+  if(retval)
+    transaction.commit();
+  else
+    transaction.rollback();
+
+  swapStores(retval);
+  return retval;
+}
+
+void OnlinedataManager::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  for(const OnlineClientStore *store : {clientStore, atcStore, clientStoreRead, atcStoreRead})
+  {
+    if(store != nullptr)
+      store->getMemoryUsage(bytes, elements);
+  }
+}
+
+void OnlinedataManager::swapStores(bool retval)
+{
+  clientChanges.clear();
+  atcChanges.clear();
+
+  if(retval)
+  {
+    // Keep current data for sections which were not found in the file
+    // Previous data is in the read stores after swapping
+    if(clientStoreRead->isUpdated())
+    {
+      std::swap(clientStore, clientStoreRead);
+      clientChanges = OnlineClientStore::diff(*clientStoreRead, *clientStore);
+      databaseOutdated = databaseOnDemand;
+    }
+
+    if(atcStoreRead->isUpdated())
+    {
+      std::swap(atcStore, atcStoreRead);
+      atcChanges = OnlineClientStore::diff(*atcStoreRead, *atcStore);
+      databaseOutdated = databaseOnDemand;
+    }
+
+    qDebug() << Q_FUNC_INFO << "clients added" << clientChanges.added.size() << "removed" << clientChanges.removed.size()
+             << "moved" << clientChanges.moved.size() << "changed" << clientChanges.changed.size()
+             << "atc added" << atcChanges.added.size() << "removed" << atcChanges.removed.size()
+             << "changed" << atcChanges.changed.size();
+
+    if(changeCallback && (!clientChanges.isEmpty() || !atcChanges.isEmpty()))
+      changeCallback(clientChanges, atcChanges);
+  }
+
+  // Release memory of outdated or partially read data
+  clientStoreRead->reset();
+  atcStoreRead->reset();
+}
+
+void OnlinedataManager::setDatabaseOnDemand(bool value)
+{
+  databaseOnDemand = value;
+  whazzup->setWriteDatabase(!databaseOnDemand);
+
+  // Tables are not in sync with stores if switched to on demand
+  databaseOutdated = databaseOnDemand;
+}
+
+void OnlinedataManager::updateDatabase()
+{
+  if(databaseOutdated)
+  {
+    SqlTransaction transaction(db);
+    clientStore->writeToDatabase(db);
+    atcStore->writeToDatabase(db);
+    transaction.commit();
+    databaseOutdated = false;
+  }
+}
+
+void OnlinedataManager::writeSnapshot(const QString& filename) const
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+
+  whazzup->writeState(out);
+  clientStore->writeToStream(out);
+  atcStore->writeToStream(out);
+
+  // Servers are not kept in a store - copy table
+  SqlQuery query("select * from server", db);
+  query.exec();
+  QStringList columnNames;
+  QVector<QVariantList> rows;
+  while(query.next())
+  {
+    SqlRecord rec = query.record();
+    if(columnNames.isEmpty())
+      columnNames = rec.fieldNames();
+
+    QVariantList row;
+    for(int i = 0; i < rec.count(); i++)
+      row.append(rec.value(i));
+    rows.append(row);
+  }
+  out << columnNames << rows;
+
+  QFile file(filename);
+  if(!file.open(QIODevice::WriteOnly))
+    throw atools::Exception(QString("Cannot open file \"%1\". Reason: %2.").arg(filename).arg(file.errorString()));
+
+  QDataStream fileOut(&file);
+  fileOut.setVersion(QDataStream::Qt_5_5);
+  fileOut << ONLINE_SNAPSHOT_MAGIC_NUMBER << ONLINE_SNAPSHOT_VERSION << qCompress(bytes);
+  file.close();
+
+  qDebug() << Q_FUNC_INFO << filename << "clients" << clientStore->size() << "atc" << atcStore->size()
+           << "servers" << rows.size() << "bytes" << bytes.size();
+}
+
+void OnlinedataManager::readSnapshot(const QString& filename)
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    throw atools::Exception(QString("Cannot open file \"%1\". Reason: %2.").arg(filename).arg(file.errorString()));
+
+  QDataStream fileIn(&file);
+  fileIn.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magicNumber, version;
+  QByteArray compressed;
+  fileIn >> magicNumber >> version;
+  if(magicNumber != ONLINE_SNAPSHOT_MAGIC_NUMBER)
+    throw atools::Exception(QString("File \"%1\" is not an online snapshot.").arg(filename));
+  if(version != ONLINE_SNAPSHOT_VERSION)
+    throw atools::Exception(QString("File \"%1\" has wrong version %2.").arg(filename).arg(version));
+
+  fileIn >> compressed;
+  file.close();
+
+  QByteArray bytes = qUncompress(compressed);
+  QDataStream in(&bytes, QIODevice::ReadOnly);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  clientStoreRead->reset();
+  atcStoreRead->reset();
+
+  whazzup->readState(in);
+  clientStoreRead->readFromStream(in);
+  atcStoreRead->readFromStream(in);
+
+  QStringList columnNames;
+  QVector<QVariantList> rows;
+  in >> columnNames >> rows;
+
+  if(in.status() != QDataStream::Ok)
+  {
+    swapStores(false);
+    throw atools::Exception(QString("File \"%1\" contains invalid data.").arg(filename));
+  }
+
+  SqlTransaction transaction(db);
+  db->exec("delete from server");
+  if(!rows.isEmpty())
+  {
+    SqlQuery insertQuery(db);
+    insertQuery.prepare(SqlUtil(db).buildInsertStatement("server"));
+    for(const QVariantList& row : rows)
+    {
+      insertQuery.clearBoundValues();
+      for(int i = 0; i < columnNames.size() && i < row.size(); i++)
+      {
+        if(insertQuery.hasPlaceholder(':' + columnNames.at(i)))
+          insertQuery.bindValue(':' + columnNames.at(i), row.at(i));
+      }
+      insertQuery.exec();
+    }
+  }
+
+  swapStores(true);
+
+  if(!databaseOnDemand)
+  {
+    // Tables are only written for on demand mode when needed
+    clientStore->writeToDatabase(db);
+    atcStore->writeToDatabase(db);
+  }
+  transaction.commit();
+
+  qDebug() << Q_FUNC_INFO << filename << "clients" << clientStore->size() << "atc" << atcStore->size()
+           << "servers" << rows.size();
+}
+
 void OnlinedataManager::readFromTransceivers(const QString& transceiverTxt)
 {
   whazzup->readTransceivers(transceiverTxt);
 }
 
+void OnlinedataManager::readFromTransceivers(const QByteArray& transceiverBytes)
+{
+  whazzup->readTransceivers(transceiverBytes);
+}
+
 bool OnlinedataManager::readServersFromWhazzup(const QString& whazzupTxt, Format format, const QDateTime& lastUpdate)
 {
   SqlTransaction transaction(db);
@@ -121,7 +346,8 @@ bool OnlinedataManager::hasSchema()
 
 bool OnlinedataManager::hasData()
 {
-  return SqlUtil(db).hasTableAndRows("client") || SqlUtil(db).hasTableAndRows("atc");
+  return !clientStore->isEmpty() || !atcStore->isEmpty() ||
+         SqlUtil(db).hasTableAndRows("client") || SqlUtil(db).hasTableAndRows("atc");
 }
 
 void OnlinedataManager::createSchema()
@@ -142,6 +368,12 @@ void OnlinedataManager::clearData()
   for(const QString& table : tables)
     db->exec("delete from " + table);
   transaction.commit();
+
+  clientStore->reset();
+  atcStore->reset();
+  clientChanges.clear();
+  atcChanges.clear();
+  databaseOutdated = false;
 }
 
 void OnlinedataManager::dropSchema()
@@ -190,45 +422,25 @@ atools::fs::sc::SimConnectAircraft OnlinedataManager::getClientAircraft(const at
 
 sql::SqlRecord OnlinedataManager::getClientRecordById(int clientId)
 {
-  SqlQuery query(db);
-  query.prepare("select * from client where client_id = :id");
-  query.bindValue(":id", clientId);
-  query.exec();
-  SqlRecord rec;
-  if(query.next())
-    rec = query.record();
-  query.finish();
-  return rec;
+  return clientStore->getRecord(clientStore->indexOfId(clientId));
 }
 
 sql::SqlRecordList OnlinedataManager::getClientRecordsByCallsign(const QString& callsign)
 {
-  SqlQuery query(db);
-  query.prepare("select * from client where callsign = :callsign");
-  query.bindValue(":callsign", callsign);
-  query.exec();
   sql::SqlRecordList recs;
-  while(query.next())
-    recs.append(query.record());
+  for(int index : clientStore->indexesOfCallsign(callsign))
+    recs.append(clientStore->getRecord(index));
   return recs;
 }
 
 QVector<OnlineAircraft> OnlinedataManager::getClientCallsignAndPosMap()
 {
-  QVector<OnlineAircraft> clientMap;
-  SqlQuery query("select client_id, vid, callsign, groundspeed, heading, altitude, lonx, laty from client", db);
-  query.exec();
-  while(query.next())
-    clientMap.append(OnlineAircraft(query.valueInt("client_id"), query.valueStr("vid"), query.valueStr("callsign"),
-                                    atools::fs::sc::SimConnectAircraft::airplaneRegistrationToKey(query.valueStr("callsign")),
-                                    query.valueFloat("groundspeed"), query.valueFloat("heading"),
-                                    atools::geo::Pos(query.valueFloat("lonx"), query.valueFloat("laty"), query.valueFloat("altitude"))));
-  return clientMap;
+  return clientStore->getOnlineAircraft();
 }
 
 int OnlinedataManager::getNumClients() const
 {
-  return SqlUtil(db).rowCount("client");
+  return clientStore->size();
 }
 
 void OnlinedataManager::setAtcSize(const QHash<fac::FacilityType, int>& value)
@@ -270,7 +482,7 @@ void OnlinedataManager::fillFromClient(sc::SimConnectAircraft& ac, const sql::Sq
   }
 
   ac.objectId = static_cast<quint32>(record.valueInt("client_id"));
-  ac.airplaneReg = record.valueStr("callsign");
+  ac.info->airplaneReg = record.valueStr("callsign");
 
   // record.valueStr("vid");
   // record.valueStr("name");
@@ -284,15 +496,15 @@ void OnlinedataManager::fillFromClient(sc::SimConnectAircraft& ac, const sql::Sq
   // ac.airplaneFlightnumber,
 
   ac.groundSpeedKts = record.valueFloat("groundspeed");
-  ac.airplaneType = record.valueStr("flightplan_aircraft");
+  ac.info->airplaneType = record.valueStr("flightplan_aircraft");
 
   // record.valueStr("flightplan_cruising_speed");
 
-  ac.fromIdent = record.valueStr("flightplan_departure_aerodrome");
+  ac.info->fromIdent = record.valueStr("flightplan_departure_aerodrome");
 
   // record.valueStr("flightplan_cruising_level");
 
-  ac.toIdent = record.valueStr("flightplan_destination_aerodrome");
+  ac.info->toIdent = record.valueStr("flightplan_destination_aerodrome");
 
   // Convert octal string to decimal
   bool ok;
@@ -20,6 +20,7 @@
 
 #include "fs/online/onlinetypes.h"
 #include "sql/sqltypes.h"
+#include "util/memoryaccounting.h"
 
 #include <QString>
 
@@ -43,6 +44,7 @@ class SimConnectAircraft;
 
 namespace online {
 
+class OnlineClientStore;
 class StatusTextParser;
 class WhazzupTextParser;
 
@@ -50,16 +52,19 @@ class WhazzupTextParser;
  * Facade for online classes that parse whazzup.txt and status.txt files for IVAO, VATSIM or other muultiplayer
  * services.
  *
- * All content from whazzup.txt is written into the given database.
+ * Clients and ATC are kept in in-memory stores which are used for all queries of this class.
+ * All content from whazzup.txt is written into the given database. Writing of tables client and atc
+ * can be deferred until updateDatabase() is called. See setDatabaseOnDemand().
  *
  * Check for schema and create this before reading.
  */
-class OnlinedataManager
+class OnlinedataManager :
+  public atools::util::MemoryAccountable
 {
 
 public:
   OnlinedataManager(atools::sql::SqlDatabase *sqlDb, bool verboseErrorReporting);
-  ~OnlinedataManager();
+  virtual ~OnlinedataManager() override;
 
   OnlinedataManager(const OnlinedataManager& other) = delete;
   OnlinedataManager& operator=(const OnlinedataManager& other) = delete;
@@ -71,12 +76,25 @@ public:
    * Returns true if the file was read and is more recent than lastUpdate. */
   bool readFromWhazzup(const QString& whazzupTxt, Format format, const QDateTime& lastUpdate);
 
+  /* As above but streams JSON formats directly from the downloaded UTF-8 bytes. Preferred for JSON. */
+  bool readFromWhazzup(const QByteArray& whazzupBytes, Format format, const QDateTime& lastUpdate);
+
   /* Read VATSIM transceivers-data.json and stores map in this object. Call before calling "readFromWhazzup" */
   void readFromTransceivers(const QString& transceiverTxt);
+  void readFromTransceivers(const QByteArray& transceiverBytes);
 
   /* Read all servers and voice_servers from whazzup.txt file with file content in string and writes all into the database */
   bool readServersFromWhazzup(const QString& whazzupTxt, Format format, const QDateTime& lastUpdate);
 
+  /* Write parsed clients, ATC, servers, transceivers and timestamps into a compact binary snapshot file.
+   * Throws atools::Exception on error. */
+  void writeSnapshot(const QString& filename) const;
+
+  /* Load a snapshot written by writeSnapshot() without parsing. Replaces all online data and
+   * fills tables depending on setDatabaseOnDemand(). Changes are reported like for readFromWhazzup().
+   * Throws atools::Exception on error. */
+  void readSnapshot(const QString& filename);
+
   /* Get a randon URL from the status file which points to the redundant whazzup files */
   QString getWhazzupUrlFromStatus(bool& gzipped, bool& json) const;
 
@@ -146,6 +164,45 @@ public:
   /* Number of client aircraft in client table */
   int getNumClients() const;
 
+  /* In-memory stores for current clients and ATC */
+  const atools::fs::online::OnlineClientStore& getClientStore() const
+  {
+    return *clientStore;
+  }
+
+  const atools::fs::online::OnlineClientStore& getAtcStore() const
+  {
+    return *atcStore;
+  }
+
+  /* Current and read client and ATC stores. Elements are clients and ATC stations. Nothing can be released. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
+  /* Changes of the last successful readFromWhazzup() call. Empty if nothing changed or the section was
+   * not contained in the file. */
+  const atools::fs::online::OnlineChanges& getClientChanges() const
+  {
+    return clientChanges;
+  }
+
+  const atools::fs::online::OnlineChanges& getAtcChanges() const
+  {
+    return atcChanges;
+  }
+
+  /* Set a callback which is called after readFromWhazzup() if clients or ATC changed */
+  void setChangeCallback(atools::fs::online::ChangeCallbackType func)
+  {
+    changeCallback = func;
+  }
+
+  /* Do not write tables client and atc when reading whazzup. Tables are written on demand by calling
+   * updateDatabase() which is needed before using SQL on these tables. Default is false. */
+  void setDatabaseOnDemand(bool value);
+
+  /* Write stores into tables client and atc if changed since last call and writing is deferred. Commits. */
+  void updateDatabase();
+
   /* Set default circle radii for certain ATC types where visual range is unusable */
   void setAtcSize(const QHash<atools::fs::online::fac::FacilityType, int>& value);
 
@@ -156,9 +213,21 @@ public:
 private:
   atools::sql::SqlDatabase *db;
 
+  /* Swap stores into current if read successfully */
+  void swapStores(bool retval);
+
   atools::fs::online::WhazzupTextParser *whazzup = nullptr;
   atools::fs::online::WhazzupTextParser *whazzupServers = nullptr;
   atools::fs::online::StatusTextParser *status = nullptr;
+
+  /* Current stores and the ones filled by the parser */
+  atools::fs::online::OnlineClientStore *clientStore = nullptr, *atcStore = nullptr,
+                                        *clientStoreRead = nullptr, *atcStoreRead = nullptr;
+
+  bool databaseOnDemand = false, databaseOutdated = false;
+
+  atools::fs::online::OnlineChanges clientChanges, atcChanges;
+  atools::fs::online::ChangeCallbackType changeCallback;
 };
 
 } // namespace online
@@ -68,6 +68,34 @@ struct OnlineAircraft
 
 };
 
+/* Changes between two online data updates. Contains database ids client.client_id or atc.atc_id
+ * which are kept stable between updates for the same callsign, facility type and vid. */
+struct OnlineChanges
+{
+  /* New and vanished ids */
+  QVector<int> added, removed;
+
+  /* Position, altitude, heading or ground speed changed */
+  QVector<int> moved;
+
+  /* Any other column like flight plan, frequency or ATIS changed. Can overlap with moved. */
+  QVector<int> changed;
+
+  bool isEmpty() const
+  {
+    return added.isEmpty() && removed.isEmpty() && moved.isEmpty() && changed.isEmpty();
+  }
+
+  void clear()
+  {
+    added.clear();
+    removed.clear();
+    moved.clear();
+    changed.clear();
+  }
+
+};
+
 /* Online data format which is to be downloaded. */
 enum Format
 {
@@ -179,6 +207,10 @@ enum Simulator
  * Default circle will be used if this returns an empty byte array. */
 typedef std::function<const atools::geo::LineString *(const QString& callsign, atools::fs::online::fac::FacilityType type)> GeoCallbackType;
 
+/* Called after a successful update with changes for clients and ATC */
+typedef std::function<void (const atools::fs::online::OnlineChanges& clientChanges,
+                            const atools::fs::online::OnlineChanges& atcChanges)> ChangeCallbackType;
+
 QString facilityTypeText(int type);
 
 /* Display text like "Observer", "Ground", "Tower", etc. */
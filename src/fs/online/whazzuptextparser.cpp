@@ -17,16 +17,21 @@
 
 #include "fs/online/whazzuptextparser.h"
 
+#include "fs/online/onlineclientstore.h"
+
 #include "sql/sqlquery.h"
 #include "sql/sqlutil.h"
 #include "geo/calculations.h"
 #include "sql/sqldatabase.h"
 #include "geo/linestring.h"
 #include "fs/common/binarygeometry.h"
+#include "util/jsonstreamreader.h"
+#include "util/tracing.h"
 
+#include <QDataStream>
 #include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
+#include <QStringBuilder>
 #include <QTextCodec>
 
 using atools::sql::SqlDatabase;
@@ -152,7 +157,7 @@ bool WhazzupTextParser::read(QString file, Format streamFormat, const QDateTime&
   format = streamFormat;
 
   if(streamFormat == VATSIM_JSON3 || streamFormat == IVAO_JSON2)
-    return readInternalJson(file, lastUpdate);
+    return readInternalJson(file.toUtf8(), lastUpdate);
   else
   {
     QTextStream stream(&file, QIODevice::ReadOnly | QIODevice::Text);
@@ -160,7 +165,24 @@ bool WhazzupTextParser::read(QString file, Format streamFormat, const QDateTime&
   }
 }
 
+bool WhazzupTextParser::read(const QByteArray& bytes, Format streamFormat, const QDateTime& lastUpdate)
+{
+  if(streamFormat == VATSIM_JSON3 || streamFormat == IVAO_JSON2)
+  {
+    reset(); // Also resets format
+    format = streamFormat;
+    return readInternalJson(bytes, lastUpdate);
+  }
+  else
+    return read(QString::fromUtf8(bytes), streamFormat, lastUpdate);
+}
+
 void WhazzupTextParser::readTransceivers(const QString& file)
+{
+  readTransceivers(file.toUtf8());
+}
+
+void WhazzupTextParser::readTransceivers(const QByteArray& bytes)
 {
   transceiverMap.clear();
 
@@ -179,17 +201,10 @@ void WhazzupTextParser::readTransceivers(const QString& file)
   // ]
   // },
 
-  // Open and check for errors
-  QJsonParseError jsonErr;
-  QJsonDocument doc = QJsonDocument::fromJson(file.toUtf8(), &jsonErr);
-  if(jsonErr.error != QJsonParseError::NoError)
-    qWarning() << Q_FUNC_INFO << "Error reading data" << jsonErr.errorString() << "at offset" << jsonErr.offset;
-
-  // Top level is an array or unnamed objects
-  const QJsonArray transValues = doc.array();
-  for(const QJsonValue& transVal : transValues)
-  {
-    QJsonObject transObj = transVal.toObject();
+  // Top level is an array or unnamed objects - get them one by one
+  atools::util::JsonStreamReader reader;
+  reader.addArrayPath(QString());
+  reader.setElementCallback([this](const QString&, const QJsonObject& transObj) -> bool {
     QString callsign = transObj.value("callsign").toString();
 
     // Get all transceivers with coordinates and frequency for this callsign
@@ -197,7 +212,6 @@ void WhazzupTextParser::readTransceivers(const QString& file)
     for(const QJsonValue& transceiverVal : transceiverValues)
     {
       QJsonObject transceiverObj = transceiverVal.toObject();
-      Pos pos(transceiverObj.value("lonDeg"), transceiverObj.value("latDeg"));
 
       // Build and add object to multi hash with callsign as key
       Transceiver transceiver;
@@ -211,19 +225,23 @@ void WhazzupTextParser::readTransceivers(const QString& file)
       transceiver.pos = Pos(transceiverObj.value("lonDeg"), transceiverObj.value("latDeg"));
       transceiverMap.insertMulti(callsign, transceiver);
     } // for(QJsonValue transceiverVal : transObj.value("transceivers").toArray())
-  } // for(QJsonValue transVal : doc.array())
+    return true;
+  });
+
+  // Open and check for errors
+  if(!reader.read(bytes))
+    qWarning() << Q_FUNC_INFO << "Error reading data" << reader.getErrorString() << "at offset" << reader.getErrorOffset();
 }
 
-bool WhazzupTextParser::readInternalJson(const QString& file, const QDateTime& lastUpdate)
+bool WhazzupTextParser::readInternalJson(const QByteArray& bytes, const QDateTime& lastUpdate)
 {
-  // Open and check for errors =============
-  QJsonParseError jsonErr;
-  QJsonDocument doc = QJsonDocument::fromJson(file.toUtf8(), &jsonErr);
-  if(jsonErr.error != QJsonParseError::NoError)
-    qWarning() << Q_FUNC_INFO << "Error reading data" << jsonErr.errorString() << "at offset" << jsonErr.offset;
+  ATOOLS_TRACE_SPAN("online", "WhazzupTextParser::readJson");
 
+  // File is streamed and elements are inserted while reading. Sections might appear before the timestamp
+  // which results in deleted tables if the file is outdated. Caller rolls the transaction back in this case.
+  atools::util::JsonStreamReader reader;
   QDateTime update;
-  QJsonObject obj = doc.object();
+  bool outdated = false;
 
   if(format == VATSIM_JSON3)
   {
@@ -236,63 +254,107 @@ bool WhazzupTextParser::readInternalJson(const QString& file, const QDateTime& l
     // "connected_clients": 1857,
     // "unique_users": 1777
     // },
-    QJsonObject generalObj = obj.value("general").toObject();
-    update = generalObj.value("update_timestamp").toVariant().toDateTime();
+    reader.addValuePath("general/update_timestamp");
+    reader.addValuePath("general/version");
+    reader.addValuePath("general/reload");
 
-    // Version and reload time in minutes
-    version = generalObj.value("version").toInt();
-    reload = generalObj.value("reload").toInt();
+    reader.addArrayPath("pilots");
+    reader.addArrayPath("controllers");
+    reader.addArrayPath("servers");
+
+    // Prefiles - only VATSIM
+    reader.addArrayPath("prefiles");
+
+    // ATIS - only VATSIM
+    // "atis" - readAtisJson(obj); TODO Currently ignored since missing connection to controllers
   }
   else if(format == IVAO_JSON2)
-    // "updatedAt": "2021-06-20T21:09:19.642Z",
-    update = obj.value("updatedAt").toVariant().toDateTime();
-
-  if(update.isValid())
   {
-    if(update <= lastUpdate)
-      // This is older than the last update - bail out
-      return false;
+    // "updatedAt": "2021-06-20T21:09:19.642Z",
+    reader.addValuePath("updatedAt");
 
-    update.setTimeSpec(Qt::UTC);
-    updateTimestamp = update;
+    reader.addArrayPath("clients/pilots");
+    reader.addArrayPath("clients/atcs");
+    reader.addArrayPath("clients/observers");
+    reader.addArrayPath("servers");
+    reader.addArrayPath("voiceServers");
   }
 
-  // Read other object arrays ==================================================================
-  // Clients/pilots =================================
-  QJsonObject clients = format == VATSIM_JSON3 ? obj : obj.value("clients").toObject();
-  QJsonArray pilotsArr = clients.value("pilots").toArray();
-  if(!pilotsArr.isEmpty())
-    db->exec("delete from client");
-
-  readPilotsJson(pilotsArr);
-
-  // Controllers/atcs and observers =================================
-  QJsonArray controllersArr = format == VATSIM_JSON3 ? obj.value("controllers").toArray() :
-                              obj.value("clients").toObject().value("atcs").toArray();
-  if(!controllersArr.isEmpty())
-    db->exec("delete from atc");
-  readControllersJson(controllersArr, false /* observer */);
-
-  if(format == IVAO_JSON2)
-    readControllersJson(clients.value("observers").toArray(), true /* observer */);
+  reader.setValueCallback([&](const QString& path, const QJsonValue& value) -> bool {
+    if(path == QLatin1String("general/version"))
+      version = value.toInt();
+    else if(path == QLatin1String("general/reload"))
+      // Reload time in minutes
+      reload = value.toInt();
+    else
+    {
+      update = value.toVariant().toDateTime();
+      if(update.isValid())
+      {
+        if(update <= lastUpdate)
+        {
+          // This is older than the last update - bail out
+          outdated = true;
+          return false;
+        }
 
-  // Servers =================================
-  QJsonArray serversArr = obj.value("servers").toArray();
-  if(!serversArr.isEmpty())
-    db->exec("delete from server");
-  readServersJson(serversArr, false /* voice */);
+        update.setTimeSpec(Qt::UTC);
+        updateTimestamp = update;
+      }
+    }
+    return true;
+  });
 
-  if(format == IVAO_JSON2)
-    readServersJson(obj.value("voiceServers").toArray(), true /* voice */);
+  // Clear tables before first insert
+  QSet<QString> clearedTables;
+  auto clearTable = [this, &clearedTables](const QString& table) {
+    if(!clearedTables.contains(table))
+    {
+      clearStoreOrTable(table);
+      clearedTables.insert(table);
+    }
+  };
 
-  // Prefiles - only VATSIM =================================
-  if(format == VATSIM_JSON3)
-    readPrefilesJson(obj);
+  // Read object arrays one element at a time =============================================
+  reader.setElementCallback([&](const QString& path, const QJsonObject& obj) -> bool {
+    if(path == QLatin1String("pilots") || path == QLatin1String("clients/pilots"))
+    {
+      // Clients/pilots =================================
+      clearTable("client");
+      readPilotJson(obj);
+    }
+    else if(path == QLatin1String("controllers") || path == QLatin1String("clients/atcs"))
+    {
+      // Controllers/atcs and observers =================================
+      clearTable("atc");
+      readControllerJson(obj, false /* observer */);
+    }
+    else if(path == QLatin1String("clients/observers"))
+    {
+      clearTable("atc");
+      readControllerJson(obj, true /* observer */);
+    }
+    else if(path == QLatin1String("servers"))
+    {
+      // Servers =================================
+      clearTable("server");
+      readServerJson(obj, false /* voice */);
+    }
+    else if(path == QLatin1String("voiceServers"))
+    {
+      clearTable("server");
+      readServerJson(obj, true /* voice */);
+    }
+    else if(path == QLatin1String("prefiles"))
+      readPrefileJson(obj);
+    return true;
+  });
 
-  // ATIS - only VATSIM =================================
-  // readAtisJson(obj); TODO Currently ignored since missing connection to controllers
+  // Open and check for errors =============
+  if(!reader.read(bytes) && !reader.isStopped())
+    qWarning() << Q_FUNC_INFO << "Error reading data" << reader.getErrorString() << "at offset" << reader.getErrorOffset();
 
-  return true;
+  return !outdated;
 }
 
 // Currently ignored
@@ -339,371 +401,357 @@ void WhazzupTextParser::readAtisJson(const QJsonObject& obj)
   }
 }
 
-void WhazzupTextParser::readServersJson(const QJsonArray& serversArr, bool voice)
+void WhazzupTextParser::readServerJson(const QJsonObject& serverObj, bool voice)
 {
-  for(const QJsonValue& serverVal : serversArr)
-  {
-    QJsonObject serverObj = serverVal.toObject();
-
-    // Build a column list like the one fetched from the whazzup.txt
-    // ident:hostname_or_IP:location:name:clients_connection_allowed:
-    // CZECH:212.67.73.150:Czech Republic:CenterEast Europe Server - sponsored by VACC-CZ:1:
-    QStringList columns;
-
-    if(format == VATSIM_JSON3)
-    {
-      // "servers": [
-      // {
-      // "ident": "CANADA",
-      // "hostname_or_ip": "165.22.239.218",
-      // "location": "Toronto, Canada",
-      // "name": "ANONYM",
-      // "clients_connection_allowed": 1
-      // },
-      columns.append(serverObj.value("ident").toVariant().toString());
-      columns.append(serverObj.value("hostname_or_ip").toVariant().toString());
-      columns.append(serverObj.value("location").toVariant().toString());
-      columns.append(serverObj.value("name").toVariant().toString());
-      columns.append(QString()); // client_connections_allowed
-      columns.append(QString()); // allowed_connections
-      columns.append(QString()); // voice_type
-    }
-    else if(format == IVAO_JSON2)
-    {
-      // "servers": [
-      // {
-      // "id": "SHARD1",
-      // "hostname": "shard1.net.ivao.aero",
-      // "ip": "146.59.200.142",
-      // "description": "IVAO SHARD1 - Network Server",
-      // "countryId": "FR",
-      // "currentConnections": 131,
-      // "maximumConnections": 750
-      // },
-      columns.append(serverObj.value("id").toVariant().toString());
-      columns.append(serverObj.value("hostname").toVariant().toString());
-      columns.append(serverObj.value("countryId").toVariant().toString());
-      columns.append(serverObj.value("description").toVariant().toString());
-      columns.append(QString()); // client_connections_allowed
-      columns.append(QString()); // allowed_connections
-      columns.append(voice ? "T" : QString()); // voice_type
-    }
+  // Build a column list like the one fetched from the whazzup.txt
+  // ident:hostname_or_IP:location:name:clients_connection_allowed:
+  // CZECH:212.67.73.150:Czech Republic:CenterEast Europe Server - sponsored by VACC-CZ:1:
+  QStringList columns;
 
-    parseServersSection(columns);
+  if(format == VATSIM_JSON3)
+  {
+    // "servers": [
+    // {
+    // "ident": "CANADA",
+    // "hostname_or_ip": "165.22.239.218",
+    // "location": "Toronto, Canada",
+    // "name": "ANONYM",
+    // "clients_connection_allowed": 1
+    // },
+    columns.append(serverObj.value("ident").toVariant().toString());
+    columns.append(serverObj.value("hostname_or_ip").toVariant().toString());
+    columns.append(serverObj.value("location").toVariant().toString());
+    columns.append(serverObj.value("name").toVariant().toString());
+    columns.append(QString()); // client_connections_allowed
+    columns.append(QString()); // allowed_connections
+    columns.append(QString()); // voice_type
+  }
+  else if(format == IVAO_JSON2)
+  {
+    // "servers": [
+    // {
+    // "id": "SHARD1",
+    // "hostname": "shard1.net.ivao.aero",
+    // "ip": "146.59.200.142",
+    // "description": "IVAO SHARD1 - Network Server",
+    // "countryId": "FR",
+    // "currentConnections": 131,
+    // "maximumConnections": 750
+    // },
+    columns.append(serverObj.value("id").toVariant().toString());
+    columns.append(serverObj.value("hostname").toVariant().toString());
+    columns.append(serverObj.value("countryId").toVariant().toString());
+    columns.append(serverObj.value("description").toVariant().toString());
+    columns.append(QString()); // client_connections_allowed
+    columns.append(QString()); // allowed_connections
+    columns.append(voice ? "T" : QString()); // voice_type
   }
+
+  parseServersSection(columns);
 }
 
-void WhazzupTextParser::readControllersJson(const QJsonArray& controllersArr, bool observer)
+void WhazzupTextParser::readControllerJson(const QJsonObject& atcObj, bool observer)
 {
-  // Open and check for errors =========================================
   // Prefill with empty strings for pilots/clients delimited format
-  for(const QJsonValue& atcVal : controllersArr)
+  QStringList columns(defaultColumns);
+  QString callsign = atcObj.value("callsign").toVariant().toString();
+  columns[c::CALLSIGN] = callsign;
+  columns[c::CLIENTTYPE] = "ATC";
+
+  if(format == VATSIM_JSON3)
   {
-    QStringList columns(defaultColumns);
-    QJsonObject atcObj = atcVal.toObject();
-    QString callsign = atcObj.value("callsign").toVariant().toString();
-    columns[c::CALLSIGN] = callsign;
-    columns[c::CLIENTTYPE] = "ATC";
+    // "controllers": [
+    // {
+    // "cid": 813331,
+    // "name": "ANONYM",
+    // "callsign": "EFIN_D_CTR",
+    // "frequency": "121.300",
+    // "facility": 6,
+    // "rating": 5,
+    // "server": "UK-1",
+    // "visual_range": 300,
+    // "text_atis": [
+    // "HELSINKI CONTROL"
+    // ],
+    // "last_updated": "2021-03-14T16:07:00.8535377Z",
+    // "logon_time": "2021-03-14T08:10:47.665987Z"
+    // },
+    columns[c::CID] = atcObj.value("cid").toVariant().toString();
+    columns[c::REALNAME] = atcObj.value("name").toVariant().toString();
 
-    if(format == VATSIM_JSON3)
+    columns[c::FACILITYTYPE] = atcObj.value("facility").toVariant().toString();
+    columns[c::SERVER] = atcObj.value("server").toVariant().toString();
+    columns[c::VISUALRANGE] = atcObj.value("visual_range").toVariant().toString();
+
+    // Read ATIS message array into linefeed separated string =========
+    QStringList atisStrList;
+    const QJsonArray atisArray = atcObj.value("text_atis").toArray();
+    for(const QJsonValue& value : atisArray)
+      atisStrList.append(value.toString());
+    atisStrList.removeAll(QString());
+    columns[v::ATIS_MESSAGE] = atisStrList.join('\n');
+    columns[v::TIME_LAST_ATIS_RECEIVED] = atcObj.value("last_updated").toVariant().toString();
+    columns[v::TIME_LOGON] = atcObj.value("logon_time").toVariant().toString();
+
+    // Get all transceivers with callsign =========
+    if(transceiverMap.contains(callsign))
     {
-      // "controllers": [
-      // {
-      // "cid": 813331,
-      // "name": "ANONYM",
-      // "callsign": "EFIN_D_CTR",
-      // "frequency": "121.300",
-      // "facility": 6,
-      // "rating": 5,
-      // "server": "UK-1",
-      // "visual_range": 300,
-      // "text_atis": [
-      // "HELSINKI CONTROL"
-      // ],
-      // "last_updated": "2021-03-14T16:07:00.8535377Z",
-      // "logon_time": "2021-03-14T08:10:47.665987Z"
-      // },
-      columns[c::CID] = atcObj.value("cid").toVariant().toString();
-      columns[c::REALNAME] = atcObj.value("name").toVariant().toString();
-
-      columns[c::FACILITYTYPE] = atcObj.value("facility").toVariant().toString();
-      columns[c::SERVER] = atcObj.value("server").toVariant().toString();
-      columns[c::VISUALRANGE] = atcObj.value("visual_range").toVariant().toString();
-
-      // Read ATIS message array into linefeed separated string =========
-      QStringList atisStrList;
-      const QJsonArray atisArray = atcObj.value("text_atis").toArray();
-      for(const QJsonValue& value : atisArray)
-        atisStrList.append(value.toString());
-      atisStrList.removeAll(QString());
-      columns[v::ATIS_MESSAGE] = atisStrList.join('\n');
-      columns[v::TIME_LAST_ATIS_RECEIVED] = atcObj.value("last_updated").toVariant().toString();
-      columns[v::TIME_LOGON] = atcObj.value("logon_time").toVariant().toString();
-
-      // Get all transceivers with callsign =========
-      if(transceiverMap.contains(callsign))
+      Rect rect;
+      QSet<int> frequencies; // kHz
+      frequencies.insert(atools::roundToInt(atcObj.value("frequency").toVariant().toDouble() * 1000.f));
+
+      // Read all frequencies and build a bounding rectangle from positions
+      const QList<Transceiver> transceivers = transceiverMap.values(callsign);
+      for(const Transceiver& transceiver : transceivers)
       {
-        Rect rect;
-        QSet<int> frequencies; // kHz
-        frequencies.insert(atools::roundToInt(atcObj.value("frequency").toVariant().toDouble() * 1000.f));
+        frequencies.unite(transceiver.frequency);
+        rect.extend(transceiver.pos);
+      }
+      frequencies.remove(0);
 
-        // Read all frequencies and build a bounding rectangle from positions
-        const QList<Transceiver> transceivers = transceiverMap.values(callsign);
-        for(const Transceiver& transceiver : transceivers)
-        {
-          frequencies.unite(transceiver.frequency);
-          rect.extend(transceiver.pos);
-        }
-        frequencies.remove(0);
+      // Convert frequencies to mHz
+      QVector<float> frequenciesMhz;
+      for(int f : frequencies)
+        frequenciesMhz.append(f / 1000.f);
 
-        // Convert frequencies to mHz
-        QVector<float> frequenciesMhz;
-        for(int f : frequencies)
-          frequenciesMhz.append(f / 1000.f);
+      columns[c::FREQUENCY] = atools::floatVectorToStrList(frequenciesMhz).join('&');
 
-        columns[c::FREQUENCY] = atools::floatVectorToStrList(frequenciesMhz).join('&');
+      // Use center of bounding rectangle as position
+      columns[c::LONGITUDE] = QString::number(rect.getCenter().getLonX());
+      columns[c::LATITUDE] = QString::number(rect.getCenter().getLatY());
+    }
+    else
+    {
+      // Center has no geometry in the transceiever list ====================
+      columns[c::FREQUENCY] = QString::number(atcObj.value("frequency").toVariant().toDouble());
 
-        // Use center of bounding rectangle as position
-        columns[c::LONGITUDE] = QString::number(rect.getCenter().getLonX());
-        columns[c::LATITUDE] = QString::number(rect.getCenter().getLatY());
-      }
-      else
+      if(atcObj.contains("latitude") && atcObj.contains("longitude"))
       {
-        // Center has no geometry in the transceiever list ====================
-        columns[c::FREQUENCY] = QString::number(atcObj.value("frequency").toVariant().toDouble());
-
-        if(atcObj.contains("latitude") && atcObj.contains("longitude"))
-        {
-          columns[c::LATITUDE] = atcObj.value("latitude").toVariant().toString();
-          columns[c::LONGITUDE] = atcObj.value("longitude").toVariant().toString();
-        }
+        columns[c::LATITUDE] = atcObj.value("latitude").toVariant().toString();
+        columns[c::LONGITUDE] = atcObj.value("longitude").toVariant().toString();
       }
     }
-    else if(format == IVAO_JSON2)
-    {
-      // "atcs": [
-      // {
-      // "time": 22493,
-      // "id": 40650557,
-      // "userId": 646135,
-      // "callsign": "YBBN_CTR",
-      // "serverId": "SHARD2",
-      // "softwareTypeId": "aurora",
-      // "softwareVersion": "1.2.16b",
-      // "createdAt": "2021-06-20T14:54:25.000Z",
-      // "atcSession": {
-      // "frequency": 124.8,
-      // "position": "CTR"
-      // },
-      // "atis": {
-      // "lines": [
-      // "eu17.ts.ivao.aero/YBBN_CTR",
-      // "Brisbane Centre",
-      // "TRL FL110 / TA 10000ft",
-      // ""
-      // ],
-      // "revision": "O",
-      // "timestamp": "2021-06-20T20:50:03.891Z"
-      // },
-      // "lastTrack": {
-      // "distance": 1000,
-      // "latitude": -27.38417,
-      // "longitude": 153.1175,
-      // "time": 22474,
-      // "timestamp": "2021-06-20T21:08:59.133Z"
-      // }
-      // },
-      columns[c::CID] = atcObj.value("id").toVariant().toString();
-      columns[c::REALNAME] = atcObj.value("name").toVariant().toString();
-      columns[c::SERVER] = atcObj.value("serverId").toVariant().toString();
-      columns[i::SOFTWARE_NAME] = atcObj.value("softwareTypeId").toVariant().toString();
-      columns[i::SOFTWARE_VERSION] = atcObj.value("softwareVersion").toVariant().toString();
-
-      // Read ATIS message array =========
-      QStringList atisList;
-      const QJsonArray atisArr = atcObj.value("atis").toObject().value("lines").toArray();
-      for(const QJsonValue& value : atisArr)
-        atisList.append(value.toString());
-      atisList.removeAll(QString());
-      columns[i::ATIS] = atisList.join('\n');
-      columns[i::ATIS_TIME] = atcObj.value("atis").toObject().value("timestamp").toString();
-
-      columns[i::CONNECTION_TIME] = atcObj.value("createdAt").toVariant().toString();
-
-      QJsonObject atcSession = atcObj.value("atcSession").toObject();
-      columns[c::FREQUENCY] = atcSession.value("frequency").toVariant().toString();
-
-      if(observer)
-        columns[c::FACILITYTYPE] = QString::number(fac::OBSERVER);
-      else
-        columns[c::FACILITYTYPE] = QString::number(textToFacilityType(atcSession.value("position").toVariant().toString()));
+  }
+  else if(format == IVAO_JSON2)
+  {
+    // "atcs": [
+    // {
+    // "time": 22493,
+    // "id": 40650557,
+    // "userId": 646135,
+    // "callsign": "YBBN_CTR",
+    // "serverId": "SHARD2",
+    // "softwareTypeId": "aurora",
+    // "softwareVersion": "1.2.16b",
+    // "createdAt": "2021-06-20T14:54:25.000Z",
+    // "atcSession": {
+    // "frequency": 124.8,
+    // "position": "CTR"
+    // },
+    // "atis": {
+    // "lines": [
+    // "eu17.ts.ivao.aero/YBBN_CTR",
+    // "Brisbane Centre",
+    // "TRL FL110 / TA 10000ft",
+    // ""
+    // ],
+    // "revision": "O",
+    // "timestamp": "2021-06-20T20:50:03.891Z"
+    // },
+    // "lastTrack": {
+    // "distance": 1000,
+    // "latitude": -27.38417,
+    // "longitude": 153.1175,
+    // "time": 22474,
+    // "timestamp": "2021-06-20T21:08:59.133Z"
+    // }
+    // },
+    columns[c::CID] = atcObj.value("id").toVariant().toString();
+    columns[c::REALNAME] = atcObj.value("name").toVariant().toString();
+    columns[c::SERVER] = atcObj.value("serverId").toVariant().toString();
+    columns[i::SOFTWARE_NAME] = atcObj.value("softwareTypeId").toVariant().toString();
+    columns[i::SOFTWARE_VERSION] = atcObj.value("softwareVersion").toVariant().toString();
 
-      QJsonObject lastTrack = atcObj.value("lastTrack").toObject();
-      columns[c::VISUALRANGE] = lastTrack.value("distance").toVariant().toString();
-      columns[c::LONGITUDE] = lastTrack.value("longitude").toVariant().toString();
-      columns[c::LATITUDE] = lastTrack.value("latitude").toVariant().toString();
-    }
+    // Read ATIS message array =========
+    QStringList atisList;
+    const QJsonArray atisArr = atcObj.value("atis").toObject().value("lines").toArray();
+    for(const QJsonValue& value : atisArr)
+      atisList.append(value.toString());
+    atisList.removeAll(QString());
+    columns[i::ATIS] = atisList.join('\n');
+    columns[i::ATIS_TIME] = atcObj.value("atis").toObject().value("timestamp").toString();
+
+    columns[i::CONNECTION_TIME] = atcObj.value("createdAt").toVariant().toString();
 
-    // Read line with method for delimited format
-    parseSection(columns, true /* isAtc */, false /* isPrefile */, true /* isJson */);
-  } // for(QJsonValue atcVal : controllersArr)
+    QJsonObject atcSession = atcObj.value("atcSession").toObject();
+    columns[c::FREQUENCY] = atcSession.value("frequency").toVariant().toString();
+
+    if(observer)
+      columns[c::FACILITYTYPE] = QString::number(fac::OBSERVER);
+    else
+      columns[c::FACILITYTYPE] = QString::number(textToFacilityType(atcSession.value("position").toVariant().toString()));
+
+    QJsonObject lastTrack = atcObj.value("lastTrack").toObject();
+    columns[c::VISUALRANGE] = lastTrack.value("distance").toVariant().toString();
+    columns[c::LONGITUDE] = lastTrack.value("longitude").toVariant().toString();
+    columns[c::LATITUDE] = lastTrack.value("latitude").toVariant().toString();
+  }
+
+  // Read line with method for delimited format
+  parseSection(columns, true /* isAtc */, false /* isPrefile */, true /* isJson */);
 }
 
-void WhazzupTextParser::readPilotsJson(const QJsonArray& pilotsArr)
+void WhazzupTextParser::readPilotJson(const QJsonObject& pilotObj)
 {
   // Prefill with empty strings for pilots/clients delimited format
-  for(const QJsonValue& pilotVal : pilotsArr)
+  QStringList columns(defaultColumns);
+
+  columns[c::CALLSIGN] = pilotObj.value("callsign").toString();
+  columns[c::CLIENTTYPE] = "PILOT";
+
+  if(format == VATSIM_JSON3)
   {
-    QStringList columns(defaultColumns);
-    QJsonObject pilotObj = pilotVal.toObject();
+    // "pilots": [
+    // {
+    // "cid": 1474512,
+    // "name": "ANONYM",
+    // "callsign": "ABS9481",
+    // "server": "GERMANY-2",
+    // "pilot_rating": 0,
+    // "latitude": 33.68793,
+    // "longitude": -7.51442,
+    // "altitude": 2501,
+    // "groundspeed": 193,
+    // "transponder": "2000",
+    // "heading": 163,
+    // "qnh_i_hg": 30.13,
+    // "qnh_mb": 1020,
+    //
+    // "flight_plan": {
+    // "flight_rules": "I",
+    // "aircraft": "B77L/H-SDE1E2E3FGHIJ2J3J4J5M1RWXY/LB1D1",
+    // "aircraft_faa": "H/B77L/L",
+    // "aircraft_short": "B77L",
+    // "departure": "OMDB",
+    // "arrival": "SBGR",
+    // "alternate": "SBGL",
+    // "cruise_tas": "492",
+    // "altitude": "32000",
+    // "deptime": "2300",
+    // "enroute_time": "1442",
+    // "fuel_time": "1638",
+    // "remarks": "PBN/A1B1C1D1L1O1S2 DOF/210313 ... /V/",
+    // "route": "NABIX3G NABIX P699 OXARI M430 KIA ... UL327 SIDUR UZ10 ILMIG DCT TBE TBE2B"
+    // },
+    //
+    // "logon_time": "2021-03-13T22:38:09.826199Z",
+    // "last_updated": "2021-03-14T16:07:00.8565953Z"
+    // },
+    columns[c::CID] = pilotObj.value("cid").toVariant().toString();
+    columns[c::REALNAME] = pilotObj.value("name").toString();
+    columns[c::LATITUDE] = pilotObj.value("latitude").toVariant().toString();
+    columns[c::LONGITUDE] = pilotObj.value("longitude").toVariant().toString();
+    columns[c::ALTITUDE] = pilotObj.value("altitude").toVariant().toString();
+    columns[c::GROUNDSPEED] = pilotObj.value("groundspeed").toVariant().toString();
+    columns[c::SERVER] = pilotObj.value("server").toVariant().toString();
+    columns[c::TRANSPONDER] = pilotObj.value("transponder").toVariant().toString();
 
-    columns[c::CALLSIGN] = pilotObj.value("callsign").toString();
-    columns[c::CLIENTTYPE] = "PILOT";
+    // Insert values from flight plan object
+    assignFlightplan(columns, pilotObj.value("flight_plan").toObject());
 
-    if(format == VATSIM_JSON3)
-    {
-      // "pilots": [
-      // {
-      // "cid": 1474512,
-      // "name": "ANONYM",
-      // "callsign": "ABS9481",
-      // "server": "GERMANY-2",
-      // "pilot_rating": 0,
-      // "latitude": 33.68793,
-      // "longitude": -7.51442,
-      // "altitude": 2501,
-      // "groundspeed": 193,
-      // "transponder": "2000",
-      // "heading": 163,
-      // "qnh_i_hg": 30.13,
-      // "qnh_mb": 1020,
-      //
-      // "flight_plan": {
-      // "flight_rules": "I",
-      // "aircraft": "B77L/H-SDE1E2E3FGHIJ2J3J4J5M1RWXY/LB1D1",
-      // "aircraft_faa": "H/B77L/L",
-      // "aircraft_short": "B77L",
-      // "departure": "OMDB",
-      // "arrival": "SBGR",
-      // "alternate": "SBGL",
-      // "cruise_tas": "492",
-      // "altitude": "32000",
-      // "deptime": "2300",
-      // "enroute_time": "1442",
-      // "fuel_time": "1638",
-      // "remarks": "PBN/A1B1C1D1L1O1S2 DOF/210313 ... /V/",
-      // "route": "NABIX3G NABIX P699 OXARI M430 KIA ... UL327 SIDUR UZ10 ILMIG DCT TBE TBE2B"
-      // },
-      //
-      // "logon_time": "2021-03-13T22:38:09.826199Z",
-      // "last_updated": "2021-03-14T16:07:00.8565953Z"
-      // },
-      columns[c::CID] = pilotObj.value("cid").toVariant().toString();
-      columns[c::REALNAME] = pilotObj.value("name").toString();
-      columns[c::LATITUDE] = pilotObj.value("latitude").toVariant().toString();
-      columns[c::LONGITUDE] = pilotObj.value("longitude").toVariant().toString();
-      columns[c::ALTITUDE] = pilotObj.value("altitude").toVariant().toString();
-      columns[c::GROUNDSPEED] = pilotObj.value("groundspeed").toVariant().toString();
-      columns[c::SERVER] = pilotObj.value("server").toVariant().toString();
-      columns[c::TRANSPONDER] = pilotObj.value("transponder").toVariant().toString();
-
-      // Insert values from flight plan object
-      assignFlightplan(columns, pilotObj.value("flight_plan").toObject());
-
-      // IGNORED planned_depairport_lat
-      // IGNORED planned_depairport_lon
-      // IGNORED planned_destairport_lat
-      // IGNORED planned_destairport_lon
-      // atis_message
-      // time_last_atis_received
-      columns[v::TIME_LOGON] = pilotObj.value("logon_time").toVariant().toString();
-      columns[v::HEADING] = pilotObj.value("heading").toVariant().toString();
-    }
-    else if(format == IVAO_JSON2)
-    {
-      // "pilots": [
-      // {
-      // "time": 483139,
-      // "id": 40494681,
-      // "userId": 396659,
-      // "callsign": "ROT071",
-      // "serverId": "SHARD3",
-      // "softwareTypeId": "altitude",
-      // "softwareVersion": "1.10.4b",
-      // "createdAt": "2021-06-15T06:57:00.000Z",
-      // "flightPlan": {
-      // "revision": 0,
-      // "aircraftId": "SR22",
-      // "aircraftNumber": 1,
-      // "departureId": "TNCS",
-      // "arrivalId": "TFFJ",
-      // "alternativeId": "TNCE",
-      // "alternative2Id": null,
-      // "route": "WEST MODOR SOUTH",
-      // "remarks": "DOF/210615 RMK/WORLDTOUR",
-      // "speed": "K0120",
-      // "level": "VFR",
-      // "flightRules": "V",
-      // "flightType": "G",
-      // "eet": 900,
-      // "endurance": 360,
-      // "departureTime": 25500,
-      // "actualDepartureTime": 25500,
-      // "peopleOnBoard": 1,
-      // "createdAt": "2021-06-15T06:57:00.000Z",
-      // "updatedAt": "2021-06-15T06:57:00.000Z",
-      // "aircraftEquipments": "S",
-      // "aircraftTransponderTypes": "S"
-      // },
-      // "pilotSession": {
-      // "simulatorId": "MS2020"
-      // },
-      // "lastTrack": {
-      // "altitude": 128,
-      // "altitudeDifference": 0,
-      // "arrivalDistance": 26.597875703772427,
-      // "departureDistance": 0.046724870958816,
-      // "groundSpeed": 0,
-      // "heading": 205,
-      // "latitude": 17.644595,
-      // "longitude": -63.220497,
-      // "onGround": true,
-      // "state": "Boarding",
-      // "time": 140,
-      // "timestamp": "2021-06-15T06:59:20.538Z",
-      // "transponder": 2000,
-      // "transponderMode": "S"
-      // }
-
-      columns[c::CID] = pilotObj.value("userId").toVariant().toString();
-
-      QJsonObject lastTrack = pilotObj.value("lastTrack").toObject();
-      columns[c::LATITUDE] = lastTrack.value("latitude").toVariant().toString();
-      columns[c::LONGITUDE] = lastTrack.value("longitude").toVariant().toString();
-      columns[c::ALTITUDE] = lastTrack.value("altitude").toVariant().toString();
-      columns[c::GROUNDSPEED] = lastTrack.value("groundSpeed").toVariant().toString();
-
-      columns[c::SERVER] = pilotObj.value("serverId").toVariant().toString();
-      columns[c::TRANSPONDER] = lastTrack.value("transponder").toVariant().toString();
-
-      // Insert values from flight plan object
-      assignFlightplan(columns, pilotObj.value("flightPlan").toObject());
-
-      columns[i::CONNECTION_TIME] = pilotObj.value("createdAt").toVariant().toString();
-      columns[i::SOFTWARE_NAME] = pilotObj.value("softwareTypeId").toVariant().toString();
-      columns[i::SOFTWARE_VERSION] = pilotObj.value("softwareVersion").toVariant().toString();
-      columns[i::HEADING] = lastTrack.value("heading").toVariant().toString();
-      columns[i::ON_GROUND] = lastTrack.value("onGround").toVariant().toBool() ? "1" : "0";
-      columns[i::STATE] = lastTrack.value("state").toVariant().toString();
-      columns[i::SIMULATOR] = pilotObj.value("pilotSession").toObject().value("simulatorId").toVariant().toString();
-    }
+    // IGNORED planned_depairport_lat
+    // IGNORED planned_depairport_lon
+    // IGNORED planned_destairport_lat
+    // IGNORED planned_destairport_lon
+    // atis_message
+    // time_last_atis_received
+    columns[v::TIME_LOGON] = pilotObj.value("logon_time").toVariant().toString();
+    columns[v::HEADING] = pilotObj.value("heading").toVariant().toString();
+  }
+  else if(format == IVAO_JSON2)
+  {
+    // "pilots": [
+    // {
+    // "time": 483139,
+    // "id": 40494681,
+    // "userId": 396659,
+    // "callsign": "ROT071",
+    // "serverId": "SHARD3",
+    // "softwareTypeId": "altitude",
+    // "softwareVersion": "1.10.4b",
+    // "createdAt": "2021-06-15T06:57:00.000Z",
+    // "flightPlan": {
+    // "revision": 0,
+    // "aircraftId": "SR22",
+    // "aircraftNumber": 1,
+    // "departureId": "TNCS",
+    // "arrivalId": "TFFJ",
+    // "alternativeId": "TNCE",
+    // "alternative2Id": null,
+    // "route": "WEST MODOR SOUTH",
+    // "remarks": "DOF/210615 RMK/WORLDTOUR",
+    // "speed": "K0120",
+    // "level": "VFR",
+    // "flightRules": "V",
+    // "flightType": "G",
+    // "eet": 900,
+    // "endurance": 360,
+    // "departureTime": 25500,
+    // "actualDepartureTime": 25500,
+    // "peopleOnBoard": 1,
+    // "createdAt": "2021-06-15T06:57:00.000Z",
+    // "updatedAt": "2021-06-15T06:57:00.000Z",
+    // "aircraftEquipments": "S",
+    // "aircraftTransponderTypes": "S"
+    // },
+    // "pilotSession": {
+    // "simulatorId": "MS2020"
+    // },
+    // "lastTrack": {
+    // "altitude": 128,
+    // "altitudeDifference": 0,
+    // "arrivalDistance": 26.597875703772427,
+    // "departureDistance": 0.046724870958816,
+    // "groundSpeed": 0,
+    // "heading": 205,
+    // "latitude": 17.644595,
+    // "longitude": -63.220497,
+    // "onGround": true,
+    // "state": "Boarding",
+    // "time": 140,
+    // "timestamp": "2021-06-15T06:59:20.538Z",
+    // "transponder": 2000,
+    // "transponderMode": "S"
+    // }
+
+    columns[c::CID] = pilotObj.value("userId").toVariant().toString();
+
+    QJsonObject lastTrack = pilotObj.value("lastTrack").toObject();
+    columns[c::LATITUDE] = lastTrack.value("latitude").toVariant().toString();
+    columns[c::LONGITUDE] = lastTrack.value("longitude").toVariant().toString();
+    columns[c::ALTITUDE] = lastTrack.value("altitude").toVariant().toString();
+    columns[c::GROUNDSPEED] = lastTrack.value("groundSpeed").toVariant().toString();
+
+    columns[c::SERVER] = pilotObj.value("serverId").toVariant().toString();
+    columns[c::TRANSPONDER] = lastTrack.value("transponder").toVariant().toString();
 
-    // Read line with method for delimited format
-    parseSection(columns, false /* isAtc */, false /* isPrefile */, true /* isJson */);
+    // Insert values from flight plan object
+    assignFlightplan(columns, pilotObj.value("flightPlan").toObject());
+
+    columns[i::CONNECTION_TIME] = pilotObj.value("createdAt").toVariant().toString();
+    columns[i::SOFTWARE_NAME] = pilotObj.value("softwareTypeId").toVariant().toString();
+    columns[i::SOFTWARE_VERSION] = pilotObj.value("softwareVersion").toVariant().toString();
+    columns[i::HEADING] = lastTrack.value("heading").toVariant().toString();
+    columns[i::ON_GROUND] = lastTrack.value("onGround").toVariant().toBool() ? "1" : "0";
+    columns[i::STATE] = lastTrack.value("state").toVariant().toString();
+    columns[i::SIMULATOR] = pilotObj.value("pilotSession").toObject().value("simulatorId").toVariant().toString();
   }
+
+  // Read line with method for delimited format
+  parseSection(columns, false /* isAtc */, false /* isPrefile */, true /* isJson */);
 }
 
-void WhazzupTextParser::readPrefilesJson(const QJsonObject& obj)
+void WhazzupTextParser::readPrefileJson(const QJsonObject& pilotObj)
 {
   // "prefiles": [
   // {
@@ -728,24 +776,18 @@ void WhazzupTextParser::readPrefilesJson(const QJsonObject& obj)
   // },
   // "last_updated": "2021-03-14T13:19:23.9417633Z"
   // },
-  // Prefill with empty strings for pilots/clients delimited format
-  const QJsonArray prefilesArr = obj.value("prefiles").toArray();
-  for(const QJsonValue& prefileVal : prefilesArr)
-  {
-    QStringList columns(defaultColumns);
-    QJsonObject pilotObj = prefileVal.toObject();
+  QStringList columns(defaultColumns);
 
-    columns[c::CALLSIGN] = pilotObj.value("callsign").toVariant().toString();
-    columns[c::CID] = pilotObj.value("cid").toVariant().toString();
-    columns[c::REALNAME] = pilotObj.value("name").toVariant().toString();
-    columns[c::CLIENTTYPE] = "PILOT";
+  columns[c::CALLSIGN] = pilotObj.value("callsign").toVariant().toString();
+  columns[c::CID] = pilotObj.value("cid").toVariant().toString();
+  columns[c::REALNAME] = pilotObj.value("name").toVariant().toString();
+  columns[c::CLIENTTYPE] = "PILOT";
 
-    // Insert values from flight plan object
-    assignFlightplan(columns, pilotObj.value("flight_plan").toObject());
+  // Insert values from flight plan object
+  assignFlightplan(columns, pilotObj.value("flight_plan").toObject());
 
-    // Prefill with empty strings for pilots/clients delimited format
-    parseSection(columns, false /*ATC*/, true /* prefile */, true /* isJson */);
-  }
+  // Prefill with empty strings for pilots/clients delimited format
+  parseSection(columns, false /*ATC*/, true /* prefile */, true /* isJson */);
 }
 
 void WhazzupTextParser::assignFlightplan(QStringList& columns, const QJsonObject& flightplanObj)
@@ -883,6 +925,8 @@ void WhazzupTextParser::assignFlightplan(QStringList& columns, const QJsonObject
 
 bool WhazzupTextParser::readInternalDelimited(QTextStream& stream, const QDateTime& lastUpdate)
 {
+  ATOOLS_TRACE_SPAN("online", "WhazzupTextParser::readDelimited");
+
   QSet<QString> sections;
 
   // Read through file to get all sections
@@ -897,8 +941,8 @@ bool WhazzupTextParser::readInternalDelimited(QTextStream& stream, const QDateTi
   // Delete tables for available sections and keep others
   if(sections.contains("CLIENTS"))
   {
-    db->exec("delete from client");
-    db->exec("delete from atc");
+    clearStoreOrTable("client");
+    clearStoreOrTable("atc");
   }
 
   if(sections.contains("SERVERS"))
@@ -1276,34 +1320,49 @@ void WhazzupTextParser::parseSection(const QStringList& line, bool isAtc, bool p
     if(hasCoordinates)
     {
       // Geometry for centers =============================================================================
-      LineString lineString;
-      if(geometryCallback)
-      {
-        // Try to get from callback (i.e. user airspace database)
-        const LineString *ptr = geometryCallback(callsign, facilityType);
-        if(ptr != nullptr)
-          // Copy cache object
-          lineString = *ptr;
-      }
+      // Circle depends on position and radius - round position to about ten meters
+      QString geometryKey = callsign % '|' % QString::number(facilityType) % '|' % QString::number(circleRadius) %
+                            '|' % QString::number(position.getLonX(), 'f', 4) % '|' %
+                            QString::number(position.getLatY(), 'f', 4);
 
-      if(lineString.isEmpty())
+      auto it = atcGeometryCache.find(geometryKey);
+      if(it == atcGeometryCache.end())
       {
-        // Nothing found or no callback - create a circle shape
-        // Create a circular polygon with 10 degree segments
+        LineString lineString;
+        if(geometryCallback)
+        {
+          // Try to get from callback (i.e. user airspace database)
+          const LineString *ptr = geometryCallback(callsign, facilityType);
+          if(ptr != nullptr)
+            // Copy cache object
+            lineString = *ptr;
+        }
 
-        // at least 1/10 nm radius
-        lineString = LineString(position, atools::geo::nmToMeter(std::min(1000.f, std::max(1.f, static_cast<float>(circleRadius)))), 36);
+        if(lineString.isEmpty())
+        {
+          // Nothing found or no callback - create a circle shape
+          // Create a circular polygon with 10 degree segments
+
+          // at least 1/10 nm radius
+          lineString = LineString::circle(position, atools::geo::nmToMeter(std::min(1000.f, std::max(1.f, static_cast<float>(circleRadius)))));
+        }
+
+        // Store geometry in packed format which is faster to read - online database is not persistent
+        AtcGeometry geometry;
+        geometry.bounding = lineString.boundingRect();
+        geometry.geometry = atools::fs::common::BinaryGeometry(lineString).writeToByteArray(
+          atools::fs::common::BinaryGeometry::FORMAT_PACKED);
+        it = atcGeometryCache.insert(geometryKey, geometry);
       }
+      it->generation = atcGeometryGeneration;
 
       // Add bounding rectangle
-      Rect bounding = lineString.boundingRect();
+      const Rect& bounding = it->bounding;
       insertQuery->bindValue(":max_lonx", bounding.getEast());
       insertQuery->bindValue(":max_laty", bounding.getNorth());
       insertQuery->bindValue(":min_lonx", bounding.getWest());
       insertQuery->bindValue(":min_laty", bounding.getSouth());
-
-      // Store geometry in same format as boundaries
-      insertQuery->bindValue(":geometry", atools::fs::common::BinaryGeometry(lineString).writeToByteArray());
+      insertQuery->bindValue(":geometry", it->geometry);
     }
     else
     {
@@ -1327,7 +1386,36 @@ void WhazzupTextParser::parseSection(const QStringList& line, bool isAtc, bool p
   // qDebug() << hashKey << id;
   insertQuery->bindValue(isAtc ? ":atc_id" : ":client_id", id);
 
-  insertQuery->exec();
+  OnlineClientStore *store = isAtc ? atcStore : clientStore;
+  if(store != nullptr)
+    store->addFromQuery(*insertQuery, id);
+
+  if(store == nullptr || writeDatabase)
+    insertQuery->exec();
+}
+
+void WhazzupTextParser::clearStoreOrTable(const QString& table)
+{
+  if(table == QLatin1String("atc"))
+  {
+    // Remove cached geometry for centers which were not online in the last read and start new generation
+    for(auto it = atcGeometryCache.begin(); it != atcGeometryCache.end();)
+    {
+      if(it->generation != atcGeometryGeneration)
+        it = atcGeometryCache.erase(it);
+      else
+        ++it;
+    }
+    atcGeometryGeneration++;
+  }
+
+  OnlineClientStore *store = table == QLatin1String("client") ? clientStore :
+                             (table == QLatin1String("atc") ? atcStore : nullptr);
+  if(store != nullptr)
+    store->clear();
+
+  if(store == nullptr || writeDatabase)
+    db->exec("delete from " + table);
 }
 
 int WhazzupTextParser::semiPermanentId(QHash<QString, int>& idMap, int& curId, const QString& key)
@@ -1439,9 +1527,61 @@ void WhazzupTextParser::resetForNewOptions()
   // Clear the id maps but do not reset the current ids to avoid overlaps
   atcIdMap.clear();
   clientIdMap.clear();
+  clearGeometryCache();
   reset();
 }
 
+void WhazzupTextParser::writeState(QDataStream& out) const
+{
+  out << static_cast<qint32>(format) << static_cast<qint32>(version) << static_cast<qint32>(reload) << updateTimestamp;
+
+  out << static_cast<quint32>(transceiverMap.size());
+  for(auto it = transceiverMap.constBegin(); it != transceiverMap.constEnd(); ++it)
+    out << it.key() << it.value().frequency << it.value().pos;
+
+  out << clientIdMap << atcIdMap << static_cast<qint32>(curClientId) << static_cast<qint32>(curAtcId);
+}
+
+void WhazzupTextParser::readState(QDataStream& in)
+{
+  qint32 fmt, ver, rel, clientId, atcId;
+  in >> fmt >> ver >> rel >> updateTimestamp;
+  format = static_cast<Format>(fmt);
+  version = ver;
+  reload = rel;
+
+  transceiverMap.clear();
+  quint32 numTransceivers;
+  in >> numTransceivers;
+  for(quint32 i = 0; i < numTransceivers && in.status() == QDataStream::Ok; i++)
+  {
+    QString callsign;
+    Transceiver transceiver;
+    in >> callsign >> transceiver.frequency >> transceiver.pos;
+    transceiverMap.insert(callsign, transceiver);
+  }
+
+  in >> clientIdMap >> atcIdMap >> clientId >> atcId;
+  curClientId = clientId;
+  curAtcId = atcId;
+
+  // Geometry might belong to other data
+  clearGeometryCache();
+}
+
+void WhazzupTextParser::setAtcSize(const QHash<fac::FacilityType, int>& value)
+{
+  if(atcRadius != value)
+    clearGeometryCache();
+  atcRadius = value;
+}
+
+void WhazzupTextParser::setGeometryCallback(GeoCallbackType func)
+{
+  clearGeometryCache();
+  geometryCallback = func;
+}
+
 void WhazzupTextParser::reset()
 {
   curSection.clear();
@@ -19,11 +19,13 @@
 #define ATOOLS_FS_WHAZZUPTEXTPARSER_H
 
 #include "geo/pos.h"
+#include "geo/rect.h"
 #include "fs/online/onlinetypes.h"
 
 #include <QDateTime>
 #include <QString>
 
+class QDataStream;
 class QTextStream;
 
 namespace atools {
@@ -35,6 +37,8 @@ class SqlQuery;
 namespace fs {
 namespace online {
 
+class OnlineClientStore;
+
 /*
  * Reads a "whazzup.txt" file and stores all found data in the database.
  * Schema has to be created before.
@@ -57,8 +61,13 @@ public:
    * Returns true if the file was read and is more recent than lastUpdate. */
   bool read(QString file, atools::fs::online::Format streamFormat, const QDateTime& lastUpdate);
 
+  /* As above but reads JSON formats directly from the downloaded UTF-8 bytes without building a document.
+   * Text formats are converted from UTF-8. */
+  bool read(const QByteArray& bytes, atools::fs::online::Format streamFormat, const QDateTime& lastUpdate);
+
   /* Read VATSIM transceivers-data.json and stores map in this object. Call before calling "read". */
   void readTransceivers(const QString& file);
+  void readTransceivers(const QByteArray& bytes);
 
   /* Create all queries */
   void initQueries();
@@ -81,20 +90,42 @@ public:
   void reset();
   void resetForNewOptions();
 
-  /* Set default circle radii for certain ATC types where visual range is unusable */
-  void setAtcSize(const QHash<atools::fs::online::fac::FacilityType, int>& value)
+  /* Set default circle radii for certain ATC types where visual range is unusable. Clears geometry cache if changed. */
+  void setAtcSize(const QHash<atools::fs::online::fac::FacilityType, int>& value);
+
+  /* Set a callback that tries to fetch geometry from the user airspace database.
+   * Default circle will be used if this returns an empty byte array.
+   * Results are cached. Call again or clearGeometryCache() if the airspace database changes. */
+  void setGeometryCallback(GeoCallbackType func);
+
+  /* Write or read timestamps, transceivers and semi-permanent id maps. Used for snapshots. */
+  void writeState(QDataStream& out) const;
+  void readState(QDataStream& in);
+
+  /* Remove all cached ATC geometry */
+  void clearGeometryCache()
   {
-    atcRadius = value;
+    atcGeometryCache.clear();
   }
 
-  /* Set a callback that tries to fetch geometry from the user airspace database.
-   * Default circle will be used if this returns an empty byte array. */
-  void setGeometryCallback(GeoCallbackType func)
+  /* Set stores which receive all client and ATC rows. Null disables a store.
+   * Tables are still written if writeDatabase is true. Stores are not owned. */
+  void setStores(atools::fs::online::OnlineClientStore *clients, atools::fs::online::OnlineClientStore *atcs)
   {
-    geometryCallback = func;
+    clientStore = clients;
+    atcStore = atcs;
+  }
+
+  /* Write client and ATC rows into the database too if stores are set. Default is true. */
+  void setWriteDatabase(bool value)
+  {
+    writeDatabase = value;
   }
 
 private:
+  /* Clear store for table "client" or "atc" if set and delete all rows in table if needed */
+  void clearStoreOrTable(const QString& table);
+
   /* Read time from general section */
   QDateTime parseGeneralSection(const QStringList& line);
 
@@ -117,14 +148,16 @@ private:
   QString convertName(QString name, bool utf8);
   int semiPermanentId(QHash<QString, int>& idMap, int& curId, const QString& key);
 
-  /* Read VATSIM JSON format and create a column list based on the whazzup.txt lists.
-   * This is read by the delimited methods. */
-  bool readInternalJson(const QString& file, const QDateTime& lastUpdate);
+  /* Stream VATSIM or IVAO JSON format and create a column list based on the whazzup.txt lists for each element.
+   * This is read by the delimited methods. Returns false if outdated. */
+  bool readInternalJson(const QByteArray& bytes, const QDateTime& lastUpdate);
   bool readInternalDelimited(QTextStream& stream, const QDateTime& lastUpdate);
-  void readPilotsJson(const QJsonArray& pilotsArr);
-  void readControllersJson(const QJsonArray& controllersArr, bool observer);
-  void readServersJson(const QJsonArray& serversArr, bool voice);
-  void readPrefilesJson(const QJsonObject& obj);
+
+  /* Read a single element of the respective arrays */
+  void readPilotJson(const QJsonObject& pilotObj);
+  void readControllerJson(const QJsonObject& atcObj, bool observer);
+  void readServerJson(const QJsonObject& serverObj, bool voice);
+  void readPrefileJson(const QJsonObject& pilotObj);
 
   void readAtisJson(const QJsonObject& obj);
 
@@ -146,6 +179,10 @@ private:
   atools::sql::SqlDatabase *db;
   atools::sql::SqlQuery *clientInsertQuery = nullptr, *atcInsertQuery = nullptr, *serverInsertQuery = nullptr;
 
+  /* Not owned */
+  atools::fs::online::OnlineClientStore *clientStore = nullptr, *atcStore = nullptr;
+  bool writeDatabase = true;
+
   // Assign row ids manually
   int curClientId = 1, curAtcId = 1;
 
@@ -167,6 +204,18 @@ private:
   bool error = false;
 
   GeoCallbackType geometryCallback;
+
+  /* Precomputed geometry blob and bounding rectangle for ATC centers */
+  struct AtcGeometry
+  {
+    QByteArray geometry;
+    atools::geo::Rect bounding;
+    quint32 generation = 0; // Read generation this was last used in
+  };
+
+  /* Key is callsign, facility type, radius and position. Entries not used in the last read are removed. */
+  QHash<QString, AtcGeometry> atcGeometryCache;
+  quint32 atcGeometryGeneration = 0;
   QStringList ivaoDefaultColumns, defaultColumns;
 };
 
@@ -58,6 +58,7 @@ void AircraftPerfHandler::start()
 
   aircraftClimb = aircraftDescent = aircraftFuelFlow = aircraftGround = aircraftFlying = false;
   aircraftCruise = 0;
+  statusTextsKey = -1;
 
   perf->setNull();
 
@@ -139,9 +140,9 @@ void AircraftPerfHandler::simDataChanged(const sc::SimConnectData& simulatorData
           flightSegment = aircraftFuelFlow ? DEPARTURE_TAXI : DEPARTURE_PARKING;
         else if(aircraftCruise >= 0)
           flightSegment = CRUISE;
-        else if(isClimbing() && aircraftCruise == -1)
+        else if(aircraftClimb && aircraftCruise == -1)
           flightSegment = CLIMB;
-        else if(isDescending() && aircraftCruise == -1)
+        else if(aircraftDescent && aircraftCruise == -1)
           flightSegment = DESCENT;
         break;
 
@@ -194,7 +195,7 @@ void AircraftPerfHandler::simDataChanged(const sc::SimConnectData& simulatorData
   }
 
   // Remember segment dependent sample time to allow averaging =============
-  qint64 aircraftZuluTime = simulatorData.getUserAircraftConst().getZuluTime().toMSecsSinceEpoch();
+  qint64 aircraftZuluTime = curSimAircraft->getZuluTime().toMSecsSinceEpoch();
   if(flightSegment != currentFlightSegment)
   {
     if(flightSegment == CLIMB)
@@ -231,6 +232,12 @@ bool AircraftPerfHandler::isFinished() const
 
 QStringList AircraftPerfHandler::getAircraftStatusTexts()
 {
+  // Texts depend only on the status flags - rebuild only if these changed
+  int key = (aircraftGround ? 1 : 0) | (aircraftFuelFlow ? 2 : 0) | (aircraftFlying ? 4 : 0) |
+            (aircraftClimb ? 8 : 0) | (aircraftDescent ? 16 : 0) | ((aircraftCruise + 1) << 5);
+  if(key == statusTextsKey)
+    return statusTexts;
+
   QStringList retval;
   if(aircraftGround)
   {
@@ -267,6 +274,9 @@ QStringList AircraftPerfHandler::getAircraftStatusTexts()
       first.prepend(firstChar.toUpper());
     }
   }
+
+  statusTexts = retval;
+  statusTextsKey = key;
   return retval;
 }
 
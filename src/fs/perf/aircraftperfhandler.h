@@ -159,6 +159,10 @@ private:
   /* -1 if below, 0 if at and 1 if above flight plan cruise altitude. Use below as default. */
   int aircraftCruise = -1;
 
+  /* Cached result of getAircraftStatusTexts() and bit mask of the flags it was built from */
+  QStringList statusTexts;
+  int statusTextsKey = -1;
+
   /* Last time of sample to allow calculation of averages */
   qint64 lastSampleTimeMs = 0L;
   qint64 lastCruiseSampleTimeMs = 0L, lastClimbSampleTimeMs = 0L, lastDescentSampleTimeMs = 0L;
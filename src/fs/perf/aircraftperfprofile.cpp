@@ -0,0 +1,128 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/perf/aircraftperfprofile.h"
+
+#include "fs/perf/aircraftperf.h"
+#include "geo/calculations.h"
+#include "geo/linestring.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace fs {
+namespace perf {
+
+namespace ageo = atools::geo;
+
+/* Altitude difference in feet below which a leg is considered level */
+static const float LEVEL_LEG_ALTITUDE_FT = 10.f;
+
+void AircraftPerfProfile::compile(const AircraftPerf& perf)
+{
+  climb.trueAirspeed = perf.getClimbSpeed();
+  climb.fuelFlowLbs = perf.getClimbFuelFlowLbs();
+  climb.fuelFlowGal = perf.getClimbFuelFlowGal();
+
+  cruise.trueAirspeed = perf.getCruiseSpeed();
+  cruise.fuelFlowLbs = perf.getCruiseFuelFlowLbs();
+  cruise.fuelFlowGal = perf.getCruiseFuelFlowGal();
+
+  descent.trueAirspeed = perf.getDescentSpeed();
+  descent.fuelFlowLbs = perf.getDescentFuelFlowLbs();
+  descent.fuelFlowGal = perf.getDescentFuelFlowGal();
+
+  valid = perf.isSpeedValid();
+}
+
+FlightSegment AircraftPerfProfile::segmentForLeg(float altitude1Ft, float altitude2Ft)
+{
+  if(altitude2Ft > altitude1Ft + LEVEL_LEG_ALTITUDE_FT)
+    return CLIMB;
+  else if(altitude2Ft < altitude1Ft - LEVEL_LEG_ALTITUDE_FT)
+    return DESCENT;
+  else
+    return CRUISE;
+}
+
+float AircraftPerfProfile::getGroundSpeed(FlightSegment segment, float courseDeg, float windDirDeg,
+                                          float windSpeedKts) const
+{
+  float tas = phase(segment).trueAirspeed;
+
+  if(windSpeedKts < 1.f)
+    return std::max(tas, 1.f);
+
+  float groundSpeed = ageo::windCorrectedGroundSpeed(windSpeedKts, windDirDeg, courseDeg, tas);
+  if(!(groundSpeed < ageo::INVALID_FLOAT / 2.f))
+    // Wind stronger than airspeed - use head wind component only
+    groundSpeed = tas - ageo::headWindForCourse(windSpeedKts, windDirDeg, courseDeg);
+
+  return std::max(groundSpeed, 1.f);
+}
+
+void AircraftPerfProfile::calculateRoute(PerfRouteResult& result, const ageo::LineString& route,
+                                         const QVector<grib::Wind>& legWinds) const
+{
+  result.clear();
+
+  if(route.size() < 2)
+    return;
+
+  result.legs.reserve(route.size() - 1);
+  bool hasWind = legWinds.size() == route.size() - 1;
+  if(!hasWind && !legWinds.isEmpty())
+    qWarning() << Q_FUNC_INFO << "Wrong number of winds" << legWinds.size() << "for legs" << route.size() - 1;
+
+  for(int i = 0; i < route.size() - 1; i++)
+  {
+    const ageo::Pos& pos1 = route.at(i);
+    const ageo::Pos& pos2 = route.at(i + 1);
+
+    PerfLegResult leg;
+    leg.segment = segmentForLeg(pos1.getAltitude(), pos2.getAltitude());
+    leg.distanceNm = ageo::meterToNm(pos1.distanceMeterTo(pos2));
+    leg.courseDeg = pos1.angleDegTo(pos2);
+
+    if(hasWind && legWinds.at(i).isValid())
+    {
+      leg.windDirDeg = legWinds.at(i).dir;
+      leg.windSpeedKts = legWinds.at(i).speed;
+    }
+    else
+      leg.windDirDeg = leg.windSpeedKts = 0.f;
+
+    leg.headWindKts = leg.windSpeedKts < 1.f ? 0.f :
+                      ageo::headWindForCourse(leg.windSpeedKts, leg.windDirDeg, leg.courseDeg);
+    leg.groundSpeedKts = getGroundSpeed(leg.segment, leg.courseDeg, leg.windDirDeg, leg.windSpeedKts);
+
+    const Phase& legPhase = phase(leg.segment);
+    leg.timeHours = leg.distanceNm / leg.groundSpeedKts;
+    leg.fuelLbs = leg.timeHours * legPhase.fuelFlowLbs;
+    leg.fuelGal = leg.timeHours * legPhase.fuelFlowGal;
+
+    result.distanceNm += leg.distanceNm;
+    result.timeHours += leg.timeHours;
+    result.fuelLbs += leg.fuelLbs;
+    result.fuelGal += leg.fuelGal;
+    result.legs.append(leg);
+  }
+}
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
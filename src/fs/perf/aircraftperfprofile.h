@@ -0,0 +1,142 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_AIRCRAFTPERFPROFILE_H
+#define ATOOLS_AIRCRAFTPERFPROFILE_H
+
+#include "fs/perf/aircraftperfconstants.h"
+#include "grib/windtypes.h"
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace fs {
+namespace perf {
+
+class AircraftPerf;
+
+/* Estimation result for one leg of a route */
+struct PerfLegResult
+{
+  /* CLIMB, CRUISE or DESCENT */
+  atools::fs::perf::FlightSegment segment;
+
+  /* Wind direction in degrees true and speed in knots. Head wind is negative for tail wind. */
+  float distanceNm, courseDeg, windDirDeg, windSpeedKts, headWindKts, groundSpeedKts;
+  float timeHours, fuelLbs, fuelGal;
+};
+
+/* Estimation result for a whole route */
+struct PerfRouteResult
+{
+  QVector<atools::fs::perf::PerfLegResult> legs;
+  float distanceNm = 0.f, timeHours = 0.f, fuelLbs = 0.f, fuelGal = 0.f;
+
+  void clear()
+  {
+    legs.clear();
+    distanceNm = timeHours = fuelLbs = fuelGal = 0.f;
+  }
+
+};
+
+/*
+ * Compiled form of an aircraft performance for fast repeated route estimation.
+ *
+ * All values needed for the climb, cruise and descent phases are converted once into knots and fuel flow
+ * in lbs and gallons per hour. Estimation for a whole route is done in one call using the altitude at each
+ * route point to detect the phase of each leg. Leg winds can be fetched in one call with
+ * atools::grib::WindQuery::getWindAverageForLegs().
+ *
+ * Compile again after changing the performance. Copies are cheap and can be used in other threads.
+ */
+class AircraftPerfProfile
+{
+public:
+  AircraftPerfProfile()
+  {
+  }
+
+  explicit AircraftPerfProfile(const atools::fs::perf::AircraftPerf& perf)
+  {
+    compile(perf);
+  }
+
+  /* Precompute all values from performance */
+  void compile(const atools::fs::perf::AircraftPerf& perf);
+
+  /* True if speeds are valid for all phases */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  /* Speed in knots TAS for CLIMB, CRUISE or DESCENT. Other segments return cruise values. */
+  float getTrueAirspeed(atools::fs::perf::FlightSegment segment) const
+  {
+    return phase(segment).trueAirspeed;
+  }
+
+  float getFuelFlowLbs(atools::fs::perf::FlightSegment segment) const
+  {
+    return phase(segment).fuelFlowLbs;
+  }
+
+  float getFuelFlowGal(atools::fs::perf::FlightSegment segment) const
+  {
+    return phase(segment).fuelFlowGal;
+  }
+
+  /* Ground speed in knots for the phase, course in degrees true and wind. Never below one knot. */
+  float getGroundSpeed(atools::fs::perf::FlightSegment segment, float courseDeg, float windDirDeg,
+                       float windSpeedKts) const;
+
+  /* Segment for a leg from the altitudes in feet at start and end */
+  static atools::fs::perf::FlightSegment segmentForLeg(float altitude1Ft, float altitude2Ft);
+
+  /*
+   * Estimate time and fuel for all legs of route. Positions of route have to contain the altitude in feet.
+   * legWinds has to contain one wind for each leg or can be empty to calculate without wind.
+   */
+  void calculateRoute(atools::fs::perf::PerfRouteResult& result, const atools::geo::LineString& route,
+                      const QVector<atools::grib::Wind>& legWinds = QVector<atools::grib::Wind>()) const;
+
+private:
+  struct Phase
+  {
+    float trueAirspeed = 0.f, fuelFlowLbs = 0.f, fuelFlowGal = 0.f;
+  };
+
+  const Phase& phase(atools::fs::perf::FlightSegment segment) const
+  {
+    return segment == CLIMB ? climb : (segment == DESCENT ? descent : cruise);
+  }
+
+  Phase climb, cruise, descent;
+  bool valid = false;
+};
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
+
+Q_DECLARE_TYPEINFO(atools::fs::perf::PerfLegResult, Q_PRIMITIVE_TYPE);
+
+#endif // ATOOLS_AIRCRAFTPERFPROFILE_H
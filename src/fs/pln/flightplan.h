@@ -22,6 +22,7 @@
 #include "fs/pln/flightplanconstants.h"
 
 #include <QCoreApplication>
+#include <QVector>
 
 class QXmlStreamReader;
 
@@ -40,9 +41,10 @@ class FlightplanIO;
 
 /*
  * A class to load, modify and save FSX (and all other compatible simulators) flight plans.
+ * Entries are stored contiguously.
  */
 class Flightplan :
-  private QList<atools::fs::pln::FlightplanEntry>
+  private QVector<atools::fs::pln::FlightplanEntry>
 {
   Q_DECLARE_TR_FUNCTIONS(Flightplan)
 
@@ -109,33 +111,33 @@ public:
 
   /* Pull required methods into public space */
   /* Keep clear() hidden */
-  using QList::append;
-  using QList::at;
-  using QList::begin;
-  using QList::constBegin;
-  using QList::constEnd;
-  using QList::constFirst;
-  using QList::constLast;
-  using QList::end;
-  using QList::erase;
-  using QList::first;
-  using QList::insert;
-  using QList::isEmpty;
-  using QList::last;
-  using QList::move;
-  using QList::operator[];
-  using QList::prepend;
-  using QList::rbegin;
-  using QList::removeAt;
-  using QList::rend;
-  using QList::replace;
-  using QList::size;
+  using QVector::append;
+  using QVector::at;
+  using QVector::begin;
+  using QVector::constBegin;
+  using QVector::constEnd;
+  using QVector::constFirst;
+  using QVector::constLast;
+  using QVector::end;
+  using QVector::erase;
+  using QVector::first;
+  using QVector::insert;
+  using QVector::isEmpty;
+  using QVector::last;
+  using QVector::move;
+  using QVector::operator[];
+  using QVector::prepend;
+  using QVector::rbegin;
+  using QVector::removeAt;
+  using QVector::rend;
+  using QVector::replace;
+  using QVector::size;
 
   void clearAll();
 
   void clearEntries()
   {
-    QList::clear();
+    QVector::clear();
   }
 
   void clearProperties()
@@ -17,10 +17,45 @@
 
 #include "fs/pln/flightplanentry.h"
 
+#include <QMutex>
+#include <QSet>
+
 namespace atools {
 namespace fs {
 namespace pln {
 
+/* Longer strings like user defined idents are not pooled */
+static const int MAX_INTERN_LENGTH = 10;
+
+const QString FlightplanEntry::EMPTY_STRING;
+
+QString FlightplanEntry::intern(const QString& str)
+{
+  if(str.isEmpty() || str.size() > MAX_INTERN_LENGTH)
+    return str;
+
+  static QMutex mutex;
+  static QSet<QString> pool;
+
+  QMutexLocker locker(&mutex);
+  QSet<QString>::const_iterator it = pool.constFind(str);
+  if(it == pool.constEnd())
+    it = pool.insert(str);
+  return *it;
+}
+
+void FlightplanEntry::setProcedureValue(QString ProcedureData::*field, const QString& value)
+{
+  if(procedure.constData() != nullptr)
+    // Detaches if shared
+    procedure.data()->*field = value;
+  else if(!value.isEmpty())
+  {
+    procedure = new ProcedureData;
+    procedure.data()->*field = value;
+  }
+}
+
 QString FlightplanEntry::getWaypointTypeAsStringShort() const
 {
   const QString type = waypointTypeToFsxString(waypointType);
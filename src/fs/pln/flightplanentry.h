@@ -19,6 +19,7 @@
 #define ATOOLS_FLIGHTPLANENTRY_H
 
 #include <QCoreApplication>
+#include <QSharedDataPointer>
 
 #include "fs/pln/flightplanconstants.h"
 #include "geo/pos.h"
@@ -29,6 +30,10 @@ namespace pln {
 
 /*
  * Waypoint or airport as part of the flight plan. Also covers departure and destination airports.
+ *
+ * Ident, region and airway are taken from a global string pool so that equal values share memory across
+ * plans and their copies. The MSFS procedure fields are stored in a separate implicitly shared structure which is
+ * only allocated if any of them is set.
  */
 class FlightplanEntry
 {
@@ -79,7 +84,7 @@ public:
 
   void setAirway(const QString& value)
   {
-    airway = value;
+    airway = intern(value);
   }
 
   /*
@@ -92,7 +97,7 @@ public:
 
   void setRegion(const QString& value)
   {
-    region = value;
+    region = intern(value);
   }
 
   /*
@@ -105,7 +110,7 @@ public:
 
   void setIdent(const QString& value)
   {
-    ident = value;
+    ident = intern(value);
   }
 
   /*
@@ -239,66 +244,66 @@ public:
   /* All below are for MSFS and are set before export =========================== */
   const QString& getSid() const
   {
-    return sid;
+    return procedure ? procedure->sid : EMPTY_STRING;
   }
 
   void setSid(const QString& value)
   {
-    sid = value;
+    setProcedureValue(&ProcedureData::sid, value);
   }
 
   const QString& getStar() const
   {
-    return star;
+    return procedure ? procedure->star : EMPTY_STRING;
   }
 
   void setStar(const QString& value)
   {
-    star = value;
+    setProcedureValue(&ProcedureData::star, value);
   }
 
   const QString& getApproach() const
   {
-    return approach;
+    return procedure ? procedure->approach : EMPTY_STRING;
   }
 
   const QString& getApproachSuffix() const
   {
-    return approachSuffix;
+    return procedure ? procedure->approachSuffix : EMPTY_STRING;
   }
 
   void setApproach(const QString& approachType, const QString& suffix, const QString& transition)
   {
-    approach = approachType;
-    approachSuffix = suffix;
-    approachTransition = transition;
+    setProcedureValue(&ProcedureData::approach, approachType);
+    setProcedureValue(&ProcedureData::approachSuffix, suffix);
+    setProcedureValue(&ProcedureData::approachTransition, transition);
   }
 
   const QString& getRunwayNumber() const
   {
-    return runway;
+    return procedure ? procedure->runway : EMPTY_STRING;
   }
 
   void setRunway(const QString& runwayNumber, const QString& runwayDesignator)
   {
-    runway = runwayNumber;
-    designator = runwayDesignator;
+    setProcedureValue(&ProcedureData::runway, runwayNumber);
+    setProcedureValue(&ProcedureData::designator, runwayDesignator);
   }
 
   /* One letter code like L, R, C and more */
   const QString& getRunwayDesignator() const
   {
-    return designator;
+    return procedure ? procedure->designator : EMPTY_STRING;
   }
 
   const QString& getAirport() const
   {
-    return airport;
+    return procedure ? procedure->airport : EMPTY_STRING;
   }
 
   void setAirport(const QString& value)
   {
-    airport = value;
+    setProcedureValue(&ProcedureData::airport, value);
   }
 
   /* true if entry is valid and not default constructed */
@@ -309,27 +314,27 @@ public:
 
   const QString& getStarTransition() const
   {
-    return starTransition;
+    return procedure ? procedure->starTransition : EMPTY_STRING;
   }
 
   void setStarTransition(const QString& value)
   {
-    starTransition = value;
+    setProcedureValue(&ProcedureData::starTransition, value);
   }
 
   const QString& getSidTransition() const
   {
-    return sidTransition;
+    return procedure ? procedure->sidTransition : EMPTY_STRING;
   }
 
   void setSidTransition(const QString& value)
   {
-    sidTransition = value;
+    setProcedureValue(&ProcedureData::sidTransition, value);
   }
 
   const QString& getApproachTransition() const
   {
-    return approachTransition;
+    return procedure ? procedure->approachTransition : EMPTY_STRING;
   }
 
 private:
@@ -342,15 +347,31 @@ private:
   static atools::fs::pln::entry::WaypointType stringToWaypointTypeLnm(const QString& str);
   static QString flagsAsString(atools::fs::pln::entry::Flags flags);
 
-  atools::fs::pln::entry::WaypointType waypointType = entry::UNKNOWN;
-  QString airway, region, ident, name, comment;
-
   /* MSFS fields - these are set as found in the ATCWaypoint element.
    * Needed here since the waypoints have to be removed after loading. */
-  QString sid, sidTransition, star, starTransition,
-          approach, approachSuffix, approachTransition, runway, designator, airport;
+  struct ProcedureData :
+    public QSharedData
+  {
+    QString sid, sidTransition, star, starTransition,
+            approach, approachSuffix, approachTransition, runway, designator, airport;
+  };
+
+  /* Set field in procedure data. Does not allocate the structure for empty values. */
+  void setProcedureValue(QString ProcedureData::*field, const QString& value);
+
+  /* Get a string sharing data with an equal one from the global pool. Thread safe. */
+  static QString intern(const QString& str);
+
+  /* Returned by getters for procedure data if not allocated */
+  static const QString EMPTY_STRING;
+
+  QString airway, region, ident, name, comment;
+
+  /* Null if no procedure fields are set */
+  QSharedDataPointer<ProcedureData> procedure;
 
   atools::geo::Pos position;
+  atools::fs::pln::entry::WaypointType waypointType = entry::UNKNOWN;
   atools::fs::pln::entry::Flags flags = atools::fs::pln::entry::NONE;
   float magvar = 0.f;
   int frequency = 0;
@@ -26,8 +26,11 @@
 #include "fs/pln/flightplan.h"
 #include "util/xmlstream.h"
 #include "zip/gzip.h"
+#include "zip/gzipdevice.h"
+#include "util/parallel.h"
 
 #include <QBitArray>
+#include <QBuffer>
 #include <QDataStream>
 #include <QDateTime>
 #include <QTimeZone>
@@ -37,6 +40,7 @@
 #include <QRegularExpression>
 #include <QXmlStreamReader>
 #include <QDir>
+#include <QDirIterator>
 
 using atools::geo::Pos;
 using atools::geo::PosD;
@@ -115,6 +119,12 @@ struct FprPlan
 
 } // namespace fpr
 
+struct FlightplanIO::ExportCache
+{
+  /* Coordinate strings for user waypoints and plan positions */
+  QHash<atools::geo::Pos, QString> degMinFormats;
+};
+
 FlightplanIO::FlightplanIO()
 {
   errorMsg = tr("Cannot open file %1. Reason: %2");
@@ -127,72 +137,228 @@ FlightplanIO::~FlightplanIO()
 
 atools::fs::pln::FileFormat FlightplanIO::load(atools::fs::pln::Flightplan& plan, const QString& file)
 {
-  FileFormat format = detectFormat(file);
+  return loadFile(plan, file, true /* exceptionIfUnknown */);
+}
+
+atools::fs::pln::FileFormat FlightplanIO::load(atools::fs::pln::Flightplan& plan, const QByteArray& bytes,
+                                               const QString& filename)
+{
+  return loadBytes(plan, bytes, filename, true /* exceptionIfUnknown */);
+}
+
+atools::fs::pln::FileFormat FlightplanIO::loadFile(atools::fs::pln::Flightplan& plan, const QString& file,
+                                                   bool exceptionIfUnknown)
+{
+  QFile planFile(file);
+  if(!planFile.open(QIODevice::ReadOnly))
+    throw Exception(errorMsg.arg(file).arg(planFile.errorString()));
+
+  // Read file only once for detection and loading - map into memory if possible
+  QByteArray bytes;
+  qint64 size = planFile.size();
+  uchar *mem = size > 0 && size < std::numeric_limits<int>::max() ? planFile.map(0, size) : nullptr;
+  if(mem != nullptr)
+    // Not copied - valid as long as file is open
+    bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(mem), static_cast<int>(size));
+  else
+    bytes = planFile.readAll();
+
+  return loadBytes(plan, bytes, file, exceptionIfUnknown);
+}
+
+atools::fs::pln::FileFormat FlightplanIO::loadBytes(atools::fs::pln::Flightplan& plan, const QByteArray& bytes,
+                                                    const QString& filename, bool exceptionIfUnknown)
+{
+  FileFormat format = detectFormat(bytes, filename);
+
+  if(format == NONE)
+  {
+    if(exceptionIfUnknown)
+      throw Exception(tr("Cannot open flight plan file \"%1\". No supported flight plan format detected. "
+                         "Supported formats are LNMPLN, PLN (FSX XML, MSFS XML, FS9 INI and FSC), X-Plane FMS, FLP and "
+                         "FlightGear FGFP.").arg(filename));
+    return NONE;
+  }
 
   plan.clearAll();
 
+  // Buffer shares the data without copying - loaders open and close it
+  QBuffer buffer;
+  buffer.setData(bytes);
+
   switch(format)
   {
     case atools::fs::pln::NONE:
-      throw Exception(tr("Cannot open flight plan file \"%1\". No supported flight plan format detected. "
-                         "Supported formats are LNMPLN, PLN (FSX XML, MSFS XML, FS9 INI and FSC), X-Plane FMS, FLP and "
-                         "FlightGear FGFP.").arg(file));
+      break;
 
     case atools::fs::pln::LNM_PLN:
-      loadLnm(plan, file);
+      loadLnm(plan, buffer, filename);
       plan.setLnmFormat(true); // Indicate that plan was loaded using new native format
       break;
 
     case atools::fs::pln::MSFS_PLN:
     case atools::fs::pln::FSX_PLN:
-      loadPln(plan, file);
+      loadPln(plan, buffer, filename);
       plan.setLnmFormat(false); // Indicate that a "foreign" format was user to load which cannot be saved directly
       break;
 
     case atools::fs::pln::FS9_PLN:
-      loadFs9(plan, file);
+      loadFs9(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FMS11:
     case atools::fs::pln::FMS3:
-      loadFms(plan, file);
+      loadFms(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FLP:
-      loadFlp(plan, file);
+      loadFlp(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FSC_PLN:
-      loadFsc(plan, file);
+      loadFsc(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FLIGHTGEAR:
-      loadFlightGear(plan, file);
+      loadFlightGear(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::GARMIN_FPL:
-      loadGarminFpl(plan, file);
+      loadGarminFpl(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::GARMIN_GFP:
-      loadGarminGfp(plan, file);
+      loadGarminGfp(plan, buffer, filename);
       plan.setLnmFormat(false);
       break;
   }
   return format;
 }
 
+void FlightplanIO::loadFiles(QVector<FlightplanLoadResult>& results, const QStringList& filenames, int numThreads)
+{
+  loadFilesInternal(results, filenames, numThreads, false /* skipUnknown */);
+}
+
+void FlightplanIO::loadDirectory(QVector<FlightplanLoadResult>& results, const QString& directory, bool recursive,
+                                 int numThreads)
+{
+  QStringList filenames;
+  QDirIterator it(directory, QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                  recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+  while(it.hasNext())
+    filenames.append(it.next());
+
+  // Keep order independent of file system
+  filenames.sort();
+
+  loadFilesInternal(results, filenames, numThreads, true /* skipUnknown */);
+}
+
+void FlightplanIO::loadFilesInternal(QVector<FlightplanLoadResult>& results, const QStringList& filenames,
+                                     int numThreads, bool skipUnknown)
+{
+  QVector<FlightplanLoadResult> loaded(filenames.size());
+
+  // Get pointer once to avoid detaching in threads
+  FlightplanLoadResult *loadedData = loaded.data();
+
+  atools::util::parallelFor(filenames.size(), numThreads, [loadedData, &filenames, skipUnknown](int begin, int end, int) -> void {
+    // Not thread safe - one instance per chunk
+    FlightplanIO flightplanIO;
+
+    for(int i = begin; i < end; i++)
+    {
+      FlightplanLoadResult& result = loadedData[i];
+      result.filename = filenames.at(i);
+
+      try
+      {
+        result.format = flightplanIO.loadFile(result.plan, result.filename, !skipUnknown /* exceptionIfUnknown */);
+      }
+      catch(std::exception& e)
+      {
+        result.errorMessage = QString::fromUtf8(e.what());
+      }
+    }
+  }, 1 /* minChunkSize */);
+
+  results.reserve(results.size() + loaded.size());
+  for(const FlightplanLoadResult& result : qAsConst(loaded))
+  {
+    // Drop files which are not flight plans
+    if(!skipUnknown || result.format != NONE || !result.errorMessage.isEmpty())
+      results.append(result);
+  }
+}
+
+bool FlightplanIO::saveAll(const Flightplan& plan, QVector<FlightplanSaveJob>& jobs, int numThreads)
+{
+  // Calculate strings used by several formats only once
+  ExportCache cache;
+  for(const FlightplanEntry& entry : plan)
+  {
+    if(entry.getWaypointType() == atools::fs::pln::entry::USER || entry.getWaypointType() == atools::fs::pln::entry::UNKNOWN)
+    {
+      if(!cache.degMinFormats.contains(entry.getPosition()))
+        cache.degMinFormats.insert(entry.getPosition(), atools::fs::util::toDegMinFormat(entry.getPosition()));
+    }
+  }
+
+  // Get pointer once to avoid detaching in threads
+  FlightplanSaveJob *jobData = jobs.data();
+  const ExportCache *cachePtr = &cache;
+
+  atools::util::parallelFor(jobs.size(), numThreads, [jobData, cachePtr, &plan](int begin, int end, int) -> void {
+    // Not thread safe - one instance per chunk sharing the read only cache
+    FlightplanIO flightplanIO;
+    flightplanIO.exportCache = cachePtr;
+
+    for(int i = begin; i < end; i++)
+    {
+      FlightplanSaveJob& job = jobData[i];
+      try
+      {
+        job.func(flightplanIO, plan);
+      }
+      catch(std::exception& e)
+      {
+        job.errorMessage = QString::fromUtf8(e.what());
+      }
+    }
+  }, 1 /* minChunkSize */);
+
+  bool ok = true;
+  for(const FlightplanSaveJob& job : qAsConst(jobs))
+  {
+    if(!job.errorMessage.isEmpty())
+    {
+      qWarning() << Q_FUNC_INFO << "Error saving" << job.filename << job.errorMessage;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
 FileFormat FlightplanIO::detectFormat(const QString& file)
 {
-  // Get first 30 non empty lines - always returns a list of 30
-  QStringList lines = probeFile(file, 30 /* numLinesRead */);
+  // Get first 30 non empty lines
+  return detectFormatLines(probeFile(file, 30 /* numLinesRead */), file);
+}
 
+FileFormat FlightplanIO::detectFormat(const QByteArray& bytes, const QString& filename)
+{
+  return detectFormatLines(atools::probeBytes(bytes, 30 /* numLinesRead */), filename);
+}
+
+FileFormat FlightplanIO::detectFormatLines(const QStringList& lines, const QString& file)
+{
   if(lines.isEmpty())
     throw Exception(tr("Cannot open empty flight plan file \"%1\".").arg(file));
 
@@ -268,7 +434,7 @@ FileFormat FlightplanIO::detectFormat(const QString& file)
     return NONE;
 }
 
-void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, QIODevice& flpFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
@@ -288,8 +454,6 @@ void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, const QString& fil
   // DctWpt15=DEGAB
   // DctWpt15Coordinates=48.705685,13.931495
 
-  QFile flpFile(filename);
-
   if(flpFile.open(QIODevice::ReadOnly))
   {
     FlightplanEntry entry, departure, destination;
@@ -417,7 +581,7 @@ void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, const QString& fil
     throw Exception(errorMsg.arg(filename).arg(flpFile.errorString()));
 }
 
-void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, QIODevice& flpFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
@@ -452,7 +616,6 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
   // 3 RDU V155 0.000000 35.872520 -78.783340
   // 1 KRDU ADES 435.000000 35.877640 -78.787476
 
-  QFile flpFile(filename);
   int version = 0;
   bool v11Format = false;
   int minListSize = 5;
@@ -468,7 +631,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
     bool ok = false;
     version = stream.readLine().section(" ", 0, 0).toInt(&ok); // 3 version
     if(!ok)
-      throw Exception(tr("Invalid FMS file. Cannot read version number: %1").arg(flpFile.fileName()));
+      throw Exception(tr("Invalid FMS file. Cannot read version number: %1").arg(filename));
 
     if(version == 3)
     {
@@ -483,7 +646,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
       fieldOffset = 1;
     }
     else
-      throw Exception(tr("Invalid FMS file. Invalid version %2: %1").arg(flpFile.fileName()).arg(version));
+      throw Exception(tr("Invalid FMS file. Invalid version %2: %1").arg(filename).arg(version));
 
     float maxAlt = std::numeric_limits<float>::min();
     QString destinationRwy;
@@ -575,7 +738,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
           bool lonOk, latOk;
           Pos position(list.at(4 + fieldOffset).toFloat(&lonOk), list.at(3 + fieldOffset).toFloat(&latOk), altitude);
           if(!position.isValidRange() || !lonOk || !latOk)
-            throw Exception(tr("Invalid FMS file. Invalid coordinate in %1").arg(flpFile.fileName()));
+            throw Exception(tr("Invalid FMS file. Invalid coordinate in %1").arg(filename));
 
           FlightplanEntry entry;
           const QString& ident = list.at(1);
@@ -587,7 +750,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
           bool typeOk;
           int type = list.at(0).toInt(&typeOk);
           if(!typeOk)
-            throw Exception(tr("Invalid FMS file. Cannot read waypoint type in %1").arg(flpFile.fileName()));
+            throw Exception(tr("Invalid FMS file. Cannot read waypoint type in %1").arg(filename));
 
           switch(type)
           {
@@ -613,7 +776,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
               break;
 
             default:
-              throw Exception(tr("Invalid FMS file. Invalid waypoint type in %1").arg(flpFile.fileName()));
+              throw Exception(tr("Invalid FMS file. Invalid waypoint type in %1").arg(filename));
           }
 
           entry.setIdent(ident);
@@ -623,7 +786,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
         }
         else
           throw Exception(tr("Invalid FMS file. Number of sections is not %2: %1").
-                          arg(flpFile.fileName()).arg(minListSize));
+                          arg(filename).arg(minListSize));
       }
     }
     flpFile.close();
@@ -658,7 +821,7 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
     throw Exception(errorMsg.arg(filename).arg(flpFile.errorString()));
 }
 
-void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, QIODevice& plnFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
   // [FSCFP]
@@ -730,8 +893,6 @@ void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, const QString& fil
   // WP=24,Int,RONAG,RONAG,46.77942,10.25900,0.00,252.4302,2.587,1,0,0,,0,0,22797
   // WP=25,Int,ARDED,ARDED,46.73528,10.12778,0.00,243.8965,2.587,1,0,0,,0,0,22725
 
-  QFile plnFile(filename);
-
   if(plnFile.open(QIODevice::ReadOnly))
   {
     QTextStream stream(&plnFile);
@@ -882,7 +1043,7 @@ void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, const QString& fil
     throw Exception(errorMsg.arg(filename).arg(plnFile.errorString()));
 }
 
-void FlightplanIO::loadFs9(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFs9(atools::fs::pln::Flightplan& plan, QIODevice& plnFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
   // [flightplan]
@@ -920,8 +1081,6 @@ void FlightplanIO::loadFs9(atools::fs::pln::Flightplan& plan, const QString& fil
   // waypoint.1=D205T, I, N56* 59.87', W2* 28.54', +000000.00,
   // waypoint.2=LUK, V, N56* 22.37', W2* 51.82', +000000.00,
 
-  QFile plnFile(filename);
-
   if(plnFile.open(QIODevice::ReadOnly))
   {
     QTextStream stream(&plnFile);
@@ -1046,7 +1205,7 @@ void FlightplanIO::insertPropertyIf(atools::fs::pln::Flightplan& plan, const QSt
     plan.properties.insert(key, value.trimmed());
 }
 
-void FlightplanIO::readWaypointsLnm(atools::util::XmlStream& xmlStream, QList<FlightplanEntry>& entries, const QString& elementName)
+void FlightplanIO::readWaypointsLnm(atools::util::XmlStream& xmlStream, QVector<FlightplanEntry>& entries, const QString& elementName)
 {
   QXmlStreamReader& reader = xmlStream.getReader();
 
@@ -1103,13 +1262,31 @@ void FlightplanIO::loadLnmStr(atools::fs::pln::Flightplan& plan, const QString&
 
 void FlightplanIO::loadLnmGz(atools::fs::pln::Flightplan& plan, const QByteArray& bytes)
 {
-  loadLnmStr(plan, QString(atools::zip::gzipDecompress(bytes)));
+  plan.clearAll();
+  if(atools::zip::isGzipCompressed(bytes))
+  {
+    // Inflate while parsing instead of decompressing into a string first
+    QBuffer buffer;
+    buffer.setData(bytes);
+    buffer.open(QIODevice::ReadOnly);
+    atools::zip::GzipDevice gzipDevice(&buffer, atools::zip::GzipDevice::GZIP);
+    if(gzipDevice.open(QIODevice::ReadOnly))
+    {
+      atools::util::XmlStream xmlStream(&gzipDevice);
+      loadLnmInternal(plan, xmlStream);
+    }
+  }
 }
 
 void FlightplanIO::loadLnm(atools::fs::pln::Flightplan& plan, const QString& filename)
 {
-  plan.clearAll();
   QFile xmlFile(filename);
+  loadLnm(plan, xmlFile, filename);
+}
+
+void FlightplanIO::loadLnm(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename)
+{
+  plan.clearAll();
   if(xmlFile.open(QIODevice::ReadOnly))
   {
     atools::util::XmlStream xmlStream(&xmlFile, filename);
@@ -1124,7 +1301,7 @@ void FlightplanIO::loadLnmInternal(atools::fs::pln::Flightplan& plan, atools::ut
 {
   QXmlStreamReader& reader = xmlStream.getReader();
 
-  QList<FlightplanEntry> alternates, waypoints;
+  QVector<FlightplanEntry> alternates, waypoints;
 
   xmlStream.readUntilElement("LittleNavmap");
   xmlStream.readUntilElement("Flightplan");
@@ -1316,13 +1493,12 @@ void FlightplanIO::loadLnmInternal(atools::fs::pln::Flightplan& plan, atools::ut
   }
 }
 
-void FlightplanIO::loadPln(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadPln(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
   plan.clearAll();
 
-  QFile xmlFile(filename);
   if(xmlFile.open(QIODevice::ReadOnly))
   {
     atools::util::XmlStream xmlStream(&xmlFile, filename);
@@ -1515,13 +1691,12 @@ void FlightplanIO::loadPln(atools::fs::pln::Flightplan& plan, const QString& fil
 // <ident type="string">29</ident>
 // <icao type="string">KOAK</icao>
 // </wp>
-void FlightplanIO::loadFlightGear(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFlightGear(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
   plan.clearAll();
 
-  QFile xmlFile(filename);
   if(xmlFile.open(QIODevice::ReadOnly))
   {
     atools::util::XmlStream xmlStream(&xmlFile, filename);
@@ -3378,7 +3553,7 @@ void FlightplanIO::saveFmsInternal(const atools::fs::pln::Flightplan& plan, cons
 
         if(ident.isEmpty())
           // No ident - can appear if using export options
-          stream << atools::fs::util::toDegMinFormat(entry.getPosition()) << " ";
+          stream << degMinFormat(entry.getPosition()) << " ";
         else
           // Replace spaces
           stream << ident.replace(SPACE_REGEXP, "_") << " ";
@@ -4000,8 +4175,13 @@ void FlightplanIO::saveGarminFpl(atools::fs::pln::Flightplan plan, const QString
 
 void FlightplanIO::loadGarminFpl(atools::fs::pln::Flightplan& plan, const QString& filename)
 {
-  plan.clearAll();
   QFile xmlFile(filename);
+  loadGarminFpl(plan, xmlFile, filename);
+}
+
+void FlightplanIO::loadGarminFpl(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename)
+{
+  plan.clearAll();
   if(xmlFile.open(QIODevice::ReadOnly))
   {
     atools::util::XmlStream xmlStream(&xmlFile, filename);
@@ -4012,6 +4192,12 @@ void FlightplanIO::loadGarminFpl(atools::fs::pln::Flightplan& plan, const QStrin
     throw Exception(tr("Cannot open file \"%1\". Reason: %2").arg(filename).arg(xmlFile.errorString()));
 }
 
+void FlightplanIO::loadGarminGfp(atools::fs::pln::Flightplan& plan, const QString& filename)
+{
+  QFile gfpFile(filename);
+  loadGarminGfp(plan, gfpFile, filename);
+}
+
 // FPN/RI:F:BIKF:F:RIMUM:F:CELLO:F:6119N:F:BILTO:F:NETKI:F:AMDEP:F:UMLER:F:RIVAK:F:KORUL:F:MAVOS:F:LEAS
 // FPN/RI:F:ENGM:F:N58208E006148:F:N57296E006526:F:N57000E007136:F:N49119E008518:F:N48371E009156:F:N48153E009277:F:EDDM
 // FPN/RI:F:EDDF:F:WUR,N49431E009568:AA:EDDN:A:BISB1E(10O)
@@ -4019,12 +4205,10 @@ void FlightplanIO::loadGarminFpl(atools::fs::pln::Flightplan& plan, const QStrin
 // FPN/RI:F:SPZO:F:ILMOX.V11.JUL.A304.PAZ.W11.VIR.A556.VAS.A311.COSTA:F:SGES
 // FPN/RI:DA:KYKM:D:WENAS7.PERTT:R:09O:F:COBDI,N47072W120397:F:N47406W120509:F:ROZSE,N48134W121018:F:DIABO,N48500W120562.J503.FOLDY,N49031W120427:
 // AA:CYLW:A:PIGLU4.YDC(16O):AP:I16-Z.HUMEK
-void FlightplanIO::loadGarminGfp(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadGarminGfp(atools::fs::pln::Flightplan& plan, QIODevice& gfpFile, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
-  QFile gfpFile(filename);
-
   if(gfpFile.open(QIODevice::ReadOnly))
   {
     QTextStream stream(&gfpFile);
@@ -4138,7 +4322,7 @@ void FlightplanIO::loadGarminGfp(atools::fs::pln::Flightplan& plan, const QStrin
           insertPropertyIf(plan, TRANSITION, value.section('.', 1, 1));
         }
         else
-          qWarning() << Q_FUNC_INFO << "Unknown key in file" << gfpFile.fileName() << lastKey;
+          qWarning() << Q_FUNC_INFO << "Unknown key in file" << filename << lastKey;
 
         lastKey.clear();
       } // if(atools::contains(value,  ... else
@@ -4533,11 +4717,22 @@ QString FlightplanIO::identOrDegMinFormat(const atools::fs::pln::FlightplanEntry
 {
   if(entry.getWaypointType() == atools::fs::pln::entry::USER ||
      entry.getWaypointType() == atools::fs::pln::entry::UNKNOWN)
-    return atools::fs::util::toDegMinFormat(entry.getPosition());
+    return degMinFormat(entry.getPosition());
   else
     return entry.getIdent();
 }
 
+QString FlightplanIO::degMinFormat(const atools::geo::Pos& pos)
+{
+  if(exportCache != nullptr)
+  {
+    QHash<atools::geo::Pos, QString>::const_iterator it = exportCache->degMinFormats.constFind(pos);
+    if(it != exportCache->degMinFormats.constEnd())
+      return it.value();
+  }
+  return atools::fs::util::toDegMinFormat(pos);
+}
+
 QString FlightplanIO::xplaneRunway(QString runway)
 {
   if(runway.startsWith("RW"))
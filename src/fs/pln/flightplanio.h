@@ -18,13 +18,16 @@
 #ifndef ATOOLS_FLIGHTPLANIO_H
 #define ATOOLS_FLIGHTPLANIO_H
 
-#include "fs/pln/flightplanconstants.h"
+#include "fs/pln/flightplan.h"
 
 #include <QCoreApplication>
 
+#include <functional>
+
 class QXmlStreamReader;
 class QXmlStreamWriter;
 class QTextStream;
+class QIODevice;
 
 namespace atools {
 namespace util {
@@ -37,8 +40,33 @@ class Pos;
 namespace fs {
 namespace pln {
 
-class Flightplan;
-class FlightplanEntry;
+/* Result for one file of a batch load */
+struct FlightplanLoadResult
+{
+  QString filename;
+  atools::fs::pln::Flightplan plan;
+  atools::fs::pln::FileFormat format = atools::fs::pln::NONE;
+
+  /* Not empty if loading failed. plan is incomplete in this case. */
+  QString errorMessage;
+};
+
+class FlightplanIO;
+
+/* Calls one of the save methods of the given FlightplanIO. Example:
+ * [filename](FlightplanIO& io, const Flightplan& plan) { io.saveFms11(plan, filename); } */
+typedef std::function<void (atools::fs::pln::FlightplanIO& flightplanIO, const atools::fs::pln::Flightplan& plan)> SaveFuncType;
+
+/* One file for FlightplanIO::saveAll() */
+struct FlightplanSaveJob
+{
+  /* Used for error messages only */
+  QString filename;
+  atools::fs::pln::SaveFuncType func;
+
+  /* Not empty if saving failed */
+  QString errorMessage;
+};
 
 /*
  * Collects all save and load methods of flight plan.
@@ -61,9 +89,28 @@ public:
    */
   FileFormat load(atools::fs::pln::Flightplan& plan, const QString& file);
 
+  /* Same as above but loads from a buffer containing the whole file. filename is used for error reporting only. */
+  FileFormat load(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+
+  /*
+   * Load all files in parallel using one FlightplanIO instance per thread.
+   * Each file is read only once. Errors are reported in FlightplanLoadResult::errorMessage and do not stop loading.
+   * Results are appended in order of filenames.
+   * numThreads: 0 uses the number of cores.
+   */
+  static void loadFiles(QVector<atools::fs::pln::FlightplanLoadResult>& results, const QStringList& filenames,
+                        int numThreads = 0);
+
+  /* Load all flight plans in a directory in parallel as above. Files not having a supported format are skipped. */
+  static void loadDirectory(QVector<atools::fs::pln::FlightplanLoadResult>& results, const QString& directory,
+                            bool recursive, int numThreads = 0);
+
   /* Detect format by reading the first few lines */
   static atools::fs::pln::FileFormat detectFormat(const QString& file);
 
+  /* Detect format by reading the first few lines from the beginning of the buffer */
+  static atools::fs::pln::FileFormat detectFormat(const QByteArray& bytes, const QString& filename);
+
   /* true for any supported flight plan file */
   static bool isFlightplanFile(const QString& file)
   {
@@ -173,6 +220,16 @@ public:
   /*  iFly Jets Advanced Series */
   void saveIfly(const Flightplan& plan, const QString& filename);
 
+  /*
+   * Export one plan to many files and formats at once. Coordinate strings shared by the formats are calculated once
+   * before running all jobs concurrently using one FlightplanIO instance per thread.
+   * Errors are reported in FlightplanSaveJob::errorMessage and do not stop other jobs.
+   * Returns true if all jobs succeeded.
+   * numThreads: 0 uses the number of cores.
+   */
+  static bool saveAll(const atools::fs::pln::Flightplan& plan, QVector<atools::fs::pln::FlightplanSaveJob>& jobs,
+                      int numThreads = 0);
+
   /* Version number to save into LNMPLN files */
   static const int LNMPLN_VERSION_MAJOR = 1;
   static const int LNMPLN_VERSION_MINOR = 2;
@@ -186,13 +243,28 @@ private:
   void loadGarminFplInternal(Flightplan& plan, util::XmlStream& xmlStream);
   atools::fs::pln::entry::WaypointType garminToWaypointType(const QString& typeStr) const;
 
-  /* Load specific formats after content detection */
-  void loadPln(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFs9(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFlp(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFms(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFsc(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFlightGear(atools::fs::pln::Flightplan& plan, const QString& filename);
+  /* Read file once into a memory mapped or loaded buffer and load the plan from there. Returns NONE without loading
+   * if format is unknown and exceptionIfUnknown is false. */
+  FileFormat loadFile(atools::fs::pln::Flightplan& plan, const QString& file, bool exceptionIfUnknown);
+  FileFormat loadBytes(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename,
+                       bool exceptionIfUnknown);
+
+  static void loadFilesInternal(QVector<atools::fs::pln::FlightplanLoadResult>& results, const QStringList& filenames,
+                                int numThreads, bool skipUnknown);
+
+  static atools::fs::pln::FileFormat detectFormatLines(const QStringList& lines, const QString& file);
+
+  /* Load specific formats after content detection. Device is opened and closed by the methods.
+   * filename is used for messages only. */
+  void loadPln(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename);
+  void loadFs9(atools::fs::pln::Flightplan& plan, QIODevice& plnFile, const QString& filename);
+  void loadFlp(atools::fs::pln::Flightplan& plan, QIODevice& flpFile, const QString& filename);
+  void loadFms(atools::fs::pln::Flightplan& plan, QIODevice& flpFile, const QString& filename);
+  void loadFsc(atools::fs::pln::Flightplan& plan, QIODevice& plnFile, const QString& filename);
+  void loadFlightGear(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename);
+  void loadLnm(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename);
+  void loadGarminFpl(atools::fs::pln::Flightplan& plan, QIODevice& xmlFile, const QString& filename);
+  void loadGarminGfp(atools::fs::pln::Flightplan& plan, QIODevice& gfpFile, const QString& filename);
 
   /* Write string into memory location, truncate if needed and fill up to length with null */
   void writeBinaryString(char *mem, QString str, int length);
@@ -227,7 +299,7 @@ private:
   atools::geo::Pos readPosLnm(util::XmlStream& xmlStream);
 
   /* Read waypoint elements and attributes from stream */
-  void readWaypointsLnm(atools::util::XmlStream& xmlStream, QList<FlightplanEntry>& entries,
+  void readWaypointsLnm(atools::util::XmlStream& xmlStream, QVector<FlightplanEntry>& entries,
                         const QString& elementName);
 
   /* Number of entries including start and destination but excluding procedure points */
@@ -245,8 +317,15 @@ private:
   /* Add zero prefix for X-Plane runway numbers */
   QString xplaneRunway(QString runway);
 
+  /* Coordinates in degree and minutes format. Uses values calculated by saveAll() if available. */
+  QString degMinFormat(const atools::geo::Pos& pos);
+
   QString errorMsg;
 
+  /* Precalculated values shared by all instances used in saveAll(). Read only. */
+  struct ExportCache;
+  const ExportCache *exportCache = nullptr;
+
 };
 
 } // namespace pln
@@ -0,0 +1,319 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/primitivebenchmark.h"
+
+#include "fs/common/globereader.h"
+#include "fs/pln/flightplan.h"
+#include "fs/pln/flightplanio.h"
+#include "fs/weather/metarparser.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+#include "geo/spatialindex.h"
+#include "grib/windquery.h"
+#include "util/csvreader.h"
+#include "util/microbenchmark.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+namespace atools {
+namespace fs {
+
+using atools::geo::Pos;
+using atools::geo::Rect;
+using atools::geo::LineString;
+using atools::util::MicroBenchmark;
+
+/* Number of positions or items processed per call for the synthetic benchmarks */
+static const int NUM_ITEMS = 1000;
+static const int NUM_INDEX_POINTS = 100000;
+static const quint32 SEED = 1;
+
+/* Object for the spatial index */
+struct BenchmarkPoint
+{
+  Pos pos;
+
+  const Pos& getPosition() const
+  {
+    return pos;
+  }
+
+};
+
+static QVector<Pos> randomPositions(QRandomGenerator& random, int number, float maxAltitude = 0.f)
+{
+  QVector<Pos> positions;
+  for(int i = 0; i < number; i++)
+    positions.append(Pos(static_cast<float>(random.generateDouble() * 360. - 180.),
+                         static_cast<float>(random.generateDouble() * 170. - 85.),
+                         static_cast<float>(random.generateDouble() * maxAltitude)));
+  return positions;
+}
+
+PrimitiveBenchmark::PrimitiveBenchmark(util::MicroBenchmark& microBenchmark)
+  : benchmark(microBenchmark)
+{
+}
+
+void PrimitiveBenchmark::runAll(const PrimitiveBenchmarkInputs& inputs)
+{
+  runGeo();
+  runSpatialIndex();
+  runWind();
+
+  if(!inputs.metarFile.isEmpty())
+    runMetar(inputs.metarFile);
+
+  if(!inputs.globeDir.isEmpty())
+    runGlobe(inputs.globeDir);
+
+  if(!inputs.flightplanFiles.isEmpty())
+    runFlightplans(inputs.flightplanFiles);
+
+  if(!inputs.csvFile.isEmpty())
+    runCsv(inputs.csvFile);
+}
+
+void PrimitiveBenchmark::runGeo()
+{
+  QRandomGenerator random(SEED);
+  const QVector<Pos> positions = randomPositions(random, NUM_ITEMS + 1);
+
+  QVector<Rect> rects;
+  for(const Pos& pos : positions)
+    rects.append(Rect(pos, static_cast<float>(random.bounded(1000000)), true /* fast */));
+
+  benchmark.run("Pos::distanceMeterTo", [&positions]() {
+    for(int i = 0; i < NUM_ITEMS; i++)
+      MicroBenchmark::keep(positions.at(i).distanceMeterTo(positions.at(i + 1)));
+  }, NUM_ITEMS);
+
+  benchmark.run("Pos::distanceMeterToFast", [&positions]() {
+    for(int i = 0; i < NUM_ITEMS; i++)
+      MicroBenchmark::keep(positions.at(i).distanceMeterToFast(positions.at(i + 1)));
+  }, NUM_ITEMS);
+
+  benchmark.run("Pos::angleDegTo", [&positions]() {
+    for(int i = 0; i < NUM_ITEMS; i++)
+      MicroBenchmark::keep(positions.at(i).angleDegTo(positions.at(i + 1)));
+  }, NUM_ITEMS);
+
+  benchmark.run("Pos::interpolate", [&positions]() {
+    for(int i = 0; i < NUM_ITEMS; i++)
+      MicroBenchmark::keep(positions.at(i).interpolate(positions.at(i + 1), 0.3f));
+  }, NUM_ITEMS);
+
+  benchmark.run("Rect::overlaps", [&rects]() {
+    for(int i = 0; i < NUM_ITEMS; i++)
+      MicroBenchmark::keep(rects.at(i).overlaps(rects.at(i + 1)));
+  }, NUM_ITEMS);
+
+  benchmark.run("Rect::contains", [&rects, &positions]() {
+    for(int i = 0; i < NUM_ITEMS; i++)
+      MicroBenchmark::keep(rects.at(i).contains(positions.at(i + 1)));
+  }, NUM_ITEMS);
+}
+
+void PrimitiveBenchmark::runSpatialIndex()
+{
+  QRandomGenerator random(SEED);
+  const QVector<Pos> points = randomPositions(random, NUM_INDEX_POINTS);
+  const QVector<Pos> queries = randomPositions(random, NUM_ITEMS);
+
+  benchmark.run("SpatialIndex::updateIndex", [&points]() {
+    atools::geo::SpatialIndex<BenchmarkPoint> index;
+    index.reserve(points.size());
+    for(const Pos& pos : points)
+      index.append({pos});
+    index.updateIndex();
+    MicroBenchmark::keep(index.size());
+  }, NUM_INDEX_POINTS);
+
+  atools::geo::SpatialIndex<BenchmarkPoint> index;
+  for(const Pos& pos : points)
+    index.append({pos});
+  index.updateIndex();
+
+  benchmark.run("SpatialIndex::getNearestIndex", [&index, &queries]() {
+    for(const Pos& pos : queries)
+      MicroBenchmark::keep(index.getNearestIndex(pos));
+  }, NUM_ITEMS);
+
+  QVector<int> indexes;
+  benchmark.run("SpatialIndex::getRadiusIndexes", [&index, &queries, &indexes]() {
+    for(const Pos& pos : queries)
+    {
+      indexes.clear();
+      index.getRadiusIndexes(indexes, pos, 100000.f);
+      MicroBenchmark::keep(indexes.size());
+    }
+  }, NUM_ITEMS);
+}
+
+void PrimitiveBenchmark::runWind()
+{
+  QRandomGenerator random(SEED);
+  const QVector<Pos> positions = randomPositions(random, NUM_ITEMS, 40000.f);
+
+  atools::grib::WindQuery windQuery(nullptr, false /* verbose */);
+  windQuery.initFromFixedModel(250.f, 20.f, 5000.f, 280.f, 80.f, 35000.f);
+
+  benchmark.run("WindQuery::getWindForPos", [&windQuery, &positions]() {
+    for(const Pos& pos : positions)
+      MicroBenchmark::keep(windQuery.getWindForPos(pos));
+  }, NUM_ITEMS);
+}
+
+void PrimitiveBenchmark::runMetar(const QString& filename)
+{
+  // Skip empty lines and date lines like "2023/05/01 12:00"
+  static const QRegularExpression DATE_REGEXP("^\\d{4}/\\d{2}/\\d{2}");
+  QStringList metars;
+  for(const QString& line : readLines(filename))
+  {
+    if(!line.isEmpty() && !DATE_REGEXP.match(line).hasMatch())
+      metars.append(line);
+  }
+
+  if(metars.isEmpty())
+    return;
+
+  benchmark.run("MetarParser", [&metars]() {
+    for(const QString& metar : metars)
+    {
+      atools::fs::weather::MetarParser parser(metar);
+      MicroBenchmark::keep(parser);
+    }
+  }, metars.size());
+}
+
+void PrimitiveBenchmark::runGlobe(const QString& dir)
+{
+  atools::fs::common::GlobeReader reader(dir);
+  if(!reader.openFiles())
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open GLOBE files in" << dir;
+    return;
+  }
+
+  // Long distance route crossing oceans and mountains
+  Pos from(8.570556f, 50.033333f), to(-73.778889f, 40.639722f);
+  LineString line;
+  line.append(from);
+  from.interpolatePoints(to, from.distanceMeterTo(to), 500, line);
+  line.append(to);
+
+  LineString elevations;
+  benchmark.run("GlobeReader::getElevations", [&reader, &line, &elevations]() {
+    elevations.clear();
+    reader.getElevations(elevations, line);
+    MicroBenchmark::keep(elevations.size());
+  }, line.size());
+}
+
+void PrimitiveBenchmark::runFlightplans(const QStringList& filenames)
+{
+  QTemporaryDir tempDir;
+  atools::fs::pln::FlightplanIO flightplanIO;
+
+  for(const QString& filename : filenames)
+  {
+    QString name = QFileInfo(filename).fileName();
+    atools::fs::pln::Flightplan plan;
+    try
+    {
+      flightplanIO.load(plan, filename);
+    }
+    catch(std::exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot load" << filename << e.what();
+      continue;
+    }
+
+    benchmark.run("FlightplanIO::load " + name, [&flightplanIO, &filename]() {
+      atools::fs::pln::Flightplan loaded;
+      flightplanIO.load(loaded, filename);
+      MicroBenchmark::keep(loaded);
+    });
+
+    QString out = tempDir.filePath("plan");
+    benchmark.run("FlightplanIO::saveLnm " + name, [&flightplanIO, &plan, &out]() {
+      flightplanIO.saveLnm(plan, out);
+    });
+    benchmark.run("FlightplanIO::savePln " + name, [&flightplanIO, &plan, &out]() {
+      flightplanIO.savePln(plan, out);
+    });
+    benchmark.run("FlightplanIO::saveFms11 " + name, [&flightplanIO, &plan, &out]() {
+      flightplanIO.saveFms11(plan, out);
+    });
+    benchmark.run("FlightplanIO::saveGarminFpl " + name, [&flightplanIO, &plan, &out]() {
+      flightplanIO.saveGarminFpl(plan, out, false /* saveAsUserWaypoints */);
+    });
+    benchmark.run("FlightplanIO::saveRte " + name, [&flightplanIO, &plan, &out]() {
+      flightplanIO.saveRte(plan, out);
+    });
+    benchmark.run("FlightplanIO::saveFlp " + name, [&flightplanIO, &plan, &out]() {
+      flightplanIO.saveFlp(plan, out);
+    });
+  }
+}
+
+void PrimitiveBenchmark::runCsv(const QString& filename)
+{
+  const QStringList lines = readLines(filename);
+  if(lines.isEmpty())
+    return;
+
+  benchmark.run("CsvReader", [&lines]() {
+    atools::util::CsvReader reader;
+    for(const QString& line : lines)
+    {
+      reader.readCsvLine(line);
+      if(!reader.isInEscape())
+      {
+        MicroBenchmark::keep(reader.getValues().size());
+        reader.reset();
+      }
+    }
+  }, lines.size());
+}
+
+QStringList PrimitiveBenchmark::readLines(const QString& filename)
+{
+  QStringList lines;
+  QFile file(filename);
+  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    QTextStream stream(&file);
+    while(!stream.atEnd())
+      lines.append(stream.readLine().trimmed());
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+  return lines;
+}
+
+} // namespace fs
+} // namespace atools
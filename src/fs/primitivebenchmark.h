@@ -0,0 +1,85 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_PRIMITIVEBENCHMARK_H
+#define ATOOLS_FS_PRIMITIVEBENCHMARK_H
+
+#include <QCoreApplication>
+#include <QStringList>
+
+namespace atools {
+namespace util {
+class MicroBenchmark;
+}
+
+namespace fs {
+
+/* Optional input files for benchmarks which need real data. Benchmarks are skipped if a value is empty. */
+struct PrimitiveBenchmarkInputs
+{
+  /* Text file with one METAR per line like the NOAA cycle files. Date lines are ignored. */
+  QString metarFile;
+
+  /* Directory containing the GLOBE elevation files */
+  QString globeDir;
+
+  /* Any CSV file like the userpoint export */
+  QString csvFile;
+
+  /* Flight plans in any format which can be loaded by FlightplanIO */
+  QStringList flightplanFiles;
+};
+
+/*
+ * Set of micro benchmarks for frequently used primitives:
+ * positions and rectangles, spatial index, METAR parser, wind query, GLOBE elevation reader,
+ * flight plan loading and saving and CSV reader.
+ *
+ * Geometry and wind benchmarks use synthetic data from a fixed seed. The others need input files.
+ * The wind query uses a fixed two layer model since GRIB files are loaded asynchronously.
+ *
+ * Results are added to the given MicroBenchmark which allows to save and compare them.
+ */
+class PrimitiveBenchmark
+{
+  Q_DECLARE_TR_FUNCTIONS(PrimitiveBenchmark)
+
+public:
+  PrimitiveBenchmark(atools::util::MicroBenchmark& microBenchmark);
+
+  /* Run all benchmarks having input data */
+  void runAll(const atools::fs::PrimitiveBenchmarkInputs& inputs);
+
+  void runGeo();
+  void runSpatialIndex();
+  void runWind();
+  void runMetar(const QString& filename);
+  void runGlobe(const QString& dir);
+  void runFlightplans(const QStringList& filenames);
+  void runCsv(const QString& filename);
+
+private:
+  /* Read all lines of a text file. Returns empty list and logs a warning on error. */
+  static QStringList readLines(const QString& filename);
+
+  atools::util::MicroBenchmark& benchmark;
+};
+
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_PRIMITIVEBENCHMARK_H
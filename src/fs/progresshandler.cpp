@@ -20,17 +20,27 @@
 #include "fs/scenery/sceneryarea.h"
 
 #include <QDebug>
+#include <QMutexLocker>
 
 namespace atools {
 namespace fs {
 
+ProgressHandler::ProgressHandler()
+  : numFiles(0), numAirports(0), numNamelists(0), numVors(0), numIls(0), numNdbs(0), numMarker(0),
+  numBoundaries(0), numWaypoints(0), numObjectsWritten(0), numErrors(0), current(0), aborted(false),
+  nextCallbackMs(0)
+{
+  timer.start();
+}
+
 void ProgressHandler::increaseCurrent(int increase)
 {
-  info.current += increase;
+  current.fetch_add(increase, std::memory_order_relaxed);
 }
 
 bool ProgressHandler::reportOtherMsg(const QString& otherAction)
 {
+  QMutexLocker locker(&mutex);
   info.otherAction = otherAction;
   info.newFile = false;
   info.newSceneryArea = false;
@@ -39,31 +49,31 @@ bool ProgressHandler::reportOtherMsg(const QString& otherAction)
   return callHandler();
 }
 
-bool ProgressHandler::reportOther(const QString& otherAction, int current, bool silent)
+bool ProgressHandler::reportOther(const QString& otherAction, int currentValue, bool silent)
 {
-  info.lastCurrent = info.current;
-  if(current != -1)
-    info.current = current;
+  if(currentValue != -1)
+    current.store(currentValue, std::memory_order_relaxed);
   else
-    info.current++;
-  info.otherAction = otherAction;
+    current.fetch_add(1, std::memory_order_relaxed);
 
+  if(silent)
+    return false;
+
+  QMutexLocker locker(&mutex);
+  info.otherAction = otherAction;
   info.newFile = false;
   info.newSceneryArea = false;
   info.newOther = true;
 
-  if(silent)
-    return false;
-  else
-    return callHandler();
+  return callHandler();
 }
 
 bool ProgressHandler::reportOtherInc(const QString& otherAction, int increment)
 {
-  info.lastCurrent = info.current;
-  info.current += increment;
-  info.otherAction = otherAction;
+  current.fetch_add(increment, std::memory_order_relaxed);
 
+  QMutexLocker locker(&mutex);
+  info.otherAction = otherAction;
   info.newFile = false;
   info.newSceneryArea = false;
   info.newOther = true;
@@ -71,20 +81,50 @@ bool ProgressHandler::reportOtherInc(const QString& otherAction, int increment)
   return callHandler();
 }
 
+bool ProgressHandler::reportProgress(int increment, const MessageFuncType& messageFunc)
+{
+  current.fetch_add(increment, std::memory_order_relaxed);
+
+  // Cheap check without locking
+  if(timer.elapsed() < nextCallbackMs.load(std::memory_order_relaxed))
+    return aborted.load(std::memory_order_relaxed);
+
+  // Do not wait for other threads which are already reporting
+  if(!mutex.tryLock())
+    return aborted.load(std::memory_order_relaxed);
+
+  bool retval = aborted.load(std::memory_order_relaxed);
+  if(timer.elapsed() >= nextCallbackMs.load(std::memory_order_relaxed))
+  {
+    if(messageFunc)
+      info.otherAction = messageFunc();
+    info.newFile = false;
+    info.newSceneryArea = false;
+    info.newOther = true;
+    retval = callHandler();
+  }
+  mutex.unlock();
+  return retval;
+}
+
 void ProgressHandler::reportError()
 {
-  info.numErrors++;
+  numErrors.fetch_add(1, std::memory_order_relaxed);
 }
 
 void ProgressHandler::reportErrors(int num)
 {
-  info.numErrors += num;
+  numErrors.fetch_add(num, std::memory_order_relaxed);
 }
 
 bool ProgressHandler::reportBglFile(const QString& bglFilepath)
 {
-  info.lastCurrent = info.current;
-  info.current++;
+  current.fetch_add(1, std::memory_order_relaxed);
+
+  if(timer.elapsed() < nextCallbackMs.load(std::memory_order_relaxed))
+    return aborted.load(std::memory_order_relaxed);
+
+  QMutexLocker locker(&mutex);
   info.filepath = bglFilepath;
 
   info.newFile = true;
@@ -96,25 +136,30 @@ bool ProgressHandler::reportBglFile(const QString& bglFilepath)
 
 bool ProgressHandler::reportFinish()
 {
+  QMutexLocker locker(&mutex);
   info.lastCall = true;
   info.newFile = false;
   info.newSceneryArea = false;
   info.newOther = false;
 
-  qDebug() << Q_FUNC_INFO << "info.current" << info.current;
+  qDebug() << Q_FUNC_INFO << "current" << current.load();
 
   return callHandler();
 }
 
 void ProgressHandler::setTotal(int total)
 {
+  QMutexLocker locker(&mutex);
   info.total = total;
 }
 
 void ProgressHandler::reset()
 {
-  info.numErrors = 0;
-  info.current = 0;
+  QMutexLocker locker(&mutex);
+  numErrors.store(0);
+  current.store(0);
+  aborted.store(false);
+  nextCallbackMs.store(0);
   info.lastCurrent = 0;
   info.sceneryArea = nullptr;
   info.filepath.clear();
@@ -127,8 +172,9 @@ void ProgressHandler::reset()
 
 bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea)
 {
-  info.lastCurrent = info.current;
-  info.current++;
+  current.fetch_add(1, std::memory_order_relaxed);
+
+  QMutexLocker locker(&mutex);
   info.sceneryArea = sceneryArea;
 
   info.newFile = false;
@@ -142,6 +188,21 @@ bool ProgressHandler::callHandler()
 {
   bool retval = false;
 
+  // Copy counters - lastCurrent is the value of the last call
+  info.lastCurrent = info.current;
+  info.current = current.load(std::memory_order_relaxed);
+  info.numFiles = numFiles.load(std::memory_order_relaxed);
+  info.numAirports = numAirports.load(std::memory_order_relaxed);
+  info.numNamelists = numNamelists.load(std::memory_order_relaxed);
+  info.numVors = numVors.load(std::memory_order_relaxed);
+  info.numIls = numIls.load(std::memory_order_relaxed);
+  info.numNdbs = numNdbs.load(std::memory_order_relaxed);
+  info.numMarker = numMarker.load(std::memory_order_relaxed);
+  info.numBoundaries = numBoundaries.load(std::memory_order_relaxed);
+  info.numWaypoints = numWaypoints.load(std::memory_order_relaxed);
+  info.numObjectsWritten = numObjectsWritten.load(std::memory_order_relaxed);
+  info.numErrors = numErrors.load(std::memory_order_relaxed);
+
   // Alway call default handler - this one cannot call cancel
   if(callDefaultCallback)
     defaultProgressCallback();
@@ -153,6 +214,11 @@ bool ProgressHandler::callHandler()
   if(info.firstCall)
     info.firstCall = false;
 
+  if(retval)
+    aborted.store(true);
+
+  nextCallbackMs.store(timer.elapsed() + callbackIntervalMs, std::memory_order_relaxed);
+
   return retval;
 }
 
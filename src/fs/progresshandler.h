@@ -21,6 +21,11 @@
 #include "fs/navdatabaseprogress.h"
 #include "fs/navdatabaseoptions.h"
 
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+
 namespace atools {
 namespace fs {
 namespace scenery {
@@ -29,10 +34,18 @@ class SceneryArea;
 
 /*
  * Progress handler. Fills the NavDatabaseProgress object with information and calls the progress callback.
+ *
+ * Counters are atomic and can be updated from worker threads. All report methods are thread safe.
+ * reportBglFile() and reportProgress() are throttled and call the callbacks at most once per callback interval.
+ * Skipped calls only update counters and return the last abort state. Messages for reportProgress() are built
+ * only if a callback is actually called.
+ * All other report methods always call the callbacks since they are used for the less frequent steps.
  */
 class ProgressHandler
 {
 public:
+  ProgressHandler();
+
   void setProgressCallback(const atools::fs::NavDatabaseOptions::ProgressCallbackType& value)
   {
     progressCallback = value;
@@ -43,13 +56,22 @@ public:
     callDefaultCallback = value;
   }
 
+  /* Minimum time between two callbacks for throttled reports. 0 calls the callbacks on each report. */
+  void setCallbackIntervalMs(int value)
+  {
+    callbackIntervalMs = value;
+  }
+
+  /* Message is built only if the callbacks are called */
+  typedef std::function<QString()> MessageFuncType;
+
   /*
    * Increment progress by one and send message about new scenery area
    */
   bool reportSceneryArea(const atools::fs::scenery::SceneryArea *sceneryArea);
 
   /*
-   * Increment progress by one and send message about new BGL file
+   * Increment progress by one and send message about new BGL file. Throttled.
    */
   bool reportBglFile(const QString& bglFilepath);
 
@@ -77,6 +99,13 @@ public:
   /* Only send message without incrementing progress */
   bool reportOtherMsg(const QString& otherAction);
 
+  /*
+   * Increment progress by increment and send message about other processes if the callback interval has passed.
+   * Can be called from worker threads. The callbacks are not called if another thread is currently reporting.
+   * Returns true if the callback requested to abort in this or an earlier call.
+   */
+  bool reportProgress(int increment, const MessageFuncType& messageFunc = nullptr);
+
   /* set total amount of progress steps */
   void setTotal(int total);
 
@@ -89,102 +118,102 @@ public:
   /* Set current number of BGL files */
   void setNumFiles(int value)
   {
-    info.numFiles = value;
+    numFiles.store(value, std::memory_order_relaxed);
   }
 
   void setNumAirports(int value)
   {
-    info.numAirports = value;
+    numAirports.store(value, std::memory_order_relaxed);
   }
 
   void setNumNamelists(int value)
   {
-    info.numNamelists = value;
+    numNamelists.store(value, std::memory_order_relaxed);
   }
 
   void setNumVors(int value)
   {
-    info.numVors = value;
+    numVors.store(value, std::memory_order_relaxed);
   }
 
   void setNumIls(int value)
   {
-    info.numIls = value;
+    numIls.store(value, std::memory_order_relaxed);
   }
 
   void setNumNdbs(int value)
   {
-    info.numNdbs = value;
+    numNdbs.store(value, std::memory_order_relaxed);
   }
 
   void setNumMarker(int value)
   {
-    info.numMarker = value;
+    numMarker.store(value, std::memory_order_relaxed);
   }
 
   void setNumBoundaries(int value)
   {
-    info.numBoundaries = value;
+    numBoundaries.store(value, std::memory_order_relaxed);
   }
 
   void setNumWaypoints(int value)
   {
-    info.numWaypoints = value;
+    numWaypoints.store(value, std::memory_order_relaxed);
   }
 
   void setNumObjectsWritten(int value)
   {
-    info.numObjectsWritten = value;
+    numObjectsWritten.store(value, std::memory_order_relaxed);
   }
 
   void incNumFiles(int value = 1)
   {
-    info.numFiles += value;
+    numFiles.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumAirports(int value = 1)
   {
-    info.numAirports += value;
+    numAirports.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumNamelists(int value = 1)
   {
-    info.numNamelists += value;
+    numNamelists.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumVors(int value = 1)
   {
-    info.numVors += value;
+    numVors.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumIls(int value = 1)
   {
-    info.numIls += value;
+    numIls.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumNdbs(int value = 1)
   {
-    info.numNdbs += value;
+    numNdbs.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumMarker(int value = 1)
   {
-    info.numMarker += value;
+    numMarker.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumBoundaries(int value = 1)
   {
-    info.numBoundaries += value;
+    numBoundaries.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumWaypoints(int value = 1)
   {
-    info.numWaypoints += value;
+    numWaypoints.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumObjectsWritten(int value = 1)
   {
-    info.numObjectsWritten += value;
+    numObjectsWritten.fetch_add(value, std::memory_order_relaxed);
   }
 
 private:
@@ -193,10 +222,27 @@ private:
 
   atools::fs::NavDatabaseOptions::ProgressCallbackType progressCallback;
 
+  /* Only accessed when mutex is locked */
   atools::fs::NavDatabaseProgress info;
 
+  /* Copies counters into info and calls callbacks. Mutex has to be locked. */
   bool callHandler();
 
+  /* Counters copied into info before calling the callbacks */
+  std::atomic<int> numFiles, numAirports, numNamelists, numVors, numIls, numNdbs, numMarker, numBoundaries,
+                   numWaypoints, numObjectsWritten, numErrors, current;
+
+  /* Aborted by callback */
+  std::atomic_bool aborted;
+
+  /* Time since start for next throttled callback */
+  std::atomic<qint64> nextCallbackMs;
+  QElapsedTimer timer;
+  int callbackIntervalMs = 100;
+
+  /* Serializes callbacks and access to info */
+  QMutex mutex;
+
   static QString numbersAsString(const atools::fs::NavDatabaseProgress& inf);
 
 };
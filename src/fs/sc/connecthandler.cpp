@@ -17,6 +17,9 @@
 
 #include "fs/sc/connecthandler.h"
 
+#include "fs/sc/simconnectdata.h"
+#include "geo/calculations.h"
+
 namespace atools {
 namespace fs {
 namespace sc {
@@ -29,6 +32,36 @@ ConnectHandler::~ConnectHandler()
 {
 }
 
+bool ConnectHandler::isInsideRadius(const geo::Pos& center, const geo::Pos& pos, int radiusKm)
+{
+  if(radiusKm <= 0 || !center.isValid())
+    return true;
+
+  if(!pos.isValid())
+    return false;
+
+  float radiusMeter = static_cast<float>(radiusKm) * 1000.f;
+
+  // One degree latitude is always about 60 NM - cheap check before calculating great circle distance
+  if(std::abs(center.getLatY() - pos.getLatY()) * atools::geo::nmToMeter(60.f) > radiusMeter)
+    return false;
+
+  return center.distanceMeterTo(pos) <= radiusMeter;
+}
+
+void ConnectHandler::filterAiByRadius(SimConnectData& data, int radiusKm)
+{
+  const atools::geo::Pos& center = data.getUserAircraftConst().getPosition();
+  if(radiusKm <= 0 || !center.isValid())
+    return;
+
+  QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+  aiAircraft.erase(std::remove_if(aiAircraft.begin(), aiAircraft.end(),
+                                  [&center, radiusKm](const SimConnectAircraft& aircraft) -> bool {
+                                    return !isInsideRadius(center, aircraft.getPosition(), radiusKm);
+                                  }), aiAircraft.end());
+}
+
 } // namespace sc
 } // namespace fs
 } // namespace atools
@@ -21,6 +21,10 @@
 #include "fs/sc/simconnecttypes.h"
 
 namespace atools {
+namespace geo {
+class Pos;
+}
+
 namespace fs {
 namespace sc {
 
@@ -53,7 +57,8 @@ public:
 
   virtual bool isLoaded() const = 0;
 
-  /* Fetch data from simulator. Returns false if no data was retrieved due to paused or not running fs. */
+  /* Fetch data from simulator. Returns false if no data was retrieved due to paused or not running fs.
+   * AI outside of radiusKm around the user aircraft is not collected. 0 means no limit for X-Plane. */
   virtual bool fetchData(atools::fs::sc::SimConnectData& data, int radiusKm, atools::fs::sc::Options options) = 0;
   virtual bool fetchWeatherData(atools::fs::sc::SimConnectData& data) = 0;
 
@@ -73,6 +78,14 @@ public:
   /* Name which can be used when saving options */
   virtual QString getName() const = 0;
 
+protected:
+  /* true if pos is within radius around center. Checks the latitude difference first to avoid costly
+   * distance calculations for far away objects. Always true if radius is 0 or center is not valid. */
+  static bool isInsideRadius(const atools::geo::Pos& center, const atools::geo::Pos& pos, int radiusKm);
+
+  /* Remove AI aircraft, helicopters and boats outside of radius around the user aircraft. Does nothing if radius is 0. */
+  static void filterAiByRadius(atools::fs::sc::SimConnectData& data, int radiusKm);
+
 };
 
 } // namespace sc
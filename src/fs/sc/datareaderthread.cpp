@@ -16,17 +16,24 @@
 *****************************************************************************/
 
 #include "fs/sc/datareaderthread.h"
+#include "fs/sc/replayfile.h"
+#include "fs/sc/simconnectdatabuffer.h"
 
 #include "fs/sc/simconnecthandler.h"
+#include "fs/sc/weatherrequestbroker.h"
 #include "fs/sc/xpconnecthandler.h"
 #include "atools.h"
 
+#include "geo/calculations.h"
+#include "util/metrics.h"
+
 #include <QDebug>
 #include <QDateTime>
 #include <QFile>
 #include <QDataStream>
 #include <QCoreApplication>
 #include <QDir>
+#include <QSet>
 
 namespace atools {
 namespace fs {
@@ -221,11 +228,32 @@ DataReaderThread::DataReaderThread(QObject *parent, bool verboseLog)
   setObjectName("DataReaderThread");
 
   options = atools::fs::sc::FETCH_AI_AIRCRAFT | atools::fs::sc::FETCH_AI_BOAT;
+  dataBuffer = new SimConnectDataBuffer;
+  weatherBroker = new WeatherRequestBroker;
 }
 
 DataReaderThread::~DataReaderThread()
 {
   qDebug() << Q_FUNC_INFO;
+  delete dataBuffer;
+  delete weatherBroker;
+}
+
+void DataReaderThread::postData(const SimConnectData& data)
+{
+  static atools::util::MetricCounter& packetCounter =
+    atools::util::Metrics::instance().counter("atools_simconnect_packets_total", "Packets read from the simulator");
+  static atools::util::MetricGauge& droppedGauge =
+    atools::util::Metrics::instance().gauge("atools_simconnect_dropped_packets",
+                                            "Packets dropped by the data buffer since start of the reader thread");
+
+  emit postSimConnectData(data);
+
+  if(dataBuffer->write(data))
+    emit simConnectDataAvailable();
+
+  packetCounter.increment();
+  droppedGauge.set(static_cast<qint64>(dataBuffer->getNumDropped()));
 }
 
 void DataReaderThread::setHandler(ConnectHandler *connectHandler)
@@ -269,6 +297,13 @@ void DataReaderThread::connectToSimulator()
 #endif
 
           connected = true;
+
+          {
+            // Cached weather is not valid for a new session
+            QMutexLocker locker(&handlerMutex);
+            weatherBroker->clear();
+          }
+
           emit connectedToSimulator();
           QString connectMsg = tr("Connected to simulator.");
           emit postStatus(atools::fs::sc::OK, connectMsg);
@@ -315,7 +350,7 @@ void DataReaderThread::run()
 
   // Try to connect first ============================================
 
-  if(loadReplayFile == nullptr)
+  if(replayReader == nullptr)
     // Connect to the simulator
     connectToSimulator();
   else
@@ -331,21 +366,31 @@ void DataReaderThread::run()
   failedTerminally = false;
 
   // Main loop  ============================================
+  QElapsedTimer iterationTimer;
   while(!terminate)
   {
+    iterationTimer.start();
+    bool idle = false;
+
     atools::fs::sc::SimConnectData data;
     atools::fs::sc::Options opts = options;
 
-    if(loadReplayFile != nullptr)
+    if(replayReader != nullptr)
     {
       // Do replay ============================================
-      data.read(loadReplayFile);
+      // Skip frames if the replay speed exceeds the update rate
+      bool ok = true;
+      for(int i = 1; i < replaySkipFrames && ok; i++)
+      {
+        atools::fs::sc::SimConnectData skipped;
+        ok = replayReader->readNext(skipped);
+      }
+
+      if(ok)
+        replayReader->readNext(data);
 
       if(data.getStatus() == OK)
       {
-        if(loadReplayFile->atEnd())
-          loadReplayFile->seek(REPLAY_FILE_DATA_START_OFFSET);
-
         // Remove boat and ship traffic depending on settings for testing purposes
         QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
         if(!(opts & atools::fs::sc::FETCH_AI_AIRCRAFT))
@@ -381,7 +426,7 @@ void DataReaderThread::run()
                                                   }), data.getAiAircraft().end());
 #endif
 
-        emit postSimConnectData(data);
+        postData(data);
       }
       else
       {
@@ -390,18 +435,18 @@ void DataReaderThread::run()
                             arg(loadReplayFilepath).arg(data.getStatusText()), false, true);
         closeReplay();
       }
-    } // if(loadReplayFile != nullptr)
+    } // if(replayReader != nullptr)
     else if(fetchData(data, aiFetchRadiusKm, opts))
     {
       // Data fetched from simconnect - send to client ============================================
       if(verbose && !data.getMetars().isEmpty())
         qDebug() << "DataReaderThread::run() num metars" << data.getMetars().size();
 
-      emit postSimConnectData(data);
+      postData(data);
 
-      if(saveReplayFile != nullptr && saveReplayFile->isOpen() && data.getPacketId() > 0)
+      if(replayWriter != nullptr && data.getPacketId() > 0)
         // Save only simulator packets, not weather replays
-        data.write(saveReplayFile);
+        replayWriter->write(data);
     }
     else
     {
@@ -453,16 +498,24 @@ void DataReaderThread::run()
 
         break;
       }
-      // else
-      // qWarning() << "No data fetched";
+      else
+        // No data fetched - simulator paused or not running
+        idle = true;
     }
 
     unsigned long sleepMs = 500;
-    if(loadReplayFile != nullptr)
-      sleepMs = static_cast<unsigned long>(static_cast<float>(replayUpdateRateMs) /
+    if(replayReader != nullptr)
+      sleepMs = static_cast<unsigned long>(static_cast<float>(replayUpdateRateMs) * replaySkipFrames /
                                            static_cast<float>(replaySpeed));
     else
-      sleepMs = updateRate;
+    {
+      // Wait longer if nothing is happening - weather requests still wake up the thread
+      sleepMs = idle ? std::max(updateRate, IDLE_UPDATE_RATE_MS) : updateRate;
+
+      // Subtract time needed for fetching to keep the rate and avoid adding latency
+      unsigned long elapsedMs = static_cast<unsigned long>(iterationTimer.elapsed());
+      sleepMs = sleepMs > elapsedMs ? sleepMs - elapsedMs : 1;
+    }
 
     bool wakeUpSignalled = waitCondition.wait(&waitMutex, sleepMs);
     if(wakeUpSignalled && verbose)
@@ -496,7 +549,7 @@ bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiu
 
   QMutexLocker locker(&handlerMutex);
 
-  bool weatherRequested = handler->getWeatherRequest().isValid();
+  bool weatherRequested = weatherBroker->hasRequests();
 
   bool retval = false;
 
@@ -505,7 +558,10 @@ bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiu
     if(verbose)
       qDebug() << "DataReaderThread::fetchData weather";
 
-    handler->fetchWeatherData(data);
+    // Answer all requests collected since last iteration in one reply
+    QVector<atools::fs::weather::MetarResult> metars;
+    weatherBroker->fetch(handler, metars);
+    data.setMetars(metars);
 
     // Weather requests and reply always have packet id 0
     data.setPacketId(0);
@@ -518,8 +574,45 @@ bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiu
     if(verbose)
       qDebug() << "DataReaderThread::fetchData nextPacketId" << nextPacketId;
 
-    retval = handler->fetchData(data, radiusKm, fetchOptions);
+    const Options aiOptions = atools::fs::sc::FETCH_AI_AIRCRAFT | atools::fs::sc::FETCH_AI_BOAT;
+    bool fetchAi = fetchOptions & aiOptions;
+
+    // Fetch all AI if due - otherwise only near AI or none
+    bool fullAiUpdate = !fetchAi || aiUpdateRate <= updateRate || !aiUpdateTimer.isValid() ||
+                        aiUpdateTimer.elapsed() >= static_cast<qint64>(aiUpdateRate);
+
+    // X-Plane has no radius limit for full updates
+    int fetchRadiusKm = isXplaneHandler() ? 0 : radiusKm;
+    Options opts = fetchOptions;
+    if(!fullAiUpdate)
+    {
+      if(aiNearRadiusKm > 0)
+        fetchRadiusKm = fetchRadiusKm > 0 ? std::min(aiNearRadiusKm, fetchRadiusKm) : aiNearRadiusKm;
+      else
+        opts &= ~aiOptions;
+    }
+
+    static atools::util::MetricHistogram& fetchHistogram =
+      atools::util::Metrics::instance().histogram("atools_simconnect_fetch_duration_seconds",
+                                                  "Time needed to fetch a packet from the simulator");
+    QElapsedTimer fetchTimer;
+    fetchTimer.start();
+    retval = handler->fetchData(data, fetchRadiusKm, opts);
+    fetchHistogram.observe(fetchTimer.nsecsElapsed() / 1.e9);
     data.setPacketId(nextPacketId++);
+
+    if(!fetchAi)
+      lastAiAircraft.clear();
+    else if(retval)
+    {
+      if(fullAiUpdate)
+      {
+        lastAiAircraft = data.getAiAircraftConst();
+        aiUpdateTimer.start();
+      }
+      else
+        mergeDistantAiAircraft(data);
+    }
   }
 
   data.setPacketTimestamp(QDateTime::currentDateTimeUtc());
@@ -539,88 +632,82 @@ bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiu
   return retval;
 }
 
-void DataReaderThread::setupReplay()
+void DataReaderThread::mergeDistantAiAircraft(SimConnectData& data)
 {
-  if(!loadReplayFilepath.isEmpty())
-  {
-    loadReplayFile = new QFile(loadReplayFilepath);
+  QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
 
-    if(loadReplayFile->size() > static_cast<qint64>(REPLAY_FILE_DATA_START_OFFSET))
-    {
-      if(!loadReplayFile->open(QIODevice::ReadOnly))
-      {
-        emit postLogMessage(tr("Cannot open \"%1\".").arg(loadReplayFilepath), false, true);
-        delete loadReplayFile;
-        loadReplayFile = nullptr;
-      }
-      else
-      {
-        QDataStream in(loadReplayFile);
-        in.setVersion(QDataStream::Qt_5_5);
-        in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  QSet<unsigned int> ids;
+  for(const SimConnectAircraft& aircraft : qAsConst(aiAircraft))
+    ids.insert(aircraft.getObjectId());
 
-        quint32 magicNumber, version;
+  const atools::geo::Pos& userPos = data.getUserAircraftConst().getPosition();
+  float nearRadiusMeter = static_cast<float>(aiNearRadiusKm) * 1000.f;
 
-        in >> magicNumber >> version >> replayUpdateRateMs;
-        if(magicNumber != REPLAY_FILE_MAGIC_NUMBER)
-        {
-          emit postLogMessage(tr("Cannot open \"%1\". Is not a replay file - wrong magic number.").
-                              arg(loadReplayFilepath), false, true);
-          closeReplay();
-          return;
-        }
-        if(version != REPLAY_FILE_VERSION)
-        {
-          emit postLogMessage(tr("Cannot open \"%1\". Wrong version.").arg(loadReplayFilepath), false, true);
-          closeReplay();
-          return;
-        }
+  for(const SimConnectAircraft& aircraft : qAsConst(lastAiAircraft))
+  {
+    // Keep last values for distant aircraft - aircraft which were near and are missing now are gone
+    if(!ids.contains(aircraft.getObjectId()) &&
+       (!userPos.isValid() || aiNearRadiusKm <= 0 || userPos.distanceMeterTo(aircraft.getPosition()) > nearRadiusMeter))
+      aiAircraft.append(aircraft);
+  }
 
-        emit postLogMessage(tr("Replaying from \"%1\".").arg(loadReplayFilepath), false, false);
-        emit connectedToSimulator();
-      }
-    }
-    else
+  lastAiAircraft = aiAircraft;
+}
+
+void DataReaderThread::setupReplay()
+{
+  if(!loadReplayFilepath.isEmpty())
+  {
+    replayReader = new ReplayReader(loadReplayFilepath);
+
+    if(!replayReader->open())
     {
-      emit postLogMessage(tr("Cannot open \"%1\". File is too small.").arg(loadReplayFilepath), false, true);
+      emit postLogMessage(tr("Cannot open \"%1\". %2.").arg(loadReplayFilepath).arg(replayReader->getErrorString()),
+                          false, true);
       closeReplay();
       return;
     }
+
+    replayUpdateRateMs = std::max(replayReader->getUpdateRateMs(), 1U);
+
+    // Do not go below the normal update rate with high replay speeds - skip frames instead
+    float intervalMs = static_cast<float>(replayUpdateRateMs) / static_cast<float>(replaySpeed);
+    replaySkipFrames = intervalMs < updateRate ? std::max(1, atools::roundToInt(updateRate / intervalMs)) : 1;
+
+    qDebug() << Q_FUNC_INFO << "version" << replayReader->getVersion() << "frames" << replayReader->getNumFrames()
+             << "update rate" << replayUpdateRateMs << "skip frames" << replaySkipFrames;
+
+    emit postLogMessage(tr("Replaying from \"%1\".").arg(loadReplayFilepath), false, false);
+    emit connectedToSimulator();
   }
   else if(!saveReplayFilepath.isEmpty())
   {
-    saveReplayFile = new QFile(saveReplayFilepath);
-    if(!saveReplayFile->open(QIODevice::WriteOnly))
+    replayWriter = new ReplayWriter(saveReplayFilepath, static_cast<quint32>(updateRate));
+    if(!replayWriter->open())
     {
-      emit postLogMessage(tr("Cannot open \"%1\".").arg(saveReplayFilepath), false, true);
-      delete saveReplayFile;
-      saveReplayFile = nullptr;
+      emit postLogMessage(tr("Cannot open \"%1\". %2.").arg(saveReplayFilepath).arg(replayWriter->getErrorString()),
+                          false, true);
+      closeReplay();
     }
     else
-    {
       emit postLogMessage(tr("Saving replay to \"%1\".").arg(saveReplayFilepath), false, false);
-
-      // Save file header
-      QDataStream out(saveReplayFile);
-      out << REPLAY_FILE_MAGIC_NUMBER << REPLAY_FILE_VERSION << static_cast<quint32>(updateRate);
-    }
   }
 }
 
 void DataReaderThread::closeReplay()
 {
-  if(saveReplayFile != nullptr)
+  if(replayWriter != nullptr)
   {
-    saveReplayFile->close();
-    delete saveReplayFile;
-    saveReplayFile = nullptr;
+    replayWriter->close();
+    delete replayWriter;
+    replayWriter = nullptr;
   }
 
-  if(loadReplayFile != nullptr)
+  if(replayReader != nullptr)
   {
-    loadReplayFile->close();
-    delete loadReplayFile;
-    loadReplayFile = nullptr;
+    replayReader->close();
+    delete replayReader;
+    replayReader = nullptr;
   }
 }
 
@@ -655,7 +742,7 @@ void DataReaderThread::setWeatherRequest(atools::fs::sc::WeatherRequest request)
     return;
   }
 
-  if(saveReplayFile != nullptr)
+  if(replayWriter != nullptr)
   {
     // Post a dummy weather reply if replaying, do not pass to handler
     emit postSimConnectData(atools::fs::sc::SimConnectData());
@@ -664,7 +751,7 @@ void DataReaderThread::setWeatherRequest(atools::fs::sc::WeatherRequest request)
 
   {
     QMutexLocker locker(&handlerMutex);
-    handler->addWeatherRequest(request);
+    weatherBroker->addRequest(request);
   }
 
   waitCondition.wakeAll();
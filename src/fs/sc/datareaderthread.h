@@ -21,17 +21,21 @@
 #include "fs/sc/simconnectdata.h"
 #include "fs/sc/simconnectreply.h"
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QWaitCondition>
 
-class QFile;
 
 namespace atools {
 namespace fs {
 namespace sc {
 
 class ConnectHandler;
+class ReplayReader;
+class ReplayWriter;
+class SimConnectDataBuffer;
+class WeatherRequestBroker;
 
 /* Actively reads flight simulator data using the simconnect interface in background and sends a
  * signal for each data package. */
@@ -58,12 +62,22 @@ public:
     terminate = terminateFlag;
   }
 
-  /* Read data and send a signal every updateRateMs */
+  /* Read data and send a signal every updateRateMs. The time needed for fetching is subtracted from the wait time. */
   void setUpdateRate(unsigned int updateRateMs)
   {
     updateRate = updateRateMs;
   }
 
+  /* Fetch all AI within aiFetchRadiusKm only every aiUpdateRateMs. 0 or a value not larger than the update rate
+   * fetches AI in each iteration. AI within aiNearRadiusKm around the user aircraft is fetched in each iteration
+   * while the last known values are kept for more distant AI in between. aiNearRadiusKm = 0 updates no AI
+   * in between. */
+  void setAiUpdateRate(unsigned int aiUpdateRateMs, int aiNearRadiusKmParam)
+  {
+    aiUpdateRate = aiUpdateRateMs;
+    aiNearRadiusKm = aiNearRadiusKmParam;
+  }
+
   /* If simulator connection is lost try to reconnect every reconnectSec seconds. */
   void setReconnectRateSec(int reconnectSec)
   {
@@ -121,7 +135,8 @@ public:
 
   bool canFetchWeather() const;
 
-  /* Sets a one shot request to fetch on next iteration */
+  /* Adds a request to the batch fetched on next iteration. Identical requests are merged and answered from a cache
+   * if possible. All results of a batch are sent in one weather reply. */
   void setWeatherRequest(atools::fs::sc::WeatherRequest request);
 
   void setSimconnectOptions(atools::fs::sc::Options value)
@@ -143,10 +158,21 @@ public:
     return handler;
   }
 
+  /* Ring buffer getting all packets from the simulator or replay. Weather replies from setWeatherRequest() are only
+   * sent by postSimConnectData(). Read it after receiving simConnectDataAvailable() in the consumer thread. */
+  atools::fs::sc::SimConnectDataBuffer *getDataBuffer() const
+  {
+    return dataBuffer;
+  }
+
 signals:
   /* Send on each received data package from the simconnect interface */
   void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
 
+  /* Sent once new data was written to the ring buffer and the consumer has read all packets notified before.
+   * Use instead of a queued connection to postSimConnectData() to avoid copying and queueing each packet. */
+  void simConnectDataAvailable();
+
   /* Only used in Navconnect */
   void postLogMessage(QString messge, bool warning, bool error);
 
@@ -165,10 +191,20 @@ private:
   void setupReplay();
   bool fetchData(atools::fs::sc::SimConnectData& data, int radiusKm, atools::fs::sc::Options fetchOptions);
 
+  /* Add AI from the last full update which are outside of the near radius and not in data */
+  void mergeDistantAiAircraft(atools::fs::sc::SimConnectData& data);
+
+  /* Emit signal and write packet to ring buffer */
+  void postData(const atools::fs::sc::SimConnectData& data);
+
   /* Updates whazzup.txt file in given folder during replay */
   void debugWriteWhazzup(const atools::fs::sc::SimConnectData& dataPacket);
 
   atools::fs::sc::ConnectHandler *handler = nullptr;
+  atools::fs::sc::SimConnectDataBuffer *dataBuffer = nullptr;
+
+  /* Collects and caches weather requests from all clients. Protected by handlerMutex. */
+  atools::fs::sc::WeatherRequestBroker *weatherBroker = nullptr;
 
   /* Have to protect options since they will be modified from outside the thread */
   std::atomic<atools::fs::sc::Options> options;
@@ -181,18 +217,28 @@ private:
   int numErrors = 0;
   const int MAX_NUMBER_OF_ERRORS = 10;
 
-  const quint32 REPLAY_FILE_MAGIC_NUMBER = 0XCACF4F27;
-  const quint32 REPLAY_FILE_VERSION = 1;
-  const int REPLAY_FILE_DATA_START_OFFSET = sizeof(REPLAY_FILE_MAGIC_NUMBER) + sizeof(REPLAY_FILE_VERSION) +
-                                            sizeof(quint32);
-
   QString saveReplayFilepath, loadReplayFilepath, replayWhazzupFile;
   int replaySpeed = 1, whazzupUpdateSeconds = 15;
-  QFile *saveReplayFile = nullptr, *loadReplayFile = nullptr;
+  atools::fs::sc::ReplayWriter *replayWriter = nullptr;
+  atools::fs::sc::ReplayReader *replayReader = nullptr;
   quint32 replayUpdateRateMs = 500;
 
+  /* Number of frames to advance per iteration for high replay speeds */
+  int replaySkipFrames = 1;
+
   bool terminate = false, verbose = false, failedTerminally = false;
   unsigned int updateRate = 500;
+
+  /* Wait time if simulator is paused or does not deliver data */
+  const unsigned int IDLE_UPDATE_RATE_MS = 1000;
+
+  /* Adaptive AI update rate */
+  unsigned int aiUpdateRate = 0;
+  int aiNearRadiusKm = 0;
+  QElapsedTimer aiUpdateTimer;
+
+  /* AI aircraft from the last update including distant ones */
+  QVector<atools::fs::sc::SimConnectAircraft> lastAiAircraft;
   int reconnectRateSec = 10;
   bool connected = false, reconnecting = false;
 
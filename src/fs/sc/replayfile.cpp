@@ -0,0 +1,378 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/replayfile.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+static const quint32 REPLAY_FILE_MAGIC_NUMBER = 0XCACF4F27;
+static const quint32 REPLAY_FILE_VERSION_1 = 1;
+static const quint32 REPLAY_FILE_VERSION_2 = 2;
+static const quint32 REPLAY_BLOCK_MAGIC_NUMBER = 0x4B4C4252;
+static const quint32 REPLAY_INDEX_MAGIC_NUMBER = 0x58444952;
+
+/* Magic number, version and update rate */
+static const qint64 REPLAY_FILE_DATA_START_OFFSET = 3 * sizeof(quint32);
+
+/* Magic number, number of frames and compressed size */
+static const qint64 REPLAY_BLOCK_HEADER_SIZE = 3 * sizeof(quint32);
+
+/* Index offset, number of blocks and magic number */
+static const qint64 REPLAY_TRAILER_SIZE = sizeof(quint64) + 2 * sizeof(quint32);
+
+/* About 30 seconds for the default update rate */
+static const int REPLAY_FRAMES_PER_BLOCK = 60;
+
+/* Decode the next packet in device using lastFrame as base for deltas and update lastFrame */
+static bool readFrame(QIODevice *device, SimConnectData& data, SimConnectData *& lastFrame)
+{
+  if(!data.read(device, lastFrame))
+    return false;
+
+  delete lastFrame;
+  lastFrame = new SimConnectData(data);
+  return true;
+}
+
+// ==============================================================================================
+ReplayWriter::ReplayWriter(const QString& filename, quint32 updateRateMs)
+  : file(filename), updateRate(updateRateMs)
+{
+}
+
+ReplayWriter::~ReplayWriter()
+{
+  close();
+}
+
+bool ReplayWriter::open()
+{
+  if(!file.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream out(&file);
+  out << REPLAY_FILE_MAGIC_NUMBER << REPLAY_FILE_VERSION_2 << updateRate;
+  return true;
+}
+
+void ReplayWriter::write(const SimConnectData& data)
+{
+  if(!file.isOpen())
+    return;
+
+  if(blockFrames == 0 || lastFrame == nullptr)
+  {
+    // Key frame at start of each block
+    blockBytes.append(data.writeToBytes());
+    delete lastFrame;
+    lastFrame = new SimConnectData(data);
+  }
+  else
+  {
+    QByteArray delta = data.writeDeltaToBytes(*lastFrame);
+
+    // Decode own delta to get the same base as the reader
+    QBuffer buffer(&delta);
+    buffer.open(QIODevice::ReadOnly);
+    SimConnectData decoded;
+    if(!readFrame(&buffer, decoded, lastFrame))
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot decode delta" << decoded.getStatusText();
+      return;
+    }
+    blockBytes.append(delta);
+  }
+
+  blockFrames++;
+  numFrames++;
+
+  if(blockFrames >= REPLAY_FRAMES_PER_BLOCK)
+    writeBlock();
+}
+
+void ReplayWriter::writeBlock()
+{
+  if(blockFrames == 0)
+    return;
+
+  QByteArray compressed = qCompress(blockBytes);
+
+  ReplayBlock block;
+  block.offset = file.pos();
+  block.firstFrame = numFrames - blockFrames;
+  block.numFrames = blockFrames;
+  index.append(block);
+
+  QDataStream out(&file);
+  out << REPLAY_BLOCK_MAGIC_NUMBER << static_cast<quint32>(blockFrames) << static_cast<quint32>(compressed.size());
+  out.writeRawData(compressed.constData(), compressed.size());
+  file.flush();
+
+  blockBytes.clear();
+  blockFrames = 0;
+  delete lastFrame;
+  lastFrame = nullptr;
+}
+
+void ReplayWriter::close()
+{
+  if(file.isOpen())
+  {
+    writeBlock();
+
+    // Write index and trailer
+    quint64 indexOffset = static_cast<quint64>(file.pos());
+    QDataStream out(&file);
+    for(const ReplayBlock& block : qAsConst(index))
+      out << static_cast<quint64>(block.offset) << static_cast<quint32>(block.firstFrame)
+          << static_cast<quint32>(block.numFrames);
+    out << indexOffset << static_cast<quint32>(index.size()) << REPLAY_INDEX_MAGIC_NUMBER;
+
+    file.close();
+  }
+
+  delete lastFrame;
+  lastFrame = nullptr;
+  index.clear();
+}
+
+// ==============================================================================================
+ReplayReader::ReplayReader(const QString& filename)
+  : file(filename)
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+  close();
+}
+
+bool ReplayReader::open()
+{
+  close();
+
+  if(file.size() <= REPLAY_FILE_DATA_START_OFFSET)
+  {
+    errorString = tr("File is too small");
+    return false;
+  }
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    errorString = file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magicNumber;
+  in >> magicNumber >> version >> updateRate;
+  if(magicNumber != REPLAY_FILE_MAGIC_NUMBER)
+  {
+    errorString = tr("Is not a replay file - wrong magic number");
+    close();
+    return false;
+  }
+
+  if(version == REPLAY_FILE_VERSION_2)
+  {
+    if(!readIndex())
+      scanBlocks();
+
+    if(index.isEmpty())
+    {
+      errorString = tr("No data");
+      close();
+      return false;
+    }
+
+    numFrames = index.constLast().firstFrame + index.constLast().numFrames;
+    qDebug() << Q_FUNC_INFO << file.fileName() << "blocks" << index.size() << "frames" << numFrames;
+  }
+  else if(version != REPLAY_FILE_VERSION_1)
+  {
+    errorString = tr("Wrong version");
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void ReplayReader::close()
+{
+  file.close();
+  blockBuffer.close();
+  blockBytes.clear();
+  delete lastFrame;
+  lastFrame = nullptr;
+  index.clear();
+  numFrames = -1;
+  currentFrame = 0;
+  currentBlock = -1;
+}
+
+bool ReplayReader::readIndex()
+{
+  if(file.size() < REPLAY_FILE_DATA_START_OFFSET + REPLAY_TRAILER_SIZE)
+    return false;
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  file.seek(file.size() - REPLAY_TRAILER_SIZE);
+  quint64 indexOffset;
+  quint32 numBlocks, magicNumber;
+  in >> indexOffset >> numBlocks >> magicNumber;
+
+  if(magicNumber != REPLAY_INDEX_MAGIC_NUMBER || indexOffset < static_cast<quint64>(REPLAY_FILE_DATA_START_OFFSET) ||
+     indexOffset + numBlocks * 16ULL + REPLAY_TRAILER_SIZE != static_cast<quint64>(file.size()))
+    return false;
+
+  file.seek(static_cast<qint64>(indexOffset));
+  for(quint32 i = 0; i < numBlocks; i++)
+  {
+    quint64 offset;
+    quint32 firstFrame, frames;
+    in >> offset >> firstFrame >> frames;
+    index.append({static_cast<qint64>(offset), static_cast<int>(firstFrame), static_cast<int>(frames)});
+  }
+  return in.status() == QDataStream::Ok;
+}
+
+void ReplayReader::scanBlocks()
+{
+  // Recording was interrupted - collect block headers
+  qInfo() << Q_FUNC_INFO << file.fileName() << "No index found. Scanning.";
+  index.clear();
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  int frames = 0;
+  qint64 offset = REPLAY_FILE_DATA_START_OFFSET;
+  while(offset + REPLAY_BLOCK_HEADER_SIZE <= file.size())
+  {
+    file.seek(offset);
+    quint32 magicNumber, blockFrames, compressedSize;
+    in >> magicNumber >> blockFrames >> compressedSize;
+
+    if(magicNumber != REPLAY_BLOCK_MAGIC_NUMBER || offset + REPLAY_BLOCK_HEADER_SIZE + compressedSize > file.size())
+      break;
+
+    index.append({offset, frames, static_cast<int>(blockFrames)});
+    frames += static_cast<int>(blockFrames);
+    offset += REPLAY_BLOCK_HEADER_SIZE + compressedSize;
+  }
+}
+
+bool ReplayReader::loadBlock(int blockIndex)
+{
+  const ReplayBlock& block = index.at(blockIndex);
+
+  file.seek(block.offset);
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magicNumber, blockFrames, compressedSize;
+  in >> magicNumber >> blockFrames >> compressedSize;
+  if(magicNumber != REPLAY_BLOCK_MAGIC_NUMBER)
+    return false;
+
+  blockBuffer.close();
+  blockBytes = qUncompress(file.read(compressedSize));
+  blockBuffer.setBuffer(&blockBytes);
+  blockBuffer.open(QIODevice::ReadOnly);
+
+  // Block starts with a key frame
+  delete lastFrame;
+  lastFrame = nullptr;
+
+  currentBlock = blockIndex;
+  currentFrame = block.firstFrame;
+  return !blockBytes.isEmpty();
+}
+
+bool ReplayReader::readNext(SimConnectData& data)
+{
+  if(!file.isOpen())
+    return false;
+
+  if(version == REPLAY_FILE_VERSION_1)
+  {
+    // Plain packet sequence
+    if(file.atEnd())
+      file.seek(REPLAY_FILE_DATA_START_OFFSET);
+
+    bool ok = data.read(&file);
+    currentFrame++;
+    return ok && data.getStatus() == OK;
+  }
+
+  if(currentBlock == -1 || blockBuffer.atEnd())
+  {
+    // Load next block and wrap around at the end
+    int next = currentBlock + 1 < index.size() ? currentBlock + 1 : 0;
+    if(!loadBlock(next))
+      return false;
+  }
+
+  if(!readFrame(&blockBuffer, data, lastFrame))
+    return false;
+
+  currentFrame++;
+  return data.getStatus() == OK;
+}
+
+bool ReplayReader::seekFrame(int frame)
+{
+  if(version != REPLAY_FILE_VERSION_2 || frame < 0 || frame >= numFrames)
+    return false;
+
+  // Blocks have a fixed size except the last one
+  int blockIndex = std::min(frame / REPLAY_FRAMES_PER_BLOCK, static_cast<int>(index.size()) - 1);
+  while(blockIndex > 0 && index.at(blockIndex).firstFrame > frame)
+    blockIndex--;
+  while(blockIndex < index.size() - 1 && index.at(blockIndex + 1).firstFrame <= frame)
+    blockIndex++;
+
+  if(!loadBlock(blockIndex))
+    return false;
+
+  // Decode frames up to the requested one
+  while(currentFrame < frame)
+  {
+    SimConnectData data;
+    if(!readFrame(&blockBuffer, data, lastFrame))
+      return false;
+    currentFrame++;
+  }
+  return true;
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
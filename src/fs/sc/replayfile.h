@@ -0,0 +1,176 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_REPLAYFILE_H
+#define ATOOLS_FS_SC_REPLAYFILE_H
+
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+
+/*
+ * Replay file format for recorded simulator data.
+ *
+ * Header: magic number, file version and update rate in milliseconds.
+ *
+ * Version 1 is a plain sequence of full SimConnectData packets after the header.
+ *
+ * Version 2 consists of zlib compressed blocks of REPLAY_FRAMES_PER_BLOCK frames. Each block starts with a full
+ * packet as key frame followed by delta packets which can only be decoded in sequence.
+ * Block header is magic number, number of frames and compressed size.
+ * An index of all blocks and a trailer is appended when closing the file. The index is rebuilt by scanning block
+ * headers if the trailer is missing since recording was interrupted.
+ */
+
+/* Index entry for a compressed block */
+struct ReplayBlock
+{
+  qint64 offset; /* File offset of block header */
+  int firstFrame, numFrames;
+};
+
+/* Writes replay files in version 2 format */
+class ReplayWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(ReplayWriter)
+
+public:
+  explicit ReplayWriter(const QString& filename, quint32 updateRateMs);
+  ~ReplayWriter();
+
+  ReplayWriter(const ReplayWriter& other) = delete;
+  ReplayWriter& operator=(const ReplayWriter& other) = delete;
+
+  /* Create file and write header. Returns false on error. */
+  bool open();
+
+  /* Append a simulator packet. Weather replies should not be recorded. */
+  void write(const atools::fs::sc::SimConnectData& data);
+
+  /* Write pending block, index and trailer */
+  void close();
+
+  QString getErrorString() const
+  {
+    return file.errorString();
+  }
+
+  bool isOpen() const
+  {
+    return file.isOpen();
+  }
+
+private:
+  void writeBlock();
+
+  QFile file;
+  quint32 updateRate;
+
+  /* Uncompressed frames of the current block */
+  QByteArray blockBytes;
+  int blockFrames = 0, numFrames = 0;
+
+  /* Last frame as decoded by a reader. Base for delta frames. */
+  atools::fs::sc::SimConnectData *lastFrame = nullptr;
+
+  QVector<ReplayBlock> index;
+};
+
+/* Reads replay files in version 1 and 2 format. Playback wraps around at the end of the file. */
+class ReplayReader
+{
+  Q_DECLARE_TR_FUNCTIONS(ReplayReader)
+
+public:
+  explicit ReplayReader(const QString& filename);
+  ~ReplayReader();
+
+  ReplayReader(const ReplayReader& other) = delete;
+  ReplayReader& operator=(const ReplayReader& other) = delete;
+
+  /* Open file and read header and index. Returns false and sets error message on error. */
+  bool open();
+  void close();
+
+  /* Read next frame into an empty data object. Starts from the beginning after the last frame.
+   * Returns false on error. Status of data has details. */
+  bool readNext(atools::fs::sc::SimConnectData& data);
+
+  /* Position reader so that the next call to readNext() returns the given frame. Only for version 2.
+   * Needs to decode at most one block. */
+  bool seekFrame(int frame);
+
+  /* Number of frames or -1 if unknown for version 1 files */
+  int getNumFrames() const
+  {
+    return numFrames;
+  }
+
+  /* Index of the frame returned by the next call to readNext() */
+  int getCurrentFrame() const
+  {
+    return currentFrame;
+  }
+
+  quint32 getUpdateRateMs() const
+  {
+    return updateRate;
+  }
+
+  quint32 getVersion() const
+  {
+    return version;
+  }
+
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+private:
+  bool readIndex();
+  void scanBlocks();
+  bool loadBlock(int blockIndex);
+
+  QFile file;
+  QString errorString;
+  quint32 version = 0, updateRate = 500;
+  int numFrames = -1, currentFrame = 0, currentBlock = -1;
+
+  /* Uncompressed data of the current block */
+  QByteArray blockBytes;
+  QBuffer blockBuffer;
+
+  /* Last decoded frame used as base for delta frames */
+  atools::fs::sc::SimConnectData *lastFrame = nullptr;
+
+  QVector<ReplayBlock> index;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_REPLAYFILE_H
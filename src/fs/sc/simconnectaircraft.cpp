@@ -24,7 +24,27 @@ namespace atools {
 namespace fs {
 namespace sc {
 
+/* Shared by all default constructed aircraft to avoid allocations */
+static const QSharedDataPointer<SimConnectAircraftInfo>& emptyInfo()
+{
+  static const QSharedDataPointer<SimConnectAircraftInfo> EMPTY_INFO(new SimConnectAircraftInfo);
+  return EMPTY_INFO;
+}
+
+bool SimConnectAircraftInfo::operator==(const SimConnectAircraftInfo& other) const
+{
+  return airplaneTitle == other.airplaneTitle &&
+         airplaneType == other.airplaneType &&
+         airplaneModel == other.airplaneModel &&
+         airplaneReg == other.airplaneReg &&
+         airplaneAirline == other.airplaneAirline &&
+         airplaneFlightnumber == other.airplaneFlightnumber &&
+         fromIdent == other.fromIdent &&
+         toIdent == other.toIdent;
+}
+
 SimConnectAircraft::SimConnectAircraft()
+  : info(emptyInfo())
 {
 
 }
@@ -48,14 +68,19 @@ void SimConnectAircraft::read(QDataStream& in)
 
   if(!(dataFlags & DATA_STRINGS_OMITTED))
   {
-    readString(in, airplaneTitle);
-    readString(in, airplaneModel);
-    readString(in, airplaneReg);
-    readString(in, airplaneType);
-    readString(in, airplaneAirline);
-    readString(in, airplaneFlightnumber);
-    readString(in, fromIdent);
-    readString(in, toIdent);
+    SimConnectAircraftInfo newInfo;
+    readString(in, newInfo.airplaneTitle);
+    readString(in, newInfo.airplaneModel);
+    readString(in, newInfo.airplaneReg);
+    readString(in, newInfo.airplaneType);
+    readString(in, newInfo.airplaneAirline);
+    readString(in, newInfo.airplaneFlightnumber);
+    readString(in, newInfo.fromIdent);
+    readString(in, newInfo.toIdent);
+
+    // Keep shared record if reading into an aircraft with the same names, e.g. when decoding delta packets
+    if(newInfo != *info.constData())
+      info = new SimConnectAircraftInfo(newInfo);
   }
 
   float lonx, laty, altitude;
@@ -110,14 +135,14 @@ void SimConnectAircraft::write(QDataStream& out) const
 
   if(!(dataFlags & DATA_STRINGS_OMITTED))
   {
-    writeString(out, airplaneTitle);
-    writeString(out, airplaneModel);
-    writeString(out, airplaneReg);
-    writeString(out, airplaneType);
-    writeString(out, airplaneAirline);
-    writeString(out, airplaneFlightnumber);
-    writeString(out, fromIdent);
-    writeString(out, toIdent);
+    writeString(out, info->airplaneTitle);
+    writeString(out, info->airplaneModel);
+    writeString(out, info->airplaneReg);
+    writeString(out, info->airplaneType);
+    writeString(out, info->airplaneAirline);
+    writeString(out, info->airplaneFlightnumber);
+    writeString(out, info->fromIdent);
+    writeString(out, info->toIdent);
   }
 
   out << position.getLonX() << position.getLatY() << position.getAltitude() << headingTrueDeg << headingMagDeg
@@ -137,21 +162,25 @@ int SimConnectAircraft::getId() const
 
 bool SimConnectAircraft::isSameAircraft(const SimConnectAircraft& other) const
 {
-  return airplaneTitle == other.airplaneTitle &&
-         airplaneModel == other.airplaneModel &&
-         airplaneReg == other.airplaneReg &&
-         airplaneType == other.airplaneType &&
-         airplaneAirline == other.airplaneAirline &&
-         airplaneFlightnumber == other.airplaneFlightnumber;
+  if(info == other.info)
+    return true;
+
+  return info->airplaneTitle == other.info->airplaneTitle &&
+         info->airplaneModel == other.info->airplaneModel &&
+         info->airplaneReg == other.info->airplaneReg &&
+         info->airplaneType == other.info->airplaneType &&
+         info->airplaneAirline == other.info->airplaneAirline &&
+         info->airplaneFlightnumber == other.info->airplaneFlightnumber;
 }
 
 void SimConnectAircraft::updateAircraftNames(const QString& airplaneTypeParam, const QString& airplaneAirlineParam,
                                              const QString& airplaneTitleParam, const QString& airplaneModelParam)
 {
-  airplaneType = airplaneTypeParam;
-  airplaneAirline = airplaneAirlineParam;
-  airplaneTitle = airplaneTitleParam;
-  airplaneModel = airplaneModelParam;
+  SimConnectAircraftInfo *i = info.data();
+  i->airplaneType = airplaneTypeParam;
+  i->airplaneAirline = airplaneAirlineParam;
+  i->airplaneTitle = airplaneTitleParam;
+  i->airplaneModel = airplaneModelParam;
 }
 
 } // namespace sc
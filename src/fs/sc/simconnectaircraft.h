@@ -22,6 +22,7 @@
 #include "fs/sc/simconnectdatabase.h"
 #include "util/props.h"
 
+#include <QSharedData>
 #include <QString>
 
 class QIODevice;
@@ -42,6 +43,7 @@ namespace sc {
 class SimConnectHandler;
 class SimConnectHandlerPrivate;
 class SimConnectData;
+class XpConnectRing;
 
 enum Category : quint8
 {
@@ -82,8 +84,30 @@ enum SimConnectAircraftPropTypes
   PROP_XPCONNECT_VERSION
 };
 
+/*
+ * Rarely changing names and identifiers of an aircraft. Implicitly shared between copies of an aircraft and
+ * between packets as long as nothing changes.
+ */
+struct SimConnectAircraftInfo
+  : public QSharedData
+{
+  /* Compares all except the derived registration key */
+  bool operator==(const SimConnectAircraftInfo& other) const;
+
+  bool operator!=(const SimConnectAircraftInfo& other) const
+  {
+    return !operator==(other);
+  }
+
+  QString airplaneTitle, airplaneType, airplaneModel, airplaneReg, airplaneRegKey,
+          airplaneAirline, airplaneFlightnumber, fromIdent, toIdent;
+};
+
 /*
  * Base aircraft that is used to transfer across network links. For user and AI aircraft.
+ *
+ * Per tick flight data is kept in plain members while all strings are in a shared SimConnectAircraftInfo record.
+ * Copying an aircraft therefore copies only a single pointer for the strings.
  */
 class SimConnectAircraft :
   public SimConnectDataBase
@@ -100,46 +124,46 @@ public:
   /* Mooney, Boeing, Actually aircraft model. */
   const QString& getAirplaneType() const
   {
-    return airplaneType;
+    return info->airplaneType;
   }
 
   const QString& getAirplaneAirline() const
   {
-    return airplaneAirline;
+    return info->airplaneAirline;
   }
 
   const QString& getAirplaneFlightnumber() const
   {
-    return airplaneFlightnumber;
+    return info->airplaneFlightnumber;
   }
 
   /* Beech Baron 58 Paint 1 */
   const QString& getAirplaneTitle() const
   {
-    return airplaneTitle;
+    return info->airplaneTitle;
   }
 
   /* ICAO aircraft designator: MD80, BE58, etc. */
   const QString& getAirplaneModel() const
   {
-    return airplaneModel;
+    return info->airplaneModel;
   }
 
   void setAirplaneModel(const QString& value)
   {
-    airplaneModel = value;
+    info->airplaneModel = value;
   }
 
   /* N71FS */
   const QString& getAirplaneRegistration() const
   {
-    return airplaneReg;
+    return info->airplaneReg;
   }
 
   /* "dedfs" for "D-EDFS" */
   const QString& getAirplaneRegistrationKey() const
   {
-    return airplaneRegKey;
+    return info->airplaneRegKey;
   }
 
   /* Includes actual altitude in feet */
@@ -157,9 +181,9 @@ public:
   /* More accurate optional position as double */
   atools::geo::PosD getPositionD() const
   {
-    if(properties.contains(PROP_AIRCRAFT_LONX) && properties.contains(PROP_AIRCRAFT_LATY))
-      return atools::geo::PosD(properties.value(PROP_AIRCRAFT_LONX).getValueDouble(),
-                               properties.value(PROP_AIRCRAFT_LATY).getValueDouble(), position.getAltitude());
+    const atools::util::Prop *lonx = properties.find(PROP_AIRCRAFT_LONX), *laty = properties.find(PROP_AIRCRAFT_LATY);
+    if(lonx != nullptr && laty != nullptr)
+      return atools::geo::PosD(lonx->getValueDouble(), laty->getValueDouble(), position.getAltitude());
     else
       return atools::geo::PosD(position);
   }
@@ -297,12 +321,12 @@ public:
 
   const QString& getFromIdent() const
   {
-    return fromIdent;
+    return info->fromIdent;
   }
 
   const QString& getToIdent() const
   {
-    return toIdent;
+    return info->toIdent;
   }
 
   bool isOnGround() const
@@ -430,14 +454,17 @@ public:
   /* For debugging purposes */
   void setAirplaneRegistration(const QString& value)
   {
-    airplaneReg = value;
+    info->airplaneReg = value;
   }
 
   /* "dedfs" for "D-EDFS" not transferred in stream. Needs to be updated after loading in client.
    *  Used to match aircraft from sim/online. */
   void updateAirplaneRegistrationKey()
   {
-    airplaneRegKey = airplaneRegistrationToKey(airplaneReg);
+    // Detach only if changed
+    QString key = airplaneRegistrationToKey(info.constData()->airplaneReg);
+    if(key != info.constData()->airplaneRegKey)
+      info->airplaneRegKey = key;
   }
 
   /* Converts "D-EDFS" to "dedfs" */
@@ -450,12 +477,13 @@ private:
   friend class atools::fs::sc::SimConnectHandler;
   friend class atools::fs::sc::SimConnectHandlerPrivate;
   friend class atools::fs::sc::SimConnectData;
+  friend class atools::fs::sc::XpConnectRing;
   friend class xpc::XpConnect;
   friend class xpc::AircraftFileLoader;
   friend class atools::fs::online::OnlinedataManager;
 
-  QString airplaneTitle, airplaneType, airplaneModel, airplaneReg, airplaneRegKey,
-          airplaneAirline, airplaneFlightnumber, fromIdent, toIdent;
+  /* Names and identifiers. Use constData() for reading in non const methods to avoid detaching. */
+  QSharedDataPointer<SimConnectAircraftInfo> info;
 
   // Altitude field in pos is actual altitude
   atools::geo::Pos position;
@@ -18,10 +18,12 @@
 #include "fs/sc/simconnectdata.h"
 
 #include "geo/calculations.h"
+#include "atools.h"
 
 #include <QDebug>
 #include <QDataStream>
 #include <QIODevice>
+#include <QSet>
 
 using atools::fs::weather::MetarResult;
 
@@ -29,6 +31,8 @@ namespace atools {
 namespace fs {
 namespace sc {
 
+Q_DECL_CONSTEXPR float SimConnectData::DELTA_POS_QUANT;
+
 SimConnectData::SimConnectData()
 {
 
@@ -44,7 +48,7 @@ SimConnectData::~SimConnectData()
 
 }
 
-bool SimConnectData::read(QIODevice *ioDevice)
+bool SimConnectData::read(QIODevice *ioDevice, const SimConnectData *baseData)
 {
   status = OK;
 
@@ -79,7 +83,7 @@ bool SimConnectData::read(QIODevice *ioDevice)
     return false;
 
   in >> version;
-  if(version != DATA_VERSION)
+  if(version != DATA_VERSION && version != DATA_VERSION_DELTA)
   {
     qWarning() << "SimConnectData::read: version mismatch" << version << "!=" << DATA_VERSION;
     status = VERSION_MISMATCH;
@@ -91,20 +95,91 @@ bool SimConnectData::read(QIODevice *ioDevice)
   in >> ts;
   packetTs = QDateTime::fromSecsSinceEpoch(ts, Qt::UTC);
 
+  quint32 basePacketId = 0;
+  if(version == DATA_VERSION_DELTA)
+  {
+    in >> basePacketId;
+
+    if(baseData == nullptr || basePacketId == 0 || baseData->packetId != basePacketId)
+    {
+      // Skip rest of packet - size includes version, packet id, timestamp and base id
+      qWarning() << "SimConnectData::read: base packet missing" << basePacketId;
+      ioDevice->skip(packetSize - static_cast<qint64>(sizeof(quint32) * 4));
+      status = DELTA_BASE_MISSING;
+      return false;
+    }
+  }
+
   quint8 hasUser = 0;
   in >> hasUser;
   if(hasUser == 1)
     userAircraft.read(in);
 
-  quint16 numAi = 0;
-  in >> numAi;
-  for(quint16 i = 0; i < numAi; i++)
+  if(version == DATA_VERSION_DELTA)
   {
-    SimConnectAircraft ap;
-    ap.read(in);
-    aiAircraft.append(ap);
+    // Removed aircraft
+    quint16 numRemoved = 0;
+    in >> numRemoved;
+    QSet<quint32> removedIds;
+    for(quint16 i = 0; i < numRemoved; i++)
+    {
+      quint32 id;
+      in >> id;
+      removedIds.insert(id);
+    }
+
+    // Copy remaining aircraft from base
+    QHash<quint32, int> idIndex;
+    for(const SimConnectAircraft& aircraft : baseData->aiAircraft)
+    {
+      if(!removedIds.contains(aircraft.objectId))
+      {
+        idIndex.insert(aircraft.objectId, aiAircraft.size());
+        aiAircraft.append(aircraft);
+      }
+    }
+
+    // Added and changed aircraft
+    quint16 numChanged = 0;
+    in >> numChanged;
+    for(quint16 i = 0; i < numChanged; i++)
+    {
+      quint32 id;
+      quint8 delta;
+      in >> id >> delta;
+
+      int index = idIndex.value(id, -1);
+      if(index == -1)
+      {
+        // New aircraft - always sent in full
+        index = aiAircraft.size();
+        idIndex.insert(id, index);
+        aiAircraft.append(SimConnectAircraft());
+      }
+
+      readAircraftDelta(in, aiAircraft[index], delta);
+      aiAircraft[index].objectId = id;
+    }
   }
+  else
+  {
+    quint16 numAi = 0;
+    in >> numAi;
+    for(quint16 i = 0; i < numAi; i++)
+    {
+      SimConnectAircraft ap;
+      ap.read(in);
+      aiAircraft.append(ap);
+    }
+  }
+
+  readMetars(in);
 
+  return true;
+}
+
+void SimConnectData::readMetars(QDataStream& in)
+{
   quint16 numMetar = 0;
   in >> numMetar;
   for(quint16 i = 0; i < numMetar; i++)
@@ -127,20 +202,53 @@ bool SimConnectData::read(QIODevice *ioDevice)
 
     metarResults.append(result);
   }
+}
 
-  return true;
+void SimConnectData::writeMetars(QDataStream& out) const
+{
+  qsizetype numMetar = std::min(static_cast<qsizetype>(65535), static_cast<qsizetype>(metarResults.size()));
+  out << static_cast<quint16>(numMetar);
+
+  for(int i = 0; i < numMetar; i++)
+  {
+    const MetarResult& result = metarResults.at(i);
+    writeString(out, result.requestIdent);
+    out << result.requestPos.getLonX() << result.requestPos.getLatY() << result.requestPos.getAltitude()
+        << static_cast<quint32>(result.timestamp.toSecsSinceEpoch());
+    writeLongString(out, result.metarForStation);
+    writeLongString(out, result.metarForNearest);
+    writeLongString(out, result.metarForInterpolated);
+  }
 }
 
 int SimConnectData::write(QIODevice *ioDevice)
 {
   status = OK;
+  return SimConnectDataBase::writeBlock(ioDevice, writeToBytes(), status);
+}
 
+void SimConnectData::writeHeader(QDataStream& out, quint32 dataVersion) const
+{
+  out << MAGIC_NUMBER_DATA << packetSize << dataVersion << packetId
+      << static_cast<quint32>(packetTs.toSecsSinceEpoch());
+}
+
+void SimConnectData::finishBlock(QDataStream& out, QByteArray& block)
+{
+  // Go back and update size
+  out.device()->seek(sizeof(MAGIC_NUMBER_DATA));
+  int size = block.size() - static_cast<int>(sizeof(quint32)) - static_cast<int>(sizeof(MAGIC_NUMBER_DATA));
+  out << static_cast<quint32>(size);
+}
+
+QByteArray SimConnectData::writeToBytes() const
+{
   QByteArray block;
   QDataStream out(&block, QIODevice::WriteOnly);
   out.setVersion(QDataStream::Qt_5_5);
   out.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-  out << MAGIC_NUMBER_DATA << packetSize << DATA_VERSION << packetId << static_cast<quint32>(packetTs.toSecsSinceEpoch());
+  writeHeader(out, DATA_VERSION);
 
   bool userValid = userAircraft.getPosition().isValid();
   out << static_cast<quint8>(userValid);
@@ -153,26 +261,278 @@ int SimConnectData::write(QIODevice *ioDevice)
   for(int i = 0; i < numAi; i++)
     aiAircraft.at(i).write(out);
 
-  qsizetype numMetar = std::min(static_cast<qsizetype>(65535), static_cast<qsizetype>(metarResults.size()));
-  out << static_cast<quint16>(numMetar);
+  writeMetars(out);
+  finishBlock(out, block);
 
-  for(int i = 0; i < numMetar; i++)
+  return block;
+}
+
+QByteArray SimConnectData::writeDeltaToBytes(const SimConnectData& baseData) const
+{
+  QByteArray block;
+  QDataStream out(&block, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  writeHeader(out, DATA_VERSION_DELTA);
+  out << baseData.packetId;
+
+  bool userValid = userAircraft.getPosition().isValid();
+  out << static_cast<quint8>(userValid);
+  if(userValid)
+    userAircraft.write(out);
+
+  // Limit number of aircraft as for full packets
+  int numAi = std::min(65535, static_cast<int>(aiAircraft.size()));
+  QHash<quint32, int> idIndex;
+  for(int i = 0; i < numAi; i++)
+    idIndex.insert(aiAircraft.at(i).objectId, i);
+
+  // Removed aircraft ==============================
+  QVector<quint32> removedIds;
+  QHash<quint32, int> baseIdIndex;
+  for(int i = 0; i < baseData.aiAircraft.size(); i++)
   {
-    const MetarResult& result = metarResults.at(i);
-    writeString(out, result.requestIdent);
-    out << result.requestPos.getLonX() << result.requestPos.getLatY() << result.requestPos.getAltitude()
-        << static_cast<quint32>(result.timestamp.toSecsSinceEpoch());
-    writeLongString(out, result.metarForStation);
-    writeLongString(out, result.metarForNearest);
-    writeLongString(out, result.metarForInterpolated);
+    quint32 id = baseData.aiAircraft.at(i).objectId;
+    if(idIndex.contains(id))
+      baseIdIndex.insert(id, i);
+    else
+      removedIds.append(id);
   }
 
-  // Go back and update size
-  out.device()->seek(sizeof(MAGIC_NUMBER_DATA));
-  int size = block.size() - static_cast<int>(sizeof(packetSize)) - static_cast<int>(sizeof(MAGIC_NUMBER_DATA));
-  out << static_cast<quint32>(size);
+  out << static_cast<quint16>(std::min(65535, static_cast<int>(removedIds.size())));
+  for(int i = 0; i < removedIds.size() && i < 65535; i++)
+    out << removedIds.at(i);
+
+  // Added and changed aircraft ==============================
+  QVector<std::pair<int, quint8> > changed;
+  for(int i = 0; i < numAi; i++)
+  {
+    const SimConnectAircraft& aircraft = aiAircraft.at(i);
+    int baseIndex = baseIdIndex.value(aircraft.objectId, -1);
+
+    quint8 delta = baseIndex == -1 ? DELTA_FULL : aircraftDelta(aircraft, baseData.aiAircraft.at(baseIndex));
+    if(delta != 0)
+      changed.append(std::make_pair(i, delta));
+  }
+
+  out << static_cast<quint16>(changed.size());
+  for(const std::pair<int, quint8>& change : changed)
+  {
+    const SimConnectAircraft& aircraft = aiAircraft.at(change.first);
+    int baseIndex = baseIdIndex.value(aircraft.objectId, -1);
+
+    out << aircraft.objectId << change.second;
+    writeAircraftDelta(out, aircraft, baseIndex == -1 ? EMPTY_SIMCONNECT_AIRCRAFT : baseData.aiAircraft.at(baseIndex),
+                       change.second);
+  }
+
+  writeMetars(out);
+  finishBlock(out, block);
+
+  return block;
+}
+
+/* Append string as JSON string literal */
+static void appendJsonString(QByteArray& json, const QString& str)
+{
+  QString escaped;
+  escaped.reserve(str.size() + 2);
+  for(QChar c : str)
+  {
+    if(c == '"' || c == '\\')
+      escaped.append('\\').append(c);
+    else if(c.unicode() < 0x20)
+      escaped.append(QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')));
+    else
+      escaped.append(c);
+  }
+  json.append('"').append(escaped.toUtf8()).append('"');
+}
+
+/* Append position and motion. Static values only if full is set. */
+static void appendJsonAircraft(QByteArray& json, const SimConnectAircraft& aircraft, bool full)
+{
+  const atools::geo::Pos& pos = aircraft.getPosition();
+  json.append("{\"id\":").append(QByteArray::number(aircraft.getObjectId())).
+  append(",\"lat\":").append(QByteArray::number(pos.getLatY(), 'f', 6)).
+  append(",\"lon\":").append(QByteArray::number(pos.getLonX(), 'f', 6)).
+  append(",\"alt\":").append(QByteArray::number(pos.getAltitude(), 'f', 0)).
+  append(",\"hdg\":").append(QByteArray::number(aircraft.getHeadingDegTrue(), 'f', 1)).
+  append(",\"gs\":").append(QByteArray::number(aircraft.getGroundSpeedKts(), 'f', 0)).
+  append(",\"vs\":").append(QByteArray::number(aircraft.getVerticalSpeedFeetPerMin(), 'f', 0)).
+  append(",\"gnd\":").append(aircraft.isOnGround() ? "true" : "false");
+
+  if(full)
+  {
+    json.append(",\"reg\":");
+    appendJsonString(json, aircraft.getAirplaneRegistration());
+    json.append(",\"type\":");
+    appendJsonString(json, aircraft.getAirplaneType());
+  }
+  json.append('}');
+}
+
+QByteArray SimConnectData::writeJsonToBytes(const SimConnectData *baseData) const
+{
+  QByteArray json;
+  json.reserve(256 + aiAircraft.size() * (baseData == nullptr ? 160 : 100));
+
+  json.append("{\"packet\":").append(QByteArray::number(packetId)).
+  append(",\"time\":").append(QByteArray::number(packetTs.toMSecsSinceEpoch()));
+  if(baseData != nullptr)
+    json.append(",\"base\":").append(QByteArray::number(baseData->packetId));
+
+  // User aircraft is always written in full
+  json.append(",\"user\":");
+  if(userAircraft.getPosition().isValid())
+    appendJsonAircraft(json, userAircraft, true);
+  else
+    json.append("null");
+
+  QHash<quint32, int> baseIdIndex;
+  if(baseData != nullptr)
+  {
+    for(int i = 0; i < baseData->aiAircraft.size(); i++)
+      baseIdIndex.insert(baseData->aiAircraft.at(i).objectId, i);
+  }
+
+  // Added and changed aircraft ==============================
+  json.append(",\"ai\":[");
+  bool first = true;
+  QSet<quint32> ids;
+  for(const SimConnectAircraft& aircraft : aiAircraft)
+  {
+    bool full = true;
+    if(baseData != nullptr)
+    {
+      ids.insert(aircraft.objectId);
+      int baseIndex = baseIdIndex.value(aircraft.objectId, -1);
+      if(baseIndex != -1)
+      {
+        quint8 delta = aircraftDelta(aircraft, baseData->aiAircraft.at(baseIndex));
+        if(delta == 0)
+          continue;
+        full = delta & DELTA_FULL;
+      }
+    }
+
+    if(!first)
+      json.append(',');
+    first = false;
+    appendJsonAircraft(json, aircraft, full);
+  }
+  json.append(']');
+
+  // Removed aircraft ==============================
+  if(baseData != nullptr)
+  {
+    json.append(",\"removed\":[");
+    first = true;
+    for(const SimConnectAircraft& aircraft : baseData->aiAircraft)
+    {
+      if(!ids.contains(aircraft.objectId))
+      {
+        if(!first)
+          json.append(',');
+        first = false;
+        json.append(QByteArray::number(aircraft.objectId));
+      }
+    }
+    json.append(']');
+  }
+
+  json.append('}');
+  return json;
+}
+
+quint8 SimConnectData::aircraftDelta(const SimConnectAircraft& aircraft, const SimConnectAircraft& base)
+{
+  // Any static value changed - send full record
+  if(aircraft.dataFlags != base.dataFlags || aircraft.flags != base.flags || aircraft.category != base.category ||
+     aircraft.engineType != base.engineType || aircraft.numberOfEngines != base.numberOfEngines ||
+     aircraft.wingSpanFt != base.wingSpanFt || aircraft.modelRadiusFt != base.modelRadiusFt ||
+     aircraft.deckHeight != base.deckHeight || aircraft.transponderCode != base.transponderCode ||
+     aircraft.properties != base.properties ||
+     (aircraft.info != base.info && *aircraft.info != *base.info)) // Compare strings only if not shared
+    return DELTA_FULL;
+
+  quint8 delta = 0;
+
+  // Position changed by more than quantization
+  const atools::geo::Pos& pos = aircraft.position, & basePos = base.position;
+  float diffLonX = pos.getLonX() - basePos.getLonX(), diffLatY = pos.getLatY() - basePos.getLatY();
+  if(std::abs(diffLonX) >= DELTA_POS_QUANT / 2.f || std::abs(diffLatY) >= DELTA_POS_QUANT / 2.f ||
+     pos.getAltitude() != basePos.getAltitude())
+  {
+    float maxDiff = DELTA_POS_QUANT * std::numeric_limits<qint16>::max();
+    if(std::abs(diffLonX) < maxDiff && std::abs(diffLatY) < maxDiff)
+      delta |= DELTA_POSITION;
+    else
+      delta |= DELTA_POSITION_ABS;
+  }
+
+  if(aircraft.headingTrueDeg != base.headingTrueDeg || aircraft.headingMagDeg != base.headingMagDeg ||
+     aircraft.groundSpeedKts != base.groundSpeedKts || aircraft.indicatedSpeedKts != base.indicatedSpeedKts ||
+     aircraft.verticalSpeedFeetPerMin != base.verticalSpeedFeetPerMin ||
+     aircraft.indicatedAltitudeFt != base.indicatedAltitudeFt || aircraft.trueAirspeedKts != base.trueAirspeedKts ||
+     aircraft.machSpeed != base.machSpeed)
+    delta |= DELTA_MOTION;
+
+  return delta;
+}
 
-  return SimConnectDataBase::writeBlock(ioDevice, block, status);
+void SimConnectData::writeAircraftDelta(QDataStream& out, const SimConnectAircraft& aircraft,
+                                        const SimConnectAircraft& base, quint8 delta)
+{
+  if(delta & DELTA_FULL)
+    aircraft.write(out);
+  else
+  {
+    const atools::geo::Pos& pos = aircraft.position;
+    if(delta & DELTA_POSITION)
+    {
+      // Difference to the base as seen by the client
+      out << static_cast<qint16>(atools::roundToInt((pos.getLonX() - base.position.getLonX()) / DELTA_POS_QUANT))
+          << static_cast<qint16>(atools::roundToInt((pos.getLatY() - base.position.getLatY()) / DELTA_POS_QUANT))
+          << pos.getAltitude();
+    }
+    else if(delta & DELTA_POSITION_ABS)
+      out << pos.getLonX() << pos.getLatY() << pos.getAltitude();
+
+    if(delta & DELTA_MOTION)
+      out << aircraft.headingTrueDeg << aircraft.headingMagDeg << aircraft.groundSpeedKts
+          << aircraft.indicatedSpeedKts << aircraft.verticalSpeedFeetPerMin << aircraft.indicatedAltitudeFt
+          << aircraft.trueAirspeedKts << aircraft.machSpeed;
+  }
+}
+
+void SimConnectData::readAircraftDelta(QDataStream& in, SimConnectAircraft& aircraft, quint8 delta)
+{
+  if(delta & DELTA_FULL)
+    aircraft.read(in);
+  else
+  {
+    if(delta & DELTA_POSITION)
+    {
+      qint16 diffLonX, diffLatY;
+      float altitude;
+      in >> diffLonX >> diffLatY >> altitude;
+      aircraft.position = atools::geo::Pos(aircraft.position.getLonX() + diffLonX * DELTA_POS_QUANT,
+                                           aircraft.position.getLatY() + diffLatY * DELTA_POS_QUANT, altitude);
+    }
+    else if(delta & DELTA_POSITION_ABS)
+    {
+      float lonx, laty, altitude;
+      in >> lonx >> laty >> altitude;
+      aircraft.position = atools::geo::Pos(lonx, laty, altitude);
+    }
+
+    if(delta & DELTA_MOTION)
+      in >> aircraft.headingTrueDeg >> aircraft.headingMagDeg >> aircraft.groundSpeedKts
+      >> aircraft.indicatedSpeedKts >> aircraft.verticalSpeedFeetPerMin >> aircraft.indicatedAltitudeFt
+      >> aircraft.trueAirspeedKts >> aircraft.machSpeed;
+  }
 }
 
 SimConnectAircraft *SimConnectData::getAiAircraftById(int id)
@@ -229,13 +589,13 @@ SimConnectData SimConnectData::buildDebugForPosition(const geo::Pos& pos, const
   data.userAircraft.zuluDateTime = QDateTime::currentDateTimeUtc();
   data.userAircraft.localDateTime = QDateTime::currentDateTime();
 
-  data.userAircraft.airplaneTitle = "Beech Baron 58 Paint 1";
-  data.userAircraft.airplaneType = "Beechcraft";
-  data.userAircraft.airplaneModel = "BE58";
-  data.userAircraft.airplaneReg = "N12345";
-  data.userAircraft.airplaneAirline = "Airline";
-  data.userAircraft.airplaneFlightnumber = "965";
-  data.userAircraft.fromIdent = "EDDF";
+  data.userAircraft.info->airplaneTitle = "Beech Baron 58 Paint 1";
+  data.userAircraft.info->airplaneType = "Beechcraft";
+  data.userAircraft.info->airplaneModel = "BE58";
+  data.userAircraft.info->airplaneReg = "N12345";
+  data.userAircraft.info->airplaneAirline = "Airline";
+  data.userAircraft.info->airplaneFlightnumber = "965";
+  data.userAircraft.info->fromIdent = "EDDF";
   data.userAircraft.transponderCode = 00123; // Octal code (4095)
 
   data.userAircraft.verticalSpeedFeetPerMin = vertSpeed;
@@ -243,7 +603,7 @@ SimConnectData SimConnectData::buildDebugForPosition(const geo::Pos& pos, const
   data.userAircraft.windDirectionDegT = atools::geo::normalizeCourse(headingTrue + 45.f);
   data.userAircraft.windSpeedKts = 19.f;
 
-  data.userAircraft.toIdent = "LIRF";
+  data.userAircraft.info->toIdent = "LIRF";
   data.userAircraft.altitudeAboveGroundFt = pos.getAltitude();
   data.userAircraft.indicatedAltitudeFt = pos.getAltitude();
 
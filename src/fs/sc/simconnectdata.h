@@ -40,6 +40,10 @@ class SimConnectHandler;
 /*
  * Class that transfers flight simulator data read using the simconnect interface across the network to
  * a client like Little Navmap. A version of the protocol is maintained to check for application compatibility.
+ *
+ * Two packet formats exist. Full packets contain all data. Delta packets refer to a previous packet by id and
+ * contain only added, changed and removed AI aircraft. Delta packets are only sent to clients which announced
+ * support with CMD_DELTA_SUPPORTED in their replies.
  */
 class SimConnectData :
   public SimConnectDataBase
@@ -51,9 +55,11 @@ public:
 
   /*
    * Read from IO device.
+   * baseData is the last fully read packet which is needed to decode delta packets.
+   * Status is DELTA_BASE_MISSING if a delta packet cannot be decoded. The packet is skipped in this case.
    * @return true if it was fully read. False if not or an error occured.
    */
-  bool read(QIODevice *ioDevice);
+  bool read(QIODevice *ioDevice, const SimConnectData *baseData = nullptr);
 
   /*
    * Write to IO device.
@@ -61,6 +67,18 @@ public:
    */
   int write(QIODevice *ioDevice);
 
+  /* Serialize packet into a block which can be written into one or more devices */
+  QByteArray writeToBytes() const;
+
+  /* Serialize packet as delta to baseData which is the packet as decoded by the client.
+   * User aircraft and metars are always written in full. */
+  QByteArray writeDeltaToBytes(const SimConnectData& baseData) const;
+
+  /* Compact JSON with position and motion of user and AI aircraft for web clients.
+   * Only changed AI aircraft and the ids of removed ones are written if baseData is given.
+   * Registration and type are added for new aircraft and if static values changed. */
+  QByteArray writeJsonToBytes(const SimConnectData *baseData = nullptr) const;
+
   // metadata ----------------------------------------------------
   /* Serial number for data packet. */
   int getPacketId() const
@@ -157,8 +175,34 @@ private:
   friend class atools::fs::sc::SimConnectHandler;
   friend class xpc::XpConnect;
 
+  /* Bits for each AI aircraft entry in a delta packet */
+  enum DeltaFlag : quint8
+  {
+    DELTA_FULL = 1 << 0, /* Aircraft was added or static values changed - full record follows */
+    DELTA_POSITION = 1 << 1, /* Quantized position difference to base and altitude */
+    DELTA_POSITION_ABS = 1 << 2, /* Absolute position if difference does not fit */
+    DELTA_MOTION = 1 << 3 /* Speed, heading and other dynamic values */
+  };
+
+  /* Get delta flags for aircraft compared to base */
+  static quint8 aircraftDelta(const SimConnectAircraft& aircraft, const SimConnectAircraft& base);
+  static void writeAircraftDelta(QDataStream& out, const SimConnectAircraft& aircraft,
+                                 const SimConnectAircraft& base, quint8 delta);
+  static void readAircraftDelta(QDataStream& in, SimConnectAircraft& aircraft, quint8 delta);
+
+  void readMetars(QDataStream& in);
+  void writeMetars(QDataStream& out) const;
+
+  /* Write header with size placeholder and fill in size after writing the packet */
+  void writeHeader(QDataStream& out, quint32 dataVersion) const;
+  static void finishBlock(QDataStream& out, QByteArray& block);
+
   const static quint32 MAGIC_NUMBER_DATA = 0xF75E0AF3;
   const static quint32 DATA_VERSION = 11;
+  const static quint32 DATA_VERSION_DELTA = 12;
+
+  /* Position quantization for delta packets in degree. Differences up to about 0.3 degree are sent as 16 bit. */
+  static Q_DECL_CONSTEXPR float DELTA_POS_QUANT = 0.00001f;
 
   quint32 packetId = 0;
   QDateTime packetTs;
@@ -52,6 +52,9 @@ QString SimConnectDataBase::getStatusText() const
 
     case atools::fs::sc::WRITE_ERROR:
       return QObject::tr("Write error");
+
+    case atools::fs::sc::DELTA_BASE_MISSING:
+      return QObject::tr("Missing base packet for delta");
   }
   return QObject::tr("Unknown Status");
 }
@@ -0,0 +1,185 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/simconnectdatabuffer.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+Q_DECL_CONSTEXPR int SimConnectDataBuffer::WRITING;
+
+struct SimConnectDataBuffer::Slot
+{
+  atools::fs::sc::SimConnectData data;
+
+  /* Number of readers or WRITING */
+  std::atomic_int refs;
+
+  /* Sequence number of packet or 0 if empty */
+  std::atomic<quint64> sequence;
+};
+
+SimConnectDataBuffer::SimConnectDataBuffer(int size, Policy bufferPolicy)
+  : numSlots(std::max(size, 3)), policy(bufferPolicy)
+{
+  slots.reset(new Slot[static_cast<size_t>(numSlots)]);
+  for(int i = 0; i < numSlots; i++)
+  {
+    slots[i].refs.store(0);
+    slots[i].sequence.store(0);
+  }
+
+  latest.store(-1);
+  sequence.store(0);
+  dropped.store(0);
+  notified.store(false);
+}
+
+SimConnectDataBuffer::~SimConnectDataBuffer()
+{
+}
+
+bool SimConnectDataBuffer::write(const SimConnectData& data)
+{
+  int latestIndex = latest.load(std::memory_order_acquire);
+
+  // Find a free slot after the latest one - never overwrite the latest or an acquired slot
+  for(int i = 1; i <= numSlots; i++)
+  {
+    int index = (latestIndex + i + numSlots) % numSlots;
+    if(index == latestIndex)
+      continue;
+
+    Slot& slot = slots[index];
+    int expected = 0;
+    if(slot.refs.compare_exchange_strong(expected, WRITING, std::memory_order_acquire))
+    {
+      // Assignment shares the aircraft lists with data - no deep copy
+      slot.data = data;
+
+      quint64 newSequence = sequence.load(std::memory_order_relaxed) + 1;
+      slot.sequence.store(newSequence, std::memory_order_relaxed);
+      slot.refs.store(0, std::memory_order_release);
+
+      sequence.store(newSequence, std::memory_order_release);
+      latest.store(index, std::memory_order_release);
+
+      // Notify only if consumer has reset the flag
+      return !notified.exchange(true);
+    }
+  }
+
+  // All slots busy - consumer holds one and the latest is protected - cannot happen with three or more slots
+  dropped.fetch_add(1);
+  return false;
+}
+
+bool SimConnectDataBuffer::acquireSlot(int index, quint64 slotSequence)
+{
+  Slot& slot = slots[index];
+  int refs = slot.refs.load(std::memory_order_relaxed);
+  while(refs >= 0)
+  {
+    if(slot.refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acquire))
+    {
+      // Check if producer overwrote slot between lookup and acquiring
+      if(slot.sequence.load(std::memory_order_relaxed) == slotSequence)
+      {
+        acquiredSlot = index;
+        return true;
+      }
+
+      slot.refs.fetch_sub(1, std::memory_order_release);
+      return false;
+    }
+  }
+  return false;
+}
+
+const SimConnectData *SimConnectDataBuffer::acquire()
+{
+  if(acquiredSlot != -1)
+  {
+    qWarning() << Q_FUNC_INFO << "Packet not released";
+    release();
+  }
+
+  // Reset before reading to avoid losing notifications for packets written from now on
+  notified.store(false);
+
+  // Retry if producer overwrites slots while looking for one
+  for(int retry = 0; retry < numSlots; retry++)
+  {
+    int latestIndex = latest.load(std::memory_order_acquire);
+    if(latestIndex == -1)
+      return nullptr;
+
+    quint64 latestSequence = slots[latestIndex].sequence.load(std::memory_order_acquire);
+    if(latestSequence <= lastReadSequence)
+      // Nothing new
+      return nullptr;
+
+    int index = latestIndex;
+    quint64 slotSequence = latestSequence;
+
+    if(policy == SEQUENTIAL && latestSequence > lastReadSequence + 1)
+    {
+      // Look for the oldest unread packet which is still available
+      for(int i = 0; i < numSlots; i++)
+      {
+        quint64 seq = slots[i].sequence.load(std::memory_order_acquire);
+        if(seq > lastReadSequence && seq < slotSequence)
+        {
+          index = i;
+          slotSequence = seq;
+        }
+      }
+    }
+
+    if(acquireSlot(index, slotSequence))
+    {
+      // Count skipped or overwritten packets
+      if(slotSequence > lastReadSequence + 1)
+        dropped.fetch_add(slotSequence - lastReadSequence - 1);
+
+      lastReadSequence = slotSequence;
+      return &slots[index].data;
+    }
+  }
+  return nullptr;
+}
+
+void SimConnectDataBuffer::release()
+{
+  if(acquiredSlot != -1)
+  {
+    slots[acquiredSlot].refs.fetch_sub(1, std::memory_order_release);
+    acquiredSlot = -1;
+  }
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
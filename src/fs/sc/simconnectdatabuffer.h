@@ -0,0 +1,128 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_SIMCONNECTDATABUFFER_H
+#define ATOOLS_FS_SC_SIMCONNECTDATABUFFER_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+
+/*
+ * Lock-free single producer and single consumer ring buffer of preallocated simulator data packets.
+ *
+ * The producer (DataReaderThread) copies packets into free slots. The consumer acquires a slot, reads the data in
+ * place without copying and releases it afterwards. Slots are reference counted and the producer never overwrites
+ * a slot which is acquired by the consumer.
+ *
+ * Policy LATEST gives only the newest packet and silently drops all older ones which were not read.
+ * Policy SEQUENTIAL gives all packets in order as long as they were not overwritten due to a slow consumer.
+ * Dropped packets are counted in both cases.
+ */
+class SimConnectDataBuffer
+{
+public:
+  enum Policy
+  {
+    LATEST,
+    SEQUENTIAL
+  };
+
+  /* Size is the number of slots which is at least three */
+  explicit SimConnectDataBuffer(int size = 4, Policy bufferPolicy = LATEST);
+  ~SimConnectDataBuffer();
+
+  SimConnectDataBuffer(const SimConnectDataBuffer& other) = delete;
+  SimConnectDataBuffer& operator=(const SimConnectDataBuffer& other) = delete;
+
+  /* Producer side. Copy data into a free slot and publish it.
+   * Returns true if the consumer has to be notified, i.e. it has read all previous packets since the last
+   * notification. This allows to coalesce notification signals under load. */
+  bool write(const atools::fs::sc::SimConnectData& data);
+
+  /* Consumer side. Get next packet depending on policy or null if there is no new packet.
+   * Data is valid until calling release(). Only one packet can be acquired at a time. */
+  const atools::fs::sc::SimConnectData *acquire();
+
+  /* Release packet acquired by acquire(). */
+  void release();
+
+  /* Consumer policy. Not thread safe. */
+  void setPolicy(Policy value)
+  {
+    policy = value;
+  }
+
+  Policy getPolicy() const
+  {
+    return policy;
+  }
+
+  /* Packets skipped or overwritten before the consumer acquired them and packets which could not be written since
+   * all slots were busy. Thread safe. */
+  quint64 getNumDropped() const
+  {
+    return dropped.load();
+  }
+
+  /* Number of packets written. Thread safe. */
+  quint64 getNumWritten() const
+  {
+    return sequence.load();
+  }
+
+private:
+  struct Slot;
+
+  /* Try to acquire slot for reading. Checks if slot still contains the given sequence number */
+  bool acquireSlot(int index, quint64 slotSequence);
+
+  /* Reference count value if slot is being written by producer */
+  static Q_DECL_CONSTEXPR int WRITING = -1;
+
+  std::unique_ptr<Slot[]> slots;
+  int numSlots;
+  Policy policy;
+
+  /* Index of slot with the newest packet or -1 if nothing written yet */
+  std::atomic_int latest;
+
+  /* Sequence number of last written packet. Starts with 1. */
+  std::atomic<quint64> sequence;
+  std::atomic<quint64> dropped;
+
+  /* Set by producer if notification is due and reset by consumer when reading */
+  std::atomic_bool notified;
+
+  /* Consumer state */
+  int acquiredSlot = -1;
+  quint64 lastReadSequence = 0;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_SIMCONNECTDATABUFFER_H
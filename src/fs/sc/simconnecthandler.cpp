@@ -28,7 +28,7 @@
 #include <QTime>
 #include <QDateTime>
 #include <QThread>
-#include <QSet>
+#include <QHash>
 #include <QCache>
 #include <QLatin1String>
 #include <QCoreApplication>
@@ -46,7 +46,9 @@ enum EventIds
 {
   EVENT_SIM_STATE,
   EVENT_SIM_PAUSE,
-  EVENT_AIRCRAFT_LOADED
+  EVENT_AIRCRAFT_LOADED,
+  EVENT_OBJECT_ADDED,
+  EVENT_OBJECT_REMOVED
 };
 
 enum DataRequestId
@@ -60,10 +62,22 @@ enum DataRequestId
 #if defined(SIMCONNECT_BUILD_WIN32)
   DATA_REQUEST_ID_WEATHER_INTERPOLATED = 5,
   DATA_REQUEST_ID_WEATHER_NEAREST_STATION = 6,
-  DATA_REQUEST_ID_WEATHER_STATION = 7
+  DATA_REQUEST_ID_WEATHER_STATION = 7,
 #endif
+
+  /* Periodic request for user aircraft if subscribed */
+  DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE = 8,
+
+  /* Periodic requests for AI objects if subscribed. One id per object counting up from here. */
+  DATA_REQUEST_ID_AI_SUBSCRIBE_BASE = 1000
 };
 
+/* Subscribed user aircraft data is sent every n-th simulator frame if changed */
+const DWORD SUBSCRIBE_USER_FRAME_INTERVAL = 5;
+
+/* Maximum radius for SimConnect to find AI objects which existed before subscribing */
+const DWORD SUBSCRIBE_AI_RADIUS_METER = 200000;
+
 enum DataDefinitionId
 {
   DATA_DEFINITION_USER_AIRCRAFT = 10,
@@ -188,17 +202,63 @@ public:
   void fillDataDefinition();
   void fillDataDefinitionAicraft(DataDefinitionId definitionId);
 
-  void copyToSimConnectAircraft(const SimDataAircraft& simDataAircraft, atools::fs::sc::SimConnectAircraft& aircraft);
+  /* Copy data into aircraft. Category is only set if updateCategory is true. Names are only
+   * assigned if changed to allow re-using an aircraft object without allocations. */
+  void copyToSimConnectAircraft(const SimDataAircraft& simDataAircraft, atools::fs::sc::SimConnectAircraft& aircraft,
+                                bool updateCategory = true);
 
   bool checkCall(HRESULT hr, const QString& message);
   bool callDispatch(bool& dataFetched, const QString& message);
 
+  /* Process all queued messages without waiting for new ones */
+  bool dispatchPending(const QString& message);
+
+  /* Start or stop periodic data requests for user aircraft and AI objects */
+  bool subscribeData();
+  void unsubscribeData();
+
+  /* Request data for an AI object periodically if changed. Does nothing if already subscribed. */
+  void subscribeAiObject(unsigned long objectId, DataDefinitionId definitionId);
+  void storeAiData(unsigned long objectId, DataDefinitionId definitionId, const SimDataAircraft& simDataAircraft);
+
+  /* Appends the pooled AI aircraft for the object id to the list if not already added in this fetch.
+   * Data is only copied into the pooled object if update is true or the object is new. */
+  void appendAiAircraft(QVector<atools::fs::sc::SimConnectAircraft>& aircraftList, unsigned long objectId,
+                        const SimDataAircraft& simDataAircraft, bool update);
+
   SimData simData;
   unsigned long simDataObjectId;
 
   QVector<SimDataAircraft> simDataAircraftList;
   QVector<unsigned long> simDataAircraftObjectIds;
 
+  /* AI aircraft objects re-used between fetches by object id to avoid allocating the names record for
+   * each aircraft on every update. fetchCounter is the last fetch the object was seen in. */
+  struct PooledAircraft
+  {
+    atools::fs::sc::SimConnectAircraft aircraft;
+    quint32 fetchCounter = 0;
+  };
+
+  QHash<unsigned long, PooledAircraft> aiAircraftPool;
+  quint32 fetchCounter = 0;
+
+  /* Last data received for an AI object while subscribed. changed is reset once the data was used in a fetch. */
+  struct SubscribedAircraft
+  {
+    SimDataAircraft data;
+    SIMCONNECT_DATA_REQUEST_ID requestId;
+    DataDefinitionId definitionId;
+    bool valid = false, changed = false;
+  };
+
+  QHash<unsigned long, SubscribedAircraft> subscribedAircraft;
+  SIMCONNECT_DATA_REQUEST_ID nextAiRequestId = DATA_REQUEST_ID_AI_SUBSCRIBE_BASE;
+  bool subscribed = false;
+
+  /* Number of received messages used to detect an empty queue */
+  quint32 dispatchCounter = 0;
+
   sc::State state = sc::STATEOK;
   bool dataDefined = false; // fillDataDefinition called
 
@@ -223,6 +283,8 @@ void SimConnectHandlerPrivate::dispatchProcedure(SIMCONNECT_RECV *pData, DWORD c
   if(verbose)
     qDebug() << "DispatchProcedure entered";
 
+  dispatchCounter++;
+
   switch(pData->dwID)
   {
     case SIMCONNECT_RECV_ID_OPEN:
@@ -299,6 +361,56 @@ void SimConnectHandlerPrivate::dispatchProcedure(SIMCONNECT_RECV *pData, DWORD c
         break;
       }
 
+    case SIMCONNECT_RECV_ID_EVENT_OBJECT_ADDREMOVE:
+      {
+        SIMCONNECT_RECV_EVENT_OBJECT_ADDREMOVE *evt = static_cast<SIMCONNECT_RECV_EVENT_OBJECT_ADDREMOVE *>(pData);
+        unsigned long objectId = evt->dwData;
+
+        if(verbose)
+          qDebug() << "SIMCONNECT_RECV_ID_EVENT_OBJECT_ADDREMOVE" << evt->uEventID << "object" << objectId
+                   << "type" << evt->eObjType;
+
+        if(subscribed && evt->uEventID == EVENT_OBJECT_ADDED)
+        {
+          if(evt->eObjType == SIMCONNECT_SIMOBJECT_TYPE_AIRCRAFT)
+            subscribeAiObject(objectId, DATA_DEFINITION_AI_AIRCRAFT);
+          else if(evt->eObjType == SIMCONNECT_SIMOBJECT_TYPE_HELICOPTER)
+            subscribeAiObject(objectId, DATA_DEFINITION_AI_HELICOPTER);
+          else if(evt->eObjType == SIMCONNECT_SIMOBJECT_TYPE_BOAT)
+            subscribeAiObject(objectId, DATA_DEFINITION_AI_BOAT);
+        }
+        else if(evt->uEventID == EVENT_OBJECT_REMOVED)
+        {
+          // Request ends with the object
+          subscribedAircraft.remove(objectId);
+          aiAircraftPool.remove(objectId);
+        }
+        break;
+      }
+
+    case SIMCONNECT_RECV_ID_SIMOBJECT_DATA:
+      {
+        // Periodic data sent for subscriptions
+        SIMCONNECT_RECV_SIMOBJECT_DATA *pObjData = static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA *>(pData);
+
+        if(verbose)
+          qDebug() << "SIMCONNECT_RECV_ID_SIMOBJECT_DATA"
+                   << "pObjData->dwDefineID" << pObjData->dwDefineID
+                   << "pObjData->dwObjectID" << pObjData->dwObjectID
+                   << "pObjData->dwRequestID" << pObjData->dwRequestID;
+
+        if(pObjData->dwRequestID == DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE)
+        {
+          simData = *reinterpret_cast<SimData *>(&pObjData->dwData);
+          simDataObjectId = pObjData->dwObjectID;
+          userDataFetched = true;
+        }
+        else if(pObjData->dwRequestID >= DATA_REQUEST_ID_AI_SUBSCRIBE_BASE)
+          storeAiData(pObjData->dwObjectID, static_cast<DataDefinitionId>(pObjData->dwDefineID),
+                      *reinterpret_cast<SimDataAircraft *>(&pObjData->dwData));
+        break;
+      }
+
     case SIMCONNECT_RECV_ID_SIMOBJECT_DATA_BYTYPE:
       {
         SIMCONNECT_RECV_SIMOBJECT_DATA_BYTYPE *pObjData = static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA_BYTYPE *>(pData);
@@ -410,8 +522,14 @@ void SimConnectHandlerPrivate::dispatchProcedure(SIMCONNECT_RECV *pData, DWORD c
                          << simDataAircraftPtr->planeHeadingTrueDeg << "T"
                 ;
 
-              simDataAircraftList.append(*simDataAircraftPtr);
-              simDataAircraftObjectIds.append(objectID);
+              if(subscribed)
+                // Object existed before subscribing - answer to initial request
+                storeAiData(objectID, static_cast<DataDefinitionId>(pObjData->dwDefineID), *simDataAircraftPtr);
+              else
+              {
+                simDataAircraftList.append(*simDataAircraftPtr);
+                simDataAircraftObjectIds.append(objectID);
+              }
               aiDataFetched = true;
             }
           }
@@ -462,7 +580,14 @@ void CALLBACK SimConnectHandlerPrivate::dispatchCallback(SIMCONNECT_RECV *pData,
   handlerClass->dispatchProcedure(pData, cbData);
 }
 
-void SimConnectHandlerPrivate::copyToSimConnectAircraft(const SimDataAircraft& simDataAircraft, SimConnectAircraft& aircraft)
+/* Comparing to Latin-1 does not allocate - non ASCII strings are simply always assigned */
+static bool isEqual(const QString& str, const char *value)
+{
+  return str == QLatin1String(value);
+}
+
+void SimConnectHandlerPrivate::copyToSimConnectAircraft(const SimDataAircraft& simDataAircraft, SimConnectAircraft& aircraft,
+                                                        bool updateCategory)
 {
 #if defined(SIMCONNECT_BUILD_WIN32)
   aircraft.flags = atools::fs::sc::SIM_FSX_P3D;
@@ -470,14 +595,27 @@ void SimConnectHandlerPrivate::copyToSimConnectAircraft(const SimDataAircraft& s
   aircraft.flags = atools::fs::sc::SIM_MSFS;
 #endif
 
-  aircraft.airplaneTitle = simDataAircraft.aircraftTitle;
-  aircraft.airplaneModel = simDataAircraft.aircraftAtcModel;
-  aircraft.airplaneReg = simDataAircraft.aircraftAtcId;
-  aircraft.airplaneType = simDataAircraft.aircraftAtcType;
-  aircraft.airplaneAirline = simDataAircraft.aircraftAtcAirline;
-  aircraft.airplaneFlightnumber = simDataAircraft.aircraftAtcFlightNumber;
-  aircraft.fromIdent = simDataAircraft.aiFrom;
-  aircraft.toIdent = simDataAircraft.aiTo;
+  // Keep the shared names record of re-used objects if nothing changed
+  const SimConnectAircraftInfo *oldInfo = aircraft.info.constData();
+  if(!isEqual(oldInfo->airplaneTitle, simDataAircraft.aircraftTitle) ||
+     !isEqual(oldInfo->airplaneModel, simDataAircraft.aircraftAtcModel) ||
+     !isEqual(oldInfo->airplaneReg, simDataAircraft.aircraftAtcId) ||
+     !isEqual(oldInfo->airplaneType, simDataAircraft.aircraftAtcType) ||
+     !isEqual(oldInfo->airplaneAirline, simDataAircraft.aircraftAtcAirline) ||
+     !isEqual(oldInfo->airplaneFlightnumber, simDataAircraft.aircraftAtcFlightNumber) ||
+     !isEqual(oldInfo->fromIdent, simDataAircraft.aiFrom) ||
+     !isEqual(oldInfo->toIdent, simDataAircraft.aiTo))
+  {
+    SimConnectAircraftInfo *info = aircraft.info.data();
+    info->airplaneTitle = simDataAircraft.aircraftTitle;
+    info->airplaneModel = simDataAircraft.aircraftAtcModel;
+    info->airplaneReg = simDataAircraft.aircraftAtcId;
+    info->airplaneType = simDataAircraft.aircraftAtcType;
+    info->airplaneAirline = simDataAircraft.aircraftAtcAirline;
+    info->airplaneFlightnumber = simDataAircraft.aircraftAtcFlightNumber;
+    info->fromIdent = simDataAircraft.aiFrom;
+    info->toIdent = simDataAircraft.aiTo;
+  }
 
 #if defined(SIMCONNECT_BUILD_WIN64)
   // Add aircraft.cfg location as additional property for MSFS
@@ -485,21 +623,25 @@ void SimConnectHandlerPrivate::copyToSimConnectAircraft(const SimDataAircraft& s
     aircraft.properties.addProp(atools::util::Prop(atools::fs::sc::PROP_AIRCRAFT_CFG, aircraftFilePath));
 #endif
 
-  QString cat = QString(simDataAircraft.category).toLower().trimmed();
-  if(cat == "airplane")
-    aircraft.category = AIRPLANE;
-  else if(cat == "helicopter")
-    aircraft.category = HELICOPTER;
-  else if(cat == "boat")
-    aircraft.category = BOAT;
-  else if(cat == "groundvehicle")
-    aircraft.category = GROUNDVEHICLE;
-  else if(cat == "controltower")
-    aircraft.category = CONTROLTOWER;
-  else if(cat == "simpleobject")
-    aircraft.category = SIMPLEOBJECT;
-  else if(cat == "viewer")
-    aircraft.category = VIEWER;
+  if(updateCategory)
+  {
+    // Category does not change for an object
+    QString cat = QString(simDataAircraft.category).toLower().trimmed();
+    if(cat == "airplane")
+      aircraft.category = AIRPLANE;
+    else if(cat == "helicopter")
+      aircraft.category = HELICOPTER;
+    else if(cat == "boat")
+      aircraft.category = BOAT;
+    else if(cat == "groundvehicle")
+      aircraft.category = GROUNDVEHICLE;
+    else if(cat == "controltower")
+      aircraft.category = CONTROLTOWER;
+    else if(cat == "simpleobject")
+      aircraft.category = SIMPLEOBJECT;
+    else if(cat == "viewer")
+      aircraft.category = VIEWER;
+  }
 
   aircraft.wingSpanFt = static_cast<quint16>(simDataAircraft.wingSpan);
   aircraft.modelRadiusFt = static_cast<quint16>(simDataAircraft.modelRadius);
@@ -583,6 +725,148 @@ bool SimConnectHandlerPrivate::callDispatch(bool& dataFetched, const QString& me
   return true;
 }
 
+bool SimConnectHandlerPrivate::dispatchPending(const QString& message)
+{
+  simconnectException = SIMCONNECT_EXCEPTION_NONE;
+
+  // Call until a call does not deliver any message - limit in case the simulator sends faster than we process
+  int dispatchCycles = 0;
+  quint32 lastDispatchCounter;
+  do
+  {
+    lastDispatchCounter = dispatchCounter;
+    HRESULT hr = api.CallDispatch(dispatchCallback, this);
+
+    if(hr != S_OK && simconnectException != SIMCONNECT_EXCEPTION_WEATHER_UNABLE_TO_GET_OBSERVATION)
+    {
+      qWarning() << "SimConnect_CallDispatch during " << message << ": Exception" << simconnectException;
+      state = sc::FETCH_ERROR;
+      return false;
+    }
+    dispatchCycles++;
+  } while(lastDispatchCounter != dispatchCounter && dispatchCycles < 1000);
+
+  if(verbose)
+    qDebug() << "dispatch pending" << message << "cycles" << dispatchCycles;
+
+  return true;
+}
+
+bool SimConnectHandlerPrivate::subscribeData()
+{
+  qDebug() << Q_FUNC_INFO;
+
+  subscribedAircraft.clear();
+  userDataFetched = false;
+
+  HRESULT hr = api.RequestDataOnSimObject(DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE, DATA_DEFINITION_USER_AIRCRAFT,
+                                          SIMCONNECT_OBJECT_ID_USER, SIMCONNECT_PERIOD_SIM_FRAME,
+                                          SIMCONNECT_DATA_REQUEST_FLAG_CHANGED, 0, SUBSCRIBE_USER_FRAME_INTERVAL);
+  if(!checkCall(hr, "DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE"))
+    return false;
+
+  api.SubscribeToSystemEvent(EVENT_OBJECT_ADDED, "ObjectAdded");
+  api.SubscribeToSystemEvent(EVENT_OBJECT_REMOVED, "ObjectRemoved");
+  subscribed = true;
+
+  // Events are sent only for new objects - find the existing ones once
+  hr = api.RequestDataOnSimObjectType(DATA_REQUEST_ID_AI_AIRCRAFT, DATA_DEFINITION_AI_AIRCRAFT,
+                                      SUBSCRIBE_AI_RADIUS_METER, SIMCONNECT_SIMOBJECT_TYPE_AIRCRAFT);
+  if(!checkCall(hr, "DATA_REQUEST_ID_AI_AIRCRAFT"))
+    return false;
+
+  hr = api.RequestDataOnSimObjectType(DATA_REQUEST_ID_AI_HELICOPTER, DATA_DEFINITION_AI_HELICOPTER,
+                                      SUBSCRIBE_AI_RADIUS_METER, SIMCONNECT_SIMOBJECT_TYPE_HELICOPTER);
+  if(!checkCall(hr, "DATA_REQUEST_ID_AI_HELICOPTER"))
+    return false;
+
+  hr = api.RequestDataOnSimObjectType(DATA_REQUEST_ID_AI_BOAT, DATA_DEFINITION_AI_BOAT,
+                                      SUBSCRIBE_AI_RADIUS_METER, SIMCONNECT_SIMOBJECT_TYPE_BOAT);
+  return checkCall(hr, "DATA_REQUEST_ID_AI_BOAT");
+}
+
+void SimConnectHandlerPrivate::unsubscribeData()
+{
+  qDebug() << Q_FUNC_INFO;
+
+  api.RequestDataOnSimObject(DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE, DATA_DEFINITION_USER_AIRCRAFT,
+                             SIMCONNECT_OBJECT_ID_USER, SIMCONNECT_PERIOD_NEVER);
+  api.UnsubscribeFromSystemEvent(EVENT_OBJECT_ADDED);
+  api.UnsubscribeFromSystemEvent(EVENT_OBJECT_REMOVED);
+
+  for(auto it = subscribedAircraft.constBegin(); it != subscribedAircraft.constEnd(); ++it)
+    api.RequestDataOnSimObject(it.value().requestId, it.value().definitionId, it.key(), SIMCONNECT_PERIOD_NEVER);
+
+  subscribedAircraft.clear();
+  subscribed = false;
+}
+
+void SimConnectHandlerPrivate::subscribeAiObject(unsigned long objectId, DataDefinitionId definitionId)
+{
+  if(subscribedAircraft.contains(objectId))
+    return;
+
+  SIMCONNECT_DATA_REQUEST_ID requestId = nextAiRequestId++;
+  HRESULT hr = api.RequestDataOnSimObject(requestId, definitionId, objectId, SIMCONNECT_PERIOD_SECOND,
+                                          SIMCONNECT_DATA_REQUEST_FLAG_CHANGED);
+  if(hr == S_OK)
+  {
+    SubscribedAircraft& aircraft = subscribedAircraft[objectId];
+    aircraft.requestId = requestId;
+    aircraft.definitionId = definitionId;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Error subscribing object" << objectId;
+}
+
+void SimConnectHandlerPrivate::storeAiData(unsigned long objectId, DataDefinitionId definitionId,
+                                           const SimDataAircraft& simDataAircraft)
+{
+  if(simDataAircraft.userSim > 0)
+    return;
+
+  subscribeAiObject(objectId, definitionId);
+
+  auto it = subscribedAircraft.find(objectId);
+  if(it != subscribedAircraft.end())
+  {
+    it.value().data = simDataAircraft;
+    it.value().valid = it.value().changed = true;
+  }
+}
+
+void SimConnectHandlerPrivate::appendAiAircraft(QVector<SimConnectAircraft>& aircraftList, unsigned long objectId,
+                                                const SimDataAircraft& simDataAircraft, bool update)
+{
+  bool newAircraft = !aiAircraftPool.contains(objectId);
+  PooledAircraft& pooled = aiAircraftPool[objectId];
+
+  // Avoid duplicates
+  if(pooled.fetchCounter != fetchCounter)
+  {
+    pooled.fetchCounter = fetchCounter;
+
+    atools::fs::sc::SimConnectAircraft& aiAircraft = pooled.aircraft;
+    if(update || newAircraft || aiAircraft.isSimPaused() != simPaused)
+    {
+      copyToSimConnectAircraft(simDataAircraft, aiAircraft, newAircraft);
+
+#if defined(SIMCONNECT_BUILD_WIN64)
+      // MSFS ground flag is is unreliable for AI - try to detect by speed at least, AGL is not available for this
+      aiAircraft.flags.setFlag(atools::fs::sc::ON_GROUND, simDataAircraft.isSimOnGround > 0 ||
+                               (aiAircraft.verticalSpeedFeetPerMin < 0.01f && simDataAircraft.groundVelocityKts < 30.f));
+#else
+      // FSX and P3D
+      aiAircraft.flags.setFlag(atools::fs::sc::ON_GROUND, simDataAircraft.isSimOnGround > 0);
+#endif
+      aiAircraft.objectId = static_cast<unsigned int>(objectId);
+    }
+
+    // Copy shares the names record with the pooled object
+    aircraftList.append(aiAircraft);
+  }
+}
+
 void SimConnectHandlerPrivate::fillDataDefinition()
 {
   fillDataDefinitionAicraft(DATA_DEFINITION_AI_AIRCRAFT);
@@ -799,6 +1083,11 @@ bool SimConnectHandler::connect()
 
     p->fillDataDefinition();
 
+    // Object ids and requests are not valid across connections
+    p->aiAircraftPool.clear();
+    p->subscribedAircraft.clear();
+    p->subscribed = false;
+
     // Request an event when the simulation starts or pauses
     p->api.SubscribeToSystemEvent(EVENT_SIM_STATE, "Sim");
     p->api.SubscribeToSystemEvent(EVENT_SIM_PAUSE, "Pause");
@@ -825,7 +1114,20 @@ bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radi
   // === Get AI aircraft =======================================================
   p->simDataAircraftList.clear();
   p->simDataAircraftObjectIds.clear();
-  p->simDataObjectId = 0;
+
+  // Switch between polling and subscriptions
+  bool subscribe = options.testFlag(SUBSCRIBE_DATA);
+  if(subscribe && !p->subscribed)
+  {
+    if(!p->subscribeData())
+      return false;
+  }
+  else if(!subscribe && p->subscribed)
+    p->unsubscribeData();
+
+  // Keep last user object when subscribed since data is only sent if changed
+  if(!subscribe)
+    p->simDataObjectId = 0;
 
 #if defined(SIMCONNECT_BUILD_WIN64)
   if(!p->lastSystemRequestTime.isValid() || p->lastSystemRequestTime.msecsTo(QDateTime::currentDateTime()) > 1000)
@@ -837,7 +1139,15 @@ bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radi
 
   HRESULT hr = 0;
 
-  if(options & FETCH_AI_AIRCRAFT)
+  if(subscribe)
+  {
+    // Wait for initial data after subscribing - otherwise get only what was sent since last fetch
+    if(p->userDataFetched)
+      p->dispatchPending("DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE and DATA_REQUEST_ID_AI_SUBSCRIBE");
+    else
+      p->callDispatch(p->userDataFetched, "DATA_REQUEST_ID_USER_AIRCRAFT_SUBSCRIBE");
+  }
+  else if(options & FETCH_AI_AIRCRAFT)
   {
     hr = p->api.RequestDataOnSimObjectType(DATA_REQUEST_ID_AI_AIRCRAFT, DATA_DEFINITION_AI_AIRCRAFT,
                                            static_cast<DWORD>(radiusKm) * 1000, SIMCONNECT_SIMOBJECT_TYPE_AIRCRAFT);
@@ -850,7 +1160,7 @@ bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radi
       return false;
   }
 
-  if(options & FETCH_AI_BOAT)
+  if(!subscribe && (options & FETCH_AI_BOAT))
   {
     hr = p->api.RequestDataOnSimObjectType(DATA_REQUEST_ID_AI_BOAT, DATA_DEFINITION_AI_BOAT,
                                            static_cast<DWORD>(radiusKm) * 1000, SIMCONNECT_SIMOBJECT_TYPE_BOAT);
@@ -858,44 +1168,71 @@ bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radi
       return false;
   }
 
-  p->callDispatch(p->aiDataFetched, "DATA_REQUEST_ID_AI_HELICOPTER, DATA_REQUEST_ID_AI_BOAT and DATA_REQUEST_ID_AI_AIRCRAFT");
+  if(!subscribe)
+    p->callDispatch(p->aiDataFetched,
+                    "DATA_REQUEST_ID_AI_HELICOPTER, DATA_REQUEST_ID_AI_BOAT and DATA_REQUEST_ID_AI_AIRCRAFT");
 
   if(p->state == sc::STATEOK)
   {
     // === Get user aircraft =======================================================
-    hr = p->api.RequestDataOnSimObjectType(
-      DATA_REQUEST_ID_USER_AIRCRAFT, DATA_DEFINITION_USER_AIRCRAFT, 0,
-      SIMCONNECT_SIMOBJECT_TYPE_USER);
-    if(!p->checkCall(hr, "DATA_REQUEST_ID_USER_AIRCRAFT"))
-      return false;
+    if(!subscribe)
+    {
+      hr = p->api.RequestDataOnSimObjectType(
+        DATA_REQUEST_ID_USER_AIRCRAFT, DATA_DEFINITION_USER_AIRCRAFT, 0,
+        SIMCONNECT_SIMOBJECT_TYPE_USER);
+      if(!p->checkCall(hr, "DATA_REQUEST_ID_USER_AIRCRAFT"))
+        return false;
 
-    p->callDispatch(p->userDataFetched, "DATA_REQUEST_ID_USER_AIRCRAFT");
+      p->callDispatch(p->userDataFetched, "DATA_REQUEST_ID_USER_AIRCRAFT");
+    }
 
     p->state = sc::STATEOK;
 
     // Get AI aircraft =======================================================================
-    QSet<unsigned long> objectIds;
-    for(int i = 0; i < p->simDataAircraftList.size(); i++)
+    p->fetchCounter++;
+    if(subscribe)
     {
-      unsigned long oid = p->simDataAircraftObjectIds.at(i);
-      // Avoid duplicates
-      if(!objectIds.contains(oid))
+      // Filter the last received data of all known objects by options and radius
+      atools::geo::Pos userPos(p->simData.aircraft.longitudeDeg, p->simData.aircraft.latitudeDeg);
+      float radiusMeter = static_cast<float>(radiusKm) * 1000.f;
+      bool checkRadius = p->userDataFetched && radiusKm > 0;
+
+      data.aiAircraft.reserve(p->subscribedAircraft.size());
+      for(auto it = p->subscribedAircraft.begin(); it != p->subscribedAircraft.end(); ++it)
       {
-        const SimDataAircraft& simDataAircraft = p->simDataAircraftList.at(i);
-        atools::fs::sc::SimConnectAircraft aiAircraft;
-        p->copyToSimConnectAircraft(simDataAircraft, aiAircraft);
+        SimConnectHandlerPrivate::SubscribedAircraft& subscribed = it.value();
+        if(!subscribed.valid)
+          continue;
 
-#if defined(SIMCONNECT_BUILD_WIN64)
-        // MSFS ground flag is is unreliable for AI - try to detect by speed at least, AGL is not available for this
-        aiAircraft.flags.setFlag(atools::fs::sc::ON_GROUND, simDataAircraft.isSimOnGround > 0 ||
-                                 (aiAircraft.verticalSpeedFeetPerMin < 0.01f && simDataAircraft.groundVelocityKts < 30.f));
-#else
-        // FSX and P3D
-        aiAircraft.flags.setFlag(atools::fs::sc::ON_GROUND, simDataAircraft.isSimOnGround > 0);
-#endif
-        aiAircraft.objectId = static_cast<unsigned int>(oid);
-        data.aiAircraft.append(aiAircraft);
-        objectIds.insert(aiAircraft.objectId);
+        bool boat = subscribed.definitionId == DATA_DEFINITION_AI_BOAT;
+        if((boat && !(options & FETCH_AI_BOAT)) || (!boat && !(options & FETCH_AI_AIRCRAFT)))
+          continue;
+
+        if(checkRadius &&
+           userPos.distanceMeterTo(atools::geo::Pos(subscribed.data.longitudeDeg, subscribed.data.latitudeDeg)) >
+           radiusMeter)
+          continue;
+
+        p->appendAiAircraft(data.aiAircraft, it.key(), subscribed.data, subscribed.changed);
+        subscribed.changed = false;
+      }
+    }
+    else
+    {
+      data.aiAircraft.reserve(p->simDataAircraftList.size());
+      for(int i = 0; i < p->simDataAircraftList.size(); i++)
+        p->appendAiAircraft(data.aiAircraft, p->simDataAircraftObjectIds.at(i), p->simDataAircraftList.at(i), true);
+    }
+
+    // Remove aircraft which are gone from pool if it grows too large
+    if(p->aiAircraftPool.size() > data.aiAircraft.size() * 2 + 100)
+    {
+      for(auto it = p->aiAircraftPool.begin(); it != p->aiAircraftPool.end();)
+      {
+        if(it.value().fetchCounter != p->fetchCounter)
+          it = p->aiAircraftPool.erase(it);
+        else
+          ++it;
       }
     }
 
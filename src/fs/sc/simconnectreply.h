@@ -35,7 +35,11 @@ namespace sc {
 enum CommandEnum
 {
   CMD_NONE,
-  CMD_WEATHER_REQUEST
+  CMD_WEATHER_REQUEST,
+
+  /* Sent by clients with normal replies to indicate that they can read delta packets.
+   * Servers not knowing this command treat it like CMD_NONE. Do not combine with CMD_WEATHER_REQUEST. */
+  CMD_DELTA_SUPPORTED
 };
 
 Q_DECLARE_FLAGS(Command, CommandEnum);
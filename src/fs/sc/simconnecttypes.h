@@ -36,14 +36,19 @@ enum SimConnectStatus
   INVALID_MAGIC_NUMBER, /* Packet data does not start with expected magic number */
   VERSION_MISMATCH, /* Client and server data version does not match for either data or reply */
   INSUFFICIENT_WRITE, /* Wrote less than block */
-  WRITE_ERROR /* Error from IO device */
+  WRITE_ERROR, /* Error from IO device */
+  DELTA_BASE_MISSING /* Delta packet received but the packet it refers to is not available */
 };
 
 enum Option
 {
   NO_OPTION = 0,
   FETCH_AI_AIRCRAFT = 1 << 0,
-  FETCH_AI_BOAT = 1 << 1
+  FETCH_AI_BOAT = 1 << 1,
+
+  /* Let the simulator send user and AI data only if changed instead of requesting all data on each fetch.
+   * Only used by the SimConnect handler. */
+  SUBSCRIBE_DATA = 1 << 2
 };
 
 Q_DECLARE_FLAGS(Options, Option);
@@ -34,6 +34,7 @@ namespace fs {
 namespace sc {
 class SimConnectHandler;
 class SimConnectData;
+class XpConnectRing;
 
 /*
  * User aircraft that is used to transfer across network links.
@@ -237,6 +238,7 @@ public:
 private:
   friend class atools::fs::sc::SimConnectHandler;
   friend class atools::fs::sc::SimConnectData;
+  friend class atools::fs::sc::XpConnectRing;
   friend class xpc::XpConnect;
 
   float
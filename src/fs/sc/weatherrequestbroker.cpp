@@ -0,0 +1,180 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/sc/weatherrequestbroker.h"
+
+#include "fs/sc/connecthandler.h"
+#include "fs/sc/simconnectdata.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+using atools::fs::weather::MetarResult;
+
+WeatherRequestBroker::WeatherRequestBroker()
+{
+
+}
+
+bool WeatherRequestBroker::addRequest(const WeatherRequest& request)
+{
+  if(!request.isValid())
+    return false;
+
+  QString key = requestKey(request);
+  if(pendingKeys.contains(key))
+    return false;
+
+  pendingKeys.insert(key);
+  pending.append(request);
+  return true;
+}
+
+int WeatherRequestBroker::fetch(ConnectHandler *handler, QVector<MetarResult>& metars)
+{
+  removeExpired();
+
+  int fetches = 0, cached = 0;
+  QVector<WeatherRequest> remaining;
+  for(const WeatherRequest& request : qAsConst(pending))
+  {
+    MetarResult result;
+    if(findCached(request, result))
+    {
+      metars.append(result);
+      cached++;
+    }
+    else if(fetches < maxFetchesPerBatch && handler->getState() == sc::STATEOK)
+    {
+      // Simulator accepts only one observation request at a time
+      SimConnectData data;
+      handler->addWeatherRequest(request);
+      bool fetched = handler->fetchWeatherData(data);
+      fetches++;
+
+      for(const MetarResult& metar : data.getMetars())
+      {
+        // Do not cache results if simulator is paused or not running
+        if(fetched)
+          insertCache(metar);
+        metars.append(metar);
+      }
+    }
+    else
+      remaining.append(request);
+  }
+  handler->addWeatherRequest(WeatherRequest());
+
+  pending.swap(remaining);
+  pendingKeys.clear();
+  for(const WeatherRequest& request : qAsConst(pending))
+    pendingKeys.insert(requestKey(request));
+
+  qDebug() << Q_FUNC_INFO << "fetched" << fetches << "cached" << cached << "pending" << pending.size();
+
+  return fetches;
+}
+
+void WeatherRequestBroker::clear()
+{
+  pending.clear();
+  pendingKeys.clear();
+  stationCache.clear();
+  positionCache.clear();
+}
+
+QString WeatherRequestBroker::requestKey(const WeatherRequest& request)
+{
+  if(!request.getStation().isEmpty())
+    return QStringLiteral("S") + request.getStation().toUpper();
+  else
+  {
+    const atools::geo::Pos& pos = request.getPosition();
+    return QStringLiteral("P") + QString::number(pos.getLonX(), 'f', 5) + QStringLiteral(",") +
+           QString::number(pos.getLatY(), 'f', 5) + QStringLiteral(",") + QString::number(pos.getAltitude(), 'f', 0);
+  }
+}
+
+bool WeatherRequestBroker::findCached(const WeatherRequest& request, MetarResult& result) const
+{
+  QDateTime now = QDateTime::currentDateTimeUtc();
+
+  if(!request.getStation().isEmpty())
+  {
+    auto it = stationCache.constFind(request.getStation().toUpper());
+    if(it != stationCache.constEnd() && !isExpired(it.value(), now))
+    {
+      result = it.value();
+      result.requestIdent = request.getStation();
+      result.requestPos = request.getPosition();
+      return true;
+    }
+  }
+  else if(request.getPosition().isValid())
+  {
+    // Nearest station and interpolated weather do not change much for a close position
+    for(const MetarResult& cachedResult : positionCache)
+    {
+      if(!isExpired(cachedResult, now) &&
+         cachedResult.requestPos.distanceMeterTo(request.getPosition()) <= nearestRadiusMeter)
+      {
+        result = cachedResult;
+        result.requestPos = request.getPosition();
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void WeatherRequestBroker::insertCache(const MetarResult& result)
+{
+  if(!result.requestIdent.isEmpty())
+    stationCache.insert(result.requestIdent.toUpper(), result);
+  else if(result.requestPos.isValid())
+    positionCache.append(result);
+}
+
+bool WeatherRequestBroker::isExpired(const MetarResult& result, const QDateTime& now) const
+{
+  return !result.timestamp.isValid() || result.timestamp.secsTo(now) > timeToLiveSeconds;
+}
+
+void WeatherRequestBroker::removeExpired()
+{
+  QDateTime now = QDateTime::currentDateTimeUtc();
+
+  for(auto it = stationCache.begin(); it != stationCache.end();)
+  {
+    if(isExpired(it.value(), now))
+      it = stationCache.erase(it);
+    else
+      ++it;
+  }
+
+  positionCache.erase(std::remove_if(positionCache.begin(), positionCache.end(),
+                                     [this, &now](const MetarResult& result) -> bool {
+    return isExpired(result, now);
+  }), positionCache.end());
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_SC_WEATHERREQUESTBROKER_H
+#define ATOOLS_FS_SC_WEATHERREQUESTBROKER_H
+
+#include "fs/sc/weatherrequest.h"
+#include "fs/weather/weathertypes.h"
+
+#include <QHash>
+#include <QSet>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class ConnectHandler;
+
+/*
+ * Collects weather requests from all clients between two fetches and answers them in one batch.
+ *
+ * Requests for the same station ident or position are merged. Results are cached for a time to live and
+ * requests are answered from the cache if possible. Requests without station ident are answered from cached
+ * results of nearby positions. Only the remaining ones are passed one by one to the handler, limited to a number
+ * per batch to keep the aircraft updates going. Requests not fetched stay pending for the next batch.
+ *
+ * Not thread safe. DataReaderThread protects access with its handler mutex.
+ */
+class WeatherRequestBroker
+{
+public:
+  WeatherRequestBroker();
+
+  /* Add a request to the next batch. Returns false if an identical request is already pending or it is not valid. */
+  bool addRequest(const atools::fs::sc::WeatherRequest& request);
+
+  /* true if any requests are pending */
+  bool hasRequests() const
+  {
+    return !pending.isEmpty();
+  }
+
+  /* Answer pending requests from the cache or the handler and append the results to metars.
+   * Returns the number of simulator round trips. */
+  int fetch(atools::fs::sc::ConnectHandler *handler, QVector<atools::fs::weather::MetarResult>& metars);
+
+  /* Remove pending requests and cache. Call when connecting to a new simulator session. */
+  void clear();
+
+  /* Cached results are used for this time */
+  void setTimeToLiveSeconds(int value)
+  {
+    timeToLiveSeconds = value;
+  }
+
+  /* Requests without station are answered by cached results within this radius */
+  void setNearestRadiusKm(float value)
+  {
+    nearestRadiusMeter = value * 1000.f;
+  }
+
+  /* Maximum number of handler requests for one batch */
+  void setMaxFetchesPerBatch(int value)
+  {
+    maxFetchesPerBatch = std::max(1, value);
+  }
+
+private:
+  /* Key for merging requests */
+  static QString requestKey(const atools::fs::sc::WeatherRequest& request);
+
+  bool findCached(const atools::fs::sc::WeatherRequest& request, atools::fs::weather::MetarResult& result) const;
+  void insertCache(const atools::fs::weather::MetarResult& result);
+  bool isExpired(const atools::fs::weather::MetarResult& result, const QDateTime& now) const;
+  void removeExpired();
+
+  QVector<atools::fs::sc::WeatherRequest> pending;
+  QSet<QString> pendingKeys;
+
+  /* Results by upper case station ident */
+  QHash<QString, atools::fs::weather::MetarResult> stationCache;
+
+  /* Results of requests without station ident */
+  QVector<atools::fs::weather::MetarResult> positionCache;
+
+  int timeToLiveSeconds = 300, maxFetchesPerBatch = 10;
+  float nearestRadiusMeter = 2000.f;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_WEATHERREQUESTBROKER_H
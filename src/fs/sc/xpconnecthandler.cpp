@@ -41,6 +41,20 @@ XpConnectHandler::~XpConnectHandler()
 
 bool XpConnectHandler::connect()
 {
+  if(ring.isAttached() && !ring.isTerminated())
+  {
+    qDebug() << Q_FUNC_INFO << "Ring already attached";
+    state = STATEOK;
+    return true;
+  }
+
+  // Prefer ring segment of newer plugins
+  if(ring.attach())
+  {
+    state = STATEOK;
+    return true;
+  }
+
   if(sharedMemory.isAttached())
   {
     qDebug() << Q_FUNC_INFO << "Already attached";
@@ -66,8 +80,17 @@ bool XpConnectHandler::connect()
 
 bool XpConnectHandler::fetchData(fs::sc::SimConnectData& data, int radiusKm, fs::sc::Options options)
 {
-  Q_UNUSED(radiusKm)
-  Q_UNUSED(options)
+  if(ring.isAttached())
+  {
+    if(ring.isTerminated())
+    {
+      disconnect();
+      return false;
+    }
+
+    // Converted in place from the newest frame - no lock needed
+    return ring.read(data) && filterData(data, radiusKm, options);
+  }
 
   if(!sharedMemory.isAttached())
   {
@@ -101,14 +124,7 @@ bool XpConnectHandler::fetchData(fs::sc::SimConnectData& data, int radiusKm, fs:
         return false;
       }
 
-      if(data.isUserAircraftValid() && data.getStatus() == OK)
-      {
-        if(!(options & atools::fs::sc::FETCH_AI_AIRCRAFT))
-          // Have to clear this here since the X-Plane plugin has no configuration option
-          data.clearAiAircraft();
-
-        return true;
-      }
+      return filterData(data, radiusKm, options);
     }
     else
       sharedMemory.unlock();
@@ -161,8 +177,25 @@ QString XpConnectHandler::getName() const
   return QLatin1String("XpConnect");
 }
 
+bool XpConnectHandler::filterData(SimConnectData& data, int radiusKm, Options options)
+{
+  if(data.isUserAircraftValid() && data.getStatus() == OK)
+  {
+    if(!(options & atools::fs::sc::FETCH_AI_AIRCRAFT))
+      // Have to clear this here since the X-Plane plugin has no configuration option
+      data.clearAiAircraft();
+    else
+      // Plugin sends all aircraft - apply radius here
+      filterAiByRadius(data, radiusKm);
+
+    return true;
+  }
+  return false;
+}
+
 void XpConnectHandler::disconnect()
 {
+  ring.detach();
   bool result = sharedMemory.detach();
   qDebug() << Q_FUNC_INFO << "result" << result;
   state = DISCONNECTED;
@@ -19,6 +19,7 @@
 #define ATOOLS_XPCONNECTHANDLER_H
 
 #include "fs/sc/connecthandler.h"
+#include "fs/sc/xpconnectring.h"
 
 #include <QSharedMemory>
 #include <functional>
@@ -32,7 +33,9 @@ static const int SHARED_MEMORY_SIZE = 8196;
 static const QLatin1String SHARED_MEMORY_KEY("LittleXpconnect");
 
 /*
- * Reads data from a callback function into SimConnectData.
+ * Reads data from the shared memory of the Xpconnect plugin into SimConnectData.
+ * Uses the ring segment with fixed binary layout if the plugin provides it. Otherwise falls back to the
+ * segment containing a serialized SimConnectData packet.
  */
 class XpConnectHandler :
   public atools::fs::sc::ConnectHandler
@@ -45,7 +48,7 @@ public:
   XpConnectHandler();
   virtual ~XpConnectHandler() override;
 
-  /* Attach to shared memory if available */
+  /* Attach to shared memory if available. Ring segment is preferred. */
   virtual bool connect() override;
 
   /* Always loaded since X-Plane is always available */
@@ -80,6 +83,13 @@ public:
 private:
   void disconnect();
 
+  /* Apply options and radius to fetched data. Returns true if data is valid. */
+  bool filterData(SimConnectData& data, int radiusKm, Options options);
+
+  /* Ring transport with fixed layout */
+  atools::fs::sc::XpConnectRing ring;
+
+  /* Stream transport */
   QSharedMemory sharedMemory;
   atools::fs::sc::State state = DISCONNECTED;
 
@@ -0,0 +1,432 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/sc/xpconnectring.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QDebug>
+#include <QSet>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+using xpring::Aircraft;
+using xpring::UserAircraft;
+using xpring::Frame;
+using xpring::Slot;
+using xpring::Header;
+
+/* Slots start after the header aligned to 64 bytes */
+static Q_DECL_CONSTEXPR int HEADER_SIZE = ((sizeof(Header) + 63) / 64) * 64;
+static Q_DECL_CONSTEXPR int SLOT_SIZE = ((sizeof(Slot) + 63) / 64) * 64;
+
+/* Number of attempts if the writer changes a frame while reading */
+static const int MAX_READ_ATTEMPTS = 3;
+
+/* Comparing to Latin-1 does not allocate - non ASCII strings are simply always assigned */
+template<int SIZE>
+static bool isEqual(const QString& str, const char (&value)[SIZE])
+{
+  return str == QLatin1String(value, static_cast<int>(qstrnlen(value, SIZE)));
+}
+
+template<int SIZE>
+static QString toString(const char (&value)[SIZE])
+{
+  return QString::fromUtf8(value, static_cast<int>(qstrnlen(value, SIZE)));
+}
+
+/* Copy and cut off at array size - no partial UTF-8 characters are removed */
+template<int SIZE>
+static void fromString(char(&value)[SIZE], const QString& str)
+{
+  QByteArray bytes = str.toUtf8();
+  size_t len = std::min(static_cast<size_t>(bytes.size()), static_cast<size_t>(SIZE - 1));
+  std::memcpy(value, bytes.constData(), len);
+  value[len] = '\0';
+}
+
+XpConnectRing::XpConnectRing()
+{
+
+}
+
+XpConnectRing::~XpConnectRing()
+{
+  detach();
+}
+
+int XpConnectRing::segmentSize()
+{
+  return HEADER_SIZE + SLOT_SIZE * xpring::NUM_SLOTS;
+}
+
+bool XpConnectRing::create()
+{
+  detach();
+
+  sharedMemory.setKey(SHARED_MEMORY_RING_KEY);
+  if(!sharedMemory.create(segmentSize(), QSharedMemory::ReadWrite))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot create" << sharedMemory.errorString() << sharedMemory.error();
+    return false;
+  }
+
+  char *base = static_cast<char *>(sharedMemory.data());
+  std::memset(base, 0, static_cast<size_t>(segmentSize()));
+
+  for(int i = 0; i < xpring::NUM_SLOTS; i++)
+    new (base + HEADER_SIZE + SLOT_SIZE * i) Slot;
+
+  Header *hdr = new (base) Header;
+  hdr->numSlots = xpring::NUM_SLOTS;
+  hdr->slotSize = SLOT_SIZE;
+  hdr->version = xpring::VERSION;
+  hdr->writeSequence.store(0, std::memory_order_relaxed);
+  hdr->terminate.store(0, std::memory_order_relaxed);
+
+  // Readers check the magic number last
+  std::atomic_thread_fence(std::memory_order_release);
+  hdr->magicNumber = xpring::MAGIC_NUMBER;
+
+  header = hdr;
+  sequence = 0;
+  qInfo() << Q_FUNC_INFO << "Created" << sharedMemory.key() << "size" << segmentSize();
+  return true;
+}
+
+bool XpConnectRing::attach()
+{
+  detach();
+
+  sharedMemory.setKey(SHARED_MEMORY_RING_KEY);
+  if(!sharedMemory.attach(QSharedMemory::ReadOnly))
+  {
+    if(sharedMemory.error() != QSharedMemory::NotFound)
+      qWarning() << Q_FUNC_INFO << "Cannot attach" << sharedMemory.errorString() << sharedMemory.error();
+    return false;
+  }
+
+  Header *hdr = static_cast<Header *>(const_cast<void *>(sharedMemory.constData()));
+  if(sharedMemory.size() < segmentSize() || hdr->magicNumber != xpring::MAGIC_NUMBER ||
+     hdr->version != xpring::VERSION || hdr->numSlots != xpring::NUM_SLOTS ||
+     hdr->slotSize != static_cast<quint32>(SLOT_SIZE))
+  {
+    qWarning() << Q_FUNC_INFO << "Layout mismatch" << "size" << sharedMemory.size()
+               << "version" << hdr->version << "expected" << xpring::VERSION;
+    sharedMemory.detach();
+    return false;
+  }
+
+  header = hdr;
+  sequence = 0;
+  aircraftPool.clear();
+  qInfo() << Q_FUNC_INFO << "Attached to" << sharedMemory.key() << "native" << sharedMemory.nativeKey();
+  return true;
+}
+
+void XpConnectRing::detach()
+{
+  if(sharedMemory.isAttached())
+    sharedMemory.detach();
+  header = nullptr;
+  aircraftPool.clear();
+}
+
+Slot *XpConnectRing::slot(quint64 seq) const
+{
+  char *base = reinterpret_cast<char *>(header);
+  return reinterpret_cast<Slot *>(base + HEADER_SIZE + SLOT_SIZE * static_cast<int>(seq % xpring::NUM_SLOTS));
+}
+
+void XpConnectRing::write(const SimConnectData& data)
+{
+  if(header == nullptr)
+    return;
+
+  quint64 seq = header->writeSequence.load(std::memory_order_relaxed) + 1;
+  Slot *next = slot(seq);
+
+  // Mark slot as being changed before touching the frame
+  next->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  Frame& frame = next->frame;
+  frame.timestampMs = QDateTime::currentMSecsSinceEpoch();
+  writeUserAircraft(data.getUserAircraftConst(), frame.userAircraft);
+
+  const QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraftConst();
+  int num = std::min(static_cast<int>(aiAircraft.size()), xpring::MAX_AI_AIRCRAFT);
+  for(int i = 0; i < num; i++)
+    writeAircraft(aiAircraft.at(i), frame.aiAircraft[i]);
+  frame.numAiAircraft = static_cast<quint32>(num);
+
+  next->sequence.store(seq, std::memory_order_release);
+  header->writeSequence.store(seq, std::memory_order_release);
+  sequence = seq;
+}
+
+void XpConnectRing::setTerminate()
+{
+  if(header != nullptr)
+    header->terminate.store(1, std::memory_order_release);
+}
+
+bool XpConnectRing::isTerminated() const
+{
+  return header != nullptr && header->terminate.load(std::memory_order_acquire) != 0;
+}
+
+bool XpConnectRing::read(SimConnectData& data)
+{
+  if(header == nullptr)
+    return false;
+
+  for(int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+  {
+    quint64 seq = header->writeSequence.load(std::memory_order_acquire);
+    if(seq == 0)
+      // Nothing written yet
+      return false;
+
+    const Slot *current = slot(seq);
+    if(current->sequence.load(std::memory_order_acquire) != seq)
+      // Writer is already overwriting this slot - start over with the newer sequence
+      continue;
+
+    // Convert in place - no copy of the frame
+    const Frame& frame = current->frame;
+    readUserAircraft(frame.userAircraft, data.getUserAircraft());
+
+    QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+    int num = std::min(static_cast<int>(frame.numAiAircraft), xpring::MAX_AI_AIRCRAFT);
+    aiAircraft.clear();
+    aiAircraft.reserve(num);
+    for(int i = 0; i < num; i++)
+    {
+      // Re-use pooled aircraft to keep strings if unchanged
+      SimConnectAircraft& aircraft = aircraftPool[frame.aiAircraft[i].objectId];
+      readAircraft(frame.aiAircraft[i], aircraft);
+      aiAircraft.append(aircraft);
+    }
+
+    // Check if the writer changed the slot while converting
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(current->sequence.load(std::memory_order_relaxed) == seq)
+    {
+      sequence = seq;
+
+      // Remove aircraft which are gone from pool if it grows too large
+      if(aircraftPool.size() > num * 2 + 100)
+      {
+        QSet<quint32> ids;
+        for(int i = 0; i < num; i++)
+          ids.insert(frame.aiAircraft[i].objectId);
+
+        for(auto it = aircraftPool.begin(); it != aircraftPool.end();)
+        {
+          if(!ids.contains(it.key()))
+            it = aircraftPool.erase(it);
+          else
+            ++it;
+        }
+      }
+
+      data.updateIndexesAndKeys();
+      return true;
+    }
+  }
+
+  qWarning() << Q_FUNC_INFO << "Cannot read consistent frame";
+  return false;
+}
+
+void XpConnectRing::writeAircraft(const SimConnectAircraft& aircraft, Aircraft& ringAircraft)
+{
+  const SimConnectAircraftInfo *info = aircraft.info.constData();
+  fromString(ringAircraft.title, info->airplaneTitle);
+  fromString(ringAircraft.type, info->airplaneType);
+  fromString(ringAircraft.model, info->airplaneModel);
+  fromString(ringAircraft.registration, info->airplaneReg);
+  fromString(ringAircraft.airline, info->airplaneAirline);
+  fromString(ringAircraft.flightnumber, info->airplaneFlightnumber);
+  fromString(ringAircraft.fromIdent, info->fromIdent);
+  fromString(ringAircraft.toIdent, info->toIdent);
+
+  ringAircraft.lonX = aircraft.position.getLonX();
+  ringAircraft.latY = aircraft.position.getLatY();
+  ringAircraft.altitudeFt = aircraft.position.getAltitude();
+  ringAircraft.headingTrueDeg = aircraft.headingTrueDeg;
+  ringAircraft.headingMagDeg = aircraft.headingMagDeg;
+  ringAircraft.groundSpeedKts = aircraft.groundSpeedKts;
+  ringAircraft.indicatedAltitudeFt = aircraft.indicatedAltitudeFt;
+  ringAircraft.indicatedSpeedKts = aircraft.indicatedSpeedKts;
+  ringAircraft.trueAirspeedKts = aircraft.trueAirspeedKts;
+  ringAircraft.machSpeed = aircraft.machSpeed;
+  ringAircraft.verticalSpeedFeetPerMin = aircraft.verticalSpeedFeetPerMin;
+
+  ringAircraft.objectId = aircraft.objectId;
+  ringAircraft.modelRadiusFt = aircraft.modelRadiusFt;
+  ringAircraft.wingSpanFt = aircraft.wingSpanFt;
+  ringAircraft.deckHeight = aircraft.deckHeight;
+  ringAircraft.transponderCode = aircraft.transponderCode;
+  ringAircraft.flags = static_cast<quint16>(aircraft.flags);
+  ringAircraft.dataFlags = static_cast<quint8>(aircraft.dataFlags);
+  ringAircraft.category = static_cast<quint8>(aircraft.category);
+  ringAircraft.engineType = static_cast<quint8>(aircraft.engineType);
+  ringAircraft.numberOfEngines = aircraft.numberOfEngines;
+}
+
+void XpConnectRing::writeUserAircraft(const SimConnectUserAircraft& aircraft, UserAircraft& ringAircraft)
+{
+  writeAircraft(aircraft, ringAircraft.aircraft);
+
+  ringAircraft.altitudeAboveGroundFt = aircraft.altitudeAboveGroundFt;
+  ringAircraft.groundAltitudeFt = aircraft.groundAltitudeFt;
+  ringAircraft.altitudeAutopilotFt = aircraft.altitudeAutopilotFt;
+  ringAircraft.windSpeedKts = aircraft.windSpeedKts;
+  ringAircraft.windDirectionDegT = aircraft.windDirectionDegT;
+  ringAircraft.ambientTemperatureCelsius = aircraft.ambientTemperatureCelsius;
+  ringAircraft.totalAirTemperatureCelsius = aircraft.totalAirTemperatureCelsius;
+  ringAircraft.seaLevelPressureMbar = aircraft.seaLevelPressureMbar;
+  ringAircraft.airplaneTotalWeightLbs = aircraft.airplaneTotalWeightLbs;
+  ringAircraft.airplaneMaxGrossWeightLbs = aircraft.airplaneMaxGrossWeightLbs;
+  ringAircraft.airplaneEmptyWeightLbs = aircraft.airplaneEmptyWeightLbs;
+  ringAircraft.fuelTotalQuantityGallons = aircraft.fuelTotalQuantityGallons;
+  ringAircraft.fuelTotalWeightLbs = aircraft.fuelTotalWeightLbs;
+  ringAircraft.fuelFlowPPH = aircraft.fuelFlowPPH;
+  ringAircraft.fuelFlowGPH = aircraft.fuelFlowGPH;
+  ringAircraft.magVarDeg = aircraft.magVarDeg;
+  ringAircraft.ambientVisibilityMeter = aircraft.ambientVisibilityMeter;
+  ringAircraft.trackMagDeg = aircraft.trackMagDeg;
+  ringAircraft.trackTrueDeg = aircraft.trackTrueDeg;
+
+  ringAircraft.pitotIcePercent = aircraft.pitotIcePercent;
+  ringAircraft.structuralIcePercent = aircraft.structuralIcePercent;
+  ringAircraft.aoaIcePercent = aircraft.aoaIcePercent;
+  ringAircraft.inletIcePercent = aircraft.inletIcePercent;
+  ringAircraft.propIcePercent = aircraft.propIcePercent;
+  ringAircraft.statIcePercent = aircraft.statIcePercent;
+  ringAircraft.windowIcePercent = aircraft.windowIcePercent;
+  ringAircraft.carbIcePercent = aircraft.carbIcePercent;
+
+  ringAircraft.zuluDateTimeMs = aircraft.zuluDateTime.isValid() ? aircraft.zuluDateTime.toMSecsSinceEpoch() : 0;
+  ringAircraft.localDateTimeMs = aircraft.localDateTime.isValid() ? aircraft.localDateTime.toMSecsSinceEpoch() : 0;
+  ringAircraft.localOffsetSeconds = aircraft.localDateTime.isValid() ? aircraft.localDateTime.offsetFromUtc() : 0;
+}
+
+void XpConnectRing::readAircraft(const Aircraft& ringAircraft, SimConnectAircraft& aircraft)
+{
+  // Keep the shared names record if nothing changed
+  const SimConnectAircraftInfo *oldInfo = aircraft.info.constData();
+  if(!isEqual(oldInfo->airplaneTitle, ringAircraft.title) ||
+     !isEqual(oldInfo->airplaneType, ringAircraft.type) ||
+     !isEqual(oldInfo->airplaneModel, ringAircraft.model) ||
+     !isEqual(oldInfo->airplaneReg, ringAircraft.registration) ||
+     !isEqual(oldInfo->airplaneAirline, ringAircraft.airline) ||
+     !isEqual(oldInfo->airplaneFlightnumber, ringAircraft.flightnumber) ||
+     !isEqual(oldInfo->fromIdent, ringAircraft.fromIdent) ||
+     !isEqual(oldInfo->toIdent, ringAircraft.toIdent))
+  {
+    SimConnectAircraftInfo *info = aircraft.info.data();
+    info->airplaneTitle = toString(ringAircraft.title);
+    info->airplaneType = toString(ringAircraft.type);
+    info->airplaneModel = toString(ringAircraft.model);
+    info->airplaneReg = toString(ringAircraft.registration);
+    info->airplaneAirline = toString(ringAircraft.airline);
+    info->airplaneFlightnumber = toString(ringAircraft.flightnumber);
+    info->fromIdent = toString(ringAircraft.fromIdent);
+    info->toIdent = toString(ringAircraft.toIdent);
+  }
+
+  aircraft.position = atools::geo::Pos(ringAircraft.lonX, ringAircraft.latY,
+                                       static_cast<double>(ringAircraft.altitudeFt));
+  aircraft.headingTrueDeg = ringAircraft.headingTrueDeg;
+  aircraft.headingMagDeg = ringAircraft.headingMagDeg;
+  aircraft.groundSpeedKts = ringAircraft.groundSpeedKts;
+  aircraft.indicatedAltitudeFt = ringAircraft.indicatedAltitudeFt;
+  aircraft.indicatedSpeedKts = ringAircraft.indicatedSpeedKts;
+  aircraft.trueAirspeedKts = ringAircraft.trueAirspeedKts;
+  aircraft.machSpeed = ringAircraft.machSpeed;
+  aircraft.verticalSpeedFeetPerMin = ringAircraft.verticalSpeedFeetPerMin;
+
+  aircraft.objectId = ringAircraft.objectId;
+  aircraft.modelRadiusFt = ringAircraft.modelRadiusFt;
+  aircraft.wingSpanFt = ringAircraft.wingSpanFt;
+  aircraft.deckHeight = ringAircraft.deckHeight;
+  aircraft.transponderCode = ringAircraft.transponderCode;
+  aircraft.flags = AircraftFlags(ringAircraft.flags);
+  aircraft.dataFlags = static_cast<DataFlags>(ringAircraft.dataFlags);
+  aircraft.category = static_cast<Category>(ringAircraft.category);
+  aircraft.engineType = static_cast<EngineType>(ringAircraft.engineType);
+  aircraft.numberOfEngines = ringAircraft.numberOfEngines;
+}
+
+void XpConnectRing::readUserAircraft(const UserAircraft& ringAircraft, SimConnectUserAircraft& aircraft)
+{
+  readAircraft(ringAircraft.aircraft, aircraft);
+
+  aircraft.altitudeAboveGroundFt = ringAircraft.altitudeAboveGroundFt;
+  aircraft.groundAltitudeFt = ringAircraft.groundAltitudeFt;
+  aircraft.altitudeAutopilotFt = ringAircraft.altitudeAutopilotFt;
+  aircraft.windSpeedKts = ringAircraft.windSpeedKts;
+  aircraft.windDirectionDegT = ringAircraft.windDirectionDegT;
+  aircraft.ambientTemperatureCelsius = ringAircraft.ambientTemperatureCelsius;
+  aircraft.totalAirTemperatureCelsius = ringAircraft.totalAirTemperatureCelsius;
+  aircraft.seaLevelPressureMbar = ringAircraft.seaLevelPressureMbar;
+  aircraft.airplaneTotalWeightLbs = ringAircraft.airplaneTotalWeightLbs;
+  aircraft.airplaneMaxGrossWeightLbs = ringAircraft.airplaneMaxGrossWeightLbs;
+  aircraft.airplaneEmptyWeightLbs = ringAircraft.airplaneEmptyWeightLbs;
+  aircraft.fuelTotalQuantityGallons = ringAircraft.fuelTotalQuantityGallons;
+  aircraft.fuelTotalWeightLbs = ringAircraft.fuelTotalWeightLbs;
+  aircraft.fuelFlowPPH = ringAircraft.fuelFlowPPH;
+  aircraft.fuelFlowGPH = ringAircraft.fuelFlowGPH;
+  aircraft.magVarDeg = ringAircraft.magVarDeg;
+  aircraft.ambientVisibilityMeter = ringAircraft.ambientVisibilityMeter;
+  aircraft.trackMagDeg = ringAircraft.trackMagDeg;
+  aircraft.trackTrueDeg = ringAircraft.trackTrueDeg;
+
+  aircraft.pitotIcePercent = ringAircraft.pitotIcePercent;
+  aircraft.structuralIcePercent = ringAircraft.structuralIcePercent;
+  aircraft.aoaIcePercent = ringAircraft.aoaIcePercent;
+  aircraft.inletIcePercent = ringAircraft.inletIcePercent;
+  aircraft.propIcePercent = ringAircraft.propIcePercent;
+  aircraft.statIcePercent = ringAircraft.statIcePercent;
+  aircraft.windowIcePercent = ringAircraft.windowIcePercent;
+  aircraft.carbIcePercent = ringAircraft.carbIcePercent;
+
+  if(ringAircraft.zuluDateTimeMs != 0)
+    aircraft.zuluDateTime = QDateTime::fromMSecsSinceEpoch(ringAircraft.zuluDateTimeMs, Qt::UTC);
+  else
+    aircraft.zuluDateTime = QDateTime();
+
+  if(ringAircraft.localDateTimeMs != 0)
+    aircraft.localDateTime = QDateTime::fromMSecsSinceEpoch(ringAircraft.localDateTimeMs, Qt::OffsetFromUTC,
+                                                            ringAircraft.localOffsetSeconds);
+  else
+    aircraft.localDateTime = QDateTime();
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
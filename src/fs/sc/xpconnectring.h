@@ -0,0 +1,188 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_SC_XPCONNECTRING_H
+#define ATOOLS_FS_SC_XPCONNECTRING_H
+
+#include <QHash>
+#include <QSharedMemory>
+
+#include <atomic>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+class SimConnectAircraft;
+class SimConnectUserAircraft;
+
+/* Key for the ring segment. Used before falling back to the stream segment SHARED_MEMORY_KEY. */
+static const QLatin1String SHARED_MEMORY_RING_KEY("LittleXpconnectRing");
+
+/* Fixed binary layout shared between the Xpconnect plugin and XpConnectHandler. Both sides have to use the
+ * same version. Strings are zero terminated UTF-8 and cut off at the array size. */
+namespace xpring {
+
+static Q_DECL_CONSTEXPR quint32 MAGIC_NUMBER = 0x58505247;
+static Q_DECL_CONSTEXPR quint32 VERSION = 1;
+
+/* Number of frames in the ring. The writer needs this number of frames to overwrite a slot being read. */
+static Q_DECL_CONSTEXPR int NUM_SLOTS = 4;
+
+/* Maximum number of AI aircraft per frame. Aircraft above this are dropped. */
+static Q_DECL_CONSTEXPR int MAX_AI_AIRCRAFT = 512;
+
+struct Aircraft
+{
+  char title[128], type[32], model[32], registration[32], airline[64], flightnumber[16], fromIdent[8], toIdent[8];
+
+  double lonX, latY;
+  float altitudeFt, headingTrueDeg, headingMagDeg, groundSpeedKts, indicatedAltitudeFt, indicatedSpeedKts,
+        trueAirspeedKts, machSpeed, verticalSpeedFeetPerMin;
+
+  quint32 objectId;
+  quint16 modelRadiusFt, wingSpanFt, deckHeight;
+  qint16 transponderCode;
+  quint16 flags; // AircraftFlags
+  quint8 dataFlags, category, engineType, numberOfEngines, reserved[2];
+};
+
+struct UserAircraft
+{
+  Aircraft aircraft;
+
+  float altitudeAboveGroundFt, groundAltitudeFt, altitudeAutopilotFt, windSpeedKts, windDirectionDegT,
+        ambientTemperatureCelsius, totalAirTemperatureCelsius, seaLevelPressureMbar, airplaneTotalWeightLbs,
+        airplaneMaxGrossWeightLbs, airplaneEmptyWeightLbs, fuelTotalQuantityGallons, fuelTotalWeightLbs,
+        fuelFlowPPH, fuelFlowGPH, magVarDeg, ambientVisibilityMeter, trackMagDeg, trackTrueDeg;
+
+  quint8 pitotIcePercent, structuralIcePercent, aoaIcePercent, inletIcePercent, propIcePercent, statIcePercent,
+         windowIcePercent, carbIcePercent;
+
+  /* Milliseconds since epoch and offset of local time to UTC */
+  qint64 zuluDateTimeMs;
+  qint64 localDateTimeMs;
+  qint32 localOffsetSeconds, reserved;
+};
+
+struct Frame
+{
+  qint64 timestampMs; // Milliseconds since epoch when written
+  quint32 numAiAircraft, reserved;
+  UserAircraft userAircraft;
+  Aircraft aiAircraft[MAX_AI_AIRCRAFT];
+};
+
+struct Slot
+{
+  /* Sequence number of the frame in this slot. 0 while the writer changes the frame. */
+  std::atomic<quint64> sequence;
+  Frame frame;
+};
+
+struct Header
+{
+  quint32 magicNumber, version, numSlots, slotSize;
+
+  /* Sequence number of the last complete frame. 0 if nothing was written yet. Frame is in slot sequence % NUM_SLOTS */
+  std::atomic<quint64> writeSequence;
+
+  /* Set by the writer when X-Plane exits */
+  std::atomic<quint32> terminate;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory needs lock free 64 bit atomics");
+
+} // namespace xpring
+
+/*
+ * Shared memory ring of frames in fixed binary layout between the Xpconnect plugin and XpConnectHandler.
+ *
+ * The plugin creates the segment and writes frames. The handler attaches read only and converts the newest frame
+ * in place into SimConnectData without the stream serialization. No lock is used. Each slot carries a sequence
+ * number which is checked before and after reading and the frame is read again if the writer changed it meanwhile.
+ *
+ * String data of AI aircraft is only converted if changed. Aircraft are kept by object id between reads for this.
+ */
+class XpConnectRing
+{
+public:
+  XpConnectRing();
+  ~XpConnectRing();
+
+  XpConnectRing(const XpConnectRing& other) = delete;
+  XpConnectRing& operator=(const XpConnectRing& other) = delete;
+
+  /* Writer side. Create and initialize the segment. */
+  bool create();
+
+  /* Reader side. Attach to the segment of the writer. Fails if not available or layout does not match. */
+  bool attach();
+
+  void detach();
+
+  bool isAttached() const
+  {
+    return header != nullptr;
+  }
+
+  /* Writer side. Copy data into the next slot and publish it. */
+  void write(const atools::fs::sc::SimConnectData& data);
+
+  /* Writer side. Tell readers to detach. */
+  void setTerminate();
+
+  /* Reader side. Read the newest frame into data.
+   * Returns false if nothing was written yet or the frame could not be read consistently. */
+  bool read(atools::fs::sc::SimConnectData& data);
+
+  /* Reader side. true if the writer has terminated. */
+  bool isTerminated() const;
+
+  /* Sequence number of the last frame read or written */
+  quint64 getSequence() const
+  {
+    return sequence;
+  }
+
+  /* Total size of the segment */
+  static int segmentSize();
+
+private:
+  static void writeAircraft(const atools::fs::sc::SimConnectAircraft& aircraft, xpring::Aircraft& ringAircraft);
+  static void writeUserAircraft(const atools::fs::sc::SimConnectUserAircraft& aircraft,
+                                xpring::UserAircraft& ringAircraft);
+  static void readAircraft(const xpring::Aircraft& ringAircraft, atools::fs::sc::SimConnectAircraft& aircraft);
+  static void readUserAircraft(const xpring::UserAircraft& ringAircraft,
+                               atools::fs::sc::SimConnectUserAircraft& aircraft);
+
+  xpring::Slot *slot(quint64 seq) const;
+
+  QSharedMemory sharedMemory;
+  xpring::Header *header = nullptr;
+  quint64 sequence = 0;
+
+  /* AI aircraft from the last read by object id to keep the string record */
+  QHash<quint32, atools::fs::sc::SimConnectAircraft> aircraftPool;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_XPCONNECTRING_H
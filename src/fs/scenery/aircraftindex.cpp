@@ -20,10 +20,17 @@
 #include "atools.h"
 #include "fs/scenery/manifestjson.h"
 #include "fs/scenery/layoutjson.h"
+#include "exception.h"
+#include "io/fastinireader.h"
+#include "util/parallel.h"
 
+#include <QAtomicInt>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
-#include <QTextStream>
+#include <QSaveFile>
 #include <QStringBuilder>
+#include <QVector>
 #include <QDebug>
 
 namespace atools {
@@ -36,86 +43,340 @@ void AircraftIndex::loadIndex(const QStringList& basePaths)
   {
     clear();
     loadedBasePaths = basePaths;
+    scan();
+  }
+}
 
-    qDebug() << Q_FUNC_INFO << "Loading from" << basePaths << "...";
+void AircraftIndex::scan()
+{
+  qDebug() << Q_FUNC_INFO << "Loading from" << loadedBasePaths << "...";
 
-    for(const QString& path : basePaths)
+  aircraftShortToFullPathMap.clear();
+
+  QFileInfoList addonDirs;
+  for(const QString& path : loadedBasePaths)
+    // dir = .../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Official/OneStore
+    addonDirs.append(QDir(path).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot));
+
+  // Validate cache and read changed manifests and layouts in parallel
+  QVector<AddonEntry> addons(addonDirs.size());
+  QAtomicInt numRead;
+  const QHash<QString, AddonEntry>& cache = addonCache;
+  atools::util::parallelFor(addonDirs.size(), 0,
+                            [&addonDirs, &addons, &numRead, &cache](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
     {
-      // dir = .../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Official/OneStore
-      QDir dir(path);
-      for(const QFileInfo& addonDir : dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+      // addonDir = .../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Official/OneStore/asobo-aircraft-208b-grand-caravan-ex
+      const QFileInfo& addonDir = addonDirs.at(i);
+      QString manifestPath = addonDir.filePath() + QDir::separator() + "manifest.json";
+      QString layoutPath = addonDir.filePath() + QDir::separator() + "layout.json";
+
+      AddonEntry& addon = addons[i];
+      addon.manifest = fileStamp(manifestPath);
+      addon.layout = fileStamp(layoutPath);
+
+      auto it = cache.constFind(addonDir.filePath());
+      if(it != cache.constEnd() && it->manifest == addon.manifest && it->layout == addon.layout)
       {
-        // addonDir = .../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Official/OneStore/asobo-aircraft-208b-grand-caravan-ex
+        // Unchanged
+        addon.cfgPaths = it->cfgPaths;
+        continue;
+      }
 
-        // Read manifest and check for aircraft
-        ManifestJson manifest;
-        manifest.read(addonDir.filePath() + QDir::separator() + "manifest.json");
-        if(manifest.isValid() && manifest.isAircraft())
+      numRead.ref();
+
+      // Read manifest and check for aircraft
+      ManifestJson manifest;
+      manifest.read(manifestPath);
+      if(manifest.isValid() && manifest.isAircraft())
+      {
+        // Find aircraft.cfg relative location in manifest
+        LayoutJson layout;
+        layout.read(layoutPath);
+        if(layout.isValid())
         {
-          // Find aircraft.cfg relative location in manifest
-          LayoutJson layout;
-          layout.read(addonDir.filePath() + QDir::separator() + "layout.json");
-          if(layout.isValid())
+          // There may be more than one aircraft.cfg, e.g. for wheeled and floats
+          for(const QString& layoutCfgPath : layout.getAircraftCfgPaths())
           {
-            // There may be more than one aircraft.cfg, e.g. for wheeled and floats
-            for(const QString& layoutPath : layout.getAircraftCfgPaths())
-            {
-              // This is the hashmap key returned by SimConnect_RequestSystemState(EVENT_AIRCRAFT_LOADED, ...)
-              // SimObjects/Airplanes/Asobo_208B_GRAND_CARAVAN_EX/aircraft.cfg
-              QString cfgPathKey = QDir::cleanPath(layoutPath);
-              QFileInfo fullCfgPathValue(addonDir.filePath() + QDir::separator() + cfgPathKey);
-
-              if(fullCfgPathValue.exists() && fullCfgPathValue.isFile())
-                aircraftShortToFullPathMap.insert(cfgPathKey.toLower(), atools::cleanPath(fullCfgPathValue.canonicalFilePath()));
-            }
+            // This is the hashmap key returned by SimConnect_RequestSystemState(EVENT_AIRCRAFT_LOADED, ...)
+            // SimObjects/Airplanes/Asobo_208B_GRAND_CARAVAN_EX/aircraft.cfg
+            QString cfgPathKey = QDir::cleanPath(layoutCfgPath);
+            QFileInfo fullCfgPathValue(addonDir.filePath() + QDir::separator() + cfgPathKey);
+
+            if(fullCfgPathValue.exists() && fullCfgPathValue.isFile())
+              addon.cfgPaths.append(std::make_pair(cfgPathKey.toLower(),
+                                                   atools::cleanPath(fullCfgPathValue.canonicalFilePath())));
           }
         }
       }
     }
-    qDebug() << Q_FUNC_INFO << "loading done.";
+  }, 8);
+
+  // Insert in directory order to keep the result independent of thread timing
+  // Cache keeps only add-ons which still exist
+  QHash<QString, AddonEntry> newAddonCache;
+  newAddonCache.reserve(addons.size());
+  for(int i = 0; i < addons.size(); i++)
+  {
+    const AddonEntry& addon = addons.at(i);
+    for(const std::pair<QString, QString>& path : addon.cfgPaths)
+      aircraftShortToFullPathMap.insert(path.first, path.second);
+    newAddonCache.insert(addonDirs.at(i).filePath(), addon);
   }
+  addonCache.swap(newAddonCache);
+
+  qDebug() << Q_FUNC_INFO << "loading done. Read" << numRead.loadAcquire() << "of" << addonDirs.size() << "add-ons.";
+}
+
+void AircraftIndex::pathsUpdated(const QStringList& paths)
+{
+  for(const QString& changedPath : paths)
+  {
+    QString path = QDir::cleanPath(QDir::fromNativeSeparators(changedPath));
+
+    // Drop add-ons containing the changed path or below it
+    for(auto it = addonCache.begin(); it != addonCache.end();)
+    {
+      QString addonPath = QDir::fromNativeSeparators(it.key());
+      if(isSameOrBelow(path, addonPath) || isSameOrBelow(addonPath, path))
+        it = addonCache.erase(it);
+      else
+        ++it;
+    }
+
+    for(auto it = cfgCache.begin(); it != cfgCache.end();)
+    {
+      if(isSameOrBelow(QDir::fromNativeSeparators(it.key()), path))
+        it = cfgCache.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  // Type designators are revalidated against the file cache on next access
+  shortPathToTypeDesMap.clear();
+  scan();
+}
+
+bool AircraftIndex::isSameOrBelow(const QString& path, const QString& parent)
+{
+  return path.compare(parent, Qt::CaseInsensitive) == 0 ||
+         (path.startsWith(parent, Qt::CaseInsensitive) && path.size() > parent.size() && path.at(parent.size()) == '/');
+}
+
+void AircraftIndex::loadIcaoTypeDesignators()
+{
+  // Collect all files not read yet or changed
+  QStringList keys, filenames;
+  QVector<FileStamp> stamps;
+  for(auto it = aircraftShortToFullPathMap.constBegin(); it != aircraftShortToFullPathMap.constEnd(); ++it)
+  {
+    if(shortPathToTypeDesMap.contains(it.key()))
+      continue;
+
+    FileStamp stamp = fileStamp(it.value());
+    auto cacheIt = cfgCache.constFind(it.value());
+    if(cacheIt != cfgCache.constEnd() && cacheIt->stamp == stamp)
+      shortPathToTypeDesMap.insert(it.key(), cacheIt->typeDesignator);
+    else
+    {
+      keys.append(it.key());
+      filenames.append(it.value());
+      stamps.append(stamp);
+    }
+  }
+
+  // Each index is written by one thread only
+  QVector<QString> typeDesignators(filenames.size());
+  atools::io::FastIniReader::readFiles(filenames,
+                                       [&typeDesignators](int index, const atools::io::FastIniReader& reader) -> void {
+    typeDesignators[index] = typeDesignator(reader);
+  });
+
+  // Add empty values for missing files too to avoid re-reading
+  for(int i = 0; i < keys.size(); i++)
+  {
+    shortPathToTypeDesMap.insert(keys.at(i), typeDesignators.at(i));
+    cfgCache.insert(filenames.at(i), CfgEntry({stamps.at(i), typeDesignators.at(i)}));
+  }
+
+  qDebug() << Q_FUNC_INFO << "Read" << filenames.size() << "aircraft.cfg files";
 }
 
 QString AircraftIndex::getIcaoTypeDesignator(const QString& aircraftCfgFilepath)
 {
   QString aircraftCfgKey = QDir::cleanPath(aircraftCfgFilepath).toLower();
-  QString typeDesignator = shortPathToTypeDesMap.value(aircraftCfgKey);
 
-  if(typeDesignator.isEmpty())
-  {
-    // Nothing in index yet - read aircraft.cfg file
+  auto it = shortPathToTypeDesMap.constFind(aircraftCfgKey);
+  if(it != shortPathToTypeDesMap.constEnd())
+    return it.value();
+
+  // Nothing in index yet - read aircraft.cfg file or get it from file cache
+  QString typeDesignator = readTypeDesignator(aircraftShortToFullPathMap.value(aircraftCfgKey));
 
-    // Get full filename for key
-    QString aircraftCfgPath = aircraftShortToFullPathMap.value(aircraftCfgKey);
+  // Add designator to index or empty value in case of missing file to avoid re-reading
+  shortPathToTypeDesMap.insert(aircraftCfgKey, typeDesignator);
 
+  return typeDesignator;
+}
+
+QString AircraftIndex::readTypeDesignator(const QString& fullPath)
+{
+  if(fullPath.isEmpty())
+    return QString();
+
+  FileStamp stamp = fileStamp(fullPath);
+  auto it = cfgCache.constFind(fullPath);
+  if(it != cfgCache.constEnd() && it->stamp == stamp)
+    return it->typeDesignator;
+
+  QString typeDesignator;
+  try
+  {
     // Read type designator from aircraft.cfg file
-    QFile file(aircraftCfgPath);
-    if(file.open(QIODevice::ReadOnly))
-    {
-      QTextStream stream(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-      stream.setCodec("UTF-8");
-#endif
-      stream.setAutoDetectUnicode(true);
+    atools::io::FastIniReader reader;
+    reader.read(fullPath);
+    typeDesignator = AircraftIndex::typeDesignator(reader);
+  }
+  catch(atools::Exception&)
+  {
+    // Ignore missing files
+  }
 
-      while(!stream.atEnd())
-      {
-        QString line = stream.readLine().trimmed();
+  cfgCache.insert(fullPath, CfgEntry({stamp, typeDesignator}));
+  return typeDesignator;
+}
 
-        if(line.startsWith("icao_type_designator", Qt::CaseInsensitive)) // icao_type_designator = "A20N"
-        {
-          typeDesignator = line.section('=', 1).remove('"').trimmed();
-          break;
-        }
-      }
-      file.close();
+QString AircraftIndex::typeDesignator(const atools::io::FastIniReader& reader)
+{
+  // icao_type_designator = "A20N"
+  return reader.findValueString("icao_type_designator").remove('"').trimmed();
+}
+
+AircraftIndex::FileStamp AircraftIndex::fileStamp(const QString& filepath)
+{
+  FileStamp stamp;
+  QFileInfo fileinfo(filepath);
+  if(fileinfo.exists())
+  {
+    stamp.size = fileinfo.size();
+    stamp.lastModified = fileinfo.lastModified().toMSecsSinceEpoch();
+  }
+  return stamp;
+}
+
+bool AircraftIndex::loadCache(const QString& filename)
+{
+  addonCache.clear();
+  cfgCache.clear();
+
+  QFile file(filename);
+  if(!file.exists())
+    return false;
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read cache" << filename << ":" << file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magic;
+  quint16 version;
+  in >> magic >> version;
+
+  if(magic != CACHE_MAGIC_NUMBER || version != CACHE_VERSION)
+  {
+    qInfo() << Q_FUNC_INFO << "Cache" << filename << "has invalid format or version";
+    return false;
+  }
+
+  quint32 numAddons = 0;
+  in >> numAddons;
+  for(quint32 i = 0; i < numAddons && in.status() == QDataStream::Ok; i++)
+  {
+    QString path;
+    AddonEntry addon;
+    quint32 numCfg = 0;
+    in >> path >> addon.manifest.size >> addon.manifest.lastModified >> addon.layout.size >> addon.layout.lastModified
+    >> numCfg;
+
+    for(quint32 j = 0; j < numCfg && in.status() == QDataStream::Ok; j++)
+    {
+      std::pair<QString, QString> cfgPath;
+      in >> cfgPath.first >> cfgPath.second;
+      addon.cfgPaths.append(cfgPath);
     }
+    addonCache.insert(path, addon);
+  }
 
-    // Add designator to index or empty value in case of missing file to avoid re-reading
-    shortPathToTypeDesMap.insert(aircraftCfgKey, typeDesignator);
+  quint32 numCfg = 0;
+  in >> numCfg;
+  for(quint32 i = 0; i < numCfg && in.status() == QDataStream::Ok; i++)
+  {
+    QString path;
+    CfgEntry cfg;
+    in >> path >> cfg.stamp.size >> cfg.stamp.lastModified >> cfg.typeDesignator;
+    cfgCache.insert(path, cfg);
   }
 
-  return typeDesignator;
+  if(in.status() != QDataStream::Ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Cache" << filename << "is truncated";
+    addonCache.clear();
+    cfgCache.clear();
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << addonCache.size() << "add-ons and" << cfgCache.size()
+           << "aircraft.cfg files from" << filename;
+  return true;
+}
+
+void AircraftIndex::saveCache(const QString& filename) const
+{
+  QSaveFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out << CACHE_MAGIC_NUMBER << CACHE_VERSION;
+
+    out << static_cast<quint32>(addonCache.size());
+    for(auto it = addonCache.constBegin(); it != addonCache.constEnd(); ++it)
+    {
+      const AddonEntry& addon = it.value();
+      out << it.key() << addon.manifest.size << addon.manifest.lastModified << addon.layout.size
+          << addon.layout.lastModified << static_cast<quint32>(addon.cfgPaths.size());
+      for(const std::pair<QString, QString>& cfgPath : addon.cfgPaths)
+        out << cfgPath.first << cfgPath.second;
+    }
+
+    // Keep only files which are part of the current index
+    QVector<QString> cfgPaths;
+    for(const QString& path : aircraftShortToFullPathMap)
+    {
+      if(cfgCache.contains(path))
+        cfgPaths.append(path);
+    }
+
+    out << static_cast<quint32>(cfgPaths.size());
+    for(const QString& path : cfgPaths)
+    {
+      const CfgEntry& cfg = cfgCache[path];
+      out << path << cfg.stamp.size << cfg.stamp.lastModified << cfg.typeDesignator;
+    }
+
+    if(out.status() != QDataStream::Ok || !file.commit())
+      qWarning() << Q_FUNC_INFO << "Cannot write cache" << filename << ":" << file.errorString();
+    else
+      qDebug() << Q_FUNC_INFO << "Saved" << addonCache.size() << "add-ons and" << cfgPaths.size()
+               << "aircraft.cfg files to" << filename;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache" << filename << ":" << file.errorString();
 }
 
 void AircraftIndex::clear()
@@ -20,14 +20,25 @@
 
 #include <QHash>
 #include <QStringList>
+#include <QVector>
+
+#include <utility>
 
 namespace atools {
+namespace io {
+class FastIniReader;
+}
+
 namespace fs {
 namespace scenery {
 
 /* .../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Official/OneStore/asobo-aircraft-208b-grand-caravan-ex/
  * .../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Community
- * "SimObjects/Airplanes/Asobo_B787_10/aircraft.cfg" */
+ * "SimObjects/Airplanes/Asobo_B787_10/aircraft.cfg"
+ *
+ * The results of reading add-on folders and aircraft.cfg files can be saved to a cache file which is loaded
+ * on next start. Cached results are used as long as size and modification time of manifest.json, layout.json
+ * and aircraft.cfg files did not change. Only new or changed add-ons are read then. */
 class AircraftIndex
 {
 public:
@@ -35,12 +46,43 @@ public:
    * Store aircraft.cfg
    * layout.json "path": "SimObjects/Airplanes/Asobo_B787_10/aircraft.cfg",
    * manifest.json   "content_type": "AIRCRAFT",
+   * Add-on folders are read in parallel. Unchanged add-ons are taken from the cache.
    */
   void loadIndex(const QStringList& paths);
 
+  /* Read all aircraft.cfg files in the index in parallel and cache their type designators.
+   * Optional. Avoids reading files one by one in getIcaoTypeDesignator(). */
+  void loadIcaoTypeDesignators();
+
   /* "SimObjects/Airplanes/Asobo_B787_10/aircraft.cfg". Read file and look for "icao_type_designator" */
   QString getIcaoTypeDesignator(const QString& aircraftCfgFilepath);
 
+  /*
+   * Revalidate the index after files or folders changed. Paths can be base paths, add-on folders or files in
+   * add-on folders. Cached results for these are dropped and the base paths are scanned again which reads only
+   * changed add-ons.
+   *
+   * Connect to FileSystemWatcher signals for live updates, e.g.:
+   * connect(watcher, &FileSystemWatcher::dirUpdated, [this](const QString& dir) {
+   *   aircraftIndex.pathsUpdated({dir});
+   * });
+   */
+  void pathsUpdated(const QStringList& paths);
+
+  /* Base paths as given to loadIndex(). Watch these for new or removed add-ons. */
+  const QStringList& getBasePaths() const
+  {
+    return loadedBasePaths;
+  }
+
+  /* Load cached add-on and aircraft.cfg results from file. Call before loadIndex().
+   * Returns false if file is missing or invalid. */
+  bool loadCache(const QString& filename);
+
+  /* Save add-on and aircraft.cfg results for the current index to file */
+  void saveCache(const QString& filename) const;
+
+  /* Clear index but keep cached file results */
   void clear();
 
   bool isEmpty() const
@@ -54,6 +96,48 @@ public:
   }
 
 private:
+  /* Size and last modification time of a file. Zero if file does not exist. */
+  struct FileStamp
+  {
+    qint64 size = 0, lastModified = 0;
+
+    bool operator==(const FileStamp& other) const
+    {
+      return size == other.size && lastModified == other.lastModified;
+    }
+
+  };
+
+  /* Cached result for an add-on folder */
+  struct AddonEntry
+  {
+    FileStamp manifest, layout;
+
+    /* Short path key and full canonical path for each aircraft.cfg. Empty if not an aircraft. */
+    QVector<std::pair<QString, QString> > cfgPaths;
+  };
+
+  /* Cached result for an aircraft.cfg file */
+  struct CfgEntry
+  {
+    FileStamp stamp;
+    QString typeDesignator;
+  };
+
+  /* Scan loadedBasePaths and use cached results for unchanged add-ons */
+  void scan();
+
+  /* Get designator for a full path from cache or read file */
+  QString readTypeDesignator(const QString& fullPath);
+
+  static FileStamp fileStamp(const QString& filepath);
+
+  /* Get value of icao_type_designator in any section */
+  static QString typeDesignator(const atools::io::FastIniReader& reader);
+
+  /* true if path equals parent or is below */
+  static bool isSameOrBelow(const QString& path, const QString& parent);
+
   /* Maps short path "SimObjects/Airplanes/Asobo_B787_10/aircraft.cfg" to aircraft type "B787" */
   QHash<QString, QString> shortPathToTypeDesMap;
 
@@ -62,6 +146,13 @@ private:
 
   /* Used by load index to avoid unneeded reload */
   QStringList loadedBasePaths;
+
+  /* Cached results by add-on folder path and by full aircraft.cfg path. Persisted by saveCache(). */
+  QHash<QString, AddonEntry> addonCache;
+  QHash<QString, CfgEntry> cfgCache;
+
+  const quint32 CACHE_MAGIC_NUMBER = 0x51D0E7A2;
+  const quint16 CACHE_VERSION = 1;
 };
 
 } // namespace scenery
@@ -18,6 +18,7 @@
 #include "atools.h"
 #include "fs/navdatabaseoptions.h"
 #include "fs/scenery/fileresolver.h"
+#include "fs/scenery/fileresolvercache.h"
 #include "fs/scenery/layoutjson.h"
 #include "fs/scenery/sceneryarea.h"
 
@@ -97,8 +98,6 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
           sceneryDirs.append(QFileInfo(sceneryAreaDir.path()));
       }
 
-      scenery::LayoutJson layout;
-
       // get all scenery directories - normally only one
       for(const QFileInfo& scenery : sceneryDirs)
       {
@@ -107,53 +106,28 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
           // Check if directory is included
           if(options.isIncludedGui(scenery))
           {
-            QFileInfoList bglFiles;
-
-            if(options.getSimulatorType() == atools::fs::FsPaths::MSFS)
-            {
-              // Read MSFS layout file and add all BGL files ================
-              layout.clear();
-              layout.read(scenery.absoluteFilePath() + atools::SEP + "layout.json");
-
-              for(const QString& path : layout.getBglPaths())
-                bglFiles.append(sceneryArea.filePath() + atools::SEP + path);
-            }
-            else
-            {
-              // Read all BGL files from directory structure ==============
-              QDir sceneryAreaDirObj(scenery.absoluteFilePath());
-              bglFiles = sceneryAreaDirObj.entryInfoList({"*.bgl"},
-                                                         QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
-                                                         QDir::Name | QDir::IgnoreCase);
-            }
+            QStringList bglFiles = listBglFiles(sceneryArea, scenery);
 
             // Get all BGL files
-            for(const QFileInfo& bglFile : qAsConst(bglFiles))
+            for(const QString& filepath : qAsConst(bglFiles))
             {
-              if(bglFile.isFile() && bglFile.isReadable())
+              QFileInfo bglFile(filepath);
+              QString filename = bglFile.fileName();
+
+              // Check if file is included from config file and GUI options
+              if(options.isIncludedFilename(filename) && options.isIncludedGui(bglFile))
               {
-                QString filename = bglFile.fileName();
-                QString filepath = bglFile.filePath();
-
-                // Check if file is included from config file and GUI options
-                if(options.isIncludedFilename(filename) && options.isIncludedGui(bglFile))
-                {
-                  // Skip maintenance BGL from Navigraph udpate in MSFS
-                  if(options.getSimulatorType() == atools::fs::FsPaths::MSFS &&
-                     area.isMsfsNavigraphNavdata() && filename.compare("maintenance.bgl", Qt::CaseInsensitive) == 0)
-                    continue;
-
-                  numFiles++;
-                  if(filepaths != nullptr)
-                    filepaths->append(filepath);
-                  if(filenames != nullptr)
-                    filenames->append(filename);
-                }
+                // Skip maintenance BGL from Navigraph udpate in MSFS
+                if(options.getSimulatorType() == atools::fs::FsPaths::MSFS &&
+                   area.isMsfsNavigraphNavdata() && filename.compare("maintenance.bgl", Qt::CaseInsensitive) == 0)
+                  continue;
+
+                numFiles++;
+                if(filepaths != nullptr)
+                  filepaths->append(filepath);
+                if(filenames != nullptr)
+                  filenames->append(filename);
               }
-#ifndef DEBUG_SILENCE_COMPILER_WARNINGS
-              else
-                qWarning().nospace().noquote() << bglFile.absoluteFilePath() << " is no file or not readable.";
-#endif
             }
           }
           else
@@ -179,6 +153,52 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
   return numFiles;
 }
 
+QStringList FileResolver::listBglFiles(const QFileInfo& sceneryArea, const QFileInfo& scenery)
+{
+  bool msfs = options.getSimulatorType() == atools::fs::FsPaths::MSFS;
+
+  // MSFS listing depends on the layout file and FSX/P3D on the directory content
+  QString cacheKey = msfs ? scenery.absoluteFilePath() + atools::SEP + "layout.json" : scenery.absoluteFilePath();
+
+  QStringList bglPaths;
+  if(cache != nullptr && cache->get(cacheKey, bglPaths))
+    return bglPaths;
+
+  QFileInfoList bglFiles;
+  if(msfs)
+  {
+    // Read MSFS layout file and add all BGL files ================
+    scenery::LayoutJson layout;
+    layout.read(cacheKey);
+
+    for(const QString& path : layout.getBglPaths())
+      bglFiles.append(sceneryArea.filePath() + atools::SEP + path);
+  }
+  else
+  {
+    // Read all BGL files from directory structure ==============
+    QDir sceneryAreaDirObj(scenery.absoluteFilePath());
+    bglFiles = sceneryAreaDirObj.entryInfoList({"*.bgl"},
+                                               QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+                                               QDir::Name | QDir::IgnoreCase);
+  }
+
+  for(const QFileInfo& bglFile : qAsConst(bglFiles))
+  {
+    if(bglFile.isFile() && bglFile.isReadable())
+      bglPaths.append(bglFile.filePath());
+#ifndef DEBUG_SILENCE_COMPILER_WARNINGS
+    else
+      qWarning().nospace().noquote() << bglFile.absoluteFilePath() << " is no file or not readable.";
+#endif
+  }
+
+  if(cache != nullptr)
+    cache->insert(cacheKey, bglPaths);
+
+  return bglPaths;
+}
+
 } // namespace scenery
 } // namespace fs
 } // namespace atools
@@ -22,12 +22,15 @@
 #include <QStringList>
 #include <QCoreApplication>
 
+class QFileInfo;
+
 namespace atools {
 namespace fs {
 class NavDatabaseOptions;
 namespace scenery {
 
 class SceneryArea;
+class FileResolverCache;
 
 /*
  * Collects all BGL files for a scenery area considering include and exclude configuration options.
@@ -58,10 +61,20 @@ public:
     return errorMessages;
   }
 
+  /* Reuse and fill directory listings from this cache if not null. Not owned. */
+  void setCache(atools::fs::scenery::FileResolverCache *value)
+  {
+    cache = value;
+  }
+
 private:
+  /* Get existing and readable BGL files from a scenery directory or MSFS layout file using the cache if set */
+  QStringList listBglFiles(const QFileInfo& sceneryArea, const QFileInfo& scenery);
+
   QStringList errorMessages;
   const atools::fs::NavDatabaseOptions& options;
   bool quiet = false;
+  atools::fs::scenery::FileResolverCache *cache = nullptr;
 };
 
 } // namespace scenery
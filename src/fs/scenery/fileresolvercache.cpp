@@ -0,0 +1,146 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/scenery/fileresolvercache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace atools {
+namespace fs {
+namespace scenery {
+
+FileResolverCache::FileResolverCache()
+{
+
+}
+
+FileResolverCache::~FileResolverCache()
+{
+
+}
+
+qint64 FileResolverCache::lastModified(const QString& path)
+{
+  QFileInfo fileinfo(path);
+  return fileinfo.exists() ? fileinfo.lastModified().toMSecsSinceEpoch() : -1L;
+}
+
+bool FileResolverCache::get(const QString& path, QStringList& filepaths)
+{
+  auto it = entries.find(path);
+  if(it == entries.end())
+    return false;
+
+  if(!it->validated)
+  {
+    // Loaded from file - check once if directory or layout file changed since last run
+    if(it->lastModified != lastModified(path))
+    {
+      entries.erase(it);
+      return false;
+    }
+    it->validated = true;
+  }
+
+  filepaths = it->filepaths;
+  return true;
+}
+
+void FileResolverCache::insert(const QString& path, const QStringList& filepaths)
+{
+  Entry& entry = entries[path];
+  entry.lastModified = lastModified(path);
+  entry.validated = true;
+  entry.filepaths = filepaths;
+}
+
+bool FileResolverCache::load(const QString& filename)
+{
+  entries.clear();
+
+  QFile file(filename);
+  if(!file.exists())
+    return false;
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read cache" << filename << ":" << file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magic;
+  quint16 version;
+  qint32 numEntries;
+  in >> magic >> version >> numEntries;
+
+  if(magic != CACHE_MAGIC_NUMBER || version != CACHE_VERSION || numEntries < 0)
+  {
+    qInfo() << Q_FUNC_INFO << "Cache" << filename << "has invalid format or version";
+    return false;
+  }
+
+  entries.reserve(numEntries);
+  for(qint32 i = 0; i < numEntries && in.status() == QDataStream::Ok; i++)
+  {
+    QString path;
+    Entry entry;
+    in >> path >> entry.lastModified >> entry.filepaths;
+    entries.insert(path, entry);
+  }
+
+  if(in.status() != QDataStream::Ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Cache" << filename << "is truncated";
+    entries.clear();
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << entries.size() << "entries from" << filename;
+  return true;
+}
+
+void FileResolverCache::save(const QString& filename) const
+{
+  QSaveFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+
+    out << CACHE_MAGIC_NUMBER << CACHE_VERSION << static_cast<qint32>(entries.size());
+    for(auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+      out << it.key() << it->lastModified << it->filepaths;
+
+    if(out.status() != QDataStream::Ok || !file.commit())
+      qWarning() << Q_FUNC_INFO << "Cannot write cache" << filename << ":" << file.errorString();
+    else
+      qDebug() << Q_FUNC_INFO << "Saved" << entries.size() << "entries to" << filename;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache" << filename << ":" << file.errorString();
+}
+
+} // namespace scenery
+} // namespace fs
+} // namespace atools
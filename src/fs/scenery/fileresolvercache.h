@@ -0,0 +1,97 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SCENERY_FILERESOLVERCACHE_H
+#define ATOOLS_SCENERY_FILERESOLVERCACHE_H
+
+#include <QHash>
+#include <QStringList>
+
+namespace atools {
+namespace fs {
+namespace scenery {
+
+/*
+ * Caches the BGL file lists found by FileResolver for each scenery directory or MSFS layout file.
+ * Filled by the counting pass and reused by the loading pass to avoid scanning all directories twice.
+ *
+ * Only the raw listing of existing and readable files is stored. Include and exclude options are
+ * applied by FileResolver on each call.
+ *
+ * Can be saved to and loaded from a file to avoid the directory scans between compile runs too.
+ * Entries loaded from a file are validated once against the modification time of the directory or
+ * layout file before being used.
+ */
+class FileResolverCache
+{
+public:
+  FileResolverCache();
+  ~FileResolverCache();
+
+  /* Get cached absolute BGL file paths for an absolute directory or layout file path.
+   * Returns false if not cached or outdated. Outdated entries are removed. */
+  bool get(const QString& path, QStringList& filepaths);
+
+  /* Add or replace file list for an absolute directory or layout file path */
+  void insert(const QString& path, const QStringList& filepaths);
+
+  /* Load entries from file. Clears cache before. Returns false if file is missing or invalid. */
+  bool load(const QString& filename);
+
+  /* Save all entries to file. */
+  void save(const QString& filename) const;
+
+  void clear()
+  {
+    entries.clear();
+  }
+
+  int size() const
+  {
+    return entries.size();
+  }
+
+  bool isEmpty() const
+  {
+    return entries.isEmpty();
+  }
+
+private:
+  struct Entry
+  {
+    /* Modification time of the directory or layout file in milliseconds since epoch */
+    qint64 lastModified = 0L;
+
+    /* false if loaded from file and not checked against the file system yet */
+    bool validated = false;
+
+    QStringList filepaths;
+  };
+
+  static qint64 lastModified(const QString& path);
+
+  const quint32 CACHE_MAGIC_NUMBER = 0x5B1F3E29;
+  const quint16 CACHE_VERSION = 1;
+
+  QHash<QString, Entry> entries;
+};
+
+} // namespace scenery
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_SCENERY_FILERESOLVERCACHE_H
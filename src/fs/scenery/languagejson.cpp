@@ -18,10 +18,12 @@
 #include "fs/scenery/languagejson.h"
 
 #include "atools.h"
+#include "fs/scenery/parsecache.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlutil.h"
 
+#include <QDataStream>
 #include <QFile>
 #include <QDebug>
 #include <QJsonArray>
@@ -53,9 +55,47 @@ const static QSet<QString> NO_NAMES = {
  *  }
  */
 void LanguageJson::readFromFile(const QString& filename, const QStringList& keyPrefixes)
+{
+  if(lazy)
+    pendingFiles.append({filename, keyPrefixes});
+  else
+    readFile(filename, keyPrefixes);
+}
+
+void LanguageJson::readPending() const
+{
+  // Keep order of files since later files override earlier ones
+  QVector<PendingFile> files;
+  files.swap(pendingFiles);
+  for(const PendingFile& file : qAsConst(files))
+    readFile(file.filename, file.keyPrefixes);
+}
+
+void LanguageJson::readFile(const QString& filename, const QStringList& keyPrefixes) const
 {
   if(atools::checkFile(Q_FUNC_INFO, filename))
   {
+    QByteArray key, data;
+    QString fileLanguage;
+    QHash<QString, QString> fileNames;
+
+    if(cache != nullptr)
+    {
+      // Use parsed result from last run if file did not change - prefixes change the result too
+      key = ParseCache::fileKey(filename, keyPrefixes.join('|'));
+      if(cache->get(key, data))
+      {
+        QDataStream in(data);
+        in.setVersion(QDataStream::Qt_5_5);
+        in >> fileLanguage >> fileNames;
+
+        language = fileLanguage;
+        for(auto it = fileNames.constBegin(); it != fileNames.constEnd(); ++it)
+          names.insert(it.key(), it.value());
+        return;
+      }
+    }
+
     QFile file(filename);
     if(file.open(QIODevice::ReadOnly))
     {
@@ -72,16 +112,27 @@ void LanguageJson::readFromFile(const QString& filename, const QStringList& keyP
 
       for(auto it = strings.constBegin(); it != strings.constEnd(); ++it)
       {
-        QString key = it.key();
-        if(keyPrefixes.isEmpty() || atools::strStartsWith(keyPrefixes, key))
+        QString stringKey = it.key();
+        if(keyPrefixes.isEmpty() || atools::strStartsWith(keyPrefixes, stringKey))
         {
           QString txt = it.value().toString();
 
           if(!NO_NAMES.contains(txt))
-            names.insert(key, txt);
+            fileNames.insert(stringKey, txt);
         }
       }
       file.close();
+
+      for(auto it = fileNames.constBegin(); it != fileNames.constEnd(); ++it)
+        names.insert(it.key(), it.value());
+
+      if(cache != nullptr)
+      {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_5);
+        out << language << fileNames;
+        cache->insert(key, data);
+      }
     }
     else
       qWarning() << Q_FUNC_INFO << "Cannot open file" << filename << file.errorString();
@@ -94,7 +145,8 @@ void LanguageJson::readFromDirToDb(sql::SqlDatabase *db, const QString& dirname,
   QDir dir(dirname);
   for(const QFileInfo& file: dir.entryInfoList({fileFilter}, QDir::Files))
   {
-    readFromFile(file.filePath(), keyPrefixes);
+    // Read directly also in lazy mode
+    readFile(file.filePath(), keyPrefixes);
     writeToDb(db);
   }
   clear();
@@ -164,7 +216,7 @@ void LanguageJson::writeToDb(sql::SqlDatabase *db) const
   db->commit();
 }
 
-void LanguageJson::adjustLanguage()
+void LanguageJson::adjustLanguage() const
 {
   if(language.isEmpty())
     language = "en-US";
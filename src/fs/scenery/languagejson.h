@@ -19,7 +19,8 @@
 #define ATOOLS_LANGUAGEJSON_H
 
 #include <QHash>
-#include <QString>
+#include <QStringList>
+#include <QVector>
 
 namespace atools {
 namespace sql {
@@ -29,12 +30,17 @@ class SqlDatabase;
 namespace fs {
 namespace scenery {
 
+class ParseCache;
+
 /*
  * Reads MSFS language files like
  * ".../Microsoft.FlightSimulator_8wekyb3d8bbwe/LocalCache/Packages/Official/OneStore/fs-base/en-US.locPak"
  * and creates a map for airport names like "TT:AIRPORTXX.MYNN.name" to the real localized name.
  *
  * The class can only store the translations for one language.
+ *
+ * Parsed files are taken from and added to a ParseCache if set.
+ * In lazy mode readFromFile() only remembers the file which is parsed on first access of the names.
  */
 class LanguageJson
 {
@@ -61,6 +67,7 @@ public:
   {
     names.clear();
     language.clear();
+    pendingFiles.clear();
 #ifdef DEBUG_MODEL_SUPPORT
     models.clear();
 #endif
@@ -68,6 +75,8 @@ public:
 
   bool isEmpty() const
   {
+    if(!pendingFiles.isEmpty())
+      readPending();
     return names.isEmpty();
   }
 
@@ -75,9 +84,23 @@ public:
    * Returns key if it does not start with the translation prefix "TT:" or list is empty */
   QString getName(QString key) const
   {
+    if(!pendingFiles.isEmpty())
+      readPending();
     return valueFromMap(names, key);
   }
 
+  /* Use cache for parsed files if not null. Not owned. */
+  void setCache(atools::fs::scenery::ParseCache *value)
+  {
+    cache = value;
+  }
+
+  /* Defer reading of files in readFromFile() until names are accessed */
+  void setLazy(bool value)
+  {
+    lazy = value;
+  }
+
 #ifdef DEBUG_MODEL_SUPPORT
   /* Aircraft model "C172" from "ATCCOM.AC_MODEL_C172.0.text". */
   QString getModel(QString key) const;
@@ -87,14 +110,33 @@ public:
   /* Get language as read from file or db. E.g. "en-US" */
   const QString& getLanguage() const
   {
+    if(!pendingFiles.isEmpty())
+      readPending();
     return language;
   }
 
 private:
-  void adjustLanguage();
+  /* File and key prefixes remembered in lazy mode */
+  struct PendingFile
+  {
+    QString filename;
+    QStringList keyPrefixes;
+  };
+
+  void adjustLanguage() const;
+
+  /* Read all files remembered in lazy mode */
+  void readPending() const;
+
+  /* Read file or get it from cache. Const to allow lazy loading. */
+  void readFile(const QString& filename, const QStringList& keyPrefixes) const;
+
+  /* Maps key like "TT:AIRPORTXX.MYNN.name" to text. Mutable for lazy loading. */
+  mutable QHash<QString, QString> names;
+  mutable QVector<PendingFile> pendingFiles;
 
-  /* Maps key like "TT:AIRPORTXX.MYNN.name" to text */
-  QHash<QString, QString> names;
+  atools::fs::scenery::ParseCache *cache = nullptr;
+  bool lazy = false;
 
 #ifdef DEBUG_MODEL_SUPPORT
   void addModel(const QString& key, const QString& value);
@@ -104,7 +146,7 @@ private:
 #endif
 
   /* Loaded language */
-  QString language;
+  mutable QString language;
 
   QString valueFromMap(const QHash<QString, QString>& hash, QString key) const;
 
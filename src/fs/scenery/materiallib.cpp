@@ -20,8 +20,10 @@
 #include "atools.h"
 #include "fs/navdatabaseoptions.h"
 #include "fs/scenery/layoutjson.h"
+#include "fs/scenery/parsecache.h"
 #include "util/xmlstream.h"
 
+#include <QDataStream>
 #include <QDir>
 #include <QFile>
 #include <QUuid>
@@ -43,7 +45,7 @@ void MaterialLib::readCommunity(const QString& basePath)
   LayoutJson layout;
   layout.read(basePath + atools::SEP + "layout.json");
   for(const QString& str : layout.getMaterialPaths())
-    read(basePath + atools::SEP + str);
+    addFile(basePath + atools::SEP + str);
 }
 
 void MaterialLib::readOfficial(const QString& basePath)
@@ -52,12 +54,34 @@ void MaterialLib::readOfficial(const QString& basePath)
 
   layout.read(basePath + atools::SEP + "asobo-material-lib" + atools::SEP + "layout.json");
   for(const QString& str : layout.getMaterialPaths())
-    read(basePath + atools::SEP + "asobo-material-lib" + atools::SEP + str);
+    addFile(basePath + atools::SEP + "asobo-material-lib" + atools::SEP + str);
 
   layout.clear();
   layout.read(basePath + atools::SEP + "fs-base-material-lib" + atools::SEP + "layout.json");
   for(const QString& str : layout.getMaterialPaths())
-    read(basePath + atools::SEP + "fs-base-material-lib" + atools::SEP + str);
+    addFile(basePath + atools::SEP + "fs-base-material-lib" + atools::SEP + str);
+}
+
+void MaterialLib::addFile(const QString& filename)
+{
+  if(lazy)
+    pendingFiles.append(filename);
+  else
+    readFile(filename);
+}
+
+void MaterialLib::readPending() const
+{
+  // Keep order of files since later files override earlier ones
+  QStringList files;
+  files.swap(pendingFiles);
+  for(const QString& filename : qAsConst(files))
+    readFile(filename);
+}
+
+void MaterialLib::read(const QString& filename)
+{
+  readFile(filename);
 }
 
 /*
@@ -74,12 +98,31 @@ void MaterialLib::readOfficial(const QString& basePath)
  *   <TagList>
  *     <Tag>Test</Tag>
  */
-void MaterialLib::read(const QString& filename)
+void MaterialLib::readFile(const QString& filename) const
 {
   if(options->isIncludedGui(QFileInfo(filename)))
   {
     if(atools::checkFile(Q_FUNC_INFO, filename))
     {
+      QByteArray key, data;
+      QHash<QUuid, QString> fileSurfaceMap;
+
+      if(cache != nullptr)
+      {
+        // Use parsed result from last run if file did not change
+        key = ParseCache::fileKey(filename);
+        if(cache->get(key, data))
+        {
+          QDataStream in(data);
+          in.setVersion(QDataStream::Qt_5_5);
+          in >> fileSurfaceMap;
+
+          for(auto it = fileSurfaceMap.constBegin(); it != fileSurfaceMap.constEnd(); ++it)
+            surfaceMap.insert(it.key(), it.value());
+          return;
+        }
+      }
+
       QStringList probe = atools::probeFile(filename, 10);
 
       // Test if this is not another file type like aircraft checklist definitions
@@ -100,7 +143,11 @@ void MaterialLib::read(const QString& filename)
             {
               QString surface = reader.attributes().value("SurfaceType").toString();
               if(surface != "UNDEFINED")
-                surfaceMap.insert(QUuid(reader.attributes().value("Guid").toString()), surface);
+              {
+                QUuid uuid(reader.attributes().value("Guid").toString());
+                surfaceMap.insert(uuid, surface);
+                fileSurfaceMap.insert(uuid, surface);
+              }
 
               // Read only attributes
               xmlStream.skipCurrentElement();
@@ -115,6 +162,14 @@ void MaterialLib::read(const QString& filename)
       }
       else
         qWarning() << Q_FUNC_INFO << "Cannot open file" << filename << "Not a material library file";
+
+      if(cache != nullptr)
+      {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_5);
+        out << fileSurfaceMap;
+        cache->insert(key, data);
+      }
     }
   }
 }
@@ -19,6 +19,7 @@
 #define ATOOLS_MATERIALLIB_H
 
 #include <QHash>
+#include <QStringList>
 #include <QUuid>
 
 namespace atools {
@@ -28,8 +29,13 @@ class NavDatabaseOptions;
 
 namespace scenery {
 
+class ParseCache;
+
 /*
  * Reads MSFS material library XML and maps GUIDs to material name if not "UNDEFINED"
+ *
+ * Parsed files are taken from and added to a ParseCache if set.
+ * In lazy mode files are only parsed on the first call of getSurfaceForUuid().
  */
 class MaterialLib
 {
@@ -53,17 +59,47 @@ public:
   void clear()
   {
     surfaceMap.clear();
+    pendingFiles.clear();
   }
 
   /* Get a long surface name like "ASPHALT" for the given UUID/GUID */
   QString getSurfaceForUuid(const QUuid& uuid) const
   {
+    if(!pendingFiles.isEmpty())
+      readPending();
+
     return surfaceMap.value(uuid);
   }
 
+  /* Use cache for parsed files if not null. Not owned. */
+  void setCache(atools::fs::scenery::ParseCache *value)
+  {
+    cache = value;
+  }
+
+  /* Defer reading of files given to readCommunity() and readOfficial() until a surface is requested */
+  void setLazy(bool value)
+  {
+    lazy = value;
+  }
+
 private:
-  QHash<QUuid, QString> surfaceMap;
+  /* Read now or remember for later if lazy */
+  void addFile(const QString& filename);
+
+  /* Read all files remembered in lazy mode */
+  void readPending() const;
+
+  /* Read file or get it from cache. Const to allow lazy loading in getSurfaceForUuid(). */
+  void readFile(const QString& filename) const;
+
+  /* Mutable for lazy loading */
+  mutable QHash<QUuid, QString> surfaceMap;
+  mutable QStringList pendingFiles;
+
   const atools::fs::NavDatabaseOptions *options = nullptr;
+  atools::fs::scenery::ParseCache *cache = nullptr;
+  bool lazy = false;
 };
 
 } // namespace scenery
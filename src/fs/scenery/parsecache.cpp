@@ -0,0 +1,134 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/scenery/parsecache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace atools {
+namespace fs {
+namespace scenery {
+
+ParseCache::ParseCache()
+{
+
+}
+
+ParseCache::~ParseCache()
+{
+
+}
+
+QByteArray ParseCache::fileKey(const QString& filepath, const QString& extra)
+{
+  QFileInfo fileinfo(filepath);
+  QString key = fileinfo.absoluteFilePath() + '|' + QString::number(fileinfo.size()) + '|' +
+                QString::number(fileinfo.lastModified().toMSecsSinceEpoch()) + '|' + extra;
+  return QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+}
+
+bool ParseCache::get(const QByteArray& key, QByteArray& data)
+{
+  auto it = entries.constFind(key);
+  if(it == entries.constEnd())
+    return false;
+
+  usedKeys.insert(key);
+  data = it.value();
+  return true;
+}
+
+void ParseCache::insert(const QByteArray& key, const QByteArray& data)
+{
+  usedKeys.insert(key);
+  entries.insert(key, data);
+}
+
+bool ParseCache::load(const QString& filename)
+{
+  clear();
+
+  QFile file(filename);
+  if(!file.exists())
+    return false;
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read cache" << filename << ":" << file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magic;
+  quint16 version;
+  in >> magic >> version;
+
+  if(magic != CACHE_MAGIC_NUMBER || version != CACHE_VERSION)
+  {
+    qInfo() << Q_FUNC_INFO << "Cache" << filename << "has invalid format or version";
+    return false;
+  }
+
+  in >> entries;
+
+  if(in.status() != QDataStream::Ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Cache" << filename << "is truncated";
+    entries.clear();
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << entries.size() << "entries from" << filename;
+  return true;
+}
+
+void ParseCache::save(const QString& filename) const
+{
+  // Drop outdated entries which were not used in this run
+  QHash<QByteArray, QByteArray> used;
+  for(auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+  {
+    if(usedKeys.contains(it.key()))
+      used.insert(it.key(), it.value());
+  }
+
+  QSaveFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out << CACHE_MAGIC_NUMBER << CACHE_VERSION << used;
+
+    if(out.status() != QDataStream::Ok || !file.commit())
+      qWarning() << Q_FUNC_INFO << "Cannot write cache" << filename << ":" << file.errorString();
+    else
+      qDebug() << Q_FUNC_INFO << "Saved" << used.size() << "entries to" << filename;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache" << filename << ":" << file.errorString();
+}
+
+} // namespace scenery
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,88 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SCENERY_PARSECACHE_H
+#define ATOOLS_SCENERY_PARSECACHE_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+namespace atools {
+namespace fs {
+namespace scenery {
+
+/*
+ * Binary cache for parsed results of MSFS files like material libraries or language files.
+ *
+ * Each entry is keyed by a hash over file path, size, modification time and an additional key. A changed
+ * file simply produces a new key, so no further validation is needed. Entries not used in a
+ * run are dropped when saving.
+ *
+ * Values are opaque byte arrays. Serialization is left to the user, e.g. MaterialLib or LanguageJson.
+ * Not thread safe.
+ */
+class ParseCache
+{
+public:
+  ParseCache();
+  ~ParseCache();
+
+  ParseCache(const ParseCache& other) = delete;
+  ParseCache& operator=(const ParseCache& other) = delete;
+
+  /* Build key from path, size and last modification time of file and the given extra string */
+  static QByteArray fileKey(const QString& filepath, const QString& extra = QString());
+
+  /* Get cached data for key and mark entry as used. Returns false if not found. */
+  bool get(const QByteArray& key, QByteArray& data);
+
+  /* Add or replace data for key */
+  void insert(const QByteArray& key, const QByteArray& data);
+
+  /* Load entries from file. Clears cache before. Returns false if file is missing or invalid. */
+  bool load(const QString& filename);
+
+  /* Save all entries used in this run to file */
+  void save(const QString& filename) const;
+
+  void clear()
+  {
+    entries.clear();
+    usedKeys.clear();
+  }
+
+  int size() const
+  {
+    return entries.size();
+  }
+
+private:
+  QHash<QByteArray, QByteArray> entries;
+
+  /* Keys used by get() or insert() in this run */
+  QSet<QByteArray> usedKeys;
+
+  const quint32 CACHE_MAGIC_NUMBER = 0x7C3A91E4;
+  const quint16 CACHE_VERSION = 1;
+};
+
+} // namespace scenery
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_SCENERY_PARSECACHE_H
@@ -22,6 +22,9 @@
 #include "geo/calculations.h"
 #include "fs/util/coordinates.h"
 #include "fs/common/binarygeometry.h"
+#include "fs/userdata/airspacereaderivao.h"
+#include "fs/userdata/airspacereaderopenair.h"
+#include "fs/userdata/airspacereadervatsim.h"
 #include "exception.h"
 #include "sql/sqlutil.h"
 #include "sql/sqlquery.h"
@@ -72,7 +75,7 @@ AirspaceReaderBase::~AirspaceReaderBase()
 
 void AirspaceReaderBase::reset()
 {
-  insertAirspaceQuery->clearBoundValues();
+  clearAirspace();
 }
 
 void AirspaceReaderBase::resetErrors()
@@ -104,12 +107,34 @@ AirspaceReaderBase::Format AirspaceReaderBase::detectFileFormat(const QString& f
   return UNKNOWN;
 }
 
+AirspaceReaderBase *AirspaceReaderBase::createReader(Format format, sql::SqlDatabase *sqlDb)
+{
+  switch(format)
+  {
+    case atools::fs::userdata::AirspaceReaderBase::OPEN_AIR:
+      return new AirspaceReaderOpenAir(sqlDb);
+
+    case atools::fs::userdata::AirspaceReaderBase::IVAO_JSON:
+      return new AirspaceReaderIvao(sqlDb);
+
+    case atools::fs::userdata::AirspaceReaderBase::VATSIM_GEO_JSON:
+      return new AirspaceReaderVatsim(sqlDb);
+
+    case atools::fs::userdata::AirspaceReaderBase::UNKNOWN:
+      break;
+  }
+  return nullptr;
+}
+
 void AirspaceReaderBase::initQueries()
 {
   deInitQueries();
 
-  insertAirspaceQuery = new SqlQuery(db);
-  insertAirspaceQuery->prepare(SqlUtil(db).buildInsertStatement("boundary"));
+  if(db != nullptr)
+  {
+    insertAirspaceQuery = new SqlQuery(db);
+    insertAirspaceQuery->prepare(SqlUtil(db).buildInsertStatement("boundary"));
+  }
 }
 
 void AirspaceReaderBase::deInitQueries()
@@ -129,6 +154,38 @@ QString AirspaceReaderBase::mid(const QStringList& line, int index, bool ignoreE
   return QString();
 }
 
+void AirspaceReaderBase::bindValue(const QString& name, const QVariant& value)
+{
+  // Replace value if already bound
+  for(std::pair<QString, QVariant>& pair : airspaceValues)
+  {
+    if(pair.first == name)
+    {
+      pair.second = value;
+      return;
+    }
+  }
+  airspaceValues.append(std::make_pair(name, value));
+}
+
+void AirspaceReaderBase::bindNullStr(const QString& name)
+{
+  bindValue(name, QVariant(QVariant::String));
+}
+
+void AirspaceReaderBase::writeAirspace()
+{
+  if(insertAirspaceQuery != nullptr)
+  {
+    insertAirspaceQuery->bindValues(airspaceValues);
+    insertAirspaceQuery->exec();
+    insertAirspaceQuery->clearBoundValues();
+  }
+  else
+    collectedAirspaces.append(airspaceValues);
+  clearAirspace();
+}
+
 void AirspaceReaderBase::errWarn(const QString& msg)
 {
   qWarning() << filename << ":" << lineNumber << msg;
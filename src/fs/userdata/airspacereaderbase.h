@@ -21,6 +21,7 @@
 #include <functional>
 
 #include <QCoreApplication>
+#include <QVariant>
 #include <QVector>
 
 namespace atools {
@@ -39,12 +40,16 @@ namespace userdata {
 
 /*
  * Base class for reading airspace text formats. Provides SQL query and error collection methods.
+ *
+ * Airspaces are written to the table "boundary" directly if a database is given. Otherwise all airspaces are
+ * collected and can be fetched with takeAirspaces(). This allows to use readers in worker threads.
  */
 class AirspaceReaderBase
 {
   Q_DECLARE_TR_FUNCTIONS(AirspaceWriter)
 
 public:
+  /* Collects airspaces instead of writing if sqlDb is null */
   AirspaceReaderBase(sql::SqlDatabase *sqlDb);
   virtual ~AirspaceReaderBase();
 
@@ -123,6 +128,20 @@ public:
    * reader returns nothing for a not matching JSON schema */
   static Format detectFileFormat(const QString& file);
 
+  /* Create a reader for the format. Returns null for UNKNOWN. Caller takes ownership. */
+  static AirspaceReaderBase *createReader(Format format, sql::SqlDatabase *sqlDb);
+
+  /* Column name and value pairs for one airspace. Names are prefixed with ":". */
+  typedef QVector<std::pair<QString, QVariant> > AirspaceValues;
+
+  /* Get airspaces collected when not using a database and clear the internal list */
+  QVector<AirspaceValues> takeAirspaces()
+  {
+    QVector<AirspaceValues> retval;
+    retval.swap(collectedAirspaces);
+    return retval;
+  }
+
 protected:
   void initQueries();
   void deInitQueries();
@@ -130,9 +149,26 @@ protected:
   void errWarn(const QString& msg);
   QString mid(const QStringList& line, int index, bool ignoreError = false);
 
+  /* Set column values for the current airspace. Placeholder names like ":name". */
+  void bindValue(const QString& name, const QVariant& value);
+  void bindNullStr(const QString& name);
+
+  /* Write or collect the current airspace and clear values */
+  void writeAirspace();
+
+  /* Clear values of the current airspace */
+  void clearAirspace()
+  {
+    airspaceValues.clear();
+  }
+
   atools::sql::SqlQuery *insertAirspaceQuery = nullptr;
   atools::sql::SqlDatabase *db;
 
+  /* Values of the current airspace and all airspaces collected if not writing to the database */
+  AirspaceValues airspaceValues;
+  QVector<AirspaceValues> collectedAirspaces;
+
   QString filename;
   int airspaceId = 1;
   int lineNumber = 0;
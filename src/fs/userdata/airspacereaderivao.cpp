@@ -159,21 +159,21 @@ bool AirspaceReaderIvao::readFile(const QString& filenameParam)
 
         if(!dbType.isEmpty() && !airportId.isEmpty())
         {
-          insertAirspaceQuery->bindValue(":boundary_id", airspaceId++);
-          insertAirspaceQuery->bindValue(":file_id", fileId);
-          insertAirspaceQuery->bindValue(":description", name);
-          insertAirspaceQuery->bindValue(":type", dbType);
+          bindValue(":boundary_id", airspaceId++);
+          bindValue(":file_id", fileId);
+          bindValue(":description", name);
+          bindValue(":type", dbType);
 
           // Unused fields here
-          insertAirspaceQuery->bindNullStr(":restrictive_designation");
-          insertAirspaceQuery->bindNullStr(":restrictive_type");
-          insertAirspaceQuery->bindNullStr(":multiple_code");
-          insertAirspaceQuery->bindValue(":time_code", "U");
+          bindNullStr(":restrictive_designation");
+          bindNullStr(":restrictive_type");
+          bindNullStr(":multiple_code");
+          bindValue(":time_code", "U");
 
           // Build ident string like "LEPA_S_TWR" as used in IVAO data JSON ==================
           QStringList ident({airportId, middleIdent, position});
           ident.removeAll(QString());
-          insertAirspaceQuery->bindValue(":name", ident.join('_'));
+          bindValue(":name", ident.join('_'));
 
           // Get airport position from callback ====================
           Pos airportPos;
@@ -195,17 +195,16 @@ bool AirspaceReaderIvao::readFile(const QString& filenameParam)
 
           if(!line.isEmpty())
           {
-            insertAirspaceQuery->bindValue(":max_lonx", bounding.getEast());
-            insertAirspaceQuery->bindValue(":max_laty", bounding.getNorth());
-            insertAirspaceQuery->bindValue(":min_lonx", bounding.getWest());
-            insertAirspaceQuery->bindValue(":min_laty", bounding.getSouth());
+            bindValue(":max_lonx", bounding.getEast());
+            bindValue(":max_laty", bounding.getNorth());
+            bindValue(":min_lonx", bounding.getWest());
+            bindValue(":min_laty", bounding.getSouth());
 
             // Create geometry blob
             atools::fs::common::BinaryGeometry geo(line);
-            insertAirspaceQuery->bindValue(":geometry", geo.writeToByteArray());
+            bindValue(":geometry", geo.writeToByteArray());
 
-            insertAirspaceQuery->exec();
-            insertAirspaceQuery->clearBoundValues();
+            writeAirspace();
             numAirspacesRead++;
           }
           else
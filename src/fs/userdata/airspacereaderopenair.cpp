@@ -125,13 +125,13 @@ void AirspaceReaderOpenAir::readLine(const QStringList& line, int fileIdParam, c
 
 void AirspaceReaderOpenAir::writeBoundary()
 {
-  // insertAirspaceQuery->bindValue(":com_type", );
-  // insertAirspaceQuery->bindValue(":com_frequency", );
-  // insertAirspaceQuery->bindValue(":com_name", );
-  // insertAirspaceQuery->bindValue(":comment", );
+  // bindValue(":com_type", );
+  // bindValue(":com_frequency", );
+  // bindValue(":com_name", );
+  // bindValue(":comment", );
 
-  insertAirspaceQuery->bindValue(":boundary_id", airspaceId++);
-  insertAirspaceQuery->bindValue(":file_id", fileId);
+  bindValue(":boundary_id", airspaceId++);
+  bindValue(":file_id", fileId);
 
   // Remove all remaining invalid points
   auto it = std::remove_if(curLine.begin(), curLine.end(), [](const Pos& p) -> bool
@@ -152,22 +152,22 @@ void AirspaceReaderOpenAir::writeBoundary()
 
     if(!bounding.isPoint())
     {
-      insertAirspaceQuery->bindValue(":max_lonx", bounding.getEast());
-      insertAirspaceQuery->bindValue(":max_laty", bounding.getNorth());
-      insertAirspaceQuery->bindValue(":min_lonx", bounding.getWest());
-      insertAirspaceQuery->bindValue(":min_laty", bounding.getSouth());
+      bindValue(":max_lonx", bounding.getEast());
+      bindValue(":max_laty", bounding.getNorth());
+      bindValue(":min_lonx", bounding.getWest());
+      bindValue(":min_laty", bounding.getSouth());
 
       // Create geometry blob
       atools::fs::common::BinaryGeometry geo(curLine);
-      insertAirspaceQuery->bindValue(":geometry", geo.writeToByteArray());
+      bindValue(":geometry", geo.writeToByteArray());
 
       // Fields not used by X-Plane
-      insertAirspaceQuery->bindNullStr(":restrictive_designation");
-      insertAirspaceQuery->bindNullStr(":restrictive_type");
-      insertAirspaceQuery->bindNullStr(":multiple_code");
-      insertAirspaceQuery->bindValue(":time_code", "U");
+      bindNullStr(":restrictive_designation");
+      bindNullStr(":restrictive_type");
+      bindNullStr(":multiple_code");
+      bindValue(":time_code", "U");
 
-      insertAirspaceQuery->exec();
+      writeAirspace();
 
       numAirspacesRead++;
     }
@@ -181,8 +181,6 @@ void AirspaceReaderOpenAir::writeBoundary()
 
 void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
 {
-  // Related to full circle - 7.5° - number is checked in MapPainterAirspace::render()
-  const static int CIRCLE_SEGMENTS = 48;
   QString key = at(line, 0).toUpper();
   QString value = mid(line, 1).trimmed().toUpper();
 
@@ -208,7 +206,7 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
       Pos pos1 = center.endpoint(atools::geo::nmToMeter(radius), angleStart);
       Pos pos2 = center.endpoint(atools::geo::nmToMeter(radius), angleEnd);
       if(pos1.isValid() && pos2.isValid() && center.isValidRange())
-        curLine.append(LineString(center, pos1, pos2, clockwise, CIRCLE_SEGMENTS));
+        curLine.append(LineString::arc(center, pos1, pos2, clockwise));
       else
         errWarn("Found invalid coordinates in airspace record DA: \"" + value + "\"");
     }
@@ -221,7 +219,7 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
     Pos pos2 = fromOpenAirFormat(value.section(',', 1, 1).trimmed());
 
     if(pos1.isValid() && pos2.isValid() && center.isValidRange())
-      curLine.append(LineString(center, pos1, pos2, clockwise, CIRCLE_SEGMENTS));
+      curLine.append(LineString::arc(center, pos1, pos2, clockwise));
     else
       errWarn("Found invalid coordinates in airspace record DB: \"" + value + "\"");
     clockwise = true;
@@ -231,7 +229,7 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
     // DC radius - draw a circle (center taken from the previous V X=... record, radius in nm
     float radius = value.toFloat();
     if(radius > 0.2f && center.isValidRange())
-      curLine.append(LineString(center, atools::geo::nmToMeter(radius), CIRCLE_SEGMENTS));
+      curLine.append(LineString::circle(center, atools::geo::nmToMeter(radius)));
     else
       // Small values are apparently used to define colors
       qWarning() << filename << ":" << lineNumber <<
@@ -266,7 +264,7 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
 
 void AirspaceReaderOpenAir::bindName(const QString& name)
 {
-  insertAirspaceQuery->bindValue(":name", name);
+  bindValue(":name", name);
 }
 
 void AirspaceReaderOpenAir::bindClass(const QString& cls)
@@ -308,7 +306,7 @@ void AirspaceReaderOpenAir::bindClass(const QString& cls)
     qWarning() << filename << ":" << lineNumber << "Unknown airspace class" << cls;
     type = cls;
   }
-  insertAirspaceQuery->bindValue(":type", type);
+  bindValue(":type", type);
 }
 
 void AirspaceReaderOpenAir::bindAltitude(const QStringList& line, bool isMax)
@@ -385,8 +383,8 @@ void AirspaceReaderOpenAir::bindAltitude(const QStringList& line, bool isMax)
     }
   }
 
-  insertAirspaceQuery->bindValue(prefix + "_altitude_type", type);
-  insertAirspaceQuery->bindValue(prefix + "_altitude", altitude);
+  bindValue(prefix + "_altitude_type", type);
+  bindValue(prefix + "_altitude", altitude);
 }
 
 void AirspaceReaderOpenAir::finish()
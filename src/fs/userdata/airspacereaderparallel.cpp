@@ -0,0 +1,145 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/userdata/airspacereaderparallel.h"
+
+#include "exception.h"
+#include "sql/sqlbulkinsert.h"
+#include "util/parallel.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QScopedPointer>
+
+namespace atools {
+namespace fs {
+namespace userdata {
+
+/* Result of one file filled by worker threads */
+struct AirspaceFileResult
+{
+  QVector<AirspaceReaderBase::AirspaceValues> airspaces;
+  QVector<AirspaceReaderBase::AirspaceErr> errors;
+  QString exceptionMessage;
+};
+
+AirspaceReaderParallel::AirspaceReaderParallel(sql::SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+}
+
+int AirspaceReaderParallel::readFiles(const QStringList& filenames, const QVector<int>& fileIds)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  errors.clear();
+  numAirspacesRead = 0;
+
+  // Parse files in worker threads - one file per chunk ==========================
+  QVector<AirspaceFileResult> results(filenames.size());
+  AirspaceFileResult *resultData = results.data();
+
+  atools::util::parallelFor(filenames.size(), numThreads,
+                            [this, &filenames, &fileIds, resultData](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
+    {
+      AirspaceFileResult& result = resultData[i];
+      const QString& filename = filenames.at(i);
+
+      AirspaceReaderBase::Format format = AirspaceReaderBase::detectFileFormat(filename);
+      if(format == AirspaceReaderBase::UNKNOWN)
+      {
+        result.errors.append({filename, tr("Unknown airspace file format"), 0});
+        continue;
+      }
+
+      // Reader without database collects airspaces
+      QScopedPointer<AirspaceReaderBase> reader(AirspaceReaderBase::createReader(format, nullptr));
+      reader->setFileId(fileIds.value(i));
+      reader->setFetchAirportCoords(fetchAirportCoords);
+
+      try
+      {
+        reader->readFile(filename);
+      }
+      catch(const atools::Exception& e)
+      {
+        // Pass to calling thread
+        result.exceptionMessage = e.getMessage();
+      }
+      catch(const std::exception& e)
+      {
+        result.exceptionMessage = QString::fromUtf8(e.what());
+      }
+
+      result.airspaces = reader->takeAirspaces();
+      result.errors = reader->getErrors();
+    }
+  }, 1);
+
+  // Write in file order with batched inserts ==========================
+  atools::sql::SqlBulkInsert insert(db, "boundary");
+  const QStringList& columns = insert.getColumns();
+
+  // Map bind names like ":name" to column index
+  QHash<QString, int> columnIndex;
+  for(int i = 0; i < columns.size(); i++)
+    columnIndex.insert(':' + columns.at(i), i);
+
+  int boundaryIdIndex = columnIndex.value(":boundary_id", -1);
+  for(const AirspaceFileResult& result : qAsConst(results))
+  {
+    if(!result.exceptionMessage.isEmpty())
+      throw atools::Exception(result.exceptionMessage);
+
+    errors.append(result.errors);
+
+    for(const AirspaceReaderBase::AirspaceValues& airspace : result.airspaces)
+    {
+      QVariantList row;
+      row.reserve(columns.size());
+      for(int i = 0; i < columns.size(); i++)
+        row.append(QVariant());
+
+      for(const std::pair<QString, QVariant>& value : airspace)
+      {
+        int index = columnIndex.value(value.first, -1);
+        if(index != -1)
+          row[index] = value.second;
+      }
+
+      // Readers count ids per file - replace with continuous ids
+      if(boundaryIdIndex != -1)
+        row[boundaryIdIndex] = airspaceId;
+      airspaceId++;
+
+      insert.addRow(row);
+      numAirspacesRead++;
+    }
+  }
+  insert.flush();
+
+  qDebug() << Q_FUNC_INFO << "files" << filenames.size() << "airspaces" << numAirspacesRead
+           << "errors" << errors.size() << timer.elapsed() << "ms";
+
+  return numAirspacesRead;
+}
+
+} // namespace userdata
+} // namespace fs
+} // namespace atools
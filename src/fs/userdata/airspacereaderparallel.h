@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_AIRSPACEREADER_PARALLEL_H
+#define ATOOLS_AIRSPACEREADER_PARALLEL_H
+
+#include "fs/userdata/airspacereaderbase.h"
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace userdata {
+
+/*
+ * Reads several airspace files of any supported format concurrently. Each file is parsed by its own reader in a
+ * worker thread including arc and circle calculation and geometry blob encoding. The collected airspaces are then
+ * written in the calling thread to the table "boundary" using batched multi-row inserts.
+ *
+ * Airspace ids are assigned in order of files. Does not commit.
+ */
+class AirspaceReaderParallel
+{
+  Q_DECLARE_TR_FUNCTIONS(AirspaceReaderParallel)
+
+public:
+  AirspaceReaderParallel(atools::sql::SqlDatabase *sqlDb);
+
+  AirspaceReaderParallel(const AirspaceReaderParallel& other) = delete;
+  AirspaceReaderParallel& operator=(const AirspaceReaderParallel& other) = delete;
+
+  /* Read all files and write the airspaces. fileIds gives the value for column "file_id" for each file.
+   * Files with unknown format are skipped with an error. Throws an exception if a file cannot be read.
+   * Returns number of airspaces written. */
+  int readFiles(const QStringList& filenames, const QVector<int>& fileIds);
+
+  /* Set to a function that returns the coordinates for an airport ident. Has to be thread safe. */
+  void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value)
+  {
+    fetchAirportCoords = value;
+  }
+
+  /* Threads used for reading. 0 uses the number of cores. */
+  void setNumThreads(int value)
+  {
+    numThreads = value;
+  }
+
+  /* Set first boundary_id to be used */
+  void setAirspaceId(int value)
+  {
+    airspaceId = value;
+  }
+
+  int getNextAirspaceId() const
+  {
+    return airspaceId;
+  }
+
+  /* Errors of all files from the last call to readFiles() */
+  const QVector<AirspaceReaderBase::AirspaceErr>& getErrors() const
+  {
+    return errors;
+  }
+
+  int getNumAirspacesRead() const
+  {
+    return numAirspacesRead;
+  }
+
+private:
+  atools::sql::SqlDatabase *db;
+  std::function<atools::geo::Pos(const QString&)> fetchAirportCoords;
+  QVector<AirspaceReaderBase::AirspaceErr> errors;
+  int numThreads = 0, airspaceId = 1, numAirspacesRead = 0;
+};
+
+} // namespace userdata
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_AIRSPACEREADER_PARALLEL_H
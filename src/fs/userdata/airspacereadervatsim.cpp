@@ -213,14 +213,14 @@ bool AirspaceReaderVatsim::readFile(const QString& filenameParam)
 
             if(!line.isEmpty())
             {
-              insertAirspaceQuery->bindValue(":boundary_id", airspaceId++);
-              insertAirspaceQuery->bindValue(":file_id", fileId);
+              bindValue(":boundary_id", airspaceId++);
+              bindValue(":file_id", fileId);
 
               // Unused fields here
-              insertAirspaceQuery->bindNullStr(":restrictive_designation");
-              insertAirspaceQuery->bindNullStr(":restrictive_type");
-              insertAirspaceQuery->bindNullStr(":multiple_code");
-              insertAirspaceQuery->bindValue(":time_code", "U");
+              bindNullStr(":restrictive_designation");
+              bindNullStr(":restrictive_type");
+              bindNullStr(":multiple_code");
+              bindValue(":time_code", "U");
 
               // Build boundary name
               QStringList ident;
@@ -229,9 +229,9 @@ bool AirspaceReaderVatsim::readFile(const QString& filenameParam)
                 // Center - only firboundaries.json
                 ident.append(id.replace('-', '_').replace("__", "_") % "_CTR");
                 ident.removeAll(QString());
-                insertAirspaceQuery->bindValue(":type", "C");
-                insertAirspaceQuery->bindValue(":name", ident.join('_'));
-                insertAirspaceQuery->bindValue(":description", QString(id.section(REGEXP_DESCR, 0, 0) % " Center"));
+                bindValue(":type", "C");
+                bindValue(":name", ident.join('_'));
+                bindValue(":description", QString(id.section(REGEXP_DESCR, 0, 0) % " Center"));
               }
               else
               {
@@ -252,33 +252,32 @@ bool AirspaceReaderVatsim::readFile(const QString& filenameParam)
                 {
                   // Departure
                   ident.append("DEP");
-                  insertAirspaceQuery->bindValue(":type", "D");
+                  bindValue(":type", "D");
                 }
                 else
                 {
                   // Approach
                   ident.append("APP");
-                  insertAirspaceQuery->bindValue(":type", "A");
+                  bindValue(":type", "A");
                 }
 
                 ident.removeAll(QString());
-                insertAirspaceQuery->bindValue(":name", ident.join('_'));
-                insertAirspaceQuery->bindValue(":description", propertiesObj.value("name").toString());
+                bindValue(":name", ident.join('_'));
+                bindValue(":description", propertiesObj.value("name").toString());
               }
 
               // Assign bounding rectangle
               Rect bounding = line.boundingRect();
-              insertAirspaceQuery->bindValue(":max_lonx", bounding.getEast());
-              insertAirspaceQuery->bindValue(":max_laty", bounding.getNorth());
-              insertAirspaceQuery->bindValue(":min_lonx", bounding.getWest());
-              insertAirspaceQuery->bindValue(":min_laty", bounding.getSouth());
+              bindValue(":max_lonx", bounding.getEast());
+              bindValue(":max_laty", bounding.getNorth());
+              bindValue(":min_lonx", bounding.getWest());
+              bindValue(":min_laty", bounding.getSouth());
 
               // Create geometry blob
               atools::fs::common::BinaryGeometry geo(line);
-              insertAirspaceQuery->bindValue(":geometry", geo.writeToByteArray());
+              bindValue(":geometry", geo.writeToByteArray());
 
-              insertAirspaceQuery->exec();
-              insertAirspaceQuery->clearBoundValues();
+              writeAirspace();
               numAirspacesRead++;
             }
             else
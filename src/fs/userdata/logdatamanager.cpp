@@ -21,8 +21,9 @@
 #include "sql/sqlutil.h"
 #include "sql/sqlexport.h"
 #include "sql/sqldatabase.h"
-#include "util/csvreader.h"
+#include "util/csvbulkreader.h"
 #include "geo/pos.h"
+#include "geo/linestring.h"
 #include "zip/gzip.h"
 #include "geo/calculations.h"
 #include "exception.h"
@@ -32,6 +33,8 @@
 #include <QDir>
 #include <QStringBuilder>
 
+#include <algorithm>
+
 namespace atools {
 namespace fs {
 namespace userdata {
@@ -147,13 +150,18 @@ const static QHash<int, SqlColumn> COL_MAP =
 
 const static QStringList CLEANUP_COLUMNS({"departure_ident", "destination_ident", "distance_flown"});
 
+Q_DECL_CONSTEXPR int LogdataManager::SPATIAL_DEPARTURE;
+Q_DECL_CONSTEXPR int LogdataManager::SPATIAL_DESTINATION;
+
 LogdataManager::LogdataManager(sql::SqlDatabase *sqlDb)
   : DataManagerBase(sqlDb, "logbook", "logbook_id",
                     {":/atools/resources/sql/fs/logbook/create_logbook_schema.sql"},
                     ":/atools/resources/sql/fs/logbook/create_logbook_schema_undo.sql",
-                    ":/atools/resources/sql/fs/logbook/drop_logbook_schema.sql"), cache(MAX_CACHE_ENTRIES)
+                    ":/atools/resources/sql/fs/logbook/drop_logbook_schema.sql"), cache(-1, MAX_CACHE_ENTRIES)
 {
-
+  // Same order as SPATIAL_DEPARTURE and SPATIAL_DESTINATION
+  addSpatialIndex("departure_lonx", "departure_laty");
+  addSpatialIndex("destination_lonx", "destination_laty");
 }
 
 LogdataManager::~LogdataManager()
@@ -165,158 +173,151 @@ int LogdataManager::importCsv(const QString& filepath)
 {
   int numImported = 0;
   QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(file.open(QIODevice::ReadOnly))
   {
     int id = getCurrentId() + 1;
     atools::sql::DataManagerUndoHandler undoHandler(this, id);
-    QString idBinding(":" % idColumnName);
 
-    // Autogenerate id - exclude logbook_id from insert
-    SqlQuery insertQuery(db);
-    insertQuery.prepare(SqlUtil(db).buildInsertStatement(tableName, QString(), QStringList(), true /* namedBindings */));
+    // Map file and split into records and values
+    atools::util::CsvBulkReader reader;
+    if(!reader.read(&file))
+      throw atools::Exception(tr("Cannot read file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
 
-    atools::util::CsvReader reader;
-
-    QTextStream stream(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    stream.setCodec("UTF-8");
-#endif
-
-    int lineNum = 1;
-    while(!stream.atEnd())
+    int firstRecord = 0;
+    if(reader.getNumRecords() > 0)
     {
-      QString line = stream.readLine();
-
-      if(lineNum == 1)
-      {
-        QString header = QString(line).simplified().replace(' ', QString()).replace('"', QString()).toLower();
-        if(header.startsWith(csv::HEADER_LINE) || header.startsWith(csv::HEADER_LINE2))
-        {
-          lineNum++;
-          // Ignore header
-          continue;
-        }
-      }
-
-      // Skip empty lines but add them if within an escaped field
-      if(line.isEmpty() && !reader.isInEscape())
-        continue;
-
-      reader.readCsvLine(line);
-      if(reader.isInEscape())
-        // Still in an escaped line so continue to read unchanged until " shows the end of the field
-        continue;
-
-      const QStringList& values = reader.getValues();
-
-      if(values.size() < csv::MIN_NUM_COLS)
-        throw atools::Exception(tr("File contains invalid data.\n\"%1\"\nLine %2.").arg(line).arg(lineNum));
-
-      if(at(values, csv::DEPARTURE_IDENT).isEmpty() && at(values, csv::DESTINATION_IDENT).isEmpty())
-        throw atools::Exception(tr("File is not valid. Neither departure nor destination ident is set.\n\"%1\"\nLine %2.").arg(line).arg(
-                                  lineNum));
+      QString header = reader.getLine(0).simplified().replace(' ', QString()).replace('"', QString()).toLower();
+      if(header.startsWith(csv::HEADER_LINE) || header.startsWith(csv::HEADER_LINE2))
+        // Ignore header
+        firstRecord = 1;
+    }
 
-      insertQuery.bindValue(idBinding, id++);
+    // Order of values as added by rowFunc - logbook_id is added by bulkInsert()
+    const static QStringList COLUMNS({
+      "aircraft_name", "aircraft_type", "aircraft_registration",
+      "flightplan_number", "flightplan_cruise_altitude", "flightplan_file",
+      "performance_file", "block_fuel", "trip_fuel", "used_fuel", "is_jetfuel", "grossweight", "distance", "distance_flown",
+      "departure_ident", "departure_name", "departure_runway", "departure_lonx", "departure_laty", "departure_alt",
+      "departure_time", "departure_time_sim",
+      "destination_ident", "destination_name", "destination_runway", "destination_lonx", "destination_laty", "destination_alt",
+      "destination_time", "destination_time_sim",
+      "route_string", "simulator", "description",
+      "flightplan", "aircraft_perf", "aircraft_trail"});
+
+    // Called in parallel for all records
+    auto rowFunc = [this, &reader, firstRecord](QVariantList& row, int record) -> bool {
+      // Skip header and empty lines
+      if(record < firstRecord || reader.isEmpty(record))
+        return false;
+
+      int lineNum = reader.getLineNumber(record);
+      if(reader.getNumValues(record) < csv::MIN_NUM_COLS)
+        throw atools::Exception(tr("File contains invalid data.\n\"%1\"\nLine %2.").arg(reader.getLine(record)).arg(lineNum));
+
+      if(reader.isEmpty(record, csv::DEPARTURE_IDENT) && reader.isEmpty(record, csv::DESTINATION_IDENT))
+        throw atools::Exception(tr("File is not valid. Neither departure nor destination ident is set.\n\"%1\"\nLine %2.").
+                                arg(reader.getLine(record)).arg(lineNum));
+
+      // Same as fixEmptyFields() - fill null fields with empty strings to avoid issues when searching
+      auto str = [&reader, record](int index) -> QString {
+        QString value = reader.getString(record, index);
+        return value.isNull() ? QString("") : value;
+      };
+
+      // Number or null if empty
+      auto num = [&reader, record](int index) -> QVariant {
+        return reader.isEmpty(record, index) ? QVariant() : QVariant(reader.getFloat(record, index));
+      };
+
+      // Add files as Gzipped BLOBS or null if empty
+      auto blob = [&reader, record](int index) -> QVariant {
+        QByteArray bytes = atools::zip::gzipCompress(reader.getBytes(record, index));
+        return bytes.isEmpty() ? QVariant(QVariant::ByteArray) : QVariant(bytes);
+      };
 
       // Aircraft ===============================================================
-      insertQuery.bindValue(":aircraft_name", at(values, csv::AIRCRAFT_NAME));
-      insertQuery.bindValue(":aircraft_type", at(values, csv::AIRCRAFT_TYPE));
-      insertQuery.bindValue(":aircraft_registration", at(values, csv::AIRCRAFT_REGISTRATION));
+      row.append(str(csv::AIRCRAFT_NAME));
+      row.append(str(csv::AIRCRAFT_TYPE));
+      row.append(str(csv::AIRCRAFT_REGISTRATION));
 
       // Flightplan ===============================================================
-      insertQuery.bindValue(":flightplan_number", at(values, csv::FLIGHTPLAN_NUMBER));
-      if(!at(values, csv::FLIGHTPLAN_CRUISE_ALTITUDE).isEmpty())
-        insertQuery.bindValue(":flightplan_cruise_altitude", atFloat(values, csv::FLIGHTPLAN_CRUISE_ALTITUDE, true));
-      insertQuery.bindValue(":flightplan_file", at(values, csv::FLIGHTPLAN_FILE));
+      row.append(reader.getString(record, csv::FLIGHTPLAN_NUMBER));
+      row.append(num(csv::FLIGHTPLAN_CRUISE_ALTITUDE));
+      row.append(reader.getString(record, csv::FLIGHTPLAN_FILE));
 
       // Trip ===============================================================
-      insertQuery.bindValue(":performance_file", at(values, csv::PERFORMANCE_FILE));
-      if(!at(values, csv::BLOCK_FUEL).isEmpty())
-        insertQuery.bindValue(":block_fuel", atFloat(values, csv::BLOCK_FUEL, true));
-      if(!at(values, csv::TRIP_FUEL).isEmpty())
-        insertQuery.bindValue(":trip_fuel", atFloat(values, csv::TRIP_FUEL, true));
-      if(!at(values, csv::USED_FUEL).isEmpty())
-        insertQuery.bindValue(":used_fuel", atFloat(values, csv::USED_FUEL, true));
-      if(!at(values, csv::IS_JETFUEL).isEmpty())
-        insertQuery.bindValue(":is_jetfuel", atInt(values, csv::IS_JETFUEL, true));
-      if(!at(values, csv::GROSSWEIGHT).isEmpty())
-        insertQuery.bindValue(":grossweight", atFloat(values, csv::GROSSWEIGHT, true));
-      if(!at(values, csv::DISTANCE).isEmpty())
-        insertQuery.bindValue(":distance", atFloat(values, csv::DISTANCE, true));
-      if(!at(values, csv::DISTANCE_FLOWN).isEmpty())
-        insertQuery.bindValue(":distance_flown", atFloat(values, csv::DISTANCE_FLOWN, true));
+      row.append(reader.getString(record, csv::PERFORMANCE_FILE));
+      row.append(num(csv::BLOCK_FUEL));
+      row.append(num(csv::TRIP_FUEL));
+      row.append(num(csv::USED_FUEL));
+      row.append(reader.isEmpty(record, csv::IS_JETFUEL) ? QVariant() : QVariant(reader.getInt(record, csv::IS_JETFUEL)));
+      row.append(num(csv::GROSSWEIGHT));
+      row.append(reader.isEmpty(record, csv::DISTANCE) ? 0.f : reader.getFloat(record, csv::DISTANCE));
+      row.append(num(csv::DISTANCE_FLOWN));
 
       // Departure ===============================================================
-      insertQuery.bindValue(":departure_ident", at(values, csv::DEPARTURE_IDENT));
-      insertQuery.bindValue(":departure_name", at(values, csv::DEPARTURE_NAME));
-      insertQuery.bindValue(":departure_runway", at(values, csv::DEPARTURE_RUNWAY));
+      row.append(str(csv::DEPARTURE_IDENT));
+      row.append(reader.getString(record, csv::DEPARTURE_NAME));
+      row.append(reader.getString(record, csv::DEPARTURE_RUNWAY));
 
-      if(!at(values, csv::DEPARTURE_LONX).isEmpty() && !at(values, csv::DEPARTURE_LATY).isEmpty())
+      QVariant lonx, laty;
+      if(!reader.isEmpty(record, csv::DEPARTURE_LONX) && !reader.isEmpty(record, csv::DEPARTURE_LATY))
       {
-        Pos departPos = validateCoordinates(line, at(values, csv::DEPARTURE_LONX), at(values, csv::DEPARTURE_LATY),
-                                            lineNum, true /* checkNull */);
-
+        Pos departPos = validateCoordinates(reader.getLine(record), reader.getString(record, csv::DEPARTURE_LONX),
+                                            reader.getString(record, csv::DEPARTURE_LATY), lineNum, true /* checkNull */);
         if(departPos.isValid())
         {
-          insertQuery.bindValue(":departure_lonx", departPos.getLonX());
-          insertQuery.bindValue(":departure_laty", departPos.getLatY());
+          lonx = departPos.getLonX();
+          laty = departPos.getLatY();
         }
       }
-      if(!at(values, csv::DEPARTURE_ALT).isEmpty())
-        insertQuery.bindValue(":departure_alt", atFloat(values, csv::DEPARTURE_ALT, true));
+      row.append(lonx);
+      row.append(laty);
+      row.append(num(csv::DEPARTURE_ALT));
 
-      insertQuery.bindValue(":departure_time", QDateTime::fromString(at(values, csv::DEPARTURE_TIME, true), Qt::ISODate));
-      insertQuery.bindValue(":departure_time_sim", QDateTime::fromString(at(values, csv::DEPARTURE_TIME_SIM, true), Qt::ISODate));
+      row.append(QDateTime::fromString(reader.getString(record, csv::DEPARTURE_TIME), Qt::ISODate));
+      row.append(QDateTime::fromString(reader.getString(record, csv::DEPARTURE_TIME_SIM), Qt::ISODate));
 
       // Destination ===============================================================
-      insertQuery.bindValue(":destination_ident", at(values, csv::DESTINATION_IDENT));
-      insertQuery.bindValue(":destination_name", at(values, csv::DESTINATION_NAME));
-      insertQuery.bindValue(":destination_runway", at(values, csv::DESTINATION_RUNWAY));
+      row.append(str(csv::DESTINATION_IDENT));
+      row.append(reader.getString(record, csv::DESTINATION_NAME));
+      row.append(reader.getString(record, csv::DESTINATION_RUNWAY));
 
-      if(!at(values, csv::DESTINATION_LONX).isEmpty() && !at(values, csv::DESTINATION_LATY).isEmpty())
+      lonx = laty = QVariant();
+      if(!reader.isEmpty(record, csv::DESTINATION_LONX) && !reader.isEmpty(record, csv::DESTINATION_LATY))
       {
-        Pos destPos = validateCoordinates(line, at(values, csv::DESTINATION_LONX), at(values, csv::DESTINATION_LATY),
-                                          lineNum, true /* checkNull */);
+        Pos destPos = validateCoordinates(reader.getLine(record), reader.getString(record, csv::DESTINATION_LONX),
+                                          reader.getString(record, csv::DESTINATION_LATY), lineNum, true /* checkNull */);
         if(destPos.isValid())
         {
-          insertQuery.bindValue(":destination_lonx", destPos.getLonX());
-          insertQuery.bindValue(":destination_laty", destPos.getLatY());
+          lonx = destPos.getLonX();
+          laty = destPos.getLatY();
         }
       }
+      row.append(lonx);
+      row.append(laty);
+      row.append(num(csv::DESTINATION_ALT));
 
-      if(!at(values, csv::DESTINATION_ALT).isEmpty())
-        insertQuery.bindValue(":destination_alt", atFloat(values, csv::DESTINATION_ALT, true));
-
-      insertQuery.bindValue(":destination_time", QDateTime::fromString(at(values, csv::DESTINATION_TIME, true), Qt::ISODate));
-      insertQuery.bindValue(":destination_time_sim", QDateTime::fromString(at(values, csv::DESTINATION_TIME_SIM, true), Qt::ISODate));
+      row.append(QDateTime::fromString(reader.getString(record, csv::DESTINATION_TIME), Qt::ISODate));
+      row.append(QDateTime::fromString(reader.getString(record, csv::DESTINATION_TIME_SIM), Qt::ISODate));
 
       // Other ===============================================================
-      insertQuery.bindValue(":route_string", at(values, csv::ROUTE_STRING));
-      insertQuery.bindValue(":simulator", at(values, csv::SIMULATOR));
-      insertQuery.bindValue(":description", at(values, csv::DESCRIPTION));
-
-      // Add files as Gzipped BLOBS ===========================================
-      insertQuery.bindValue(":flightplan", atools::zip::gzipCompress(at(values, csv::FLIGHTPLAN, true /* nowarn */).toUtf8()));
-      insertQuery.bindValue(":aircraft_perf", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_PERF, true /* nowarn */).toUtf8()));
-      insertQuery.bindValue(":aircraft_trail", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_TRAIL, true /* nowarn */).toUtf8()));
+      row.append(str(csv::ROUTE_STRING));
+      row.append(str(csv::SIMULATOR));
+      row.append(str(csv::DESCRIPTION));
 
-      // Fill null fields with empty strings to avoid issues when searching
-      // Also turn empty BLOBs to NULL
-      fixEmptyFields(insertQuery);
+      // Files ===============================================================
+      row.append(blob(csv::FLIGHTPLAN));
+      row.append(blob(csv::AIRCRAFT_PERF));
+      row.append(blob(csv::AIRCRAFT_TRAIL));
+      return true;
+    };
 
-      insertQuery.exec();
-      undoHandler.inserted();
-
-      // Reset unassigned fields to null
-      insertQuery.clearBoundValues();
-
-      lineNum++;
-      numImported++;
-    }
+    numImported = bulkInsert(COLUMNS, reader.getNumRecords(), rowFunc, id, undoHandler);
 
     file.close();
     undoHandler.finish();
-  } // if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  } // if(file.open(QIODevice::ReadOnly))
   else
     throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
 
@@ -603,6 +604,10 @@ void LogdataManager::updateSchema()
   addColumnIf("aircraft_perf", "blob");
   addColumnIf("aircraft_trail", "blob");
 
+  // Compact binary version of aircraft_trail created on demand
+  addColumnIf("aircraft_trail_bin", "blob");
+  trailBinaryColumn = true;
+
   DataManagerBase::updateUndoSchema();
 }
 
@@ -611,6 +616,35 @@ void LogdataManager::clearGeometryCache()
   cache.clear();
 }
 
+void LogdataManager::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  using atools::util::MemoryAccounting;
+
+  cache.forEach([&bytes](int, const atools::fs::gpx::GpxData& data) {
+    bytes += static_cast<qint64>(sizeof(atools::fs::gpx::GpxData)) + MemoryAccounting::vectorBytes(data.trails) +
+             static_cast<qint64>(data.flightplan.size()) *
+             static_cast<qint64>(sizeof(atools::fs::pln::FlightplanEntry));
+
+    for(const atools::fs::gpx::TrailPoints& points : data.trails)
+      bytes += MemoryAccounting::vectorBytes(points);
+  });
+  elements += cache.size();
+}
+
+void LogdataManager::releaseMemory(qint64 maxBytes)
+{
+  qint64 bytes = 0, elements = 0;
+  getMemoryUsage(bytes, elements);
+
+  if(bytes > maxBytes && elements > 0)
+  {
+    // Entries differ in size - assume average size and shrink to the proportional number of entries
+    int maxEntries = cache.getMaxEntries();
+    cache.setMaxEntries(std::max(static_cast<int>(elements * maxBytes / bytes), 1));
+    cache.setMaxEntries(maxEntries);
+  }
+}
+
 void LogdataManager::preCleanup()
 {
   sql::DataManagerBase::preCleanup(CLEANUP_COLUMNS);
@@ -683,78 +717,317 @@ bool LogdataManager::hasTrackAttached(int id)
 const gpx::GpxData *LogdataManager::getGpxData(int id)
 {
   loadGpx(id);
-  return cache.object(id);
+  return cache.value(id);
+}
+
+void LogdataManager::getTrailGeometry(int id, QVector<atools::geo::LineString>& trails)
+{
+  trails.clear();
+
+  if(!cache.contains(id) && trailBinaryColumn)
+  {
+    // Decode binary directly into line strings without filling the cache
+    gpx::GpxData gpxData;
+    bool loaded;
+    QByteArray binary = trailBinary(id, gpxData, loaded);
+    if(loaded)
+    {
+      trailsToLines(trails, gpxData.trails);
+      return;
+    }
+
+    if(binary.isEmpty())
+      // No trail attached
+      return;
+
+    if(gpx::GpxIO().loadGpxBinaryTrails(trails, binary))
+      return;
+  }
+
+  trailsToLines(trails, getGpxData(id)->trails);
+}
+
+void LogdataManager::trailsToLines(QVector<geo::LineString>& lines, const gpx::Trails& trails)
+{
+  lines.reserve(trails.size());
+  for(const gpx::TrailPoints& trail : trails)
+  {
+    atools::geo::LineString line;
+    line.reserve(trail.size());
+    for(const gpx::TrailPoint& point : trail)
+      line.append(point.pos.asPos());
+    lines.append(line);
+  }
 }
 
 void LogdataManager::loadGpx(int id)
 {
   if(!cache.contains(id))
   {
-    gpx::GpxData *entry = new gpx::GpxData;
-    atools::fs::gpx::GpxIO().loadGpxGz(*entry, getValue(id, "aircraft_trail").toByteArray());
-    cache.insert(id, entry);
+    gpx::GpxData entry;
+    gpx::GpxIO gpxIO;
+    if(trailBinaryColumn)
+    {
+      bool loaded;
+      QByteArray binary = trailBinary(id, entry, loaded);
+
+      // Fall back to GPX if binary is corrupted
+      if(!loaded && !binary.isEmpty() && !gpxIO.loadGpxBinary(entry, binary))
+        gpxIO.loadGpxGz(entry, getValue(id, "aircraft_trail").toByteArray());
+    }
+    else
+      gpxIO.loadGpxGz(entry, getValue(id, "aircraft_trail").toByteArray());
+    cache.insert(id, std::move(entry));
   }
 }
 
-void LogdataManager::getFlightStatsTime(QDateTime& earliest, QDateTime& latest, QDateTime& earliestSim,
-                                        QDateTime& latestSim)
+QByteArray LogdataManager::trailBinary(int id, gpx::GpxData& gpxData, bool& loaded)
 {
-  SqlQuery query("select min(departure_time), max(departure_time), "
-                 "min(departure_time_sim), max(departure_time_sim) from " % tableName, db);
+  loaded = false;
+
+  // Get binary and a key for the GPX BLOB built from size and the Gzip trailer which contains CRC and size
+  // This avoids reading and decompressing the BLOB
+  SqlQuery query(db);
+  query.prepare("select aircraft_trail_bin, length(aircraft_trail), substr(aircraft_trail, -8) from " % tableName %
+                " where " % idColumnName % " = ?");
+  query.bindValue(0, id);
   query.exec();
-  if(query.next())
+  if(!query.next())
+    return QByteArray();
+
+  QByteArray binary = query.value(0).toByteArray();
+  qint64 length = query.value(1).toLongLong();
+  QByteArray key = QByteArray::number(length) + ':' + query.value(2).toByteArray().toHex();
+  query.finish();
+
+  if(length <= 0)
+    // No trail attached
+    return QByteArray();
+
+  if(!binary.isEmpty() && gpx::GpxIO::getGpxBinarySourceKey(binary) == key)
+    return binary;
+
+  // Binary missing or outdated - load GPX and save binary for next time
+  gpx::GpxIO gpxIO;
+  gpxIO.loadGpxGz(gpxData, getValue(id, "aircraft_trail").toByteArray());
+  loaded = true;
+  binary = gpxIO.saveGpxBinary(gpxData, key);
+
+  // Derived data - no undo
+  SqlTransaction transaction(db);
+  SqlQuery update(db);
+  update.prepare("update " % tableName % " set aircraft_trail_bin = ? where " % idColumnName % " = ?");
+  update.bindValue(0, binary);
+  update.bindValue(1, id);
+  update.exec();
+  transaction.commit();
+
+  return binary;
+}
+
+/* Columns as used by FlightStats::add() */
+static QString flightStatsQuery(const QString& table)
+{
+  return "select departure_time, departure_time_sim, distance, "
+         "strftime('%s', destination_time) - strftime('%s', departure_time), "
+         "strftime('%s', destination_time_sim) - strftime('%s', departure_time_sim), "
+         "departure_ident, destination_ident, aircraft_type, aircraft_registration, aircraft_name, simulator "
+         "from " % table;
+}
+
+/* Change reference count for key and remove it if not used anymore */
+template<typename MAP, typename KEY>
+static void addCount(MAP& map, const KEY& key, int count)
+{
+  int& value = map[key];
+  value += count;
+  if(value <= 0)
+    map.remove(key);
+}
+
+void LogdataManager::FlightStats::add(const SqlQuery& query, int count)
+{
+  QVariant value = query.value(0);
+  if(!value.isNull())
+    addCount(departureTimes, value.toString(), count);
+
+  value = query.value(1);
+  if(!value.isNull())
+    addCount(departureTimesSim, value.toString(), count);
+
+  value = query.value(2);
+  if(!value.isNull())
   {
-    earliest = query.valueDateTime(0);
-    latest = query.valueDateTime(1);
-    earliestSim = query.valueDateTime(2);
-    latestSim = query.valueDateTime(3);
+    float distance = value.toFloat();
+    addCount(distances, distance, count);
+    distanceSum += static_cast<double>(distance) * count;
+    distanceNum += count;
   }
+
+  // Trip times are null if one of the times is null
+  qint64 tripTime = query.value(3).toLongLong();
+  if(tripTime > 0)
+  {
+    addCount(tripTimes, tripTime, count);
+    tripTimeSum += tripTime * count;
+    tripTimeNum += count;
+  }
+
+  tripTime = query.value(4).toLongLong();
+  if(tripTime > 0)
+  {
+    addCount(tripTimesSim, tripTime, count);
+    tripTimeSimSum += tripTime * count;
+    tripTimeSimNum += count;
+  }
+
+  QHash<QString, int> *distinct[] =
+  {&departureIdents, &destinationIdents, &aircraftTypes, &aircraftRegistrations, &aircraftNames};
+  int index = 5;
+  for(QHash<QString, int> *hash : distinct)
+  {
+    value = query.value(index++);
+    if(!value.isNull())
+      addCount(*hash, value.toString(), count);
+  }
+
+  // Null has its own group in the simulator statistics but is not counted as distinct value
+  value = query.value(index);
+  if(value.isNull())
+    simulatorNullNum += count;
+  else
+    addCount(simulators, value.toString(), count);
 }
 
-void LogdataManager::getFlightStatsDistance(float& distTotal, float& distMax, float& distAverage)
+void LogdataManager::FlightStats::clear()
 {
-  SqlQuery query("select sum(distance), max(distance), avg(distance) from " % tableName, db);
-  query.exec();
-  if(query.next())
+  valid = false;
+  departureTimes.clear();
+  departureTimesSim.clear();
+  distances.clear();
+  distanceSum = 0.;
+  distanceNum = 0;
+  tripTimes.clear();
+  tripTimesSim.clear();
+  tripTimeSum = tripTimeSimSum = 0;
+  tripTimeNum = tripTimeSimNum = 0;
+  departureIdents.clear();
+  destinationIdents.clear();
+  aircraftTypes.clear();
+  aircraftRegistrations.clear();
+  aircraftNames.clear();
+  simulators.clear();
+  simulatorNullNum = 0;
+}
+
+void LogdataManager::updateFlightStats()
+{
+  if(!flightStats.valid)
   {
-    distTotal = query.valueFloat(0);
-    distMax = query.valueFloat(1);
-    distAverage = query.valueFloat(2);
+    flightStats.clear();
+
+    // Calculate all aggregates in one table scan
+    SqlQuery query(flightStatsQuery(tableName), db);
+    query.exec();
+    while(query.next())
+      flightStats.add(query, 1);
+
+    flightStats.valid = true;
   }
 }
 
-void LogdataManager::getFlightStatsAirports(int& numDepartAirports, int& numDestAirports)
+void LogdataManager::updateFlightStats(const QSet<int>& ids, int count)
 {
-  SqlQuery query("select count(distinct departure_ident), count(distinct destination_ident) from " % tableName, db);
-  query.exec();
-  if(query.next())
+  // Nothing to do if statistics were not calculated yet - an empty set would select the whole table
+  if(flightStats.valid && !ids.isEmpty())
   {
-    numDepartAirports = query.valueInt(0);
-    numDestAirports = query.valueInt(1);
+    QueryWrapper query(flightStatsQuery(tableName), db, ids, idColumnName);
+    query.exec();
+    while(query.next())
+      flightStats.add(query.query, count);
   }
 }
 
-void LogdataManager::getFlightStatsAircraft(int& numTypes, int& numRegistrations, int& numNames, int& numSimulators)
+void LogdataManager::rowsChanging(const QSet<int>& ids)
 {
-  SqlQuery query("select count(distinct aircraft_type), count(distinct aircraft_registration), "
-                 "count(distinct aircraft_name), count(distinct simulator) "
-                 "from " % tableName, db);
-  query.exec();
-  if(query.next())
+  updateFlightStats(ids, -1);
+}
+
+void LogdataManager::rowsChanged(const QSet<int>& ids)
+{
+  updateFlightStats(ids, 1);
+}
+
+void LogdataManager::tableChanged()
+{
+  clearFlightStats();
+}
+
+void LogdataManager::getFlightStatsTime(QDateTime& earliest, QDateTime& latest, QDateTime& earliestSim,
+                                        QDateTime& latestSim)
+{
+  updateFlightStats();
+
+  if(!flightStats.departureTimes.isEmpty())
+  {
+    earliest = QVariant(flightStats.departureTimes.firstKey()).toDateTime();
+    latest = QVariant(flightStats.departureTimes.lastKey()).toDateTime();
+  }
+  else
+    earliest = latest = QDateTime();
+
+  if(!flightStats.departureTimesSim.isEmpty())
   {
-    numTypes = query.valueInt(0);
-    numRegistrations = query.valueInt(1);
-    numNames = query.valueInt(2);
-    numSimulators = query.valueInt(3);
+    earliestSim = QVariant(flightStats.departureTimesSim.firstKey()).toDateTime();
+    latestSim = QVariant(flightStats.departureTimesSim.lastKey()).toDateTime();
   }
+  else
+    earliestSim = latestSim = QDateTime();
+}
+
+void LogdataManager::getFlightStatsDistance(float& distTotal, float& distMax, float& distAverage)
+{
+  updateFlightStats();
+
+  distTotal = static_cast<float>(flightStats.distanceSum);
+  distMax = flightStats.distances.isEmpty() ? 0.f : flightStats.distances.lastKey();
+  distAverage = flightStats.distanceNum > 0 ? static_cast<float>(flightStats.distanceSum / flightStats.distanceNum) : 0.f;
+}
+
+void LogdataManager::getFlightStatsAirports(int& numDepartAirports, int& numDestAirports)
+{
+  updateFlightStats();
+
+  numDepartAirports = flightStats.departureIdents.size();
+  numDestAirports = flightStats.destinationIdents.size();
+}
+
+void LogdataManager::getFlightStatsAircraft(int& numTypes, int& numRegistrations, int& numNames, int& numSimulators)
+{
+  updateFlightStats();
+
+  numTypes = flightStats.aircraftTypes.size();
+  numRegistrations = flightStats.aircraftRegistrations.size();
+  numNames = flightStats.aircraftNames.size();
+  numSimulators = flightStats.simulators.size();
 }
 
 void LogdataManager::getFlightStatsSimulator(QVector<std::pair<int, QString> >& numSimulators)
 {
-  SqlQuery query("select count(1), simulator from " % tableName % " group by simulator order by count(1) desc", db);
-  query.exec();
-  while(query.next())
-    numSimulators.append(std::make_pair(query.valueInt(0), query.valueStr(1)));
+  updateFlightStats();
+
+  int first = numSimulators.size();
+  for(auto it = flightStats.simulators.constBegin(); it != flightStats.simulators.constEnd(); ++it)
+    numSimulators.append(std::make_pair(it.value(), it.key()));
+
+  if(flightStats.simulatorNullNum > 0)
+    numSimulators.append(std::make_pair(flightStats.simulatorNullNum, QString()));
+
+  // Order by count descending
+  std::sort(numSimulators.begin() + first, numSimulators.end(),
+            [](const std::pair<int, QString>& p1, const std::pair<int, QString>& p2) -> bool {
+    return p1.first > p2.first;
+  });
 }
 
 void LogdataManager::fixEmptyStrField(sql::SqlRecord& rec, const QString& name)
@@ -822,31 +1095,16 @@ void LogdataManager::fixEmptyFields(sql::SqlQuery& query)
 void LogdataManager::getFlightStatsTripTime(float& timeMaximum, float& timeAverage, float& timeTotal,
                                             float& timeMaximumSim, float& timeAverageSim, float& timeTotalSim)
 {
-  SqlQuery query(db);
+  updateFlightStats();
 
-  query.exec("select max(time_real), avg(time_real), sum(time_real) "
-             "from (select strftime('%s', destination_time) - strftime('%s', departure_time) as time_real "
-             "from " % tableName % ") where time_real > 0");
-  if(query.next())
-  {
-    int idx = 0;
-    timeMaximum = query.valueFloat(idx++) / 3600.f;
-    timeAverage = query.valueFloat(idx++) / 3600.f;
-    timeTotal = query.valueFloat(idx++) / 3600.f;
-  }
-  query.finish();
+  const FlightStats& stats = flightStats;
+  timeMaximum = stats.tripTimes.isEmpty() ? 0.f : stats.tripTimes.lastKey() / 3600.f;
+  timeAverage = stats.tripTimeNum > 0 ? static_cast<float>(stats.tripTimeSum) / stats.tripTimeNum / 3600.f : 0.f;
+  timeTotal = stats.tripTimeSum / 3600.f;
 
-  query.exec("select max(time_sim), avg(time_sim), sum(time_sim) "
-             "from (select strftime('%s', destination_time_sim) - strftime('%s', departure_time_sim) as time_sim "
-             "from " % tableName % ") where time_sim > 0");
-  if(query.next())
-  {
-    int idx = 0;
-    timeMaximumSim = query.valueFloat(idx++) / 3600.f;
-    timeAverageSim = query.valueFloat(idx++) / 3600.f;
-    timeTotalSim = query.valueFloat(idx++) / 3600.f;
-  }
-  query.finish();
+  timeMaximumSim = stats.tripTimesSim.isEmpty() ? 0.f : stats.tripTimesSim.lastKey() / 3600.f;
+  timeAverageSim = stats.tripTimeSimNum > 0 ? static_cast<float>(stats.tripTimeSimSum) / stats.tripTimeSimNum / 3600.f : 0.f;
+  timeTotalSim = stats.tripTimeSimSum / 3600.f;
 }
 
 } // namespace userdata
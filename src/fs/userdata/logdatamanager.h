@@ -20,8 +20,11 @@
 
 #include "sql/datamanagerbase.h"
 #include "fs/gpx/gpxtypes.h"
+#include "util/memoryaccounting.h"
+#include "util/timedcache.h"
 
-#include <QCache>
+#include <QHash>
+#include <QMap>
 
 namespace atools {
 namespace geo {
@@ -40,12 +43,18 @@ namespace userdata {
  * Contains special functionality around the logbook database.
  */
 class LogdataManager :
-  public atools::sql::DataManagerBase
+  public atools::sql::DataManagerBase, public atools::util::MemoryAccountable
 {
 public:
   LogdataManager(atools::sql::SqlDatabase *sqlDb);
   virtual ~LogdataManager() override;
 
+  /* Flight plans and trails in the geometry cache. Elements are cached logbook entries. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
+  /* Removes least recently used entries from the geometry cache until below maxBytes */
+  virtual void releaseMemory(qint64 maxBytes) override;
+
   /* Import from a custom CSV format which covers all fields in the logbook table. */
   int importCsv(const QString& filepath);
 
@@ -66,6 +75,10 @@ public:
    *  Also includes route waypoint names. */
   const atools::fs::gpx::GpxData *getGpxData(int id);
 
+  /* Get only trail geometry with one line string per trail segment. Faster than getGpxData() since the compact
+   * binary trail is decoded directly without using the cache. Use to show many logbook trails at once. */
+  void getTrailGeometry(int id, QVector<atools::geo::LineString>& trails);
+
   /* Clear cache used by getRouteGeometry and getTrackGeometry */
   void clearGeometryCache();
 
@@ -82,6 +95,9 @@ public:
   bool hasPerfAttached(int id);
   bool hasTrackAttached(int id);
 
+  /* All getFlightStats* methods use aggregates which are calculated in one table scan on first access and kept
+   * up to date incrementally for changes done through this class. */
+
   /* Get various statistical information for departure times */
   void getFlightStatsTime(QDateTime& earliest, QDateTime& latest, QDateTime& earliestSim, QDateTime& latestSim);
 
@@ -105,6 +121,11 @@ public:
 
   static const int MAX_CACHE_ENTRIES = 100;
 
+  /* Spatial index numbers for departure and destination positions in DataManagerBase::getIdsInRadius(),
+   * getNearestId() and getIdsInRect() */
+  static Q_DECL_CONSTEXPR int SPATIAL_DEPARTURE = 0;
+  static Q_DECL_CONSTEXPR int SPATIAL_DESTINATION = 1;
+
   /* Run this to replace null values with empty strings to allow queries in cleanupUserdata() and getCleanupPreview().
    * Clean up - set null string columns empty to allow join - hidden compatibility change, no need to undo */
   void preCleanup();
@@ -113,7 +134,54 @@ public:
    * Clean up - set empty string columns back to null - no need to undo. */
   void postCleanup();
 
+  /* Forces recalculation of flight statistics on next access. Call after changing the table directly or after
+   * rolling back a transaction. */
+  void clearFlightStats()
+  {
+    flightStats.valid = false;
+  }
+
+protected:
+  /* Update statistics from DataManagerBase change hooks */
+  virtual void rowsChanging(const QSet<int>& ids) override;
+  virtual void rowsChanged(const QSet<int>& ids) override;
+  virtual void tableChanged() override;
+
 private:
+  /* Materialized aggregates for statistics. All values are reference counted to allow removing rows
+   * without a full table scan. Distinct counts are the number of keys and minimum or maximum are the first or last
+   * keys of ordered maps. Null values are not counted like in SQL aggregates. */
+  struct FlightStats
+  {
+    /* Add (count = 1) or remove (count = -1) the row at the current position of query */
+    void add(const atools::sql::SqlQuery& query, int count);
+    void clear();
+
+    bool valid = false;
+
+    /* Departure times as stored in the table - ISO format sorts like SQL min and max */
+    QMap<QString, int> departureTimes, departureTimesSim;
+
+    QMap<float, int> distances;
+    double distanceSum = 0.;
+    int distanceNum = 0;
+
+    /* Trip times in seconds - only values > 0 */
+    QMap<qint64, int> tripTimes, tripTimesSim;
+    qint64 tripTimeSum = 0, tripTimeSimSum = 0;
+    int tripTimeNum = 0, tripTimeSimNum = 0;
+
+    QHash<QString, int> departureIdents, destinationIdents, aircraftTypes, aircraftRegistrations, aircraftNames,
+                        simulators;
+    int simulatorNullNum = 0;
+  };
+
+  /* Run full table scan if statistics are not valid */
+  void updateFlightStats();
+
+  /* Add or remove rows to statistics if valid */
+  void updateFlightStats(const QSet<int>& ids, int count);
+
   static void fixEmptyStrField(atools::sql::SqlRecord& rec, const QString& name);
   static void fixEmptyStrField(atools::sql::SqlQuery& query, const QString& name);
   static void fixEmptyBlobField(atools::sql::SqlRecord& rec, const QString& name);
@@ -131,8 +199,19 @@ private:
   /* Prime cache by loading the GpxCacheEntry */
   void loadGpx(int id);
 
+  /* Get binary trail for id. Creates and stores it from the GPX BLOB if missing or outdated.
+   * Fills gpxData and sets loaded to true if the GPX had to be loaded. Returns empty array if no trail is attached. */
+  QByteArray trailBinary(int id, atools::fs::gpx::GpxData& gpxData, bool& loaded);
+
+  static void trailsToLines(QVector<atools::geo::LineString>& lines, const atools::fs::gpx::Trails& trails);
+
   /* Cache to avoid reading BLOBs */
-  QCache<int, atools::fs::gpx::GpxData> cache;
+  atools::util::TimedCache<int, atools::fs::gpx::GpxData> cache;
+
+  /* Column aircraft_trail_bin was added by updateSchema() */
+  bool trailBinaryColumn = false;
+
+  FlightStats flightStats;
 
 };
 
@@ -23,18 +23,22 @@
 #include "fs/util/fsutil.h"
 #include "geo/calculations.h"
 #include "geo/pos.h"
+#include "io/linereader.h"
 #include "sql/sqlcolumn.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlexport.h"
 #include "sql/sqltransaction.h"
 #include "sql/sqlutil.h"
-#include "util/csvreader.h"
+#include "util/csvbulkreader.h"
 
 #include <QDir>
+#include <QHash>
 #include <QRegularExpression>
 #include <QStringBuilder>
 #include <QXmlStreamReader>
 
+#include <cmath>
+
 namespace atools {
 namespace fs {
 namespace userdata {
@@ -56,6 +60,9 @@ using Qt::endl;
 const static double VISIBLE_FROM_DEFAULT_NM = 250.;
 const static QStringList CLEANUP_COLUMNS({"type", "name", "ident", "region", "description", "tags"});
 
+/* Maximum sum of longitude and latitude difference in degrees for duplicate coordinates */
+const static double CLEANUP_MAX_COORDINATE_DIFF = 0.0001;
+
 namespace csv {
 /* Column indexes in CSV format */
 enum Index
@@ -112,7 +119,8 @@ UserdataManager::UserdataManager(sql::SqlDatabase *sqlDb)
                     ":/atools/resources/sql/fs/userdata/create_user_schema_undo.sql",
                     ":/atools/resources/sql/fs/userdata/drop_user_schema.sql")
 {
-
+  // Spatial index number 0 used by default in queries
+  addSpatialIndex("lonx", "laty");
 }
 
 UserdataManager::~UserdataManager()
@@ -152,7 +160,11 @@ int UserdataManager::cleanupUserdata(const QStringList& duplicateColumns, bool d
   qDebug() << Q_FUNC_INFO;
 
   QSet<int> ids;
-  SqlUtil(db).getIds(ids, cleanupWhere(duplicateColumns, duplicateCoordinates, empty));
+  if(empty)
+    SqlUtil(db).getIds(ids, cleanupEmptyQuery());
+
+  if(!duplicateColumns.isEmpty())
+    findDuplicateIds(ids, duplicateColumns, duplicateCoordinates);
 
   postCleanup();
 
@@ -175,28 +187,132 @@ QString UserdataManager::cleanupWhere(const QStringList& duplicateColumns, bool
 
   // Sub-query to delete empty rows ==================================================
   if(empty)
-    // Query for empty using empty column values as prepared by preCleanup() - avoid null compare
-    whereStmt.append("select " % idColumnName % " from " % tableName %
-                     " where name = '' and ident = '' and region = '' and description = '' and tags = ''");
+    whereStmt.append(cleanupEmptyQuery());
 
   // Sub-query to remove duplicates ========================================
   if(!duplicateColumns.isEmpty())
   {
-    QStringList joinCols;
-    for(const QString& column : duplicateColumns)
-      joinCols.append(QString(" u1.%1 = u2.%1 ").arg(column));
+    // Duplicates are found in memory - pass ids as list
+    QSet<int> ids;
+    findDuplicateIds(ids, duplicateColumns, duplicateCoordinates);
 
-    QString queryStr("select u1.userdata_id from userdata u1 join userdata u2 on " % joinCols.join(" and ") %
-                     " where u1.userdata_id < u2.userdata_id");
+    QStringList idList;
+    idList.reserve(ids.size());
+    for(int id : qAsConst(ids))
+      idList.append(QString::number(id));
 
-    if(duplicateCoordinates)
-      queryStr.append(" and (abs(u1.lonx - u2.lonx) + abs(u1.laty - u2.laty)) < 0.0001");
-
-    whereStmt.append(queryStr);
+    whereStmt.append("select " % idColumnName % " from " % tableName % " where " % idColumnName % " in (" %
+                     idList.join(",") % ")");
   }
   return whereStmt.join(" union ");
 }
 
+QString UserdataManager::cleanupEmptyQuery() const
+{
+  // Query for empty using empty column values as prepared by preCleanup() - avoid null compare
+  return "select " % idColumnName % " from " % tableName %
+         " where name = '' and ident = '' and region = '' and description = '' and tags = ''";
+}
+
+void UserdataManager::findDuplicateIds(QSet<int>& ids, const QStringList& duplicateColumns, bool duplicateCoordinates)
+{
+  struct Entry
+  {
+    int id;
+    double lonx, laty;
+  };
+
+  // Collect entries by key in one table scan ==============================
+  QHash<QString, QVector<Entry> > groups;
+  SqlQuery query("select " % idColumnName % ", lonx, laty, " % duplicateColumns.join(", ") % " from " % tableName, db);
+  query.exec();
+
+  int numColumns = duplicateColumns.size();
+  QString key;
+  while(query.next())
+  {
+    key.clear();
+    for(int i = 0; i < numColumns; i++)
+    {
+      // Fold only ASCII characters like SQLite collate nocase - null is equal to empty as after preCleanup()
+      QString value = query.valueStr(i + 3);
+      for(QChar& c : value)
+      {
+        if(c.unicode() >= 'A' && c.unicode() <= 'Z')
+          c = QChar(c.unicode() + ('a' - 'A'));
+      }
+      key.append(value);
+      key.append(QChar(0x1f)); // Unit separator
+    }
+    groups[key].append({query.valueInt(0), query.valueDouble(1), query.valueDouble(2)});
+  }
+
+  for(QVector<Entry>& group : groups)
+  {
+    if(group.size() < 2)
+      continue;
+
+    if(!duplicateCoordinates)
+    {
+      // Keep only the entry with the highest id
+      int maxId = group.constFirst().id;
+      for(const Entry& entry : qAsConst(group))
+        maxId = std::max(maxId, entry.id);
+
+      for(const Entry& entry : qAsConst(group))
+      {
+        if(entry.id != maxId)
+          ids.insert(entry.id);
+      }
+    }
+    else
+    {
+      // Put entries into grid cells having the size of the maximum difference.
+      // Close entries can only be in the same or a neighbor cell.
+      const double CELL = CLEANUP_MAX_COORDINATE_DIFF;
+      QHash<QPair<qint64, qint64>, QVector<int> > grid;
+      for(int i = 0; i < group.size(); i++)
+      {
+        const Entry& entry = group.at(i);
+        grid[qMakePair(static_cast<qint64>(std::floor(entry.lonx / CELL)),
+                       static_cast<qint64>(std::floor(entry.laty / CELL)))].append(i);
+      }
+
+      for(const Entry& entry : qAsConst(group))
+      {
+        qint64 cellX = static_cast<qint64>(std::floor(entry.lonx / CELL));
+        qint64 cellY = static_cast<qint64>(std::floor(entry.laty / CELL));
+
+        // Duplicate if there is a close entry with a higher id
+        bool found = false;
+        for(qint64 x = cellX - 1; x <= cellX + 1 && !found; x++)
+        {
+          for(qint64 y = cellY - 1; y <= cellY + 1 && !found; y++)
+          {
+            auto it = grid.constFind(qMakePair(x, y));
+            if(it != grid.constEnd())
+            {
+              for(int index : it.value())
+              {
+                const Entry& other = group.at(index);
+                if(other.id > entry.id &&
+                   std::abs(entry.lonx - other.lonx) + std::abs(entry.laty - other.laty) < CLEANUP_MAX_COORDINATE_DIFF)
+                {
+                  found = true;
+                  break;
+                }
+              }
+            }
+          }
+        }
+
+        if(found)
+          ids.insert(entry.id);
+      }
+    }
+  }
+}
+
 void UserdataManager::clearTemporary()
 {
   qDebug() << Q_FUNC_INFO;
@@ -212,104 +328,82 @@ int UserdataManager::importCsv(const QStringList& filepaths, atools::fs::userdat
   int id = getCurrentId() + 1;
   atools::sql::DataManagerUndoHandler undoHandler(this, id);
 
+  const static QStringList COLUMNS({"type", "name", "ident", "region", "description", "tags", "import_file_path", "temp",
+                                    "last_edit_timestamp", "visible_from", "altitude", "lonx", "laty"});
+
   for(const QString& filepath : filepaths)
   {
     if(filepath.isEmpty())
       continue;
 
     QFile file(filepath);
-    if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+    if(file.open(QIODevice::ReadOnly))
     {
-      QString idBinding(":" % idColumnName);
-
-      // Autogenerate id
-      QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(), QStringList(), true /* namedBindings */);
-      SqlQuery insertQuery(db);
-      insertQuery.prepare(insert);
+      // Map file and split into records and values
+      atools::util::CsvBulkReader reader(separator.toLatin1(), escape.toLatin1(), true /* trim */);
+      if(!reader.read(&file))
+        throw atools::Exception(tr("Cannot read file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
 
       QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-      QDateTime now = QDateTime::currentDateTime();
-
-      atools::util::CsvReader reader(separator, escape, true /* trim */);
-
-      QTextStream stream(&file);
-      stream.setCodec("UTF-8");
+      QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
 
-      int lineNum = 1;
-      while(!stream.atEnd())
+      int firstRecord = 0;
+      if(reader.getNumRecords() > 0)
       {
-        QString line = stream.readLine();
-
-        if(lineNum == 1)
-        {
-          QString header = QString(line).simplified().replace(' ', QString()).replace('"', QString()).toLower();
-          if(flags & CSV_HEADER || header.startsWith("type,name,ident,latitude,longitude"))
-          {
-            lineNum++;
-            // Ignore header
-            continue;
-          }
-        }
-
-        // Skip empty lines but add them if within an escaped field
-        if(line.isEmpty() && !reader.isInEscape())
-          continue;
-
-        reader.readCsvLine(line);
-        if(reader.isInEscape())
-          // Still in an escaped line so continue to read unchanged until " shows the end of the field
-          continue;
-
-        const QStringList& values = reader.getValues();
-
-        if(values.size() < csv::MIN_NUM_COLS)
-          throw atools::Exception(tr("File contains invalid data.\n\"%1\"\nLine %2.").arg(line).arg(lineNum));
+        QString header = reader.getLine(0).simplified().replace(' ', QString()).replace('"', QString()).toLower();
+        if(flags & CSV_HEADER || header.startsWith("type,name,ident,latitude,longitude"))
+          // Ignore header
+          firstRecord = 1;
+      }
 
-        insertQuery.bindValue(idBinding, id++);
-        insertQuery.bindValue(":type", at(values, csv::TYPE));
-        insertQuery.bindValue(":name", at(values, csv::NAME));
-        insertQuery.bindValue(":ident", at(values, csv::IDENT));
-        insertQuery.bindValue(":region", at(values, csv::REGION, true /* no warning */));
-        insertQuery.bindValue(":description", at(values, csv::DESCRIPTION));
-        insertQuery.bindValue(":tags", at(values, csv::TAGS));
-        insertQuery.bindValue(":import_file_path", absfilepath);
-        insertQuery.bindValue(":temp", 0);
+      // Called in parallel for all records
+      auto rowFunc = [this, &reader, firstRecord, &absfilepath, &now](QVariantList& row, int record) -> bool {
+        // Skip header and empty lines
+        if(record < firstRecord || reader.isEmpty(record))
+          return false;
+
+        if(reader.getNumValues(record) < csv::MIN_NUM_COLS)
+          throw atools::Exception(tr("File contains invalid data.\n\"%1\"\nLine %2.").
+                                  arg(reader.getLine(record)).arg(reader.getLineNumber(record)));
+
+        row.append(reader.getString(record, csv::TYPE));
+        row.append(reader.getString(record, csv::NAME));
+        row.append(reader.getString(record, csv::IDENT));
+        row.append(reader.getString(record, csv::REGION));
+        row.append(reader.getString(record, csv::DESCRIPTION));
+        row.append(reader.getString(record, csv::TAGS));
+        row.append(absfilepath);
+        row.append(0);
 
         // YYYY-MM-DDTHH:mm:ss
-        QDateTime lastEdit = QDateTime::fromString(at(values, csv::LAST_EDIT, true /* no warning */), Qt::ISODate);
-        if(lastEdit.isValid())
-          insertQuery.bindValue(":last_edit_timestamp", lastEdit.toString(Qt::ISODate));
-        else
-          insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
+        QDateTime lastEdit = QDateTime::fromString(reader.getString(record, csv::LAST_EDIT), Qt::ISODate);
+        row.append(lastEdit.isValid() ? lastEdit.toString(Qt::ISODate) : now);
 
         bool ok;
-        float visibleFrom = at(values, csv::VISIBLE_FROM, true /* no warning */).toFloat(&ok);
+        float visibleFrom = reader.getFloat(record, csv::VISIBLE_FROM, &ok);
         if(visibleFrom > 0.f && ok)
-          insertQuery.bindValue(":visible_from", visibleFrom);
+          row.append(visibleFrom);
         else
-          insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
+          row.append(VISIBLE_FROM_DEFAULT_NM);
 
-        QString altStr = at(values, csv::ALT).trimmed();
+        QByteArray altStr = reader.getBytes(record, csv::ALT).trimmed();
         float alt = 0.f;
-        if(altStr.endsWith("f"))
-          alt = altStr.leftRef(altStr.size() - 1).toFloat();
-        else if(altStr.endsWith("m"))
-          alt = atools::geo::meterToFeet(altStr.leftRef(altStr.size() - 1).toFloat());
+        if(altStr.endsWith('f'))
+          alt = altStr.left(altStr.size() - 1).toFloat();
+        else if(altStr.endsWith('m'))
+          alt = atools::geo::meterToFeet(altStr.left(altStr.size() - 1).toFloat());
         else
           alt = altStr.toFloat();
+        row.append(alt);
 
-        insertQuery.bindValue(":altitude", alt);
-
-        validateCoordinates(line, at(values, csv::LONX), at(values, csv::LATY), lineNum, false /* checkNull */);
-        insertQuery.bindValue(":lonx", at(values, csv::LONX, true));
-        insertQuery.bindValue(":laty", at(values, csv::LATY, true));
-
-        insertQuery.exec();
-        undoHandler.inserted();
+        validateCoordinates(reader.getLine(record), reader.getString(record, csv::LONX), reader.getString(record, csv::LATY),
+                            reader.getLineNumber(record), false /* checkNull */);
+        row.append(reader.getDouble(record, csv::LONX));
+        row.append(reader.getDouble(record, csv::LATY));
+        return true;
+      };
 
-        lineNum++;
-        numImported++;
-      }
+      numImported += bulkInsert(COLUMNS, reader.getNumRecords(), rowFunc, id, undoHandler);
       file.close();
     }
     else
@@ -332,44 +426,53 @@ int UserdataManager::importXplane(const QString& filepath)
 {
   int numImported = 0;
   QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(file.open(QIODevice::ReadOnly))
   {
     int id = getCurrentId() + 1;
     atools::sql::DataManagerUndoHandler undoHandler(this, id);
-    QString idBinding(":" % idColumnName);
 
-    QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(), {"description", "altitude"}, true /* namedBindings */);
-    SqlQuery insertQuery(db);
-    insertQuery.prepare(insert);
+    QVector<QByteArray> lines;
+    atools::io::LineReader lineReader;
+    readLines(lines, lineReader, file);
 
     QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-    QDateTime now = QDateTime::currentDateTime();
-
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+    QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
 
-    QString line = stream.readLine().simplified();
+    QString line = lineAt(lines, 0).simplified();
     if(line != "I" && line != "A")
       throw atools::Exception(tr("File is not an X-Plane user_fix.dat file."));
 
-    line = stream.readLine().simplified();
+    line = lineAt(lines, 1).simplified();
     if(!line.startsWith("11") && !line.startsWith("12"))
       throw atools::Exception(tr("File is not an X-Plane user_fix.dat file."));
 
-    line = stream.readLine().simplified();
+    line = lineAt(lines, 2).simplified();
     if(!line.isEmpty())
       throw atools::Exception(tr("File is not an X-Plane user_fix.dat file."));
 
-    int lineNum = 1;
-    while(!stream.atEnd())
+    // Data starts after the header and ends before "99"
+    const int FIRST_LINE = 3;
+    int numLines = std::max(lines.size() - FIRST_LINE, 0);
+    for(int i = 0; i < numLines; i++)
     {
-      line = stream.readLine().simplified();
-      if(line.isEmpty())
-        continue;
-      if(line == "99")
+      if(lines.at(i + FIRST_LINE).trimmed() == "99")
+      {
+        numLines = i;
         break;
+      }
+    }
 
-      QStringList cols = line.split(' ');
+    const static QStringList COLUMNS({"type", "ident", "region", "tags", "name", "last_edit_timestamp", "import_file_path",
+                                      "visible_from", "temp", "lonx", "laty"});
+
+    // Called in parallel for all lines
+    auto rowFunc = [this, &lines, FIRST_LINE, &absfilepath, &now](QVariantList& row, int record) -> bool {
+      int lineIndex = record + FIRST_LINE;
+      QString dataLine = QString::fromUtf8(lines.at(lineIndex)).simplified();
+      if(dataLine.isEmpty())
+        return false;
+
+      QStringList cols = dataLine.split(' ');
 
       // XP12 "51.801667   -8.573889  VP001 ENRT EI 2105430 HALFWAY ROUTE"
       // XP11 "46.646819444 -123.722388889 AAYRR KSEA  K1 4530263"
@@ -378,31 +481,27 @@ int UserdataManager::importXplane(const QString& filepath)
       tags.append(atools::fs::util::waypointFlagsFromXplane(at(cols, xp::FLAGS, true /* nowarn */)).replace(' ', '_'));
       tags.removeAll(QString());
 
-      insertQuery.bindValue(idBinding, id++);
-      insertQuery.bindValue(":type", "Waypoint");
-      insertQuery.bindValue(":ident", at(cols, xp::IDENT));
-      insertQuery.bindValue(":region", at(cols, xp::REGION));
-      insertQuery.bindValue(":tags", tags.join(' '));
-      insertQuery.bindValue(":name", cols.mid(xp::NAME).join(' ')); // Get rest of line as name
-      insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-      insertQuery.bindValue(":temp", 0);
-
-      validateCoordinates(line, at(cols, xp::LONX), at(cols, xp::LATY), lineNum, false /* checkNull */);
-      insertQuery.bindValue(":lonx", at(cols, xp::LONX));
-      insertQuery.bindValue(":laty", at(cols, xp::LATY));
+      row.append("Waypoint");
+      row.append(at(cols, xp::IDENT));
+      row.append(at(cols, xp::REGION));
+      row.append(tags.join(' '));
+      row.append(cols.mid(xp::NAME).join(' ')); // Get rest of line as name
+      row.append(now);
+      row.append(absfilepath);
+      row.append(VISIBLE_FROM_DEFAULT_NM);
+      row.append(0);
 
-      insertQuery.exec();
-      undoHandler.inserted();
+      validateCoordinates(dataLine, at(cols, xp::LONX), at(cols, xp::LATY), lineIndex + 1, false /* checkNull */);
+      row.append(at(cols, xp::LONX));
+      row.append(at(cols, xp::LATY));
+      return true;
+    };
 
-      numImported++;
-      lineNum++;
-    } // while(!stream.atEnd())
+    numImported = bulkInsert(COLUMNS, numLines, rowFunc, id, undoHandler);
 
     file.close();
     undoHandler.finish();
-  } // if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  } // if(file.open(QIODevice::ReadOnly))
   else
     throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
 
@@ -434,60 +533,69 @@ int UserdataManager::importGarmin(const QString& filepath)
 {
   int numImported = 0;
   QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(file.open(QIODevice::ReadOnly))
   {
     int id = getCurrentId() + 1;
     atools::sql::DataManagerUndoHandler undoHandler(this, id);
-    QString idBinding(":" % idColumnName);
 
-    QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(),
-                                                      {"description", "altitude", "region"}, true /* namedBindings */);
-    SqlQuery insertQuery(db);
-    insertQuery.prepare(insert);
+    QVector<QByteArray> lines;
+    atools::io::LineReader lineReader;
+    readLines(lines, lineReader, file);
 
     QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-    QDateTime now = QDateTime::currentDateTime();
+    QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
 
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+    const static QStringList COLUMNS({"type", "name", "ident", "last_edit_timestamp", "import_file_path", "visible_from",
+                                      "temp", "lonx", "laty"});
 
-    int lineNum = 1;
-    while(!stream.atEnd())
-    {
-      QString line = stream.readLine().simplified();
+    // Called in parallel for all lines
+    auto rowFunc = [this, &lines, &absfilepath, &now](QVariantList& row, int record) -> bool {
+      QString line = QString::fromUtf8(lines.at(record)).simplified();
       if(line.isEmpty())
-        continue;
+        return false;
 
       QStringList cols = line.split(",");
 
-      insertQuery.bindValue(idBinding, id++);
-      insertQuery.bindValue(":type", "Waypoint");
-      insertQuery.bindValue(":name", at(cols, gm::NAME));
-      insertQuery.bindValue(":ident", at(cols, gm::IDENT));
-      insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-      insertQuery.bindValue(":temp", 0);
-
-      validateCoordinates(line, at(cols, gm::LONX), at(cols, gm::LATY), lineNum, false /* checkNull */);
-      insertQuery.bindValue(":lonx", at(cols, gm::LONX));
-      insertQuery.bindValue(":laty", at(cols, gm::LATY));
+      row.append("Waypoint");
+      row.append(at(cols, gm::NAME));
+      row.append(at(cols, gm::IDENT));
+      row.append(now);
+      row.append(absfilepath);
+      row.append(VISIBLE_FROM_DEFAULT_NM);
+      row.append(0);
 
-      insertQuery.exec();
-      undoHandler.inserted();
+      validateCoordinates(line, at(cols, gm::LONX), at(cols, gm::LATY), record + 1, false /* checkNull */);
+      row.append(at(cols, gm::LONX));
+      row.append(at(cols, gm::LATY));
+      return true;
+    };
 
-      numImported++;
-      lineNum++;
-    }
+    numImported = bulkInsert(COLUMNS, lines.size(), rowFunc, id, undoHandler);
 
     file.close();
     undoHandler.finish();
-  } // if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  } // if(file.open(QIODevice::ReadOnly))
   else
     throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
   return numImported;
 }
 
+void UserdataManager::readLines(QVector<QByteArray>& lines, io::LineReader& lineReader, QFile& file)
+{
+  if(!lineReader.open(&file))
+    throw atools::Exception(tr("Cannot read file \"%1\". Reason: %2.").arg(file.fileName()).arg(file.errorString()));
+
+  // Lines reference the mapped file
+  QByteArray line;
+  while(lineReader.readLine(line))
+    lines.append(line);
+}
+
+QString UserdataManager::lineAt(const QVector<QByteArray>& lines, int index)
+{
+  return index < lines.size() ? QString::fromUtf8(lines.at(index)) : QString();
+}
+
 int UserdataManager::exportCsv(const QString& filepath, const QVector<int>& ids, atools::fs::userdata::Flags flags, QChar separator,
                                QChar escape) const
 {
@@ -20,6 +20,8 @@
 
 #include "sql/datamanagerbase.h"
 
+class QFile;
+
 namespace atools {
 
 namespace sql {
@@ -27,6 +29,9 @@ namespace sql {
 class SqlColumn;
 class SqlDatabase;
 }
+namespace io {
+class LineReader;
+}
 namespace fs {
 namespace common {
 class MagDecReader;
@@ -110,6 +115,21 @@ private:
   /* Returns a union query returning the ids to delete */
   QString cleanupWhere(const QStringList& duplicateColumns, bool duplicateCoordinates, bool empty);
 
+  /* Query for empty userpoints */
+  QString cleanupEmptyQuery() const;
+
+  /* Find duplicates in one table scan by hashing the case folded values of duplicateColumns. All entries of a
+   * group except the one with the highest id are added to ids. If duplicateCoordinates is set an entry is only
+   * a duplicate if an entry with a higher id in the same group is closer than CLEANUP_MAX_COORDINATE_DIFF.
+   * Nearby entries are found using a grid hash. */
+  void findDuplicateIds(QSet<int>& ids, const QStringList& duplicateColumns, bool duplicateCoordinates);
+
+  /* Map file and get all lines referencing the mapped memory. Throws exception on error. */
+  void readLines(QVector<QByteArray>& lines, atools::io::LineReader& lineReader, QFile& file);
+
+  /* Line converted to string or empty if index is out of range */
+  static QString lineAt(const QVector<QByteArray>& lines, int index);
+
   atools::fs::common::MagDecReader *magDec;
 };
 
@@ -33,53 +33,347 @@ namespace util {
 
 // N48194W123096
 const static QString COORDS_FLIGHTPLAN_FORMAT_GFP("%1%2%3%4%5%6");
-const static QRegularExpression LONG_FORMAT_REGEXP_GFP("^([NS])([0-9]{2})([0-9]{3})"
-                                                       "([EW])([0-9]{3})([0-9]{3})$");
-
-// 46N078W
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG("^([0-9]{2})([NS])"
-                                                       "([0-9]{3})([EW])$");
 
 // 4510N06810W
 const static QString COORDS_FLIGHTPLAN_FORMAT_DEG_MIN("%1%2%3%4%5%6");
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN("^([0-9]{2})([0-9]{2})([NS])"
-                                                           "([0-9]{3})([0-9]{2})([EW])$");
 
 // 481200N0112842E
 const static QString COORDS_FLIGHTPLAN_FORMAT_DEG_MIN_SEC("%1%2%3%4%5%6%7%8");
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN_SEC("^([0-9]{2})([0-9]{2})([0-9]{2})([NS])"
-                                                               "([0-9]{3})([0-9]{2})([0-9]{2})([EW])$");
-
-// Pattern allows trailing garbage
-// 50:40:42 N 003:13:30 E
-// 31:30:00 N 086:44:59 W
-static QRegularExpression MATCH_COORD_OPENAIR_MIN_SEC("^([\\d]+):([\\d]+):([\\d\\.]+)\\s*([NS])\\s*"
-                                                      "([\\d]+):([\\d]+):([\\d\\.]+)\\s*([EW])");
-
-// Pattern allows trailing garbage
-// 39:06.2 N 121:35.5 W
-static QRegularExpression MATCH_COORD_OPENAIR_MIN("^([\\d]+):([\\d\\.]+)\\s*([NS])\\s*"
-                                                  "([\\d]+):([\\d\\.]+)\\s*([EW])");
-
-// ARINC full degreee waypoints
-// 57N30 5730N 5730E 57E30
-// 57W30 5730W 5730S 57S30
-const static QRegularExpression LONG_FORMAT_REGEXP_ARINC("^([0-9]{2})"
-                                                         "([0-9]{2})([NWES])$");
-const static QRegularExpression LONG_FORMAT_REGEXP_ARINC2("^([0-9]{2})([NWES])"
-                                                          "([0-9]{2})$");
-
-// N6400 W07000 or N6400/W07000
-const static QString COORDS_FLIGHTPLAN_FORMAT_PAIR("%1%2/%3%4");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR("^([NS])([0-9]{2})([0-9]{2})[ /]"
-                                                        "([EW])([0-9]{3})([0-9]{2})$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR2("^([0-9]{2})([0-9]{2})([NS])[ /]"
-                                                         "([0-9]{3})([0-9]{2})([EW])$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR_LAT("^([NS])([0-9]{2})([0-9]{2})$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR_LON("^([EW])([0-9]{3})([0-9]{2})$");
-
-atools::geo::Pos degMinSecFormatFromCapture(const QStringList& captured);
-atools::geo::Pos degMinFormatFromCapture(const QStringList& captured);
+
+// ================================================================================
+// Scanner for fixed width waypoint formats
+
+namespace {
+
+enum WaypointFormat
+{
+  WP_DEG_MIN_SEC, /* 481200N0112842E */
+  WP_GFP, /* N48194W123096 */
+  WP_PAIR, /* N6400 W07000 or N6400/W07000 */
+  WP_DEG_MIN, /* 4510N06810W */
+  WP_DEG, /* 46N078W */
+  WP_ARINC, /* 5730N 5730E 5730W 5730S */
+  WP_ARINC2 /* 57N30 57E30 57W30 57S30 - longitude + 100 */
+};
+
+/* Pattern characters:
+ * H: latitude designator N or S, V: longitude designator E or W, X: any of N, S, E and W
+ * a, b, c: digit of latitude degree, minute and second
+ * x, y, z: digit of longitude degree, minute and second
+ * /: space or slash */
+struct WaypointPattern
+{
+  WaypointFormat format;
+  const char *pattern;
+  int length;
+};
+
+const static WaypointPattern WAYPOINT_PATTERNS[] =
+{
+  {WP_DEG_MIN_SEC, "aabbccHxxxyyzzV", 15},
+  {WP_GFP, "HaabbbVxxxyyy", 13},
+  {WP_PAIR, "Haabb/Vxxxyy", 12},
+  {WP_PAIR, "aabbH/xxxyyV", 12},
+  {WP_DEG_MIN, "aabbHxxxyyV", 11},
+  {WP_DEG, "aaHxxxV", 7},
+  {WP_ARINC, "aaxxX", 5},
+  {WP_ARINC2, "aaXxx", 5}
+};
+
+/* Numeric fields and designators collected by a scan */
+struct WaypointFields
+{
+  int latDeg = 0, latMin = 0, latSec = 0, lonDeg = 0, lonMin = 0, lonSec = 0;
+  char ns = '\0', ew = '\0', designator = '\0';
+};
+
+/* Checks all characters against the pattern and collects fields in one pass. str has to be upper case. */
+bool scanPattern(const QString& str, const WaypointPattern& pattern, WaypointFields& fields)
+{
+  if(str.size() != pattern.length)
+    return false;
+
+  fields = WaypointFields();
+  const QChar *data = str.constData();
+  for(int i = 0; i < pattern.length; i++)
+  {
+    ushort c = data[i].unicode();
+    char type = pattern.pattern[i];
+    int *field = nullptr;
+    switch(type)
+    {
+      case 'a':
+        field = &fields.latDeg;
+        break;
+      case 'b':
+        field = &fields.latMin;
+        break;
+      case 'c':
+        field = &fields.latSec;
+        break;
+      case 'x':
+        field = &fields.lonDeg;
+        break;
+      case 'y':
+        field = &fields.lonMin;
+        break;
+      case 'z':
+        field = &fields.lonSec;
+        break;
+
+      case 'H':
+        if(c != 'N' && c != 'S')
+          return false;
+        fields.ns = static_cast<char>(c);
+        break;
+
+      case 'V':
+        if(c != 'E' && c != 'W')
+          return false;
+        fields.ew = static_cast<char>(c);
+        break;
+
+      case 'X':
+        if(c != 'N' && c != 'S' && c != 'E' && c != 'W')
+          return false;
+        fields.designator = static_cast<char>(c);
+        break;
+
+      case '/':
+        if(c != ' ' && c != '/')
+          return false;
+        break;
+    }
+
+    if(field != nullptr)
+    {
+      if(c < '0' || c > '9')
+        return false;
+      *field = *field * 10 + (c - '0');
+    }
+  }
+  return true;
+}
+
+/* Apply ARINC designator to degrees which are both positive */
+Pos arincPos(int lonXDeg, int latYDeg, char designator)
+{
+  if(designator == 'N')
+    lonXDeg = -lonXDeg;
+  else if(designator == 'W')
+  {
+    lonXDeg = -lonXDeg;
+    latYDeg = -latYDeg;
+  }
+  else if(designator == 'S')
+    latYDeg = -latYDeg;
+
+  Pos pos(static_cast<float>(lonXDeg), static_cast<float>(latYDeg));
+  return pos.isValidRange() ? pos : atools::geo::EMPTY_POS;
+}
+
+/* Convert scanned fields to position. Returns EMPTY_POS if out of range. */
+Pos waypointPos(WaypointFormat format, const WaypointFields& f)
+{
+  if(format == WP_ARINC)
+    return arincPos(f.lonDeg, f.latDeg, f.designator);
+  else if(format == WP_ARINC2)
+    return arincPos(f.lonDeg + 100, f.latDeg, f.designator);
+
+  if(f.latDeg > 90 || f.lonDeg > 180)
+    return atools::geo::EMPTY_POS;
+
+  switch(format)
+  {
+    case WP_DEG_MIN_SEC:
+      return Pos(f.lonDeg, f.lonMin, static_cast<float>(f.lonSec), f.ew == 'W',
+                 f.latDeg, f.latMin, static_cast<float>(f.latSec), f.ns == 'S');
+
+    case WP_GFP:
+      {
+        // Minutes in tenths
+        float latYMin = f.latMin / 10.f;
+        float lonXMin = f.lonMin / 10.f;
+        return Pos(f.lonDeg, static_cast<int>(lonXMin), (lonXMin - std::floor(lonXMin)) * 60.f, f.ew == 'W',
+                   f.latDeg, static_cast<int>(latYMin), (latYMin - std::floor(latYMin)) * 60.f, f.ns == 'S');
+      }
+
+    case WP_PAIR:
+    case WP_DEG_MIN:
+      return Pos(f.lonDeg, f.lonMin, 0.f, f.ew == 'W', f.latDeg, f.latMin, 0.f, f.ns == 'S');
+
+    case WP_DEG:
+      return Pos(f.lonDeg, 0, 0.f, f.ew == 'W', f.latDeg, 0, 0.f, f.ns == 'S');
+
+    case WP_ARINC:
+    case WP_ARINC2:
+      break;
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+/* Try all patterns of the given format */
+Pos scanWaypoint(const QString& str, WaypointFormat format)
+{
+  QString upper = str.simplified().toUpper();
+  WaypointFields fields;
+  for(const WaypointPattern& pattern : WAYPOINT_PATTERNS)
+  {
+    if(pattern.format == format && scanPattern(upper, pattern, fields))
+      return waypointPos(format, fields);
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+// ================================================================================
+// Scanner for OpenAir coordinates
+
+/* Reads tokens from an upper case string. All read methods leave the position unchanged on failure. */
+class CoordScanner
+{
+public:
+  explicit CoordScanner(const QString& str)
+    : data(str.constData()), size(str.size())
+  {
+  }
+
+  void skipSpace()
+  {
+    while(index < size && data[index].isSpace())
+      index++;
+  }
+
+  bool readChar(char c)
+  {
+    if(index < size && data[index].unicode() == c)
+    {
+      index++;
+      return true;
+    }
+    return false;
+  }
+
+  /* One of the two given characters */
+  bool readDesignator(char c1, char c2, char& designator)
+  {
+    if(index < size && (data[index].unicode() == c1 || data[index].unicode() == c2))
+    {
+      designator = static_cast<char>(data[index++].unicode());
+      return true;
+    }
+    return false;
+  }
+
+  /* At least one digit */
+  bool readInt(int& value)
+  {
+    int start = index;
+    value = 0;
+    while(index < size && data[index].isDigit())
+      value = value * 10 + data[index++].digitValue();
+    return index > start;
+  }
+
+  /* Digits with an optional decimal point */
+  bool readDecimal(float& value)
+  {
+    int start = index, digits = 0, points = 0;
+    double number = 0., divisor = 1.;
+    while(index < size && (data[index].isDigit() || data[index].unicode() == '.'))
+    {
+      if(data[index].unicode() == '.')
+        points++;
+      else
+      {
+        number = number * 10. + data[index].digitValue();
+        digits++;
+        if(points > 0)
+          divisor *= 10.;
+      }
+      index++;
+    }
+
+    if(digits == 0 || points > 1)
+    {
+      index = start;
+      return false;
+    }
+    value = static_cast<float>(number / divisor);
+    return true;
+  }
+
+  void reset()
+  {
+    index = 0;
+  }
+
+private:
+  const QChar *data;
+  int size, index = 0;
+};
+
+/* Degree, minutes and seconds 50:40:42 N 003:13:30 E - allows trailing garbage */
+bool scanOpenAirMinSec(CoordScanner& scanner, Pos& pos)
+{
+  int latYDeg, latYMin, lonXDeg, lonXMin;
+  float latYSec, lonXSec;
+  char ns, ew;
+
+  if(!(scanner.readInt(latYDeg) && scanner.readChar(':') && scanner.readInt(latYMin) && scanner.readChar(':') &&
+       scanner.readDecimal(latYSec)))
+    return false;
+
+  scanner.skipSpace();
+  if(!scanner.readDesignator('N', 'S', ns))
+    return false;
+  scanner.skipSpace();
+
+  if(!(scanner.readInt(lonXDeg) && scanner.readChar(':') && scanner.readInt(lonXMin) && scanner.readChar(':') &&
+       scanner.readDecimal(lonXSec)))
+    return false;
+
+  scanner.skipSpace();
+  if(!scanner.readDesignator('E', 'W', ew))
+    return false;
+
+  if(latYDeg <= 90 && lonXDeg <= 180)
+    pos = Pos(lonXDeg, lonXMin, lonXSec, ew == 'W', latYDeg, latYMin, latYSec, ns == 'S');
+  else
+    pos = atools::geo::EMPTY_POS;
+  return true;
+}
+
+/* Degree and decimal minutes 39:06.2 N 121:35.5 E - allows trailing garbage */
+bool scanOpenAirMin(CoordScanner& scanner, Pos& pos)
+{
+  int latYDeg, lonXDeg;
+  float latYMin, lonXMin;
+  char ns, ew;
+
+  if(!(scanner.readInt(latYDeg) && scanner.readChar(':') && scanner.readDecimal(latYMin)))
+    return false;
+
+  scanner.skipSpace();
+  if(!scanner.readDesignator('N', 'S', ns))
+    return false;
+  scanner.skipSpace();
+
+  if(!(scanner.readInt(lonXDeg) && scanner.readChar(':') && scanner.readDecimal(lonXMin)))
+    return false;
+
+  scanner.skipSpace();
+  if(!scanner.readDesignator('E', 'W', ew))
+    return false;
+
+  if(latYDeg <= 90 && lonXDeg <= 180)
+    pos = Pos((lonXDeg + lonXMin / 60.f) * (ew == 'W' ? -1.f : 1.f),
+              (latYDeg + latYMin / 60.f) * (ns == 'S' ? -1.f : 1.f));
+  else
+    pos = atools::geo::EMPTY_POS;
+  return true;
+}
+
+} // namespace
 
 QString toGfpFormat(const atools::geo::Pos& pos)
 {
@@ -128,225 +422,40 @@ QString toDegMinSecFormat(const atools::geo::Pos& pos)
 // Garmin format N48194W123096
 atools::geo::Pos fromGfpFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_GFP.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
-  {
-    QStringList captured = match.capturedTexts();
-
-    if(captured.size() == 7)
-    {
-      bool latOk, lonOk, latMinOk, lonMinOk;
-      QString ns = captured.at(1);
-      int latYDeg = captured.at(2).toInt(&latOk);
-      float latYMin = captured.at(3).toFloat(&latMinOk) / 10.f;
-      float latYSec = (latYMin - std::floor(latYMin)) * 60.f;
-
-      QString ew = captured.at(4);
-      int lonXDeg = captured.at(5).toInt(&lonOk);
-      float lonXMin = captured.at(6).toFloat(&lonMinOk) / 10.f;
-      float lonXSec = (lonXMin - std::floor(lonXMin)) * 60.f;
-
-      if(latOk && lonOk && latMinOk && lonMinOk &&
-         -90 <= latYDeg && latYDeg <= 90 &&
-         -180 <= lonXDeg && lonXDeg <= 180)
-        return atools::geo::Pos(lonXDeg, static_cast<int>(lonXMin), lonXSec, ew == "W",
-                                latYDeg, static_cast<int>(latYMin), latYSec, ns == "S");
-    }
-  }
-  return atools::geo::EMPTY_POS;
+  return scanWaypoint(str, WP_GFP);
 }
 
 // Degrees only 46N078W
 atools::geo::Pos fromDegFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
-  {
-    QStringList captured = match.capturedTexts();
-
-    if(captured.size() == 5)
-    {
-      bool latOk, lonOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      QString ns = captured.at(2);
-
-      int lonXDeg = captured.at(3).toInt(&lonOk);
-      QString ew = captured.at(4);
-
-      if(latOk && lonOk &&
-         -90.f <= latYDeg && latYDeg <= 90.f &&
-         -180.f <= lonXDeg && lonXDeg <= 180.f)
-        return atools::geo::Pos(lonXDeg, 0, 0.f, ew == "W",
-                                latYDeg, 0, 0.f, ns == "S");
-    }
-  }
-  return atools::geo::EMPTY_POS;
+  return scanWaypoint(str, WP_DEG);
 }
 
 // Degrees and minutes 4510N06810W
 atools::geo::Pos fromDegMinFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
-  {
-    QStringList captured = match.capturedTexts();
-
-    if(captured.size() == 7)
-    {
-      bool latOk, lonOk, latMinOk, lonMinOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      int latYMin = captured.at(2).toInt(&latMinOk);
-      QString ns = captured.at(3);
-
-      int lonXDeg = captured.at(4).toInt(&lonOk);
-      int lonXMin = captured.at(5).toInt(&lonMinOk);
-      QString ew = captured.at(6);
-
-      if(latOk && lonOk && latMinOk && lonMinOk &&
-         -90 <= latYDeg && latYDeg <= 90 &&
-         -180 <= lonXDeg && lonXDeg <= 180)
-        return atools::geo::Pos(lonXDeg, lonXMin, 0.f, ew == "W",
-                                latYDeg, latYMin, 0.f, ns == "S");
-    }
-  }
-
-  return atools::geo::EMPTY_POS;
+  return scanWaypoint(str, WP_DEG_MIN);
 }
 
 // Degrees, minutes and seconds 481200N0112842E
 atools::geo::Pos fromDegMinSecFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN_SEC.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
-    return degMinSecFormatFromCapture(match.capturedTexts());
-
-  return atools::geo::EMPTY_POS;
+  return scanWaypoint(str, WP_DEG_MIN_SEC);
 }
 
 // Degrees and minutes in pair N6400 W07000 or N6400/W07000
 atools::geo::Pos fromDegMinPairFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_PAIR.match(str.simplified().toUpper());
-
-  bool latOk = false, lonOk = false, latMinOk = false, lonMinOk = false;
-  QString ns, ew;
-  int latYDeg = 0, latYMin = 0, lonXDeg = 0, lonXMin = 0;
-
-  if(match.hasMatch())
-  {
-    QStringList captured = match.capturedTexts();
-    if(captured.size() == 7)
-    {
-      ns = captured.at(1);
-      latYDeg = captured.at(2).toInt(&latOk);
-      latYMin = captured.at(3).toInt(&latMinOk);
-      ew = captured.at(4);
-      lonXDeg = captured.at(5).toInt(&lonOk);
-      lonXMin = captured.at(6).toInt(&lonMinOk);
-    }
-  }
-  else
-  {
-    QRegularExpressionMatch match2 = LONG_FORMAT_REGEXP_PAIR2.match(str.simplified().toUpper());
-
-    if(match2.hasMatch())
-    {
-      QStringList captured = match2.capturedTexts();
-      if(captured.size() == 7)
-      {
-        latYDeg = captured.at(1).toInt(&latOk);
-        latYMin = captured.at(2).toInt(&latMinOk);
-        ns = captured.at(3);
-        lonXDeg = captured.at(4).toInt(&lonOk);
-        lonXMin = captured.at(5).toInt(&lonMinOk);
-        ew = captured.at(6);
-      }
-    }
-  }
-
-  if(latOk && lonOk && latMinOk && lonMinOk &&
-     -90 <= latYDeg && latYDeg <= 90 &&
-     -180 <= lonXDeg && lonXDeg <= 180)
-    return atools::geo::Pos(lonXDeg, lonXMin, 0.f, ew == "W",
-                            latYDeg, latYMin, 0.f, ns == "S");
-  else
-    return atools::geo::EMPTY_POS;
+  return scanWaypoint(str, WP_PAIR);
 }
 
 // 57N30 5730N 5730E 57E30 57W30 5730W 5730S 57S30
 atools::geo::Pos fromArincFormat(const QString& str)
 {
-  // 5730N 5730E 5730W 5730S
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_ARINC.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
-  {
-    QStringList captured = match.capturedTexts();
-
-    if(captured.size() == 4)
-    {
-      bool latOk, lonOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      int lonXDeg = captured.at(2).toInt(&lonOk);
-
-      if(latOk && lonOk)
-      {
-        QChar designator = atools::charAt(captured.at(3), 0);
-        if(designator == 'N')
-          lonXDeg = -lonXDeg;
-        else if(designator == 'W')
-        {
-          lonXDeg = -lonXDeg;
-          latYDeg = -latYDeg;
-        }
-        else if(designator == 'S')
-          latYDeg = -latYDeg;
-
-        Pos pos(static_cast<float>(lonXDeg), static_cast<float>(latYDeg));
-        if(pos.isValidRange())
-          return pos;
-      }
-    }
-  }
-
-  // 57N30 57E30 57W30 57S30 longitude + 100
-  match = LONG_FORMAT_REGEXP_ARINC2.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
-  {
-    QStringList captured = match.capturedTexts();
-
-    if(captured.size() == 4)
-    {
-      bool latOk, lonOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      int lonXDeg = captured.at(3).toInt(&lonOk) + 100;
-
-      if(latOk && lonOk)
-      {
-        QChar designator = atools::charAt(captured.at(2), 0);
-        if(designator == 'N')
-          lonXDeg = -lonXDeg;
-        else if(designator == 'W')
-        {
-          lonXDeg = -lonXDeg;
-          latYDeg = -latYDeg;
-        }
-        else if(designator == 'S')
-          latYDeg = -latYDeg;
-
-        Pos pos(static_cast<float>(lonXDeg), static_cast<float>(latYDeg));
-        if(pos.isValidRange())
-          return pos;
-      }
-    }
-  }
-
-  return atools::geo::EMPTY_POS;
+  Pos pos = scanWaypoint(str, WP_ARINC);
+  if(!pos.isValid())
+    pos = scanWaypoint(str, WP_ARINC2);
+  return pos;
 }
 
 atools::geo::Pos fromAnyWaypointFormat(const QString& str)
@@ -373,65 +482,33 @@ atools::geo::Pos fromAnyWaypointFormat(const QString& str)
   return atools::geo::EMPTY_POS;
 }
 
-geo::Pos fromOpenAirFormat(const QString& coordStr)
+void fromAnyWaypointFormat(QVector<atools::geo::Pos>& positions, const QStringList& strings)
 {
-  QRegularExpressionMatch match = MATCH_COORD_OPENAIR_MIN_SEC.match(coordStr.toUpper());
-  if(match.hasMatch())
-    return degMinSecFormatFromCapture(match.capturedTexts());
-  else
-  {
-    match = MATCH_COORD_OPENAIR_MIN.match(coordStr);
-    if(match.hasMatch())
-      return degMinFormatFromCapture(match.capturedTexts());
-  }
-
-  return atools::geo::EMPTY_POS;
+  positions.resize(strings.size());
+  for(int i = 0; i < strings.size(); i++)
+    positions[i] = fromAnyWaypointFormat(strings.at(i));
 }
 
-atools::geo::Pos degMinFormatFromCapture(const QStringList& captured)
+geo::Pos fromOpenAirFormat(const QString& coordStr)
 {
-  if(captured.size() == 7)
-  {
-    bool latOk, lonOk, latMinOk, lonMinOk;
-    int latYDeg = captured.at(1).toInt(&latOk);
-    float latYMin = captured.at(2).toFloat(&latMinOk);
-    QString ns = captured.at(3);
-
-    int lonXDeg = captured.at(4).toInt(&lonOk);
-    float lonXMin = captured.at(5).toFloat(&lonMinOk);
-    QString ew = captured.at(6);
-
-    if(latOk && lonOk && latMinOk && lonMinOk &&
-       -90 <= latYDeg && latYDeg <= 90 &&
-       -180 <= lonXDeg && lonXDeg <= 180)
-      return atools::geo::Pos((lonXDeg + lonXMin / 60.f) * (ew == "W" ? -1.f : 1.f),
-                              (latYDeg + latYMin / 60.f) * (ns == "S" ? -1.f : 1.f));
-  }
+  QString upper = coordStr.toUpper();
+  CoordScanner scanner(upper);
+  Pos pos;
+  if(scanOpenAirMinSec(scanner, pos))
+    return pos;
+
+  scanner.reset();
+  if(scanOpenAirMin(scanner, pos))
+    return pos;
+
   return atools::geo::EMPTY_POS;
 }
 
-atools::geo::Pos degMinSecFormatFromCapture(const QStringList& captured)
+void fromOpenAirFormat(QVector<atools::geo::Pos>& positions, const QStringList& coordStrings)
 {
-  if(captured.size() == 9)
-  {
-    bool latOk, lonOk, latMinOk, lonMinOk, latSecOk, lonSecOk;
-    int latYDeg = captured.at(1).toInt(&latOk);
-    int latYMin = captured.at(2).toInt(&latMinOk);
-    float latYSec = captured.at(3).toFloat(&latSecOk);
-    QString ns = captured.at(4);
-
-    int lonXDeg = captured.at(5).toInt(&lonOk);
-    int lonXMin = captured.at(6).toInt(&lonMinOk);
-    float lonXSec = captured.at(7).toFloat(&lonSecOk);
-    QString ew = captured.at(8);
-
-    if(latOk && lonOk && latMinOk && lonMinOk && latSecOk && lonSecOk &&
-       -90 <= latYDeg && latYDeg <= 90 &&
-       -180 <= lonXDeg && lonXDeg <= 180)
-      return atools::geo::Pos(lonXDeg, lonXMin, lonXSec, ew == "W",
-                              latYDeg, latYMin, latYSec, ns == "S");
-  }
-  return atools::geo::EMPTY_POS;
+  positions.resize(coordStrings.size());
+  for(int i = 0; i < coordStrings.size(); i++)
+    positions[i] = fromOpenAirFormat(coordStrings.at(i));
 }
 
 QRegularExpressionMatch safeMatch(const QRegularExpression& regexp, const QString& str)
@@ -18,7 +18,8 @@
 #ifndef LITTLENAVMAP_COORDINATES_H
 #define LITTLENAVMAP_COORDINATES_H
 
-#include <QString>
+#include <QStringList>
+#include <QVector>
 
 namespace atools {
 namespace geo {
@@ -59,8 +60,13 @@ QString toDegMinFormat(const atools::geo::Pos& pos);
 /* Skyvector 481050N0113157E */
 QString toDegMinSecFormat(const atools::geo::Pos& pos);
 
+/* Fixed width waypoint formats below. Detected by length and parsed by a single pass scanner without
+ * regular expressions. */
 atools::geo::Pos fromAnyWaypointFormat(const QString& str);
 
+/* Parse many strings at once. positions contains one entry for each string. EMPTY_POS if not recognized. */
+void fromAnyWaypointFormat(QVector<atools::geo::Pos>& positions, const QStringList& strings);
+
 /* N44124W122451 or N14544W017479 or S31240E136502 */
 atools::geo::Pos fromGfpFormat(const QString& str);
 
@@ -84,6 +90,9 @@ atools::geo::Pos fromArincFormat(const QString& str);
 *  39:06.2 N 121:35.5 E */
 atools::geo::Pos fromOpenAirFormat(const QString& coordStr);
 
+/* Parse many OpenAir coordinates at once. positions contains one entry for each string. */
+void fromOpenAirFormat(QVector<atools::geo::Pos>& positions, const QStringList& coordStrings);
+
 } // namespace util
 } // namespace fs
 } // namespace atools
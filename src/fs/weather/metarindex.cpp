@@ -18,23 +18,41 @@
 #include "fs/weather/metarindex.h"
 
 #include "geo/spatialindex.h"
+#include "fs/weather/metar.h"
 #include "fs/weather/weathertypes.h"
 #include "atools.h"
+#include "util/str.h"
+#include "util/tracing.h"
 
 #include <QTimeZone>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QTextStream>
+
+#include <cstring>
+#include <limits>
 
 namespace atools {
 namespace fs {
 namespace weather {
 
-/* Internal struct for METAR data. Stored in the spatial index */
+/* Number of parsed METARs kept in the cache */
+static const int PARSED_CACHE_SIZE = 100;
+
+/* Buffers are compacted if they are larger than this and more than half of the text is not used anymore */
+static const qint64 COMPACT_MIN_BYTES = 1024 * 1024;
+
+static const qint64 INVALID_TIMESTAMP = std::numeric_limits<qint64>::min();
+
+/* Internal struct for METAR data. Stored in the spatial index.
+ * Text is only referenced by buffer index, offset and length. */
 struct MetarData
 {
-  MetarData(const QString& identParam, const QString& metarParam, QDateTime timestampParam, const atools::geo::Pos& posParam)
-    : ident(identParam), metar(metarParam), timestamp(timestampParam), pos(posParam)
+  MetarData(quint64 identParam, int bufferParam, int offsetParam, int lengthParam, qint64 timestampParam,
+            const atools::geo::Pos& posParam)
+    : ident(identParam), buffer(bufferParam), offset(offsetParam), length(lengthParam), timestamp(timestampParam),
+    pos(posParam)
   {
   }
 
@@ -42,12 +60,21 @@ struct MetarData
   {
   }
 
-  QString ident, metar;
-  QDateTime timestamp;
+  /* Packed ident. See MetarIndex::packIdent() */
+  quint64 ident = 0;
+
+  /* Index in MetarIndex::buffers, byte offset and size of METAR text */
+  int buffer = -1, offset = 0, length = 0;
+
+  /* Milliseconds since epoch UTC */
+  qint64 timestamp = INVALID_TIMESTAMP;
+
+  /* Number of the last read which contained this station. See MetarIndex::readCycle */
+  quint32 cycle = 0;
 
   bool isValid() const
   {
-    return !ident.isEmpty();
+    return ident != 0;
   }
 
   atools::geo::Pos pos;
@@ -59,21 +86,120 @@ struct MetarData
 
 };
 
-inline bool isDigit(QChar c)
+inline bool isDigit(char c)
 {
   return c >= '0' && c <= '9';
 }
 
-inline bool isLetterOrDigit(QChar c)
+inline bool isLetterOrDigit(char c)
 {
   return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z');
 }
 
+inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+/* Get next line from data starting at pos and trim it. Returns false if at end. */
+static bool nextLine(const QByteArray& data, int& pos, int& lineStart, int& lineLength)
+{
+  if(pos >= data.size())
+    return false;
+
+  int end = data.indexOf('\n', pos);
+  if(end == -1)
+    end = data.size();
+
+  lineStart = pos;
+  int lineEnd = end;
+  pos = end + 1;
+
+  const char *text = data.constData();
+  while(lineStart < lineEnd && isSpace(text[lineStart]))
+    lineStart++;
+  while(lineEnd > lineStart && isSpace(text[lineEnd - 1]))
+    lineEnd--;
+
+  lineLength = lineEnd - lineStart;
+  return true;
+}
+
+inline bool startsWith(const char *line, int length, const char *prefix)
+{
+  int prefixLen = static_cast<int>(std::strlen(prefix));
+  return length >= prefixLen && std::strncmp(line, prefix, static_cast<size_t>(prefixLen)) == 0;
+}
+
+/* Length of first word separated by space */
+inline int wordLength(const char *line, int length)
+{
+  const char *space = static_cast<const char *>(std::memchr(line, ' ', static_cast<size_t>(length)));
+  return space != nullptr ? static_cast<int>(space - line) : length;
+}
+
+/* Read two digit number. Sets ok to false on error. */
+inline int twoDigits(const char *text, bool& ok)
+{
+  ok = isDigit(text[0]) && isDigit(text[1]);
+  return ok ? (text[0] - '0') * 10 + (text[1] - '0') : 0;
+}
+
+/* true if text contains no whitespace other than single spaces between words */
+static bool isSimplified(const char *line, int length)
+{
+  for(int i = 0; i < length; i++)
+  {
+    char c = line[i];
+    if(isSpace(c) && (c != ' ' || i == 0 || i == length - 1 || line[i + 1] == ' '))
+      return false;
+  }
+  return true;
+}
+
+/* true if text is equal to the result of QString::simplified().toUpper() */
+static bool isSimplifiedUpper(const char *line, int length)
+{
+  for(int i = 0; i < length; i++)
+  {
+    char c = line[i];
+    if((c >= 'a' && c <= 'z') || static_cast<unsigned char>(c) > 127)
+      return false;
+  }
+  return isSimplified(line, length);
+}
+
+/* Parse date line like "2017/07/30 18:45". Returns milliseconds since epoch or INVALID_TIMESTAMP */
+static qint64 parseNoaaDate(const char *line, int length)
+{
+  if(length < 16 || line[13] != ':')
+    return INVALID_TIMESTAMP;
+
+  bool ok1, ok2, ok3, ok4, ok5, ok6;
+  int year = twoDigits(line, ok1) * 100 + twoDigits(line + 2, ok2);
+  int month = twoDigits(line + 5, ok3);
+  int day = twoDigits(line + 8, ok4);
+  int hour = twoDigits(line + 11, ok5);
+  int minute = twoDigits(line + 14, ok6);
+
+  if(!ok1 || !ok2 || !ok3 || !ok4 || !ok5 || !ok6)
+    return INVALID_TIMESTAMP;
+
+  QDateTime datetime(QDate(year, month, day), QTime(hour, minute), QTimeZone::utc());
+  return datetime.isValid() ? datetime.toMSecsSinceEpoch() : INVALID_TIMESTAMP;
+}
+
+static QDateTime toDateTime(qint64 timestamp)
+{
+  return timestamp == INVALID_TIMESTAMP ? QDateTime() : QDateTime::fromMSecsSinceEpoch(timestamp, QTimeZone::utc());
+}
+
 // ====================================================================================================
 MetarIndex::MetarIndex(MetarFormat formatParam, bool verboseLogging)
   : verbose(verboseLogging), format(formatParam)
 {
   spatialIndex = new atools::geo::SpatialIndex<MetarData>;
+  parsedCache.setMaxEntries(PARSED_CACHE_SIZE);
 }
 
 MetarIndex::~MetarIndex()
@@ -81,11 +207,57 @@ MetarIndex::~MetarIndex()
   delete spatialIndex;
 }
 
+quint64 MetarIndex::packIdent(const char *ident, int size)
+{
+  if(size <= 0 || size > 10)
+    return 0;
+
+  // Six bits for each character - digits 1-10 and letters 11-36
+  quint64 packed = 0;
+  for(int i = 0; i < size; i++)
+  {
+    char c = ident[i];
+    quint64 value;
+    if(c >= '0' && c <= '9')
+      value = static_cast<quint64>(c - '0' + 1);
+    else if(c >= 'A' && c <= 'Z')
+      value = static_cast<quint64>(c - 'A' + 11);
+    else if(c >= 'a' && c <= 'z')
+      value = static_cast<quint64>(c - 'a' + 11);
+    else
+      return 0;
+
+    packed = (packed << 6) | value;
+  }
+  return packed;
+}
+
+quint64 MetarIndex::packIdent(const QString& ident)
+{
+  QByteArray latin1 = ident.toLatin1();
+  return packIdent(latin1.constData(), latin1.size());
+}
+
 int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
 {
+  return read(stream.readAll().toUtf8(), fileOrUrl, merge);
+}
+
+int MetarIndex::read(const QByteArray& data, const QString& fileOrUrl, bool merge)
+{
+  ATOOLS_TRACE_SPAN("weather", "MetarIndex::read");
+
   Q_ASSERT(format != UNKNOWN);
   Q_ASSERT(fetchAirportCoords);
 
+  // Parsed entries might be outdated
+  parsedCache.clear();
+
+  // Stations not found in this read are removed later if not merging
+  readCycle++;
+  stationsChanged = false;
+
+  int found = 0;
   switch(format)
   {
     case atools::fs::weather::UNKNOWN:
@@ -93,15 +265,29 @@ int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
 
     case atools::fs::weather::NOAA:
     case atools::fs::weather::XPLANE:
-      return readNoaaXplane(stream, fileOrUrl, merge);
+      found = readNoaaXplane(data, fileOrUrl, merge);
+      break;
 
     case atools::fs::weather::FLAT:
-      return readFlat(stream, fileOrUrl, merge);
+      found = readFlat(data, fileOrUrl, merge);
+      break;
 
     case atools::fs::weather::JSON:
-      return readJson(stream, fileOrUrl, merge);
+      found = readJson(data, fileOrUrl, merge);
+      break;
   }
-  return 0;
+
+  if(!merge)
+    removeStale();
+
+  // Rebuild spatial index only if stations were added or removed. Otherwise only METAR texts changed.
+  updateIndex();
+  compactBuffers();
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "stations changed" << stationsChanged << "coordinate cache" << coordCache.size();
+
+  return found;
 }
 
 // 2017/07/30 18:45
@@ -112,57 +298,54 @@ int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
 //
 // 2017/07/30 18:47
 // KADS 301847Z 06005G14KT 13SM SKC 32/19 A3007
-int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::readNoaaXplane(const QByteArray& data, const QString& fileOrUrl, bool merge)
 {
-  if(!merge)
-  {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
+  // Keep the raw buffer - entries point into it
+  int bufferIndex = buffers.size();
+  buffers.append(data);
+  const char *text = data.constData();
 
-  QDateTime latest, oldest;
+  qint64 latest = INVALID_TIMESTAMP, oldest = INVALID_TIMESTAMP;
   QString latestIdent, oldestIdent;
 
   int lineNum = 1;
-  QString line;
-  QDateTime lastTimestamp, now = QDateTime::currentDateTimeUtc();
+  int pos = 0, lineStart = 0, lineLength = 0;
+  qint64 lastTimestamp = INVALID_TIMESTAMP, now = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
   int futureDates = 0, invalidDates = 0, found = 0;
 
-  while(!stream.atEnd())
+  while(nextLine(data, pos, lineStart, lineLength))
   {
-    line = stream.readLine().trimmed();
+    const char *line = text + lineStart;
 
-    if(line.isEmpty() || line.size() > 256)
+    if(lineLength == 0 || lineLength > 256)
     {
       lineNum++;
       continue;
     }
 
-    if(format == XPLANE && (line.startsWith("MDEG ") || line.startsWith("DEG ")))
+    if(format == XPLANE && (startsWith(line, lineLength, "MDEG ") || startsWith(line, lineLength, "DEG ")))
     {
       lineNum++;
       // Ignore X-Plane's special coordinate format
       continue;
     }
 
-    if(line.size() >= 4)
+    if(lineLength >= 4)
     {
-      // static const QRegularExpression DATE_REGEXP("^[\\d]{4}/[\\d]{2}/[\\d]{2}");
-      if(line.size() > 10 &&
+      if(lineLength > 10 &&
          // 2017/07/30 18:55 - detect only date part
-         isDigit(line.at(0)) && isDigit(line.at(1)) && isDigit(line.at(2)) && isDigit(line.at(3)) &&
-         line.at(4) == '/' && isDigit(line.at(5)) && isDigit(line.at(6)) &&
-         line.at(7) == '/' && isDigit(line.at(8)) && isDigit(line.at(9)) &&
-         line.at(10) == ' ')
+         isDigit(line[0]) && isDigit(line[1]) && isDigit(line[2]) && isDigit(line[3]) &&
+         line[4] == '/' && isDigit(line[5]) && isDigit(line[6]) &&
+         line[7] == '/' && isDigit(line[8]) && isDigit(line[9]) &&
+         line[10] == ' ')
       {
         // Found line containing date like "2017/10/29 11:45"
-        lastTimestamp = QDateTime::fromString(line, "yyyy/MM/dd hh:mm");
-        lastTimestamp.setTimeZone(QTimeZone::utc()); // Does not change date and time numbers
+        lastTimestamp = parseNoaaDate(line, lineLength);
         lineNum++;
         continue;
       }
 
-      if(!lastTimestamp.isValid())
+      if(lastTimestamp == INVALID_TIMESTAMP)
       {
         // Ignore invalid dates
         invalidDates++;
@@ -178,47 +361,46 @@ int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bo
         continue;
       }
 
-      QString ident = line.section(' ', 0, 0);
+      int identLength = wordLength(line, lineLength);
+      quint64 ident = packIdent(line, identLength);
+
       // Recognize METAR airport ident
-      // static const QRegularExpression IDENT_REGEXP("^[A-Z0-9]{2,5}$");
-      if(ident.size() >= 3 &&
+      if(ident != 0 && identLength >= 3 &&
          // KPRO 301855Z AUTO 11003KT 10SM CLR 26/14 A3022 RMK AO2 T02570135
-         isLetterOrDigit(line.at(0)) && isLetterOrDigit(line.at(1)) && isLetterOrDigit(line.at(2)))
+         isLetterOrDigit(line[0]) && isLetterOrDigit(line[1]) && isLetterOrDigit(line[2]))
       {
         // Found METAR line
         if(verbose)
         {
-          if(!latest.isValid() || lastTimestamp > latest)
+          if(latest == INVALID_TIMESTAMP || lastTimestamp > latest)
           {
             latest = lastTimestamp;
-            latestIdent = ident;
+            latestIdent = QString::fromLatin1(line, identLength);
           }
-          if(!oldest.isValid() || lastTimestamp < oldest)
+          if(oldest == INVALID_TIMESTAMP || lastTimestamp < oldest)
           {
             oldest = lastTimestamp;
-            oldestIdent = ident;
+            oldestIdent = QString::fromLatin1(line, identLength);
           }
         }
 
         found++;
-        updateOrInsert(line, ident, lastTimestamp);
+        updateOrInsert(ident, line, identLength, bufferIndex, lineStart, lineLength, lastTimestamp, merge);
       }
       else
         qWarning() << "Ident in METAR does not match in file/URL"
-                   << fileOrUrl << "line num" << lineNum << "line" << line;
+                   << fileOrUrl << "line num" << lineNum << "line" << QString::fromUtf8(line, lineLength);
     }
     lineNum++;
   }
 
-  updateIndex();
-
   if(verbose)
   {
     qDebug() << "index->size()" << spatialIndex->size();
     qDebug() << "metarMap.size()" << identIndexMap.size();
     qDebug() << "found " << found << "futureDates " << futureDates << "invalidDates" << invalidDates;
-    qDebug() << "Latest" << latestIdent << latest;
-    qDebug() << "Oldest" << oldestIdent << oldest;
+    qDebug() << "Latest" << latestIdent << toDateTime(latest);
+    qDebug() << "Oldest" << oldestIdent << toDateTime(oldest);
   }
 
   qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
@@ -232,55 +414,85 @@ int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bo
 // AGGH 100900Z 16003KT 9999 FEW016 FEW017CB SCT300 27/25 Q1010
 // ANYN 100900Z 08005KT 9999 FEW020 27/23 Q1010
 // AYMH 100800Z 16015KT 9999 SHRA BKN090 18/16 Q1018 RMK
-int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::readFlat(const QByteArray& data, const QString& fileOrUrl, bool merge)
 {
-  if(!merge)
-  {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
-
-  QDateTime latest, oldest;
+  // Keep the raw buffer - entries point into it
+  // Lines which need normalization are copied into a second buffer
+  int bufferIndex = buffers.size(), normalizedIndex = buffers.size() + 1;
+  buffers.append(data);
+  QByteArray normalized;
+  const char *text = data.constData();
+
+  qint64 latest = INVALID_TIMESTAMP, oldest = INVALID_TIMESTAMP;
   QString latestIdent, oldestIdent;
 
   int lineNum = 1;
-  QString line;
-  const QDateTime now = QDateTime::currentDateTimeUtc();
+  int pos = 0, lineStart = 0, lineLength = 0;
+  const qint64 now = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
   int futureDates = 0, invalidDates = 0, found = 0;
 
-  while(!stream.atEnd())
+  while(nextLine(data, pos, lineStart, lineLength))
   {
-    line = stream.readLine().simplified().toUpper();
+    const char *line = text + lineStart;
+    int lineBuffer = bufferIndex, lineOffset = lineStart;
+
+    if(!isSimplifiedUpper(line, lineLength))
+    {
+      QByteArray lineNormalized;
+      if(atools::util::scan::isAscii(line, line + lineLength) && isSimplified(line, lineLength))
+      {
+        // Only lower case letters - convert bytes directly
+        lineNormalized = QByteArray(line, lineLength);
+        atools::util::scan::toUpperAscii(lineNormalized.data(), lineNormalized.data() + lineLength);
+      }
+      else
+        // Same as simplified().toUpper() for QString
+        lineNormalized = QString::fromUtf8(line, lineLength).simplified().toUpper().toUtf8();
+      lineBuffer = normalizedIndex;
+      lineOffset = normalized.size();
+      lineLength = lineNormalized.size();
+      normalized.append(lineNormalized);
+      line = normalized.constData() + lineOffset;
+    }
 
-    if(line.isEmpty() || line.size() > 256)
+    if(lineLength == 0 || lineLength > 256)
     {
       lineNum++;
       continue;
     }
 
-    if(line.size() >= 4)
+    if(lineLength >= 4)
     {
-      QString ident = line.section(' ', 0, 0).simplified().toUpper();
-      QString dateStr = line.section(' ', 1, 1).simplified().toUpper();
+      int identLength = wordLength(line, lineLength);
+      const char *dateStr = line + std::min(identLength + 1, lineLength);
+      int dateLength = wordLength(dateStr, lineLength - static_cast<int>(dateStr - line));
+      quint64 ident = packIdent(line, identLength);
 
-      if(ident.size() >= 3 && ident.size() <= 4 && dateStr.size() >= 5)
+      if(ident != 0 && identLength >= 3 && identLength <= 4 && dateLength >= 5)
       {
-        if(dateStr.endsWith('Z'))
-          dateStr.chop(1);
+        if(dateStr[dateLength - 1] == 'Z')
+          dateLength--;
 
-        if(dateStr.size() == 5)
-          dateStr.prepend('0');
+        // Day might be given with only one digit
+        char dateBuf[6] = {'0', '0', '0', '0', '0', '0'};
+        if(dateLength == 5)
+        {
+          dateBuf[0] = '0';
+          std::memcpy(dateBuf + 1, dateStr, 5);
+        }
+        else
+          std::memcpy(dateBuf, dateStr, static_cast<size_t>(std::min(dateLength, 6)));
 
         bool ok;
-        int day = dateStr.mid(0, 2).toInt(&ok);
+        int day = twoDigits(dateBuf, ok);
         if((!ok || day < 1 || day > 31) && verbose)
-          qWarning() << Q_FUNC_INFO << "Cannot read day in METAR" << line;
-        int hour = dateStr.mid(2, 2).toInt(&ok);
+          qWarning() << Q_FUNC_INFO << "Cannot read day in METAR" << QString::fromUtf8(line, lineLength);
+        int hour = twoDigits(dateBuf + 2, ok);
         if((!ok || hour < 0 || hour > 23) && verbose)
-          qWarning() << Q_FUNC_INFO << "Cannot read hour in METAR" << line;
-        int minute = dateStr.mid(4, 2).toInt(&ok);
+          qWarning() << Q_FUNC_INFO << "Cannot read hour in METAR" << QString::fromUtf8(line, lineLength);
+        int minute = twoDigits(dateBuf + 4, ok);
         if((!ok || minute < 0 || minute > 60) && verbose)
-          qWarning() << Q_FUNC_INFO << "Cannot read minute in METAR" << line;
+          qWarning() << Q_FUNC_INFO << "Cannot read minute in METAR" << QString::fromUtf8(line, lineLength);
 
         QDateTime metarDateTime = atools::correctDate(day, hour, minute);
 
@@ -292,7 +504,8 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
           continue;
         }
 
-        if(metarDateTime > now)
+        qint64 metarTimestamp = metarDateTime.toMSecsSinceEpoch();
+        if(metarTimestamp > now)
         {
           // Ignore METARs with future UTC time
           futureDates++;
@@ -303,36 +516,38 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
         // Found METAR line
         if(verbose)
         {
-          if(!latest.isValid() || metarDateTime > latest)
+          if(latest == INVALID_TIMESTAMP || metarTimestamp > latest)
           {
-            latest = metarDateTime;
-            latestIdent = ident;
+            latest = metarTimestamp;
+            latestIdent = QString::fromLatin1(line, identLength);
           }
-          if(!oldest.isValid() || metarDateTime < oldest)
+          if(oldest == INVALID_TIMESTAMP || metarTimestamp < oldest)
           {
-            oldest = metarDateTime;
-            oldestIdent = ident;
+            oldest = metarTimestamp;
+            oldestIdent = QString::fromLatin1(line, identLength);
           }
         }
 
         found++;
-        updateOrInsert(line, ident, metarDateTime);
+        updateOrInsert(ident, line, identLength, lineBuffer, lineOffset, lineLength, metarTimestamp, merge);
       }
       else if(verbose)
-        qWarning() << "Invalid METAR in file/URL" << fileOrUrl << "line num" << lineNum << "line" << line;
+        qWarning() << "Invalid METAR in file/URL" << fileOrUrl << "line num" << lineNum
+                   << "line" << QString::fromUtf8(line, lineLength);
     }
     lineNum++;
   }
 
-  updateIndex();
+  buffers.append(normalized);
 
   if(verbose)
   {
     qDebug() << "index->size()" << spatialIndex->size();
     qDebug() << "metarMap.size()" << identIndexMap.size();
+    qDebug() << "normalized bytes" << normalized.size();
     qDebug() << "found " << found << "futureDates " << futureDates << "invalidDates" << invalidDates;
-    qDebug() << "Latest" << latestIdent << latest;
-    qDebug() << "Oldest" << oldestIdent << oldest;
+    qDebug() << "Latest" << latestIdent << toDateTime(latest);
+    qDebug() << "Oldest" << oldestIdent << toDateTime(oldest);
   }
 
   qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
@@ -355,26 +570,25 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
 // .    "metar": "AYMH 090800Z VRB04KT 9999 -SHRA SCT008 BKN030 -/- Q1019",
 // .    "updatedAt": "2022-03-09T08:00:00.000Z"
 // .  },
-int MetarIndex::readJson(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::readJson(const QByteArray& data, const QString& fileOrUrl, bool merge)
 {
-  if(!merge)
-  {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
+  // JSON strings might be escaped - collect decoded METARs in a new buffer
+  int bufferIndex = buffers.size();
+  buffers.append(QByteArray());
+  QByteArray text;
 
-  QDateTime latest, oldest;
+  qint64 latest = INVALID_TIMESTAMP, oldest = INVALID_TIMESTAMP;
   QString latestIdent, oldestIdent;
 
-  const QDateTime now = QDateTime::currentDateTimeUtc();
+  const qint64 now = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
   int futureDates = 0, invalidDates = 0, found = 0;
 
-  QJsonDocument doc = QJsonDocument::fromJson(stream.readAll().toUtf8());
+  QJsonDocument doc = QJsonDocument::fromJson(data);
   for(QJsonValue airportValue : doc.array())
   {
     QJsonObject airportObj = airportValue.toObject();
-    QString ident = airportObj.value("airportIcao").toString();
-    QString metar = airportObj.value("metar").toString();
+    QByteArray ident = airportObj.value("airportIcao").toString().toLatin1();
+    QByteArray metar = airportObj.value("metar").toString().toUtf8();
     QDateTime metarDateTime = QDateTime::fromString(airportObj.value("updatedAt").toString(), Qt::ISODateWithMs);
 
     if(!metarDateTime.isValid())
@@ -384,74 +598,222 @@ int MetarIndex::readJson(QTextStream& stream, const QString& fileOrUrl, bool mer
       continue;
     }
 
-    if(metarDateTime > now)
+    qint64 metarTimestamp = metarDateTime.toMSecsSinceEpoch();
+    if(metarTimestamp > now)
     {
       // Ignore METARs with future UTC time
       futureDates++;
       continue;
     }
 
+    quint64 packedIdent = packIdent(ident.constData(), ident.size());
+    if(packedIdent == 0)
+    {
+      if(verbose)
+        qWarning() << Q_FUNC_INFO << "Invalid ident in METAR" << ident << "in" << fileOrUrl;
+      continue;
+    }
+
     // Found METAR line
     if(verbose)
     {
-      if(!latest.isValid() || metarDateTime > latest)
+      if(latest == INVALID_TIMESTAMP || metarTimestamp > latest)
       {
-        latest = metarDateTime;
-        latestIdent = ident;
+        latest = metarTimestamp;
+        latestIdent = QString::fromLatin1(ident);
       }
-      if(!oldest.isValid() || metarDateTime < oldest)
+      if(oldest == INVALID_TIMESTAMP || metarTimestamp < oldest)
       {
-        oldest = metarDateTime;
-        oldestIdent = ident;
+        oldest = metarTimestamp;
+        oldestIdent = QString::fromLatin1(ident);
       }
     }
 
     found++;
-    updateOrInsert(metar, ident, metarDateTime);
+    updateOrInsert(packedIdent, ident.constData(), ident.size(), bufferIndex, text.size(), metar.size(),
+                   metarTimestamp, merge);
+    text.append(metar);
   }
 
-  updateIndex();
+  buffers[bufferIndex] = text;
 
   if(verbose)
   {
     qDebug() << "index->size()" << spatialIndex->size();
     qDebug() << "metarMap.size()" << identIndexMap.size();
     qDebug() << "found " << found << "futureDates " << futureDates << "invalidDates" << invalidDates;
-    qDebug() << "Latest" << latestIdent << latest;
-    qDebug() << "Oldest" << oldestIdent << oldest;
+    qDebug() << "Latest" << latestIdent << toDateTime(latest);
+    qDebug() << "Oldest" << oldestIdent << toDateTime(oldest);
   }
 
   qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
   return found;
 }
 
-void MetarIndex::updateOrInsert(const QString& metar, const QString& ident, const QDateTime& lastTimestamp)
+void MetarIndex::updateOrInsert(quint64 ident, const char *identStr, int identSize, int buffer, int offset,
+                                int length, qint64 timestamp, bool merge)
 {
   int idx = identIndexMap.value(ident, -1);
   if(idx != -1)
   {
     // Already in list - get writeable reference to entry
     MetarData& md = (*spatialIndex)[idx];
-    if(!md.timestamp.isValid() || md.timestamp < lastTimestamp)
+
+    // Replace entries from previous reads unconditionally if not merging
+    if((!merge && md.cycle != readCycle) || md.timestamp == INVALID_TIMESTAMP || md.timestamp < timestamp)
     {
-      // This one is newer - update
-      md.metar = metar;
-      md.timestamp = lastTimestamp;
+      // This one is newer - update in place. Position and index do not change.
+      md.buffer = buffer;
+      md.offset = offset;
+      md.length = length;
+      md.timestamp = timestamp;
     }
     // else leave as is
+    md.cycle = readCycle;
   }
   else
   {
     // Insert new record
-    spatialIndex->append(MetarData(ident, metar, lastTimestamp, fetchAirportCoords(ident)));
+    MetarData md(ident, buffer, offset, length, timestamp, airportCoords(ident, identStr, identSize));
+    md.cycle = readCycle;
+    spatialIndex->append(md);
     identIndexMap.insert(ident, spatialIndex->size() - 1);
+    stationsChanged = true;
+  }
+}
+
+atools::geo::Pos MetarIndex::airportCoords(quint64 ident, const char *identStr, int identSize)
+{
+  // Lookups are cached across download cycles - also invalid positions for unknown airports
+  auto it = coordCache.constFind(ident);
+  if(it != coordCache.constEnd())
+    return it.value();
+
+  atools::geo::Pos pos = fetchAirportCoords(QString::fromLatin1(identStr, identSize));
+  coordCache.insert(ident, pos);
+  return pos;
+}
+
+void MetarIndex::removeStale()
+{
+  // Move entries found in the last read to the front
+  int numKept = 0;
+  for(int i = 0; i < spatialIndex->size(); i++)
+  {
+    if(spatialIndex->at(i).cycle == readCycle)
+    {
+      if(numKept != i)
+        (*spatialIndex)[numKept] = spatialIndex->at(i);
+      numKept++;
+    }
+  }
+
+  if(numKept < spatialIndex->size())
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "removed" << spatialIndex->size() - numKept;
+
+    spatialIndex->resize(numKept);
+
+    identIndexMap.clear();
+    for(int i = 0; i < spatialIndex->size(); i++)
+      identIndexMap.insert(spatialIndex->at(i).ident, i);
+    stationsChanged = true;
+  }
+}
+
+void MetarIndex::setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value)
+{
+  fetchAirportCoords = value;
+
+  clearCoordinateCache();
+}
+
+void MetarIndex::clearCoordinateCache()
+{
+  coordCache.clear();
+
+  if(!spatialIndex->isEmpty())
+  {
+    // Update positions of all stations from the new source
+    for(int i = 0; i < spatialIndex->size(); i++)
+    {
+      MetarData& md = (*spatialIndex)[i];
+      QByteArray ident = unpackIdent(md.ident).toLatin1();
+      md.pos = airportCoords(md.ident, ident.constData(), ident.size());
+    }
+    stationsChanged = true;
+    updateIndex();
+  }
+}
+
+void MetarIndex::compactBuffers()
+{
+  // Sum up bytes still referenced in each buffer
+  QVector<qint64> usedBytes(buffers.size(), 0);
+  qint64 totalUsed = 0;
+  for(const MetarData& md : qAsConst(*spatialIndex))
+  {
+    usedBytes[md.buffer] += md.length;
+    totalUsed += md.length;
+  }
+
+  // Release buffers which were fully replaced by newer reports
+  qint64 totalSize = 0;
+  for(int i = 0; i < buffers.size(); i++)
+  {
+    if(usedBytes.at(i) == 0)
+      buffers[i] = QByteArray();
+    totalSize += buffers.at(i).size();
+  }
+
+  if(totalSize > COMPACT_MIN_BYTES && totalSize > totalUsed * 2)
+  {
+    // Copy all referenced text into one new buffer
+    QByteArray compacted;
+    compacted.reserve(static_cast<int>(totalUsed));
+    for(int i = 0; i < spatialIndex->size(); i++)
+    {
+      MetarData& md = (*spatialIndex)[i];
+      int offset = compacted.size();
+      compacted.append(buffers.at(md.buffer).constData() + md.offset, md.length);
+      md.buffer = 0;
+      md.offset = offset;
+    }
+
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "compacted" << totalSize << "to" << compacted.size() << "bytes";
+
+    buffers.clear();
+    buffers.append(compacted);
   }
 }
 
+void MetarIndex::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  using atools::util::MemoryAccounting;
+
+  for(const QByteArray& buffer : buffers)
+    bytes += MemoryAccounting::byteArrayBytes(buffer);
+
+  bytes += MemoryAccounting::vectorBytes(buffers) + MemoryAccounting::hashBytes(identIndexMap) +
+           MemoryAccounting::hashBytes(coordCache) + spatialIndex->getMemoryBytes() +
+           static_cast<qint64>(parsedCache.size()) * static_cast<qint64>(sizeof(Metar));
+  elements += spatialIndex->size();
+}
+
+void MetarIndex::releaseMemory(qint64)
+{
+  parsedCache.clear();
+  compactBuffers();
+}
+
 void MetarIndex::clear()
 {
   spatialIndex->clear();
   identIndexMap.clear();
+  buffers.clear();
+  parsedCache.clear();
 }
 
 bool MetarIndex::isEmpty() const
@@ -470,7 +832,7 @@ atools::fs::weather::MetarResult MetarIndex::getMetar(const QString& station, co
   result.init(station, pos);
 
   if(!station.isEmpty())
-    result.metarForStation = metarData(station).metar;
+    result.metarForStation = metarText(metarData(station));
 
   if(result.metarForStation.isEmpty() && pos.isValid())
   {
@@ -478,22 +840,21 @@ atools::fs::weather::MetarResult MetarIndex::getMetar(const QString& station, co
 
     if(data.isValid())
     {
+      QString dataIdent = unpackIdent(data.ident);
+
       // Found a METAR
-      if(data.ident == station)
+      if(!station.isEmpty() && data.ident == packIdent(station))
       {
         // Found exact match
-        result.metarForStation = data.metar;
-
-        if(station.isEmpty())
-          result.requestIdent = data.ident;
+        result.metarForStation = metarText(data);
       }
       else
       {
         // Found a station nearby
-        result.metarForNearest = data.metar;
+        result.metarForNearest = metarText(data);
 
         if(station.isEmpty())
-          result.requestIdent = data.ident;
+          result.requestIdent = dataIdent;
       }
     }
   }
@@ -501,15 +862,38 @@ atools::fs::weather::MetarResult MetarIndex::getMetar(const QString& station, co
   return result;
 }
 
+atools::fs::weather::Metar MetarIndex::getParsedMetar(const QString& station)
+{
+  quint64 ident = packIdent(station);
+
+  const Metar *cached = parsedCache.value(ident);
+  if(cached != nullptr)
+    return *cached;
+
+  MetarData data = metarData(station);
+  if(!data.isValid())
+    return Metar();
+
+  // Parse and remember result
+  Metar metar(metarText(data), station, toDateTime(data.timestamp));
+  parsedCache.insert(ident, metar);
+  return metar;
+}
+
 void MetarIndex::updateIndex()
 {
   Q_ASSERT(spatialIndex->size() == identIndexMap.size());
-  spatialIndex->updateIndex();
+
+  if(stationsChanged)
+  {
+    spatialIndex->updateIndex();
+    stationsChanged = false;
+  }
 }
 
 MetarData MetarIndex::metarData(const QString& ident)
 {
-  int idx = identIndexMap.value(ident, -1);
+  int idx = identIndexMap.value(packIdent(ident), -1);
 
   if(idx != -1)
     return spatialIndex->at(idx);
@@ -517,6 +901,26 @@ MetarData MetarIndex::metarData(const QString& ident)
   return MetarData();
 }
 
+QString MetarIndex::metarText(const MetarData& data) const
+{
+  if(data.isValid() && data.buffer >= 0 && data.buffer < buffers.size())
+    return QString::fromUtf8(buffers.at(data.buffer).constData() + data.offset, data.length);
+  else
+    return QString();
+}
+
+QString MetarIndex::unpackIdent(quint64 ident)
+{
+  QString str;
+  while(ident != 0)
+  {
+    int value = static_cast<int>(ident & 0x3f);
+    str.prepend(value <= 10 ? QChar('0' + value - 1) : QChar('A' + value - 11));
+    ident >>= 6;
+  }
+  return str;
+}
+
 } // namespace weather
 } // namespace fs
 } // namespace atools
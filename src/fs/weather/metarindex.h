@@ -19,6 +19,9 @@
 #define ATOOLS_METARINDEX_H
 
 #include "fs/weather/weathertypes.h"
+#include "util/memoryaccounting.h"
+#include "util/timedcache.h"
+
 
 class QTextStream;
 
@@ -33,6 +36,7 @@ namespace weather {
 
 struct MetarResult;
 struct MetarData;
+class Metar;
 
 /*
  * Reads, caches and indexes (by position) METAR reports in NOAA style as also used by X-Plane.
@@ -53,8 +57,16 @@ struct MetarData;
  *
  * KC99 100906Z AUTO 30022G42KT 10SM CLR M01/M04 A3035 RMK AO2
  * LCEN 100920Z 16004KT 090V230 CAVOK 31/10 Q1010 NOSIG
+ *
+ * The raw downloaded buffers are kept and entries only hold offset and length into them. Station idents are packed
+ * into integers. Strings are created on request and METARs are only parsed in getParsedMetar() which uses a
+ * small LRU cache. Buffers are compacted if most of their text was replaced by newer reports.
+ *
+ * Reads update existing stations in place. A read without merge removes stations which are not contained anymore.
+ * The spatial index is only rebuilt if stations were added or removed. Airport coordinates are cached.
  */
-class MetarIndex
+class MetarIndex :
+  public atools::util::MemoryAccountable
 {
 public:
   MetarIndex(atools::fs::weather::MetarFormat formatParam, bool verboseLogging = false);
@@ -68,6 +80,9 @@ public:
    * Returns number of METARs read. */
   int read(QTextStream& stream, const QString& fileName, bool merge);
 
+  /* As above but reads from raw bytes in UTF-8 or Latin-1 encoding. The buffer is kept without copying. */
+  int read(const QByteArray& data, const QString& fileName, bool merge);
+
   /* Clears all lists */
   void clear();
 
@@ -81,38 +96,86 @@ public:
    * Also keeps position and ident of original request.*/
   atools::fs::weather::MetarResult getMetar(const QString& station, const atools::geo::Pos& pos);
 
-  /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest. */
-  void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value)
-  {
-    fetchAirportCoords = value;
-  }
+  /* Get parsed METAR for station. Parses only on first request and keeps the last results in a cache.
+   * Returns an invalid METAR if station is not found. */
+  atools::fs::weather::Metar getParsedMetar(const QString& station);
+
+  /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest.
+   * Clears the coordinate cache. */
+  void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value);
+
+  /* Results of fetchAirportCoords are cached across reads. Call this if the airport database changed.
+   * Positions of all stations are fetched again and the spatial index is rebuilt. */
+  void clearCoordinateCache();
+
+  /* Pack an ident with up to ten characters A-Z and 0-9 into an integer. Returns 0 if not possible. */
+  static quint64 packIdent(const char *ident, int size);
+  static quint64 packIdent(const QString& ident);
+
+  /* Get ident back from packed value */
+  static QString unpackIdent(quint64 ident);
+
+  /* Raw buffers, index and caches. Elements are stations. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
+  /* Clears parsed METAR cache and compacts buffers */
+  virtual void releaseMemory(qint64 maxBytes) override;
 
 private:
-  /* Get a METAR string. Empty if not available */
+  /* Get METAR data for ident. Invalid if not available */
   MetarData metarData(const QString& ident);
 
+  /* Create METAR string from the raw buffers */
+  QString metarText(const MetarData& data) const;
+
   /* Read NOAA or XPLANE format */
-  int readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  int readNoaaXplane(const QByteArray& data, const QString& fileOrUrl, bool merge);
 
   /* Read flat file format like VATSIM */
-  int readFlat(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  int readFlat(const QByteArray& data, const QString& fileOrUrl, bool merge);
 
   /* Read JSON file format from IVAO */
-  int readJson(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  int readJson(const QByteArray& data, const QString& fileOrUrl, bool merge);
+
+  /* Copy text still in use into a new buffer if the buffers contain mostly replaced reports */
+  void compactBuffers();
 
-  /* Copy airports from the complete list to the index with coordinates.
-   * Copies only airports that exist in the current simulator database, i.e. where fetchAirportCoords returns
-   * a valid coordinate. */
+  /* Rebuild the spatial index if stations were added or removed.
+   * Airports which do not exist in the current simulator database, i.e. where fetchAirportCoords returns
+   * an invalid coordinate, are not considered by the index. */
   void updateIndex();
 
-  /* Update or insert a METAR entry */
-  void updateOrInsert(const QString& metar, const QString& ident, const QDateTime& lastTimestamp);
+  /* Update or insert a METAR entry. Text is given by offset and length into the buffer at index buffer.
+   * Entries from previous reads are always replaced if merge is false. */
+  void updateOrInsert(quint64 ident, const char *identStr, int identSize, int buffer, int offset, int length,
+                      qint64 timestamp, bool merge);
+
+  /* Get cached coordinates or call fetchAirportCoords */
+  atools::geo::Pos airportCoords(quint64 ident, const char *identStr, int identSize);
+
+  /* Remove stations not found in last read */
+  void removeStale();
 
   /* Callback to get airport coodinates by ICAO ident */
   std::function<atools::geo::Pos(const QString&)> fetchAirportCoords;
 
-  /* Map containing all found METARs airport idents mapped to the position in the spatial index */
-  QHash<QString, int> identIndexMap;
+  /* Map containing all found METARs packed airport idents mapped to the position in the spatial index */
+  QHash<quint64, int> identIndexMap;
+
+  /* Raw downloaded or read data referenced by the entries. Might contain empty, released buffers. */
+  QVector<QByteArray> buffers;
+
+  /* Packed ident to result of fetchAirportCoords. Kept across reads. */
+  QHash<quint64, atools::geo::Pos> coordCache;
+
+  /* Incremented for each read */
+  quint32 readCycle = 0;
+
+  /* Stations were added or removed and the spatial index needs an update */
+  bool stationsChanged = false;
+
+  /* Packed ident to parsed METAR. Cleared on each read. */
+  atools::util::TimedCache<quint64, atools::fs::weather::Metar> parsedCache;
 
   /* Index containing all stations. Stations without valid position will be located at x/y/z = 0/0/0 and therfore
    * not considered in the index. */
@@ -43,6 +43,7 @@
 #include <string>
 #include <time.h>
 #include <cstring>
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <QDateTime>
@@ -119,11 +120,107 @@ namespace atools {
 namespace fs {
 namespace weather {
 
-static QVector<Token> description;
-static QVector<Token> phenomenon;
-static QVector<Token> special;
-static QVector<Token> colors;
-static QVector<Token> cloud_types;
+/*
+ * Keyword table for MetarParser::scanToken(). Tokens are hashed by their first two letters which
+ * gives a bucket index without collisions between different prefixes. Each bucket is sorted by descending
+ * token length to find the longest match first. Matching works on the raw characters without allocations.
+ */
+class TokenTable
+{
+public:
+  void set(const QVector<Token>& tokenList);
+
+  /* Find longest token at start of str. Returns null if nothing found. */
+  const Token *scan(const char *str, int& length) const;
+
+  /* Text of token converted once for the std::string based results */
+  const std::string& textStd(const Token *token) const
+  {
+    return texts.at(static_cast<int>(token - tokens.constData()));
+  }
+
+private:
+  static int hash(const char *str)
+  {
+    if(str[0] >= 'A' && str[0] <= 'Z' && str[1] >= 'A' && str[1] <= 'Z')
+      return (str[0] - 'A') * 26 + (str[1] - 'A');
+    else
+      return -1;
+  }
+
+  static Q_DECL_CONSTEXPR int NUM_BUCKETS = 26 * 26;
+
+  QVector<Token> tokens;
+  QVector<QByteArray> ids;
+  QVector<std::string> texts;
+
+  /* Token indexes for each two letter prefix */
+  QVector<QVector<int> > buckets;
+};
+
+Q_DECL_CONSTEXPR int TokenTable::NUM_BUCKETS;
+
+void TokenTable::set(const QVector<Token>& tokenList)
+{
+  tokens.clear();
+  ids.clear();
+  texts.clear();
+  buckets.fill(QVector<int>(), NUM_BUCKETS);
+
+  for(const Token& token : tokenList)
+  {
+    // Skip list terminator and tokens which cannot be hashed
+    QByteArray id = token.id.toLatin1();
+    if(id.size() < 2 || hash(id.constData()) == -1)
+      continue;
+
+    tokens.append(token);
+    ids.append(id);
+    texts.append(token.text.toStdString());
+  }
+
+  for(int i = 0; i < tokens.size(); i++)
+  {
+    QVector<int>& bucket = buckets[hash(ids.at(i).constData())];
+    bucket.append(i);
+
+    // Longest first - keep first in list for duplicates
+    std::stable_sort(bucket.begin(), bucket.end(), [this](int idx1, int idx2) -> bool {
+      return ids.at(idx1).size() > ids.at(idx2).size();
+    });
+  }
+}
+
+const Token *TokenTable::scan(const char *str, int& length) const
+{
+  length = 0;
+  if(str[0] == '\0' || buckets.isEmpty())
+    return nullptr;
+
+  int h = hash(str);
+  if(h == -1)
+    return nullptr;
+
+  for(int idx : buckets.at(h))
+  {
+    const QByteArray& id = ids.at(idx);
+    if(std::strncmp(str, id.constData(), static_cast<size_t>(id.size())) == 0)
+    {
+      length = id.size();
+      return &tokens.at(idx);
+    }
+  }
+  return nullptr;
+}
+
+static TokenTable description;
+static TokenTable phenomenon;
+static TokenTable special;
+static TokenTable colors;
+static TokenTable cloud_types;
+
+/* Weather intensity texts converted once */
+static std::string lightText, heavyText, moderateText, vicinityText;
 
 static QStringList runway_deposit;
 static QStringList runway_deposit_extent;
@@ -131,7 +228,7 @@ static QStringList runway_friction;
 
 void initTranslateableTexts()
 {
-  description =
+  description.set(
   {
     {
       "SH", MetarParser::tr("Showers of")
@@ -160,9 +257,9 @@ void initTranslateableTexts()
     {
       QString(), QString()
     }
-  };
+  });
 
-  phenomenon =
+  phenomenon.set(
   {
     {
       "DZ", MetarParser::tr("Drizzle")
@@ -239,9 +336,9 @@ void initTranslateableTexts()
     {
       QString(), QString()
     }
-  };
+  });
 
-  special =
+  special.set(
   {
     {
       "NSW", MetarParser::tr("No significant weather")
@@ -251,9 +348,9 @@ void initTranslateableTexts()
     }
     /*	{ "VCSH", "showers in the vicinity" },
      *  { "VCTS", "thunderstorm in the vicinity" }, */
-  };
+  });
 
-  colors =
+  colors.set(
   {
     {
       "BLU", MetarParser::tr("Blue")
@@ -276,9 +373,9 @@ void initTranslateableTexts()
     {
       QString(), QString()
     }
-  };
+  });
 
-  cloud_types =
+  cloud_types.set(
   {
     {
       "AC", MetarParser::tr("altocumulus")
@@ -340,7 +437,12 @@ void initTranslateableTexts()
     {
       QString(), QString()
     }
-  };
+  });
+
+  lightText = MetarParser::tr("Light ").toStdString();
+  heavyText = MetarParser::tr("Heavy ").toStdString();
+  moderateText = MetarParser::tr("Moderate ").toStdString();
+  vicinityText = MetarParser::tr("in the vicinity ").toStdString();
 
   runway_deposit = QStringList(
         {
@@ -1130,7 +1232,7 @@ bool MetarParser::scanWeather()
     if(!scanBoundary(&m))
       return false;
 
-    _weather.push_back(a->text.toStdString());
+    _weather.push_back(special.textStd(a));
     _m = m;
     return true;
   }
@@ -1139,13 +1241,13 @@ bool MetarParser::scanWeather()
   struct Weather w;
 
   if(*m == '-')
-    m++, pre = tr("Light ").toStdString(), w.intensity = LIGHT;
+    m++, pre = lightText, w.intensity = LIGHT;
   else if(*m == '+')
-    m++, pre = tr("Heavy ").toStdString(), w.intensity = HEAVY;
+    m++, pre = heavyText, w.intensity = HEAVY;
   else if(!strncmp(m, "VC", 2))
-    m += 2, post = tr("in the vicinity ").toStdString(), w.vincinity = true;
+    m += 2, post = vicinityText, w.vincinity = true;
   else
-    pre = tr("Moderate ").toStdString(), w.intensity = MODERATE;
+    pre = moderateText, w.intensity = MODERATE;
 
   int i;
   for(i = 0; i < 3; i++)
@@ -1153,7 +1255,8 @@ bool MetarParser::scanWeather()
     if(!(a = scanToken(&m, description)))
       break;
     w.descriptions.push_back(a->id);
-    weather += a->text.toStdString() + " ";
+    weather += description.textStd(a);
+    weather += ' ';
   }
 
   for(i = 0; i < 3; i++)
@@ -1161,7 +1264,8 @@ bool MetarParser::scanWeather()
     if(!(a = scanToken(&m, phenomenon)))
       break;
     w.phenomena.push_back(a->id);
-    weather += a->text.toStdString() + " ";
+    weather += phenomenon.textStd(a);
+    weather += ' ';
     if(a->id == "RA")
       _rain = w.intensity;
     else if(a->id == "HA")
@@ -1775,34 +1879,12 @@ int MetarParser::scanNumber(char **src, int *num, int min, int max)
   return i;
 }
 
-// find longest match of str in list
-const struct Token *MetarParser::scanToken(char **str, const QVector<Token>& list)
+// find longest match of str in table
+const struct Token *MetarParser::scanToken(char **str, const TokenTable& table)
 {
-  const struct Token *longest = nullptr;
-  int maxlen = 0;
-  QString string(*str);
-
-  for(const Token& token : list)
-  {
-    int len = token.id.size();
-    if(string.left(len) == token.id && len > maxlen)
-    {
-      maxlen = len;
-      longest = &token;
-    }
-  }
-
-  // const char *s;
-  // for(int i = 0; (s = list[i].id); i++)
-  // {
-  // len = strlen(s);
-  // if(!strncmp(s, *str, len) && len > maxlen)
-  // {
-  // maxlen = len;
-  // longest = &list[i];
-  // }
-  // }
-  *str += maxlen;
+  int len;
+  const struct Token *longest = table.scan(*str, len);
+  *str += len;
   return longest;
 }
 
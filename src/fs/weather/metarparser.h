@@ -42,6 +42,8 @@ struct Token
   QString text;
 };
 
+class TokenTable;
+
 const Q_DECL_CONSTEXPR float INVALID_METAR_VALUE = std::numeric_limits<float>::max();
 
 class MetarParser;
@@ -545,7 +547,7 @@ private:
 
   int scanNumber(char **str, int *num, int min, int max = 0);
   bool scanBoundary(char **str);
-  const struct Token *scanToken(char **str, const QVector<Token>& list);
+  const struct Token *scanToken(char **str, const TokenTable& table);
   void normalizeData();
 
   /* Calculate flight rules (IFR, VFR, etc.), max and lowest ceiling*/
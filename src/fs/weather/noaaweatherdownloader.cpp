@@ -77,8 +77,7 @@ bool NoaaWeatherDownloader::isDownloading() const
 
 bool NoaaWeatherDownloader::read(const QByteArray& data, const QString& url)
 {
-  QTextStream stream(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO));
-  return metarIndex->read(stream, url, true /* merge */) > 0;
+  return metarIndex->read(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), url, true /* merge */) > 0;
 }
 
 void NoaaWeatherDownloader::downloadFinished(const QByteArray& data, QString url)
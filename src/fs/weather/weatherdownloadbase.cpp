@@ -20,6 +20,7 @@
 #include "util/httpdownloader.h"
 #include "fs/weather/weathertypes.h"
 #include "fs/weather/metarindex.h"
+#include "fs/weather/metar.h"
 
 namespace atools {
 namespace fs {
@@ -59,6 +60,11 @@ MetarResult WeatherDownloadBase::getMetar(const QString& airportIcao, const geo:
   return metarIndex->getMetar(airportIcao, pos);
 }
 
+Metar WeatherDownloadBase::getParsedMetar(const QString& airportIcao)
+{
+  return metarIndex->getParsedMetar(airportIcao);
+}
+
 void WeatherDownloadBase::setRequestUrl(const QString& url)
 {
   downloader->setUrl(url);
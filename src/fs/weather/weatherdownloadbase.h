@@ -31,6 +31,7 @@ namespace weather {
 
 struct MetarResult;
 class MetarIndex;
+class Metar;
 
 /*
  * Base class for weather downloaders and readers.
@@ -55,6 +56,9 @@ public:
    */
   virtual atools::fs::weather::MetarResult getMetar(const QString& airportIcao, const atools::geo::Pos& pos);
 
+  /* Parsed METAR for station from cache. Parsed on first request. Invalid if not found or not downloaded yet. */
+  atools::fs::weather::Metar getParsedMetar(const QString& airportIcao);
+
   /* Set download request URL */
   virtual void setRequestUrl(const QString& url);
   virtual const QString& getRequestUrl() const;
@@ -17,6 +17,7 @@
 
 #include "fs/weather/weathernetdownload.h"
 
+#include "util/asyncpipeline.h"
 #include "util/httpdownloader.h"
 #include "fs/weather/metarindex.h"
 #include "zip/gzip.h"
@@ -30,6 +31,22 @@ WeatherNetDownload::WeatherNetDownload(QObject *parent, atools::fs::weather::Met
 {
   connect(downloader, &atools::util::HttpDownloader::downloadFinished, this, &WeatherNetDownload::downloadFinished);
   connect(downloader, &atools::util::HttpDownloader::downloadFailed, this, &WeatherNetDownload::downloadFailed);
+
+  pipeline = new atools::util::AsyncPipeline<QByteArray>(this);
+  pipeline->addStage("gzip", [](QByteArray& data) -> void {
+    data = atools::zip::gzipDecompressIf(data, Q_FUNC_INFO);
+  });
+  pipeline->setBuildStage("metar", [](const QByteArray& data) -> std::shared_ptr<QByteArray> {
+    return std::make_shared<QByteArray>(data);
+  });
+  pipeline->setDelivered([this](std::shared_ptr<const QByteArray> data) -> void {
+    dataDecompressed(data);
+  });
+}
+
+WeatherNetDownload::~WeatherNetDownload()
+{
+  delete pipeline;
 }
 
 void WeatherNetDownload::downloadFinished(const QByteArray& data, QString url)
@@ -40,18 +57,24 @@ void WeatherNetDownload::downloadFinished(const QByteArray& data, QString url)
   // Reset error state which avoids triggering downloads
   setErrorStateTimer(false);
 
+  // Continues in dataDecompressed()
+  pipelineUrl = url;
+  pipeline->process(data);
+}
+
+void WeatherNetDownload::dataDecompressed(std::shared_ptr<const QByteArray> data)
+{
   // AGGH 161200Z 14002KT 9999 FEW016 25/24 Q1010
   // AYNZ 160800Z 09005G10KT 9999 SCT030 BKN ABV050 27/24 Q1007 RMK
   // AYPY 160700Z 28010KT 9999 SCT025 OVC050 28/23 Q1008 RMK/ BUILD UPS TO S/W
-  QTextStream stream(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), QIODevice::ReadOnly | QIODevice::Text);
-  metarIndex->read(stream, downloader->getUrl(), false /* merge */);
+  metarIndex->read(*data, downloader->getUrl(), false /* merge */);
 
   if(verbose)
-    qDebug() << Q_FUNC_INFO << "Loaded" << data.size() << "bytes and" << metarIndex->size()
+    qDebug() << Q_FUNC_INFO << "Loaded" << data->size() << "bytes and" << metarIndex->size()
              << "metars from" << downloader->getUrl();
 
   if(metarIndex->isEmpty())
-    emit weatherDownloadFailed(tr("No METARs found in download."), 0, url);
+    emit weatherDownloadFailed(tr("No METARs found in download."), 0, pipelineUrl);
   else
     emit weatherUpdated();
 }
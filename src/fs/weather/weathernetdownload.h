@@ -20,9 +20,13 @@
 
 #include "fs/weather/weatherdownloadbase.h"
 
+#include <memory>
+
 namespace atools {
 namespace util {
 class HttpDownloader;
+template<typename RESULT>
+class AsyncPipeline;
 }
 namespace fs {
 namespace weather {
@@ -33,6 +37,8 @@ class MetarIndex;
 /*
  * Manages metar files that are download fully from the web like IVAO.
  * Has a timer that triggers a recurrent lookup.
+ * Downloaded data is decompressed in a background thread. The METAR index is updated in the thread of this
+ * object since it looks up airport coordinates in the simulator database.
  */
 class WeatherNetDownload :
   public WeatherDownloadBase
@@ -41,11 +47,18 @@ class WeatherNetDownload :
 
 public:
   explicit WeatherNetDownload(QObject *parent, atools::fs::weather::MetarFormat format, bool verbose);
+  virtual ~WeatherNetDownload() override;
 
 private:
   void downloadFinished(const QByteArray& data, QString url);
+
+  /* Called in this thread once data was decompressed */
+  void dataDecompressed(std::shared_ptr<const QByteArray> data);
   void downloadFailed(const QString& error, int errorCode, QString url);
 
+  atools::util::AsyncPipeline<QByteArray> *pipeline;
+  QString pipelineUrl;
+
 };
 
 } // namespace weather
@@ -21,6 +21,7 @@
 #include "fs/weather/metarindex.h"
 #include "fs/util/fsutil.h"
 
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFileInfo>
 #include <QMap>
@@ -31,6 +32,37 @@ namespace weather {
 
 using atools::util::FileSystemWatcher;
 
+/* METAR-2022-9-6-19.00-ZULU.txt, METAR-2022-9-6-20.00-ZULU.txt, METAR-2022-9-6-19.00.txt */
+const static QStringList XP12_METAR_FILTERS = {"METAR-*.txt"};
+
+/* Size of the blocks at file start and before the read offset which are compared to detect rewritten files */
+const static qint64 HASH_BLOCK_SIZE = 4096;
+
+/* Hash of len bytes at pos */
+static QByteArray blockHash(QFile& file, qint64 pos, qint64 len)
+{
+  file.seek(pos);
+  return QCryptographicHash::hash(file.read(len), QCryptographicHash::Md5);
+}
+
+/* Line containing date like "2017/10/29 11:45" which precedes each METAR line */
+static bool isDateLine(const char *line, int length)
+{
+  auto digit = [line](int i) -> bool {
+    return line[i] >= '0' && line[i] <= '9';
+  };
+
+  return length > 10 && digit(0) && digit(1) && digit(2) && digit(3) && line[4] == '/' && digit(5) && digit(6) &&
+         line[7] == '/' && digit(8) && digit(9) && line[10] == ' ';
+}
+
+/* Sort by timestamp - put latest at begin of list */
+static bool metarFileLessThan(const QString& file1, const QString& file2)
+{
+  return atools::fs::util::xpMetarFilenameToDate(QFileInfo(file1).fileName()) >
+         atools::fs::util::xpMetarFilenameToDate(QFileInfo(file2).fileName());
+}
+
 XpWeatherReader::XpWeatherReader(QObject *parent, bool verboseLogging)
   : QObject(parent), verbose(verboseLogging)
 {
@@ -60,6 +92,7 @@ void XpWeatherReader::load()
   if(fileWatcher == nullptr && !weatherPath.isEmpty())
   {
     metarIndex->clear();
+    fileStates.clear();
     currentMetarFiles = collectWeatherFiles();
 
     if(verbose)
@@ -83,8 +116,10 @@ void XpWeatherReader::clear()
     qDebug() << Q_FUNC_INFO;
   deleteFsWatcher();
   metarIndex->clear();
+  fileStates.clear();
   weatherPath.clear();
   currentMetarFiles.clear();
+  allMetarFiles.clear();
 }
 
 void XpWeatherReader::setFetchAirportCoords(const std::function<geo::Pos(const QString&)>& value)
@@ -94,36 +129,102 @@ void XpWeatherReader::setFetchAirportCoords(const std::function<geo::Pos(const Q
 
 bool XpWeatherReader::read(const QStringList& filenames)
 {
-  // Read and merge all changed filenames into the METAR index
+  // Read and merge appended or changed parts of all filenames into the METAR index
+  bool updated = false;
   for(const QString& filename : filenames)
   {
     QFile file(filename);
-    if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+    if(file.open(QIODevice::ReadOnly))
     {
+      FileState& state = fileStates[filename];
+      qint64 size = file.size();
+
+      // Continue at last offset if neither start of file nor block before offset were changed
+      qint64 start = 0;
+      if(state.offset > 0 && size >= state.offset &&
+         blockHash(file, 0, std::min(state.offset, HASH_BLOCK_SIZE)) == state.headHash &&
+         blockHash(file, std::max(state.offset - HASH_BLOCK_SIZE, 0LL), std::min(state.offset, HASH_BLOCK_SIZE)) ==
+         state.tailHash)
+        start = state.offset;
+      else
+        state = FileState();
+
+      if(start == size)
+        // Nothing appended
+        continue;
+
+      file.seek(start);
+      QByteArray data = file.readAll();
+
+      // Consume complete lines only and keep a trailing date line together with its METAR for the next read
+      int end = 0, pos = 0;
+      QByteArray lastDateLine = state.lastDateLine;
+      while(pos < data.size())
+      {
+        int next = data.indexOf('\n', pos);
+        if(next == -1)
+          break;
+
+        if(isDateLine(data.constData() + pos, next - pos))
+          lastDateLine = data.mid(pos, next - pos);
+        else
+          end = next + 1;
+        pos = next + 1;
+      }
+
+      if(end == 0)
+        // No complete METAR line yet
+        continue;
+
       if(verbose)
-        qDebug() << Q_FUNC_INFO << filename;
-      QTextStream stream(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-      stream.setCodec("UTF-8");
-#endif
-
-      // Read and merge into current METAR entries
-      metarIndex->read(stream, filename, true /* merge */);
+        qDebug() << Q_FUNC_INFO << filename << "from" << start << "to" << start + end;
+
+      // Read and merge into current METAR entries - raw UTF-8 buffer is kept by the index
+      // Appended data might start with METAR lines belonging to a date line before the offset
+      if(start > 0 && !state.lastDateLine.isEmpty())
+        metarIndex->read(state.lastDateLine + '\n' + data.left(end), filename, true /* merge */);
+      else
+        metarIndex->read(data.left(end), filename, true /* merge */);
+
+      // Date line after end belongs to the next read
+      state.lastDateLine = lastDateLine;
+      state.offset = start + end;
+      state.headHash = blockHash(file, 0, std::min(state.offset, HASH_BLOCK_SIZE));
+      state.tailHash = blockHash(file, std::max(state.offset - HASH_BLOCK_SIZE, 0LL),
+                                 std::min(state.offset, HASH_BLOCK_SIZE));
       file.close();
+      updated = true;
     }
     else
       qWarning() << "cannot open" << file.fileName() << "reason" << file.errorString();
   }
-  return !metarIndex->isEmpty();
+  return updated;
 }
 
-void XpWeatherReader::dirUpdated(const QString& dir)
+void XpWeatherReader::dirEntriesChanged(const QString& dir, const QStringList& added, const QStringList& removed)
 {
   if(verbose)
-    qDebug() << Q_FUNC_INFO << dir;
+    qDebug() << Q_FUNC_INFO << dir << "added" << added << "removed" << removed;
+
+  // Single file for X-Plane 11 does not depend on folder content
+  if(weatherType != atools::fs::weather::WEATHER_XP12)
+    return;
 
-  // Update list of files and reload weather if this has changed
-  QStringList metarFiles = collectWeatherFiles();
+  // Update sorted file list without reading the folder again
+  for(const QString& file : removed)
+  {
+    allMetarFiles.removeAll(QFileInfo(file).absoluteFilePath());
+    fileStates.remove(QFileInfo(file).absoluteFilePath());
+  }
+
+  for(const QString& file : added)
+  {
+    QString path = QFileInfo(file).absoluteFilePath();
+    allMetarFiles.insert(std::upper_bound(allMetarFiles.begin(), allMetarFiles.end(), path, metarFileLessThan), path);
+  }
+
+  // Reload weather if list of latest files has changed
+  QStringList metarFiles = latestWeatherFiles();
   if(metarFiles != currentMetarFiles)
   {
     currentMetarFiles = metarFiles;
@@ -144,39 +245,33 @@ void XpWeatherReader::filesUpdated(const QStringList& filenames)
 
 QStringList XpWeatherReader::collectWeatherFiles()
 {
-  QFileInfoList metarFiles;
+  allMetarFiles.clear();
 
   if(weatherType == atools::fs::weather::WEATHER_XP11)
     // METAR.rwx
-    metarFiles.append(weatherPath);
+    allMetarFiles.append(QFileInfo(weatherPath).absoluteFilePath());
   else if(weatherType == atools::fs::weather::WEATHER_XP12)
   {
-    // METAR-2022-9-6-19.00-ZULU.txt, METAR-2022-9-6-20.00-ZULU.txt
-    // METAR-2022-9-6-19.00.txt, METAR-2022-9-6-20.00.txt
-    QDir weatherDir(weatherPath, "METAR-*.txt", QDir::Name, QDir::Files | QDir::NoDotAndDotDot);
+    QDir weatherDir(weatherPath, QString(), QDir::Unsorted, QDir::Files | QDir::NoDotAndDotDot);
+    weatherDir.setNameFilters(XP12_METAR_FILTERS);
     const QFileInfoList entries = weatherDir.entryInfoList();
-    for(QFileInfo entry : entries)
-      metarFiles.append(entry);
-
-    // Sort by timestamp - put latest at begin of list
-    if(metarFiles.size() > 1)
-      std::sort(metarFiles.begin(), metarFiles.end(), [](const QFileInfo& file1, const QFileInfo& file2)->bool {
-              return atools::fs::util::xpMetarFilenameToDate(file1.fileName()) > atools::fs::util::xpMetarFilenameToDate(file2.fileName());
-            });
+    for(const QFileInfo& entry : entries)
+      allMetarFiles.append(entry.absoluteFilePath());
+
+    if(allMetarFiles.size() > 1)
+      std::sort(allMetarFiles.begin(), allMetarFiles.end(), metarFileLessThan);
   }
 
   if(verbose)
-    qDebug() << Q_FUNC_INFO << metarFiles;
+    qDebug() << Q_FUNC_INFO << allMetarFiles;
 
-  // Return only latest three files
-  QStringList files;
-  for(int i = 0; i < std::min(3, metarFiles.size()); i++)
-    files.append(metarFiles.at(i).absoluteFilePath());
-
-  if(verbose)
-    qDebug() << Q_FUNC_INFO << files;
+  return latestWeatherFiles();
+}
 
-  return files;
+QStringList XpWeatherReader::latestWeatherFiles() const
+{
+  // Return only latest three files
+  return allMetarFiles.mid(0, 3);
 }
 
 void XpWeatherReader::deleteFsWatcher()
@@ -184,7 +279,8 @@ void XpWeatherReader::deleteFsWatcher()
   if(fileWatcher != nullptr)
   {
     atools::util::FileSystemWatcher::disconnect(fileWatcher, &FileSystemWatcher::filesUpdated, this, &XpWeatherReader::filesUpdated);
-    atools::util::FileSystemWatcher::disconnect(fileWatcher, &FileSystemWatcher::dirUpdated, this, &XpWeatherReader::dirUpdated);
+    atools::util::FileSystemWatcher::disconnect(fileWatcher, &FileSystemWatcher::dirEntriesChanged, this,
+                                                &XpWeatherReader::dirEntriesChanged);
     fileWatcher->deleteLater();
     fileWatcher = nullptr;
   }
@@ -200,7 +296,12 @@ void XpWeatherReader::createFsWatcher()
     // Set to smaller value to deal with ASX weather files
     fileWatcher->setMinFileSize(1000);
     atools::util::FileSystemWatcher::connect(fileWatcher, &FileSystemWatcher::filesUpdated, this, &XpWeatherReader::filesUpdated);
-    atools::util::FileSystemWatcher::connect(fileWatcher, &FileSystemWatcher::dirUpdated, this, &XpWeatherReader::dirUpdated);
+    atools::util::FileSystemWatcher::connect(fileWatcher, &FileSystemWatcher::dirEntriesChanged, this,
+                                             &XpWeatherReader::dirEntriesChanged);
+
+    // Report only added or removed METAR files in folder
+    if(weatherType == WEATHER_XP12)
+      fileWatcher->setDirNameFilters(XP12_METAR_FILTERS);
   }
 
   // Load initially
@@ -218,6 +319,7 @@ void XpWeatherReader::debugDumpContainerSizes() const
 {
   qDebug() << Q_FUNC_INFO << "currentMetarFiles.size()" << currentMetarFiles.size();
   qDebug() << Q_FUNC_INFO << "metarIndex.size()" << metarIndex->size();
+  qDebug() << Q_FUNC_INFO << "fileStates.size()" << fileStates.size();
 }
 
 } // namespace weather
@@ -20,6 +20,7 @@
 
 #include "fs/weather/weathertypes.h"
 
+#include <QHash>
 #include <QObject>
 #include <functional>
 
@@ -39,6 +40,10 @@ class MetarIndex;
 
 /*
  * Reads the X-Plane 11 METAR.rwx or X-Plane 12 folder and watches the files/folder for changes.
+ *
+ * Files are read incrementally. The read offset and hashes of the first and last block before the offset are
+ * kept for each file. Only appended data is parsed and merged into the index if both blocks are unchanged.
+ * Otherwise the file was rewritten and is read completely.
  */
 class XpWeatherReader
   : public QObject
@@ -88,22 +93,39 @@ signals:
   void weatherUpdated();
 
 private:
+  /* Position after the last consumed line and hashes to detect rewritten files */
+  struct FileState
+  {
+    qint64 offset = 0;
+    QByteArray headHash, tailHash;
+
+    /* Last date line before offset which is prepended to appended METAR lines */
+    QByteArray lastDateLine;
+  };
+
   void deleteFsWatcher();
   void createFsWatcher();
+
+  /* Read appended or rewritten parts of files. Returns true if any data was merged into the index. */
   bool read(const QStringList& filenames);
 
   /* Called from fsWatcher */
   void filesUpdated(const QStringList& filenames);
-  void dirUpdated(const QString& dir);
+  void dirEntriesChanged(const QString& dir, const QStringList& added, const QStringList& removed);
 
-  /* Get all METAR files from parent folder */
+  /* Get all METAR files from parent folder into allMetarFiles and return the latest */
   QStringList collectWeatherFiles();
 
+  /* Latest three files from allMetarFiles */
+  QStringList latestWeatherFiles() const;
+
   atools::fs::weather::MetarIndex *metarIndex = nullptr;
   atools::util::FileSystemWatcher *fileWatcher = nullptr;
 
   QString weatherPath; // Folder or file depending on simulator
   QStringList currentMetarFiles; // Set file or collected files from folder
+  QStringList allMetarFiles; // All files in folder sorted by timestamp with latest first
+  QHash<QString, FileState> fileStates; // Read state by filename
 
   bool verbose;
 
@@ -18,14 +18,16 @@
 #include "fs/xp/airwaypostprocess.h"
 
 #include "sql/sqldatabase.h"
+#include "sql/sqlbulkinsert.h"
 #include "sql/sqlquery.h"
-#include "sql/sqlutil.h"
+#include "util/parallel.h"
 #include "atools.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 using atools::sql::SqlQuery;
-using atools::sql::SqlUtil;
+using atools::sql::SqlBulkInsert;
 
 namespace atools {
 namespace fs {
@@ -41,24 +43,27 @@ bool operator!=(const AirwayPoint& seg1, const AirwayPoint& seg2)
   return !(seg1 == seg2);
 }
 
-bool operator==(const AirwaySegment& seg1, const AirwaySegment& seg2)
-{
-  return seg1.next == seg2.next && seg1.prev == seg2.prev;
-}
-
-bool operator!=(const AirwaySegment& seg1, const AirwaySegment& seg2)
+inline uint qHash(const AirwayPoint& seg)
 {
-  return !(seg1 == seg2);
+  return (static_cast<uint>(seg.ident) * 31u + static_cast<uint>(seg.region)) * 31u + static_cast<uint>(seg.type);
 }
 
-inline uint qHash(const AirwayPoint& seg)
+/* Key for undirected segment between two waypoint ids */
+inline quint64 pairKey(int id1, int id2)
 {
-  return qHash(seg.ident) ^ qHash(seg.region) ^ static_cast<uint>(seg.type);
+  return (static_cast<quint64>(static_cast<quint32>(std::min(id1, id2))) << 32) |
+         static_cast<quint32>(std::max(id1, id2));
 }
 
-inline uint qHash(const AirwaySegment& seg)
+/* Flip forward and backward direction */
+inline char reverseDirection(char dir)
 {
-  return qHash(seg.prev) ^ qHash(seg.next);
+  if(dir == 'B')
+    return 'F';
+  else if(dir == 'F')
+    return 'B';
+  else
+    return dir;
 }
 
 /* Convert X-Plane type into database type */
@@ -103,8 +108,8 @@ QString convertAirwayType(AirwayType type)
 
 // ==================================================================
 
-AirwayPostProcess::AirwayPostProcess(sql::SqlDatabase& sqlDb)
-  : db(sqlDb)
+AirwayPostProcess::AirwayPostProcess(sql::SqlDatabase& sqlDb, int numThreads)
+  : db(sqlDb), threads(numThreads)
 {
 }
 
@@ -114,292 +119,250 @@ AirwayPostProcess::~AirwayPostProcess()
 
 bool AirwayPostProcess::postProcessEarthAirway()
 {
-  // A29
-  // A123 - 1
-  // A105 - 2
-  // A126 -5
-  // A125 -8
-  // V16 -216
-  // where name in ('V16')
+  QElapsedTimer timer;
+  timer.start();
+
   SqlQuery query("select name, type, direction, minimum_altitude, maximum_altitude, "
                  "previous_type, previous_ident, previous_region, "
                  "next_type, next_ident, next_region from airway_temp order by name", db);
 
-  SqlQuery insert(db);
-  insert.prepare(SqlUtil(db).buildInsertStatement("tmp_airway_point", QString(),
-                                                  {"airway_point_id", "waypoint_id", "next_airport_ident",
-                                                   "previous_airport_ident"}));
+  // Maps waypoint to a consecutive integer id
+  QHash<AirwayPoint, int> pointIds;
+  auto pointId = [&pointIds](const AirwayPoint& point) -> int {
+                   auto it = pointIds.constFind(point);
+                   if(it != pointIds.constEnd())
+                     return it.value();
 
-  QString currentAirway;
-  AirwayType currentAirwayType = NONE;
-  QList<AirwaySegment> segments;
+                   int id = pointIds.size();
+                   pointIds.insert(point, id);
+                   return id;
+                 };
 
-  // Read duplets from temp table
+  // Read all duplets from temp table into the flat segment vector ==============================
   while(query.next())
   {
     QString airway = query.value("name").toString();
-    AirwayType airwayType = static_cast<AirwayType>(query.value("type").toInt());
-
-    if(currentAirway.isEmpty())
-    {
-      // First iteration
-      currentAirway = airway;
-      currentAirwayType = airwayType;
-    }
-
-    if(currentAirway != airway && !segments.isEmpty())
+    if(airwayNames.isEmpty() || airwayNames.constLast() != airway)
     {
-      // Airway has changed - order and write all its segments
-      writeSegments(segments, insert, currentAirway, currentAirwayType);
-
-      segments.clear();
-      currentAirway = airway;
-      currentAirwayType = airwayType;
+      // Airway has changed - remember name, type and first segment
+      airwayNames.append(airway);
+      airwayTypes.append(static_cast<AirwayType>(query.value("type").toInt()));
+      airwayStart.append(segments.size());
     }
 
-    // Add a segment from the database
     AirwaySegment segment;
     segment.minAlt = query.value("minimum_altitude").toInt();
     segment.maxAlt = query.value("maximum_altitude").toInt();
-    segment.next.ident = query.value("next_ident").toString();
-    segment.next.region = query.value("next_region").toString();
+    segment.next.ident = interner.intern(query.value("next_ident").toString());
+    segment.next.region = interner.intern(query.value("next_region").toString());
     segment.next.type = static_cast<AirwayPointType>(query.value("next_type").toInt());
-    segment.prev.ident = query.value("previous_ident").toString();
-    segment.prev.region = query.value("previous_region").toString();
+    segment.prev.ident = interner.intern(query.value("previous_ident").toString());
+    segment.prev.region = interner.intern(query.value("previous_region").toString());
     segment.prev.type = static_cast<AirwayPointType>(query.value("previous_type").toInt());
     segment.dir = atools::strToChar(query.value("direction").toString());
 
-    segments.insert(segments.size(), segment);
+    int index = segments.size(), airwayIndex = airwayNames.size() - 1;
+    segments.append(segment);
+    prevIds.append(pointId(segment.prev));
+    nextIds.append(pointId(segment.next));
+    ends.append({airwayIndex, prevIds.constLast(), index, true});
+    ends.append({airwayIndex, nextIds.constLast(), index, false});
   }
+  airwayStart.append(segments.size());
+  pointIds.clear();
+
+  // Sort segment ends once by airway and waypoint to allow lookup of connected segments ==============================
+  atools::util::parallelSort(ends.begin(), ends.end(), [](const SegmentEnd& e1, const SegmentEnd& e2) -> bool {
+    if(e1.airway != e2.airway)
+      return e1.airway < e2.airway;
+    else if(e1.point != e2.point)
+      return e1.point < e2.point;
+    else if(e1.segment != e2.segment)
+      return e1.segment < e2.segment;
+    else
+      return e1.isPrev && !e2.isPrev;
+  }, threads);
 
-  // Write the last airway
-  if(!segments.isEmpty())
-    writeSegments(segments, insert, currentAirway, currentAirwayType);
+  // Build groups of equal airway and waypoint and assign them to the segment ends ==============================
+  prevGroups.resize(segments.size());
+  nextGroups.resize(segments.size());
+  for(int i = 0; i < ends.size(); i++)
+  {
+    const SegmentEnd& end = ends.at(i);
+    if(i == 0 || end.airway != ends.at(i - 1).airway || end.point != ends.at(i - 1).point)
+      groupStart.append(i);
+
+    if(end.isPrev)
+      prevGroups[end.segment] = groupStart.size() - 1;
+    else
+      nextGroups[end.segment] = groupStart.size() - 1;
+  }
+  groupStart.append(ends.size());
+
+  used.fill(false, segments.size());
+
+  // Link and write all airways ========================================
+  SqlBulkInsert insert(&db, "tmp_airway_point",
+                       {"name", "type", "mid_type", "mid_ident", "mid_region",
+                        "previous_type", "previous_ident", "previous_region",
+                        "previous_minimum_altitude", "previous_maximum_altitude", "previous_direction",
+                        "next_type", "next_ident", "next_region",
+                        "next_minimum_altitude", "next_maximum_altitude", "next_direction"});
+
+  for(int airway = 0; airway < airwayNames.size(); airway++)
+    writeAirway(insert, airway);
+  insert.flush();
+
+  qDebug() << Q_FUNC_INFO << "airways" << airwayNames.size() << "segments" << segments.size()
+           << "rows" << insert.getNumWritten() << timer.elapsed() << "ms";
+
+  // Free memory
+  segments.clear();
+  prevIds.clear();
+  nextIds.clear();
+  prevGroups.clear();
+  nextGroups.clear();
+  used.clear();
+  ends.clear();
+  groupStart.clear();
+  airwayNames.clear();
+  airwayTypes.clear();
+  airwayStart.clear();
+  donePairs.clear();
+  interner.clear();
 
   return false;
 }
 
-void AirwayPostProcess::writeSegments(QList<AirwaySegment>& segments, SqlQuery& insert, const QString& name,
-                                      AirwayType type)
+void AirwayPostProcess::writeAirway(sql::SqlBulkInsert& insert, int airway)
 {
-  // if(name != "UJ20" && name != "UJ3")
-  // return;
-
-  // Create a list ordered by next waypoint id
-  QVector<AirwaySegment> segsByNext(segments.toVector());
-  std::sort(segsByNext.begin(), segsByNext.end(), nextOrderFunc);
-
-  // Create a list ordered by previous waypoint id
-  QVector<AirwaySegment> segsByPrev(segments.toVector());
-  std::sort(segsByPrev.begin(), segsByPrev.end(), prevOrderFunc);
+  const QString& name = airwayNames.at(airway);
+  QString type = convertAirwayType(airwayTypes.at(airway));
 
-  // List of finished segments with original and reversed from/to
-  QSet<AirwaySegment> done;
+  // Group in sorted ends for the start and end point of an item
+  auto startGroup = [this](const FragmentItem& item) -> int {
+                      return item.reversed ? nextGroups.at(item.segment) : prevGroups.at(item.segment);
+                    };
+  auto endGroup = [this](const FragmentItem& item) -> int {
+                    return item.reversed ? prevGroups.at(item.segment) : nextGroups.at(item.segment);
+                  };
 
-  // for(const Segment& s : segsByNext)
-  // qDebug() << "BYNEXT" << s.prev.ident << s.prev.region << s.prev.type
-  // << s.next.ident << s.next.region << s.next.type;
-  // for(const Segment& s : segsByPrev)
-  // qDebug() << "BYPREV" << s.prev.ident << s.prev.region << s.prev.type
-  // << s.next.ident << s.next.region << s.next.type;
+  donePairs.clear();
 
   // Iterate over all segments of this airway
-  while(!segments.isEmpty())
+  for(int start = airwayStart.at(airway); start < airwayStart.at(airway + 1); start++)
   {
-    // Create an airway fragment
-    QVector<AirwaySegment> found;
-    QVector<AirwaySegment> sortedSegments;
+    if(used.at(start))
+      continue;
 
-    // Insert start segment
-    sortedSegments.append(segments.constFirst());
-
-    // Start segment is finished here - add from/to and to/from to simplify search
-    done.insert(segments.constFirst());
-    done.insert(segments.constFirst().reversed());
-    segments.removeFirst();
+    // Create an airway fragment with the start segment
+    // Items found at the end go into forward and items found at the beginning into backward in reverse order
+    QVector<FragmentItem> forward({{start, false}}), backward;
+    used[start] = true;
+    donePairs.insert(pairKey(prevIds.at(start), nextIds.at(start)));
 
     bool foundPrev = true, foundNext = true;
     while(foundNext || foundPrev)
     {
-      // Find next for last segment
-      const AirwaySegment& last = sortedSegments.constLast();
-      if(findSegment(found, done, segsByPrev, last.next, last.prev, true))
-      {
-        // Found segment is in correct order
-        segments.removeOne(found.constFirst());
-        sortedSegments.append(found.constFirst());
-        foundNext = true;
-      }
-      else if(findSegment(found, done, segsByNext, last.next, last.prev, false))
+      // Find next for last segment - prefers segments in correct order
+      const FragmentItem last = forward.constLast();
+      bool isPrev;
+      int seg = findLink(endGroup(last), endId(last), startId(last), true /* preferPrev */, isPrev);
+      foundNext = seg != -1;
+      if(foundNext)
       {
-        // Found segment is in reversed order
-        segments.removeOne(found.constFirst());
-        sortedSegments.append(found.constFirst().reversed());
-        foundNext = true;
+        used[seg] = true;
+        donePairs.insert(pairKey(prevIds.at(seg), nextIds.at(seg)));
+        forward.append({seg, !isPrev /* reversed */});
       }
-      else
-        foundNext = false;
 
-      // Find previous for first segment
-      const AirwaySegment& first = sortedSegments.constFirst();
-      if(findSegment(found, done, segsByNext, first.prev, first.next, false))
+      // Find previous for first segment - prefers segments in correct order
+      const FragmentItem first = backward.isEmpty() ? forward.constFirst() : backward.constLast();
+      seg = findLink(startGroup(first), startId(first), endId(first), false /* preferPrev */, isPrev);
+      foundPrev = seg != -1;
+      if(foundPrev)
       {
-        // Found segment is in correct order
-        segments.removeOne(found.constFirst());
-        sortedSegments.prepend(found.constFirst());
-        foundPrev = true;
+        used[seg] = true;
+        donePairs.insert(pairKey(prevIds.at(seg), nextIds.at(seg)));
+        backward.append({seg, isPrev /* reversed */});
       }
-      else if(findSegment(found, done, segsByPrev, first.prev, first.next, true))
-      {
-        // Found segment is in reversed order
-        segments.removeOne(found.constFirst());
-        sortedSegments.prepend(found.constFirst().reversed());
-        foundPrev = true;
-      }
-      else
-        foundPrev = false;
     }
 
-    // qDebug() << "-------";
-    // for(const Segment& s: sortedSegments)
-    // qDebug() << "SORTED" << s.prev.ident << s.prev.region << s.prev.type
-    // << s.next.ident << s.next.region << s.next.type;
-    // qDebug() << "-------";
+    std::reverse(backward.begin(), backward.end());
+    backward.append(forward);
+    const QVector<FragmentItem>& fragment = backward;
 
     // Write the from/via/to triplets now
-    for(int i = 0; i < sortedSegments.size(); i++)
+    for(int i = 0; i < fragment.size(); i++)
     {
-      // use value method to get default constructed objects if index is invalid
-      // 1 -> 2
-      AirwaySegment prev12 = sortedSegments.value(i - 1);
       // 2 -> 3
-      AirwaySegment mid23 = sortedSegments.value(i);
+      const FragmentItem *mid23 = &fragment.at(i);
       // 3 -> 4
-      AirwaySegment next34 = sortedSegments.value(i + 1);
-
-      // Write in order 1 -> 2 -> 3
-      // qDebug() << "1 -> 2 -> 3 ###################################################";
-      // qDebug() << name << prev12.prev.ident << ">" << QChar(prev12.dir) << ">" << prev12.next.ident
-      // << mid23.prev.ident << ">" << QChar(mid23.dir) << ">" << mid23.next.ident;
+      const FragmentItem *next34 = i < fragment.size() - 1 ? &fragment.at(i + 1) : nullptr;
 
-      if(i == 0) // Avoid overlapping/duplicates
-        writeSegment(insert, name, type, prev12, mid23);
+      if(i == 0) // Write in order 1 -> 2 -> 3 and avoid overlapping/duplicates
+        writeSegment(insert, name, type, nullptr, mid23);
 
       // Write in order 2 -> 3 -> 4
-      // qDebug() << "2 -> 3 -> 4 ######";
-      // qDebug() << name << mid23.prev.ident << ">" << QChar(mid23.dir) << ">" << mid23.next.ident
-      // << next34.prev.ident << ">" << QChar(next34.dir) << ">" << next34.next.ident;
       writeSegment(insert, name, type, mid23, next34);
     }
   }
 }
 
-void AirwayPostProcess::writeSegment(SqlQuery& insert, const QString& name, AirwayType type,
-                                     const AirwaySegment& prevSeg, const AirwaySegment& nextSeg)
+int AirwayPostProcess::findLink(int group, int point, int excludePoint, bool preferPrev, bool& isPrev) const
 {
-  insert.clearBoundValues();
-
-  insert.bindValue(":name", name);
-  insert.bindValue(":type", convertAirwayType(type));
-  insert.bindValue(":mid_type", convertType(prevSeg.next.type));
-  insert.bindValue(":mid_ident", prevSeg.next.ident);
-  insert.bindValue(":mid_region", prevSeg.next.region);
-
-  if(!prevSeg.prev.ident.isEmpty())
-  {
-    insert.bindValue(":previous_type", convertType(prevSeg.prev.type));
-    insert.bindValue(":previous_ident", prevSeg.prev.ident);
-    insert.bindValue(":previous_region", prevSeg.prev.region);
-    insert.bindValue(":previous_minimum_altitude", prevSeg.minAlt * 100);
-    insert.bindValue(":previous_maximum_altitude", prevSeg.maxAlt * 100);
-    insert.bindValue(":previous_direction", atools::charToStr(prevSeg.dir));
-  }
-
-  if(!nextSeg.next.ident.isEmpty())
+  // First pass looks for segments in preferred order and second for all others
+  for(int pass = 0; pass < 2; pass++)
   {
-    insert.bindValue(":next_type", convertType(nextSeg.next.type));
-    insert.bindValue(":next_ident", nextSeg.next.ident);
-    insert.bindValue(":next_region", nextSeg.next.region);
-    insert.bindValue(":next_minimum_altitude", nextSeg.minAlt * 100);
-    insert.bindValue(":next_maximum_altitude", nextSeg.maxAlt * 100);
-    insert.bindValue(":next_direction", atools::charToStr(nextSeg.dir));
-  }
+    bool wantPrev = pass == 0 ? preferPrev : !preferPrev;
+    for(int i = groupStart.at(group); i < groupStart.at(group + 1); i++)
+    {
+      const SegmentEnd& end = ends.at(i);
+      if(end.isPrev != wantPrev || used.at(end.segment))
+        continue;
 
-  insert.exec();
-}
+      int other = end.isPrev ? nextIds.at(end.segment) : prevIds.at(end.segment);
+      if(other == excludePoint || donePairs.contains(pairKey(point, other)))
+        continue;
 
-bool AirwayPostProcess::nextOrderFunc(const AirwaySegment& s1, const AirwaySegment& s2)
-{
-  if(s1.next.ident == s2.next.ident)
-  {
-    if(s1.next.region == s2.next.region)
-      return s1.next.type < s2.next.type;
-    else
-      return s1.next.region < s2.next.region;
+      isPrev = end.isPrev;
+      return end.segment;
+    }
   }
-  else
-    return s1.next.ident < s2.next.ident;
+  return -1;
 }
 
-bool AirwayPostProcess::prevOrderFunc(const AirwaySegment& s1, const AirwaySegment& s2)
+void AirwayPostProcess::writeSegment(sql::SqlBulkInsert& insert, const QString& name, const QString& type,
+                                     const FragmentItem *prevItem, const FragmentItem *nextItem) const
 {
-  if(s1.prev.ident == s2.prev.ident)
-  {
-    if(s1.prev.region == s2.prev.region)
-      return s1.prev.type < s2.prev.type;
-    else
-      return s1.prev.region < s2.prev.region;
-  }
-  else
-    return s1.prev.ident < s2.prev.ident;
-}
+  // Empty point if no previous segment
+  AirwayPoint mid = prevItem != nullptr ? endPoint(*prevItem) : AirwayPoint();
 
-bool AirwayPostProcess::findSegment(QVector<AirwaySegment>& found, QSet<AirwaySegment>& done,
-                                    const QVector<AirwaySegment>& segments,
-                                    AirwayPoint airwayPoint, AirwayPoint excludePoint, bool searchPrevious)
-{
-  found.clear();
+  QVariantList row({name, type, convertType(mid.type), interner.getString(mid.ident), interner.getString(mid.region)});
 
-  AirwaySegment segment;
-  if(searchPrevious)
-    segment.prev = airwayPoint;
+  if(prevItem != nullptr && startPoint(*prevItem).ident != atools::util::StringInterner::EMPTY_ID)
+  {
+    const AirwayPoint& prev = startPoint(*prevItem);
+    const AirwaySegment& seg = segments.at(prevItem->segment);
+    row << convertType(prev.type) << interner.getString(prev.ident) << interner.getString(prev.region)
+        << seg.minAlt * 100 << seg.maxAlt * 100
+        << atools::charToStr(prevItem->reversed ? reverseDirection(seg.dir) : seg.dir);
+  }
   else
-    segment.next = airwayPoint;
-
-  auto lower = std::lower_bound(segments.constBegin(), segments.constEnd(), segment, searchPrevious ? prevOrderFunc : nextOrderFunc);
-  auto upper = std::upper_bound(segments.constBegin(), segments.constEnd(), segment, searchPrevious ? prevOrderFunc : nextOrderFunc);
+    row << QVariant() << QVariant() << QVariant() << QVariant() << QVariant() << QVariant();
 
-  // qDebug() << "SEARCH" << idx.ident << idx.region << idx.type << prev;
-
-  for(auto it = lower; it < upper; ++it)
+  if(nextItem != nullptr && endPoint(*nextItem).ident != atools::util::StringInterner::EMPTY_ID)
   {
-    // qDebug() << "FOUND" << (*it).prev.ident << (*it).prev.region << (*it).prev.type
-    // << (*it).next.ident << (*it).next.region << (*it).next.type;
-
-    if(searchPrevious)
-    {
-      if(it->next != excludePoint && !done.contains(*it))
-      {
-        found.append(*it);
-        done.insert(*it);
-        done.insert((*it).reversed());
-      }
-    }
-    else
-    {
-      if(it->prev != excludePoint && !done.contains(*it))
-      {
-        found.append(*it);
-        done.insert(*it);
-        done.insert((*it).reversed());
-      }
-    }
+    const AirwayPoint& next = endPoint(*nextItem);
+    const AirwaySegment& seg = segments.at(nextItem->segment);
+    row << convertType(next.type) << interner.getString(next.ident) << interner.getString(next.region)
+        << seg.minAlt * 100 << seg.maxAlt * 100
+        << atools::charToStr(nextItem->reversed ? reverseDirection(seg.dir) : seg.dir);
   }
+  else
+    row << QVariant() << QVariant() << QVariant() << QVariant() << QVariant() << QVariant();
 
-  if(found.size() > 1)
-    qWarning() << "Found more than one airway segment";
-
-  return !found.isEmpty();
+  insert.addRow(row);
 }
 
 } // namespace xp
@@ -18,13 +18,17 @@
 #ifndef ATOOLS_XP_POSTPROCESS_H
 #define ATOOLS_XP_POSTPROCESS_H
 
-#include <QString>
+#include "util/stringinterner.h"
+
+#include <QSet>
+#include <QStringList>
+#include <QVector>
 
 namespace atools {
 
 namespace sql {
 class SqlDatabase;
-class SqlQuery;
+class SqlBulkInsert;
 }
 
 namespace fs {
@@ -51,10 +55,10 @@ enum AirwayType
   BOTH = 3 /* artifical type created by merge of victor and jet */
 };
 
-/* Waypoint along the airway */
+/* Waypoint along the airway. Ident and region are ids of the interner in AirwayPostProcess. */
 struct AirwayPoint
 {
-  QString ident, region;
+  int ident = atools::util::StringInterner::EMPTY_ID, region = atools::util::StringInterner::EMPTY_ID;
   AirwayPointType type = AW_NONE;
 };
 
@@ -69,8 +73,8 @@ struct AirwaySegment
   AirwaySegment reversed() const
   {
     AirwaySegment retval(*this);
-    retval.prev.ident.swap(retval.next.ident);
-    retval.prev.region.swap(retval.next.region);
+    std::swap(retval.prev.ident, retval.next.ident);
+    std::swap(retval.prev.region, retval.next.region);
     std::swap(retval.prev.type, retval.next.type);
     if(retval.dir == 'B')
       retval.dir = 'F';
@@ -84,36 +88,99 @@ struct AirwaySegment
 /*
  * Takes the unordered from/to and to/from lists from X-Plane and converts them into an ordered list with from/via/to rows.
  * Reads from table airway_temp and inserts into tmp_airway_point
+ *
+ * All segments are kept in one flat vector. Waypoints are mapped to integer ids and segment ends are sorted once
+ * by airway and waypoint id. Fragments are then linked in place by following the sorted ends which
+ * makes the whole process scale linearly with the number of segments.
  */
 class AirwayPostProcess
 {
 public:
-  AirwayPostProcess(atools::sql::SqlDatabase& sqlDb);
+  /* @param numThreads Threads used for sorting. 0 uses the number of cores. */
+  AirwayPostProcess(atools::sql::SqlDatabase& sqlDb, int numThreads = 1);
   virtual ~AirwayPostProcess();
 
   /* Reads all from/to and to/from segments of all airways and creates from/via/to segments. */
   bool postProcessEarthAirway();
 
 private:
-  /* Sort and write out all segments of an airway. This also includes multiple fragments of the same airway name.
-   * The list segments is emptied during this process. */
-  void writeSegments(QList<AirwaySegment>& segments, sql::SqlQuery& insert, const QString& name, AirwayType type);
+  /* Start or end of a segment. Sorted by airway, waypoint and segment index. */
+  struct SegmentEnd
+  {
+    int airway, point, segment;
+    bool isPrev; /* true if point is the previous/from point of the segment */
+  };
+
+  /* Segment in an airway fragment which might be used in reversed order */
+  struct FragmentItem
+  {
+    int segment;
+    bool reversed;
+  };
+
+  /* Link fragments for all segments of airway index airway and write them out */
+  void writeAirway(atools::sql::SqlBulkInsert& insert, int airway);
+
+  /* Find a segment which is not used yet and is connected to point in ends group.
+   * Segments using excludePoint as other end are ignored. Prefers segments having point as previous/from point
+   * if preferPrev is true and as next/to point otherwise. Returns -1 if nothing was found. */
+  int findLink(int group, int point, int excludePoint, bool preferPrev, bool& isPrev) const;
 
-  /* Finds an airway segment starting or ending with airwayPoint in the list segments which can sorted by next or prev ids.*/
-  bool findSegment(QVector<AirwaySegment>& found, QSet<AirwaySegment>& done, const QVector<AirwaySegment>& segments,
-                   AirwayPoint airwayPoint, AirwayPoint excludePoint, bool searchPrevious);
+  /* Write a from/via/to (prev/mid/next) triplet. Items can be null for the first or last waypoint. */
+  void writeSegment(atools::sql::SqlBulkInsert& insert, const QString& name, const QString& type,
+                    const FragmentItem *prevItem, const FragmentItem *nextItem) const;
 
-  /* Write a from/via/to (prev/mid/next) triplet into the database */
-  void writeSegment(atools::sql::SqlQuery& insert, const QString& name, AirwayType type,
-                    const AirwaySegment& prevSeg, const AirwaySegment& nextSeg);
+  const AirwayPoint& startPoint(const FragmentItem& item) const
+  {
+    return item.reversed ? segments.at(item.segment).next : segments.at(item.segment).prev;
+  }
+
+  const AirwayPoint& endPoint(const FragmentItem& item) const
+  {
+    return item.reversed ? segments.at(item.segment).prev : segments.at(item.segment).next;
+  }
 
-  /* Used for sorting and binary search in the ordered segment lists. Sorts by next/to */
-  static bool nextOrderFunc(const AirwaySegment& s1, const AirwaySegment& s2);
+  int startId(const FragmentItem& item) const
+  {
+    return item.reversed ? nextIds.at(item.segment) : prevIds.at(item.segment);
+  }
 
-  /* Used for sorting and binary search in the ordered segment lists. Sorts by previous/from */
-  static bool prevOrderFunc(const AirwaySegment& s1, const AirwaySegment& s2);
+  int endId(const FragmentItem& item) const
+  {
+    return item.reversed ? prevIds.at(item.segment) : nextIds.at(item.segment);
+  }
 
   atools::sql::SqlDatabase& db;
+  int threads;
+
+  /* Idents and regions of all airway points */
+  atools::util::StringInterner interner;
+
+  /* All segments of all airways in order of airway name. Index is segment index. */
+  QVector<AirwaySegment> segments;
+
+  /* Integer waypoint ids for previous and next point. Index is segment index. */
+  QVector<int> prevIds, nextIds;
+
+  /* Group of equal airway/point in the sorted ends for previous and next point. Index is segment index. */
+  QVector<int> prevGroups, nextGroups;
+
+  /* Segment already added to a fragment. Index is segment index. */
+  QVector<bool> used;
+
+  /* Segment ends sorted by airway, point and segment */
+  QVector<SegmentEnd> ends;
+
+  /* Start index of each group of equal airway/point in ends. Has one more entry for the end. */
+  QVector<int> groupStart;
+
+  /* Airway name, type and first segment index. airwayStart has one more entry for the end. */
+  QStringList airwayNames;
+  QVector<AirwayType> airwayTypes;
+  QVector<int> airwayStart;
+
+  /* Point id pairs of segments used in the current airway. Avoids using from/to and to/from duplicates. */
+  QSet<quint64> donePairs;
 };
 
 } // namespace xp
@@ -70,12 +70,15 @@ enum ProcedureFieldIndex
 };
 /* *INDENT-ON* */
 
+Q_DECL_CONSTEXPR int XpCifpWriter::AIRPORT_BATCH_SIZE;
+
 XpCifpWriter::XpCifpWriter(atools::sql::SqlDatabase& sqlDb, atools::fs::common::AirportIndex *airportIndexParam,
                            const NavDatabaseOptions& opts, ProgressHandler *progressHandler,
                            atools::fs::NavDatabaseErrors *navdatabaseErrors)
   : XpWriter(sqlDb, opts, progressHandler, navdatabaseErrors)
 {
   procWriter = new atools::fs::common::ProcedureWriter(sqlDb, airportIndexParam);
+  parallel = opts.getReaderThreads() != 1;
 }
 
 XpCifpWriter::~XpCifpWriter()
@@ -161,11 +164,26 @@ void XpCifpWriter::write(const QStringList& line, const XpWriterContext& context
   procInput.centerSubCode = at(line, CENTER_SUB_CODE);
   procInput.gnssFmsIndicator = at(line, GNSS_FMS_IND);
 
-  procWriter->write(procInput);
+  if(parallel)
+    airportLines.append(procInput);
+  else
+    procWriter->write(procInput);
 }
 
 void XpCifpWriter::finish(const XpWriterContext& context)
 {
+  if(parallel)
+  {
+    // Keep airport for conversion in worker threads
+    if(!airportLines.isEmpty())
+      airports.append(airportLines);
+    airportLines.clear();
+
+    if(airports.size() >= AIRPORT_BATCH_SIZE)
+      flush();
+    return;
+  }
+
   atools::fs::common::ProcedureInput procInput;
 
   procInput.context = context.messagePrefix();
@@ -178,6 +196,21 @@ void XpCifpWriter::finish(const XpWriterContext& context)
 void XpCifpWriter::reset()
 {
   procWriter->reset();
+  airportLines.clear();
+}
+
+void XpCifpWriter::flush()
+{
+  if(airports.isEmpty())
+    return;
+
+  QVector<atools::fs::common::ProcedureRecords> records;
+  procWriter->convertAirports(airports, records, options.getReaderThreads());
+  airports.clear();
+
+  // Write all in original order
+  for(const atools::fs::common::ProcedureRecords& rec : qAsConst(records))
+    procWriter->writeRecords(rec);
 }
 
 } // namespace xp
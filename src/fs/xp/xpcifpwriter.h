@@ -19,6 +19,7 @@
 #define ATOOLS_FS_XP_CIFPWRITER_H
 
 #include "fs/xp/xpwriter.h"
+#include "fs/common/procedurewriter.h"
 
 #include "sql/sqlrecord.h"
 
@@ -43,6 +44,9 @@ namespace xp {
 
 /*
  * Reads a CIFP file and writes all approaches,transitons, SIDs and STARs into the database.
+ *
+ * Rows of each airport are collected and converted in worker threads in batches if more than one reader thread
+ * is configured. Call flush() after reading all files to write the remaining airports.
  */
 class XpCifpWriter :
   public atools::fs::xp::XpWriter
@@ -60,8 +64,19 @@ public:
   virtual void finish(const XpWriterContext& context) override;
   virtual void reset() override;
 
+  /* Convert and write all collected airports */
+  void flush();
+
 private:
+  /* Number of airports collected before procedures are converted and written */
+  static Q_DECL_CONSTEXPR int AIRPORT_BATCH_SIZE = 500;
+
   atools::fs::common::ProcedureWriter *procWriter = nullptr;
+
+  /* Rows of the current airport and finished airports waiting for conversion if parallel */
+  QVector<atools::fs::common::ProcedureInput> airportLines;
+  QVector<QVector<atools::fs::common::ProcedureInput> > airports;
+  bool parallel = false;
 };
 
 } // namespace xp
@@ -17,6 +17,7 @@
 
 #include "fs/xp/xpdatacompiler.h"
 
+#include "fs/compileprofiler.h"
 #include "fs/navdatabaseoptions.h"
 #include "fs/xp/xpfixwriter.h"
 #include "fs/xp/xpmorawriter.h"
@@ -27,6 +28,7 @@
 #include "fs/xp/xpairportwriter.h"
 #include "fs/xp/xpcifpwriter.h"
 #include "fs/xp/xpairspacewriter.h"
+#include "fs/xp/xplinetokenizer.h"
 #include "fs/xp/scenerypacks.h"
 #include "fs/common/magdecreader.h"
 #include "sql/sqldatabase.h"
@@ -40,12 +42,14 @@
 #include "fs/common/airportindex.h"
 #include "fs/common/metadatawriter.h"
 #include "fs/navdatabaseerrors.h"
+#include "io/filereadahead.h"
+#include "io/linereader.h"
+#include "util/tracing.h"
 
 #include <QFileInfo>
 #include <QDir>
 #include <QDebug>
 #include <QDateTime>
-#include <QElapsedTimer>
 #include <QRegularExpression>
 #include <QStandardPaths>
 #include <QTextCodec>
@@ -73,9 +77,6 @@ const static int NUM_REPORT_STEPS_SMALL = 100;
 
 const static int NUM_REPORT_STEPS_CIFP = 2000;
 
-/* Report progress twice a second */
-const static int MIN_PROGRESS_REPORT_MS = 500;
-
 // Check for correct CIFP file basenames
 const static QRegularExpression CIFP_MATCH("^[A-Z0-9]{3,8}$");
 
@@ -102,7 +103,7 @@ XpDataCompiler::XpDataCompiler(sql::SqlDatabase& sqlDb, const NavDatabaseOptions
   cifpWriter = new XpCifpWriter(db, airportIndex, options, progress, errors);
   airspaceWriter = new XpAirspaceWriter(db, options, progress, errors);
   airwayWriter = new XpAirwayWriter(db, options, progress, errors);
-  airwayPostProcess = new AirwayPostProcess(db);
+  airwayPostProcess = new AirwayPostProcess(db, options.getReaderThreads());
   metadataWriter = new MetadataWriter(db);
   magDecReader = new MagDecReader();
 
@@ -235,12 +236,10 @@ bool XpDataCompiler::compileCustomApt()
   // X-Plane 11/Custom Scenery/LFPG Paris - Charles de Gaulle/Earth Nav data/apt.dat
   QStringList aptDatFiles = findCustomAptDatFiles(buildPathNoCase({options.getBasepath(), "Custom Scenery"}),
                                                   options, errors, progress, true /* verbose */, false /* userInclude */);
-  for(const QString& aptdat : aptDatFiles)
-  {
-    // Only one progress report per file
-    if(readDataFile(aptdat, 1, airportWriter, IS_ADDON | READ_SHORT_REPORT, 1))
-      return true;
-  }
+  // Only one progress report per file
+  if(readDataFiles(aptDatFiles, 1, airportWriter, IS_ADDON | READ_SHORT_REPORT, 1))
+    return true;
+
   db.commit();
   return false;
 }
@@ -251,12 +250,10 @@ bool XpDataCompiler::compileUserIncludeApt()
   {
     // Find all apt.dat in the included folder
     QStringList aptDatFiles = findCustomAptDatFiles(path, options, errors, progress, true /* verbose */, true /* userInclude */);
-    for(const QString& aptdat : aptDatFiles)
-    {
-      // Only one progress report per file
-      if(readDataFile(aptdat, 1, airportWriter, IS_ADDON | READ_SHORT_REPORT, 1))
-        return true;
-    }
+
+    // Only one progress report per file
+    if(readDataFiles(aptDatFiles, 1, airportWriter, IS_ADDON | READ_SHORT_REPORT, 1))
+      return true;
   }
   db.commit();
   return false;
@@ -319,23 +316,29 @@ bool XpDataCompiler::compileCifp()
     static_cast<int>(std::ceil(static_cast<float>(cifpFiles.size()) / static_cast<float>(NUM_REPORT_STEPS_CIFP)));
   int row = 0, steps = 0;
 
-  for(const QString& file : cifpFiles)
+  // Filter before to avoid loading excluded files ahead
+  QStringList includedFiles;
+  for(const QString& file : qAsConst(cifpFiles))
   {
     if(options.isIncludedFilename(file))
+      includedFiles.append(file);
+  }
+
+  bool aborted = readDataFiles(includedFiles, 1, cifpWriter, READ_CIFP | READ_SHORT_REPORT, 0,
+                               [&row, &steps, rowsPerStep, this](const QString& file) -> bool {
+    if((row++ % rowsPerStep) == 0)
     {
-      if(readDataFile(file, 1, cifpWriter, READ_CIFP | READ_SHORT_REPORT, 0))
-        return true;
+      steps++;
+      return progress->reportOther(tr("Reading: %1").arg(atools::nativeCleanPath(file)));
+    }
+    return false;
+  });
 
-      if((row % rowsPerStep) == 0)
-      {
-        if(progress->reportOther(tr("Reading: %1").arg(atools::nativeCleanPath(file))))
-          return true;
+  if(aborted)
+    return true;
 
-        steps++;
-      }
-      row++;
-    }
-  }
+  // Write airports collected for parallel conversion
+  cifpWriter->flush();
 
   // Consume remaining progress steps
   progress->increaseCurrent(NUM_REPORT_STEPS_CIFP - steps);
@@ -411,18 +414,46 @@ bool XpDataCompiler::compileUserFix()
 
 bool XpDataCompiler::compileMagDeclBgl()
 {
-  magDecReader->readFromWmm();
+  if(options.getSharedMagDecReader() != nullptr)
+    magDecReader->copyFrom(*options.getSharedMagDecReader());
+  else
+    magDecReader->readFromWmm();
   magDecReader->writeToTable(db);
   db.commit();
   return false;
 }
 
+bool XpDataCompiler::readDataFiles(const QStringList& filepaths, int minColumns, XpWriter *writer,
+                                   atools::fs::xp::ContextFlags flags, int numReportSteps,
+                                   const std::function<bool(const QString& filepath)>& reportFunc)
+{
+  // Load the next files in background threads while the current one is parsed and written
+  atools::io::FileReadAhead readAhead(filepaths, options.getReaderThreads());
+  QByteArray content;
+
+  for(int i = 0; i < filepaths.size(); i++)
+  {
+    const QString& filepath = filepaths.at(i);
+
+    // Falls back to reading the file in openFile() if not loaded
+    bool loaded = readAhead.next(i, content);
+    if(readDataFile(filepath, minColumns, writer, flags, numReportSteps, loaded ? &content : nullptr))
+      return true;
+
+    if(reportFunc && reportFunc(filepath))
+      return true;
+  }
+  return false;
+}
+
 bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWriter *writer,
-                                  atools::fs::xp::ContextFlags flags, int numReportSteps)
+                                  atools::fs::xp::ContextFlags flags, int numReportSteps, const QByteArray *content)
 {
+  ATOOLS_TRACE_SPAN("compile", "XpDataCompiler::readDataFile");
+
   QFile file;
   QTextStream stream;
-  stream.setCodec("UTF-8");
+  atools::io::LineReader reader;
   bool aborted = false;
 
   QString progressMsg = tr("Reading: %1").arg(atools::nativeCleanPath(filepath));
@@ -440,8 +471,11 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
   try
   {
     // Open file and read header - throws exception on error
-    if(openFile(stream, file, filepath, flags, lineNum, totalNumLines, fileVersion))
+    if(openFile(stream, reader, file, content, filepath, flags, lineNum, totalNumLines, fileVersion))
     {
+      if(profiler != nullptr)
+        profiler->addBytesRead(content != nullptr && !flags.testFlag(READ_AIRSPACE) ? content->size() : file.size());
+
       XpWriterContext context;
       context.curFileId = curFileId;
       context.fileName = fileinfo.fileName();
@@ -479,12 +513,12 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
         context.cifpAirportId = airportIndex->getAirportId(context.cifpAirportIdent);
       }
 
+      // Line buffer and fields are reused for all lines
       QString line;
-      QStringList fields;
-
-      QElapsedTimer timer;
-      timer.start();
-      qint64 elapsed = timer.elapsed();
+      QByteArray bytes;
+      bool useStream = flags.testFlag(READ_AIRSPACE);
+      XpLineTokenizer tokenizer;
+      QStringList& fields = tokenizer.getFields();
 
       int rowsPerStep = 0;
 
@@ -494,22 +528,27 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
       int row = 0, steps = 0;
 
       // Read lines
-      while(!stream.atEnd() && line != "99")
+      while(!(useStream ? stream.atEnd() : reader.atEnd()) && line != "99")
       {
-        line = stream.readLine().trimmed();
+        if(useStream)
+          stream.readLineInto(&line);
+        else
+        {
+          // Convert to string without decoder for plain ASCII lines
+          reader.readLine(bytes);
+          atools::io::LineReader::toString(bytes, line);
+        }
+        line = std::move(line).trimmed();
 
         if(!flags.testFlag(READ_SHORT_REPORT) && numReportSteps > 0)
         {
           if((row++ % rowsPerStep) == 0)
           {
-            qint64 elapsed2 = timer.elapsed();
-
-            // Update only every 500 ms - otherwise update only progress count
-            bool silent = !(elapsed + MIN_PROGRESS_REPORT_MS < elapsed2);
-            if(!silent)
-              elapsed = elapsed2;
+            // Callback is throttled by the handler - otherwise update only progress count
             steps++;
-            if((aborted = progress->reportOther(progressMsg, -1, silent)) == true)
+            if((aborted = progress->reportProgress(1, [&progressMsg]() -> QString {
+                return progressMsg;
+              })) == true)
               break;
           }
         }
@@ -531,9 +570,9 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
         if(!line.isEmpty())
         {
           if(flags.testFlag(READ_CIFP))
-            fields = line.split(",");
+            tokenizer.tokenize(line, QLatin1Char(','));
           else
-            fields = line.simplified().split(" ");
+            tokenizer.tokenize(line);
 
           if(fields.size() >= minColumns)
           {
@@ -586,7 +625,8 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
   return aborted;
 }
 
-bool XpDataCompiler::openFile(QTextStream& stream, QFile& filepath, const QString& filename, atools::fs::xp::ContextFlags flags,
+bool XpDataCompiler::openFile(QTextStream& stream, atools::io::LineReader& reader, QFile& filepath,
+                              const QByteArray *content, const QString& filename, atools::fs::xp::ContextFlags flags,
                               int& lineNum, int& totalNumLines, int& fileVersion)
 {
   bool retval = false;
@@ -594,89 +634,95 @@ bool XpDataCompiler::openFile(QTextStream& stream, QFile& filepath, const QStrin
   filepath.setFileName(filename);
   lineNum = 1;
 
-  if(filepath.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(flags & READ_AIRSPACE)
   {
-    if(flags & READ_AIRSPACE)
-    {
-      // Try to detect code using the BOM for airspaces only - use ANSI as fallback
-      stream.setDevice(&filepath);
-      stream.setCodec(atools::codecForFile(filepath, QTextCodec::codecForName("Windows-1252")));
-    }
-    else
-    {
-      stream.setDevice(&filepath);
-      stream.setCodec("UTF-8");
-    }
-    stream.setAutoDetectUnicode(true);
+    if(!filepath.open(QIODevice::ReadOnly | QIODevice::Text))
+      throw atools::Exception("Cannot open file. Reason: " + filepath.errorString() + ".");
 
-    if(!(flags & READ_CIFP) && !(flags & READ_AIRSPACE))
-    {
-      // Read file header =============================
-      // Skip empty lines which can appear in some malformed add-on airport files
-      // Byte order identifier ===========
-      QString line;
-      do
-      {
-        line = stream.readLine().simplified();
-        lineNum++;
-      } while(line.isEmpty() && !stream.atEnd() && line != "99");
-      qInfo() << Q_FUNC_INFO << line;
+    // Try to detect code using the BOM for airspaces only - use ANSI as fallback
+    stream.setDevice(&filepath);
+    stream.setCodec(atools::codecForFile(filepath, QTextCodec::codecForName("Windows-1252")));
+    stream.setAutoDetectUnicode(true);
 
-      // Metadata and copyright ===========
-      do
-      {
-        line = stream.readLine().simplified();
-        lineNum++;
-      } while(line.isEmpty() && !stream.atEnd() && line != "99");
-      qInfo() << Q_FUNC_INFO << line;
+    metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
+    progress->incNumFiles();
+    return true;
+  }
 
-      QStringList fields = line.simplified().split(" ");
-      if(!fields.isEmpty())
-        fileVersion = fields.constFirst().toInt();
+  // UTF-8 files - read from memory if file was already loaded or map file
+  if(content != nullptr)
+    reader.setData(*content);
+  else if(!filepath.open(QIODevice::ReadOnly) || !reader.open(&filepath))
+    throw atools::Exception("Cannot open file. Reason: " + filepath.errorString() + ".");
 
-      if(!fields.isEmpty() && fileVersion < minFileVersion)
-      {
-        qWarning() << "Version of" << filename << "is" << fields.constFirst() << "but expected a minimum of" << minFileVersion;
-        throw atools::Exception(QString("Found file version %1. Minimum supported is %2.").arg(fields.constFirst()).arg(minFileVersion));
-      }
+  if(!(flags & READ_CIFP))
+  {
+    // Read file header =============================
+    // Skip empty lines which can appear in some malformed add-on airport files
+    // Byte order identifier ===========
+    QString line;
+    do
+    {
+      reader.readLine(line);
+      line = line.simplified();
+      lineNum++;
+    } while(line.isEmpty() && !reader.atEnd() && line != "99");
+    qInfo() << Q_FUNC_INFO << line;
+
+    // Metadata and copyright ===========
+    do
+    {
+      reader.readLine(line);
+      line = line.simplified();
+      lineNum++;
+    } while(line.isEmpty() && !reader.atEnd() && line != "99");
+    qInfo() << Q_FUNC_INFO << line;
 
-      metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
-      progress->incNumFiles();
-      retval = true;
+    QStringList fields = line.simplified().split(" ");
+    if(!fields.isEmpty())
+      fileVersion = fields.constFirst().toInt();
 
-      if(flags & UPDATE_CYCLE)
-        updateAiracCycleFromHeader(line, filename, lineNum);
+    if(!fields.isEmpty() && fileVersion < minFileVersion)
+    {
+      qWarning() << "Version of" << filename << "is" << fields.constFirst() << "but expected a minimum of" << minFileVersion;
+      throw atools::Exception(QString("Found file version %1. Minimum supported is %2.").arg(fields.constFirst()).arg(minFileVersion));
+    }
 
-      qInfo() << Q_FUNC_INFO << "Counting lines for" << filename;
-      qint64 pos = stream.pos();
-      int lines = 0;
-      while(!stream.atEnd())
-      {
-        line = stream.readLine();
-        if(line == "99")
-          break;
-        lines++;
-      }
+    metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
+    progress->incNumFiles();
+    retval = true;
 
-      if(lines == 0)
-      {
-        qWarning() << Q_FUNC_INFO << "Empty file" << filepath;
-        retval = false;
-      }
+    if(flags & UPDATE_CYCLE)
+      updateAiracCycleFromHeader(line, filename, lineNum);
 
-      totalNumLines = lines;
-      stream.seek(pos);
-      qInfo() << Q_FUNC_INFO << "Num lines" << lines;
+    // Count lines on raw bytes which avoids decoding the whole file twice
+    qInfo() << Q_FUNC_INFO << "Counting lines for" << filename;
+    qint64 pos = reader.getPos();
+    int lines = 0;
+    QByteArray bytes;
+    while(reader.readLine(bytes))
+    {
+      if(bytes == "99")
+        break;
+      lines++;
     }
-    else
+
+    if(lines == 0)
     {
-      metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
-      progress->incNumFiles();
-      retval = true;
+      qWarning() << Q_FUNC_INFO << "Empty file" << filepath;
+      retval = false;
     }
+
+    totalNumLines = lines;
+    reader.seek(pos);
+    qInfo() << Q_FUNC_INFO << "Num lines" << lines;
   }
   else
-    throw atools::Exception("Cannot open file. Reason: " + filepath.errorString() + ".");
+  {
+    metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
+    progress->incNumFiles();
+    retval = true;
+  }
 
   return retval;
 }
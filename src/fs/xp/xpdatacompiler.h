@@ -22,12 +22,19 @@
 
 #include <QCoreApplication>
 
+#include <functional>
+
+class QByteArray;
 class QTextStream;
 class QFile;
 class QFileInfo;
 
 namespace atools {
 
+namespace io {
+class LineReader;
+}
+
 namespace sql {
 class SqlDatabase;
 class SqlQuery;
@@ -37,6 +44,7 @@ namespace fs {
 class NavDatabaseOptions;
 class NavDatabaseErrors;
 class ProgressHandler;
+class CompileProfiler;
 
 namespace common {
 class MagDecReader;
@@ -242,17 +250,31 @@ public:
     return airacCycle;
   }
 
+  /* Reports bytes of all read files to the profiler if not null */
+  void setProfiler(atools::fs::CompileProfiler *value)
+  {
+    profiler = value;
+  }
+
 private:
   void initQueries();
   void deInitQueries();
 
-  /* Open file and read header */
-  bool openFile(QTextStream& stream, QFile& filepath, const QString& filename, ContextFlags flags,
-                int& lineNum, int& totalNumLines, int& fileVersion);
+  /* Open file and read header. Reads from content if not null.
+   * Airspaces are read using the text stream with codec detection. All other UTF-8 files use the reader. */
+  bool openFile(QTextStream& stream, atools::io::LineReader& reader, QFile& filepath, const QByteArray *content,
+                const QString& filename, ContextFlags flags, int& lineNum, int& totalNumLines, int& fileVersion);
 
-  /* Read file line by line and call writer for each one */
+  /* Read file line by line and call writer for each one.
+   * content is the already loaded file if not null. Not supported for airspaces. */
   bool readDataFile(const QString& filepath, int minColumns, atools::fs::xp::XpWriter *writer,
-                    atools::fs::xp::ContextFlags flags, int numReportSteps);
+                    atools::fs::xp::ContextFlags flags, int numReportSteps, const QByteArray *content = nullptr);
+
+  /* Read all files in list using one writer. Loads files ahead in background threads if enabled in options.
+   * Calls reportFunc after each file if given. Returns true if aborted. */
+  bool readDataFiles(const QStringList& filepaths, int minColumns, atools::fs::xp::XpWriter *writer,
+                     atools::fs::xp::ContextFlags flags, int numReportSteps,
+                     const std::function<bool(const QString& filepath)>& reportFunc = nullptr);
   static QString buildBasePath(const NavDatabaseOptions& opts, const QString& filename);
 
   /* FInd custom apt.dat like X-Plane 11/Custom Scenery/LFPG Paris - Charles de Gaulle/Earth Nav data/apt.dat */
@@ -305,6 +327,7 @@ private:
   atools::fs::common::AirportIndex *airportIndex = nullptr;
   atools::fs::common::MagDecReader *magDecReader = nullptr;
   atools::fs::common::MetadataWriter *metadataWriter = nullptr;
+  atools::fs::CompileProfiler *profiler = nullptr;
 
   int minFileVersion = 850;
   atools::fs::NavDatabaseErrors *errors = nullptr;
@@ -0,0 +1,104 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/xp/xplinetokenizer.h"
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+const QStringList& XpLineTokenizer::tokenize(const QString& line)
+{
+  numFields = 0;
+  const QChar *data = line.constData();
+  int size = line.size(), start = -1;
+
+  for(int i = 0; i < size; i++)
+  {
+    if(data[i].isSpace())
+    {
+      if(start != -1)
+      {
+        addField(data + start, i - start);
+        start = -1;
+      }
+    }
+    else if(start == -1)
+      start = i;
+  }
+
+  if(start != -1)
+    addField(data + start, size - start);
+
+  finishLine();
+  return fields;
+}
+
+const QStringList& XpLineTokenizer::tokenize(const QString& line, QChar separator)
+{
+  numFields = 0;
+  const QChar *data = line.constData();
+  int size = line.size(), start = 0;
+
+  for(int i = 0; i < size; i++)
+  {
+    if(data[i] == separator)
+    {
+      addField(data + start, i - start);
+      start = i + 1;
+    }
+  }
+  addField(data + start, size - start);
+
+  finishLine();
+  return fields;
+}
+
+void XpLineTokenizer::addField(const QChar *str, int length)
+{
+  if(numFields < fields.size())
+  {
+    QString& field = fields[numFields];
+    if(length > 0)
+      // Copies into existing buffer if not shared and large enough
+      field.setUnicode(str, length);
+    else
+      // Empty but not null like split()
+      field = QString(0, Qt::Uninitialized);
+  }
+  else if(!spare.isEmpty())
+  {
+    QString field = spare.takeLast();
+    field.setUnicode(str, length);
+    fields.append(field);
+  }
+  else
+    fields.append(QString(str, length));
+
+  numFields++;
+}
+
+void XpLineTokenizer::finishLine()
+{
+  while(fields.size() > numFields)
+    spare.append(fields.takeLast());
+}
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
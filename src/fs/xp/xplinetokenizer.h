@@ -0,0 +1,68 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_XP_XPLINETOKENIZER_H
+#define ATOOLS_FS_XP_XPLINETOKENIZER_H
+
+#include <QStringList>
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+/*
+ * Splits lines of X-Plane dat and CIFP files into fields.
+ *
+ * Reuses the field list and the character buffers of the field strings from previous lines. This avoids
+ * allocating a new list and new strings for each of the millions of lines in apt.dat.
+ * Fields which are kept by a writer are detached automatically by the implicit sharing of QString.
+ *
+ * The returned list is valid until the next call.
+ */
+class XpLineTokenizer
+{
+public:
+  /* Split at any whitespace and ignore leading, trailing and repeated whitespace.
+   * Same result as line.simplified().split(" ") for non-empty lines. */
+  const QStringList& tokenize(const QString& line);
+
+  /* Split at separator and keep empty fields. Same as line.split(separator). */
+  const QStringList& tokenize(const QString& line, QChar separator);
+
+  /* Fields of the last tokenized line */
+  QStringList& getFields()
+  {
+    return fields;
+  }
+
+private:
+  /* Set field at numFields and increment number */
+  void addField(const QChar *str, int length);
+
+  /* Remove unused fields from last line and keep their strings for reuse */
+  void finishLine();
+
+  QStringList fields, spare;
+  int numFields = 0;
+};
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_XP_XPLINETOKENIZER_H
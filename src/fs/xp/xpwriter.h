@@ -90,8 +90,26 @@ protected:
 
   QString mid(const QStringList& line, int index, bool ignoreError = false)
   {
-    if(index < line.size())
-      return line.mid(index).join(" ");
+    if(index == line.size() - 1)
+      // Avoid copying a single field
+      return line.at(index);
+    else if(index < line.size())
+    {
+      // Join without creating an intermediate list
+      int size = line.size() - index - 1;
+      for(int i = index; i < line.size(); i++)
+        size += line.at(i).size();
+
+      QString str;
+      str.reserve(size);
+      for(int i = index; i < line.size(); i++)
+      {
+        if(i > index)
+          str.append(QLatin1Char(' '));
+        str.append(line.at(i));
+      }
+      return str;
+    }
     else if(!ignoreError)
       // Have to stop reading the file since the rest can be corrupted
       throw atools::Exception(ctx->messagePrefix() + QString(": Index out of bounds: Index: %1, size: %2").arg(index).arg(line.size()));
@@ -24,6 +24,8 @@
 #include <QPointF>
 #include <QRect>
 
+#include <vector>
+
 namespace atools {
 
 namespace geo {
@@ -168,14 +170,14 @@ void calcArcLength(const atools::geo::Line& line, const atools::geo::Pos& center
   }
 }
 
-Rect boundingRect(const QList<Pos>& positions)
+Rect boundingRect(const QVector<Pos>& positions)
 {
   Rect rect;
   boundingRect(rect, positions);
   return rect;
 }
 
-void boundingRect(Rect& rect, QList<atools::geo::Pos> positions)
+void boundingRect(Rect& rect, QVector<atools::geo::Pos> positions)
 {
   // Remove all invalid positions
   auto iter = std::remove_if(positions.begin(), positions.end(), [](const atools::geo::Pos& p) -> bool
@@ -780,5 +782,164 @@ bool isEastCourse(float lonx1, float lonx2)
     return lonx1 < lonx2;
 }
 
+
+/* Latitude sine and cosine and longitude in radians in separate arrays */
+struct LatLonArrays
+{
+  explicit LatLonArrays(const QVector<Pos>& positions)
+  {
+    int size = positions.size();
+    lonRad.resize(static_cast<size_t>(size));
+    latRad.resize(static_cast<size_t>(size));
+    sinLat.resize(static_cast<size_t>(size));
+    cosLat.resize(static_cast<size_t>(size));
+
+    const Pos *pos = positions.constData();
+    for(int i = 0; i < size; i++)
+    {
+      lonRad[static_cast<size_t>(i)] = toRadians(static_cast<double>(pos[i].getLonX()));
+      latRad[static_cast<size_t>(i)] = toRadians(static_cast<double>(pos[i].getLatY()));
+    }
+
+    for(size_t i = 0; i < static_cast<size_t>(size); i++)
+    {
+      sinLat[i] = sin(latRad[i]);
+      cosLat[i] = cos(latRad[i]);
+    }
+  }
+
+  std::vector<double> lonRad, latRad, sinLat, cosLat;
+};
+
+/* Haversine distance in meter using precalculated latitude cosines */
+inline static float distanceMeterPrecalc(double lon1, double lat1, double cosLat1, double lon2, double lat2,
+                                          double cosLat2)
+{
+  double l1 = sin((lat1 - lat2) / 2.);
+  double l2 = sin((lon1 - lon2) / 2.);
+  return static_cast<float>(2. * asin(sqrt(l1 * l1 + cosLat1 * cosLat2 * l2 * l2)) * Pos::EARTH_RADIUS_METER_DOUBLE);
+}
+
+void distancesMeter(QVector<float>& distances, const QVector<Pos>& positions)
+{
+  distances.clear();
+  int size = positions.size();
+  if(size < 2)
+    return;
+
+  LatLonArrays arr(positions);
+  distances.resize(size - 1);
+  float *dist = distances.data();
+  const Pos *pos = positions.constData();
+
+  for(int i = 0; i < size - 1; i++)
+  {
+    size_t i1 = static_cast<size_t>(i), i2 = static_cast<size_t>(i + 1);
+    if(!pos[i].isValid() || !pos[i + 1].isValid())
+      dist[i] = INVALID_FLOAT;
+    else if(pos[i] == pos[i + 1])
+      dist[i] = 0.f;
+    else
+      dist[i] = distanceMeterPrecalc(arr.lonRad[i1], arr.latRad[i1], arr.cosLat[i1],
+                                     arr.lonRad[i2], arr.latRad[i2], arr.cosLat[i2]);
+  }
+}
+
+void distancesMeter(QVector<float>& distances, const Pos& origin, const QVector<Pos>& positions)
+{
+  distances.clear();
+  int size = positions.size();
+  if(size < 1)
+    return;
+
+  distances.fill(INVALID_FLOAT, size);
+  if(!origin.isValid())
+    return;
+
+  LatLonArrays arr(positions);
+  double lonOrig = toRadians(static_cast<double>(origin.getLonX())),
+         latOrig = toRadians(static_cast<double>(origin.getLatY())), cosLatOrig = cos(latOrig);
+  float *dist = distances.data();
+  const Pos *pos = positions.constData();
+
+  for(int i = 0; i < size; i++)
+  {
+    size_t idx = static_cast<size_t>(i);
+    if(!pos[i].isValid())
+      continue;
+    else if(pos[i] == origin)
+      dist[i] = 0.f;
+    else
+      dist[i] = distanceMeterPrecalc(lonOrig, latOrig, cosLatOrig, arr.lonRad[idx], arr.latRad[idx], arr.cosLat[idx]);
+  }
+}
+
+void coursesDeg(QVector<float>& courses, const QVector<Pos>& positions)
+{
+  courses.clear();
+  int size = positions.size();
+  if(size < 2)
+    return;
+
+  LatLonArrays arr(positions);
+  courses.resize(size - 1);
+  float *course = courses.data();
+  const Pos *pos = positions.constData();
+
+  for(int i = 0; i < size - 1; i++)
+  {
+    size_t i1 = static_cast<size_t>(i), i2 = static_cast<size_t>(i + 1);
+    if(!pos[i].isValid() || !pos[i + 1].isValid() || pos[i] == pos[i + 1])
+      course[i] = INVALID_FLOAT;
+    else
+    {
+      // Same as Pos::courseRad() but with precalculated latitude values
+      double dlon = arr.lonRad[i2] - arr.lonRad[i1];
+      double val = atan2(sin(dlon) * arr.cosLat[i2],
+                         arr.cosLat[i1] * arr.sinLat[i2] - arr.sinLat[i1] * arr.cosLat[i2] * cos(dlon));
+      course[i] = static_cast<float>(normalizeCourse(toDegree(std::fmod(val + M_PI * 2., M_PI * 2.))));
+    }
+  }
+}
+
+void interpolatePoints(QVector<Pos>& positions, const Pos& from, const Pos& to, float distanceMeter, int numPoints)
+{
+  if(!from.isValid() || !to.isValid() || from == to || numPoints <= 0)
+    return;
+
+  // Cartesian coordinates of both end points are calculated only once
+  double lon1 = toRadians(static_cast<double>(from.getLonX())), lat1 = toRadians(static_cast<double>(from.getLatY()));
+  double lon2 = toRadians(static_cast<double>(to.getLonX())), lat2 = toRadians(static_cast<double>(to.getLatY()));
+  double x1 = cos(lat1) * cos(lon1), y1 = cos(lat1) * sin(lon1), z1 = sin(lat1);
+  double x2 = cos(lat2) * cos(lon2), y2 = cos(lat2) * sin(lon2), z2 = sin(lat2);
+
+  double distanceRad = nmToRad(meterToNm(static_cast<double>(distanceMeter)));
+  double sinDistance = sin(distanceRad);
+  double step = 1. / numPoints;
+  float altitude = from.getAltitude();
+
+  int offset = positions.size();
+  positions.resize(offset + numPoints);
+  Pos *result = positions.data() + offset;
+
+  result[0] = from;
+  for(int j = 1; j < numPoints; j++)
+  {
+    // Use float step as in Pos::interpolatePoints() to get identical fractions
+    double fraction = static_cast<float>(step) * static_cast<float>(j);
+    if(fraction >= 1.)
+    {
+      result[j] = Pos(to).alt(altitude);
+      continue;
+    }
+
+    double a = sin((1. - fraction) * distanceRad) / sinDistance;
+    double b = sin(fraction * distanceRad) / sinDistance;
+    double x = a * x1 + b * x2, y = a * y1 + b * y2, z = a * z1 + b * z2;
+
+    result[j] = Pos(atan2(y, x), atan2(z, sqrt(x * x + y * y))).toDeg().normalize().alt(altitude);
+  }
+}
+
 } // namespace geo
 } // namespace atools
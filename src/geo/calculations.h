@@ -25,6 +25,7 @@
 
 #include <QLineF>
 #include <QString>
+#include <QVector>
 
 namespace atools {
 namespace geo {
@@ -82,8 +83,8 @@ void calcArcLength(const atools::geo::Line& line, const atools::geo::Pos& center
 
 /* Calculate a bounding rectangle for a list of positions. Also around the anti meridian which can
  * mean that left > right */
-void boundingRect(atools::geo::Rect& rect, QList<Pos> positions);
-atools::geo::Rect boundingRect(const QList<Pos>& positions);
+void boundingRect(atools::geo::Rect& rect, QVector<Pos> positions);
+atools::geo::Rect boundingRect(const QVector<Pos>& positions);
 
 /* true if longitude values cross the anti-meridian independent of direction but unreliable for large rectangles. */
 bool crossesAntiMeridian(float lonx1, float lonx2);
@@ -91,6 +92,27 @@ bool crossesAntiMeridian(float lonx1, float lonx2);
 bool isWestCourse(float lonx1, float lonx2);
 bool isEastCourse(float lonx1, float lonx2);
 
+/* Batch great circle calculations for whole position arrays ====================================================
+ * Give the same results as the respective Pos methods but calculate sine and cosine of each latitude only once
+ * and work on plain arrays which allows the compiler to vectorize the arithmetic parts. */
+
+/* Great circle distance in meter between consecutive positions. distances will contain size - 1 values.
+ * INVALID_FLOAT for invalid positions. */
+void distancesMeter(QVector<float>& distances, const QVector<atools::geo::Pos>& positions);
+
+/* Great circle distance in meter from origin to all positions */
+void distancesMeter(QVector<float>& distances, const atools::geo::Pos& origin,
+                    const QVector<atools::geo::Pos>& positions);
+
+/* Initial great circle course in degree true between consecutive positions. courses will contain size - 1 values.
+ * INVALID_FLOAT for invalid or equal positions. */
+void coursesDeg(QVector<float>& courses, const QVector<atools::geo::Pos>& positions);
+
+/* Append numPoints great circle points from "from" towards "to" at equal fractions.
+ * First point is "from" and "to" is not included. Same as Pos::interpolatePoints(). Altitude of "from" is used. */
+void interpolatePoints(QVector<atools::geo::Pos>& positions, const atools::geo::Pos& from,
+                       const atools::geo::Pos& to, float distanceMeter, int numPoints);
+
 /* Degree to rad */
 template<typename TYPE>
 constexpr TYPE toRadians(TYPE deg)
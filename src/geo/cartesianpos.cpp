@@ -0,0 +1,69 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "geo/cartesianpos.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace atools {
+namespace geo {
+
+Q_DECL_CONSTEXPR float CartesianPos::EARTH_RADIUS_METER;
+
+CartesianPos::CartesianPos(const Pos& position)
+  : pos(position)
+{
+  if(pos.isValid())
+  {
+    double xx, yy, zz;
+    pos.toCartesian(xx, yy, zz);
+    x = static_cast<float>(xx / Pos::EARTH_RADIUS_METER_DOUBLE);
+    y = static_cast<float>(yy / Pos::EARTH_RADIUS_METER_DOUBLE);
+    z = static_cast<float>(zz / Pos::EARTH_RADIUS_METER_DOUBLE);
+  }
+  else
+    x = y = z = 0.f;
+}
+
+float CartesianPos::distanceMeterTo(const CartesianPos& other) const
+{
+  if(!isValid() || !other.isValid())
+    return Pos::INVALID_VALUE;
+
+  return distanceForChordSquared(chordSquared(other));
+}
+
+float CartesianPos::chordSquaredForDistance(float distanceMeter)
+{
+  // Chord for central angle is 2 * sin(angle / 2) - everything beyond the antipode is covered by 4
+  double angle = static_cast<double>(distanceMeter) / Pos::EARTH_RADIUS_METER_DOUBLE;
+  if(angle >= M_PI)
+    return 4.f;
+
+  double chord = 2. * std::sin(angle / 2.);
+  return static_cast<float>(chord * chord);
+}
+
+float CartesianPos::distanceForChordSquared(float chordSquared)
+{
+  return static_cast<float>(2. * std::asin(std::min(1., std::sqrt(static_cast<double>(chordSquared)) / 2.)) *
+                            Pos::EARTH_RADIUS_METER_DOUBLE);
+}
+
+} // namespace geo
+} // namespace atools
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GEO_CARTESIANPOS_H
+#define ATOOLS_GEO_CARTESIANPOS_H
+
+#include "geo/pos.h"
+#include "geo/point3d.h"
+
+namespace atools {
+namespace geo {
+
+/*
+ * Position which keeps a precalculated unit sphere vector alongside the coordinates.
+ *
+ * Use this for objects which are stored once and compared often in inner loops.
+ * Distance checks are reduced to a squared chord length which needs only a few multiplications.
+ * Chord length is used instead of dot product since it keeps float precision for short distances.
+ */
+class CartesianPos
+{
+public:
+  CartesianPos()
+    : x(0.f), y(0.f), z(0.f)
+  {
+  }
+
+  explicit CartesianPos(const atools::geo::Pos& position);
+
+  /* Position given in constructor */
+  const atools::geo::Pos& getPos() const
+  {
+    return pos;
+  }
+
+  bool isValid() const
+  {
+    return pos.isValid();
+  }
+
+  /* Dot product of unit vectors which is the cosine of the central angle */
+  float dot(const CartesianPos& other) const
+  {
+    return x * other.x + y * other.y + z * other.z;
+  }
+
+  /* Squared chord length on the unit sphere. Comparable value for distances. */
+  float chordSquared(const CartesianPos& other) const
+  {
+    float xdiff = other.x - x, ydiff = other.y - y, zdiff = other.z - z;
+    return xdiff * xdiff + ydiff * ydiff + zdiff * zdiff;
+  }
+
+  /* true if great circle distance to other is below the distance used to calculate maxChordSquared.
+   * Use chordSquaredForDistance() to get the value once before loops. */
+  bool isWithinChord(const CartesianPos& other, float maxChordSquared) const
+  {
+    return chordSquared(other) <= maxChordSquared;
+  }
+
+  /* Great circle distance in meter. Invalid value if any position is not valid. */
+  float distanceMeterTo(const CartesianPos& other) const;
+
+  /* Point in meter as used by the spatial index */
+  atools::geo::Point3D toPoint3D() const
+  {
+    return atools::geo::Point3D(x * EARTH_RADIUS_METER, y * EARTH_RADIUS_METER, z * EARTH_RADIUS_METER);
+  }
+
+  /* Convert great circle distance in meter to squared chord length for comparison with chordSquared() */
+  static float chordSquaredForDistance(float distanceMeter);
+
+  /* Convert squared chord length to great circle distance in meter */
+  static float distanceForChordSquared(float chordSquared);
+
+private:
+  Q_DECL_CONSTEXPR static float EARTH_RADIUS_METER = 6371.f * 1000.f;
+
+  atools::geo::Pos pos;
+  float x, y, z;
+};
+
+} // namespace geo
+} // namespace atools
+
+Q_DECLARE_TYPEINFO(atools::geo::CartesianPos, Q_PRIMITIVE_TYPE);
+
+#endif // ATOOLS_GEO_CARTESIANPOS_H
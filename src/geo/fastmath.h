@@ -0,0 +1,194 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GEO_FASTMATH_H
+#define ATOOLS_GEO_FASTMATH_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace atools {
+namespace geo {
+
+/*
+ * Math policies for the templated geo primitives below.
+ *
+ * PreciseMath uses the double precision standard library functions and is the default.
+ * FastMath uses single precision polynomial approximations without calls into the math library.
+ * Absolute errors are below 1e-6 for sin and cos and about 2e-6 radians for atan2 and asin which results in
+ * distance errors of up to about 25 meter. Use it only for indexing and display where this is acceptable.
+ */
+struct PreciseMath
+{
+  typedef double REAL;
+
+  static double sin(double rad)
+  {
+    return std::sin(rad);
+  }
+
+  static double cos(double rad)
+  {
+    return std::cos(rad);
+  }
+
+  static void sinCos(double rad, double& sinValue, double& cosValue)
+  {
+    sinValue = std::sin(rad);
+    cosValue = std::cos(rad);
+  }
+
+  static double atan2(double y, double x)
+  {
+    return std::atan2(y, x);
+  }
+
+  static double asin(double value)
+  {
+    return std::asin(value);
+  }
+};
+
+struct FastMath
+{
+  typedef float REAL;
+
+  static float sin(float rad)
+  {
+    float s, c;
+    sinCos(rad, s, c);
+    return s;
+  }
+
+  static float cos(float rad)
+  {
+    float s, c;
+    sinCos(rad, s, c);
+    return c;
+  }
+
+  /* Range reduction to -pi/4 to pi/4 and Taylor polynomials on the reduced range */
+  static void sinCos(float rad, float& sinValue, float& cosValue)
+  {
+    // Split pi/2 into two parts to keep precision while reducing
+    const float TWO_BY_PI = 0.636619772f, PI_2_HI = 1.57079625f, PI_2_LO = 7.54978995e-8f;
+
+    float quadrant = std::nearbyint(rad * TWO_BY_PI);
+    float r = (rad - quadrant * PI_2_HI) - quadrant * PI_2_LO;
+    float r2 = r * r;
+
+    float s = r * (1.f + r2 * (-1.f / 6.f + r2 * (1.f / 120.f + r2 * (-1.f / 5040.f))));
+    float c = 1.f + r2 * (-0.5f + r2 * (1.f / 24.f + r2 * (-1.f / 720.f + r2 * (1.f / 40320.f))));
+
+    switch(static_cast<int>(quadrant) & 3)
+    {
+      case 0:
+        sinValue = s;
+        cosValue = c;
+        break;
+      case 1:
+        sinValue = c;
+        cosValue = -s;
+        break;
+      case 2:
+        sinValue = -s;
+        cosValue = -c;
+        break;
+      case 3:
+        sinValue = -c;
+        cosValue = s;
+        break;
+    }
+  }
+
+  /* Polynomial for atan on 0 to 1 and octant mapping */
+  static float atan2(float y, float x)
+  {
+    const float PI = 3.14159265f, PI_2 = 1.57079633f;
+
+    float absX = std::abs(x), absY = std::abs(y);
+    if(absX == 0.f && absY == 0.f)
+      return 0.f;
+
+    bool swap = absY > absX;
+    float t = swap ? absX / absY : absY / absX;
+    float t2 = t * t;
+    float a = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f +
+                                                                                  t2 * (0.05265332f + t2 * -0.01172120f)))));
+    if(swap)
+      a = PI_2 - a;
+    if(x < 0.f)
+      a = PI - a;
+    return y < 0.f ? -a : a;
+  }
+
+  static float asin(float value)
+  {
+    return atan2(value, std::sqrt(std::max(0.f, 1.f - value * value)));
+  }
+};
+
+/* Great circle distance in meter using the haversine formula. Coordinates in degree. */
+template<typename MATH = PreciseMath>
+inline float distanceMeter(float lonX1, float latY1, float lonX2, float latY2)
+{
+  typedef typename MATH::REAL REAL;
+  const REAL TO_RAD = static_cast<REAL>(0.017453292519943295), RADIUS = static_cast<REAL>(6371. * 1000.);
+
+  REAL lat1 = static_cast<REAL>(latY1) * TO_RAD, lat2 = static_cast<REAL>(latY2) * TO_RAD;
+  REAL l1 = MATH::sin((lat1 - lat2) / 2);
+  REAL l2 = MATH::sin((static_cast<REAL>(lonX1) - static_cast<REAL>(lonX2)) * TO_RAD / 2);
+  REAL h = l1 * l1 + MATH::cos(lat1) * MATH::cos(lat2) * l2 * l2;
+  return static_cast<float>(2 * MATH::asin(std::sqrt(std::min(static_cast<REAL>(1), h))) * RADIUS);
+}
+
+/* Initial great circle course in degree true 0 to 360. Coordinates in degree. */
+template<typename MATH = PreciseMath>
+inline float courseDeg(float lonX1, float latY1, float lonX2, float latY2)
+{
+  typedef typename MATH::REAL REAL;
+  const REAL TO_RAD = static_cast<REAL>(0.017453292519943295), TO_DEG = static_cast<REAL>(57.29577951308232);
+
+  REAL sinLat1, cosLat1, sinLat2, cosLat2, sinDlon, cosDlon;
+  MATH::sinCos(static_cast<REAL>(latY1) * TO_RAD, sinLat1, cosLat1);
+  MATH::sinCos(static_cast<REAL>(latY2) * TO_RAD, sinLat2, cosLat2);
+  MATH::sinCos((static_cast<REAL>(lonX2) - static_cast<REAL>(lonX1)) * TO_RAD, sinDlon, cosDlon);
+
+  REAL course = MATH::atan2(sinDlon * cosLat2, cosLat1 * sinLat2 - sinLat1 * cosLat2 * cosDlon) * TO_DEG;
+  return static_cast<float>(course < 0 ? course + 360 : course);
+}
+
+/* Convert coordinates in degree to cartesian coordinates in meter. Same axes as Pos::toCartesian(). */
+template<typename MATH = PreciseMath>
+inline void toCartesian(float lonX, float latY, float& x, float& y, float& z)
+{
+  typedef typename MATH::REAL REAL;
+  const REAL TO_RAD = static_cast<REAL>(0.017453292519943295), RADIUS = static_cast<REAL>(6371. * 1000.);
+
+  REAL sinLat, cosLat, sinLon, cosLon;
+  MATH::sinCos(static_cast<REAL>(latY) * TO_RAD, sinLat, cosLat);
+  MATH::sinCos(static_cast<REAL>(lonX) * TO_RAD, sinLon, cosLon);
+
+  x = static_cast<float>(RADIUS * cosLat * cosLon);
+  y = static_cast<float>(RADIUS * cosLat * sinLon);
+  z = static_cast<float>(RADIUS * sinLat);
+}
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_FASTMATH_H
@@ -19,9 +19,11 @@
 #include "geo/calculations.h"
 
 #include "geo/line.h"
+#include "util/heap.h"
 
 #include <QDataStream>
 #include <cmath>
+#include <algorithm>
 
 namespace atools {
 namespace geo {
@@ -46,6 +48,45 @@ LineString::LineString(const Pos& origin, float radiusMeter, int numSegments)
     append(origin.endpoint(radiusMeter, j));
 }
 
+Q_DECL_CONSTEXPR float LineString::ARC_MAX_ERROR_METER;
+Q_DECL_CONSTEXPR int LineString::ARC_MIN_SEGMENTS;
+Q_DECL_CONSTEXPR int LineString::ARC_MAX_SEGMENTS;
+
+int LineString::segmentsForRadius(float radiusMeter, float maxErrorMeter, int minSegments, int maxSegments)
+{
+  // Divisors of 360 giving whole degree steps for the circle constructor
+  static const int SEGMENTS[] = {4, 6, 8, 9, 10, 12, 15, 18, 20, 24, 30, 36, 40, 45, 60, 72, 90, 120, 180, 360};
+
+  int segments = minSegments;
+  if(maxErrorMeter > 0.f && radiusMeter > maxErrorMeter)
+  {
+    // Sagitta e = r * (1 - cos(step / 2)) solved for the angle step
+    double step = 2. * std::acos(1. - static_cast<double>(maxErrorMeter) / static_cast<double>(radiusMeter));
+    if(step > 0.)
+      segments = static_cast<int>(std::ceil(2. * M_PI / step));
+    else
+      segments = maxSegments;
+  }
+  segments = std::max(minSegments, std::min(segments, maxSegments));
+
+  for(int s : SEGMENTS)
+  {
+    if(s >= segments)
+      return std::min(s, maxSegments);
+  }
+  return maxSegments;
+}
+
+LineString LineString::circle(const Pos& origin, float radiusMeter, float maxErrorMeter)
+{
+  return LineString(origin, radiusMeter, segmentsForRadius(radiusMeter, maxErrorMeter));
+}
+
+LineString LineString::arc(const Pos& origin, const Pos& start, const Pos& end, bool clockwise, float maxErrorMeter)
+{
+  return LineString(origin, start, end, clockwise, segmentsForRadius(origin.distanceMeterTo(start), maxErrorMeter));
+}
+
 LineString::LineString(const Pos& origin, const Pos& start, const Pos& end, bool clockwise, int numSegments)
 {
   float distance = origin.distanceMeterTo(start);
@@ -146,6 +187,141 @@ void LineString::removeDuplicates()
   removeDuplicates(std::numeric_limits<float>::epsilon());
 }
 
+/* Project positions to a plane in meter using sinusoidal projection around the first position */
+static void projectToPlane(const LineString& line, QVector<double>& x, QVector<double>& y)
+{
+  const double METER_PER_DEGREE = EARTH_CIRCUMFERENCE_METER / 360.;
+  double refLonX = line.constFirst().getLonX();
+
+  x.resize(line.size());
+  y.resize(line.size());
+  for(int i = 0; i < line.size(); i++)
+  {
+    const Pos& pos = line.at(i);
+    double lat = static_cast<double>(pos.getLatY());
+    x[i] = normalizeLonXDeg(static_cast<double>(pos.getLonX()) - refLonX) * std::cos(toRadians(lat)) * METER_PER_DEGREE;
+    y[i] = lat * METER_PER_DEGREE;
+  }
+}
+
+void LineString::simplifyDouglasPeucker(float toleranceMeter)
+{
+  if(size() < 3 || !(toleranceMeter > 0.f))
+    return;
+
+  QVector<double> x, y;
+  projectToPlane(*this, x, y);
+
+  QVector<bool> keep(size(), false);
+  keep[0] = keep[size() - 1] = true;
+
+  double toleranceSq = static_cast<double>(toleranceMeter) * static_cast<double>(toleranceMeter);
+
+  // Use stack instead of recursion to avoid overflow for large tracks
+  QVector<std::pair<int, int> > stack;
+  stack.append(std::make_pair(0, size() - 1));
+  while(!stack.isEmpty())
+  {
+    std::pair<int, int> range = stack.takeLast();
+    int first = range.first, last = range.second;
+
+    double dx = x.at(last) - x.at(first), dy = y.at(last) - y.at(first);
+    double lengthSq = dx * dx + dy * dy;
+
+    // Find point with the largest squared distance to the segment
+    double maxDistSq = 0.;
+    int maxIndex = -1;
+    for(int i = first + 1; i < last; i++)
+    {
+      double px = x.at(i) - x.at(first), py = y.at(i) - y.at(first), distSq;
+      if(lengthSq > 0.)
+      {
+        double cross = px * dy - py * dx;
+        distSq = cross * cross / lengthSq;
+      }
+      else
+        // First and last are equal for closed polygons
+        distSq = px * px + py * py;
+
+      if(distSq > maxDistSq)
+      {
+        maxDistSq = distSq;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1 && maxDistSq > toleranceSq)
+    {
+      keep[maxIndex] = true;
+      stack.append(std::make_pair(first, maxIndex));
+      stack.append(std::make_pair(maxIndex, last));
+    }
+  }
+
+  int dst = 0;
+  for(int i = 0; i < size(); i++)
+  {
+    if(keep.at(i))
+      (*this)[dst++] = at(i);
+  }
+  resize(dst);
+}
+
+void LineString::simplifyVisvalingam(float minAreaSqMeter)
+{
+  if(size() < 3 || !(minAreaSqMeter > 0.f))
+    return;
+
+  QVector<double> x, y;
+  projectToPlane(*this, x, y);
+
+  int num = size();
+
+  // Double linked list of remaining points
+  QVector<int> prev(num), next(num);
+  for(int i = 0; i < num; i++)
+  {
+    prev[i] = i - 1;
+    next[i] = i + 1;
+  }
+
+  auto area = [&x, &y](int p1, int p2, int p3) -> float {
+                return static_cast<float>(std::abs((x.at(p2) - x.at(p1)) * (y.at(p3) - y.at(p1)) -
+                                                   (x.at(p3) - x.at(p1)) * (y.at(p2) - y.at(p1))) / 2.);
+              };
+
+  atools::util::IndexedHeap<float> heap;
+  heap.resize(num);
+  for(int i = 1; i < num - 1; i++)
+    heap.push(i, area(i - 1, i, i + 1));
+
+  QVector<bool> removed(num, false);
+  while(!heap.isEmpty() && heap.topCost() < minAreaSqMeter)
+  {
+    int index;
+    float removedArea = heap.pop(index);
+    removed[index] = true;
+
+    int p = prev.at(index), n = next.at(index);
+    next[p] = n;
+    prev[n] = p;
+
+    // Update neighbours - area of a point is never smaller than the one of an already removed point
+    if(p > 0)
+      heap.change(p, std::max(removedArea, area(prev.at(p), p, n)));
+    if(n < num - 1)
+      heap.change(n, std::max(removedArea, area(p, n, next.at(n))));
+  }
+
+  int dst = 0;
+  for(int i = 0; i < num; i++)
+  {
+    if(!removed.at(i))
+      (*this)[dst++] = at(i);
+  }
+  resize(dst);
+}
+
 void LineString::distanceMeterToLineString(const Pos& pos, LineDistance& result,
                                            LineDistance *closestLineResult, int *index, const atools::geo::Rect *screenRect) const
 {
@@ -430,12 +606,16 @@ QDataStream& operator>>(QDataStream& in, LineString& obj)
 {
   quint32 size;
   in >> size;
+
+  // Read directly into contiguous storage allocated once
+  int offset = obj.size();
+  obj.resize(offset + static_cast<int>(size));
+  Pos *data = obj.data() + offset;
   for(quint32 i = 0; i < size; i++)
-  {
-    Pos p;
-    in >> p;
-    obj.append(p);
-  }
+    in >> data[i];
+
+  if(in.status() != QDataStream::Ok)
+    obj.resize(offset);
   return in;
 }
 
@@ -29,10 +29,11 @@ namespace geo {
 class Line;
 
 /*
- * List of geographic positions
+ * List of geographic positions.
+ * Uses contiguous storage since Pos is too large to be stored inline in a QList in Qt 5.
  */
 class LineString :
-  public QList<atools::geo::Pos>
+  public QVector<atools::geo::Pos>
 {
 public:
   LineString()
@@ -43,24 +44,33 @@ public:
   explicit LineString(const std::initializer_list<float>& coordinatePairs);
 
   explicit LineString(const std::initializer_list<atools::geo::Pos>& list)
-    : QList(list)
+    : QVector(list)
   {
   }
 
+  explicit LineString(const QVector<atools::geo::Pos>& vector)
+    : QVector(vector)
+  {
+
+  }
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
   explicit LineString(const QList<atools::geo::Pos>& list)
-    : QList(list)
+    : QVector(QVector<atools::geo::Pos>::fromList(list))
   {
 
   }
 
+#endif
+
   explicit LineString(const atools::geo::Pos& pos)
-    : QList({pos})
+    : QVector({pos})
   {
 
   }
 
   explicit LineString(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2)
-    : QList({pos1, pos2})
+    : QVector({pos1, pos2})
   {
 
   }
@@ -72,35 +82,56 @@ public:
   explicit LineString(const atools::geo::Pos& origin, const atools::geo::Pos& start,
                       const atools::geo::Pos& end, bool clockwise, int numSegments);
 
+  /* Default maximum distance between a chord and the true arc used by the adaptive functions below */
+  static Q_DECL_CONSTEXPR float ARC_MAX_ERROR_METER = 100.f;
+  static Q_DECL_CONSTEXPR int ARC_MIN_SEGMENTS = 12;
+  static Q_DECL_CONSTEXPR int ARC_MAX_SEGMENTS = 72;
+
+  /* Build a circle using the least number of segments which keeps the chord error below maxErrorMeter */
+  static atools::geo::LineString circle(const atools::geo::Pos& origin, float radiusMeter,
+                                        float maxErrorMeter = ARC_MAX_ERROR_METER);
+
+  /* Build an arc using the least number of segments which keeps the chord error below maxErrorMeter.
+   * Radius is taken from the distance between origin and start. */
+  static atools::geo::LineString arc(const atools::geo::Pos& origin, const atools::geo::Pos& start,
+                                     const atools::geo::Pos& end, bool clockwise,
+                                     float maxErrorMeter = ARC_MAX_ERROR_METER);
+
+  /* Number of segments for a full circle so that the maximum distance between chord and circle (sagitta)
+   * is below maxErrorMeter. Result is rounded up to a divisor of 360 to get whole degree steps and
+   * limited to minSegments and maxSegments. */
+  static int segmentsForRadius(float radiusMeter, float maxErrorMeter = ARC_MAX_ERROR_METER,
+                               int minSegments = ARC_MIN_SEGMENTS, int maxSegments = ARC_MAX_SEGMENTS);
+
   LineString(const atools::geo::LineString& other)
-    : QList(other)
+    : QVector(other)
   {
   }
 
   atools::geo::LineString& operator=(const atools::geo::LineString& other)
   {
-    QList::operator=(other);
+    QVector::operator=(other);
     return *this;
   }
 
   void append(const atools::geo::Pos& pos)
   {
-    QList::append(pos);
+    QVector::append(pos);
   }
 
   void append(const atools::geo::LineString& linestring)
   {
-    QList::append(linestring);
+    QVector::append(linestring);
   }
 
   void append(float longitudeX, float latitudeY, float alt = 0.f)
   {
-    QList::append(Pos(longitudeX, latitudeY, alt));
+    QVector::append(Pos(longitudeX, latitudeY, alt));
   }
 
   void append(double longitudeX, double latitudeY, double alt = 0.f)
   {
-    QList::append(Pos(longitudeX, latitudeY, alt));
+    QVector::append(Pos(longitudeX, latitudeY, alt));
   }
 
   LineString reversed();
@@ -123,6 +154,15 @@ public:
   void removeDuplicates(float epsilon);
   void removeDuplicates();
 
+  /* Remove points using the Douglas-Peucker algorithm. Points closer than toleranceMeter to the simplified line
+   * are dropped. First and last point are kept. Uses a sinusoidal projection which is sufficient for display. */
+  void simplifyDouglasPeucker(float toleranceMeter);
+
+  /* Remove points using the Visvalingam-Whyatt algorithm. Points forming a triangle with an area smaller than
+   * minAreaSqMeter with their neighbours are dropped. First and last point are kept.
+   * Gives smoother results than Douglas-Peucker for coast line like boundaries. */
+  void simplifyVisvalingam(float minAreaSqMeter);
+
   /* Calculate status, cross track distance and more to this line.
    * Index is for Line(at(i), at(i + 1)) */
   void distanceMeterToLineString(const atools::geo::Pos& pos, atools::geo::LineDistance& result,
@@ -153,19 +193,19 @@ public:
    * (or all remaining elements if there are less than length elements) are included.*/
   const atools::geo::LineString mid(int pos, int len = -1) const
   {
-    return atools::geo::LineString(QList::mid(pos, len));
+    return atools::geo::LineString(QVector::mid(pos, len));
   }
 
   /* Returns a string with len number of coordinates from the beginning of the list */
   const atools::geo::LineString left(int len) const
   {
-    return atools::geo::LineString(QList::mid(0, len));
+    return atools::geo::LineString(QVector::mid(0, len));
   }
 
   /* Returns a string with len number of coordinates from the end of the list */
   const atools::geo::LineString right(int len) const
   {
-    return atools::geo::LineString(QList::mid(size() - len));
+    return atools::geo::LineString(QVector::mid(size() - len));
   }
 
   /* Calculate Length of the line string in meter */
@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "geo/calculations.h"
+#include "geo/fastmath.h"
 #include "geo/pos.h"
 #include "geo/point3d.h"
 #include "exception.h"
@@ -286,6 +287,16 @@ double Pos::distanceMeterToDouble(const Pos& otherPos) const
                        toRadians(static_cast<double>(otherPos.latY))) * EARTH_RADIUS_METER_DOUBLE;
 }
 
+float Pos::distanceMeterToFast(const Pos& otherPos) const
+{
+  if(!isValid() || !otherPos.isValid())
+    return INVALID_VALUE;
+  else if(*this == otherPos)
+    return 0.f;
+  else
+    return atools::geo::distanceMeter<FastMath>(lonX, latY, otherPos.lonX, otherPos.latY);
+}
+
 double Pos::distanceMeterTo3dDouble(const Pos& otherPos, double altitudeWeight) const
 {
   double distMeter = distanceMeterToDouble(otherPos);
@@ -385,6 +396,16 @@ float Pos::angleDegTo(const Pos& otherPos) const
   return static_cast<float>(normalizeCourse(angleDeg));
 }
 
+float Pos::angleDegToFast(const Pos& otherPos) const
+{
+  if(!isValid() || !otherPos.isValid())
+    return INVALID_VALUE;
+  else if(*this == otherPos)
+    return INVALID_VALUE;
+
+  return atools::geo::courseDeg<FastMath>(lonX, latY, otherPos.lonX, otherPos.latY);
+}
+
 float Pos::initialBearing(const Pos& otherPos) const
 {
   if(!this->isValid() || !otherPos.isValid())
@@ -590,14 +611,8 @@ QString Pos::toString(int precision, bool alt) const
 
 void Pos::interpolatePoints(const Pos& otherPos, float distanceMeter, int numPoints, atools::geo::LineString& positions) const
 {
-  if(!isValid() || !otherPos.isValid())
-    return;
-  else if(*this == otherPos)
-    return;
-
-  float step = 1.f / numPoints;
-  for(int j = 0; j < numPoints; j++)
-    positions.append(interpolate(otherPos, distanceMeter, step * static_cast<float>(j)).alt(altitude));
+  // Batch version calculates end point coordinates only once
+  atools::geo::interpolatePoints(positions, *this, otherPos, distanceMeter, numPoints);
 }
 
 void Pos::interpolatePointsRhumb(const Pos& otherPos, float distanceMeter, int numPoints, atools::geo::LineString& positions) const
@@ -820,6 +835,18 @@ void Pos::toCartesian(double& x, double& y, double& z) const
     x = y = z = 0.;
 }
 
+void Pos::toCartesianFast(Point3D& point) const
+{
+  if(isValid())
+  {
+    float x, y, z;
+    atools::geo::toCartesian<FastMath>(lonX, latY, x, y, z);
+    point.set(x, y, z);
+  }
+  else
+    point.set(0.f, 0.f, 0.f);
+}
+
 double PosD::distanceMeterTo(const PosD& otherPos) const
 {
   if(!isValid() || !otherPos.isValid())
@@ -211,6 +211,9 @@ public:
 
   double distanceMeterToDouble(const atools::geo::Pos& otherPos) const;
 
+  /* As distanceMeterTo() but uses fast approximated trigonometric functions. See FastMath in fastmath.h. */
+  float distanceMeterToFast(const atools::geo::Pos& otherPos) const;
+
   /* Also uses distance in altitude which has to be given in feet.
    * Vertical distance is added to GC distance using Pythagoras and hence only accurate for short distances.
    * altitudeWeight can be used to lower or raise altitude priority. */
@@ -229,6 +232,9 @@ public:
   /* Angle to other point (initial course) */
   float angleDegTo(const atools::geo::Pos& otherPos) const;
 
+  /* As angleDegTo() but uses fast approximated trigonometric functions */
+  float angleDegToFast(const atools::geo::Pos& otherPos) const;
+
   /* Initial GC angle/course to the other point */
   float initialBearing(const atools::geo::Pos& otherPos) const;
 
@@ -333,6 +339,9 @@ public:
   void toCartesian(double& x, double& y, double& z) const;
   void toCartesian(float& x, float& y, float& z) const;
 
+  /* As toCartesian() but uses fast approximated trigonometric functions. For building spatial indexes. */
+  void toCartesianFast(atools::geo::Point3D& point) const;
+
   // 1 deg / minutes / nm to meter / to 10 cm
   Q_DECL_CONSTEXPR static float POS_EPSILON_MIN = std::numeric_limits<float>::epsilon();
   Q_DECL_CONSTEXPR static float POS_EPSILON_10CM = 1.f / 60.f / 1852.216f / 10.f; /* ca 10 cm for lat and lon nearby equator */
@@ -0,0 +1,184 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "geo/rtree.h"
+
+#include "geo/rect.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+namespace atools {
+namespace geo {
+
+RTree::RTree(int nodeSize)
+  : nodeSize(std::max(nodeSize, 2))
+{
+}
+
+RTree::~RTree()
+{
+}
+
+void RTree::Box::extend(const Box& other)
+{
+  west = std::min(west, other.west);
+  south = std::min(south, other.south);
+  east = std::max(east, other.east);
+  north = std::max(north, other.north);
+}
+
+void RTree::clear()
+{
+  items.clear();
+  levels.clear();
+  numObjects = 0;
+  dirty = false;
+}
+
+void RTree::add(int id, const Rect& rect)
+{
+  if(!rect.isValid())
+    return;
+
+  // Store both parts if rectangle crosses the anti-meridian
+  for(const Rect& r : rect.splitAtAntiMeridian())
+    items.append({{r.getWest(), r.getSouth(), r.getEast(), r.getNorth()}, id});
+
+  numObjects++;
+  dirty = true;
+}
+
+template<typename TYPE>
+void RTree::packLevel(QVector<TYPE>& entries, QVector<TreeNode>& level) const
+{
+  // Sort-tile-recursive: Sort by center longitude, cut into vertical slices and sort each slice by center latitude
+  int num = entries.size();
+  int numNodes = (num + nodeSize - 1) / nodeSize;
+  int numSlices = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numNodes))));
+  int sliceSize = numSlices * nodeSize;
+
+  std::sort(entries.begin(), entries.end(), [](const TYPE& e1, const TYPE& e2) -> bool {
+              return e1.box.west + e1.box.east < e2.box.west + e2.box.east;
+            });
+
+  for(int slice = 0; slice < num; slice += sliceSize)
+    std::sort(entries.begin() + slice, entries.begin() + std::min(slice + sliceSize, num),
+              [](const TYPE& e1, const TYPE& e2) -> bool {
+                return e1.box.south + e1.box.north < e2.box.south + e2.box.north;
+              });
+
+  // Group consecutive entries into nodes
+  level.clear();
+  level.reserve(numNodes);
+  for(int first = 0; first < num; first += nodeSize)
+  {
+    TreeNode node;
+    node.first = first;
+    node.count = std::min(nodeSize, num - first);
+    node.box = entries.at(first).box;
+    for(int i = first + 1; i < first + node.count; i++)
+      node.box.extend(entries.at(i).box);
+    level.append(node);
+  }
+}
+
+void RTree::build()
+{
+  levels.clear();
+  dirty = false;
+
+  if(items.isEmpty())
+    return;
+
+  // Leaf level pointing into items
+  levels.append(QVector<TreeNode>());
+  packLevel(items, levels.last());
+
+  // Pack upper levels until only the root is left
+  while(levels.constLast().size() > 1)
+  {
+    QVector<TreeNode> lower = levels.takeLast();
+    QVector<TreeNode> upper;
+    packLevel(lower, upper);
+    levels.append(lower);
+    levels.append(upper);
+  }
+
+  qDebug() << Q_FUNC_INFO << "objects" << numObjects << "items" << items.size() << "levels" << levels.size();
+}
+
+void RTree::search(QVector<int>& ids, const Box& box) const
+{
+  if(levels.isEmpty())
+    return;
+
+  // Stack of level and node index
+  QVector<std::pair<int, int> > stack;
+  stack.append(std::make_pair(levels.size() - 1, 0));
+
+  while(!stack.isEmpty())
+  {
+    std::pair<int, int> top = stack.takeLast();
+    const TreeNode& node = levels.at(top.first).at(top.second);
+
+    if(!node.box.overlaps(box))
+      continue;
+
+    if(top.first == 0)
+    {
+      for(int i = node.first; i < node.first + node.count; i++)
+      {
+        const Item& item = items.at(i);
+        if(item.box.overlaps(box))
+          ids.append(item.id);
+      }
+    }
+    else
+    {
+      for(int i = node.first; i < node.first + node.count; i++)
+        stack.append(std::make_pair(top.first - 1, i));
+    }
+  }
+}
+
+void RTree::getOverlapping(QVector<int>& ids, const Rect& rect) const
+{
+  ids.clear();
+  if(dirty)
+    qWarning() << Q_FUNC_INFO << "Tree not built";
+
+  if(!rect.isValid())
+    return;
+
+  for(const Rect& r : rect.splitAtAntiMeridian())
+    search(ids, {r.getWest(), r.getSouth(), r.getEast(), r.getNorth()});
+
+  // Remove duplicates from split rectangles
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void RTree::getContaining(QVector<int>& ids, const Pos& pos) const
+{
+  getOverlapping(ids, Rect(pos));
+}
+
+} // namespace geo
+} // namespace atools
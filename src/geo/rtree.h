@@ -0,0 +1,116 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GEO_RTREE_H
+#define ATOOLS_GEO_RTREE_H
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+
+class Pos;
+class Rect;
+
+/*
+ * Static R-tree for bounding rectangles which is bulk loaded using sort-tile-recursive (STR) packing.
+ * Objects are identified by an id which is usually an index into a separate vector or a database id.
+ *
+ * Call add() for all objects and build() afterwards. Queries are only allowed after build().
+ * Rectangles crossing the anti-meridian are split and stored twice. Query results are sorted by id and
+ * contain no duplicates.
+ *
+ * Query methods are const and can be called from several threads once the tree is built.
+ */
+class RTree
+{
+public:
+  /* nodeSize: Maximum number of children for each tree node */
+  explicit RTree(int nodeSize = 16);
+  ~RTree();
+
+  /* Add object with bounding rectangle. Invalid rectangles are ignored. Needs build() afterwards. */
+  void add(int id, const atools::geo::Rect& rect);
+
+  /* Pack tree. Can be called again after adding more objects. */
+  void build();
+
+  void clear();
+
+  /* Number of objects added */
+  int size() const
+  {
+    return numObjects;
+  }
+
+  bool isEmpty() const
+  {
+    return numObjects == 0;
+  }
+
+  /* Get ids of all objects with bounding rectangle overlapping rect */
+  void getOverlapping(QVector<int>& ids, const atools::geo::Rect& rect) const;
+
+  /* Get ids of all objects with bounding rectangle containing pos */
+  void getContaining(QVector<int>& ids, const atools::geo::Pos& pos) const;
+
+private:
+  /* Simple rectangle not crossing the anti-meridian */
+  struct Box
+  {
+    float west, south, east, north;
+
+    bool overlaps(const Box& other) const
+    {
+      return west <= other.east && east >= other.west && south <= other.north && north >= other.south;
+    }
+
+    void extend(const Box& other);
+  };
+
+  struct Item
+  {
+    Box box;
+    int id;
+  };
+
+  /* Children are either items for leaf level 0 or nodes of the level below */
+  struct TreeNode
+  {
+    Box box;
+    int first, count;
+  };
+
+  template<typename TYPE>
+  void packLevel(QVector<TYPE>& entries, QVector<TreeNode>& level) const;
+
+  void search(QVector<int>& ids, const Box& box) const;
+
+  int nodeSize, numObjects = 0;
+  bool dirty = false;
+
+  /* Objects sorted by STR order after build */
+  QVector<Item> items;
+
+  /* levels[0] contains leaf nodes pointing into items. Last level contains the root. */
+  QVector<QVector<TreeNode> > levels;
+};
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_RTREE_H
@@ -0,0 +1,218 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "geo/spatialgrid.h"
+
+#include "geo/calculations.h"
+#include "geo/rect.h"
+
+namespace atools {
+namespace geo {
+
+/* Length of one degree latitude */
+const static float METER_PER_DEGREE = atools::geo::EARTH_CIRCUMFERENCE_METER / 360.f;
+
+SpatialGrid::SpatialGrid(float cellSizeDeg)
+  : cellSize(std::max(cellSizeDeg, 0.01f))
+{
+  numColumns = static_cast<int>(std::ceil(360.f / cellSize));
+  numRows = static_cast<int>(std::ceil(180.f / cellSize));
+}
+
+SpatialGrid::~SpatialGrid()
+{
+}
+
+int SpatialGrid::row(float laty) const
+{
+  return atools::minmax(0, numRows - 1, static_cast<int>((laty + 90.f) / cellSize));
+}
+
+int SpatialGrid::column(float lonx) const
+{
+  return atools::minmax(0, numColumns - 1, static_cast<int>((lonx + 180.f) / cellSize));
+}
+
+void SpatialGrid::insert(int id, const Pos& pos)
+{
+  Pos normalized = pos.normalized();
+  int cell = cellIndex(row(normalized.getLatY()), column(normalized.getLonX()));
+
+  auto it = entries.find(id);
+  if(it != entries.end())
+  {
+    if(it->cell != cell)
+    {
+      // Move to other bucket
+      cells[it->cell].removeOne(id);
+      cells[cell].append(id);
+      it->cell = cell;
+    }
+    it->pos = CartesianPos(normalized);
+  }
+  else
+  {
+    Entry entry;
+    entry.pos = CartesianPos(normalized);
+    entry.cell = cell;
+    entries.insert(id, entry);
+    cells[cell].append(id);
+  }
+}
+
+bool SpatialGrid::remove(int id)
+{
+  auto it = entries.find(id);
+  if(it == entries.end())
+    return false;
+
+  auto cellIt = cells.find(it->cell);
+  if(cellIt != cells.end())
+  {
+    cellIt->removeOne(id);
+    if(cellIt->isEmpty())
+      cells.erase(cellIt);
+  }
+  entries.erase(it);
+  return true;
+}
+
+void SpatialGrid::clear()
+{
+  entries.clear();
+  cells.clear();
+}
+
+void SpatialGrid::getRadius(QVector<IndexDistance>& result, const Pos& pos, float radiusMeter, int maxResults) const
+{
+  result.clear();
+  if(entries.isEmpty() || !pos.isValid())
+    return;
+
+  Pos origin = pos.normalized();
+  CartesianPos originCartesian(origin);
+  float maxChordSquared = CartesianPos::chordSquaredForDistance(radiusMeter);
+  float radiusDeg = radiusMeter / METER_PER_DEGREE;
+  float latMin = origin.getLatY() - radiusDeg, latMax = origin.getLatY() + radiusDeg;
+
+  int rowMin = row(latMin), rowMax = row(latMax);
+
+  // Longitude range widens with latitude - use all columns if a pole is within the search area
+  int colFirst = 0, numCols = numColumns;
+  if(latMin > -90.f && latMax < 90.f)
+  {
+    float maxAbsLat = std::max(std::abs(latMin), std::abs(latMax));
+    float lonDelta = radiusDeg / std::cos(atools::geo::toRadians(maxAbsLat));
+    if(lonDelta < 180.f)
+    {
+      colFirst = static_cast<int>(std::floor((origin.getLonX() - lonDelta + 180.f) / cellSize));
+      int colLast = static_cast<int>(std::floor((origin.getLonX() + lonDelta + 180.f) / cellSize));
+      numCols = std::min(colLast - colFirst + 1, numColumns);
+    }
+  }
+
+  for(int r = rowMin; r <= rowMax; r++)
+  {
+    for(int c = 0; c < numCols; c++)
+    {
+      // Wrap around at the anti-meridian
+      int col = atools::wrapIndex(colFirst + c, numColumns);
+
+      auto it = cells.constFind(cellIndex(r, col));
+      if(it == cells.constEnd())
+        continue;
+
+      for(int id : it.value())
+      {
+        float chordSquared = originCartesian.chordSquared(entries.value(id).pos);
+        if(chordSquared <= maxChordSquared)
+          result.append({id, CartesianPos::distanceForChordSquared(chordSquared)});
+      }
+    }
+  }
+
+  auto compare = [](const IndexDistance& e1, const IndexDistance& e2) -> bool {
+                   return e1.distanceMeter < e2.distanceMeter;
+                 };
+
+  if(maxResults > 0 && result.size() > maxResults)
+  {
+    std::partial_sort(result.begin(), result.begin() + maxResults, result.end(), compare);
+    result.resize(maxResults);
+  }
+  else
+    std::sort(result.begin(), result.end(), compare);
+}
+
+int SpatialGrid::getNearest(const Pos& pos, float maxRadiusMeter, float *distanceMeter) const
+{
+  // Start with the size of one cell and increase radius until something is found
+  QVector<IndexDistance> result;
+  float radius = std::min(cellSize * METER_PER_DEGREE, maxRadiusMeter);
+  while(true)
+  {
+    getRadius(result, pos, radius, 1);
+    if(!result.isEmpty())
+    {
+      if(distanceMeter != nullptr)
+        *distanceMeter = result.constFirst().distanceMeter;
+      return result.constFirst().index;
+    }
+
+    if(radius >= maxRadiusMeter)
+      break;
+    radius = std::min(radius * 2.f, maxRadiusMeter);
+  }
+  return -1;
+}
+
+void SpatialGrid::getRect(QVector<int>& ids, const Rect& rect) const
+{
+  ids.clear();
+  if(entries.isEmpty() || !rect.isValid())
+    return;
+
+  for(const Rect& part : rect.splitAtAntiMeridian())
+  {
+    int rowMin = row(part.getSouth()), rowMax = row(part.getNorth());
+    int colMin = column(part.getWest()), colMax = column(part.getEast());
+
+    for(int r = rowMin; r <= rowMax; r++)
+    {
+      for(int c = colMin; c <= colMax; c++)
+      {
+        auto it = cells.constFind(cellIndex(r, c));
+        if(it == cells.constEnd())
+          continue;
+
+        // Cells at the border are only partially covered
+        for(int id : it.value())
+        {
+          if(part.contains(entries.value(id).pos.getPos()))
+            ids.append(id);
+        }
+      }
+    }
+  }
+
+  // Remove objects found in both parts
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+} // namespace geo
+} // namespace atools
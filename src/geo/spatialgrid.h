@@ -0,0 +1,123 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GEO_SPATIALGRID_H
+#define ATOOLS_GEO_SPATIALGRID_H
+
+#include "geo/cartesianpos.h"
+#include "geo/spatialindex.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+
+class Rect;
+
+/*
+ * Dynamic spatial index for frequently changing point sets like AI or online aircraft.
+ *
+ * Objects are identified by an id and stored in buckets of a regular longitude/latitude grid.
+ * Insert, move and remove are O(1) on average and do not need a rebuild like SpatialIndex.
+ * Radius queries look only at grid cells overlapping the search area and consider the anti-meridian and poles.
+ * Positions keep a precalculated unit vector which reduces the distance check for each candidate to a chord length.
+ *
+ * Not thread safe.
+ */
+class SpatialGrid
+{
+public:
+  /* cellSizeDeg: Size of grid cells in degree. Should be in the range of the typical search radius. */
+  explicit SpatialGrid(float cellSizeDeg = 1.f);
+  ~SpatialGrid();
+
+  /* Add object or update position if it already exists */
+  void insert(int id, const atools::geo::Pos& pos);
+
+  /* Change position of an existing object or add it if not found */
+  void move(int id, const atools::geo::Pos& pos)
+  {
+    insert(id, pos);
+  }
+
+  /* Remove object. Returns false if not found. */
+  bool remove(int id);
+
+  void clear();
+
+  bool contains(int id) const
+  {
+    return entries.contains(id);
+  }
+
+  /* Position of object or invalid position if not found */
+  atools::geo::Pos getPosition(int id) const
+  {
+    return entries.value(id).pos.getPos();
+  }
+
+  int size() const
+  {
+    return entries.size();
+  }
+
+  bool isEmpty() const
+  {
+    return entries.isEmpty();
+  }
+
+  /* Get all objects within radiusMeter sorted by great circle distance. IndexDistance::index contains the object id.
+   * maxResults: Return only the closest objects if > 0. */
+  void getRadius(QVector<atools::geo::IndexDistance>& result, const atools::geo::Pos& pos, float radiusMeter,
+                 int maxResults = 0) const;
+
+  /* Get id of nearest object within maxRadiusMeter or -1 if none. */
+  int getNearest(const atools::geo::Pos& pos, float maxRadiusMeter, float *distanceMeter = nullptr) const;
+
+  /* Get ids of all objects inside rect sorted by id. Considers rectangles crossing the anti-meridian. */
+  void getRect(QVector<int>& ids, const atools::geo::Rect& rect) const;
+
+private:
+  struct Entry
+  {
+    atools::geo::CartesianPos pos;
+    int cell = -1;
+  };
+
+  int cellIndex(int row, int column) const
+  {
+    return row * numColumns + column;
+  }
+
+  int row(float laty) const;
+  int column(float lonx) const;
+
+  float cellSize;
+  int numColumns, numRows;
+
+  /* Object id to position and cell */
+  QHash<int, Entry> entries;
+
+  /* Cell index to object ids */
+  QHash<int, QVector<int> > cells;
+};
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_SPATIALGRID_H
@@ -16,8 +16,15 @@
 *****************************************************************************/
 
 #include "geo/spatialindex.h"
+#include "geo/calculations.h"
 #include "geo/nanoflann.h"
 #include "geo/pos.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <cstdio>
 
 using namespace std;
 using namespace nanoflann;
@@ -169,15 +176,15 @@ private:
   RadiusCallbackType callback;
 };
 
-void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, const Pos& origin, float radiusMaxMeter,
-                                         const RadiusCallbackType& callback) const
+/* Radius search using the given buffer for intermediate results */
+static void radiusSearch(const DataSource *p, QVector<int>& indexes, const Pos& origin, float radiusMaxMeter,
+                         const RadiusCallbackType& callback, QVector<IndexEntry>& indicesDists)
 {
   float originPtArr[3];
   origin.toCartesian(originPtArr[0], originPtArr[1], originPtArr[2]);
-  Point3D originPt(originPtArr[0], originPtArr[1], originPtArr[2]);
 
-  QVector<IndexEntry> indicesDists;
-  indicesDists.reserve(100000);
+  // Keeps capacity
+  indicesDists.resize(0);
   RadiusResults resultCallback(indicesDists, radiusMaxMeter, callback);
 
   nanoflann::SearchParams params;
@@ -189,11 +196,252 @@ void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, const Pos& origi
     indexes.append(indicesDists.at(i).index);
 }
 
+void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, const Pos& origin, float radiusMaxMeter,
+                                         const RadiusCallbackType& callback) const
+{
+  QVector<IndexEntry> indicesDists;
+  indicesDists.reserve(100000);
+  radiusSearch(p, indexes, origin, radiusMaxMeter, callback, indicesDists);
+}
+
+void SpatialIndexPrivate::pointsInRadiusBatch(QVector<QVector<int> >& results, const QVector<Pos>& positions,
+                                              float radiusMaxMeter, int numThreads) const
+{
+  results.clear();
+  results.resize(positions.size());
+
+  // One buffer for each thread
+  QVector<QVector<IndexEntry> > buffers(atools::util::parallelChunks(positions.size(), numThreads, MIN_BATCH_CHUNK));
+
+  atools::util::parallelFor(positions.size(), numThreads, [&](int begin, int end, int chunk) -> void {
+    QVector<IndexEntry>& buffer = buffers[chunk];
+    buffer.reserve(1000);
+    for(int i = begin; i < end; i++)
+      radiusSearch(p, results[i], positions.at(i), radiusMaxMeter, RadiusCallbackType(), buffer);
+  }, MIN_BATCH_CHUNK);
+}
+
+void SpatialIndexPrivate::pointsInRadiusSortedBatch(QVector<QVector<IndexDistance> >& results,
+                                                    const QVector<Pos>& positions, float radiusMeter,
+                                                    int maxResults, int numThreads) const
+{
+  results.clear();
+  results.resize(positions.size());
+
+  atools::util::parallelFor(positions.size(), numThreads, [&](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
+      pointsInRadiusSorted(results[i], positions.at(i), radiusMeter, maxResults, RadiusCallbackType());
+  }, MIN_BATCH_CHUNK);
+}
+
+void SpatialIndexPrivate::nearestPointBatch(QVector<int>& results, const QVector<Pos>& positions,
+                                            int numThreads) const
+{
+  results.clear();
+  results.resize(positions.size());
+
+  atools::util::parallelFor(positions.size(), numThreads, [&](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
+      results[i] = nearestPoint(positions.at(i));
+  }, MIN_BATCH_CHUNK);
+}
+
+/* Manhattan distance is at most sqrt(3) times the euclidean distance in three dimensions */
+const static float L1_TO_L2_FACTOR = 1.7320508f;
+
+/* Collects points within a manhattan radius. Used as first stage for exact queries. */
+class RadiusCandidates
+{
+public:
+  RadiusCandidates(QVector<int>& resultParam, float radiusMaxParam)
+    : radiusMax(radiusMaxParam), result(resultParam)
+  {
+  }
+
+  size_t size() const
+  {
+    return static_cast<size_t>(result.size());
+  }
+
+  bool full() const
+  {
+    return true;
+  }
+
+  bool addPoint(float dist, int index)
+  {
+    if(dist <= radiusMax)
+      result.append(index);
+    return true;
+  }
+
+  float worstDist() const
+  {
+    return radiusMax;
+  }
+
+private:
+  float radiusMax;
+  QVector<int>& result;
+};
+
+void SpatialIndexPrivate::pointsInRadiusSorted(QVector<IndexDistance>& result, const Pos& origin, float radiusMeter,
+                                               int maxResults, const RadiusCallbackType& callback) const
+{
+  result.clear();
+  if(p->pointsSize == 0)
+    return;
+
+  float originPtArr[3];
+  origin.toCartesian(originPtArr[0], originPtArr[1], originPtArr[2]);
+  Point3D originPt(originPtArr[0], originPtArr[1], originPtArr[2]);
+
+  // Convert great circle radius to chord length and then to manhattan radius which covers the sphere cap
+  const float diameter = 2.f * atools::geo::EARTH_RADIUS_METER;
+  float angle = std::min(radiusMeter / diameter, static_cast<float>(M_PI / 2.));
+  float chord = diameter * std::sin(angle);
+
+  QVector<int> candidates;
+  RadiusCandidates resultCallback(candidates, chord * L1_TO_L2_FACTOR);
+  nanoflann::SearchParams params;
+  params.sorted = false;
+  p->index.radiusSearchCustomCallback(originPtArr, resultCallback, params);
+
+  // Second stage - filter by exact distance
+  result.reserve(candidates.size());
+  for(int index : candidates)
+  {
+    float dist = originPt.gcDistanceMeter(p->points[index]);
+    if(dist <= radiusMeter && (!callback || callback(dist, index)))
+      result.append({index, dist});
+  }
+
+  auto compare = [](const IndexDistance& e1, const IndexDistance& e2) -> bool {
+                   return e1.distanceMeter < e2.distanceMeter;
+                 };
+
+  if(maxResults > 0 && result.size() > maxResults)
+  {
+    // Sort only the needed part
+    std::partial_sort(result.begin(), result.begin() + maxResults, result.end(), compare);
+    result.resize(maxResults);
+  }
+  else
+    std::sort(result.begin(), result.end(), compare);
+}
+
+void SpatialIndexPrivate::nearestPointsSorted(QVector<IndexDistance>& result, const Pos& pos, int number) const
+{
+  result.clear();
+  if(p->pointsSize == 0 || number <= 0)
+    return;
+
+  // Get candidates by manhattan distance first
+  QVector<int> indexes;
+  nearestPoints(indexes, pos, number);
+  if(indexes.isEmpty())
+    return;
+
+  // The true nearest points are not farther away than the farthest candidate
+  Point3D originPt = pos.toCartesian();
+  float maxDist = 0.f;
+  for(int index : indexes)
+    maxDist = std::max(maxDist, originPt.gcDistanceMeter(p->points[index]));
+
+  // Exact search with radius covering all candidates
+  pointsInRadiusSorted(result, pos, maxDist, number, RadiusCallbackType());
+}
+
 void SpatialIndexPrivate::buildIndex()
 {
   p->index.buildIndex();
 }
 
+bool SpatialIndexPrivate::saveIndex(const QString& filename, quint32 dataVersion) const
+{
+  // Write to temporary file first to avoid leaving a broken file behind
+  QString tempFilename = filename + ".tmp";
+  FILE *stream = fopen(QFile::encodeName(tempFilename).constData(), "wb");
+  if(stream == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << tempFilename;
+    return false;
+  }
+
+  quint32 header[] = {INDEX_MAGIC_NUMBER, INDEX_VERSION, dataVersion, static_cast<quint32>(p->pointsSize),
+                      static_cast<quint32>(sizeof(Point3D))};
+  fwrite(header, sizeof(header), 1, stream);
+  fwrite(p->points, sizeof(Point3D), static_cast<size_t>(p->pointsSize), stream);
+  p->index.saveIndex(stream);
+
+  bool ok = ferror(stream) == 0;
+  ok &= fclose(stream) == 0;
+
+  if(ok)
+  {
+    QFile::remove(filename);
+    ok = QFile::rename(tempFilename, filename);
+  }
+
+  if(!ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename;
+    QFile::remove(tempFilename);
+  }
+  return ok;
+}
+
+bool SpatialIndexPrivate::loadIndex(const QString& filename, quint32 dataVersion, int size)
+{
+  if(!QFile::exists(filename))
+    return false;
+
+  FILE *stream = fopen(QFile::encodeName(filename).constData(), "rb");
+  if(stream == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename;
+    return false;
+  }
+
+  bool ok = false;
+  quint32 header[5];
+  if(fread(header, sizeof(header), 1, stream) == 1)
+  {
+    if(header[0] != INDEX_MAGIC_NUMBER || header[1] != INDEX_VERSION || header[4] != sizeof(Point3D))
+      qInfo() << Q_FUNC_INFO << filename << "has invalid format or version";
+    else if(header[2] != dataVersion || header[3] != static_cast<quint32>(size))
+      qInfo() << Q_FUNC_INFO << filename << "is outdated";
+    else
+    {
+      p->init(size);
+      if(fread(p->points, sizeof(Point3D), static_cast<size_t>(size), stream) == static_cast<size_t>(size))
+      {
+        try
+        {
+          // Throws runtime_error if file is truncated
+          p->index.freeIndex(p->index);
+          p->index.loadIndex(stream);
+          p->index.m_size_at_index_build = p->index.m_size;
+          ok = p->index.m_size == static_cast<size_t>(size);
+        }
+        catch(std::runtime_error& e)
+        {
+          qWarning() << Q_FUNC_INFO << filename << e.what();
+        }
+      }
+
+      if(!ok)
+      {
+        // Leave a clean state for rebuilding
+        p->index.freeIndex(p->index);
+        p->free();
+      }
+    }
+  }
+  fclose(stream);
+  return ok;
+}
+
 void SpatialIndexPrivate::set(const Point3D& point, int index)
 {
   p->points[index] = point;
@@ -214,6 +462,12 @@ const atools::geo::Point3D *SpatialIndexPrivate::points3D()
   return p->points;
 }
 
+qint64 SpatialIndexPrivate::memoryBytes() const
+{
+  return static_cast<qint64>(p->pointsSize) * static_cast<qint64>(sizeof(Point3D)) +
+         static_cast<qint64>(p->index.usedMemory(p->index));
+}
+
 SpatialIndexPrivate::SpatialIndexPrivate()
 {
   p = new DataSource;
@@ -230,3 +484,4 @@ SpatialIndexPrivate::~SpatialIndexPrivate()
 } // namespace atools
 
 Q_DECLARE_TYPEINFO(atools::geo::internal::IndexEntry, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::geo::IndexDistance, Q_PRIMITIVE_TYPE);
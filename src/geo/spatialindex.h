@@ -19,7 +19,9 @@
 #define ATOOLS_GEO_SPATIALINDEX_H
 
 #include "geo/point3d.h"
+#include "util/parallel.h"
 
+#include <QString>
 #include <QVector>
 #include <functional>
 
@@ -34,6 +36,13 @@ class SpatialIndex;
  * after filtering by manhattan distance to origin. */
 typedef std::function<bool (float, int)> RadiusCallbackType;
 
+/* Index into the spatial index vector and precise great circle distance to the query position */
+struct IndexDistance
+{
+  int index;
+  float distanceMeter;
+};
+
 /* Private parts *************************************************************************************/
 
 namespace internal {
@@ -53,15 +62,35 @@ class SpatialIndexPrivate
   void nearestPoints(QVector<int>& indexes, const atools::geo::Pos& pos, int number) const;
   void pointsInRadius(QVector<int>& indexes, const atools::geo::Pos& origin, float radiusMaxMeter,
                       const RadiusCallbackType& callback) const;
+  void pointsInRadiusSorted(QVector<IndexDistance>& result, const atools::geo::Pos& origin, float radiusMeter,
+                            int maxResults, const RadiusCallbackType& callback) const;
+  void nearestPointsSorted(QVector<IndexDistance>& result, const atools::geo::Pos& pos, int number) const;
+  void pointsInRadiusBatch(QVector<QVector<int> >& results, const QVector<atools::geo::Pos>& positions,
+                           float radiusMaxMeter, int numThreads) const;
+  void pointsInRadiusSortedBatch(QVector<QVector<IndexDistance> >& results, const QVector<atools::geo::Pos>& positions,
+                                 float radiusMeter, int maxResults, int numThreads) const;
+  void nearestPointBatch(QVector<int>& results, const QVector<atools::geo::Pos>& positions, int numThreads) const;
+  bool saveIndex(const QString& filename, quint32 dataVersion) const;
+  bool loadIndex(const QString& filename, quint32 dataVersion, int size);
   void set(const Point3D& point, int index);
   void buildIndex();
   void clear();
   void reserve(int size);
   const Point3D *points3D();
 
+  /* Bytes used by points and KD-tree */
+  qint64 memoryBytes() const;
+
   /* Data source containing nanoflann structures. */
   DataSource *p = nullptr;
 
+  /* Minimum number of queries per thread for batch queries */
+  static Q_DECL_CONSTEXPR int MIN_BATCH_CHUNK = 64;
+
+  /* Header for index cache files */
+  static Q_DECL_CONSTEXPR quint32 INDEX_MAGIC_NUMBER = 0x4B445431;
+  static Q_DECL_CONSTEXPR quint32 INDEX_VERSION = 1;
+
 };
 
 } // namespace internal
@@ -132,8 +161,75 @@ public:
     p->pointsInRadius(indexes, pos, radiusMaxMeter, RadiusCallbackType());
   }
 
-  /* Rebuild the KD-tree and Point3D vector. Call this after changing the base class vector. */
-  void updateIndex();
+  /* Get all objects within radiusMeter sorted by precise great circle distance to pos. Result contains the distance.
+   * No further distance filtering is needed by the caller.
+   * maxResults: Return only the closest maxResults objects if > 0.
+   * callback: Optional filter called with great circle distance and index. Return false to omit an object. */
+  void getRadiusSorted(QVector<atools::geo::IndexDistance>& result, const atools::geo::Pos& pos, float radiusMeter,
+                       int maxResults = 0, const RadiusCallbackType& callback = RadiusCallbackType()) const
+  {
+    p->pointsInRadiusSorted(result, pos, radiusMeter, maxResults, callback);
+  }
+
+  /* Get number nearest objects sorted by precise great circle distance. In contrast to getNearestIndexes
+   * the result is exact and not affected by the manhattan distance used in the KD-tree. */
+  void getNearestSorted(QVector<atools::geo::IndexDistance>& result, const atools::geo::Pos& pos, int number) const
+  {
+    p->nearestPointsSorted(result, pos, number);
+  }
+
+  /* Batch queries for many positions at once. Queries are spread over numThreads threads where 0 uses all cores.
+   * Each thread reuses its result buffers. results contains one entry for each position in the same order. */
+  void getRadiusIndexesBatch(QVector<QVector<int> >& results, const QVector<atools::geo::Pos>& positions,
+                             float radiusMaxMeter, int numThreads = 0) const
+  {
+    p->pointsInRadiusBatch(results, positions, radiusMaxMeter, numThreads);
+  }
+
+  /* Same as getRadiusSorted for each position */
+  void getRadiusSortedBatch(QVector<QVector<atools::geo::IndexDistance> >& results,
+                            const QVector<atools::geo::Pos>& positions, float radiusMeter, int maxResults = 0,
+                            int numThreads = 0) const
+  {
+    p->pointsInRadiusSortedBatch(results, positions, radiusMeter, maxResults, numThreads);
+  }
+
+  /* Same as getNearestIndex for each position. Result is -1 for an empty index. */
+  void getNearestIndexBatch(QVector<int>& results, const QVector<atools::geo::Pos>& positions, int numThreads = 0) const
+  {
+    p->nearestPointBatch(results, positions, numThreads);
+  }
+
+  /* Rebuild the KD-tree and Point3D vector. Call this after changing the base class vector.
+   * Conversion of positions is done in parallel if numThreads is not 1. 0 uses all cores. */
+  void updateIndex(int numThreads = 1);
+
+  /* Save KD-tree and points to a cache file. Objects of the vector are not saved.
+   * dataVersion should identify the source data like a checksum or timestamp.
+   * File is only valid for the same platform and build. Returns false on error. */
+  bool saveIndex(const QString& filename, quint32 dataVersion) const
+  {
+    return p->saveIndex(filename, dataVersion);
+  }
+
+  /* Load KD-tree and points from cache file for the objects currently in the vector.
+   * Returns false if the file is missing, invalid or does not match dataVersion and vector size.
+   * Call updateIndex() in this case. */
+  bool loadIndex(const QString& filename, quint32 dataVersion)
+  {
+    QVector<T>::squeeze();
+    return p->loadIndex(filename, dataVersion, QVector<T>::size());
+  }
+
+  /* Load index from cache file or update index and write cache file if not valid */
+  void loadOrUpdateIndex(const QString& filename, quint32 dataVersion, int numThreads = 1)
+  {
+    if(!loadIndex(filename, dataVersion))
+    {
+      updateIndex(numThreads);
+      saveIndex(filename, dataVersion);
+    }
+  }
 
   /* Get points converted to 3D euclidian space from base vector.
    * Size is the same as in the underlying parent QVector. */
@@ -142,6 +238,12 @@ public:
     return p->points3D();
   }
 
+  /* Approximate bytes used by objects, points and KD-tree. Does not include heap memory owned by objects. */
+  qint64 getMemoryBytes() const
+  {
+    return static_cast<qint64>(QVector<T>::capacity()) * static_cast<qint64>(sizeof(T)) + p->memoryBytes();
+  }
+
   const Point3D& atPoint3D(int index) const
   {
     return p->points3D()[index];
@@ -202,13 +304,16 @@ void SpatialIndex<T>::getRadius(QVector<T>& objects, const Pos& pos, float radiu
 }
 
 template<typename T>
-void SpatialIndex<T>::updateIndex()
+void SpatialIndex<T>::updateIndex(int numThreads)
 {
   QVector<T>::squeeze();
   p->reserve(QVector<T>::size());
 
-  for(int i = 0; i < QVector<T>::size(); i++)
-    p->set(QVector<T>::at(i).getPosition().toCartesian(), i);
+  // Threads write to distinct positions in the point array
+  atools::util::parallelFor(QVector<T>::size(), numThreads, [this](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
+      p->set(QVector<T>::at(i).getPosition().toCartesian(), i);
+  });
 
   p->buildIndex();
 }
@@ -27,6 +27,7 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
+#include <QTimer>
 #include <cmath>
 
 namespace atools {
@@ -34,11 +35,57 @@ namespace grib {
 
 using atools::util::HttpDownloader;
 
+/* Get byte ranges of all index lines matching the parameter and level names. Adjacent ranges are merged.
+ * Index line format is "number:offset:d=date:parameter:level:forecast:" */
+static QVector<std::pair<qint64, qint64> > rangesFromIndex(const QByteArray& index, const QStringList& parameters,
+                                                           const QStringList& levels)
+{
+  // Collect offset and match flag for all lines ======================
+  QVector<std::pair<qint64, bool> > entries;
+  for(const QByteArray& line : index.split('\n'))
+  {
+    QList<QByteArray> fields = line.trimmed().split(':');
+    if(fields.size() < 6)
+      continue;
+
+    bool ok;
+    qint64 offset = fields.at(1).toLongLong(&ok);
+    if(!ok)
+      continue;
+
+    bool match = parameters.contains(QString::fromLatin1(fields.at(3))) &&
+                 levels.contains(QString::fromLatin1(fields.at(4)));
+    entries.append(std::make_pair(offset, match));
+  }
+
+  // Build ranges using next offset as end ======================
+  QVector<std::pair<qint64, qint64> > ranges;
+  for(int i = 0; i < entries.size(); i++)
+  {
+    if(!entries.at(i).second)
+      continue;
+
+    qint64 start = entries.at(i).first;
+    qint64 end = i < entries.size() - 1 ? entries.at(i + 1).first - 1 : -1;
+
+    if(!ranges.isEmpty() && ranges.last().second != -1 && ranges.last().second + 1 == start)
+      // Adjacent to previous - merge
+      ranges.last().second = end;
+    else
+      ranges.append(std::make_pair(start, end));
+  }
+  return ranges;
+}
+
 GribDownloader::GribDownloader(QObject *parent, bool logVerbose = false)
   : QObject(parent), verbose(logVerbose)
 {
   downloader = new HttpDownloader(parent, verbose);
   downloader->setAcceptEncoding("gzip");
+
+  updateTimer = new QTimer(this);
+  updateTimer->setSingleShot(true);
+  connect(updateTimer, &QTimer::timeout, this, &GribDownloader::startDownloadInternal);
   connect(downloader, &HttpDownloader::downloadFinished, this, &GribDownloader::downloadFinished);
   connect(downloader, &HttpDownloader::downloadFailed, this, &GribDownloader::downloadFailed);
   connect(downloader, &HttpDownloader::downloadSslErrors, this, &GribDownloader::gribDownloadSslErrors);
@@ -65,7 +112,8 @@ void GribDownloader::startDownload(const QDateTime& timestamp, const QString& ba
   // Files are updated every 6 hours
   datetime = atools::timeToNextHourInterval(timestamp.isValid() ? timestamp : QDateTime::currentDateTimeUtc(), 6);
 
-  downloader->setUpdatePeriod(UPDATE_PERIOD);
+  // Range request mode does several downloads per update and uses own timer
+  downloader->setUpdatePeriod(rangeRequests ? -1 : UPDATE_PERIOD);
   startDownloadInternal();
 }
 
@@ -73,10 +121,14 @@ void GribDownloader::stopDownload()
 {
   if(downloader->isDownloading())
     downloader->cancelDownload();
+  updateTimer->stop();
 
   retries = 0;
   datetime = QDateTime();
   datasets.clear();
+  ranges.clear();
+  rangeData.clear();
+  rangeIndex = -1;
 }
 
 void GribDownloader::startDownloadInternal()
@@ -88,6 +140,31 @@ void GribDownloader::startDownloadInternal()
   // gfs.2019042506
   // gfs.2019042500
 
+  // Need to use C locale due to Qt bug which uses system locale to create date
+  QLocale cLocale(QLocale::C);
+  QString hh(cLocale.toString(datetime, "hh"));
+  QString yyyyMMdd(cLocale.toString(datetime, "yyyyMMdd"));
+
+  if(rangeRequests)
+  {
+    // https://nomads.ncep.noaa.gov/pub/data/nccf/com/gfs/prod/gfs.20190614/00/atmos/gfs.t00z.pgrb2.1p00.anl.idx
+    QString base = baseUrl.isEmpty() ? "https://nomads.ncep.noaa.gov/pub/data/nccf/com/gfs/prod" : baseUrl;
+    rangeUrl = base + "/gfs." + yyyyMMdd + "/" + hh + "/atmos/gfs.t" + hh + "z.pgrb2.1p00.anl";
+    ranges.clear();
+    rangeData.clear();
+    rangeIndex = -1;
+
+    // Ranges refer to the uncompressed file
+    downloader->setAcceptEncoding(QString());
+    downloader->setHeaderParameters(QHash<QString, QString>());
+    downloader->setUrl(rangeUrl + ".idx");
+
+    qDebug() << Q_FUNC_INFO << "Starting index" << downloader->getUrl();
+
+    downloader->startDownload();
+    return;
+  }
+
   // Collect surface parameters ======================
   QString levelStr;
   for(int surface : qAsConst(surfaces))
@@ -115,14 +192,11 @@ void GribDownloader::startDownloadInternal()
   // var_UGRD=on&var_VGRD=on&dir=%2Fgfs.20210323%2F06%2Fatmos
   QString base = baseUrl.isEmpty() ? "https://nomads.ncep.noaa.gov/cgi-bin/filter_gfs_1p00.pl" : baseUrl;
 
-  // Need to use C locale due to Qt bug which uses system locale to create date
-  QLocale cLocale(QLocale::C);
-  QString hh(cLocale.toString(datetime, "hh"));
-  QString yyyyMMdd(cLocale.toString(datetime, "yyyyMMdd"));
-
   QString url = base + "?file=gfs.t" + hh + "z.pgrb2.1p00.anl&" + levelStr + parameterStr + "dir=%2Fgfs." +
                 yyyyMMdd + "%2F" + hh + "%2Fatmos";
 
+  downloader->setAcceptEncoding("gzip");
+  downloader->setHeaderParameters(QHash<QString, QString>());
   downloader->setUrl(url);
 
   qDebug() << Q_FUNC_INFO << "Starting" << url;
@@ -134,13 +208,98 @@ void GribDownloader::downloadFinished(const QByteArray& data, QString downloadUr
 {
   qDebug() << Q_FUNC_INFO << data.size() << downloadUrl;
 
+  if(rangeRequests)
+  {
+    if(rangeIndex == -1)
+      indexDownloadFinished(data);
+    else
+      rangeDownloadFinished(data);
+  }
+  else
+    decodeData(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), downloadUrl);
+}
+
+void GribDownloader::indexDownloadFinished(const QByteArray& data)
+{
+  // Build names as used in index file ======================
+  QStringList levels;
+  for(int surface : qAsConst(surfaces))
+  {
+    if(surface > 0)
+      levels.append(QString("%1 mb").arg(surface));
+    else if(surface < 0)
+      levels.append(QString("%1 m above ground").arg(-surface));
+  }
+
+  ranges = rangesFromIndex(data, parameters, levels);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "ranges" << ranges;
+
+  if(ranges.isEmpty())
+  {
+    downloadFailed(tr("No matching fields found in GRIB index."), 0, downloader->getUrl());
+    return;
+  }
+
+  rangeIndex = 0;
+  rangeData.clear();
+  startRangeDownload();
+}
+
+void GribDownloader::startRangeDownload()
+{
+  const std::pair<qint64, qint64>& range = ranges.at(rangeIndex);
+  QString rangeStr = range.second == -1 ? QString("bytes=%1-").arg(range.first) :
+                     QString("bytes=%1-%2").arg(range.first).arg(range.second);
+
+  downloader->setHeaderParameters({
+    {"Range", rangeStr}
+  });
+  downloader->setUrl(rangeUrl);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << rangeUrl << rangeStr;
+
+  downloader->startDownload();
+}
+
+void GribDownloader::rangeDownloadFinished(const QByteArray& data)
+{
+  const std::pair<qint64, qint64>& range = ranges.at(rangeIndex);
+  qint64 length = range.second == -1 ? -1 : range.second - range.first + 1;
+
+  if(length != -1 && data.size() > length && data.size() > range.first)
+    // Server ignored range and sent the whole file
+    rangeData.append(data.mid(static_cast<int>(range.first), static_cast<int>(length)));
+  else
+    rangeData.append(data);
+
+  if(++rangeIndex < ranges.size())
+    startRangeDownload();
+  else
+  {
+    // All fields loaded - concatenated GRIB messages are a valid file
+    rangeIndex = -1;
+    downloader->setHeaderParameters(QHash<QString, QString>());
+
+    QByteArray gribData;
+    gribData.swap(rangeData);
+    decodeData(gribData, rangeUrl);
+
+    updateTimer->start(UPDATE_PERIOD * 1000);
+  }
+}
+
+void GribDownloader::decodeData(const QByteArray& data, const QString& downloadUrl)
+{
   retries = 0;
 
   try
   {
     // Decode and copy the data
     GribReader reader(verbose);
-    reader.readData(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO));
+    reader.readData(data);
     datasets = reader.getDatasets();
   }
   catch(atools::Exception& e)
@@ -160,6 +319,11 @@ void GribDownloader::downloadFinished(const QByteArray& data, QString downloadUr
 void GribDownloader::downloadFailed(const QString& error, int errorCode, QString downloadUrl)
 {
   qDebug() << Q_FUNC_INFO << errorCode << error << "retries" << retries;
+
+  // Start over with index file in range request mode
+  rangeIndex = -1;
+  rangeData.clear();
+
   if(++retries < MAX_RETRIES)
   {
     // Download failed - try an earlier dataset 6 hours ago
@@ -170,6 +334,9 @@ void GribDownloader::downloadFailed(const QString& error, int errorCode, QString
   {
     // Failed for good
     retries = 0;
+
+    if(rangeRequests)
+      updateTimer->start(UPDATE_PERIOD * 1000);
     emit gribDownloadFailed(error, errorCode, downloadUrl);
   }
 }
@@ -191,6 +358,7 @@ void GribDownloader::debugDumpContainerSizes() const
   qDebug() << Q_FUNC_INFO << "surfaces.size()" << surfaces.size();
   qDebug() << Q_FUNC_INFO << "parameters.size()" << parameters.size();
   qDebug() << Q_FUNC_INFO << "datasets.size()" << datasets.size();
+  qDebug() << Q_FUNC_INFO << "ranges.size()" << ranges.size();
 }
 
 } // namespace grib
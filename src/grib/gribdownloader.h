@@ -24,6 +24,8 @@
 #include <QObject>
 #include <QVector>
 
+class QTimer;
+
 namespace atools {
 
 namespace util {
@@ -40,6 +42,15 @@ namespace grib {
  *
  * Only U/V wind components, full earth bounding rectangle and one-degree raster supported.
  *
+ * Alternatively uses partial downloads from the file server with base URL
+ * https://nomads.ncep.noaa.gov/pub/data/nccf/com/gfs/prod if range requests are enabled.
+ * The ".idx" index file is downloaded first and then only the byte ranges of the required fields.
+ *
+ * Example:
+ * https://nomads.ncep.noaa.gov/pub/data/nccf/com/gfs/prod/gfs.20190614/00/atmos/gfs.t00z.pgrb2.1p00.anl.idx
+ * 1:0:d=2019061400:PRMSL:mean sea level:anl:
+ * 2:1003475:d=2019061400:CLWMR:1 mb:anl:
+ * ...
  */
 class GribDownloader :
   public QObject
@@ -91,6 +102,18 @@ public:
     parameters = value;
   }
 
+  /* Download index file and fetch only the needed fields using HTTP range requests instead of using the filter
+   * script. The base URL given in startDownload() has to point to the file server directory in this case. */
+  void setRangeRequests(bool value)
+  {
+    rangeRequests = value;
+  }
+
+  bool isRangeRequests() const
+  {
+    return rangeRequests;
+  }
+
   /* Get downloaded and decoded datasets after gribDownloadFinished signal. Valid until next download. */
   const atools::grib::GribDatasetVector& getDatasets() const
   {
@@ -123,6 +146,18 @@ private:
   void downloadFailed(const QString& error, int errorCode, QString downloadUrl);
   void startDownloadInternal();
 
+  /* Parse index file and start range downloads */
+  void indexDownloadFinished(const QByteArray& data);
+
+  /* Collect range data and decode when all ranges are complete */
+  void rangeDownloadFinished(const QByteArray& data);
+
+  /* Request next range from rangeIndex */
+  void startRangeDownload();
+
+  /* Decode GRIB data and send signal */
+  void decodeData(const QByteArray& data, const QString& downloadUrl);
+
   /* Maximum retries if the data for the current timestamp is not available. Tries current UTC time minus one hour */
   static const int MAX_RETRIES = 4;
   /* Redownload every UPDATE_PERIOD seconds */
@@ -139,6 +174,24 @@ private:
   /* Use default if empty */
   QString baseUrl;
 
+  /* Range request mode ========================================= */
+  bool rangeRequests = false;
+
+  /* Timer to repeat downloads in range request mode */
+  QTimer *updateTimer = nullptr;
+
+  /* URL of the GRIB file */
+  QString rangeUrl;
+
+  /* Merged byte ranges inclusive of first and last byte. Last is -1 for the rest of the file. */
+  QVector<std::pair<qint64, qint64> > ranges;
+
+  /* Index of range in download or -1 if index file is loaded */
+  int rangeIndex = -1;
+
+  /* Collected GRIB messages */
+  QByteArray rangeData;
+
   bool verbose = false;
   /* Counter for retries if current date is not available */
   int retries = 0;
@@ -17,7 +17,8 @@
 
 #include "grib/gribreader.h"
 #include "geo/calculations.h"
-#include "io/tempfile.h"
+#include "util/parallel.h"
+#include "util/tracing.h"
 #include "exception.h"
 
 extern "C" {
@@ -92,8 +93,8 @@ Q_REQUIRED_RESULT bool checkValue(const QString& message, TYPE value, const QVec
 }
 
 // =====================================================================================
-GribReader::GribReader(bool verboseParam)
-  : verbose(verboseParam)
+GribReader::GribReader(bool verboseParam, int numThreadsParam)
+  : verbose(verboseParam), numThreads(numThreadsParam)
 {
 
 }
@@ -106,386 +107,435 @@ void GribReader::readFile(const QString& filename)
   if(!validateGribFile(filename))
     throw atools::Exception(tr("Not a GRIB file"));
 
-  unsigned char *cgrib;
-  g2int listSection0[3], listSection1[13], numlocal, numfields;
-  long skipBytes, numGribBytes, seekBytes = 0L;
-  g2int expand = 1, unpack = 1, ret, ierr;
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    throw atools::Exception(tr("Cannot open file %1").arg(filename));
+
+  QByteArray data = file.readAll();
+  if(file.error() != QFileDevice::NoError)
+    throw atools::Exception(tr("Cannot read file %1").arg(filename));
+  file.close();
+
+  decode(data, filename);
+}
+
+void GribReader::readData(const QByteArray& data)
+{
+  ATOOLS_TRACE_SPAN("weather", "GribReader::readData");
 
-#if defined(Q_OS_WIN32)
-  // Windows fopen uses local charset for filename - convert UTF-8 to UTF-16 and use wfopen
-  wchar_t *path = new wchar_t[static_cast<unsigned int>(filename.size()) + 1];
-  filename.toWCharArray(path);
-  path[filename.size()] = L'\0';
+  if(data.isEmpty())
+    throw atools::Exception(tr("GRIB data empty"));
+
+  if(!validateGribData(data))
+    throw atools::Exception(tr("Not a GRIB file"));
+
+  datasets.clear();
+  decode(data, tr("GRIB data"));
 
-  FILE *fptr = _wfopen(path, L"rb");
-#else
-  FILE *fptr = fopen(filename.toUtf8().constData(), "rb");
-#endif
+  if(verbose)
+  {
+    qDebug() << Q_FUNC_INFO << "Datasets ============================================================";
+    for(const GribDataset& dataset : qAsConst(datasets))
+      qDebug() << dataset;
+  }
+}
 
-  if(fptr != nullptr)
+QVector<GribReader::GribMessage> GribReader::findMessages(const QByteArray& data)
+{
+  // Same as seekgb() but in memory - search for "GRIB", read the total length from
+  // section 0 and check the end marker "7777"
+  QVector<GribMessage> messages;
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data.constData());
+  qint64 size = data.size(), pos = 0;
+  while(pos + 16 <= size)
   {
-    while(true)
+    if(bytes[pos] == 'G' && bytes[pos + 1] == 'R' && bytes[pos + 2] == 'I' && bytes[pos + 3] == 'B' && bytes[pos + 7] == 2)
     {
-      if(verbose)
-        qDebug() << "======================================================================";
-
-      // Search for next/first GRIB message ========================================
-      seekgb(fptr, seekBytes, 128000, &skipBytes, &numGribBytes);
-      if(numGribBytes == 0)
-        break; // end loop at EOF or problem
-
-      cgrib = new unsigned char[static_cast<size_t>(numGribBytes)];
-      ret = fseek(fptr, skipBytes, SEEK_SET);
-      if(ret != g2int(0))
-        throw atools::Exception(tr("Cannot seek in file %1").arg(filename));
-
-      // Read message ========================================
-      size_t lengrib = fread(cgrib, sizeof(unsigned char), static_cast<size_t>(numGribBytes), fptr);
-      if(lengrib <= 0)
-        throw atools::Exception(tr("Cannot read file %1").arg(filename));
-
-      seekBytes = skipBytes + numGribBytes;
-      ierr = g2_info(cgrib, listSection0, listSection1, &numfields, &numlocal);
-      if(ierr != g2int(0))
-        throw atools::Exception(tr("Cannot read file %1").arg(filename));
-
-      if(verbose)
+      // Total length of GRIB message in octets 9-16 big endian
+      qint64 length = 0;
+      for(int i = 8; i < 16; i++)
+        length = (length << 8) | bytes[pos + i];
+
+      if(length >= 16 && pos + length <= size &&
+         bytes[pos + length - 4] == '7' && bytes[pos + length - 3] == '7' &&
+         bytes[pos + length - 2] == '7' && bytes[pos + length - 1] == '7')
       {
-        qDebug() << Q_FUNC_INFO << "numfields" << numfields << "numlocal" << numlocal;
-        printArrInt(QString(Q_FUNC_INFO) + " Section 0: ", listSection0, 3);
-        printArrInt(QString(Q_FUNC_INFO) + " Section 1: ", listSection1, 13);
+        messages.append({pos, length, 0});
+        pos += length;
+        continue;
       }
+    }
+    pos++;
+  }
+  return messages;
+}
 
-      // Read datasets / GRIB messages ========================================
-      for(long n = 0; n < numfields; n++)
-      {
-        GribDataset dataset;
-
-        gribfield *gribField;
-        ierr = g2_getfld(cgrib, n + 1, unpack, expand, &gribField);
-
-        if(verbose)
-        {
-          // gfld->version = GRIB edition number ( currently 2 )
-          // gfld->discipline = Message Discipline ( see Code Table 0.0 )
-          qDebug() << Q_FUNC_INFO << "===================================";
-          qDebug() << Q_FUNC_INFO << "field" << n << "version" << gribField->version << "discipline" << gribField->discipline;
-        }
-
-        // ID section ====================================================================================
-        // gfld->idsect = Contains the entries in the Identification
-        // Section ( Section 1 )
-        // This element is a pointer to an array
-        // that holds the data.
-        // gfld->idsect[0]  = Identification of originating Centre
-        // ( see Common Code Table C-1 )
-        // 7 - US National Weather Service
-        // gfld->idsect[1]  = Identification of originating Sub-centre
-        // gfld->idsect[2]  = GRIB Master Tables Version Number
-        // ( see Code Table 1.0 )
-        // 0 - Experimental
-        // 1 - Initial operational version number
-        // gfld->idsect[3]  = GRIB Local Tables Version Number
-        // ( see Code Table 1.1 )
-        // 0     - Local tables not used
-        // 1-254 - Number of local tables version used
-        // gfld->idsect[4]  = Significance of Reference Time (Code Table 1.2)
-        // 0 - Analysis
-        // 1 - Start of forecast
-        // 2 - Verifying time of forecast
-        // 3 - Observation time
-        // gfld->idsect[5]  = Year ( 4 digits )
-        // gfld->idsect[6]  = Month
-        // gfld->idsect[7)  = Day
-        // gfld->idsect[8]  = Hour
-        // gfld->idsect[9]  = Minute
-        // gfld->idsect[10]  = Second
-        // gfld->idsect[11]  = Production status of processed data
-        // ( see Code Table 1.3 )
-        // 0 - Operational products
-        // 1 - Operational test products
-        // 2 - Research products
-        // 3 - Re-analysis products
-        // gfld->idsect[12]  = Type of processed data ( see Code Table 1.4 )
-        // 0  - Analysis products
-        // 1  - Forecast products
-        // 2  - Analysis and forecast products
-        // 3  - Control forecast products
-        // 4  - Perturbed forecast products
-        // 5  - Control and perturbed forecast products
-        // 6  - Processed satellite observations
-        // 7  - Processed radar observations
-        if(verbose)
-          printArrInt("idsect", gribField->idsect, gribField->idsectlen);
-
-        if(gribField->idsectlen > 11)
-        {
-          // Read timestamp  ========================================
-          dataset.datetime = QDateTime(QDate(static_cast<int>(gribField->idsect[5]),
-                                             static_cast<int>(gribField->idsect[6]),
-                                             static_cast<int>(gribField->idsect[7])),
-                                       QTime(static_cast<int>(gribField->idsect[8]),
-                                             static_cast<int>(gribField->idsect[9]),
-                                             static_cast<int>(gribField->idsect[10])), Qt::UTC);
-        }
-        if(!checkValue("Datetime is not valid", dataset.datetime.isValid(), true))
-          continue;
-
-        // gfld->ifldnum = field number within GRIB message
-        if(verbose)
-          qDebug() << "ifldnum" << gribField->ifldnum;
-
-        // Grid definition ====================================================================================
-        // gfld->griddef = Source of grid definition (see Code Table 3.0)
-        // 0 - Specified in Code table 3.1
-        // 1 - Predetermined grid Defined by originating centre
-        // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-0.shtml
-        if(verbose)
-          qDebug() << Q_FUNC_INFO << "griddef" << gribField->griddef;
-        if(!checkValue("Grid definition", gribField->griddef, g2int(0)))
-          continue;
-
-        // gfld->igdtnum = Grid Definition Template Number (Code Table 3.1)
-        // Latitude/Longitude (See Template 3.0)
-        // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-1.shtml
-        if(verbose)
-          qDebug() << Q_FUNC_INFO << "igdtnum" << gribField->igdtnum;
-        if(!checkValue("Grid Definition Template Number", gribField->igdtnum, g2int(0)))
-          continue;
-
-        // gfld->igdtmpl  = Contains the data values for the specified Grid
-        // Definition Template ( NN=gfld->igdtnum ).  Each
-        // element of this integer array contains an entry (in
-        // the order specified) of Grid Defintion Template 3.NN
-        // This element is a pointer to an array
-        // that holds the data.
-        // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_temp3-0.shtml
-
-        // 0	/  15	Shape of the Earth (See Code Table 3.2)
-        // 1	/  16	Scale Factor of radius of spherical Earth
-        // 2	/  17-20	Scale value of radius of spherical Earth
-        // 3	/  21	Scale factor of major axis of oblate spheroid Earth
-        // 4	/  22-25	Scaled value of major axis of oblate spheroid Earth
-        // 5	/  26	Scale factor of minor axis of oblate spheroid Earth
-        // 6	/  27-30	Scaled value of minor axis of oblate spheroid Earth
-        // 7	/  31-34	Ni — number of points along a parallel
-        // 8	/  35-38	Nj — number of points along a meridian
-        // 9	/  39-42	Basic angle of the initial production domain (see Note 1)
-        // 10	/  43-46	Subdivisions of basic angle used to define extreme longitudes and latitudes, and direction increments (see Note 1)
-        // 11	/  47-50	La1 — latitude of first grid point (see Note 1)
-        // 12	/  51-54	Lo1 — longitude of first grid point (see Note 1)
-        // 13	/  55	Resolution and component flags (see Flag Table 3.3)
-        // 14	/  56-59	La2 — latitude of last grid point (see Note 1)
-        // 15	/  60-63	Lo2 — longitude of last grid point (see Note 1)
-        // 16	/  64-67	Di — i direction increment (see Notes 1 and 5)
-        // 17	/  68-71	Dj — j direction increment (see Note 1 and 5)
-        // 18	/  72	Scanning mode (flags — see Flag Table 3.4 and Note 6)
-        // List of number of points along each meridian or parallel
-        // (These octets are only present for quasi-regular grids as described in notes 2 and 3)
-
-        if(verbose)
-          // -      [0, 1, 2, 3, 4, 5, 6,   7,   8, 9,         10,       11,12, 13,        14,        15,      16,      17,18]
-          // igdtmpl[6, 0, 0, 0, 0, 0, 0, 360, 181, 0, 4294967295, 90000000, 0, 48, -90000000, 359000000, 1000000, 1000000, 0]
-          printArrInt("igdtmpl", gribField->igdtmpl, gribField->igdtlen);
-
-        if(!checkValue("shape of earth", gribField->igdtmpl[0], g2int(6)))
-          continue;
-        if(!checkValue("radius scale factor", gribField->igdtmpl[1], g2int(0)))
-          continue;
-        if(!checkValue("scale value", gribField->igdtmpl[2], g2int(0)))
-          continue;
-        if(!checkValue("scale factor of major axis", gribField->igdtmpl[3], g2int(0)))
-          continue;
-        if(!checkValue("scale value of major axis", gribField->igdtmpl[4], g2int(0)))
-          continue;
-        if(!checkValue("scale factor of minor axis", gribField->igdtmpl[5], g2int(0)))
-          continue;
-        if(!checkValue("scale value of minor axis", gribField->igdtmpl[6], g2int(0)))
-          continue;
-        if(!checkValue("Ni", gribField->igdtmpl[7], g2int(360)))
-          continue;
-        if(!checkValue("Nj", gribField->igdtmpl[8], g2int(181)))
-          continue;
-        if(!checkValue("Basic angle", gribField->igdtmpl[9], g2int(0)))
-          continue;
-        if(!checkValue("resolution component flags", gribField->igdtmpl[13], g2int(48)))
-          continue;
-        if(!checkValue("scanning mode flags", gribField->igdtmpl[18], g2int(0)))
-          continue;
-
-        // if(!checkValue("i increment", gfld->igdtmpl[16], g2int(1))) continue;
-        // if(!checkValue("j increment", gfld->igdtmpl[17], g2int(1))) continue;
-
-        // g2int di = gfld->igdtmpl[16], dj = gfld->igdtmpl[17];
-        // dataset.firstLatY = gfld->igdtmpl[11] / dj;
-        // dataset.firstLonX = gfld->igdtmpl[12] / di;
-        // dataset.lastLatY = gfld->igdtmpl[14] / dj;
-        // dataset.lastLonX = gfld->igdtmpl[15] / di;
-
-        // Product definition ====================================================================================
-        // gfdl->ipdtnum = Product Definition Template Number(see Code Table 4.0)
-        // Analysis or forecast at a horizontal level or in a horizontal layer at a point in time.
-        if(verbose)
-          qDebug() << "ipdtnum" << gribField->ipdtnum;
-
-        // gfld->ipdtmpl  = Contains the data values for the specified Product
-        // Definition Template ( N=gfdl->ipdtnum ). Each element
-        // of this integer array contains an entry (in the
-        // order specified) of Product Defintion Template 4.N.
-        // This element is a pointer to an array
-        // that holds the data.
-        // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_temp4-0.shtml
-        // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table4-2-0-2.shtml
-        // 0	/ 10 Parameter category (see Code table 4.1)
-        // 1	/ 11 Parameter number (see Code table 4.2)
-        // 2	/ 12 Type of generating process (see Code table 4.3)
-        // 3	/ 13 Background generating process identifier (defined by originating centre)
-        // 4	/ 14 Analysis or forecast generating process identified (see Code ON388 Table A)
-        // 5	/ 15-16 Hours of observational data cutoff after reference time (see Note)
-        // 6	/ 17 Minutes of observational data cutoff after reference time (see Note)
-        // 7	/ 18 Indicator of unit of time range (see Code table 4.4)
-        // 8	/ 19-22 Forecast time in units defined by octet 18
-        // 9	/ 23 Type of first fixed surface (see Code table 4.5)
-        // 10	/ 24 Scale factor of first fixed surface
-        // 11	/ 25-28 Scaled value of first fixed surface
-        // 12	/ 29 Type of second fixed surfaced (see Code table 4.5)
-        // 13	/ 30 Scale factor of second fixed surface
-        // 14	/ 31-34 Scaled value of second fixed surfaces
-        // -          [0, 1, 2, 3,  4, 5, 6, 7, 8,   9,10,    11,  12,13,14
-        // ipdtmpl(15)[2, 2, 0, 0, 81, 0, 0, 1, 0, 100, 0, 20000, 255, 0, 0]
-        if(verbose)
-          printArrInt("ipdtmpl", gribField->ipdtmpl, gribField->ipdtlen);
-
-        if(!checkValue("Parameter category", gribField->ipdtmpl[0], g2int(2)))
-          continue;
-        if(!checkValue("Parameter number", gribField->ipdtmpl[1], {g2int(2), g2int(3)}))
-          continue;
-        if(gribField->ipdtmpl[1] == 2)
-          dataset.parameterType = U_WIND;
-        else if(gribField->ipdtmpl[1] == 3)
-          dataset.parameterType = V_WIND;
-
-        if(!checkValue("Time range", gribField->ipdtmpl[7], g2int(1)))
-          continue;
-        if(!checkValue("Surface type", gribField->ipdtmpl[9], {g2int(100), g2int(103)}))
-          continue;
-        if(gribField->ipdtmpl[9] == 100)
-        {
-          dataset.surfaceType = MBAR;
-          dataset.surface =
-            (gribField->ipdtmpl[11] / (gribField->ipdtmpl[10] > 0 ? gribField->ipdtmpl[10] : 1.f)) / 100.f;
-          dataset.altFeetCalculated = atools::geo::meterToFeet(atools::geo::altMeterForPressureMbar(dataset.surface));
-          // Round altitude to the next 2000 feet
-          dataset.altFeetRounded = std::round(dataset.altFeetCalculated / 2000.f) * 2000.f;
-        }
-        else if(gribField->ipdtmpl[9] == 103)
-        {
-          dataset.surfaceType = METER_AGL;
-          dataset.surface = gribField->ipdtmpl[11] / (gribField->ipdtmpl[10] > 0 ? gribField->ipdtmpl[10] : 1.f);
-          dataset.altFeetCalculated = atools::geo::meterToFeet(dataset.surface);
-          // Round altitude to the next 2000 feet
-          dataset.altFeetRounded = std::round(dataset.altFeetCalculated / 10.f) * 10.f;
-        }
-
-        if(!checkValue("Second surface scale factor", gribField->ipdtmpl[13], g2int(0)))
-          continue;
-        if(!checkValue("Second surface value", gribField->ipdtmpl[14], g2int(0)))
-          continue;
-
-        if(verbose)
-          qDebug() << "Calculated altitude" << dataset.altFeetCalculated
-                   << "rounded altitude" << dataset.altFeetRounded;
-
-        // Pack/unpack flags (ignored) ====================================================================================
-        // gfld->unpacked = logical value indicating whether the bitmap and
-        // data values were unpacked.  If false,
-        if(!checkValue("Unpacked", gribField->unpacked, g2int(1)))
-          continue;
-        // gfld->bmap and gfld->fld pointers are nullified.
-        // gfld->expanded = Logical value indicating whether the data field
-        // was expanded to the grid in the case where a
-        // bit-map is present.  If true, the data points in
-        // gfld->fld match the grid points and zeros were
-        // inserted at grid points where data was bit-mapped
-        // out.  If false, the data values in gfld->fld were
-        // not expanded to the grid and are just a consecutive
-        // array of data points corresponding to each value of
-        // "1" in gfld->bmap.
-        if(!checkValue("Unpacked", gribField->expanded, g2int(1)))
-          continue;
-        // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-3.shtml
-
-        // Data ====================================================================================
-        // gfld->fld  = Array of gfld->ndpts unpacked data points.
-        if(verbose)
-          printArrFloat("fld", gribField->fld, std::min(gribField->ndpts, g2int(100)));
-
-        if(verbose)
-          qDebug() << Q_FUNC_INFO
-                   << "param type" << dataset.parameterType
-                   << "surface" << dataset.surface
-                   << "surface type" << dataset.surfaceType
-                   << "alt calculated" << dataset.altFeetCalculated
-                   << "alt rounded" << dataset.altFeetRounded;
-
-        // Copy data as is
-        for(int i = 0; i < gribField->ndpts; i++)
-          dataset.data.append(gribField->fld[i]);
-
-        datasets.append(dataset);
-
-        // checkValue("Number of values", g2int(dataset.data.size()),
-        // g2int(std::abs(dataset.lastLonX - dataset.firstLonX + 1) *
-        // std::abs(dataset.firstLatY - dataset.lastLatY + 1)));
-
-        g2_free(gribField);
-      }
-      delete[] cgrib;
+void GribReader::decode(const QByteArray& data, const QString& name)
+{
+  // g2clib does not modify the message buffer but uses non-const pointers
+  unsigned char *bytes = reinterpret_cast<unsigned char *>(const_cast<char *>(data.constData()));
+
+  // Extract message offsets and number of fields once ========================================
+  QVector<GribMessage> messages = findMessages(data);
+  QVector<QPair<int, int> > fields; // Message index and field number starting at 1
+  for(int m = 0; m < messages.size(); m++)
+  {
+    GribMessage& message = messages[m];
+    g2int listSection0[3], listSection1[13], numlocal, numfields;
+    g2int ierr = g2_info(bytes + message.offset, listSection0, listSection1, &numfields, &numlocal);
+    if(ierr != g2int(0))
+      throw atools::Exception(tr("Cannot read file %1").arg(name));
+
+    if(verbose)
+    {
+      qDebug() << "======================================================================";
+      qDebug() << Q_FUNC_INFO << "numfields" << numfields << "numlocal" << numlocal;
+      printArrInt(QString(Q_FUNC_INFO) + " Section 0: ", listSection0, 3);
+      printArrInt(QString(Q_FUNC_INFO) + " Section 1: ", listSection1, 13);
     }
 
-    // Sort first by altitude from low to high and second by parameter type from U to V
-    std::sort(datasets.begin(), datasets.end(),
-              [](const atools::grib::GribDataset& d1, const atools::grib::GribDataset& d2) -> bool
-        {
-          if(atools::almostEqual(d1.altFeetCalculated, d2.altFeetCalculated))
-            return d1.parameterType < d2.parameterType;
-          else
-            return d1.altFeetCalculated < d2.altFeetCalculated;
-        });
-
-    fclose(fptr);
+    message.numFields = static_cast<int>(numfields);
+    for(int n = 0; n < message.numFields; n++)
+      fields.append(qMakePair(m, n + 1));
   }
+
+  // Decode datasets / GRIB fields ========================================
+  // Fields are independent from each other - decode in parallel unless verbose output is requested
+  QVector<GribDataset> decoded(fields.size());
+  QVector<bool> valid(fields.size(), false);
+
+  // Use raw pointers to avoid detach checks in threads
+  GribDataset *decodedData = decoded.data();
+  bool *validData = valid.data();
+  auto decodeRange = [&](int begin, int end, int) -> void {
+                       for(int i = begin; i < end; i++)
+                       {
+                         const QPair<int, int>& field = fields.at(i);
+                         validData[i] = decodeField(bytes + messages.at(field.first).offset, field.second,
+                                                    decodedData[i], verbose);
+                       }
+                     };
+
+  if(verbose || numThreads == 1 || fields.size() < 2)
+    decodeRange(0, fields.size(), 0);
   else
-    throw atools::Exception(tr("Cannot open file %1").arg(filename));
+  {
+    // Decode first field in this thread to initialize static values in g2clib like in rdieee()
+    decodeRange(0, 1, 0);
+    atools::util::parallelFor(fields.size() - 1, numThreads, [&](int begin, int end, int chunk) -> void {
+      decodeRange(begin + 1, end + 1, chunk);
+    }, 1);
+  }
 
-#if defined(Q_OS_WIN32)
-  delete[] path;
-#endif
+  // Move valid datasets in file order
+  for(int i = 0; i < decoded.size(); i++)
+  {
+    if(valid.at(i))
+      datasets.append(std::move(decoded[i]));
+  }
+
+  // Sort first by altitude from low to high and second by parameter type from U to V
+  std::sort(datasets.begin(), datasets.end(),
+            [](const atools::grib::GribDataset& d1, const atools::grib::GribDataset& d2) -> bool
+      {
+        if(atools::almostEqual(d1.altFeetCalculated, d2.altFeetCalculated))
+          return d1.parameterType < d2.parameterType;
+        else
+          return d1.altFeetCalculated < d2.altFeetCalculated;
+      });
 
   if(datasets.isEmpty())
     throw atools::Exception(tr("Wrong GRIB file type"));
 }
 
-void GribReader::readData(const QByteArray& data)
+bool GribReader::decodeField(unsigned char *cgrib, int fieldNumber, GribDataset& dataset, bool verbose)
 {
-  if(data.isEmpty())
-    throw atools::Exception(tr("GRIB data empty"));
+  gribfield *gribField = nullptr;
+  g2int ierr = g2_getfld(cgrib, fieldNumber, 1 /* unpack */, 1 /* expand */, &gribField);
+  if(ierr != g2int(0))
+  {
+    qWarning() << Q_FUNC_INFO << "GribReader: Error reading field" << fieldNumber << "code" << ierr;
+    if(gribField != nullptr)
+      g2_free(gribField);
+    return false;
+  }
 
-  if(!validateGribData(data))
-    throw atools::Exception(tr("Not a GRIB file"));
+  bool ok = decodeField(gribField, fieldNumber, dataset, verbose);
+  g2_free(gribField);
+  return ok;
+}
 
-  // Create a temporary file since the GRIB reader can only deal with files
-  atools::io::TempFile temp(data, ".grib");
+bool GribReader::decodeField(const gribfield *gribField, int fieldNumber, GribDataset& dataset, bool verbose)
+{
+  if(verbose)
+  {
+    // gfld->version = GRIB edition number ( currently 2 )
+    // gfld->discipline = Message Discipline ( see Code Table 0.0 )
+    qDebug() << Q_FUNC_INFO << "===================================";
+    qDebug() << Q_FUNC_INFO << "field" << fieldNumber << "version" << gribField->version << "discipline" << gribField->discipline;
+  }
 
-  datasets.clear();
-  readFile(temp.getFilePath());
+  // ID section ====================================================================================
+  // gfld->idsect = Contains the entries in the Identification
+  // Section ( Section 1 )
+  // This element is a pointer to an array
+  // that holds the data.
+  // gfld->idsect[0]  = Identification of originating Centre
+  // ( see Common Code Table C-1 )
+  // 7 - US National Weather Service
+  // gfld->idsect[1]  = Identification of originating Sub-centre
+  // gfld->idsect[2]  = GRIB Master Tables Version Number
+  // ( see Code Table 1.0 )
+  // 0 - Experimental
+  // 1 - Initial operational version number
+  // gfld->idsect[3]  = GRIB Local Tables Version Number
+  // ( see Code Table 1.1 )
+  // 0     - Local tables not used
+  // 1-254 - Number of local tables version used
+  // gfld->idsect[4]  = Significance of Reference Time (Code Table 1.2)
+  // 0 - Analysis
+  // 1 - Start of forecast
+  // 2 - Verifying time of forecast
+  // 3 - Observation time
+  // gfld->idsect[5]  = Year ( 4 digits )
+  // gfld->idsect[6]  = Month
+  // gfld->idsect[7)  = Day
+  // gfld->idsect[8]  = Hour
+  // gfld->idsect[9]  = Minute
+  // gfld->idsect[10]  = Second
+  // gfld->idsect[11]  = Production status of processed data
+  // ( see Code Table 1.3 )
+  // 0 - Operational products
+  // 1 - Operational test products
+  // 2 - Research products
+  // 3 - Re-analysis products
+  // gfld->idsect[12]  = Type of processed data ( see Code Table 1.4 )
+  // 0  - Analysis products
+  // 1  - Forecast products
+  // 2  - Analysis and forecast products
+  // 3  - Control forecast products
+  // 4  - Perturbed forecast products
+  // 5  - Control and perturbed forecast products
+  // 6  - Processed satellite observations
+  // 7  - Processed radar observations
+  if(verbose)
+    printArrInt("idsect", gribField->idsect, gribField->idsectlen);
+
+  if(gribField->idsectlen > 11)
+  {
+    // Read timestamp  ========================================
+    dataset.datetime = QDateTime(QDate(static_cast<int>(gribField->idsect[5]),
+                                       static_cast<int>(gribField->idsect[6]),
+                                       static_cast<int>(gribField->idsect[7])),
+                                 QTime(static_cast<int>(gribField->idsect[8]),
+                                       static_cast<int>(gribField->idsect[9]),
+                                       static_cast<int>(gribField->idsect[10])), Qt::UTC);
+  }
+  if(!checkValue("Datetime is not valid", dataset.datetime.isValid(), true))
+    return false;
+
+  // gfld->ifldnum = field number within GRIB message
+  if(verbose)
+    qDebug() << "ifldnum" << gribField->ifldnum;
+
+  // Grid definition ====================================================================================
+  // gfld->griddef = Source of grid definition (see Code Table 3.0)
+  // 0 - Specified in Code table 3.1
+  // 1 - Predetermined grid Defined by originating centre
+  // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-0.shtml
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "griddef" << gribField->griddef;
+  if(!checkValue("Grid definition", gribField->griddef, g2int(0)))
+    return false;
+
+  // gfld->igdtnum = Grid Definition Template Number (Code Table 3.1)
+  // Latitude/Longitude (See Template 3.0)
+  // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-1.shtml
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "igdtnum" << gribField->igdtnum;
+  if(!checkValue("Grid Definition Template Number", gribField->igdtnum, g2int(0)))
+    return false;
+
+  // gfld->igdtmpl  = Contains the data values for the specified Grid
+  // Definition Template ( NN=gfld->igdtnum ).  Each
+  // element of this integer array contains an entry (in
+  // the order specified) of Grid Defintion Template 3.NN
+  // This element is a pointer to an array
+  // that holds the data.
+  // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_temp3-0.shtml
+
+  // 0	/  15	Shape of the Earth (See Code Table 3.2)
+  // 1	/  16	Scale Factor of radius of spherical Earth
+  // 2	/  17-20	Scale value of radius of spherical Earth
+  // 3	/  21	Scale factor of major axis of oblate spheroid Earth
+  // 4	/  22-25	Scaled value of major axis of oblate spheroid Earth
+  // 5	/  26	Scale factor of minor axis of oblate spheroid Earth
+  // 6	/  27-30	Scaled value of minor axis of oblate spheroid Earth
+  // 7	/  31-34	Ni — number of points along a parallel
+  // 8	/  35-38	Nj — number of points along a meridian
+  // 9	/  39-42	Basic angle of the initial production domain (see Note 1)
+  // 10	/  43-46	Subdivisions of basic angle used to define extreme longitudes and latitudes, and direction increments (see Note 1)
+  // 11	/  47-50	La1 — latitude of first grid point (see Note 1)
+  // 12	/  51-54	Lo1 — longitude of first grid point (see Note 1)
+  // 13	/  55	Resolution and component flags (see Flag Table 3.3)
+  // 14	/  56-59	La2 — latitude of last grid point (see Note 1)
+  // 15	/  60-63	Lo2 — longitude of last grid point (see Note 1)
+  // 16	/  64-67	Di — i direction increment (see Notes 1 and 5)
+  // 17	/  68-71	Dj — j direction increment (see Note 1 and 5)
+  // 18	/  72	Scanning mode (flags — see Flag Table 3.4 and Note 6)
+  // List of number of points along each meridian or parallel
+  // (These octets are only present for quasi-regular grids as described in notes 2 and 3)
+
+  if(verbose)
+    // -      [0, 1, 2, 3, 4, 5, 6,   7,   8, 9,         10,       11,12, 13,        14,        15,      16,      17,18]
+    // igdtmpl[6, 0, 0, 0, 0, 0, 0, 360, 181, 0, 4294967295, 90000000, 0, 48, -90000000, 359000000, 1000000, 1000000, 0]
+    printArrInt("igdtmpl", gribField->igdtmpl, gribField->igdtlen);
+
+  if(!checkValue("shape of earth", gribField->igdtmpl[0], g2int(6)))
+    return false;
+  if(!checkValue("radius scale factor", gribField->igdtmpl[1], g2int(0)))
+    return false;
+  if(!checkValue("scale value", gribField->igdtmpl[2], g2int(0)))
+    return false;
+  if(!checkValue("scale factor of major axis", gribField->igdtmpl[3], g2int(0)))
+    return false;
+  if(!checkValue("scale value of major axis", gribField->igdtmpl[4], g2int(0)))
+    return false;
+  if(!checkValue("scale factor of minor axis", gribField->igdtmpl[5], g2int(0)))
+    return false;
+  if(!checkValue("scale value of minor axis", gribField->igdtmpl[6], g2int(0)))
+    return false;
+  if(!checkValue("Ni", gribField->igdtmpl[7], g2int(360)))
+    return false;
+  if(!checkValue("Nj", gribField->igdtmpl[8], g2int(181)))
+    return false;
+  if(!checkValue("Basic angle", gribField->igdtmpl[9], g2int(0)))
+    return false;
+  if(!checkValue("resolution component flags", gribField->igdtmpl[13], g2int(48)))
+    return false;
+  if(!checkValue("scanning mode flags", gribField->igdtmpl[18], g2int(0)))
+    return false;
+
+  // if(!checkValue("i increment", gfld->igdtmpl[16], g2int(1))) return false;
+  // if(!checkValue("j increment", gfld->igdtmpl[17], g2int(1))) return false;
 
+  // g2int di = gfld->igdtmpl[16], dj = gfld->igdtmpl[17];
+  // dataset.firstLatY = gfld->igdtmpl[11] / dj;
+  // dataset.firstLonX = gfld->igdtmpl[12] / di;
+  // dataset.lastLatY = gfld->igdtmpl[14] / dj;
+  // dataset.lastLonX = gfld->igdtmpl[15] / di;
+
+  // Product definition ====================================================================================
+  // gfdl->ipdtnum = Product Definition Template Number(see Code Table 4.0)
+  // Analysis or forecast at a horizontal level or in a horizontal layer at a point in time.
+  if(verbose)
+    qDebug() << "ipdtnum" << gribField->ipdtnum;
+
+  // gfld->ipdtmpl  = Contains the data values for the specified Product
+  // Definition Template ( N=gfdl->ipdtnum ). Each element
+  // of this integer array contains an entry (in the
+  // order specified) of Product Defintion Template 4.N.
+  // This element is a pointer to an array
+  // that holds the data.
+  // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_temp4-0.shtml
+  // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table4-2-0-2.shtml
+  // 0	/ 10 Parameter category (see Code table 4.1)
+  // 1	/ 11 Parameter number (see Code table 4.2)
+  // 2	/ 12 Type of generating process (see Code table 4.3)
+  // 3	/ 13 Background generating process identifier (defined by originating centre)
+  // 4	/ 14 Analysis or forecast generating process identified (see Code ON388 Table A)
+  // 5	/ 15-16 Hours of observational data cutoff after reference time (see Note)
+  // 6	/ 17 Minutes of observational data cutoff after reference time (see Note)
+  // 7	/ 18 Indicator of unit of time range (see Code table 4.4)
+  // 8	/ 19-22 Forecast time in units defined by octet 18
+  // 9	/ 23 Type of first fixed surface (see Code table 4.5)
+  // 10	/ 24 Scale factor of first fixed surface
+  // 11	/ 25-28 Scaled value of first fixed surface
+  // 12	/ 29 Type of second fixed surfaced (see Code table 4.5)
+  // 13	/ 30 Scale factor of second fixed surface
+  // 14	/ 31-34 Scaled value of second fixed surfaces
+  // -          [0, 1, 2, 3,  4, 5, 6, 7, 8,   9,10,    11,  12,13,14
+  // ipdtmpl(15)[2, 2, 0, 0, 81, 0, 0, 1, 0, 100, 0, 20000, 255, 0, 0]
   if(verbose)
+    printArrInt("ipdtmpl", gribField->ipdtmpl, gribField->ipdtlen);
+
+  if(!checkValue("Parameter category", gribField->ipdtmpl[0], g2int(2)))
+    return false;
+  if(!checkValue("Parameter number", gribField->ipdtmpl[1], {g2int(2), g2int(3)}))
+    return false;
+  if(gribField->ipdtmpl[1] == 2)
+    dataset.parameterType = U_WIND;
+  else if(gribField->ipdtmpl[1] == 3)
+    dataset.parameterType = V_WIND;
+
+  if(!checkValue("Time range", gribField->ipdtmpl[7], g2int(1)))
+    return false;
+  if(!checkValue("Surface type", gribField->ipdtmpl[9], {g2int(100), g2int(103)}))
+    return false;
+  if(gribField->ipdtmpl[9] == 100)
   {
-    qDebug() << Q_FUNC_INFO << "Datasets ============================================================";
-    for(const GribDataset& dataset : qAsConst(datasets))
-      qDebug() << dataset;
+    dataset.surfaceType = MBAR;
+    dataset.surface =
+      (gribField->ipdtmpl[11] / (gribField->ipdtmpl[10] > 0 ? gribField->ipdtmpl[10] : 1.f)) / 100.f;
+    dataset.altFeetCalculated = atools::geo::meterToFeet(atools::geo::altMeterForPressureMbar(dataset.surface));
+    // Round altitude to the next 2000 feet
+    dataset.altFeetRounded = std::round(dataset.altFeetCalculated / 2000.f) * 2000.f;
   }
+  else if(gribField->ipdtmpl[9] == 103)
+  {
+    dataset.surfaceType = METER_AGL;
+    dataset.surface = gribField->ipdtmpl[11] / (gribField->ipdtmpl[10] > 0 ? gribField->ipdtmpl[10] : 1.f);
+    dataset.altFeetCalculated = atools::geo::meterToFeet(dataset.surface);
+    // Round altitude to the next 2000 feet
+    dataset.altFeetRounded = std::round(dataset.altFeetCalculated / 10.f) * 10.f;
+  }
+
+  if(!checkValue("Second surface scale factor", gribField->ipdtmpl[13], g2int(0)))
+    return false;
+  if(!checkValue("Second surface value", gribField->ipdtmpl[14], g2int(0)))
+    return false;
+
+  if(verbose)
+    qDebug() << "Calculated altitude" << dataset.altFeetCalculated
+             << "rounded altitude" << dataset.altFeetRounded;
+
+  // Pack/unpack flags (ignored) ====================================================================================
+  // gfld->unpacked = logical value indicating whether the bitmap and
+  // data values were unpacked.  If false,
+  if(!checkValue("Unpacked", gribField->unpacked, g2int(1)))
+    return false;
+  // gfld->bmap and gfld->fld pointers are nullified.
+  // gfld->expanded = Logical value indicating whether the data field
+  // was expanded to the grid in the case where a
+  // bit-map is present.  If true, the data points in
+  // gfld->fld match the grid points and zeros were
+  // inserted at grid points where data was bit-mapped
+  // out.  If false, the data values in gfld->fld were
+  // not expanded to the grid and are just a consecutive
+  // array of data points corresponding to each value of
+  // "1" in gfld->bmap.
+  if(!checkValue("Unpacked", gribField->expanded, g2int(1)))
+    return false;
+  // https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-3.shtml
+
+  // Data ====================================================================================
+  // gfld->fld  = Array of gfld->ndpts unpacked data points.
+  if(verbose)
+    printArrFloat("fld", gribField->fld, std::min(gribField->ndpts, g2int(100)));
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO
+             << "param type" << dataset.parameterType
+             << "surface" << dataset.surface
+             << "surface type" << dataset.surfaceType
+             << "alt calculated" << dataset.altFeetCalculated
+             << "alt rounded" << dataset.altFeetRounded;
+
+  // Copy data as is in one block
+  dataset.data.resize(static_cast<int>(gribField->ndpts));
+  std::copy(gribField->fld, gribField->fld + gribField->ndpts, dataset.data.begin());
+
+  return true;
 }
 
 void GribReader::clear()
@@ -23,6 +23,10 @@
 #include <QVector>
 #include <QCoreApplication>
 
+extern "C" {
+struct gribfield;
+}
+
 namespace atools {
 namespace grib {
 
@@ -31,6 +35,8 @@ namespace grib {
  * Only U/V wind, full earth bounding rectangle and one-degree raster supported.
  * Throws atools::Exception if parameters are not correct.
  *
+ * Message offsets are extracted once and all fields are decoded in parallel since they are independent.
+ *
  * https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/
  * https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-1.shtml
  */
@@ -39,7 +45,9 @@ class GribReader
   Q_DECLARE_TR_FUNCTIONS(GribReader)
 
 public:
-  GribReader(bool verboseParam = false);
+  /* numThreadsParam: Threads for decoding fields. 0 uses the number of cores and 1 decodes sequentially.
+   * Always sequential if verbose for readable output. */
+  GribReader(bool verboseParam = false, int numThreadsParam = 0);
 
   /* Reads a GRIB dataset from a file or byte array.
    * Throws atools::Exception if parameters are not correct. */
@@ -60,8 +68,28 @@ public:
   static bool validateGribData(QByteArray bytes);
 
 private:
+  /* Position and number of fields of a GRIB message in the data */
+  struct GribMessage
+  {
+    qint64 offset, length;
+    int numFields;
+  };
+
+  /* Find all complete messages in data */
+  static QVector<GribMessage> findMessages(const QByteArray& data);
+
+  /* Decode all fields of all messages in data and append them to datasets. name is used for error messages. */
+  void decode(const QByteArray& data, const QString& name);
+
+  /* Decode field number (1 based) of GRIB message cgrib. Returns false if field cannot be used.
+   * Thread safe. */
+  static bool decodeField(unsigned char *cgrib, int fieldNumber, atools::grib::GribDataset& dataset, bool verbose);
+  static bool decodeField(const gribfield *gribField, int fieldNumber, atools::grib::GribDataset& dataset,
+                          bool verbose);
+
   atools::grib::GribDatasetVector datasets;
   bool verbose = false;
+  int numThreads = 0;
 };
 
 } // namespace grib
@@ -0,0 +1,323 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "grib/windforecast.h"
+
+#include "atools.h"
+#include "exception.h"
+#include "geo/calculations.h"
+#include "geo/pos.h"
+#include "grib/gribreader.h"
+#include "grib/windgrid.h"
+
+#include <QDebug>
+#include <QMap>
+
+#include <algorithm>
+
+namespace atools {
+namespace grib {
+
+using atools::geo::Pos;
+
+WindForecast::WindForecast()
+{
+
+}
+
+WindForecast::~WindForecast()
+{
+
+}
+
+void WindForecast::addHour(const QDateTime& validTime, const QString& filename)
+{
+  Hour hour;
+  hour.validTimeMs = validTime.toMSecsSinceEpoch();
+  hour.filename = filename;
+  insertHour(hour);
+}
+
+void WindForecast::addHour(const QDateTime& validTime, const QByteArray& gribData)
+{
+  Hour hour;
+  hour.validTimeMs = validTime.toMSecsSinceEpoch();
+  hour.gribData = gribData;
+  insertHour(hour);
+}
+
+void WindForecast::insertHour(const Hour& hour)
+{
+  auto it = std::lower_bound(hours.begin(), hours.end(), hour.validTimeMs, [](const Hour& h, qint64 time) -> bool {
+    return h.validTimeMs < time;
+  });
+
+  if(it != hours.end() && it->validTimeMs == hour.validTimeMs)
+    *it = hour;
+  else
+    hours.insert(it, hour);
+}
+
+void WindForecast::clear()
+{
+  QMutexLocker locker(&mutex);
+  hours.clear();
+  useCounter = 0;
+}
+
+void WindForecast::releaseGrids()
+{
+  QMutexLocker locker(&mutex);
+  for(Hour& hour : hours)
+    hour.grid.reset();
+}
+
+void WindForecast::setMaxDecodedHours(int value)
+{
+  QMutexLocker locker(&mutex);
+  maxDecodedHours = value > 0 ? std::max(value, 2) : 0;
+  releaseUnused();
+}
+
+int WindForecast::getNumDecodedHours() const
+{
+  QMutexLocker locker(&mutex);
+  int num = 0;
+  for(const Hour& hour : hours)
+  {
+    if(hour.grid != nullptr)
+      num++;
+  }
+  return num;
+}
+
+qint64 WindForecast::getDecodedSizeBytes() const
+{
+  QMutexLocker locker(&mutex);
+  qint64 size = 0;
+  for(const Hour& hour : hours)
+  {
+    if(hour.grid != nullptr)
+      size += hour.grid->getSizeBytes();
+  }
+  return size;
+}
+
+QDateTime WindForecast::getFirstTime() const
+{
+  return hours.isEmpty() ? QDateTime() : QDateTime::fromMSecsSinceEpoch(hours.constFirst().validTimeMs, Qt::UTC);
+}
+
+QDateTime WindForecast::getLastTime() const
+{
+  return hours.isEmpty() ? QDateTime() : QDateTime::fromMSecsSinceEpoch(hours.constLast().validTimeMs, Qt::UTC);
+}
+
+Wind WindForecast::getWindForPos(Pos pos, const QDateTime& time) const
+{
+  if(hours.isEmpty())
+    return EMPTY_WIND;
+
+  pos.normalize();
+  if(!pos.isValid())
+  {
+    qWarning() << Q_FUNC_INFO << "invalid pos";
+    return EMPTY_WIND;
+  }
+
+  int lower, upper;
+  float weight;
+  hoursForTime(lower, upper, weight, time);
+
+  float u, v;
+  std::shared_ptr<const WindGrid> lowerGrid = gridForHour(lower);
+  lowerGrid->windForPos(pos, u, v);
+
+  if(upper != lower)
+  {
+    float u1, v1;
+    std::shared_ptr<const WindGrid> upperGrid = gridForHour(upper);
+    upperGrid->windForPos(pos, u1, v1);
+    u += (u1 - u) * weight;
+    v += (v1 - v) * weight;
+  }
+
+  return {atools::geo::windDirectionFromUV(u, v), atools::geo::windSpeedFromUV(u, v)};
+}
+
+void WindForecast::getWindForPosList(QVector<Wind>& winds, QVector<Pos> positions, const QDateTime& time) const
+{
+  if(hours.isEmpty())
+  {
+    winds.fill(EMPTY_WIND, positions.size());
+    return;
+  }
+
+  // Remember invalid positions and replace them to allow batch interpolation
+  QVector<bool> valid(positions.size());
+  for(int i = 0; i < positions.size(); i++)
+  {
+    Pos& pos = positions[i];
+    pos.normalize();
+    valid[i] = pos.isValid();
+    if(!valid.at(i))
+      pos = Pos(0.f, 0.f, 0.f);
+  }
+
+  int lower, upper;
+  float weight;
+  hoursForTime(lower, upper, weight, time);
+
+  QVector<float> u, v;
+  std::shared_ptr<const WindGrid> lowerGrid = gridForHour(lower);
+  lowerGrid->windForPos(positions, u, v);
+
+  if(upper != lower)
+  {
+    QVector<float> u1, v1;
+    std::shared_ptr<const WindGrid> upperGrid = gridForHour(upper);
+    upperGrid->windForPos(positions, u1, v1);
+    for(int i = 0; i < positions.size(); i++)
+    {
+      u[i] += (u1.at(i) - u.at(i)) * weight;
+      v[i] += (v1.at(i) - v.at(i)) * weight;
+    }
+  }
+
+  winds.resize(positions.size());
+  for(int i = 0; i < positions.size(); i++)
+  {
+    if(valid.at(i))
+      winds[i] = {atools::geo::windDirectionFromUV(u.at(i), v.at(i)), atools::geo::windSpeedFromUV(u.at(i), v.at(i))};
+    else
+      winds[i] = EMPTY_WIND;
+  }
+}
+
+void WindForecast::hoursForTime(int& lower, int& upper, float& weight, const QDateTime& time) const
+{
+  qint64 timeMs = time.toMSecsSinceEpoch();
+  weight = 0.f;
+
+  if(!time.isValid() || timeMs <= hours.constFirst().validTimeMs)
+    lower = upper = 0;
+  else if(timeMs >= hours.constLast().validTimeMs)
+    lower = upper = hours.size() - 1;
+  else
+  {
+    // First hour after time - there is always one before
+    auto it = std::upper_bound(hours.constBegin(), hours.constEnd(), timeMs, [](qint64 t, const Hour& h) -> bool {
+      return t < h.validTimeMs;
+    });
+    upper = static_cast<int>(std::distance(hours.constBegin(), it));
+    lower = upper - 1;
+
+    qint64 lowerMs = hours.at(lower).validTimeMs;
+    weight = static_cast<float>(timeMs - lowerMs) / static_cast<float>(hours.at(upper).validTimeMs - lowerMs);
+  }
+}
+
+std::shared_ptr<const WindGrid> WindForecast::gridForHour(int index) const
+{
+  // Decoding under lock avoids reading the same hour twice if threads query at the same time
+  QMutexLocker locker(&mutex);
+  const Hour& hour = hours.at(index);
+  hour.lastUsed = ++useCounter;
+
+  if(hour.grid == nullptr)
+  {
+    GribReader reader;
+    if(hour.filename.isEmpty())
+      reader.readData(hour.gribData);
+    else
+      reader.readFile(hour.filename);
+
+    hour.grid = buildGrid(reader.getDatasets());
+
+    qDebug() << Q_FUNC_INFO << "decoded" << QDateTime::fromMSecsSinceEpoch(hour.validTimeMs, Qt::UTC)
+             << hour.filename << "levels" << hour.grid->getNumLevels() << "bytes" << hour.grid->getSizeBytes();
+
+    releaseUnused();
+  }
+  return hour.grid;
+}
+
+void WindForecast::releaseUnused() const
+{
+  if(maxDecodedHours == 0)
+    return;
+
+  // Collect decoded hours and release the oldest ones - grids in use by other threads are kept alive by their pointers
+  QVector<const Hour *> decoded;
+  for(const Hour& hour : hours)
+  {
+    if(hour.grid != nullptr)
+      decoded.append(&hour);
+  }
+
+  if(decoded.size() > maxDecodedHours)
+  {
+    std::sort(decoded.begin(), decoded.end(), [](const Hour *h1, const Hour *h2) -> bool {
+      return h1->lastUsed < h2->lastUsed;
+    });
+
+    for(int i = 0; i < decoded.size() - maxDecodedHours; i++)
+      decoded.at(i)->grid.reset();
+  }
+}
+
+std::shared_ptr<WindGrid> WindForecast::buildGrid(const GribDatasetVector& datasets)
+{
+  // Sort U and V components by altitude
+  QMap<int, std::pair<const GribDataset *, const GribDataset *> > layers;
+  for(int dsidx = 0; dsidx + 1 < datasets.size(); dsidx += 2)
+  {
+    const GribDataset& datasetUWind = datasets.at(dsidx);
+    const GribDataset& datasetVWind = datasets.at(dsidx + 1);
+
+    if(datasetUWind.getParameterType() == atools::grib::U_WIND &&
+       datasetVWind.getParameterType() == atools::grib::V_WIND &&
+       datasetUWind.getData().size() == WindGrid::CELLS && datasetVWind.getData().size() == WindGrid::CELLS)
+      layers.insert(atools::roundToInt(datasetUWind.getAltFeetRounded()), std::make_pair(&datasetUWind, &datasetVWind));
+    else
+      throw atools::Exception(tr("Invalid dataset order for U and V wind component"));
+  }
+
+  if(layers.isEmpty())
+    throw atools::Exception(tr("No wind data found"));
+
+  std::shared_ptr<WindGrid> grid(new WindGrid);
+  grid->setCompact(true);
+
+  QVector<float> u(WindGrid::CELLS), v(WindGrid::CELLS);
+  for(auto it = layers.constBegin(); it != layers.constEnd(); ++it)
+  {
+    const QVector<float>& dataU = it.value().first->getData();
+    const QVector<float>& dataV = it.value().second->getData();
+    for(int i = 0; i < WindGrid::CELLS; i++)
+    {
+      u[i] = atools::geo::meterPerSecToKnots(dataU.at(i));
+      v[i] = atools::geo::meterPerSecToKnots(dataV.at(i));
+    }
+    grid->addLevel(it.key(), u, v);
+  }
+  grid->finish();
+  return grid;
+}
+
+} // namespace grib
+} // namespace atools
@@ -0,0 +1,146 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GRIB_WINDFORECAST_H
+#define ATOOLS_GRIB_WINDFORECAST_H
+
+#include "grib/gribcommon.h"
+#include "grib/windtypes.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QMutex>
+
+#include <memory>
+
+namespace atools {
+namespace geo {
+class Pos;
+}
+
+namespace grib {
+
+class WindGrid;
+
+/*
+ * Wind cube with several forecast hours. Each hour is a separate compact WindGrid which is decoded
+ * from its GRIB file or buffer on first use. Winds are interpolated linearly in time between the two hours
+ * around the query time. Times before the first or after the last hour use the first or last hour.
+ *
+ * Only the hours touched by queries are kept decoded. The number of decoded hours can be limited
+ * in which case the least recently used hours are released.
+ *
+ * All query methods are const and can be called from several threads. Hours are decoded while holding a lock.
+ * Adding or removing hours is not thread safe.
+ */
+class WindForecast
+{
+  Q_DECLARE_TR_FUNCTIONS(WindForecast)
+
+public:
+  WindForecast();
+  ~WindForecast();
+
+  WindForecast(const WindForecast& other) = delete;
+  WindForecast& operator=(const WindForecast& other) = delete;
+
+  /* Add a forecast hour valid at the given time. File or buffer is only read when the hour is needed.
+   * An hour with the same time is replaced. */
+  void addHour(const QDateTime& validTime, const QString& filename);
+  void addHour(const QDateTime& validTime, const QByteArray& gribData);
+
+  /* Remove all hours and decoded data */
+  void clear();
+
+  /* Release all decoded grids. Hours are decoded again when needed. */
+  void releaseGrids();
+
+  /* Get interpolated wind for position and time. Altitude in feet is used from position.
+   * Returns EMPTY_WIND if no hours are added or the position is invalid.
+   * Throws atools::Exception if a GRIB file cannot be read. */
+  atools::grib::Wind getWindForPos(atools::geo::Pos pos, const QDateTime& time) const;
+
+  /* Same as above for many positions at the same time. winds contains one entry for each position. */
+  void getWindForPosList(QVector<atools::grib::Wind>& winds, QVector<atools::geo::Pos> positions,
+                         const QDateTime& time) const;
+
+  /* Maximum number of decoded hours kept in memory. 0 is unlimited which is default.
+   * At least two hours are kept to allow interpolation. */
+  void setMaxDecodedHours(int value);
+
+  bool isEmpty() const
+  {
+    return hours.isEmpty();
+  }
+
+  int getNumHours() const
+  {
+    return hours.size();
+  }
+
+  /* Number of hours currently decoded */
+  int getNumDecodedHours() const;
+
+  /* Memory used by all decoded grids in bytes */
+  qint64 getDecodedSizeBytes() const;
+
+  /* First and last valid time of all hours */
+  QDateTime getFirstTime() const;
+  QDateTime getLastTime() const;
+
+  /* Convert U and V wind datasets in m/s to a compact grid in knots.
+   * Throws atools::Exception on invalid data. */
+  static std::shared_ptr<atools::grib::WindGrid> buildGrid(const atools::grib::GribDatasetVector& datasets);
+
+private:
+  struct Hour
+  {
+    qint64 validTimeMs;
+    QString filename;
+    QByteArray gribData;
+
+    /* Null if not decoded. Guarded by mutex. */
+    mutable std::shared_ptr<const atools::grib::WindGrid> grid;
+
+    /* Counter value of last access for release of least recently used grids. Guarded by mutex. */
+    mutable quint64 lastUsed = 0;
+  };
+
+  /* Insert sorted by time or replace hour with same time */
+  void insertHour(const Hour& hour);
+
+  /* Get hour indexes and weight of the upper hour for time. upper is equal to lower if not interpolating. */
+  void hoursForTime(int& lower, int& upper, float& weight, const QDateTime& time) const;
+
+  /* Get grid for hour and decode if needed. Thread safe. */
+  std::shared_ptr<const atools::grib::WindGrid> gridForHour(int index) const;
+
+  /* Release least recently used grids above maxDecodedHours. Called with locked mutex. */
+  void releaseUnused() const;
+
+  /* Sorted by valid time */
+  QVector<Hour> hours;
+
+  int maxDecodedHours = 0;
+  mutable quint64 useCounter = 0;
+  mutable QMutex mutex;
+};
+
+} // namespace grib
+} // namespace atools
+
+#endif // ATOOLS_GRIB_WINDFORECAST_H
@@ -0,0 +1,287 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "grib/windgrid.h"
+
+#include "atools.h"
+#include "geo/pos.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace grib {
+
+Q_DECL_CONSTEXPR int WindGrid::COLUMNS;
+Q_DECL_CONSTEXPR int WindGrid::ROWS;
+Q_DECL_CONSTEXPR int WindGrid::CELLS;
+Q_DECL_CONSTEXPR int WindGrid::TABLE_STEP_FT;
+Q_DECL_CONSTEXPR int WindGrid::BLOCK_SIZE;
+
+Q_DECL_CONSTEXPR float WindGrid::COMPACT_SCALE;
+
+/* Allowed altitude inaccuracy when comparing layer altitudes. Same as in WindQuery. */
+Q_CONSTEXPR static int ALTITUDE_EPSILON = 50;
+
+/* Interpolate bilinear in cells given by lower and upper index and linear between them for float or
+ * fixed point storage. Values are multiplied by scale. */
+template<typename TYPE>
+void interpolateBlock(const TYPE *uData, const TYPE *vData, float scale, int size,
+                      const float *fx, const float *fy, const float *weight,
+                      const int *lower, const int *upper, const int *right, const int *down, float *u, float *v)
+{
+  for(int i = 0; i < size; i++)
+  {
+    float wTopLeft = (1.f - fx[i]) * (1.f - fy[i]), wTopRight = fx[i] * (1.f - fy[i]),
+          wBottomLeft = (1.f - fx[i]) * fy[i], wBottomRight = fx[i] * fy[i];
+    int l = lower[i], up = upper[i], r = right[i], d = down[i];
+
+    float uLower = uData[l] * wTopLeft + uData[l + r] * wTopRight + uData[l + d] * wBottomLeft +
+                   uData[l + d + r] * wBottomRight;
+    float vLower = vData[l] * wTopLeft + vData[l + r] * wTopRight + vData[l + d] * wBottomLeft +
+                   vData[l + d + r] * wBottomRight;
+    float uUpper = uData[up] * wTopLeft + uData[up + r] * wTopRight + uData[up + d] * wBottomLeft +
+                   uData[up + d + r] * wBottomRight;
+    float vUpper = vData[up] * wTopLeft + vData[up + r] * wTopRight + vData[up + d] * wBottomLeft +
+                   vData[up + d + r] * wBottomRight;
+
+    u[i] = (uLower + (uUpper - uLower) * weight[i]) * scale;
+    v[i] = (vLower + (vUpper - vLower) * weight[i]) * scale;
+  }
+}
+
+/* Convert knots to fixed point and clamp to range */
+inline qint16 toCompact(float value)
+{
+  return static_cast<qint16>(atools::minmax(-32767, 32767, atools::roundToInt(value * WindGrid::COMPACT_SCALE)));
+}
+
+WindGrid::WindGrid()
+{
+
+}
+
+WindGrid::~WindGrid()
+{
+
+}
+
+void WindGrid::clear()
+{
+  altitudes.clear();
+  uValues.clear();
+  vValues.clear();
+  uCompact.clear();
+  vCompact.clear();
+  levelTable.clear();
+}
+
+void WindGrid::addLevel(int altitude, const QVector<float>& u, const QVector<float>& v)
+{
+  if(u.size() != CELLS || v.size() != CELLS)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid number of values" << u.size() << v.size();
+    return;
+  }
+
+  if(!altitudes.isEmpty() && altitude <= altitudes.constLast())
+  {
+    qWarning() << Q_FUNC_INFO << "Levels not in ascending order" << altitude;
+    return;
+  }
+
+  if(compact)
+  {
+    if(uCompact.isEmpty())
+    {
+      // Add zero wind block for ground allowing interpolation without branches
+      uCompact.fill(0, CELLS);
+      vCompact.fill(0, CELLS);
+    }
+
+    int offset = uCompact.size();
+    uCompact.resize(offset + CELLS);
+    vCompact.resize(offset + CELLS);
+    for(int i = 0; i < CELLS; i++)
+    {
+      uCompact[offset + i] = toCompact(u.at(i));
+      vCompact[offset + i] = toCompact(v.at(i));
+    }
+  }
+  else
+  {
+    if(uValues.isEmpty())
+    {
+      // Add zero wind block for ground allowing interpolation without branches
+      uValues.fill(0.f, CELLS);
+      vValues.fill(0.f, CELLS);
+    }
+
+    uValues.append(u);
+    vValues.append(v);
+  }
+  altitudes.append(altitude);
+}
+
+void WindGrid::finish()
+{
+  levelTable.clear();
+  if(altitudes.isEmpty())
+    return;
+
+  // One entry beyond the highest level which points to the end
+  int size = std::max(altitudes.constLast(), 0) / TABLE_STEP_FT + 2;
+  levelTable.resize(size);
+
+  int level = 0;
+  for(int i = 0; i < size; i++)
+  {
+    while(level < altitudes.size() && altitudes.at(level) < i * TABLE_STEP_FT)
+      level++;
+    levelTable[i] = level;
+  }
+}
+
+WindGrid::LevelPair WindGrid::levelsForAlt(float altitude) const
+{
+  int numLevels = altitudes.size();
+  if(numLevels == 1 || (altitude < altitudes.constFirst() && altitudes.constFirst() <= 0))
+    // Only one level or no interpolation towards ground possible
+    return {0, 0, 0.f};
+
+  // Find first level equal or above the altitude - table gives a start near the right level
+  int alt = atools::roundToInt(altitude);
+  int level = levelTable.at(atools::minmax(0, levelTable.size() - 1, alt / TABLE_STEP_FT));
+  while(level < numLevels && altitudes.at(level) < alt)
+    level++;
+
+  if(level == numLevels)
+    // Above highest level
+    return {numLevels - 1, numLevels - 1, 0.f};
+  else if(atools::almostEqual(altitudes.at(level), alt, ALTITUDE_EPSILON))
+    // Level is at requested altitude - no need to interpolate
+    return {level, level, 0.f};
+  else if(level == 0)
+    // Below first level - interpolate between level and zero wind at zero altitude
+    return {-1, 0, altitude / altitudes.at(0)};
+  else
+  {
+    float lowerAlt = altitudes.at(level - 1);
+    return {level - 1, level, (altitude - lowerAlt) / (altitudes.at(level) - lowerAlt)};
+  }
+}
+
+void WindGrid::windForBlock(const geo::Pos *positions, int size, float *u, float *v) const
+{
+  // Structure of arrays for one block - loops without dependencies can be vectorized by the compiler
+  float fx[BLOCK_SIZE], fy[BLOCK_SIZE], weight[BLOCK_SIZE];
+  int index[BLOCK_SIZE], right[BLOCK_SIZE], down[BLOCK_SIZE], lower[BLOCK_SIZE], upper[BLOCK_SIZE];
+
+  // Cell index and fractions ==========================================
+  for(int i = 0; i < size; i++)
+  {
+    // Column 0 is 0° and row 0 is 90° North
+    float lonX = positions[i].getLonX();
+    float x = lonX + (lonX < 0.f ? 360.f : 0.f);
+    float y = 90.f - positions[i].getLatY();
+    int column = std::min(std::max(static_cast<int>(x), 0), COLUMNS - 1);
+    int row = std::min(std::max(static_cast<int>(y), 0), ROWS - 1);
+    fx[i] = std::min(std::max(x - column, 0.f), 1.f);
+    fy[i] = std::min(std::max(y - row, 0.f), 1.f);
+    index[i] = row * COLUMNS + column;
+
+    // Right column wraps around at the anti-meridian and last row has no row below
+    right[i] = column < COLUMNS - 1 ? 1 : 1 - COLUMNS;
+    down[i] = row < ROWS - 1 ? COLUMNS : 0;
+  }
+
+  // Levels ==========================================
+  for(int i = 0; i < size; i++)
+  {
+    LevelPair levels = levelsForAlt(positions[i].getAltitude());
+    // Block 0 is zero wind for level -1
+    lower[i] = (levels.lower + 1) * CELLS + index[i];
+    upper[i] = (levels.upper + 1) * CELLS + index[i];
+    weight[i] = levels.weight;
+  }
+
+  // Gather corners and interpolate bilinear in cell and linear between levels ======================
+  if(compact)
+    interpolateBlock(uCompact.constData(), vCompact.constData(), 1.f / COMPACT_SCALE, size,
+                     fx, fy, weight, lower, upper, right, down, u, v);
+  else
+    interpolateBlock(uValues.constData(), vValues.constData(), 1.f, size, fx, fy, weight, lower, upper, right, down,
+                     u, v);
+}
+
+void WindGrid::windForCell(int level, int column, int row, float& u, float& v) const
+{
+  int index = (level + 1) * CELLS + row * COLUMNS + column;
+  if(compact)
+  {
+    u = uCompact.at(index) / COMPACT_SCALE;
+    v = vCompact.at(index) / COMPACT_SCALE;
+  }
+  else
+  {
+    u = uValues.at(index);
+    v = vValues.at(index);
+  }
+}
+
+void WindGrid::windForPos(const geo::Pos& pos, float& u, float& v) const
+{
+  if(altitudes.isEmpty())
+    u = v = 0.f;
+  else
+    windForBlock(&pos, 1, &u, &v);
+}
+
+void WindGrid::windForPos(const QVector<geo::Pos>& positions, QVector<float>& u, QVector<float>& v) const
+{
+  u.fill(0.f, positions.size());
+  v.fill(0.f, positions.size());
+
+  if(!altitudes.isEmpty())
+  {
+    float *uData = u.data(), *vData = v.data();
+    for(int i = 0; i < positions.size(); i += BLOCK_SIZE)
+      windForBlock(positions.constData() + i, std::min(BLOCK_SIZE, positions.size() - i), uData + i, vData + i);
+  }
+}
+
+void WindGrid::windSumForPos(const QVector<geo::Pos>& positions, float& uSum, float& vSum) const
+{
+  uSum = vSum = 0.f;
+  if(!altitudes.isEmpty())
+  {
+    float u[BLOCK_SIZE], v[BLOCK_SIZE];
+    for(int i = 0; i < positions.size(); i += BLOCK_SIZE)
+    {
+      int size = std::min(BLOCK_SIZE, positions.size() - i);
+      windForBlock(positions.constData() + i, size, u, v);
+
+      for(int j = 0; j < size; j++)
+      {
+        uSum += u[j];
+        vSum += v[j];
+      }
+    }
+  }
+}
+
+} // namespace grib
+} // namespace atools
@@ -0,0 +1,153 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GRIB_WINDGRID_H
+#define ATOOLS_GRIB_WINDGRID_H
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class Pos;
+}
+
+namespace grib {
+
+/*
+ * Dense wind store covering the whole earth with a one degree raster for all altitude levels.
+ * U and V components in knots are kept in contiguous float arrays, one block of 360 x 181 values per level.
+ * Row 0 is 90° North and column 0 is 0° E/W.
+ *
+ * A precomputed table maps altitude to levels, so finding the cell and levels for a position is O(1).
+ * Values are interpolated bilinear in the cell and linear between the levels below and above.
+ * Below the lowest level values are interpolated towards zero wind at zero altitude.
+ * Above the highest level the highest level is used.
+ *
+ * Positions are processed in blocks using local structure of arrays. This allows the compiler
+ * to vectorize index and weight calculation. Zero wind at ground is stored as an extra level so that the
+ * interpolation needs no branches.
+ *
+ * All query methods are const and can be called from several threads.
+ */
+class WindGrid
+{
+public:
+  WindGrid();
+  ~WindGrid();
+
+  /* Add a level with 360 x 181 U and V values in knots. Levels have to be added in ascending altitude order.
+   * Call finish() after adding all levels. */
+  void addLevel(int altitude, const QVector<float>& u, const QVector<float>& v);
+
+  /* Build altitude lookup table after adding all levels */
+  void finish();
+
+  void clear();
+
+  /* Store values as 16 bit fixed point with a resolution of 0.01 knots instead of float. Halves memory usage.
+   * Values are clamped to +/-327 knots. Clears the grid if changed. */
+  void setCompact(bool value)
+  {
+    if(value != compact)
+    {
+      clear();
+      compact = value;
+    }
+  }
+
+  bool isCompact() const
+  {
+    return compact;
+  }
+
+  /* Memory used by grid values in bytes */
+  qint64 getSizeBytes() const
+  {
+    return static_cast<qint64>(uValues.size() + vValues.size()) * static_cast<qint64>(sizeof(float)) +
+           static_cast<qint64>(uCompact.size() + vCompact.size()) * static_cast<qint64>(sizeof(qint16));
+  }
+
+  bool isEmpty() const
+  {
+    return altitudes.isEmpty();
+  }
+
+  int getNumLevels() const
+  {
+    return altitudes.size();
+  }
+
+  /* Get interpolated U and V components in knots for position. Uses altitude in feet from position.
+   * Position has to be valid and normalized. */
+  void windForPos(const atools::geo::Pos& pos, float& u, float& v) const;
+
+  /* Same as above for many positions at once. u and v are resized to the number of positions. */
+  void windForPos(const QVector<atools::geo::Pos>& positions, QVector<float>& u, QVector<float>& v) const;
+
+  /* Sum of U and V components for all positions. Avoids allocating result arrays for averages. */
+  void windSumForPos(const QVector<atools::geo::Pos>& positions, float& uSum, float& vSum) const;
+
+  /* Values at grid point without interpolation. level is index in ascending order as added. */
+  void windForCell(int level, int column, int row, float& u, float& v) const;
+
+  /* Number of columns and rows of the global grid */
+  static Q_DECL_CONSTEXPR int COLUMNS = 360;
+  static Q_DECL_CONSTEXPR int ROWS = 181;
+  static Q_DECL_CONSTEXPR int CELLS = COLUMNS * ROWS;
+
+  /* Fixed point values per knot in compact mode */
+  static Q_DECL_CONSTEXPR float COMPACT_SCALE = 100.f;
+
+private:
+  /* Levels and weight for upper level for an altitude. lower is -1 for zero wind on ground. */
+  struct LevelPair
+  {
+    int lower, upper;
+    float weight;
+  };
+
+  LevelPair levelsForAlt(float altitude) const;
+
+  /* Interpolate winds for up to BLOCK_SIZE positions. Grid must not be empty. */
+  void windForBlock(const atools::geo::Pos *positions, int size, float *u, float *v) const;
+
+  /* Altitude step for the lookup table in feet */
+  static Q_DECL_CONSTEXPR int TABLE_STEP_FT = 100;
+
+  /* Number of positions interpolated together in local arrays */
+  static Q_DECL_CONSTEXPR int BLOCK_SIZE = 64;
+
+  /* Levels in ascending order */
+  QVector<int> altitudes;
+
+  /* Values for all levels. Index is (level + 1) * CELLS + row * COLUMNS + column.
+   * First block contains zero wind used as ground level for interpolation. */
+  QVector<float> uValues, vValues;
+
+  /* Same as above in compact mode */
+  QVector<qint16> uCompact, vCompact;
+
+  /* Index of the first level having an altitude equal or above table index * TABLE_STEP_FT */
+  QVector<int> levelTable;
+
+  bool compact = false;
+};
+
+} // namespace grib
+} // namespace atools
+
+#endif // ATOOLS_GRIB_WINDGRID_H
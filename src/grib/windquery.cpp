@@ -28,7 +28,11 @@
 #include "util/filesystemwatcher.h"
 #include "fs/util/fsutil.h"
 
+#include <QCache>
 #include <QDir>
+#include <QRunnable>
+
+#include <cstring>
 
 using atools::grib::GribDownloader;
 using atools::geo::Rect;
@@ -82,6 +86,16 @@ struct WindData
 
 const static atools::grib::WindData EMPTY_WIND_DATA = {0.f, 0.f};
 
+/* X-Plane 12 wind files like GRIB-2022-9-6-21.00-ZULU-wind.grib or GRIB-2023-02-22-18.00-ZULU-wind-v2.grib */
+const static QStringList XP12_GRIB_FILTERS = {"GRIB-*-wind-v*.grib", "GRIB-*-wind.grib"};
+
+/* Sort by timestamp - put latest at begin of list */
+static bool gribFileLessThan(const QString& file1, const QString& file2)
+{
+  return atools::fs::util::xpGribFilenameToDate(QFileInfo(file1).fileName()) >
+         atools::fs::util::xpGribFilenameToDate(QFileInfo(file2).fileName());
+}
+
 /* Internal data structure for wind direction and speed computed from U/V speeds */
 struct WindAltLayer
 {
@@ -89,6 +103,9 @@ struct WindAltLayer
   QVector<WindData> winds;
   float surface;
 
+  /* Index in windGrid. Used in compact mode where winds is empty. -1 if not in grid. */
+  int gridLevel = -1;
+
   bool operator<(const WindAltLayer& l) const
   {
     return altitude < l.altitude;
@@ -106,21 +123,113 @@ struct WindAltLayer
 
   bool isValid() const
   {
-    return !winds.isEmpty();
+    return !winds.isEmpty() || gridLevel >= 0;
   }
 
 };
 
-/* One grid cell with all wind values at the corners for interpolation. top left corresponds to queried position. */
-struct WindRect
+/* Number of memoized leg averages per model */
+Q_CONSTEXPR static int LEG_CACHE_SIZE = 10000;
+
+/* Key for memoized leg averages. Positions are normalized and compared bitwise including altitude. */
+struct LegKey
 {
-  WindData topLeft, topRight, bottomRight, bottomLeft;
+  float values[6];
+  int samplesPerDegree;
+
+  bool operator==(const LegKey& other) const
+  {
+    return std::memcmp(values, other.values, sizeof(values)) == 0 && samplesPerDegree == other.samplesPerDegree;
+  }
+
 };
 
-/* One grid cell with all grid positions values at the corners for interpolation. top left corresponds to queried position. */
-struct GridRect
+inline uint qHash(const LegKey& key)
 {
-  QPoint topLeft, topRight, bottomRight, bottomLeft;
+  uint hash = static_cast<uint>(key.samplesPerDegree);
+  for(float value : key.values)
+  {
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    hash = hash * 31 + bits;
+  }
+  return hash;
+}
+
+/* Immutable wind data published by WindQuery. Never modified after publishing except the leg cache. */
+struct WindModel
+{
+  /* Maps rounded altitude to wind layer data. Sorted by altitude. */
+  QMap<int, WindAltLayer> windLayers;
+
+  /* Same data as in windLayers used for fast interpolation */
+  WindGrid windGrid;
+
+  QDateTime analyisTime;
+
+  /* Memoized average winds of legs. Belongs to this dataset and is dropped together with it on updates. */
+  mutable QCache<LegKey, WindData> legCache{LEG_CACHE_SIZE};
+  mutable QMutex legCacheMutex;
+};
+
+/* Reads a GRIB file if given and converts datasets into a new model in the conversion thread pool */
+class WindConversionTask :
+  public QRunnable
+{
+public:
+  WindConversionTask(WindQuery *windQuery, int generationParam, bool compactParam, bool verboseParam,
+                     const GribDatasetVector& datasetsParam, const QString& filenameParam)
+    : query(windQuery), generation(generationParam), compact(compactParam), verbose(verboseParam),
+    datasets(datasetsParam), filename(filenameParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    QString error;
+    std::shared_ptr<WindModel> model;
+    try
+    {
+      if(!filename.isEmpty())
+      {
+        GribReader reader(verbose);
+        reader.readFile(filename);
+        datasets = reader.getDatasets();
+      }
+      model = WindQuery::buildModel(datasets, compact, verbose);
+    }
+    catch(atools::Exception& e)
+    {
+      error = e.getMessage();
+    }
+    catch(...)
+    {
+      error = WindQuery::tr("Unknown error.");
+    }
+
+    WindQuery *windQuery = query;
+    int gen = generation;
+    if(error.isEmpty())
+    {
+      // Publish immediately - readers get the new data with the next query
+      if(windQuery->publish(model, gen))
+        QMetaObject::invokeMethod(windQuery, [windQuery, gen]() -> void {
+          windQuery->conversionFinished(gen, QString());
+        }, Qt::QueuedConnection);
+    }
+    else
+      QMetaObject::invokeMethod(windQuery, [windQuery, gen, error]() -> void {
+        windQuery->conversionFinished(gen, error);
+      }, Qt::QueuedConnection);
+  }
+
+private:
+  WindQuery *query;
+  int generation;
+  bool compact, verbose;
+  GribDatasetVector datasets;
+  QString filename;
 };
 
 // Debug IO =======================================================================
@@ -156,39 +265,13 @@ inline QPoint gridPos(const atools::geo::Pos& pos)
   return QPoint(colNum(pos), rowNum(pos));
 }
 
-/* A rectangle at one degree cell boundaries covering the given position */
-inline atools::geo::Rect globalRect(const atools::geo::Pos& pos)
-{
-  atools::geo::Rect rect;
-  rect.setNorth(std::ceil(pos.getLatY()));
-  rect.setWest(std::floor(pos.getLonX()));
-  rect.setSouth(std::floor(pos.getLatY()));
-  rect.setEast(std::ceil(pos.getLonX()));
-
-  // Return at least a one degree width or height
-  if(atools::almostEqual(rect.getWidthDegree(), 0.f))
-    rect.setEast(rect.getEast() + 1.f);
-  if(atools::almostEqual(rect.getHeightMeter(), 0.f))
-    rect.setSouth(rect.getNorth() - 1.f);
-
-  return rect;
-}
-
-/* Gives a rectangle for grid positions for the given world coordinate rect */
-inline GridRect gridRect(const atools::geo::Rect& rect)
-{
-  GridRect retval;
-  retval.topLeft = gridPos(rect.getTopLeft());
-  retval.topRight = gridPos(rect.getTopRight());
-  retval.bottomRight = gridPos(rect.getBottomRight());
-  retval.bottomLeft = gridPos(rect.getBottomLeft());
-  return retval;
-}
-
 // ===============================================================
 WindQuery::WindQuery(QObject *parentObject, bool logVerbose)
-  : QObject(parentObject), verbose(logVerbose)
+  : QObject(parentObject), verbose(logVerbose), generation(0)
 {
+  // Convert one dataset after the other in background
+  conversionPool.setMaxThreadCount(1);
+
   downloader = new GribDownloader(parentObject, logVerbose);
 
   // Download or read U and V components of wind - will be used to calculated speed and direction
@@ -206,12 +289,16 @@ WindQuery::WindQuery(QObject *parentObject, bool logVerbose)
   fileWatcher = new atools::util::FileSystemWatcher(parentObject, logVerbose);
   fileWatcher->setMinFileSize(180000); // Do not accept smaller files
   fileWatcher->setDelayMs(10000); // Delay notification for 10 seconds to avoid incomplete files
-  connect(fileWatcher, &atools::util::FileSystemWatcher::dirUpdated, this, &WindQuery::gribDirUpdated);
+  connect(fileWatcher, &atools::util::FileSystemWatcher::dirEntriesChanged, this, &WindQuery::gribDirEntriesChanged);
   connect(fileWatcher, &atools::util::FileSystemWatcher::filesUpdated, this, &WindQuery::gribFileUpdated);
 }
 
 WindQuery::~WindQuery()
 {
+  // Drop results of running conversions and wait for them
+  generation++;
+  conversionPool.waitForDone();
+
   delete downloader;
   delete fileWatcher;
 }
@@ -241,6 +328,9 @@ void WindQuery::initFromPath(const QString& path, atools::fs::weather::XpWeather
   // Inital load
   gribFileUpdated({currentGribFile});
 
+  // Report only added or removed wind files in folder
+  fileWatcher->setDirNameFilters(weatherType == atools::fs::weather::WEATHER_XP12 ? XP12_GRIB_FILTERS : QStringList());
+
   if(currentGribFile.isEmpty() && weatherType == atools::fs::weather::WEATHER_XP12)
     // Watch folder if file not given
     fileWatcher->setFilenameAndStart(weatherPath);
@@ -251,37 +341,29 @@ void WindQuery::initFromPath(const QString& path, atools::fs::weather::XpWeather
 
 QString WindQuery::collectGribFiles()
 {
-  QFileInfoList gribFiles;
+  gribFiles.clear();
   if(weatherType == atools::fs::weather::WEATHER_XP11)
     // global_winds.grib
-    gribFiles.append(QFileInfo(weatherPath));
+    gribFiles.append(QFileInfo(weatherPath).absoluteFilePath());
   else if(weatherType == atools::fs::weather::WEATHER_XP12)
   {
-    // GRIB-2022-9-6-21.00-ZULU-wind.grib
-    // GRIB-2023-02-22-18.00-ZULU-wind-v2.grib
     QDir weatherDir(weatherPath);
     weatherDir.setSorting(QDir::Unsorted);
     weatherDir.setFilter(QDir::Files | QDir::NoDotAndDotDot);
-    weatherDir.setNameFilters({"GRIB-*-wind-v*.grib", "GRIB-*-wind.grib"});
+    weatherDir.setNameFilters(XP12_GRIB_FILTERS);
 
-    for(QFileInfo entry : weatherDir.entryInfoList())
-      gribFiles.append(entry);
+    for(const QFileInfo& entry : weatherDir.entryInfoList())
+      gribFiles.append(entry.absoluteFilePath());
 
-    // Sort by timestamp - put latest at begin of list
     if(gribFiles.size() > 1)
-      std::sort(gribFiles.begin(), gribFiles.end(), [](const QFileInfo& file1, const QFileInfo& file2)->bool {
-            return atools::fs::util::xpGribFilenameToDate(file1.fileName()) > atools::fs::util::xpGribFilenameToDate(file2.fileName());
-          });
+      std::sort(gribFiles.begin(), gribFiles.end(), gribFileLessThan);
   }
 
   if(verbose)
     qDebug() << Q_FUNC_INFO << gribFiles;
 
   // Return first and latest file since GRIB cannot be merged like METAR
-  if(!gribFiles.isEmpty())
-    return gribFiles.constFirst().absoluteFilePath();
-  else
-    return QString();
+  return gribFiles.value(0);
 }
 
 void WindQuery::initFromFixedModel(float dir, float speed, float altitude)
@@ -295,33 +377,47 @@ void WindQuery::initFromFixedModel(float dirLower, float speedLower, float altit
 {
   deinit();
 
+  std::shared_ptr<WindModel> newModel(new WindModel);
+
   // Add lower layer ==========================
   WindAltLayer groundLayer;
   groundLayer.altitude = roundToInt(altitudeLower);
   groundLayer.winds.fill(WindData{windUComponent(speedLower, dirLower),
                                   windVComponent(speedLower, dirLower)}, 360 * 181);
-  windLayers.insert(atools::roundToInt(groundLayer.altitude), groundLayer);
+  newModel->windLayers.insert(atools::roundToInt(groundLayer.altitude), groundLayer);
 
   // Add upper layer ==========================
   WindAltLayer altLayer;
   altLayer.altitude = roundToInt(altitudeUpper);
   altLayer.winds.fill(WindData{windUComponent(speedUpper, dirUpper),
                                windVComponent(speedUpper, dirUpper)}, 360 * 181);
-  windLayers.insert(atools::roundToInt(altLayer.altitude), altLayer);
+  newModel->windLayers.insert(atools::roundToInt(altLayer.altitude), altLayer);
+  updateWindGrid(*newModel, compactStorage, verbose);
+
+  publish(newModel, generation);
 }
 
 void WindQuery::deinit()
 {
-  analyisTime = QDateTime();
-  windLayers.clear();
+  {
+    // Drop results of running conversions and clear data
+    QMutexLocker locker(&publishMutex);
+    generation++;
+    std::atomic_store(&model, std::shared_ptr<const WindModel>());
+  }
   downloader->stopDownload();
   fileWatcher->stopWatching();
   weatherPath.clear();
   currentGribFile.clear();
+  gribFiles.clear();
 }
 
 Wind WindQuery::getWindForPos(atools::geo::Pos pos, bool interpolateValue) const
 {
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m == nullptr)
+    return EMPTY_WIND;
+
   pos.normalize();
 
   if(!pos.isValid())
@@ -335,18 +431,18 @@ Wind WindQuery::getWindForPos(atools::geo::Pos pos, bool interpolateValue) const
   if(verbose)
     qDebug() << Q_FUNC_INFO << pos << gPos;
 
-  // Get next layers below and above altitude
-  WindAltLayer lower, upper;
-  layersByAlt(lower, upper, pos.getAltitude());
-
   if(!interpolateValue || pos.nearGrid(1.f, atools::geo::Pos::POS_EPSILON_500M))
   {
+    // Get next layers below and above altitude
+    WindAltLayer lower, upper;
+    layersByAlt(*m, lower, upper, pos.getAltitude());
+
     // No need to interpolate within grid - use position as is
-    WindData lW = windForLayer(lower, gPos);
+    WindData lW = windForLayer(*m, lower, gPos);
 
     if(upper != lower)
     {
-      WindData uW = windForLayer(upper, gPos);
+      WindData uW = windForLayer(*m, upper, gPos);
       // Interpolate between upper and lower layer
       return interpolateWind(lW, uW, lower.altitude, upper.altitude, pos.getAltitude()).toWind();
     }
@@ -355,27 +451,39 @@ Wind WindQuery::getWindForPos(atools::geo::Pos pos, bool interpolateValue) const
   }
   else
   {
-    Rect global = globalRect(pos);
-    GridRect grid = gridRect(global);
-
-    // Interpolate wind within a grid rectangle for the lower layer
-    WindRect windRectLower;
-    windRectForLayer(windRectLower, lower, grid);
-    WindData lWind = interpolateRect(windRectLower, global, pos);
+    // Interpolate wind within the grid cell and between layers
+    WindData wind;
+    m->windGrid.windForPos(pos, wind.u, wind.v);
+    return wind.toWind();
+  }
+}
 
-    if(upper != lower)
-    {
-      // Interpolate wind within a grid rectangle for the upper layer if layers differ
-      WindRect windRectUpper;
-      windRectForLayer(windRectUpper, upper, grid);
-      WindData uWind = interpolateRect(windRectUpper, global, pos);
+void WindQuery::getWindForPosList(QVector<Wind>& winds, QVector<Pos> positions) const
+{
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m == nullptr)
+  {
+    winds.fill(EMPTY_WIND, positions.size());
+    return;
+  }
 
-      // Interpolate between upper and lower wind
-      return interpolateWind(lWind, uWind, lower.altitude, upper.altitude, pos.getAltitude()).toWind();
-    }
-    else
-      return lWind.toWind();
+  // Remember invalid positions and replace them to allow batch interpolation
+  QVector<bool> valid(positions.size());
+  for(int i = 0; i < positions.size(); i++)
+  {
+    Pos& pos = positions[i];
+    pos.normalize();
+    valid[i] = pos.isValid();
+    if(!valid.at(i))
+      pos = Pos(0.f, 0.f, 0.f);
   }
+
+  QVector<float> u, v;
+  m->windGrid.windForPos(positions, u, v);
+
+  winds.resize(positions.size());
+  for(int i = 0; i < positions.size(); i++)
+    winds[i] = valid.at(i) ? WindData{u.at(i), v.at(i)}.toWind() : EMPTY_WIND;
 }
 
 WindPosList WindQuery::getWindForRect(const atools::geo::Rect& rect, float altFeet) const
@@ -387,7 +495,8 @@ WindPosList WindQuery::getWindForRect(const atools::geo::Rect& rect, float altFe
 
 void WindQuery::getWindForRect(WindPosList& result, atools::geo::Rect rect, float altFeet, int gridSpacing) const
 {
-  if(windLayers.isEmpty())
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m == nullptr || m->windLayers.isEmpty())
     return;
 
   rect.normalize();
@@ -404,7 +513,7 @@ void WindQuery::getWindForRect(WindPosList& result, atools::geo::Rect rect, floa
   {
     // Get next layers below and above altitude
     WindAltLayer lower, upper;
-    layersByAlt(lower, upper, altFeet);
+    layersByAlt(*m, lower, upper, altFeet);
 
     // Split rectangle if it crosses the anti-meridian (date line)
     for(const atools::geo::Rect& r : rect.splitAtAntiMeridian())
@@ -426,10 +535,10 @@ void WindQuery::getWindForRect(WindPosList& result, atools::geo::Rect rect, floa
 
           if(upper != lower)
             // Interpolate wind within a grid rectangle for the upper layer if layers differ
-            wp.wind = interpolateWind(windForLayer(lower, gPos), windForLayer(upper, gPos),
+            wp.wind = interpolateWind(windForLayer(*m, lower, gPos), windForLayer(*m, upper, gPos),
                                       lower.altitude, upper.altitude, altFeet).toWind();
           else
-            wp.wind = windForLayer(lower, gPos).toWind();
+            wp.wind = windForLayer(*m, lower, gPos).toWind();
 
           result.append(wp);
         }
@@ -448,16 +557,20 @@ Wind WindQuery::getWindAverageForLineString(const geo::LineString& linestring) c
     return getWindAverageForLine(linestring.toLine());
   else
   {
+    std::shared_ptr<const WindModel> m = currentModel();
+    if(m == nullptr)
+      return EMPTY_WIND;
+
+    // Sum up averages of all lines - unchanged lines are taken from the cache
     WindData windData = EMPTY_WIND_DATA;
-    // Sum up values
     for(int i = 0; i < linestring.size() - 1; i++)
     {
-      WindData wd = windAverageForLine(linestring.at(i), linestring.at(i + 1));
-      windData.u += wd.u;
-      windData.v += wd.v;
+      WindData lineData = windAverageForLeg(*m, linestring.at(i), linestring.at(i + 1));
+      windData.u += lineData.u;
+      windData.v += lineData.v;
     }
 
-    // Calculate average
+    // Calculate average and convert to speed and direction only once
     windData.u = windData.u / (linestring.size() - 1);
     windData.v = windData.v / (linestring.size() - 1);
 
@@ -475,11 +588,16 @@ QString WindQuery::getDebug(const geo::Pos& pos) const
   out.setRealNumberPrecision(2);
   out.setRealNumberNotation(QTextStream::FixedNotation);
   out << "=================" << endl;
-  for(auto it = windLayers.begin(); it != windLayers.end(); ++it)
+
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m == nullptr)
+    return retval;
+
+  for(auto it = m->windLayers.constBegin(); it != m->windLayers.constEnd(); ++it)
   {
     WindAltLayer layer = it.value();
     QPoint grid = gridPos(pos);
-    WindData wind = windForLayer(layer, grid);
+    WindData wind = windForLayer(*m, layer, grid);
 
     out << "altitude " << it.key() << " surface " << layer.surface
         << " grid x " << grid.x() << " y " << grid.y() << endl;
@@ -496,21 +614,104 @@ void WindQuery::setIgnoreSslErrors(bool value)
   downloader->setIgnoreSslErrors(value);
 }
 
+bool WindQuery::hasWindData() const
+{
+  std::shared_ptr<const WindModel> m = currentModel();
+  return m != nullptr && !m->windLayers.isEmpty();
+}
+
+QDateTime WindQuery::getAnalyisTime() const
+{
+  std::shared_ptr<const WindModel> m = currentModel();
+  return m != nullptr ? m->analyisTime : QDateTime();
+}
+
 void WindQuery::getValidity(QDateTime& from, QDateTime& to) const
 {
+  QDateTime analyisTime = getAnalyisTime();
   from = analyisTime;
   to = analyisTime.addSecs(3600 * 6);
 }
 
+std::shared_ptr<const WindModel> WindQuery::currentModel() const
+{
+  return std::atomic_load(&model);
+}
+
+bool WindQuery::publish(const std::shared_ptr<const WindModel>& newModel, int modelGeneration)
+{
+  QMutexLocker locker(&publishMutex);
+  if(modelGeneration != generation)
+    // deinit() or another update was called in the meantime
+    return false;
+
+  // Readers holding the old model keep their copy until done
+  std::atomic_store(&model, newModel);
+  return true;
+}
+
+void WindQuery::startConversion(const GribDatasetVector& datasets, const QString& filename)
+{
+  conversionPool.start(new WindConversionTask(this, generation, compactStorage, verbose, datasets, filename));
+}
+
+void WindQuery::conversionFinished(int modelGeneration, const QString& error)
+{
+  if(modelGeneration != generation)
+    return;
+
+  if(error.isEmpty())
+    emit windDataUpdated();
+  else
+    emit windDownloadFailed(error, 0);
+}
+
 void WindQuery::debugDumpContainerSizes() const
 {
   if(downloader != nullptr)
     downloader->debugDumpContainerSizes();
 }
 
-WindData WindQuery::windForLayer(const WindAltLayer& layer, const QPoint& point) const
+void WindQuery::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m != nullptr)
+  {
+    // Layers keep full copies only if not in compact mode
+    for(const WindAltLayer& layer : m->windLayers)
+      bytes += atools::util::MemoryAccounting::vectorBytes(layer.winds);
+
+    bytes += m->windGrid.getSizeBytes();
+    elements += m->windGrid.getNumLevels() * WindGrid::CELLS;
+
+    QMutexLocker locker(&m->legCacheMutex);
+    bytes += static_cast<qint64>(m->legCache.totalCost()) * static_cast<qint64>(sizeof(LegKey) + sizeof(WindData));
+  }
+}
+
+void WindQuery::releaseMemory(qint64)
+{
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m != nullptr)
+  {
+    QMutexLocker locker(&m->legCacheMutex);
+    m->legCache.clear();
+  }
+}
+
+WindData WindQuery::windForLayer(const WindModel& m, const WindAltLayer& layer, const QPoint& point) const
 {
-  return layer.isValid() ? layer.winds.at(point.x() + point.y() * 360) : EMPTY_WIND_DATA;
+  if(!layer.winds.isEmpty())
+    return layer.winds.at(point.x() + point.y() * 360);
+  else if(layer.gridLevel >= 0)
+  {
+    // Compact mode - decode from grid
+    WindData wind;
+    m.windGrid.windForCell(layer.gridLevel, point.x(), point.y(), wind.u, wind.v);
+    return wind;
+  }
+  else
+    return EMPTY_WIND_DATA;
 }
 
 Wind WindQuery::getWindAverageForLine(const Line& line) const
@@ -523,20 +724,83 @@ Wind WindQuery::getWindAverageForLine(const Pos& pos1, const Pos& pos2) const
   return windAverageForLine(pos1, pos2).toWind();
 }
 
+void WindQuery::getWindAverageForLegs(QVector<Wind>& winds, const LineString& linestring) const
+{
+  winds.clear();
+  if(linestring.size() < 2)
+    return;
+
+  winds.reserve(linestring.size() - 1);
+
+  std::shared_ptr<const WindModel> m = currentModel();
+  for(int i = 0; i < linestring.size() - 1; i++)
+  {
+    const Pos& pos1 = linestring.at(i);
+    const Pos& pos2 = linestring.at(i + 1);
+    if(m != nullptr && pos1.isValid() && pos2.isValid())
+      winds.append(windAverageForLeg(*m, pos1, pos2).toWind());
+    else
+      winds.append(EMPTY_WIND);
+  }
+}
+
 WindData WindQuery::windAverageForLine(geo::Pos pos1, geo::Pos pos2) const
 {
   WindData windData = EMPTY_WIND_DATA;
 
+  std::shared_ptr<const WindModel> m = currentModel();
+  if(m != nullptr)
+    windData = windAverageForLeg(*m, pos1, pos2);
+  return windData;
+}
+
+WindData WindQuery::windAverageForLeg(const WindModel& m, Pos pos1, Pos pos2) const
+{
+  WindData windData = EMPTY_WIND_DATA;
+  if(!pos1.isValid() || !pos2.isValid())
+    return windData;
+
+  pos1.normalize();
+  pos2.normalize();
+  LegKey key = {{pos1.getLonX(), pos1.getLatY(), pos1.getAltitude(), pos2.getLonX(), pos2.getLatY(),
+                 pos2.getAltitude()}, samplesPerDegree};
+
+  {
+    QMutexLocker locker(&m.legCacheMutex);
+    const WindData *cached = m.legCache.object(key);
+    if(cached != nullptr)
+      return *cached;
+  }
+
+  LineString positions;
+  if(samplePositions(positions, pos1, pos2))
+  {
+    // Interpolate in grid cells and between layers for all positions at once
+    m.windGrid.windSumForPos(positions, windData.u, windData.v);
+
+    windData.u /= positions.size();
+    windData.v /= positions.size();
+
+    QMutexLocker locker(&m.legCacheMutex);
+    m.legCache.insert(key, new WindData(windData));
+  }
+  return windData;
+}
+
+bool WindQuery::samplePositions(LineString& positions, Pos pos1, Pos pos2) const
+{
+  positions.clear();
+
   if(!pos1.isValid())
   {
     qWarning() << Q_FUNC_INFO << "invalid pos1";
-    return windData;
+    return false;
   }
 
   if(!pos2.isValid())
   {
     qWarning() << Q_FUNC_INFO << "invalid pos2";
-    return windData;
+    return false;
   }
 
   pos1.normalize();
@@ -548,8 +812,6 @@ WindData WindQuery::windAverageForLine(geo::Pos pos1, geo::Pos pos2) const
   float meterPerSample = meterPerDeg / samplesPerDegree;
   int numPoints = atools::roundToInt(distanceMeter / meterPerSample);
 
-  LineString positions;
-
   if(numPoints > 1)
   {
     // Calculate number of points - will include origin but not pos2
@@ -560,45 +822,13 @@ WindData WindQuery::windAverageForLine(geo::Pos pos1, geo::Pos pos2) const
     // Only start and end needed
     positions << pos1 << pos2;
 
-  WindRect windRectLower, windRectUpper;
-
-  for(const atools::geo::Pos& pos : qAsConst(positions))
-  {
-    Rect global = globalRect(pos);
-    GridRect grid = gridRect(global);
-
-    // Get next layers below and above altitude
-    WindAltLayer lower, upper;
-    layersByAlt(lower, upper, pos.getAltitude());
-
-    // Get interpolated wind in grid cell at lower layer
-    windRectForLayer(windRectLower, lower, grid);
-    WindData lW = interpolateRect(windRectLower, global, pos);
-
-    WindData w;
-    if(upper != lower)
-    {
-      // Get interpolated wind in grid cell at upper layer
-      windRectForLayer(windRectUpper, upper, grid);
-
-      // Interpolate at altitude between layers
-      w = interpolateWind(lW, interpolateRect(windRectUpper, global, pos),
-                          lower.altitude, upper.altitude, pos.getAltitude());
-    }
-    else
-      w = lW;
-
-    windData.u += w.u;
-    windData.v += w.v;
-  }
-
-  windData.u /= positions.size();
-  windData.v /= positions.size();
-  return windData;
+  return true;
 }
 
-void WindQuery::layersByAlt(WindAltLayer& lower, WindAltLayer& upper, float altitude) const
+void WindQuery::layersByAlt(const WindModel& m, WindAltLayer& lower, WindAltLayer& upper, float altitude) const
 {
+  const QMap<int, WindAltLayer>& windLayers = m.windLayers;
+
   if(windLayers.size() == 1)
     // Only one wind layer
     lower = upper = windLayers.first();
@@ -631,33 +861,12 @@ void WindQuery::layersByAlt(WindAltLayer& lower, WindAltLayer& upper, float alti
   }
 }
 
-WindData WindQuery::interpolateRect(const WindRect& windRect, const atools::geo::Rect& rect, const geo::Pos& pos) const
-{
-  float left = rect.getWest(), right = rect.getEast(), top = rect.getNorth(), bottom = rect.getSouth();
-
-  // Interpolate at top and bottom between left and right
-  WindData wTop = interpolateWind(windRect.topLeft, windRect.topRight, left, right, pos.getLonX());
-  WindData wBottom = interpolateWind(windRect.bottomLeft, windRect.bottomRight, left, right, pos.getLonX());
-
-  // Interpolate between top and bottom
-  return interpolateWind(wTop, wBottom, top, bottom, pos.getLatY());
-}
-
-void WindQuery::windRectForLayer(WindRect& windRect, const WindAltLayer& layer, const GridRect& rect) const
-{
-  windRect.topLeft = windForLayer(layer, rect.topLeft);
-  windRect.topRight = windForLayer(layer, rect.topRight);
-  windRect.bottomRight = windForLayer(layer, rect.bottomRight);
-  windRect.bottomLeft = windForLayer(layer, rect.bottomLeft);
-}
-
 void WindQuery::gribDownloadFinished(const GribDatasetVector& datasets, QString downloadUrl)
 {
   qDebug() << Q_FUNC_INFO << downloadUrl;
 
-  // Download finished - update coordinates
-  convertDataset(datasets);
-  emit windDataUpdated();
+  // Download finished - convert in background and emit windDataUpdated() when done
+  startConversion(datasets, QString());
 }
 
 void WindQuery::gribDownloadFailed(const QString& error, int errorCode, QString downloadUrl)
@@ -666,15 +875,29 @@ void WindQuery::gribDownloadFailed(const QString& error, int errorCode, QString
   emit windDownloadFailed(error, errorCode);
 }
 
-void WindQuery::gribDirUpdated(const QString& dir)
+void WindQuery::gribDirEntriesChanged(const QString& dir, const QStringList& added, const QStringList& removed)
 {
   if(verbose)
-    qDebug() << Q_FUNC_INFO << dir;
+    qDebug() << Q_FUNC_INFO << dir << "added" << added << "removed" << removed;
+
+  // Single file for X-Plane 11 does not depend on folder content
+  if(weatherType != atools::fs::weather::WEATHER_XP12)
+    return;
+
+  // Update sorted file list without reading the folder again
+  for(const QString& file : removed)
+    gribFiles.removeAll(QFileInfo(file).absoluteFilePath());
+
+  for(const QString& file : added)
+  {
+    QString path = QFileInfo(file).absoluteFilePath();
+    gribFiles.insert(std::upper_bound(gribFiles.begin(), gribFiles.end(), path, gribFileLessThan), path);
+  }
 
-  QString gribFile = collectGribFiles();
+  QString gribFile = gribFiles.value(0);
   if(gribFile != currentGribFile)
   {
-    // Read file(s) again if updated and the list has changed
+    // Read file again if the latest file has changed
     currentGribFile = gribFile;
     gribFileUpdated({currentGribFile});
   }
@@ -688,26 +911,8 @@ void WindQuery::gribFileUpdated(const QStringList& filenames)
     qDebug() << Q_FUNC_INFO << filename;
 
   if(!filename.isEmpty())
-  {
-    try
-    {
-      GribReader reader(verbose);
-      reader.readFile(filename);
-      convertDataset(reader.getDatasets());
-    }
-    catch(atools::Exception& e)
-    {
-      emit windDownloadFailed(e.getMessage(), 0);
-      return;
-    }
-    catch(...)
-    {
-      emit windDownloadFailed(tr("Unknown error."), 0);
-      return;
-    }
-
-    emit windDataUpdated();
-  }
+    // Read and convert in background and emit windDataUpdated() or windDownloadFailed() when done
+    startConversion(GribDatasetVector(), filename);
 }
 
 // Required GRIB parameters:
@@ -731,9 +936,9 @@ void WindQuery::gribFileUpdated(const QStringList& filenames)
 // j direction - south to north along a meridian, or bottom to top along a y-axis.
 // V component of wind; northward_wind;
 // U component of wind; eastward_wind;
-void WindQuery::convertDataset(const GribDatasetVector& datasets)
+std::shared_ptr<WindModel> WindQuery::buildModel(const GribDatasetVector& datasets, bool compact, bool verbose)
 {
-  windLayers.clear();
+  std::shared_ptr<WindModel> newModel(new WindModel);
 
   for(int dsidx = 0; dsidx < datasets.size(); dsidx += 2)
   {
@@ -745,7 +950,7 @@ void WindQuery::convertDataset(const GribDatasetVector& datasets)
        datasetVWind.getParameterType() == atools::grib::V_WIND)
     {
       if(datasetUWind.getDatetime().isValid())
-        analyisTime = datasetUWind.getDatetime();
+        newModel->analyisTime = datasetUWind.getDatetime();
 
       const QVector<float>& dataU = datasetUWind.getData();
       const QVector<float>& dataV = datasetVWind.getData();
@@ -763,11 +968,45 @@ void WindQuery::convertDataset(const GribDatasetVector& datasets)
           layer.winds.append(wind);
         }
       }
-      windLayers.insert(atools::roundToInt(layer.altitude), layer);
+      newModel->windLayers.insert(atools::roundToInt(layer.altitude), layer);
     }
     else
       throw atools::Exception("Invalid dataset order for  U and V wind component");
   }
+  updateWindGrid(*newModel, compact, verbose);
+  return newModel;
+}
+
+void WindQuery::updateWindGrid(WindModel& m, bool compact, bool verbose)
+{
+  WindGrid& windGrid = m.windGrid;
+  windGrid.clear();
+  windGrid.setCompact(compact);
+
+  // Map is sorted by altitude
+  QVector<float> u(WindGrid::CELLS), v(WindGrid::CELLS);
+  for(WindAltLayer& layer : m.windLayers)
+  {
+    if(layer.winds.size() == WindGrid::CELLS)
+    {
+      for(int i = 0; i < WindGrid::CELLS; i++)
+      {
+        u[i] = layer.winds.at(i).u;
+        v[i] = layer.winds.at(i).v;
+      }
+      windGrid.addLevel(layer.altitude, u, v);
+      layer.gridLevel = windGrid.getNumLevels() - 1;
+
+      if(compact)
+        // Values are only kept in the grid
+        layer.winds = QVector<WindData>();
+    }
+  }
+  windGrid.finish();
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "levels" << windGrid.getNumLevels() << "compact" << windGrid.isCompact()
+             << "bytes" << windGrid.getSizeBytes();
 }
 
 /* Interpolate wind speed and direction between two altitude layers */
@@ -19,10 +19,17 @@
 #define ATOOLS_GRIB_WINDQUERY_H
 
 #include "grib/gribcommon.h"
+#include "grib/windgrid.h"
 #include "grib/windtypes.h"
 #include "fs/weather/weathertypes.h"
+#include "util/memoryaccounting.h"
 
+#include <QMutex>
 #include <QObject>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
 
 class QObject;
 
@@ -41,10 +48,10 @@ namespace grib {
 
 class GribDownloader;
 
-struct WindRect;
-struct GridRect;
 struct WindData;
 struct WindAltLayer;
+struct WindModel;
+class WindConversionTask;
 
 /*
  * Takes care for downloading/reading and decoding of GRIB2 wind files. Provides a query API to calculate and interpolate
@@ -57,6 +64,11 @@ struct WindAltLayer;
  * Data is updated automatically every 30 minutes.
  * Files are checked for changes.
  *
+ * Downloaded or changed files are converted in a background thread. The result is an immutable wind model which is
+ * published by an atomic pointer swap. Queries take a snapshot of the current model and never block or see
+ * partially converted data. windDataUpdated() is emitted in the thread of this object once the new model is active.
+ * Average winds for legs are memoized in the model and are dropped together with it when new data is published.
+ *
  * All internal calculations the U and V components of the wind instead of speed and direction.
  * Most query methods use the altitude from the Pos parameter.
  *
@@ -73,7 +85,7 @@ struct WindAltLayer;
  * 50000 ft | 11.6 mb       | 100            |            |
  */
 class WindQuery
-  : public QObject
+  : public QObject, public atools::util::MemoryAccountable
 {
   Q_OBJECT
 
@@ -106,6 +118,10 @@ public:
   /* Get interpolated wind data for single position. Altitude in feet is used from position. */
   Wind getWindForPos(atools::geo::Pos pos, bool interpolateValue = true) const;
 
+  /* Get interpolated wind data for many positions at once. Altitude in feet is used from positions.
+   * winds contains one entry for each position. Invalid positions give EMPTY_WIND. */
+  void getWindForPosList(QVector<atools::grib::Wind>& winds, QVector<atools::geo::Pos> positions) const;
+
   /* Get an array of wind data for the given rectangle at the given altitude from the data grid.
    * Data is only interpolated between layers. Result is sorted by y and x coordinates. */
   void getWindForRect(atools::grib::WindPosList& result, atools::geo::Rect rect, float altFeet, int gridSpacing) const;
@@ -118,9 +134,17 @@ public:
   Wind getWindAverageForLine(const atools::geo::Line& line) const;
   Wind getWindAverageForLineString(const atools::geo::LineString& linestring) const;
 
-  bool hasWindData() const
+  /* Get average wind for each leg of the line string as getWindAverageForLine() does. winds will contain
+   * linestring.size() - 1 entries. Uses the same model for all legs. Fills EMPTY_WIND if no data is available. */
+  void getWindAverageForLegs(QVector<atools::grib::Wind>& winds, const atools::geo::LineString& linestring) const;
+
+  bool hasWindData() const;
+
+  /* Keep winds only as 16 bit fixed point values in the grid to save memory. Grid points are decoded on the fly.
+   * Takes effect with the next data update. */
+  void setCompactStorage(bool value)
   {
-    return !windLayers.isEmpty();
+    compactStorage = value;
   }
 
   /* Samples per degree for wind interpolation along lines and line strings */
@@ -136,10 +160,7 @@ public:
   void setIgnoreSslErrors(bool value);
 
   /* Latest analysis time from the dataset. Updated four times a day in six hour steps */
-  const QDateTime& getAnalyisTime() const
-  {
-    return analyisTime;
-  }
+  QDateTime getAnalyisTime() const;
 
   /* Validity period */
   void getValidity(QDateTime& from, QDateTime& to) const;
@@ -147,6 +168,12 @@ public:
   /* Print the size of all container classes to detect overflow or memory leak conditions */
   void debugDumpContainerSizes() const;
 
+  /* Wind layers, grid and leg cache of the current model. Elements are grid values of all layers. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
+  /* Clears the leg cache of the current model */
+  virtual void releaseMemory(qint64 maxBytes) override;
+
 signals:
   /* Download successfully finished. Emitted for all init methods. */
   void windDataUpdated();
@@ -160,27 +187,39 @@ signals:
   void windDownloadProgress(qint64 bytesReceived, qint64 bytesTotal, QString downloadUrl);
 
 private:
+  friend class atools::grib::WindConversionTask;
+
   /* Wind for grid position */
-  WindData windForLayer(const WindAltLayer& layer, const QPoint& point) const;
+  WindData windForLayer(const WindModel& m, const WindAltLayer& layer, const QPoint& point) const;
 
   /* Get layer above and below (or at) altitude */
-  void layersByAlt(WindAltLayer& lower, WindAltLayer& upper, float altitude) const;
+  void layersByAlt(const WindModel& m, WindAltLayer& lower, WindAltLayer& upper, float altitude) const;
+
+  /* Convert data from U/V components to a new model. Thread safe. Throws atools::Exception on invalid data. */
+  static std::shared_ptr<WindModel> buildModel(const atools::grib::GribDatasetVector& datasets, bool compact,
+                                               bool verbose);
+
+  /* Copy all layers into windGrid of model */
+  static void updateWindGrid(WindModel& m, bool compact, bool verbose);
 
-  /* Fill cell rectangle with wind values at corners */
-  void windRectForLayer(WindRect& windRect, const WindAltLayer& layer, const atools::grib::GridRect& rect) const;
+  /* Snapshot of the current model for readers. Null if no data. Thread safe. */
+  std::shared_ptr<const WindModel> currentModel() const;
 
-  /* Quadratic interpolation- Returns wind for position in the grid cell */
-  WindData interpolateRect(const WindRect& windRect, const geo::Rect& rect, const geo::Pos& pos) const;
+  /* Make model current if generation is still valid. Returns false if result was dropped. Thread safe. */
+  bool publish(const std::shared_ptr<const WindModel>& newModel, int modelGeneration);
 
-  /* Convert data from U/V components to speed/heading */
-  void convertDataset(const atools::grib::GribDatasetVector& datasets);
+  /* Read file if not empty or convert datasets in background */
+  void startConversion(const atools::grib::GribDatasetVector& datasets, const QString& filename);
+
+  /* Called in object thread after background conversion. Emits signals. */
+  void conversionFinished(int modelGeneration, const QString& error);
 
   void gribDownloadFinished(const atools::grib::GribDatasetVector& datasets, QString downloadUrl);
   void gribDownloadFailed(const QString& error, int errorCode, QString downloadUrl);
 
   /* Called from FileSystemWatcher */
   void gribFileUpdated(const QStringList& filenames);
-  void gribDirUpdated(const QString& dir);
+  void gribDirEntriesChanged(const QString& dir, const QStringList& added, const QStringList& removed);
 
   /* get interpolated wind for two sets at two altitudes */
   WindData interpolateWind(const WindData& w0, const WindData& w1, float alt0, float alt1, float alt) const;
@@ -189,6 +228,15 @@ private:
    *  Normalizes positions to avoid overflow on grid access */
   WindData windAverageForLine(atools::geo::Pos pos1, atools::geo::Pos pos2) const;
 
+  /* Same as above for the given model. Results are memoized per model so unchanged legs are not
+   * interpolated again until the next data update. Thread safe. */
+  WindData windAverageForLeg(const WindModel& m, atools::geo::Pos pos1, atools::geo::Pos pos2) const;
+
+  /* Fill positions with samples along the great circle line including both ends. Altitude is interpolated.
+   * Returns false and leaves positions empty if one position is invalid. */
+  bool samplePositions(atools::geo::LineString& positions, atools::geo::Pos pos1, atools::geo::Pos pos2) const;
+
+  /* Read all GRIB files from folder into gribFiles and return the latest */
   QString collectGribFiles();
 
   /* Surfaces to download from NOAA. Negative value denotes AGL in ft and positive is millibar level.
@@ -220,14 +268,23 @@ private:
   /* Check for file changes */
   atools::util::FileSystemWatcher *fileWatcher = nullptr;
 
-  bool verbose = false;
+  bool verbose = false, compactStorage = false;
+
+  /* Current immutable wind data. Always accessed using std::atomic_load and std::atomic_store. */
+  std::shared_ptr<const WindModel> model;
+
+  /* Incremented on deinit() to drop results of running conversions */
+  std::atomic_int generation;
+
+  /* Serializes generation check and model swap for writers. Never used by readers. */
+  QMutex publishMutex;
 
-  /* Maps rounded altitude to wind layer data. Sorted by altitude. */
-  QMap<int, WindAltLayer> windLayers;
-  QDateTime analyisTime;
+  /* Single thread for background conversion */
+  QThreadPool conversionPool;
 
   QString weatherPath; // Folder or file depending on simulator
   QString currentGribFile; // Latest from a collected list from folder (XP12)
+  QStringList gribFiles; // All files in folder sorted by timestamp with latest first (XP12)
 
   atools::fs::weather::XpWeatherType weatherType = atools::fs::weather::WEATHER_XP_UNKNOWN;
 };
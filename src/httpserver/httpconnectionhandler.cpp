@@ -5,24 +5,33 @@
 
 #include "httpconnectionhandler.h"
 #include "httpresponse.h"
+#include "util/metrics.h"
+
+#include <QElapsedTimer>
 
 using namespace stefanfrings;
 
 HttpConnectionHandler::HttpConnectionHandler(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler,
-                                             const QSslConfiguration *sslConfiguration)
+                                             QThread *thread, const QSslConfiguration *sslConfiguration)
   : QObject()
 {
   Q_ASSERT(requestHandler != nullptr);
+  Q_ASSERT(thread != nullptr);
   this->settings = settings;
   this->requestHandler = requestHandler;
   this->sslConfiguration = sslConfiguration;
   currentRequest = nullptr;
-  busy = false;
+  numRequests = 0;
+  closing = false;
+
+  readTimeoutMs = settings.value("readTimeout", 10000).toInt();
+  keepAliveTimeoutMs = settings.value("keepAliveTimeout", readTimeoutMs).toInt();
+  maxKeepAliveRequests = settings.value("maxKeepAliveRequests", 1000).toInt();
+  compression = settings.value("compression", true).toBool();
+  minCompressSize = settings.value("minCompressSize", 1024).toInt();
+  compressionLevel = settings.value("compressionLevel", -1).toInt();
 
-  // execute signals in a new thread
-  thread = new QThread();
-  thread->start();
-  qDebug("HttpConnectionHandler (%p): thread started", static_cast<void *>(this));
+  // execute signals in the worker thread which is shared with other connections
   moveToThread(thread);
   readTimer.moveToThread(thread);
   readTimer.setSingleShot(true);
@@ -37,23 +46,33 @@ HttpConnectionHandler::HttpConnectionHandler(QHash<QString, QVariant> settings,
   connect(&readTimer, SIGNAL(timeout()), SLOT(readTimeout()));
   connect(thread, SIGNAL(finished()), this, SLOT(thread_done()));
 
+#ifdef SUPERVERBOSE
   qDebug("HttpConnectionHandler (%p): constructed", static_cast<void *>(this));
+#endif
 }
 
 void HttpConnectionHandler::thread_done()
 {
   readTimer.stop();
-  socket->close();
-  delete socket;
+  if(socket != nullptr)
+  {
+    socket->close();
+    delete socket;
+    socket = nullptr;
+  }
   qDebug("HttpConnectionHandler (%p): thread stopped", static_cast<void *>(this));
 }
 
 HttpConnectionHandler::~HttpConnectionHandler()
 {
-  thread->quit();
-  thread->wait();
-  thread->deleteLater();
+  stopEventStream();
+
+  // Socket is already deleted if the worker thread was stopped before
+  delete socket;
+  delete currentRequest;
+#ifdef SUPERVERBOSE
   qDebug("HttpConnectionHandler (%p): destroyed", static_cast<void *>(this));
+#endif
 }
 
 void HttpConnectionHandler::createSocket()
@@ -75,19 +94,17 @@ void HttpConnectionHandler::createSocket()
 
 void HttpConnectionHandler::handleConnection(tSocketDescriptor socketDescriptor)
 {
+#ifdef SUPERVERBOSE
   qDebug("HttpConnectionHandler (%p): handle new connection", static_cast<void *>(this));
-  busy = true;
+#endif
   Q_ASSERT(socket->isOpen() == false); // if not, then the handler is already busy
 
-  // UGLY workaround - we need to clear writebuffer before reusing this socket
-  // https://bugreports.qt-project.org/browse/QTBUG-28914
-  socket->connectToHost("", 0);
-  socket->abort();
-
   if(!socket->setSocketDescriptor(socketDescriptor))
   {
     qCritical("HttpConnectionHandler (%p): cannot initialize socket: %s",
               static_cast<void *>(this), qPrintable(socket->errorString()));
+    closing = true;
+    emit finished(this);
     return;
   }
 
@@ -101,21 +118,7 @@ void HttpConnectionHandler::handleConnection(tSocketDescriptor socketDescriptor)
     #endif
 
   // Start timer for read timeout
-  int readTimeout = settings.value("readTimeout", 10000).toInt();
-  readTimer.start(readTimeout);
-  // delete previous request
-  delete currentRequest;
-  currentRequest = nullptr;
-}
-
-bool HttpConnectionHandler::isBusy()
-{
-  return busy;
-}
-
-void HttpConnectionHandler::setBusy()
-{
-  this->busy = true;
+  readTimer.start(readTimeoutMs);
 }
 
 void HttpConnectionHandler::readTimeout()
@@ -125,25 +128,53 @@ void HttpConnectionHandler::readTimeout()
   // Commented out because QWebView cannot handle this.
   // socket->write("HTTP/1.1 408 request timeout\r\nConnection: close\r\n\r\n408 request timeout\r\n");
 
-  while(socket->bytesToWrite())
-    socket->waitForBytesWritten();
-  socket->disconnectFromHost();
+  closeSocket();
   delete currentRequest;
   currentRequest = nullptr;
 }
 
 void HttpConnectionHandler::disconnected()
 {
+#ifdef SUPERVERBOSE
   qDebug("HttpConnectionHandler (%p): disconnected", static_cast<void *>(this));
+#endif
   socket->close();
   readTimer.stop();
-  busy = false;
+  closing = true;
+  stopEventStream();
+
+  // Pool will delete this handler later in the worker thread
+  emit finished(this);
+}
+
+void HttpConnectionHandler::closeSocket()
+{
+  if(closing)
+    // Already closing or disconnected
+    return;
+
+  closing = true;
+  readTimer.stop();
+
+  // Does not block. The socket sends all pending data before closing and emits disconnected() then.
+  if(socket->state() == QAbstractSocket::UnconnectedState)
+    disconnected();
+  else
+    socket->disconnectFromHost();
 }
 
 void HttpConnectionHandler::read()
 {
-  // The loop adds support for HTTP pipelinig
-  while(socket->bytesAvailable())
+  if(eventStream != nullptr)
+  {
+    // Client only listens - discard anything it sends
+    socket->readAll();
+    return;
+  }
+
+  // The loop adds support for HTTP pipelining. Requests which were received while a response was
+  // generated are still in the socket buffer and are processed in order.
+  while(!closing && socket->bytesAvailable())
   {
         #ifdef SUPERVERBOSE
     qDebug("HttpConnectionHandler (%p): read input", static_cast<void *>(this));
@@ -153,6 +184,9 @@ void HttpConnectionHandler::read()
     if(!currentRequest)
     {
       currentRequest = new HttpRequest(settings);
+
+      // First bytes of a new request - whole request has to arrive within the read timeout
+      readTimer.start(readTimeoutMs);
     }
 
     // Collect data for the request object
@@ -164,8 +198,7 @@ void HttpConnectionHandler::read()
       {
         // Restart timer for read timeout, otherwise it would
         // expire during large file uploads.
-        int readTimeout = settings.value("readTimeout", 10000).toInt();
-        readTimer.start(readTimeout);
+        readTimer.start(readTimeoutMs);
       }
     }
 
@@ -173,9 +206,7 @@ void HttpConnectionHandler::read()
     if(currentRequest->getStatus() == HttpRequest::abort)
     {
       socket->write("HTTP/1.1 413 entity too large\r\nConnection: close\r\n\r\n413 Entity too large\r\n");
-      while(socket->bytesToWrite())
-        socket->waitForBytesWritten();
-      socket->disconnectFromHost();
+      closeSocket();
       delete currentRequest;
       currentRequest = nullptr;
       return;
@@ -185,89 +216,155 @@ void HttpConnectionHandler::read()
     if(currentRequest->getStatus() == HttpRequest::complete)
     {
       readTimer.stop();
-      // qDebug("HttpConnectionHandler (%p): received request", static_cast<void *>(this));
+      bool closeConnection = serviceRequest();
+      delete currentRequest;
+      currentRequest = nullptr;
 
-      // Copy the Connection:close header to the response
-      HttpResponse response(socket);
-      bool closeConnection =
-        QString::compare(currentRequest->getHeader("Connection"), "close", Qt::CaseInsensitive) == 0;
+      if(eventStream != nullptr)
+        // Connection is kept open for events only
+        return;
+
+      // Close the connection or prepare for the next request on the same connection.
       if(closeConnection)
-      {
-        response.setHeader("Connection", "close");
-      }
-      // In case of HTTP 1.0 protocol add the Connection:close header.
-      // This ensures that the HttpResponse does not activate chunked mode, which is not spported by HTTP 1.0.
+        closeSocket();
       else
-      {
-        bool http1_0 = QString::compare(currentRequest->getVersion(), "HTTP/1.0", Qt::CaseInsensitive) == 0;
-        if(http1_0)
-        {
-          closeConnection = true;
-          response.setHeader("Connection", "close");
-        }
-      }
+        // Wait for next request using the idle timeout
+        readTimer.start(keepAliveTimeoutMs);
+    }
+  }
+}
 
-      // Call the request mapper
-      try
-      {
-        requestHandler->service(*currentRequest, response);
-      }
-      catch(...)
-      {
-        qCritical("HttpConnectionHandler (%p): An uncatched exception occured in the request handler",
-                  static_cast<void *>(this));
-      }
+bool HttpConnectionHandler::serviceRequest()
+{
+  // qDebug("HttpConnectionHandler (%p): received request", static_cast<void *>(this));
+  numRequests++;
 
-      // Finalize sending the response if not already done
-      if(!response.hasSentLastPart())
-      {
-        response.write(QByteArray(), true);
-      }
+  // Copy the Connection:close header to the response
+  HttpResponse response(socket);
+  bool closeConnection =
+    QString::compare(currentRequest->getHeader("Connection"), "close", Qt::CaseInsensitive) == 0;
 
-      // qDebug("HttpConnectionHandler (%p): finished request", static_cast<void *>(this));
+  // In case of HTTP 1.0 protocol add the Connection:close header.
+  // This ensures that the HttpResponse does not activate chunked mode, which is not spported by HTTP 1.0.
+  if(!closeConnection)
+    closeConnection = QString::compare(currentRequest->getVersion(), "HTTP/1.0", Qt::CaseInsensitive) == 0;
 
-      // Find out whether the connection must be closed
-      if(!closeConnection)
+  // Limit number of requests per connection
+  if(!closeConnection && maxKeepAliveRequests > 0)
+    closeConnection = numRequests >= maxKeepAliveRequests;
+
+  if(closeConnection)
+  {
+    response.setHeader("Connection", "close");
+  }
+
+  // Allow compression of single part responses
+  if(compression)
+  {
+    response.setCompression(currentRequest->acceptsEncoding("gzip"), currentRequest->acceptsEncoding("deflate"),
+                            minCompressSize, compressionLevel);
+  }
+
+  static atools::util::MetricCounter& requestCounter =
+    atools::util::Metrics::instance().counter("atools_http_requests_total", "HTTP requests handled");
+  static atools::util::MetricCounter& errorCounter =
+    atools::util::Metrics::instance().counter("atools_http_request_exceptions_total",
+                                              "HTTP requests aborted by an exception in the request handler");
+  static atools::util::MetricHistogram& latencyHistogram =
+    atools::util::Metrics::instance().histogram("atools_http_request_duration_seconds",
+                                                "Time spent in the request handler");
+
+  // Call the request mapper
+  QElapsedTimer serviceTimer;
+  serviceTimer.start();
+  try
+  {
+    requestHandler->service(*currentRequest, response);
+  }
+  catch(...)
+  {
+    errorCounter.increment();
+    qCritical("HttpConnectionHandler (%p): An uncatched exception occured in the request handler",
+              static_cast<void *>(this));
+  }
+  requestCounter.increment();
+  latencyHistogram.observe(serviceTimer.nsecsElapsed() / 1.e9);
+
+  if(response.getEventStream() != nullptr)
+  {
+    startEventStream(response.getEventStream());
+    return false;
+  }
+
+  // Finalize sending the response if not already done
+  if(!response.hasSentLastPart())
+  {
+    response.write(QByteArray(), true);
+  }
+
+  // qDebug("HttpConnectionHandler (%p): finished request", static_cast<void *>(this));
+
+  // Find out whether the connection must be closed
+  if(!closeConnection)
+  {
+    // Maybe the request handler or mapper added a Connection:close header in the meantime
+    bool closeResponse =
+      QString::compare(response.getHeaders().value("Connection"), "close", Qt::CaseInsensitive) == 0;
+    if(closeResponse == true)
+    {
+      closeConnection = true;
+    }
+    else
+    {
+      // If we have no Content-Length header and did not use chunked mode, then we have to close the
+      // connection to tell the HTTP client that the end of the response has been reached.
+      bool hasContentLength = response.getHeaders().contains("Content-Length");
+      if(!hasContentLength)
       {
-        // Maybe the request handler or mapper added a Connection:close header in the meantime
-        bool closeResponse =
-          QString::compare(response.getHeaders().value("Connection"), "close", Qt::CaseInsensitive) == 0;
-        if(closeResponse == true)
+        bool hasChunkedMode = QString::compare(response.getHeaders().value(
+                                                 "Transfer-Encoding"), "chunked", Qt::CaseInsensitive) == 0;
+        if(!hasChunkedMode)
         {
           closeConnection = true;
         }
-        else
-        {
-          // If we have no Content-Length header and did not use chunked mode, then we have to close the
-          // connection to tell the HTTP client that the end of the response has been reached.
-          bool hasContentLength = response.getHeaders().contains("Content-Length");
-          if(!hasContentLength)
-          {
-            bool hasChunkedMode = QString::compare(response.getHeaders().value(
-                                                     "Transfer-Encoding"), "chunked", Qt::CaseInsensitive) == 0;
-            if(!hasChunkedMode)
-            {
-              closeConnection = true;
-            }
-          }
-        }
-      }
-
-      // Close the connection or prepare for the next request on the same connection.
-      if(closeConnection)
-      {
-        while(socket->bytesToWrite())
-          socket->waitForBytesWritten();
-        socket->disconnectFromHost();
-      }
-      else
-      {
-        // Start timer for next request
-        int readTimeout = settings.value("readTimeout", 10000).toInt();
-        readTimer.start(readTimeout);
       }
-      delete currentRequest;
-      currentRequest = nullptr;
     }
   }
+  return closeConnection;
+}
+
+void HttpConnectionHandler::startEventStream(HttpEventStream *stream)
+{
+  eventStream = stream;
+  eventStream->addClient();
+
+  // Queued from the publishing thread into this worker thread
+  connect(stream, &HttpEventStream::framePublished, this, &HttpConnectionHandler::writeEvent);
+  socket->write(stream->getInitialFrames());
+}
+
+void HttpConnectionHandler::stopEventStream()
+{
+  if(eventStream != nullptr)
+  {
+    disconnect(eventStream, &HttpEventStream::framePublished, this, &HttpConnectionHandler::writeEvent);
+    eventStream->removeClient();
+  }
+  eventStream = nullptr;
+}
+
+void HttpConnectionHandler::writeEvent(const QByteArray& frame)
+{
+  if(closing || eventStream == nullptr)
+    return;
+
+  // Disconnect slow clients instead of buffering without limit. They reconnect and get the retained state.
+  if(socket->bytesToWrite() > eventStream->getMaxEventBuffer())
+  {
+    qWarning("HttpConnectionHandler (%p): event client too slow, closing", static_cast<void *>(this));
+    stopEventStream();
+    closeSocket();
+    return;
+  }
+  socket->write(frame);
 }
@@ -12,9 +12,11 @@
 #include <QTcpSocket>
 #include <QTimer>
 #include <QThread>
+#include <QPointer>
 #include "httpglobal.h"
 #include "httprequest.h"
 #include "httprequesthandler.h"
+#include "httpeventstream.h"
 
 namespace stefanfrings {
 
@@ -31,18 +33,37 @@ typedef int tSocketDescriptor;
 #endif
 
 /**
- *  The connection handler accepts incoming connections and dispatches incoming requests to to a
+ *  The connection handler serves one accepted connection and dispatches incoming requests to to a
  *  request mapper. Since HTTP clients can send multiple requests before waiting for the response,
- *  the incoming requests are queued and processed one after the other.
+ *  the incoming requests are queued and processed one after the other (pipelining).
+ *  The connection is kept open for further requests (keep-alive) unless the client or the response asks for close.
+ *  <p>
+ *  Handlers do not own a thread. They are moved into one of the worker threads of the
+ *  HttpConnectionHandlerPool and share its event loop with all other connections of this worker.
+ *  A handler emits finished() once the connection is closed and is deleted by the pool afterwards.
  *  <p>
  *  Example for the required configuration settings:
  *  <code><pre>
  *  readTimeout=60000
+ *  keepAliveTimeout=10000
+ *  maxKeepAliveRequests=1000
+ *  compression=true
+ *  minCompressSize=1024
+ *  compressionLevel=-1
  *  maxRequestSize=16000
  *  maxMultiPartSize=1000000
  *  </pre></code>
  *  <p>
  *  The readTimeout value defines the maximum time to wait for a complete HTTP request.
+ *  keepAliveTimeout is the maximum idle time between two requests on the same connection and defaults to readTimeout.
+ *  maxKeepAliveRequests limits the number of requests per connection. 0 means no limit.
+ *  compression enables gzip or deflate compression of responses depending on the Accept-Encoding header.
+ *  Bodies smaller than minCompressSize bytes are sent uncompressed.
+ *  <p>
+ *  A connection turned into a server-sent event stream by the request handler stays open without timeout
+ *  and only forwards the events of the stream. Further requests on this connection are ignored.
+ *  @see HttpEventStream
+ *  @see HttpResponse::setCompression()
  *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize.
  */
 class DECLSPEC HttpConnectionHandler :
@@ -53,22 +74,21 @@ class DECLSPEC HttpConnectionHandler :
 
 public:
   /**
-   *  Constructor.
+   *  Constructor. The handler and its socket are moved into the given thread.
    *  @param settings Configuration settings of the HTTP webserver
    *  @param requestHandler Handler that will process each incoming HTTP request
+   *  @param thread Worker thread that processes events of this connection
    *  @param sslConfiguration SSL (HTTPS) will be used if not NULL
    */
-  HttpConnectionHandler(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler,
+  HttpConnectionHandler(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler, QThread *thread,
                         const QSslConfiguration *sslConfiguration = nullptr);
 
   /** Destructor */
   virtual ~HttpConnectionHandler() override;
 
-  /** Returns true, if this handler is in use. */
-  bool isBusy();
-
-  /** Mark this handler as busy */
-  void setBusy();
+signals:
+  /** Emitted in the worker thread when the connection has been closed and the handler can be deleted */
+  void finished(stefanfrings::HttpConnectionHandler *handler);
 
 private:
   /** Configuration settings */
@@ -77,9 +97,6 @@ private:
   /** TCP socket of the current connection  */
   QTcpSocket *socket;
 
-  /** The thread that processes events of this connection */
-  QThread *thread;
-
   /** Time for read timeout detection */
   QTimer readTimer;
 
@@ -89,15 +106,40 @@ private:
   /** Dispatches received requests to services */
   HttpRequestHandler *requestHandler;
 
-  /** This shows the busy-state from a very early time */
-  bool busy;
-
   /** Configuration for SSL */
   const QSslConfiguration *sslConfiguration;
 
+  /** Settings read once from the configuration */
+  int readTimeoutMs, keepAliveTimeoutMs, maxKeepAliveRequests;
+
+  /** Compression settings passed to each response */
+  bool compression;
+  int minCompressSize, compressionLevel;
+
+  /** Number of requests served on this connection */
+  int numRequests;
+
+  /** Set once the connection is closing. Remaining pipelined requests are ignored. */
+  bool closing;
+
+  /** Set if the connection was turned into a server-sent event stream */
+  QPointer<HttpEventStream> eventStream;
+
   /**  Create SSL or TCP socket */
   void createSocket();
 
+  /** Close the connection after all pending data was sent without blocking the worker thread */
+  void closeSocket();
+
+  /** Process a complete request. Returns true if the connection has to be closed afterwards. */
+  bool serviceRequest();
+
+  /** Start forwarding events to the client */
+  void startEventStream(HttpEventStream *stream);
+
+  /** Stop forwarding events */
+  void stopEventStream();
+
 public slots:
   /**
    *  Received from from the listener, when the handler shall start processing a new connection.
@@ -115,9 +157,12 @@ private slots:
   /** Received from the socket when a connection has been closed */
   void disconnected();
 
-  /** Cleanup after the thread is closed */
+  /** Cleanup after the worker thread is closed */
   void thread_done();
 
+  /** Received from the event stream in the worker thread */
+  void writeEvent(const QByteArray& frame);
+
 };
 
 } // end of namespace
@@ -16,70 +16,81 @@ HttpConnectionHandlerPool::HttpConnectionHandlerPool(QHash<QString, QVariant> se
   this->settings = settings;
   this->requestHandler = requestHandler;
   this->sslConfiguration = NULL;
+  nextWorker = 0;
+  maxConnections = settings.value("maxConnections", 1000).toInt();
   loadSslConfig();
-  cleanupTimer.start(settings.value("cleanupInterval", 1000).toInt());
-  connect(&cleanupTimer, SIGNAL(timeout()), SLOT(cleanup()));
+
+  // Start a fixed number of worker threads - each one serves many connections in its event loop
+  int numWorkers = settings.value("workerThreads", QThread::idealThreadCount()).toInt();
+  if(numWorkers < 1)
+  {
+    numWorkers = 1;
+  }
+  for(int i = 0; i < numWorkers; i++)
+  {
+    QThread *thread = new QThread();
+    thread->start();
+    workers.append(thread);
+  }
+  qDebug("HttpConnectionHandlerPool (%p): started %i worker threads", this, numWorkers);
 }
 
 HttpConnectionHandlerPool::~HttpConnectionHandlerPool()
 {
-  // delete all connection handlers and wait until their threads are closed
+  // Stop all worker threads. Handlers close their sockets when the thread finishes.
+  foreach(QThread * thread, workers)
+  {
+    thread->quit();
+    thread->wait();
+  }
+
+  // delete all remaining connection handlers after their threads are closed
+  mutex.lock();
   foreach(HttpConnectionHandler * handler, pool)
   {
     delete handler;
   }
+  pool.clear();
+  mutex.unlock();
+
+  qDeleteAll(workers);
+  workers.clear();
   delete sslConfiguration;
   qDebug("HttpConnectionHandlerPool (%p): destroyed", this);
 }
 
 HttpConnectionHandler *HttpConnectionHandlerPool::getConnectionHandler()
 {
-  HttpConnectionHandler *freeHandler = 0;
+  HttpConnectionHandler *handler = 0;
   mutex.lock();
-  // find a free handler in pool
-  foreach(HttpConnectionHandler * handler, pool)
-  {
-    if(!handler->isBusy())
-    {
-      freeHandler = handler;
-      freeHandler->setBusy();
-      break;
-    }
-  }
-  // create a new handler, if necessary
-  if(!freeHandler)
+  if(pool.count() < maxConnections)
   {
-    int maxConnectionHandlers = settings.value("maxThreads", 100).toInt();
-    if(pool.count() < maxConnectionHandlers)
-    {
-      freeHandler = new HttpConnectionHandler(settings, requestHandler, sslConfiguration);
-      freeHandler->setBusy();
-      pool.append(freeHandler);
-    }
+    // Assign connections to workers round robin
+    QThread *thread = workers.at(nextWorker);
+    nextWorker = (nextWorker + 1) % workers.size();
+
+    handler = new HttpConnectionHandler(settings, requestHandler, thread, sslConfiguration);
+
+    // Direct connection since the signal is sent from the worker thread
+    connect(handler, SIGNAL(finished(stefanfrings::HttpConnectionHandler *)),
+            this, SLOT(handlerFinished(stefanfrings::HttpConnectionHandler *)), Qt::DirectConnection);
+    pool.append(handler);
   }
   mutex.unlock();
-  return freeHandler;
+  return handler;
 }
 
-void HttpConnectionHandlerPool::cleanup()
+void HttpConnectionHandlerPool::handlerFinished(HttpConnectionHandler *handler)
 {
-  int maxIdleHandlers = settings.value("minThreads", 1).toInt();
-  int idleCounter = 0;
   mutex.lock();
-  foreach(HttpConnectionHandler * handler, pool)
+  bool found = pool.removeOne(handler);
+  mutex.unlock();
+
+  if(found)
   {
-    if(!handler->isBusy())
-    {
-      if(++idleCounter > maxIdleHandlers)
-      {
-        delete handler;
-        pool.removeOne(handler);
-        qDebug("HttpConnectionHandlerPool: Removed connection handler (%p), pool size is now %i", handler, pool.size());
-        break;         // remove only one handler in each interval
-      }
-    }
+    // Handler lives in the worker thread and is deleted there
+    handler->deleteLater();
   }
-  mutex.unlock();
 }
 
 void HttpConnectionHandlerPool::loadSslConfig()
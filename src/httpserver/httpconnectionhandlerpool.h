@@ -2,7 +2,7 @@
 #define HTTPCONNECTIONHANDLERPOOL_H
 
 #include <QList>
-#include <QTimer>
+#include <QVector>
 #include <QObject>
 #include <QMutex>
 #include "httpglobal.h"
@@ -11,24 +11,23 @@
 namespace stefanfrings {
 
 /**
- *  Pool of http connection handlers. The size of the pool grows and
- *  shrinks on demand.
+ *  Pool of worker threads serving HTTP connections. A fixed number of worker threads is started with
+ *  the pool. Each worker runs an event loop which multiplexes many connections. New connections are
+ *  assigned to the workers round robin and the connection handler is deleted once the connection is closed.
  *  <p>
  *  Example for the required configuration settings:
  *  <code><pre>
- *  minThreads=4
- *  maxThreads=100
- *  cleanupInterval=60000
+ *  workerThreads=4
+ *  maxConnections=1000
  *  readTimeout=60000
+ *  keepAliveTimeout=10000
  *  ;sslKeyFile=ssl/my.key
  *  ;sslCertFile=ssl/my.cert
  *  maxRequestSize=16000
  *  maxMultiPartSize=1000000
  *  </pre></code>
- *  After server start, the size of the thread pool is always 0. Threads
- *  are started on demand when requests come in. The cleanup timer reduces
- *  the number of idle threads slowly by closing one thread in each interval.
- *  But the configured minimum number of threads are kept running.
+ *  workerThreads defaults to the number of CPU cores. maxConnections is the maximum number of open connections
+ *  over all workers. Connections beyond this limit are rejected by the listener.
  *  <p>
  *  For SSL support, you need an OpenSSL certificate file and a key file.
  *  Both can be created with the command
@@ -41,7 +40,7 @@ namespace stefanfrings {
  *  Please note that a listener with SSL settings can only handle HTTPS protocol. To
  *  support both HTTP and HTTPS simultaneously, you need to start two listeners on different ports -
  *  one with SLL and one without SSL.
- *  @see HttpConnectionHandler for description of the readTimeout
+ *  @see HttpConnectionHandler for description of the readTimeout and keep-alive settings
  *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
  */
 
@@ -63,7 +62,7 @@ public:
   /** Destructor */
   virtual ~HttpConnectionHandlerPool() override;
 
-  /** Get a free connection handler, or 0 if not available. */
+  /** Create a connection handler in the next worker thread, or 0 if the maximum number of connections is reached. */
   HttpConnectionHandler *getConnectionHandler();
 
 private:
@@ -73,11 +72,17 @@ private:
   /** Will be assigned to each Connectionhandler during their creation */
   HttpRequestHandler *requestHandler;
 
-  /** Pool of connection handlers */
+  /** Handlers of all open connections */
   QList<HttpConnectionHandler *> pool;
 
-  /** Timer to clean-up unused connection handler */
-  QTimer cleanupTimer;
+  /** Worker threads running an event loop each */
+  QVector<QThread *> workers;
+
+  /** Index of the worker which gets the next connection */
+  int nextWorker;
+
+  /** Maximum number of open connections */
+  int maxConnections;
 
   /** Used to synchronize threads */
   QMutex mutex;
@@ -89,8 +94,8 @@ private:
   void loadSslConfig();
 
 private slots:
-  /** Received from the clean-up timer.  */
-  void cleanup();
+  /** Received from a handler in its worker thread when the connection was closed. Deletes the handler later. */
+  void handlerFinished(stefanfrings::HttpConnectionHandler *handler);
 
 };
 
@@ -0,0 +1,92 @@
+/**
+ *  @file
+ */
+
+#include "httpeventstream.h"
+
+using namespace stefanfrings;
+
+HttpEventStream::HttpEventStream(QHash<QString, QVariant> settings, QObject *parent)
+  : QObject(parent)
+{
+  maxEventBuffer = settings.value("maxEventBuffer", 1000000).toLongLong();
+  retry = settings.value("retry", 3000).toInt();
+
+  int heartbeatInterval = settings.value("heartbeatInterval", 15000).toInt();
+  connect(&heartbeatTimer, SIGNAL(timeout()), this, SLOT(heartbeat()));
+  if(heartbeatInterval > 0)
+  {
+    heartbeatTimer.start(heartbeatInterval);
+  }
+  qDebug("HttpEventStream: heartbeat=%i, retry=%i, maxEventBuffer=%lli", heartbeatInterval, retry, maxEventBuffer);
+}
+
+void HttpEventStream::accept(HttpRequest& request, HttpResponse& response)
+{
+  Q_UNUSED(request)
+  response.startEventStream(this);
+}
+
+void HttpEventStream::publish(const QByteArray& event, const QByteArray& data, bool retain)
+{
+  QByteArray frame;
+  frame.reserve(event.size() + data.size() + 32);
+  if(!event.isEmpty())
+  {
+    frame.append("event: ").append(event).append('\n');
+  }
+
+  // Each line of the payload needs its own data field
+  int start = 0;
+  do
+  {
+    int end = data.indexOf('\n', start);
+    if(end == -1)
+    {
+      end = data.size();
+    }
+    frame.append("data: ").append(data.constData() + start, end - start).append('\n');
+    start = end + 1;
+  } while(start < data.size());
+  frame.append('\n');
+
+  if(retain)
+  {
+    mutex.lock();
+    retainedFrames.insert(event, frame);
+    mutex.unlock();
+  }
+
+  // Queued to the worker threads of all streaming connections
+  emit framePublished(frame);
+}
+
+QByteArray HttpEventStream::getInitialFrames() const
+{
+  QByteArray frames("retry: " + QByteArray::number(retry) + "\n\n");
+  mutex.lock();
+  for(const QByteArray& frame : retainedFrames)
+  {
+    frames.append(frame);
+  }
+  mutex.unlock();
+  return frames;
+}
+
+void HttpEventStream::addClient()
+{
+  numClients.ref();
+}
+
+void HttpEventStream::removeClient()
+{
+  numClients.deref();
+}
+
+void HttpEventStream::heartbeat()
+{
+  if(hasClients())
+  {
+    emit framePublished(":\n\n");
+  }
+}
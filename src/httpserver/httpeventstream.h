@@ -0,0 +1,123 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPEVENTSTREAM_H
+#define HTTPEVENTSTREAM_H
+
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QTimer>
+#include "httpglobal.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+
+namespace stefanfrings {
+
+/**
+ *  Pushes server-sent events (SSE, content type text/event-stream) to any number of web clients.
+ *  Clients open the stream once with an EventSource and get all updates over this connection instead of
+ *  polling, which saves request parsing and response building for each update.
+ *  <p>
+ *  A request handler passes the request to accept(). The connection stays open and is not used for further
+ *  requests. Each call to publish() is sent to all connected clients. The frame is built once and shared
+ *  by all connections which write it from their own worker thread.
+ *  <p>
+ *  The last retained frame of each event name is sent to new clients right after connecting, so events
+ *  should carry full state. A heartbeat comment keeps proxies from closing idle connections. Clients which
+ *  cannot keep up and have more than maxEventBuffer bytes pending are disconnected. Browsers reconnect
+ *  automatically after the retry time.
+ *  <p>
+ *  Example for a live aircraft feed:
+ *  <code><pre>
+ *  // Request handler
+ *  if(path == "/events")
+ *    eventStream->accept(request, response);
+ *
+ *  // Called for each packet received from the simulator
+ *  if(eventStream->hasClients())
+ *    eventStream->publish("aircraft", simConnectData.writeJsonToBytes());
+ *  </pre></code>
+ *  <p>
+ *  Example for the configuration settings:
+ *  <code><pre>
+ *  heartbeatInterval=15000
+ *  retry=3000
+ *  maxEventBuffer=1000000
+ *  </pre></code>
+ *  @see HttpResponse::startEventStream()
+ */
+class DECLSPEC HttpEventStream :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventStream)
+
+public:
+  /**
+   *  Constructor.
+   *  @param settings Configuration settings
+   *  @param parent Parent object
+   */
+  HttpEventStream(QHash<QString, QVariant> settings, QObject *parent = nullptr);
+
+  /**
+   *  Start sending events to the client of this request.
+   *  This method is thread safe.
+   */
+  void accept(HttpRequest& request, HttpResponse& response);
+
+  /**
+   *  Send an event to all connected clients.
+   *  This method is thread safe.
+   *  @param event Event name which is used by the client to select the listener. Not sent if empty.
+   *  @param data Payload like compact JSON. Line feeds are allowed.
+   *  @param retain Keep the frame and send it to new clients. Do not retain incremental updates.
+   */
+  void publish(const QByteArray& event, const QByteArray& data, bool retain = true);
+
+  /** true if at least one client is connected. Allows to skip building events. */
+  bool hasClients() const
+  {
+    return numClients.loadAcquire() > 0;
+  }
+
+  /** Pending bytes for a client before it is disconnected */
+  qint64 getMaxEventBuffer() const
+  {
+    return maxEventBuffer;
+  }
+
+  /** Retry time and retained frames which are sent first to new clients. This method is thread safe. */
+  QByteArray getInitialFrames() const;
+
+  /** Called by the connection handler when a client starts or stops listening. */
+  void addClient();
+  void removeClient();
+
+signals:
+  /** Emitted for each published frame. Connected to all streaming connection handlers. */
+  void framePublished(const QByteArray& frame);
+
+private:
+  /** Last frame by event name */
+  QMap<QByteArray, QByteArray> retainedFrames;
+
+  /** Used to synchronize access to retained frames */
+  mutable QMutex mutex;
+
+  QTimer heartbeatTimer;
+  QAtomicInt numClients;
+  qint64 maxEventBuffer;
+  int retry;
+
+private slots:
+  /** Sends a comment to all clients */
+  void heartbeat();
+
+};
+
+} // end of namespace
+
+#endif // HTTPEVENTSTREAM_H
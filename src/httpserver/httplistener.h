@@ -23,10 +23,10 @@ namespace stefanfrings {
  *  <code><pre>
  *  ;host=192.168.0.100
  *  port=8080
- *  minThreads=1
- *  maxThreads=10
- *  cleanupInterval=1000
+ *  workerThreads=4
+ *  maxConnections=1000
  *  readTimeout=60000
+ *  keepAliveTimeout=10000
  *  ;sslKeyFile=ssl/my.key
  *  ;sslCertFile=ssl/my.cert
  *  maxRequestSize=16000
@@ -35,8 +35,8 @@ namespace stefanfrings {
  *  The optional host parameter binds the listener to one network interface.
  *  The listener handles all network interfaces if no host is configured.
  *  The port number specifies the incoming TCP port that this listener listens to.
- *  @see HttpConnectionHandlerPool for description of config settings minThreads, maxThreads, cleanupInterval and ssl settings
- *  @see HttpConnectionHandler for description of the readTimeout
+ *  @see HttpConnectionHandlerPool for description of config settings workerThreads, maxConnections and ssl settings
+ *  @see HttpConnectionHandler for description of the readTimeout and keep-alive settings
  *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
  */
 
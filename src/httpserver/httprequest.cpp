@@ -7,6 +7,8 @@
 #include <QList>
 #include <QDir>
 #include "httpcookie.h"
+#include <cctype>
+#include <cstring>
 
 using namespace stefanfrings;
 
@@ -15,76 +17,139 @@ HttpRequest::HttpRequest(QHash<QString, QVariant> settings)
   status = waitForRequest;
   currentSize = 0;
   expectedBodySize = 0;
+  lineLength = 0;
   maxSize = settings.value("maxRequestSize", "16000").toInt();
   maxMultiPartSize = settings.value("maxMultiPartSize", "1000000").toInt();
   tempFile = nullptr;
 }
 
+/** Skip leading and trailing whitespace including line breaks of the range [start, end) */
+static void trimRange(const char *data, int& start, int& end)
+{
+  while(start < end && isspace(static_cast<unsigned char>(data[start])))
+  {
+    start++;
+  }
+  while(end > start && isspace(static_cast<unsigned char>(data[end - 1])))
+  {
+    end--;
+  }
+}
+
+/** Find character in range [start, end). Returns -1 if not found. */
+static int findChar(const char *data, int start, int end, char c)
+{
+  const char *found = static_cast<const char *>(memchr(data + start, c, static_cast<size_t>(end - start)));
+  return found == nullptr ? -1 : static_cast<int>(found - data);
+}
+
+bool HttpRequest::readLine(QTcpSocket *socket)
+{
+  // Buffer is allocated once and reused for all lines of this request
+  if(lineBuffer.isEmpty())
+  {
+    // allow one byte more to be able to detect overflow and one for the terminating zero
+    lineBuffer.resize(maxSize + 2);
+  }
+
+  qint64 toRead = qMin(static_cast<qint64>(maxSize - currentSize + 2),
+                       static_cast<qint64>(lineBuffer.size() - lineLength));
+  qint64 bytesRead = toRead > 1 ? socket->readLine(lineBuffer.data() + lineLength, toRead) : 0;
+  if(bytesRead <= 0)
+  {
+    // No progress possible - line is too long
+    qWarning("HttpRequest: received too many bytes in line");
+    status = abort;
+    return false;
+  }
+  lineLength += static_cast<int>(bytesRead);
+  currentSize += static_cast<int>(bytesRead);
+
+  if(lineBuffer.at(lineLength - 1) != '\n')
+  {
+        #ifdef SUPERVERBOSE
+    qDebug("HttpRequest: collecting more parts until line break");
+        #endif
+    return false;
+  }
+  return true;
+}
+
 void HttpRequest::readRequest(QTcpSocket *socket)
 {
     #ifdef SUPERVERBOSE
   qDebug("HttpRequest: read request");
     #endif
-  int toRead = maxSize - currentSize + 1; // allow one byte more to be able to detect overflow
-  lineBuffer.append(socket->readLine(toRead));
-  currentSize += lineBuffer.size();
-  if(!lineBuffer.contains('\r') && !lineBuffer.contains('\n'))
+  if(!readLine(socket))
   {
-        #ifdef SUPERVERBOSE
-    qDebug("HttpRequest: collecting more parts until line break");
-        #endif
     return;
   }
-  QByteArray newData = lineBuffer.trimmed();
-  lineBuffer.clear();
-  if(!newData.isEmpty())
+
+  // Parse line in place without splitting into a list
+  const char *line = lineBuffer.constData();
+  int start = 0, end = lineLength;
+  lineLength = 0;
+  trimRange(line, start, end);
+  if(start < end)
   {
 #ifdef DEBUG_INFORMATION_WEB
-       qDebug("HttpRequest: from %s: %s", qPrintable(socket->peerAddress().toString()), newData.constData());
+    qDebug("HttpRequest: from %s: %s", qPrintable(socket->peerAddress().toString()),
+           QByteArray(line + start, end - start).constData());
 #endif
-    QList<QByteArray> list = newData.split(' ');
-    if(list.count() != 3 || !list.at(2).contains("HTTP"))
+    // Need exactly three parts separated by single spaces
+    int space1 = findChar(line, start, end, ' ');
+    int space2 = space1 >= 0 ? findChar(line, space1 + 1, end, ' ') : -1;
+    if(space1 < 0 || space2 < 0 || findChar(line, space2 + 1, end, ' ') >= 0)
     {
       qWarning("HttpRequest: received broken HTTP request, invalid first line");
       status = abort;
     }
     else
     {
-      method = list.at(0).trimmed();
-      path = list.at(1);
-      version = list.at(2);
-      peerAddress = socket->peerAddress();
-      status = waitForHeader;
+      version = QByteArray(line + space2 + 1, end - space2 - 1);
+      if(!version.contains("HTTP"))
+      {
+        qWarning("HttpRequest: received broken HTTP request, invalid first line");
+        status = abort;
+      }
+      else
+      {
+        method = QByteArray(line + start, space1 - start);
+        path = QByteArray(line + space1 + 1, space2 - space1 - 1);
+        peerAddress = socket->peerAddress();
+        status = waitForHeader;
+      }
     }
   }
 }
 
 void HttpRequest::readHeader(QTcpSocket *socket)
 {
-  int toRead = maxSize - currentSize + 1; // allow one byte more to be able to detect overflow
-  lineBuffer.append(socket->readLine(toRead));
-  currentSize += lineBuffer.size();
-  if(!lineBuffer.contains('\r') && !lineBuffer.contains('\n'))
+  if(!readLine(socket))
   {
-        #ifdef SUPERVERBOSE
-    qDebug("HttpRequest: collecting more parts until line break");
-        #endif
     return;
   }
-  QByteArray newData = lineBuffer.trimmed();
-  lineBuffer.clear();
-  int colon = newData.indexOf(':');
-  if(colon > 0)
+
+  // Parse line in place
+  const char *line = lineBuffer.constData();
+  int start = 0, end = lineLength;
+  lineLength = 0;
+  trimRange(line, start, end);
+
+  int colon = findChar(line, start, end, ':');
+  if(colon > start)
   {
     // Received a line with a colon - a header
-    currentHeader = newData.left(colon).toLower();
-    QByteArray value = newData.mid(colon + 1).trimmed();
+    currentHeader = QByteArray(line + start, colon - start).toLower();
+    int valueStart = colon + 1, valueEnd = end;
+    trimRange(line, valueStart, valueEnd);
+    QByteArray value(line + valueStart, valueEnd - valueStart);
     headers.insert(currentHeader, value);
         #ifdef SUPERVERBOSE
     qDebug("HttpRequest: received header %s: %s", currentHeader.data(), value.data());
         #endif
   }
-  else if(!newData.isEmpty())
+  else if(start < end)
   {
     // received another line - belongs to the previous header
         #ifdef SUPERVERBOSE
@@ -93,7 +158,7 @@ void HttpRequest::readHeader(QTcpSocket *socket)
     // Received additional line of previous header
     if(headers.contains(currentHeader))
     {
-      headers.insert(currentHeader, headers.value(currentHeader) + " " + newData);
+      headers.insert(currentHeader, headers.value(currentHeader) + " " + QByteArray(line + start, end - start));
     }
   }
   else
@@ -359,6 +424,43 @@ QMultiMap<QByteArray, QByteArray> HttpRequest::getHeaderMap() const
   return headers;
 }
 
+bool HttpRequest::acceptsEncoding(const QByteArray& encoding) const
+{
+  bool wildcard = false;
+  foreach(QByteArray header, headers.values("accept-encoding"))
+  {
+    // Example: "gzip, deflate;q=0.5, br;q=0"
+    foreach(QByteArray part, header.split(','))
+    {
+      QByteArray coding = part.trimmed();
+      QByteArray quality;
+      int semicolon = coding.indexOf(';');
+      if(semicolon >= 0)
+      {
+        quality = coding.mid(semicolon + 1).trimmed();
+        coding = coding.left(semicolon).trimmed();
+      }
+
+      bool disabled = false;
+      if(quality.startsWith("q="))
+      {
+        disabled = quality.mid(2).toDouble() <= 0.;
+      }
+
+      if(qstricmp(coding.constData(), encoding.constData()) == 0)
+      {
+        // Explicit entry has precedence over wildcard
+        return !disabled;
+      }
+      else if(coding == "*")
+      {
+        wildcard = !disabled;
+      }
+    }
+  }
+  return wildcard;
+}
+
 QByteArray HttpRequest::getParameter(const QByteArray& name) const
 {
   return parameters.value(name);
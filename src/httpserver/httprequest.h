@@ -103,6 +103,13 @@ public:
    */
   QMultiMap<QByteArray, QByteArray> getHeaderMap() const;
 
+  /**
+   *  Check the Accept-Encoding header for a content coding like "gzip" or "deflate".
+   *  @param encoding Name of the coding, not case-sensitive.
+   *  @return true if the coding or "*" is listed and not disabled with "q=0".
+   */
+  bool acceptsEncoding(const QByteArray& encoding) const;
+
   /**
    *  Get the value of a HTTP request parameter.
    *  @param name Name of the parameter, case-sensitive.
@@ -215,6 +222,12 @@ private:
   /** Parse the multipart body, that has been stored in the temp file. */
   void parseMultiPartFile();
 
+  /**
+   *  Read a line or a part of it into the line buffer without allocating memory.
+   *  Returns true if a line including the line break is in the buffer. Sets status to abort if the line is too long.
+   */
+  bool readLine(QTcpSocket *socket);
+
   /** Sub-procedure of readFromSocket(), read the first line of a request. */
   void readRequest(QTcpSocket *socket);
 
@@ -230,9 +243,12 @@ private:
   /** Sub-procedure of readFromSocket(), extract cookies from headers */
   void extractCookies();
 
-  /** Buffer for collecting characters of request and header lines */
+  /** Buffer for collecting characters of request and header lines. Allocated once and reused for each line. */
   QByteArray lineBuffer;
 
+  /** Number of valid bytes in lineBuffer */
+  int lineLength;
+
 };
 
 } // end of namespace
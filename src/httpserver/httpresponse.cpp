@@ -4,6 +4,9 @@
  */
 
 #include "httpresponse.h"
+#include "zip/gzip.h"
+
+#include <algorithm>
 
 using namespace stefanfrings;
 
@@ -15,6 +18,68 @@ HttpResponse::HttpResponse(QTcpSocket *socket)
   sentHeaders = false;
   sentLastPart = false;
   chunkedMode = false;
+  compressGzip = false;
+  compressDeflate = false;
+  compressMinSize = 1024;
+  compressLevel = -1;
+  eventStream = nullptr;
+}
+
+void HttpResponse::setCompression(bool gzip, bool deflate, int minSize, int level)
+{
+  Q_ASSERT(sentHeaders == false);
+  compressGzip = gzip;
+  compressDeflate = deflate;
+  compressMinSize = minSize;
+  compressLevel = level;
+}
+
+bool HttpResponse::isCompressible(const QByteArray& contentType)
+{
+  // Assume text if not given
+  return contentType.isEmpty() || contentType.startsWith("text/") || contentType.contains("json") ||
+         contentType.contains("javascript") || contentType.contains("xml") || contentType.contains("x-font-ttf") ||
+         contentType.contains("font-otf") || contentType.contains("ms-fontobject");
+}
+
+QByteArray HttpResponse::compressBody(const QByteArray& data)
+{
+  // Partial content refers to the uncompressed representation
+  if((!compressGzip && !compressDeflate) || data.size() < compressMinSize || statusCode == 204 || statusCode == 206 ||
+     statusCode == 304 || headers.contains("Content-Encoding") || !isCompressible(headers.value("Content-Type")))
+  {
+    return data;
+  }
+
+  QByteArray compressed;
+  QByteArray coding;
+  if(compressGzip)
+  {
+    if(atools::zip::gzipCompress(data, compressed, compressLevel))
+    {
+      coding = "gzip";
+    }
+  }
+  else
+  {
+    // qCompress adds a four byte length prefix in front of the zlib stream
+    compressed = qCompress(data, compressLevel);
+    if(compressed.size() > 4)
+    {
+      compressed.remove(0, 4);
+      coding = "deflate";
+    }
+  }
+
+  if(coding.isEmpty() || compressed.size() >= data.size())
+  {
+    // Failed or not worth it
+    return data;
+  }
+
+  headers.insert("Content-Encoding", coding);
+  headers.insert("Vary", "Accept-Encoding");
+  return compressed;
 }
 
 void HttpResponse::setHeader(QByteArray name, QByteArray value)
@@ -75,14 +140,22 @@ void HttpResponse::writeHeaders()
 
 bool HttpResponse::writeToSocket(QByteArray data)
 {
-  int remaining = data.size();
-  const char *ptr = data.constData();
+  return writeToSocket(data.constData(), data.size());
+}
+
+bool HttpResponse::writeToSocket(const char *data, qint64 size)
+{
+  qint64 remaining = size;
+  const char *ptr = data;
   while(socket->isOpen() && remaining > 0)
   {
     // If the output buffer has become large, then wait until it has been sent.
     if(socket->bytesToWrite() > 16384)
     {
-      socket->waitForBytesWritten(-1);
+      if(!socket->waitForBytesWritten(-1) && socket->state() != QAbstractSocket::ConnectedState)
+      {
+        return false;
+      }
     }
 
     qint64 written = socket->write(ptr, remaining);
@@ -93,7 +166,7 @@ bool HttpResponse::writeToSocket(QByteArray data)
     ptr += written;
     remaining -= written;
   }
-  return true;
+  return remaining == 0;
 }
 
 void HttpResponse::write(QByteArray data, bool lastPart)
@@ -107,6 +180,9 @@ void HttpResponse::write(QByteArray data, bool lastPart)
     // size of the response and therefore can set the Content-Length header automatically.
     if(lastPart)
     {
+      // Whole body is known - compress it if allowed
+      data = compressBody(data);
+
       // Automatically set the Content-Length header
       headers.insert("Content-Length", QByteArray::number(data.size()));
     }
@@ -157,6 +233,62 @@ void HttpResponse::write(QByteArray data, bool lastPart)
   }
 }
 
+bool HttpResponse::writeFile(QFile& file, qint64 offset, qint64 length)
+{
+  Q_ASSERT(sentLastPart == false);
+
+  if(sentHeaders == false)
+  {
+    headers.insert("Content-Length", QByteArray::number(length));
+    writeHeaders();
+  }
+
+  // Map segments to limit address space usage for large files
+  const qint64 SEGMENT_SIZE = 4 * 1024 * 1024;
+  const qint64 CHUNK_SIZE = 65536;
+
+  bool ok = true;
+  qint64 pos = offset, end = offset + length;
+  while(ok && pos < end)
+  {
+    qint64 segmentSize = std::min(SEGMENT_SIZE, end - pos);
+    uchar *mapped = file.map(pos, segmentSize);
+    if(mapped != nullptr)
+    {
+      // Socket copies from the mapping into its buffer
+      ok = writeToSocket(reinterpret_cast<const char *>(mapped), segmentSize);
+      file.unmap(mapped);
+      pos += segmentSize;
+    }
+    else
+    {
+      // Read chunk instead if the file cannot be mapped
+      if(!file.seek(pos))
+      {
+        ok = false;
+        break;
+      }
+      QByteArray chunk = file.read(std::min(CHUNK_SIZE, end - pos));
+      if(chunk.isEmpty())
+      {
+        ok = false;
+        break;
+      }
+      ok = writeToSocket(chunk);
+      pos += chunk.size();
+    }
+  }
+
+  if(!ok)
+  {
+    qWarning("HttpResponse: Sending file %s aborted at offset %lli", qPrintable(file.fileName()), pos);
+  }
+
+  socket->flush();
+  sentLastPart = true;
+  return ok;
+}
+
 bool HttpResponse::hasSentLastPart() const
 {
   return sentLastPart;
@@ -183,6 +315,21 @@ void HttpResponse::redirect(const QByteArray& url)
   write("Redirect", true);
 }
 
+void HttpResponse::startEventStream(HttpEventStream *stream)
+{
+  Q_ASSERT(sentHeaders == false);
+  setHeader("Content-Type", "text/event-stream");
+  setHeader("Cache-Control", "no-cache");
+
+  // Tell proxies not to buffer the events
+  setHeader("X-Accel-Buffering", "no");
+
+  // Body is neither chunked nor has a length - it ends when the connection closes
+  writeHeaders();
+  sentLastPart = true;
+  eventStream = stream;
+}
+
 void HttpResponse::flush()
 {
   socket->flush();
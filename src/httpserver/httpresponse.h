@@ -6,6 +6,7 @@
 #ifndef HTTPRESPONSE_H
 #define HTTPRESPONSE_H
 
+#include <QFile>
 #include <QMap>
 #include <QString>
 #include <QTcpSocket>
@@ -14,6 +15,8 @@
 
 namespace stefanfrings {
 
+class HttpEventStream;
+
 /**
  *  This object represents a HTTP response, used to return something to the web client.
  *  <p>
@@ -31,6 +34,10 @@ namespace stefanfrings {
  *  <p>
  *  In case of large responses (e.g. file downloads), a Content-Length header should be set
  *  before calling write(). Web Browsers use that information to display a progress bar.
+ *  <p>
+ *  Responses written with a single call to write(data, true) are compressed with gzip or deflate
+ *  if enabled by setCompression() and the body is large enough. Images, fonts and other already compressed
+ *  content types are sent as is. Responses having a Content-Encoding header are never compressed again.
  */
 
 class DECLSPEC HttpResponse
@@ -90,11 +97,40 @@ public:
    */
   void write(const QByteArray data, const bool lastPart = false);
 
+  /**
+   *  Send a part of a file as the whole body without loading it into memory.
+   *  The file is memory mapped in segments and passed to the socket from the mapping. Falls back to reading
+   *  chunks if mapping is not possible, e.g. for resource files. Writing blocks while the socket buffer is
+   *  full, so a slow client does not grow memory usage.
+   *  <p>
+   *  Sets the Content-Length header if headers are not sent yet. The body is never compressed.
+   *  Cannot be combined with write().
+   *  @param file Opened file
+   *  @param offset Start of the part in bytes
+   *  @param length Length of the part in bytes
+   *  @return false if the file could not be read or the connection was lost
+   */
+  bool writeFile(QFile& file, qint64 offset, qint64 length);
+
   /**
    *  Indicates whether the body has been sent completely (write() has been called with lastPart=true).
    */
   bool hasSentLastPart() const;
 
+  /**
+   *  Enable compression of the body. Usually called by the connection handler depending on the
+   *  Accept-Encoding header of the request. Gzip is preferred if both are allowed.
+   *  You must call this method before the first write().
+   *  @param gzip Client accepts gzip
+   *  @param deflate Client accepts deflate (zlib format)
+   *  @param minSize Smaller bodies are not compressed
+   *  @param level Compression level (0 = no compression, 9 = max, -1 = default)
+   */
+  void setCompression(bool gzip, bool deflate, int minSize = 1024, int level = -1);
+
+  /** Returns true if bodies of the given content type are worth compressing. Empty type is assumed to be text. */
+  static bool isCompressible(const QByteArray& contentType);
+
   /**
    *  Set a cookie.
    *  You must call this method before the first write().
@@ -108,6 +144,21 @@ public:
    */
   void redirect(const QByteArray& url);
 
+  /**
+   *  Turn this response into a server-sent event stream which stays open after
+   *  HttpRequestHandler::service() returned. Headers are sent immediately and the connection handler
+   *  forwards all events published on the stream to the client afterwards.
+   *  Cannot be combined with write().
+   *  @see HttpEventStream::accept()
+   */
+  void startEventStream(HttpEventStream *stream);
+
+  /** Stream passed to startEventStream() or null */
+  HttpEventStream *getEventStream() const
+  {
+    return eventStream;
+  }
+
   /**
    * Flush the output buffer (of the underlying socket).
    * You normally don't need to call this method because flush is
@@ -146,8 +197,21 @@ private:
   /** Cookies */
   QMap<QByteArray, HttpCookie> cookies;
 
+  /** Accepted content codings as passed to setCompression() */
+  bool compressGzip, compressDeflate;
+
+  /** Minimum body size and level for compression */
+  int compressMinSize, compressLevel;
+
+  /** Set if the connection is kept open for server-sent events */
+  HttpEventStream *eventStream;
+
+  /** Compress data if enabled and suitable. Sets Content-Encoding and Vary headers. */
+  QByteArray compressBody(const QByteArray& data);
+
   /** Write raw data to the socket. This method blocks until all bytes have been passed to the TCP buffer */
   bool writeToSocket(QByteArray data);
+  bool writeToSocket(const char *data, qint64 size);
 
   /**
    *  Write the response HTTP status and headers to the socket.
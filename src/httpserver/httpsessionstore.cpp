@@ -9,12 +9,19 @@
 
 using namespace stefanfrings;
 
+/* Length of a timer wheel tick which is also the cleanup timer interval. 60 ticks per expiration time
+ * limited to one second up to one minute. */
+static int expiryTick(const QHash<QString, QVariant>& settings)
+{
+  return qBound(1000, settings.value("expirationTime", 3600000).toInt() / 60, 60000);
+}
+
 HttpSessionStore::HttpSessionStore(QHash<QString, QVariant> settings, QObject *parent)
-  : QObject(parent)
+  : QObject(parent), expiryWheel(expiryTick(settings), QDateTime::currentMSecsSinceEpoch())
 {
   this->settings = settings;
   connect(&cleanupTimer, SIGNAL(timeout()), this, SLOT(sessionTimerEvent()));
-  cleanupTimer.start(60000);
+  cleanupTimer.start(expiryTick(settings));
   cookieName = settings.value("cookieName", "sessionid").toByteArray();
   expirationTime = settings.value("expirationTime", 3600000).toInt();
   qDebug("HttpSessionStore: Sessions expire after %i milliseconds", expirationTime);
@@ -28,7 +35,6 @@ HttpSessionStore::~HttpSessionStore()
 QByteArray HttpSessionStore::getSessionId(HttpRequest& request, HttpResponse& response)
 {
   // The session ID in the response has priority because this one will be used in the next request.
-  mutex.lock();
   // Get the session ID from the response cookie
   QByteArray sessionId = response.getCookies().value(cookieName).getValue();
   if(sessionId.isEmpty())
@@ -39,33 +45,32 @@ QByteArray HttpSessionStore::getSessionId(HttpRequest& request, HttpResponse& re
   // Clear the session ID if there is no such session in the storage.
   if(!sessionId.isEmpty())
   {
-    if(!sessions.contains(sessionId))
+    Shard& shard = shardFor(sessionId);
+    shard.mutex.lock();
+    bool found = shard.sessions.contains(sessionId);
+    shard.mutex.unlock();
+    if(!found)
     {
       qDebug("HttpSessionStore: received invalid session cookie with ID %s", sessionId.constData());
       sessionId.clear();
     }
   }
-  mutex.unlock();
   return sessionId;
 }
 
 HttpSession HttpSessionStore::getSession(HttpRequest& request, HttpResponse& response, bool allowCreate)
 {
   QByteArray sessionId = getSessionId(request, response);
-  mutex.lock();
   if(!sessionId.isEmpty())
   {
-    HttpSession session = sessions.value(sessionId);
+    Shard& shard = shardFor(sessionId);
+    shard.mutex.lock();
+    HttpSession session = shard.sessions.value(sessionId);
+    shard.mutex.unlock();
     if(!session.isNull())
     {
-      mutex.unlock();
       // Refresh the session cookie
-      QByteArray cookieName = settings.value("cookieName", "sessionid").toByteArray();
-      QByteArray cookiePath = settings.value("cookiePath").toByteArray();
-      QByteArray cookieComment = settings.value("cookieComment").toByteArray();
-      QByteArray cookieDomain = settings.value("cookieDomain").toByteArray();
-      response.setCookie(HttpCookie(cookieName, session.getId(), expirationTime / 1000, cookiePath, cookieComment,
-                                    cookieDomain));
+      setSessionCookie(response, session);
       session.setLastAccess();
       return session;
     }
@@ -73,56 +78,91 @@ HttpSession HttpSessionStore::getSession(HttpRequest& request, HttpResponse& res
   // Need to create a new session
   if(allowCreate)
   {
-    QByteArray cookieName = settings.value("cookieName", "sessionid").toByteArray();
-    QByteArray cookiePath = settings.value("cookiePath").toByteArray();
-    QByteArray cookieComment = settings.value("cookieComment").toByteArray();
-    QByteArray cookieDomain = settings.value("cookieDomain").toByteArray();
     HttpSession session(true);
     qDebug("HttpSessionStore: create new session with ID %s", session.getId().constData());
-    sessions.insert(session.getId(), session);
-    response.setCookie(HttpCookie(cookieName, session.getId(), expirationTime / 1000, cookiePath, cookieComment,
-                                  cookieDomain));
-    mutex.unlock();
+    Shard& shard = shardFor(session.getId());
+    shard.mutex.lock();
+    shard.sessions.insert(session.getId(), session);
+    shard.mutex.unlock();
+
+    wheelMutex.lock();
+    expiryWheel.schedule(session.getId(), session.getLastAccess() + expirationTime);
+    wheelMutex.unlock();
+
+    setSessionCookie(response, session);
     return session;
   }
   // Return a null session
-  mutex.unlock();
   return HttpSession();
 }
 
+void HttpSessionStore::setSessionCookie(HttpResponse& response, const HttpSession& session)
+{
+  QByteArray cookiePath = settings.value("cookiePath").toByteArray();
+  QByteArray cookieComment = settings.value("cookieComment").toByteArray();
+  QByteArray cookieDomain = settings.value("cookieDomain").toByteArray();
+  response.setCookie(HttpCookie(cookieName, session.getId(), expirationTime / 1000, cookiePath, cookieComment,
+                                cookieDomain));
+}
+
 HttpSession HttpSessionStore::getSession(const QByteArray id)
 {
-  mutex.lock();
-  HttpSession session = sessions.value(id);
-  mutex.unlock();
+  Shard& shard = shardFor(id);
+  shard.mutex.lock();
+  HttpSession session = shard.sessions.value(id);
+  shard.mutex.unlock();
   session.setLastAccess();
   return session;
 }
 
 void HttpSessionStore::sessionTimerEvent()
 {
-  mutex.lock();
   qint64 now = QDateTime::currentMSecsSinceEpoch();
-  QMap<QByteArray, HttpSession>::iterator i = sessions.begin();
-  while(i != sessions.end())
+  QVector<QByteArray> due;
+  wheelMutex.lock();
+  expiryWheel.advance(now, due);
+  wheelMutex.unlock();
+
+  QVector<QPair<QByteArray, qint64> > reschedule;
+  for(const QByteArray& id : due)
+  {
+    Shard& shard = shardFor(id);
+    shard.mutex.lock();
+    QHash<QByteArray, HttpSession>::iterator it = shard.sessions.find(id);
+    if(it != shard.sessions.end())
+    {
+      qint64 lastAccess = it.value().getLastAccess();
+      if(now - lastAccess > expirationTime)
+      {
+        qDebug("HttpSessionStore: session %s expired", id.constData());
+        shard.sessions.erase(it);
+      }
+      else
+      {
+        // Accessed in the meantime
+        reschedule.append(qMakePair(id, lastAccess + expirationTime));
+      }
+    }
+    shard.mutex.unlock();
+  }
+
+  if(!reschedule.isEmpty())
   {
-    QMap<QByteArray, HttpSession>::iterator prev = i;
-    ++i;
-    HttpSession session = prev.value();
-    qint64 lastAccess = session.getLastAccess();
-    if(now - lastAccess > expirationTime)
+    wheelMutex.lock();
+    for(const QPair<QByteArray, qint64>& entry : reschedule)
     {
-      qDebug("HttpSessionStore: session %s expired", session.getId().constData());
-      sessions.erase(prev);
+      expiryWheel.schedule(entry.first, entry.second);
     }
+    wheelMutex.unlock();
   }
-  mutex.unlock();
 }
 
 /** Delete a session */
 void HttpSessionStore::removeSession(HttpSession session)
 {
-  mutex.lock();
-  sessions.remove(session.getId());
-  mutex.unlock();
+  // Key stays in the wheel and is ignored when due
+  Shard& shard = shardFor(session.getId());
+  shard.mutex.lock();
+  shard.sessions.remove(session.getId());
+  shard.mutex.unlock();
 }
@@ -7,13 +7,14 @@
 #define HTTPSESSIONSTORE_H
 
 #include <QObject>
-#include <QMap>
+#include <QHash>
 #include <QTimer>
 #include <QMutex>
 #include "httpglobal.h"
 #include "httpsession.h"
 #include "httpresponse.h"
 #include "httprequest.h"
+#include "timerwheel.h"
 
 namespace stefanfrings {
 
@@ -30,6 +31,11 @@ namespace stefanfrings {
  *  cookieComment=Session ID
  *  ;cookieDomain=stefanfrings.de
  *  </pre></code>
+ *  <p>
+ *  Sessions are distributed over shards by ID. Each shard has its own lock, so concurrent lookups
+ *  rarely block each other. Expiry uses a timer wheel instead of scanning all sessions.
+ *  A session which was accessed after being scheduled is scheduled again when its slot comes up.
+ *  @see TimerWheel
  */
 
 class DECLSPEC HttpSessionStore :
@@ -89,11 +95,35 @@ public:
   /** Delete a session */
   void removeSession(const HttpSession session);
 
-protected:
-  /** Storage for the sessions */
-  QMap<QByteArray, HttpSession> sessions;
-
 private:
+  /** Number of shards. Must be a power of two. */
+  static Q_DECL_CONSTEXPR int NUM_SHARDS = 16;
+
+  struct Shard
+  {
+    /** Storage for the sessions */
+    QHash<QByteArray, HttpSession> sessions;
+
+    /** Used to synchronize threads */
+    QMutex mutex;
+  };
+
+  Shard& shardFor(const QByteArray& id)
+  {
+    return shards[qHash(id) & (NUM_SHARDS - 1)];
+  }
+
+  /** Create session cookie and set it in response */
+  void setSessionCookie(HttpResponse& response, const HttpSession& session);
+
+  Shard shards[NUM_SHARDS];
+
+  /** Session IDs by expiration time */
+  TimerWheel<QByteArray> expiryWheel;
+
+  /** Used to synchronize access to the wheel */
+  QMutex wheelMutex;
+
   /** Configuration settings */
   QHash<QString, QVariant> settings;
 
@@ -106,11 +136,8 @@ private:
   /** Time when sessions expire (in ms)*/
   int expirationTime;
 
-  /** Used to synchronize threads */
-  QMutex mutex;
-
 private slots:
-  /** Called every minute to cleanup expired sessions. */
+  /** Called every tick of the timer wheel to cleanup expired sessions. */
   void sessionTimerEvent();
 
 };
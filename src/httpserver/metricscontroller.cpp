@@ -0,0 +1,37 @@
+/**
+ *  @file
+ */
+
+#include "metricscontroller.h"
+#include "util/metrics.h"
+
+using namespace stefanfrings;
+
+MetricsController::MetricsController(QObject *parent)
+  : HttpRequestHandler(parent)
+{
+}
+
+void MetricsController::service(HttpRequest& request, HttpResponse& response)
+{
+  const QByteArray method = request.getMethod();
+  if(method != "GET" && method != "HEAD")
+  {
+    response.setStatus(405, "Method Not Allowed");
+    response.setHeader("Allow", "GET, HEAD");
+    response.write("405 method not allowed", true);
+    return;
+  }
+
+  response.setHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+  response.setHeader("Cache-Control", "no-cache");
+
+  if(method == "HEAD")
+  {
+    response.write(QByteArray(), true);
+  }
+  else
+  {
+    response.write(atools::util::Metrics::instance().writePrometheus(), true);
+  }
+}
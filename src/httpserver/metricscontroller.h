@@ -0,0 +1,46 @@
+/**
+ *  @file
+ */
+
+#ifndef METRICSCONTROLLER_H
+#define METRICSCONTROLLER_H
+
+#include "httpglobal.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "httprequesthandler.h"
+
+namespace stefanfrings {
+
+/**
+ *  Delivers all counters, gauges and histograms of atools::util::Metrics in the Prometheus text format.
+ *  Map a path like "/metrics" to this controller in the request handler:
+ *  <code><pre>
+ *  if(path == "/metrics")
+ *    metricsController->service(request, response);
+ *  </pre></code>
+ *  <p>
+ *  Only GET and HEAD requests are accepted. The output is never cached by clients.
+ *  @see atools::util::Metrics
+ */
+class DECLSPEC MetricsController :
+  public HttpRequestHandler
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(MetricsController)
+
+public:
+  /**
+   *  Constructor.
+   *  @param parent Parent object
+   */
+  MetricsController(QObject *parent = nullptr);
+
+  /** Generates the response */
+  virtual void service(HttpRequest& request, HttpResponse& response) override;
+
+};
+
+} // end of namespace
+
+#endif // METRICSCONTROLLER_H
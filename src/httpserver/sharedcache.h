@@ -0,0 +1,217 @@
+/**
+ *  @file
+ */
+
+#ifndef SHAREDCACHE_H
+#define SHAREDCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <memory>
+
+namespace stefanfrings {
+
+/**
+ *  Cache for immutable entries which can be read by many threads without locking.
+ *  <p>
+ *  The cache is split into shards by the hash of the key. Each shard keeps its table behind an atomic
+ *  shared pointer. Readers load the pointer and look up the entry without taking a lock (read-copy-update).
+ *  Writers copy the table of one shard, modify the copy and publish it. Writers of the same shard are
+ *  serialized by a mutex which is never used by readers.
+ *  <p>
+ *  Entries are returned as shared pointers to const objects. A returned entry stays valid even
+ *  if it is removed from the cache by another thread in the meantime, so no copy is needed.
+ *  <p>
+ *  Inserting is expensive compared to a lookup since the shard table is copied. This fits to file caches
+ *  where misses are rare compared to hits. The total cost is limited per shard. The oldest entries of a
+ *  shard are removed first if the limit is exceeded.
+ */
+template<typename KEY, typename TYPE>
+class SharedCache
+{
+  Q_DISABLE_COPY(SharedCache)
+
+public:
+  typedef std::shared_ptr<const TYPE> EntryPtr;
+
+  /**
+   *  Constructor.
+   *  @param maxCost Maximum total cost of all entries
+   *  @param timeoutMs Entries older than this are not returned. Never expire if 0.
+   */
+  SharedCache(int maxCost = 1000000, int timeoutMs = 0)
+  {
+    setMaxCost(maxCost);
+    timeout = timeoutMs;
+  }
+
+  void setMaxCost(int maxCost)
+  {
+    totalMaxCost = maxCost;
+    shardMaxCost = maxCost / NUM_SHARDS;
+  }
+
+  int maxCost() const
+  {
+    return totalMaxCost;
+  }
+
+  void setTimeout(int timeoutMs)
+  {
+    timeout = timeoutMs;
+  }
+
+  /**
+   *  Get an entry without locking.
+   *  @param key Key of the entry
+   *  @param now Current time in milliseconds since epoch used to check the timeout
+   *  @return The entry or null if not found or timed out
+   */
+  EntryPtr object(const KEY& key, qint64 now) const
+  {
+    std::shared_ptr<const Table> table = std::atomic_load(&shardFor(key).table);
+    if(table)
+    {
+      typename QHash<KEY, Item>::const_iterator it = table->items.constFind(key);
+      if(it != table->items.constEnd() && (timeout == 0 || it->created > now - timeout))
+      {
+        return it->entry;
+      }
+    }
+    return EntryPtr();
+  }
+
+  /**
+   *  Insert or replace an entry. The entry must not be modified afterwards.
+   *  Entries with a cost larger than a shard can hold are not inserted.
+   *  @param key Key of the entry
+   *  @param entry Immutable entry
+   *  @param cost Cost, usually the size in bytes
+   *  @param now Current time in milliseconds since epoch
+   */
+  void insert(const KEY& key, const EntryPtr& entry, int cost, qint64 now)
+  {
+    if(cost > shardMaxCost)
+    {
+      return;
+    }
+
+    Shard& shard = shardFor(key);
+    QMutexLocker locker(&shard.writeMutex);
+
+    // Copy the current table - readers still use the old one
+    std::shared_ptr<const Table> oldTable = std::atomic_load(&shard.table);
+    std::shared_ptr<Table> table = oldTable ? std::make_shared<Table>(*oldTable) : std::make_shared<Table>();
+
+    typename QHash<KEY, Item>::iterator it = table->items.find(key);
+    if(it != table->items.end())
+    {
+      table->cost -= it->cost;
+      table->items.erase(it);
+    }
+
+    // Remove oldest entries until the new one fits
+    while(!table->items.isEmpty() && table->cost + cost > shardMaxCost)
+    {
+      typename QHash<KEY, Item>::iterator oldest = table->items.begin();
+      for(it = table->items.begin(); it != table->items.end(); ++it)
+      {
+        if(it->created < oldest->created)
+        {
+          oldest = it;
+        }
+      }
+      table->cost -= oldest->cost;
+      table->items.erase(oldest);
+    }
+
+    Item item;
+    item.entry = entry;
+    item.cost = cost;
+    item.created = now;
+    table->items.insert(key, item);
+    table->cost += cost;
+
+    // Publish
+    std::atomic_store(&shard.table, std::shared_ptr<const Table>(table));
+  }
+
+  /** Total cost of all entries. Reads the current table of each shard without locking. */
+  int totalCost() const
+  {
+    int cost = 0;
+    for(int i = 0; i < NUM_SHARDS; i++)
+    {
+      std::shared_ptr<const Table> table = std::atomic_load(&shards[i].table);
+      if(table)
+      {
+        cost += table->cost;
+      }
+    }
+    return cost;
+  }
+
+  /** Number of entries including timed out ones which are not removed yet */
+  int count() const
+  {
+    int num = 0;
+    for(int i = 0; i < NUM_SHARDS; i++)
+    {
+      std::shared_ptr<const Table> table = std::atomic_load(&shards[i].table);
+      if(table)
+      {
+        num += table->items.size();
+      }
+    }
+    return num;
+  }
+
+  /** Remove all entries */
+  void clear()
+  {
+    for(int i = 0; i < NUM_SHARDS; i++)
+    {
+      QMutexLocker locker(&shards[i].writeMutex);
+      std::atomic_store(&shards[i].table, std::shared_ptr<const Table>());
+    }
+  }
+
+private:
+  /** Number of shards. Writers to different shards do not block each other. */
+  static Q_DECL_CONSTEXPR int NUM_SHARDS = 16;
+
+  struct Item
+  {
+    EntryPtr entry;
+    int cost;
+    qint64 created;
+  };
+
+  /** Immutable once published */
+  struct Table
+  {
+    QHash<KEY, Item> items;
+    int cost = 0;
+  };
+
+  struct Shard
+  {
+    /** Always accessed using std::atomic_load and std::atomic_store */
+    std::shared_ptr<const Table> table;
+
+    /** Serializes writers */
+    QMutex writeMutex;
+  };
+
+  Shard& shardFor(const KEY& key) const
+  {
+    return shards[qHash(key) % NUM_SHARDS];
+  }
+
+  mutable Shard shards[NUM_SHARDS];
+  int totalMaxCost, shardMaxCost, timeout;
+};
+
+} // end of namespace
+
+#endif // SHAREDCACHE_H
@@ -1,199 +1,395 @@
-/**
- *  @file
- *  @author Stefan Frings
- */
-
-#include "staticfilecontroller.h"
-#include <QFileInfo>
-#include <QDir>
-#include <QDateTime>
-
-using namespace stefanfrings;
-
-StaticFileController::StaticFileController(QHash<QString, QVariant> settings, QObject *parent)
-  : HttpRequestHandler(parent)
-{
-  maxAge = settings.value("maxAge", "60000").toInt();
-  encoding = settings.value("encoding", "UTF-8").toString();
-  docroot = settings.value("path", ".").toString();
-  if(!(docroot.startsWith(":/") || docroot.startsWith("qrc://")))
-  {
-    // Convert relative path to absolute, based on the directory of the config file.
-    if(QDir::isRelativePath(docroot))
-    {
-      QFileInfo configFile(settings.value("filename").toString());
-      docroot = QFileInfo(configFile.absolutePath(), docroot).absoluteFilePath();
-    }
-  }
-  qDebug("StaticFileController: docroot=%s, encoding=%s, maxAge=%i", qPrintable(docroot), qPrintable(encoding), maxAge);
-  maxCachedFileSize = settings.value("maxCachedFileSize", "65536").toInt();
-  cache.setMaxCost(settings.value("cacheSize", "1000000").toInt());
-  cacheTimeout = settings.value("cacheTime", "60000").toInt();
-  qDebug("StaticFileController: cache timeout=%i, size=%i", cacheTimeout, cache.maxCost());
-}
-
-void StaticFileController::service(HttpRequest& request, HttpResponse& response)
-{
-  QByteArray path = request.getPath();
-  // Check if we have the file in cache
-  qint64 now = QDateTime::currentMSecsSinceEpoch();
-  mutex.lock();
-  CacheEntry *entry = cache.object(path);
-  if(entry && (cacheTimeout == 0 || entry->created > now - cacheTimeout))
-  {
-    QByteArray document = entry->document;   // copy the cached document, because other threads may destroy the cached entry immediately after mutex unlock.
-    QByteArray filename = entry->filename;
-    mutex.unlock();
-#ifdef DEBUG_INFORMATION_WEB
-    qDebug("StaticFileController: Cache hit for %s", path.constData());
-#endif
-    setContentType(filename, response);
-    response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
-    response.write(document);
-  }
-  else
-  {
-    mutex.unlock();
-    // The file is not in cache.
-#ifdef DEBUG_INFORMATION_WEB
-    qDebug("StaticFileController: Cache miss for %s", path.constData());
-#endif
-    // Forbid access to files outside the docroot directory
-    if(path.contains("/.."))
-    {
-      qWarning("StaticFileController: detected forbidden characters in path %s", path.constData());
-      response.setStatus(403, "forbidden");
-      response.write("403 forbidden", true);
-      return;
-    }
-    // If the filename is a directory, append index.html.
-    if(QFileInfo(docroot + path).isDir())
-    {
-      path += "/index.html";
-    }
-    // Try to open the file
-    QFile file(docroot + path);
-#ifdef DEBUG_INFORMATION_WEB
-    qDebug("StaticFileController: Open file %s", qPrintable(file.fileName()));
-#endif
-    if(file.open(QIODevice::ReadOnly))
-    {
-      setContentType(path, response);
-      response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
-      if(file.size() <= maxCachedFileSize)
-      {
-        // Return the file content and store it also in the cache
-        entry = new CacheEntry();
-        while(!file.atEnd() && !file.error())
-        {
-          QByteArray buffer = file.read(65536);
-          response.write(buffer);
-          entry->document.append(buffer);
-        }
-        entry->created = now;
-        entry->filename = path;
-        mutex.lock();
-        cache.insert(request.getPath(), entry, entry->document.size());
-        mutex.unlock();
-      }
-      else
-      {
-        // Return the file content, do not store in cache
-        while(!file.atEnd() && !file.error())
-        {
-          response.write(file.read(65536));
-        }
-      }
-      file.close();
-    }
-    else
-    {
-      if(file.exists())
-      {
-        qWarning("StaticFileController: Cannot open existing file %s for reading", qPrintable(file.fileName()));
-        response.setStatus(403, "forbidden");
-        response.write("403 forbidden", true);
-      }
-      else
-      {
-        response.setStatus(404, "not found");
-        response.write("404 not found", true);
-      }
-    }
-  }
-}
-
-void StaticFileController::setContentType(const QString fileName, HttpResponse& response) const
-{
-  if(fileName.endsWith(".png"))
-  {
-    response.setHeader("Content-Type", "image/png");
-  }
-  else if(fileName.endsWith(".jpg"))
-  {
-    response.setHeader("Content-Type", "image/jpeg");
-  }
-  else if(fileName.endsWith(".gif"))
-  {
-    response.setHeader("Content-Type", "image/gif");
-  }
-  else if(fileName.endsWith(".pdf"))
-  {
-    response.setHeader("Content-Type", "application/pdf");
-  }
-  else if(fileName.endsWith(".txt"))
-  {
-    response.setHeader("Content-Type", qPrintable("text/plain; charset=" + encoding));
-  }
-  else if(fileName.endsWith(".html") || fileName.endsWith(".htm"))
-  {
-    response.setHeader("Content-Type", qPrintable("text/html; charset=" + encoding));
-  }
-  else if(fileName.endsWith(".css"))
-  {
-    response.setHeader("Content-Type", "text/css");
-  }
-  else if(fileName.endsWith(".js"))
-  {
-    response.setHeader("Content-Type", "text/javascript");
-  }
-  else if(fileName.endsWith(".svg"))
-  {
-    response.setHeader("Content-Type", "image/svg+xml");
-  }
-  else if(fileName.endsWith(".woff"))
-  {
-    response.setHeader("Content-Type", "font/woff");
-  }
-  else if(fileName.endsWith(".woff2"))
-  {
-    response.setHeader("Content-Type", "font/woff2");
-  }
-  else if(fileName.endsWith(".ttf"))
-  {
-    response.setHeader("Content-Type", "application/x-font-ttf");
-  }
-  else if(fileName.endsWith(".eot"))
-  {
-    response.setHeader("Content-Type", "application/vnd.ms-fontobject");
-  }
-  else if(fileName.endsWith(".otf"))
-  {
-    response.setHeader("Content-Type", "application/font-otf");
-  }
-  else if(fileName.endsWith(".json"))
-  {
-    response.setHeader("Content-Type", "application/json");
-  }
-  else if(fileName.endsWith(".xml"))
-  {
-    response.setHeader("Content-Type", "text/xml");
-  }
-  // Todo: add all of your content types
-  else
-  {
-#ifdef DEBUG_INFORMATION_WEB
-    qDebug("StaticFileController: unknown MIME type for filename '%s'", qPrintable(fileName));
-#endif
-  }
-}
+/**
+ *  @file
+ *  @author Stefan Frings
+ */
+
+#include "staticfilecontroller.h"
+#include "zip/gzip.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QLocale>
+
+#include <algorithm>
+
+using namespace stefanfrings;
+
+StaticFileController::StaticFileController(QHash<QString, QVariant> settings, QObject *parent)
+  : HttpRequestHandler(parent)
+{
+  maxAge = settings.value("maxAge", "60000").toInt();
+  encoding = settings.value("encoding", "UTF-8").toString();
+  docroot = settings.value("path", ".").toString();
+  if(!(docroot.startsWith(":/") || docroot.startsWith("qrc://")))
+  {
+    // Convert relative path to absolute, based on the directory of the config file.
+    if(QDir::isRelativePath(docroot))
+    {
+      QFileInfo configFile(settings.value("filename").toString());
+      docroot = QFileInfo(configFile.absolutePath(), docroot).absoluteFilePath();
+    }
+  }
+  qDebug("StaticFileController: docroot=%s, encoding=%s, maxAge=%i", qPrintable(docroot), qPrintable(encoding), maxAge);
+  maxCachedFileSize = settings.value("maxCachedFileSize", "65536").toInt();
+  cache.setMaxCost(settings.value("cacheSize", "1000000").toInt());
+  cacheTimeout = settings.value("cacheTime", "60000").toInt();
+  cache.setTimeout(cacheTimeout);
+  compression = settings.value("compression", true).toBool();
+  qDebug("StaticFileController: cache timeout=%i, size=%i", cacheTimeout, cache.maxCost());
+}
+
+void StaticFileController::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  // Cost is the size of document and compressed copy
+  bytes += cache.totalCost();
+  elements += cache.count();
+}
+
+void StaticFileController::releaseMemory(qint64 maxBytes)
+{
+  Q_UNUSED(maxBytes)
+  cache.clear();
+}
+
+void StaticFileController::service(HttpRequest& request, HttpResponse& response)
+{
+  QByteArray path = request.getPath();
+  bool acceptGzip = compression && request.acceptsEncoding("gzip");
+
+  // Check if we have the file in cache - lookup does not lock and shares the immutable entry
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  SharedCache<QByteArray, CacheEntry>::EntryPtr entry = cache.object(path, now);
+  if(entry)
+  {
+#ifdef DEBUG_INFORMATION_WEB
+    qDebug("StaticFileController: Cache hit for %s", path.constData());
+#endif
+    writeDocument(request, response, *entry, acceptGzip && !entry->gzipDocument.isEmpty());
+  }
+  else
+  {
+    // The file is not in cache.
+#ifdef DEBUG_INFORMATION_WEB
+    qDebug("StaticFileController: Cache miss for %s", path.constData());
+#endif
+    // Forbid access to files outside the docroot directory
+    if(path.contains("/.."))
+    {
+      qWarning("StaticFileController: detected forbidden characters in path %s", path.constData());
+      response.setStatus(403, "forbidden");
+      response.write("403 forbidden", true);
+      return;
+    }
+    // If the filename is a directory, append index.html.
+    if(QFileInfo(docroot + path).isDir())
+    {
+      path += "/index.html";
+    }
+    // Try to open the file
+    QFile file(docroot + path);
+#ifdef DEBUG_INFORMATION_WEB
+    qDebug("StaticFileController: Open file %s", qPrintable(file.fileName()));
+#endif
+    if(file.open(QIODevice::ReadOnly))
+    {
+      if(file.size() <= maxCachedFileSize)
+      {
+        // Return the file content and store it also in the cache
+        setContentType(path, response);
+        CacheEntry *newEntry = createEntry(file, path, response.getHeaders().value("Content-Type"));
+        entry.reset(newEntry);
+        writeDocument(request, response, *entry, acceptGzip && !entry->gzipDocument.isEmpty());
+        cache.insert(request.getPath(), entry, entry->document.size() + entry->gzipDocument.size(), now);
+      }
+      else
+      {
+        setContentType(path, response);
+        response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
+
+        QByteArray etag, lastModified;
+        fileValidators(file, etag, lastModified);
+        if(!writeNotModified(request, response, etag, lastModified))
+        {
+          // Send pre-compressed sidecar file instead if present - ranges are served only from the plain file
+          QFile gzipFile(file.fileName() + ".gz");
+          if(acceptGzip && request.getHeader("Range").isEmpty() && gzipFile.open(QIODevice::ReadOnly))
+          {
+            response.setHeader("Content-Encoding", "gzip");
+            response.setHeader("Vary", "Accept-Encoding");
+            response.writeFile(gzipFile, 0, gzipFile.size());
+          }
+          else
+          {
+            // Stream the file content or the requested range from a mapping, do not store in cache
+            qint64 start = 0, length = file.size();
+            if(writeRange(request, response, file.size(), etag, lastModified, start, length))
+            {
+              response.writeFile(file, start, length);
+            }
+          }
+        }
+      }
+      file.close();
+    }
+    else
+    {
+      if(file.exists())
+      {
+        qWarning("StaticFileController: Cannot open existing file %s for reading", qPrintable(file.fileName()));
+        response.setStatus(403, "forbidden");
+        response.write("403 forbidden", true);
+      }
+      else
+      {
+        response.setStatus(404, "not found");
+        response.write("404 not found", true);
+      }
+    }
+  }
+}
+
+StaticFileController::CacheEntry *StaticFileController::createEntry(QFile& file, const QByteArray& path,
+                                                                     const QByteArray& contentType) const
+{
+  CacheEntry *entry = new CacheEntry();
+  entry->document = file.readAll();
+  entry->filename = path;
+  fileValidators(file, entry->etag, entry->lastModified);
+
+  if(compression && HttpResponse::isCompressible(contentType))
+  {
+    // Prefer pre-compressed sidecar file
+    QFile gzipFile(file.fileName() + ".gz");
+    if(gzipFile.size() <= maxCachedFileSize && gzipFile.open(QIODevice::ReadOnly))
+    {
+      entry->gzipDocument = gzipFile.readAll();
+      gzipFile.close();
+    }
+    else
+    {
+      atools::zip::gzipCompress(entry->document, entry->gzipDocument);
+    }
+
+    // Keep only if compression saves space
+    if(entry->gzipDocument.size() >= entry->document.size())
+    {
+      entry->gzipDocument.clear();
+    }
+  }
+  return entry;
+}
+
+void StaticFileController::writeDocument(HttpRequest& request, HttpResponse& response, const CacheEntry& entry,
+                                         bool gzipped) const
+{
+  setContentType(entry.filename, response);
+  response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
+  if(compression)
+  {
+    response.setHeader("Vary", "Accept-Encoding");
+  }
+
+  if(!writeNotModified(request, response, entry.etag, entry.lastModified))
+  {
+    if(!request.getHeader("Range").isEmpty())
+    {
+      // Ranges refer to the plain document - send the part without compression
+      qint64 start = 0, length = entry.document.size();
+      if(writeRange(request, response, entry.document.size(), entry.etag, entry.lastModified, start, length))
+      {
+        response.write(entry.document.mid(static_cast<int>(start), static_cast<int>(length)), true);
+      }
+      return;
+    }
+
+    if(gzipped)
+    {
+      response.setHeader("Content-Encoding", "gzip");
+    }
+
+    // Send in one part which allows the response to set the content length
+    response.write(gzipped ? entry.gzipDocument : entry.document, true);
+  }
+}
+
+bool StaticFileController::writeRange(HttpRequest& request, HttpResponse& response, qint64 size,
+                                      const QByteArray& etag, const QByteArray& lastModified,
+                                      qint64& start, qint64& length) const
+{
+  response.setHeader("Accept-Ranges", "bytes");
+
+  QByteArray range = request.getHeader("Range").trimmed();
+  if(!range.startsWith("bytes=") || range.contains(','))
+  {
+    // No range, other unit or multiple ranges - send whole file which is allowed by RFC 7233
+    return true;
+  }
+
+  // Range applies only if the client still has the same version
+  QByteArray ifRange = request.getHeader("If-Range").trimmed();
+  if(!ifRange.isEmpty() && ifRange != etag && ifRange != lastModified)
+  {
+    return true;
+  }
+
+  QByteArray spec = range.mid(6).trimmed();
+  int dash = spec.indexOf('-');
+  bool okFirst = true, okLast = true;
+  qint64 first = -1, last = size - 1;
+  if(dash == 0)
+  {
+    // Suffix range like "-500" for the last 500 bytes
+    qint64 suffix = spec.mid(1).toLongLong(&okLast);
+    first = std::max(size - suffix, Q_INT64_C(0));
+    okLast = okLast && suffix > 0;
+  }
+  else if(dash > 0)
+  {
+    first = spec.left(dash).toLongLong(&okFirst);
+    if(dash < spec.size() - 1)
+    {
+      last = std::min(spec.mid(dash + 1).toLongLong(&okLast), size - 1);
+    }
+  }
+  else
+  {
+    okFirst = false;
+  }
+
+  if(!okFirst || !okLast || first < 0 || first > last || first >= size)
+  {
+    response.setStatus(416, "Range Not Satisfiable");
+    response.setHeader("Content-Range", "bytes */" + QByteArray::number(size));
+    response.write(QByteArray(), true);
+    return false;
+  }
+
+  start = first;
+  length = last - first + 1;
+  response.setStatus(206, "Partial Content");
+  response.setHeader("Content-Range", "bytes " + QByteArray::number(first) + '-' + QByteArray::number(last) + '/' +
+                     QByteArray::number(size));
+  return true;
+}
+
+bool StaticFileController::writeNotModified(HttpRequest& request, HttpResponse& response, const QByteArray& etag,
+                                            const QByteArray& lastModified) const
+{
+  response.setHeader("ETag", etag);
+  response.setHeader("Last-Modified", lastModified);
+
+  // If-None-Match takes precedence over If-Modified-Since
+  bool notModified = false;
+  QByteArray ifNoneMatch = request.getHeader("If-None-Match");
+  if(!ifNoneMatch.isEmpty())
+  {
+    for(const QByteArray& tag : ifNoneMatch.split(','))
+    {
+      QByteArray trimmed = tag.trimmed();
+      if(trimmed == "*" || trimmed == etag || trimmed == "W/" + etag)
+      {
+        notModified = true;
+        break;
+      }
+    }
+  }
+  else
+  {
+    QByteArray ifModifiedSince = request.getHeader("If-Modified-Since");
+    notModified = !ifModifiedSince.isEmpty() && ifModifiedSince == lastModified;
+  }
+
+  if(notModified)
+  {
+    response.setStatus(304, "Not Modified");
+    response.write(QByteArray(), true);
+  }
+  return notModified;
+}
+
+void StaticFileController::fileValidators(const QFile& file, QByteArray& etag, QByteArray& lastModified)
+{
+  QFileInfo fileInfo(file);
+  QDateTime modified = fileInfo.lastModified().toUTC();
+
+  etag = '"' + QByteArray::number(fileInfo.size(), 16) + '-' +
+         QByteArray::number(modified.toMSecsSinceEpoch(), 16) + '"';
+
+  // RFC 7231 IMF-fixdate, always in English
+  lastModified = QLocale::c().toString(modified, "ddd, dd MMM yyyy hh:mm:ss").toLatin1() + " GMT";
+}
+
+void StaticFileController::setContentType(const QString fileName, HttpResponse& response) const
+{
+  if(fileName.endsWith(".png"))
+  {
+    response.setHeader("Content-Type", "image/png");
+  }
+  else if(fileName.endsWith(".jpg"))
+  {
+    response.setHeader("Content-Type", "image/jpeg");
+  }
+  else if(fileName.endsWith(".gif"))
+  {
+    response.setHeader("Content-Type", "image/gif");
+  }
+  else if(fileName.endsWith(".pdf"))
+  {
+    response.setHeader("Content-Type", "application/pdf");
+  }
+  else if(fileName.endsWith(".txt"))
+  {
+    response.setHeader("Content-Type", qPrintable("text/plain; charset=" + encoding));
+  }
+  else if(fileName.endsWith(".html") || fileName.endsWith(".htm"))
+  {
+    response.setHeader("Content-Type", qPrintable("text/html; charset=" + encoding));
+  }
+  else if(fileName.endsWith(".css"))
+  {
+    response.setHeader("Content-Type", "text/css");
+  }
+  else if(fileName.endsWith(".js"))
+  {
+    response.setHeader("Content-Type", "text/javascript");
+  }
+  else if(fileName.endsWith(".svg"))
+  {
+    response.setHeader("Content-Type", "image/svg+xml");
+  }
+  else if(fileName.endsWith(".woff"))
+  {
+    response.setHeader("Content-Type", "font/woff");
+  }
+  else if(fileName.endsWith(".woff2"))
+  {
+    response.setHeader("Content-Type", "font/woff2");
+  }
+  else if(fileName.endsWith(".ttf"))
+  {
+    response.setHeader("Content-Type", "application/x-font-ttf");
+  }
+  else if(fileName.endsWith(".eot"))
+  {
+    response.setHeader("Content-Type", "application/vnd.ms-fontobject");
+  }
+  else if(fileName.endsWith(".otf"))
+  {
+    response.setHeader("Content-Type", "application/font-otf");
+  }
+  else if(fileName.endsWith(".json"))
+  {
+    response.setHeader("Content-Type", "application/json");
+  }
+  else if(fileName.endsWith(".xml"))
+  {
+    response.setHeader("Content-Type", "text/xml");
+  }
+  // Todo: add all of your content types
+  else
+  {
+#ifdef DEBUG_INFORMATION_WEB
+    qDebug("StaticFileController: unknown MIME type for filename '%s'", qPrintable(fileName));
+#endif
+  }
+}
@@ -1,103 +1,148 @@
-/**
- *  @file
- *  @author Stefan Frings
- */
-
-#ifndef STATICFILECONTROLLER_H
-#define STATICFILECONTROLLER_H
-
-#include <QCache>
-#include <QMutex>
-#include "httpglobal.h"
-#include "httprequest.h"
-#include "httpresponse.h"
-#include "httprequesthandler.h"
-
-namespace stefanfrings {
-
-/**
- *  Delivers static files. It is usually called by the applications main request handler when
- *  the caller requests a path that is mapped to static files.
- *  <p>
- *  The following settings are required in the config file:
- *  <code><pre>
- *  path=../docroot
- *  encoding=UTF-8
- *  maxAge=60000
- *  cacheTime=60000
- *  cacheSize=1000000
- *  maxCachedFileSize=65536
- *  </pre></code>
- *  The path is relative to the directory of the config file. In case of windows, if the
- *  settings are in the registry, the path is relative to the current working directory.
- *  <p>
- *  The encoding is sent to the web browser in case of text and html files.
- *  <p>
- *  The cache improves performance of small files when loaded from a network
- *  drive. Large files are not cached. Files are cached as long as possible,
- *  when cacheTime=0. The maxAge value (in msec!) controls the remote browsers cache.
- *  <p>
- *  Do not instantiate this class in each request, because this would make the file cache
- *  useless. Better create one instance during start-up and call it when the application
- *  received a related HTTP request.
- */
-
-class DECLSPEC StaticFileController :
-  public HttpRequestHandler
-{
-  Q_OBJECT
-  Q_DISABLE_COPY(StaticFileController)
-
-public:
-  /**
-   *  Constructor.
-   *  @param settings Configuration settings, usually stored in an INI file. Must not be 0.
-   *  Settings are read from the current group, so the caller must have called settings->beginGroup().
-   *  Because the group must not change during runtime, it is recommended to provide a
-   *  separate QSettings instance that is not used by other parts of the program.
-   *  The StaticFileController does not take over ownership of the QSettings instance, so the
-   *  caller should destroy it during shutdown.
-   *  @param parent Parent object
-   */
-  StaticFileController(QHash<QString, QVariant> settings, QObject *parent = nullptr);
-
-  /** Generates the response */
-  virtual void service(HttpRequest& request, HttpResponse& response) override;
-
-private:
-  /** Encoding of text files */
-  QString encoding;
-
-  /** Root directory of documents */
-  QString docroot;
-
-  /** Maximum age of files in the browser cache */
-  int maxAge;
-
-  struct CacheEntry
-  {
-    QByteArray document;
-    qint64 created;
-    QByteArray filename;
-  };
-
-  /** Timeout for each cached file */
-  int cacheTimeout;
-
-  /** Maximum size of files in cache, larger files are not cached */
-  int maxCachedFileSize;
-
-  /** Cache storage */
-  QCache<QString, CacheEntry> cache;
-
-  /** Used to synchronize cache access for threads */
-  QMutex mutex;
-
-  /** Set a content-type header in the response depending on the ending of the filename */
-  void setContentType(const QString file, HttpResponse& response) const;
-
-};
-
-} // end of namespace
-
-#endif // STATICFILECONTROLLER_H
+/**
+ *  @file
+ *  @author Stefan Frings
+ */
+
+#ifndef STATICFILECONTROLLER_H
+#define STATICFILECONTROLLER_H
+
+#include <QFile>
+#include "httpglobal.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "httprequesthandler.h"
+#include "sharedcache.h"
+#include "util/memoryaccounting.h"
+
+namespace stefanfrings {
+
+/**
+ *  Delivers static files. It is usually called by the applications main request handler when
+ *  the caller requests a path that is mapped to static files.
+ *  <p>
+ *  The following settings are required in the config file:
+ *  <code><pre>
+ *  path=../docroot
+ *  encoding=UTF-8
+ *  maxAge=60000
+ *  cacheTime=60000
+ *  cacheSize=1000000
+ *  maxCachedFileSize=65536
+ *  compression=true
+ *  </pre></code>
+ *  The path is relative to the directory of the config file. In case of windows, if the
+ *  settings are in the registry, the path is relative to the current working directory.
+ *  <p>
+ *  The encoding is sent to the web browser in case of text and html files.
+ *  <p>
+ *  The cache improves performance of small files when loaded from a network
+ *  drive. Large files are not cached. Files are cached as long as possible,
+ *  when cacheTime=0. The maxAge value (in msec!) controls the remote browsers cache.
+ *  <p>
+ *  If compression is enabled, a gzip compressed copy of text files is kept in the cache and sent to clients
+ *  accepting gzip. A pre-compressed sidecar file with the additional extension ".gz" (e.g. "map.js.gz")
+ *  is used instead of compressing at runtime. Sidecar files are also sent for large files which are not cached.
+ *  <p>
+ *  All files are sent with ETag and Last-Modified headers. Requests with a matching If-None-Match
+ *  or If-Modified-Since header get an empty 304 response.
+ *  <p>
+ *  A single byte range given by a Range header is answered with a 206 response if an If-Range header is
+ *  missing or matches. Large files are streamed from memory mapped segments and are never loaded completely.
+ *  <p>
+ *  Cache hits do not lock and do not copy the document.
+ *  @see SharedCache
+ *  <p>
+ *  Do not instantiate this class in each request, because this would make the file cache
+ *  useless. Better create one instance during start-up and call it when the application
+ *  received a related HTTP request.
+ */
+
+class DECLSPEC StaticFileController :
+  public HttpRequestHandler, public atools::util::MemoryAccountable
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(StaticFileController)
+
+public:
+  /**
+   *  Constructor.
+   *  @param settings Configuration settings, usually stored in an INI file. Must not be 0.
+   *  Settings are read from the current group, so the caller must have called settings->beginGroup().
+   *  Because the group must not change during runtime, it is recommended to provide a
+   *  separate QSettings instance that is not used by other parts of the program.
+   *  The StaticFileController does not take over ownership of the QSettings instance, so the
+   *  caller should destroy it during shutdown.
+   *  @param parent Parent object
+   */
+  StaticFileController(QHash<QString, QVariant> settings, QObject *parent = nullptr);
+
+  /** Generates the response */
+  virtual void service(HttpRequest& request, HttpResponse& response) override;
+
+  /** Cached documents and compressed copies. Elements are cached files. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
+  /** Clears the file cache */
+  virtual void releaseMemory(qint64 maxBytes) override;
+
+private:
+  /** Encoding of text files */
+  QString encoding;
+
+  /** Root directory of documents */
+  QString docroot;
+
+  /** Maximum age of files in the browser cache */
+  int maxAge;
+
+  /** Immutable after insertion into the cache */
+  struct CacheEntry
+  {
+    QByteArray document;
+    QByteArray gzipDocument; /* Compressed copy or empty if not compressible */
+    QByteArray filename;
+    QByteArray etag; /* Quoted entity tag from size and modification time of the file */
+    QByteArray lastModified; /* HTTP date */
+  };
+
+  /** Keep gzip compressed copies in the cache and use sidecar files */
+  bool compression;
+
+  /** Timeout for each cached file */
+  int cacheTimeout;
+
+  /** Maximum size of files in cache, larger files are not cached */
+  int maxCachedFileSize;
+
+  /** Cache storage. Thread safe. */
+  SharedCache<QByteArray, CacheEntry> cache;
+
+  /** Set a content-type header in the response depending on the ending of the filename */
+  void setContentType(const QString file, HttpResponse& response) const;
+
+  /** Read file and gzip sidecar file into a new cache entry if present. Compresses the document if no sidecar. */
+  CacheEntry *createEntry(QFile& file, const QByteArray& path, const QByteArray& contentType) const;
+
+  /** Send cached document or its compressed copy. Sends 304 if the client has the document already. */
+  void writeDocument(HttpRequest& request, HttpResponse& response, const CacheEntry& entry, bool gzipped) const;
+
+  /** Set ETag and Last-Modified headers. Returns true and sends a 304 response if the client has the file already. */
+  bool writeNotModified(HttpRequest& request, HttpResponse& response, const QByteArray& etag,
+                        const QByteArray& lastModified) const;
+
+  /**
+   *  Handle Range and If-Range headers for a single byte range. Sets Accept-Ranges and for a valid range the
+   *  206 status and Content-Range. Start and length are left unchanged if the whole file has to be sent.
+   *  @return false if a 416 response was sent for an invalid range
+   */
+  bool writeRange(HttpRequest& request, HttpResponse& response, qint64 size, const QByteArray& etag,
+                  const QByteArray& lastModified, qint64& start, qint64& length) const;
+
+  /** Get quoted entity tag and HTTP date for a file */
+  static void fileValidators(const QFile& file, QByteArray& etag, QByteArray& lastModified);
+
+};
+
+} // end of namespace
+
+#endif // STATICFILECONTROLLER_H
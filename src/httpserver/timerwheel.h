@@ -0,0 +1,127 @@
+/**
+ *  @file
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QVector>
+#include <algorithm>
+
+namespace stefanfrings {
+
+/**
+ *  Hierarchical timer wheel which collects keys when their due time has passed.
+ *  <p>
+ *  Time is counted in ticks of a fixed length. Level 0 has one slot per tick, each higher level has one slot
+ *  per full turn of the level below. Keys due far in the future are put into higher levels and moved down
+ *  when the lower level wraps. Scheduling is O(1) and advancing costs O(1) per tick plus the number of
+ *  moved or expired keys. No scan over all keys is needed.
+ *  <p>
+ *  A key is returned once for each call to schedule(). Callers which extend the due time of a key (e.g. on
+ *  access) simply check the real due time when the key is returned and schedule it again.
+ *  <p>
+ *  This class is not thread safe.
+ */
+template<typename KEY>
+class TimerWheel
+{
+public:
+  /**
+   *  @param tickMs Length of a tick in milliseconds
+   *  @param now Current time in milliseconds since epoch
+   */
+  TimerWheel(qint64 tickMs, qint64 now)
+    : tick(tickMs), currentTick(now / tickMs)
+  {
+    for(int i = 0; i < LEVELS; i++)
+    {
+      levels[i].resize(SLOTS);
+    }
+  }
+
+  /** Schedule key to be returned by advance() once due time in milliseconds since epoch has passed */
+  void schedule(const KEY& key, qint64 dueMs)
+  {
+    // Round up so that a key is never returned before its due time
+    insert(Entry({key, (dueMs + tick - 1) / tick}), currentTick + 1);
+  }
+
+  /**
+   *  Move the wheel forward to the given time and append all keys which are due to expired.
+   *  @param now Current time in milliseconds since epoch
+   */
+  void advance(qint64 now, QVector<KEY>& expired)
+  {
+    qint64 nowTick = now / tick;
+    while(currentTick < nowTick)
+    {
+      currentTick++;
+
+      // Move entries of higher levels down if the level below wrapped
+      for(int level = LEVELS - 1; level > 0; level--)
+      {
+        if((currentTick & ((Q_INT64_C(1) << (BITS * level)) - 1)) == 0)
+        {
+          QVector<Entry> entries;
+          entries.swap(levels[level][slotIndex(currentTick, level)]);
+          for(const Entry& entry : entries)
+          {
+            insert(entry, currentTick);
+          }
+        }
+      }
+
+      QVector<Entry>& slot = levels[0][slotIndex(currentTick, 0)];
+      for(const Entry& entry : slot)
+      {
+        expired.append(entry.key);
+      }
+      slot.clear();
+    }
+  }
+
+private:
+  static Q_DECL_CONSTEXPR int BITS = 6;
+  static Q_DECL_CONSTEXPR int SLOTS = 1 << BITS;
+  static Q_DECL_CONSTEXPR int LEVELS = 4;
+
+  struct Entry
+  {
+    KEY key;
+    qint64 dueTick;
+  };
+
+  static int slotIndex(qint64 tickNum, int level)
+  {
+    return static_cast<int>((tickNum >> (BITS * level)) & (SLOTS - 1));
+  }
+
+  /* Entries due before minTick are put into the slot of minTick */
+  void insert(const Entry& entry, qint64 minTick)
+  {
+    qint64 due = std::max(entry.dueTick, minTick);
+    qint64 delta = due - currentTick;
+
+    int level = 0;
+    while(level < LEVELS - 1 && delta >= (Q_INT64_C(1) << (BITS * (level + 1))))
+    {
+      level++;
+    }
+
+    if(delta >= (Q_INT64_C(1) << (BITS * LEVELS)))
+    {
+      // Too far in the future - park it in the last slot reachable and let it cascade again
+      due = currentTick + (Q_INT64_C(1) << (BITS * LEVELS)) - 1;
+    }
+
+    levels[level][slotIndex(due, level)].append(Entry({entry.key, entry.dueTick}));
+  }
+
+  qint64 tick, currentTick;
+  QVector<QVector<Entry> > levels[LEVELS];
+};
+
+} // end of namespace
+
+#endif // TIMERWHEEL_H
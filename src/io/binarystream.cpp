@@ -23,6 +23,8 @@
 #include <QFileInfo>
 #include "exception.h"
 
+#include <algorithm>
+
 namespace atools {
 namespace io {
 
@@ -35,35 +37,81 @@ using Qt::dec;
  * Big endian 1A2B3C4D = 1A 2B 3C 4D in mem
  * Little endian 1A2B3C4D =  4D 3C 2B 1A in mem
  */
-BinaryStream::BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order)
-  : is(binaryFile), filename(binaryFile->fileName()), filesize(binaryFile->size())
+BinaryStream::BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order, ReadMode mode)
+  : is(binaryFile), filename(binaryFile->fileName()), filesize(binaryFile->size()), file(binaryFile),
+  bigEndian(order == QDataStream::BigEndian)
 {
   is.setByteOrder(order);
   checkStream("constructor");
+
+  if(mode == READ_MAPPED && filesize > 0)
+  {
+    // Map from current file position to be consistent with the stream
+    pos = file->pos();
+    data = file->map(0, filesize);
+    if(data == nullptr)
+      qWarning() << Q_FUNC_INFO << "Cannot map" << filename << file->errorString() << "- using stream";
+  }
 }
 
-quint32 BinaryStream::readUInt()
+BinaryStream::~BinaryStream()
 {
-  quint32 retval;
-  is >> retval;
-
-  checkStream("readInt");
-
-  return retval;
+  if(data != nullptr && file->isOpen())
+    file->unmap(const_cast<uchar *>(data));
 }
 
 int BinaryStream::readBytes(char bytes[], int size)
 {
-  int numRead = is.readRawData(bytes, size);
-  checkStream("readBytes");
-  return numRead;
+  if(data != nullptr)
+  {
+    checkMapped(static_cast<size_t>(std::max(size, 0)), "readBytes");
+    std::memcpy(bytes, data + pos, static_cast<size_t>(size));
+    pos += size;
+    return size;
+  }
+  else
+  {
+    int numRead = is.readRawData(bytes, size);
+    checkStream("readBytes");
+    return numRead;
+  }
 }
 
 int BinaryStream::readUBytes(unsigned char bytes[], int size)
 {
-  int numRead = is.readRawData(reinterpret_cast<char *>(bytes), size);
-  checkStream("readBytes");
-  return numRead;
+  return readBytes(reinterpret_cast<char *>(bytes), size);
+}
+
+void BinaryStream::readInts(qint32 values[], int size)
+{
+  if(size <= 0)
+    return;
+
+  if(data != nullptr)
+  {
+    checkMapped(static_cast<size_t>(size) * sizeof(qint32), "readInts");
+    std::memcpy(values, data + pos, static_cast<size_t>(size) * sizeof(qint32));
+    pos += static_cast<qint64>(size) * static_cast<qint64>(sizeof(qint32));
+  }
+  else
+  {
+    is.readRawData(reinterpret_cast<char *>(values), size * static_cast<int>(sizeof(qint32)));
+    checkStream("readInts");
+  }
+
+  // Raw data is copied as is - swap only if file and host order differ
+  if(bigEndian)
+  {
+    for(int i = 0; i < size; i++)
+      values[i] = qFromBigEndian(values[i]);
+  }
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+  else
+  {
+    for(int i = 0; i < size; i++)
+      values[i] = qFromLittleEndian(values[i]);
+  }
+#endif
 }
 
 QUuid BinaryStream::readUuid()
@@ -80,21 +128,34 @@ QUuid BinaryStream::readUuid()
 
 qint64 BinaryStream::tellg() const
 {
+  if(data != nullptr)
+    return pos;
+
   checkStream("tellg");
   return is.device()->pos();
 }
 
 void BinaryStream::skip(qint64 bytes)
 {
-  checkStream("skip");
-  if(bytes != 0)
-    is.device()->seek(tellg() + bytes);
+  if(data != nullptr)
+    pos += bytes;
+  else
+  {
+    checkStream("skip");
+    if(bytes != 0)
+      is.device()->seek(tellg() + bytes);
+  }
 }
 
-void BinaryStream::seekg(qint64 pos)
+void BinaryStream::seekg(qint64 posParam)
 {
-  checkStream("seekg");
-  is.device()->seek(pos);
+  if(data != nullptr)
+    pos = posParam;
+  else
+  {
+    checkStream("seekg");
+    is.device()->seek(posParam);
+  }
 }
 
 QString BinaryStream::getFilenameOnly() const
@@ -113,109 +174,89 @@ float BinaryStream::readFloat()
 
   u.intValue = readUInt();
 
-  checkStream("readFloat");
-
   return u.floatValue;
 }
 
-quint16 BinaryStream::readUShort()
-{
-  quint16 retval;
-  is >> retval;
-
-  checkStream("readShort");
-
-  return retval;
-}
-
-quint8 BinaryStream::readUByte()
-{
-  quint8 retval;
-  is >> retval;
-
-  checkStream("readByte");
-
-  return retval;
-}
-
-qint32 BinaryStream::readInt()
+/* Convert bytes to string using encoding */
+static QString decodeString(const char *str, int size, Encoding encoding)
 {
-  qint32 retval;
-  is >> retval;
-
-  checkStream("readInt");
-
-  return retval;
+  if(size == 0)
+    // Return empty but not null string to avoid binding null values
+    return QString("");
+  else if(encoding == UTF8)
+    return QString::fromUtf8(str, size);
+  else if(encoding == LATIN1)
+    return QString::fromLatin1(str, size);
+  else
+    return QString::fromLocal8Bit(str, size);
 }
 
-qint16 BinaryStream::readShort()
+QString BinaryStream::readString(Encoding encoding)
 {
-  qint16 retval;
-  is >> retval;
-
-  checkStream("readShort");
-
-  return retval;
-}
+  if(data != nullptr)
+  {
+    // Search terminating NUL directly in mapped memory
+    checkMapped(1, "readString");
+    const char *str = reinterpret_cast<const char *>(data + pos);
+    const void *end = std::memchr(str, '\0', static_cast<size_t>(filesize - pos));
 
-qint8 BinaryStream::readByte()
-{
-  qint8 retval;
-  is >> retval;
+    if(end == nullptr)
+    {
+      // Same behavior as stream which reads past end
+      pos = filesize;
+      throwReadPastEnd("readString");
+    }
 
-  checkStream("readByte");
+    int length = static_cast<int>(static_cast<const char *>(end) - str);
+    pos += length + 1;
+    return decodeString(str, length, encoding);
+  }
+  else
+  {
+    QByteArray retval;
+    char c = 0;
+    do
+    {
+      c = readByte();
+      if(c != '\0')
+        retval.append(c);
+    } while(c != '\0');
 
-  return retval;
-}
+    checkStream("readString");
 
-QChar BinaryStream::readChar()
-{
-  return QChar::fromLatin1(readByte());
+    return decodeString(retval.constData(), retval.size(), encoding);
+  }
 }
 
-QString BinaryStream::readString(Encoding encoding)
+QString BinaryStream::readString(int length, Encoding encoding)
 {
-  QByteArray retval;
-  char c = 0;
-  do
+  if(data != nullptr)
   {
-    c = readByte();
-    retval.append(c);
-  } while(c != '\0');
-
-  checkStream("readString");
-
-  if(encoding == UTF8)
-    return QString::fromUtf8(retval);
-  else if(encoding == LATIN1)
-    return QString::fromLatin1(retval);
+    checkMapped(static_cast<size_t>(std::max(length, 0)), "readBytes");
+    const char *str = reinterpret_cast<const char *>(data + pos);
+    pos += length;
+    return decodeString(str, static_cast<int>(qstrnlen(str, static_cast<uint>(length))), encoding);
+  }
   else
-    return QString::fromLocal8Bit(retval);
+  {
+    QByteArray buf(length, '\0');
+    readBytes(buf.data(), length);
+    return decodeString(buf.constData(), static_cast<int>(qstrnlen(buf.constData(), static_cast<uint>(length))),
+                        encoding);
+  }
 }
 
-QString BinaryStream::readString(int length, Encoding encoding)
+void BinaryStream::throwReadPastEnd(const char *what) const
 {
-  char *buf = new char[static_cast<size_t>(length)];
-  readBytes(buf, length);
+  QString msg = QString("%1 for file \"%2\" failed. Reason: %3 (%4).").
+                arg(QString::fromLatin1(what)).arg(getFilename()).arg(tr("Read past file end")).
+                arg(QDataStream::ReadPastEnd);
 
-  QByteArray retval;
-  for(int i = 0; i < length; i++)
-  {
-    retval.append(buf[i]);
-    if(buf[i] == '\0')
-      break;
-  }
-  delete[] buf;
-
-  if(encoding == UTF8)
-    return QString::fromUtf8(retval);
-  else if(encoding == LATIN1)
-    return QString::fromLatin1(retval);
-  else
-    return QString::fromLocal8Bit(retval);
+  qWarning() << msg << "Position" << hex << "0x" << pos << dec << pos;
+  throw Exception(msg);
 }
 
-void BinaryStream::checkStream(const QString& what) const
+void BinaryStream::checkStream(const char *what) const
 {
   if(is.status() != QDataStream::Ok)
   {
@@ -236,7 +277,7 @@ void BinaryStream::checkStream(const QString& what) const
         break;
     }
 
-    QString msg = QString("%1 for file \"%2\" failed. Reason: %3 (%4).").arg(what).arg(getFilename()).arg(statusText).arg(is.status());
+    QString msg = QString("%1 for file \"%2\" failed. Reason: %3 (%4).").arg(QString::fromLatin1(what)).arg(getFilename()).arg(statusText).arg(is.status());
 
     qWarning() << msg << "Position" << hex << "0x" << is.device()->pos() << dec << is.device()->pos();
     throw Exception(msg);
@@ -20,6 +20,9 @@
 
 #include <QDataStream>
 #include <QCoreApplication>
+#include <QtEndian>
+
+#include <cstring>
 
 class QFile;
 
@@ -32,28 +35,64 @@ enum Encoding
   LATIN1
 };
 
+/* Backend used to read the file */
+enum ReadMode
+{
+  /* Read through QDataStream on the file */
+  READ_STREAM,
+
+  /* Map the whole file into memory and read from the pointer.
+   * Falls back to READ_STREAM if the file cannot be mapped. */
+  READ_MAPPED
+};
+
 /*
- * Simple wrapper for binary file reading around QDataStream
- * that will throw an Exception in case of
- * errors.
+ * Simple wrapper for binary file reading around QDataStream or a memory mapped file
+ * that will throw an Exception in case of errors.
+ *
+ * The file has to stay open for the lifetime of the stream if READ_MAPPED is used.
  */
 class BinaryStream
 {
   Q_DECLARE_TR_FUNCTIONS(BinaryStream)
 
 public:
-  BinaryStream(QFile* binaryFile, QDataStream::ByteOrder order = QDataStream::LittleEndian);
+  BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order = QDataStream::LittleEndian,
+               atools::io::ReadMode mode = READ_STREAM);
+  ~BinaryStream();
 
   BinaryStream(const BinaryStream& other) = delete;
   BinaryStream& operator=(const BinaryStream& other) = delete;
 
-  qint8 readByte();
-  qint16 readShort();
-  qint32 readInt();
+  qint8 readByte()
+  {
+    return read<qint8>("readByte");
+  }
+
+  qint16 readShort()
+  {
+    return read<qint16>("readShort");
+  }
+
+  qint32 readInt()
+  {
+    return read<qint32>("readInt");
+  }
+
+  quint8 readUByte()
+  {
+    return read<quint8>("readByte");
+  }
+
+  quint16 readUShort()
+  {
+    return read<quint16>("readShort");
+  }
 
-  quint8 readUByte();
-  quint16 readUShort();
-  quint32 readUInt();
+  quint32 readUInt()
+  {
+    return read<quint32>("readInt");
+  }
 
   float readFloat();
 
@@ -64,11 +103,17 @@ public:
   QString readString(int length, Encoding encoding);
 
   /* Reads a single byte as a latin-1 character */
-  QChar readChar();
+  QChar readChar()
+  {
+    return QChar::fromLatin1(readByte());
+  }
 
   int readBytes(char bytes[], int size);
   int readUBytes(unsigned char bytes[], int size);
 
+  /* Reads size 32 bit integers at once and converts byte order */
+  void readInts(qint32 values[], int size);
+
   /* Reads 16 bytes like 38EA37B0-F8ED-E54A-B41B-2CA423ADA3EF into UUID
    *  {B037EA38-EDF8-4AE5-B41B-2CA423ADA3EF} */
   QUuid readUuid();
@@ -91,12 +136,54 @@ public:
   /* Returns file name without path */
   QString getFilenameOnly() const;
 
+  /* true if the file is mapped into memory */
+  bool isMapped() const
+  {
+    return data != nullptr;
+  }
+
 private:
-  void checkStream(const QString& what) const;
+  /* Read a value from mapped memory or the stream */
+  template<typename TYPE>
+  TYPE read(const char *what)
+  {
+    if(data != nullptr)
+    {
+      checkMapped(sizeof(TYPE), what);
+
+      TYPE retval;
+      std::memcpy(&retval, data + pos, sizeof(TYPE));
+      pos += static_cast<qint64>(sizeof(TYPE));
+      return bigEndian ? qFromBigEndian(retval) : qFromLittleEndian(retval);
+    }
+    else
+    {
+      TYPE retval;
+      is >> retval;
+      checkStream(what);
+      return retval;
+    }
+  }
+
+  /* Throws if size bytes cannot be read at the current position of the mapped file */
+  void checkMapped(size_t size, const char *what) const
+  {
+    if(pos < 0 || static_cast<quint64>(pos) + size > static_cast<quint64>(filesize))
+      throwReadPastEnd(what);
+  }
+
+  void checkStream(const char *what) const;
+  [[noreturn]] void throwReadPastEnd(const char *what) const;
 
   QDataStream is;
   QString filename;
   qint64 filesize;
+
+  /* Mapped file or null if reading from the stream */
+  QFile *file;
+  const uchar *data = nullptr;
+  qint64 pos = 0;
+  bool bigEndian = false;
 };
 
 } /* namespace io */
@@ -0,0 +1,312 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "io/fastinireader.h"
+
+#include "exception.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QTextStream>
+
+namespace atools {
+namespace io {
+
+FastIniReader::FastIniReader()
+{
+
+}
+
+FastIniReader::~FastIniReader()
+{
+  clear();
+}
+
+void FastIniReader::read(const QString& filename)
+{
+  clear();
+  filepath = filename;
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    throw Exception(tr("Cannot open file %1. Reason: %2").arg(filename).arg(file.errorString()));
+
+  QByteArray bom = file.peek(2);
+  if(bom.startsWith("\xFF\xFE") || bom.startsWith("\xFE\xFF"))
+  {
+    // UTF-16 - convert whole file to UTF-8 once
+    QTextStream stream(&file);
+    stream.setAutoDetectUnicode(true);
+    converted = stream.readAll().toUtf8();
+    lineReader.setData(converted);
+  }
+  else if(!lineReader.open(&file))
+    throw Exception(tr("Cannot read file %1. Reason: %2").arg(filename).arg(file.errorString()));
+
+  parse();
+}
+
+void FastIniReader::readData(const QByteArray& data)
+{
+  clear();
+  lineReader.setData(data);
+  parse();
+}
+
+void FastIniReader::clear()
+{
+  // Unmap before closing
+  lineReader.setData(QByteArray());
+  if(file.isOpen())
+    file.close();
+
+  filepath.clear();
+  converted.clear();
+  names.clear();
+  nameIds.clear();
+  sections.clear();
+  entries.clear();
+  entryIndexMap.clear();
+}
+
+void FastIniReader::parse()
+{
+  int currentSection = -1;
+  int lineNum = 0;
+  QByteArray line, name;
+
+  while(lineReader.readLine(line))
+  {
+    lineNum++;
+
+    // Cut off comment
+    int end = line.size();
+    for(char c : qAsConst(commentCharacters))
+    {
+      int idx = line.indexOf(c);
+      if(idx >= 0 && idx < end)
+        end = idx;
+    }
+
+    line = trimmed(line, 0, end);
+    if(line.isEmpty())
+      continue;
+
+    if(line.at(0) == '[')
+    {
+      if(line.endsWith(']'))
+        name = trimmed(line, 1, line.size() - 1);
+      else
+      {
+        name = trimmed(line, 1, line.size());
+        qWarning() << "Missing closing \"]\" in" << filepath << "line" << lineNum;
+      }
+
+      toLowerAscii(name);
+      currentSection = internName(name);
+      if(!sections.contains(currentSection))
+        sections.append(currentSection);
+    }
+    else
+    {
+      int eq = line.indexOf('=');
+      if(eq < 0)
+      {
+        qWarning() << "Missing \"=\" in" << filepath << "line" << lineNum;
+        continue;
+      }
+
+      name = trimmed(line, 0, eq);
+      if(name.isEmpty())
+      {
+        qWarning() << "Missing key name before \"=\" in" << filepath << "line" << lineNum;
+        continue;
+      }
+
+      if(currentSection == -1)
+      {
+        // Keys before the first section
+        currentSection = internName(QByteArray(""));
+        sections.append(currentSection);
+      }
+
+      toLowerAscii(name);
+      int key = internName(name);
+      QByteArray value = trimmed(line, eq + 1, line.size());
+
+      quint64 hashKey = entryKey(currentSection, key);
+      QHash<quint64, int>::const_iterator it = entryIndexMap.constFind(hashKey);
+      if(it != entryIndexMap.constEnd())
+        // Later keys replace earlier ones
+        entries[it.value()].value = value;
+      else
+      {
+        entryIndexMap.insert(hashKey, entries.size());
+        entries.append(Entry({currentSection, key, value}));
+      }
+    }
+  }
+}
+
+int FastIniReader::internName(const QByteArray& name)
+{
+  QHash<QByteArray, int>::const_iterator it = nameIds.constFind(name);
+  if(it != nameIds.constEnd())
+    return it.value();
+
+  // Deep copy to detach from the file and the parse buffer
+  QByteArray copy(name.constData(), name.size());
+  int id = names.size();
+  names.append(copy);
+  nameIds.insert(copy, id);
+  return id;
+}
+
+int FastIniReader::nameId(const QString& name) const
+{
+  QByteArray bytes = name.toUtf8();
+  toLowerAscii(bytes);
+  return nameIds.value(bytes, -1);
+}
+
+int FastIniReader::entryIndex(const QString& section, const QString& key) const
+{
+  int sectionId = nameId(section), keyId = nameId(key);
+  if(sectionId == -1 || keyId == -1)
+    return -1;
+
+  return entryIndexMap.value(entryKey(sectionId, keyId), -1);
+}
+
+bool FastIniReader::hasSection(const QString& section) const
+{
+  int id = nameId(section);
+  return id != -1 && sections.contains(id);
+}
+
+bool FastIniReader::hasKey(const QString& section, const QString& key) const
+{
+  return entryIndex(section, key) != -1;
+}
+
+QByteArray FastIniReader::getValueBytes(const QString& section, const QString& key) const
+{
+  int idx = entryIndex(section, key);
+  return idx != -1 ? entries.at(idx).value : QByteArray();
+}
+
+QString FastIniReader::getValueString(const QString& section, const QString& key) const
+{
+  QString str;
+  LineReader::toString(getValueBytes(section, key), str);
+  return str;
+}
+
+QString FastIniReader::findValueString(const QString& key) const
+{
+  QString str;
+  int keyId = nameId(key);
+  if(keyId != -1)
+  {
+    for(const Entry& entry : entries)
+    {
+      if(entry.key == keyId)
+      {
+        LineReader::toString(entry.value, str);
+        break;
+      }
+    }
+  }
+  return str;
+}
+
+QStringList FastIniReader::getSections() const
+{
+  QStringList retval;
+  for(int id : sections)
+    retval.append(QString::fromUtf8(names.at(id)));
+  return retval;
+}
+
+IniKeyValues FastIniReader::getKeyValuePairs(const QString& section) const
+{
+  IniKeyValues retval;
+  int sectionId = nameId(section);
+  if(sectionId != -1)
+  {
+    for(const Entry& entry : entries)
+    {
+      if(entry.section == sectionId)
+        retval.insert(QString::fromUtf8(names.at(entry.key)), QString::fromUtf8(entry.value));
+    }
+  }
+  return retval;
+}
+
+QByteArray FastIniReader::trimmed(const QByteArray& bytes, int from, int to)
+{
+  const char *data = bytes.constData();
+  while(from < to && (data[from] == ' ' || data[from] == '\t' || data[from] == '\r'))
+    from++;
+  while(to > from && (data[to - 1] == ' ' || data[to - 1] == '\t' || data[to - 1] == '\r'))
+    to--;
+
+  // Does not copy
+  return QByteArray::fromRawData(data + from, to - from);
+}
+
+void FastIniReader::toLowerAscii(QByteArray& bytes)
+{
+  // Avoid detaching if nothing to convert
+  const char *data = bytes.constData();
+  for(int i = 0; i < bytes.size(); i++)
+  {
+    if(data[i] >= 'A' && data[i] <= 'Z')
+    {
+      char *dest = bytes.data();
+      for(int j = i; j < bytes.size(); j++)
+      {
+        if(dest[j] >= 'A' && dest[j] <= 'Z')
+          dest[j] = static_cast<char>(dest[j] - 'A' + 'a');
+      }
+      break;
+    }
+  }
+}
+
+void FastIniReader::readFiles(const QStringList& filenames, const FastIniReaderFuncType& func, int numThreads)
+{
+  atools::util::parallelFor(filenames.size(), numThreads, [&filenames, &func](int begin, int end, int) -> void {
+    // One reader per chunk to reuse buffers
+    FastIniReader reader;
+    for(int i = begin; i < end; i++)
+    {
+      try
+      {
+        reader.read(filenames.at(i));
+        func(i, reader);
+      }
+      catch(atools::Exception& e)
+      {
+        qWarning() << Q_FUNC_INFO << e.getMessage();
+      }
+    }
+  }, 8);
+}
+
+} // namespace io
+} // namespace atools
@@ -0,0 +1,164 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_IO_FASTINIREADER_H
+#define ATOOLS_IO_FASTINIREADER_H
+
+#include "io/inireader.h"
+#include "io/linereader.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+#include <functional>
+
+namespace atools {
+namespace io {
+
+class FastIniReader;
+
+/* Called for each file read by FastIniReader::readFiles(). index is the position in the file list. */
+typedef std::function<void (int index, const FastIniReader& reader)> FastIniReaderFuncType;
+
+/*
+ * Reads INI style files like aircraft.cfg into memory at once and allows lookups by section and key.
+ *
+ * The file is mapped into memory and split into lines without decoding. Section and key names are converted to
+ * lower case and interned, i.e. each distinct name is stored only once per reader. Values are not copied and
+ * reference the mapped file. Values are valid as long as the reader is not cleared, reused or deleted.
+ *
+ * Files have to be UTF-8 or ASCII. Files with a UTF-16 byte order mark are converted to UTF-8 on loading.
+ * Case conversion is done for ASCII characters only.
+ *
+ * Like IniReader section names keep a numbered suffix like [fltsim.0], keys before the first section are
+ * stored in an empty section and later duplicate keys replace earlier ones.
+ *
+ * Use readFiles() to read a large number of files in parallel.
+ */
+class FastIniReader
+{
+  Q_DECLARE_TR_FUNCTIONS(atools::io::FastIniReader)
+
+public:
+  FastIniReader();
+  ~FastIniReader();
+
+  FastIniReader(const FastIniReader& other) = delete;
+  FastIniReader& operator=(const FastIniReader& other) = delete;
+
+  /* Map and read the file. Throws Exception if the file cannot be opened. */
+  void read(const QString& filename);
+
+  /* Read from data which has to exist as long as values are used */
+  void readData(const QByteArray& data);
+
+  /* Removes all values and unmaps the file */
+  void clear();
+
+  /* Characters which start a line comment. Default is ";". */
+  void setCommentCharacters(const QByteArray& value)
+  {
+    commentCharacters = value;
+  }
+
+  bool hasSection(const QString& section) const;
+  bool hasKey(const QString& section, const QString& key) const;
+
+  /* Get value as bytes referencing the file. Empty if not found. */
+  QByteArray getValueBytes(const QString& section, const QString& key) const;
+
+  /* Get value converted to string. Empty if not found. */
+  QString getValueString(const QString& section, const QString& key) const;
+
+  /* Get value of the first key with the given name in any section in file order. Empty if not found. */
+  QString findValueString(const QString& key) const;
+
+  /* All section names in file order */
+  QStringList getSections() const;
+
+  /* All key value pairs for a [section] as used by IniReader. Values are copied. */
+  IniKeyValues getKeyValuePairs(const QString& section) const;
+
+  const QString& getFilepath() const
+  {
+    return filepath;
+  }
+
+  /*
+   * Read all files in a local thread pool and call func for each file from the worker thread.
+   * func is called concurrently and has to write its results to separate places for each index.
+   * Blocks until all files are read. Files which cannot be read are skipped with a warning.
+   *
+   * numThreads: 0 uses the number of cores.
+   */
+  static void readFiles(const QStringList& filenames, const FastIniReaderFuncType& func, int numThreads = 0);
+
+private:
+  struct Entry
+  {
+    int section, key;
+    QByteArray value;
+  };
+
+  /* Read lines from lineReader and fill the index */
+  void parse();
+
+  /* Get id of name or insert it. name is lower case. */
+  int internName(const QByteArray& name);
+
+  /* Get id of name converted to lower case UTF-8 or -1 if not found */
+  int nameId(const QString& name) const;
+
+  /* Get index into entries or -1 */
+  int entryIndex(const QString& section, const QString& key) const;
+
+  static quint64 entryKey(int section, int key)
+  {
+    return (static_cast<quint64>(static_cast<quint32>(section)) << 32) | static_cast<quint32>(key);
+  }
+
+  /* Remove comment and whitespace at both ends without copying */
+  static QByteArray trimmed(const QByteArray& bytes, int from, int to);
+  static void toLowerAscii(QByteArray& bytes);
+
+  QString filepath;
+  QFile file;
+  LineReader lineReader;
+
+  /* Converted file content if not UTF-8 */
+  QByteArray converted;
+
+  QByteArray commentCharacters = ";";
+
+  /* Interned lower case section and key names */
+  QVector<QByteArray> names;
+  QHash<QByteArray, int> nameIds;
+
+  /* Section name ids in file order */
+  QVector<int> sections;
+
+  /* Values in file order and index by section and key name id */
+  QVector<Entry> entries;
+  QHash<quint64, int> entryIndexMap;
+};
+
+} // namespace io
+} // namespace atools
+
+#endif // ATOOLS_IO_FASTINIREADER_H
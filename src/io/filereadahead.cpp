@@ -0,0 +1,135 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "io/filereadahead.h"
+#include "util/tracing.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+
+namespace atools {
+namespace io {
+
+/* Number of files read ahead for each thread */
+static Q_DECL_CONSTEXPR int FILES_PER_THREAD = 4;
+
+/* Reads one file in the thread pool */
+class FileReadAheadTask :
+  public QRunnable
+{
+public:
+  FileReadAheadTask(FileReadAhead *readAheadParam, FileReadAhead::ReadResult *resultParam, const QString& filepathParam)
+    : readAhead(readAheadParam), result(resultParam), filepath(filepathParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    ATOOLS_TRACE_SPAN("io", "FileReadAhead::read");
+
+    if(!readAhead->canceled)
+    {
+      QFile file(filepath);
+      if(file.open(QIODevice::ReadOnly))
+      {
+        result->content = file.readAll();
+        result->ok = file.error() == QFileDevice::NoError;
+        file.close();
+      }
+    }
+
+    QMutexLocker locker(&readAhead->mutex);
+    result->done = true;
+    readAhead->doneCondition.wakeAll();
+  }
+
+private:
+  FileReadAhead *readAhead;
+  FileReadAhead::ReadResult *result;
+  QString filepath;
+};
+
+FileReadAhead::FileReadAhead(const QStringList& filepaths, int numThreads)
+  : files(filepaths), canceled(false)
+{
+  if(numThreads <= 0)
+    numThreads = QThread::idealThreadCount();
+
+  numReaderThreads = std::max(std::min(numThreads, static_cast<int>(files.size())), 1);
+
+  if(numReaderThreads > 1)
+  {
+    pool.setMaxThreadCount(numReaderThreads);
+    results.resize(static_cast<size_t>(files.size()));
+  }
+}
+
+FileReadAhead::~FileReadAhead()
+{
+  // Remove tasks which are not started yet and wait for the running ones before the results are deleted
+  canceled = true;
+  pool.clear();
+  pool.waitForDone();
+}
+
+bool FileReadAhead::next(int index, QByteArray& content)
+{
+  content.clear();
+
+  if(numReaderThreads == 1 || index < 0 || index >= files.size())
+    return false;
+
+  // Release previous content since indexes are requested in order
+  if(index > 0)
+    results[static_cast<size_t>(index - 1)].reset();
+
+  schedule(index);
+
+  ReadResult *result = results.at(static_cast<size_t>(index)).get();
+  {
+    ATOOLS_TRACE_SPAN("io", "FileReadAhead::wait");
+    QMutexLocker locker(&mutex);
+    while(!result->done)
+      doneCondition.wait(&mutex);
+  }
+
+  if(result->ok)
+    content = result->content;
+  return result->ok;
+}
+
+void FileReadAhead::schedule(int index)
+{
+  int last = std::min(index + numReaderThreads * FILES_PER_THREAD, static_cast<int>(files.size()) - 1);
+
+  // Results are only read by the worker threads after start()
+  for(; numScheduled <= last; numScheduled++)
+  {
+    ReadResult *result = new ReadResult;
+    results[static_cast<size_t>(numScheduled)].reset(result);
+    pool.start(new FileReadAheadTask(this, result, files.at(numScheduled)));
+  }
+}
+
+} // namespace io
+} // namespace atools
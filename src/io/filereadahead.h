@@ -0,0 +1,95 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_IO_FILEREADAHEAD_H
+#define ATOOLS_IO_FILEREADAHEAD_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace atools {
+namespace io {
+
+/*
+ * Loads the content of a list of files ahead in a local thread pool while the caller processes the
+ * previous files. Files are returned in the order of the list.
+ *
+ * Useful for many small text files like X-Plane CIFP where opening and reading dominates.
+ * Does nothing if only one thread is requested. Callers read the file directly in this case.
+ */
+class FileReadAhead
+{
+public:
+  /*
+   * @param numThreads Number of reader threads. 0 uses the number of cores.
+   * filepaths has to stay valid for the lifetime of this object.
+   */
+  FileReadAhead(const QStringList& filepaths, int numThreads);
+
+  /* Cancels all tasks not started yet and waits for the running ones */
+  ~FileReadAhead();
+
+  FileReadAhead(const FileReadAhead& other) = delete;
+  FileReadAhead& operator=(const FileReadAhead& other) = delete;
+
+  /*
+   * Get the content for index in filepaths. Indexes have to be requested in ascending order.
+   * Blocks until the file is read. Returns false if the file could not be read or read ahead is disabled.
+   * The caller should read the file directly in this case to get the usual error handling.
+   */
+  bool next(int index, QByteArray& content);
+
+  /* Number of reader threads or 1 if disabled */
+  int getNumThreads() const
+  {
+    return numReaderThreads;
+  }
+
+private:
+  friend class FileReadAheadTask;
+
+  /* Result of one reader task */
+  struct ReadResult
+  {
+    QByteArray content;
+    bool ok = false, done = false;
+  };
+
+  /* Start tasks for all files up to index plus the read ahead window */
+  void schedule(int index);
+
+  const QStringList& files;
+  std::vector<std::unique_ptr<ReadResult> > results;
+  int numReaderThreads = 1, numScheduled = 0;
+  std::atomic_bool canceled;
+  QMutex mutex;
+  QWaitCondition doneCondition;
+  QThreadPool pool;
+};
+
+} // namespace io
+} // namespace atools
+
+#endif // ATOOLS_IO_FILEREADAHEAD_H
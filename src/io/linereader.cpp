@@ -0,0 +1,161 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "io/linereader.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QString>
+
+#include <cstring>
+
+namespace atools {
+namespace io {
+
+LineReader::LineReader()
+{
+
+}
+
+LineReader::~LineReader()
+{
+  close();
+}
+
+bool LineReader::open(QFile *file, qint64 offset)
+{
+  close();
+
+  qint64 fileSize = file->size();
+  if(fileSize > 0)
+  {
+    mapped = file->map(0, fileSize);
+    if(mapped != nullptr)
+    {
+      mappedFile = file;
+      init(reinterpret_cast<const char *>(mapped), fileSize, offset);
+      return true;
+    }
+
+    // Fall back to reading all
+    qint64 oldPos = file->pos();
+    if(file->seek(0))
+    {
+      loaded = file->readAll();
+      file->seek(oldPos);
+      init(loaded.constData(), loaded.size(), offset);
+      return file->error() == QFileDevice::NoError;
+    }
+    return false;
+  }
+
+  init(nullptr, 0, 0);
+  return true;
+}
+
+void LineReader::setData(const QByteArray& dataParam, qint64 offset)
+{
+  close();
+  init(dataParam.constData(), dataParam.size(), offset);
+}
+
+void LineReader::init(const char *dataParam, qint64 sizeParam, qint64 offset)
+{
+  data = dataParam;
+  size = sizeParam;
+  seek(offset);
+
+  // Skip UTF-8 BOM
+  if(pos == 0 && size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    pos = 3;
+}
+
+void LineReader::close()
+{
+  if(mapped != nullptr && mappedFile != nullptr && mappedFile->isOpen())
+    mappedFile->unmap(mapped);
+  mapped = nullptr;
+  mappedFile = nullptr;
+  loaded.clear();
+  data = nullptr;
+  size = pos = 0;
+}
+
+bool LineReader::readLine(QByteArray& line)
+{
+  if(pos >= size)
+  {
+    line.clear();
+    return false;
+  }
+
+  const char *start = data + pos;
+  const char *end = static_cast<const char *>(std::memchr(start, '\n', static_cast<size_t>(size - pos)));
+
+  qint64 length;
+  if(end != nullptr)
+  {
+    length = end - start;
+    pos += length + 1;
+  }
+  else
+  {
+    // Last line without line feed
+    length = size - pos;
+    pos = size;
+  }
+
+  if(length > 0 && start[length - 1] == '\r')
+    length--;
+
+  // Does not copy
+  line = QByteArray::fromRawData(start, static_cast<int>(length));
+  return true;
+}
+
+bool LineReader::readLine(QString& line)
+{
+  QByteArray bytes;
+  bool retval = readLine(bytes);
+  toString(bytes, line);
+  return retval;
+}
+
+void LineReader::toString(const QByteArray& bytes, QString& str)
+{
+  const char *chars = bytes.constData();
+  int length = bytes.size();
+
+  for(int i = 0; i < length; i++)
+  {
+    if(static_cast<uchar>(chars[i]) >= 0x80)
+    {
+      str = QString::fromUtf8(chars, length);
+      return;
+    }
+  }
+
+  // Pure ASCII - copy into existing buffer
+  str.resize(length);
+  QChar *dest = str.data();
+  for(int i = 0; i < length; i++)
+    dest[i] = QLatin1Char(chars[i]);
+}
+
+} // namespace io
+} // namespace atools
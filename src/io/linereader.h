@@ -0,0 +1,99 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_IO_LINEREADER_H
+#define ATOOLS_IO_LINEREADER_H
+
+#include <QByteArray>
+
+#include <algorithm>
+
+class QFile;
+class QString;
+
+namespace atools {
+namespace io {
+
+/*
+ * Reads lines of UTF-8 or ASCII text files without decoding them into QString.
+ * Maps the file into memory or uses a byte array which was already loaded.
+ *
+ * Lines are returned as byte arrays referencing the mapped memory without copying. These are valid
+ * as long as the reader and the file or byte array exist. Use toString() to convert only the lines or fields
+ * which are actually needed.
+ *
+ * Trailing "\n" and "\r\n" are removed. A UTF-8 byte order mark at the start of the file is skipped.
+ */
+class LineReader
+{
+public:
+  LineReader();
+  ~LineReader();
+
+  LineReader(const LineReader& other) = delete;
+  LineReader& operator=(const LineReader& other) = delete;
+
+  /* Map an open file and start reading at byte offset. Reads the whole file into memory if mapping fails.
+   * File has to stay open while reading. Returns false if the file could not be read. */
+  bool open(QFile *file, qint64 offset = 0);
+
+  /* Read from data starting at byte offset. data has to exist while reading. */
+  void setData(const QByteArray& data, qint64 offset = 0);
+
+  /* Get next line. Returns false if at end. */
+  bool readLine(QByteArray& line);
+
+  /* Get next line converted to a string. Returns false if at end. */
+  bool readLine(QString& line);
+
+  bool atEnd() const
+  {
+    return pos >= size;
+  }
+
+  /* Current byte offset */
+  qint64 getPos() const
+  {
+    return pos;
+  }
+
+  /* Continue reading at byte offset */
+  void seek(qint64 offset)
+  {
+    pos = std::min(std::max(offset, Q_INT64_C(0)), size);
+  }
+
+  /* Convert UTF-8 bytes to string. Reuses the buffer of str and avoids the decoder for pure ASCII. */
+  static void toString(const QByteArray& bytes, QString& str);
+
+private:
+  void init(const char *dataParam, qint64 sizeParam, qint64 offset);
+  void close();
+
+  QFile *mappedFile = nullptr;
+  uchar *mapped = nullptr;
+  QByteArray loaded;
+
+  const char *data = nullptr;
+  qint64 size = 0, pos = 0;
+};
+
+} // namespace io
+} // namespace atools
+
+#endif // ATOOLS_IO_LINEREADER_H
@@ -56,6 +56,7 @@ LoggingConfig::LoggingConfig(const QString& logConfiguration, const QString& log
 
   // Read general parameters
   readConfigurationSection(settings);
+  readRateLimits(settings);
 
   QHash<QString, Channel *> channelMap;
   // Create all file streams and add them to the channelMap
@@ -298,6 +299,13 @@ void LoggingConfig::readConfigurationSection(QSettings *settings)
   narrow = settings->value("configuration/narrow").toBool();
 #endif
 
+  async = settings->value("configuration/async").toBool();
+  flushIntervalMs = settings->value("configuration/flushinterval", 500).toInt();
+
+  rateLimit = settings->value("configuration/ratelimit").toInt();
+  rateLimitIntervalMs = settings->value("configuration/ratelimitinterval", 10000).toInt();
+  rateSample = settings->value("configuration/ratesample").toInt();
+
   QString filesParameter = settings->value("configuration/files").toString();
   if(filesParameter == "truncate" || filesParameter == "roll")
     fileOpenMode = QIODevice::WriteOnly | QIODevice::Text;
@@ -328,6 +336,21 @@ void LoggingConfig::readConfigurationSection(QSettings *settings)
                << "use either warning, critical or fatal (default).";
 }
 
+void LoggingConfig::readRateLimits(QSettings *settings)
+{
+  settings->beginGroup("ratelimit");
+  const QStringList keys = settings->allKeys();
+  for(const QString& key : keys)
+  {
+    int limit = settings->value(key).toInt();
+    if(limit > 0)
+      categoryRateLimits.insert(key, limit);
+    else
+      qWarning() << "Invalid value for ratelimit/" << key << ":" << settings->value(key).toString();
+  }
+  settings->endGroup();
+}
+
 void LoggingConfig::readChannels(QSettings *settings, QHash<QString, Channel *>& channelMap)
 {
   settings->beginGroup("channels");
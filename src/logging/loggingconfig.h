@@ -32,6 +32,8 @@ namespace logging {
 class LoggingHandler;
 namespace internal {
 
+class LoggingWriter;
+
 /* Internal logging class that reads the configuration and sets up all the
  * streams. */
 class LoggingConfig
@@ -45,6 +47,7 @@ public:
 
 private:
   friend class atools::logging::LoggingHandler;
+  friend class atools::logging::internal::LoggingWriter;
 
   /* get a list of log files (excluding stdout and stderr) */
   QStringList getLogFiles() const;
@@ -98,6 +101,13 @@ private:
   int readFilesMaxParameter(QSettings *settings) const;
   void readConfigurationSection(QSettings *settings);
 
+  /* Read category limits
+   *
+   * [ratelimit]
+   * category = 100
+   */
+  void readRateLimits(QSettings *settings);
+
   void closeStreams(QSet<Channel *>& channels, const ChannelMap& channelMap);
 
   void closeStreams(QSet<Channel *>& channels, const ChannelVector& channelVector);
@@ -120,6 +130,14 @@ private:
   /* Shorten file and method names if true. */
   bool narrow = false;
 
+  /* Write in background thread if true. Flushes after each interval. */
+  bool async = false;
+  int flushIntervalMs = 500;
+
+  /* Rate limits. Disabled if call site limit is 0 and no category limits are given. */
+  int rateLimit = 0, rateLimitIntervalMs = 10000, rateSample = 0;
+  QHash<QString, int> categoryRateLimits;
+
   QString logConfig, logDir, logPrefix;
 
   // Messages of this type or worse cause a call to abort()
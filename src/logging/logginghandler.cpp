@@ -17,6 +17,8 @@
 
 #include "logging/logginghandler.h"
 #include "logging/loggingconfig.h"
+#include "logging/loggingwriter.h"
+#include "logging/loggingratelimiter.h"
 
 #include <QDebug>
 #include <QDir>
@@ -45,6 +47,16 @@ LoggingHandler::LoggingHandler(const QString& logConfiguration,
 {
   logConfig = new LoggingConfig(logConfiguration, logDirectory, logFilePrefix);
 
+  if(logConfig->rateLimit > 0 || !logConfig->categoryRateLimits.isEmpty())
+    rateLimiter = new internal::LoggingRateLimiter(logConfig->rateLimit, logConfig->rateLimitIntervalMs,
+                                                   logConfig->rateSample, logConfig->categoryRateLimits);
+
+  if(logConfig->async)
+  {
+    writer = new internal::LoggingWriter(logConfig, logConfig->flushIntervalMs);
+    writer->start(QThread::LowPriority);
+  }
+
   // Override category filter since some systems disable debug logging in the qtlogging.ini
   oldCategoryFilter = QLoggingCategory::installFilter(categoryFilter);
 
@@ -59,6 +71,19 @@ LoggingHandler::~LoggingHandler()
 {
   qInstallMessageHandler(oldMessageHandler);
   QLoggingCategory::installFilter(oldCategoryFilter);
+
+  // Report messages dropped in the last interval
+  if(rateLimiter != nullptr)
+  {
+    internal::ChannelMap noCategories;
+    const QStringList summaries = rateLimiter->takeSummaries();
+    for(const QString& summary : summaries)
+      logToCatChannels(noCategories, logConfig->getStream(QtInfoMsg), summary);
+    delete rateLimiter;
+  }
+
+  // Write all pending messages before closing the streams
+  delete writer;
   delete logConfig;
 }
 
@@ -122,6 +147,23 @@ const QStringList LoggingHandler::getLogFiles()
 void LoggingHandler::logToCatChannels(internal::ChannelMap& streamListCat,
                                       internal::ChannelVector& streamList, const QString& message, const QString& category)
 {
+  if(writer != nullptr)
+  {
+    // Queue message and return without waiting for the write
+    if(category.isEmpty())
+    {
+      if(!streamList.isEmpty())
+        writer->enqueue(streamList, message);
+    }
+    else
+    {
+      internal::ChannelMap::const_iterator it = streamListCat.constFind(category);
+      if(it != streamListCat.constEnd() && !it.value().isEmpty())
+        writer->enqueue(it.value(), message);
+    }
+    return;
+  }
+
   QMutexLocker locker(&instance->mutex);
 
   if(category.isEmpty())
@@ -165,6 +207,10 @@ void LoggingHandler::checkAbortType(QtMsgType type, const QMessageLogContext& co
       break;
   }
 
+  // Qt terminates after fatal messages in any case - write everything before
+  if(writer != nullptr && (doAbort || type == QtFatalMsg))
+    writer->flush();
+
   if(doAbort)
   {
     if(abortFunc)
@@ -174,10 +220,37 @@ void LoggingHandler::checkAbortType(QtMsgType type, const QMessageLogContext& co
   }
 }
 
+bool LoggingHandler::checkRateLimit(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+  static const QLatin1String DEFAULT("default");
+
+  QString summary;
+  if(!rateLimiter->check(type, context, summary))
+  {
+    // Dropped - abort anyway if configured
+    checkAbortType(type, context, msg);
+    return false;
+  }
+
+  if(!summary.isEmpty())
+  {
+    QString category = context.category;
+    if(category == DEFAULT)
+      category.clear();
+
+    logToCatChannels(logConfig->getCatStream(type), logConfig->getStream(type),
+                     qFormatLogMessage(type, context, summary), category);
+  }
+  return true;
+}
+
 void LoggingHandler::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
 {
   static const QLatin1String DEFAULT("default");
 
+  if(instance->rateLimiter != nullptr && !instance->checkRateLimit(type, context, msg))
+    return;
+
   if(logFunc)
     logFunc(type, context, msg);
 
@@ -200,6 +273,10 @@ void LoggingHandler::messageHandlerNarrow(QtMsgType type, const QMessageLogConte
   static const QLatin1String VIRTUAL("virtual ");
   static const QLatin1String DEFAULT("default");
 
+  // Check with original context since file and category strings are used as keys
+  if(instance->rateLimiter != nullptr && !instance->checkRateLimit(type, context, msg))
+    return;
+
   QString message = msg;
   QString function(context.function);
   QString file(context.file);
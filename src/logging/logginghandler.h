@@ -34,6 +34,8 @@ namespace atools {
 namespace logging {
 namespace internal {
 class LoggingConfig;
+class LoggingWriter;
+class LoggingRateLimiter;
 }
 
 class LoggingGuiAbortHandler;
@@ -54,6 +56,11 @@ class LoggingGuiAbortHandler;
  * files = roll
  * maxfiles = 2
  * abort = fatal
+ * async = true
+ * flushinterval = 500
+ * ratelimit = 200
+ * ratelimitinterval = 10000
+ * ratesample = 100
  *
  * [channels]
  * console     = stdio
@@ -67,6 +74,17 @@ class LoggingGuiAbortHandler;
  * critical.default = console-err,log
  * fatal.default    = console-err,log
  *
+ * [ratelimit]
+ * gui = 50
+ *
+ * ratelimit is the maximum number of messages from one source line within ratelimitinterval milliseconds.
+ * Keys in [ratelimit] limit messages per category in the same way. Messages above the limit are dropped
+ * except every ratesample-th message. The number of dropped messages is logged once the interval has passed.
+ * Critical and fatal messages are never dropped. Rate limiting is disabled by default.
+ *
+ * async = true moves writing into a background thread. The calling thread only queues the formatted message.
+ * Messages are written in batches and flushed every flushinterval milliseconds. All pending messages are
+ * written before aborting and on shutdown.
  */
 class LoggingHandler :
   public QObject
@@ -148,6 +166,9 @@ private:
 
   void checkAbortType(QtMsgType type, const QMessageLogContext& context, const QString& msg);
 
+  /* Returns false if the message has to be dropped due to rate limits. Logs summary of dropped messages. */
+  bool checkRateLimit(QtMsgType type, const QMessageLogContext& context, const QString& msg);
+
   static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg);
   static void messageHandlerNarrow(QtMsgType type, const QMessageLogContext& context, const QString& msg);
   static void categoryFilter(QLoggingCategory *category);
@@ -156,6 +177,12 @@ private:
   static LoggingHandler *instance;
 
   atools::logging::internal::LoggingConfig *logConfig;
+
+  /* Background writer or null if logging synchronously */
+  atools::logging::internal::LoggingWriter *writer = nullptr;
+
+  /* Null if rate limiting is disabled */
+  atools::logging::internal::LoggingRateLimiter *rateLimiter = nullptr;
   QtMessageHandler oldMessageHandler = nullptr;
   QLoggingCategory::CategoryFilter oldCategoryFilter = nullptr;
 
@@ -0,0 +1,124 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "logging/loggingratelimiter.h"
+
+#include <QFileInfo>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+LoggingRateLimiter::LoggingRateLimiter(int callsiteLimit, int intervalMs, int sampleRate,
+                                       const QHash<QString, int>& categoryLimits)
+  : callsiteLimit(callsiteLimit), interval(intervalMs), sampleRate(sampleRate), categoryLimits(categoryLimits)
+{
+  timer.start();
+}
+
+bool LoggingRateLimiter::check(QtMsgType type, const QMessageLogContext& context, QString& summary)
+{
+  if(type == QtCriticalMsg || type == QtFatalMsg)
+    return true;
+
+  QMutexLocker locker(&mutex);
+  qint64 now = timer.elapsed();
+  bool allow = true;
+
+  if(callsiteLimit > 0 && context.file != nullptr)
+  {
+    Counter& counter = callsites[qMakePair(reinterpret_cast<quintptr>(context.file), context.line)];
+    if(counter.limit == -1)
+    {
+      counter.limit = callsiteLimit;
+      counter.name = QFileInfo(context.file).fileName() + ":" + QString::number(context.line);
+    }
+    allow = count(counter, now, summary);
+  }
+
+  if(allow && context.category != nullptr && !categoryLimits.isEmpty())
+  {
+    Counter& counter = categories[reinterpret_cast<quintptr>(context.category)];
+    if(counter.limit == -1)
+    {
+      counter.name = QString("category ") + context.category;
+      counter.limit = categoryLimits.value(context.category, 0);
+    }
+
+    if(counter.limit > 0)
+      allow = count(counter, now, summary);
+  }
+  return allow;
+}
+
+bool LoggingRateLimiter::count(Counter& counter, qint64 now, QString& summary)
+{
+  if(now - counter.windowStart >= interval)
+  {
+    // Window passed - report and start a new one
+    if(counter.suppressed > 0)
+    {
+      if(!summary.isEmpty())
+        summary.append("; ");
+      summary.append(summaryText(counter));
+    }
+    counter.windowStart = now;
+    counter.count = 0;
+    counter.suppressed = 0;
+  }
+
+  counter.count++;
+  if(counter.count <= counter.limit)
+    return true;
+
+  // Above limit - let every n-th pass if sampling
+  if(sampleRate > 0 && (counter.count - counter.limit) % sampleRate == 0)
+    return true;
+
+  counter.suppressed++;
+  return false;
+}
+
+QString LoggingRateLimiter::summaryText(const Counter& counter) const
+{
+  return QString("Suppressed %1 log messages from %2 exceeding %3 per %4 ms").
+         arg(counter.suppressed).arg(counter.name).arg(counter.limit).arg(interval);
+}
+
+QStringList LoggingRateLimiter::takeSummaries()
+{
+  QMutexLocker locker(&mutex);
+  QStringList summaries;
+  for(Counter& counter : callsites)
+  {
+    if(counter.suppressed > 0)
+      summaries.append(summaryText(counter));
+    counter.suppressed = 0;
+  }
+
+  for(Counter& counter : categories)
+  {
+    if(counter.suppressed > 0)
+      summaries.append(summaryText(counter));
+    counter.suppressed = 0;
+  }
+  return summaries;
+}
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
@@ -0,0 +1,93 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_LOGGING_LOGGINGRATELIMITER_H
+#define ATOOLS_LOGGING_LOGGINGRATELIMITER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+/*
+ * Limits the number of messages per call site (source file and line) and per category within a time window.
+ *
+ * Messages exceeding the limit are dropped. If a sample rate is given every n-th message above the
+ * limit is still logged. The number of dropped messages is reported once the window of the call site or category
+ * has passed and the next message arrives, or on shutdown.
+ *
+ * Critical and fatal messages are never limited.
+ *
+ * Thread safe.
+ */
+class LoggingRateLimiter
+{
+public:
+  /*
+   * @param callsiteLimit Maximum messages per call site and window. 0 to disable.
+   * @param intervalMs Window length in milliseconds
+   * @param sampleRate Log every n-th message above the limit. 0 to drop all.
+   * @param categoryLimits Maximum messages per window by category name
+   */
+  LoggingRateLimiter(int callsiteLimit, int intervalMs, int sampleRate, const QHash<QString, int>& categoryLimits);
+
+  LoggingRateLimiter(const LoggingRateLimiter& other) = delete;
+  LoggingRateLimiter& operator=(const LoggingRateLimiter& other) = delete;
+
+  /*
+   * Count message and decide if it can be logged.
+   * @param summary Set to a note about dropped messages of the last window which should be logged first.
+   * @return false if message has to be dropped.
+   */
+  bool check(QtMsgType type, const QMessageLogContext& context, QString& summary);
+
+  /* Get notes for all call sites and categories having dropped messages and reset counts */
+  QStringList takeSummaries();
+
+private:
+  struct Counter
+  {
+    QString name;
+    int limit = -1; /* -1 if not resolved yet */
+    qint64 windowStart = 0;
+    int count = 0, suppressed = 0;
+  };
+
+  /* Count message for counter. Appends note to summary if a window with dropped messages ended. */
+  bool count(Counter& counter, qint64 now, QString& summary);
+  QString summaryText(const Counter& counter) const;
+
+  int callsiteLimit, interval, sampleRate;
+  QHash<QString, int> categoryLimits;
+
+  /* Keys are the addresses of the static file and category name strings. No string hashing needed. */
+  QHash<QPair<quintptr, int>, Counter> callsites;
+  QHash<quintptr, Counter> categories;
+
+  QElapsedTimer timer;
+  QMutex mutex;
+};
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
+
+#endif // ATOOLS_LOGGING_LOGGINGRATELIMITER_H
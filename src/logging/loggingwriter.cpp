@@ -0,0 +1,132 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "logging/loggingwriter.h"
+#include "logging/loggingconfig.h"
+
+#include <QTextStream>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+LoggingWriter::LoggingWriter(LoggingConfig *loggingConfig, int flushIntervalMs)
+  : config(loggingConfig), flushInterval(flushIntervalMs), head(nullptr), stopRequested(false)
+{
+  setObjectName("LoggingWriter");
+}
+
+LoggingWriter::~LoggingWriter()
+{
+  stop();
+}
+
+void LoggingWriter::enqueue(const ChannelVector& channels, const QString& text)
+{
+  LogMessage *message = new LogMessage({nullptr, channels, text});
+
+  // Push to the front of the list
+  LogMessage *oldHead = head.load(std::memory_order_relaxed);
+  do
+  {
+    message->next = oldHead;
+  } while(!head.compare_exchange_weak(oldHead, message, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void LoggingWriter::flush()
+{
+  // Writer thread is already busy writing - locking again would dead lock
+  if(QThread::currentThread() == this)
+    return;
+
+  QMutexLocker locker(&writeMutex);
+  writeQueue();
+}
+
+void LoggingWriter::stop()
+{
+  if(isRunning())
+  {
+    waitMutex.lock();
+    stopRequested.store(true);
+    waitCondition.wakeAll();
+    waitMutex.unlock();
+    wait();
+  }
+
+  // Write anything which arrived after the last batch
+  flush();
+}
+
+void LoggingWriter::run()
+{
+  while(!stopRequested.load())
+  {
+    waitMutex.lock();
+    if(!stopRequested.load())
+      waitCondition.wait(&waitMutex, static_cast<unsigned long>(flushInterval));
+    waitMutex.unlock();
+
+    QMutexLocker locker(&writeMutex);
+    writeQueue();
+  }
+}
+
+void LoggingWriter::writeQueue()
+{
+  // Take all messages at once
+  LogMessage *message = head.exchange(nullptr, std::memory_order_acquire);
+  if(message == nullptr)
+    return;
+
+  // Reverse list to get messages in order of arrival
+  LogMessage *ordered = nullptr;
+  while(message != nullptr)
+  {
+    LogMessage *next = message->next;
+    message->next = ordered;
+    ordered = message;
+    message = next;
+  }
+
+  // Write without flushing and remember channels
+  ChannelVector touched;
+  while(ordered != nullptr)
+  {
+    for(Channel *channel : qAsConst(ordered->channels))
+    {
+      (*channel->stream) << ordered->text << '\n';
+      if(!touched.contains(channel))
+        touched.append(channel);
+    }
+
+    LogMessage *next = ordered->next;
+    delete ordered;
+    ordered = next;
+  }
+
+  // Flush once per channel and roll files if needed
+  for(Channel *channel : qAsConst(touched))
+  {
+    channel->stream->flush();
+    config->checkStreamSize(channel);
+  }
+}
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
@@ -0,0 +1,95 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_LOGGING_LOGGINGWRITER_H
+#define ATOOLS_LOGGING_LOGGINGWRITER_H
+
+#include "logging/loggingtypes.h"
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+class LoggingConfig;
+
+/* Formatted message and its target channels in the queue */
+struct LogMessage
+{
+  LogMessage *next;
+  ChannelVector channels;
+  QString text;
+};
+
+/*
+ * Background thread for asynchronous logging.
+ *
+ * Logging threads push messages into a lock-free list and return immediately. The writer takes all pending
+ * messages at once every flush interval, writes them in order and flushes each touched channel only once
+ * per batch. File size limits and rolling are checked after each batch.
+ */
+class LoggingWriter :
+  public QThread
+{
+public:
+  LoggingWriter(LoggingConfig *loggingConfig, int flushIntervalMs);
+  virtual ~LoggingWriter() override;
+
+  LoggingWriter(const LoggingWriter& other) = delete;
+  LoggingWriter& operator=(const LoggingWriter& other) = delete;
+
+  /* Add message to the queue. Lock-free and can be called from any thread. */
+  void enqueue(const ChannelVector& channels, const QString& text);
+
+  /* Write and flush all queued messages in the calling thread. Used before aborting.
+   * Does nothing if called from the writer thread itself. */
+  void flush();
+
+  /* Stop thread and write all remaining messages */
+  void stop();
+
+private:
+  virtual void run() override;
+
+  /* Take all messages and write them. Called with writeMutex locked. */
+  void writeQueue();
+
+  LoggingConfig *config;
+  int flushInterval;
+
+  /* Newest message first */
+  std::atomic<LogMessage *> head;
+  std::atomic_bool stopRequested;
+
+  /* Serializes writing between writer thread and flush() */
+  QMutex writeMutex;
+
+  /* Used to wake the writer thread on stop */
+  QMutex waitMutex;
+  QWaitCondition waitCondition;
+};
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
+
+#endif // ATOOLS_LOGGING_LOGGINGWRITER_H
@@ -0,0 +1,131 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routebenchmark.h"
+
+#include "geo/calculations.h"
+#include "sql/sqlquery.h"
+
+#include <QStringBuilder>
+
+using atools::sql::SqlQuery;
+
+namespace atools {
+namespace routing {
+
+RouteBenchmark::RouteBenchmark(sql::SqlDatabase *sqlDbNav, const RouteNetwork *routeNetwork)
+  : db(sqlDbNav), network(routeNetwork)
+{
+}
+
+RouteBenchmark::~RouteBenchmark()
+{
+}
+
+QVector<RouteBenchmarkPair> RouteBenchmark::defaultPairs()
+{
+  return {
+    {"EDDF", "EDDM"}, // Short domestic
+    {"KLAX", "KSFO"},
+    {"EGLL", "LEMD"}, // Continental
+    {"KJFK", "KMIA"},
+    {"LFPG", "LTFM"},
+    {"EDDF", "KJFK"}, // Transatlantic - tracks if loaded
+    {"EGLL", "KORD"},
+    {"KSFO", "RJTT"}, // Transpacific
+    {"YSSY", "NZAA"},
+    {"EDDM", "VHHH"}, // Long haul over land
+    {"OMDB", "FAOR"},
+    {"SBGR", "SCEL"}
+  };
+}
+
+QVector<RouteBenchmarkResult> RouteBenchmark::run(const QVector<RouteBenchmarkPair>& pairs, int flownAltitude,
+                                                  Modes mode, int repetitions)
+{
+  QVector<RouteBenchmarkResult> results;
+  RouteFinder finder(network);
+  finder.setLandmarks(landmarks);
+
+  QVector<RouteLeg> legs;
+  for(const RouteBenchmarkPair& pair : pairs)
+  {
+    atools::geo::Pos from = airportPos(pair.from), to = airportPos(pair.to);
+    if(!from.isValid() || !to.isValid())
+    {
+      qWarning() << Q_FUNC_INFO << "Airport not found for" << pair.from << pair.to;
+      continue;
+    }
+
+    RouteBenchmarkResult result;
+    result.pair = pair;
+    for(int i = 0; i < std::max(repetitions, 1); i++)
+    {
+      finder.calculateRoute(from, to, flownAltitude, mode);
+
+      // Keep fastest run
+      if(i == 0 || finder.getStats().totalMicroSec < result.stats.totalMicroSec)
+        result.stats = finder.getStats();
+    }
+
+    if(result.stats.found)
+    {
+      finder.extractLegs(legs, result.distanceMeter);
+      result.numLegs = legs.size();
+    }
+
+    qDebug() << Q_FUNC_INFO << pair.from << pair.to << result.stats;
+    results.append(result);
+  }
+  return results;
+}
+
+QString RouteBenchmark::toCsv(const QVector<RouteBenchmarkResult>& results)
+{
+  QString csv("from,to,found,legs,distance_nm,expanded,heap_pushes,heap_updates,neighbour_lookups,"
+              "nearest_queries,successors,init_us,search_us,total_us\n");
+
+  for(const RouteBenchmarkResult& result : results)
+  {
+    const RouteFinderStats& stats = result.stats;
+    csv.append(result.pair.from % ',' % result.pair.to % ',' % QString::number(stats.found) % ',' %
+               QString::number(result.numLegs) % ',' %
+               QString::number(atools::geo::meterToNm(result.distanceMeter), 'f', 1) % ',' %
+               QString::number(stats.expandedNodes) % ',' % QString::number(stats.heapPushes) % ',' %
+               QString::number(stats.heapUpdates) % ',' % QString::number(stats.neighbourLookups) % ',' %
+               QString::number(stats.nearestQueries) % ',' % QString::number(stats.successors) % ',' %
+               QString::number(stats.initMicroSec) % ',' % QString::number(stats.searchMicroSec) % ',' %
+               QString::number(stats.totalMicroSec) % '\n');
+  }
+  return csv;
+}
+
+atools::geo::Pos RouteBenchmark::airportPos(const QString& ident) const
+{
+  SqlQuery query(db);
+  query.prepare("select lonx, laty from airport where ident = :ident");
+  query.bindValue(":ident", ident);
+  query.exec();
+
+  atools::geo::Pos pos;
+  if(query.next())
+    pos = atools::geo::Pos(query.valueFloat("lonx"), query.valueFloat("laty"));
+  return pos;
+}
+
+} // namespace routing
+} // namespace atools
@@ -0,0 +1,86 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTEBENCHMARK_H
+#define ATOOLS_ROUTEBENCHMARK_H
+
+#include "routing/routefinder.h"
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace routing {
+
+/* Departure and destination airport idents for a benchmark run */
+struct RouteBenchmarkPair
+{
+  QString from, to;
+};
+
+/* Result of one pair. Stats contain the fastest of all repetitions. */
+struct RouteBenchmarkResult
+{
+  atools::routing::RouteBenchmarkPair pair;
+  atools::routing::RouteFinderStats stats;
+  float distanceMeter = 0.f;
+  int numLegs = 0;
+};
+
+/*
+ * Replays a fixed set of airport pairs against a loaded network and collects RouteFinder statistics.
+ * Use to detect performance regressions of the routing between releases on the same navdata.
+ *
+ * Airports are resolved by ident from table airport in the navdata database.
+ */
+class RouteBenchmark
+{
+public:
+  RouteBenchmark(atools::sql::SqlDatabase *sqlDbNav, const atools::routing::RouteNetwork *routeNetwork);
+  ~RouteBenchmark();
+
+  /* Fixed set of short, continental, transatlantic and transpacific city pairs */
+  static QVector<atools::routing::RouteBenchmarkPair> defaultPairs();
+
+  /* Calculate all pairs repetitions times. Pairs with unknown airports are skipped and logged. */
+  QVector<atools::routing::RouteBenchmarkResult> run(const QVector<atools::routing::RouteBenchmarkPair>& pairs,
+                                                     int flownAltitude, atools::routing::Modes mode,
+                                                     int repetitions = 1);
+
+  /* Convert results to CSV with header line for simple comparison */
+  static QString toCsv(const QVector<atools::routing::RouteBenchmarkResult>& results);
+
+  /* Passed to RouteFinder */
+  void setLandmarks(const atools::routing::RouteLandmarks *value)
+  {
+    landmarks = value;
+  }
+
+private:
+  /* Position of airport by ident or invalid if not found */
+  atools::geo::Pos airportPos(const QString& ident) const;
+
+  atools::sql::SqlDatabase *db;
+  const atools::routing::RouteNetwork *network;
+  const atools::routing::RouteLandmarks *landmarks = nullptr;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTEBENCHMARK_H
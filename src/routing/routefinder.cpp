@@ -17,13 +17,18 @@
 
 #include "routing/routefinder.h"
 
+#include "routing/routelandmarks.h"
 #include "routing/routenetwork.h"
 #include "routing/routenetworkloader.h"
+#include "routing/routewindcosts.h"
 #include "atools.h"
 #include "geo/calculations.h"
+#include "util/metrics.h"
+#include "util/tracing.h"
 
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QSet>
 
 using atools::geo::Pos;
 
@@ -37,8 +42,19 @@ inline TYPE& at(TYPE *arr, int index)
   return arr[index + 3];
 }
 
-RouteFinder::RouteFinder(RouteNetwork *routeNetwork)
-  : network(routeNetwork), openNodesHeap(10000)
+/* Convert node index to heap key and back. Same offset as in at() */
+inline int heapKey(int index)
+{
+  return index + 3;
+}
+
+inline int heapIndex(int key)
+{
+  return key - 3;
+}
+
+RouteFinder::RouteFinder(const RouteNetwork *routeNetwork)
+  : network(routeNetwork)
 {
   successors.reserve(500);
 }
@@ -51,56 +67,370 @@ RouteFinder::~RouteFinder()
 bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude,
                                  atools::routing::Modes mode)
 {
+  ATOOLS_TRACE_SPAN("routing", "RouteFinder::calculateRoute");
   qDebug() << Q_FUNC_INFO << "from" << from << "to" << to << "altitude" << flownAltitude << "mode" << mode;
 
-  allocArrays();
-
   QElapsedTimer timer;
   timer.start();
+  stats.clear();
+
+  bool bidirectional = mode.testFlag(MODE_BIDIRECTIONAL);
+  initSearch(from, to, flownAltitude, mode);
+  stats.initMicroSec = timer.nsecsElapsed() / 1000L;
+
+  bool destinationFound = false;
+  if(bidirectional)
+    destinationFound = calculateRouteBidirectional();
+  else
+  {
+    Node currentNode;
+    while(!forward.openNodesHeap.isEmpty())
+    {
+      // Contains known nodes
+      int currentIndex = heapIndex(forward.openNodesHeap.popData());
+
+      if(currentIndex == destNode.index)
+      {
+        destinationFound = true;
+        break;
+      }
+
+      currentNode = network->getNode(query, currentIndex);
+
+      // Invoke user callback if set
+      if(!invokeCallback(currentNode))
+        break;
+
+      // Contains nodes with known shortest path
+      at(forward.closedNodes, currentNode.index) = true;
+
+      // Work on successors
+      if(!expandNode(forward, currentNode, at(forward.edgePredecessorArr, currentNode.index), false /* reverse */))
+        break;
+    }
+  }
+
+  stats.searchMicroSec = timer.nsecsElapsed() / 1000L - stats.initMicroSec;
+
+  if(destinationFound)
+    storePath();
+  else
+    previousPath.clear();
+
+  stats.totalMicroSec = timer.nsecsElapsed() / 1000L;
+  stats.found = destinationFound;
+
+  static atools::util::MetricCounter& queryCounter =
+    atools::util::Metrics::instance().counter("atools_routing_queries_total", "Route calculations");
+  static atools::util::MetricCounter& notFoundCounter =
+    atools::util::Metrics::instance().counter("atools_routing_not_found_total", "Route calculations without result");
+  static atools::util::MetricCounter& expandedCounter =
+    atools::util::Metrics::instance().counter("atools_routing_expanded_nodes_total", "Nodes expanded by route search");
+  static atools::util::MetricHistogram& durationHistogram =
+    atools::util::Metrics::instance().histogram("atools_routing_duration_seconds", "Time for route calculation");
+  queryCounter.increment();
+  if(!destinationFound)
+    notFoundCounter.increment();
+  expandedCounter.increment(stats.expandedNodes);
+  durationHistogram.observe(stats.totalMicroSec / 1.e6);
+
+  qDebug() << Q_FUNC_INFO << "found" << destinationFound << "heap size" << forward.openNodesHeap.size()
+           << "backward heap size" << backward.openNodesHeap.size() << stats;
+
+  return destinationFound;
+}
+
+void RouteFinder::initSearch(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude,
+                             atools::routing::Modes mode)
+{
+  allocArrays(mode.testFlag(MODE_BIDIRECTIONAL));
 
   altitude = flownAltitude;
-  network->setParameters(from, to, altitude, mode);
-  startNode = network->getDepartureNode();
-  destNode = network->getDestinationNode();
+  query = network->createQuery(from, to, altitude, mode);
+  startNode = query.departureNode;
+  destNode = query.destinationNode;
   totalDist = atools::roundToInt(network->getDirectDistanceMeter(startNode, destNode));
   lastDist = totalDist;
 
-  openNodesHeap.pushData(startNode.index, 0);
-  at(nodeAltRangeMaxArr, startNode.index) = std::numeric_limits<quint16>::max();
+  // Landmark distances are along airways only
+  useLandmarks = landmarks != nullptr && landmarks->isValid() && network->isAirwayRouting() &&
+                 !mode.testFlag(MODE_WAYPOINT);
+  if(useLandmarks)
+  {
+    startAnchorIndex = network->getNearestNode(from).index;
+    destAnchorIndex = network->getNearestNode(to).index;
+    useLandmarks = startAnchorIndex >= 0 && destAnchorIndex >= 0;
+
+    if(useLandmarks)
+    {
+      startAnchorDist = atools::roundToInt(network->getGcDistanceMeter(startNode,
+                                                                       network->getNode(query, startAnchorIndex)));
+      destAnchorDist = atools::roundToInt(network->getGcDistanceMeter(network->getNode(query, destAnchorIndex),
+                                                                      destNode));
+    }
+  }
+
+  useWindCosts = windCosts != nullptr && windCosts->isValid();
+  windEstimateFactor = useWindCosts ? windCosts->getMinTimeFactor() : 1.f;
+
+  forward.openNodesHeap.pushData(heapKey(startNode.index), 0);
+  at(forward.nodeAltRangeMaxArr, startNode.index) = std::numeric_limits<quint16>::max();
 
   time = QDateTime::currentSecsSinceEpoch();
+}
+
+bool RouteFinder::recalculateRoute(const atools::geo::Pos& from)
+{
+  if(previousPath.isEmpty())
+  {
+    qWarning() << Q_FUNC_INFO << "No previous route";
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << "from" << from;
+
+  QElapsedTimer timer;
+  timer.start();
+  stats.clear();
+
+  // Copy since arrays and path are overwritten by the search
+  const QVector<PathEntry> oldPath = previousPath;
+  atools::geo::Pos to = query.destinationNode.pos;
+  Modes mode = query.mode;
+  int flownAltitude = altitude;
+
+  // Collect nodes of the previous route which have an open path to the destination =======================
+  // Maps node index to the costs along the previous route from node to destination
+  QHash<int, int> joinCosts;
+  int destCost = oldPath.constLast().cost;
+  for(int i = oldPath.size() - 1; i > 0; i--)
+  {
+    // Edge at i leads from i - 1 to i
+    if(isEdgeClosed(oldPath.at(i).edge))
+      break;
+
+    const PathEntry& entry = oldPath.at(i - 1);
+    if(entry.index >= 0)
+      joinCosts.insert(entry.index, destCost - entry.cost);
+  }
+
+  // Forward search from the new position to the destination or to any join node ======================
+  // Backward search is not used since the destination tree part is taken from the previous route
+  Modes forwardMode(mode);
+  forwardMode.setFlag(MODE_BIDIRECTIONAL, false);
+  initSearch(from, to, flownAltitude, forwardMode);
+  stats.initMicroSec = timer.nsecsElapsed() / 1000L;
 
+  int bestCost = std::numeric_limits<int>::max(), bestJoinIndex = Node::INVALID_INDEX;
   Node currentNode;
-  bool destinationFound = false;
-  while(!openNodesHeap.isEmpty())
+  while(!forward.openNodesHeap.isEmpty())
   {
-    // Contains known nodes
-    int currentIndex = openNodesHeap.popData();
+    // Stop if no open node can lead to a cheaper route. Heap costs are a lower bound.
+    if(forward.openNodesHeap.topCost() >= bestCost)
+      break;
+
+    int currentIndex = heapIndex(forward.openNodesHeap.popData());
+    int currentCost = at(forward.nodeCostArr, currentIndex);
 
     if(currentIndex == destNode.index)
     {
-      destinationFound = true;
+      if(currentCost < bestCost)
+      {
+        bestCost = currentCost;
+        bestJoinIndex = currentIndex;
+      }
       break;
     }
 
-    currentNode = network->getNode(currentIndex);
+    // Check if previous route can be used from here
+    auto it = joinCosts.constFind(currentIndex);
+    if(it != joinCosts.constEnd() && currentCost + it.value() < bestCost)
+    {
+      bestCost = currentCost + it.value();
+      bestJoinIndex = currentIndex;
+    }
+
+    currentNode = network->getNode(query, currentIndex);
+
+    if(!invokeCallback(currentNode))
+    {
+      previousPath.clear();
+      return false;
+    }
+
+    at(forward.closedNodes, currentNode.index) = true;
+
+    if(!expandNode(forward, currentNode, at(forward.edgePredecessorArr, currentNode.index), false /* reverse */))
+    {
+      previousPath.clear();
+      return false;
+    }
+  }
+
+  if(bestJoinIndex == Node::INVALID_INDEX)
+  {
+    qDebug() << Q_FUNC_INFO << "not found" << timer.restart() << "ms";
+    previousPath.clear();
+    return false;
+  }
+
+  if(bestJoinIndex != destNode.index)
+  {
+    // Append the remaining part of the previous route to the predecessor arrays =======================
+    int joinPos = 0;
+    while(oldPath.at(joinPos).index != bestJoinIndex)
+      joinPos++;
+
+    int joinCost = at(forward.nodeCostArr, bestJoinIndex);
+    for(int i = joinPos + 1; i < oldPath.size(); i++)
+    {
+      const PathEntry& entry = oldPath.at(i);
+      at(forward.nodePredecessorArr, entry.index) = oldPath.at(i - 1).index;
+      at(forward.edgePredecessorArr, entry.index) = entry.edge;
+      at(forward.nodeCostArr, entry.index) = joinCost + entry.cost - oldPath.at(joinPos).cost;
+    }
+
+    // New part might cross the old part - fall back to a full calculation in this case
+    QSet<int> indexes;
+    for(int index = destNode.index; index != Node::INVALID_INDEX; index = at(forward.nodePredecessorArr, index))
+    {
+      if(indexes.contains(index))
+      {
+        qDebug() << Q_FUNC_INFO << "loop detected - full calculation";
+        return calculateRoute(from, to, flownAltitude, mode);
+      }
+      indexes.insert(index);
+    }
+  }
+
+  // Restore original mode for next calls
+  query.mode = mode;
+  storePath();
+
+  stats.totalMicroSec = timer.nsecsElapsed() / 1000L;
+  stats.searchMicroSec = stats.totalMicroSec - stats.initMicroSec;
+  stats.found = true;
+
+  qDebug() << Q_FUNC_INFO << "found joined at" << bestJoinIndex << "heap size" << forward.openNodesHeap.size()
+           << stats;
+  return true;
+}
+
+void RouteFinder::storePath()
+{
+  previousPath.clear();
+  for(int index = query.destinationNode.index; index != Node::INVALID_INDEX;
+      index = at(forward.nodePredecessorArr, index))
+    previousPath.prepend({index, at(forward.edgePredecessorArr, index), at(forward.nodeCostArr, index)});
+}
+
+bool RouteFinder::calculateRouteBidirectional()
+{
+  meetNodeIndex = Node::INVALID_INDEX;
+  meetCost = std::numeric_limits<int>::max();
+
+  backward.openNodesHeap.pushData(heapKey(destNode.index), 0);
+  at(backward.nodeAltRangeMaxArr, destNode.index) = std::numeric_limits<quint16>::max();
+
+  bool cancelled = false;
+  Node currentNode;
+  while(!forward.openNodesHeap.isEmpty() && !backward.openNodesHeap.isEmpty())
+  {
+    // Stop if no path through the open nodes of either search can be cheaper than the best one found so far
+    if(meetNodeIndex != Node::INVALID_INDEX &&
+       (forward.openNodesHeap.topCost() >= meetCost || backward.openNodesHeap.topCost() >= meetCost))
+      break;
+
+    // Continue with the search having less open nodes to keep both balanced
+    bool reverse = backward.openNodesHeap.size() < forward.openNodesHeap.size();
+    SearchDirection& dir = reverse ? backward : forward;
+
+    int currentIndex = heapIndex(dir.openNodesHeap.popData());
+    currentNode = network->getNode(query, currentIndex);
 
     // Invoke user callback if set
     if(!invokeCallback(currentNode))
+    {
+      cancelled = true;
       break;
+    }
 
     // Contains nodes with known shortest path
-    at(closedNodes, currentNode.index) = true;
+    at(dir.closedNodes, currentNode.index) = true;
 
-    // Work on successors
-    if(!expandNode(currentNode, at(edgePredecessorArr, currentNode.index)))
+    // Do not expand beyond the start of the other search
+    if(currentIndex == (reverse ? startNode.index : destNode.index))
+      continue;
+
+    // Work on successors or predecessors
+    if(!expandNode(dir, currentNode, at(dir.edgePredecessorArr, currentNode.index), reverse))
+    {
+      cancelled = true;
       break;
+    }
   }
 
-  qDebug() << Q_FUNC_INFO << "found" << destinationFound << "heap size" << openNodesHeap.size()
-           << timer.restart() << "ms";
+  if(cancelled || meetNodeIndex == Node::INVALID_INDEX)
+    return false;
 
-  return destinationFound;
+  return joinPaths();
+}
+
+void RouteFinder::updateMeetingNode(int index)
+{
+  if(isReached(forward, index, startNode) && isReached(backward, index, destNode))
+  {
+    // Altitude ranges of both path halves have to overlap
+    quint16 altRangeMin = at(forward.nodeAltRangeMinArr, index);
+    quint16 altRangeMax = at(forward.nodeAltRangeMaxArr, index);
+    if(combineRanges(altRangeMin, altRangeMax, at(backward.nodeAltRangeMinArr, index),
+                     at(backward.nodeAltRangeMaxArr, index)))
+    {
+      int cost = at(forward.nodeCostArr, index) + at(backward.nodeCostArr, index);
+      if(cost < meetCost)
+      {
+        meetCost = cost;
+        meetNodeIndex = index;
+      }
+    }
+  }
+}
+
+bool RouteFinder::isReached(const SearchDirection& dir, int index, const Node& searchStartNode) const
+{
+  return index == searchStartNode.index || at(dir.nodePredecessorArr, index) != Node::INVALID_INDEX;
+}
+
+bool RouteFinder::joinPaths()
+{
+  // Collect nodes of the forward path to detect loops
+  QSet<int> forwardIndexes;
+  for(int index = meetNodeIndex; index != Node::INVALID_INDEX; index = at(forward.nodePredecessorArr, index))
+    forwardIndexes.insert(index);
+
+  // Follow the backward search from the meeting node to the destination and
+  // insert the nodes into the predecessor arrays as used by extractLegs
+  int index = meetNodeIndex;
+  while(index != destNode.index)
+  {
+    int next = at(backward.nodePredecessorArr, index);
+    if(next == Node::INVALID_INDEX || forwardIndexes.contains(next))
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot join paths at" << index << "next" << next;
+      return false;
+    }
+
+    // Edge has toIndex set to the predecessor - fix direction
+    Edge edge = at(backward.edgePredecessorArr, index);
+    edge.toIndex = next;
+
+    at(forward.nodePredecessorArr, next) = index;
+    at(forward.edgePredecessorArr, next) = edge;
+    at(forward.nodeCostArr, next) = meetCost - at(backward.nodeCostArr, next);
+    forwardIndexes.insert(next);
+    index = next;
+  }
+  return true;
 }
 
 bool RouteFinder::invokeCallback(const atools::routing::Node& currentNode)
@@ -122,75 +452,127 @@ bool RouteFinder::invokeCallback(const atools::routing::Node& currentNode)
   return true;
 }
 
-bool RouteFinder::expandNode(const atools::routing::Node& currentNode, const atools::routing::Edge& prevEdge)
+bool RouteFinder::expandNode(SearchDirection& dir, const atools::routing::Node& currentNode,
+                             const atools::routing::Edge& prevEdge, bool reverse)
 {
   successors.clear();
-  network->getNeighbours(successors, currentNode, &prevEdge);
+  if(reverse)
+    network->getNeighboursReverse(successors, query, currentNode, &prevEdge);
+  else
+    network->getNeighbours(successors, query, currentNode, &prevEdge);
+
+  stats.expandedNodes++;
+  stats.neighbourLookups++;
+  stats.nearestQueries += successors.numNearestQueries;
+  stats.successors += successors.size();
 
   quint32 currentEdgeAirwayHash = 0;
   if(network->isAirwayRouting())
-    currentEdgeAirwayHash = at(edgeNameHashArr, currentNode.index);
+    currentEdgeAirwayHash = at(dir.edgeNameHashArr, currentNode.index);
+
+  bool bidirectional = query.mode.testFlag(MODE_BIDIRECTIONAL);
 
   for(int i = 0; i < successors.nodes.size(); i++)
   {
     int successorIndex = successors.nodes.at(i);
 
-    if(at(closedNodes, successorIndex))
+    if(at(dir.closedNodes, successorIndex))
       // Already has a shortest path
       continue;
 
-    const Node& successor = network->getNode(successorIndex);
+    const Node& successor = network->getNode(query, successorIndex);
     const Edge& edge = successors.edges.at(i);
 
+    if(isEdgeClosed(edge))
+      // Airway or track closed by user
+      continue;
+
     // Invoke user callback if set
     if(!invokeCallback(successor))
       return false;
 
-    int successorEdgeCosts = calculateEdgeCost(currentNode, successor, edge, currentEdgeAirwayHash);
+    // Costs are always calculated in flight direction - successor is the predecessor for the backward search
+    int successorEdgeCosts = reverse ?
+                             calculateEdgeCost(successor, currentNode, edge, currentEdgeAirwayHash) :
+                             calculateEdgeCost(currentNode, successor, edge, currentEdgeAirwayHash);
 
-    int successorNodeCosts = at(nodeCostArr, currentNode.index) + successorEdgeCosts;
+    int successorNodeCosts = at(dir.nodeCostArr, currentNode.index) + successorEdgeCosts;
     bool contains = true;
-    if(successorNodeCosts >= at(nodeCostArr, successorIndex))
+    if(successorNodeCosts >= at(dir.nodeCostArr, successorIndex))
     {
-      contains = openNodesHeap.contains(successorIndex);
+      contains = dir.openNodesHeap.contains(heapKey(successorIndex));
       if(contains)
         // New path is not cheaper
         continue;
     }
 
-    quint16 successorNodeAltRangeMin = at(nodeAltRangeMinArr, currentNode.index);
-    quint16 successorNodeAltRangeMax = at(nodeAltRangeMaxArr, currentNode.index);
+    quint16 successorNodeAltRangeMin = at(dir.nodeAltRangeMinArr, currentNode.index);
+    quint16 successorNodeAltRangeMax = at(dir.nodeAltRangeMaxArr, currentNode.index);
 
     if(!combineRanges(successorNodeAltRangeMin, successorNodeAltRangeMax, edge.minAltFt, edge.maxAltFt))
       continue;
 
     // New path is cheaper - update node
-    at(edgePredecessorArr, successorIndex) = successors.edges.at(i);
+    at(dir.edgePredecessorArr, successorIndex) = successors.edges.at(i);
     if(network->isAirwayRouting())
-      at(edgeNameHashArr, successorIndex) = successors.edges.at(i).airwayHash;
-    at(nodePredecessorArr, successorIndex) = currentNode.index;
-    at(nodeCostArr, successorIndex) = successorNodeCosts;
-    at(nodeAltRangeMinArr, successorIndex) = successorNodeAltRangeMin;
-    at(nodeAltRangeMaxArr, successorIndex) = successorNodeAltRangeMax;
+      at(dir.edgeNameHashArr, successorIndex) = successors.edges.at(i).airwayHash;
+    at(dir.nodePredecessorArr, successorIndex) = currentNode.index;
+    at(dir.nodeCostArr, successorIndex) = successorNodeCosts;
+    at(dir.nodeAltRangeMinArr, successorIndex) = successorNodeAltRangeMin;
+    at(dir.nodeAltRangeMaxArr, successorIndex) = successorNodeAltRangeMax;
 
     // Costs from start to successor + estimate to destination = sort order in heap
-    int totalCost = successorNodeCosts + static_cast<int>(network->getGcDistanceMeter(successor, destNode));
+    int totalCost = successorNodeCosts + estimateCost(successor, reverse);
 
-    if(contains)
-      // Update node and resort heap or add node if not exists
-      openNodesHeap.changeOrPush(successorIndex, totalCost);
+    int key = heapKey(successorIndex);
+    if(contains && dir.openNodesHeap.contains(key))
+    {
+      // Update node and resort heap
+      dir.openNodesHeap.change(key, totalCost);
+      stats.heapUpdates++;
+    }
     else
-      openNodesHeap.push(successorIndex, totalCost);
+    {
+      dir.openNodesHeap.push(key, totalCost);
+      stats.heapPushes++;
+    }
+
+    if(bidirectional)
+      updateMeetingNode(successorIndex);
   }
   return true;
 }
 
+int RouteFinder::estimateCost(const atools::routing::Node& node, bool reverse) const
+{
+  // Great circle distance to destination of this search
+  int estimate = static_cast<int>(network->getGcDistanceMeter(node, reverse ? startNode : destNode));
+
+  if(useLandmarks && node.index >= 0)
+  {
+    // Network distance to the node nearest to the target minus the distance from there to the target
+    int landmarkEstimate = reverse ?
+                           landmarks->lowerBoundMeter(startAnchorIndex, node.index) - startAnchorDist :
+                           landmarks->lowerBoundMeter(node.index, destAnchorIndex) - destAnchorDist;
+    estimate = std::max(estimate, landmarkEstimate);
+  }
+
+  if(useWindCosts)
+    // Strongest tailwind everywhere
+    estimate = static_cast<int>(estimate * windEstimateFactor);
+  return estimate;
+}
+
 int RouteFinder::calculateEdgeCost(const atools::routing::Node& currentNode,
                                    const atools::routing::Node& successorNode,
                                    const atools::routing::Edge& edge, quint32 currentEdgeAirwayHash)
 {
   float costs = edge.lengthMeter;
 
+  if(useWindCosts)
+    // Flight time instead of distance
+    costs *= windCosts->timeFactor(currentNode, successorNode);
+
   if(currentNode.type == NODE_DEPARTURE && successorNode.type == NODE_DESTINATION)
     // Avoid direct connections between departure and destination
     costs *= COST_FACTOR_DIRECT;
@@ -223,7 +605,7 @@ int RouteFinder::calculateEdgeCost(const atools::routing::Node& currentNode,
       else if(edge.lengthMeter < atools::geo::nmToMeter(25))
         costs *= COST_FACTOR_NEAR_WAYPOINTS;
     }
-    else if(edge.isTrack() && network->getMode() & MODE_TRACK)
+    else if(edge.isTrack() && query.mode & MODE_TRACK)
       // Track ======================
       costs *= COST_FACTOR_TRACK;
   }
@@ -245,9 +627,70 @@ int RouteFinder::calculateEdgeCost(const atools::routing::Node& currentNode,
   if(currentEdgeAirwayHash != edge.airwayHash)
     costs *= COST_FACTOR_AIRWAY_CHANGE;
 
+  // Make edges of previously found alternative routes more expensive
+  if(!edgePenalties.isEmpty())
+  {
+    int count = edgePenalties.value(edgeKey(currentNode.index, successorNode.index), 0);
+    if(count > 0)
+      costs *= 1.f + COST_FACTOR_ALTERNATIVE_PENALTY * count;
+  }
+
   return static_cast<int>(costs);
 }
 
+int RouteFinder::calculateAlternativeRoutes(QVector<RouteAlternative>& routes, const atools::geo::Pos& from,
+                                            const atools::geo::Pos& to, int flownAltitude, Modes mode, int numRoutes)
+{
+  routes.clear();
+  edgePenalties.clear();
+
+  // Limit number of searches if penalties result in the same routes
+  for(int attempt = 0; attempt < numRoutes * 2 && routes.size() < numRoutes; attempt++)
+  {
+    if(!calculateRoute(from, to, flownAltitude, mode))
+      break;
+
+    RouteAlternative route;
+    extractLegs(route.legs, route.distanceMeter);
+
+    // Compare by navaid and airway sequence
+    bool duplicate = false;
+    for(const RouteAlternative& other : routes)
+    {
+      if(other.legs.size() == route.legs.size() &&
+         std::equal(other.legs.begin(), other.legs.end(), route.legs.begin(),
+                    [](const RouteLeg& leg1, const RouteLeg& leg2) -> bool {
+            return leg1.navId == leg2.navId && leg1.type == leg2.type && leg1.airwayId == leg2.airwayId;
+          }))
+      {
+        duplicate = true;
+        break;
+      }
+    }
+
+    if(!duplicate)
+      routes.append(route);
+
+    addRoutePenalties();
+  }
+
+  edgePenalties.clear();
+  return routes.size();
+}
+
+void RouteFinder::addRoutePenalties()
+{
+  // Walk back from destination - ignore virtual departure and destination edges which are used by all routes
+  int index = query.destinationNode.index;
+  while(index != Node::INVALID_INDEX)
+  {
+    int pred = at(forward.nodePredecessorArr, index);
+    if(pred >= 0 && index >= 0)
+      edgePenalties[edgeKey(pred, index)]++;
+    index = pred;
+  }
+}
+
 void RouteFinder::extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter) const
 {
   distanceMeter = 0.f;
@@ -255,7 +698,7 @@ void RouteFinder::extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter
   routeLegs.reserve(500);
 
   // Build route
-  Node pred = network->getDestinationNode();
+  Node pred = query.destinationNode;
   while(pred.index != -1)
   {
     if(pred.type != NODE_DEPARTURE && pred.type != NODE_DESTINATION)
@@ -263,25 +706,57 @@ void RouteFinder::extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter
       RouteLeg leg;
       leg.navId = pred.id;
       leg.type = pred.type;
-      leg.airwayId = at(edgePredecessorArr, pred.index).id;
+      leg.airwayId = at(forward.edgePredecessorArr, pred.index).id;
       leg.pos = pred.pos;
       routeLegs.prepend(leg);
     }
 
-    Node next = network->getNode(at(nodePredecessorArr, pred.index));
+    Node next = network->getNode(query, at(forward.nodePredecessorArr, pred.index));
     if(next.pos.isValid())
       distanceMeter += pred.pos.distanceMeterTo(next.pos);
     pred = next;
   }
 }
 
-void RouteFinder::allocArrays()
+void RouteFinder::allocArrays(bool bidirectional)
 {
-  freeArrays();
   // Reserve space at beginning for start and destination node
   // Relies on RouteNetwork::DEPARTURE_NODE_INDEX and RouteNetwork::DESTINATION_NODE_INDEX
   int num = network->getNodes().size() + 3;
 
+  forward.allocArrays(num);
+
+  if(bidirectional)
+    backward.allocArrays(num);
+  else
+    backward.freeArrays();
+}
+
+void RouteFinder::freeArrays()
+{
+  forward.freeArrays();
+  backward.freeArrays();
+}
+
+void RouteFinder::SearchDirection::allocArrays(int num)
+{
+  if(num == numEntries)
+  {
+    // Reuse arrays when calculating several routes in the same network
+    std::fill(edgeNameHashArr, edgeNameHashArr + num, 0);
+    std::fill(nodeCostArr, nodeCostArr + num, 0);
+    std::fill(nodeAltRangeMinArr, nodeAltRangeMinArr + num, 0);
+    std::fill(nodeAltRangeMaxArr, nodeAltRangeMaxArr + num, 0);
+    std::fill(nodePredecessorArr, nodePredecessorArr + num, -1);
+    std::fill(edgePredecessorArr, edgePredecessorArr + num, Edge());
+    std::fill(closedNodes, closedNodes + num, false);
+    openNodesHeap.clear();
+    return;
+  }
+
+  freeArrays();
+
+  numEntries = num;
   edgeNameHashArr = atools::allocArray<quint32>(num);
   nodeCostArr = atools::allocArray<int>(num);
   nodeAltRangeMinArr = atools::allocArray<quint16>(num);
@@ -289,9 +764,12 @@ void RouteFinder::allocArrays()
   nodePredecessorArr = atools::allocArray<int>(num, -1);
   edgePredecessorArr = atools::allocArray<Edge>(num, Edge());
   closedNodes = atools::allocArray<bool>(num);
+
+  // Clears heap and allocates position index for all nodes
+  openNodesHeap.resize(num);
 }
 
-void RouteFinder::freeArrays()
+void RouteFinder::SearchDirection::freeArrays()
 {
   atools::freeArray(edgeNameHashArr);
   atools::freeArray(nodeCostArr);
@@ -300,6 +778,27 @@ void RouteFinder::freeArrays()
   atools::freeArray(nodePredecessorArr);
   atools::freeArray(edgePredecessorArr);
   atools::freeArray(closedNodes);
+  openNodesHeap.resize(0);
+  numEntries = 0;
+}
+
+QDebug operator<<(QDebug out, const RouteFinderStats& obj)
+{
+  QDebugStateSaver saver(out);
+
+  out.nospace().noquote() << "RouteFinderStats("
+                          << "found " << obj.found
+                          << ", expanded " << obj.expandedNodes
+                          << ", heap pushes " << obj.heapPushes
+                          << ", heap updates " << obj.heapUpdates
+                          << ", neighbour lookups " << obj.neighbourLookups
+                          << ", nearest queries " << obj.nearestQueries
+                          << ", successors " << obj.successors
+                          << ", init " << obj.initMicroSec << " us"
+                          << ", search " << obj.searchMicroSec << " us"
+                          << ", total " << obj.totalMicroSec << " us"
+                          << ")";
+  return out;
 }
 
 QDebug operator<<(QDebug out, const RouteLeg& obj)
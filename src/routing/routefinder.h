@@ -19,12 +19,15 @@
 #define ATOOLS_ROUTEFINDER_H
 
 #include "util/heap.h"
-#include "routing/routenetworktypes.h"
+#include "routing/routenetwork.h"
+
+#include <QSet>
 
 namespace atools {
 namespace routing {
 
-class RouteNetwork;
+class RouteLandmarks;
+class RouteWindCosts;
 
 struct RouteLeg
 {
@@ -37,17 +40,48 @@ struct RouteLeg
 
 };
 
+/* Counters and times of the last route calculation */
+struct RouteFinderStats
+{
+  bool found = false;
+  int expandedNodes = 0, /* Nodes taken from the open heap and expanded */
+      heapPushes = 0, /* Nodes added to the open heap */
+      heapUpdates = 0, /* Cost changes of nodes already in the open heap */
+      neighbourLookups = 0, /* Calls of RouteNetwork::getNeighbours or getNeighboursReverse */
+      nearestQueries = 0, /* Spatial index radius queries done by RouteNetwork */
+      successors = 0; /* Total number of neighbours returned */
+
+  /* Wall time for array allocation and preparation, search including path joining and total */
+  qint64 initMicroSec = 0L, searchMicroSec = 0L, totalMicroSec = 0L;
+
+  void clear()
+  {
+    *this = RouteFinderStats();
+  }
+
+  friend QDebug operator<<(QDebug out, const atools::routing::RouteFinderStats& obj);
+};
+
+/* One of several alternative routes as returned by RouteFinder::calculateAlternativeRoutes */
+struct RouteAlternative
+{
+  QVector<atools::routing::RouteLeg> legs;
+  float distanceMeter = 0.f;
+};
+
 /*
  * Calculates flight plans within a route network which can be an airway or radio navaid network.
  * Uses A* algorithm and several cost factor adjustments to get reasonable routes.
+ * A bidirectional A* is used if mode contains MODE_BIDIRECTIONAL.
  *
- * The class has a state (i.e. start and destination) and is not re-entrant.
+ * The class has a state (i.e. start and destination) and is not re-entrant. The network is not modified and
+ * several route finders can use the same loaded network in different threads. Use one finder per thread.
  */
 class RouteFinder
 {
 public:
   /* Creates a route finder that uses the given network */
-  RouteFinder(RouteNetwork *routeNetwork);
+  RouteFinder(const RouteNetwork *routeNetwork);
   virtual ~RouteFinder();
 
   /*
@@ -63,11 +97,38 @@ public:
   /* Extract legs of shortest route and distance not including departure and destination. */
   void extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter) const;
 
+  /*
+   * Recalculates the last found route from a new departure position, e.g. after a diversion, keeping destination,
+   * altitude and mode. Closed airways and tracks are considered.
+   *
+   * Reuses the previous route: The search stops as soon as the rest of the previous route behind the last closed
+   * edge is reached on a cheapest path instead of searching all the way to the destination.
+   * Falls back to a full calculation if the new route would cross itself.
+   * @return true if a route was found. Result can be read using extractLegs.
+   */
+  bool recalculateRoute(const atools::geo::Pos& from);
+
+  /*
+   * Calculates up to numRoutes different routes between two points. First route is the same as returned by
+   * calculateRoute. Following routes are found by adding a penalty to the costs of all network edges used by
+   * previous routes and searching again. Identical routes are omitted.
+   * Parameters as in calculateRoute.
+   * @return number of routes found which can be less than numRoutes
+   */
+  int calculateAlternativeRoutes(QVector<atools::routing::RouteAlternative>& routes, const atools::geo::Pos& from,
+                                 const atools::geo::Pos& to, int flownAltitude, Modes mode, int numRoutes);
+
   const RouteNetwork *getNetwork() const
   {
     return network;
   }
 
+  /* Statistics for last call of calculateRoute or recalculateRoute */
+  const atools::routing::RouteFinderStats& getStats() const
+  {
+    return stats;
+  }
+
   /* Callback for progress reporting. distToDest is the direct euclidian distance in 3D space between
    * departure and destination. curDistToDest is the direct euclidian distance in 3D space of
    * the current node processed to the destination.
@@ -84,16 +145,138 @@ public:
     costFactorForceAirways = value;
   }
 
+  /* Airways by database airway.airway_id which are not used for routing */
+  void setClosedAirways(const QSet<int>& airwayIds)
+  {
+    closedAirways = airwayIds;
+  }
+
+  /* Tracks by database track.track_id which are not used for routing */
+  void setClosedTracks(const QSet<int>& trackIds)
+  {
+    closedTracks = trackIds;
+  }
+
+  /* Use precomputed landmark distances to improve the cost estimate for airway routing.
+   * Landmarks are ignored if mode contains MODE_WAYPOINT since generated direct connections are not part of the
+   * precomputed distances. Landmarks have to be built for the network used by this finder. Set to null to disable. */
+  void setLandmarks(const atools::routing::RouteLandmarks *value)
+  {
+    landmarks = value;
+  }
+
+  /* Use precomputed winds to weight edge costs by flight time instead of distance. Wind costs have to be built
+   * for the network used by this finder and the flown altitude. Set to null to disable. */
+  void setWindCosts(const atools::routing::RouteWindCosts *value)
+  {
+    windCosts = value;
+  }
+
 private:
-  /* Expands a node by investigating all successors */
-  bool expandNode(const atools::routing::Node& node, const Edge& prevEdge);
+  /* Arrays and open nodes heap for one search direction. Forward search runs from departure to destination and
+   * backward search from destination to departure if MODE_BIDIRECTIONAL is used.
+   *
+   * Using plain arrays below to speed up access compared to hash tables
+   * Positions 0 and 1 are reserved for departure and destination. 2 is invalid.
+   * 3 corresponds to first index in nodeIndex.*/
+  struct SearchDirection
+  {
+    SearchDirection()
+      : openNodesHeap(10000)
+    {
+    }
+
+    ~SearchDirection()
+    {
+      freeArrays();
+    }
+
+    SearchDirection(const SearchDirection& other) = delete;
+    SearchDirection& operator=(const SearchDirection& other) = delete;
+
+    /* Allocates arrays or only resets them if already allocated with the same size */
+    void allocArrays(int num);
+    void freeArrays();
+
+    /* Size of allocated arrays */
+    int numEntries = 0;
+
+    /* Indexed heap structure storing the index of open nodes. Costs are based on meters plus factors as integer.
+     * Sort order is defined by costs from start to node + estimate to destination.
+     * Keys are node indexes shifted by three like the arrays below. */
+    atools::util::IndexedHeap<int> openNodesHeap;
+
+    /* Nodes that have been processed already and have a known shortest path */
+    bool *closedNodes = nullptr;
+
+    /* Costs from start to this node. Maps node id to costs. Costs are distance in meter
+     * adjusted by factors. */
+    int *nodeCostArr = nullptr;
+
+    /* Min and maximum altitude range of airways to this node so far */
+    quint16 *nodeAltRangeMinArr = nullptr;
+    quint16 *nodeAltRangeMaxArr = nullptr;
+
+    /* Maps node index to predecessor node id in search order.
+     * This is the successor in flight direction for the backward search. */
+    int *nodePredecessorArr = nullptr;
+
+    /* Maps node index to predecessor edge - similar as above */
+    atools::routing::Edge *edgePredecessorArr = nullptr;
+
+    /* Airway name hash value for edge at index */
+    quint32 *edgeNameHashArr = nullptr;
+  };
+
+  /* One node of the last found route in flight order */
+  struct PathEntry
+  {
+    int index; /* Node index */
+    atools::routing::Edge edge; /* Edge leading to this node */
+    int cost; /* Costs from departure to this node */
+  };
+
+  /* Reset arrays, prepare query and add departure to the open nodes */
+  void initSearch(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude, Modes mode);
+
+  /* Search from departure and destination towards each other */
+  bool calculateRouteBidirectional();
+
+  /* Save the found route from forward predecessor arrays in previousPath for recalculateRoute */
+  void storePath();
+
+  /* true if edge belongs to a closed airway or track */
+  bool isEdgeClosed(const atools::routing::Edge& edge) const
+  {
+    if(closedAirways.isEmpty() && closedTracks.isEmpty())
+      return false;
+
+    return (edge.isTrack() && closedTracks.contains(edge.id)) ||
+           (edge.isAnyAirway() && closedAirways.contains(edge.id));
+  }
+
+  /* Expands a node by investigating all successors. Looks at predecessors if reverse is true. */
+  bool expandNode(SearchDirection& dir, const atools::routing::Node& node, const Edge& prevEdge, bool reverse);
+
+  /* Checks if a node is reached by both searches and remembers the cheapest meeting point */
+  void updateMeetingNode(int index);
+
+  /* Joins the backward search path into the predecessor arrays of the forward search.
+   * Returns false if paths cannot be joined. */
+  bool joinPaths();
+
+  /* true if node was reached by the given search */
+  bool isReached(const SearchDirection& dir, int index, const atools::routing::Node& searchStartNode) const;
+
+  /* Estimated costs from node to destination or to departure if reverse is true */
+  int estimateCost(const atools::routing::Node& node, bool reverse) const;
 
   /* Calculates the costs to travel from current to successor. Base is the distance between the nodes in meter that
    * will have several factors applied to get reasonable routes */
   int calculateEdgeCost(const atools::routing::Node& node, const atools::routing::Node& successorNode,
                         const Edge& edge, quint32 currentEdgeAirwayHash);
 
-  bool combineRanges(quint16& min1, quint16& max1, quint16 min, quint16 max)
+  bool combineRanges(quint16& min1, quint16& max1, quint16 min, quint16 max) const
   {
     if(max1 < min || min1 > max)
       return false;
@@ -104,7 +287,7 @@ private:
   }
 
   void freeArrays();
-  void allocArrays();
+  void allocArrays(bool bidirectional);
   bool invokeCallback(const Node& currentNode);
 
   /* Avoid direct waypoint connections when using airways */
@@ -133,45 +316,68 @@ private:
   /* Avoid airway changes during routing */
   static Q_DECL_CONSTEXPR float COST_FACTOR_AIRWAY_CHANGE = 1.1f;
 
+  /* Cost increase for each previous alternative route using an edge */
+  static Q_DECL_CONSTEXPR float COST_FACTOR_ALTERNATIVE_PENALTY = 0.5f;
+
+  /* Key for edgePenalties */
+  static quint64 edgeKey(int fromIndex, int toIndex)
+  {
+    return (static_cast<quint64>(static_cast<quint32>(fromIndex)) << 32) | static_cast<quint32>(toIndex);
+  }
+
+  /* Add penalty for all network edges of the last found route */
+  void addRoutePenalties();
+
   /* Altitude to use  for airway selection of 0 if not used */
   int altitude = 0;
 
-  /* Used network */
-  atools::routing::RouteNetwork *network;
+  /* Used network. Read only. */
+  const atools::routing::RouteNetwork *network;
 
-  /* Heap structure storing the index of open nodes. Costs are based on meters plus factors as integer.
-   * Sort order is defined by costs from start to node + estimate to destination */
-  atools::util::Heap<int, int> openNodesHeap;
+  /* Departure, destination and filter parameters for the current calculation */
+  atools::routing::RouteNetworkQuery query;
 
-  /* Using plain arrays below to speed up access compared to hash tables
-   * Positions 0 and 1 are reserved for departure and destination. 2 is invalid.
-   * 3 corresponds to first index in nodeIndex.*/
+  /* Search from departure to destination. Always used. */
+  SearchDirection forward;
 
-  /* Nodes that have been processed already and have a known shortest path */
-  bool *closedNodes = nullptr;
+  /* Search from destination to departure. Only used and allocated for MODE_BIDIRECTIONAL. */
+  SearchDirection backward;
 
-  /* Costs from start to this node. Maps node id to costs. Costs are distance in meter
-   * adjusted by factors. */
-  int *nodeCostArr = nullptr;
+  /* Cheapest node reached by both searches and the total costs of the path through it */
+  int meetNodeIndex = Node::INVALID_INDEX;
+  int meetCost = std::numeric_limits<int>::max();
 
-  /* Min and maximum altitude range of airways to this node so far */
-  quint16 *nodeAltRangeMinArr = nullptr;
-  quint16 *nodeAltRangeMaxArr = nullptr;
+  atools::routing::Node startNode, destNode;
 
-  /* Maps node index to predecessor node id */
-  int *nodePredecessorArr = nullptr;
+  /* Optional landmarks for cost estimate */
+  const atools::routing::RouteLandmarks *landmarks = nullptr;
+  bool useLandmarks = false;
 
-  /* Maps node index to predecessor edge - similar as above */
-  atools::routing::Edge *edgePredecessorArr = nullptr;
+  /* Optional wind time factors for edge costs. Estimate is scaled by the minimum factor to keep it a lower bound. */
+  const atools::routing::RouteWindCosts *windCosts = nullptr;
+  bool useWindCosts = false;
+  float windEstimateFactor = 1.f;
 
-  /* Airway name hash value for edge at index */
-  quint32 *edgeNameHashArr = nullptr;
+  /* Network nodes nearest to departure and destination used to apply landmark distances
+   * and their distance to the respective virtual node. */
+  int startAnchorIndex = Node::INVALID_INDEX, destAnchorIndex = Node::INVALID_INDEX;
+  int startAnchorDist = 0, destAnchorDist = 0;
 
-  atools::routing::Node startNode, destNode;
+  /* Number of previous alternative routes using an edge. Key is edgeKey() in flight direction.
+   * Only filled by calculateAlternativeRoutes. */
+  QHash<quint64, int> edgePenalties;
+
+  /* Airway and track ids excluded from routing */
+  QSet<int> closedAirways, closedTracks;
+
+  /* Last found route used by recalculateRoute */
+  QVector<PathEntry> previousPath;
 
   /* For RouteNetwork::getNeighbours to avoid instantiations */
   atools::routing::Result successors;
 
+  atools::routing::RouteFinderStats stats;
+
   RouteFinderCallbackType callback;
   int totalDist = 0;
   int lastDist = 0;
@@ -0,0 +1,328 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routelandmarks.h"
+
+#include "routing/routenetwork.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlscript.h"
+#include "sql/sqlutil.h"
+#include "util/heap.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+
+using atools::sql::SqlUtil;
+using atools::sql::SqlQuery;
+using atools::sql::SqlScript;
+
+namespace atools {
+namespace routing {
+
+Q_DECL_CONSTEXPR quint32 RouteLandmarks::INVALID_DISTANCE;
+
+/* Convert one landmark column of the node major array to a compressed blob */
+static QByteArray distancesToBlob(const QVector<quint32>& distances, int landmark, int numLandmarks, int numNodes)
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+
+  for(int i = 0; i < numNodes; i++)
+    out << distances.at(i * numLandmarks + landmark);
+
+  return qCompress(bytes);
+}
+
+/* Fill one landmark column of the node major array from a compressed blob */
+static bool blobToDistances(QVector<quint32>& distances, const QByteArray& blob, int landmark, int numLandmarks,
+                            int numNodes)
+{
+  QByteArray bytes = qUncompress(blob);
+  if(bytes.size() != numNodes * static_cast<int>(sizeof(quint32)))
+    return false;
+
+  QDataStream in(&bytes, QIODevice::ReadOnly);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  for(int i = 0; i < numNodes; i++)
+    in >> distances[i * numLandmarks + landmark];
+
+  return in.status() == QDataStream::Ok;
+}
+
+RouteLandmarks::RouteLandmarks()
+{
+
+}
+
+RouteLandmarks::~RouteLandmarks()
+{
+
+}
+
+void RouteLandmarks::clear()
+{
+  landmarkIndexes.clear();
+  landmarkNodeIds.clear();
+  distancesFrom.clear();
+  distancesTo.clear();
+  numNodes = 0;
+  checksum = 0;
+}
+
+void RouteLandmarks::build(const RouteNetwork *network, int numLandmarks)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+
+  const QVector<Node>& nodes = network->getNodes();
+  if(nodes.isEmpty() || numLandmarks <= 0)
+    return;
+
+  // Use only nodes connected to airways or tracks as landmark candidates
+  QVector<int> candidates;
+  for(const Node& node : nodes)
+  {
+    if(!network->getEdges(node.index).isEmpty())
+      candidates.append(node.index);
+  }
+
+  if(candidates.isEmpty())
+    return;
+
+  // Select landmarks by farthest point selection ======================================
+  // Minimum distance of each candidate to all landmarks selected so far
+  QVector<float> minDistances(candidates.size(), std::numeric_limits<float>::max());
+
+  // Start with the node farthest away from the first candidate
+  const Node& firstNode = nodes.at(candidates.constFirst());
+  int nextIndex = candidates.constFirst();
+  float maxDist = 0.f;
+  for(int idx : candidates)
+  {
+    float dist = network->getDirectDistanceMeter(firstNode, nodes.at(idx));
+    if(dist > maxDist)
+    {
+      maxDist = dist;
+      nextIndex = idx;
+    }
+  }
+
+  while(landmarkIndexes.size() < std::min(numLandmarks, candidates.size()))
+  {
+    const Node& landmarkNode = nodes.at(nextIndex);
+    landmarkIndexes.append(nextIndex);
+    landmarkNodeIds.append(landmarkNode.id);
+
+    // Update minimum distances and get candidate with the largest one as next landmark
+    maxDist = 0.f;
+    for(int i = 0; i < candidates.size(); i++)
+    {
+      float dist = network->getDirectDistanceMeter(landmarkNode, nodes.at(candidates.at(i)));
+      if(dist < minDistances.at(i))
+        minDistances[i] = dist;
+
+      if(minDistances.at(i) > maxDist)
+      {
+        maxDist = minDistances.at(i);
+        nextIndex = candidates.at(i);
+      }
+    }
+
+    if(maxDist <= 0.f)
+      // All candidates used
+      break;
+  }
+
+  // Calculate distances for all landmarks ======================================
+  numNodes = nodes.size();
+  checksum = nodeChecksum(network);
+  distancesFrom.fill(INVALID_DISTANCE, numNodes * landmarkIndexes.size());
+  distancesTo.fill(INVALID_DISTANCE, numNodes * landmarkIndexes.size());
+
+  for(int landmark = 0; landmark < landmarkIndexes.size(); landmark++)
+  {
+    calculateDistances(network, landmark, false /* reverse */, distancesFrom);
+    calculateDistances(network, landmark, true /* reverse */, distancesTo);
+  }
+
+  qDebug() << Q_FUNC_INFO << "landmarks" << landmarkIndexes.size() << "nodes" << numNodes
+           << timer.elapsed() << "ms";
+}
+
+void RouteLandmarks::calculateDistances(const RouteNetwork *network, int landmark, bool reverse,
+                                        QVector<quint32>& distances) const
+{
+  const QVector<Node>& nodes = network->getNodes();
+  int numLandmarks = landmarkIndexes.size();
+  int start = landmarkIndexes.at(landmark);
+
+  atools::util::IndexedHeap<quint32> heap(10000);
+  heap.resize(nodes.size());
+
+  distances[start * numLandmarks + landmark] = 0;
+  heap.push(start, 0);
+
+  while(!heap.isEmpty())
+  {
+    int index;
+    quint32 distance = heap.pop(index);
+
+    // Look at outgoing edges to get distances from landmark and at incoming edges to get distances to landmark
+    EdgeRange edges = reverse ? network->getReverseEdges(index) : network->getEdges(index);
+    for(const Edge& edge : edges)
+    {
+      quint32 newDistance = distance + static_cast<quint32>(std::max(edge.lengthMeter, 0));
+      quint32& oldDistance = distances[edge.toIndex * numLandmarks + landmark];
+
+      if(newDistance < oldDistance)
+      {
+        oldDistance = newDistance;
+        heap.changeOrPush(edge.toIndex, newDistance);
+      }
+    }
+  }
+}
+
+int RouteLandmarks::lowerBoundMeter(int fromIndex, int toIndex) const
+{
+  int numLandmarks = landmarkIndexes.size();
+  const quint32 *fromTo = distancesTo.constData() + fromIndex * numLandmarks;
+  const quint32 *toTo = distancesTo.constData() + toIndex * numLandmarks;
+  const quint32 *fromFrom = distancesFrom.constData() + fromIndex * numLandmarks;
+  const quint32 *toFrom = distancesFrom.constData() + toIndex * numLandmarks;
+
+  qint64 bound = 0;
+  for(int i = 0; i < numLandmarks; i++)
+  {
+    // d(from, to) >= d(from, landmark) - d(to, landmark)
+    if(fromTo[i] != INVALID_DISTANCE && toTo[i] != INVALID_DISTANCE)
+      bound = std::max(bound, static_cast<qint64>(fromTo[i]) - static_cast<qint64>(toTo[i]));
+
+    // d(from, to) >= d(landmark, to) - d(landmark, from)
+    if(toFrom[i] != INVALID_DISTANCE && fromFrom[i] != INVALID_DISTANCE)
+      bound = std::max(bound, static_cast<qint64>(toFrom[i]) - static_cast<qint64>(fromFrom[i]));
+  }
+  return static_cast<int>(std::min(bound, static_cast<qint64>(std::numeric_limits<int>::max())));
+}
+
+quint32 RouteLandmarks::nodeChecksum(const RouteNetwork *network)
+{
+  quint32 sum = static_cast<quint32>(network->getNodes().size());
+  for(const Node& node : network->getNodes())
+    sum = sum * 31 + static_cast<quint32>(node.id);
+  return sum;
+}
+
+void RouteLandmarks::writeToDatabase(sql::SqlDatabase *db) const
+{
+  if(!SqlUtil(db).hasTable("route_landmark"))
+    SqlScript(db, false).executeScript(":/atools/resources/sql/fs/db/create_route_landmark_schema.sql");
+  else
+    db->exec("delete from route_landmark");
+
+  if(isValid())
+  {
+    SqlQuery insert(db);
+    insert.prepare("insert into route_landmark (landmark_id, node_id, node_index, num_nodes, checksum, "
+                   "distances_from, distances_to) "
+                   "values(:landmark_id, :node_id, :node_index, :num_nodes, :checksum, "
+                   ":distances_from, :distances_to)");
+
+    int numLandmarks = landmarkIndexes.size();
+    for(int landmark = 0; landmark < numLandmarks; landmark++)
+    {
+      insert.bindValue(":landmark_id", landmark + 1);
+      insert.bindValue(":node_id", landmarkNodeIds.at(landmark));
+      insert.bindValue(":node_index", landmarkIndexes.at(landmark));
+      insert.bindValue(":num_nodes", numNodes);
+      insert.bindValue(":checksum", checksum);
+      insert.bindValue(":distances_from", distancesToBlob(distancesFrom, landmark, numLandmarks, numNodes));
+      insert.bindValue(":distances_to", distancesToBlob(distancesTo, landmark, numLandmarks, numNodes));
+      insert.exec();
+    }
+  }
+  db->commit();
+}
+
+bool RouteLandmarks::readFromDatabase(sql::SqlDatabase *db, const RouteNetwork *network)
+{
+  clear();
+
+  if(!SqlUtil(db).hasTableAndRows("route_landmark"))
+    return false;
+
+  int networkNumNodes = network->getNodes().size();
+  quint32 networkChecksum = nodeChecksum(network);
+
+  // Read landmark indexes first to get the total number
+  SqlQuery query("select node_id, node_index, num_nodes, checksum from route_landmark order by landmark_id", db);
+  query.exec();
+  while(query.next())
+  {
+    if(query.valueInt("num_nodes") != networkNumNodes ||
+       static_cast<quint32>(query.value("checksum").toLongLong()) != networkChecksum)
+    {
+      qInfo() << Q_FUNC_INFO << "Landmarks do not match network";
+      clear();
+      return false;
+    }
+    landmarkIndexes.append(query.valueInt("node_index"));
+    landmarkNodeIds.append(query.valueInt("node_id"));
+  }
+
+  numNodes = networkNumNodes;
+  checksum = networkChecksum;
+  int numLandmarks = landmarkIndexes.size();
+  distancesFrom.fill(INVALID_DISTANCE, numNodes * numLandmarks);
+  distancesTo.fill(INVALID_DISTANCE, numNodes * numLandmarks);
+
+  // Read and uncompress distances ================================
+  query.exec("select distances_from, distances_to from route_landmark order by landmark_id");
+  int landmark = 0;
+  while(query.next() && landmark < numLandmarks)
+  {
+    if(!blobToDistances(distancesFrom, query.value("distances_from").toByteArray(), landmark, numLandmarks,
+                        numNodes) ||
+       !blobToDistances(distancesTo, query.value("distances_to").toByteArray(), landmark, numLandmarks, numNodes))
+    {
+      qWarning() << Q_FUNC_INFO << "Invalid landmark data for" << landmark;
+      clear();
+      return false;
+    }
+    landmark++;
+  }
+
+  qDebug() << Q_FUNC_INFO << "landmarks" << landmarkIndexes.size() << "nodes" << numNodes;
+  return isValid();
+}
+
+void RouteLandmarks::loadOrBuild(sql::SqlDatabase *db, const RouteNetwork *network, int numLandmarks)
+{
+  if(!readFromDatabase(db, network))
+  {
+    build(network, numLandmarks);
+    writeToDatabase(db);
+  }
+}
+
+} // namespace routing
+} // namespace atools
@@ -0,0 +1,111 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTELANDMARKS_H
+#define ATOOLS_ROUTELANDMARKS_H
+
+#include "routing/routenetworktypes.h"
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace routing {
+
+class RouteNetwork;
+
+/*
+ * Precomputed network distances between a small set of landmark nodes and all other nodes of an airway network.
+ * Used by RouteFinder to get a better cost estimate than the great circle distance (ALT heuristic: A*, landmarks and
+ * triangle inequality). This reduces the number of expanded nodes considerably for long airway routes.
+ *
+ * Distances are calculated along airway and track edges only and do not consider altitude or mode filters.
+ * The result is only valid for the network it was built with. Uses a checksum over all node ids to detect changes.
+ *
+ * Data can be saved in and loaded from table route_landmark in the navdata database.
+ */
+class RouteLandmarks
+{
+public:
+  RouteLandmarks();
+  ~RouteLandmarks();
+
+  /* Select landmarks by farthest point selection and calculate distances for all nodes using Dijkstra.
+   * Network has to be loaded. */
+  void build(const atools::routing::RouteNetwork *network, int numLandmarks = 16);
+
+  /* Write landmarks into table route_landmark. Table is created if missing. Commits. */
+  void writeToDatabase(atools::sql::SqlDatabase *db) const;
+
+  /* Read landmarks from table route_landmark. Returns false and clears all if the table is empty, missing
+   * or does not match the network. */
+  bool readFromDatabase(atools::sql::SqlDatabase *db, const atools::routing::RouteNetwork *network);
+
+  /* Read from database or build and write if not found or outdated. */
+  void loadOrBuild(atools::sql::SqlDatabase *db, const atools::routing::RouteNetwork *network, int numLandmarks = 16);
+
+  /* Lower bound of the network distance in meter from node index fromIndex to toIndex.
+   * Returns 0 if unknown. Both indexes have to be valid network node indexes. */
+  int lowerBoundMeter(int fromIndex, int toIndex) const;
+
+  /* true if built or loaded */
+  bool isValid() const
+  {
+    return numNodes > 0 && !landmarkIndexes.isEmpty();
+  }
+
+  void clear();
+
+  int getNumLandmarks() const
+  {
+    return landmarkIndexes.size();
+  }
+
+  /* Network node indexes of the landmarks */
+  const QVector<int>& getLandmarkIndexes() const
+  {
+    return landmarkIndexes;
+  }
+
+private:
+  /* Dijkstra on airway edges from landmark at index. Uses incoming edges if reverse is true. */
+  void calculateDistances(const atools::routing::RouteNetwork *network, int landmark, bool reverse,
+                          QVector<quint32>& distances) const;
+
+  /* Checksum over all node ids in network order */
+  static quint32 nodeChecksum(const atools::routing::RouteNetwork *network);
+
+  /* Distance for unreachable nodes */
+  static Q_DECL_CONSTEXPR quint32 INVALID_DISTANCE = std::numeric_limits<quint32>::max();
+
+  /* Network node index and database id for each landmark */
+  QVector<int> landmarkIndexes, landmarkNodeIds;
+
+  /* Node major arrays with num landmarks values for each node. Index is node index * num landmarks + landmark.
+   * Keeps all landmark values of a node in one cache line. */
+  QVector<quint32> distancesFrom, /* Landmark to node */
+                   distancesTo; /* Node to landmark */
+
+  int numNodes = 0;
+  quint32 checksum = 0;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTELANDMARKS_H
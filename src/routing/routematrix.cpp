@@ -0,0 +1,129 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routematrix.h"
+
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace atools {
+namespace routing {
+
+/* Runs calculation for one origin in the thread pool */
+class RouteMatrixTask :
+  public QRunnable
+{
+public:
+  RouteMatrixTask(const std::function<void()>& taskFunc)
+    : func(taskFunc)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    func();
+  }
+
+private:
+  std::function<void()> func;
+};
+
+RouteMatrix::RouteMatrix(const RouteNetwork *routeNetwork)
+  : network(routeNetwork)
+{
+}
+
+RouteMatrix::~RouteMatrix()
+{
+}
+
+void RouteMatrix::clear()
+{
+  origins.clear();
+  destinations.clear();
+  entries.clear();
+  numOrigins = numDestinations = 0;
+}
+
+void RouteMatrix::calculate(const QVector<geo::Pos>& originPositions, const QVector<geo::Pos>& destinationPositions,
+                            int flownAltitude, Modes mode, bool withLegs)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+  origins = originPositions;
+  destinations = destinationPositions;
+  numOrigins = origins.size();
+  numDestinations = destinations.size();
+  entries.resize(numOrigins * numDestinations);
+
+  if(entries.isEmpty())
+    return;
+
+  // Use a separate pool to avoid blocking or being blocked by other users of the global instance
+  QThreadPool pool;
+  if(maxThreads > 0)
+    pool.setMaxThreadCount(maxThreads);
+
+  for(int i = 0; i < numOrigins; i++)
+    pool.start(new RouteMatrixTask([this, i, flownAltitude, mode, withLegs]() -> void {
+      calculateOrigin(i, flownAltitude, mode, withLegs);
+    }));
+
+  pool.waitForDone();
+
+  qDebug() << Q_FUNC_INFO << "origins" << numOrigins << "destinations" << numDestinations
+           << "threads" << pool.maxThreadCount() << timer.elapsed() << "ms";
+}
+
+void RouteMatrix::calculateOrigin(int originIndex, int flownAltitude, Modes mode, bool withLegs)
+{
+  // One finder per origin and thread - arrays are reused for all destinations
+  RouteFinder finder(network);
+  finder.setCostFactorForceAirways(costFactorForceAirways);
+  finder.setLandmarks(landmarks);
+
+  const atools::geo::Pos& origin = origins.at(originIndex);
+  QVector<RouteLeg> legs;
+
+  for(int dest = 0; dest < numDestinations; dest++)
+  {
+    RouteMatrixEntry& entry = entries[originIndex * numDestinations + dest];
+    const atools::geo::Pos& destination = destinations.at(dest);
+
+    if(origin == destination)
+    {
+      // Nothing to calculate
+      entry.found = true;
+      continue;
+    }
+
+    entry.found = finder.calculateRoute(origin, destination, flownAltitude, mode);
+    if(entry.found)
+    {
+      finder.extractLegs(legs, entry.distanceMeter);
+      if(withLegs)
+        entry.legs = legs;
+    }
+  }
+}
+
+} // namespace routing
+} // namespace atools
@@ -0,0 +1,118 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTEMATRIX_H
+#define ATOOLS_ROUTEMATRIX_H
+
+#include "routing/routefinder.h"
+
+namespace atools {
+namespace routing {
+
+/* Result for one origin and destination pair */
+struct RouteMatrixEntry
+{
+  bool found = false;
+  float distanceMeter = 0.f; /* Flown distance along legs */
+  QVector<atools::routing::RouteLeg> legs; /* Only filled if requested. Not including origin and destination. */
+};
+
+/*
+ * Calculates routes between all pairs of a set of origins and a set of destinations in one RouteNetwork.
+ *
+ * Origins are calculated in parallel using a thread pool. Each worker uses one RouteFinder for all destinations
+ * of an origin which avoids re-allocation of search arrays. Network must be loaded and is not modified.
+ *
+ * Results are the same as using RouteFinder::calculateRoute for each pair.
+ */
+class RouteMatrix
+{
+public:
+  RouteMatrix(const atools::routing::RouteNetwork *routeNetwork);
+  ~RouteMatrix();
+
+  RouteMatrix(const RouteMatrix& other) = delete;
+  RouteMatrix& operator=(const RouteMatrix& other) = delete;
+
+  /* Calculate routes from all origins to all destinations. Blocks until all routes are calculated.
+   * Parameters as in RouteFinder::calculateRoute. Fills legs in result entries if withLegs is true. */
+  void calculate(const QVector<atools::geo::Pos>& originPositions,
+                 const QVector<atools::geo::Pos>& destinationPositions, int flownAltitude, Modes mode,
+                 bool withLegs = false);
+
+  /* Same as above for a single origin */
+  void calculateOneToMany(const atools::geo::Pos& origin, const QVector<atools::geo::Pos>& destinationPositions,
+                          int flownAltitude, Modes mode, bool withLegs = false)
+  {
+    calculate({origin}, destinationPositions, flownAltitude, mode, withLegs);
+  }
+
+  /* Get result for index in origin and destination list given to calculate */
+  const atools::routing::RouteMatrixEntry& getEntry(int originIndex, int destinationIndex) const
+  {
+    return entries.at(originIndex * numDestinations + destinationIndex);
+  }
+
+  int getNumOrigins() const
+  {
+    return numOrigins;
+  }
+
+  int getNumDestinations() const
+  {
+    return numDestinations;
+  }
+
+  void clear();
+
+  /* Maximum number of threads used. Default is number of cores. */
+  void setMaxThreads(int value)
+  {
+    maxThreads = value;
+  }
+
+  /* Passed to RouteFinder */
+  void setCostFactorForceAirways(float value)
+  {
+    costFactorForceAirways = value;
+  }
+
+  void setLandmarks(const atools::routing::RouteLandmarks *value)
+  {
+    landmarks = value;
+  }
+
+private:
+  /* Calculate all routes for origin at index. Called from worker threads. */
+  void calculateOrigin(int originIndex, int flownAltitude, Modes mode, bool withLegs);
+
+  const atools::routing::RouteNetwork *network;
+  const atools::routing::RouteLandmarks *landmarks = nullptr;
+  float costFactorForceAirways = 1.3f;
+  int maxThreads = 0;
+
+  QVector<atools::geo::Pos> origins, destinations;
+  int numOrigins = 0, numDestinations = 0;
+
+  /* Origin major matrix. Each worker writes only to the row of its origin. */
+  QVector<atools::routing::RouteMatrixEntry> entries;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTEMATRIX_H
@@ -17,7 +17,11 @@
 
 #include "routing/routenetwork.h"
 
+#include "atools.h"
 #include "geo/calculations.h"
+#include "util/parallel.h"
+
+#include <QElapsedTimer>
 
 using atools::geo::nmToMeter;
 using atools::geo::Point3D;
@@ -49,12 +53,44 @@ RouteNetwork::~RouteNetwork()
 
 void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge *prevEdge) const
 {
-  Q_ASSERT(destinationNode.isValid());
-  Q_ASSERT(departureNode.isValid());
+  getNeighboursInternal(result, parameters, origin, prevEdge, false /* reverse */);
+}
+
+void RouteNetwork::getNeighboursReverse(Result& result, const Node& origin, const Edge *nextEdge) const
+{
+  getNeighboursInternal(result, parameters, origin, nextEdge, true /* reverse */);
+}
+
+void RouteNetwork::getNeighbours(Result& result, const RouteNetworkQuery& query, const Node& origin,
+                                 const Edge *prevEdge) const
+{
+  getNeighboursInternal(result, query, origin, prevEdge, false /* reverse */);
+}
+
+void RouteNetwork::getNeighboursReverse(Result& result, const RouteNetworkQuery& query, const Node& origin,
+                                        const Edge *nextEdge) const
+{
+  getNeighboursInternal(result, query, origin, nextEdge, true /* reverse */);
+}
+
+void RouteNetwork::getNeighboursInternal(Result& result, const RouteNetworkQuery& query, const Node& origin,
+                                         const Edge *prevEdge, bool reverse) const
+{
+  Q_ASSERT(query.destinationNode.isValid());
+  Q_ASSERT(query.departureNode.isValid());
+
+  const Modes& mode = query.mode;
+
+  // Target is destination for forward and departure for backward search
+  const Node& targetNode = reverse ? query.departureNode : query.destinationNode;
+  const Point3D& targetPoint = reverse ? query.departurePoint : query.destinationPoint;
+
+  // Node where the search started - departure for forward search
+  bool originStart = reverse ? origin.isDestination() : origin.isDeparture();
 
   // Node might be also departure or destination
-  Point3D originPoint = point3D(origin.index);
-  float originToDestDist = originPoint.directDistanceMeter(destinationPoint);
+  Point3D originPoint = point3D(query, origin.index);
+  float originToTargetDist = originPoint.directDistanceMeter(targetPoint);
 
   // Check for track/non-track or non-track/track transition if true
   // Limits neighbors if origin is in the middle of a track and not an endpoint
@@ -63,9 +99,12 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
 
   if(source == SOURCE_AIRWAY)
   {
+    // Outgoing edges for forward and incoming edges for backward search
+    EdgeRange edges = reverse ? reverseEdgeIndex.range(origin.index) : edgeIndex.range(origin.index);
+
     // Add airway edges =======================================
-    result.nodes.reserve(origin.edges.size());
-    result.edges.reserve(origin.edges.size());
+    result.nodes.reserve(edges.size());
+    result.edges.reserve(edges.size());
 
     // Avoid duplicates with direct neighbor search
     QSet<int> nodeIndexes;
@@ -73,15 +112,15 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
     if(mode & MODE_AIRWAY)
     {
       // Look at all node edges/airways
-      for(const Edge& edge : origin.edges)
+      for(const Edge& edge : edges)
       {
         // Check if edge type matches criteria (altitude, RNAV and airway type)
-        if(!matchEdge(edge))
+        if(!matchEdge(query, edge))
           continue;
 
         const Node& node = nodeIndex.at(edge.toIndex);
         // Check if node type matches like airway type
-        if(!matchNode(node))
+        if(!matchNode(query, node))
           continue;
 
         // Avoid track transitions at the wrong points
@@ -94,13 +133,13 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
 
         // Edge can have only another node - not departure or destination
         Point3D curPoint = nodeIndex.atPoint3D(edge.toIndex);
-        float curToDestDist = curPoint.directDistanceMeter(destinationPoint);
+        float curToTargetDist = curPoint.directDistanceMeter(targetPoint);
 
-        // Add only nodes/edges that are ahead of the current node and lead towards the destination
-        if(curToDestDist < originToDestDist)
+        // Add only nodes/edges that are ahead of the current node and lead towards the target
+        if(curToTargetDist < originToTargetDist)
         {
           float curToOriginDist = curPoint.directDistanceMeter(originPoint);
-          if(curToDestDist + curToOriginDist < originToDestDist * directDistanceFactorAirway)
+          if(curToTargetDist + curToOriginDist < originToTargetDist * directDistanceFactorAirway)
           {
             result.nodes.append(edge.toIndex);
             result.edges.append(edge);
@@ -113,18 +152,18 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
     }
 
     // Additionally search for direct waypoint connections if result is limited
-    if((mode & MODE_WAYPOINT && result.size() < 2) || origin.isDeparture())
+    if((mode & MODE_WAYPOINT && result.size() < 2) || originStart)
     {
       // Use nearest of underlying waypoint if calculating for selected route legs or looking for
       // nearest airway point
-      float minDist = origin.isDeparture() &&
+      float minDist = originStart &&
                       (mode.testFlag(MODE_POINT_TO_POINT) || mode & MODE_AIRWAY) ? 0.f : minNearestDistanceWpM;
 
-      int found = searchNearest(result, origin, minDist, maxNearestDistanceWpM, &nodeIndexes);
+      int found = searchNearest(result, query, origin, minDist, maxNearestDistanceWpM, &nodeIndexes, reverse);
 
       if(found < 6)
         // Not enough results - try with larger search radius
-        searchNearest(result, origin, minDist * 2, maxNearestDistanceWpM * 5, &nodeIndexes);
+        searchNearest(result, query, origin, minDist * 2, maxNearestDistanceWpM * 5, &nodeIndexes, reverse);
 
       // Check for track transitions and remove any edges/nodes beginning from the end of the list
       if(originNotTrackEnd)
@@ -141,24 +180,28 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
       }
     }
   }
+  else if(origin.index >= 0 && hasRadioNeighbours())
+    // Use precalculated nearest navaids =======================================
+    searchRadioNeighbours(result, query, origin, reverse);
   else
     // Find nearest navaids =======================================
-    searchNearest(result, origin, minNearestDistanceRadioM, maxNearestDistanceRadioM);
+    searchNearest(result, query, origin, minNearestDistanceRadioM, maxNearestDistanceRadioM, nullptr, reverse);
 
-  // Add destination node and calculate edges to it if in range ==========================================
-  if(originToDestDist < nearestDestDistanceM)
+  // Add target node and calculate edges to it if in range ==========================================
+  if(originToTargetDist < (reverse ? nearestDepartureDistanceM : nearestDestDistanceM))
   {
     // Avoid jumping directly into a track
     if(!(originNotTrackEnd && prevEdge->isTrack()))
     {
-      result.nodes.append(destinationNode.index);
-      result.edges.append(Edge(Node::DESTINATION_INDEX, originPoint.gcDistanceMeter(destinationPoint)));
+      result.nodes.append(targetNode.index);
+      result.edges.append(Edge(targetNode.index, originPoint.gcDistanceMeter(targetPoint)));
     }
   }
 }
 
-int RouteNetwork::searchNearest(Result& result, const Node& origin,
-                                float minDistanceMeter, float maxDistanceMeter, const QSet<int> *excludeIndexes) const
+int RouteNetwork::searchNearest(Result& result, const RouteNetworkQuery& query, const Node& origin,
+                                float minDistanceMeter, float maxDistanceMeter, const QSet<int> *excludeIndexes,
+                                bool reverse) const
 {
   /* Callback class used for secondary stage filtering in radius searches.
    * Mainly used to keep all local variables accessible for the callback method. */
@@ -226,21 +269,25 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
     const QSet<int> *excludeIndexes = nullptr;
   };
 
+  // Node where the search started - departure for forward search
+  bool originStart = reverse ? origin.isDestination() : origin.isDeparture();
+
   // Prepare callback with data =========================
+  // Destination is the node where the search ends - departure for backward search
   RadiusCallback callbackObj;
-  callbackObj.origin = nodeToCartesian(origin);
+  callbackObj.origin = nodeToCartesian(query, origin);
   callbackObj.points = nodeIndex.getPoints3D();
   callbackObj.excludeIndexes = (excludeIndexes == nullptr || excludeIndexes->isEmpty()) ? nullptr : excludeIndexes;
   callbackObj.radionav = isRadionavRouting();
-  callbackObj.originDeparture = origin.isDeparture();
+  callbackObj.originDeparture = originStart;
 
   callbackObj.directDistFactor = isAirwayRouting() ? directDistanceFactorWp : directDistanceFactorRadio;
-  callbackObj.originToDestDist = getDirectDistanceMeter(origin, destinationNode);
-  callbackObj.dest = destinationPoint;
+  callbackObj.originToDestDist = getDirectDistanceMeter(origin, reverse ? query.departureNode : query.destinationNode);
+  callbackObj.dest = reverse ? query.departurePoint : query.destinationPoint;
 
   if(callbackObj.radionav)
   {
-    if(origin.isDeparture())
+    if(originStart)
       // Allow all points close to departure
       callbackObj.radiusMin = 0.f;
     else
@@ -249,7 +296,7 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
   }
   else
   {
-    if(origin.isDeparture())
+    if(originStart)
       // Lower minimum distance for departure
       callbackObj.radiusMin = minDistanceMeter / 5.f;
     else
@@ -268,16 +315,17 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
                                                  };
   QVector<int> indexes;
   nodeIndex.getRadiusIndexes(indexes, origin.pos, maxDistanceMeter, callbackFunc);
+  result.numNearestQueries++;
 
   result.nodes.reserve(indexes.size());
   result.edges.reserve(indexes.size());
 
   // Copy node indexes and edges to result ======================
   int numFound = 0;
-  Point3D originPoint = nodeToCartesian(origin);
+  Point3D originPoint = nodeToCartesian(query, origin);
   for(int idx : indexes)
   {
-    if(matchNode(nodeIndex.at(idx)))
+    if(matchNode(query, nodeIndex.at(idx)))
     {
       // Add node and edge leading to it
       result.nodes.append(idx);
@@ -288,74 +336,178 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
   return numFound;
 }
 
+int RouteNetwork::searchRadioNeighbours(Result& result, const RouteNetworkQuery& query, const Node& origin,
+                                        bool reverse) const
+{
+  // Same filter as the callback in searchNearest for nodes not being departure or destination
+  Point3D originPoint = nodeIndex.atPoint3D(origin.index);
+  const Point3D& dest = reverse ? query.departurePoint : query.destinationPoint;
+  float originToDestDist = getDirectDistanceMeter(origin, reverse ? query.departureNode : query.destinationNode);
+  float maxDistance = originToDestDist * directDistanceFactorRadio;
+
+  int first = radioNeighbourOffsets.at(origin.index), last = radioNeighbourOffsets.at(origin.index + 1);
+  result.nodes.reserve(last - first);
+  result.edges.reserve(last - first);
+
+  int numFound = 0;
+  for(int i = first; i < last; i++)
+  {
+    const RadioNeighbour& neighbour = radioNeighbours.at(i);
+    const Point3D& curPt = nodeIndex.atPoint3D(neighbour.index);
+
+    // Include only points ahead of the origin
+    float curToDestDist = curPt.directDistanceMeter(dest);
+    if(curToDestDist >= originToDestDist + 100.f)
+      continue;
+
+    // Total distance (origin -> current -> destination) not much bigger than the direct connection
+    if(curToDestDist + curPt.directDistanceMeter(originPoint) >= maxDistance)
+      continue;
+
+    if(matchNode(query, nodeIndex.at(neighbour.index)))
+    {
+      Edge edge(neighbour.index, 0.f);
+      edge.lengthMeter = neighbour.lengthMeter;
+      result.nodes.append(neighbour.index);
+      result.edges.append(edge);
+      numFound++;
+    }
+  }
+  return numFound;
+}
+
+void RouteNetwork::updateRadioNeighbours(int numThreads)
+{
+  clearRadioNeighbours();
+
+  if(!isRadionavRouting() || nodeIndex.isEmpty())
+    return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  const int MIN_CHUNK_SIZE = 100;
+  int size = nodeIndex.size();
+  int chunks = atools::util::parallelChunks(size, numThreads, MIN_CHUNK_SIZE);
+
+  // Collect neighbours per chunk and number of neighbours per node
+  QVector<QVector<RadioNeighbour> > chunkNeighbours(chunks);
+  QVector<int> counts(size, 0);
+  atools::util::parallelFor(size, chunks, [this, &chunkNeighbours, &counts](int begin, int end, int chunk) -> void {
+    QVector<RadioNeighbour>& neighbours = chunkNeighbours[chunk];
+    QVector<int> indexes;
+    for(int i = begin; i < end; i++)
+    {
+      // Same minimum radius as used by searchNearest for nodes not being departure or destination
+      const Point3D& originPoint = nodeIndex.atPoint3D(i);
+      float radiusMin = minNearestDistanceRadioM;
+      atools::geo::RadiusCallbackType callback = [this, &originPoint, radiusMin](float, int index) -> bool {
+        return !(radiusMin > 0.f) || nodeIndex.atPoint3D(index).directDistanceMeter(originPoint) > radiusMin;
+      };
+
+      indexes.clear();
+      nodeIndex.getRadiusIndexes(indexes, nodeIndex.at(i).pos, maxNearestDistanceRadioM, callback);
+
+      for(int idx : qAsConst(indexes))
+        neighbours.append({idx, static_cast<int>(originPoint.gcDistanceMeter(nodeIndex.atPoint3D(idx)))});
+      counts[i] = indexes.size();
+    }
+  }, MIN_CHUNK_SIZE);
+
+  // Chunks are consecutive ranges - concatenate in order
+  int total = 0;
+  radioNeighbourOffsets.reserve(size + 1);
+  radioNeighbourOffsets.append(0);
+  for(int count : qAsConst(counts))
+  {
+    total += count;
+    radioNeighbourOffsets.append(total);
+  }
+
+  radioNeighbours.reserve(total);
+  for(const QVector<RadioNeighbour>& neighbours : qAsConst(chunkNeighbours))
+    radioNeighbours.append(neighbours);
+
+  qDebug() << Q_FUNC_INFO << timer.elapsed() << "ms" << "nodes" << size << "neighbours" << total
+           << "threads" << chunks;
+}
+
+void RouteNetwork::clearRadioNeighbours()
+{
+  radioNeighbours.clear();
+  radioNeighbourOffsets.clear();
+}
+
 void RouteNetwork::setParameters(const geo::Pos& departurePos, const geo::Pos& destinationPos, int altitudeParam,
                                  Modes modeParam)
 {
-  clearParameters();
+  parameters = createQuery(departurePos, destinationPos, altitudeParam, modeParam);
+}
 
-  altitude = altitudeParam;
-  mode = modeParam;
+RouteNetworkQuery RouteNetwork::createQuery(const geo::Pos& departurePos, const geo::Pos& destinationPos,
+                                            int altitudeParam, Modes modeParam) const
+{
+  RouteNetworkQuery query;
+  query.altitude = altitudeParam;
+  query.mode = modeParam;
 
   if(departurePos.isValid())
   {
     // Add departure node to network ====================
-    departureNode.index = Node::DEPARTURE_INDEX;
-    departureNode.pos = departurePos;
-    departureNode.type = NODE_DEPARTURE;
-    departureNode.range = 0;
-    departureNode.subtype = NODE_NONE;
-    departureNode.con = CONNECTION_NONE;
-    departurePos.toCartesian(departurePoint);
+    query.departureNode.index = Node::DEPARTURE_INDEX;
+    query.departureNode.pos = departurePos;
+    query.departureNode.type = NODE_DEPARTURE;
+    query.departureNode.range = 0;
+    query.departureNode.subtype = NODE_NONE;
+    query.departureNode.con = CONNECTION_NONE;
+    departurePos.toCartesian(query.departurePoint);
   }
 
   if(destinationPos.isValid())
   {
     // Add destination node to network ====================
-    destinationNode.index = Node::DESTINATION_INDEX;
-    destinationNode.pos = destinationPos;
-    destinationNode.type = NODE_DESTINATION;
-    destinationNode.range = 0;
-    destinationNode.subtype = NODE_NONE;
-    destinationNode.con = CONNECTION_NONE;
-    destinationPos.toCartesian(destinationPoint);
+    query.destinationNode.index = Node::DESTINATION_INDEX;
+    query.destinationNode.pos = destinationPos;
+    query.destinationNode.type = NODE_DESTINATION;
+    query.destinationNode.range = 0;
+    query.destinationNode.subtype = NODE_NONE;
+    query.destinationNode.con = CONNECTION_NONE;
+    destinationPos.toCartesian(query.destinationPoint);
 
     if(departurePos.isValid())
     {
-      routeDirectDistance = getDirectDistanceMeter(departureNode, destinationNode);
-      routeGcDistance = getGcDistanceMeter(departureNode, destinationNode);
+      query.routeDirectDistance = getDirectDistanceMeter(query.departureNode, query.destinationNode);
+      query.routeGcDistance = getGcDistanceMeter(query.departureNode, query.destinationNode);
     }
   }
+  return query;
 }
 
 void RouteNetwork::clearParameters()
 {
-  altitude = 0;
-  mode = MODE_ALL;
-  departureNode = Node();
-  departurePoint = Point3D();
-
-  destinationNode = Node();
-  destinationPoint = Point3D();
-  routeDirectDistance = routeGcDistance = 0.f;
+  parameters = RouteNetworkQuery();
 }
 
-const Node& RouteNetwork::getNode(int index) const
+const Node& RouteNetwork::getNode(const RouteNetworkQuery& query, int index) const
 {
   const static atools::routing::Node INVALID;
 
   if(index >= 0)
     return nodeIndex.at(index);
   else if(index == Node::DEPARTURE_INDEX)
-    return departureNode;
+    return query.departureNode;
   else if(index == Node::DESTINATION_INDEX)
-    return destinationNode;
+    return query.destinationNode;
   else
     return INVALID;
 }
 
 void RouteNetwork::setMinNearestDistanceRadioNm(float value)
 {
-  minNearestDistanceRadioM = nmToMeter(value);
+  float distance = nmToMeter(value);
+  if(atools::almostNotEqual(distance, minNearestDistanceRadioM))
+    clearRadioNeighbours();
+  minNearestDistanceRadioM = distance;
 }
 
 void RouteNetwork::setMinNearestDistanceWpNm(float value)
@@ -365,7 +517,10 @@ void RouteNetwork::setMinNearestDistanceWpNm(float value)
 
 void RouteNetwork::setMaxNearestDistanceRadioNm(float value)
 {
-  maxNearestDistanceRadioM = nmToMeter(value);
+  float distance = nmToMeter(value);
+  if(atools::almostNotEqual(distance, maxNearestDistanceRadioM))
+    clearRadioNeighbours();
+  maxNearestDistanceRadioM = distance;
 }
 
 void RouteNetwork::setMaxNearestDistanceWpNm(float value)
@@ -383,22 +538,23 @@ void RouteNetwork::setNearestDestDistanceNm(float value)
   nearestDestDistanceM = nmToMeter(value);
 }
 
-const geo::Point3D& RouteNetwork::point3D(int index) const
+const geo::Point3D& RouteNetwork::point3D(const RouteNetworkQuery& query, int index) const
 {
   const static Point3D INVALID;
 
   if(index >= 0)
     return nodeIndex.atPoint3D(index);
   else if(index == Node::DEPARTURE_INDEX)
-    return departurePoint;
+    return query.departurePoint;
   else if(index == Node::DESTINATION_INDEX)
-    return destinationPoint;
+    return query.destinationPoint;
   else
     return INVALID;
 }
 
-bool RouteNetwork::matchNode(const Node& node) const
+bool RouteNetwork::matchNode(const RouteNetworkQuery& query, const Node& node) const
 {
+  const Modes& mode = query.mode;
   atools::routing::NodeType nodeType = node.type;
   bool ok = true;
 
@@ -445,8 +601,10 @@ bool RouteNetwork::matchNode(const Node& node) const
   return ok;
 }
 
-bool RouteNetwork::matchEdge(const Edge& edge) const
+bool RouteNetwork::matchEdge(const RouteNetworkQuery& query, const Edge& edge) const
 {
+  const Modes& mode = query.mode;
+  int altitude = query.altitude;
   bool ok = (altitude == 0 || (altitude >= edge.minAltFt && altitude <= edge.maxAltFt));
 
   // Check if RNAV has to be excluded
@@ -474,13 +632,161 @@ bool RouteNetwork::matchEdge(const Edge& edge) const
   return ok;
 }
 
+void RouteNetwork::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  using atools::util::MemoryAccounting;
+
+  bytes += nodeIndex.getMemoryBytes() + MemoryAccounting::vectorBytes(radioNeighbours) +
+           MemoryAccounting::vectorBytes(radioNeighbourOffsets) + MemoryAccounting::vectorBytes(baseConnections) +
+           MemoryAccounting::hashBytes(baseNodeIdIndex) + MemoryAccounting::hashBytes(altLevelsEast) +
+           MemoryAccounting::hashBytes(altLevelsWest);
+
+  for(const EdgeIndex *index : {&edgeIndex, &reverseEdgeIndex, &baseEdgeIndex})
+    bytes += MemoryAccounting::vectorBytes(index->edges) + MemoryAccounting::vectorBytes(index->offsets);
+
+  for(const QVector<quint16>& levels : altLevelsEast)
+    bytes += MemoryAccounting::vectorBytes(levels);
+  for(const QVector<quint16>& levels : altLevelsWest)
+    bytes += MemoryAccounting::vectorBytes(levels);
+
+  elements += nodeIndex.size();
+}
+
 void RouteNetwork::clear()
 {
   clearParameters();
   nodeIndex.clear();
   nodeIndex.updateIndex();
+  edgeIndex.clear();
+  reverseEdgeIndex.clear();
+  clearRadioNeighbours();
+  altLevelsEast.clear();
+  altLevelsWest.clear();
+
+  numBaseNodes = -1;
+  baseEdgeIndex.clear();
+  baseConnections.clear();
+  baseNodeIdIndex.clear();
+}
+
+void RouteNetwork::initTrackOverlay()
+{
+  if(numBaseNodes != -1)
+    return;
+
+  numBaseNodes = nodeIndex.size();
+
+  // Copy all edges except tracks ======================
+  baseEdgeIndex.clear();
+  baseEdgeIndex.reserve(numBaseNodes, edgeIndex.edges.size());
+  baseConnections.reserve(numBaseNodes);
+  baseNodeIdIndex.reserve(numBaseNodes);
+  for(const Node& node : qAsConst(nodeIndex))
+  {
+    for(const Edge& edge : edgeIndex.range(node.index))
+    {
+      if(!edge.isTrack())
+        baseEdgeIndex.appendEdge(edge);
+    }
+    baseEdgeIndex.finishNode();
+
+    NodeConnections connections = edgeConnections(baseEdgeIndex.range(node.index));
+    baseConnections.append(static_cast<NodeConnection>(connections.operator unsigned int()));
+    baseNodeIdIndex.insert(node.id, node.index);
+  }
+}
+
+void RouteNetwork::setTrackOverlay(const QVector<Node>& trackNodes, const QMultiHash<int, Edge>& trackEdges,
+                                   const QSet<int>& startEndIds)
+{
+  if(!isAirwayRouting() || !isLoaded())
+    return;
+
+  clearParameters();
+  initTrackOverlay();
+
+  // Collect track points which are not part of the base network ======================
+  QVector<Node> overlayNodes;
+  for(const Node& node : trackNodes)
+  {
+    if(!baseNodeIdIndex.contains(node.id))
+      overlayNodes.append(node);
+  }
+
+  // Check if appended nodes changed and update spatial index only if needed ======================
+  bool nodesChanged = overlayNodes.size() != nodeIndex.size() - numBaseNodes;
+  for(int i = 0; i < overlayNodes.size() && !nodesChanged; i++)
+  {
+    const Node& cur = nodeIndex.at(numBaseNodes + i);
+    nodesChanged = cur.id != overlayNodes.at(i).id || cur.pos != overlayNodes.at(i).pos;
+  }
+
+  if(nodesChanged)
+  {
+    nodeIndex.resize(numBaseNodes);
+    for(Node node : qAsConst(overlayNodes))
+    {
+      node.index = nodeIndex.size();
+      node.setConnections(CONNECTION_NONE);
+      nodeIndex.append(node);
+    }
+    nodeIndex.updateIndex(0);
+  }
+
+  // Map ids of appended nodes
+  QHash<int, int> overlayNodeIdIndex;
+  for(int i = numBaseNodes; i < nodeIndex.size(); i++)
+    overlayNodeIdIndex.insert(nodeIndex.at(i).id, i);
+
+  auto indexForId = [this, &overlayNodeIdIndex](int id) -> int {
+                      int index = baseNodeIdIndex.value(id, -1);
+                      return index != -1 ? index : overlayNodeIdIndex.value(id, -1);
+                    };
+
+  // Merge base and track edges into new edge index ======================
+  EdgeIndex newEdgeIndex;
+  newEdgeIndex.reserve(nodeIndex.size(), baseEdgeIndex.edges.size() + trackEdges.size());
+  for(Node& node : nodeIndex)
+  {
+    bool baseNode = node.index < numBaseNodes;
+    if(baseNode)
+    {
+      for(const Edge& edge : baseEdgeIndex.range(node.index))
+        newEdgeIndex.appendEdge(edge);
+    }
+
+    bool hasTrackEdges = false;
+    for(auto it = trackEdges.find(node.id); it != trackEdges.end() && it.key() == node.id; ++it)
+    {
+      Edge edge = it.value();
+      edge.toIndex = indexForId(edge.toIndex);
+      if(edge.toIndex == -1)
+        continue;
+
+      edge.lengthMeter = atools::roundToInt(nodeIndex.atPoint3D(node.index).
+                                            gcDistanceMeter(nodeIndex.atPoint3D(edge.toIndex)));
+      newEdgeIndex.appendEdge(edge);
+      hasTrackEdges = true;
+    }
+    newEdgeIndex.finishNode();
+
+    // Reset connection flags to base and add tracks ==============
+    node.con = baseNode ? baseConnections.at(node.index) : CONNECTION_NONE;
+    if(hasTrackEdges)
+      node.addConnection(CONNECTION_TRACK);
+    if(startEndIds.contains(node.id))
+      node.addConnection(CONNECTION_TRACK_START_END);
+  }
+
+  edgeIndex = newEdgeIndex;
+  reverseEdgeIndex = edgeIndex.reversed();
+}
+
+void RouteNetwork::clearTrackOverlay()
+{
   altLevelsEast.clear();
   altLevelsWest.clear();
+  setTrackOverlay(QVector<Node>(), QMultiHash<int, Edge>(), QSet<int>());
 }
 
 bool RouteNetwork::isLoaded() const
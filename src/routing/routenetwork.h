@@ -20,12 +20,31 @@
 
 #include "geo/spatialindex.h"
 #include "routing/routenetworktypes.h"
+#include "util/memoryaccounting.h"
 
 namespace atools {
 namespace routing {
 
 class RouteNetworkLoader;
 
+/*
+ * Parameters and virtual departure and destination nodes for one route calculation.
+ * Created by RouteNetwork::createQuery(). Using separate query objects allows to use one loaded
+ * RouteNetwork from several threads at the same time.
+ */
+struct RouteNetworkQuery
+{
+  /* Used to filter airway edges by altitude restrictions. */
+  int altitude = 0;
+
+  /* Filter for getNeighbours */
+  atools::routing::Modes mode = atools::routing::MODE_ALL;
+
+  atools::routing::Node departureNode, destinationNode;
+  atools::geo::Point3D departurePoint, destinationPoint;
+  float routeDirectDistance = 0.f, routeGcDistance = 0.f;
+};
+
 /*
  * Network forming a directed graph by navaid nodes and airway edges or generated edges by neares neighbor search.
  * The class already applies various filtering mechanisms (e.g. distance to destination) when looking for nearest nodes.
@@ -35,16 +54,20 @@ class RouteNetworkLoader;
  *
  * Several optimizations limit the number of returned neighbors.
  *
- * The class has a state (i.e. start and destination) and is not re-entrant.
+ * Network data is not changed after loading. All methods taking a RouteNetworkQuery are const and re-entrant
+ * and can be called from several threads at the same time with one query object per thread.
  *
- * A call to setParameters with valid departure and destination is required before using any other methods.
+ * The convenience methods without query parameter use an internal state (i.e. start and destination)
+ * and are not re-entrant. A call to setParameters with valid departure and destination is required
+ * before using these.
  */
-class RouteNetwork
+class RouteNetwork :
+  public atools::util::MemoryAccountable
 {
 public:
   /* Does not load the data */
   RouteNetwork(atools::routing::DataSource dataSource);
-  virtual ~RouteNetwork();
+  virtual ~RouteNetwork() override;
 
   /* true if network is loaded. */
   bool isLoaded() const;
@@ -52,6 +75,9 @@ public:
   /* Remove departure and destination nodes */
   void clear();
 
+  /* Nodes, spatial index, edges and neighbour lists. Elements are nodes. Nothing can be released. */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+
   /* Get all adjacent nodes and attached edges for the given node. Edges might be different than Node::edges.
    * Adjacent objects are filtered based on distance and type criteria like airway types.
    * Edges may be airways or generated edges by nearest neighbor search.
@@ -59,6 +85,20 @@ public:
   void getNeighbours(atools::routing::Result& result, const atools::routing::Node& origin,
                      const Edge *prevEdge = nullptr) const;
 
+  /* Same as above but using the given query instead of the internal parameters. Re-entrant. */
+  void getNeighbours(atools::routing::Result& result, const atools::routing::RouteNetworkQuery& query,
+                     const atools::routing::Node& origin, const Edge *prevEdge = nullptr) const;
+
+  /* Same as above but for a backward search from destination to departure. Uses incoming edges and
+   * filters adjacent nodes by distance to departure. Returned edges have toIndex set to the adjacent node which is
+   * the predecessor of origin in flight direction. nextEdge is the edge leaving origin in flight direction. */
+  void getNeighboursReverse(atools::routing::Result& result, const atools::routing::Node& origin,
+                            const Edge *nextEdge = nullptr) const;
+
+  /* Same as above but using the given query instead of the internal parameters. Re-entrant. */
+  void getNeighboursReverse(atools::routing::Result& result, const atools::routing::RouteNetworkQuery& query,
+                            const atools::routing::Node& origin, const Edge *nextEdge = nullptr) const;
+
   /* Same as above but uses a the nearest node for the position. */
   void getNeighbours(atools::routing::Result& result, const atools::geo::Pos& origin,
                      const Edge *prevEdge = nullptr) const
@@ -82,27 +122,39 @@ public:
   }
 
   /* Integrate departure and destination positions into the network as virtual nodes/edges.
-   * Altitude is used to filter airway edges if > 0. Modes provides and additional neighbour filter. */
+   * Altitude is used to filter airway edges if > 0. Modes provides and additional neighbour filter.
+   * Changes the internal state. */
   void setParameters(const atools::geo::Pos& departurePos, const atools::geo::Pos& destinationPos,
                      int altitudeParam, atools::routing::Modes modeParam);
 
+  /* Same as above but returns a query object for use with the re-entrant methods. Does not change the network. */
+  atools::routing::RouteNetworkQuery createQuery(const atools::geo::Pos& departurePos,
+                                                 const atools::geo::Pos& destinationPos,
+                                                 int altitudeParam, atools::routing::Modes modeParam) const;
+
   /* Reset all parameters set by above method*/
   void clearParameters();
 
   /* Get the virtual departure node that was added using setParameters */
   const atools::routing::Node& getDepartureNode() const
   {
-    return departureNode;
+    return parameters.departureNode;
   }
 
   /* Get the virtual destination node that was added using setParameters */
   const atools::routing::Node& getDestinationNode() const
   {
-    return destinationNode;
+    return parameters.destinationNode;
   }
 
   /* Get a node by routing network node index. If index is -1 an invalid node with id -1 is returned */
-  const atools::routing::Node& getNode(int index) const;
+  const atools::routing::Node& getNode(int index) const
+  {
+    return getNode(parameters, index);
+  }
+
+  /* Same as above but returns departure and destination from the given query. Re-entrant. */
+  const atools::routing::Node& getNode(const atools::routing::RouteNetworkQuery& query, int index) const;
 
   /* Get a single nearest node to the position. */
   const atools::routing::Node& getNearestNode(const atools::geo::Pos& pos) const
@@ -116,6 +168,19 @@ public:
     return nodeIndex;
   }
 
+  /* Outgoing airway and track edges of node at index. Empty for departure, destination and radio navaid networks.
+   * Do not use this for routing since edges are not filtered. Use getNeighbours instead. */
+  atools::routing::EdgeRange getEdges(int index) const
+  {
+    return edgeIndex.range(index);
+  }
+
+  /* Incoming airway and track edges of node at index. Edge::toIndex points to the node where the edge starts. */
+  atools::routing::EdgeRange getReverseEdges(int index) const
+  {
+    return reverseEdgeIndex.range(index);
+  }
+
   /* true if airways and other navaids are used as data source. */
   bool isAirwayRouting() const
   {
@@ -137,6 +202,18 @@ public:
   /* Maximum distance for nearest neighbor search. Only for radionav search (SOURCE_RADIO). */
   void setMaxNearestDistanceRadioNm(float value);
 
+  /* Precalculate neighbours of all nodes for radionav search (SOURCE_RADIO) in parallel.
+   * getNeighbours() then uses these lists and applies only the filters depending on the destination instead of
+   * a spatial query for each node. Called by RouteNetworkLoader. Changing the radio distances clears the lists.
+   * Does nothing for airway networks. numThreads: 0 uses the number of cores. */
+  void updateRadioNeighbours(int numThreads = 0);
+  void clearRadioNeighbours();
+
+  bool hasRadioNeighbours() const
+  {
+    return !radioNeighbourOffsets.isEmpty();
+  }
+
   /* Maximum distance for nearest neighbor search. Only for airway/waypoint search (SOURCE_AIRWAY). */
   void setMaxNearestDistanceWpNm(float value);
 
@@ -177,32 +254,75 @@ public:
     return altLevelsWest.value(trackId);
   }
 
+  /* Replace all track nodes and edges in a loaded airway network without reloading. Tracks loaded with the network
+   * are removed on first call. Not reentrant and must not be called while routing.
+   *
+   * trackNodes: Track waypoints. Nodes with an id already in the network are merged. Others are appended which
+   *             requires an update of the spatial index if they differ from the last call. Node::index is ignored.
+   * trackEdges: Outgoing edges keyed by database id of the start node. Edge::toIndex has to contain the database id
+   *             of the end node. Distances are calculated.
+   * startEndIds: Database ids of track start and end points.
+   *
+   * Altitude levels have to be updated separately. RouteNetworkLoader::loadTracks() does all this.
+   * Landmarks in RouteLandmarks have to be rebuilt after changing tracks. */
+  void setTrackOverlay(const QVector<atools::routing::Node>& trackNodes,
+                       const QMultiHash<int, atools::routing::Edge>& trackEdges, const QSet<int>& startEndIds);
+
+  /* Remove all tracks */
+  void clearTrackOverlay();
+
   /* Mode that defines which features are used for edge filtering (airways, tracks, direct connections, etc.) */
   atools::routing::Modes getMode() const
   {
-    return mode;
+    return parameters.mode;
   }
 
 private:
   friend class atools::routing::RouteNetworkLoader;
 
-  /* Get nearest nodes and edges */
-  int searchNearest(atools::routing::Result& result, const Node& origin, float minDistanceMeter,
-                    float maxDistanceMeter, const QSet<int> *excludeIndexes = nullptr) const;
+  /* Shared implementation for getNeighbours and getNeighboursReverse */
+  void getNeighboursInternal(atools::routing::Result& result, const atools::routing::RouteNetworkQuery& query,
+                             const atools::routing::Node& origin, const Edge *prevEdge, bool reverse) const;
+
+  /* Get nearest nodes and edges. Filters by distance to departure instead of destination if reverse is true. */
+  int searchNearest(atools::routing::Result& result, const atools::routing::RouteNetworkQuery& query,
+                    const Node& origin, float minDistanceMeter, float maxDistanceMeter,
+                    const QSet<int> *excludeIndexes = nullptr, bool reverse = false) const;
+
+  /* Same as searchNearest for radionav networks but uses the precalculated neighbours */
+  int searchRadioNeighbours(atools::routing::Result& result, const atools::routing::RouteNetworkQuery& query,
+                            const Node& origin, bool reverse) const;
+
+  /* Remember network without tracks on first overlay call */
+  void initTrackOverlay();
 
   /* Check node filter based on mode. */
-  bool matchNode(const Node& node) const;
+  bool matchNode(const atools::routing::RouteNetworkQuery& query, const Node& node) const;
+
+  /* Uses precalculated points from index or query for departure and destination */
+  atools::geo::Point3D nodeToCartesian(const atools::routing::RouteNetworkQuery& query,
+                                       const atools::routing::Node& node) const
+  {
+    if(node.index >= 0)
+      return nodeIndex.atPoint3D(node.index);
+    else if(node.index == Node::DEPARTURE_INDEX && query.departurePoint.isValid())
+      return query.departurePoint;
+    else if(node.index == Node::DESTINATION_INDEX && query.destinationPoint.isValid())
+      return query.destinationPoint;
+    else
+      return node.pos.toCartesian();
+  }
 
   atools::geo::Point3D nodeToCartesian(const atools::routing::Node& node) const
   {
-    return node.index >= 0 ? nodeIndex.atPoint3D(node.index) : node.pos.toCartesian();
+    return nodeToCartesian(parameters, node);
   }
 
   /* Check if altitude, RNAV constraints and more allow to use this edge */
-  bool matchEdge(const atools::routing::Edge& edge) const;
+  bool matchEdge(const atools::routing::RouteNetworkQuery& query, const atools::routing::Edge& edge) const;
 
   /* Get point in 3D space. Returns destination or departure for appropriate indexes. */
-  const atools::geo::Point3D& point3D(int index) const;
+  const atools::geo::Point3D& point3D(const atools::routing::RouteNetworkQuery& query, int index) const;
 
   /* All distances in meter */
   float minNearestDistanceRadioM, maxNearestDistanceRadioM,
@@ -211,19 +331,35 @@ private:
 
   float directDistanceFactorRadio, directDistanceFactorWp, directDistanceFactorAirway;
 
-  /* Used to filter airway edges by altitude restrictions. */
-  int altitude = 0;
-
-  /* Filter for getNeighbours */
-  atools::routing::Modes mode = atools::routing::MODE_ALL;
-
-  atools::routing::Node departureNode, destinationNode;
-  atools::geo::Point3D departurePoint, destinationPoint;
-  float routeDirectDistance = 0.f, routeGcDistance = 0.f;
+  /* Internal state used by setParameters and all methods not taking a query */
+  atools::routing::RouteNetworkQuery parameters;
 
   /* Spatial index for nearest neighbor search using KD-tree internally */
   atools::geo::SpatialIndex<Node> nodeIndex;
 
+  /* Precalculated node index and great circle distance to all nodes within the radio distances */
+  struct RadioNeighbour
+  {
+    int index, lengthMeter;
+  };
+
+  /* Neighbours of node i are radioNeighbours[radioNeighbourOffsets[i]] up to
+   * radioNeighbours[radioNeighbourOffsets[i + 1] - 1] like in EdgeIndex. Empty if not calculated. */
+  QVector<RadioNeighbour> radioNeighbours;
+  QVector<int> radioNeighbourOffsets;
+
+  /* Outgoing and incoming airway edges for all nodes in nodeIndex order */
+  atools::routing::EdgeIndex edgeIndex, reverseEdgeIndex;
+
+  /* Network without tracks for overlays. numBaseNodes is -1 if not initialized.
+   *  Nodes from baseNumNodes to end of nodeIndex are track points not in the base network. */
+  int numBaseNodes = -1;
+  atools::routing::EdgeIndex baseEdgeIndex;
+  QVector<atools::routing::NodeConnection> baseConnections;
+
+  /* Map database id to node index for base network */
+  QHash<int, int> baseNodeIdIndex;
+
   /* Map database track.track_id to altitude levels if existing */
   QHash<int, QVector<quint16> > altLevelsEast, altLevelsWest;
 
@@ -21,15 +21,22 @@
 #include "io/binaryutil.h"
 #include "routing/routenetwork.h"
 #include "sql/sqldatabase.h"
+#include "sql/sqlnativequery.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
 #include "sql/sqlutil.h"
 #include "track/tracktypes.h"
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSysInfo>
 
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
+using atools::sql::SqlNativeQuery;
 using atools::geo::nmToMeter;
 using atools::geo::Point3D;
 using atools::charAt;
@@ -66,6 +73,18 @@ void RouteNetworkLoader::load(atools::routing::RouteNetwork *networkParam)
   network = networkParam;
   network->clear();
 
+  QString key;
+  if(!snapshotFile.isEmpty())
+  {
+    key = snapshotKey();
+    if(readSnapshot(key))
+    {
+      network->updateRadioNeighbours();
+      qDebug() << Q_FUNC_INFO << "snapshot" << timer.restart() << "ms" << "nodes" << network->getNodes().size();
+      return;
+    }
+  }
+
   bool hasTracks = dbTrack != nullptr && SqlUtil(dbTrack).hasTableAndRows("track");
   bool hasNav = dbNav != nullptr && SqlUtil(dbNav).hasTableAndRows("waypoint");
 
@@ -161,69 +180,245 @@ void RouteNetworkLoader::load(atools::routing::RouteNetwork *networkParam)
                       "where w.type = 'N' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)",
                       false, true /* NDB */, false, false);
 
-    // Insert outgoing edges to each node and copy node to the index ========================
+    // Insert outgoing edges of each node into the edge index and copy node to the index ========================
     network->nodeIndex.reserve(nodeVector.size());
-    for(Node& node : nodeVector)
+    network->edgeIndex.reserve(nodeVector.size(), nodeEdgeMap.size());
+    for(const Node& node : nodeVector)
     {
       for(auto it = nodeEdgeMap.find(node.id); it != nodeEdgeMap.end() && it.key() == node.id; ++it)
-        node.edges.append(it.value());
-
-      // Replace database ids in Edge::toIndex with array indexes
-      for(Edge& edge : node.edges)
+      {
+        // Replace database ids in Edge::toIndex with array indexes
+        Edge edge = it.value();
         edge.toIndex = nodeIdIndexMap.value(edge.toIndex);
+        network->edgeIndex.appendEdge(edge);
+      }
+      network->edgeIndex.finishNode();
 
       network->nodeIndex.append(node);
     }
   } // else if(network->source == SOURCE_AIRWAY)
 
-  // Update spatial index
-  network->nodeIndex.updateIndex();
+  // Update spatial index or load it from cache file next to the snapshot
+  if(!snapshotFile.isEmpty())
+    network->nodeIndex.loadOrUpdateIndex(snapshotIndexFile(), snapshotIndexVersion(key));
+  else
+    network->nodeIndex.updateIndex();
 
   // Calculate distance for all edges of all nodes and set node connection flags ================
+  QVector<Edge>& edges = network->edgeIndex.edges;
+  const QVector<int>& offsets = network->edgeIndex.offsets;
   for(Node& node : network->nodeIndex)
   {
-    atools::routing::NodeConnections connections = CONNECTION_NONE;
-    for(Edge& edge : node.edges)
-    {
-      // Fill connection flags based on outgoing edges
-      switch(edge.type)
-      {
-        case atools::routing::EDGE_NONE:
-          break;
-
-        case atools::routing::EDGE_VICTOR:
-          connections |= CONNECTION_VICTOR;
-          break;
-
-        case atools::routing::EDGE_JET:
-          connections |= CONNECTION_JET;
-          break;
-
-        case atools::routing::EDGE_BOTH:
-          connections |= CONNECTION_AIRWAY_BOTH;
-          break;
-
-        case atools::routing::EDGE_TRACK:
-          connections |= CONNECTION_TRACK;
-          break;
-      }
+    if(node.index + 1 >= offsets.size())
+      // No edges for radio navaid network
+      break;
 
+    for(int i = offsets.at(node.index); i < offsets.at(node.index + 1); i++)
+    {
       // Calculate great circle distance for all edges ====================
+      Edge& edge = edges[i];
       edge.lengthMeter = atools::roundToInt(network->nodeIndex.atPoint3D(node.index).
                                             gcDistanceMeter(network->nodeIndex.atPoint3D(edge.toIndex)));
     }
 
-    node.setConnections(connections);
+    // Fill connection flags based on outgoing edges
+    node.setConnections(edgeConnections(network->edgeIndex.range(node.index)));
   }
 
+  // Collect incoming edges for each node to allow backward search ================
+  network->reverseEdgeIndex = network->edgeIndex.reversed();
+
   // Assign CONNECTION_TRACK_START_END to all nodes which are track end or start points
   if(hasTracks)
-    readTrackStartEndPoints();
+  {
+    // Build a temporary index mapping id to array index
+    QHash<int, int> nodeIdIndexMap;
+    for(const Node& node : network->getNodes())
+      nodeIdIndexMap.insert(node.id, node.index);
+
+    for(int id : readTrackStartEndIds())
+    {
+      int index = nodeIdIndexMap.value(id, -1);
+      if(index != -1)
+        network->nodeIndex[index].addConnection(CONNECTION_TRACK_START_END);
+    }
+  }
+
+  if(!snapshotFile.isEmpty())
+    writeSnapshot(key);
+
+  // Neighbour lists for radio navaid networks - depend on distance settings and are not part of the snapshot
+  network->updateRadioNeighbours();
 
   qDebug() << Q_FUNC_INFO << timer.restart() << "ms" << "nodes" << network->getNodes().size();
 }
 
-void RouteNetworkLoader::readTrackStartEndPoints() const
+QString RouteNetworkLoader::snapshotKey() const
+{
+  QStringList key;
+  key << QString::number(network->source);
+
+  if(dbNav != nullptr)
+  {
+    // Database file name, size and modification time
+    QFileInfo fi(dbNav->databaseName());
+    key << fi.canonicalFilePath() << QString::number(fi.size())
+        << QString::number(fi.lastModified().toMSecsSinceEpoch());
+
+    SqlUtil util(dbNav);
+    if(util.hasTableAndRows("metadata"))
+    {
+      SqlQuery query("select last_load_timestamp, airac_cycle from metadata", dbNav);
+      query.exec();
+      if(query.next())
+        key << query.valueStr(0) << query.valueStr(1);
+    }
+  }
+
+  if(dbTrack != nullptr && SqlUtil(dbTrack).hasTableAndRows("track"))
+  {
+    // Track database is usually in memory and changes more often - use content
+    SqlQuery query("select count(1), max(track_id), sum(from_waypoint_id + to_waypoint_id) from track", dbTrack);
+    query.exec();
+    if(query.next())
+      key << query.valueStr(0) << query.valueStr(1) << query.valueStr(2);
+  }
+  return key.join('|');
+}
+
+void RouteNetworkLoader::writeSnapshot(const QString& key) const
+{
+  QSaveFile file(snapshotFile);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // Edges and offsets are saved as raw memory blocks - store byte order and struct size to detect changes
+    out << SNAPSHOT_MAGIC_NUMBER << SNAPSHOT_VERSION << static_cast<qint32>(QSysInfo::ByteOrder)
+        << static_cast<quint32>(sizeof(Edge)) << key;
+
+    // Nodes ==============================
+    const QVector<Node>& nodes = network->getNodes();
+    out << static_cast<qint32>(nodes.size());
+    for(const Node& node : nodes)
+      out << node.id << node.range << node.pos.getLonX() << node.pos.getLatY()
+          << static_cast<quint8>(node.type) << static_cast<quint8>(node.subtype) << static_cast<quint8>(node.con);
+
+    // Edges ==============================
+    for(const EdgeIndex *index : {&network->edgeIndex, &network->reverseEdgeIndex})
+    {
+      out << static_cast<qint32>(index->offsets.size()) << static_cast<qint32>(index->edges.size());
+      out.writeRawData(reinterpret_cast<const char *>(index->offsets.constData()),
+                       index->offsets.size() * static_cast<int>(sizeof(int)));
+      out.writeRawData(reinterpret_cast<const char *>(index->edges.constData()),
+                       index->edges.size() * static_cast<int>(sizeof(Edge)));
+    }
+
+    // Track altitude levels
+    out << network->altLevelsEast << network->altLevelsWest;
+
+    if(out.status() != QDataStream::Ok || !file.commit())
+      qWarning() << Q_FUNC_INFO << "Cannot write snapshot" << snapshotFile << ":" << file.errorString();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write snapshot" << snapshotFile << ":" << file.errorString();
+}
+
+bool RouteNetworkLoader::readSnapshot(const QString& key)
+{
+  QFile file(snapshotFile);
+  if(!file.exists())
+    return false;
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read snapshot" << snapshotFile << ":" << file.errorString();
+    return false;
+  }
+
+  // Map file into memory and read from the mapped area without copying the file
+  uchar *data = file.map(0, file.size());
+  if(data == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot map snapshot" << snapshotFile << ":" << file.errorString();
+    return false;
+  }
+
+  QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(file.size()));
+  QDataStream in(bytes);
+  in.setVersion(QDataStream::Qt_5_5);
+  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  quint32 magic, edgeSize;
+  quint16 version;
+  qint32 byteOrder;
+  QString fileKey;
+  in >> magic >> version >> byteOrder >> edgeSize >> fileKey;
+
+  if(magic != SNAPSHOT_MAGIC_NUMBER || version != SNAPSHOT_VERSION || byteOrder != QSysInfo::ByteOrder ||
+     edgeSize != sizeof(Edge))
+  {
+    qInfo() << Q_FUNC_INFO << "Snapshot" << snapshotFile << "has invalid format or version";
+    return false;
+  }
+
+  if(fileKey != key)
+  {
+    qInfo() << Q_FUNC_INFO << "Snapshot" << snapshotFile << "is outdated";
+    return false;
+  }
+
+  // Nodes ==============================
+  qint32 numNodes;
+  in >> numNodes;
+  network->nodeIndex.reserve(numNodes);
+  for(int i = 0; i < numNodes && in.status() == QDataStream::Ok; i++)
+  {
+    Node node;
+    float lonx, laty;
+    quint8 type, subtype, con;
+    in >> node.id >> node.range >> lonx >> laty >> type >> subtype >> con;
+    node.index = i;
+    node.pos = atools::geo::Pos(lonx, laty);
+    node.type = static_cast<NodeType>(type);
+    node.subtype = static_cast<NodeType>(subtype);
+    node.con = static_cast<NodeConnection>(con);
+    network->nodeIndex.append(node);
+  }
+
+  // Edges ==============================
+  for(EdgeIndex *index : {&network->edgeIndex, &network->reverseEdgeIndex})
+  {
+    qint32 numOffsets = 0, numEdges = 0;
+    in >> numOffsets >> numEdges;
+    if(numOffsets < 0 || numEdges < 0)
+      in.setStatus(QDataStream::ReadCorruptData);
+
+    if(in.status() != QDataStream::Ok)
+      break;
+
+    index->offsets.resize(numOffsets);
+    index->edges.resize(numEdges);
+    in.readRawData(reinterpret_cast<char *>(index->offsets.data()), numOffsets * static_cast<int>(sizeof(int)));
+    in.readRawData(reinterpret_cast<char *>(index->edges.data()), numEdges * static_cast<int>(sizeof(Edge)));
+  }
+
+  in >> network->altLevelsEast >> network->altLevelsWest;
+
+  if(in.status() != QDataStream::Ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Snapshot" << snapshotFile << "is truncated";
+    network->clear();
+    return false;
+  }
+
+  network->nodeIndex.loadOrUpdateIndex(snapshotIndexFile(), snapshotIndexVersion(key));
+  return true;
+}
+
+QSet<int> RouteNetworkLoader::readTrackStartEndIds() const
 {
   enum
   {
@@ -231,18 +426,55 @@ void RouteNetworkLoader::readTrackStartEndPoints() const
     ENDPOINT_ID
   };
 
-  // Build a temporary index mapping id to array index
-  QHash<int, int> nodeIdIndexMap;
-  for(const Node& node : network->getNodes())
-    nodeIdIndexMap.insert(node.id, node.index);
-
+  QSet<int> ids;
   SqlQuery query("select startpoint_id, endpoint_id from trackmeta", dbTrack);
   query.exec();
   while(query.next())
   {
-    network->nodeIndex[nodeIdIndexMap.value(query.valueInt(STARTPOINT_ID))].addConnection(CONNECTION_TRACK_START_END);
-    network->nodeIndex[nodeIdIndexMap.value(query.valueInt(ENDPOINT_ID))].addConnection(CONNECTION_TRACK_START_END);
+    ids.insert(query.valueInt(STARTPOINT_ID));
+    ids.insert(query.valueInt(ENDPOINT_ID));
   }
+  return ids;
+}
+
+void RouteNetworkLoader::loadTracks(RouteNetwork *networkParam)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  network = networkParam;
+
+  if(network->source != SOURCE_AIRWAY || !network->isLoaded())
+  {
+    qWarning() << Q_FUNC_INFO << "Network not loaded or no airway network";
+    return;
+  }
+
+  // Levels are only used by tracks - replaced by readEdgesAirway
+  network->altLevelsEast.clear();
+  network->altLevelsWest.clear();
+
+  QMultiHash<int, Edge> nodeEdgeMap;
+  QVector<Node> nodeVector;
+  QSet<int> startEndIds;
+
+  if(dbTrack != nullptr && SqlUtil(dbTrack).hasTableAndRows("track"))
+  {
+    readEdgesAirway(nodeEdgeMap, true /* track */);
+
+    // Track points which are navdata waypoints are merged with the existing nodes by id
+    QHash<int, int> nodeIdIndexMap;
+    readNodesAirway(nodeVector, nodeIdIndexMap,
+                    "select w.trackpoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway "
+                    "from trackpoint w", false, false, true /* track */, false);
+
+    startEndIds = readTrackStartEndIds();
+  }
+
+  network->setTrackOverlay(nodeVector, nodeEdgeMap, startEndIds);
+
+  qDebug() << Q_FUNC_INFO << timer.restart() << "ms" << "track nodes" << nodeVector.size()
+           << "track edges" << nodeEdgeMap.size();
 }
 
 void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, bool track) const
@@ -436,8 +668,8 @@ void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>&
     }
   }
 
-  SqlQuery query(queryStr, track ? dbTrack : dbNav);
-  query.exec();
+  // Uses native access if available since this reads all waypoints
+  SqlNativeQuery query(queryStr, track ? dbTrack : dbNav);
   while(query.next())
   {
     int nodeId = query.valueInt(ID);
@@ -493,7 +725,7 @@ void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>&
     // Connection flags are populated later by analyzing edges
 
     if(node.type == NODE_NONE)
-      qWarning() << Q_FUNC_INFO << "No node type" << query.record();
+      qWarning() << Q_FUNC_INFO << "No node type" << query.getQueryString() << "id" << nodeId;
 
     nodes.append(node);
     nodeIdIndexMap.insert(node.id, node.index);
@@ -513,8 +745,7 @@ void RouteNetworkLoader::readNodesRadio(const QString& queryStr, bool vor)
     HAS_DME
   };
 
-  SqlQuery query(queryStr, dbNav);
-  query.exec();
+  SqlNativeQuery query(queryStr, dbNav);
   while(query.next())
   {
     Node node;
@@ -20,6 +20,9 @@
 
 #include "routing/routenetworktypes.h"
 
+#include <QHash>
+#include <QSet>
+
 namespace atools {
 namespace sql {
 class SqlDatabase;
@@ -44,10 +47,42 @@ public:
   virtual ~RouteNetworkLoader();
 
   /* Loads network data from databases into memory in RouteNetwork.
-   * Not reentrant. */
+   * Uses the snapshot file if set and matching. Not reentrant. */
   void load(atools::routing::RouteNetwork *networkParam);
 
+  /* Replace tracks in an already loaded airway network by the ones from the track database without reloading.
+   * Only the track database is read. Can be used after load() with or without tracks. Not reentrant. */
+  void loadTracks(atools::routing::RouteNetwork *networkParam);
+
+  /* Use a binary snapshot of the loaded network to speed up loading. The snapshot file is memory mapped and used
+   * if it matches database files, metadata and tracks. Otherwise it is rebuilt after loading from the databases.
+   * Set to empty string to disable. */
+  void setSnapshotFile(const QString& filename)
+  {
+    snapshotFile = filename;
+  }
+
 private:
+  /* Get a key identifying network source, database files and content for the snapshot */
+  QString snapshotKey() const;
+
+  /* Read network from snapshot file. Returns false and leaves network empty if file is missing or does not match */
+  bool readSnapshot(const QString& key);
+
+  /* Write loaded network to snapshot file */
+  void writeSnapshot(const QString& key) const;
+
+  /* KD-tree cache file for the node index next to the snapshot file and version for the key */
+  QString snapshotIndexFile() const
+  {
+    return snapshotFile + ".kdtree";
+  }
+
+  static quint32 snapshotIndexVersion(const QString& key)
+  {
+    return static_cast<quint32>(qHash(key));
+  }
+
   /* Read VOR and NDB into index */
   void readNodesRadio(const QString& queryStr, bool vor);
 
@@ -59,11 +94,17 @@ private:
    * nodeEdgeMap receiives a list of node ids mapped to a list of edges. */
   void readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, bool track) const;
 
-  /* Reads metadata and adds CONNECTION_TRACK_START_END flag to nodes if they are a start or end of a track. */
-  void readTrackStartEndPoints() const;
+  /* Reads metadata and returns ids of all nodes which are a start or end of a track. */
+  QSet<int> readTrackStartEndIds() const;
 
   atools::routing::RouteNetwork *network = nullptr;
   atools::sql::SqlDatabase *dbNav = nullptr, *dbTrack = nullptr;
+
+  QString snapshotFile;
+
+  /* Increase version on any change of Node, Edge or file structure */
+  const quint32 SNAPSHOT_MAGIC_NUMBER = 0x2A6E5C13;
+  const quint16 SNAPSHOT_VERSION = 1;
 };
 
 } // namespace routing
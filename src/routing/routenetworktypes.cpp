@@ -31,12 +31,70 @@ QDebug operator<<(QDebug out, const Node& obj)
                           << ", type " << nodeTypeToStr(obj.type)
                           << ", subtype " << nodeTypeToStr(obj.subtype)
                           << ", connections " << nodeConnectionsToStr(obj.con)
-                          << ", num edges " << obj.edges.size()
                           << ")";
   return out;
 
 }
 
+EdgeIndex EdgeIndex::reversed() const
+{
+  int num = numNodes();
+  EdgeIndex reverse;
+  reverse.edges.resize(edges.size());
+  reverse.offsets.fill(0, num + 1);
+
+  // Count incoming edges for each node
+  for(const Edge& edge : edges)
+    reverse.offsets[edge.toIndex + 1]++;
+
+  // Convert counts to offsets
+  for(int i = 0; i < num; i++)
+    reverse.offsets[i + 1] += reverse.offsets.at(i);
+
+  // Fill edges adjusting toIndex to the start node - next position per node is kept in insert
+  QVector<int> insert(reverse.offsets);
+  for(int from = 0; from < num; from++)
+  {
+    for(const Edge& edge : range(from))
+    {
+      Edge& reverseEdge = reverse.edges[insert[edge.toIndex]++];
+      reverseEdge = edge;
+      reverseEdge.toIndex = from;
+    }
+  }
+  return reverse;
+}
+
+NodeConnections edgeConnections(const EdgeRange& edges)
+{
+  NodeConnections connections = CONNECTION_NONE;
+  for(const Edge& edge : edges)
+  {
+    switch(edge.type)
+    {
+      case atools::routing::EDGE_NONE:
+        break;
+
+      case atools::routing::EDGE_VICTOR:
+        connections |= CONNECTION_VICTOR;
+        break;
+
+      case atools::routing::EDGE_JET:
+        connections |= CONNECTION_JET;
+        break;
+
+      case atools::routing::EDGE_BOTH:
+        connections |= CONNECTION_AIRWAY_BOTH;
+        break;
+
+      case atools::routing::EDGE_TRACK:
+        connections |= CONNECTION_TRACK;
+        break;
+    }
+  }
+  return connections;
+}
+
 QDebug operator<<(QDebug out, const Edge& obj)
 {
   QDebugStateSaver saver(out);
@@ -32,7 +32,7 @@ enum DataSource
 };
 
 /* Network mode. Changes which edges and nodes are returned as neighbours. */
-enum Mode : unsigned char
+enum Mode : quint16
 {
   MODE_NONE = 0,
   MODE_RADIONAV_VOR = 1 << 0, /* VOR/NDB to VOR/NDB */
@@ -48,6 +48,9 @@ enum Mode : unsigned char
                                 * instead of airport to airport.
                                 * Sets minimum distance at departure to zero. */
 
+  MODE_BIDIRECTIONAL = 1 << 8, /* Search from departure and destination at the same time and meet in the middle.
+                                * Only changes the search algorithm in RouteFinder and not the neighbour filter. */
+
   MODE_AIRWAY = MODE_VICTOR | MODE_JET,
   MODE_AIRWAY_WAYPOINT = MODE_VICTOR | MODE_JET | MODE_WAYPOINT,
   MODE_AIRWAY_TRACK = MODE_AIRWAY | MODE_TRACK,
@@ -183,6 +186,104 @@ struct Edge
 
 };
 
+/* Read only view on a consecutive range of edges in an EdgeIndex. Can be used in range based for loops. */
+struct EdgeRange
+{
+  const Edge *first = nullptr, *last = nullptr;
+
+  const Edge *begin() const
+  {
+    return first;
+  }
+
+  const Edge *end() const
+  {
+    return last;
+  }
+
+  const Edge& at(int i) const
+  {
+    return first[i];
+  }
+
+  int size() const
+  {
+    return static_cast<int>(last - first);
+  }
+
+  bool isEmpty() const
+  {
+    return first == last;
+  }
+
+};
+
+/*
+ * Edges of all nodes in a compressed sparse row layout. All edges are stored in one contiguous array sorted by
+ * start node. Edges of the node at index i are located at edges[offsets[i]] up to edges[offsets[i + 1] - 1].
+ *
+ * Avoids one allocation per node and keeps the edges of neighbouring nodes close in memory.
+ * Build by calling appendEdge() for all edges of a node followed by finishNode() in node index order.
+ */
+struct EdgeIndex
+{
+  QVector<Edge> edges;
+  QVector<int> offsets; /* Size number of nodes + 1 after building */
+
+  void clear()
+  {
+    edges.clear();
+    offsets.clear();
+  }
+
+  void reserve(int numNodes, int numEdges)
+  {
+    offsets.reserve(numNodes + 1);
+    edges.reserve(numEdges);
+  }
+
+  /* Add edge to the node currently built */
+  void appendEdge(const Edge& edge)
+  {
+    if(offsets.isEmpty())
+      offsets.append(0);
+    edges.append(edge);
+  }
+
+  /* Finish current node and proceed to the next one */
+  void finishNode()
+  {
+    if(offsets.isEmpty())
+      offsets.append(0);
+    offsets.append(edges.size());
+  }
+
+  /* Edges of node at index. Returns an empty range for invalid, departure or destination indexes. */
+  EdgeRange range(int nodeIndex) const
+  {
+    if(nodeIndex < 0 || nodeIndex + 1 >= offsets.size())
+      return EdgeRange();
+
+    EdgeRange edgeRange;
+    edgeRange.first = edges.constData() + offsets.at(nodeIndex);
+    edgeRange.last = edges.constData() + offsets.at(nodeIndex + 1);
+    return edgeRange;
+  }
+
+  /* Number of nodes */
+  int numNodes() const
+  {
+    return std::max(offsets.size() - 1, 0);
+  }
+
+  /* Build index of incoming edges. Edge::toIndex in result points to the node where the edge starts. */
+  EdgeIndex reversed() const;
+};
+
+/* Connection flags like airway or track types derived from outgoing edges. Does not include
+ * CONNECTION_TRACK_START_END. */
+atools::routing::NodeConnections edgeConnections(const atools::routing::EdgeRange& edges);
+
 /* Network node. VOR, NDB, waypoint or user defined departure/destination */
 struct Node
 {
@@ -201,9 +302,6 @@ struct Node
                             subtype /* VOR, VORDME, NDB, ... for airway network if type is one of WAYPOINT_* */;
   atools::routing::NodeConnection con; /* Flags indicating all connected airways and tracks */
 
-  QVector<Edge> edges; /* Attached outgoing edges on airway only.
-                        * Do not use this since edges are already filtered by the RouteNetwork. */
-
   /* Default unitialized */
   constexpr static int INVALID_INDEX = -1;
 
@@ -302,10 +400,14 @@ struct Result
   QVector<int> nodes;
   QVector<Edge> edges;
 
+  /* Number of spatial index radius queries needed to fill this result. Used for statistics. */
+  int numNearestQueries = 0;
+
   void clear()
   {
     nodes.clear();
     edges.clear();
+    numNearestQueries = 0;
   }
 
   void reserve(int size)
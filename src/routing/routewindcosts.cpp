@@ -0,0 +1,180 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routewindcosts.h"
+
+#include "routing/routenetwork.h"
+#include "grib/windquery.h"
+#include "geo/calculations.h"
+#include "util/parallel.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+using atools::geo::Pos;
+
+namespace atools {
+namespace routing {
+
+Q_DECL_CONSTEXPR float RouteWindCosts::MIN_GROUNDSPEED_FACTOR;
+
+RouteWindCosts::RouteWindCosts()
+{
+
+}
+
+RouteWindCosts::~RouteWindCosts()
+{
+
+}
+
+void RouteWindCosts::clear()
+{
+  nodeWinds.clear();
+  minTimeFactor = 1.f;
+}
+
+void RouteWindCosts::toUnitVector(NodeWind& nodeWind, const atools::geo::Pos& pos)
+{
+  // Same orientation as Pos::toCartesian() but without earth radius
+  float sinLat = atools::geo::sinDeg(pos.getLatY()), cosLat = atools::geo::cosDeg(pos.getLatY());
+  float sinLon = atools::geo::sinDeg(pos.getLonX()), cosLon = atools::geo::cosDeg(pos.getLonX());
+  nodeWind.x = cosLat * cosLon;
+  nodeWind.y = cosLat * sinLon;
+  nodeWind.z = sinLat;
+}
+
+void RouteWindCosts::build(const RouteNetwork *network, const atools::grib::WindQuery *windQuery,
+                           float altitudeFt, float trueAirspeedKts, int numThreads)
+{
+  lastNetwork = network;
+  altitude = altitudeFt;
+  trueAirspeed = trueAirspeedKts;
+  rebuild(windQuery, numThreads);
+}
+
+void RouteWindCosts::rebuild(const atools::grib::WindQuery *windQuery, int numThreads)
+{
+  clear();
+
+  if(lastNetwork == nullptr || !lastNetwork->isLoaded() || windQuery == nullptr || !windQuery->hasWindData() ||
+     !(trueAirspeed > 0.f))
+    return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  const QVector<Node>& nodes = lastNetwork->getNodes();
+  int size = nodes.size();
+  nodeWinds.resize(size);
+
+  const int MIN_CHUNK_SIZE = 1000;
+  int chunks = atools::util::parallelChunks(size, numThreads, MIN_CHUNK_SIZE);
+  QVector<float> chunkMaxWind(chunks, 0.f);
+
+  atools::util::parallelFor(size, chunks, [this, &nodes, windQuery, &chunkMaxWind](int begin, int end,
+                                                                                  int chunk) -> void {
+    // One batch query per chunk to reuse the interpolation setup
+    QVector<Pos> positions;
+    positions.reserve(end - begin);
+    for(int i = begin; i < end; i++)
+      positions.append(Pos(nodes.at(i).pos.getLonX(), nodes.at(i).pos.getLatY(), altitude));
+
+    QVector<atools::grib::Wind> winds;
+    windQuery->getWindForPosList(winds, positions);
+
+    float maxWind = 0.f;
+    for(int i = begin; i < end; i++)
+    {
+      NodeWind& nodeWind = nodeWinds[i];
+      const Pos& pos = positions.at(i - begin);
+      toUnitVector(nodeWind, pos);
+
+      const atools::grib::Wind& wind = winds.at(i - begin);
+      if(wind.isValid() && !wind.isNull())
+      {
+        // Direction is where the wind comes from - convert to east and north components of the air movement
+        float speed = wind.speed / trueAirspeed;
+        float east = -speed * atools::geo::sinDeg(wind.dir), north = -speed * atools::geo::cosDeg(wind.dir);
+
+        // East (-sin lon, cos lon, 0) and north (-sin lat cos lon, -sin lat sin lon, cos lat) unit vectors
+        float sinLat = atools::geo::sinDeg(pos.getLatY()), cosLat = atools::geo::cosDeg(pos.getLatY());
+        float sinLon = atools::geo::sinDeg(pos.getLonX()), cosLon = atools::geo::cosDeg(pos.getLonX());
+        nodeWind.windX = -east * sinLon - north * sinLat * cosLon;
+        nodeWind.windY = east * cosLon - north * sinLat * sinLon;
+        nodeWind.windZ = north * cosLat;
+        maxWind = std::max(maxWind, speed);
+      }
+      else
+        nodeWind.windX = nodeWind.windY = nodeWind.windZ = 0.f;
+    }
+    chunkMaxWind[chunk] = maxWind;
+  }, MIN_CHUNK_SIZE);
+
+  // Ground speed cannot exceed true airspeed plus the strongest wind
+  float maxWind = *std::max_element(chunkMaxWind.constBegin(), chunkMaxWind.constEnd());
+  minTimeFactor = 1.f / (1.f + maxWind);
+
+  qDebug() << Q_FUNC_INFO << "nodes" << size << "altitude" << altitude << "tas" << trueAirspeed
+           << "max wind" << maxWind * trueAirspeed << "elapsed" << timer.elapsed() << "ms";
+}
+
+float RouteWindCosts::timeFactor(const Node& from, const Node& to) const
+{
+  const NodeWind *fromWind = nodeWind(from), *toWind = nodeWind(to);
+
+  if(fromWind == nullptr && toWind == nullptr)
+    // Direct connection between departure and destination or unknown nodes
+    return 1.f;
+
+  // Calculate position of virtual nodes - only used for a few edges
+  NodeWind fromVirtual, toVirtual;
+  if(fromWind == nullptr)
+  {
+    fromVirtual = *toWind;
+    toUnitVector(fromVirtual, from.pos);
+    fromWind = &fromVirtual;
+  }
+  else if(toWind == nullptr)
+  {
+    toVirtual = *fromWind;
+    toUnitVector(toVirtual, to.pos);
+    toWind = &toVirtual;
+  }
+
+  // Chord direction is tangent at the edge midpoint
+  float dx = toWind->x - fromWind->x, dy = toWind->y - fromWind->y, dz = toWind->z - fromWind->z;
+  float len = std::sqrt(dx * dx + dy * dy + dz * dz);
+  if(len < 1.e-9f)
+    return 1.f;
+
+  // Average wind of both nodes
+  float wx = (fromWind->windX + toWind->windX) * 0.5f, wy = (fromWind->windY + toWind->windY) * 0.5f,
+        wz = (fromWind->windZ + toWind->windZ) * 0.5f;
+
+  // Tailwind positive - ground speed is the along track component plus the remaining airspeed after
+  // correcting for crosswind
+  float along = (wx * dx + wy * dy + wz * dz) / len;
+  float crossSq = std::max(wx * wx + wy * wy + wz * wz - along * along, 0.f);
+  float groundSpeed = std::sqrt(std::max(1.f - crossSq, 0.f)) + along;
+
+  return 1.f / std::max(groundSpeed, MIN_GROUNDSPEED_FACTOR);
+}
+
+} // namespace routing
+} // namespace atools
@@ -0,0 +1,116 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTEWINDCOSTS_H
+#define ATOOLS_ROUTEWINDCOSTS_H
+
+#include "routing/routenetworktypes.h"
+
+namespace atools {
+namespace grib {
+class WindQuery;
+}
+namespace routing {
+
+class RouteNetwork;
+
+/*
+ * Precomputed winds for all nodes of a route network at one flight altitude. Used by RouteFinder to weight edge
+ * costs by flight time instead of distance without sampling winds during the search.
+ *
+ * Each node keeps its position as a unit vector and the wind as a vector in the same cartesian frame scaled by the
+ * true airspeed. The time factor of an edge is then derived from a few multiplications and a square root
+ * which is cheap enough for each expansion and also covers generated edges which are not part of the edge index.
+ *
+ * The result is only valid for the network, wind data and altitude it was built with.
+ * Call rebuild() when WindQuery::windDataUpdated() is emitted. Not thread safe - do not rebuild while a RouteFinder
+ * using this object is running.
+ */
+class RouteWindCosts
+{
+public:
+  RouteWindCosts();
+  ~RouteWindCosts();
+
+  /* Get wind for all nodes at altitude in a parallel pass. Network has to be loaded and wind query must
+   * have wind data. Otherwise the object is cleared. numThreads: 0 uses the number of cores. */
+  void build(const atools::routing::RouteNetwork *network, const atools::grib::WindQuery *windQuery,
+             float altitudeFt, float trueAirspeedKts, int numThreads = 0);
+
+  /* Build again with network, altitude and speed of the last call to build(). Use after wind data changed. */
+  void rebuild(const atools::grib::WindQuery *windQuery, int numThreads = 0);
+
+  /* Flight time factor for edge from node to node. Always forward direction.
+   * 1 is no wind, < 1 for tailwind and > 1 for headwind.
+   * Virtual departure and destination nodes use the wind of the other node. */
+  float timeFactor(const atools::routing::Node& from, const atools::routing::Node& to) const;
+
+  /* Lowest possible time factor for all edges. Used to keep the cost estimate a lower bound. */
+  float getMinTimeFactor() const
+  {
+    return minTimeFactor;
+  }
+
+  /* true if built */
+  bool isValid() const
+  {
+    return !nodeWinds.isEmpty();
+  }
+
+  void clear();
+
+  float getAltitudeFt() const
+  {
+    return altitude;
+  }
+
+  float getTrueAirspeedKts() const
+  {
+    return trueAirspeed;
+  }
+
+private:
+  /* Position and wind for a node. 24 bytes. */
+  struct NodeWind
+  {
+    float x, y, z, /* Unit vector of position */
+          windX, windY, windZ; /* Wind speed and direction as fraction of true airspeed. Tangent to the sphere. */
+  };
+
+  /* Get node wind or nullptr for invalid, departure, destination or nodes added after building */
+  const NodeWind *nodeWind(const atools::routing::Node& node) const
+  {
+    return node.index >= 0 && node.index < nodeWinds.size() ? &nodeWinds.at(node.index) : nullptr;
+  }
+
+  static void toUnitVector(NodeWind& nodeWind, const atools::geo::Pos& pos);
+
+  /* Limit ground speed in case of strong headwind to avoid excessive and negative costs. Fraction of TAS. */
+  static Q_DECL_CONSTEXPR float MIN_GROUNDSPEED_FACTOR = 0.2f;
+
+  QVector<NodeWind> nodeWinds;
+  float minTimeFactor = 1.f;
+
+  /* Parameters of last build */
+  const atools::routing::RouteNetwork *lastNetwork = nullptr;
+  float altitude = 0.f, trueAirspeed = 0.f;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTEWINDCOSTS_H
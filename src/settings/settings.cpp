@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "settings/settings.h"
+#include "settings/settingswriter.h"
 #include "exception.h"
 
 #include <QDebug>
@@ -76,6 +77,8 @@ Settings::Settings()
 
 Settings::~Settings()
 {
+  // Writes pending changes and stops thread
+  delete writer;
   delete qSettings;
 }
 
@@ -92,7 +95,7 @@ void Settings::clearAndShutdown()
   qDebug() << Q_FUNC_INFO;
 
   // Write current settings
-  syncSettings();
+  flushSettings();
 
   // Create a backup
   QFileInfo file(getFilename());
@@ -191,7 +194,35 @@ QVariant Settings::getAndStoreValue(const QString& key, const QVariant& defaultV
   }
 }
 
+void Settings::setWriteBehind(int minIntervalMs)
+{
+  Settings& settings = instance();
+
+  if(settings.writer != nullptr)
+  {
+    delete settings.writer;
+    settings.writer = nullptr;
+  }
+
+  if(minIntervalMs > 0)
+  {
+    settings.writer = new SettingsWriter(settings.qSettings->fileName(), settings.qSettings->format(), minIntervalMs);
+
+    // Changes done by setValue() are written in background instead of the event loop
+    settings.writer->attach(settings.qSettings);
+  }
+}
+
 void Settings::syncSettings()
+{
+  Settings& settings = instance();
+  if(settings.writer != nullptr)
+    settings.writer->requestSync();
+  else
+    flushSettings();
+}
+
+void Settings::flushSettings()
 {
   QSettings *qs = getQSettings();
   qs->sync();
@@ -209,7 +240,7 @@ void Settings::clearSettings()
   if(qs->status() != QSettings::NoError)
     throw Exception(QString("Error clearing settings file \"%1\" reason %2").
                     arg(qs->fileName()).arg(qs->status()));
-  syncSettings();
+  flushSettings();
 }
 
 bool Settings::contains(const QString& key) const
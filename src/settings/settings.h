@@ -26,6 +26,8 @@ class QSettings;
 namespace atools {
 namespace settings {
 
+class SettingsWriter;
+
 /*
  * Provides access to QSettings in a singleton as well as access to the
  * settings directory. The settings are always stored in a file ini format.
@@ -110,9 +112,20 @@ public:
    * if not already present. Call syncSettings afterwards to write all defaults to the file. */
   QVariant getAndStoreValue(const QString& key, const QVariant& defaultValue = QVariant()) const;
 
-  /* Write settings to file and reload all changes in settings file */
+  /* Write settings to file and reload all changes in settings file.
+   * Only requests a write in the background if write behind is enabled. */
   static void syncSettings();
 
+  /* Write settings to file synchronously even if write behind is enabled.
+   * Throws Exception on error. */
+  static void flushSettings();
+
+  /* Enable writing the settings file in a background thread to avoid blocking on frequent calls of syncSettings().
+   * Changes are coalesced and written at most once per minIntervalMs and on shutdown. This applies to changes
+   * done by setValue() like window state and file history too. 0 disables write behind which is the default.
+   * Write errors are only logged if enabled. */
+  static void setWriteBehind(int minIntervalMs);
+
   /* Remove all key/value pairs */
   static void clearSettings();
 
@@ -151,6 +164,9 @@ private:
 
   QSettings *qSettings;
 
+  /* Not null if write behind is enabled */
+  SettingsWriter *writer = nullptr;
+
   static QString overrideOrganisation, overridePath;
 
   static Settings *settingsInstance;
@@ -0,0 +1,145 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "settings/settingswriter.h"
+
+#include <QDebug>
+#include <QEvent>
+#include <QThread>
+
+#include <algorithm>
+
+namespace atools {
+namespace settings {
+
+/* Catches the update request which QSettings posts to itself after changes */
+class SettingsUpdateFilter :
+  public QObject
+{
+public:
+  explicit SettingsUpdateFilter(SettingsWriter *writerParam)
+    : writer(writerParam)
+  {
+  }
+
+  virtual bool eventFilter(QObject *object, QEvent *event) override
+  {
+    if(event->type() == QEvent::UpdateRequest)
+    {
+      writer->requestSync();
+      return true;
+    }
+    return QObject::eventFilter(object, event);
+  }
+
+private:
+  SettingsWriter *writer;
+};
+
+SettingsWriter::SettingsWriter(const QString& filenameParam, QSettings::Format formatParam, int minIntervalMsParam)
+  : filename(filenameParam), format(formatParam), minIntervalMs(minIntervalMsParam), syncRequested(false),
+  numSyncs(0)
+{
+  qDebug() << Q_FUNC_INFO << filename << "interval" << minIntervalMs;
+
+  thread = new QThread;
+  thread->setObjectName("SettingsWriter");
+  moveToThread(thread);
+  thread->start();
+}
+
+SettingsWriter::~SettingsWriter()
+{
+  // Removes filter from attached settings
+  delete updateFilter;
+
+  stop();
+  delete settings;
+  delete timer;
+  delete thread;
+}
+
+void SettingsWriter::requestSync()
+{
+  if(!syncRequested.exchange(true))
+    QMetaObject::invokeMethod(this, "scheduleSync", Qt::QueuedConnection);
+}
+
+void SettingsWriter::attach(QSettings *qSettings)
+{
+  if(updateFilter == nullptr)
+    updateFilter = new SettingsUpdateFilter(this);
+  qSettings->installEventFilter(updateFilter);
+}
+
+void SettingsWriter::stop()
+{
+  if(thread != nullptr && thread->isRunning())
+  {
+    // Final write of all pending changes
+    QMetaObject::invokeMethod(this, "syncNow", Qt::BlockingQueuedConnection);
+
+    thread->quit();
+    thread->wait();
+    qDebug() << Q_FUNC_INFO << "Written" << numSyncs.load() << "times";
+  }
+}
+
+void SettingsWriter::scheduleSync()
+{
+  if(timer == nullptr)
+  {
+    // Created here to have timer in writer thread
+    timer = new QTimer;
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout, this, &SettingsWriter::syncNow);
+  }
+
+  if(!timer->isActive())
+  {
+    // Wait for the rest of the interval if the last write is too recent
+    qint64 wait = lastSyncTimer.isValid() ? std::max(minIntervalMs - lastSyncTimer.elapsed(), Q_INT64_C(0)) : 0;
+    timer->start(static_cast<int>(wait));
+  }
+}
+
+void SettingsWriter::syncNow()
+{
+  if(timer != nullptr)
+    timer->stop();
+
+  // Reset before writing so that changes done during the write trigger another one
+  syncRequested.store(false);
+
+  QSettings *s = writerSettings();
+  s->sync();
+  lastSyncTimer.start();
+  numSyncs++;
+
+  if(s->status() != QSettings::NoError)
+    qWarning() << Q_FUNC_INFO << "Error writing to settings file" << filename << "reason" << s->status();
+}
+
+QSettings *SettingsWriter::writerSettings()
+{
+  if(settings == nullptr)
+    settings = new QSettings(filename, format);
+  return settings;
+}
+
+} // namespace settings
+} // namespace atools
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SETTINGS_SETTINGSWRITER_H
+#define ATOOLS_SETTINGS_SETTINGSWRITER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSettings>
+#include <QTimer>
+
+#include <atomic>
+
+class QThread;
+
+namespace atools {
+namespace settings {
+
+/*
+ * Writes a settings file in a background thread at a bounded rate.
+ *
+ * Uses its own QSettings object for the same file which is created in the writer thread. All QSettings objects
+ * of a process share the file content in memory, so syncing this object writes all changes done through the
+ * settings object of the main thread too. QSettings replaces the file atomically by writing a temporary file
+ * and renaming it which avoids a truncated file on a crash.
+ *
+ * Requests are coalesced. At most one write is done per minimum interval. Errors are logged since they cannot be
+ * reported to the caller.
+ *
+ * Used by Settings if write behind is enabled. See Settings::setWriteBehind().
+ */
+class SettingsWriter :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SettingsWriter(const QString& filenameParam, QSettings::Format formatParam, int minIntervalMsParam);
+  virtual ~SettingsWriter() override;
+
+  SettingsWriter(const SettingsWriter& other) = delete;
+  SettingsWriter& operator=(const SettingsWriter& other) = delete;
+
+  /* Request a write. Returns immediately. Can be called from any thread. */
+  void requestSync();
+
+  /* Replace the automatic write which QSettings does in the event loop of its thread after changes with
+   * a request to this writer. Call from the thread of qSettings. */
+  void attach(QSettings *qSettings);
+
+  /* Write pending changes and stop the writer thread. Blocks until done. Call from the owning thread. */
+  void stop();
+
+  /* Number of writes done. Thread safe. */
+  int getNumSyncs() const
+  {
+    return numSyncs.load();
+  }
+
+private:
+  /* Called in writer thread */
+  Q_INVOKABLE void scheduleSync();
+  Q_INVOKABLE void syncNow();
+
+  QSettings *writerSettings();
+
+  QString filename;
+  QSettings::Format format;
+  int minIntervalMs;
+
+  /* All members below are used only in the writer thread except the atomics */
+  QSettings *settings = nullptr;
+  QTimer *timer = nullptr;
+  QElapsedTimer lastSyncTimer;
+  QThread *thread = nullptr;
+
+  /* Event filter for attached settings. Lives in the thread of the attached settings. */
+  QObject *updateFilter = nullptr;
+
+  /* Avoids flooding the event queue if requests come faster than the writer runs */
+  std::atomic_bool syncRequested;
+  std::atomic_int numSyncs;
+};
+
+} // namespace settings
+} // namespace atools
+
+#endif // ATOOLS_SETTINGS_SETTINGSWRITER_H
@@ -0,0 +1,120 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/databaseswap.h"
+
+#include "exception.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#if defined(Q_OS_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#endif
+
+namespace atools {
+namespace sql {
+
+/* Journal files of a database */
+static const QStringList SIDECAR_SUFFIXES({"-journal", "-wal", "-shm"});
+
+DatabaseSwap::DatabaseSwap()
+{
+
+}
+
+DatabaseSwap& DatabaseSwap::instance()
+{
+  static DatabaseSwap swap;
+  return swap;
+}
+
+QString DatabaseSwap::temporaryFilename(const QString& filename)
+{
+  return filename + ".building";
+}
+
+void DatabaseSwap::removeTemporary(const QString& filename)
+{
+  QString temporaryFile = temporaryFilename(filename);
+  QFile::remove(temporaryFile);
+  for(const QString& suffix : SIDECAR_SUFFIXES)
+    QFile::remove(temporaryFile + suffix);
+}
+
+QString DatabaseSwap::canonicalName(const QString& filename)
+{
+  return QFileInfo(filename).absoluteFilePath();
+}
+
+QString DatabaseSwap::renameReplace(const QString& from, const QString& to)
+{
+#if defined(Q_OS_WIN32)
+  if(!MoveFileExW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(from).utf16()),
+                  reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(to).utf16()),
+                  MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    return QString("Windows error %1").arg(GetLastError());
+#else
+  // Atomic on POSIX - readers see either the old or the new file
+  if(std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) != 0)
+    return QString::fromLocal8Bit(std::strerror(errno));
+#endif
+  return QString();
+}
+
+quint64 DatabaseSwap::publish(const QString& temporaryFile, const QString& filename)
+{
+  qDebug() << Q_FUNC_INFO << temporaryFile << "to" << filename;
+
+  // A journal means that the database is still open or was not closed cleanly
+  for(const QString& suffix : SIDECAR_SUFFIXES)
+  {
+    if(QFile::exists(temporaryFile + suffix))
+      throw atools::Exception(tr("Database \"%1\" is still open.").arg(temporaryFile));
+  }
+
+  QString name = canonicalName(filename);
+  QString error = renameReplace(temporaryFile, name);
+  if(!error.isEmpty())
+    throw atools::Exception(tr("Cannot replace \"%1\" with \"%2\". Reason: %3").
+                            arg(name).arg(temporaryFile).arg(error));
+
+  quint64 generation;
+  {
+    QMutexLocker locker(&mutex);
+    generation = ++generations[name];
+  }
+
+  qInfo() << Q_FUNC_INFO << "Published" << name << "generation" << generation;
+  emit databasePublished(name, generation);
+  return generation;
+}
+
+quint64 DatabaseSwap::getGeneration(const QString& filename) const
+{
+  QMutexLocker locker(&mutex);
+  return generations.value(canonicalName(filename), 0);
+}
+
+} // namespace sql
+} // namespace atools
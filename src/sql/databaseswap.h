@@ -0,0 +1,84 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_DATABASESWAP_H
+#define ATOOLS_SQL_DATABASESWAP_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+
+namespace atools {
+namespace sql {
+
+/*
+ * Publishes database files which were built under a temporary name and notifies listeners.
+ *
+ * A database is compiled or updated into temporaryFilename() and then moved over the live file by an atomic
+ * rename in publish(). Connections opened before keep reading the old file until they are reopened. On Windows
+ * the rename fails while connections to the old file are open.
+ *
+ * Each publish increments the generation of the file and emits databasePublished() in the calling thread.
+ * Long living readers like route network, MORA, magnetic declination or caches connect to the signal, load the
+ * new file on their own connection in the background and switch over when done. See atools::util::HotSwap.
+ *
+ * The live file must not use WAL mode since -wal and -shm files are not replaced.
+ *
+ * All methods are thread safe.
+ */
+class DatabaseSwap :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  static DatabaseSwap& instance();
+
+  /* Temporary filename in the same directory which is needed for an atomic rename */
+  static QString temporaryFilename(const QString& filename);
+
+  /* Delete temporary file and its journal if left over from a crashed or canceled compilation */
+  static void removeTemporary(const QString& filename);
+
+  /* Move closed temporaryFile over filename and emit databasePublished().
+   * Throws atools::Exception if the temporary file still has a journal or cannot be renamed.
+   * Returns the new generation. */
+  quint64 publish(const QString& temporaryFile, const QString& filename);
+
+  /* Generation of the file which is 0 before the first publish */
+  quint64 getGeneration(const QString& filename) const;
+
+signals:
+  /* Emitted after the new file is in place. filename is the absolute path. */
+  void databasePublished(const QString& filename, quint64 generation);
+
+private:
+  DatabaseSwap();
+
+  static QString canonicalName(const QString& filename);
+
+  /* Platform dependent replacing rename. Returns error message or empty string. */
+  static QString renameReplace(const QString& from, const QString& to);
+
+  QHash<QString, quint64> generations;
+  mutable QMutex mutex;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_DATABASESWAP_H
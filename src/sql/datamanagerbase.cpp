@@ -21,20 +21,28 @@
 #include "exception.h"
 #include "sql/sqlrecord.h"
 #include "geo/pos.h"
+#include "geo/spatialgrid.h"
+#include "sql/sqlbulkinsert.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlscript.h"
 #include "sql/sqltransaction.h"
 #include "sql/sqlutil.h"
+#include "util/parallel.h"
 
 #include <QDir>
 #include <QStringBuilder>
 #include <QAction>
 
+#include <algorithm>
+#include <memory>
+
 using atools::geo::Pos;
 
 namespace atools {
 namespace sql {
 
+Q_DECL_CONSTEXPR int DataManagerBase::UNDO_COMPACT_MIN_ROWS;
+
 DataManagerBase::DataManagerBase(sql::SqlDatabase *sqlDb, const QString& tableNameParam,
                                  const QString& idColumnNameParam, const QStringList& createSqlScripts, const QString& createUndoSqlScript,
                                  const QString& dropSqlScript)
@@ -52,6 +60,7 @@ DataManagerBase::DataManagerBase(sql::SqlDatabase *sqlDb, const QString& tableNa
 
 DataManagerBase::~DataManagerBase()
 {
+  clearSpatialIndexes();
   deInitQueries();
   delete util;
 }
@@ -92,6 +101,7 @@ void DataManagerBase::createSchema(bool verboseLogging)
   transaction.commit();
 
   updateUndoRedoActions();
+  notifyTableChanged();
 }
 
 void DataManagerBase::updateSchema()
@@ -113,6 +123,17 @@ void DataManagerBase::updateUndoSchema()
     initQueries();
     undoActive = hasUndoSchema();
   }
+  else if(hasUndoSchema() && !util->hasTableAndColumn("undo_data", "undo_columns"))
+  {
+    // Older schema - add column which allows to store changed columns only
+    qDebug() << Q_FUNC_INFO << "Adding undo_columns for" << tableName;
+
+    deInitQueries();
+    SqlTransaction transaction(db);
+    util->addColumnIf("undo_data", "undo_columns", "varchar(1024)");
+    transaction.commit();
+    initQueries();
+  }
 
   updateUndoRedoActions();
 }
@@ -126,6 +147,7 @@ void DataManagerBase::dropSchema()
   SqlScript script(db, true);
   script.executeScript(dropScript);
   transaction.commit();
+  notifyTableChanged();
 }
 
 void DataManagerBase::initCurrentId()
@@ -171,6 +193,10 @@ bool DataManagerBase::addColumnIf(const QString& colName, const QString& colType
     retvalUndo = util->addColumnIf("undo_data", colName, colType);
   transaction.commit();
 
+  if(retvalUndo)
+    // Rebuild insert and update statements for undo table
+    initQueries();
+
   if(retval || retvalUndo)
     qDebug() << Q_FUNC_INFO << colName << colType << "added" << retval << "added undo" << retvalUndo;
 
@@ -197,6 +223,7 @@ void DataManagerBase::insertOneRecord(SqlRecord record, int id)
   preUndoInsert({record});
 
   queryInsertRecords->bindAndExecRecord(record, ":");
+  notifyRowsChanged({record.valueInt(idColumnName)});
   postUndo();
 }
 
@@ -205,11 +232,16 @@ void DataManagerBase::insertRecords(sql::SqlRecordList records)
   initCurrentId();
 
   // Insert id in records if id column is 0 or missing
+  QSet<int> ids;
   for(SqlRecord& record : records)
+  {
     updateIdColumn(record, getNextId());
+    ids.insert(record.valueInt(idColumnName));
+  }
 
   preUndoInsert(records);
   queryInsertRecords->bindAndExecRecords(records, ":");
+  notifyRowsChanged(ids);
   postUndo();
 }
 
@@ -221,13 +253,17 @@ void DataManagerBase::insertRecords(const SqlRecordList& records, const QString&
   SqlQuery insert(db);
   insert.prepare(util->buildInsertStatement(table));
   insert.bindAndExecRecords(records, ":");
+
+  if(table == tableName)
+    notifyTableChanged();
 }
 
 void DataManagerBase::updateField(const QString& column, const QSet<int>& ids, const QVariant& value)
 {
   if(!ids.isEmpty())
   {
-    preUndoUpdate(ids);
+    preUndoUpdate(ids, {column});
+    notifyRowsChanging(ids);
     SqlQuery query(db);
     query.prepare("update " + tableName + " set " + column + " = ? where " + idColumnName + " = ?");
 
@@ -240,6 +276,7 @@ void DataManagerBase::updateField(const QString& column, const QSet<int>& ids, c
       if(query.numRowsAffected() != 1)
         qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != 1";
     }
+    notifyRowsChanged(ids);
     postUndo();
   }
 }
@@ -257,7 +294,7 @@ void DataManagerBase::updateRecords(const sql::SqlRecord& record, const QSet<int
 {
   if(!ids.isEmpty())
   {
-    preUndoUpdate(ids);
+    preUndoUpdate(ids, record.fieldNames());
     updateRecordsInternal(record, ids);
     postUndo();
   }
@@ -282,6 +319,8 @@ void DataManagerBase::updateRecordsInternal(sql::SqlRecord record, const QSet<in
     // Bind all record values
     query.bindRecord(record, ":");
 
+    notifyRowsChanging(ids);
+
     // Now update table columns for all given ids
     for(int id : ids)
     {
@@ -290,6 +329,8 @@ void DataManagerBase::updateRecordsInternal(sql::SqlRecord record, const QSet<in
       if(query.numRowsAffected() != 1)
         qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != 1. id " << id;
     }
+
+    notifyRowsChanged(ids);
   }
 }
 
@@ -297,6 +338,7 @@ void DataManagerBase::deleteAllRows()
 {
   preUndoDeleteAll();
   SqlQuery("delete from " % tableName, db).exec();
+  notifyTableChanged();
   postUndo();
 }
 
@@ -322,10 +364,15 @@ void DataManagerBase::deleteAllRows(const QString& table)
   // Undo not supported for this method
   checkUndoTable(table);
   SqlQuery("delete from " % table, db).exec();
+
+  if(table == tableName)
+    notifyTableChanged();
 }
 
 void DataManagerBase::deleteRowsInternal(const QSet<int>& ids)
 {
+  notifyRowsChanging(ids);
+
   for(int id : ids)
   {
     queryDeleteRowById->bindValue(0, id);
@@ -335,6 +382,105 @@ void DataManagerBase::deleteRowsInternal(const QSet<int>& ids)
   }
 }
 
+void DataManagerBase::notifyRowsChanging(const QSet<int>& ids)
+{
+  for(SpatialIndexColumns& index : spatialIndexes)
+  {
+    if(index.grid != nullptr)
+    {
+      for(int id : ids)
+        index.grid->remove(id);
+    }
+  }
+
+  rowsChanging(ids);
+}
+
+void DataManagerBase::notifyRowsChanged(const QSet<int>& ids)
+{
+  if(!ids.isEmpty())
+  {
+    for(SpatialIndexColumns& index : spatialIndexes)
+    {
+      if(index.grid != nullptr)
+        loadSpatialPositions(index, ids);
+    }
+  }
+
+  rowsChanged(ids);
+}
+
+void DataManagerBase::notifyTableChanged()
+{
+  // Reload on next query
+  clearSpatialIndexes();
+
+  tableChanged();
+}
+
+int DataManagerBase::addSpatialIndex(const QString& lonxColumn, const QString& latyColumn)
+{
+  SpatialIndexColumns index;
+  index.lonxColumn = lonxColumn;
+  index.latyColumn = latyColumn;
+  spatialIndexes.append(index);
+  return spatialIndexes.size() - 1;
+}
+
+void DataManagerBase::clearSpatialIndexes()
+{
+  for(SpatialIndexColumns& index : spatialIndexes)
+  {
+    delete index.grid;
+    index.grid = nullptr;
+  }
+}
+
+const atools::geo::SpatialGrid *DataManagerBase::spatialGrid(int spatialIndex)
+{
+  SpatialIndexColumns& index = spatialIndexes[spatialIndex];
+  if(index.grid == nullptr)
+  {
+    index.grid = new atools::geo::SpatialGrid;
+    if(hasSchema())
+      loadSpatialPositions(index, QSet<int>());
+  }
+  return index.grid;
+}
+
+void DataManagerBase::loadSpatialPositions(SpatialIndexColumns& index, const QSet<int>& ids)
+{
+  // Loads all rows if ids are empty
+  QueryWrapper query("select " % idColumnName % ", " % index.lonxColumn % ", " % index.latyColumn % " from " % tableName,
+                     db, ids, idColumnName);
+  query.exec();
+  while(query.next())
+  {
+    if(!query.query.isNull(1) && !query.query.isNull(2))
+    {
+      Pos pos(query.query.valueFloat(1), query.query.valueFloat(2));
+      if(pos.isValidRange())
+        index.grid->insert(query.query.valueInt(0), pos);
+    }
+  }
+}
+
+void DataManagerBase::getIdsInRadius(QVector<atools::geo::IndexDistance>& result, const Pos& pos, float radiusMeter,
+                                     int maxResults, int spatialIndex)
+{
+  spatialGrid(spatialIndex)->getRadius(result, pos, radiusMeter, maxResults);
+}
+
+int DataManagerBase::getNearestId(const Pos& pos, float maxRadiusMeter, float *distanceMeter, int spatialIndex)
+{
+  return spatialGrid(spatialIndex)->getNearest(pos, maxRadiusMeter, distanceMeter);
+}
+
+void DataManagerBase::getIdsInRect(QVector<int>& ids, const atools::geo::Rect& rect, int spatialIndex)
+{
+  spatialGrid(spatialIndex)->getRect(ids, rect);
+}
+
 void DataManagerBase::deleteRows(const QString& column, const QVariant& value)
 {
   // Collect all ids for rows to delete
@@ -359,6 +505,9 @@ void DataManagerBase::deleteRows(const QString& table, const QString& column, co
   query.prepare("delete from " + table + " where " + column + " = ?");
   query.bindValue(0, value);
   query.exec();
+
+  if(table == tableName)
+    notifyTableChanged();
 }
 
 void DataManagerBase::getValues(QVariantList& values, const QSet<int>& ids, const QString& colName) const
@@ -454,6 +603,74 @@ atools::geo::Pos DataManagerBase::validateCoordinates(const QString& line, const
   return pos;
 }
 
+int DataManagerBase::bulkInsert(const QStringList& columns, int numRecords, const BulkRowFuncType& func, int& id,
+                                DataManagerUndoHandler& undoHandler)
+{
+  // Avoid thread overhead for small files
+  const int MIN_RECORDS_PER_THREAD = 1000;
+
+  QVector<QVariantList> rows(numRecords);
+  int chunks = atools::util::parallelChunks(numRecords, 0, MIN_RECORDS_PER_THREAD);
+
+  // First error for each chunk
+  std::vector<std::unique_ptr<atools::Exception> > errors(static_cast<size_t>(chunks));
+
+  QVariantList *rowData = rows.data();
+  std::unique_ptr<atools::Exception> *errorData = errors.data();
+  int numColumns = columns.size();
+
+  // Convert records in parallel ====================================
+  atools::util::parallelFor(numRecords, chunks, [&func, rowData, errorData, numColumns](int begin, int end, int chunk) -> void {
+    for(int i = begin; i < end; i++)
+    {
+      try
+      {
+        QVariantList& row = rowData[i];
+        row.reserve(numColumns);
+        if(!func(row, i))
+          row.clear();
+      }
+      catch(const atools::Exception& e)
+      {
+        errorData[chunk].reset(e.clone());
+        break;
+      }
+      catch(const std::exception& e)
+      {
+        errorData[chunk].reset(new atools::Exception(QString::fromUtf8(e.what())));
+        break;
+      }
+    }
+  }, MIN_RECORDS_PER_THREAD);
+
+  // Chunks are in record order - first error is the one of the earliest record
+  for(const std::unique_ptr<atools::Exception>& error : errors)
+  {
+    if(error)
+      error->raise();
+  }
+
+  // Insert rows in file order ====================================
+  SqlBulkInsert insert(db, tableName, QStringList(idColumnName) + columns);
+  int numInserted = 0;
+  for(QVariantList& row : rows)
+  {
+    if(!row.isEmpty())
+    {
+      row.prepend(id++);
+      insert.addRow(row);
+      undoHandler.inserted();
+      numInserted++;
+
+      // Release memory early
+      row.clear();
+    }
+  }
+  insert.flush();
+
+  return numInserted;
+}
+
 QString DataManagerBase::at(const QStringList& line, int index, bool nowarn)
 {
   if(index < line.size())
@@ -497,6 +714,7 @@ void DataManagerBase::clearUndoRedoData()
   {
     SqlQuery query(db);
     query.exec("delete from undo_data");
+    numUndoRowsRemoved += query.numRowsAffected();
     query.exec("delete from undo_current");
     query.exec("insert into undo_current (undo_group_id) values(0)");
   }
@@ -535,6 +753,7 @@ void DataManagerBase::preUndoBulkInsert(int idFrom)
 void DataManagerBase::abortUndoBulkInsert()
 {
   preBulkInsertId = currentId = -1;
+  notifyTableChanged();
 }
 
 void DataManagerBase::postUndoBulkInsert()
@@ -578,6 +797,7 @@ void DataManagerBase::postUndoBulkInsert()
 
   // get current (max) id from table
   initCurrentId();
+  notifyTableChanged();
 }
 
 void DataManagerBase::preUndoDeleteAll()
@@ -602,9 +822,12 @@ void DataManagerBase::preUndoDeleteAll()
   }
 }
 
-void DataManagerBase::preUndoUpdate(const QSet<int>& ids)
+void DataManagerBase::preUndoUpdate(const QSet<int>& ids, const QStringList& columns)
 {
-  preUndoCopyInternal(ids, UNDO_UPDATE);
+  if(undoColumnsSupported)
+    preUndoCopyColumns(ids, columns);
+  else
+    preUndoCopyInternal(ids, UNDO_UPDATE);
 }
 
 void DataManagerBase::preUndoDelete(const QSet<int>& ids)
@@ -633,6 +856,76 @@ void DataManagerBase::preUndoCopyInternal(const QSet<int>& ids, UndoAction actio
   }
 }
 
+void DataManagerBase::preUndoCopyColumns(const QSet<int>& ids, QStringList columns)
+{
+  if(undoActive)
+  {
+    truncateUndoIf();
+    currentUndoGroupId++;
+
+    columns.removeAll(idColumnName);
+    columns.removeDuplicates();
+
+    // Store names of changed columns which are restored on undo or redo
+    QString undoColumns = columns.join(',');
+
+    // Add id and columns which cannot be null in the undo table - these are not restored
+    QStringList copyColumns({idColumnName});
+    for(const QString& col : undoNotNullColumns)
+    {
+      if(!columns.contains(col))
+        copyColumns.append(col);
+    }
+    copyColumns.append(columns);
+
+    SqlQuery insert(db);
+    insert.prepare("insert into undo_data (undo_data_id, undo_group_id, undo_type, undo_columns, " % copyColumns.join(", ") %
+                   ") values (?, ?, ?, ?" % QString(", ?").repeated(copyColumns.size()) % ")");
+
+    QueryWrapper wrapped("select " % copyColumns.join(", ") % " from " % tableName, db, ids, idColumnName);
+    wrapped.exec();
+    while(wrapped.next())
+    {
+      insert.bindValue(0, ++currentUndoId);
+      insert.bindValue(1, currentUndoGroupId);
+      insert.bindValue(2, atools::charToStr(UNDO_UPDATE));
+      insert.bindValue(3, undoColumns);
+      for(int i = 0; i < copyColumns.size(); i++)
+        insert.bindValue(i + 4, wrapped.query.value(i));
+      insert.exec();
+    }
+  }
+}
+
+void DataManagerBase::undoRedoColumns(const SqlRecord& undoRec, int id, int undoDataId)
+{
+  QStringList columns = undoRec.valueStr("undo_columns").split(',');
+  columns.removeAll(QString());
+  if(columns.isEmpty())
+    return;
+
+  // Get temporary values of changed columns from main table
+  SqlRecord tempRecord = getRecord(id);
+  SqlRecord restoreRecord;
+  QStringList binds;
+  for(const QString& col : columns)
+  {
+    restoreRecord.appendFieldAndValue(col, undoRec.value(col));
+    binds.append(col % " = ?");
+  }
+
+  // Copy changed columns from undo table back to original table
+  updateRecordsInternal(restoreRecord, {id});
+
+  // Update undo table with temp values from original table
+  SqlQuery update(db);
+  update.prepare("update undo_data set " % binds.join(", ") % " where undo_data_id = ?");
+  for(int i = 0; i < columns.size(); i++)
+    update.bindValue(i, tempRecord.value(columns.at(i)));
+  update.bindValue(columns.size(), undoDataId);
+  update.exec();
+}
+
 void DataManagerBase::postUndo()
 {
   // Write current undo state to database
@@ -675,8 +968,21 @@ void DataManagerBase::undoRedo(bool undo)
       int id = undoRec.valueInt(idColumnName);
       int undoDataId = undoRec.valueInt("undo_data_id");
 
+      if(action == UNDO_UPDATE && !undoRec.isNull("undo_columns"))
+      {
+        // Partial copy - swap changed columns only
+        undoRedoColumns(undoRec, id, undoDataId);
+
+        if(!invokeCallback(total, current++))
+        {
+          canceled = true;
+          break;
+        }
+        continue;
+      }
+
       // Get rid if fields except the ones from the main table
-      undoRec.remove({"undo_data_id", "undo_group_id", "undo_type"});
+      undoRec.remove({"undo_data_id", "undo_group_id", "undo_type", "undo_columns"});
 
       switch(action)
       {
@@ -689,6 +995,7 @@ void DataManagerBase::undoRedo(bool undo)
             // Insert again - keep copy in undo table for undo
             updateIdColumn(undoRec, id);
             queryInsertRecords->bindAndExecRecord(undoRec, ":");
+            notifyRowsChanged({id});
           }
           break;
 
@@ -716,6 +1023,7 @@ void DataManagerBase::undoRedo(bool undo)
             // Revert delete - insert values from undo table and keep copy in undo table for redo
             updateIdColumn(undoRec, id);
             queryInsertRecords->bindAndExecRecord(undoRec, ":");
+            notifyRowsChanged({id});
           }
           else
             // Delete again - keep copy in undo table for undo
@@ -794,18 +1102,14 @@ void DataManagerBase::canUndoRedo(bool& undo, bool& redo) const
   undo = redo = false;
 
   selectMinMax->exec();
-  if(selectMinMax->next())
+  if(selectMinMax->next() && !selectMinMax->isNull(0))
   {
     int minGroupId = selectMinMax->valueInt(0);
     int maxGroupId = selectMinMax->valueInt(1);
-    int count = selectMinMax->valueInt(2);
 
-    if(count > 0)
-    {
-      // Undo id points to the step which will be reverted when calling undo()
-      undo = currentUndoGroupId >= minGroupId;
-      redo = currentUndoGroupId < maxGroupId;
-    }
+    // Undo id points to the step which will be reverted when calling undo()
+    undo = currentUndoGroupId >= minGroupId;
+    redo = currentUndoGroupId < maxGroupId;
   }
 }
 
@@ -887,19 +1191,62 @@ void DataManagerBase::truncateUndoIf()
   queryTruncateUndoDataCurrent->bindValue(0, currentUndoGroupId);
   queryTruncateUndoDataCurrent->exec();
 
+  numUndoRowsRemoved += queryTruncateUndoDataCurrent->numRowsAffected();
+
   // Now check if maximum undo steps are exceeded and remove all rows beginning from the first one (older steps)
+  // Group ids are consecutive which allows to use the indexed min and max instead of counting
+  int truncateGroupId = -1, minUndoDataId = -1;
   selectMinMax->exec();
-  if(selectMinMax->next())
+  if(selectMinMax->next() && !selectMinMax->isNull(0))
   {
+    int minUndoGroupId = selectMinMax->valueInt(0);
     int maxUndoGroupId = selectMinMax->valueInt(1);
-    int count = selectMinMax->valueInt(2);
+    minUndoDataId = selectMinMax->valueInt(2);
+
+    if(maxUndoGroupId - minUndoGroupId + 1 > maximumUndoSteps + 10)
+      truncateGroupId = maxUndoGroupId - maximumUndoSteps;
+  }
+  selectMinMax->finish();
 
-    if(count > maximumUndoSteps + 10)
+  // Check if maximum number of rows is exceeded - data ids are consecutive too
+  if(minUndoDataId != -1 && maximumUndoRows > 0 && currentUndoId - minUndoDataId + 1 > maximumUndoRows)
+  {
+    // Find the group of the first row to keep and remove all groups before
+    selectUndoGroupByDataId->bindValue(0, currentUndoId - maximumUndoRows + 1);
+    selectUndoGroupByDataId->exec();
+    if(selectUndoGroupByDataId->next())
+      truncateGroupId = std::max(truncateGroupId, selectUndoGroupByDataId->valueInt(0));
+    selectUndoGroupByDataId->finish();
+  }
+
+  if(truncateGroupId != -1)
+  {
+    queryTruncateUndoData->bindValue(0, truncateGroupId);
+    queryTruncateUndoData->exec();
+    numUndoRowsRemoved += queryTruncateUndoData->numRowsAffected();
+
+#ifdef DEBUG_INFORMATION
+    qDebug() << Q_FUNC_INFO << "truncated below group" << truncateGroupId << "removed" << numUndoRowsRemoved;
+#endif
+  }
+}
+
+void DataManagerBase::compactUndo(bool force)
+{
+  if(force || isUndoCompactRecommended())
+  {
+    qDebug() << Q_FUNC_INFO << tableName << "removed undo rows" << numUndoRowsRemoved;
+
+    if(db->isAutomaticTransactions())
     {
-      int id = maxUndoGroupId - maximumUndoSteps;
-      queryTruncateUndoData->bindValue(0, id);
-      queryTruncateUndoData->exec();
+      // Vacuum cannot run in a transaction - commit and reopen transaction afterwards
+      db->commit();
+      db->vacuum();
     }
+    else
+      SqlQuery(db).exec("vacuum");
+
+    numUndoRowsRemoved = 0;
   }
 }
 
@@ -942,7 +1289,11 @@ void DataManagerBase::initQueries()
     queryTruncateUndoData = new SqlQuery(db);
     queryTruncateUndoData->prepare("delete from undo_data where undo_group_id < ?");
 
-    selectMinMax = new SqlQuery("select min(undo_group_id), max(undo_group_id), count(distinct undo_group_id) from undo_data", db);
+    // Min and max are resolved by index
+    selectMinMax = new SqlQuery("select min(undo_group_id), max(undo_group_id), min(undo_data_id) from undo_data", db);
+
+    selectUndoGroupByDataId = new SqlQuery(db);
+    selectUndoGroupByDataId->prepare("select undo_group_id from undo_data where undo_data_id >= ? order by undo_data_id limit 1");
 
     queryTruncateUndoDataCurrent = new SqlQuery(db);
     queryTruncateUndoDataCurrent->prepare("delete from undo_data where undo_group_id > ?");
@@ -951,13 +1302,28 @@ void DataManagerBase::initQueries()
     querySelectUndoByGroup->prepare("select undo_type, count(1) from undo_data where undo_group_id = ? group by undo_group_id");
 
     updateUndoById = new SqlQuery(db);
-    updateUndoById->prepare(util->buildUpdateStatement("undo_data", "undo_data_id = :id", {"undo_data_id", "undo_group_id", "undo_type"}));
+    updateUndoById->prepare(util->buildUpdateStatement("undo_data", "undo_data_id = :id",
+                                                       {"undo_data_id", "undo_group_id", "undo_type", "undo_columns"}));
 
     selectUndoByGroup = new SqlQuery(db);
     selectUndoByGroup->prepare("select * from undo_data where undo_group_id = :id");
 
+    // Full copies leave undo_columns null
     queryInsertUndoData = new SqlQuery(db);
-    queryInsertUndoData->prepare(util->buildInsertStatement("undo_data"));
+    queryInsertUndoData->prepare(util->buildInsertStatement("undo_data", QString(), {"undo_columns"}));
+
+    undoColumnsSupported = util->hasTableAndColumn("undo_data", "undo_columns");
+
+    // Collect columns which have to be copied for partial updates - "pragma table_info" returns cid, name, type, notnull, ...
+    undoNotNullColumns.clear();
+    SqlQuery pragma("pragma table_info(undo_data)", db);
+    pragma.exec();
+    while(pragma.next())
+    {
+      QString name = pragma.valueStr(1);
+      if(pragma.valueBool(3) && !name.startsWith("undo_") && name != idColumnName)
+        undoNotNullColumns.append(name);
+    }
   }
 
   if(hasSchema())
@@ -984,6 +1350,9 @@ void DataManagerBase::deInitQueries()
   delete selectMinMax;
   selectMinMax = nullptr;
 
+  delete selectUndoGroupByDataId;
+  selectUndoGroupByDataId = nullptr;
+
   delete queryTruncateUndoDataCurrent;
   queryTruncateUndoDataCurrent = nullptr;
 
@@ -1030,6 +1399,7 @@ void DataManagerBase::preCleanup(const QStringList& columns)
   for(const QString& column : columns)
     query.exec("update " % tableName % " set " % column % " = '' where " % column % " is null");
   db->analyze();
+  notifyTableChanged();
 }
 
 void DataManagerBase::postCleanup(const QStringList& columns)
@@ -1038,6 +1408,7 @@ void DataManagerBase::postCleanup(const QStringList& columns)
   for(const QString& column : columns)
     query.exec("update " % tableName % " set " % column % " = null where " % column % " = ''");
   db->analyze();
+  notifyTableChanged();
 }
 
 } // namespace sql
@@ -23,16 +23,22 @@
 #include <QCoreApplication>
 #include <QVector>
 
+#include <functional>
+
 class QAction;
 
 namespace atools {
 
 namespace geo {
 class Pos;
+class Rect;
+class SpatialGrid;
+struct IndexDistance;
 }
 
 namespace sql {
 
+class DataManagerUndoHandler;
 class SqlDatabase;
 class SqlRecord;
 class SqlUtil;
@@ -161,6 +167,21 @@ public:
   /* true if row with the given id and column name has a BLOB larger than 0 */
   bool hasBlob(int id, const QString& colName) const;
 
+  /* Spatial queries using the in-memory index added by addSpatialIndex(). The index is loaded on first use and kept
+   * up to date for all changes done through this class. spatialIndex is the number returned by addSpatialIndex().
+   * Rows with null coordinates are not indexed. */
+
+  /* Get ids of all rows within radiusMeter sorted by great circle distance. IndexDistance::index contains the id.
+   * maxResults: Return only the closest rows if > 0. */
+  void getIdsInRadius(QVector<atools::geo::IndexDistance>& result, const atools::geo::Pos& pos, float radiusMeter,
+                      int maxResults = 0, int spatialIndex = 0);
+
+  /* Get id of the nearest row within maxRadiusMeter or -1 if none */
+  int getNearestId(const atools::geo::Pos& pos, float maxRadiusMeter, float *distanceMeter = nullptr, int spatialIndex = 0);
+
+  /* Get ids of all rows inside rect sorted by id. Considers rectangles crossing the anti-meridian. */
+  void getIdsInRect(QVector<int>& ids, const atools::geo::Rect& rect, int spatialIndex = 0);
+
   /* Update schema if needed. Empty body here. */
   virtual void updateSchema();
 
@@ -237,6 +258,23 @@ public:
     maximumUndoSteps = value;
   }
 
+  /* Maximum number of rows in the undo table. Oldest steps are removed before a change if exceeded.
+   * A single step is never split and can exceed this limit. */
+  void setMaximumUndoRows(int value)
+  {
+    maximumUndoRows = value;
+  }
+
+  /* true if enough undo rows were removed in this session to make compactUndo() worthwhile */
+  bool isUndoCompactRecommended() const
+  {
+    return numUndoRowsRemoved >= UNDO_COMPACT_MIN_ROWS;
+  }
+
+  /* Commits pending changes and runs vacuum on the database if recommended or forced.
+   * Call this when idle or on shutdown since it rewrites the whole database file. */
+  void compactUndo(bool force = false);
+
   void initQueries();
   void deInitQueries();
 
@@ -323,6 +361,17 @@ private:
    * Clean up - set empty string columns back to null - no need to undo. */
   void postCleanup(const QStringList& columns);
 
+  /* Fills row with values for all columns except the id for the given record number of an import file.
+   * Return false to skip the record. Can throw exceptions. Called from several threads at once. */
+  typedef std::function<bool (QVariantList& row, int record)> BulkRowFuncType;
+
+  /* Converts numRecords records in parallel using func and inserts the rows in record order with multi-row
+   * statements. columns are all columns filled by func excluding the id column. Ids are assigned starting at id
+   * which is incremented for each row. Exceptions thrown by func are rethrown for the first failing record before
+   * anything is inserted. Does not commit. Returns the number of inserted rows. */
+  int bulkInsert(const QStringList& columns, int numRecords, const BulkRowFuncType& func, int& id,
+                 atools::sql::DataManagerUndoHandler& undoHandler);
+
   /* Prints a warning of colummn does not exist */
   QString at(const QStringList& line, int index, bool nowarn = false);
 
@@ -333,12 +382,38 @@ private:
    * Returns true if table was changed. */
   bool addColumnIf(const QString& colName, const QString& colType);
 
+  /* Add an in-memory spatial index for the position in the given coordinate columns. Call in the constructor.
+   * Returns the number of the index to be used in spatial queries. */
+  int addSpatialIndex(const QString& lonxColumn, const QString& latyColumn);
+
+  /* Change hooks for derived classes which keep data derived from the main table like statistics.
+   * Called for all changes done by this class including undo and redo. Default implementations do nothing.
+   * rowsChanging() is called before rows are updated or deleted and rowsChanged() after rows were inserted or updated.
+   * An update calls both. tableChanged() is called after bulk changes where the affected rows are not known
+   * like imports, deleting all rows or cleanup. */
+  virtual void rowsChanging(const QSet<int>&)
+  {
+  }
+
+  virtual void rowsChanged(const QSet<int>&)
+  {
+  }
+
+  virtual void tableChanged()
+  {
+  }
+
   atools::sql::SqlDatabase *db = nullptr;
 
   QString tableName, idColumnName;
 
   void deleteRowsInternal(const QSet<int>& ids);
 
+  /* Update spatial indexes and call the virtual change hooks */
+  void notifyRowsChanging(const QSet<int>& ids);
+  void notifyRowsChanged(const QSet<int>& ids);
+  void notifyTableChanged();
+
   /* Update all fields in the record given for given ids */
   void updateRecordsInternal(sql::SqlRecord record, const QSet<int>& ids);
 
@@ -350,9 +425,15 @@ private:
 
   /* pre methods create a copy of main table rows in the table undo_data. These have to be called before any table change. */
   void preUndoInsert(SqlRecordList records);
-  void preUndoUpdate(const QSet<int>& ids);
+  void preUndoUpdate(const QSet<int>& ids, const QStringList& columns);
   void preUndoDelete(const QSet<int>& ids);
   void preUndoCopyInternal(const QSet<int>& ids, UndoAction undoAction);
+
+  /* Copies only the given columns plus id and not null columns. Changed column names are stored in undo_columns. */
+  void preUndoCopyColumns(const QSet<int>& ids, QStringList columns);
+
+  /* Swap values of changed columns only between main table and undo table for an update */
+  void undoRedoColumns(const SqlRecord& undoRec, int id, int undoDataId);
   void preUndoDeleteAll();
 
   /* Copies current undo_group_id to table undo_current */
@@ -383,8 +464,20 @@ private:
   QString createUndoScript, dropScript, textSuffixSingular, textSuffixPlural;
   QStringList createScripts;
 
+  /* Vacuum is recommended after removing this number of undo rows */
+  static Q_DECL_CONSTEXPR int UNDO_COMPACT_MIN_ROWS = 50000;
+
   bool undoActive = false;
-  int currentId = 0, currentUndoId = 0, preBulkInsertId = -1, maximumUndoSteps = 1000;
+  int currentId = 0, currentUndoId = 0, preBulkInsertId = -1, maximumUndoSteps = 1000, maximumUndoRows = 500000;
+
+  /* Number of rows removed from undo_data by truncation in this session */
+  int numUndoRowsRemoved = 0;
+
+  /* undo_data has column undo_columns which allows to store changed columns only for updates */
+  bool undoColumnsSupported = false;
+
+  /* Columns in undo_data which do not allow null values and have to be copied for partial updates */
+  QStringList undoNotNullColumns;
 
   /* Undo id points to the step which will be reverted when calling undo(). Can be min(undo_group_id) - 1 to max(undo_group_id) */
   int currentUndoGroupId = 0;
@@ -393,12 +486,28 @@ private:
   QAction *undoAction = nullptr, *redoAction = nullptr;
 
   atools::sql::SqlQuery *queryUndoCurrent = nullptr, *queryTruncateUndoData = nullptr, *selectMinMax = nullptr,
-                        *queryTruncateUndoDataCurrent = nullptr, *querySelectUndoByGroup = nullptr, *updateUndoById = nullptr,
+                        *queryTruncateUndoDataCurrent = nullptr, *selectUndoGroupByDataId = nullptr, *querySelectUndoByGroup = nullptr, *updateUndoById = nullptr,
                         *selectUndoByGroup = nullptr, *queryInsertUndoData = nullptr, *queryDeleteRowById = nullptr,
                         *queryInsertRecords = nullptr, *querySelectById = nullptr;
 
   UndoRedoCallbackType callback;
   qint64 callbackTime = 0L;
+
+  /* Coordinate columns and grid. Grid is null if not loaded yet. */
+  struct SpatialIndexColumns
+  {
+    QString lonxColumn, latyColumn;
+    atools::geo::SpatialGrid *grid = nullptr;
+  };
+
+  /* Get loaded spatial grid */
+  const atools::geo::SpatialGrid *spatialGrid(int spatialIndex);
+
+  /* Insert positions of the given rows or all rows if ids is empty */
+  void loadSpatialPositions(SpatialIndexColumns& index, const QSet<int>& ids);
+  void clearSpatialIndexes();
+
+  QVector<SpatialIndexColumns> spatialIndexes;
 };
 
 /* Creates bulk before insert. Aborts bulk insert in destructor. */
@@ -0,0 +1,150 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlbulkinsert.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "sql/sqlutil.h"
+
+#include <QDebug>
+#include <QStringBuilder>
+
+namespace atools {
+namespace sql {
+
+Q_DECL_CONSTEXPR int SqlBulkInsert::MAX_VARIABLES;
+
+SqlBulkInsert::SqlBulkInsert(SqlDatabase *sqlDb, const QString& tablename, const QStringList& columnNames,
+                             int rowsPerStatementParam, const QString& otherClause)
+  : db(sqlDb), table(tablename), clause(otherClause), columns(columnNames)
+{
+  if(columns.isEmpty())
+    columns = SqlUtil(db).buildColumnList(table);
+
+  if(columns.isEmpty())
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": No columns for table \"" % table % "\"");
+
+  // Stay below the host parameter limit
+  rowsPerStatement = std::max(1, std::min(rowsPerStatementParam, MAX_VARIABLES / columns.size()));
+  values.reserve(rowsPerStatement * columns.size());
+}
+
+SqlBulkInsert::~SqlBulkInsert()
+{
+  if(!values.isEmpty())
+    qWarning() << Q_FUNC_INFO << "Table" << table << getNumPending() << "rows not written";
+
+  delete fullQuery;
+}
+
+void SqlBulkInsert::addRow(const QVariantList& row)
+{
+  if(row.size() != columns.size())
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Number of values " % QString::number(row.size()) %
+                       " does not match number of columns " % QString::number(columns.size()) %
+                       " for table \"" % table % "\"");
+
+  values.append(row);
+
+  if(values.size() >= rowsPerStatement * columns.size())
+    flush();
+}
+
+void SqlBulkInsert::addRecord(const SqlRecord& record)
+{
+  QVariantList row;
+  row.reserve(columns.size());
+  for(const QString& column : columns)
+    row.append(record.contains(column) ? record.value(column) : QVariant());
+  addRow(row);
+}
+
+void SqlBulkInsert::addRecords(const SqlRecordList& records)
+{
+  for(const SqlRecord& record : records)
+    addRecord(record);
+}
+
+int SqlBulkInsert::flush()
+{
+  int numRows = getNumPending();
+  int offset = 0;
+
+  // Full chunks use the cached prepared statement
+  while(numRows - offset >= rowsPerStatement)
+  {
+    execRows(offset, rowsPerStatement);
+    offset += rowsPerStatement;
+  }
+
+  // Remainder
+  if(offset < numRows)
+    execRows(offset, numRows - offset);
+
+  values.clear();
+  numWritten += numRows;
+  return numRows;
+}
+
+void SqlBulkInsert::execRows(int offset, int numRows)
+{
+  SqlQuery *query, remainderQuery(db);
+
+  if(numRows == rowsPerStatement)
+  {
+    if(fullQuery == nullptr)
+    {
+      fullQuery = new SqlQuery(db);
+      fullQuery->prepare(buildStatement(rowsPerStatement));
+    }
+    query = fullQuery;
+  }
+  else
+  {
+    remainderQuery.prepare(buildStatement(numRows));
+    query = &remainderQuery;
+  }
+
+  int numColumns = columns.size();
+  int first = offset * numColumns, num = numRows * numColumns;
+  for(int i = 0; i < num; i++)
+    query->bindValue(i, values.at(first + i));
+
+  query->exec();
+
+  if(query->numRowsAffected() != numRows)
+    qWarning() << Q_FUNC_INFO << "Table" << table << "inserted" << query->numRowsAffected() << "expected" << numRows;
+}
+
+QString SqlBulkInsert::buildStatement(int numRows) const
+{
+  QString row = "(" % QString("?, ").repeated(columns.size() - 1) % "?)";
+
+  QStringList rows;
+  rows.reserve(numRows);
+  for(int i = 0; i < numRows; i++)
+    rows.append(row);
+
+  return "insert " % clause % " into " % table % " (" % columns.join(", ") % ") values" % rows.join(", ");
+}
+
+} // namespace sql
+} // namespace atools
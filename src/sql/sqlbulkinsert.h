@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLBULKINSERT_H
+#define ATOOLS_SQL_SQLBULKINSERT_H
+
+#include "sql/sqltypes.h"
+
+#include <QStringList>
+#include <QVariantList>
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+class SqlQuery;
+class SqlRecord;
+
+/*
+ * Buffers rows for one table and writes them using multi-row statements
+ * "insert into table (a, b) values(?, ?), (?, ?), ...". This avoids the per statement overhead
+ * of SQLite and Qt which is considerable when inserting millions of small rows.
+ *
+ * Rows per statement are reduced automatically to stay below the SQLite host parameter limit.
+ * Rows are written automatically when the buffer is full. Call flush() to write the remaining rows
+ * before reading from the table or committing.
+ *
+ * Throws SqlException on errors.
+ */
+class SqlBulkInsert
+{
+public:
+  /*
+   * @param sqlDb open database
+   * @param tablename table to insert rows into
+   * @param columnNames columns in order of values for addRow(). All table columns are used if empty.
+   * @param rowsPerStatement maximum number of rows inserted with one statement
+   * @param otherClause inserted after "insert" like "or replace"
+   */
+  SqlBulkInsert(atools::sql::SqlDatabase *sqlDb, const QString& tablename,
+                const QStringList& columnNames = QStringList(), int rowsPerStatement = 100,
+                const QString& otherClause = QString());
+  ~SqlBulkInsert();
+
+  SqlBulkInsert(const SqlBulkInsert& other) = delete;
+  SqlBulkInsert& operator=(const SqlBulkInsert& other) = delete;
+
+  /* Add a row with values in column order. Number of values has to match the number of columns. */
+  void addRow(const QVariantList& row);
+
+  /* Add a row by matching record field names to columns. Columns missing in the record are null. */
+  void addRecord(const atools::sql::SqlRecord& record);
+  void addRecords(const atools::sql::SqlRecordList& records);
+
+  /* Write all buffered rows. Returns number of rows inserted. */
+  int flush();
+
+  /* Remove all buffered rows without writing */
+  void clear()
+  {
+    values.clear();
+  }
+
+  /* Number of buffered rows not written yet */
+  int getNumPending() const
+  {
+    return values.size() / columns.size();
+  }
+
+  /* Total number of rows written since creation */
+  int getNumWritten() const
+  {
+    return numWritten;
+  }
+
+  /* Effective rows per statement after applying the parameter limit */
+  int getRowsPerStatement() const
+  {
+    return rowsPerStatement;
+  }
+
+  const QStringList& getColumns() const
+  {
+    return columns;
+  }
+
+  /* Default limit for the number of host parameters in a statement (SQLITE_MAX_VARIABLE_NUMBER) for SQLite
+   * before 3.32. Newer versions allow 32766. */
+  static Q_DECL_CONSTEXPR int MAX_VARIABLES = 999;
+
+private:
+  /* Insert numRows rows from the buffer beginning at row offset. Uses the prepared statement for full chunks. */
+  void execRows(int offset, int numRows);
+  QString buildStatement(int numRows) const;
+
+  atools::sql::SqlDatabase *db;
+  QString table, clause;
+  QStringList columns;
+  int rowsPerStatement, numWritten = 0;
+
+  /* Flat list of buffered rows with columns.size() values each */
+  QVariantList values;
+
+  /* Prepared on first use for statements having rowsPerStatement rows */
+  atools::sql::SqlQuery *fullQuery = nullptr;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLBULKINSERT_H
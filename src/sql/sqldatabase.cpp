@@ -17,19 +17,33 @@
 
 #include "sql/sqldatabase.h"
 #include "sql/sqlexception.h"
+#include "sql/sqlpagecompression.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
+#include "sql/sqlstatementcache.h"
 
 #include <QSettings>
 #include <QDebug>
 #include <QFileInfo>
 #include <QSqlIndex>
 #include <QSqlDriver>
+#include <QMutex>
 
 namespace atools {
 
 namespace sql {
 
+/* Statement caches per connection name. Not deleted on exit to avoid finalizing statements after driver
+ * shutdown. */
+static QHash<QString, SqlStatementCache *> statementCaches;
+static QMutex statementCachesMutex;
+
+static void deleteStatementCache(const QString& connectionName)
+{
+  QMutexLocker locker(&statementCachesMutex);
+  delete statementCaches.take(connectionName);
+}
+
 SqlDatabase::SqlDatabase()
 {
 }
@@ -147,6 +161,9 @@ void SqlDatabase::close()
   if(readonly && isFileModified())
     qWarning() << Q_FUNC_INFO << "Readonly database modified when closed" << databaseName();
 
+  // Finalize cached statements before closing
+  deleteStatementCache(connectionName());
+
   db.close();
 
   qInfo() << Q_FUNC_INFO << "Closed database" << databaseName();
@@ -206,6 +223,19 @@ void SqlDatabase::executePragmas(const QStringList& pragmas)
   checkError(db.transaction(), "SqlDatabase::pragma() error");
 }
 
+QStringList SqlDatabase::readPragmas(const QStringList& names) const
+{
+  QStringList pragmas;
+  for(const QString& name : names)
+  {
+    SqlQuery query(this);
+    query.exec("pragma " + name);
+    if(query.next())
+      pragmas.append("pragma " + name + "=" + query.value(0).toString());
+  }
+  return pragmas;
+}
+
 void SqlDatabase::attachDatabase(const QString& file, const QString& name)
 {
   checkError(db.rollback(), "SqlDatabase::attachDatabase() error");
@@ -348,6 +378,15 @@ void SqlDatabase::setDatabaseName(const QString& name)
   db.setDatabaseName(name);
 }
 
+void SqlDatabase::setCompressedDatabaseName(const QString& filename)
+{
+  checkError(!isOpen(), "SqlDatabase::setCompressedDatabaseName() on opened database");
+  SqlPageCompression::registerVfs();
+  setReadonly();
+  db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_OPEN_URI");
+  db.setDatabaseName(SqlPageCompression::uriFilename(filename));
+}
+
 void SqlDatabase::setUserName(const QString& name)
 {
   checkError(!isOpen(), "SqlDatabase::setUserName() on opened database");
@@ -458,9 +497,20 @@ SqlDatabase SqlDatabase::database(const QString& connectionName, bool open)
 
 void SqlDatabase::removeDatabase(const QString& connectionName)
 {
+  deleteStatementCache(connectionName);
   QSqlDatabase::removeDatabase(connectionName);
 }
 
+SqlStatementCache& SqlDatabase::statementCache() const
+{
+  QMutexLocker locker(&statementCachesMutex);
+
+  SqlStatementCache *& cache = statementCaches[connectionName()];
+  if(cache == nullptr)
+    cache = new SqlStatementCache(this);
+  return *cache;
+}
+
 bool SqlDatabase::contains(const QString& connectionName)
 {
   return QSqlDatabase::contains(connectionName);
@@ -38,6 +38,8 @@ class SqlRecord;
  * This class also add a normal commit/rollback mechanism which always keeps an
  * transaction open.
  */
+class SqlStatementCache;
+
 class SqlDatabase
 {
 public:
@@ -94,6 +96,12 @@ public:
   void transaction();
 
   void setDatabaseName(const QString& name);
+
+  /* Use a database file created by SqlPageCompression::compress(). Registers the VFS, sets the URI filename
+   * and connection options and makes the connection read only. Throws atools::Exception if native SQLite
+   * access is not available. */
+  void setCompressedDatabaseName(const QString& filename);
+
   void setUserName(const QString& name);
   void setPassword(const QString& password);
   void setHostName(const QString& host);
@@ -132,6 +140,11 @@ public:
    * Rolls the current transaction back and executes the list of pragmas. Opens transaction again afterwards. */
   void executePragmas(const QStringList& pragmas);
 
+  /* Sqlite only.
+   * Reads the current values of the given pragma names like "journal_mode" or "cache_size" and
+   * returns statements like "pragma journal_mode=delete" which can be passed to executePragmas() to restore them. */
+  QStringList readPragmas(const QStringList& names) const;
+
   bool isAutocommit() const
   {
     return autocommit;
@@ -157,6 +170,10 @@ public:
   void attachDatabase(const QString& file, const QString& name);
   void detachDatabase(const QString& name);
 
+  /* Prepared statement cache for this connection. Created on first call and shared by all SqlDatabase
+   * instances using the same connection name. Deleted when the database is closed or removed. */
+  atools::sql::SqlStatementCache& statementCache() const;
+
   /* Sqlite only. Compresses the database */
   void vacuum();
 
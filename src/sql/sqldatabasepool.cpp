@@ -0,0 +1,162 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqldatabasepool.h"
+
+#include "sql/sqldatabase.h"
+
+#include <QDebug>
+#include <QThread>
+
+namespace atools {
+namespace sql {
+
+Q_DECL_CONSTEXPR qint64 SqlDatabasePool::MMAP_SIZE;
+
+SqlDatabasePool::Checkout::Checkout(Checkout&& other)
+  : pool(other.pool), database(other.database)
+{
+  other.pool = nullptr;
+  other.database = nullptr;
+}
+
+SqlDatabasePool::Checkout::~Checkout()
+{
+  if(pool != nullptr && database != nullptr)
+    pool->checkin(database);
+}
+
+// ============================================================================================
+SqlDatabasePool::SqlDatabasePool(const SqlDatabase *templateDb, const QStringList& pragmas)
+  : databaseName(templateDb->databaseName()), driverName(templateDb->driverName()),
+  connectOptions(templateDb->connectOptions()), connectionPrefix(templateDb->connectionName() + "_pool_"),
+  connectionPragmas(pragmas)
+{
+  // Add read only flag to options given by the template
+  if(!connectOptions.contains("QSQLITE_OPEN_READONLY"))
+    connectOptions = connectOptions.isEmpty() ? "QSQLITE_OPEN_READONLY" : connectOptions + ";QSQLITE_OPEN_READONLY";
+
+  if(connectionPragmas.isEmpty())
+    connectionPragmas = QStringList({"pragma mmap_size=" + QString::number(MMAP_SIZE), "pragma query_only=on"});
+}
+
+SqlDatabasePool::~SqlDatabasePool()
+{
+  QMutexLocker locker(&mutex);
+
+  if(!connections.isEmpty())
+    qDebug() << Q_FUNC_INFO << "Closing" << connections.size() << "connections";
+
+  // Disconnect first to avoid calls for connections which are still checked out
+  for(const Connection& connection : qAsConst(connections))
+    QObject::disconnect(connection.finishedConnection);
+
+  for(QThread *thread : connections.keys())
+    releaseThreadInternal(thread);
+}
+
+SqlDatabasePool::Checkout SqlDatabasePool::checkout()
+{
+  QThread *thread = QThread::currentThread();
+  QMutexLocker locker(&mutex);
+
+  Connection& connection = connections[thread];
+  if(connection.db == nullptr)
+  {
+    // First checkout in this thread - clone and open a new connection ===========================
+    QString name = connectionPrefix + QString::number(++connectionNum);
+    SqlDatabase *db = new SqlDatabase(SqlDatabase::addDatabase(driverName, name));
+
+    try
+    {
+      db->setDatabaseName(databaseName);
+      db->setConnectOptions(connectOptions);
+      db->setReadonly();
+      db->setAutomaticTransactions(false);
+      db->open(connectionPragmas);
+    }
+    catch(...)
+    {
+      delete db;
+      SqlDatabase::removeDatabase(name);
+      connections.remove(thread);
+      throw;
+    }
+
+    connection.db = db;
+
+    // Clean up in the finishing thread itself since connection must be closed in its thread
+    connection.finishedConnection = QObject::connect(thread, &QThread::finished, [this, thread]() {
+            QMutexLocker threadLocker(&mutex);
+            releaseThreadInternal(thread);
+          });
+
+    qDebug() << Q_FUNC_INFO << "Opened" << name << "for" << databaseName;
+  }
+
+  connection.checkouts++;
+  return Checkout(this, connection.db);
+}
+
+void SqlDatabasePool::checkin(SqlDatabase *sqlDb)
+{
+  QMutexLocker locker(&mutex);
+
+  auto it = connections.find(QThread::currentThread());
+  if(it != connections.end() && it->db == sqlDb)
+    it->checkouts--;
+  else
+    qWarning() << Q_FUNC_INFO << "Connection returned from wrong thread" << sqlDb->connectionName();
+}
+
+void SqlDatabasePool::releaseThread()
+{
+  QMutexLocker locker(&mutex);
+  releaseThreadInternal(QThread::currentThread());
+}
+
+void SqlDatabasePool::releaseThreadInternal(QThread *thread)
+{
+  auto it = connections.find(thread);
+  if(it != connections.end())
+  {
+    if(it->checkouts > 0)
+      qWarning() << Q_FUNC_INFO << "Connection still checked out" << it->db->connectionName();
+    else
+    {
+      QObject::disconnect(it->finishedConnection);
+
+      QString name = it->db->connectionName();
+      it->db->close();
+      delete it->db;
+      connections.erase(it);
+
+      // Can only be called after all instances are deleted
+      SqlDatabase::removeDatabase(name);
+    }
+  }
+}
+
+int SqlDatabasePool::size() const
+{
+  QMutexLocker locker(&mutex);
+  return connections.size();
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,140 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLDATABASEPOOL_H
+#define ATOOLS_SQL_SQLDATABASEPOOL_H
+
+#include <QHash>
+#include <QMetaObject>
+#include <QMutex>
+#include <QStringList>
+
+class QThread;
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+
+/*
+ * Pool of read-only connections to an SQLite database file for concurrent readers like the web server
+ * or route calculations.
+ *
+ * Qt allows a connection only to be used in the thread that created it. Therefore each thread gets its own
+ * connection which is cloned from the template database on first checkout and reused on later checkouts
+ * in the same thread. Connections are opened with QSQLITE_OPEN_READONLY. The Qt SQLite driver always
+ * uses SQLITE_OPEN_NOMUTEX.
+ *
+ * A connection is closed and removed when its thread finishes or when calling releaseThread().
+ * Remaining connections are closed when the pool is deleted.
+ *
+ * Checkout example:
+ * {
+ *   SqlDatabasePool::Checkout checkout = pool.checkout();
+ *   SqlQuery query("select count(1) from airport", checkout.db());
+ *   ...
+ * } // returned here
+ */
+class SqlDatabasePool
+{
+public:
+  /* RAII handle for a connection. Returns the connection to the pool on destruction. */
+  class Checkout
+  {
+  public:
+    Checkout(Checkout&& other);
+    ~Checkout();
+
+    Checkout(const Checkout& other) = delete;
+    Checkout& operator=(const Checkout& other) = delete;
+
+    /* Open read-only database connection of the current thread */
+    atools::sql::SqlDatabase *db() const
+    {
+      return database;
+    }
+
+    atools::sql::SqlDatabase *operator->() const
+    {
+      return database;
+    }
+
+  private:
+    friend class SqlDatabasePool;
+
+    Checkout(SqlDatabasePool *databasePool, atools::sql::SqlDatabase *sqlDb)
+      : pool(databasePool), database(sqlDb)
+    {
+    }
+
+    SqlDatabasePool *pool;
+    atools::sql::SqlDatabase *database;
+  };
+
+  /*
+   * @param templateDb database to clone. Only the connection parameters and file name are used.
+   * @param pragmas executed on each new connection. Uses a shared mmap and query_only if empty.
+   */
+  explicit SqlDatabasePool(const atools::sql::SqlDatabase *templateDb, const QStringList& pragmas = QStringList());
+
+  /* Closes and removes all connections. No connection must be checked out and
+   * threads using the pool must be finished. */
+  ~SqlDatabasePool();
+
+  SqlDatabasePool(const SqlDatabasePool& other) = delete;
+  SqlDatabasePool& operator=(const SqlDatabasePool& other) = delete;
+
+  /* Get the connection for the calling thread. Opens a new connection if not done yet for this thread.
+   * Nested checkouts in the same thread return the same connection. Thread safe. */
+  Checkout checkout();
+
+  /* Close and remove the connection of the calling thread if not checked out.
+   * Optional since this is done automatically when the thread finishes. */
+  void releaseThread();
+
+  /* Number of open connections in all threads */
+  int size() const;
+
+  /* Memory mapping size for each connection. Mapped pages are shared by all connections. */
+  static Q_DECL_CONSTEXPR qint64 MMAP_SIZE = 256LL * 1024LL * 1024LL;
+
+private:
+  struct Connection
+  {
+    atools::sql::SqlDatabase *db = nullptr;
+    int checkouts = 0;
+    QMetaObject::Connection finishedConnection;
+  };
+
+  void checkin(atools::sql::SqlDatabase *sqlDb);
+
+  /* Close and remove connection for thread. Mutex has to be locked. */
+  void releaseThreadInternal(QThread *thread);
+
+  QString databaseName, driverName, connectOptions, connectionPrefix;
+  QStringList connectionPragmas;
+
+  QHash<QThread *, Connection> connections;
+  int connectionNum = 0;
+  mutable QMutex mutex;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLDATABASEPOOL_H
@@ -0,0 +1,250 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlexportstream.h"
+
+#include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QStringBuilder>
+
+namespace atools {
+namespace sql {
+
+SqlExportStream::SqlExportStream(QIODevice *outputDevice, Format outputFormat)
+  : device(outputDevice), format(outputFormat)
+{
+}
+
+SqlExportStream::~SqlExportStream()
+{
+}
+
+int SqlExportStream::exportQuery(SqlQuery& query)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  numRows = 0;
+  buffer.clear();
+  buffer.reserve(flushSize + 4096);
+
+  // Get column names once - values are read by index later
+  QList<QByteArray> columns;
+  SqlRecord record = query.record();
+  for(int i = 0; i < record.count(); i++)
+    columns.append(record.fieldName(i).toUtf8());
+
+  // Prepared JSON keys like "\"ident\":"
+  QList<QByteArray> jsonKeys;
+  if(format == JSON)
+  {
+    for(const QByteArray& column : columns)
+    {
+      appendJsonString(QString::fromUtf8(column));
+      jsonKeys.append(buffer + ':');
+      buffer.clear();
+    }
+    buffer.append("[\n");
+  }
+  else if(header)
+  {
+    for(int i = 0; i < columns.size(); i++)
+    {
+      if(i > 0)
+        buffer.append(QString(separator).toUtf8());
+      appendCsvString(QString::fromUtf8(columns.at(i)));
+    }
+    buffer.append('\n');
+  }
+
+  QByteArray separatorUtf8 = QString(separator).toUtf8();
+  int numColumns = columns.size();
+  while(query.next())
+  {
+    if(format == JSON)
+    {
+      if(numRows > 0)
+        buffer.append(",\n");
+      buffer.append('{');
+      for(int i = 0; i < numColumns; i++)
+      {
+        if(i > 0)
+          buffer.append(',');
+        buffer.append(jsonKeys.at(i));
+        appendValue(query.value(i));
+      }
+      buffer.append('}');
+    }
+    else
+    {
+      for(int i = 0; i < numColumns; i++)
+      {
+        if(i > 0)
+          buffer.append(separatorUtf8);
+        appendValue(query.value(i));
+      }
+      buffer.append('\n');
+    }
+
+    numRows++;
+    flush(false);
+  }
+
+  if(format == JSON)
+    buffer.append("\n]\n");
+  flush(true);
+
+  elapsedMs = timer.elapsed();
+  qDebug() << Q_FUNC_INFO << "rows" << numRows << "time" << elapsedMs << "ms" << getRowsPerSecond() << "rows/s";
+  return numRows;
+}
+
+double SqlExportStream::getRowsPerSecond() const
+{
+  return elapsedMs > 0 ? numRows * 1000. / elapsedMs : 0.;
+}
+
+void SqlExportStream::appendValue(const QVariant& value)
+{
+  if(value.isNull())
+  {
+    if(format == JSON)
+      buffer.append("null");
+    else
+      buffer.append(nullValue);
+    return;
+  }
+
+  switch(value.type())
+  {
+    case QVariant::Double:
+      buffer.append(QByteArray::number(value.toDouble(), 'f', numberPrecision));
+      break;
+
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+      buffer.append(QByteArray::number(value.toLongLong()));
+      break;
+
+    case QVariant::Bool:
+      if(format == JSON)
+        buffer.append(value.toBool() ? "true" : "false");
+      else
+        buffer.append(value.toBool() ? "1" : "0");
+      break;
+
+    case QVariant::ByteArray:
+      if(format == JSON)
+        buffer.append('"').append(value.toByteArray().toBase64()).append('"');
+      else
+        appendCsvString(QString::fromUtf8(value.toByteArray()));
+      break;
+
+    default:
+      if(format == JSON)
+        appendJsonString(value.toString());
+      else
+        appendCsvString(value.toString());
+      break;
+  }
+}
+
+void SqlExportStream::appendCsvString(const QString& value)
+{
+  // Quote if any special characters or separator are found or if the string is whitespace only
+  bool quote = false, whitespaceOnly = !value.isEmpty();
+  for(const QChar& c : value)
+  {
+    if(c == separator || c == escape || c == QChar::LineFeed || c == QChar::CarriageReturn)
+      quote = true;
+    if(!c.isSpace())
+      whitespaceOnly = false;
+  }
+
+  if(quote || whitespaceOnly)
+  {
+    QString escaped(value);
+    escaped.replace(escape, QString(escape) + escape);
+    buffer.append(QString(escape).toUtf8()).append(escaped.toUtf8()).append(QString(escape).toUtf8());
+  }
+  else
+    buffer.append(value.toUtf8());
+}
+
+void SqlExportStream::appendJsonString(const QString& value)
+{
+  buffer.append('"');
+
+  bool needsEscape = false;
+  for(const QChar& c : value)
+  {
+    if(c == '"' || c == '\\' || c.unicode() < 0x20)
+    {
+      needsEscape = true;
+      break;
+    }
+  }
+
+  if(needsEscape)
+  {
+    QString escaped;
+    escaped.reserve(value.size() + 16);
+    for(const QChar& c : value)
+    {
+      if(c == '"')
+        escaped.append("\\\"");
+      else if(c == '\\')
+        escaped.append("\\\\");
+      else if(c == '\n')
+        escaped.append("\\n");
+      else if(c == '\r')
+        escaped.append("\\r");
+      else if(c == '\t')
+        escaped.append("\\t");
+      else if(c.unicode() < 0x20)
+        escaped.append("\\u" % QString::number(c.unicode(), 16).rightJustified(4, '0'));
+      else
+        escaped.append(c);
+    }
+    buffer.append(escaped.toUtf8());
+  }
+  else
+    buffer.append(value.toUtf8());
+
+  buffer.append('"');
+}
+
+void SqlExportStream::flush(bool force)
+{
+  if(force || buffer.size() >= flushSize)
+  {
+    if(!buffer.isEmpty() && device->write(buffer) != buffer.size())
+      throw SqlException(QLatin1String(Q_FUNC_INFO) % QLatin1String(": Error writing export: ") % device->errorString());
+    buffer.clear();
+  }
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,131 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLEXPORTSTREAM_H
+#define ATOOLS_SQL_SQLEXPORTSTREAM_H
+
+#include <QByteArray>
+#include <QChar>
+#include <QString>
+
+class QIODevice;
+class QVariant;
+
+namespace atools {
+namespace sql {
+
+class SqlQuery;
+
+/*
+ * Streaming exporter writing a result set as CSV or JSON into an output device.
+ *
+ * Values are read by column index and appended as UTF-8 to a buffer which is written to the device
+ * when it exceeds the flush size. No row strings or record copies are created, so memory use stays constant
+ * for large tables like logbook or userdata.
+ *
+ * CSV follows the same rules as SqlExport (RFC 4180). JSON is written as an array of objects with column names
+ * as keys. Blobs are written as base64 strings in JSON.
+ */
+class SqlExportStream
+{
+public:
+  enum Format
+  {
+    CSV,
+    JSON
+  };
+
+  explicit SqlExportStream(QIODevice *outputDevice, Format outputFormat = CSV);
+  ~SqlExportStream();
+
+  SqlExportStream(const SqlExportStream& other) = delete;
+  SqlExportStream& operator=(const SqlExportStream& other) = delete;
+
+  /* Write all rows of an executed select query. Returns number of rows written.
+   * Throws SqlException on query errors or if the device cannot be written. */
+  int exportQuery(atools::sql::SqlQuery& query);
+
+  /* Write a CSV header containing the column names. Default is true. */
+  void setHeader(bool value)
+  {
+    header = value;
+  }
+
+  /* CSV field separator. Default is ",". */
+  void setSeparatorChar(QChar value)
+  {
+    separator = value;
+  }
+
+  /* Character used to wrap CSV string fields containing special characters. Default is '"'. */
+  void setEscapeChar(QChar value)
+  {
+    escape = value;
+  }
+
+  /* Text for null values in CSV. Empty by default. Always null in JSON. */
+  void setNullValue(const QString& value)
+  {
+    nullValue = value.toUtf8();
+  }
+
+  /* Decimals for floating point values. Default is 6. */
+  void setNumberPrecision(int value)
+  {
+    numberPrecision = value;
+  }
+
+  /* Buffer size in bytes which triggers a write to the device. Default is 64 KB. */
+  void setFlushSize(int value)
+  {
+    flushSize = value;
+  }
+
+  /* Statistics of the last export */
+  int getNumRows() const
+  {
+    return numRows;
+  }
+
+  qint64 getElapsedMs() const
+  {
+    return elapsedMs;
+  }
+
+  /* Rows per second of the last export */
+  double getRowsPerSecond() const;
+
+private:
+  void appendValue(const QVariant& value);
+  void appendCsvString(const QString& value);
+  void appendJsonString(const QString& value);
+  void flush(bool force);
+
+  QIODevice *device;
+  Format format;
+  QByteArray buffer, nullValue;
+  QChar separator = ',', escape = '"';
+  bool header = true;
+  int numberPrecision = 6, flushSize = 65536, numRows = 0;
+  qint64 elapsedMs = 0;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLEXPORTSTREAM_H
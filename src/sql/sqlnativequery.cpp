@@ -0,0 +1,513 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlnativequery.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <QSqlDriver>
+#include <QStringBuilder>
+
+#ifdef ATOOLS_SQLITE_NATIVE
+#include <sqlite3.h>
+#endif
+
+namespace atools {
+namespace sql {
+
+/* Get native handle from the Qt driver or null if not available */
+static sqlite3 *nativeHandle(const SqlDatabase *sqlDb)
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  if(sqlDb != nullptr && sqlDb->isOpen() && sqlDb->driverName() == "QSQLITE")
+  {
+    QVariant handle = sqlDb->driver()->handle();
+    if(handle.isValid() && qstrcmp(handle.typeName(), "sqlite3*") == 0)
+      return *static_cast<sqlite3 **>(handle.data());
+  }
+#else
+  Q_UNUSED(sqlDb)
+#endif
+  return nullptr;
+}
+
+SqlNativeQuery::SqlNativeQuery(const SqlDatabase *sqlDb)
+{
+  db = new SqlDatabase(*sqlDb);
+  handle = nativeHandle(db);
+
+  if(handle == nullptr)
+    query = new SqlQuery(db);
+}
+
+SqlNativeQuery::SqlNativeQuery(const QString& queryStr, const SqlDatabase *sqlDb)
+  : SqlNativeQuery(sqlDb)
+{
+  exec(queryStr);
+}
+
+SqlNativeQuery::~SqlNativeQuery()
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  for(Statement *statement : qAsConst(statementCache))
+  {
+    sqlite3_finalize(statement->stmt);
+    delete statement;
+  }
+#endif
+  delete query;
+  delete db;
+}
+
+bool SqlNativeQuery::isNativeAvailable(const SqlDatabase *sqlDb)
+{
+  return nativeHandle(sqlDb) != nullptr;
+}
+
+void SqlNativeQuery::checkPrepared(const char *funcInfo) const
+{
+  if(handle != nullptr && current == nullptr)
+    throw SqlException(QLatin1String(funcInfo) % ": Query not prepared");
+}
+
+void SqlNativeQuery::checkNative(int result, const char *funcInfo) const
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  if(result != SQLITE_OK && result != SQLITE_ROW && result != SQLITE_DONE)
+    throw SqlException(QLatin1String(funcInfo) % ": " % QString::fromUtf8(sqlite3_errmsg(handle)) %
+                       " in query \"" % queryString % "\"");
+#else
+  Q_UNUSED(result)
+  Q_UNUSED(funcInfo)
+#endif
+}
+
+void SqlNativeQuery::checkColumn(const char *funcInfo, int col) const
+{
+  if(col < 0 || col >= columnCount())
+    throw SqlException(QLatin1String(funcInfo) % ": Value index " % QString::number(col) %
+                       " does not exist in query \"" % queryString % "\"");
+
+  if(handle != nullptr && !hasRow)
+    throw SqlException(QLatin1String(funcInfo) % ": No row available in query \"" % queryString % "\"");
+}
+
+void SqlNativeQuery::prepare(const QString& queryStr)
+{
+  queryString = queryStr;
+
+  if(handle == nullptr)
+  {
+    query->prepare(queryStr);
+    return;
+  }
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  reset();
+
+  Statement *statement = statementCache.value(queryStr, nullptr);
+  if(statement == nullptr)
+  {
+    statement = new Statement;
+    QByteArray utf8 = queryStr.toUtf8();
+    int result = sqlite3_prepare_v2(handle, utf8.constData(), utf8.size(), &statement->stmt, nullptr);
+    if(result != SQLITE_OK)
+    {
+      delete statement;
+      current = nullptr;
+      checkNative(result, Q_FUNC_INFO);
+    }
+
+    // Resolve all column names once
+    for(int i = 0; i < sqlite3_column_count(statement->stmt); i++)
+      statement->columns.insert(QString::fromUtf8(sqlite3_column_name(statement->stmt, i)), i);
+
+    statementCache.insert(queryStr, statement);
+  }
+  else
+    sqlite3_clear_bindings(statement->stmt);
+
+  current = statement;
+#endif
+}
+
+void SqlNativeQuery::reset()
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  if(current != nullptr)
+    sqlite3_reset(current->stmt);
+#endif
+  hasRow = pendingStep = false;
+}
+
+void SqlNativeQuery::exec()
+{
+  if(handle == nullptr)
+  {
+    query->exec();
+    return;
+  }
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkPrepared(Q_FUNC_INFO);
+  reset();
+
+  if(sqlite3_column_count(current->stmt) > 0)
+    // Select - rows are fetched in next()
+    pendingStep = true;
+  else
+  {
+    int result = sqlite3_step(current->stmt);
+    checkNative(result, Q_FUNC_INFO);
+    sqlite3_reset(current->stmt);
+
+    if(db->isAutocommit())
+      db->commit();
+  }
+#endif
+}
+
+bool SqlNativeQuery::next()
+{
+  if(handle == nullptr)
+    return query->next();
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkPrepared(Q_FUNC_INFO);
+  if(!pendingStep)
+    return false;
+
+  int result = sqlite3_step(current->stmt);
+  checkNative(result, Q_FUNC_INFO);
+
+  hasRow = result == SQLITE_ROW;
+  if(!hasRow)
+    // Release locks when done
+    reset();
+  return hasRow;
+#else
+  return false;
+#endif
+}
+
+void SqlNativeQuery::finish()
+{
+  if(handle == nullptr)
+    query->finish();
+  else
+    reset();
+}
+
+void SqlNativeQuery::clearBoundValues()
+{
+  if(handle == nullptr)
+    query->clearBoundValues();
+#ifdef ATOOLS_SQLITE_NATIVE
+  else if(current != nullptr)
+    sqlite3_clear_bindings(current->stmt);
+#endif
+}
+
+int SqlNativeQuery::placeholderIndex(const char *funcInfo, const QString& placeholder) const
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  int index = sqlite3_bind_parameter_index(current->stmt, placeholder.toUtf8().constData());
+  if(index == 0)
+    throw SqlException(QLatin1String(funcInfo) % ": Placeholder \"" % placeholder %
+                       "\" does not exist in query \"" % queryString % "\"");
+  return index;
+#else
+  Q_UNUSED(funcInfo)
+  Q_UNUSED(placeholder)
+  return 0;
+#endif
+}
+
+/* Bind methods ============================================================ */
+void SqlNativeQuery::bindNull(const QString& placeholder)
+{
+  if(handle == nullptr)
+    query->bindValue(placeholder, QVariant());
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    bindNull(placeholderIndex(Q_FUNC_INFO, placeholder) - 1);
+  }
+}
+
+void SqlNativeQuery::bindInt64(const QString& placeholder, qint64 value)
+{
+  if(handle == nullptr)
+    query->bindValue(placeholder, value);
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    bindInt64(placeholderIndex(Q_FUNC_INFO, placeholder) - 1, value);
+  }
+}
+
+void SqlNativeQuery::bindDouble(const QString& placeholder, double value)
+{
+  if(handle == nullptr)
+    query->bindValue(placeholder, value);
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    bindDouble(placeholderIndex(Q_FUNC_INFO, placeholder) - 1, value);
+  }
+}
+
+void SqlNativeQuery::bindText(const QString& placeholder, const QString& value)
+{
+  if(handle == nullptr)
+    query->bindValue(placeholder, value);
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    bindText(placeholderIndex(Q_FUNC_INFO, placeholder) - 1, value);
+  }
+}
+
+void SqlNativeQuery::bindBlob(const QString& placeholder, const QByteArray& value)
+{
+  if(handle == nullptr)
+    query->bindValue(placeholder, value);
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    bindBlob(placeholderIndex(Q_FUNC_INFO, placeholder) - 1, value);
+  }
+}
+
+void SqlNativeQuery::bindNull(int pos)
+{
+  if(handle == nullptr)
+    query->bindValue(pos, QVariant());
+#ifdef ATOOLS_SQLITE_NATIVE
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    checkNative(sqlite3_bind_null(current->stmt, pos + 1), Q_FUNC_INFO);
+  }
+#endif
+}
+
+void SqlNativeQuery::bindInt64(int pos, qint64 value)
+{
+  if(handle == nullptr)
+    query->bindValue(pos, value);
+#ifdef ATOOLS_SQLITE_NATIVE
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    checkNative(sqlite3_bind_int64(current->stmt, pos + 1, value), Q_FUNC_INFO);
+  }
+#endif
+}
+
+void SqlNativeQuery::bindDouble(int pos, double value)
+{
+  if(handle == nullptr)
+    query->bindValue(pos, value);
+#ifdef ATOOLS_SQLITE_NATIVE
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    checkNative(sqlite3_bind_double(current->stmt, pos + 1, value), Q_FUNC_INFO);
+  }
+#endif
+}
+
+void SqlNativeQuery::bindText(int pos, const QString& value)
+{
+  if(handle == nullptr)
+    query->bindValue(pos, value);
+#ifdef ATOOLS_SQLITE_NATIVE
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    if(value.isNull())
+      checkNative(sqlite3_bind_null(current->stmt, pos + 1), Q_FUNC_INFO);
+    else
+    {
+      QByteArray utf8 = value.toUtf8();
+      checkNative(sqlite3_bind_text(current->stmt, pos + 1, utf8.constData(), utf8.size(), SQLITE_TRANSIENT),
+                  Q_FUNC_INFO);
+    }
+  }
+#endif
+}
+
+void SqlNativeQuery::bindBlob(int pos, const QByteArray& value)
+{
+  if(handle == nullptr)
+    query->bindValue(pos, value);
+#ifdef ATOOLS_SQLITE_NATIVE
+  else
+  {
+    checkPrepared(Q_FUNC_INFO);
+    if(value.isNull())
+      checkNative(sqlite3_bind_null(current->stmt, pos + 1), Q_FUNC_INFO);
+    else
+      checkNative(sqlite3_bind_blob(current->stmt, pos + 1, value.constData(), value.size(), SQLITE_TRANSIENT),
+                  Q_FUNC_INFO);
+  }
+#endif
+}
+
+/* Column methods ============================================================ */
+int SqlNativeQuery::columnCount() const
+{
+  if(handle == nullptr)
+    return query->record().count();
+#ifdef ATOOLS_SQLITE_NATIVE
+  else if(current != nullptr)
+    return sqlite3_column_count(current->stmt);
+#endif
+  return 0;
+}
+
+bool SqlNativeQuery::hasField(const QString& name) const
+{
+  if(handle == nullptr)
+    return query->hasField(name);
+  else
+    return current != nullptr && current->columns.contains(name);
+}
+
+int SqlNativeQuery::columnIndex(const QString& name) const
+{
+  int index = -1;
+  if(handle == nullptr)
+    index = query->record().indexOf(name);
+  else if(current != nullptr)
+    index = current->columns.value(name, -1);
+
+  if(index == -1)
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Value name \"" % name % "\" does not exist in query \"" %
+                       queryString % "\"");
+  return index;
+}
+
+bool SqlNativeQuery::isNull(int col) const
+{
+  if(handle == nullptr)
+    return query->isNull(col);
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkColumn(Q_FUNC_INFO, col);
+  return sqlite3_column_type(current->stmt, col) == SQLITE_NULL;
+#else
+  return true;
+#endif
+}
+
+qint64 SqlNativeQuery::valueInt64(int col) const
+{
+  if(handle == nullptr)
+    return query->value(col).toLongLong();
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkColumn(Q_FUNC_INFO, col);
+  return sqlite3_column_int64(current->stmt, col);
+#else
+  return 0;
+#endif
+}
+
+double SqlNativeQuery::valueDouble(int col) const
+{
+  if(handle == nullptr)
+    return query->value(col).toDouble();
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkColumn(Q_FUNC_INFO, col);
+  return sqlite3_column_double(current->stmt, col);
+#else
+  return 0.;
+#endif
+}
+
+const char *SqlNativeQuery::valueText(int col, int *size) const
+{
+  if(handle == nullptr)
+  {
+    // Keep converted string in buffer to return a pointer
+    textBuffer = query->value(col).toString().toUtf8();
+    if(size != nullptr)
+      *size = textBuffer.size();
+    return textBuffer.constData();
+  }
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkColumn(Q_FUNC_INFO, col);
+  const char *text = reinterpret_cast<const char *>(sqlite3_column_text(current->stmt, col));
+  if(size != nullptr)
+    *size = sqlite3_column_bytes(current->stmt, col);
+  return text == nullptr ? "" : text;
+#else
+  if(size != nullptr)
+    *size = 0;
+  return "";
+#endif
+}
+
+QString SqlNativeQuery::valueStr(int col) const
+{
+  if(handle == nullptr)
+    return query->value(col).toString();
+
+  int size;
+  const char *text = valueText(col, &size);
+  return QString::fromUtf8(text, size);
+}
+
+const char *SqlNativeQuery::valueBlob(int col, int& size) const
+{
+  if(handle == nullptr)
+  {
+    textBuffer = query->value(col).toByteArray();
+    size = textBuffer.size();
+    return textBuffer.constData();
+  }
+
+#ifdef ATOOLS_SQLITE_NATIVE
+  checkColumn(Q_FUNC_INFO, col);
+  const char *data = static_cast<const char *>(sqlite3_column_blob(current->stmt, col));
+  size = sqlite3_column_bytes(current->stmt, col);
+  return data;
+#else
+  size = 0;
+  return nullptr;
+#endif
+}
+
+QByteArray SqlNativeQuery::valueBytes(int col) const
+{
+  if(handle == nullptr)
+    return query->value(col).toByteArray();
+
+  int size;
+  const char *data = valueBlob(col, size);
+  return data == nullptr ? QByteArray() : QByteArray(data, size);
+}
+
+} // namespace sql
+} // namespace atools
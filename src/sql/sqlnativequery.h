@@ -0,0 +1,230 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLNATIVEQUERY_H
+#define ATOOLS_SQL_SQLNATIVEQUERY_H
+
+#include <QHash>
+#include <QString>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+class SqlQuery;
+
+/*
+ * Thin query class using the native SQLite API for loops reading or writing many rows.
+ * Avoids the QVariant conversion and the field name lookup which QSqlQuery does for each value.
+ *
+ * The native path is only available if the library was built with ATOOLS_SQLITE_NATIVE
+ * (see ATOOLS_SQLITE_PATH in atools.pro) and the database uses the QSQLITE driver.
+ * Qt has to use the same SQLite library, i.e. Qt has to be built with system SQLite.
+ * Otherwise all methods fall back to SqlQuery transparently and give the same results.
+ *
+ * Prepared statements are cached by query string and reused when calling prepare() again with
+ * the same query. Column names are resolved to indexes once per statement.
+ *
+ * Column indexes are zero based. Placeholders are named ":name" or positional "?" with zero based index.
+ * Throws SqlException on errors like SqlQuery.
+ */
+class SqlNativeQuery
+{
+public:
+  explicit SqlNativeQuery(const atools::sql::SqlDatabase *sqlDb);
+  explicit SqlNativeQuery(const QString& queryStr, const atools::sql::SqlDatabase *sqlDb);
+  ~SqlNativeQuery();
+
+  SqlNativeQuery(const SqlNativeQuery& other) = delete;
+  SqlNativeQuery& operator=(const SqlNativeQuery& other) = delete;
+
+  /* true if native SQLite access is available for the database */
+  static bool isNativeAvailable(const atools::sql::SqlDatabase *sqlDb);
+
+  /* true if this query uses native SQLite access */
+  bool isNative() const
+  {
+    return handle != nullptr;
+  }
+
+  /* Prepare query or reuse a cached statement for the same query string */
+  void prepare(const QString& queryStr);
+
+  /* Execute prepared query. Rows of select statements are fetched by next(). */
+  void exec();
+
+  void exec(const QString& queryStr)
+  {
+    prepare(queryStr);
+    exec();
+  }
+
+  /* Fetch next row. Returns false if no more rows are available. */
+  bool next();
+
+  /* Release locks and reset statement. Bindings are kept. */
+  void finish();
+
+  /* Set all bindings to null */
+  void clearBoundValues();
+
+  /* Bind values to named placeholders like ":id" */
+  void bindNull(const QString& placeholder);
+  void bindInt64(const QString& placeholder, qint64 value);
+  void bindDouble(const QString& placeholder, double value);
+  void bindText(const QString& placeholder, const QString& value);
+  void bindBlob(const QString& placeholder, const QByteArray& value);
+
+  /* Bind values to positional placeholders */
+  void bindNull(int pos);
+  void bindInt64(int pos, qint64 value);
+  void bindDouble(int pos, double value);
+  void bindText(int pos, const QString& value);
+  void bindBlob(int pos, const QByteArray& value);
+
+  /* Number of columns of the current statement */
+  int columnCount() const;
+
+  /* Column index for name. Cached for each statement. Throws exception if not found. */
+  int columnIndex(const QString& name) const;
+
+  /* true if column exists in the statement */
+  bool hasField(const QString& name) const;
+
+  /* Typed getters for the current row =========================================== */
+  bool isNull(int col) const;
+  qint64 valueInt64(int col) const;
+  double valueDouble(int col) const;
+
+  int valueInt(int col) const
+  {
+    return static_cast<int>(valueInt64(col));
+  }
+
+  float valueFloat(int col) const
+  {
+    return static_cast<float>(valueDouble(col));
+  }
+
+  bool valueBool(int col) const
+  {
+    return valueInt64(col) != 0;
+  }
+
+  /* UTF-8 text which is valid until the next call of next() or any other value method for the same column.
+   * size receives the number of bytes if not null. Returns an empty string for null values. */
+  const char *valueText(int col, int *size = nullptr) const;
+
+  QString valueStr(int col) const;
+
+  /* Blob data which is valid until the next call of next(). size receives the number of bytes. */
+  const char *valueBlob(int col, int& size) const;
+
+  /* Copy of the blob data */
+  QByteArray valueBytes(int col) const;
+
+  /* Same as above using column names which are resolved to indexes using a cache */
+  bool isNull(const QString& name) const
+  {
+    return isNull(columnIndex(name));
+  }
+
+  qint64 valueInt64(const QString& name) const
+  {
+    return valueInt64(columnIndex(name));
+  }
+
+  int valueInt(const QString& name) const
+  {
+    return valueInt(columnIndex(name));
+  }
+
+  double valueDouble(const QString& name) const
+  {
+    return valueDouble(columnIndex(name));
+  }
+
+  float valueFloat(const QString& name) const
+  {
+    return valueFloat(columnIndex(name));
+  }
+
+  bool valueBool(const QString& name) const
+  {
+    return valueBool(columnIndex(name));
+  }
+
+  const char *valueText(const QString& name, int *size = nullptr) const
+  {
+    return valueText(columnIndex(name), size);
+  }
+
+  QString valueStr(const QString& name) const
+  {
+    return valueStr(columnIndex(name));
+  }
+
+  const char *valueBlob(const QString& name, int& size) const
+  {
+    return valueBlob(columnIndex(name), size);
+  }
+
+  QByteArray valueBytes(const QString& name) const
+  {
+    return valueBytes(columnIndex(name));
+  }
+
+  const QString& getQueryString() const
+  {
+    return queryString;
+  }
+
+private:
+  /* Prepared native statement and resolved column names */
+  struct Statement
+  {
+    sqlite3_stmt *stmt = nullptr;
+    QHash<QString, int> columns;
+  };
+
+  void checkPrepared(const char *funcInfo) const;
+  void checkColumn(const char *funcInfo, int col) const;
+  void checkNative(int result, const char *funcInfo) const;
+  int placeholderIndex(const char *funcInfo, const QString& placeholder) const;
+  void reset();
+
+  atools::sql::SqlDatabase *db = nullptr;
+  QString queryString;
+
+  /* Native access ==================== */
+  sqlite3 *handle = nullptr;
+  Statement *current = nullptr;
+  QHash<QString, Statement *> statementCache;
+  bool hasRow = false, pendingStep = false;
+
+  /* Fallback ==================== */
+  atools::sql::SqlQuery *query = nullptr;
+  mutable QByteArray textBuffer;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLNATIVEQUERY_H
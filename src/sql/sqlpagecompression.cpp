@@ -0,0 +1,661 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlpagecompression.h"
+
+#include "exception.h"
+#include "util/memoryaccounting.h"
+
+#include <QCache>
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QSaveFile>
+#include <QUrl>
+#include <QVector>
+#include <QtEndian>
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+
+#ifdef ATOOLS_SQLITE_NATIVE
+#include <sqlite3.h>
+#endif
+
+namespace atools {
+namespace sql {
+
+const char *SqlPageCompression::VFS_NAME = "atools_zpage";
+const QString SqlPageCompression::CACHE_ACCOUNTING_NAME("SQLite compressed pages");
+
+namespace  {
+
+const char MAGIC[16] = "ATOOLS-ZPAGE-DB";
+const quint32 VERSION = 1;
+const int HEADER_SIZE = 64;
+const int INDEX_ENTRY_SIZE = 12;
+
+/* Offsets in the SQLite database header */
+const int SQLITE_PAGE_SIZE_OFFSET = 16;
+const int SQLITE_WRITE_VERSION_OFFSET = 18;
+const int SQLITE_READ_VERSION_OFFSET = 19;
+
+std::atomic<qint64> defaultCacheBytes(16 * 1024 * 1024);
+
+/* Page location in the compressed file */
+struct PageEntry
+{
+  qint64 offset;
+  quint32 size;
+};
+
+/* Reads and caches decompressed pages of a compressed database file. Thread safe. */
+class CompressedPageFile :
+  public atools::util::MemoryAccountable
+{
+public:
+  CompressedPageFile()
+  {
+  }
+
+  virtual ~CompressedPageFile() override
+  {
+    if(mapped != nullptr)
+      file.unmap(mapped);
+  }
+
+  /* Read header and index. Returns false and logs a warning on error. */
+  bool open(const QString& filename);
+
+  /* Register cache in memory accounting using the budget or default for the cache size */
+  void registerCache();
+
+  qint64 getFileSize() const
+  {
+    return fileSize;
+  }
+
+  int getPageSize() const
+  {
+    return pageSize;
+  }
+
+  /* Copy amount bytes of the original file at offset into buffer.
+   * Returns number of bytes copied which is less at the end of file or -1 on error. */
+  qint64 read(char *buffer, qint64 amount, qint64 offset);
+
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const override;
+  virtual void releaseMemory(qint64 maxBytes) override;
+
+private:
+  /* Decompressed page or null on error. Mutex has to be locked. */
+  const QByteArray *page(qint64 index);
+  bool readRaw(qint64 offset, qint64 size, QByteArray& data);
+
+  QFile file;
+  uchar *mapped = nullptr;
+  int pageSize = 0;
+  qint64 fileSize = 0;
+  QVector<PageEntry> entries;
+
+  /* Decompressed pages by page index. Cost is bytes. */
+  QCache<qint64, QByteArray> cache;
+  QByteArray uncachedPage;
+  mutable QMutex mutex;
+};
+
+bool CompressedPageFile::open(const QString& filename)
+{
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+
+  // Map whole file if possible - falls back to seek and read
+  mapped = file.map(0, file.size());
+
+  QByteArray header;
+  if(!readRaw(0, HEADER_SIZE, header) || std::memcmp(header.constData(), MAGIC, sizeof(MAGIC)) != 0)
+  {
+    qWarning() << Q_FUNC_INFO << "Not a compressed database" << filename;
+    return false;
+  }
+
+  const uchar *data = reinterpret_cast<const uchar *>(header.constData());
+  quint32 version = qFromLittleEndian<quint32>(data + 16);
+  pageSize = static_cast<int>(qFromLittleEndian<quint32>(data + 20));
+  fileSize = static_cast<qint64>(qFromLittleEndian<quint64>(data + 24));
+  qint64 indexOffset = static_cast<qint64>(qFromLittleEndian<quint64>(data + 32));
+
+  if(version != VERSION || pageSize <= 0 || fileSize < 0)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid header in" << filename << "version" << version << "page size" << pageSize;
+    return false;
+  }
+
+  qint64 numPages = (fileSize + pageSize - 1) / pageSize;
+  QByteArray index;
+  if(!readRaw(indexOffset, numPages * INDEX_ENTRY_SIZE, index))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read index of" << filename;
+    return false;
+  }
+
+  entries.resize(static_cast<int>(numPages));
+  const uchar *indexData = reinterpret_cast<const uchar *>(index.constData());
+  for(int i = 0; i < entries.size(); i++)
+  {
+    entries[i].offset = static_cast<qint64>(qFromLittleEndian<quint64>(indexData + i * INDEX_ENTRY_SIZE));
+    entries[i].size = qFromLittleEndian<quint32>(indexData + i * INDEX_ENTRY_SIZE + 8);
+  }
+  return true;
+}
+
+void CompressedPageFile::registerCache()
+{
+  atools::util::MemoryAccounting& accounting = atools::util::MemoryAccounting::instance();
+  qint64 budget = accounting.getBudget(SqlPageCompression::CACHE_ACCOUNTING_NAME);
+  qint64 bytes = budget > 0 ? budget : defaultCacheBytes.load();
+  cache.setMaxCost(static_cast<int>(std::min(bytes, static_cast<qint64>(std::numeric_limits<int>::max()))));
+  accounting.add(SqlPageCompression::CACHE_ACCOUNTING_NAME, this);
+}
+
+bool CompressedPageFile::readRaw(qint64 offset, qint64 size, QByteArray& data)
+{
+  if(offset < 0 || size < 0 || offset + size > file.size())
+    return false;
+
+  if(mapped != nullptr)
+  {
+    data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped + offset), static_cast<int>(size));
+    return true;
+  }
+  else
+  {
+    if(!file.seek(offset))
+      return false;
+    data = file.read(size);
+    return data.size() == size;
+  }
+}
+
+const QByteArray *CompressedPageFile::page(qint64 index)
+{
+  const QByteArray *data = cache.object(index);
+  if(data != nullptr)
+    return data;
+
+  if(index < 0 || index >= entries.size())
+    return nullptr;
+
+  const PageEntry& entry = entries.at(static_cast<int>(index));
+  qint64 length = std::min(static_cast<qint64>(pageSize), fileSize - index * pageSize);
+
+  QByteArray raw;
+  if(!readRaw(entry.offset, entry.size, raw))
+    return nullptr;
+
+  QByteArray decompressed;
+  if(entry.size == length)
+    // Stored uncompressed - detach from mapping
+    decompressed = QByteArray(raw.constData(), raw.size());
+  else
+  {
+    decompressed.resize(static_cast<int>(length));
+    uLongf destLen = static_cast<uLongf>(length);
+    int result = uncompress(reinterpret_cast<Bytef *>(decompressed.data()), &destLen,
+                            reinterpret_cast<const Bytef *>(raw.constData()), static_cast<uLong>(raw.size()));
+    if(result != Z_OK || destLen != static_cast<uLongf>(length))
+    {
+      qWarning() << Q_FUNC_INFO << "Error decompressing page" << index << "of" << file.fileName() << "result" << result;
+      return nullptr;
+    }
+  }
+
+  if(decompressed.size() > cache.maxCost())
+  {
+    // Cache is too small or disabled - keep only the last page
+    uncachedPage = decompressed;
+    return &uncachedPage;
+  }
+
+  // Cache takes ownership
+  cache.insert(index, new QByteArray(decompressed), decompressed.size());
+  return cache.object(index);
+}
+
+qint64 CompressedPageFile::read(char *buffer, qint64 amount, qint64 offset)
+{
+  QMutexLocker locker(&mutex);
+
+  qint64 copied = 0;
+  while(copied < amount && offset + copied < fileSize)
+  {
+    qint64 pos = offset + copied;
+    const QByteArray *data = page(pos / pageSize);
+    if(data == nullptr)
+      return -1;
+
+    qint64 pageOffset = pos % pageSize;
+    qint64 num = std::min(amount - copied, static_cast<qint64>(data->size()) - pageOffset);
+    std::memcpy(buffer + copied, data->constData() + pageOffset, static_cast<size_t>(num));
+    copied += num;
+  }
+  return copied;
+}
+
+void CompressedPageFile::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  QMutexLocker locker(&mutex);
+  bytes += cache.totalCost() + atools::util::MemoryAccounting::vectorBytes(entries);
+  elements += cache.size();
+}
+
+void CompressedPageFile::releaseMemory(qint64 maxBytes)
+{
+  QMutexLocker locker(&mutex);
+
+  // Shrink and restore size - cache trims least recently used pages
+  int maxCost = cache.maxCost();
+  cache.setMaxCost(static_cast<int>(std::max(maxBytes - atools::util::MemoryAccounting::vectorBytes(entries),
+                                             Q_INT64_C(0))));
+  cache.setMaxCost(maxCost);
+}
+
+} // namespace
+
+// ==================================================================================================
+// VFS
+#ifdef ATOOLS_SQLITE_NATIVE
+
+namespace  {
+
+/* Default VFS of the platform used for all files except main databases */
+sqlite3_vfs *rootVfs = nullptr;
+
+/* File handle for SQLite. Must start with the base struct. */
+struct VfsFile
+{
+  sqlite3_file base;
+  CompressedPageFile *pages;
+};
+
+CompressedPageFile *pagesFromFile(sqlite3_file *file)
+{
+  return reinterpret_cast<VfsFile *>(file)->pages;
+}
+
+int vfsClose(sqlite3_file *file)
+{
+  delete pagesFromFile(file);
+  return SQLITE_OK;
+}
+
+int vfsRead(sqlite3_file *file, void *buffer, int amount, sqlite3_int64 offset)
+{
+  qint64 copied = pagesFromFile(file)->read(static_cast<char *>(buffer), amount, offset);
+  if(copied < 0)
+    return SQLITE_IOERR_READ;
+  else if(copied < amount)
+  {
+    // SQLite requires the rest to be filled with zeros
+    std::memset(static_cast<char *>(buffer) + copied, 0, static_cast<size_t>(amount - copied));
+    return SQLITE_IOERR_SHORT_READ;
+  }
+  return SQLITE_OK;
+}
+
+int vfsWrite(sqlite3_file *, const void *, int, sqlite3_int64)
+{
+  return SQLITE_READONLY;
+}
+
+int vfsTruncate(sqlite3_file *, sqlite3_int64)
+{
+  return SQLITE_READONLY;
+}
+
+int vfsSync(sqlite3_file *, int)
+{
+  return SQLITE_OK;
+}
+
+int vfsFileSize(sqlite3_file *file, sqlite3_int64 *size)
+{
+  *size = pagesFromFile(file)->getFileSize();
+  return SQLITE_OK;
+}
+
+int vfsLock(sqlite3_file *, int)
+{
+  // File never changes - no locking needed
+  return SQLITE_OK;
+}
+
+int vfsCheckReservedLock(sqlite3_file *, int *result)
+{
+  *result = 0;
+  return SQLITE_OK;
+}
+
+int vfsFileControl(sqlite3_file *, int, void *)
+{
+  return SQLITE_NOTFOUND;
+}
+
+int vfsSectorSize(sqlite3_file *file)
+{
+  return pagesFromFile(file)->getPageSize();
+}
+
+int vfsDeviceCharacteristics(sqlite3_file *)
+{
+  return SQLITE_IOCAP_IMMUTABLE;
+}
+
+const sqlite3_io_methods ioMethods = {
+  1, vfsClose, vfsRead, vfsWrite, vfsTruncate, vfsSync, vfsFileSize, vfsLock, vfsLock /* unlock */,
+  vfsCheckReservedLock, vfsFileControl, vfsSectorSize, vfsDeviceCharacteristics,
+  nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+int vfsOpen(sqlite3_vfs *, const char *name, sqlite3_file *file, int flags, int *outFlags)
+{
+  // Journals and temporary files are handled by the default VFS which uses the same handle memory
+  if(!(flags & SQLITE_OPEN_MAIN_DB) || name == nullptr)
+    return rootVfs->xOpen(rootVfs, name, file, flags, outFlags);
+
+  VfsFile *vfsFile = reinterpret_cast<VfsFile *>(file);
+  vfsFile->base.pMethods = nullptr;
+
+  CompressedPageFile *pages = new CompressedPageFile;
+  if(!pages->open(QString::fromUtf8(name)))
+  {
+    delete pages;
+    return SQLITE_CANTOPEN;
+  }
+  pages->registerCache();
+
+  vfsFile->pages = pages;
+  vfsFile->base.pMethods = &ioMethods;
+
+  // Always read only
+  if(outFlags != nullptr)
+    *outFlags = (flags & ~(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)) | SQLITE_OPEN_READONLY;
+  return SQLITE_OK;
+}
+
+/* All other calls are forwarded to the default VFS */
+int vfsDelete(sqlite3_vfs *, const char *name, int syncDir)
+{
+  return rootVfs->xDelete(rootVfs, name, syncDir);
+}
+
+int vfsAccess(sqlite3_vfs *, const char *name, int flags, int *result)
+{
+  return rootVfs->xAccess(rootVfs, name, flags, result);
+}
+
+int vfsFullPathname(sqlite3_vfs *, const char *name, int size, char *out)
+{
+  return rootVfs->xFullPathname(rootVfs, name, size, out);
+}
+
+void *vfsDlOpen(sqlite3_vfs *, const char *filename)
+{
+  return rootVfs->xDlOpen(rootVfs, filename);
+}
+
+void vfsDlError(sqlite3_vfs *, int size, char *message)
+{
+  rootVfs->xDlError(rootVfs, size, message);
+}
+
+void (*vfsDlSym(sqlite3_vfs *, void *handle, const char *symbol))(void)
+{
+  return rootVfs->xDlSym(rootVfs, handle, symbol);
+}
+
+void vfsDlClose(sqlite3_vfs *, void *handle)
+{
+  rootVfs->xDlClose(rootVfs, handle);
+}
+
+int vfsRandomness(sqlite3_vfs *, int size, char *out)
+{
+  return rootVfs->xRandomness(rootVfs, size, out);
+}
+
+int vfsSleep(sqlite3_vfs *, int microseconds)
+{
+  return rootVfs->xSleep(rootVfs, microseconds);
+}
+
+int vfsCurrentTime(sqlite3_vfs *, double *time)
+{
+  return rootVfs->xCurrentTime(rootVfs, time);
+}
+
+int vfsGetLastError(sqlite3_vfs *, int size, char *message)
+{
+  return rootVfs->xGetLastError(rootVfs, size, message);
+}
+
+int vfsCurrentTimeInt64(sqlite3_vfs *, sqlite3_int64 *time)
+{
+  return rootVfs->xCurrentTimeInt64(rootVfs, time);
+}
+
+sqlite3_vfs compressedVfs;
+QMutex vfsMutex;
+
+} // namespace
+
+#endif
+
+// ==================================================================================================
+bool SqlPageCompression::isVfsAvailable()
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SqlPageCompression::registerVfs()
+{
+#ifdef ATOOLS_SQLITE_NATIVE
+  QMutexLocker locker(&vfsMutex);
+  if(rootVfs != nullptr)
+    return;
+
+  sqlite3_vfs *defaultVfs = sqlite3_vfs_find(nullptr);
+  if(defaultVfs == nullptr)
+    throw atools::Exception(tr("No default SQLite VFS found"));
+
+  std::memset(&compressedVfs, 0, sizeof(compressedVfs));
+  compressedVfs.iVersion = 2;
+  compressedVfs.szOsFile = std::max(static_cast<int>(sizeof(VfsFile)), defaultVfs->szOsFile);
+  compressedVfs.mxPathname = defaultVfs->mxPathname;
+  compressedVfs.zName = VFS_NAME;
+  compressedVfs.xOpen = vfsOpen;
+  compressedVfs.xDelete = vfsDelete;
+  compressedVfs.xAccess = vfsAccess;
+  compressedVfs.xFullPathname = vfsFullPathname;
+  compressedVfs.xDlOpen = vfsDlOpen;
+  compressedVfs.xDlError = vfsDlError;
+  compressedVfs.xDlSym = vfsDlSym;
+  compressedVfs.xDlClose = vfsDlClose;
+  compressedVfs.xRandomness = vfsRandomness;
+  compressedVfs.xSleep = vfsSleep;
+  compressedVfs.xCurrentTime = vfsCurrentTime;
+  compressedVfs.xGetLastError = vfsGetLastError;
+  compressedVfs.xCurrentTimeInt64 = defaultVfs->iVersion >= 2 ? vfsCurrentTimeInt64 : nullptr;
+  if(compressedVfs.xCurrentTimeInt64 == nullptr)
+    compressedVfs.iVersion = 1;
+
+  rootVfs = defaultVfs;
+  int result = sqlite3_vfs_register(&compressedVfs, 0 /* makeDflt */);
+  if(result != SQLITE_OK)
+  {
+    rootVfs = nullptr;
+    throw atools::Exception(tr("Cannot register SQLite VFS \"%1\". Error %2").arg(VFS_NAME).arg(result));
+  }
+  qInfo() << Q_FUNC_INFO << "Registered VFS" << VFS_NAME << "based on" << defaultVfs->zName;
+#else
+  throw atools::Exception(tr("Compressed databases need native SQLite access"));
+#endif
+}
+
+QString SqlPageCompression::uriFilename(const QString& filename)
+{
+  // Immutable avoids locking and journal lookups
+  return QUrl::fromLocalFile(filename).toString(QUrl::FullyEncoded) + "?vfs=" + VFS_NAME + "&immutable=1";
+}
+
+void SqlPageCompression::setDefaultCacheBytes(qint64 bytes)
+{
+  defaultCacheBytes.store(bytes);
+}
+
+qint64 SqlPageCompression::getDefaultCacheBytes()
+{
+  return defaultCacheBytes.load();
+}
+
+bool SqlPageCompression::isCompressed(const QString& filename)
+{
+  QFile file(filename);
+  if(file.open(QIODevice::ReadOnly))
+    return file.read(sizeof(MAGIC)) == QByteArray(MAGIC, sizeof(MAGIC));
+  return false;
+}
+
+void SqlPageCompression::compress(const QString& sourceFilename, const QString& targetFilename, int level)
+{
+  qDebug() << Q_FUNC_INFO << sourceFilename << "to" << targetFilename;
+
+  QFile source(sourceFilename);
+  if(!source.open(QIODevice::ReadOnly))
+    throw atools::Exception(tr("Cannot open \"%1\": %2").arg(sourceFilename).arg(source.errorString()));
+
+  // Page size is big endian in the SQLite header. Value 1 means 65536.
+  QByteArray sqliteHeader = source.read(100);
+  if(sqliteHeader.size() < 100 || !sqliteHeader.startsWith("SQLite format 3"))
+    throw atools::Exception(tr("\"%1\" is not a SQLite database").arg(sourceFilename));
+
+  quint32 pageSize = qFromBigEndian<quint16>(reinterpret_cast<const uchar *>(sqliteHeader.constData()) +
+                                             SQLITE_PAGE_SIZE_OFFSET);
+  if(pageSize == 1)
+    pageSize = 65536;
+
+  qint64 fileSize = source.size();
+  qint64 numPages = (fileSize + pageSize - 1) / pageSize;
+
+  QSaveFile target(targetFilename);
+  if(!target.open(QIODevice::WriteOnly))
+    throw atools::Exception(tr("Cannot open \"%1\": %2").arg(targetFilename).arg(target.errorString()));
+
+  // Header is written at the end when the index offset is known
+  target.write(QByteArray(HEADER_SIZE, '\0'));
+
+  QByteArray index(static_cast<int>(numPages * INDEX_ENTRY_SIZE), '\0');
+  QByteArray compressed(static_cast<int>(compressBound(pageSize)), '\0');
+  qint64 offset = HEADER_SIZE, compressedTotal = 0;
+  if(!source.seek(0))
+    throw atools::Exception(tr("Cannot read \"%1\": %2").arg(sourceFilename).arg(source.errorString()));
+
+  for(qint64 i = 0; i < numPages; i++)
+  {
+    QByteArray page = source.read(pageSize);
+    if(page.isEmpty())
+      throw atools::Exception(tr("Cannot read \"%1\": %2").arg(sourceFilename).arg(source.errorString()));
+
+    if(i == 0)
+    {
+      // Change WAL to rollback journal mode since the VFS cannot provide shared memory
+      page[SQLITE_WRITE_VERSION_OFFSET] = 1;
+      page[SQLITE_READ_VERSION_OFFSET] = 1;
+    }
+
+    uLongf destLen = static_cast<uLongf>(compressed.size());
+    int result = compress2(reinterpret_cast<Bytef *>(compressed.data()), &destLen,
+                           reinterpret_cast<const Bytef *>(page.constData()), static_cast<uLong>(page.size()), level);
+
+    // Store uncompressed if not smaller
+    QByteArray out = result == Z_OK && destLen < static_cast<uLongf>(page.size()) ?
+                     QByteArray::fromRawData(compressed.constData(), static_cast<int>(destLen)) : page;
+
+    uchar *entry = reinterpret_cast<uchar *>(index.data()) + i * INDEX_ENTRY_SIZE;
+    qToLittleEndian<quint64>(static_cast<quint64>(offset), entry);
+    qToLittleEndian<quint32>(static_cast<quint32>(out.size()), entry + 8);
+
+    if(target.write(out) != out.size())
+      throw atools::Exception(tr("Cannot write \"%1\": %2").arg(targetFilename).arg(target.errorString()));
+    offset += out.size();
+    compressedTotal += out.size();
+  }
+
+  target.write(index);
+
+  QByteArray header(HEADER_SIZE, '\0');
+  uchar *headerData = reinterpret_cast<uchar *>(header.data());
+  std::memcpy(headerData, MAGIC, sizeof(MAGIC));
+  qToLittleEndian<quint32>(VERSION, headerData + 16);
+  qToLittleEndian<quint32>(pageSize, headerData + 20);
+  qToLittleEndian<quint64>(static_cast<quint64>(fileSize), headerData + 24);
+  qToLittleEndian<quint64>(static_cast<quint64>(offset), headerData + 32);
+
+  if(!target.seek(0) || target.write(header) != HEADER_SIZE || !target.commit())
+    throw atools::Exception(tr("Cannot write \"%1\": %2").arg(targetFilename).arg(target.errorString()));
+
+  qInfo() << Q_FUNC_INFO << "Compressed" << numPages << "pages of" << pageSize << "bytes from" << fileSize
+          << "to" << compressedTotal << "bytes";
+}
+
+void SqlPageCompression::decompress(const QString& sourceFilename, const QString& targetFilename)
+{
+  CompressedPageFile pages;
+  if(!pages.open(sourceFilename))
+    throw atools::Exception(tr("Cannot open compressed database \"%1\"").arg(sourceFilename));
+
+  QSaveFile target(targetFilename);
+  if(!target.open(QIODevice::WriteOnly))
+    throw atools::Exception(tr("Cannot open \"%1\": %2").arg(targetFilename).arg(target.errorString()));
+
+  QByteArray buffer(pages.getPageSize(), '\0');
+  for(qint64 offset = 0; offset < pages.getFileSize(); offset += pages.getPageSize())
+  {
+    qint64 copied = pages.read(buffer.data(), buffer.size(), offset);
+    if(copied <= 0)
+      throw atools::Exception(tr("Cannot read page at offset %1 in \"%2\"").arg(offset).arg(sourceFilename));
+
+    if(target.write(buffer.constData(), copied) != copied)
+      throw atools::Exception(tr("Cannot write \"%1\": %2").arg(targetFilename).arg(target.errorString()));
+  }
+
+  if(!target.commit())
+    throw atools::Exception(tr("Cannot write \"%1\": %2").arg(targetFilename).arg(target.errorString()));
+}
+
+} // namespace sql
+} // namespace atools
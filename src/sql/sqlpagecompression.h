@@ -0,0 +1,87 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLPAGECOMPRESSION_H
+#define ATOOLS_SQL_SQLPAGECOMPRESSION_H
+
+#include <QCoreApplication>
+#include <QString>
+
+namespace atools {
+namespace sql {
+
+/*
+ * Read only access to SQLite databases which are compressed page by page for distribution.
+ *
+ * compress() converts a database file into a file where each database page is deflate compressed on its own and
+ * located by an index at the end of the file. A SQLite VFS named by VFS_NAME decompresses pages on demand when
+ * SQLite reads them and keeps decompressed pages in a cache. Use SqlDatabase::setCompressedDatabaseName() to
+ * open such a file.
+ *
+ * The cache size is taken from the budget in MemoryAccounting for CACHE_ACCOUNTING_NAME if set or from
+ * setDefaultCacheBytes() otherwise. Each open connection has its own cache and is registered in
+ * MemoryAccounting.
+ *
+ * The VFS needs native SQLite access. See ATOOLS_SQLITE_PATH in atools.pro. compress() and decompress() are
+ * always available.
+ *
+ * File layout, all numbers little endian:
+ * Header of 64 bytes with magic "ATOOLS-ZPAGE-DB\0", quint32 version, quint32 page size, quint64 size of the
+ * original database and quint64 offset of the index. Then compressed pages followed by the index which contains
+ * quint64 offset and quint32 size for each page. Pages which do not get smaller are stored uncompressed.
+ */
+class SqlPageCompression
+{
+  Q_DECLARE_TR_FUNCTIONS(SqlPageCompression)
+
+public:
+  /* Name of the VFS as used in the URI parameter "vfs" */
+  static const char *VFS_NAME;
+
+  /* Name used to register caches in MemoryAccounting and to look up the budget */
+  static const QString CACHE_ACCOUNTING_NAME;
+
+  /* Compress database file. Source must not be opened for writing. WAL mode is changed to rollback journal in
+   * the result since the VFS is read only. Throws atools::Exception on error.
+   * level: zlib compression level 0-9. -1 for default. */
+  static void compress(const QString& sourceFilename, const QString& targetFilename, int level = 9);
+
+  /* Restore the original database file. Throws atools::Exception on error. */
+  static void decompress(const QString& sourceFilename, const QString& targetFilename);
+
+  /* true if the file starts with the magic of a compressed database */
+  static bool isCompressed(const QString& filename);
+
+  /* true if compiled with native SQLite access which is needed for the VFS */
+  static bool isVfsAvailable();
+
+  /* Register the VFS with SQLite if not already done. Not set as default VFS.
+   * Throws atools::Exception if native SQLite access is not available. Thread safe. */
+  static void registerVfs();
+
+  /* URI filename for the Qt driver which selects the VFS. Needs the connect option QSQLITE_OPEN_URI. */
+  static QString uriFilename(const QString& filename);
+
+  /* Cache size per connection if no budget is set in MemoryAccounting. Default is 16 MB. */
+  static void setDefaultCacheBytes(qint64 bytes);
+  static qint64 getDefaultCacheBytes();
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLPAGECOMPRESSION_H
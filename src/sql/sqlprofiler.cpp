@@ -0,0 +1,135 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlprofiler.h"
+#include "util/metrics.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+
+#include <algorithm>
+
+namespace atools {
+namespace sql {
+
+std::atomic<bool> SqlProfiler::enabled(false);
+
+/* Shared state protected by mutex */
+static QMutex profilerMutex;
+static QHash<QString, SqlProfiler::Statistics> profilerStatistics;
+static qint64 slowQueryThresholdNs = 0;
+static bool explainSlowQueries = false;
+
+void SqlProfiler::setSlowQueryThresholdMs(int value)
+{
+  QMutexLocker locker(&profilerMutex);
+  slowQueryThresholdNs = static_cast<qint64>(value) * 1000000LL;
+}
+
+void SqlProfiler::setExplainSlowQueries(bool value)
+{
+  QMutexLocker locker(&profilerMutex);
+  explainSlowQueries = value;
+}
+
+bool SqlProfiler::isExplainSlowQueries()
+{
+  QMutexLocker locker(&profilerMutex);
+  return explainSlowQueries;
+}
+
+bool SqlProfiler::recordExec(const QString& sql, qint64 nanoseconds)
+{
+  static atools::util::MetricCounter& execCounter =
+    atools::util::Metrics::instance().counter("atools_sql_exec_total", "Executed SQL statements");
+  static atools::util::MetricHistogram& execHistogram =
+    atools::util::Metrics::instance().histogram("atools_sql_exec_duration_seconds", "Time for SQL statement execution");
+  execCounter.increment();
+  execHistogram.observe(nanoseconds / 1.e9);
+
+  QMutexLocker locker(&profilerMutex);
+  Statistics& stats = profilerStatistics[sql];
+  if(stats.sql.isEmpty())
+    stats.sql = sql;
+  stats.numExec++;
+  stats.execNs += nanoseconds;
+  stats.maxExecNs = std::max(stats.maxExecNs, nanoseconds);
+
+  return slowQueryThresholdNs > 0 && nanoseconds > slowQueryThresholdNs;
+}
+
+void SqlProfiler::recordFetch(const QString& sql, qint64 nanoseconds, bool row)
+{
+  static atools::util::MetricCounter& rowCounter =
+    atools::util::Metrics::instance().counter("atools_sql_fetched_rows_total", "Rows fetched from SQL queries");
+  if(row)
+    rowCounter.increment();
+
+  QMutexLocker locker(&profilerMutex);
+  Statistics& stats = profilerStatistics[sql];
+  if(stats.sql.isEmpty())
+    stats.sql = sql;
+  stats.fetchNs += nanoseconds;
+  if(row)
+    stats.numRows++;
+}
+
+QList<SqlProfiler::Statistics> SqlProfiler::getStatistics()
+{
+  QList<Statistics> statistics;
+  {
+    QMutexLocker locker(&profilerMutex);
+    statistics = profilerStatistics.values();
+  }
+
+  std::sort(statistics.begin(), statistics.end(), [](const Statistics& s1, const Statistics& s2) {
+          return s1.execNs + s1.fetchNs > s2.execNs + s2.fetchNs;
+        });
+  return statistics;
+}
+
+void SqlProfiler::dump(int maxStatements)
+{
+  QList<Statistics> statistics = getStatistics();
+
+  qInfo() << Q_FUNC_INFO << "Statements" << statistics.size();
+  for(int i = 0; i < std::min(maxStatements, statistics.size()); i++)
+    qInfo() << statistics.at(i);
+}
+
+void SqlProfiler::reset()
+{
+  QMutexLocker locker(&profilerMutex);
+  profilerStatistics.clear();
+}
+
+QDebug operator<<(QDebug out, const SqlProfiler::Statistics& stats)
+{
+  QDebugStateSaver saver(out);
+  out.nospace().noquote() << "Statistics[total " << (stats.execNs + stats.fetchNs) / 1000000. << " ms"
+                          << ", exec " << stats.execNs / 1000000. << " ms"
+                          << ", max exec " << stats.maxExecNs / 1000000. << " ms"
+                          << ", fetch " << stats.fetchNs / 1000000. << " ms"
+                          << ", calls " << stats.numExec << ", rows " << stats.numRows
+                          << ", sql \"" << stats.sql.simplified() << "\"]";
+  return out;
+}
+
+} // namespace sql
+} // namespace atools
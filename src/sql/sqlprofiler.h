@@ -0,0 +1,91 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLPROFILER_H
+#define ATOOLS_SQL_SQLPROFILER_H
+
+#include <QList>
+#include <QString>
+
+#include <atomic>
+
+class QDebug;
+
+namespace atools {
+namespace sql {
+
+/*
+ * Global statistics for SqlQuery::exec(), execBatch() and next() aggregated by SQL text.
+ * Disabled by default. The cost is a single atomic check per call when disabled.
+ *
+ * Statements slower than the threshold are logged with their bound values and optionally their
+ * query plan to find missing indexes. All methods are thread safe.
+ */
+class SqlProfiler
+{
+public:
+  /* Aggregated statistics for one SQL statement */
+  struct Statistics
+  {
+    QString sql;
+    quint64 numExec = 0, numRows = 0;
+    qint64 execNs = 0, maxExecNs = 0, fetchNs = 0;
+  };
+
+  static void setEnabled(bool value)
+  {
+    enabled.store(value, std::memory_order_relaxed);
+  }
+
+  static bool isEnabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /* Log statements taking longer than this for exec(). 0 disables logging. Default is 0. */
+  static void setSlowQueryThresholdMs(int value);
+
+  /* Log "explain query plan" for slow statements. Default is false. */
+  static void setExplainSlowQueries(bool value);
+  static bool isExplainSlowQueries();
+
+  /* Record one execution. Returns true if the statement exceeded the slow query threshold. */
+  static bool recordExec(const QString& sql, qint64 nanoseconds);
+
+  /* Record fetching one row with next() */
+  static void recordFetch(const QString& sql, qint64 nanoseconds, bool row);
+
+  /* Copy of all statistics ordered by total time descending */
+  static QList<Statistics> getStatistics();
+
+  /* Print the statistics of the slowest statements to the log */
+  static void dump(int maxStatements = 50);
+
+  /* Remove all statistics */
+  static void reset();
+
+private:
+  static std::atomic<bool> enabled;
+};
+
+QDebug operator<<(QDebug out, const atools::sql::SqlProfiler::Statistics& stats);
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLPROFILER_H
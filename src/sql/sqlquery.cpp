@@ -19,11 +19,14 @@
 #include "atools.h"
 #include "sql/sqlexception.h"
 #include "sql/sqldatabase.h"
+#include "sql/sqlprofiler.h"
 
 #include "sql/sqlrecord.h"
 
 #include <QSqlError>
+#include <QSqlRecord>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QStringBuilder>
 
 namespace atools {
@@ -72,6 +75,7 @@ SqlQuery::SqlQuery(const SqlQuery& other)
   placeholderList = other.placeholderList;
   placeholderSet = other.placeholderSet;
   positionalPlaceholders = other.positionalPlaceholders;
+  columnIndexCache = other.columnIndexCache;
   db = new SqlDatabase(*other.db);
 }
 
@@ -89,6 +93,7 @@ SqlQuery& SqlQuery::operator=(const SqlQuery& other)
   placeholderList = other.placeholderList;
   placeholderSet = other.placeholderSet;
   positionalPlaceholders = other.positionalPlaceholders;
+  columnIndexCache = other.columnIndexCache;
 
   delete db;
   db = new SqlDatabase(*other.db);
@@ -129,10 +134,11 @@ bool SqlQuery::isNull(const QString& name) const
   checkError(isValid(), QLatin1String(Q_FUNC_INFO) % " on invalid query");
   checkError(isActive(), QLatin1String(Q_FUNC_INFO) % " on inactive query");
 
-  if(!query.record().contains(name))
+  int index = columnIndex(name);
+  if(index == -1)
     throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Value name \"" % name % "\" does not exist in query \"" % queryString % "\"");
 
-  return query.isNull(name);
+  return query.isNull(index);
 }
 
 int SqlQuery::at() const
@@ -188,8 +194,18 @@ void SqlQuery::setForwardOnly(bool forward)
 void SqlQuery::exec(const QString& queryStr)
 {
   queryString = queryStr;
+  columnIndexCache.clear();
+
+  QElapsedTimer timer;
+  bool profile = SqlProfiler::isEnabled();
+  if(profile)
+    timer.start();
+
   checkError(query.exec(queryStr), QLatin1String(Q_FUNC_INFO) % ": Error executing query");
 
+  if(profile)
+    profileExec(timer.nsecsElapsed());
+
   if(db->isAutocommit())
     db->commit();
 }
@@ -209,7 +225,8 @@ QVariant SqlQuery::value(const QString& name) const
 {
   checkError(isValid(), QLatin1String(Q_FUNC_INFO) % " on invalid query");
   checkError(isActive(), QLatin1String(Q_FUNC_INFO) % " on inactive query");
-  QVariant retval = query.value(name);
+  int index = columnIndex(name);
+  QVariant retval = index != -1 ? query.value(index) : QVariant();
   if(!retval.isValid())
     throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Value name \"" % name % "\" does not exist in query \"" % queryString % "\"");
   return retval;
@@ -219,7 +236,19 @@ bool SqlQuery::hasField(const QString& name) const
 {
   checkError(isValid(), QLatin1String(Q_FUNC_INFO) % " on invalid query");
   checkError(isActive(), QLatin1String(Q_FUNC_INFO) % " on inactive query");
-  return query.record().contains(name);
+  return columnIndex(name) != -1;
+}
+
+int SqlQuery::columnIndex(const QString& name) const
+{
+  auto it = columnIndexCache.constFind(name);
+  if(it != columnIndexCache.constEnd())
+    return it.value();
+
+  // Building the record is expensive - do it only once per column name and statement
+  int index = query.record().indexOf(name);
+  columnIndexCache.insert(name, index);
+  return index;
 }
 
 void SqlQuery::setNumericalPrecisionPolicy(QSql::NumericalPrecisionPolicy precisionPolicy)
@@ -243,7 +272,64 @@ bool SqlQuery::next()
 {
   checkError(isSelect(), QLatin1String(Q_FUNC_INFO) % " on query which is not a select");
   checkError(isActive(), QLatin1String(Q_FUNC_INFO) % " on inactive query");
-  return query.next();
+
+  if(SqlProfiler::isEnabled())
+  {
+    QElapsedTimer timer;
+    timer.start();
+    bool retval = query.next();
+    SqlProfiler::recordFetch(queryString, timer.nsecsElapsed(), retval);
+    return retval;
+  }
+  else
+    return query.next();
+}
+
+void SqlQuery::profileExec(qint64 nanoseconds)
+{
+  if(SqlProfiler::recordExec(queryString, nanoseconds))
+  {
+    qWarning().noquote() << Q_FUNC_INFO << "Slow query" << nanoseconds / 1000000. << "ms" << queryString.simplified()
+                         << boundValuesAsString();
+
+    if(SqlProfiler::isExplainSlowQueries())
+    {
+      for(const QString& line : explainQueryPlan())
+        qWarning().noquote() << Q_FUNC_INFO << "Plan" << line;
+    }
+  }
+}
+
+QStringList SqlQuery::explainQueryPlan() const
+{
+  QStringList plan;
+
+  // Use a separate plain query to avoid recursion into profiling and exceptions
+  QSqlQuery explain(db->getQSqlDatabase());
+  if(explain.prepare("explain query plan " % queryString))
+  {
+    if(positionalPlaceholders)
+    {
+      for(int i = 0; i < placeholderList.size(); i++)
+        explain.bindValue(i, query.boundValue(i));
+    }
+    else
+    {
+      for(const QString& placeholder : placeholderSet)
+        explain.bindValue(placeholder, query.boundValue(placeholder));
+    }
+
+    if(explain.exec())
+    {
+      // Columns are id, parent, notused and detail
+      while(explain.next())
+        plan.append(explain.value(explain.record().count() - 1).toString());
+    }
+  }
+
+  if(plan.isEmpty())
+    plan.append("No plan: " % explain.lastError().text());
+  return plan;
 }
 
 bool SqlQuery::previous()
@@ -270,6 +356,7 @@ bool SqlQuery::last()
 void SqlQuery::clear()
 {
   query.clear();
+  columnIndexCache.clear();
 }
 
 void SqlQuery::clearBoundValues()
@@ -309,15 +396,33 @@ void SqlQuery::exec()
   qDebug() << Q_FUNC_INFO << boundValuesAsString();
 #endif
 
+  columnIndexCache.clear();
+
+  QElapsedTimer timer;
+  bool profile = SqlProfiler::isEnabled();
+  if(profile)
+    timer.start();
+
   checkError(query.exec(), QLatin1String(Q_FUNC_INFO) % ": Error executing query");
+
+  if(profile)
+    profileExec(timer.nsecsElapsed());
   if(db->isAutocommit())
     db->commit();
 }
 
 void SqlQuery::execBatch(QSqlQuery::BatchExecutionMode mode)
 {
+  QElapsedTimer timer;
+  bool profile = SqlProfiler::isEnabled();
+  if(profile)
+    timer.start();
+
   checkError(query.execBatch(mode), QLatin1String(Q_FUNC_INFO) % ": Error executing query batch");
 
+  if(profile)
+    profileExec(timer.nsecsElapsed());
+
   if(db->isAutocommit())
     db->commit();
 }
@@ -325,6 +430,7 @@ void SqlQuery::execBatch(QSqlQuery::BatchExecutionMode mode)
 void SqlQuery::prepare(const QString& queryStr)
 {
   queryString = queryStr;
+  columnIndexCache.clear();
   checkError(query.prepare(queryStr), QLatin1String(Q_FUNC_INFO) % ": Error executing prepare");
 
   // Extract named or positional bindings
@@ -21,6 +21,7 @@
 #include "sql/sqltypes.h"
 
 #include <QDateTime>
+#include <QHash>
 #include <QSet>
 #include <QSqlQuery>
 #include <QVariant>
@@ -73,6 +74,10 @@ public:
   QVariant value(const QString& name) const;
   bool hasField(const QString& name) const;
 
+  /* Get column index for name or -1 if not found in the result record. Names are resolved once and cached
+   * until the next exec(), prepare() or clear() which makes name based access as cheap as positional access. */
+  int columnIndex(const QString& name) const;
+
   /* Typed getters. Throw exception if value does not exist as field. */
   QString valueStr(int i) const
   {
@@ -268,12 +273,21 @@ private:
   void checkValues(const QString& funcInfo, const QVariantList& values) const;
   QString boundValuesAsString() const;
 
+  /* Add statistics to SqlProfiler and log slow queries */
+  void profileExec(qint64 nanoseconds);
+
+  /* Get "explain query plan" details for the current query string with bound values */
+  QStringList explainQueryPlan() const;
+
   QSqlQuery query;
   QString queryString;
   QStringList placeholderList;
   QSet<QString> placeholderSet;
   bool positionalPlaceholders = false;
 
+  /* Caches column name to index. Index is -1 for names not found in the record. */
+  mutable QHash<QString, int> columnIndexCache;
+
   SqlDatabase *db = nullptr;
 
 };
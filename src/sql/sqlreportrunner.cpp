@@ -0,0 +1,135 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlreportrunner.h"
+
+#include "exception.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqldatabasepool.h"
+#include "sql/sqlutil.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QThread>
+
+#include <atomic>
+
+namespace atools {
+namespace sql {
+
+SqlReportRunner::SqlReportRunner(SqlDatabase *sqlDb, int numThreadsParam)
+  : db(sqlDb), numThreads(numThreadsParam)
+{
+  if(numThreads <= 0)
+    numThreads = QThread::idealThreadCount();
+}
+
+void SqlReportRunner::addJob(const JobType& job)
+{
+  jobs.append(job);
+}
+
+bool SqlReportRunner::isParallel() const
+{
+  if(numThreads < 2 || db->driverName() != "QSQLITE")
+    return false;
+
+  // Other connections cannot share an in-memory or temporary database
+  QString name = db->databaseName();
+  if(name.isEmpty() || name == ":memory:" || name.contains("mode=memory"))
+    return false;
+
+  return QFileInfo::exists(name);
+}
+
+void SqlReportRunner::run(QDebug& out)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  int numJobs = jobs.size();
+  QVector<QString> outputs(numJobs);
+  QString *outputData = outputs.data();
+  QString error;
+
+  if(numJobs > 1 && isParallel())
+  {
+    SqlDatabasePool pool(db);
+    std::atomic_int nextJob(0);
+    QMutex errorMutex;
+
+    // One chunk per thread - each takes jobs from the queue until all are done
+    int threads = std::min(numThreads, numJobs);
+    atools::util::parallelFor(threads, threads, [&](int, int, int) -> void {
+      int index;
+      while((index = nextJob++) < numJobs)
+      {
+        try
+        {
+          SqlDatabasePool::Checkout checkout = pool.checkout();
+          SqlUtil util(checkout.db());
+          QDebug debug(&outputData[index]);
+          jobs.at(index)(debug, util);
+        }
+        catch(std::exception& e)
+        {
+          QMutexLocker locker(&errorMutex);
+          if(error.isEmpty())
+            error = e.what();
+        }
+        catch(...)
+        {
+          QMutexLocker locker(&errorMutex);
+          if(error.isEmpty())
+            error = "Unknown exception in report job";
+        }
+      }
+
+      // Close connection in this thread before the pool is deleted
+      pool.releaseThread();
+    }, 1 /* minChunkSize */);
+  }
+  else
+  {
+    SqlUtil util(db);
+    for(int index = 0; index < numJobs; index++)
+    {
+      QDebug debug(&outputData[index]);
+      jobs.at(index)(debug, util);
+    }
+  }
+
+  jobs.clear();
+
+  {
+    QDebugStateSaver saver(out);
+    out.noquote().nospace();
+    for(const QString& output : qAsConst(outputs))
+      out << output;
+  }
+
+  qDebug() << Q_FUNC_INFO << numJobs << "jobs in" << timer.elapsed() << "ms";
+
+  if(!error.isEmpty())
+    throw atools::Exception(error);
+}
+
+} // namespace sql
+} // namespace atools
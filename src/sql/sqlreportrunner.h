@@ -0,0 +1,87 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLREPORTRUNNER_H
+#define ATOOLS_SQL_SQLREPORTRUNNER_H
+
+#include <QVector>
+
+#include <functional>
+
+class QDebug;
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+class SqlUtil;
+
+/*
+ * Runs independent read-only checks and reports like row counts, duplicate or range checks concurrently.
+ *
+ * Each job gets its own QDebug output buffer and an SqlUtil for a read-only connection from an SqlDatabasePool.
+ * Outputs are printed in the order the jobs were added once all are done. Jobs are taken from a shared queue so
+ * that long running jobs do not hold back others.
+ *
+ * Jobs run sequentially on the given connection if the database is not an SQLite file, e.g. in memory, or if only
+ * one thread is available. Changes of the given connection have to be committed before calling run() since
+ * other connections cannot see them otherwise.
+ *
+ * Exceptions thrown by jobs are caught and the first one is thrown again as atools::Exception after all jobs
+ * are finished.
+ *
+ * Example:
+ * SqlReportRunner runner(db);
+ * runner.addJob([](QDebug& out, const SqlUtil& util) {
+ *   util.reportDuplicates(out, "airport", "airport_id", {"ident"});
+ * });
+ * runner.run(info);
+ */
+class SqlReportRunner
+{
+public:
+  /* Gets output stream and utility for the connection of the current thread */
+  typedef std::function<void(QDebug& out, const atools::sql::SqlUtil& util)> JobType;
+
+  /*
+   * @param sqlDb open database. Used as template for the read-only connections.
+   * @param numThreadsParam 0 uses the number of cores.
+   */
+  explicit SqlReportRunner(atools::sql::SqlDatabase *sqlDb, int numThreadsParam = 0);
+
+  SqlReportRunner(const SqlReportRunner& other) = delete;
+  SqlReportRunner& operator=(const SqlReportRunner& other) = delete;
+
+  /* Add a job to be executed by run(). Has to be thread safe if run in parallel. */
+  void addJob(const JobType& job);
+
+  /* Run all jobs, print their output in order to out and remove them. Blocks until all are done. */
+  void run(QDebug& out);
+
+  /* true if jobs will be run concurrently on read-only connections */
+  bool isParallel() const;
+
+private:
+  atools::sql::SqlDatabase *db;
+  int numThreads;
+  QVector<JobType> jobs;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLREPORTRUNNER_H
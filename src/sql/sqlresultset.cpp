@@ -0,0 +1,376 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlresultset.h"
+
+#include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <QStringBuilder>
+
+namespace atools {
+namespace sql {
+
+// ============================================================================================
+QVariant SqlResultRow::value(int column) const
+{
+  return set->columnValue(set->checkedColumn(column, row), row);
+}
+
+QVariant SqlResultRow::value(const QString& name) const
+{
+  return value(checkedColumn(name));
+}
+
+bool SqlResultRow::isNull(int column) const
+{
+  return set->checkedColumn(column, row).nulls.at(row);
+}
+
+bool SqlResultRow::isNull(const QString& name) const
+{
+  return isNull(checkedColumn(name));
+}
+
+qint64 SqlResultRow::valueLongLong(int column) const
+{
+  const SqlResultSet::Column& col = set->checkedColumn(column, row);
+  switch(col.storage)
+  {
+    case SqlResultSet::STORAGE_INT:
+      return col.ints.at(row);
+
+    case SqlResultSet::STORAGE_DOUBLE:
+      return static_cast<qint64>(col.doubles.at(row));
+
+    case SqlResultSet::STORAGE_STRING:
+      return col.strings.at(row).toLongLong();
+
+    case SqlResultSet::STORAGE_VARIANT:
+      break;
+  }
+  return col.variants.at(row).toLongLong();
+}
+
+double SqlResultRow::valueDouble(int column) const
+{
+  const SqlResultSet::Column& col = set->checkedColumn(column, row);
+  switch(col.storage)
+  {
+    case SqlResultSet::STORAGE_INT:
+      return static_cast<double>(col.ints.at(row));
+
+    case SqlResultSet::STORAGE_DOUBLE:
+      return col.doubles.at(row);
+
+    case SqlResultSet::STORAGE_STRING:
+      return col.strings.at(row).toDouble();
+
+    case SqlResultSet::STORAGE_VARIANT:
+      break;
+  }
+  return col.variants.at(row).toDouble();
+}
+
+QString SqlResultRow::valueStr(int column) const
+{
+  const SqlResultSet::Column& col = set->checkedColumn(column, row);
+  if(col.nulls.at(row))
+    return QString();
+
+  switch(col.storage)
+  {
+    case SqlResultSet::STORAGE_INT:
+      return QString::number(col.ints.at(row));
+
+    case SqlResultSet::STORAGE_DOUBLE:
+      return QString::number(col.doubles.at(row));
+
+    case SqlResultSet::STORAGE_STRING:
+      return col.strings.at(row);
+
+    case SqlResultSet::STORAGE_VARIANT:
+      break;
+  }
+  return col.variants.at(row).toString();
+}
+
+qint64 SqlResultRow::valueLongLong(const QString& name) const
+{
+  return valueLongLong(checkedColumn(name));
+}
+
+int SqlResultRow::valueInt(const QString& name) const
+{
+  return valueInt(checkedColumn(name));
+}
+
+double SqlResultRow::valueDouble(const QString& name) const
+{
+  return valueDouble(checkedColumn(name));
+}
+
+float SqlResultRow::valueFloat(const QString& name) const
+{
+  return valueFloat(checkedColumn(name));
+}
+
+QString SqlResultRow::valueStr(const QString& name) const
+{
+  return valueStr(checkedColumn(name));
+}
+
+bool SqlResultRow::valueBool(const QString& name) const
+{
+  return valueBool(checkedColumn(name));
+}
+
+SqlRecord SqlResultRow::toRecord() const
+{
+  SqlRecord record;
+  for(int i = 0; i < set->columns.size(); i++)
+  {
+    const SqlResultSet::Column& col = set->columns.at(i);
+    if(col.nulls.at(row))
+      record.appendFieldAndNullValue(set->columnNames.at(i), col.type);
+    else
+      record.appendFieldAndValue(set->columnNames.at(i), set->columnValue(col, row));
+  }
+  return record;
+}
+
+int SqlResultRow::checkedColumn(const QString& name) const
+{
+  int index = set->columnIndex(name);
+  if(index == -1)
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Column name \"" % name % "\" does not exist");
+  return index;
+}
+
+// ============================================================================================
+SqlResultSet::SqlResultSet()
+{
+}
+
+SqlResultSet::~SqlResultSet()
+{
+}
+
+SqlResultSet SqlResultSet::fromQuery(SqlQuery& query)
+{
+  SqlResultSet resultSet;
+  SqlRecord record = query.record();
+  for(int i = 0; i < record.count(); i++)
+    resultSet.appendColumn(record.fieldName(i), record.fieldType(i));
+
+  int numColumns = resultSet.columns.size();
+  while(query.next())
+  {
+    for(int i = 0; i < numColumns; i++)
+      resultSet.appendValue(resultSet.columns[i], query.value(i));
+    resultSet.numRows++;
+  }
+  return resultSet;
+}
+
+SqlResultSet SqlResultSet::fromRecords(const SqlRecordList& records)
+{
+  SqlResultSet resultSet;
+  if(!records.isEmpty())
+  {
+    const SqlRecord& first = records.constFirst();
+    for(int i = 0; i < first.count(); i++)
+      resultSet.appendColumn(first.fieldName(i), first.fieldType(i));
+
+    int numColumns = resultSet.columns.size();
+    for(const SqlRecord& record : records)
+    {
+      for(int i = 0; i < numColumns; i++)
+        resultSet.appendValue(resultSet.columns[i], record.value(i));
+      resultSet.numRows++;
+    }
+  }
+  return resultSet;
+}
+
+SqlRecordList SqlResultSet::toRecords() const
+{
+  SqlRecordList records;
+  records.reserve(numRows);
+  for(int i = 0; i < numRows; i++)
+    records.append(row(i).toRecord());
+  return records;
+}
+
+void SqlResultSet::appendColumn(const QString& name, QVariant::Type type)
+{
+  if(numRows > 0)
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Cannot add column \"" % name % "\" after rows");
+
+  Column column;
+  column.type = type;
+  switch(type)
+  {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      column.storage = STORAGE_INT;
+      break;
+
+    case QVariant::Double:
+      column.storage = STORAGE_DOUBLE;
+      break;
+
+    case QVariant::String:
+      column.storage = STORAGE_STRING;
+      break;
+
+    default:
+      column.storage = STORAGE_VARIANT;
+      break;
+  }
+
+  columnIndexes.insert(name, columns.size());
+  columnNames.append(name);
+  columns.append(column);
+}
+
+void SqlResultSet::appendRow(const QVariantList& values)
+{
+  if(values.size() != columns.size())
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Number of values " % QString::number(values.size()) %
+                       " does not match number of columns " % QString::number(columns.size()));
+
+  for(int i = 0; i < columns.size(); i++)
+    appendValue(columns[i], values.at(i));
+  numRows++;
+}
+
+void SqlResultSet::clear()
+{
+  columnNames.clear();
+  columnIndexes.clear();
+  columns.clear();
+  numRows = 0;
+}
+
+void SqlResultSet::appendValue(Column& column, const QVariant& value)
+{
+  bool null = value.isNull();
+
+  // Check if value fits into the typed storage - otherwise fall back to variants
+  if(!null && column.storage != STORAGE_VARIANT)
+  {
+    QVariant::Type type = value.type();
+    bool fits = false;
+    switch(column.storage)
+    {
+      case STORAGE_INT:
+        fits = type == QVariant::Int || type == QVariant::LongLong || type == QVariant::UInt ||
+               type == QVariant::ULongLong || type == QVariant::Bool;
+        break;
+      case STORAGE_DOUBLE:
+        fits = type == QVariant::Double || type == QVariant::Int || type == QVariant::LongLong;
+        break;
+      case STORAGE_STRING:
+        fits = type == QVariant::String;
+        break;
+      case STORAGE_VARIANT:
+        break;
+    }
+
+    if(!fits)
+      toVariantStorage(column);
+  }
+
+  column.nulls.append(null);
+  switch(column.storage)
+  {
+    case STORAGE_INT:
+      column.ints.append(null ? 0 : value.toLongLong());
+      break;
+
+    case STORAGE_DOUBLE:
+      column.doubles.append(null ? 0. : value.toDouble());
+      break;
+
+    case STORAGE_STRING:
+      column.strings.append(null ? QString() : value.toString());
+      break;
+
+    case STORAGE_VARIANT:
+      column.variants.append(value);
+      break;
+  }
+}
+
+QVariant SqlResultSet::columnValue(const Column& column, int row) const
+{
+  if(column.nulls.at(row))
+    return QVariant(column.type);
+
+  switch(column.storage)
+  {
+    case STORAGE_INT:
+      if(column.type == QVariant::Int)
+        return QVariant(static_cast<int>(column.ints.at(row)));
+      else if(column.type == QVariant::Bool)
+        return QVariant(column.ints.at(row) != 0);
+      else
+        return QVariant(column.ints.at(row));
+
+    case STORAGE_DOUBLE:
+      return QVariant(column.doubles.at(row));
+
+    case STORAGE_STRING:
+      return QVariant(column.strings.at(row));
+
+    case STORAGE_VARIANT:
+      break;
+  }
+  return column.variants.at(row);
+}
+
+void SqlResultSet::toVariantStorage(Column& column)
+{
+  QVector<QVariant> variants;
+  variants.reserve(column.nulls.size());
+  for(int i = 0; i < column.nulls.size(); i++)
+    variants.append(columnValue(column, i));
+
+  column.variants.swap(variants);
+  column.ints.clear();
+  column.doubles.clear();
+  column.strings.clear();
+  column.storage = STORAGE_VARIANT;
+}
+
+const SqlResultSet::Column& SqlResultSet::checkedColumn(int column, int row) const
+{
+  if(column < 0 || column >= columns.size())
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Column index " % QString::number(column) % " does not exist");
+  if(row < 0 || row >= numRows)
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Row index " % QString::number(row) % " does not exist");
+  return columns.at(column);
+}
+
+} // namespace sql
+} // namespace atools
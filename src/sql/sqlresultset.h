@@ -0,0 +1,203 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLRESULTSET_H
+#define ATOOLS_SQL_SQLRESULTSET_H
+
+#include "sql/sqltypes.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+
+class SqlQuery;
+class SqlResultSet;
+
+/*
+ * Cheap view on one row of a SqlResultSet. Only valid as long as the result set is not changed or deleted.
+ * Getters throw SqlException for invalid column names or indexes like SqlRecord.
+ */
+class SqlResultRow
+{
+public:
+  QVariant value(int column) const;
+  QVariant value(const QString& name) const;
+
+  bool isNull(int column) const;
+  bool isNull(const QString& name) const;
+
+  /* Typed getters reading directly from the column vectors without QVariant where possible */
+  qint64 valueLongLong(int column) const;
+  int valueInt(int column) const
+  {
+    return static_cast<int>(valueLongLong(column));
+  }
+
+  double valueDouble(int column) const;
+  float valueFloat(int column) const
+  {
+    return static_cast<float>(valueDouble(column));
+  }
+
+  QString valueStr(int column) const;
+  bool valueBool(int column) const
+  {
+    return valueLongLong(column) != 0;
+  }
+
+  qint64 valueLongLong(const QString& name) const;
+  int valueInt(const QString& name) const;
+  double valueDouble(const QString& name) const;
+  float valueFloat(const QString& name) const;
+  QString valueStr(const QString& name) const;
+  bool valueBool(const QString& name) const;
+
+  /* Row index in result set */
+  int getIndex() const
+  {
+    return row;
+  }
+
+  /* Convert to a record with field names and values for existing code */
+  atools::sql::SqlRecord toRecord() const;
+
+private:
+  friend class SqlResultSet;
+
+  SqlResultRow(const SqlResultSet *resultSet, int rowIndex)
+    : set(resultSet), row(rowIndex)
+  {
+  }
+
+  int checkedColumn(const QString& name) const;
+
+  const SqlResultSet *set;
+  int row;
+};
+
+/*
+ * Columnar result set which keeps the schema once and the values in typed column vectors.
+ * Uses less memory than a SqlRecordList which has a copy of field names and QVariants in each row.
+ *
+ * Column storage is selected by the field type of the query or record. A column falls back to QVariant storage
+ * if a value does not match since SQLite allows mixed types in a column.
+ */
+class SqlResultSet
+{
+public:
+  SqlResultSet();
+  ~SqlResultSet();
+
+  /* Read all remaining rows from the executed query. Values are read by index without record copies. */
+  static SqlResultSet fromQuery(atools::sql::SqlQuery& query);
+
+  /* Convert records which all have to have the same fields as the first one */
+  static SqlResultSet fromRecords(const atools::sql::SqlRecordList& records);
+
+  /* Convert to record list for existing callers */
+  atools::sql::SqlRecordList toRecords() const;
+
+  /* Add a column. Only allowed before the first row is added. */
+  void appendColumn(const QString& name, QVariant::Type type);
+
+  /* Add a row with values in column order */
+  void appendRow(const QVariantList& values);
+
+  SqlResultRow row(int index) const
+  {
+    return SqlResultRow(this, index);
+  }
+
+  SqlResultRow operator[](int index) const
+  {
+    return SqlResultRow(this, index);
+  }
+
+  /* Number of rows */
+  int size() const
+  {
+    return numRows;
+  }
+
+  bool isEmpty() const
+  {
+    return numRows == 0;
+  }
+
+  int columnCount() const
+  {
+    return columns.size();
+  }
+
+  /* Column index for name or -1 if not found */
+  int columnIndex(const QString& name) const
+  {
+    return columnIndexes.value(name, -1);
+  }
+
+  const QStringList& getColumnNames() const
+  {
+    return columnNames;
+  }
+
+  void clear();
+
+private:
+  friend class SqlResultRow;
+
+  enum Storage
+  {
+    STORAGE_INT,
+    STORAGE_DOUBLE,
+    STORAGE_STRING,
+    STORAGE_VARIANT
+  };
+
+  struct Column
+  {
+    QVariant::Type type;
+    Storage storage;
+    QVector<qint64> ints;
+    QVector<double> doubles;
+    QVector<QString> strings;
+    QVector<QVariant> variants;
+    QVector<bool> nulls;
+  };
+
+  void appendValue(Column& column, const QVariant& value);
+  QVariant columnValue(const Column& column, int row) const;
+
+  /* Move all values of the column to QVariant storage */
+  void toVariantStorage(Column& column);
+
+  const Column& checkedColumn(int column, int row) const;
+
+  QStringList columnNames;
+  QHash<QString, int> columnIndexes;
+  QVector<Column> columns;
+  int numRows = 0;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLRESULTSET_H
@@ -22,6 +22,7 @@
 #include "sql/sqlrecord.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QTextStream>
 
@@ -69,13 +70,18 @@ void SqlScript::executeScript(QTextStream& script)
   parseSqlScript(script, statements);
 
   SqlQuery query(db);
+  QElapsedTimer timer;
   for(const ScriptCmd& cmd : qAsConst(statements))
   {
     if(verbose)
       qDebug().nospace() << cmd.lineNumber << ": " << QString(cmd.sql).replace('\n', ' ');
 
+    timer.start();
     query.exec(cmd.sql);
 
+    if(logTimings)
+      qDebug().nospace() << cmd.lineNumber << ": " << timer.elapsed() << " ms";
+
     if(verbose)
     {
       // Print affected rows if any ==============
@@ -53,6 +53,12 @@ public:
   /* Read script from stream and execute it */
   void executeScript(QTextStream& script);
 
+  /* Log execution time for each statement to find slow statements or index creation. Default is false. */
+  void setLogTimings(bool value)
+  {
+    logTimings = value;
+  }
+
 private:
   struct ScriptCmd
   {
@@ -64,7 +70,7 @@ private:
   void parseSqlScript(QTextStream& script, QList<ScriptCmd>& statements);
 
   SqlDatabase *db;
-  bool verbose = true;
+  bool verbose = true, logTimings = false;
 };
 
 } // namespace sql
@@ -0,0 +1,74 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlstatementcache.h"
+
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace sql {
+
+Q_DECL_CONSTEXPR int SqlStatementCache::DEFAULT_CAPACITY;
+
+SqlStatementCache::SqlStatementCache(const SqlDatabase *sqlDb, int maxStatements)
+  : db(*sqlDb), cache(-1, maxStatements)
+{
+}
+
+SqlStatementCache::~SqlStatementCache()
+{
+  qDebug() << Q_FUNC_INFO << db.connectionName() << "hits" << cache.getHits() << "misses" << cache.getMisses();
+}
+
+QSharedPointer<SqlQuery> SqlStatementCache::query(const QString& sql)
+{
+  QString key = normalize(sql);
+
+  QSharedPointer<SqlQuery> *cached = cache.value(key);
+  if(cached != nullptr)
+  {
+    QSharedPointer<SqlQuery> query = *cached;
+
+    // Reset statement from previous use
+    query->finish();
+    query->clearBoundValues();
+    return query;
+  }
+
+  QSharedPointer<SqlQuery> query(new SqlQuery(db));
+  query->prepare(key);
+
+  // Least recently used statement is dropped if full
+  cache.insert(key, query);
+  return query;
+}
+
+void SqlStatementCache::clear()
+{
+  cache.clear();
+}
+
+QString SqlStatementCache::normalize(const QString& sql)
+{
+  return sql.simplified();
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLSTATEMENTCACHE_H
+#define ATOOLS_SQL_SQLSTATEMENTCACHE_H
+
+#include "sql/sqldatabase.h"
+#include "util/timedcache.h"
+
+#include <QSharedPointer>
+
+namespace atools {
+namespace sql {
+
+class SqlQuery;
+
+/*
+ * Least recently used cache of prepared statements for one database connection keyed by SQL text.
+ * Repeated queries skip the parse and plan step in SQLite.
+ *
+ * SQL text is normalized by collapsing whitespace before lookup. Statements which are evicted from the cache
+ * stay valid as long as the caller keeps the returned shared pointer.
+ *
+ * Use SqlDatabase::statementCache() to get the cache for a connection. Not thread safe like the connection itself.
+ */
+class SqlStatementCache
+{
+public:
+  explicit SqlStatementCache(const atools::sql::SqlDatabase *sqlDb, int maxStatements = DEFAULT_CAPACITY);
+  ~SqlStatementCache();
+
+  SqlStatementCache(const SqlStatementCache& other) = delete;
+  SqlStatementCache& operator=(const SqlStatementCache& other) = delete;
+
+  /* Get prepared statement for the SQL text. Prepares and caches the statement if not found.
+   * Bound values are cleared and a previous result set is finished before returning a cached statement.
+   * Do not use the same SQL text in nested loops since both get the same statement. */
+  QSharedPointer<atools::sql::SqlQuery> query(const QString& sql);
+
+  /* Remove all statements */
+  void clear();
+
+  /* Number of cached statements */
+  int size() const
+  {
+    return cache.size();
+  }
+
+  int getCapacity() const
+  {
+    return cache.getMaxEntries();
+  }
+
+  void setCapacity(int maxStatements)
+  {
+    cache.setMaxEntries(maxStatements);
+  }
+
+  /* Lookup statistics for tuning */
+  quint64 getHits() const
+  {
+    return cache.getHits();
+  }
+
+  quint64 getMisses() const
+  {
+    return cache.getMisses();
+  }
+
+  /* Collapses whitespace to get a key for the cache */
+  static QString normalize(const QString& sql);
+
+  static Q_DECL_CONSTEXPR int DEFAULT_CAPACITY = 64;
+
+private:
+  atools::sql::SqlDatabase db;
+  atools::util::TimedCache<QString, QSharedPointer<atools::sql::SqlQuery> > cache;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLSTATEMENTCACHE_H
@@ -16,10 +16,12 @@
 *****************************************************************************/
 
 #include "sql/sqlutil.h"
+
 #include "sql/sqldatabase.h"
 #include "sql/sqlrecord.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlexception.h"
+#include "sql/sqlstatementcache.h"
 
 #include <QDebug>
 #include <QString>
@@ -345,55 +347,63 @@ void SqlUtil::createColumnReport(QDebug& out, const QStringList& tables) const
 
   out << "Column value report for database:" << endl;
 
-  const QStringList tableList = buildTableList(tables);
+  for(const QString& name : buildTableList(tables))
+    createColumnReportTable(out, name);
+}
 
-  SqlQuery querySelCount(db);
-  SqlQuery queryGroup(db);
+void SqlUtil::createColumnReportTable(QDebug& out, const QString& table) const
+{
+  QDebugStateSaver saver(out);
+  out.noquote().nospace();
 
-  for(const QString& name : tableList)
+  if(hasTable(table))
   {
-    if(hasTable(name))
+    if(hasTableAndRows(table))
     {
-      if(hasTableAndRows(name))
-      {
-        SqlRecord record = db->record(name);
+      SqlRecord record = db->record(table);
+
+      // Count distinct values of all columns in one table scan
+      QStringList counts;
+      for(int i = 0; i < record.count(); i++)
+        counts.append("count(distinct " % record.fieldName(i) % ")");
 
+      SqlQuery querySelCount(db);
+      querySelCount.exec("select " % counts.join(", ") % " from " % table);
+      if(querySelCount.next())
+      {
+        SqlQuery queryGroup(db);
         for(int i = 0; i < record.count(); i++)
         {
           QString col = record.fieldName(i);
-          querySelCount.exec("select count(distinct " % col % ") as cnt from " % name);
-          if(querySelCount.next())
+          int cnt = querySelCount.value(i).toInt();
+          if(cnt < 2)
           {
-            int cnt = querySelCount.value("cnt").toInt();
-            if(cnt < 2)
+            out << table << "." << col;
+            if(cnt == 0)
+              out << " has no distinct values" << endl;
+            else if(cnt == 1)
             {
-              out << name << "." << col;
-              if(cnt == 0)
-                out << " has no distinct values" << endl;
-              else if(cnt == 1)
+              out << " has only 1 distinct value: ";
+              queryGroup.exec("select " % col % " from " % table % " group by " % col);
+              while(queryGroup.next())
               {
-                out << " has only 1 distinct value: ";
-                queryGroup.exec("select " % col % " from " % name % " group by " % col);
-                while(queryGroup.next())
-                {
-                  QVariant val = queryGroup.value(0);
-                  if(val.type() != QVariant::ByteArray && val.canConvert(QVariant::String))
-                    out << val.toString();
-                  else
-                    out << "[" << val.typeName() << "]";
-                }
-                out << endl;
+                QVariant val = queryGroup.value(0);
+                if(val.type() != QVariant::ByteArray && val.canConvert(QVariant::String))
+                  out << val.toString();
+                else
+                  out << "[" << val.typeName() << "]";
               }
+              out << endl;
             }
           }
         }
       }
-      else
-        out << name << " is empty" << endl;
     }
     else
-      out << name << " does not exist" << endl;
+      out << table << " is empty" << endl;
   }
+  else
+    out << table << " does not exist" << endl;
 }
 
 void SqlUtil::reportRangeViolations(QDebug& out,
@@ -544,18 +554,16 @@ int SqlUtil::getMaxId(const QString& table, const QString& idColumn)
 
 void SqlUtil::getIds(QSet<int>& ids, const QString& table, const QString& idColumn, const QString& where)
 {
-  SqlQuery query("select " % idColumn % " from " % table % " " % (where.isEmpty() ? QString() : " where " % where), db);
-  query.exec();
-  while(query.next())
-    ids.insert(query.valueInt(0));
+  getIds(ids, "select " % idColumn % " from " % table % " " % (where.isEmpty() ? QString() : " where " % where));
 }
 
 void SqlUtil::getIds(QSet<int>& ids, const QString& queryString)
 {
-  SqlQuery query(queryString, db);
-  query.exec();
-  while(query.next())
-    ids.insert(query.valueInt(0));
+  QSharedPointer<SqlQuery> query = db->statementCache().query(queryString);
+  query->exec();
+  while(query->next())
+    ids.insert(query->valueInt(0));
+  query->finish();
 }
 
 int SqlUtil::getValueInt(const QString& queryStr, int defaultValue)
@@ -576,13 +584,13 @@ QString SqlUtil::getValueStr(const QString& queryStr, const QString& defaultValu
 QVariant SqlUtil::getValueVar(const QString& queryStr, const QVariant& defaultValue)
 {
   QVariant var;
-  SqlQuery query(queryStr, db);
-  query.exec(queryStr);
-  if(query.next())
-    var = query.value(0);
+  QSharedPointer<SqlQuery> query = db->statementCache().query(queryStr);
+  query->exec();
+  if(query->next())
+    var = query->value(0);
   else
     var = defaultValue;
-  query.finish();
+  query->finish();
   return var;
 }
 
@@ -54,6 +54,9 @@ public:
   QStringList buildColumnListIf(const QString& tablename, const QStringList& columns) const;
 
   void createColumnReport(QDebug& out, const QStringList& tables = QStringList()) const;
+
+  /* Column report for a single table without header. Counts distinct values of all columns in one scan. */
+  void createColumnReportTable(QDebug& out, const QString& table) const;
   void reportDuplicates(QDebug& out, const QString& table, const QString& idColumn,
                         const QStringList& identityColumns) const;
 
@@ -0,0 +1,282 @@
+/**
+ *  @file
+ */
+
+#include "compiledtemplate.h"
+#include <QRegularExpression>
+
+using namespace stefanfrings;
+
+CompiledTemplate::CompiledTemplate()
+{
+}
+
+CompiledTemplate::CompiledTemplate(const QString& source, const QString& sourceName)
+  : sourceName(sourceName), sourceSize(source.size())
+{
+  parse(source);
+}
+
+bool CompiledTemplate::isEmpty() const
+{
+  return nodes == nullptr || nodes->isEmpty();
+}
+
+void CompiledTemplate::parse(const QString& source)
+{
+  // Tags like "{name}", "{if name}", "{ifnot name}", "{else name}", "{end name}" and "{loop name}"
+  static const QRegularExpression TAG_REGEXP("\\{(?:(if|ifnot|else|end|loop) )?([A-Za-z0-9_.\\-]+)\\}");
+
+  // Blocks which are not closed yet - first is the root which collects the top level nodes
+  struct Block
+  {
+    Node node;
+    bool inElse;
+  };
+  QVector<Block> stack;
+  stack.append(Block({Node(), false}));
+
+  int pos = 0;
+  QRegularExpressionMatchIterator it = TAG_REGEXP.globalMatch(source);
+  while(it.hasNext())
+  {
+    QRegularExpressionMatch match = it.next();
+    Block& top = stack.last();
+    QVector<Node>& current = top.inElse ? top.node.elseChildren : top.node.children;
+    appendText(current, source.mid(pos, match.capturedStart() - pos));
+    pos = match.capturedEnd();
+
+    QString keyword = match.captured(1);
+    Node node;
+    node.text = match.captured(0);
+    node.name = match.captured(2);
+    node.path = node.name.split('.');
+
+    if(keyword.isEmpty())
+    {
+      node.type = VARIABLE;
+      current.append(node);
+    }
+    else if(keyword == "if" || keyword == "ifnot" || keyword == "loop")
+    {
+      node.type = keyword == "if" ? IF : (keyword == "ifnot" ? IFNOT : LOOP);
+      stack.append(Block({node, false}));
+    }
+    else if(keyword == "else" && stack.size() > 1 && !top.inElse && top.node.name == node.name)
+    {
+      top.inElse = true;
+    }
+    else if(keyword == "end" && stack.size() > 1 && top.node.name == node.name)
+    {
+      Node closed = stack.takeLast().node;
+      Block& parent = stack.last();
+      (parent.inElse ? parent.node.elseChildren : parent.node.children).append(closed);
+    }
+    else
+    {
+      // Else or end without matching start - keep as text like Template does
+      appendText(current, node.text);
+    }
+  }
+
+  // Close all remaining blocks at the end of the source
+  while(stack.size() > 1)
+  {
+    qWarning("CompiledTemplate: missing end {end %s} in %s", qPrintable(stack.last().node.name),
+             qPrintable(sourceName));
+    Node closed = stack.takeLast().node;
+    Block& parent = stack.last();
+    (parent.inElse ? parent.node.elseChildren : parent.node.children).append(closed);
+  }
+
+  Block& root = stack.last();
+  appendText(root.node.children, source.mid(pos));
+  nodes = std::make_shared<const QVector<Node> >(root.node.children);
+}
+
+void CompiledTemplate::appendText(QVector<Node>& nodeList, const QString& text)
+{
+  if(text.isEmpty())
+  {
+    return;
+  }
+
+  // Merge adjacent text nodes
+  if(!nodeList.isEmpty() && nodeList.last().type == TEXT)
+  {
+    nodeList.last().text.append(text);
+  }
+  else
+  {
+    Node node;
+    node.type = TEXT;
+    node.text = text;
+    nodeList.append(node);
+  }
+}
+
+QString CompiledTemplate::render(const QVariantHash& context) const
+{
+  QString output;
+  render(context, output);
+  return output;
+}
+
+void CompiledTemplate::render(const QVariantHash& context, QString& output) const
+{
+  if(nodes == nullptr)
+  {
+    return;
+  }
+
+  output.reserve(output.size() + sourceSize);
+  QVector<Scope> scopes;
+  renderNodes(*nodes, context, scopes, output);
+}
+
+void CompiledTemplate::renderNodes(const QVector<Node>& nodeList, const QVariantHash& context,
+                                   QVector<Scope>& scopes, QString& output) const
+{
+  QVariant value;
+  for(const Node& node : nodeList)
+  {
+    switch(node.type)
+    {
+      case TEXT:
+        output.append(node.text);
+        break;
+
+      case VARIABLE:
+        // Keep unknown variables as they are
+        output.append(resolve(node, context, scopes, value) ? value.toString() : node.text);
+        break;
+
+      case IF:
+      case IFNOT:
+        {
+          bool condition = resolve(node, context, scopes, value) && isTrue(value);
+          if(node.type == IFNOT)
+          {
+            condition = !condition;
+          }
+          renderNodes(condition ? node.children : node.elseChildren, context, scopes, output);
+        }
+        break;
+
+      case LOOP:
+        {
+          QVariantList list;
+          if(resolve(node, context, scopes, value) &&
+             (value.userType() == QMetaType::QVariantList || value.userType() == QMetaType::QStringList))
+          {
+            list = value.toList();
+          }
+
+          if(list.isEmpty())
+          {
+            renderNodes(node.elseChildren, context, scopes, output);
+          }
+          else
+          {
+            scopes.append(Scope({&node.name, node.path.size(), QVariant()}));
+            for(const QVariant& element : list)
+            {
+              scopes.last().value = element;
+              renderNodes(node.children, context, scopes, output);
+            }
+            scopes.removeLast();
+          }
+        }
+        break;
+    }
+  }
+}
+
+bool CompiledTemplate::resolve(const Node& node, const QVariantHash& context, const QVector<Scope>& scopes,
+                               QVariant& value) const
+{
+  int start = -1;
+
+  // Look for the innermost loop which is a prefix of the name
+  for(int i = scopes.size() - 1; i >= 0 && start == -1; i--)
+  {
+    const Scope& scope = scopes.at(i);
+    const QString& scopeName = *scope.name;
+    if(node.name.startsWith(scopeName) &&
+       (node.name.size() == scopeName.size() || node.name.at(scopeName.size()) == '.'))
+    {
+      value = scope.value;
+      start = scope.segments;
+    }
+  }
+
+  if(start == -1)
+  {
+    // Try full name first to allow flat keys containing dots
+    QVariantHash::const_iterator it = context.constFind(node.name);
+    if(it != context.constEnd())
+    {
+      value = it.value();
+      return true;
+    }
+
+    it = context.constFind(node.path.first());
+    if(it == context.constEnd())
+    {
+      return false;
+    }
+
+    value = it.value();
+    start = 1;
+  }
+
+  // Walk down into nested maps
+  for(int i = start; i < node.path.size(); i++)
+  {
+    const QString& key = node.path.at(i);
+    if(value.userType() == QMetaType::QVariantHash)
+    {
+      QVariantHash hash = value.toHash();
+      QVariantHash::const_iterator it = hash.constFind(key);
+      if(it == hash.constEnd())
+      {
+        return false;
+      }
+      value = it.value();
+    }
+    else if(value.userType() == QMetaType::QVariantMap)
+    {
+      QVariantMap map = value.toMap();
+      QVariantMap::const_iterator it = map.constFind(key);
+      if(it == map.constEnd())
+      {
+        return false;
+      }
+      value = it.value();
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CompiledTemplate::isTrue(const QVariant& value)
+{
+  switch(value.userType())
+  {
+    case QMetaType::QVariantList:
+    case QMetaType::QStringList:
+      return !value.toList().isEmpty();
+
+    case QMetaType::QVariantHash:
+      return !value.toHash().isEmpty();
+
+    case QMetaType::QVariantMap:
+      return !value.toMap().isEmpty();
+
+    default:
+      return value.toBool();
+  }
+}
@@ -0,0 +1,128 @@
+/**
+ *  @file
+ */
+
+#ifndef COMPILEDTEMPLATE_H
+#define COMPILEDTEMPLATE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <memory>
+#include "templateglobal.h"
+
+namespace stefanfrings {
+
+/**
+ *  Template which is parsed once into a syntax tree and rendered in a single pass.
+ *  Uses the same tag syntax as Template but takes all values from a context instead of
+ *  rewriting the source for each variable, condition and loop.
+ *  <p>
+ *  Loops iterate over lists in the context. Inside a loop the loop name refers to the current element.
+ *  Nested values are addressed by dotted names. Example for the nested loop shown in Template:
+ *  <p><code><pre>
+ *  QVariantList rows;
+ *  for(const Row& r : data)
+ *  {
+ *    QVariantList columns;
+ *    for(const QString& c : r.values)
+ *      columns.append(QVariantHash({{"value", c}}));
+ *    rows.append(QVariantHash({{"column", columns}}));
+ *  }
+ *
+ *  QVariantHash context;
+ *  context.insert("row", rows);
+ *  QString html = compiledTemplate.render(context);
+ *  </pre></code></p>
+ *  <p>
+ *  Rules:
+ *  - {name} is replaced by the value. Unknown variables are kept as they are like in Template.
+ *  - {if name} is true for a true boolean, a non empty list or map or any value which converts to true.
+ *  - {loop name} repeats for each element of a list. The else part is used for empty or missing lists.
+ *  - A key containing dots like "user.name" is found directly in the context as well.
+ *  <p>
+ *  Use QJsonObject::toVariantHash() to render JSON data.
+ *  <p>
+ *  The syntax tree is immutable and shared between copies, so one instance can be rendered by
+ *  many threads at the same time.
+ *  @see Template
+ *  @see TemplateCache
+ */
+class DECLSPEC CompiledTemplate
+{
+public:
+  /** Creates an empty template */
+  CompiledTemplate();
+
+  /**
+   *  Parse the given source.
+   *  @param source The template source text
+   *  @param sourceName Name of the source file, used for logging
+   */
+  CompiledTemplate(const QString& source, const QString& sourceName);
+
+  /** Render the template using the values in context */
+  QString render(const QVariantHash& context) const;
+
+  /** Render the template using the values in context and append the result to output */
+  void render(const QVariantHash& context, QString& output) const;
+
+  /** true if nothing was parsed */
+  bool isEmpty() const;
+
+  const QString& getSourceName() const
+  {
+    return sourceName;
+  }
+
+private:
+  enum NodeType
+  {
+    TEXT,
+    VARIABLE,
+    IF,
+    IFNOT,
+    LOOP
+  };
+
+  struct Node
+  {
+    NodeType type;
+
+    /* Literal text, or the original tag for variables to print unresolved ones */
+    QString text;
+
+    /* Dotted name and its segments */
+    QString name;
+    QStringList path;
+
+    /* Body and else part of conditions and loops */
+    QVector<Node> children, elseChildren;
+  };
+
+  /* Current element of a loop */
+  struct Scope
+  {
+    const QString *name;
+    int segments;
+    QVariant value;
+  };
+
+  void parse(const QString& source);
+  void renderNodes(const QVector<Node>& nodeList, const QVariantHash& context, QVector<Scope>& scopes,
+                   QString& output) const;
+  bool resolve(const Node& node, const QVariantHash& context, const QVector<Scope>& scopes, QVariant& value) const;
+
+  static void appendText(QVector<Node>& nodeList, const QString& text);
+  static bool isTrue(const QVariant& value);
+
+  /* Top level nodes - immutable and shared between copies */
+  std::shared_ptr<const QVector<Node> > nodes;
+  QString sourceName;
+  int sourceSize = 0;
+};
+
+} // end of namespace
+
+#endif // COMPILEDTEMPLATE_H
@@ -87,6 +87,7 @@ namespace stefanfrings {
  *  </pre></code></p>
  *  @see TemplateLoader
  *  @see TemplateCache
+ *  @see CompiledTemplate
  */
 
 class DECLSPEC Template :
@@ -10,27 +10,56 @@ TemplateCache::TemplateCache(QHash<QString, QVariant> settings, QObject *parent)
 {
   cache.setMaxCost(settings.value("cacheSize", "1000000").toInt());
   cacheTimeout = settings.value("cacheTime", "60000").toInt();
+  cache.setTimeout(cacheTimeout);
+  compiledCache.setMaxCost(cache.maxCost());
+  compiledCache.setTimeout(cacheTimeout);
   qDebug("TemplateCache: timeout=%i, size=%i", cacheTimeout, cache.maxCost());
 }
 
 QString TemplateCache::tryFile(const QString localizedName)
 {
   qint64 now = QDateTime::currentMSecsSinceEpoch();
-  mutex.lock();
   // search in cache
   qDebug("TemplateCache: trying cached %s", qPrintable(localizedName));
-  CacheEntry *entry = cache.object(localizedName);
-  if(entry && (cacheTimeout == 0 || entry->created > now - cacheTimeout))
+  SharedCache<QString, QString>::EntryPtr entry = cache.object(localizedName, now);
+  if(entry)
   {
-    mutex.unlock();
-    return entry->document;
+    return *entry;
   }
   // search on filesystem
-  entry = new CacheEntry();
-  entry->created = now;
-  entry->document = TemplateLoader::tryFile(localizedName);
+  entry = std::make_shared<const QString>(TemplateLoader::tryFile(localizedName));
   // Store in cache even when the file did not exist, to remember that there is no such file
-  cache.insert(localizedName, entry, entry->document.size());
-  mutex.unlock();
-  return entry->document;
+  cache.insert(localizedName, entry, entry->size(), now);
+  return *entry;
 }
+
+CompiledTemplate TemplateCache::getCompiledTemplate(const QString templateName, const QString locales)
+{
+  QString localizedName;
+  QString document = findDocument(templateName, locales, localizedName);
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  SharedCache<QString, CompiledTemplate>::EntryPtr entry = compiledCache.object(localizedName, now);
+  if(entry)
+  {
+    return *entry;
+  }
+
+  entry = std::make_shared<const CompiledTemplate>(document, localizedName);
+  compiledCache.insert(localizedName, entry, document.size(), now);
+  return *entry;
+}
+
+void TemplateCache::getMemoryUsage(qint64& bytes, qint64& elements) const
+{
+  // Cost is the number of characters - parsed templates are counted with the size of their source
+  bytes += (static_cast<qint64>(cache.totalCost()) + compiledCache.totalCost()) * static_cast<qint64>(sizeof(QChar));
+  elements += cache.count() + compiledCache.count();
+}
+
+void TemplateCache::releaseMemory(qint64 maxBytes)
+{
+  Q_UNUSED(maxBytes)
+  cache.clear();
+  compiledCache.clear();
+}
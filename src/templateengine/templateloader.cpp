@@ -60,6 +60,20 @@ QString TemplateLoader::tryFile(QString localizedName)
 }
 
 Template TemplateLoader::getTemplate(QString templateName, QString locales)
+{
+  QString localizedName;
+  QString document = findDocument(templateName, locales, localizedName);
+  return Template(document, localizedName);
+}
+
+CompiledTemplate TemplateLoader::getCompiledTemplate(QString templateName, QString locales)
+{
+  QString localizedName;
+  QString document = findDocument(templateName, locales, localizedName);
+  return CompiledTemplate(document, localizedName);
+}
+
+QString TemplateLoader::findDocument(const QString& templateName, const QString& locales, QString& localizedName)
 {
   QSet<QString> tried;   // used to suppress duplicate attempts
 
@@ -73,13 +87,13 @@ Template TemplateLoader::getTemplate(QString templateName, QString locales)
   {
     loc.replace(QRegularExpression(";.*"), "");
     loc.replace('-', '_');
-    QString localizedName = templateName + "-" + loc.trimmed();
+    localizedName = templateName + "-" + loc.trimmed();
     if(!tried.contains(localizedName))
     {
       QString document = tryFile(localizedName);
       if(!document.isEmpty())
       {
-        return Template(document, localizedName);
+        return document;
       }
       tried.insert(localizedName);
     }
@@ -89,25 +103,24 @@ Template TemplateLoader::getTemplate(QString templateName, QString locales)
   foreach(QString loc, locs)
   {
     loc.replace(QRegularExpression("[;_-].*"), "");
-    QString localizedName = templateName + "-" + loc.trimmed();
+    localizedName = templateName + "-" + loc.trimmed();
     if(!tried.contains(localizedName))
     {
       QString document = tryFile(localizedName);
       if(!document.isEmpty())
       {
-        return Template(document, localizedName);
+        return document;
       }
       tried.insert(localizedName);
     }
   }
 
   // Search for default file
+  localizedName = templateName;
   QString document = tryFile(templateName);
-  if(!document.isEmpty())
+  if(document.isEmpty())
   {
-    return Template(document, templateName);
+    qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
   }
-
-  qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
-  return Template("", templateName);
+  return document;
 }
@@ -12,6 +12,7 @@
 #include <QMutex>
 #include "templateglobal.h"
 #include "template.h"
+#include "compiledtemplate.h"
 
 namespace stefanfrings {
 
@@ -62,7 +63,22 @@ public:
    */
   Template getTemplate(const QString templateName, const QString locales = QString());
 
+  /**
+   *  Get a parsed template for a given locale. Same lookup as getTemplate().
+   *  This method is thread safe.
+   *  @return If the template cannot be loaded, an error message is logged and an empty template is returned.
+   *  @see CompiledTemplate
+   */
+  virtual CompiledTemplate getCompiledTemplate(const QString templateName, const QString locales = QString());
+
 protected:
+  /**
+   *  Find the document for the best matching locale.
+   *  @param localizedName Set to the name of the found template
+   *  @return The template document, or empty string if not found
+   */
+  QString findDocument(const QString& templateName, const QString& locales, QString& localizedName);
+
   /**
    *  Try to get a file from cache or filesystem.
    *  @param localizedName Name of the template with locale to find
@@ -23,6 +23,7 @@
 #include "exception.h"
 
 #include <QFile>
+#include <QRunnable>
 
 using atools::util::HttpDownloader;
 
@@ -68,9 +69,61 @@ const QHash<atools::track::TrackType, QStringList> TrackDownloader::PARAM =
   }
 };
 
+/* Decompresses and parses a downloaded page in the thread pool and passes the result back to the downloader thread */
+class TrackParseTask :
+  public QRunnable
+{
+public:
+  TrackParseTask(TrackDownloader *trackDownloader, TrackType trackType, int generationParam, const QByteArray& dataParam,
+                 const QString& downloadUrlParam)
+    : downloader(trackDownloader), type(trackType), generation(generationParam), data(dataParam),
+    downloadUrl(downloadUrlParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    QString error;
+    TrackVectorType tracks;
+    try
+    {
+      TrackReader reader;
+      reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), type);
+      tracks = reader.getTracks();
+    }
+    catch(atools::Exception& e)
+    {
+      error = e.getMessage();
+    }
+    catch(...)
+    {
+      error = TrackDownloader::tr("Unknown error.");
+    }
+
+    TrackDownloader *trackDownloader = downloader;
+    TrackType trackType = type;
+    int gen = generation;
+    QString url = downloadUrl;
+    QMetaObject::invokeMethod(trackDownloader, [trackDownloader, trackType, gen, tracks, error, url]() -> void {
+      trackDownloader->parsingFinished(trackType, gen, tracks, error, url);
+    }, Qt::QueuedConnection);
+  }
+
+private:
+  TrackDownloader *downloader;
+  TrackType type;
+  int generation;
+  QByteArray data;
+  QString downloadUrl;
+};
+
 TrackDownloader::TrackDownloader(QObject *parent, bool logVerbose)
   : QObject(parent), verbose(logVerbose)
 {
+  // Parse all track systems in parallel
+  parsePool.setMaxThreadCount(3);
+
   // Initialize NAT downloader ============================================================
   HttpDownloader *natDownloader = new HttpDownloader(parent, verbose);
   natDownloader->setUrl(URL.value(NAT));
@@ -107,84 +160,56 @@ TrackDownloader::TrackDownloader(QObject *parent, bool logVerbose)
 
 TrackDownloader::~TrackDownloader()
 {
+  // Results of running tasks are dropped since this object is gone
+  parsePool.waitForDone();
   qDeleteAll(downloaders);
 }
 
 void TrackDownloader::natDownloadFinished(const QByteArray& data, QString downloadUrl)
 {
-  try
-  {
-#ifdef DEBUG_TRACK_TEST_SAVE
-    QFile file("/tmp/NAT.txt");
-    if(file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-      file.write(data);
-      file.close();
-    }
-#endif
-
-    TrackReader reader;
-    reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), NAT);
-    trackList[NAT] = reader.getTracks();
-
-    emit trackDownloadFinished(trackList.value(NAT), NAT);
-  }
-  catch(atools::Exception& e)
-  {
-    qWarning() << Q_FUNC_INFO << e.what() << downloadUrl;
-    emit trackDownloadFailed(e.what(), 0, downloadUrl, NAT);
-  }
+  startParsing(NAT, data, downloadUrl);
 }
 
 void TrackDownloader::pacotsDownloadFinished(const QByteArray& data, QString downloadUrl)
 {
-  try
-  {
-#ifdef DEBUG_TRACK_TEST_SAVE
-    QFile file("/tmp/PACOTS.txt");
-    if(file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-      file.write(data);
-      file.close();
-    }
-#endif
-
-    TrackReader reader;
-    reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), PACOTS);
-    trackList[PACOTS] = reader.getTracks();
-
-    emit trackDownloadFinished(trackList.value(PACOTS), PACOTS);
-  }
-  catch(atools::Exception& e)
-  {
-    qWarning() << Q_FUNC_INFO << e.what() << downloadUrl;
-    emit trackDownloadFailed(e.what(), 0, downloadUrl, PACOTS);
-  }
+  startParsing(PACOTS, data, downloadUrl);
 }
 
 void TrackDownloader::ausotsDownloadFinished(const QByteArray& data, QString downloadUrl)
 {
-  try
-  {
+  startParsing(AUSOTS, data, downloadUrl);
+}
+
+void TrackDownloader::startParsing(TrackType type, const QByteArray& data, const QString& downloadUrl)
+{
 #ifdef DEBUG_TRACK_TEST_SAVE
-    QFile file("/tmp/AUSOTS.txt");
-    if(file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-      file.write(data);
-      file.close();
-    }
+  QFile file(QString("/tmp/%1.txt").arg(typeToString(type)));
+  if(file.open(QIODevice::WriteOnly | QIODevice::Text))
+  {
+    file.write(data);
+    file.close();
+  }
 #endif
 
-    TrackReader reader;
-    reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), AUSOTS);
-    trackList[AUSOTS] = reader.getTracks();
+  parsePool.start(new TrackParseTask(this, type, generation.value(type), data, downloadUrl));
+}
 
-    emit trackDownloadFinished(trackList.value(AUSOTS), AUSOTS);
+void TrackDownloader::parsingFinished(TrackType type, int parseGeneration, const TrackVectorType& tracks,
+                                      const QString& error, const QString& downloadUrl)
+{
+  if(parseGeneration != generation.value(type))
+    // Download was cancelled or restarted in the meantime
+    return;
+
+  if(error.isEmpty())
+  {
+    trackList[type] = tracks;
+    emit trackDownloadFinished(trackList.value(type), type);
   }
-  catch(atools::Exception& e)
+  else
   {
-    qWarning() << Q_FUNC_INFO << e.what() << downloadUrl;
-    emit trackDownloadFailed(e.what(), 0, downloadUrl, AUSOTS);
+    qWarning() << Q_FUNC_INFO << error << downloadUrl;
+    emit trackDownloadFailed(error, 0, downloadUrl, type);
   }
 }
 
@@ -222,19 +247,27 @@ void TrackDownloader::setUrl(TrackType type, const QString& url, const QStringLi
 
 void TrackDownloader::startAllDownloads()
 {
-  for(HttpDownloader *downloader : qAsConst(downloaders))
-    downloader->startDownload();
+  for(auto it = downloaders.constBegin(); it != downloaders.constEnd(); ++it)
+  {
+    // Drop results of parsing a previous download
+    generation[it.key()]++;
+    it.value()->startDownload();
+  }
 }
 
 void TrackDownloader::startDownload(TrackType type)
 {
+  generation[type]++;
   downloaders[type]->startDownload();
 }
 
 void TrackDownloader::cancelAllDownloads()
 {
-  for(HttpDownloader *downloader : qAsConst(downloaders))
-    downloader->cancelDownload();
+  for(auto it = downloaders.constBegin(); it != downloaders.constEnd(); ++it)
+  {
+    generation[it.key()]++;
+    it.value()->cancelDownload();
+  }
 }
 
 const atools::track::TrackVectorType& TrackDownloader::getTracks(TrackType type)
@@ -21,6 +21,7 @@
 #include "track/tracktypes.h"
 
 #include <QObject>
+#include <QThreadPool>
 
 namespace atools {
 namespace util {
@@ -37,6 +38,9 @@ namespace track {
  * NAT: https://notams.aim.faa.gov/nat.html
  * PACOTS: https://www.notams.faa.gov/dinsQueryWeb/advancedNotamMapAction.do
  *         Uses POST with parameters "queryType=pacificTracks&actionType=advancedNOTAMFunctions"
+ *
+ * Downloaded pages are decompressed and parsed in a thread pool. All track systems are processed in parallel.
+ * Signals are emitted in the thread of this object.
  */
 class TrackDownloader :
   public QObject
@@ -95,6 +99,15 @@ signals:
   void trackDownloadSslErrors(const QStringList& errors, const QString& downloadUrl);
 
 private:
+  friend class TrackParseTask;
+
+  /* Decompress and parse data in the thread pool */
+  void startParsing(atools::track::TrackType type, const QByteArray& data, const QString& downloadUrl);
+
+  /* Called in object thread once parsing is done. Emits signals. */
+  void parsingFinished(atools::track::TrackType type, int parseGeneration, const atools::track::TrackVectorType& tracks,
+                       const QString& error, const QString& downloadUrl);
+
   void natDownloadFinished(const QByteArray& data, QString downloadUrl);
   void pacotsDownloadFinished(const QByteArray& data, QString downloadUrl);
   void ausotsDownloadFinished(const QByteArray& data, QString downloadUrl);
@@ -109,6 +122,12 @@ private:
   /* List of tracks for each type */
   QHash<atools::track::TrackType, atools::track::TrackVectorType> trackList;
 
+  /* Incremented on start or cancel to drop results of outdated parsing tasks */
+  QHash<atools::track::TrackType, int> generation;
+
+  /* Parses downloaded pages in background */
+  QThreadPool parsePool;
+
   bool verbose = false;
 };
 
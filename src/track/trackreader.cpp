@@ -23,6 +23,7 @@
 #include <QTextStream>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QSet>
 #include <QTimeZone>
 
 namespace atools {
@@ -30,6 +31,32 @@ namespace track {
 
 const static std::initializer_list<char> INVALID_CHARS = {'/', '-', ';', ':', '<', '>', '=', '(', ')'};
 
+/* Regular expressions are compiled once and shared between threads. Matching is thread safe. */
+// TRACK 1.
+static const QRegularExpression PACOTS_TRACK_REGEXP("^TRACK (\\d+).$");
+
+// ... 07 MAR 07:00 2020 UNTIL 07 MAR 21:00 2020. CREATED: 06 MAR 18:47 2020 ...
+static const QRegularExpression PACOTS_DATE_REGEXP("(\\d\\d) ([A-Z]+) (\\d\\d):(\\d\\d) (\\d\\d\\d\\d) UNTIL "
+                                                   "(\\d\\d) ([A-Z]+) (\\d\\d):(\\d\\d) (\\d\\d\\d\\d)");
+
+// (TDM TRK K 200307050001
+static const QRegularExpression PACOT_NAME_REGEXP("^\\(TDM TRK (\\S+)");
+static const QRegularExpression AUSOT_NAME_REGEXP("^TDM TRK (\\S+)");
+
+// 2003070500 2003072100
+static const QRegularExpression DATE_REGEXP("(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d) "
+                                            "(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d)");
+
+// MAR 08/0100Z TO MAR 08/0800Z
+static const QRegularExpression NAT_DATE_REGEXP("^([A-Z]+) (\\d+)/(\\d\\d)(\\d\\d)Z TO "
+                                                "([A-Z]+) (\\d+)/(\\d\\d)(\\d\\d)Z");
+
+// "58/20" to "5820N"
+static const QRegularExpression NAT_DEG_REGEXP("^(\\d\\d)/(\\d\\d)$");
+
+// "5530/20" to "H5530".
+static const QRegularExpression NAT_DEGH_REGEXP("^(\\d\\d)30/(\\d\\d)$");
+
 TrackReader::TrackReader()
 {
 
@@ -119,13 +146,6 @@ int TrackReader::removeInvalid(TrackVectorType& trackVector)
 
 void TrackReader::extractPacotsTracksFlex(const QStringList& lines)
 {
-  // TRACK 1.
-  static const QRegularExpression PACOTS_TRACK_REGEXP("^TRACK (\\d+).$");
-
-  // ... 07 MAR 07:00 2020 UNTIL 07 MAR 21:00 2020. CREATED: 06 MAR 18:47 2020 ...
-  static const QRegularExpression PACOTS_DATE_REGEXP("(\\d\\d) ([A-Z]+) (\\d\\d):(\\d\\d) (\\d\\d\\d\\d) UNTIL "
-                                                     "(\\d\\d) ([A-Z]+) (\\d\\d):(\\d\\d) (\\d\\d\\d\\d)");
-
   // More than one track for each element. Validity date at end.
   // <PRE><b>Q0328/20</b> - EASTBOUND PACOTS TRACKS BETWEEN JAPAN AND NORTH AMERICA,
   // TRACK 1.
@@ -161,7 +181,7 @@ void TrackReader::extractPacotsTracksFlex(const QStringList& lines)
     if(inRemark)
     {
       // End of remark - parse date =======================================
-      if(line.contains("</PRE>", Qt::CaseInsensitive) || PACOTS_TRACK_REGEXP.match(line).hasMatch())
+      if(line.contains("</PRE>", Qt::CaseInsensitive) || (line.startsWith("TRACK ") && PACOTS_TRACK_REGEXP.match(line).hasMatch()))
       {
         // ____________________________________ 1  2   3  4  5          6  7   8  9  10
         // RMK : ATM CENTER TEL:81-92-608-8870. 07 MAR 07:00 2020 UNTIL 07 MAR 21:00 2020. CREATED: 06 MAR 18:43 2020
@@ -201,7 +221,11 @@ void TrackReader::extractPacotsTracksFlex(const QStringList& lines)
     }
 
     // Beginning of track - "TRACK 1." - more than one per PRE element =======================================
-    QRegularExpressionMatch match = PACOTS_TRACK_REGEXP.match(line);
+    // Avoid regexp for the majority of lines
+    QRegularExpressionMatch match;
+    if(line.startsWith("TRACK "))
+      match = PACOTS_TRACK_REGEXP.match(line);
+
     if(match.hasMatch())
     {
       inRecord = true;
@@ -237,23 +261,17 @@ void TrackReader::extractPacotsTracksFlex(const QStringList& lines)
 
 void TrackReader::extractPacotsTracks(const QStringList& lines)
 {
-  static const QRegularExpression PACOT_NAME_REGEXP("^\\(TDM TRK (\\S+)");
   extractTracks(lines, PACOT_NAME_REGEXP, PACOTS, false /* removeEmpty */);
 }
 
 void TrackReader::extractAusotsTracks(const QStringList& lines)
 {
-  static const QRegularExpression AUSOT_NAME_REGEXP("^TDM TRK (\\S+)");
   extractTracks(lines, AUSOT_NAME_REGEXP, AUSOTS, true /* removeEmpty */);
 }
 
 void TrackReader::extractTracks(const QStringList& lines, const QRegularExpression& nameRegexp, TrackType type,
                                 bool removeEmpty)
 {
-  // 2003070500 2003072100
-  static const QRegularExpression DATE_REGEXP("(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d) "
-                                              "(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d)(\\d\\d)");
-
   // One track for each element. Validity date in second line.
   // (TDM TRK K 200307050001
   // 2003070500 2003072100
@@ -271,7 +289,11 @@ void TrackReader::extractTracks(const QStringList& lines, const QRegularExpressi
   for(const QString& line : lines)
   {
     // Match and extract name =======================================
-    QRegularExpressionMatch matchName = nameRegexp.match(line);
+    // Avoid regexp for the majority of lines
+    QRegularExpressionMatch matchName;
+    if(line.contains(QLatin1String("TDM TRK ")))
+      matchName = nameRegexp.match(line);
+
     if(matchName.hasMatch())
     {
       // (TDM TRK K 200307050001
@@ -340,10 +362,6 @@ void TrackReader::extractTracks(const QStringList& lines, const QRegularExpressi
 
 void TrackReader::extractNatTracks(const QStringList& lines)
 {
-  // MAR 08/0100Z TO MAR 08/0800Z
-  static const QRegularExpression NAT_DATE_REGEXP("^([A-Z]+) (\\d+)/(\\d\\d)(\\d\\d)Z TO "
-                                                  "([A-Z]+) (\\d+)/(\\d\\d)(\\d\\d)Z");
-
   // More than one track for each element. Validity date at the beginning.
   // <pre>
   // <font color="#000099">
@@ -417,7 +435,10 @@ void TrackReader::extractNatTracks(const QStringList& lines)
     else
     {
       // MAR 08/0100Z TO MAR 08/0800Z
-      QRegularExpressionMatch match = NAT_DATE_REGEXP.match(line);
+      QRegularExpressionMatch match;
+      if(line.contains(QLatin1String(" TO ")))
+        match = NAT_DATE_REGEXP.match(line);
+
       if(match.hasMatch())
       {
         QDateTime f = QDateTime(QDate(year, monthFromStr(match.captured(1)), match.captured(2).toInt()),
@@ -447,6 +468,20 @@ void TrackReader::extractNatTracks(const QStringList& lines)
   tracks.append(temp);
 }
 
+QStringList TrackReader::waypointIdents(const TrackVectorType& trackVector)
+{
+  QSet<QString> idents;
+  for(const Track& track : trackVector)
+  {
+    for(const QString& ident : track.route)
+      idents.insert(ident);
+  }
+
+  QStringList identList = idents.values();
+  identList.sort();
+  return identList;
+}
+
 int TrackReader::monthFromStr(const QString& str)
 {
   // Also allows full months
@@ -538,18 +573,16 @@ QStringList TrackReader::readLines(QTextStream& stream)
 
 QStringList TrackReader::toNatWaypoints(const QStringList& str)
 {
-  // "58/20" to "5820N"
-  static const QRegularExpression DEG("^(\\d\\d)/(\\d\\d)$");
-
-  // "5530/20" to "H5530".
-  static const QRegularExpression DEGH("^(\\d\\d)30/(\\d\\d)$");
-
   QStringList path(str);
 
   for(int i = 0; i < path.size(); i++)
   {
     QString& wp = path[i];
-    QRegularExpressionMatch match = DEG.match(wp);
+    if(!wp.contains('/'))
+      // Named waypoint
+      continue;
+
+    QRegularExpressionMatch match = NAT_DEG_REGEXP.match(wp);
     if(match.hasMatch())
     {
       // Whole degree waypoint ========
@@ -559,7 +592,7 @@ QStringList TrackReader::toNatWaypoints(const QStringList& str)
     }
     else
     {
-      match = DEGH.match(wp);
+      match = NAT_DEGH_REGEXP.match(wp);
       if(match.hasMatch())
       {
         // Half degree waypoint ========
@@ -66,6 +66,10 @@ public:
   int removeInvalid();
   static int removeInvalid(atools::track::TrackVectorType& trackVector);
 
+  /* Get sorted list of unique waypoint names of all tracks. Allows to resolve all waypoints against the
+   * navdata in one batch query instead of one query per track. */
+  static QStringList waypointIdents(const atools::track::TrackVectorType& trackVector);
+
 private:
   /* Read all lines from stream into a list. Lines are simplified and empty ones are dropped. */
   QStringList readLines(QTextStream& stream);
@@ -0,0 +1,109 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/arena.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace atools {
+namespace util {
+
+Q_DECL_CONSTEXPR size_t Arena::DEFAULT_BLOCK_SIZE;
+
+Arena::Arena(size_t blockSizeParam)
+  : blockSize(blockSizeParam)
+{
+}
+
+Arena::~Arena()
+{
+  clear();
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+  while(true)
+  {
+    // Look for space in the current block and in the ones kept by reset()
+    for(; currentBlock < blocks.size(); currentBlock++)
+    {
+      const Block& block = blocks.at(currentBlock);
+      std::uintptr_t start = reinterpret_cast<std::uintptr_t>(block.data) + offset;
+      std::uintptr_t aligned = (start + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+      size_t newOffset = static_cast<size_t>(aligned - reinterpret_cast<std::uintptr_t>(block.data)) + size;
+
+      if(newOffset <= block.size)
+      {
+        bytesUsed += newOffset - offset;
+        offset = newOffset;
+        return reinterpret_cast<void *>(aligned);
+      }
+      offset = 0;
+    }
+
+    // Add a new block which is large enough for oversized objects
+    size_t newSize = std::max(blockSize, size + alignment);
+    blocks.push_back({new char[newSize], newSize});
+    currentBlock = blocks.size() - 1;
+    offset = 0;
+  }
+}
+
+void Arena::freeLast(const void *ptr)
+{
+  if(currentBlock < blocks.size())
+  {
+    const Block& block = blocks.at(currentBlock);
+    const char *p = static_cast<const char *>(ptr);
+    if(p >= block.data && p < block.data + offset)
+    {
+      size_t newOffset = static_cast<size_t>(p - block.data);
+      bytesUsed -= offset - newOffset;
+      offset = newOffset;
+    }
+  }
+}
+
+void Arena::reset()
+{
+  currentBlock = 0;
+  offset = 0;
+  bytesUsed = 0;
+}
+
+void Arena::clear()
+{
+  for(const Block& block : blocks)
+    delete[] block.data;
+  blocks.clear();
+  reset();
+}
+
+size_t Arena::getBytesReserved() const
+{
+  size_t size = 0;
+  for(const Block& block : blocks)
+    size += block.size;
+  return size;
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_ARENA_H
+#define ATOOLS_UTIL_ARENA_H
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Monotonic memory arena. Allocates memory in large blocks and hands out pieces of them.
+ * Single objects cannot be freed and memory is given back at once by reset() or clear().
+ *
+ * Destructors of objects created in the arena are not called automatically.
+ * The caller has to call them before resetting the arena if needed.
+ *
+ * Not thread safe.
+ */
+class Arena
+{
+public:
+  static Q_DECL_CONSTEXPR size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+  explicit Arena(size_t blockSizeParam = DEFAULT_BLOCK_SIZE);
+  ~Arena();
+
+  Arena(const Arena& other) = delete;
+  Arena& operator=(const Arena& other) = delete;
+
+  /* Get uninitialized memory. Never returns null. */
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /* Construct an object in the arena using placement new */
+  template<typename TYPE, typename ... ARGS>
+  TYPE *create(ARGS&& ... args)
+  {
+    return new (allocate(sizeof(TYPE), alignof(TYPE)))TYPE(std::forward<ARGS>(args) ...);
+  }
+
+  /* Give back the memory of the last allocation. ptr has to be the last value returned by allocate().
+   * Used to drop objects which are discarded directly after creation. */
+  void freeLast(const void *ptr);
+
+  /* Make all memory available again but keep the blocks for reuse */
+  void reset();
+
+  /* Release all blocks */
+  void clear();
+
+  /* Memory handed out since the last reset */
+  size_t getBytesUsed() const
+  {
+    return bytesUsed;
+  }
+
+  /* Memory held by all blocks */
+  size_t getBytesReserved() const;
+
+private:
+  struct Block
+  {
+    char *data;
+    size_t size;
+  };
+
+  size_t blockSize;
+  std::vector<Block> blocks;
+
+  /* Index into blocks and offset into the current block */
+  size_t currentBlock = 0, offset = 0, bytesUsed = 0;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_ARENA_H
@@ -0,0 +1,184 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_ASYNCPIPELINE_H
+#define ATOOLS_UTIL_ASYNCPIPELINE_H
+
+#include "util/hotswap.h"
+#include "util/tracing.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QVector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Runs the stages between a finished download and a usable index in a background thread and delivers the
+ * immutable result back to the thread of the context object.
+ *
+ * Byte stages like decompression modify the data in place in the order added. The build stage parses the
+ * final data and returns the new object which is published by a single pointer swap in the underlying HotSwap.
+ * Results of a download are dropped if a newer one was passed to process() or cancel() was called meanwhile.
+ * Each stage is recorded as a trace span in category "pipeline".
+ *
+ * Example:
+ * pipeline = new AsyncPipeline<QByteArray>(this);
+ * pipeline->addStage("gzip", [](QByteArray& data) {
+ *   data = atools::zip::gzipDecompressIf(data, Q_FUNC_INFO);
+ * });
+ * pipeline->setBuildStage("metar", [](const QByteArray& data) {
+ *   return std::make_shared<QByteArray>(data);
+ * });
+ * pipeline->setDelivered([this](std::shared_ptr<const QByteArray> result) {
+ *   // Called in the thread of this
+ * });
+ * ...
+ * pipeline->process(downloadedData);
+ *
+ * The stages run in a single worker thread and must not use objects which are not thread safe like the
+ * default database connection. The pipeline has to be owned by the context object, i.e. be a member or deleted
+ * in its destructor, so that no delivery is pending after destruction. Not copyable.
+ */
+template<typename RESULT>
+class AsyncPipeline
+{
+public:
+  /* Modifies the data in place */
+  typedef std::function<void(QByteArray& data)> StageType;
+
+  /* Creates the final object from the data. Return null to keep the current object. */
+  typedef std::function<std::shared_ptr<RESULT>(const QByteArray& data)> BuildType;
+
+  /* Called in the thread of the context object for each published result */
+  typedef std::function<void(std::shared_ptr<const RESULT> result)> DeliveredType;
+
+  explicit AsyncPipeline(QObject *contextParam)
+    : context(contextParam)
+  {
+  }
+
+  ~AsyncPipeline()
+  {
+    cancel();
+    swap.waitForDone();
+  }
+
+  AsyncPipeline(const AsyncPipeline& other) = delete;
+  AsyncPipeline& operator=(const AsyncPipeline& other) = delete;
+
+  /* Append a byte stage. Name has to be a string literal. */
+  void addStage(const char *name, const StageType& stage)
+  {
+    stages.append(Stage({name, stage}));
+  }
+
+  /* Set the stage producing the result. Name has to be a string literal. */
+  void setBuildStage(const char *name, const BuildType& build)
+  {
+    buildName = name;
+    buildStage = build;
+  }
+
+  void setDelivered(const DeliveredType& value)
+  {
+    delivered = value;
+  }
+
+  /* Run all stages on the data in the background. Data is implicitly shared and not copied. */
+  void process(const QByteArray& data)
+  {
+    int gen = ++generation;
+    QVector<Stage> stagesCopy(stages);
+    const char *buildNameCopy = buildName;
+    BuildType buildCopy(buildStage);
+
+    swap.reload([gen, data, stagesCopy, buildNameCopy, buildCopy, this]() -> std::shared_ptr<RESULT> {
+      QByteArray bytes(data);
+      for(const Stage& stage : stagesCopy)
+      {
+        if(gen != generation)
+          return std::shared_ptr<RESULT>();
+
+        ATOOLS_TRACE_SPAN("pipeline", stage.name);
+        stage.function(bytes);
+      }
+
+      if(gen != generation || !buildCopy)
+        return std::shared_ptr<RESULT>();
+
+      ATOOLS_TRACE_SPAN("pipeline", buildNameCopy);
+      Q_UNUSED(buildNameCopy)
+      return buildCopy(bytes);
+    }, [gen, this](bool published) -> void {
+      if(published && delivered)
+      {
+        std::shared_ptr<const RESULT> result = swap.get();
+        DeliveredType deliveredCopy(delivered);
+
+        // Deliver in the context thread
+        QMetaObject::invokeMethod(context, [gen, result, deliveredCopy, this]() -> void {
+          if(gen == generation)
+            deliveredCopy(result);
+        }, Qt::QueuedConnection);
+      }
+    });
+  }
+
+  /* Last published result. Null if nothing was delivered yet. Thread safe. */
+  std::shared_ptr<const RESULT> get() const
+  {
+    return swap.get();
+  }
+
+  /* Drop results of running or pending downloads */
+  void cancel()
+  {
+    generation++;
+    swap.cancel();
+  }
+
+  /* Wait until all pending stages are done */
+  void waitForDone()
+  {
+    swap.waitForDone();
+  }
+
+private:
+  struct Stage
+  {
+    const char *name;
+    StageType function;
+  };
+
+  QVector<Stage> stages;
+  const char *buildName = "build";
+  BuildType buildStage;
+  DeliveredType delivered;
+
+  /* Incremented by process and cancel. Stale results are neither published nor delivered. */
+  std::atomic_int generation{0};
+
+  QObject *context;
+  atools::util::HotSwap<RESULT> swap;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_ASYNCPIPELINE_H
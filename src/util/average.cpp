@@ -66,15 +66,39 @@ void MovingAverageTime::startSamples(qint64 timestampMs)
   beforeFirstTimestampMs = timestampMs;
 }
 
+void MovingAverageTime::append(const Sample& sample)
+{
+  if(count == samples.size())
+  {
+    // Full - double size and unwrap
+    QVector<Sample> newSamples(std::max(samples.size() * 2, 16));
+    for(int i = 0; i < count; i++)
+      newSamples[i] = sampleAt(i);
+    samples.swap(newSamples);
+    head = 0;
+  }
+
+  samples[(head + count) & (samples.size() - 1)] = sample;
+  count++;
+}
+
+MovingAverageTime::Sample MovingAverageTime::takeFirst()
+{
+  Sample first = samples.at(head);
+  head = (head + 1) & (samples.size() - 1);
+  count--;
+  return first;
+}
+
 void atools::util::MovingAverageTime::addSamples(float value1, float value2, qint64 timestampMs)
 {
-  if(samples.isEmpty())
+  if(count == 0)
     beforeFirstTimestampMs = timestampMs;
 
   // Check for oldest entries and remove if needed
-  while(!samples.isEmpty() && beforeFirstTimestampMs < samples.constLast().timestamp - timeRangeMs)
+  while(count > 0 && beforeFirstTimestampMs < last().timestamp - timeRangeMs)
   {
-    Sample first = samples.takeFirst();
+    Sample first = takeFirst();
 
     // Adjust total by removing this weighted value
     qint64 diff = first.timestamp - beforeFirstTimestampMs;
@@ -86,7 +110,7 @@ void atools::util::MovingAverageTime::addSamples(float value1, float value2, qin
   }
 
   // Add new value and update totals with weighted value
-  qint64 duration = timestampMs - (samples.isEmpty() ? beforeFirstTimestampMs : samples.constLast().timestamp);
+  qint64 duration = timestampMs - (count == 0 ? beforeFirstTimestampMs : last().timestamp);
 
   if(duration < 0L)
   {
@@ -98,7 +122,23 @@ void atools::util::MovingAverageTime::addSamples(float value1, float value2, qin
   {
     total1 += value1 * duration;
     total2 += value2 * duration;
-    samples.append(Sample(value1, value2, timestampMs));
+
+    if(minSampleIntervalMs > 0L && count > 0 && timestampMs - lastStartTimestamp() < minSampleIntervalMs)
+    {
+      // Decimate - merge into last sample by using weighted values over the combined duration
+      Sample& lastSample = last();
+      qint64 lastDuration = lastSample.timestamp - lastStartTimestamp();
+      qint64 mergedDuration = lastDuration + duration;
+
+      if(mergedDuration > 0L)
+      {
+        lastSample.value1 = (lastSample.value1 * lastDuration + value1 * duration) / mergedDuration;
+        lastSample.value2 = (lastSample.value2 * lastDuration + value2 * duration) / mergedDuration;
+      }
+      lastSample.timestamp = timestampMs;
+    }
+    else
+      append(Sample(value1, value2, timestampMs));
   }
 }
 
@@ -111,10 +151,10 @@ void atools::util::MovingAverageTime::getAverages(float& average1, float& averag
 {
   average1 = average2 = 0.f;
 
-  if(samples.isEmpty())
+  if(count == 0)
     return;
 
-  qint64 totalDuration = samples.constLast().timestamp - beforeFirstTimestampMs;
+  qint64 totalDuration = last().timestamp - beforeFirstTimestampMs;
 
   if(totalDuration > 0)
   {
@@ -130,10 +170,10 @@ void atools::util::MovingAverageTime::getAverages(float& average1, float& averag
 
 float MovingAverageTime::getAverage1() const
 {
-  if(samples.isEmpty())
+  if(count == 0)
     return 0.f;
 
-  qint64 totalDuration = samples.constLast().timestamp - beforeFirstTimestampMs;
+  qint64 totalDuration = last().timestamp - beforeFirstTimestampMs;
 
   if(totalDuration > 0)
     return total1 / totalDuration;
@@ -143,10 +183,10 @@ float MovingAverageTime::getAverage1() const
 
 float MovingAverageTime::getAverage2() const
 {
-  if(samples.isEmpty())
+  if(count == 0)
     return 0.f;
 
-  qint64 totalDuration = samples.constLast().timestamp - beforeFirstTimestampMs;
+  qint64 totalDuration = last().timestamp - beforeFirstTimestampMs;
 
   if(totalDuration > 0)
     return total2 / totalDuration;
@@ -156,7 +196,7 @@ float MovingAverageTime::getAverage2() const
 
 void MovingAverageTime::debugDumpContainerSizes() const
 {
-  qDebug() << Q_FUNC_INFO << "samples.size()" << samples.size();
+  qDebug() << Q_FUNC_INFO << "count" << count << "samples.size()" << samples.size();
 }
 
 } // namespace util
@@ -18,7 +18,6 @@
 #ifndef ATOOLS_AVERAGE_H
 #define ATOOLS_AVERAGE_H
 
-#include <QList>
 #include <QVector>
 
 namespace atools {
@@ -47,6 +46,12 @@ private:
 
 /*
  * Calculate moving average over a time series for two values.
+ *
+ * Samples are kept in a ring buffer which is only resized when growing. Adding and expiring samples is O(1)
+ * and does not allocate memory once the buffer has reached the size needed for the time range.
+ *
+ * A minimum sample interval can be set to decimate high rate input. Samples arriving faster are merged into
+ * the last stored sample keeping the weighted totals exact.
  */
 class MovingAverageTime
 {
@@ -72,16 +77,28 @@ public:
   float getAverage1() const;
   float getAverage2() const;
 
+  /* Keeps allocated buffer */
   void reset()
   {
-    samples.clear();
+    head = count = 0;
     total1 = total2 = 0.f;
     beforeFirstTimestampMs = 0L;
   }
 
   int size() const
   {
-    return samples.size();
+    return count;
+  }
+
+  /* Samples closer than this to the last stored sample are merged into it. 0 disables decimation. */
+  void setMinSampleIntervalMs(qint64 value)
+  {
+    minSampleIntervalMs = value;
+  }
+
+  qint64 getMinSampleIntervalMs() const
+  {
+    return minSampleIntervalMs;
   }
 
   /* Print the size of all container classes to detect overflow or memory leak conditions */
@@ -103,8 +120,37 @@ public:
   };
 
 private:
-  qint64 timeRangeMs, beforeFirstTimestampMs = 0L;
-  QList<Sample> samples;
+  /* Index relative to oldest sample */
+  const Sample& sampleAt(int index) const
+  {
+    return samples.at((head + index) & (samples.size() - 1));
+  }
+
+  Sample& last()
+  {
+    return samples[(head + count - 1) & (samples.size() - 1)];
+  }
+
+  const Sample& last() const
+  {
+    return sampleAt(count - 1);
+  }
+
+  /* Timestamp where the duration of the last sample starts */
+  qint64 lastStartTimestamp() const
+  {
+    return count > 1 ? sampleAt(count - 2).timestamp : beforeFirstTimestampMs;
+  }
+
+  void append(const Sample& sample);
+  Sample takeFirst();
+
+  qint64 timeRangeMs, beforeFirstTimestampMs = 0L, minSampleIntervalMs = 0L;
+
+  /* Ring buffer. Size is always a power of two. */
+  QVector<Sample> samples;
+  int head = 0, count = 0;
+
   float total1 = 0.f, total2 = 0.f;
 };
 
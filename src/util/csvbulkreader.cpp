@@ -0,0 +1,343 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/csvbulkreader.h"
+
+#include "io/linereader.h"
+#include "util/parallel.h"
+#include "util/str.h"
+
+#include <QFile>
+#include <QString>
+
+#include <algorithm>
+#include <cstring>
+
+namespace atools {
+namespace util {
+
+/* Records per thread below which splitting is done in one thread */
+static const int MIN_RECORDS_PER_THREAD = 2000;
+
+CsvBulkReader::CsvBulkReader(char separatorChar, char escapeChar, bool trimValues)
+  : separator(separatorChar), escape(escapeChar), trim(trimValues)
+{
+
+}
+
+CsvBulkReader::~CsvBulkReader()
+{
+  close();
+}
+
+bool CsvBulkReader::read(QFile *file)
+{
+  close();
+
+  qint64 fileSize = file->size();
+  if(fileSize > 0)
+  {
+    mapped = file->map(0, fileSize);
+    if(mapped != nullptr)
+    {
+      mappedFile = file;
+      init(reinterpret_cast<const char *>(mapped), fileSize);
+      return true;
+    }
+
+    // Fall back to reading all
+    if(file->seek(0))
+    {
+      loaded = file->readAll();
+      init(loaded.constData(), loaded.size());
+      return file->error() == QFileDevice::NoError;
+    }
+    return false;
+  }
+
+  init(nullptr, 0);
+  return true;
+}
+
+void CsvBulkReader::read(const QByteArray& dataParam)
+{
+  close();
+  init(dataParam.constData(), dataParam.size());
+}
+
+void CsvBulkReader::init(const char *dataParam, qint64 sizeParam)
+{
+  data = dataParam;
+  size = sizeParam;
+  splitRecords();
+  splitValues();
+}
+
+void CsvBulkReader::close()
+{
+  if(mapped != nullptr && mappedFile != nullptr && mappedFile->isOpen())
+    mappedFile->unmap(mapped);
+  mapped = nullptr;
+  mappedFile = nullptr;
+  loaded.clear();
+  records.clear();
+  values.clear();
+  data = nullptr;
+  size = 0;
+}
+
+void CsvBulkReader::splitRecords()
+{
+  if(data == nullptr || size == 0)
+    return;
+
+  const char *pos = data, *end = data + size;
+
+  // Skip UTF-8 BOM
+  if(size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    pos += 3;
+
+  int lineNum = 1;
+  while(pos < end)
+  {
+    const char *start = pos;
+    int startLineNum = lineNum;
+    bool inEscape = false;
+
+    // Read lines until a line feed outside of an escaped field is found
+    const char *lineFeed = nullptr;
+    while(true)
+    {
+      lineFeed = static_cast<const char *>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+      const char *lineEnd = lineFeed != nullptr ? lineFeed : end;
+
+      // Each escape character toggles the state - also for doubled ones
+      if(escape != '\0' && (std::count(pos, lineEnd, escape) & 1))
+        inEscape = !inEscape;
+
+      pos = lineEnd;
+      if(lineFeed == nullptr || !inEscape)
+        break;
+
+      // Line feed is part of the escaped field
+      pos++;
+      lineNum++;
+    }
+
+    const char *recordEnd = pos;
+    if(recordEnd > start && recordEnd[-1] == '\r')
+      recordEnd--;
+
+    records.append({start, static_cast<int>(recordEnd - start), startLineNum, 0, 0});
+
+    if(lineFeed != nullptr)
+    {
+      // Skip line feed
+      pos++;
+      lineNum++;
+    }
+  }
+}
+
+void CsvBulkReader::splitValues()
+{
+  int numRecords = records.size();
+  int chunks = parallelChunks(numRecords, numThreads, MIN_RECORDS_PER_THREAD);
+
+  // Values and first record for each chunk
+  QVector<QVector<Value> > chunkValues(chunks);
+  QVector<int> chunkBegin(chunks, numRecords);
+
+  // Detach once before accessing from threads
+  Record *recordData = records.data();
+  QVector<Value> *chunkValueData = chunkValues.data();
+  int *chunkBeginData = chunkBegin.data();
+
+  parallelFor(numRecords, chunks, [this, recordData, chunkValueData, chunkBeginData](int begin, int end, int chunk) -> void {
+    chunkBeginData[chunk] = begin;
+    for(int i = begin; i < end; i++)
+      tokenize(recordData[i], chunkValueData[chunk]);
+  }, MIN_RECORDS_PER_THREAD);
+
+  // Join values and fix indexes
+  int numValues = 0;
+  for(const QVector<Value>& valueList : chunkValues)
+    numValues += valueList.size();
+  values.reserve(numValues);
+
+  for(int chunk = 0; chunk < chunks; chunk++)
+  {
+    int end = chunk + 1 < chunks ? chunkBegin.at(chunk + 1) : numRecords;
+    for(int i = chunkBegin.at(chunk); i < end; i++)
+      recordData[i].firstValue += values.size();
+    values.append(chunkValues.at(chunk));
+  }
+}
+
+void CsvBulkReader::tokenize(Record& record, QVector<Value>& valueList) const
+{
+  record.firstValue = valueList.size();
+  record.numValues = 0;
+
+  if(record.size == 0)
+    return;
+
+  const char *pos = record.data, *end = record.data + record.size, *start = pos;
+  bool inEscape = false, escaped = false;
+
+  // Search for separator only if escaping is disabled
+  char escapeOrSeparator = escape != '\0' ? escape : separator;
+
+  while(true)
+  {
+    // Skip regular characters
+    pos = scan::findFirstOf(pos, end, separator, escapeOrSeparator);
+
+    if(pos == end || (*pos == separator && !inEscape))
+    {
+      const char *valueBegin = start, *valueEnd = pos;
+
+      // Trim only text without escape characters
+      if(trim && !escaped)
+        scan::trim(valueBegin, valueEnd);
+
+      valueList.append({valueBegin, static_cast<int>(valueEnd - valueBegin), escaped});
+      record.numValues++;
+
+      if(pos == end)
+        break;
+
+      start = ++pos;
+      escaped = false;
+      continue;
+    }
+
+    if(escape != '\0' && *pos == escape)
+    {
+      inEscape = !inEscape;
+      escaped = true;
+    }
+    pos++;
+  }
+}
+
+const CsvBulkReader::Value *CsvBulkReader::value(int record, int index) const
+{
+  const Record& rec = records.at(record);
+  if(index >= 0 && index < rec.numValues)
+    return &values.at(rec.firstValue + index);
+  else
+    return nullptr;
+}
+
+QString CsvBulkReader::getLine(int record) const
+{
+  QString line;
+  atools::io::LineReader::toString(getLineBytes(record), line);
+  return line;
+}
+
+QByteArray CsvBulkReader::getLineBytes(int record) const
+{
+  const Record& rec = records.at(record);
+  return QByteArray::fromRawData(rec.data, rec.size);
+}
+
+QString CsvBulkReader::getString(int record, int index) const
+{
+  QString str;
+  atools::io::LineReader::toString(getBytes(record, index), str);
+  return str;
+}
+
+QByteArray CsvBulkReader::getBytes(int record, int index) const
+{
+  const Value *val = value(record, index);
+  if(val == nullptr)
+    return QByteArray();
+
+  if(!val->escaped)
+    // Does not copy
+    return QByteArray::fromRawData(val->data, val->size);
+
+  // Remove escape characters using the same rules as CsvReader
+  QByteArray bytes;
+  bytes.reserve(val->size);
+  bool inEscape = false;
+  char lastChar = separator;
+  for(int i = 0; i < val->size; i++)
+  {
+    char c = val->data[i];
+    if(c == escape)
+    {
+      if(inEscape)
+        // End of escaped text
+        inEscape = false;
+      else
+      {
+        if(lastChar == escape)
+          // Escape char itself doubled "" - add single escape
+          bytes.append(c);
+        inEscape = true;
+      }
+    }
+    else if(!(c == '\r' && i + 1 < val->size && val->data[i + 1] == '\n'))
+      // Regular character - line feeds in escaped text are normalized to "\n"
+      bytes.append(c);
+    lastChar = c;
+  }
+  return bytes;
+}
+
+bool CsvBulkReader::isEmpty(int record, int index) const
+{
+  const Value *val = value(record, index);
+  if(val == nullptr || val->size == 0)
+    return true;
+
+  return val->escaped ? getBytes(record, index).isEmpty() : false;
+}
+
+float CsvBulkReader::getFloat(int record, int index, bool *ok) const
+{
+  bool valid = false;
+  float num = getBytes(record, index).toFloat(&valid);
+  if(ok != nullptr)
+    *ok = valid;
+  return valid ? num : 0.f;
+}
+
+double CsvBulkReader::getDouble(int record, int index, bool *ok) const
+{
+  bool valid = false;
+  double num = getBytes(record, index).toDouble(&valid);
+  if(ok != nullptr)
+    *ok = valid;
+  return valid ? num : 0.;
+}
+
+int CsvBulkReader::getInt(int record, int index, bool *ok) const
+{
+  bool valid = false;
+  int num = getBytes(record, index).toInt(&valid);
+  if(ok != nullptr)
+    *ok = valid;
+  return valid ? num : 0;
+}
+
+} // namespace util
+} // namespace atools
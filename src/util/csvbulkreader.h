@@ -0,0 +1,155 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_CSVBULKREADER_H
+#define ATOOLS_UTIL_CSVBULKREADER_H
+
+#include <QByteArray>
+#include <QVector>
+
+class QFile;
+class QString;
+
+namespace atools {
+namespace util {
+
+/*
+ * Reads whole CSV files for bulk imports. Uses the same rules for escaping and trimming as CsvReader but works
+ * on UTF-8 bytes of a mapped file instead of decoding each line into a QString.
+ *
+ * The file is split into records in one sequential byte scan. A record is a line or more lines if a line feed is
+ * within an escaped field. All records are then split into values in parallel using parallelFor.
+ *
+ * Values reference the mapped memory and are converted only when accessed. Numbers are read directly from the
+ * bytes. Values are valid as long as the reader and the file or byte array exist.
+ *
+ * All get methods are const and can be called from several threads at once.
+ */
+class CsvBulkReader
+{
+public:
+  /* Separator and escape have to be ASCII characters. escapeChar '\0' disables escaping. trimValues: Trims only
+   * text which is not escaped. */
+  CsvBulkReader(char separatorChar = ',', char escapeChar = '"', bool trimValues = true);
+  ~CsvBulkReader();
+
+  CsvBulkReader(const CsvBulkReader& other) = delete;
+  CsvBulkReader& operator=(const CsvBulkReader& other) = delete;
+
+  /* Map an open file or read it into memory if mapping fails and split it into records and values.
+   * File has to stay open while accessing values. Returns false if the file could not be read. */
+  bool read(QFile *file);
+
+  /* Split data into records and values. data has to exist while accessing values. */
+  void read(const QByteArray& data);
+
+  /* Threads used for splitting into values. 0 uses the number of cores. */
+  void setNumThreads(int value)
+  {
+    numThreads = value;
+  }
+
+  /* Number of records including empty lines */
+  int getNumRecords() const
+  {
+    return records.size();
+  }
+
+  /* Line number of the first line of a record starting with 1 */
+  int getLineNumber(int record) const
+  {
+    return records.at(record).lineNum;
+  }
+
+  /* true if the record is an empty line */
+  bool isEmpty(int record) const
+  {
+    return records.at(record).size == 0;
+  }
+
+  /* Full unchanged record text as used in error messages. Contains all lines of a multi line record. */
+  QString getLine(int record) const;
+
+  /* Same as getLine() but without conversion */
+  QByteArray getLineBytes(int record) const;
+
+  /* Number of values in record */
+  int getNumValues(int record) const
+  {
+    return records.at(record).numValues;
+  }
+
+  /* Unescaped and trimmed value. Returns an empty string if index is out of range. */
+  QString getString(int record, int index) const;
+
+  /* Unescaped and trimmed value as UTF-8. Does not copy if the value does not contain escape characters. */
+  QByteArray getBytes(int record, int index) const;
+
+  /* true if value is empty or index is out of range */
+  bool isEmpty(int record, int index) const;
+
+  /* Convert value to number. Returns 0 if the value is empty, out of range or not a valid number.
+   * ok is set to false in these cases if given. */
+  float getFloat(int record, int index, bool *ok = nullptr) const;
+  double getDouble(int record, int index, bool *ok = nullptr) const;
+  int getInt(int record, int index, bool *ok = nullptr) const;
+
+private:
+  struct Value
+  {
+    const char *data;
+    int size;
+
+    /* Contains escape characters which have to be removed on access */
+    bool escaped;
+  };
+
+  struct Record
+  {
+    const char *data;
+    int size, lineNum, firstValue, numValues;
+  };
+
+  void init(const char *dataParam, qint64 sizeParam);
+  void splitRecords();
+  void splitValues();
+  void tokenize(Record& record, QVector<Value>& valueList) const;
+  void close();
+
+  const Value *value(int record, int index) const;
+
+  /* Configuration */
+  char separator = ',', escape = '"';
+  bool trim = true;
+  int numThreads = 0;
+
+  QVector<Record> records;
+  QVector<Value> values;
+
+  /* Mapped or loaded file */
+  QFile *mappedFile = nullptr;
+  uchar *mapped = nullptr;
+  QByteArray loaded;
+
+  const char *data = nullptr;
+  qint64 size = 0;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_CSVBULKREADER_H
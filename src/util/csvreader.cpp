@@ -17,6 +17,8 @@
 
 #include "util/csvreader.h"
 
+#include "util/str.h"
+
 namespace atools {
 namespace util {
 
@@ -45,9 +47,21 @@ void CsvReader::readCsvLine(const QString& line)
     // In escape - add e new line
     curValue += "\n";
 
-  for(int i = 0; i < line.size(); i++)
+  const QChar *pos = line.constData(), *end = pos + line.size();
+  for(; pos < end; pos++)
   {
-    curChar = line.at(i);
+    // Copy all regular characters up to the next separator or escape at once
+    const QChar *next = scan::findFirstOf(pos, end, separator, escape);
+    if(next > pos)
+    {
+      curValue.append(pos, static_cast<int>(next - pos));
+      lastChar = curChar = next[-1];
+      pos = next;
+      if(pos == end)
+        break;
+    }
+
+    curChar = *pos;
 
     if(curChar == escape)
     {
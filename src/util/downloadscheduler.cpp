@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/downloadscheduler.h"
+
+#include "util/httpdownloader.h"
+
+#include <QDebug>
+#include <QRandomGenerator>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+DownloadScheduler::DownloadScheduler(QObject *parent, int maxConcurrentRequests, bool verboseLogging)
+  : QObject(parent), maxConcurrent(std::max(maxConcurrentRequests, 1)), verbose(verboseLogging)
+{
+}
+
+DownloadScheduler::~DownloadScheduler()
+{
+  queue.clear();
+  running.clear();
+}
+
+void DownloadScheduler::setMaxConcurrentRequests(int value)
+{
+  maxConcurrent = std::max(value, 1);
+  startNext();
+}
+
+void DownloadScheduler::enqueue(HttpDownloader *downloader, int priority)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << downloader->getUrl() << "priority" << priority
+             << "running" << running.size() << "queued" << queue.size();
+
+  queue.append({downloader, priority, nextSequence++});
+  startNext();
+}
+
+void DownloadScheduler::release(HttpDownloader *downloader)
+{
+  if(running.removeOne(downloader))
+    startNext();
+  else
+  {
+    for(int i = 0; i < queue.size(); i++)
+    {
+      if(queue.at(i).downloader == downloader)
+      {
+        queue.remove(i);
+        break;
+      }
+    }
+  }
+}
+
+void DownloadScheduler::startNext()
+{
+  while(running.size() < maxConcurrent && !queue.isEmpty())
+  {
+    // Find highest priority and lowest sequence number - queue is short
+    int best = -1;
+    for(int i = 0; i < queue.size(); i++)
+    {
+      const QueueEntry& entry = queue.at(i);
+      if(entry.downloader.isNull())
+        continue;
+
+      if(best == -1 || entry.priority > queue.at(best).priority ||
+         (entry.priority == queue.at(best).priority && entry.sequence < queue.at(best).sequence))
+        best = i;
+    }
+
+    if(best == -1)
+    {
+      // Only deleted downloaders left
+      queue.clear();
+      break;
+    }
+
+    HttpDownloader *downloader = queue.at(best).downloader.data();
+    queue.remove(best);
+    running.append(downloader);
+
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Starting" << downloader->getUrl();
+
+    downloader->startRequest();
+  }
+}
+
+int DownloadScheduler::jitter(int intervalMs) const
+{
+  if(jitterPercent > 0 && intervalMs > 0)
+  {
+    int range = static_cast<int>(static_cast<qint64>(intervalMs) * jitterPercent / 100);
+    if(range > 0)
+      return intervalMs + QRandomGenerator::global()->bounded(-range, range + 1);
+  }
+  return intervalMs;
+}
+
+void DownloadScheduler::debugDumpContainerSizes() const
+{
+  qDebug() << Q_FUNC_INFO << "queue.size()" << queue.size() << "running.size()" << running.size();
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,127 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_DOWNLOADSCHEDULER_H
+#define ATOOLS_DOWNLOADSCHEDULER_H
+
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QVector>
+
+namespace atools {
+namespace util {
+
+class HttpDownloader;
+
+/*
+ * Shared scheduler for HttpDownloader instances.
+ *
+ * Provides one network manager for all attached downloaders which allows to reuse connections (keep-alive and
+ * HTTP/2 multiplexing) instead of doing a new TLS handshake for each downloader.
+ * Limits the number of concurrent requests. Further requests are queued and started by priority and then in order
+ * of arrival when a running request finishes.
+ * Periodic downloads of attached downloaders get a random jitter to spread requests over time.
+ *
+ * Attach downloaders using HttpDownloader::setScheduler(). The scheduler has to be used in the main thread.
+ */
+class DownloadScheduler :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit DownloadScheduler(QObject *parent, int maxConcurrentRequests = 4, bool verboseLogging = false);
+  virtual ~DownloadScheduler() override;
+
+  DownloadScheduler(const DownloadScheduler& other) = delete;
+  DownloadScheduler& operator=(const DownloadScheduler& other) = delete;
+
+  /* Network manager shared by all downloaders */
+  QNetworkAccessManager *getNetworkManager()
+  {
+    return &networkManager;
+  }
+
+  int getMaxConcurrentRequests() const
+  {
+    return maxConcurrent;
+  }
+
+  /* Starts queued requests if the limit was raised */
+  void setMaxConcurrentRequests(int value);
+
+  /* Random deviation in percent which is applied to update periods. 0 disables jitter. Default is 10 percent. */
+  void setJitterPercent(int value)
+  {
+    jitterPercent = value;
+  }
+
+  int getJitterPercent() const
+  {
+    return jitterPercent;
+  }
+
+  /* Number of running and waiting requests */
+  int getNumRunning() const
+  {
+    return running.size();
+  }
+
+  int getNumQueued() const
+  {
+    return queue.size();
+  }
+
+  /* Print the size of all container classes to detect overflow or memory leak conditions */
+  void debugDumpContainerSizes() const;
+
+private:
+  friend class HttpDownloader;
+
+  /* Queue request of downloader. HttpDownloader::startRequest() is called when a slot is free.
+   * Higher priority values are started first. */
+  void enqueue(HttpDownloader *downloader, int priority);
+
+  /* Remove downloader from queue or running list and start the next waiting request */
+  void release(HttpDownloader *downloader);
+
+  /* Add jitter to interval */
+  int jitter(int intervalMs) const;
+
+  /* Start waiting requests until limit is reached */
+  void startNext();
+
+  struct QueueEntry
+  {
+    QPointer<HttpDownloader> downloader;
+    int priority;
+    quint64 sequence;
+  };
+
+  QNetworkAccessManager networkManager;
+  QVector<QueueEntry> queue;
+  QVector<HttpDownloader *> running;
+
+  int maxConcurrent, jitterPercent = 10;
+  quint64 nextSequence = 0;
+  bool verbose;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_DOWNLOADSCHEDULER_H
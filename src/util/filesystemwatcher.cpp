@@ -19,6 +19,7 @@
 
 #include "atools.h"
 
+#include <QDirIterator>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
 
@@ -36,6 +37,7 @@ FileSystemWatcher::FileSystemWatcher(QObject *parent, bool verboseLogging)
 {
   qDebug() << Q_FUNC_INFO;
 
+  clock.start();
   delayTimer.setSingleShot(true);
   QTimer::connect(&delayTimer, &QTimer::timeout, this, &FileSystemWatcher::pathUpdatedDelayed);
 }
@@ -52,6 +54,9 @@ void FileSystemWatcher::stopWatching()
   deleteFsWatcher();
   paths.clear();
   changedPathIndexes.clear();
+  dirIndex = -1;
+  dirEntries.clear();
+  subdirs.clear();
 }
 
 void FileSystemWatcher::pathChanged()
@@ -93,7 +98,7 @@ void FileSystemWatcher::pathChanged()
               qDebug() << Q_FUNC_INFO << "=== File changed" << info.path;
 
             // Start or extend the delayed notification
-            changedPathIndexes.insert(i);
+            changedPathIndexes.insert(i, clock.elapsed());
           }
           else
           {
@@ -116,7 +121,7 @@ void FileSystemWatcher::pathChanged()
           if(verbose)
             qDebug() << Q_FUNC_INFO << "=== Dir changed" << info.path;
           // Start or extend the delayed notification
-          changedPathIndexes.insert(i);
+          changedPathIndexes.insert(i, clock.elapsed());
         }
         else
         {
@@ -153,6 +158,18 @@ void FileSystemWatcher::pathChanged()
   setPathsToFsWatcher(true);
 }
 
+void FileSystemWatcher::dirChanged(const QString& path)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << path;
+
+  // Changes in subdirectories do not modify the timestamp of the watched directory
+  if(dirIndex != -1 && path != paths.at(dirIndex).path)
+    changedPathIndexes.insert(dirIndex, clock.elapsed());
+
+  pathChanged();
+}
+
 void FileSystemWatcher::pathUpdatedDelayed()
 {
   if(verbose)
@@ -160,8 +177,20 @@ void FileSystemWatcher::pathUpdatedDelayed()
 
   // Collect existing changed files and the parent directory if changed
   QStringList updatedFiles, updatedDirs;
-  for(int index : qAsConst(changedPathIndexes))
+  qint64 now = clock.elapsed(), nextDelay = -1;
+  for(auto it = changedPathIndexes.begin(); it != changedPathIndexes.end();)
   {
+    int index = it.key();
+    if(now - it.value() < delayMs)
+    {
+      // Path was changed again recently - wait until it is quiet for the whole delay
+      qint64 remaining = delayMs - (now - it.value());
+      nextDelay = nextDelay == -1 ? remaining : std::min(nextDelay, remaining);
+      ++it;
+      continue;
+    }
+    it = changedPathIndexes.erase(it);
+
     if(!atools::inRange(paths, index))
     {
       if(warn())
@@ -194,13 +223,20 @@ void FileSystemWatcher::pathUpdatedDelayed()
         qWarning() << Q_FUNC_INFO << "File" << info.path << "does not exist";
     }
   }
-  changedPathIndexes.clear();
 
   if(!updatedDirs.isEmpty())
   {
-    if(verbose)
-      qDebug() << Q_FUNC_INFO << "Updated dirs" << updatedDirs;
-    emit dirUpdated(updatedDirs.first());
+    // Report directory only if files were added or removed
+    QStringList added, removed;
+    if(updateDirEntries(added, removed))
+    {
+      if(verbose)
+        qDebug() << Q_FUNC_INFO << "Updated dirs" << updatedDirs << "added" << added << "removed" << removed;
+      emit dirEntriesChanged(updatedDirs.constFirst(), added, removed);
+      emit dirUpdated(updatedDirs.constFirst());
+    }
+    else if(verbose)
+      qDebug() << Q_FUNC_INFO << "No files added or removed in" << updatedDirs;
   }
 
   if(!updatedFiles.isEmpty())
@@ -211,8 +247,66 @@ void FileSystemWatcher::pathUpdatedDelayed()
     emit filesUpdated(updatedFiles);
   }
 
-  // pathChanged()
-  periodicCheckTimer.start(checkMs);
+  if(nextDelay != -1)
+    // Wait for paths which are still changing
+    delayTimer.start(static_cast<int>(nextDelay));
+  else
+    // pathChanged()
+    periodicCheckTimer.start(checkMs);
+}
+
+void FileSystemWatcher::readDirEntries(QSet<QString>& files, QStringList& subdirList) const
+{
+  const QString& dir = paths.at(dirIndex).path;
+  QDirIterator::IteratorFlags flags = recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
+
+  // Names only - does not need file information for each entry
+  QDirIterator fileIt(dir, dirNameFilters, QDir::Files | QDir::NoDotAndDotDot, flags);
+  while(fileIt.hasNext())
+    files.insert(fileIt.next());
+
+  if(recursive)
+  {
+    QDirIterator dirIt(dir, QDir::Dirs | QDir::NoDotAndDotDot, flags);
+    while(dirIt.hasNext())
+      subdirList.append(dirIt.next());
+  }
+}
+
+bool FileSystemWatcher::updateDirEntries(QStringList& added, QStringList& removed)
+{
+  if(dirIndex == -1)
+    return false;
+
+  QSet<QString> files;
+  QStringList subdirList;
+  readDirEntries(files, subdirList);
+
+  for(const QString& file : qAsConst(files))
+  {
+    if(!dirEntries.contains(file))
+      added.append(file);
+  }
+
+  for(const QString& file : qAsConst(dirEntries))
+  {
+    if(!files.contains(file))
+      removed.append(file);
+  }
+
+  dirEntries.swap(files);
+
+  if(fsWatcher != nullptr && subdirList != subdirs)
+  {
+    // Watch new and drop removed subdirectories
+    if(!subdirs.isEmpty())
+      fsWatcher->removePaths(subdirs);
+    if(!subdirList.isEmpty())
+      fsWatcher->addPaths(subdirList);
+  }
+  subdirs.swap(subdirList);
+
+  return !added.isEmpty() || !removed.isEmpty();
 }
 
 void FileSystemWatcher::setFilenameAndStart(const QString& path)
@@ -246,6 +340,9 @@ void FileSystemWatcher::setFilenamesAndStart(const QStringList& pathList)
       path = fileinfo.filePath();
 
     paths.append(PathInfo(path, fileinfo.lastModified(), fileinfo.size()));
+
+    if(!path.isEmpty())
+      dirIndex = paths.size() - 1;
   }
 
   createFsWatcher();
@@ -261,7 +358,7 @@ void FileSystemWatcher::deleteFsWatcher()
   if(fsWatcher != nullptr)
   {
     QFileSystemWatcher::disconnect(fsWatcher, &QFileSystemWatcher::fileChanged, this, &FileSystemWatcher::pathChanged);
-    QFileSystemWatcher::disconnect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FileSystemWatcher::pathChanged);
+    QFileSystemWatcher::disconnect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FileSystemWatcher::dirChanged);
     fsWatcher->deleteLater();
     fsWatcher = nullptr;
   }
@@ -277,11 +374,21 @@ void FileSystemWatcher::createFsWatcher()
     // Watch file for changes and directory too to catch file deletions
     fsWatcher = new QFileSystemWatcher(this);
     QFileSystemWatcher::connect(fsWatcher, &QFileSystemWatcher::fileChanged, this, &FileSystemWatcher::pathChanged);
-    QFileSystemWatcher::connect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FileSystemWatcher::pathChanged);
+    QFileSystemWatcher::connect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FileSystemWatcher::dirChanged);
   }
 
   setPathsToFsWatcher(false);
 
+  // Remember files in directory to detect added or removed ones later
+  dirEntries.clear();
+  subdirs.clear();
+  if(dirIndex != -1)
+  {
+    readDirEntries(dirEntries, subdirs);
+    if(!subdirs.isEmpty())
+      fsWatcher->addPaths(subdirs);
+  }
+
   // Initialize size and timestamp which will omit the first update signal - user has to do the initial load
   for(PathInfo& info : paths)
   {
@@ -19,6 +19,8 @@
 #define ATOOLS_UTIL_FILESYSTEMWATCHER_H
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QSet>
 #include <QTimer>
 #include <QVector>
@@ -32,7 +34,12 @@ namespace util {
  * A better file system watch class which works around for files which are removed, deleted and renamed in
  * the process by checking size and timestamp.
  *
- * Notifications are sent with a delay to catch intermediate changes.
+ * Notifications are sent with a delay to catch intermediate changes. The delay is tracked for each path
+ * separately and is extended by each change of the path.
+ *
+ * The watched directory is listed by name only and compared with the last listing. Notifications for the
+ * directory contain the added and removed files which allows callers to update without a full scan.
+ * Changes which do not modify the list of files, like temporary files, are not reported.
  */
 class FileSystemWatcher
   : public QObject
@@ -78,6 +85,19 @@ public:
     delayMs = value;
   }
 
+  /* Name filters like "METAR-*.txt" for files in the watched directory. Only added or removed files
+   * matching the filters are reported. Empty reports all files. Call before starting. */
+  void setDirNameFilters(const QStringList& value)
+  {
+    dirNameFilters = value;
+  }
+
+  /* Watch all subdirectories of the watched directory too. Call before starting. */
+  void setRecursive(bool value)
+  {
+    recursive = value;
+  }
+
 signals:
   /* Emitted once files are updated */
   void filesUpdated(const QStringList& filenames);
@@ -85,6 +105,10 @@ signals:
   /* Emitted once the parent folder of the files is updated */
   void dirUpdated(const QString& dirname);
 
+  /* Emitted before dirUpdated() with the absolute paths of files added to or removed from the folder
+   * since the last notification */
+  void dirEntriesChanged(const QString& dirname, const QStringList& added, const QStringList& removed);
+
 private:
   void deleteFsWatcher();
   void createFsWatcher();
@@ -95,6 +119,15 @@ private:
   /* Called by delayTimer event */
   void pathUpdatedDelayed();
 
+  /* Called on directory change. Marks watched directory as changed also for changes in subdirectories. */
+  void dirChanged(const QString& path);
+
+  /* List matching files and subdirectories of the watched directory */
+  void readDirEntries(QSet<QString>& files, QStringList& subdirs) const;
+
+  /* Compare directory with last listing. Returns false if nothing was added or removed. */
+  bool updateDirEntries(QStringList& added, QStringList& removed);
+
   void setPathsToFsWatcher(bool update);
   bool warn();
 
@@ -121,7 +154,17 @@ private:
   QVector<PathInfo> paths;
 
   // Indexes into above paths for pathUpdatedDelayed() filled by pathChanged() if changed
-  QSet<int> changedPathIndexes;
+  // Value is the time of the last change from clock
+  QHash<int, qint64> changedPathIndexes;
+  QElapsedTimer clock;
+
+  // Index of the watched directory in paths or -1
+  int dirIndex = -1;
+
+  // Last listing of the directory and watched subdirectories if recursive
+  QSet<QString> dirEntries;
+  QStringList subdirs, dirNameFilters;
+  bool recursive = false;
 
   /* Calls pathChanged() on folder and file changes */
   QFileSystemWatcher *fsWatcher = nullptr;
@@ -168,6 +168,226 @@ void Heap<TYPE, COST>::changeOrPush(const TYPE& data, COST cost)
   }
 }
 
+/*
+ * Indexed binary heap for dense integer keys in the range 0 to numKeys - 1.
+ *
+ * Keeps a position array for each key which allows a O(1) contains() and a
+ * O(log n) change() (decrease and increase key) instead of the linear search and heap rebuild in Heap.
+ *
+ * Call resize() before first use and to reset the heap. Keys outside of the range are not allowed.
+ */
+template<typename COST>
+class IndexedHeap
+{
+public:
+  IndexedHeap(int reserve = 0)
+  {
+    heap.reserve(static_cast<size_t>(reserve));
+  }
+
+  /* Removes all elements and prepares the heap for keys from 0 to numKeys - 1 */
+  void resize(int numKeys)
+  {
+    heap.clear();
+    positions.assign(static_cast<size_t>(numKeys), INVALID_POS);
+  }
+
+  /* Removes all elements and keeps the key range */
+  void clear()
+  {
+    for(const HeapNode& node : heap)
+      positions[static_cast<size_t>(node.key)] = INVALID_POS;
+    heap.clear();
+  }
+
+  /* Take an element from the top of the heap. This will be the one with the lowest cost assigned */
+  COST pop(int& key);
+
+  /* Return key directly. */
+  int popData();
+
+  void pop(int& key, COST& cost)
+  {
+    cost = pop(key);
+  }
+
+  /* Lowest cost key without removing it. Heap must not be empty. */
+  int topData() const
+  {
+    return heap.front().key;
+  }
+
+  /* Lowest cost without removing it. Heap must not be empty. */
+  COST topCost() const
+  {
+    return heap.front().cost;
+  }
+
+  /* Add key to the heap. Key must not be already contained. */
+  void push(int key, COST cost);
+
+  void pushData(int key, COST cost)
+  {
+    push(key, cost);
+  }
+
+  bool contains(int key) const
+  {
+    return positions.at(static_cast<size_t>(key)) != INVALID_POS;
+  }
+
+  /* Cost of a contained key */
+  COST cost(int key) const
+  {
+    return heap.at(static_cast<size_t>(positions.at(static_cast<size_t>(key)))).cost;
+  }
+
+  /* Update the costs of an element if contained. The heap will be updated.  */
+  void change(int key, COST cost);
+
+  /* Update the costs of an element or add it if not contained. */
+  void changeOrPush(int key, COST cost)
+  {
+    if(contains(key))
+      change(key, cost);
+    else
+      push(key, cost);
+  }
+
+  bool isEmpty() const
+  {
+    return heap.empty();
+  }
+
+  int size() const
+  {
+    return static_cast<int>(heap.size());
+  }
+
+  /* Number of keys allowed as given in resize() */
+  int getNumKeys() const
+  {
+    return static_cast<int>(positions.size());
+  }
+
+private:
+  struct HeapNode
+  {
+    int key;
+    COST cost;
+  };
+
+  static Q_DECL_CONSTEXPR int INVALID_POS = -1;
+
+  void siftUp(int pos);
+  void siftDown(int pos);
+
+  void place(int pos, const HeapNode& node)
+  {
+    heap[static_cast<size_t>(pos)] = node;
+    positions[static_cast<size_t>(node.key)] = pos;
+  }
+
+  std::vector<HeapNode> heap;
+
+  /* Maps key to position in heap or INVALID_POS if not contained */
+  std::vector<int> positions;
+};
+
+template<typename COST>
+Q_DECL_CONSTEXPR int IndexedHeap<COST>::INVALID_POS;
+
+template<typename COST>
+void IndexedHeap<COST>::push(int key, COST cost)
+{
+  heap.push_back({key, cost});
+  positions[static_cast<size_t>(key)] = static_cast<int>(heap.size()) - 1;
+  siftUp(static_cast<int>(heap.size()) - 1);
+}
+
+template<typename COST>
+COST IndexedHeap<COST>::pop(int& key)
+{
+  HeapNode top = heap.front();
+  positions[static_cast<size_t>(top.key)] = INVALID_POS;
+
+  HeapNode last = heap.back();
+  heap.pop_back();
+
+  if(!heap.empty())
+  {
+    place(0, last);
+    siftDown(0);
+  }
+
+  key = top.key;
+  return top.cost;
+}
+
+template<typename COST>
+int IndexedHeap<COST>::popData()
+{
+  int key;
+  pop(key);
+  return key;
+}
+
+template<typename COST>
+void IndexedHeap<COST>::change(int key, COST cost)
+{
+  int pos = positions.at(static_cast<size_t>(key));
+  if(pos != INVALID_POS)
+  {
+    COST oldCost = heap[static_cast<size_t>(pos)].cost;
+    heap[static_cast<size_t>(pos)].cost = cost;
+
+    if(cost < oldCost)
+      siftUp(pos);
+    else if(oldCost < cost)
+      siftDown(pos);
+  }
+}
+
+template<typename COST>
+void IndexedHeap<COST>::siftUp(int pos)
+{
+  HeapNode node = heap[static_cast<size_t>(pos)];
+  while(pos > 0)
+  {
+    int parent = (pos - 1) / 2;
+    if(!(node.cost < heap[static_cast<size_t>(parent)].cost))
+      break;
+
+    place(pos, heap[static_cast<size_t>(parent)]);
+    pos = parent;
+  }
+  place(pos, node);
+}
+
+template<typename COST>
+void IndexedHeap<COST>::siftDown(int pos)
+{
+  int size = static_cast<int>(heap.size());
+  HeapNode node = heap[static_cast<size_t>(pos)];
+  while(true)
+  {
+    int child = 2 * pos + 1;
+    if(child >= size)
+      break;
+
+    // Pick the cheaper child
+    if(child + 1 < size && heap[static_cast<size_t>(child + 1)].cost < heap[static_cast<size_t>(child)].cost)
+      child++;
+
+    if(!(heap[static_cast<size_t>(child)].cost < node.cost))
+      break;
+
+    place(pos, heap[static_cast<size_t>(child)]);
+    pos = child;
+  }
+  place(pos, node);
+}
+
 } // namespace util
 } // namespace atools
 
@@ -0,0 +1,190 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_HOTSWAP_H
+#define ATOOLS_UTIL_HOTSWAP_H
+
+#include <QDebug>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace atools {
+namespace util {
+
+namespace internal {
+
+/* Runs a function in a thread pool */
+class HotSwapTask :
+  public QRunnable
+{
+public:
+  explicit HotSwapTask(const std::function<void()>& functionParam)
+    : function(functionParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    function();
+  }
+
+private:
+  std::function<void()> function;
+};
+
+} // namespace internal
+
+/*
+ * Holds an immutable object which is replaced by a new one loaded in the background without blocking readers.
+ *
+ * Readers get a snapshot by get() and keep using it until done even if a new object is published meanwhile.
+ * reload() runs the loader in a single background thread and publishes the result. Results of older reloads
+ * are dropped if a newer reload or cancel() was called meanwhile.
+ *
+ * Used together with atools::sql::DatabaseSwap to rebuild components like MORA grid, magnetic declination or
+ * route network from a newly published database:
+ *
+ * connect(&DatabaseSwap::instance(), &DatabaseSwap::databasePublished, [this](const QString& filename) {
+ *   mora.reload([filename]() -> std::shared_ptr<MoraReader> {
+ *     // Use an own connection since the loader runs in another thread
+ *     SqlDatabase db(SqlDatabase::addDatabase("QSQLITE", "moraReload"));
+ *     db.setDatabaseName(filename);
+ *     db.setReadonly();
+ *     db.open();
+ *     auto reader = std::make_shared<MoraReader>(db);
+ *     reader->readFromTable();
+ *     db.close();
+ *     return reader;
+ *   });
+ * });
+ * ...
+ * std::shared_ptr<const MoraReader> reader = mora.get();
+ * if(reader)
+ *   reader->getMoraFt(pos);
+ *
+ * All methods are thread safe.
+ */
+template<typename TYPE>
+class HotSwap
+{
+public:
+  /* Loader returns the new object or null to keep the current one. Exceptions are logged and keep the current. */
+  typedef std::function<std::shared_ptr<TYPE>()> LoaderType;
+
+  /* Called in the loader thread after a reload with true if a new object was published */
+  typedef std::function<void(bool published)> FinishedType;
+
+  HotSwap()
+  {
+    pool.setMaxThreadCount(1);
+  }
+
+  ~HotSwap()
+  {
+    cancel();
+    pool.waitForDone();
+  }
+
+  HotSwap(const HotSwap& other) = delete;
+  HotSwap& operator=(const HotSwap& other) = delete;
+
+  /* Current snapshot. Null if nothing was loaded yet. */
+  std::shared_ptr<const TYPE> get() const
+  {
+    return std::atomic_load(&current);
+  }
+
+  /* Replace immediately and drop pending reloads */
+  void set(const std::shared_ptr<const TYPE>& object)
+  {
+    QMutexLocker locker(&publishMutex);
+    generation++;
+    std::atomic_store(&current, object);
+  }
+
+  /* Load a new object in the background and publish it if no newer reload was requested meanwhile */
+  void reload(const LoaderType& loader, const FinishedType& finished = FinishedType())
+  {
+    int gen = ++generation;
+    pool.start(new internal::HotSwapTask([this, gen, loader, finished]() -> void {
+      bool published = false;
+
+      // Skip if already outdated before starting
+      if(gen == generation)
+      {
+        std::shared_ptr<TYPE> object;
+        try
+        {
+          object = loader();
+        }
+        catch(std::exception& e)
+        {
+          qWarning() << Q_FUNC_INFO << "Reload failed" << e.what();
+        }
+
+        if(object)
+        {
+          QMutexLocker locker(&publishMutex);
+          if(gen == generation)
+          {
+            std::atomic_store(&current, std::shared_ptr<const TYPE>(object));
+            published = true;
+          }
+        }
+      }
+
+      if(finished)
+        finished(published);
+    }));
+  }
+
+  /* Drop results of running or pending reloads */
+  void cancel()
+  {
+    generation++;
+  }
+
+  /* Wait until all reloads are done */
+  void waitForDone()
+  {
+    pool.waitForDone();
+  }
+
+private:
+  /* Always accessed using std::atomic_load and std::atomic_store */
+  std::shared_ptr<const TYPE> current;
+
+  /* Incremented by each reload, set and cancel */
+  std::atomic_int generation{0};
+
+  /* Serializes generation check and swap for writers. Never used by readers. */
+  QMutex publishMutex;
+
+  QThreadPool pool;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_HOTSWAP_H
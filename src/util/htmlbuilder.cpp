@@ -24,6 +24,7 @@
 #include <QDateTime>
 #include <QBuffer>
 #include <QIcon>
+#include <QIODevice>
 #include <QRegularExpression>
 #include <QStringBuilder>
 
@@ -84,7 +85,8 @@ HtmlBuilder& HtmlBuilder::operator=(const atools::util::HtmlBuilder& other)
   tableRowBegin = other.tableRowBegin;
   defaultPrecision = other.defaultPrecision;
   numLines = other.numLines;
-  htmlText = other.htmlText;
+  htmlText = *other.output;
+  output = &htmlText;
   locale = other.locale;
   dateFormat = other.dateFormat;
   hasBackColor = other.hasBackColor;
@@ -157,13 +159,44 @@ void HtmlBuilder::initColors(const QColor& rowColor, const QColor& rowColorAlt)
 
 HtmlBuilder& HtmlBuilder::clear()
 {
-  htmlText.clear();
+  /* Keeps allocated capacity for reuse */
+  output->truncate(0);
   idBits.fill(false, MAX_ID + 1);
   numLines = 0;
   tableRowsCur = 0;
   return *this;
 }
 
+HtmlBuilder& HtmlBuilder::setOutputBuffer(QString *buffer)
+{
+  output = buffer == nullptr ? &htmlText : buffer;
+  markIndex = -1;
+  return *this;
+}
+
+HtmlBuilder& HtmlBuilder::reserve(int size)
+{
+  output->reserve(size);
+  return *this;
+}
+
+bool HtmlBuilder::flush(QIODevice& device)
+{
+  bool ok = true;
+  if(!output->isEmpty())
+  {
+    QByteArray bytes = output->toUtf8();
+    ok = device.write(bytes) == bytes.size();
+    if(!ok)
+      qWarning() << Q_FUNC_INFO << "Error writing" << device.errorString();
+
+    /* Keeps allocated capacity for reuse */
+    output->truncate(0);
+    markIndex = -1;
+  }
+  return ok;
+}
+
 HtmlBuilder HtmlBuilder::cleared() const
 {
   HtmlBuilder html(*this);
@@ -173,19 +206,19 @@ HtmlBuilder HtmlBuilder::cleared() const
 
 HtmlBuilder& HtmlBuilder::append(const HtmlBuilder& other)
 {
-  htmlText.append(other.getHtml());
+  output->append(other.getHtml());
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::append(const QString& other)
 {
-  htmlText.append(other);
+  output->append(other);
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::append(const char *other)
 {
-  htmlText.append(QString(other));
+  output->append(QString(other));
   return *this;
 }
 
@@ -197,7 +230,7 @@ HtmlBuilder& HtmlBuilder::mark(int markParam)
 
 HtmlBuilder& HtmlBuilder::mark()
 {
-  markIndex = htmlText.size();
+  markIndex = output->size();
   return *this;
 }
 
@@ -210,7 +243,7 @@ HtmlBuilder& HtmlBuilder::clearMark()
 HtmlBuilder& HtmlBuilder::rewind()
 {
   if(markIndex != -1)
-    htmlText.truncate(markIndex);
+    output->truncate(markIndex);
   return *this;
 }
 
@@ -221,7 +254,7 @@ int HtmlBuilder::getMark() const
 
 HtmlBuilder& HtmlBuilder::error(const QString& str, html::Flags flags)
 {
-  htmlText.append(HtmlBuilder::errorMessage(str, flags));
+  output->append(HtmlBuilder::errorMessage(str, flags));
   return *this;
 }
 
@@ -243,7 +276,7 @@ QString HtmlBuilder::errorMessage(const QString& str, html::Flags flags)
 
 HtmlBuilder& HtmlBuilder::warning(const QString& str, html::Flags flags)
 {
-  htmlText.append(HtmlBuilder::warningMessage(str, flags));
+  output->append(HtmlBuilder::warningMessage(str, flags));
   return *this;
 }
 
@@ -265,7 +298,8 @@ QString HtmlBuilder::warningMessage(const QStringList& stringList, const QString
 
 HtmlBuilder& HtmlBuilder::note(const QString& str, html::Flags flags)
 {
-  htmlText.append(HtmlBuilder::noteMessage(str, flags));
+  if(!str.isEmpty())
+    appendText(*output, str, flags, QColor("#00aa00"));
   return *this;
 }
 
@@ -287,7 +321,8 @@ QString HtmlBuilder::noteMessage(const QStringList& stringList, const QString& s
 
 HtmlBuilder& HtmlBuilder::message(const QString& str, html::Flags flags, QColor foreground, QColor background)
 {
-  htmlText.append(textMessage(str, flags, foreground, background));
+  if(!str.isEmpty())
+    appendText(*output, str, flags, foreground, background);
   numLines++;
   return *this;
 }
@@ -367,7 +402,7 @@ HtmlBuilder& HtmlBuilder::row2Var(const QString& name, const QVariant& value, ht
         valueStr = QString("Error: Invalid variant type \"%1\"").arg(value.typeName());
 
     }
-    htmlText.append(alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).arg(asText(name, flags, color), value.toString()));
+    output->append(alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).arg(asText(name, flags, color), value.toString()));
     tableRowsCur++;
     numLines++;
   }
@@ -381,7 +416,7 @@ HtmlBuilder& HtmlBuilder::row2If(const QString& name, const QString& value, html
     flags |= row2AlignRightFlag ? html::ALIGN_RIGHT : html::NONE;
     if(!value.isEmpty())
     {
-      htmlText.append(alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
+      output->append(alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
                       arg(asText(name, flags | atools::util::html::BOLD, color)).
                       arg(asText(value, flags, color)));
       tableRowsCur++;
@@ -427,7 +462,7 @@ HtmlBuilder& HtmlBuilder::row2(const QString& name, const QString& value, html::
   if(isId())
   {
     flags |= row2AlignRightFlag ? html::ALIGN_RIGHT : html::NONE;
-    htmlText.append(alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
+    output->append(alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
                     arg(asText(name, flags | html::BOLD, color)).
                     // Add space to avoid formatting issues with table
                     arg(value.isEmpty() ? "&nbsp;" : asText(value, flags, color)));
@@ -454,15 +489,15 @@ HtmlBuilder& HtmlBuilder::row2(const QString& name, int value, html::Flags flags
 
 HtmlBuilder& HtmlBuilder::td(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText.append(QLatin1String("<td") % (flags & html::ALIGN_RIGHT ? " style=\"text-align: right;\"" : "") % ">");
+  output->append(QLatin1String("<td") % (flags & html::ALIGN_RIGHT ? " style=\"text-align: right;\"" : "") % ">");
   text(str, flags, color);
-  htmlText.append("</td>\n");
+  output->append(QLatin1String("</td>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tdF(html::Flags flags)
 {
-  htmlText.append(QLatin1String("<td") % (flags & html::ALIGN_RIGHT ? " style=\"text-align: right;\"" : "") % ">");
+  output->append(QLatin1String("<td") % (flags & html::ALIGN_RIGHT ? " style=\"text-align: right;\"" : "") % ">");
   return *this;
 }
 
@@ -472,50 +507,50 @@ HtmlBuilder& HtmlBuilder::tdAtts(const QHash<QString, QString>& attributes)
   for(auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
     atts.append(QString(" %1=\"%2\" ").arg(it.key()).arg(it.value()));
 
-  htmlText.append("<td " % atts % ">");
+  output->append("<td " % atts % ">");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::td()
 {
-  htmlText.append("<td>");
+  output->append(QLatin1String("<td>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tdW(int widthPercent)
 {
-  htmlText.append(QString("<td width=\"%1%\">").arg(widthPercent));
+  output->append(QString("<td width=\"%1%\">").arg(widthPercent));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tdEnd()
 {
-  htmlText.append("</td>\n");
+  output->append(QLatin1String("</td>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::th(const QString& str, html::Flags flags, QColor color, int colspan)
 {
-  htmlText.append(QLatin1String("<th") %
+  output->append(QLatin1String("<th") %
                   (flags & html::ALIGN_RIGHT ? " align=\"right\"" : "") %
                   (flags & html::ALIGN_LEFT ? " align=\"left\"" : "") %
                   (colspan != -1 ? " colspan=\"" % QString::number(colspan) % "\"" : QString()) %
                   ">");
   text(str, flags, color);
-  htmlText.append("</th>\n");
+  output->append(QLatin1String("</th>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tr(QColor backgroundColor)
 {
   if(backgroundColor.isValid())
-    htmlText.append("<tr bgcolor=\"" % backgroundColor.name(QColor::HexRgb) % "\">\n");
+    output->append("<tr bgcolor=\"" % backgroundColor.name(QColor::HexRgb) % "\">\n");
   else
   {
     if(hasBackColor)
-      htmlText.append(alt(tableRowBegin));
+      output->append(alt(tableRowBegin));
     else
-      htmlText.append("<tr>\n");
+      output->append(QLatin1String("<tr>\n"));
   }
   tableRowsCur++;
   numLines++;
@@ -524,7 +559,7 @@ HtmlBuilder& HtmlBuilder::tr(QColor backgroundColor)
 
 HtmlBuilder& HtmlBuilder::tr()
 {
-  htmlText.append("<tr>\n");
+  output->append(QLatin1String("<tr>\n"));
   tableRowsCur++;
   numLines++;
   return *this;
@@ -532,13 +567,13 @@ HtmlBuilder& HtmlBuilder::tr()
 
 HtmlBuilder& HtmlBuilder::trEnd()
 {
-  htmlText.append("</tr>\n");
+  output->append(QLatin1String("</tr>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::table(int border, int padding, int spacing, int widthPercent, QColor bgcolor, QColor bordercolor)
 {
-  htmlText.append("<table border=\"" % QString::number(border) % "\" cellpadding=\"" %
+  output->append("<table border=\"" % QString::number(border) % "\" cellpadding=\"" %
                   QString::number(padding) % "\" cellspacing=\"" % QString::number(spacing) % "\"" %
                   (bgcolor.isValid() ? " bgcolor=\"" % bgcolor.name(QColor::HexRgb) % "\"" : QString()) %
                   (bordercolor.isValid() ? " border-color=\"" % bordercolor.name(QColor::HexRgb) % "\"" : QString()) %
@@ -559,14 +594,14 @@ HtmlBuilder& HtmlBuilder::tableAtts(const QHash<QString, QString>& attributes)
   for(auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
     atts.append(QString(" %1=\"%2\" ").arg(it.key()).arg(it.value()));
 
-  htmlText.append("<table " % atts % ">\n<tbody>\n");
+  output->append("<table " % atts % ">\n<tbody>\n");
   tableRowsCur = 0;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tableEnd()
 {
-  htmlText.append("</tbody>\n</table>\n");
+  output->append(QLatin1String("</tbody>\n</table>\n"));
   tableRowsCur = 0;
   return *this;
 }
@@ -585,7 +620,7 @@ HtmlBuilder& HtmlBuilder::h(int level, const QString& str, html::Flags flags, QC
                             const QString& id)
 {
   QString num = QString::number(level);
-  htmlText.append("<h" % num % (id.isEmpty() ? QString() : " id=\"" % id % "\"") % ">" % asText(str, flags, color) % "</h" % num % ">\n");
+  output->append("<h" % num % (id.isEmpty() ? QString() : " id=\"" % id % "\"") % ">" % asText(str, flags, color) % "</h" % num % ">\n");
   numLines++;
   return *this;
 }
@@ -628,31 +663,31 @@ HtmlBuilder& HtmlBuilder::b(const QString& str)
 
 HtmlBuilder& HtmlBuilder::b()
 {
-  htmlText.append("<b>");
+  output->append(QLatin1String("<b>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::bEnd()
 {
-  htmlText.append("</b>");
+  output->append(QLatin1String("</b>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::i()
 {
-  htmlText.append("<i>");
+  output->append(QLatin1String("<i>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::iEnd()
 {
-  htmlText.append("</i>");
+  output->append(QLatin1String("</i>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::nbsp()
 {
-  htmlText.append("&nbsp;");
+  output->append(QLatin1String("&nbsp;"));
   return *this;
 }
 
@@ -664,13 +699,13 @@ HtmlBuilder& HtmlBuilder::u(const QString& str)
 
 HtmlBuilder& HtmlBuilder::u()
 {
-  htmlText.append("<u>");
+  output->append(QLatin1String("<u>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::uEnd()
 {
-  htmlText.append("</u>");
+  output->append(QLatin1String("</u>"));
   return *this;
 }
 
@@ -682,13 +717,13 @@ HtmlBuilder& HtmlBuilder::sub(const QString& str)
 
 HtmlBuilder& HtmlBuilder::sub()
 {
-  htmlText.append("<sub>");
+  output->append(QLatin1String("<sub>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::subEnd()
 {
-  htmlText.append("</sub>");
+  output->append(QLatin1String("</sub>"));
   return *this;
 }
 
@@ -700,13 +735,13 @@ HtmlBuilder& HtmlBuilder::sup(const QString& str)
 
 HtmlBuilder& HtmlBuilder::sup()
 {
-  htmlText.append("<sup>");
+  output->append(QLatin1String("<sup>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::supEnd()
 {
-  htmlText.append("</sup>");
+  output->append(QLatin1String("</sup>"));
   return *this;
 }
 
@@ -718,13 +753,13 @@ HtmlBuilder& HtmlBuilder::small(const QString& str)
 
 HtmlBuilder& HtmlBuilder::small()
 {
-  htmlText.append("<small>");
+  output->append(QLatin1String("<small>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::smallEnd()
 {
-  htmlText.append("</small>");
+  output->append(QLatin1String("</small>"));
   return *this;
 }
 
@@ -736,13 +771,13 @@ HtmlBuilder& HtmlBuilder::big(const QString& str)
 
 HtmlBuilder& HtmlBuilder::big()
 {
-  htmlText.append("<big>");
+  output->append(QLatin1String("<big>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::bigEnd()
 {
-  htmlText.append("</big>");
+  output->append(QLatin1String("</big>"));
   return *this;
 }
 
@@ -754,13 +789,13 @@ HtmlBuilder& HtmlBuilder::code(const QString& str)
 
 HtmlBuilder& HtmlBuilder::code()
 {
-  htmlText.append("<code>");
+  output->append(QLatin1String("<code>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::codeEnd()
 {
-  htmlText.append("</code>");
+  output->append(QLatin1String("</code>"));
   return *this;
 }
 
@@ -772,7 +807,7 @@ HtmlBuilder& HtmlBuilder::nobr(const QString& str)
 
 HtmlBuilder& HtmlBuilder::br()
 {
-  htmlText.append("<br/>");
+  output->append(QLatin1String("<br/>"));
   numLines++;
   return *this;
 }
@@ -780,11 +815,11 @@ HtmlBuilder& HtmlBuilder::br()
 HtmlBuilder& HtmlBuilder::p(const QString& str, html::Flags flags, QColor color)
 {
   if(flags & html::NOBR_WHITESPACE)
-    htmlText.append("<p style=\"white-space:pre\">");
+    output->append(QLatin1String("<p style=\"white-space:pre\">"));
   else
-    htmlText.append("<p>");
+    output->append(QLatin1String("<p>"));
   text(str, flags, color);
-  htmlText.append("</p>\n");
+  output->append(QLatin1String("</p>\n"));
   numLines++;
   return *this;
 }
@@ -792,38 +827,38 @@ HtmlBuilder& HtmlBuilder::p(const QString& str, html::Flags flags, QColor color)
 HtmlBuilder& HtmlBuilder::p(html::Flags flags)
 {
   if(flags & html::NOBR_WHITESPACE)
-    htmlText.append("<p style=\"white-space:pre\">");
+    output->append(QLatin1String("<p style=\"white-space:pre\">"));
   else
-    htmlText.append("<p>");
+    output->append(QLatin1String("<p>"));
   numLines++;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::pEnd()
 {
-  htmlText.append("</p>\n");
+  output->append(QLatin1String("</p>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::pre()
 {
-  htmlText.append("<pre>");
+  output->append(QLatin1String("<pre>"));
   numLines++;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::preEnd()
 {
-  htmlText.append("</pre>\n");
+  output->append(QLatin1String("</pre>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::pre(const QString& str, html::Flags flags, QColor color)
 {
 
-  htmlText.append("<pre>");
+  output->append(QLatin1String("<pre>"));
   text(str, flags, color);
-  htmlText.append("</pre>");
+  output->append(QLatin1String("</pre>"));
   return *this;
 }
 
@@ -842,7 +877,7 @@ HtmlBuilder& HtmlBuilder::textBr(const QString& str, html::Flags flags, QColor c
 
 HtmlBuilder& HtmlBuilder::hr(int size, int widthPercent)
 {
-  htmlText.append("<hr size=\"" % QString::number(size) % "\" width=\"" % QString::number(widthPercent) % "%\"/>\n");
+  output->append("<hr size=\"" % QString::number(size) % "\" width=\"" % QString::number(widthPercent) % "%\"/>\n");
   numLines++;
   return *this;
 }
@@ -853,7 +888,7 @@ HtmlBuilder& HtmlBuilder::a(const QString& text, const QString& href, html::Flag
   if(flags & html::LINK_NO_UL)
     styleTxt = "style=\"text-decoration:none;\"";
 
-  htmlText.append("<a " % styleTxt % " " % (href.isEmpty() ? QString() : " href=\"" % href % "\"") % ">" %
+  output->append("<a " % styleTxt % " " % (href.isEmpty() ? QString() : " href=\"" % href % "\"") % ">" %
                   asText(text, flags, color) % "</a>");
   return *this;
 }
@@ -883,143 +918,181 @@ HtmlBuilder& HtmlBuilder::img(const QString& src, const QString& alt, const QStr
   QString altAtt = alt.isEmpty() ? QString() : " alt=\"" % alt % "\"";
   QString styleAtt = style.isEmpty() ? QString() : " style=\"" % style % "\"";
 
-  htmlText.append("<img src='" % src % "'" % styleAtt % altAtt % widthAtt % heightAtt % "/>");
+  output->append("<img src='" % src % "'" % styleAtt % altAtt % widthAtt % heightAtt % "/>");
 
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::ol()
 {
-  htmlText.append("<ol>");
+  output->append(QLatin1String("<ol>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::olEnd()
 {
-  htmlText.append("</ol>\n");
+  output->append(QLatin1String("</ol>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::ul()
 {
-  htmlText.append("<ul>");
+  output->append(QLatin1String("<ul>"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::ulEnd()
 {
-  htmlText.append("</ul>\n");
+  output->append(QLatin1String("</ul>\n"));
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::li(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText.append("<li>" % asText(str, flags, color) % "</li>\n");
+  output->append(QLatin1String("<li>"));
+  appendText(*output, str, flags, color);
+  output->append(QLatin1String("</li>\n"));
   numLines++;
   return *this;
 }
 
-QString HtmlBuilder::asText(QString str, html::Flags flags, QColor foreground, QColor background)
+struct FlagTag
 {
-  QString prefix, suffix;
-  if(flags & html::BOLD)
-  {
-    prefix.append("<b>");
-    suffix.prepend("</b>");
-  }
-
-  if(flags & html::ITALIC)
-  {
-    prefix.append("<i>");
-    suffix.prepend("</i>");
-  }
+  html::Flag flag;
+  const char *open, *close;
+};
 
-  if(flags & html::UNDERLINE)
-  {
-    prefix.append("<u>");
-    suffix.prepend("</u>");
-  }
+/* Opening tags in order of nesting. Closed in reverse order. */
+static const FlagTag FLAG_TAGS[] =
+{
+  {html::BOLD, "<b>", "</b>"},
+  {html::ITALIC, "<i>", "</i>"},
+  {html::UNDERLINE, "<u>", "</u>"},
+  {html::STRIKEOUT, "<s>", "</s>"},
+  {html::SUBSCRIPT, "<sub>", "</sub>"},
+  {html::SUPERSCRIPT, "<sup>", "</sup>"},
+  {html::SMALL, "<small>", "</small>"},
+  {html::BIG, "<big>", "</big>"},
+  {html::CODE, "<code>", "</code>"},
+  {html::PRE, "<pre>", "</pre>"},
+  {html::NOBR, "<nobr>", "</nobr>"}
+};
 
-  if(flags & html::STRIKEOUT)
-  {
-    prefix.append("<s>");
-    suffix.prepend("</s>");
-  }
+static Q_DECL_CONSTEXPR int NUM_FLAG_TAGS = sizeof(FLAG_TAGS) / sizeof(FLAG_TAGS[0]);
 
-  if(flags & html::SUBSCRIPT)
-  {
-    prefix.append("<sub>");
-    suffix.prepend("</sub>");
-  }
-
-  if(flags & html::SUPERSCRIPT)
-  {
-    prefix.append("<sup>");
-    suffix.prepend("</sup>");
-  }
+QString HtmlBuilder::asText(const QString& str, html::Flags flags, const QColor& foreground, const QColor& background)
+{
+  QString text;
+  appendText(text, str, flags, foreground, background);
+  return text;
+}
 
-  if(flags & html::SMALL)
+void HtmlBuilder::appendText(QString& out, const QString& str, html::Flags flags, const QColor& foreground,
+                             const QColor& background)
+{
+  for(const FlagTag& tag : FLAG_TAGS)
   {
-    prefix.append("<small>");
-    suffix.prepend("</small>");
+    if(flags & tag.flag)
+      out.append(QLatin1String(tag.open));
   }
 
-  if(flags & html::BIG)
+  bool hasBackground = background.isValid() && background != Qt::transparent;
+  bool span = foreground.isValid() || hasBackground;
+  if(span)
   {
-    prefix.append("<big>");
-    suffix.prepend("</big>");
-  }
+    out.append(QLatin1String("<span style=\""));
 
-  if(flags & html::CODE)
-  {
-    prefix.append("<code>");
-    suffix.prepend("</code>");
-  }
+    if(foreground.isValid())
+      out += QLatin1String("color:") % foreground.name(QColor::HexRgb);
 
-  if(flags & html::PRE)
-  {
-    prefix.append("<pre>");
-    suffix.prepend("</pre>");
-  }
+    if(hasBackground)
+    {
+      if(foreground.isValid())
+        out.append(QLatin1String("; "));
+      out += QLatin1String("background-color:") % background.name(QColor::HexRgb);
+    }
 
-  if(flags & html::NOBR)
-  {
-    prefix.append("<nobr>");
-    suffix.prepend("</nobr>");
+    out.append(QLatin1String("\">"));
   }
 
-  if(foreground.isValid() || (background.isValid() && background != Qt::transparent))
+  if(flags & html::REPLACE_CRLF || flags & html::AUTOLINK)
   {
-    prefix.append("<span style=\"");
-
-    if(foreground.isValid())
-      prefix.append("color:" % foreground.name(QColor::HexRgb));
+    /* Rare case - needs a temporary copy for the replacements */
+    QString text;
+    if(flags & html::NO_ENTITIES)
+      text = str;
+    else
+      appendEscaped(text, str);
 
-    if(background.isValid() && background != Qt::transparent)
+    if(flags & html::REPLACE_CRLF)
     {
-      if(foreground.isValid())
-        prefix.append("; ");
-      prefix.append("background-color:" % background.name(QColor::HexRgb));
+      text.replace(QLatin1String("\r\n"), QLatin1String("<br/>"));
+      text.replace(QLatin1String("\n"), QLatin1String("<br/>"));
+      text.replace(QLatin1String("\r"), QLatin1String("<br/>"));
     }
 
-    prefix.append("\">");
-    suffix.prepend("</span>");
+    if(flags & html::AUTOLINK)
+      text.replace(LINK_REGEXP, "<a href=\"\\1\">\\1</a>");
+
+    out.append(text);
   }
+  else if(flags & html::NO_ENTITIES)
+    out.append(str);
+  else
+    appendEscaped(out, str);
 
-  if(!(flags & html::NO_ENTITIES))
-    str = toEntities(str.toHtmlEscaped()).replace("\n", "<br/>");
+  if(span)
+    out.append(QLatin1String("</span>"));
 
-  if(flags & html::REPLACE_CRLF)
+  for(int i = NUM_FLAG_TAGS - 1; i >= 0; i--)
   {
-    str = str.replace("\r\n", "<br/>");
-    str = str.replace("\n", "<br/>");
-    str = str.replace("\r", "<br/>");
+    if(flags & FLAG_TAGS[i].flag)
+      out.append(QLatin1String(FLAG_TAGS[i].close));
   }
+}
 
-  if(flags & html::AUTOLINK)
-    str.replace(LINK_REGEXP, "<a href=\"\\1\">\\1</a>");
+void HtmlBuilder::appendEscaped(QString& out, const QString& str)
+{
+  /* Same result as toEntities(str.toHtmlEscaped()).replace("\n", "<br/>") in a single pass */
 
-  return prefix % str % suffix;
+  for(const QChar& c : str)
+  {
+    ushort code = c.unicode();
+    if(code > 128)
+    {
+      char buf[16];
+      int len = qsnprintf(buf, sizeof(buf), "&#%u;", static_cast<unsigned int>(code));
+      out.append(QLatin1String(buf, len));
+    }
+    else
+    {
+      switch(code)
+      {
+        case '<':
+          out.append(QLatin1String("&lt;"));
+          break;
+
+        case '>':
+          out.append(QLatin1String("&gt;"));
+          break;
+
+        case '&':
+          out.append(QLatin1String("&amp;"));
+          break;
+
+        case '"':
+          out.append(QLatin1String("&quot;"));
+          break;
+
+        case '\n':
+          out.append(QLatin1String("<br/>"));
+          break;
+
+        default:
+          out.append(c);
+      }
+    }
+  }
 }
 
 bool HtmlBuilder::checklength(int maxLines, const QString& msg)
@@ -1027,7 +1100,7 @@ bool HtmlBuilder::checklength(int maxLines, const QString& msg)
   QString dotText(QString("<b>%1</b>").arg(msg));
   if(numLines > maxLines)
   {
-    if(!htmlText.endsWith(dotText))
+    if(!output->endsWith(dotText))
       hr().b(msg);
     return true;
   }
@@ -1039,7 +1112,7 @@ bool HtmlBuilder::checklengthTextBar(int maxLines, const QString& msg, int lengh
   QString dotText(QString("<b>%1</b>").arg(msg));
   if(numLines > maxLines)
   {
-    if(!htmlText.endsWith(dotText))
+    if(!output->endsWith(dotText))
       textBar(lenght).b(msg);
     return true;
   }
@@ -1056,7 +1129,7 @@ HtmlBuilder& HtmlBuilder::textBar(int lenght, html::Flags flags, QColor color)
 
 HtmlBuilder& HtmlBuilder::text(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText.append(asText(str, flags, color));
+  appendText(*output, str, flags, color);
   return *this;
 }
 
@@ -1074,28 +1147,28 @@ HtmlBuilder& HtmlBuilder::textHtml(const HtmlBuilder& other)
 HtmlBuilder& HtmlBuilder::doc(const QString& title, const QString& css, const QString& bodyStyle,
                               const QStringList& headerLines)
 {
-  htmlText.append(
+  output->append(
     "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.0//EN\" \"http://www.w3.org/TR/REC-html40/strict.dtd\">\n"
       "<html>\n"
         "<head>\n");
 
   if(!css.isEmpty())
-    htmlText.append(QString("<style type=\"text/css\" xml:space=\"preserve\">\n%1</style>\n").arg(css));
+    output->append(QString("<style type=\"text/css\" xml:space=\"preserve\">\n%1</style>\n").arg(css));
 
   if(!title.isEmpty())
-    htmlText.append(QString("<title>%1</title>\n").arg(title));
+    output->append(QString("<title>%1</title>\n").arg(title));
 
   // Other header lines like "meta"
   for(const QString& line : headerLines)
-    htmlText.append(line);
+    output->append(line);
 
   // <link rel="stylesheet" href="css/style.css" type="text/css" />
-  htmlText.append("</head>\n");
+  output->append(QLatin1String("</head>\n"));
 
   if(!bodyStyle.isEmpty())
-    htmlText.append("<body style=\"" % bodyStyle % "\">\n");
+    output->append("<body style=\"" % bodyStyle % "\">\n");
   else
-    htmlText.append("<body>\n");
+    output->append(QLatin1String("<body>\n"));
 
   tableRowsCur = 0;
   markIndex = -1;
@@ -1104,7 +1177,7 @@ HtmlBuilder& HtmlBuilder::doc(const QString& title, const QString& css, const QS
 
 HtmlBuilder& HtmlBuilder::docEnd()
 {
-  htmlText.append("</body>\n</html>\n");
+  output->append(QLatin1String("</body>\n</html>\n"));
   return *this;
 }
 
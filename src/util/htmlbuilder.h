@@ -25,6 +25,8 @@
 #include <QSize>
 #include <QDebug>
 
+class QIODevice;
+
 namespace atools {
 namespace util {
 
@@ -88,7 +90,7 @@ public:
 
   const QString& getHtml() const
   {
-    return htmlText;
+    return *output;
   }
 
   HtmlBuilder& operator=(const atools::util::HtmlBuilder& other);
@@ -102,6 +104,23 @@ public:
   /* Clears this instance except settings */
   HtmlBuilder& clear();
 
+  /*
+   * Write all output into the given buffer instead of the internal one. The caller keeps ownership and can
+   * reserve capacity up front to avoid reallocations when building many documents. nullptr reverts to the
+   * internal buffer. getHtml() returns the content of the current buffer. Copies always use their own buffer.
+   */
+  HtmlBuilder& setOutputBuffer(QString *buffer);
+
+  /* Reserve capacity in the current output buffer */
+  HtmlBuilder& reserve(int size);
+
+  /*
+   * Write the current output as UTF-8 to device and empty the buffer while keeping its capacity.
+   * Allows to stream large documents in chunks. Marks are reset.
+   * @return false on write error
+   */
+  bool flush(QIODevice& device);
+
   /* Returns a clean copy of this instance */
   HtmlBuilder cleared() const;
 
@@ -365,7 +384,7 @@ public:
 
   bool isEmpty() const
   {
-    return htmlText.isEmpty();
+    return output->isEmpty();
   }
 
   /* Date format for row2Var */
@@ -472,7 +491,15 @@ public:
 private:
   /* Select alternating entries based on the index from the string list */
   const QString& alt(const QStringList& list) const;
-  static QString asText(QString str, html::Flags flags, QColor foreground, QColor background = QColor());
+  static QString asText(const QString& str, html::Flags flags, const QColor& foreground,
+                        const QColor& background = QColor());
+
+  /* Append text with tags for flags and colors directly to out without temporary strings */
+  static void appendText(QString& out, const QString& str, html::Flags flags, const QColor& foreground,
+                         const QColor& background = QColor());
+
+  /* Escapes HTML characters, converts non-ASCII to entities and newlines to <br/> */
+  static void appendEscaped(QString& out, const QString& str);
 
   void initColors(const QColor& rowColor, const QColor& rowColorAlt);
 
@@ -487,6 +514,7 @@ private:
 
   int defaultPrecision = 0, numLines = 0;
   QString htmlText;
+  QString *output = &htmlText; /* Either htmlText or a caller owned buffer */
 
   QLocale locale;
   QLocale::FormatType dateFormat = QLocale::ShortFormat;
@@ -16,16 +16,26 @@
 *****************************************************************************/
 
 #include "util/httpdownloader.h"
+#include "util/downloadscheduler.h"
 #include "util/timedcache.h"
+#include "util/metrics.h"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
 #include <QFileInfo>
 #include <QNetworkReply>
+#include <QSaveFile>
 #include <QUrlQuery>
 
 namespace atools {
 namespace util {
 
+/* Header for files of the conditional request cache */
+static const quint32 CONDITIONAL_MAGIC_NUMBER = 0x48444C43;
+static const quint16 CONDITIONAL_VERSION = 1;
+
 HttpDownloader::HttpDownloader(QObject *parent, bool verboseLogging)
   : QObject(parent), verbose(verboseLogging)
 {
@@ -103,46 +113,14 @@ void HttpDownloader::startDownload()
       {
         cancelDownload();
 
-        QNetworkRequest request(downloadUrl);
-
-        if(!userAgent.isEmpty())
-          request.setHeader(QNetworkRequest::UserAgentHeader, userAgent);
-
-        // curl -H "Accept-Encoding: gzip" https://data.vatsim.net/v3/vatsim-data.json --output vatsim-data.json.gz
-        if(!acceptEncoding.isEmpty())
-          request.setRawHeader(QByteArray("Accept-Encoding"), acceptEncoding.toUtf8());
-
-        // Add arbitrary headers ===================
-        for(auto it = headerParameters.begin(); it != headerParameters.end(); ++it)
-          request.setRawHeader(it.key().toUtf8(), it.value().toUtf8());
-
-        if(!postParameters.isEmpty())
-          // Post raw data ============================
-          reply = networkManager.post(request, postParameters);
-        else if(!postParametersQuery.isEmpty())
-        {
-          // Post form data ============================
-          request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-          QUrlQuery params;
-          for(auto it = postParametersQuery.begin(); it != postParametersQuery.end(); ++it)
-            params.addQueryItem(it.key(), it.value());
-
-          reply = networkManager.post(request, params.query().toUtf8());
-        }
-        else
-          // Get request ============================
-          reply = networkManager.get(request);
-
-        if(reply != nullptr)
+        if(!scheduler.isNull())
         {
-          connect(reply, &QNetworkReply::finished, this, &HttpDownloader::httpFinished);
-          connect(reply, &QNetworkReply::readyRead, this, &HttpDownloader::readyRead);
-          connect(reply, &QNetworkReply::downloadProgress, this, &HttpDownloader::downloadProgressInternal);
-          connect(reply, &QNetworkReply::sslErrors, this, &HttpDownloader::sslErrors);
+          // Wait for a free slot - scheduler calls startRequest()
+          queued = true;
+          scheduler->enqueue(this, priority);
         }
         else
-          qWarning() << Q_FUNC_INFO << "Reply is null" << downloadUrl;
+          startRequest();
       }
       else
         // is already downloading and waiting for finished required (restartRequest = false)
@@ -151,6 +129,84 @@ void HttpDownloader::startDownload()
   }
 }
 
+void HttpDownloader::startRequest()
+{
+  queued = false;
+
+  QNetworkRequest request(downloadUrl);
+
+  if(!scheduler.isNull())
+  {
+    // Allow multiplexing over the shared connections
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#else
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
+  }
+
+  if(!userAgent.isEmpty())
+    request.setHeader(QNetworkRequest::UserAgentHeader, userAgent);
+
+  // curl -H "Accept-Encoding: gzip" https://data.vatsim.net/v3/vatsim-data.json --output vatsim-data.json.gz
+  if(!acceptEncoding.isEmpty())
+    request.setRawHeader(QByteArray("Accept-Encoding"), acceptEncoding.toUtf8());
+
+  // Add arbitrary headers ===================
+  for(auto it = headerParameters.begin(); it != headerParameters.end(); ++it)
+    request.setRawHeader(it.key().toUtf8(), it.value().toUtf8());
+
+  // Add validators for conditional GET ===================
+  conditionalUrl.clear();
+  if(conditionalRequests && postParameters.isEmpty() && postParametersQuery.isEmpty())
+  {
+    conditionalUrl = QUrl(downloadUrl).toString();
+    const ConditionalEntry *entry = conditionalEntry(conditionalUrl);
+    if(entry != nullptr)
+    {
+      if(!entry->etag.isEmpty())
+        request.setRawHeader(QByteArray("If-None-Match"), entry->etag);
+      if(!entry->lastModified.isEmpty())
+        request.setRawHeader(QByteArray("If-Modified-Since"), entry->lastModified);
+    }
+  }
+
+  if(!postParameters.isEmpty())
+    // Post raw data ============================
+    reply = networkManager()->post(request, postParameters);
+  else if(!postParametersQuery.isEmpty())
+  {
+    // Post form data ============================
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+
+    QUrlQuery params;
+    for(auto it = postParametersQuery.begin(); it != postParametersQuery.end(); ++it)
+      params.addQueryItem(it.key(), it.value());
+
+    reply = networkManager()->post(request, params.query().toUtf8());
+  }
+  else
+    // Get request ============================
+    reply = networkManager()->get(request);
+
+  if(reply != nullptr)
+  {
+    requestTimer.start();
+    connect(reply, &QNetworkReply::finished, this, &HttpDownloader::httpFinished);
+    connect(reply, &QNetworkReply::readyRead, this, &HttpDownloader::readyRead);
+    connect(reply, &QNetworkReply::downloadProgress, this, &HttpDownloader::downloadProgressInternal);
+    connect(reply, &QNetworkReply::sslErrors, this, &HttpDownloader::sslErrors);
+  }
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Reply is null" << downloadUrl;
+
+    // Free slot for others
+    if(!scheduler.isNull())
+      scheduler->release(this);
+  }
+}
+
 void HttpDownloader::sslErrors(const QList<QSslError>& errors)
 {
   if(reply != nullptr)
@@ -195,10 +251,10 @@ void HttpDownloader::setPostParameters(const QStringList& parameters)
     postParametersQuery.insert(parameters.at(i), parameters.at(i + 1));
 }
 
-void HttpDownloader::enableCache(int secondsTimeout)
+void HttpDownloader::enableCache(int secondsTimeout, int maxEntries)
 {
   delete dataCache;
-  dataCache = new atools::util::TimedCache<QString, QByteArray>(secondsTimeout);
+  dataCache = new atools::util::TimedCache<QString, QByteArray>(secondsTimeout, maxEntries);
 }
 
 void HttpDownloader::disableCache()
@@ -207,11 +263,119 @@ void HttpDownloader::disableCache()
   dataCache = nullptr;
 }
 
+void HttpDownloader::enableConditionalRequests(const QString& cacheDirectory)
+{
+  conditionalRequests = true;
+  conditionalCacheDir = cacheDirectory;
+  conditionalEntries.clear();
+  conditionalDelivered.clear();
+
+  if(!conditionalCacheDir.isEmpty() && !QDir().mkpath(conditionalCacheDir))
+    qWarning() << Q_FUNC_INFO << "Cannot create" << conditionalCacheDir;
+}
+
+void HttpDownloader::setScheduler(DownloadScheduler *downloadScheduler, int requestPriority)
+{
+  cancelDownload();
+  scheduler = downloadScheduler;
+  priority = requestPriority;
+}
+
+QNetworkAccessManager *HttpDownloader::networkManager()
+{
+  return scheduler.isNull() ? &ownNetworkManager : scheduler->getNetworkManager();
+}
+
+void HttpDownloader::disableConditionalRequests()
+{
+  conditionalRequests = false;
+  conditionalCacheDir.clear();
+  conditionalEntries.clear();
+  conditionalDelivered.clear();
+  conditionalUrl.clear();
+}
+
+QString HttpDownloader::conditionalCacheFile(const QString& url) const
+{
+  return conditionalCacheDir + QDir::separator() +
+         QString::fromLatin1(QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".httpcache";
+}
+
+const HttpDownloader::ConditionalEntry *HttpDownloader::conditionalEntry(const QString& url)
+{
+  QHash<QString, ConditionalEntry>::const_iterator it = conditionalEntries.constFind(url);
+  if(it != conditionalEntries.constEnd())
+    return &it.value();
+
+  if(!conditionalCacheDir.isEmpty())
+  {
+    // Not in memory - try to load from disk
+    QFile file(conditionalCacheFile(url));
+    if(file.open(QIODevice::ReadOnly))
+    {
+      QDataStream in(&file);
+      in.setVersion(QDataStream::Qt_5_5);
+
+      quint32 magic = 0;
+      quint16 version = 0;
+      QString fileUrl;
+      ConditionalEntry entry;
+      in >> magic >> version >> fileUrl >> entry.etag >> entry.lastModified >> entry.data;
+
+      if(in.status() == QDataStream::Ok && magic == CONDITIONAL_MAGIC_NUMBER && version == CONDITIONAL_VERSION &&
+         fileUrl == url)
+      {
+        if(verbose)
+          qDebug() << Q_FUNC_INFO << "Loaded" << url << entry.etag << entry.lastModified << entry.data.size();
+        return &conditionalEntries.insert(url, entry).value();
+      }
+      else
+        qWarning() << Q_FUNC_INFO << "Invalid cache file" << file.fileName();
+    }
+  }
+  return nullptr;
+}
+
+void HttpDownloader::updateConditionalEntry(const QString& url)
+{
+  ConditionalEntry entry;
+  entry.etag = reply->rawHeader("ETag");
+  entry.lastModified = reply->rawHeader("Last-Modified");
+
+  if(entry.etag.isEmpty() && entry.lastModified.isEmpty())
+  {
+    // Server does not support validators - nothing to remember
+    conditionalEntries.remove(url);
+    return;
+  }
+
+  entry.data = data;
+  conditionalEntries.insert(url, entry);
+
+  if(!conditionalCacheDir.isEmpty())
+  {
+    QSaveFile file(conditionalCacheFile(url));
+    if(file.open(QIODevice::WriteOnly))
+    {
+      QDataStream out(&file);
+      out.setVersion(QDataStream::Qt_5_5);
+      out << CONDITIONAL_MAGIC_NUMBER << CONDITIONAL_VERSION << url << entry.etag << entry.lastModified << entry.data;
+
+      if(out.status() != QDataStream::Ok || !file.commit())
+        qWarning() << Q_FUNC_INFO << "Cannot write" << file.fileName() << file.errorString();
+    }
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write" << file.fileName() << file.errorString();
+  }
+}
+
 void HttpDownloader::startTimer()
 {
   if(updatePeriodSeconds > 0)
   {
-    updateTimer.setInterval(updatePeriodSeconds * 1000);
+    // Spread periodic requests of all downloaders using the scheduler
+    int intervalMs = updatePeriodSeconds * 1000;
+    updateTimer.setInterval(scheduler.isNull() ? intervalMs : scheduler->jitter(intervalMs));
     updateTimer.start();
   }
   else
@@ -249,11 +413,17 @@ void HttpDownloader::setDefaultUserAgentShort(const QString& extension)
 void HttpDownloader::debugDumpContainerSizes() const
 {
   if(dataCache != nullptr)
-    qDebug() << Q_FUNC_INFO << "dataCache->size()" << dataCache->size();
+    qDebug() << Q_FUNC_INFO << "dataCache->size()" << dataCache->size()
+             << "hits" << dataCache->getHits() << "misses" << dataCache->getMisses();
 }
 
 void HttpDownloader::deleteReply()
 {
+  // Remove from queue or free slot
+  if(!scheduler.isNull() && (reply != nullptr || queued))
+    scheduler->release(this);
+  queued = false;
+
   if(reply != nullptr)
   {
     if(verbose)
@@ -291,8 +461,66 @@ void HttpDownloader::httpFinished()
 
     data.append(reply->readAll());
 
+    static atools::util::MetricCounter& downloadCounter =
+      atools::util::Metrics::instance().counter("atools_download_requests_total", "Finished HTTP downloads");
+    static atools::util::MetricCounter& failedCounter =
+      atools::util::Metrics::instance().counter("atools_download_failed_total", "Failed HTTP downloads");
+    static atools::util::MetricCounter& notModifiedCounter =
+      atools::util::Metrics::instance().counter("atools_download_not_modified_total",
+                                                "HTTP downloads answered with 304 not modified");
+    static atools::util::MetricCounter& bytesCounter =
+      atools::util::Metrics::instance().counter("atools_download_received_bytes_total",
+                                                "Bytes received by HTTP downloads after decompression");
+    static atools::util::MetricHistogram& durationHistogram =
+      atools::util::Metrics::instance().histogram("atools_download_duration_seconds", "Time for HTTP downloads");
+
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    downloadCounter.increment();
+    bytesCounter.increment(data.size());
+    if(requestTimer.isValid())
+      durationHistogram.observe(requestTimer.nsecsElapsed() / 1.e9);
+    if(reply->error() != QNetworkReply::NoError)
+      failedCounter.increment();
+    else if(statusCode == 304)
+      notModifiedCounter.increment();
+
     if(reply->error() == QNetworkReply::NoError)
     {
+      if(!conditionalUrl.isEmpty())
+      {
+        if(statusCode == 304)
+        {
+          // Not modified - use stored data ================
+          const ConditionalEntry *entry = conditionalEntry(conditionalUrl);
+          if(entry != nullptr)
+          {
+            data = entry->data;
+
+            if(verbose)
+              qDebug() << Q_FUNC_INFO << "Not modified" << conditionalUrl;
+
+            QString url = reply->url().toString();
+            bool delivered = conditionalDelivered.contains(conditionalUrl);
+            conditionalDelivered.insert(conditionalUrl);
+            deleteReply();
+
+            if(delivered)
+              emit downloadNotModified(url);
+            else
+              emit downloadFinished(data, url);
+            startTimer();
+            return;
+          }
+          else
+            qWarning() << Q_FUNC_INFO << "Not modified but no data for" << conditionalUrl;
+        }
+        else
+        {
+          updateConditionalEntry(conditionalUrl);
+          conditionalDelivered.insert(conditionalUrl);
+        }
+      }
+
       if(dataCache != nullptr)
         dataCache->insert(reply->url().toString(), data);
 
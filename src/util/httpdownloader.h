@@ -18,7 +18,10 @@
 #ifndef ATOOLS_HTTPDOWNLOADER_H
 #define ATOOLS_HTTPDOWNLOADER_H
 
+#include <QElapsedTimer>
 #include <QNetworkAccessManager>
+#include <QPointer>
+#include <QSet>
 #include <QTimer>
 
 class QNetworkReply;
@@ -29,9 +32,12 @@ namespace util {
 template<typename KEY, typename TYPE>
 class TimedCache;
 
+class DownloadScheduler;
+
 /*
  * Simple async HTTP download tool that reads files from web addresses.
  * Has a timer to do recurring downloads and can use a timed cache.
+ * Can use conditional requests to avoid downloading unchanged files again.
  */
 class HttpDownloader :
   public QObject
@@ -80,12 +86,42 @@ public:
     return postParameters;
   }
 
-  /* Enable an internal cache for each request URL */
-  void enableCache(int secondsTimeout);
+  /* Enable an internal cache for each request URL. Least recently used responses are dropped
+   * if more than maxEntries URLs are cached. */
+  void enableCache(int secondsTimeout, int maxEntries = 100);
 
   /* Disable and clear cache*/
   void disableCache();
 
+  /*
+   * Send "If-None-Match" and "If-Modified-Since" headers for GET requests using the "ETag" and "Last-Modified"
+   * values of the last response for the same URL. The server answers with "304 Not Modified" and no body for
+   * unchanged files.
+   *
+   * downloadNotModified is emitted instead of downloadFinished in this case if the data was already delivered
+   * since enabling. Otherwise downloadFinished is emitted with the stored data. getData() returns the stored data
+   * in both cases.
+   *
+   * Responses are kept in memory and are additionally saved in cacheDirectory if not empty to be used across
+   * application restarts. The directory is created if needed.
+   */
+  void enableConditionalRequests(const QString& cacheDirectory = QString());
+
+  /* Disable conditional requests and clear the in-memory cache. Files in the directory are kept. */
+  void disableConditionalRequests();
+
+  /*
+   * Use the shared network manager and request queue of the scheduler instead of an own network manager.
+   * Requests with higher priority are started first if the concurrency limit of the scheduler is reached.
+   * Update periods get a random jitter. Pass null to detach. Cancels any running download.
+   */
+  void setScheduler(DownloadScheduler *downloadScheduler, int requestPriority = 0);
+
+  DownloadScheduler *getScheduler() const
+  {
+    return scheduler.data();
+  }
+
   const QString& getUrl() const
   {
     return downloadUrl;
@@ -131,10 +167,10 @@ public:
    */
   void setDefaultUserAgentShort(const QString& extension = QString());
 
-  /* true if download is in progress */
+  /* true if download is in progress or waiting in the scheduler queue */
   bool isDownloading() const
   {
-    return reply != nullptr;
+    return reply != nullptr || queued;
   }
 
   /* Cancels current request if true. Waits for request to be finished if false */
@@ -194,7 +230,15 @@ signals:
   /* Emitted on SSL errors. Call setIgnoreSslErrors to ignore future errors and continue.  */
   void downloadSslErrors(const QStringList& errors, const QString& downloadUrl);
 
+  /* Server reported that data did not change since last downloadFinished. See enableConditionalRequests(). */
+  void downloadNotModified(QString downloadUrl);
+
 private:
+  friend class DownloadScheduler;
+
+  /* Send network request. Called directly or by the scheduler. */
+  void startRequest();
+
   /* Request completely finished */
   void httpFinished();
 
@@ -208,11 +252,33 @@ private:
 
   void sslErrors(const QList<QSslError>& errors);
 
+  /* Response validators and body for conditional requests */
+  struct ConditionalEntry
+  {
+    QByteArray etag, lastModified, data;
+  };
+
+  /* Get entry from memory or load it from disk. Returns null if not found. */
+  const ConditionalEntry *conditionalEntry(const QString& url);
+
+  /* Store validators of the reply and data in memory and on disk */
+  void updateConditionalEntry(const QString& url);
+
+  QString conditionalCacheFile(const QString& url) const;
+
   bool restartRequest = true, ignoreSslErrors = false, sslErrorLogged = false;
 
   QString curUrl();
 
-  QNetworkAccessManager networkManager;
+  /* Own or shared network manager of scheduler */
+  QNetworkAccessManager *networkManager();
+
+  QNetworkAccessManager ownNetworkManager;
+  QPointer<DownloadScheduler> scheduler;
+  int priority = 0;
+
+  /* Waiting in scheduler queue */
+  bool queued = false;
   QTimer updateTimer;
   QString downloadUrl, userAgent, acceptEncoding;
 
@@ -222,11 +288,27 @@ private:
   int updatePeriodSeconds = -1;
   QNetworkReply *reply = nullptr;
   QByteArray data;
+
+  /* Started when sending the request. Used for metrics. */
+  QElapsedTimer requestTimer;
   bool verbose;
 
   /* Maps URL to result */
   atools::util::TimedCache<QString, QByteArray> *dataCache = nullptr;
 
+  /* Conditional requests ============================== */
+  bool conditionalRequests = false;
+  QString conditionalCacheDir;
+
+  /* Maps URL to validators and data */
+  QHash<QString, ConditionalEntry> conditionalEntries;
+
+  /* URLs which data was already sent by downloadFinished */
+  QSet<QString> conditionalDelivered;
+
+  /* URL used for the current GET request if conditional requests are enabled. Empty otherwise. */
+  QString conditionalUrl;
+
 };
 
 } // namespace util
@@ -0,0 +1,54 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/identkey.h"
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+Q_DECL_CONSTEXPR int IdentKey::MAX_LENGTH;
+
+quint64 IdentKey::encode(const QString& str)
+{
+  quint64 retval = 0;
+  int len = std::min(static_cast<int>(str.size()), MAX_LENGTH);
+  for(int i = 0; i < len; i++)
+  {
+    ushort c = str.at(i).unicode();
+    retval = (retval << 7) | (c < 0x80 ? static_cast<quint64>(c) : static_cast<quint64>('?'));
+  }
+  return retval << (7 * (MAX_LENGTH - len));
+}
+
+QString IdentKey::getString() const
+{
+  QString retval;
+  retval.reserve(MAX_LENGTH);
+  for(int i = 0; i < MAX_LENGTH; i++)
+  {
+    char c = charAt(i);
+    if(c == '\0')
+      break;
+    retval.append(QLatin1Char(c));
+  }
+  return retval;
+}
+
+} // namespace util
+} // namespace atools
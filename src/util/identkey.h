@@ -0,0 +1,239 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_IDENTKEY_H
+#define ATOOLS_UTIL_IDENTKEY_H
+
+#include <QString>
+
+namespace atools {
+namespace util {
+
+/*
+ * Packs short ASCII codes like airport idents, ICAO region codes or runway designators into a 64 bit integer.
+ * Each character uses seven bits and the first character is stored in the highest bits. This keeps the
+ * sort order of the strings.
+ *
+ * Longer strings are truncated to MAX_LENGTH characters like Str<SIZE>. Non ASCII characters are replaced by '?'.
+ * Can be used as key in OpenHash, QHash and QSet.
+ */
+class IdentKey
+{
+public:
+  /* Maximum number of characters */
+  static Q_DECL_CONSTEXPR int MAX_LENGTH = 8;
+
+  Q_DECL_CONSTEXPR IdentKey()
+    : key(0)
+  {
+  }
+
+  explicit IdentKey(const QString& str)
+    : key(encode(str))
+  {
+  }
+
+  /* Use for compile time constants */
+  explicit Q_DECL_CONSTEXPR IdentKey(const char *str)
+    : key(encode(str))
+  {
+  }
+
+  /* Encode ASCII string. Stops at null termination or after MAX_LENGTH characters. */
+  static Q_DECL_CONSTEXPR quint64 encode(const char *str)
+  {
+    quint64 retval = 0;
+    int i = 0;
+    for(; i < MAX_LENGTH && str[i] != '\0'; i++)
+      retval = (retval << 7) | encodeChar(str[i]);
+    return retval << (7 * (MAX_LENGTH - i));
+  }
+
+  static quint64 encode(const QString& str);
+
+  /* Character at position or '\0' if beyond length */
+  Q_DECL_CONSTEXPR char charAt(int index) const
+  {
+    return static_cast<char>((key >> (7 * (MAX_LENGTH - 1 - index))) & 0x7f);
+  }
+
+  /* Decoded string */
+  QString getString() const;
+
+  Q_DECL_CONSTEXPR quint64 getKey() const
+  {
+    return key;
+  }
+
+  Q_DECL_CONSTEXPR bool isEmpty() const
+  {
+    return key == 0;
+  }
+
+  /* Mixed bits for hash tables */
+  Q_DECL_CONSTEXPR quint64 hashValue() const
+  {
+    return mix(key);
+  }
+
+  /* Finalizer from MurmurHash3 */
+  static Q_DECL_CONSTEXPR quint64 mix(quint64 value)
+  {
+    return mix3(mix2(mix1(value)));
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator==(const IdentKey& key1, const IdentKey& key2)
+  {
+    return key1.key == key2.key;
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator!=(const IdentKey& key1, const IdentKey& key2)
+  {
+    return key1.key != key2.key;
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator<(const IdentKey& key1, const IdentKey& key2)
+  {
+    return key1.key < key2.key;
+  }
+
+private:
+  static Q_DECL_CONSTEXPR quint64 encodeChar(char c)
+  {
+    return static_cast<unsigned char>(c) < 0x80 ? static_cast<quint64>(c) : static_cast<quint64>('?');
+  }
+
+  static Q_DECL_CONSTEXPR quint64 mix1(quint64 value)
+  {
+    return (value ^ (value >> 33)) * 0xff51afd7ed558ccdULL;
+  }
+
+  static Q_DECL_CONSTEXPR quint64 mix2(quint64 value)
+  {
+    return (value ^ (value >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+  }
+
+  static Q_DECL_CONSTEXPR quint64 mix3(quint64 value)
+  {
+    return value ^ (value >> 33);
+  }
+
+  quint64 key;
+};
+
+/* Two packed strings like airport ident and runway name */
+class IdentKeyPair
+{
+public:
+  Q_DECL_CONSTEXPR IdentKeyPair()
+  {
+  }
+
+  explicit IdentKeyPair(const QString& firstParam, const QString& secondParam)
+    : first(firstParam), second(secondParam)
+  {
+  }
+
+  explicit Q_DECL_CONSTEXPR IdentKeyPair(const IdentKey& firstParam, const IdentKey& secondParam)
+    : first(firstParam), second(secondParam)
+  {
+  }
+
+  Q_DECL_CONSTEXPR quint64 hashValue() const
+  {
+    return IdentKey::mix(first.getKey() ^ IdentKey::mix(second.getKey()));
+  }
+
+  Q_DECL_CONSTEXPR const IdentKey& getFirst() const
+  {
+    return first;
+  }
+
+  Q_DECL_CONSTEXPR const IdentKey& getSecond() const
+  {
+    return second;
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator==(const IdentKeyPair& key1, const IdentKeyPair& key2)
+  {
+    return key1.first == key2.first && key1.second == key2.second;
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator!=(const IdentKeyPair& key1, const IdentKeyPair& key2)
+  {
+    return !(key1 == key2);
+  }
+
+private:
+  IdentKey first, second;
+};
+
+/* Three packed strings like airport ident, region and ILS ident */
+class IdentKeyTriple
+{
+public:
+  Q_DECL_CONSTEXPR IdentKeyTriple()
+  {
+  }
+
+  explicit IdentKeyTriple(const QString& firstParam, const QString& secondParam, const QString& thirdParam)
+    : first(firstParam), second(secondParam), third(thirdParam)
+  {
+  }
+
+  Q_DECL_CONSTEXPR quint64 hashValue() const
+  {
+    return IdentKey::mix(first.getKey() ^ IdentKey::mix(second.getKey() ^ IdentKey::mix(third.getKey())));
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator==(const IdentKeyTriple& key1, const IdentKeyTriple& key2)
+  {
+    return key1.first == key2.first && key1.second == key2.second && key1.third == key2.third;
+  }
+
+  friend Q_DECL_CONSTEXPR bool operator!=(const IdentKeyTriple& key1, const IdentKeyTriple& key2)
+  {
+    return !(key1 == key2);
+  }
+
+private:
+  IdentKey first, second, third;
+};
+
+} // namespace util
+} // namespace atools
+
+Q_DECLARE_TYPEINFO(atools::util::IdentKey, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::util::IdentKeyPair, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::util::IdentKeyTriple, Q_PRIMITIVE_TYPE);
+
+inline uint qHash(const atools::util::IdentKey& key)
+{
+  return static_cast<uint>(key.hashValue());
+}
+
+inline uint qHash(const atools::util::IdentKeyPair& key)
+{
+  return static_cast<uint>(key.hashValue());
+}
+
+inline uint qHash(const atools::util::IdentKeyTriple& key)
+{
+  return static_cast<uint>(key.hashValue());
+}
+
+#endif // ATOOLS_UTIL_IDENTKEY_H
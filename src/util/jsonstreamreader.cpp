@@ -0,0 +1,226 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/jsonstreamreader.h"
+
+#include "json/nlohmann/json.hpp"
+
+#include <QJsonArray>
+#include <QVector>
+
+namespace atools {
+namespace util {
+
+/* SAX event handler keeping track of the current path and building collected elements */
+class JsonStreamSax
+  : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+  explicit JsonStreamSax(JsonStreamReader *streamReader)
+    : reader(streamReader)
+  {
+  }
+
+  virtual bool null() override
+  {
+    return value(QJsonValue(QJsonValue::Null));
+  }
+
+  virtual bool boolean(bool val) override
+  {
+    return value(QJsonValue(val));
+  }
+
+  /* Numbers are stored as double like QJsonDocument does in Qt 5 */
+  virtual bool number_integer(number_integer_t val) override
+  {
+    return value(QJsonValue(static_cast<double>(val)));
+  }
+
+  virtual bool number_unsigned(number_unsigned_t val) override
+  {
+    return value(QJsonValue(static_cast<double>(val)));
+  }
+
+  virtual bool number_float(number_float_t val, const string_t&) override
+  {
+    return value(QJsonValue(val));
+  }
+
+  virtual bool string(string_t& val) override
+  {
+    return value(QJsonValue(QString::fromUtf8(val.data(), static_cast<int>(val.size()))));
+  }
+
+  virtual bool binary(binary_t&) override
+  {
+    return true;
+  }
+
+  virtual bool key(string_t& val) override
+  {
+    QString key = QString::fromUtf8(val.data(), static_cast<int>(val.size()));
+    if(!builders.isEmpty())
+      builders.last().key = key;
+    else if(!contexts.isEmpty())
+      contexts.last().key = key;
+    return true;
+  }
+
+  virtual bool start_object(std::size_t) override
+  {
+    return start(false);
+  }
+
+  virtual bool end_object() override
+  {
+    return end();
+  }
+
+  virtual bool start_array(std::size_t) override
+  {
+    return start(true);
+  }
+
+  virtual bool end_array() override
+  {
+    return end();
+  }
+
+  virtual bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+  {
+    reader->errorString = QString::fromUtf8(ex.what());
+    reader->errorOffset = static_cast<qint64>(position);
+    return false;
+  }
+
+private:
+  /* Object or array outside of collected elements */
+  struct Context
+  {
+    bool array;
+    QString path, key;
+  };
+
+  /* Object or array inside a collected element */
+  struct Builder
+  {
+    bool array;
+    QJsonObject object;
+    QJsonArray values;
+    QString key;
+  };
+
+  /* Path of a value or container added to the current context */
+  QString childPath() const
+  {
+    if(contexts.isEmpty())
+      return QString();
+
+    const Context& context = contexts.constLast();
+    if(context.array)
+      return context.path;
+    else
+      return context.path.isEmpty() ? context.key : context.path + '/' + context.key;
+  }
+
+  /* Add value to the current builder */
+  void addToBuilder(const QJsonValue& val)
+  {
+    Builder& builder = builders.last();
+    if(builder.array)
+      builder.values.append(val);
+    else
+      builder.object.insert(builder.key, val);
+  }
+
+  bool value(const QJsonValue& val)
+  {
+    if(!builders.isEmpty())
+      addToBuilder(val);
+    else if(reader->valueFunc && !contexts.isEmpty() && !contexts.constLast().array)
+    {
+      QString path = childPath();
+      if(reader->valuePaths.contains(path) && !reader->valueFunc(path, val))
+      {
+        reader->stopped = true;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool start(bool array)
+  {
+    if(!builders.isEmpty() || (!array && !contexts.isEmpty() && contexts.constLast().array &&
+                               reader->arrayPaths.contains(contexts.constLast().path)))
+      // Inside an element or start of an element in a registered array
+      builders.append({array, QJsonObject(), QJsonArray(), QString()});
+    else
+      contexts.append({array, childPath(), QString()});
+    return true;
+  }
+
+  bool end()
+  {
+    if(!builders.isEmpty())
+    {
+      Builder builder = builders.takeLast();
+      QJsonValue val = builder.array ? QJsonValue(builder.values) : QJsonValue(builder.object);
+
+      if(!builders.isEmpty())
+        addToBuilder(val);
+      else if(reader->elementFunc && !reader->elementFunc(contexts.constLast().path, builder.object))
+      {
+        // Element complete and callback wants to stop
+        reader->stopped = true;
+        return false;
+      }
+    }
+    else if(!contexts.isEmpty())
+      contexts.removeLast();
+    return true;
+  }
+
+  JsonStreamReader *reader;
+  QVector<Context> contexts;
+  QVector<Builder> builders;
+};
+
+JsonStreamReader::JsonStreamReader()
+{
+
+}
+
+JsonStreamReader::~JsonStreamReader()
+{
+
+}
+
+bool JsonStreamReader::read(const QByteArray& bytes)
+{
+  stopped = false;
+  errorString.clear();
+  errorOffset = -1;
+
+  JsonStreamSax sax(this);
+  return nlohmann::json::sax_parse(bytes.constData(), bytes.constData() + bytes.size(), &sax);
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,112 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_JSONSTREAMREADER_H
+#define ATOOLS_JSONSTREAMREADER_H
+
+#include <QJsonObject>
+#include <QSet>
+#include <QString>
+
+#include <functional>
+
+namespace atools {
+namespace util {
+
+/*
+ * Streaming JSON reader based on the SAX interface of the bundled nlohmann library.
+ * Reads directly from UTF-8 bytes without building a document for the whole input.
+ *
+ * Objects which are elements of arrays at registered paths are collected one by one into small QJsonObjects
+ * and passed to the element callback. Scalar values at registered paths are passed to the value callback.
+ * Everything else is skipped.
+ *
+ * Paths consist of object keys separated by "/" like "general/update_timestamp" or "clients/pilots".
+ * An empty path denotes the root, i.e. an array at top level. Array elements do not add a path component.
+ * Callbacks can return false to stop reading.
+ */
+class JsonStreamReader
+{
+public:
+  typedef std::function<bool (const QString& path, const QJsonObject& element)> ElementFuncType;
+  typedef std::function<bool (const QString& path, const QJsonValue& value)> ValueFuncType;
+
+  JsonStreamReader();
+  ~JsonStreamReader();
+
+  JsonStreamReader(const JsonStreamReader& other) = delete;
+  JsonStreamReader& operator=(const JsonStreamReader& other) = delete;
+
+  /* Objects in arrays at this path are passed to the element callback */
+  void addArrayPath(const QString& path)
+  {
+    arrayPaths.insert(path);
+  }
+
+  /* Scalar values at this path are passed to the value callback */
+  void addValuePath(const QString& path)
+  {
+    valuePaths.insert(path);
+  }
+
+  void setElementCallback(const ElementFuncType& func)
+  {
+    elementFunc = func;
+  }
+
+  void setValueCallback(const ValueFuncType& func)
+  {
+    valueFunc = func;
+  }
+
+  /* Parse UTF-8 encoded JSON. Returns false on parse error or if a callback stopped reading. */
+  bool read(const QByteArray& bytes);
+
+  /* true if a callback returned false in the last call to read() */
+  bool isStopped() const
+  {
+    return stopped;
+  }
+
+  /* Error message and byte offset of the last parse error. Empty if none. */
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+  qint64 getErrorOffset() const
+  {
+    return errorOffset;
+  }
+
+private:
+  friend class JsonStreamSax;
+
+  QSet<QString> arrayPaths, valuePaths;
+  ElementFuncType elementFunc;
+  ValueFuncType valueFunc;
+
+  bool stopped = false;
+  QString errorString;
+  qint64 errorOffset = -1;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_JSONSTREAMREADER_H
@@ -0,0 +1,145 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/memoryaccounting.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace util {
+
+MemoryAccountable::~MemoryAccountable()
+{
+  if(memoryRegistered)
+    MemoryAccounting::instance().remove(this);
+}
+
+void MemoryAccountable::releaseMemory(qint64)
+{
+}
+
+MemoryAccounting::MemoryAccounting()
+{
+}
+
+MemoryAccounting& MemoryAccounting::instance()
+{
+  static MemoryAccounting accounting;
+  return accounting;
+}
+
+void MemoryAccounting::add(const QString& name, MemoryAccountable *object)
+{
+  if(object == nullptr)
+    return;
+
+  QMutexLocker locker(&mutex);
+  for(const Entry& entry : qAsConst(entries))
+  {
+    if(entry.object == object)
+      return;
+  }
+
+  entries.append(Entry({name, object}));
+  object->memoryRegistered = true;
+}
+
+void MemoryAccounting::remove(MemoryAccountable *object)
+{
+  QMutexLocker locker(&mutex);
+  for(int i = entries.size() - 1; i >= 0; i--)
+  {
+    if(entries.at(i).object == object)
+      entries.remove(i);
+  }
+  object->memoryRegistered = false;
+}
+
+void MemoryAccounting::setBudget(const QString& name, qint64 maxBytes)
+{
+  QMutexLocker locker(&mutex);
+  if(maxBytes > 0)
+    budgets.insert(name, maxBytes);
+  else
+    budgets.remove(name);
+}
+
+qint64 MemoryAccounting::getBudget(const QString& name) const
+{
+  QMutexLocker locker(&mutex);
+  return budgets.value(name, 0);
+}
+
+QVector<MemoryUsage> MemoryAccounting::getUsage() const
+{
+  QMutexLocker locker(&mutex);
+  QVector<MemoryUsage> usage;
+  for(const Entry& entry : entries)
+  {
+    MemoryUsage u;
+    u.name = entry.name;
+    u.budgetBytes = budgets.value(entry.name, 0);
+    entry.object->getMemoryUsage(u.bytes, u.elements);
+    usage.append(u);
+  }
+  return usage;
+}
+
+qint64 MemoryAccounting::getTotalBytes() const
+{
+  qint64 total = 0;
+  for(const MemoryUsage& usage : getUsage())
+    total += usage.bytes;
+  return total;
+}
+
+int MemoryAccounting::enforceBudgets()
+{
+  QMutexLocker locker(&mutex);
+  int numReleased = 0;
+  for(const Entry& entry : entries)
+  {
+    qint64 budget = budgets.value(entry.name, 0);
+    if(budget > 0)
+    {
+      qint64 bytes = 0, elements = 0;
+      entry.object->getMemoryUsage(bytes, elements);
+      if(bytes > budget)
+      {
+        qDebug() << Q_FUNC_INFO << entry.name << "bytes" << bytes << "budget" << budget;
+        entry.object->releaseMemory(budget);
+        numReleased++;
+      }
+    }
+  }
+  return numReleased;
+}
+
+void MemoryAccounting::debugDump() const
+{
+  qint64 total = 0;
+  for(const MemoryUsage& usage : getUsage())
+  {
+    qDebug().nospace() << usage.name << ": " << usage.bytes / 1024 << " kB, " << usage.elements << " elements"
+                       << (usage.budgetBytes > 0 ? QString(", budget %1 kB").arg(usage.budgetBytes / 1024) : QString());
+    total += usage.bytes;
+  }
+  qDebug().nospace() << "Total: " << total / 1024 << " kB";
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,154 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_MEMORYACCOUNTING_H
+#define ATOOLS_UTIL_MEMORYACCOUNTING_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace util {
+
+/* Memory used by one registered cache or index */
+struct MemoryUsage
+{
+  QString name;
+  qint64 bytes = 0, elements = 0;
+
+  /* Budget set by MemoryAccounting::setBudget() or 0 if none */
+  qint64 budgetBytes = 0;
+};
+
+/*
+ * Interface for caches and indexes which report their approximate heap memory usage.
+ * Objects are registered with MemoryAccounting::add() and remove themselves on destruction.
+ */
+class MemoryAccountable
+{
+public:
+  MemoryAccountable()
+  {
+  }
+
+  /* Copies are not registered */
+  MemoryAccountable(const MemoryAccountable&)
+  {
+  }
+
+  MemoryAccountable& operator=(const MemoryAccountable&)
+  {
+    return *this;
+  }
+
+  virtual ~MemoryAccountable();
+
+  /* Add approximate heap bytes and number of elements like stations, nodes or cache entries */
+  virtual void getMemoryUsage(qint64& bytes, qint64& elements) const = 0;
+
+  /* Drop cached or reloadable data to get below maxBytes if possible. Called by MemoryAccounting::enforceBudgets().
+   * Default does nothing which is the case for indexes holding only required data. */
+  virtual void releaseMemory(qint64 maxBytes);
+
+private:
+  friend class MemoryAccounting;
+
+  /* Avoids locking the registry in destructors of objects never registered */
+  bool memoryRegistered = false;
+};
+
+/*
+ * Registry for caches and indexes to get their memory usage at runtime and to keep them within optional budgets.
+ *
+ * The application registers long living objects by name, e.g. "METAR NOAA" or "Route network airway".
+ * Budgets are given by name and can be set before objects are registered. enforceBudgets() asks all objects
+ * exceeding their budget to release memory.
+ *
+ * The registry is thread safe. Usage is collected by calling the objects which are usually not thread safe.
+ * Therefore query usage and enforce budgets in the thread which uses the registered objects.
+ */
+class MemoryAccounting
+{
+public:
+  static MemoryAccounting& instance();
+
+  /* Register object. Name does not have to be unique. The object removes itself on destruction. */
+  void add(const QString& name, atools::util::MemoryAccountable *object);
+  void remove(atools::util::MemoryAccountable *object);
+
+  /* Set budget in bytes for all objects with the given name. 0 removes the budget. */
+  void setBudget(const QString& name, qint64 maxBytes);
+  qint64 getBudget(const QString& name) const;
+
+  /* Usage of all registered objects in registration order */
+  QVector<atools::util::MemoryUsage> getUsage() const;
+
+  /* Sum of all registered objects */
+  qint64 getTotalBytes() const;
+
+  /* Call releaseMemory() for all objects exceeding their budget. Returns number of objects asked to release. */
+  int enforceBudgets();
+
+  /* Print usage of all registered objects to the log */
+  void debugDump() const;
+
+  /* Helpers to estimate heap usage of containers. Do not include heap memory owned by the elements. */
+  template<typename TYPE>
+  static qint64 vectorBytes(const QVector<TYPE>& vector)
+  {
+    return static_cast<qint64>(vector.capacity()) * static_cast<qint64>(sizeof(TYPE));
+  }
+
+  template<typename KEY, typename TYPE>
+  static qint64 hashBytes(const QHash<KEY, TYPE>& hash)
+  {
+    // Bucket array plus one node per entry containing next pointer, hash value, key and value
+    return static_cast<qint64>(hash.capacity()) * static_cast<qint64>(sizeof(void *)) +
+           static_cast<qint64>(hash.size()) *
+           static_cast<qint64>(sizeof(void *) + sizeof(uint) + sizeof(KEY) + sizeof(TYPE));
+  }
+
+  static qint64 stringBytes(const QString& str)
+  {
+    return static_cast<qint64>(str.capacity()) * static_cast<qint64>(sizeof(QChar));
+  }
+
+  static qint64 byteArrayBytes(const QByteArray& bytes)
+  {
+    return static_cast<qint64>(bytes.capacity());
+  }
+
+private:
+  MemoryAccounting();
+
+  struct Entry
+  {
+    QString name;
+    atools::util::MemoryAccountable *object;
+  };
+
+  QVector<Entry> entries;
+  QHash<QString, qint64> budgets;
+  mutable QMutex mutex;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_MEMORYACCOUNTING_H
@@ -0,0 +1,177 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/metrics.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+namespace atools {
+namespace util {
+
+const QVector<double> Metrics::LATENCY_SECONDS({0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1., 2.5, 5.,
+                                                10.});
+
+MetricHistogram::MetricHistogram(const QVector<double>& upperBounds)
+  : bounds(upperBounds)
+{
+  std::sort(bounds.begin(), bounds.end());
+
+  // One more for +Inf
+  buckets.reset(new std::atomic<qint64>[static_cast<size_t>(bounds.size() + 1)]);
+  for(int i = 0; i <= bounds.size(); i++)
+    buckets[static_cast<size_t>(i)].store(0);
+}
+
+void MetricHistogram::observe(double value)
+{
+  int index = static_cast<int>(std::lower_bound(bounds.constBegin(), bounds.constEnd(), value) - bounds.constBegin());
+  buckets[static_cast<size_t>(index)].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+
+  // No fetch_add for floating point atomics in C++14
+  double expected = sum.load(std::memory_order_relaxed);
+  while(!sum.compare_exchange_weak(expected, expected + value, std::memory_order_relaxed))
+    ;
+}
+
+Metrics::Metrics()
+{
+}
+
+Metrics::~Metrics()
+{
+  for(const Entry<MetricCounter>& entry : qAsConst(counters))
+    delete entry.metric;
+  for(const Entry<MetricGauge>& entry : qAsConst(gauges))
+    delete entry.metric;
+  for(const Entry<MetricHistogram>& entry : qAsConst(histograms))
+    delete entry.metric;
+}
+
+Metrics& Metrics::instance()
+{
+  static Metrics metrics;
+  return metrics;
+}
+
+MetricCounter& Metrics::counter(const QString& name, const QString& help)
+{
+  QMutexLocker locker(&mutex);
+  Entry<MetricCounter>& entry = counters[name];
+  if(entry.metric == nullptr)
+  {
+    entry.help = help;
+    entry.metric = new MetricCounter;
+  }
+  return *entry.metric;
+}
+
+MetricGauge& Metrics::gauge(const QString& name, const QString& help)
+{
+  QMutexLocker locker(&mutex);
+  Entry<MetricGauge>& entry = gauges[name];
+  if(entry.metric == nullptr)
+  {
+    entry.help = help;
+    entry.metric = new MetricGauge;
+  }
+  return *entry.metric;
+}
+
+MetricHistogram& Metrics::histogram(const QString& name, const QString& help, const QVector<double>& upperBounds)
+{
+  QMutexLocker locker(&mutex);
+  Entry<MetricHistogram>& entry = histograms[name];
+  if(entry.metric == nullptr)
+  {
+    entry.help = help;
+    entry.metric = new MetricHistogram(upperBounds);
+  }
+  return *entry.metric;
+}
+
+namespace  {
+
+void writeHeader(QByteArray& out, const QString& name, const QString& help, const char *type)
+{
+  QByteArray nameBytes = name.toUtf8();
+
+  // Backslash and line feed have to be escaped in help text
+  QByteArray helpBytes = help.toUtf8();
+  helpBytes.replace('\\', "\\\\").replace('\n', "\\n");
+
+  out.append("# HELP ").append(nameBytes).append(' ').append(helpBytes).append('\n');
+  out.append("# TYPE ").append(nameBytes).append(' ').append(type).append('\n');
+}
+
+QByteArray number(double value)
+{
+  if(std::isinf(value))
+    return value > 0. ? "+Inf" : "-Inf";
+  else if(std::isnan(value))
+    return "NaN";
+  else
+    return QByteArray::number(value, 'g', 17);
+}
+
+} // namespace
+
+QByteArray Metrics::writePrometheus() const
+{
+  QByteArray out;
+  QMutexLocker locker(&mutex);
+
+  for(auto it = counters.constBegin(); it != counters.constEnd(); ++it)
+  {
+    writeHeader(out, it.key(), it.value().help, "counter");
+    out.append(it.key().toUtf8()).append(' ').append(QByteArray::number(it.value().metric->getValue())).append('\n');
+  }
+
+  for(auto it = gauges.constBegin(); it != gauges.constEnd(); ++it)
+  {
+    writeHeader(out, it.key(), it.value().help, "gauge");
+    out.append(it.key().toUtf8()).append(' ').append(QByteArray::number(it.value().metric->getValue())).append('\n');
+  }
+
+  for(auto it = histograms.constBegin(); it != histograms.constEnd(); ++it)
+  {
+    QByteArray name = it.key().toUtf8();
+    const MetricHistogram *histogram = it.value().metric;
+    const QVector<double>& bounds = histogram->getUpperBounds();
+    writeHeader(out, it.key(), it.value().help, "histogram");
+
+    // Buckets are cumulative in the output
+    qint64 cumulative = 0;
+    for(int i = 0; i <= bounds.size(); i++)
+    {
+      cumulative += histogram->getBucketCount(i);
+      out.append(name).append("_bucket{le=\"").
+      append(i < bounds.size() ? number(bounds.at(i)) : QByteArray("+Inf")).append("\"} ").
+      append(QByteArray::number(cumulative)).append('\n');
+    }
+    out.append(name).append("_sum ").append(number(histogram->getSum())).append('\n');
+    out.append(name).append("_count ").append(QByteArray::number(histogram->getCount())).append('\n');
+  }
+
+  return out;
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,160 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_METRICS_H
+#define ATOOLS_UTIL_METRICS_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+namespace atools {
+namespace util {
+
+/* Monotonic counter like number of requests or bytes sent. Lock free. */
+class MetricCounter
+{
+public:
+  void increment(qint64 value = 1)
+  {
+    count.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  qint64 getValue() const
+  {
+    return count.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<qint64> count{0};
+};
+
+/* Value which can go up and down like number of connected clients. Lock free. */
+class MetricGauge
+{
+public:
+  void set(qint64 value)
+  {
+    gauge.store(value, std::memory_order_relaxed);
+  }
+
+  void add(qint64 value)
+  {
+    gauge.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  qint64 getValue() const
+  {
+    return gauge.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<qint64> gauge{0};
+};
+
+/* Distribution of values like latency in seconds in buckets with fixed upper bounds. Lock free. */
+class MetricHistogram
+{
+public:
+  explicit MetricHistogram(const QVector<double>& upperBounds);
+
+  void observe(double value);
+
+  /* Upper bounds in ascending order without the implicit +Inf bucket */
+  const QVector<double>& getUpperBounds() const
+  {
+    return bounds;
+  }
+
+  /* Number of observations in bucket index which is not cumulative. Last index is +Inf. */
+  qint64 getBucketCount(int index) const
+  {
+    return buckets[static_cast<size_t>(index)].load(std::memory_order_relaxed);
+  }
+
+  qint64 getCount() const
+  {
+    return count.load(std::memory_order_relaxed);
+  }
+
+  double getSum() const
+  {
+    return sum.load(std::memory_order_relaxed);
+  }
+
+private:
+  QVector<double> bounds;
+  std::unique_ptr<std::atomic<qint64>[]> buckets;
+  std::atomic<qint64> count{0};
+  std::atomic<double> sum{0.};
+};
+
+/*
+ * Registry for counters, gauges and histograms which can be exported in the Prometheus text format.
+ *
+ * Metrics are created on first access and live until program end. The returned references are stable so
+ * callers should keep them in a function local static variable to avoid the lookup on each update:
+ *
+ * static MetricCounter& requests = Metrics::instance().counter("atools_http_requests_total", "HTTP requests");
+ * requests.increment();
+ *
+ * Names have to follow the Prometheus rules [a-zA-Z_:][a-zA-Z0-9_:]* and should use base units like seconds
+ * and bytes. Creating and exporting is thread safe. Updating metrics does not lock.
+ */
+class Metrics
+{
+public:
+  static Metrics& instance();
+
+  /* Get or create metric. Help text and bounds are used only on creation. */
+  atools::util::MetricCounter& counter(const QString& name, const QString& help);
+  atools::util::MetricGauge& gauge(const QString& name, const QString& help);
+  atools::util::MetricHistogram& histogram(const QString& name, const QString& help,
+                                           const QVector<double>& upperBounds = LATENCY_SECONDS);
+
+  /* All metrics sorted by name in Prometheus text exposition format version 0.0.4 */
+  QByteArray writePrometheus() const;
+
+  /* Default buckets from one millisecond to ten seconds */
+  static const QVector<double> LATENCY_SECONDS;
+
+private:
+  Metrics();
+  ~Metrics();
+
+  template<typename TYPE>
+  struct Entry
+  {
+    QString help;
+    TYPE *metric = nullptr;
+  };
+
+  QMap<QString, Entry<MetricCounter> > counters;
+  QMap<QString, Entry<MetricGauge> > gauges;
+  QMap<QString, Entry<MetricHistogram> > histograms;
+
+  mutable QMutex mutex;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_METRICS_H
@@ -0,0 +1,134 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/microbenchmark.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringBuilder>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+/* Written by keepPointer() to force the compiler to materialize the value */
+static const void *volatile keepSink = nullptr;
+
+MicroBenchmark::MicroBenchmark(int minTimeMsParam, int repetitionsParam)
+  : minTimeMs(std::max(minTimeMsParam, 1)), repetitions(std::max(repetitionsParam, 1))
+{
+}
+
+void MicroBenchmark::keepPointer(const void *pointer)
+{
+  keepSink = pointer;
+}
+
+void MicroBenchmark::run(const QString& name, const std::function<void()>& func, int itemsPerCall)
+{
+  QElapsedTimer timer;
+
+  // Calibrate by doubling number of calls until minimum time is reached - also warms up caches
+  qint64 calls = 1;
+  while(true)
+  {
+    timer.start();
+    for(qint64 i = 0; i < calls; i++)
+      func();
+    qint64 elapsedNs = timer.nsecsElapsed();
+
+    if(elapsedNs >= minTimeMs * 1000000LL || calls >= (Q_INT64_C(1) << 40))
+      break;
+
+    // Jump close to target if far off
+    if(elapsedNs > 0 && elapsedNs < minTimeMs * 100000LL)
+      calls = std::max(calls * 2, calls * minTimeMs * 1000000LL / elapsedNs / 2);
+    else
+      calls *= 2;
+  }
+
+  QVector<double> times;
+  double items = static_cast<double>(calls) * std::max(itemsPerCall, 1);
+  for(int rep = 0; rep < repetitions; rep++)
+  {
+    timer.start();
+    for(qint64 i = 0; i < calls; i++)
+      func();
+    times.append(static_cast<double>(timer.nsecsElapsed()) / items);
+  }
+  std::sort(times.begin(), times.end());
+
+  MicroBenchmarkResult result;
+  result.name = name;
+  result.calls = calls;
+  result.itemsPerCall = std::max(itemsPerCall, 1);
+  result.nsPerItemMin = times.constFirst();
+  result.nsPerItemMedian = times.at(times.size() / 2);
+  results.append(result);
+
+  qInfo().noquote().nospace() << "Benchmark " << name << ": " << result.nsPerItemMedian << " ns median, "
+                              << result.nsPerItemMin << " ns min per item, " << calls << " calls";
+}
+
+QString MicroBenchmark::toCsv() const
+{
+  QString csv("name;calls;items_per_call;ns_per_item_min;ns_per_item_median\n");
+  for(const MicroBenchmarkResult& result : results)
+    csv.append(result.name % ';' % QString::number(result.calls) % ';' % QString::number(result.itemsPerCall) % ';' %
+               QString::number(result.nsPerItemMin, 'f', 3) % ';' % QString::number(result.nsPerItemMedian, 'f', 3) %
+               '\n');
+  return csv;
+}
+
+QString MicroBenchmark::compareCsv(const QString& baselineCsv, double thresholdPercent) const
+{
+  // Read median times by name from baseline skipping header
+  QHash<QString, double> baseline;
+  const QStringList lines = baselineCsv.split('\n');
+  for(int i = 1; i < lines.size(); i++)
+  {
+    const QStringList columns = lines.at(i).trimmed().split(';');
+    if(columns.size() >= 5)
+      baseline.insert(columns.at(0), columns.at(4).toDouble());
+  }
+
+  QString report;
+  for(const MicroBenchmarkResult& result : results)
+  {
+    if(baseline.contains(result.name))
+    {
+      double base = baseline.take(result.name);
+      double percent = base > 0. ? (result.nsPerItemMedian - base) / base * 100. : 0.;
+      QString mark = percent > thresholdPercent ? " SLOWER" : (percent < -thresholdPercent ? " FASTER" : QString());
+      report.append(result.name % ": " % QString::number(base, 'f', 3) % " ns -> " %
+                    QString::number(result.nsPerItemMedian, 'f', 3) % " ns (" %
+                    (percent >= 0. ? "+" : "") % QString::number(percent, 'f', 1) % " %)" % mark % '\n');
+    }
+    else
+      report.append(result.name % ": new\n");
+  }
+
+  for(auto it = baseline.constBegin(); it != baseline.constEnd(); ++it)
+    report.append(it.key() % ": missing\n");
+
+  return report;
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,91 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_MICROBENCHMARK_H
+#define ATOOLS_UTIL_MICROBENCHMARK_H
+
+#include <QVector>
+
+#include <functional>
+
+namespace atools {
+namespace util {
+
+/* Time per item of one benchmark */
+struct MicroBenchmarkResult
+{
+  QString name;
+
+  /* Number of calls per repetition after calibration and items processed per call */
+  qint64 calls = 0, itemsPerCall = 0;
+
+  /* Fastest and median repetition in nanoseconds per item */
+  double nsPerItemMin = 0., nsPerItemMedian = 0.;
+};
+
+/*
+ * Simple harness for micro benchmarks which can be called from applications or command line tools.
+ *
+ * Each benchmark function is calibrated first to find the number of calls which takes at least the minimum time.
+ * Then it is run repetitions times and the fastest and median time per item are recorded.
+ *
+ * Results can be saved as CSV and compared against the CSV of an earlier build to make changes visible.
+ * Benchmark names have to be stable across builds for this.
+ */
+class MicroBenchmark
+{
+public:
+  MicroBenchmark(int minTimeMsParam = 100, int repetitionsParam = 5);
+
+  /* Run func which processes itemsPerCall items on each call and add the result */
+  void run(const QString& name, const std::function<void()>& func, int itemsPerCall = 1);
+
+  const QVector<atools::util::MicroBenchmarkResult>& getResults() const
+  {
+    return results;
+  }
+
+  void clear()
+  {
+    results.clear();
+  }
+
+  /* Semicolon separated with header line. One line per benchmark. */
+  QString toCsv() const;
+
+  /* Compare median times against the CSV of an earlier run. Lists the relative change for each benchmark and
+   * marks changes larger than thresholdPercent. Benchmarks missing in one of the sets are listed too. */
+  QString compareCsv(const QString& baselineCsv, double thresholdPercent = 5.) const;
+
+  /* Prevents the compiler from optimizing away a calculation whose result is not used otherwise */
+  template<typename TYPE>
+  static void keep(const TYPE& value)
+  {
+    keepPointer(&value);
+  }
+
+private:
+  static void keepPointer(const void *pointer);
+
+  QVector<atools::util::MicroBenchmarkResult> results;
+  int minTimeMs, repetitions;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_MICROBENCHMARK_H
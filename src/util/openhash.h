@@ -0,0 +1,179 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_OPENHASH_H
+#define ATOOLS_UTIL_OPENHASH_H
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <vector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Hash map using open addressing with linear probing. Keys and values are stored in flat arrays which avoids
+ * the node allocation of QHash.
+ *
+ * KEY has to provide a quint64 hashValue() method with well mixed bits and operator==, like IdentKey.
+ * KEY and VALUE have to be default constructible and copyable. Elements cannot be removed separately.
+ *
+ * Not thread safe for writing. Concurrent const access is safe.
+ */
+template<typename KEY, typename VALUE>
+class OpenHash
+{
+public:
+  explicit OpenHash(int reserveSize = 0)
+  {
+    if(reserveSize > 0)
+      reserve(reserveSize);
+  }
+
+  /* Insert or replace value for key */
+  void insert(const KEY& key, const VALUE& value);
+
+  /* Pointer to value or null if not found. Pointer is invalid after the next insert. */
+  const VALUE *find(const KEY& key) const
+  {
+    int index = findSlot(key);
+    return index != -1 && used[static_cast<size_t>(index)] ? &values[static_cast<size_t>(index)] : nullptr;
+  }
+
+  /* Value for key or defaultValue if not found */
+  VALUE value(const KEY& key, const VALUE& defaultValue = VALUE()) const
+  {
+    const VALUE *val = find(key);
+    return val != nullptr ? *val : defaultValue;
+  }
+
+  bool contains(const KEY& key) const
+  {
+    return find(key) != nullptr;
+  }
+
+  int size() const
+  {
+    return count;
+  }
+
+  bool isEmpty() const
+  {
+    return count == 0;
+  }
+
+  /* Removes all elements and frees memory */
+  void clear()
+  {
+    keys.clear();
+    values.clear();
+    used.clear();
+    keys.shrink_to_fit();
+    values.shrink_to_fit();
+    used.shrink_to_fit();
+    count = 0;
+  }
+
+  /* Prepare for the given number of elements to avoid rehashing */
+  void reserve(int numElements)
+  {
+    int capacity = MIN_CAPACITY;
+    while(capacity < numElements * 2)
+      capacity *= 2;
+
+    if(capacity > static_cast<int>(keys.size()))
+      rehash(capacity);
+  }
+
+private:
+  static Q_DECL_CONSTEXPR int MIN_CAPACITY = 16;
+
+  /* Index of slot containing key or first free slot. -1 if table is not allocated. */
+  int findSlot(const KEY& key) const;
+
+  /* Resize table to capacity which has to be a power of two */
+  void rehash(int capacity);
+
+  std::vector<KEY> keys;
+  std::vector<VALUE> values;
+  std::vector<quint8> used;
+  int count = 0;
+};
+
+template<typename KEY, typename VALUE>
+Q_DECL_CONSTEXPR int OpenHash<KEY, VALUE>::MIN_CAPACITY;
+
+template<typename KEY, typename VALUE>
+int OpenHash<KEY, VALUE>::findSlot(const KEY& key) const
+{
+  if(keys.empty())
+    return -1;
+
+  // Capacity is power of two and load factor is below 0.5 - always finds a free slot
+  size_t mask = keys.size() - 1;
+  size_t index = static_cast<size_t>(key.hashValue()) & mask;
+  while(used[index] && !(keys[index] == key))
+    index = (index + 1) & mask;
+  return static_cast<int>(index);
+}
+
+template<typename KEY, typename VALUE>
+void OpenHash<KEY, VALUE>::insert(const KEY& key, const VALUE& value)
+{
+  // Keep load factor below 0.5
+  if((count + 1) * 2 > static_cast<int>(keys.size()))
+    rehash(keys.empty() ? MIN_CAPACITY : static_cast<int>(keys.size()) * 2);
+
+  size_t index = static_cast<size_t>(findSlot(key));
+  if(!used[index])
+  {
+    used[index] = 1;
+    keys[index] = key;
+    count++;
+  }
+  values[index] = value;
+}
+
+template<typename KEY, typename VALUE>
+void OpenHash<KEY, VALUE>::rehash(int capacity)
+{
+  std::vector<KEY> oldKeys(static_cast<size_t>(capacity));
+  std::vector<VALUE> oldValues(static_cast<size_t>(capacity));
+  std::vector<quint8> oldUsed(static_cast<size_t>(capacity), 0);
+  oldKeys.swap(keys);
+  oldValues.swap(values);
+  oldUsed.swap(used);
+
+  count = 0;
+  for(size_t i = 0; i < oldKeys.size(); i++)
+  {
+    if(oldUsed[i])
+    {
+      size_t index = static_cast<size_t>(findSlot(oldKeys[i]));
+      used[index] = 1;
+      keys[index] = oldKeys[i];
+      values[index] = oldValues[i];
+      count++;
+    }
+  }
+}
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_OPENHASH_H
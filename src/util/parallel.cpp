@@ -0,0 +1,85 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/parallel.h"
+
+#include <algorithm>
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+namespace atools {
+namespace util {
+
+/* Runs one chunk in the thread pool */
+class ParallelChunk :
+  public QRunnable
+{
+public:
+  ParallelChunk(const ParallelFuncType& funcParam, int beginParam, int endParam, int chunkParam)
+    : func(funcParam), begin(beginParam), end(endParam), chunk(chunkParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    func(begin, end, chunk);
+  }
+
+private:
+  const ParallelFuncType& func;
+  int begin, end, chunk;
+};
+
+int parallelChunks(int size, int numThreads, int minChunkSize)
+{
+  if(numThreads <= 0)
+    numThreads = QThread::idealThreadCount();
+
+  int chunks = std::min(numThreads, size / std::max(minChunkSize, 1));
+  return std::max(chunks, 1);
+}
+
+void parallelFor(int size, int numThreads, const ParallelFuncType& func, int minChunkSize)
+{
+  if(size <= 0)
+    return;
+
+  int chunks = parallelChunks(size, numThreads, minChunkSize);
+  if(chunks == 1)
+    func(0, size, 0);
+  else
+  {
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+
+    int chunkSize = (size + chunks - 1) / chunks;
+    for(int chunk = 0; chunk < chunks; chunk++)
+    {
+      int begin = chunk * chunkSize;
+      int end = std::min(begin + chunkSize, size);
+      if(begin < end)
+        pool.start(new ParallelChunk(func, begin, end, chunk));
+    }
+    pool.waitForDone();
+  }
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,84 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_PARALLEL_H
+#define ATOOLS_UTIL_PARALLEL_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace atools {
+namespace util {
+
+/* Function called for a chunk of the range [begin, end). chunk is in range 0 to number of chunks - 1 and
+ * can be used to access per thread buffers. */
+typedef std::function<void (int begin, int end, int chunk)> ParallelFuncType;
+
+/* Number of chunks used by parallelFor for the given parameters.
+ * numThreads: 0 uses the number of cores. */
+int parallelChunks(int size, int numThreads, int minChunkSize = 1000);
+
+/*
+ * Splits the range 0 to size - 1 in consecutive chunks and calls func for each chunk in a local thread pool.
+ * Blocks until all chunks are done. Runs in the calling thread if only one chunk is needed.
+ *
+ * numThreads: 0 uses the number of cores.
+ * minChunkSize: avoid thread overhead for small ranges.
+ */
+void parallelFor(int size, int numThreads, const ParallelFuncType& func, int minChunkSize = 1000);
+
+/*
+ * Sorts the random access range [begin, end) by sorting chunks in parallel using parallelFor and merging them
+ * afterwards. Not stable. Uses std::sort in the calling thread if only one chunk is needed.
+ *
+ * numThreads: 0 uses the number of cores.
+ */
+template<typename ITER, typename LESS>
+void parallelSort(ITER begin, ITER end, LESS less, int numThreads, int minChunkSize = 10000)
+{
+  int size = static_cast<int>(end - begin);
+  int chunks = parallelChunks(size, numThreads, minChunkSize);
+  if(chunks <= 1)
+  {
+    std::sort(begin, end, less);
+    return;
+  }
+
+  // Chunk boundaries as used by parallelFor - first chunk begins at 0
+  std::vector<int> bounds(static_cast<size_t>(chunks) + 1, size);
+  bounds[0] = 0;
+  parallelFor(size, chunks, [begin, &bounds, less](int chunkBegin, int chunkEnd, int chunk) -> void {
+    bounds[static_cast<size_t>(chunk) + 1] = chunkEnd;
+    std::sort(begin + chunkBegin, begin + chunkEnd, less);
+  }, minChunkSize);
+
+  // Merge neighbour chunks pairwise until only one is left
+  for(size_t width = 1; width < static_cast<size_t>(chunks); width *= 2)
+  {
+    for(size_t i = 0; i + width < static_cast<size_t>(chunks); i += 2 * width)
+    {
+      size_t last = std::min(i + 2 * width, static_cast<size_t>(chunks));
+      std::inplace_merge(begin + bounds.at(i), begin + bounds.at(i + width), begin + bounds.at(last), less);
+    }
+  }
+}
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_PARALLEL_H
@@ -20,11 +20,16 @@
 
 #include <QVariant>
 
+#include <algorithm>
+#include <cstring>
+
 namespace atools {
 namespace util {
 
 using namespace atools::util::ptinternal;
 
+Q_DECL_CONSTEXPR int Prop::INLINE_SIZE;
+
 uint qHash(const atools::util::Prop& prop)
 {
   uint hash = 43;
@@ -55,7 +60,7 @@ uint qHash(const atools::util::Prop& prop)
     case BYTES8:
     case BYTES16:
     case BYTES32:
-      hash ^= ::qHash(prop.getValueBytes());
+      hash ^= static_cast<uint>(::qHashBits(prop.getValueData(), static_cast<size_t>(prop.getValueSize())));
       break;
 
     case INVALID:
@@ -69,8 +74,8 @@ uint qHash(const atools::util::Prop& prop)
 uint qHash(const atools::util::Props& props)
 {
   uint retval = 43;
-  for(auto it = props.constBegin(); it != props.constEnd(); ++it)
-    retval ^= qHash(it.value());
+  for(const Prop& prop : props)
+    retval ^= qHash(prop);
 
   return static_cast<uint>(retval);
 }
@@ -121,20 +126,20 @@ QDataStream& operator<<(QDataStream& out, const Prop& prop)
 
     case BYTES8:
     case STRING8:
-      out << static_cast<quint8>(prop.bytes.size());
-      out.writeRawData(prop.bytes.constData(), prop.bytes.size());
+      out << static_cast<quint8>(prop.getValueSize());
+      out.writeRawData(prop.getValueData(), prop.getValueSize());
       break;
 
     case BYTES16:
     case STRING16:
-      out << static_cast<quint16>(prop.bytes.size());
-      out.writeRawData(prop.bytes.constData(), prop.bytes.size());
+      out << static_cast<quint16>(prop.getValueSize());
+      out.writeRawData(prop.getValueData(), prop.getValueSize());
       break;
 
     case BYTES32:
     case STRING32:
-      out << static_cast<quint32>(prop.bytes.size());
-      out.writeRawData(prop.bytes.constData(), prop.bytes.size());
+      out << static_cast<quint32>(prop.getValueSize());
+      out.writeRawData(prop.getValueData(), prop.getValueSize());
       break;
 
     case NONE:
@@ -230,26 +235,19 @@ QDataStream& operator<<(QDataStream& out, const Props& props)
   int size = std::min(static_cast<qsizetype>(maxSize), static_cast<qsizetype>(props.size()));
 
   int write = 0;
-  int idx = 0;
-  for(auto it = props.constBegin(); it != props.constEnd(); ++it)
+  for(int i = 0; i < size; i++)
   {
-    if(++idx > size)
-      break;
-
-    if(it.value().isValid())
+    if(props.props.at(i).isValid())
       write++;
   }
 
   out << static_cast<Props::propsSizeType>(write);
 
-  idx = 0;
-  for(auto it = props.constBegin(); it != props.constEnd(); ++it)
+  for(int i = 0; i < size; i++)
   {
-    if(++idx > size)
-      break;
-
-    if(it.value().isValid())
-      out << it.value();
+    const Prop& prop = props.props.at(i);
+    if(prop.isValid())
+      out << prop;
   }
   return out;
 }
@@ -259,16 +257,68 @@ QDataStream& operator>>(QDataStream& in, Props& props)
   Props::propsSizeType size;
   in >> size;
 
+  props.props.reserve(props.props.size() + size);
   for(int i = 0; i < size; i++)
   {
     Prop prop;
     in >> prop;
-    props.insert(prop.getKey(), prop);
+    props.addProp(prop);
   }
 
   return in;
 }
 
+// ================================================================================================
+Props::const_iterator Props::lowerBound(int key) const
+{
+  return std::lower_bound(props.constBegin(), props.constEnd(), key, [](const Prop& prop, int k) {
+    return prop.getKey() < k;
+  });
+}
+
+Props::const_iterator Props::upperBound(int key) const
+{
+  return std::upper_bound(props.constBegin(), props.constEnd(), key, [](int k, const Prop& prop) {
+    return k < prop.getKey();
+  });
+}
+
+const Prop *Props::find(int key) const
+{
+  const_iterator it = upperBound(key);
+  if(it != props.constBegin() && (it - 1)->getKey() == key)
+    // Last one with key is the last added
+    return &(*(it - 1));
+  else
+    return nullptr;
+}
+
+QList<Prop> Props::getProps(int key) const
+{
+  QList<Prop> retval;
+  const_iterator first = lowerBound(key);
+  for(const_iterator it = upperBound(key); it != first;)
+    retval.append(*--it);
+  return retval;
+}
+
+void Props::addProp(const Prop& prop)
+{
+  if(props.isEmpty() || props.constLast().getKey() <= prop.getKey())
+    // Keys are usually added in order
+    props.append(prop);
+  else
+    props.insert(static_cast<int>(upperBound(prop.getKey()) - props.constBegin()), prop);
+}
+
+void Props::remove(int key)
+{
+  int first = static_cast<int>(lowerBound(key) - props.constBegin());
+  int last = static_cast<int>(upperBound(key) - props.constBegin());
+  if(last > first)
+    props.remove(first, last - first);
+}
+
 Prop::Prop(int keyParam, const QVariant& valueParam)
   : key(keyParam)
 {
@@ -296,12 +346,12 @@ Prop::Prop(int keyParam, const QVariant& valueParam)
       break;
 
     case QMetaType::QString:
-      bytes = valueParam.toString().toUtf8();
+      setBytes(valueParam.toString().toUtf8());
       setTypeForString();
       break;
 
     case QMetaType::QByteArray:
-      bytes = valueParam.toByteArray();
+      setBytes(valueParam.toByteArray());
       setTypeForBytes();
       break;
 
@@ -321,11 +371,31 @@ Prop::Prop(int keyParam, const QVariant& valueParam)
   }
 }
 
+void Prop::setBytes(const QByteArray& value)
+{
+  if(value.size() <= INLINE_SIZE)
+  {
+    inlined = true;
+    inlineSize = static_cast<quint8>(value.size());
+    if(inlineSize > 0)
+      std::memcpy(number.inlineBytes, value.constData(), inlineSize);
+    bytes.clear();
+  }
+  else
+  {
+    // Shares data with value
+    inlined = false;
+    inlineSize = 0;
+    bytes = value;
+  }
+}
+
 void Prop::setTypeForBytes()
 {
-  if(bytes.size() <= std::numeric_limits<qint8>::max())
+  int size = getValueSize();
+  if(size <= std::numeric_limits<qint8>::max())
     type = BYTES8;
-  else if(bytes.size() <= std::numeric_limits<qint16>::max())
+  else if(size <= std::numeric_limits<qint16>::max())
     type = BYTES16;
   else
     type = BYTES32;
@@ -333,9 +403,10 @@ void Prop::setTypeForBytes()
 
 void Prop::setTypeForString()
 {
-  if(bytes.size() <= std::numeric_limits<qint8>::max())
+  int size = getValueSize();
+  if(size <= std::numeric_limits<qint8>::max())
     type = STRING8;
-  else if(bytes.size() <= std::numeric_limits<qint16>::max())
+  else if(size <= std::numeric_limits<qint16>::max())
     type = STRING16;
   else
     type = STRING32;
@@ -393,7 +464,8 @@ bool Prop::operator==(const Prop& other) const
       case atools::util::BYTES16:
       case atools::util::STRING32:
       case atools::util::BYTES32:
-        return bytes == other.bytes;
+        return getValueSize() == other.getValueSize() &&
+               std::memcmp(getValueData(), other.getValueData(), static_cast<size_t>(getValueSize())) == 0;
 
       case atools::util::NONE:
       case atools::util::INVALID:
@@ -18,7 +18,6 @@
 #ifndef ATOOLS_PROPS_H
 #define ATOOLS_PROPS_H
 
-#include <QMultiHash>
 #include <QVector>
 #include <QDataStream>
 
@@ -63,6 +62,7 @@ enum PropType : quint8
  * Key is an integer and should be defined by the user in an enumeration.
  *
  * Limitation for strings and byte arrays are a max of 2^32-1 characters.
+ * Strings and byte arrays up to INLINE_SIZE bytes are stored inside the object and do not allocate memory.
  *
  * Types and storage size is set internally depending on values.
  *
@@ -160,7 +160,7 @@ public:
   explicit Prop(int keyParam, const QString& valueParam)
     : key(keyParam)
   {
-    bytes = valueParam.toUtf8();
+    setBytes(valueParam.toUtf8());
     setTypeForString();
   }
 
@@ -168,7 +168,7 @@ public:
   explicit Prop(int keyParam, const QByteArray& valueParam)
     : key(keyParam)
   {
-    bytes = valueParam;
+    setBytes(valueParam);
     setTypeForBytes();
   }
 
@@ -247,14 +247,28 @@ public:
 
   QString getValueString() const
   {
-    return QString(bytes);
+    return QString::fromUtf8(getValueData(), getValueSize());
   }
 
   QByteArray getValueBytes() const
   {
-    return bytes;
+    return inlined ? QByteArray(number.inlineBytes, inlineSize) : bytes;
   }
 
+  /* Raw access to string or bytes without creating a copy */
+  const char *getValueData() const
+  {
+    return inlined ? number.inlineBytes : bytes.constData();
+  }
+
+  int getValueSize() const
+  {
+    return inlined ? inlineSize : static_cast<int>(bytes.size());
+  }
+
+  /* Maximum size of strings and bytes stored without allocation */
+  static Q_DECL_CONSTEXPR int INLINE_SIZE = 16;
+
   /* false for default constructed property values */
   bool isValid() const
   {
@@ -266,6 +280,9 @@ private:
   void setTypeForBytes();
   void setTypeForString();
 
+  /* Store inline if small enough */
+  void setBytes(const QByteArray& value);
+
   template<typename TYPE>
   static void readIntType(QDataStream & in, Prop & prop);
   template<typename TYPE>
@@ -282,15 +299,188 @@ private:
   /* Value type */
   ptinternal::PropType type;
 
-  /* Union for all integral data types */
+  /* Size of inlineBytes if inlined is true */
+  quint8 inlineSize = 0;
+  bool inlined = false;
+
+  /* Union for all integral data types and short strings and bytes */
   union
   {
     long long value;
     float floatValue;
     double doubleValue;
+    char inlineBytes[INLINE_SIZE];
   } number;
 
-  /* Byte array for string and bytes */
+  /* Byte array for string and bytes exceeding INLINE_SIZE */
+  QByteArray bytes;
+};
+
+/*
+ *  Multi map for saving, reading and storing property values.
+ *  Invalid values are not saved.
+ *
+ *  Properties are kept in a flat vector sorted by key which is searched binary. Copies are implicitly shared
+ *  and do not allocate. Properties with the same key are kept in order of insertion.
+ *
+ *  Maximum number of properties is limited to 65535.
+ *
+ * Class is hashable.
+ */
+class Props
+{
+public:
+  typedef QVector<atools::util::Prop>::const_iterator const_iterator;
+
+  Props()
+  {
+  }
+
+  Props(std::initializer_list<atools::util::Prop>& props)
+  {
+    for(const atools::util::Prop& prop : props)
+      addProp(prop);
+  }
+
+  Props(const QList<atools::util::Prop>& props)
+  {
+    addProps(props);
+  }
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  Props(const QVector<atools::util::Prop>& props)
+  {
+    addProps(props);
+  }
+
+#endif
+
+  /* Last added property for key or invalid property if not found */
+  atools::util::Prop getProp(int key) const
+  {
+    const atools::util::Prop *prop = find(key);
+    return prop != nullptr ? *prop : atools::util::Prop();
+  }
+
+  atools::util::Prop value(int key) const
+  {
+    return getProp(key);
+  }
+
+  /* Get pointer to last added property for key or null if not found. Valid until next modification. */
+  const atools::util::Prop *find(int key) const;
+
+  /* All properties for key. Last added first. */
+  QList<atools::util::Prop> getProps(int key) const;
+
+  bool contains(int key) const
+  {
+    return find(key) != nullptr;
+  }
+
+  void addProp(const atools::util::Prop& prop);
+
+  void addProps(const QList<atools::util::Prop>& props)
+  {
+    for(const atools::util::Prop& prop:props)
+      addProp(prop);
+  }
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  void addProps(const QVector<atools::util::Prop>& props)
+  {
+    for(const atools::util::Prop& prop:props)
+      addProp(prop);
+  }
+
+#endif
+
+  /* Remove all properties with key */
+  void remove(int key);
+
+  void clear()
+  {
+    props.clear();
+  }
+
+  int size() const
+  {
+    return static_cast<int>(props.size());
+  }
+
+  bool isEmpty() const
+  {
+    return props.isEmpty();
+  }
+
+  /* Iterate over all properties sorted by key */
+  const_iterator constBegin() const
+  {
+    return props.constBegin();
+  }
+
+  const_iterator constEnd() const
+  {
+    return props.constEnd();
+  }
+
+  const_iterator begin() const
+  {
+    return props.constBegin();
+  }
+
+  const_iterator end() const
+  {
+    return props.constEnd();
+  }
+
+  bool operator==(const Props& other) const
+  {
+    return props == other.props;
+  }
+
+  bool operator!=(const Props& other) const
+  {
+    return !operator==(other);
+  }
+
+private:
+  friend QDataStream& operator<<(QDataStream& out, const atools::util::Props& props);
+  friend QDataStream& operator>>(QDataStream& in, atools::util::Props& props);
+
+  /* Range of properties with key */
+  const_iterator lowerBound(int key) const;
+  const_iterator upperBound(int key) const;
+
+  QVector<atools::util::Prop> props;
+
+  typedef quint16 propsSizeType;
+  const static int MAX_PROPS_SIZE = std::numeric_limits<propsSizeType>::max();
+};
+
+uint qHash(const atools::util::Prop& prop);
+  friend QDebug operator<<(QDebug out, const atools::util::Prop& prop);
+
+  /* Hash key as passed in by user in constructors */
+  int key = 0;
+
+  /* Value type */
+  ptinternal::PropType type;
+
+  /* Size of inlineBytes if inlined is true */
+  quint8 inlineSize = 0;
+  bool inlined = false;
+
+  /* Union for all integral data types and short strings and bytes */
+  union
+  {
+    long long value;
+    float floatValue;
+    double doubleValue;
+    char inlineBytes[INLINE_SIZE];
+  } number;
+
+  /* Byte array for string and bytes exceeding INLINE_SIZE */
   QByteArray bytes;
 };
 
@@ -383,8 +573,20 @@ void Prop::readBytesType(QDataStream& in, Prop& prop)
 {
   TYPE size;
   in >> size;
-  prop.bytes.resize(size);
-  in.readRawData(prop.bytes.data(), size);
+  if(size <= INLINE_SIZE)
+  {
+    prop.inlined = true;
+    prop.inlineSize = static_cast<quint8>(size);
+    prop.bytes.clear();
+    in.readRawData(prop.number.inlineBytes, size);
+  }
+  else
+  {
+    prop.inlined = false;
+    prop.inlineSize = 0;
+    prop.bytes.resize(size);
+    in.readRawData(prop.bytes.data(), size);
+  }
 }
 
 } // namespace util
@@ -0,0 +1,271 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/startupscheduler.h"
+
+#include "exception.h"
+#include "util/tracing.h"
+
+#include <QDebug>
+#include <QRunnable>
+#include <QThread>
+
+namespace atools {
+namespace util {
+
+/* Runs the function of one task in the pool and reports back to the scheduler */
+class StartupScheduler::TaskRunnable :
+  public QRunnable
+{
+public:
+  TaskRunnable(StartupScheduler *schedulerParam, int indexParam, const TaskFuncType& funcParam,
+               const QString& nameParam)
+    : scheduler(schedulerParam), index(indexParam), func(funcParam), name(nameParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+#ifdef ATOOLS_TRACING
+    atools::util::TraceSpan span("startup", atools::util::Tracing::internName(name));
+#endif
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::exception_ptr exception;
+    try
+    {
+      func();
+    }
+    catch(...)
+    {
+      exception = std::current_exception();
+    }
+
+    scheduler->taskFinished(index, exception, timer.elapsed());
+  }
+
+private:
+  StartupScheduler *scheduler;
+  int index;
+  TaskFuncType func;
+  QString name;
+};
+
+StartupScheduler::StartupScheduler(int numThreads)
+{
+  pool.setMaxThreadCount(numThreads > 0 ? numThreads : QThread::idealThreadCount());
+}
+
+StartupScheduler::~StartupScheduler()
+{
+  waitForAll();
+  pool.waitForDone();
+}
+
+void StartupScheduler::addTask(const QString& name, const TaskFuncType& func, const QStringList& dependencies)
+{
+  QMutexLocker locker(&mutex);
+  if(started)
+    throw atools::Exception(tr("Cannot add startup task \"%1\" after start").arg(name));
+
+  if(taskIndexByName.contains(name))
+    throw atools::Exception(tr("Duplicate startup task \"%1\"").arg(name));
+
+  Task task;
+  task.name = name;
+  task.func = func;
+  task.dependencyNames = dependencies;
+  taskIndexByName.insert(name, tasks.size());
+  tasks.append(task);
+}
+
+void StartupScheduler::start()
+{
+  QMutexLocker locker(&mutex);
+  if(started)
+    return;
+
+  // Resolve dependencies ===============================
+  for(int i = 0; i < tasks.size(); i++)
+  {
+    Task& task = tasks[i];
+    for(const QString& dependency : qAsConst(task.dependencyNames))
+    {
+      int depIndex = taskIndexByName.value(dependency, -1);
+      if(depIndex == -1)
+        throw atools::Exception(tr("Startup task \"%1\" depends on unknown task \"%2\"").
+                                arg(task.name).arg(dependency));
+
+      tasks[depIndex].dependents.append(i);
+      task.numPendingDependencies++;
+    }
+  }
+
+  // Detect cycles by removing tasks without dependencies until nothing is left ===============================
+  QVector<int> pending(tasks.size()), ready;
+  for(int i = 0; i < tasks.size(); i++)
+  {
+    pending[i] = tasks.at(i).numPendingDependencies;
+    if(pending.at(i) == 0)
+      ready.append(i);
+  }
+
+  int numSorted = 0;
+  while(!ready.isEmpty())
+  {
+    int index = ready.takeLast();
+    numSorted++;
+    for(int dependent : tasks.at(index).dependents)
+    {
+      if(--pending[dependent] == 0)
+        ready.append(dependent);
+    }
+  }
+
+  if(numSorted < tasks.size())
+  {
+    QStringList cycle;
+    for(int i = 0; i < tasks.size(); i++)
+    {
+      if(pending.at(i) > 0)
+        cycle.append(tasks.at(i).name);
+    }
+    throw atools::Exception(tr("Cyclic dependencies in startup tasks %1").arg(cycle.join(tr(", "))));
+  }
+
+  started = true;
+  numUnfinished = tasks.size();
+  startTimer.start();
+
+  for(int i = 0; i < tasks.size(); i++)
+  {
+    if(tasks.at(i).numPendingDependencies == 0)
+      startTask(i);
+  }
+}
+
+void StartupScheduler::startTask(int index)
+{
+  Task& task = tasks[index];
+  task.state = RUNNING;
+  task.waitMs = startTimer.elapsed();
+  pool.start(new TaskRunnable(this, index, task.func, task.name));
+}
+
+void StartupScheduler::taskFinished(int index, std::exception_ptr exception, qint64 runMs)
+{
+  QMutexLocker locker(&mutex);
+
+  Task& task = tasks[index];
+  task.runMs = runMs;
+  task.exception = exception;
+  task.state = exception ? FAILED : DONE;
+  numUnfinished--;
+
+  if(exception)
+    qWarning() << Q_FUNC_INFO << "Startup task" << task.name << "failed";
+
+  // Notify dependents and fail all transitive dependents of a failed task without running them
+  QVector<int> finished({index});
+  while(!finished.isEmpty())
+  {
+    const Task& finishedTask = tasks.at(finished.takeLast());
+    for(int dependent : finishedTask.dependents)
+    {
+      Task& dependentTask = tasks[dependent];
+      if(dependentTask.state != WAITING)
+        continue;
+
+      if(finishedTask.state == FAILED)
+      {
+        dependentTask.state = FAILED;
+        dependentTask.exception = finishedTask.exception;
+        numUnfinished--;
+        finished.append(dependent);
+        qWarning() << Q_FUNC_INFO << "Startup task" << dependentTask.name << "not run due to failed dependency";
+      }
+      else if(--dependentTask.numPendingDependencies == 0)
+        startTask(dependent);
+    }
+  }
+
+  finishedCondition.wakeAll();
+}
+
+void StartupScheduler::waitFor(const QString& name)
+{
+  start();
+
+  QMutexLocker locker(&mutex);
+  int index = taskIndex(name);
+  if(index == -1)
+    throw atools::Exception(tr("Unknown startup task \"%1\"").arg(name));
+
+  while(tasks.at(index).state == WAITING || tasks.at(index).state == RUNNING)
+    finishedCondition.wait(&mutex);
+
+  if(tasks.at(index).exception)
+    std::rethrow_exception(tasks.at(index).exception);
+}
+
+void StartupScheduler::waitForAll()
+{
+  QMutexLocker locker(&mutex);
+  if(!started)
+    return;
+
+  while(numUnfinished > 0)
+    finishedCondition.wait(&mutex);
+}
+
+bool StartupScheduler::isReady(const QString& name) const
+{
+  QMutexLocker locker(&mutex);
+  int index = taskIndex(name);
+  return index != -1 && (tasks.at(index).state == DONE || tasks.at(index).state == FAILED);
+}
+
+QStringList StartupScheduler::getFailedTasks() const
+{
+  QMutexLocker locker(&mutex);
+  QStringList failed;
+  for(const Task& task : tasks)
+  {
+    if(task.state == FAILED)
+      failed.append(task.name);
+  }
+  return failed;
+}
+
+void StartupScheduler::debugDump() const
+{
+  QMutexLocker locker(&mutex);
+  for(const Task& task : tasks)
+    qDebug().noquote().nospace() << "Startup task " << task.name << ": state " << task.state
+                                 << ", started after " << task.waitMs << " ms, ran " << task.runMs << " ms";
+}
+
+int StartupScheduler::taskIndex(const QString& name) const
+{
+  return taskIndexByName.value(name, -1);
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,144 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_STARTUPSCHEDULER_H
+#define ATOOLS_UTIL_STARTUPSCHEDULER_H
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <exception>
+#include <functional>
+
+namespace atools {
+namespace util {
+
+/*
+ * Runs independent startup tasks like loading magnetic declination, MORA grid, route network, aircraft index,
+ * wind and METAR data in a thread pool instead of one after the other.
+ *
+ * Tasks are added by unique name with the names of the tasks they depend on. A task starts as soon as all its
+ * dependencies are finished. Callers block in waitFor() only when they actually need a component.
+ *
+ * Exceptions thrown by a task are kept and rethrown by waitFor(). Tasks depending on a failed task are not run
+ * and fail with the same exception.
+ *
+ * Tasks run in other threads. Database connections cannot be shared between threads, so tasks have to open
+ * their own connection or declare a dependency on the other task using the same connection.
+ * Tasks should declare dependencies instead of calling waitFor() for other tasks since this can block a thread
+ * of the pool.
+ *
+ * Example:
+ * StartupScheduler scheduler;
+ * scheduler.addTask("magdec", [&] {magDecReader->readFromTable(magdecDb);});
+ * scheduler.addTask("routenetwork", [&] {loader->load();}, {"magdec"});
+ * scheduler.start();
+ * ...
+ * scheduler.waitFor("routenetwork");
+ *
+ * All methods are thread safe.
+ */
+class StartupScheduler
+{
+  Q_DECLARE_TR_FUNCTIONS(StartupScheduler)
+
+public:
+  typedef std::function<void ()> TaskFuncType;
+
+  /* numThreads: 0 uses the number of cores */
+  explicit StartupScheduler(int numThreads = 0);
+
+  /* Waits for all started tasks */
+  ~StartupScheduler();
+
+  StartupScheduler(const StartupScheduler& other) = delete;
+  StartupScheduler& operator=(const StartupScheduler& other) = delete;
+
+  /* Add a task. Throws atools::Exception if the name is already used or if the scheduler was already started. */
+  void addTask(const QString& name, const TaskFuncType& func, const QStringList& dependencies = QStringList());
+
+  /* Start all tasks without dependencies. Throws atools::Exception for unknown dependencies or cycles.
+   * Does nothing if already started. */
+  void start();
+
+  /* Block until the task is finished. Calls start() if not done yet.
+   * Rethrows the exception of the task or of a failed dependency. Throws atools::Exception for unknown names. */
+  void waitFor(const QString& name);
+
+  /* Block until all tasks are finished. Does not throw. */
+  void waitForAll();
+
+  /* true if the task is finished successfully or failed. Does not block. */
+  bool isReady(const QString& name) const;
+
+  /* Names of failed tasks including the ones not run due to failed dependencies */
+  QStringList getFailedTasks() const;
+
+  /* Print run time of all tasks to the log */
+  void debugDump() const;
+
+private:
+  class TaskRunnable;
+
+  enum State
+  {
+    WAITING,
+    RUNNING,
+    DONE,
+    FAILED
+  };
+
+  struct Task
+  {
+    QString name;
+    TaskFuncType func;
+    QStringList dependencyNames;
+    QVector<int> dependents;
+    int numPendingDependencies = 0;
+    State state = WAITING;
+    std::exception_ptr exception;
+    qint64 waitMs = 0, runMs = 0;
+  };
+
+  /* Called by runnable when the task function returns. Starts dependents which are ready now. */
+  void taskFinished(int index, std::exception_ptr exception, qint64 runMs);
+
+  /* Mutex has to be locked */
+  void startTask(int index);
+  int taskIndex(const QString& name) const;
+
+  QVector<Task> tasks;
+  QHash<QString, int> taskIndexByName;
+  bool started = false;
+  int numUnfinished = 0;
+  QElapsedTimer startTimer;
+
+  mutable QMutex mutex;
+  QWaitCondition finishedCondition;
+  QThreadPool pool;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_STARTUPSCHEDULER_H
@@ -17,3 +17,258 @@
 
 #include "util/str.h"
 
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ATOOLS_STR_SSE2
+#endif
+
+namespace atools {
+namespace util {
+namespace scan {
+
+static inline uint code(char c)
+{
+  return static_cast<unsigned char>(c);
+}
+
+static inline uint code(QChar c)
+{
+  return c.unicode();
+}
+
+static inline bool isDigit(uint c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static inline bool isAsciiSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+#ifdef ATOOLS_STR_SSE2
+static inline __m128i load(const void *ptr)
+{
+  return _mm_loadu_si128(static_cast<const __m128i *>(ptr));
+}
+
+/* 0xFF or 0xFFFF for each element within the signed range lo to hi. Values with the highest bit set are negative
+ * and never match an ASCII range. */
+static inline __m128i inRange8(__m128i chunk, char lo, char hi)
+{
+  return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                       _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+static inline __m128i inRange16(__m128i chunk, short lo, short hi)
+{
+  return _mm_and_si128(_mm_cmpgt_epi16(chunk, _mm_set1_epi16(static_cast<short>(lo - 1))),
+                       _mm_cmplt_epi16(chunk, _mm_set1_epi16(static_cast<short>(hi + 1))));
+}
+
+#endif
+
+const char *findFirstOf(const char *begin, const char *end, char c1, char c2)
+{
+#ifdef ATOOLS_STR_SSE2
+  const __m128i v1 = _mm_set1_epi8(c1), v2 = _mm_set1_epi8(c2);
+  while(end - begin >= 16)
+  {
+    __m128i chunk = load(begin);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1), _mm_cmpeq_epi8(chunk, v2)));
+    if(mask != 0)
+      return begin + qCountTrailingZeroBits(static_cast<uint>(mask));
+    begin += 16;
+  }
+#endif
+
+  while(begin < end && *begin != c1 && *begin != c2)
+    begin++;
+  return begin;
+}
+
+const QChar *findFirstOf(const QChar *begin, const QChar *end, QChar c1, QChar c2)
+{
+#ifdef ATOOLS_STR_SSE2
+  const __m128i v1 = _mm_set1_epi16(static_cast<short>(c1.unicode())),
+                v2 = _mm_set1_epi16(static_cast<short>(c2.unicode()));
+  while(end - begin >= 8)
+  {
+    __m128i chunk = load(begin);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(chunk, v1), _mm_cmpeq_epi16(chunk, v2)));
+    if(mask != 0)
+      // Two mask bits per character
+      return begin + qCountTrailingZeroBits(static_cast<uint>(mask)) / 2;
+    begin += 8;
+  }
+#endif
+
+  while(begin < end && *begin != c1 && *begin != c2)
+    begin++;
+  return begin;
+}
+
+const char *skipDigits(const char *begin, const char *end)
+{
+#ifdef ATOOLS_STR_SSE2
+  while(end - begin >= 16)
+  {
+    int mask = ~_mm_movemask_epi8(inRange8(load(begin), '0', '9')) & 0xFFFF;
+    if(mask != 0)
+      return begin + qCountTrailingZeroBits(static_cast<uint>(mask));
+    begin += 16;
+  }
+#endif
+
+  while(begin < end && isDigit(code(*begin)))
+    begin++;
+  return begin;
+}
+
+const QChar *skipDigits(const QChar *begin, const QChar *end)
+{
+#ifdef ATOOLS_STR_SSE2
+  while(end - begin >= 8)
+  {
+    int mask = ~_mm_movemask_epi8(inRange16(load(begin), '0', '9')) & 0xFFFF;
+    if(mask != 0)
+      return begin + qCountTrailingZeroBits(static_cast<uint>(mask)) / 2;
+    begin += 8;
+  }
+#endif
+
+  while(begin < end && isDigit(code(*begin)))
+    begin++;
+  return begin;
+}
+
+template<typename CHAR>
+static const CHAR *skipNumberT(const CHAR *begin, const CHAR *end)
+{
+  const CHAR *pos = begin;
+  if(pos < end && (code(*pos) == '-' || code(*pos) == '+'))
+    pos++;
+
+  const CHAR *digits = pos;
+  pos = skipDigits(pos, end);
+  bool hasDigits = pos > digits;
+
+  if(pos < end && code(*pos) == '.')
+  {
+    const CHAR *fraction = skipDigits(pos + 1, end);
+    if(hasDigits || fraction > pos + 1)
+    {
+      hasDigits = true;
+      pos = fraction;
+    }
+  }
+
+  if(!hasDigits)
+    return begin;
+
+  // Exponent is only used if followed by digits
+  if(pos < end && (code(*pos) == 'e' || code(*pos) == 'E'))
+  {
+    const CHAR *exp = pos + 1;
+    if(exp < end && (code(*exp) == '-' || code(*exp) == '+'))
+      exp++;
+
+    const CHAR *expEnd = skipDigits(exp, end);
+    if(expEnd > exp)
+      pos = expEnd;
+  }
+  return pos;
+}
+
+const char *skipNumber(const char *begin, const char *end)
+{
+  return skipNumberT(begin, end);
+}
+
+const QChar *skipNumber(const QChar *begin, const QChar *end)
+{
+  return skipNumberT(begin, end);
+}
+
+bool isAscii(const char *begin, const char *end)
+{
+#ifdef ATOOLS_STR_SSE2
+  while(end - begin >= 16)
+  {
+    if(_mm_movemask_epi8(load(begin)) != 0)
+      return false;
+    begin += 16;
+  }
+#endif
+
+  for(; begin < end; begin++)
+  {
+    if(code(*begin) > 127)
+      return false;
+  }
+  return true;
+}
+
+void toUpperAscii(char *begin, char *end)
+{
+#ifdef ATOOLS_STR_SSE2
+  const __m128i diff = _mm_set1_epi8(0x20);
+  while(end - begin >= 16)
+  {
+    __m128i chunk = load(begin);
+    __m128i lower = inRange8(chunk, 'a', 'z');
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(begin), _mm_sub_epi8(chunk, _mm_and_si128(lower, diff)));
+    begin += 16;
+  }
+#endif
+
+  for(; begin < end; begin++)
+  {
+    if(*begin >= 'a' && *begin <= 'z')
+      *begin = static_cast<char>(*begin - 0x20);
+  }
+}
+
+void toUpperAscii(QChar *begin, QChar *end)
+{
+#ifdef ATOOLS_STR_SSE2
+  const __m128i diff = _mm_set1_epi16(0x20);
+  while(end - begin >= 8)
+  {
+    __m128i chunk = load(begin);
+    __m128i lower = inRange16(chunk, 'a', 'z');
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(begin), _mm_sub_epi16(chunk, _mm_and_si128(lower, diff)));
+    begin += 8;
+  }
+#endif
+
+  for(; begin < end; begin++)
+  {
+    ushort c = begin->unicode();
+    if(c >= 'a' && c <= 'z')
+      *begin = QChar(static_cast<ushort>(c - 0x20));
+  }
+}
+
+void trim(const char *& begin, const char *& end)
+{
+  while(begin < end && isAsciiSpace(*begin))
+    begin++;
+  while(end > begin && isAsciiSpace(end[-1]))
+    end--;
+}
+
+void trim(const QChar *& begin, const QChar *& end)
+{
+  while(begin < end && begin->isSpace())
+    begin++;
+  while(end > begin && end[-1].isSpace())
+    end--;
+}
+
+} // namespace scan
+} // namespace util
+} // namespace atools
+
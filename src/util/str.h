@@ -223,6 +223,42 @@ private:
   Str<SIZE> first, second, third;
 };
 
+/*
+ * Scanning primitives for parsers working on UTF-16 QString data or UTF-8 byte buffers.
+ *
+ * All functions take a half open range [begin, end) and use SSE2 to check 16 bytes at once on x86 platforms.
+ * A plain loop is used on other platforms and for the remaining bytes.
+ */
+namespace scan {
+
+/* Position of the first occurence of c1 or c2 or end if none was found. Pass the same character twice to
+ * search for a single one. */
+const char *findFirstOf(const char *begin, const char *end, char c1, char c2);
+const QChar *findFirstOf(const QChar *begin, const QChar *end, QChar c1, QChar c2);
+
+/* Position of the first character which is not an ASCII digit 0-9 or end */
+const char *skipDigits(const char *begin, const char *end);
+const QChar *skipDigits(const QChar *begin, const QChar *end);
+
+/* End of a number at the start of the range like "-12.5E3" or "42". Returns begin if there is no number.
+ * Does not skip whitespace. */
+const char *skipNumber(const char *begin, const char *end);
+const QChar *skipNumber(const QChar *begin, const QChar *end);
+
+/* true if all bytes are 7-bit ASCII */
+bool isAscii(const char *begin, const char *end);
+
+/* Convert ASCII letters a-z to upper case in place. All other characters are not changed. */
+void toUpperAscii(char *begin, char *end);
+void toUpperAscii(QChar *begin, QChar *end);
+
+/* Move begin and end to exclude leading and trailing whitespace. The UTF-16 version uses the same rules as
+ * QString::trimmed(). The UTF-8 version trims ASCII whitespace only. */
+void trim(const char *& begin, const char *& end);
+void trim(const QChar *& begin, const QChar *& end);
+
+} // namespace scan
+
 } // namespace util
 } // namespace atools
 
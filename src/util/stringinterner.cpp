@@ -0,0 +1,62 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/stringinterner.h"
+
+namespace atools {
+namespace util {
+
+Q_DECL_CONSTEXPR int StringInterner::EMPTY_ID;
+Q_DECL_CONSTEXPR int StringInterner::INVALID_ID;
+
+StringInterner::StringInterner()
+{
+  strings.append(QString());
+}
+
+int StringInterner::intern(const QString& str)
+{
+  if(str.isEmpty())
+    return EMPTY_ID;
+
+  auto it = ids.constFind(str);
+  if(it != ids.constEnd())
+    return it.value();
+
+  int id = strings.size();
+  strings.append(str);
+  ids.insert(str, id);
+  return id;
+}
+
+int StringInterner::find(const QString& str) const
+{
+  if(str.isEmpty())
+    return EMPTY_ID;
+
+  return ids.value(str, INVALID_ID);
+}
+
+void StringInterner::clear()
+{
+  ids.clear();
+  strings.clear();
+  strings.append(QString());
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,78 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_STRINGINTERNER_H
+#define ATOOLS_UTIL_STRINGINTERNER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Maps short strings like idents, ICAO region codes or airway names to compact integer ids and back.
+ * Used during compilation to key hash maps on integers instead of strings.
+ *
+ * Ids are consecutive starting with EMPTY_ID for null or empty strings. They are only valid for the
+ * interner instance that created them.
+ *
+ * intern() is not thread safe. find() and getString() can be called from several threads if no
+ * thread calls intern() at the same time.
+ */
+class StringInterner
+{
+public:
+  /* Id for null and empty strings */
+  static Q_DECL_CONSTEXPR int EMPTY_ID = 0;
+
+  /* Returned by find() if string is not contained */
+  static Q_DECL_CONSTEXPR int INVALID_ID = -1;
+
+  StringInterner();
+
+  /* Get id for string and add it if not already contained */
+  int intern(const QString& str);
+
+  /* Get id for string or INVALID_ID if not contained. Does not modify the interner. */
+  int find(const QString& str) const;
+
+  /* Reverse lookup. id has to be valid. */
+  const QString& getString(int id) const
+  {
+    return strings.at(id);
+  }
+
+  /* Number of strings including the empty string */
+  int size() const
+  {
+    return strings.size();
+  }
+
+  /* Removes all strings. All ids handed out before are invalid afterwards. */
+  void clear();
+
+private:
+  QHash<QString, int> ids;
+  QVector<QString> strings;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_STRINGINTERNER_H
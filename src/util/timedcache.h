@@ -18,42 +18,60 @@
 #ifndef ATOOLS_UTIL_TIMEDCACHE_H
 #define ATOOLS_UTIL_TIMEDCACHE_H
 
-#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <list>
 
 namespace atools {
 namespace util {
 
-/* Simple hash that removes entries on timeout when they are accessed */
+/*
+ * Hash that removes entries on timeout when they are accessed. Can be limited in size in which case
+ * the least recently used entries are removed first.
+ *
+ * Timestamps use a monotonic clock and are not affected by changes of the system time.
+ * A few of the least recently used entries are checked for timeout on each insert to remove stale entries
+ * without a full scan.
+ *
+ * Pointers to values stay valid until the entry is removed, evicted or timed out.
+ * Not thread safe.
+ */
 template<typename KEY, typename TYPE>
 class TimedCache
 {
 public:
-  TimedCache(int timeoutSeconds)
-    : timeout(timeoutSeconds)
+  /* timeoutSeconds < 0 disables timeout. maxEntriesParam <= 0 disables size limit. */
+  explicit TimedCache(int timeoutSeconds = -1, int maxEntriesParam = 0)
+    : timeoutMs(timeoutSeconds < 0 ? -1 : static_cast<qint64>(timeoutSeconds) * 1000), maxEntries(maxEntriesParam)
   {
   }
 
-  /* Add an entry and assign a timestamp to it **/
+  TimedCache(const TimedCache& other) = delete;
+  TimedCache& operator=(const TimedCache& other) = delete;
+
+  /* Add an entry and assign a timestamp to it. Evicts least recently used entries if size limit is exceeded. */
   void insert(const KEY& key, const TYPE& type);
+  void insert(const KEY& key, TYPE&& type);
 
-  /* Check if entry exists. If timed out entry will be removed and method will return null */
+  /* Check if entry exists. If timed out entry will be removed and method will return false.
+   * Does not change usage order and statistics. */
   bool contains(const KEY& key)
   {
-    return checkTimeout(key) != nullptr;
+    EntryIterator it;
+    return lookup(key, it);
   }
 
-  /* Get entry. If timed out entry will be removed and method will return null */
-  TYPE *value(const KEY& key)
-  {
-    return checkTimeout(key);
-  }
+  /* Get entry and mark it as recently used. If timed out entry will be removed and method will return null */
+  TYPE *value(const KEY& key);
 
   void clear()
   {
     hash.clear();
+    entries.clear();
   }
 
-  /* true if object is old. does not modify cache */
+  /* true if object is old or not in cache. does not modify cache */
   bool isTimedOut(const KEY& key) const;
 
   /* Flush from cache if old. true if timed out */
@@ -78,59 +96,179 @@ public:
     return hash.size();
   }
 
+  /* Call func(key, value) for all entries from most to least recently used. Timeout is not triggered. */
+  template<typename FUNC>
+  void forEach(FUNC func) const
+  {
+    for(const Entry& entry : entries)
+      func(entry.key, entry.value);
+  }
+
+  /* Remove all timed out entries */
+  void expire();
+
+  /* Change limit and evict entries if needed. <= 0 disables limit. */
+  void setMaxEntries(int value)
+  {
+    maxEntries = value;
+    evict();
+  }
+
+  int getMaxEntries() const
+  {
+    return maxEntries;
+  }
+
+  /* Lookup statistics of value() */
+  quint64 getHits() const
+  {
+    return hits;
+  }
+
+  quint64 getMisses() const
+  {
+    return misses;
+  }
+
+  void resetStatistics()
+  {
+    hits = misses = 0;
+  }
+
 private:
   struct Entry
   {
+    KEY key;
     TYPE value;
-    QDateTime timestamp;
+    qint64 timestampMs;
   };
 
-  TYPE *checkTimeout(const KEY& key);
+  typedef typename std::list<Entry>::iterator EntryIterator;
+
+  /* Milliseconds from monotonic clock */
+  static qint64 nowMs()
+  {
+    static const QElapsedTimer timer = [] {
+      QElapsedTimer t;
+      t.start();
+      return t;
+    } ();
+    return timer.elapsed();
+  }
+
+  bool isTimedOut(const Entry& entry, qint64 now) const
+  {
+    return timeoutMs >= 0 && entry.timestampMs + timeoutMs < now;
+  }
+
+  /* Get entry and remove it if timed out. Returns false if not found. */
+  bool lookup(const KEY& key, EntryIterator& it);
 
-  QHash<KEY, Entry> hash;
-  int timeout;
+  void removeEntry(EntryIterator it);
+
+  /* Remove least recently used entries exceeding size limit */
+  void evict();
+
+  /* Check the least recently used entries for timeout */
+  void expireSome();
+
+  /* Most recently used at front */
+  std::list<Entry> entries;
+  QHash<KEY, EntryIterator> hash;
+
+  qint64 timeoutMs;
+  int maxEntries;
+  quint64 hits = 0, misses = 0;
+
+  /* Number of least recently used entries to check for timeout on insert */
+  static Q_DECL_CONSTEXPR int EXPIRE_CHECKS = 2;
 };
 
 template<typename KEY, typename TYPE>
 void TimedCache<KEY, TYPE>::insert(const KEY& key, const TYPE& type)
 {
-  hash.insert(key, {type, QDateTime::currentDateTime()});
+  insert(key, TYPE(type));
+}
+
+template<typename KEY, typename TYPE>
+void TimedCache<KEY, TYPE>::insert(const KEY& key, TYPE&& type)
+{
+  qint64 now = nowMs();
+  typename QHash<KEY, EntryIterator>::iterator hashIt = hash.find(key);
+  if(hashIt != hash.end())
+  {
+    // Update existing and move to front
+    EntryIterator it = hashIt.value();
+    it->value = std::move(type);
+    it->timestampMs = now;
+    entries.splice(entries.begin(), entries, it);
+  }
+  else
+  {
+    entries.push_front({key, std::move(type), now});
+    hash.insert(key, entries.begin());
+    evict();
+  }
+
+  expireSome();
 }
 
 template<typename KEY, typename TYPE>
-TYPE *TimedCache<KEY, TYPE>::checkTimeout(const KEY& key)
+TYPE *TimedCache<KEY, TYPE>::value(const KEY& key)
 {
-  if(!hash.contains(key))
+  EntryIterator it;
+  if(lookup(key, it))
+  {
+    hits++;
+    entries.splice(entries.begin(), entries, it);
+    return &it->value;
+  }
+  else
+  {
+    misses++;
     return nullptr;
+  }
+}
+
+template<typename KEY, typename TYPE>
+bool TimedCache<KEY, TYPE>::lookup(const KEY& key, EntryIterator& it)
+{
+  typename QHash<KEY, EntryIterator>::iterator hashIt = hash.find(key);
+  if(hashIt == hash.end())
+    return false;
   else
   {
-    if(isTimedOut(key))
+    it = hashIt.value();
+    if(isTimedOut(*it, nowMs()))
     {
-      hash.remove(key);
-      return nullptr;
+      removeEntry(it);
+      return false;
     }
     else
-      return &hash[key].value;
+      return true;
   }
 }
 
 template<typename KEY, typename TYPE>
 bool TimedCache<KEY, TYPE>::isTimedOut(const KEY& key) const
 {
-  return hash.value(key).timestamp.addSecs(timeout) < QDateTime::currentDateTime();
+  typename QHash<KEY, EntryIterator>::const_iterator hashIt = hash.constFind(key);
+  return hashIt == hash.constEnd() || isTimedOut(*hashIt.value(), nowMs());
 }
 
 template<typename KEY, typename TYPE>
 bool TimedCache<KEY, TYPE>::timeOut(const KEY& key)
 {
-  return checkTimeout(key) == nullptr;
+  EntryIterator it;
+  return !lookup(key, it);
 }
 
 template<typename KEY, typename TYPE>
 TYPE *TimedCache<KEY, TYPE>::valueNoTimeout(const KEY& key)
 {
-  if(containsNoTimeout(key))
-    return &hash[key].value;
+  typename QHash<KEY, EntryIterator>::iterator hashIt = hash.find(key);
+  if(hashIt != hash.end())
+    return &hashIt.value()->value;
   else
     return nullptr;
 }
@@ -149,7 +287,59 @@ TYPE TimedCache<KEY, TYPE>::valueCopyAndTimeout(const KEY& key)
 template<typename KEY, typename TYPE>
 void TimedCache<KEY, TYPE>::remove(const KEY& key)
 {
-  hash.remove(key);
+  typename QHash<KEY, EntryIterator>::iterator hashIt = hash.find(key);
+  if(hashIt != hash.end())
+    removeEntry(hashIt.value());
+}
+
+template<typename KEY, typename TYPE>
+void TimedCache<KEY, TYPE>::removeEntry(EntryIterator it)
+{
+  hash.remove(it->key);
+  entries.erase(it);
+}
+
+template<typename KEY, typename TYPE>
+void TimedCache<KEY, TYPE>::evict()
+{
+  while(maxEntries > 0 && hash.size() > maxEntries)
+    removeEntry(std::prev(entries.end()));
+}
+
+template<typename KEY, typename TYPE>
+void TimedCache<KEY, TYPE>::expireSome()
+{
+  if(timeoutMs < 0)
+    return;
+
+  qint64 now = nowMs();
+  for(int i = 0; i < EXPIRE_CHECKS && !entries.empty(); i++)
+  {
+    EntryIterator last = std::prev(entries.end());
+    if(isTimedOut(*last, now))
+      removeEntry(last);
+    else
+      break;
+  }
+}
+
+template<typename KEY, typename TYPE>
+void TimedCache<KEY, TYPE>::expire()
+{
+  if(timeoutMs < 0)
+    return;
+
+  qint64 now = nowMs();
+  for(EntryIterator it = entries.begin(); it != entries.end();)
+  {
+    if(isTimedOut(*it, now))
+    {
+      hash.remove(it->key);
+      it = entries.erase(it);
+    }
+    else
+      ++it;
+  }
 }
 
 } // namespace util
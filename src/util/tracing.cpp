@@ -0,0 +1,228 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/tracing.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+#include <chrono>
+#include <memory>
+
+namespace atools {
+namespace util {
+
+std::atomic_bool Tracing::enabled(false);
+
+namespace  {
+
+struct TraceEvent
+{
+  const char *category, *name;
+  qint64 startNs, durationNs;
+};
+
+/* Spans of one thread. Mutex is only contended while writing the trace. */
+struct ThreadBuffer
+{
+  QMutex mutex;
+  QVector<TraceEvent> events;
+  QString threadName;
+  int threadId = 0;
+  qint64 dropped = 0;
+};
+
+/* Keeps buffers of all threads including finished ones */
+struct Registry
+{
+  QMutex mutex;
+  QVector<std::shared_ptr<ThreadBuffer> > buffers;
+
+  /* Names given by internName(). Data of the byte arrays is never detached or freed. */
+  QHash<QString, QByteArray> names;
+  std::atomic_int maxEvents{100000};
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+Registry& registry()
+{
+  static Registry reg;
+  return reg;
+}
+
+thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+
+ThreadBuffer *currentBuffer()
+{
+  if(threadBuffer == nullptr)
+  {
+    threadBuffer = std::make_shared<ThreadBuffer>();
+
+    QThread *thread = QThread::currentThread();
+    if(thread != nullptr && !thread->objectName().isEmpty())
+      threadBuffer->threadName = thread->objectName();
+    else if(QCoreApplication::instance() != nullptr && thread == QCoreApplication::instance()->thread())
+      threadBuffer->threadName = QStringLiteral("Main");
+
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.buffers.append(threadBuffer);
+    threadBuffer->threadId = reg.buffers.size();
+    if(threadBuffer->threadName.isEmpty())
+      threadBuffer->threadName = QString("Thread %1").arg(threadBuffer->threadId);
+  }
+  return threadBuffer.get();
+}
+
+void appendEscaped(QByteArray& out, const QByteArray& str)
+{
+  out.append('"');
+  for(char c : str)
+  {
+    if(c == '"' || c == '\\')
+      out.append('\\').append(c);
+    else if(static_cast<unsigned char>(c) < 0x20)
+      out.append(' ');
+    else
+      out.append(c);
+  }
+  out.append('"');
+}
+
+/* Nanoseconds to the microseconds used by the trace format */
+QByteArray micros(qint64 ns)
+{
+  return QByteArray::number(ns / 1000) + '.' + QByteArray::number(ns % 1000).rightJustified(3, '0');
+}
+
+} // namespace
+
+void Tracing::setEnabled(bool value)
+{
+  enabled.store(value);
+}
+
+void Tracing::setMaxEventsPerThread(int value)
+{
+  registry().maxEvents.store(value);
+}
+
+qint64 Tracing::nowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              registry().start).count();
+}
+
+const char *Tracing::internName(const QString& name)
+{
+  Registry& reg = registry();
+  QMutexLocker locker(&reg.mutex);
+  auto it = reg.names.find(name);
+  if(it == reg.names.end())
+    it = reg.names.insert(name, name.toUtf8());
+  return it.value().constData();
+}
+
+void Tracing::addSpan(const char *category, const char *name, qint64 startNs, qint64 durationNs)
+{
+  if(!isEnabled())
+    return;
+
+  ThreadBuffer *buffer = currentBuffer();
+  QMutexLocker locker(&buffer->mutex);
+  if(buffer->events.size() < registry().maxEvents.load(std::memory_order_relaxed))
+    buffer->events.append(TraceEvent({category, name, startNs, durationNs}));
+  else
+    buffer->dropped++;
+}
+
+void Tracing::clear()
+{
+  Registry& reg = registry();
+  QMutexLocker locker(&reg.mutex);
+  for(const std::shared_ptr<ThreadBuffer>& buffer : qAsConst(reg.buffers))
+  {
+    QMutexLocker bufferLocker(&buffer->mutex);
+    buffer->events.clear();
+    buffer->dropped = 0;
+  }
+}
+
+QByteArray Tracing::writeChromeTrace()
+{
+  QByteArray out("{\"traceEvents\":[\n");
+  QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+  bool first = true;
+
+  Registry& reg = registry();
+  QMutexLocker locker(&reg.mutex);
+  for(const std::shared_ptr<ThreadBuffer>& buffer : qAsConst(reg.buffers))
+  {
+    QMutexLocker bufferLocker(&buffer->mutex);
+    QByteArray tid = QByteArray::number(buffer->threadId);
+
+    // Metadata event giving the thread a name in the timeline
+    if(!first)
+      out.append(",\n");
+    first = false;
+    out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid).append(",\"tid\":").append(tid).
+    append(",\"args\":{\"name\":");
+    appendEscaped(out, buffer->threadName.toUtf8());
+    out.append("}}");
+
+    for(const TraceEvent& event : qAsConst(buffer->events))
+    {
+      out.append(",\n{\"name\":");
+      appendEscaped(out, QByteArray(event.name));
+      out.append(",\"cat\":");
+      appendEscaped(out, QByteArray(event.category));
+      out.append(",\"ph\":\"X\",\"ts\":").append(micros(event.startNs)).
+      append(",\"dur\":").append(micros(event.durationNs)).
+      append(",\"pid\":").append(pid).append(",\"tid\":").append(tid).append('}');
+    }
+
+    if(buffer->dropped > 0)
+      qWarning() << Q_FUNC_INFO << "Thread" << buffer->threadName << "dropped" << buffer->dropped << "spans";
+  }
+  out.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+  return out;
+}
+
+bool Tracing::writeChromeTrace(const QString& filename)
+{
+  QSaveFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(writeChromeTrace());
+    if(file.commit())
+    {
+      qInfo() << Q_FUNC_INFO << "Trace written to" << filename;
+      return true;
+    }
+  }
+
+  qWarning() << Q_FUNC_INFO << "Cannot write trace to" << filename << file.errorString();
+  return false;
+}
+
+} // namespace util
+} // namespace atools
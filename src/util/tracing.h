@@ -0,0 +1,116 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_TRACING_H
+#define ATOOLS_UTIL_TRACING_H
+
+#include <QString>
+
+#include <atomic>
+
+/*
+ * Span macros which are compiled out completely unless ATOOLS_TRACING is defined.
+ * Set the environment variable ATOOLS_TRACING to "true" before running qmake to enable them.
+ *
+ * Category and name have to be string literals or other strings living until the trace is written.
+ * Example:
+ * ATOOLS_TRACE_SPAN("compile", "writeSceneryArea");
+ */
+#ifdef ATOOLS_TRACING
+#define ATOOLS_TRACE_CONCAT_INTERNAL(a, b) a ## b
+#define ATOOLS_TRACE_CONCAT(a, b) ATOOLS_TRACE_CONCAT_INTERNAL(a, b)
+#define ATOOLS_TRACE_SPAN(category, name) \
+  atools::util::TraceSpan ATOOLS_TRACE_CONCAT(traceSpan, __LINE__)(category, name)
+#else
+#define ATOOLS_TRACE_SPAN(category, name)
+#endif
+
+namespace atools {
+namespace util {
+
+/*
+ * Collects complete spans per thread and writes them in the Chrome trace event format. The resulting JSON file
+ * can be opened in chrome://tracing or https://ui.perfetto.dev to show a timeline of all threads.
+ *
+ * Each thread appends to its own buffer which is locked only when writing the trace. Recording has to be
+ * enabled at runtime by setEnabled() too. Spans are ignored if disabled or if the buffer of a thread is full.
+ * Buffers of finished threads are kept until clear() is called.
+ */
+class Tracing
+{
+public:
+  /* Enable or disable recording at runtime. Disabled by default. Thread safe. */
+  static void setEnabled(bool value);
+
+  static bool isEnabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /* Maximum number of spans per thread. Default is 100000. Applies to new spans. */
+  static void setMaxEventsPerThread(int value);
+
+  /* Chrome trace JSON with all spans recorded so far including thread names. Thread safe. */
+  static QByteArray writeChromeTrace();
+
+  /* Write trace to file. Returns false and logs a warning on error. */
+  static bool writeChromeTrace(const QString& filename);
+
+  /* Remove all recorded spans. Thread safe. */
+  static void clear();
+
+  /* Monotonic time in nanoseconds since start of tracing */
+  static qint64 nowNs();
+
+  /* Returns a pointer to a copy of name which lives until program end. Allows dynamic span names.
+   * Use only for a limited set of names like compile phases. Thread safe. */
+  static const char *internName(const QString& name);
+
+  /* Add a span for the current thread. Ignored if tracing is disabled. */
+  static void addSpan(const char *category, const char *name, qint64 startNs, qint64 durationNs);
+
+private:
+  static std::atomic_bool enabled;
+};
+
+/* Records the time between construction and destruction as span. Use ATOOLS_TRACE_SPAN instead of this. */
+class TraceSpan
+{
+public:
+  TraceSpan(const char *categoryParam, const char *nameParam)
+    : category(categoryParam), name(nameParam), startNs(Tracing::isEnabled() ? Tracing::nowNs() : -1)
+  {
+  }
+
+  ~TraceSpan()
+  {
+    if(startNs >= 0)
+      Tracing::addSpan(category, name, startNs, Tracing::nowNs() - startNs);
+  }
+
+  TraceSpan(const TraceSpan& other) = delete;
+  TraceSpan& operator=(const TraceSpan& other) = delete;
+
+private:
+  const char *category, *name;
+  qint64 startNs;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_TRACING_H
@@ -19,6 +19,7 @@
 #include "io/tempfile.h"
 #include "exception.h"
 #include "geo/pos.h"
+#include "util/parallel.h"
 
 extern "C" {
 #include <stdio.h>
@@ -47,7 +48,7 @@ namespace wmm {
 /* Copy of MAG_Grid function with simplifications also avoiding the need to write the output to a file */
 QVector<float> MAG_GridInternal(int year, int month,
                                 MAGtype_MagneticModel *magneticModel,
-                                MAGtype_Geoid *Geoid, MAGtype_Ellipsoid ellipsoid);
+                                MAGtype_Geoid *Geoid, MAGtype_Ellipsoid ellipsoid, double stepSize);
 
 // ==============================================================================
 
@@ -61,15 +62,19 @@ MagDecTool::~MagDecTool()
   clear();
 }
 
-void MagDecTool::init(const QDate& dateTimeParam)
+void MagDecTool::init(const QDate& dateTimeParam, float stepDegree)
 {
-  return init(dateTimeParam.year(), dateTimeParam.month());
+  return init(dateTimeParam.year(), dateTimeParam.month(), stepDegree);
 }
 
-void MagDecTool::init(int year, int month)
+void MagDecTool::init(int year, int month, float stepDegree)
 {
   clear();
 
+  gridStep = stepDegree;
+  gridColumns = atools::roundToInt(360.f / stepDegree);
+  gridRows = atools::roundToInt(180.f / stepDegree) + 1;
+
   if(year <= 0 || month <= 0)
   {
     QDateTime dt = QDateTime::currentDateTimeUtc();
@@ -116,8 +121,8 @@ void MagDecTool::init(int year, int month)
   geoid.Geoid_Initialized = 1;
 
   // Calculate declination grid
-  QVector<float> declinations = MAG_GridInternal(year, month, magneticModel, &geoid, ellipsoid);
-  if(declinations.isEmpty())
+  QVector<float> declinations = MAG_GridInternal(year, month, magneticModel, &geoid, ellipsoid, gridStep);
+  if(declinations.size() != gridColumns * gridRows)
     throw atools::Exception(tr("Error in MAG_GridInternal."));
 
   MAG_FreeMagneticModelMemory(magneticModel);
@@ -216,94 +221,92 @@ QVector<float> MagDecTool::readGeoidBuffer()
 }
 
 QVector<float> MAG_GridInternal(int year, int month, MAGtype_MagneticModel *magneticModel,
-                                MAGtype_Geoid *geoid, MAGtype_Ellipsoid ellipsoid)
+                                MAGtype_Geoid *geoid, MAGtype_Ellipsoid ellipsoid, double stepSize)
 {
   // Boundary always covers whole world
-  MAGtype_CoordGeodetic minimum;
-  minimum.phi = -90.;
-  minimum.lambda = -180.;
-  minimum.HeightAboveGeoid = minimum.HeightAboveEllipsoid = 0.;
-  minimum.UseGeoid = 1;
-
-  MAGtype_CoordGeodetic maximum;
-  maximum.phi = 90.;
-  maximum.lambda = 179.;
-  maximum.HeightAboveGeoid = maximum.HeightAboveEllipsoid = 0.;
-  maximum.UseGeoid = 1;
+  const double minPhi = -90., maxPhi = 90., minLambda = -180., maxLambda = 180. - stepSize;
 
   // Only one date - no range
-  MAGtype_Date startdate, enddate;
-  startdate.DecimalYear = enddate.DecimalYear = year + (month - 1) / 12.;
-
-  int numTerms;
-  double b, c;
-
-  MAGtype_MagneticModel *timedMagneticModel;
-  MAGtype_CoordSpherical coordSpherical;
-  MAGtype_MagneticResults magneticResultsSph, magneticResultsGeo, magneticResultsSphVar, magneticResultsGeoVar;
-  MAGtype_SphericalHarmonicVariables *sphericalVariables;
-  MAGtype_GeoMagneticElements geoMagneticElements, errors;
-  MAGtype_LegendreFunction *legendreFunction;
+  MAGtype_Date startdate;
+  startdate.DecimalYear = year + (month - 1) / 12.;
 
-  double cord_step_size = 1.;
+  double cord_step_size = stepSize;
   if(fabs(cord_step_size) < 1.0e-10)
     cord_step_size = 99999.0; // checks to make sure that the step_size is not too small
 
-  numTerms = ((magneticModel->nMax + 1) * (magneticModel->nMax + 2) / 2);
-  timedMagneticModel = MAG_AllocateModelMemory(numTerms);
-  legendreFunction = MAG_AllocateLegendreFunctionMemory(numTerms); // For storing the ALF functions
-  sphericalVariables = MAG_AllocateSphVarMemory(magneticModel->nMax);
+  int numTerms = ((magneticModel->nMax + 1) * (magneticModel->nMax + 2) / 2);
 
-  QVector<float> retval;
-  retval.reserve(360 * 181);
+  // This modifies the Magnetic coefficients to the correct date.
+  // Done once since all grid points use the same date. Read only after this and shared by all threads.
+  MAGtype_MagneticModel *timedMagneticModel = MAG_AllocateModelMemory(numTerms);
+  MAG_TimelyModifyMagneticModel(startdate, magneticModel, timedMagneticModel);
 
-  b = minimum.phi;
-  c = minimum.lambda;
-  for(minimum.phi = b; minimum.phi <= maximum.phi; minimum.phi += cord_step_size) // Latitude Y loop
-  {
-    for(minimum.lambda = c; minimum.lambda <= maximum.lambda; minimum.lambda += cord_step_size) // Longitude X loop
+  // Use counters to avoid accumulating rounding errors for fractional steps
+  int numLat = atools::roundToInt((maxPhi - minPhi) / cord_step_size) + 1;
+  int numLon = atools::roundToInt((maxLambda - minLambda) / cord_step_size) + 1;
+
+  QVector<float> retval(numLat * numLon);
+  float *retvalData = retval.data();
+
+  // Calculate latitude rows in parallel. Each chunk uses its own work buffers.
+  // Geoid and model are only read.
+  atools::util::parallelFor(numLat, 0, [&](int begin, int end, int) -> void {
+    MAGtype_CoordGeodetic coordGeodetic;
+    coordGeodetic.HeightAboveGeoid = coordGeodetic.HeightAboveEllipsoid = 0.;
+    coordGeodetic.UseGeoid = 1;
+
+    MAGtype_CoordSpherical coordSpherical;
+    MAGtype_MagneticResults magneticResultsSph, magneticResultsGeo;
+    MAGtype_GeoMagneticElements geoMagneticElements;
+
+    // For storing the ALF functions
+    MAGtype_LegendreFunction *legendreFunction = MAG_AllocateLegendreFunctionMemory(numTerms);
+    MAGtype_SphericalHarmonicVariables *sphericalVariables = MAG_AllocateSphVarMemory(magneticModel->nMax);
+
+    for(int latIdx = begin; latIdx < end; latIdx++) // Latitude Y loop
     {
-      if(geoid->UseGeoid == 1)
-        // This converts the height above mean sea level to height above the WGS-84 ellipsoid
-        MAG_ConvertGeoidToEllipsoidHeight(&minimum, geoid);
-      else
-        minimum.HeightAboveEllipsoid = minimum.HeightAboveGeoid;
+      coordGeodetic.phi = minPhi + latIdx * cord_step_size;
+      float *row = retvalData + latIdx * numLon;
 
-      MAG_GeodeticToSpherical(ellipsoid, minimum, &coordSpherical);
+      for(int lonIdx = 0; lonIdx < numLon; lonIdx++) // Longitude X loop
+      {
+        coordGeodetic.lambda = minLambda + lonIdx * cord_step_size;
 
-      // Compute Spherical Harmonic variables
-      MAG_ComputeSphericalHarmonicVariables(ellipsoid, coordSpherical, magneticModel->nMax, sphericalVariables);
+        if(geoid->UseGeoid == 1)
+          // This converts the height above mean sea level to height above the WGS-84 ellipsoid
+          // Height varies with longitude which changes the spherical latitude slightly. Therefore,
+          // the Legendre functions cannot be shared for a whole row without losing accuracy.
+          MAG_ConvertGeoidToEllipsoidHeight(&coordGeodetic, geoid);
+        else
+          coordGeodetic.HeightAboveEllipsoid = coordGeodetic.HeightAboveGeoid;
 
-      // Compute ALF  Equations 5-6, WMM Technical report
-      MAG_AssociatedLegendreFunction(coordSpherical, magneticModel->nMax, legendreFunction);
+        MAG_GeodeticToSpherical(ellipsoid, coordGeodetic, &coordSpherical);
 
-      // This modifies the Magnetic coefficients to the correct date.
-      MAG_TimelyModifyMagneticModel(startdate, magneticModel, timedMagneticModel);
+        // Compute Spherical Harmonic variables
+        MAG_ComputeSphericalHarmonicVariables(ellipsoid, coordSpherical, magneticModel->nMax, sphericalVariables);
 
-      // Accumulate the spherical harmonic coefficients Equations 10:12 , WMM Technical report
-      MAG_Summation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical, &magneticResultsSph);
+        // Compute ALF  Equations 5-6, WMM Technical report
+        MAG_AssociatedLegendreFunction(coordSpherical, magneticModel->nMax, legendreFunction);
 
-      // Sum the Secular Variation Coefficients, Equations 13:15 , WMM Technical report
-      MAG_SecVarSummation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical,
-                          &magneticResultsSphVar);
+        // Accumulate the spherical harmonic coefficients Equations 10:12 , WMM Technical report
+        MAG_Summation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical, &magneticResultsSph);
 
-      // Map the computed Magnetic fields to Geodetic coordinates Equation 16 , WMM Technical report
-      MAG_RotateMagneticVector(coordSpherical, minimum, magneticResultsSph, &magneticResultsGeo);
+        // Map the computed Magnetic fields to Geodetic coordinates Equation 16 , WMM Technical report
+        MAG_RotateMagneticVector(coordSpherical, coordGeodetic, magneticResultsSph, &magneticResultsGeo);
 
-      // Map the secular variation field components to Geodetic coordinates, Equation 17 , WMM Technical report
-      MAG_RotateMagneticVector(coordSpherical, minimum, magneticResultsSphVar, &magneticResultsGeoVar);
+        // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
+        // Secular variation and error estimation are skipped since only the declination is needed
+        MAG_CalculateGeoMagneticElements(&magneticResultsGeo, &geoMagneticElements);
 
-      // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
-      MAG_CalculateGeoMagneticElements(&magneticResultsGeo, &geoMagneticElements);
-      MAG_WMMErrorCalc(geoMagneticElements.H, &errors);
+        row[lonIdx] = static_cast<float>(geoMagneticElements.Decl);
+      } // Longitude Loop
+    } // Latitude Loop
 
-      retval.append(static_cast<float>(geoMagneticElements.Decl));
-    } // Longitude Loop
-  } // Latitude Loop
+    MAG_FreeLegendreMemory(legendreFunction);
+    MAG_FreeSphVarMemory(sphericalVariables);
+  }, 1 /* minChunkSize */);
 
   MAG_FreeMagneticModelMemory(timedMagneticModel);
-  MAG_FreeLegendreMemory(legendreFunction);
-  MAG_FreeSphVarMemory(sphericalVariables);
 
   return retval;
 }
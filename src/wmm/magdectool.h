@@ -46,9 +46,10 @@ public:
   MagDecTool(const MagDecTool& other) = delete;
   MagDecTool& operator=(const MagDecTool& other) = delete;
 
-  /* Build the declination array for current year/month or given values. January = 1 */
-  void init(int year = 0, int month = 1);
-  void init(const QDate& dateTime);
+  /* Build the declination array for current year/month or given values. January = 1
+   * stepDegree is the grid spacing. Has to divide 180 without remainder. */
+  void init(int year = 0, int month = 1, float stepDegree = 1.f);
+  void init(const QDate& dateTime, float stepDegree = 1.f);
 
   /* Get version information for the GeomagnetismLibrary */
   QString getVersion() const;
@@ -58,7 +59,29 @@ public:
 
   float getMagVar(int col, int row)
   {
-    return magdecGrid[col + 180 + (row + 90) * 360];
+    return magdecGrid[gridIndex(col, row)];
+  }
+
+  /* Raw grid ordered by latitude rows from -90 to 90 and longitude from -180 to 180 - step.
+   * Size is getGridColumns() * getGridRows(). */
+  const float *getGrid() const
+  {
+    return magdecGrid;
+  }
+
+  int getGridColumns() const
+  {
+    return gridColumns;
+  }
+
+  int getGridRows() const
+  {
+    return gridRows;
+  }
+
+  float getGridStep() const
+  {
+    return gridStep;
   }
 
   /* Reference date as given or current date */
@@ -84,7 +107,12 @@ public:
 private:
   float getMagVar(float col, float row)
   {
-    return magdecGrid[atools::roundToInt(col) + 180 + (atools::roundToInt(row) + 90) * 360];
+    return magdecGrid[gridIndex(atools::roundToInt(col), atools::roundToInt(row))];
+  }
+
+  int gridIndex(int col, int row) const
+  {
+    return atools::roundToInt((col + 180) / gridStep) + atools::roundToInt((row + 90) / gridStep) * gridColumns;
   }
 
   // Read EGM9615.buf - only needed for grid creating
@@ -93,6 +121,8 @@ private:
   // latY (-90 to 90), lonX (-180 to 179)
   // -90.00 -180.00, -90.00 -179.00 ... 90.00 178.00, 90.00 179.00
   float *magdecGrid = nullptr;
+  float gridStep = 1.f;
+  int gridColumns = 360, gridRows = 181;
 
   QDate referenceDate;
 };
@@ -31,6 +31,8 @@ class QString;
 namespace atools {
 namespace zip {
 
+/* Functions below work on complete buffers. Use GzipDevice to inflate or deflate streams incrementally. */
+
 /* true if input stream is prefixed with Gzip magic number */
 bool isGzipCompressed(const QString& filename);
 bool isGzipCompressed(const QByteArray& bytes);
@@ -0,0 +1,204 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "zip/gzipdevice.h"
+
+#include <QDebug>
+
+#include <limits>
+
+namespace atools {
+namespace zip {
+
+/* Input and output chunk size */
+static const int CHUNK_SIZE = 32 * 1024;
+
+GzipDevice::GzipDevice(QIODevice *sourceDevice, Format streamFormat, int compressionLevel, QObject *parent)
+  : QIODevice(parent), device(sourceDevice), format(streamFormat), level(qBound(-1, compressionLevel, 9))
+{
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.avail_in = 0;
+  stream.next_in = Z_NULL;
+  stream.msg = Z_NULL;
+
+  // Allow incremental reading from network replies
+  connect(device, &QIODevice::readyRead, this, &QIODevice::readyRead);
+}
+
+GzipDevice::~GzipDevice()
+{
+  if(isOpen())
+    close();
+}
+
+bool GzipDevice::open(QIODevice::OpenMode mode)
+{
+  if((mode & QIODevice::ReadWrite) == QIODevice::ReadWrite)
+  {
+    setErrorString(tr("Reading and writing at the same time is not supported"));
+    return false;
+  }
+
+  if(!device->isOpen())
+  {
+    setErrorString(tr("Device not open"));
+    return false;
+  }
+
+  int windowBits = format == ZLIB ? MAX_WBITS : MAX_WBITS + 16;
+  int ret;
+  if(mode & QIODevice::ReadOnly)
+  {
+    // Plus 32 enables automatic header detection
+    if(format == AUTO)
+      windowBits = MAX_WBITS + 32;
+    ret = inflateInit2(&stream, windowBits);
+  }
+  else
+    ret = deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+
+  if(ret != Z_OK)
+  {
+    setZlibError(tr("Cannot initialize zlib"));
+    return false;
+  }
+
+  initialized = true;
+  streamEnd = error = false;
+
+  // Always unbuffered - zlib does the buffering
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void GzipDevice::close()
+{
+  if(initialized)
+  {
+    if(openMode() & QIODevice::WriteOnly)
+    {
+      // Write remaining data and trailer
+      if(!error)
+        deflateToDevice(Z_FINISH);
+      deflateEnd(&stream);
+    }
+    else
+      inflateEnd(&stream);
+    initialized = false;
+  }
+
+  inBuffer.clear();
+  QIODevice::close();
+}
+
+bool GzipDevice::atEnd() const
+{
+  return streamEnd || error || (stream.avail_in == 0 && device->atEnd());
+}
+
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+  if(error)
+    return -1;
+
+  stream.next_out = reinterpret_cast<Bytef *>(data);
+  stream.avail_out = static_cast<uInt>(std::min(maxSize, static_cast<qint64>(std::numeric_limits<uInt>::max())));
+  uInt availOut = stream.avail_out;
+
+  while(stream.avail_out > 0 && !streamEnd)
+  {
+    if(stream.avail_in == 0)
+    {
+      // Refill input buffer - stops if nothing is available yet
+      inBuffer = device->read(CHUNK_SIZE);
+      if(inBuffer.isEmpty())
+        break;
+
+      stream.next_in = reinterpret_cast<Bytef *>(inBuffer.data());
+      stream.avail_in = static_cast<uInt>(inBuffer.size());
+    }
+
+    int ret = inflate(&stream, Z_NO_FLUSH);
+    if(ret == Z_STREAM_END)
+      streamEnd = true;
+    else if(ret != Z_OK && ret != Z_BUF_ERROR)
+    {
+      setZlibError(tr("Error inflating data"));
+      return -1;
+    }
+  }
+
+  return availOut - stream.avail_out;
+}
+
+qint64 GzipDevice::writeData(const char *data, qint64 maxSize)
+{
+  if(error)
+    return -1;
+
+  qint64 written = 0;
+  while(written < maxSize)
+  {
+    qint64 size = std::min(maxSize - written, static_cast<qint64>(CHUNK_SIZE));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + written));
+    stream.avail_in = static_cast<uInt>(size);
+
+    if(!deflateToDevice(Z_NO_FLUSH))
+      return -1;
+    written += size;
+  }
+  return written;
+}
+
+bool GzipDevice::deflateToDevice(int flush)
+{
+  char out[CHUNK_SIZE];
+  int ret;
+  do
+  {
+    stream.next_out = reinterpret_cast<Bytef *>(out);
+    stream.avail_out = CHUNK_SIZE;
+
+    ret = deflate(&stream, flush);
+    if(ret == Z_STREAM_ERROR)
+    {
+      setZlibError(tr("Error deflating data"));
+      return false;
+    }
+
+    qint64 have = CHUNK_SIZE - stream.avail_out;
+    if(have > 0 && device->write(out, have) != have)
+    {
+      error = true;
+      setErrorString(device->errorString());
+      return false;
+    }
+  } while(stream.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+
+  return true;
+}
+
+void GzipDevice::setZlibError(const QString& message)
+{
+  error = true;
+  setErrorString(stream.msg != nullptr ? message + ": " + QString(stream.msg) : message);
+  qWarning() << Q_FUNC_INFO << errorString();
+}
+
+} // namespace zip
+} // namespace atools
@@ -0,0 +1,112 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ZIP_GZIPDEVICE_H
+#define ATOOLS_ZIP_GZIPDEVICE_H
+
+#include <QIODevice>
+
+#include <zlib.h>
+
+namespace atools {
+namespace zip {
+
+/*
+ * Sequential device which inflates or deflates gzip or zlib data on the fly while reading from or writing to
+ * another device. Allows parsers like XmlStream, QXmlStreamReader or line readers to consume compressed files,
+ * buffers or network replies incrementally without inflating everything into memory first.
+ *
+ * Opening for reading inflates and opening for writing deflates. Read/write mode is not supported.
+ * The underlying device has to be opened by the caller and is not closed. Closing this device finishes the
+ * compressed stream when writing.
+ *
+ * readyRead() of the underlying device is forwarded. Reading returns what can be inflated from the data
+ * available so far.
+ *
+ * Usage:
+ * QFile file("plan.lnmpln.gz");
+ * file.open(QIODevice::ReadOnly);
+ * GzipDevice gzip(&file);
+ * gzip.open(QIODevice::ReadOnly);
+ * XmlStream xmlStream(&gzip);
+ */
+class GzipDevice :
+  public QIODevice
+{
+  Q_OBJECT
+
+public:
+  enum Format
+  {
+    GZIP, /* RFC 1952 with header and CRC */
+    ZLIB, /* RFC 1950 as used by qCompress() without the size prefix */
+    AUTO /* Detect gzip or zlib when reading. Same as GZIP when writing. */
+  };
+
+  /*
+   * @param sourceDevice Compressed data for reading or target for writing
+   * @param streamFormat Format of the compressed data
+   * @param compressionLevel 0 = no compression, 9 = max, -1 = default. Only used when writing.
+   */
+  explicit GzipDevice(QIODevice *sourceDevice, Format streamFormat = AUTO, int compressionLevel = -1,
+                      QObject *parent = nullptr);
+  virtual ~GzipDevice() override;
+
+  GzipDevice(const GzipDevice& other) = delete;
+  GzipDevice& operator=(const GzipDevice& other) = delete;
+
+  virtual bool open(QIODevice::OpenMode mode) override;
+  virtual void close() override;
+
+  virtual bool isSequential() const override
+  {
+    return true;
+  }
+
+  /* true if the compressed stream is complete or the underlying device has no more data */
+  virtual bool atEnd() const override;
+
+  /* true if the data was corrupt or could not be written */
+  bool hasError() const
+  {
+    return error;
+  }
+
+protected:
+  virtual qint64 readData(char *data, qint64 maxSize) override;
+  virtual qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+  /* Deflate pending input and write output to the device */
+  bool deflateToDevice(int flush);
+  void setZlibError(const QString& message);
+
+  QIODevice *device;
+  Format format;
+  int level;
+
+  z_stream stream;
+  bool initialized = false, streamEnd = false, error = false;
+
+  /* Compressed input buffer for reading. Referenced by stream.next_in. */
+  QByteArray inBuffer;
+};
+
+} // namespace zip
+} // namespace atools
+
+#endif // ATOOLS_ZIP_GZIPDEVICE_H
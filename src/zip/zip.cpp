@@ -40,6 +40,15 @@
 #include <QDateTime>
 #include <QtEndian>
 #include <QDir>
+#include <QHash>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #if defined(Q_CC_MSVC)
 #include <QtZlib/zlib.h>
@@ -51,6 +60,12 @@
 // (actually, the only basic support of this version is implemented but it is enough for now)
 #define ZIP_VERSION 20
 
+// Entries larger than this are split into blocks which are compressed in parallel
+#define PARALLEL_BLOCK_SIZE (1024 * 1024)
+
+// Wait for compression before adding more entries if their size exceeds this
+#define PARALLEL_MAX_PENDING_BYTES (Q_INT64_C(256) * 1024 * 1024)
+
 #if 0
 #define ZDEBUG qDebug
 #else
@@ -164,35 +179,39 @@ static int inflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourc
   return err;
 }
 
-static int deflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
+/* Raw deflate of one block. A block which is not the last one ends with a sync flush on a byte boundary
+ * and without the final bit. This allows to compress blocks independently and concatenate them
+ * to one valid deflate stream. */
+static int deflateBlock(QByteArray& dest, const char *source, int sourceLen, int level, bool last)
 {
   z_stream stream;
-  int err;
+  memset(&stream, 0, sizeof(z_stream));
 
-  stream.next_in = const_cast<Bytef *>(source);
-  stream.avail_in = (uInt)sourceLen;
-  stream.next_out = dest;
-  stream.avail_out = (uInt) * destLen;
-  if((uLong)stream.avail_out != *destLen)
-    return Z_BUF_ERROR;
-
-  stream.zalloc = (alloc_func)0;
-  stream.zfree = (free_func)0;
-  stream.opaque = (voidpf)0;
-
-  err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  int err = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
   if(err != Z_OK)
     return err;
 
-  err = deflate(&stream, Z_FINISH);
-  if(err != Z_STREAM_END)
+  // Sync flush adds an empty stored block of five bytes
+  dest.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(sourceLen))) + 16);
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(source));
+  stream.avail_in = static_cast<uInt>(sourceLen);
+  stream.next_out = reinterpret_cast<Bytef *>(dest.data());
+  stream.avail_out = static_cast<uInt>(dest.size());
+
+  err = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  if(err == (last ? Z_STREAM_END : Z_OK) && stream.avail_in == 0 && stream.avail_out > 0)
   {
-    deflateEnd(&stream);
-    return err == Z_OK ? Z_BUF_ERROR : err;
+    dest.resize(static_cast<int>(stream.total_out));
+    err = Z_OK;
+  }
+  else
+  {
+    dest.clear();
+    if(err == Z_OK || err == Z_STREAM_END)
+      err = Z_BUF_ERROR;
   }
-  *destLen = stream.total_out;
 
-  err = deflateEnd(&stream);
+  deflateEnd(&stream);
   return err;
 }
 
@@ -556,7 +575,85 @@ public:
 
   void scanFiles();
 
+  /* Get the raw, possibly compressed, data of an entry. data points into the mapped file or into buffer
+   * if the file is not mapped. */
+  bool rawEntryData(int index, const char *& data, int& compressedSize, int& uncompressedSize, int& method,
+                    QByteArray& buffer);
+
   ZipReader::Status status;
+
+  /* Start of the mapped archive or null if not mapped */
+  const char *mappedData = nullptr;
+  qint64 mappedSize = 0;
+
+  /* Index into fileHeaders by file name as used by fileData() */
+  QHash<QString, int> nameIndex;
+};
+
+/* Entry which is compressed in blocks by the thread pool. Blocks are written in order once all are done. */
+struct ZipPendingEntry
+{
+  FileHeader header;
+  QByteArray contents;
+  bool compress;
+  int level, blockSize;
+
+  /* Compressed data and checksum for each block */
+  std::vector<QByteArray> blocks;
+  std::vector<uint> crcs;
+
+  /* Released once per finished block */
+  QSemaphore done;
+
+  int numBlocks() const
+  {
+    return static_cast<int>(blocks.size());
+  }
+
+  int blockLength(int block) const
+  {
+    return std::min(blockSize, contents.size() - block * blockSize);
+  }
+
+  void compressBlock(int block);
+};
+
+void ZipPendingEntry::compressBlock(int block)
+{
+  const char *data = contents.constData() + block * blockSize;
+  int len = blockLength(block);
+  crcs[static_cast<size_t>(block)] = ::crc32(::crc32(0, 0, 0), reinterpret_cast<const Bytef *>(data), len);
+
+  if(compress)
+  {
+    int res = deflateBlock(blocks[static_cast<size_t>(block)], data, len, level, block == numBlocks() - 1);
+    if(res == Z_MEM_ERROR)
+      qWarning("Zip: Z_MEM_ERROR: Not enough memory to compress file, skipping");
+    else if(res != Z_OK)
+      qWarning("Zip: Error %d compressing file, skipping", res);
+  }
+  done.release();
+}
+
+/* Compresses one block of a pending entry in the thread pool */
+class ZipBlockJob :
+  public QRunnable
+{
+public:
+  ZipBlockJob(const std::shared_ptr<ZipPendingEntry>& entryParam, int blockParam)
+    : entry(entryParam), block(blockParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    entry->compressBlock(block);
+  }
+
+private:
+  std::shared_ptr<ZipPendingEntry> entry;
+  int block;
 };
 
 class ZipWriterPrivate :
@@ -570,9 +667,21 @@ public:
   {
   }
 
+  ~ZipWriterPrivate()
+  {
+    threadPool.waitForDone();
+  }
+
   ZipWriter::Status status;
   QFile::Permissions permissions;
   ZipWriter::CompressionPolicy compressionPolicy;
+  int compressionLevel = Z_DEFAULT_COMPRESSION;
+  int threadCount = 1;
+
+  /* Entries waiting for compression in parallel mode and the size of their contents */
+  QList<std::shared_ptr<ZipPendingEntry> > pendingEntries;
+  qint64 pendingBytes = 0;
+  QThreadPool threadPool;
 
   enum EntryType
   {
@@ -581,6 +690,12 @@ public:
 
   void addEntry(EntryType type, const QString& fileName, const QByteArray& contents);
 
+  /* Write finished pending entries in order. Waits for all if wait is true. */
+  void writePendingEntries(bool wait);
+
+private:
+  void writeEntry(ZipPendingEntry& entry);
+
 };
 
 LocalFileHeader CentralFileHeader::toLocalHeader() const
@@ -706,6 +821,85 @@ void ZipReaderPrivate::scanFiles()
     ZDEBUG("found file '%s'", header.file_name.constData());
     fileHeaders.append(header);
   }
+
+  // Keep the first entry for duplicate names
+  nameIndex.clear();
+  nameIndex.reserve(fileHeaders.size());
+  for(i = 0; i < fileHeaders.size(); i++)
+  {
+    QString name = QString::fromLocal8Bit(fileHeaders.at(i).file_name);
+    if(!nameIndex.contains(name))
+      nameIndex.insert(name, i);
+  }
+}
+
+bool ZipReaderPrivate::rawEntryData(int index, const char *& data, int& compressedSize, int& uncompressedSize,
+                                    int& method, QByteArray& buffer)
+{
+  const FileHeader& header = fileHeaders.at(index);
+
+  ushort version_needed = readUShort(header.h.version_needed);
+  if(version_needed > ZIP_VERSION)
+  {
+    qWarning("Zip: .ZIP specification version %d implementationis needed to extract the data.",
+             version_needed);
+    status = ZipReader::FileNotSupported;
+    return false;
+  }
+
+  ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
+  if((general_purpose_bits & Encrypted) != 0)
+  {
+    qWarning("Zip: Unsupported encryption method is needed to extract the data.");
+    status = ZipReader::FileEncryptionMethodNotSupported;
+    return false;
+  }
+
+  compressedSize = readUInt(header.h.compressed_size);
+  uncompressedSize = readUInt(header.h.uncompressed_size);
+  qint64 start = readUInt(header.h.offset_local_header);
+
+  LocalFileHeader lh;
+  if(mappedData != nullptr)
+  {
+    if(start + qint64(sizeof(LocalFileHeader)) > mappedSize)
+    {
+      status = ZipReader::FileCorrupted;
+      return false;
+    }
+    memcpy(&lh, mappedData + start, sizeof(LocalFileHeader));
+
+    qint64 dataStart = start + sizeof(LocalFileHeader) + readUShort(lh.file_name_length) +
+                       readUShort(lh.extra_field_length);
+    if(compressedSize < 0 || dataStart + compressedSize > mappedSize)
+    {
+      qWarning("Zip: Entry %d exceeds the archive size", index);
+      status = ZipReader::FileCorrupted;
+      return false;
+    }
+    data = mappedData + dataStart;
+  }
+  else
+  {
+    device->seek(start);
+    device->read((char *)&lh, sizeof(LocalFileHeader));
+    uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
+    device->seek(device->pos() + skip);
+
+    buffer = device->read(compressedSize);
+    buffer.truncate(compressedSize);
+    compressedSize = buffer.size();
+    data = buffer.constData();
+  }
+
+  method = readUShort(lh.compression_method);
+  if(method != CompressionMethodStored && method != CompressionMethodDeflated)
+  {
+    qWarning("Zip: Unsupported compression method %d is needed to extract the data.", method);
+    status = ZipReader::FileEncryptionMethodNotSupported;
+    return false;
+  }
+  return true;
 }
 
 void ZipWriterPrivate::addEntry(EntryType type, const QString& fileName, const QByteArray& contents /*, QFile::Permissions permissions, QZip::Method m*/)
@@ -726,7 +920,6 @@ void ZipWriterPrivate::addEntry(EntryType type, const QString& fileName, const Q
     status = ZipWriter::FileOpenError;
     return;
   }
-  device->seek(start_of_directory);
 
   // don't compress small files
   ZipWriter::CompressionPolicy compression = compressionPolicy;
@@ -745,42 +938,6 @@ void ZipWriterPrivate::addEntry(EntryType type, const QString& fileName, const Q
   writeUShort(header.h.version_needed, ZIP_VERSION);
   writeUInt(header.h.uncompressed_size, contents.length());
   writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
-  QByteArray data = contents;
-  if(compression == ZipWriter::AlwaysCompress)
-  {
-    writeUShort(header.h.compression_method, CompressionMethodDeflated);
-
-    ulong len = contents.length();
-    // shamelessly copied form zlib
-    len += (len >> 12) + (len >> 14) + 11;
-    int res;
-    do
-    {
-      data.resize(len);
-      res = deflate((uchar *)data.data(), &len, (const uchar *)contents.constData(), contents.length());
-
-      switch(res)
-      {
-        case Z_OK:
-          data.resize(len);
-          break;
-        case Z_MEM_ERROR:
-          qWarning("Zip: Z_MEM_ERROR: Not enough memory to compress file, skipping");
-          data.resize(0);
-          break;
-        case Z_BUF_ERROR:
-          len *= 2;
-          break;
-      }
-    } while(res == Z_BUF_ERROR);
-  }
-  // TODO add a check if data.length() > contents.length().
-  // Then try to store the original and revert the compression method to be uncompressed
-  writeUInt(header.h.compressed_size, data.length());
-  uint crc_32 = ::crc32(0, 0, 0);
-  crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
-  writeUInt(header.h.crc_32, crc_32);
-
   // if bit 11 is set, the filename and comment fields must be encoded using UTF-8
   ushort general_purpose_bits = Utf8Names; // always use utf-8
   writeUShort(header.h.general_purpose_bits, general_purpose_bits);
@@ -820,10 +977,110 @@ void ZipWriterPrivate::addEntry(EntryType type, const QString& fileName, const Q
       break;
   }
   writeUInt(header.h.external_file_attributes, mode << 16);
+
+  std::shared_ptr<ZipPendingEntry> entry(new ZipPendingEntry);
+  entry->header = header;
+  entry->contents = contents;
+  entry->compress = compression == ZipWriter::AlwaysCompress;
+  entry->level = compressionLevel;
+
+  if(threadCount == 1)
+  {
+    // Compress in one block in this thread
+    entry->blockSize = std::max(contents.size(), 1);
+    entry->blocks.resize(1);
+    entry->crcs.resize(1);
+    entry->compressBlock(0);
+    writeEntry(*entry);
+  }
+  else
+  {
+    // Large entries are split into independent blocks - small ones are compressed in one job
+    entry->blockSize = PARALLEL_BLOCK_SIZE;
+    int numBlocks = std::max((contents.size() + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE, 1);
+    entry->blocks.resize(static_cast<size_t>(numBlocks));
+    entry->crcs.resize(static_cast<size_t>(numBlocks));
+
+    pendingEntries.append(entry);
+    pendingBytes += contents.size();
+    for(int block = 0; block < numBlocks; block++)
+      threadPool.start(new ZipBlockJob(entry, block));
+
+    writePendingEntries(false);
+
+    // Limit memory usage if entries are added faster than compressed
+    while(!pendingEntries.isEmpty() &&
+          (pendingBytes > PARALLEL_MAX_PENDING_BYTES || pendingEntries.size() > threadPool.maxThreadCount() * 4))
+    {
+      pendingEntries.constFirst()->done.acquire(pendingEntries.constFirst()->numBlocks());
+      writePendingEntries(false);
+    }
+  }
+}
+
+void ZipWriterPrivate::writePendingEntries(bool wait)
+{
+  while(!pendingEntries.isEmpty())
+  {
+    std::shared_ptr<ZipPendingEntry> entry = pendingEntries.constFirst();
+    if(wait)
+      entry->done.acquire(entry->numBlocks());
+    else if(!entry->done.tryAcquire(entry->numBlocks()))
+      break;
+
+    pendingEntries.removeFirst();
+    pendingBytes -= entry->contents.size();
+    writeEntry(*entry);
+  }
+}
+
+void ZipWriterPrivate::writeEntry(ZipPendingEntry& entry)
+{
+  FileHeader& header = entry.header;
+
+  uint crc_32 = entry.crcs.front();
+  for(int block = 1; block < entry.numBlocks(); block++)
+    crc_32 = ::crc32_combine(crc_32, entry.crcs[static_cast<size_t>(block)], entry.blockLength(block));
+  writeUInt(header.h.crc_32, crc_32);
+
+  QByteArray data;
+  bool compressed = entry.compress;
+  if(compressed)
+  {
+    for(const QByteArray& block : entry.blocks)
+    {
+      if(block.isEmpty())
+        // Compression failed
+        return;
+    }
+
+    if(entry.numBlocks() == 1)
+      data = entry.blocks.front();
+    else
+    {
+      int size = 0;
+      for(const QByteArray& block : entry.blocks)
+        size += block.size();
+      data.reserve(size);
+      for(const QByteArray& block : entry.blocks)
+        data.append(block);
+    }
+
+    // Store the original if compression does not pay off
+    if(compressionPolicy == ZipWriter::AutoCompress && data.size() >= entry.contents.size())
+      compressed = false;
+  }
+
+  if(!compressed)
+    data = entry.contents;
+
+  writeUShort(header.h.compression_method, compressed ? CompressionMethodDeflated : CompressionMethodStored);
+  writeUInt(header.h.compressed_size, data.length());
   writeUInt(header.h.offset_local_header, start_of_directory);
 
   fileHeaders.append(header);
 
+  device->seek(start_of_directory);
   LocalFileHeader h = header.h.toLocalHeader();
   device->write((const char *)&h, sizeof(LocalFileHeader));
   device->write(header.file_name);
@@ -1019,70 +1276,50 @@ ZipReader::FileInfo ZipReader::entryInfoAt(int index) const
  */
 QByteArray ZipReader::fileData(const QString& fileName) const
 {
-  d->scanFiles();
-  int i;
-  for(i = 0; i < d->fileHeaders.size(); i++)
-  {
-    if(QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
-      break;
-  }
-  if(i == d->fileHeaders.size())
+  int index = indexOf(fileName);
+  if(index == -1)
     return QByteArray();
 
-  FileHeader header = d->fileHeaders.at(i);
+  return fileData(index);
+}
 
-  ushort version_needed = readUShort(header.h.version_needed);
-  if(version_needed > ZIP_VERSION)
-  {
-    qWarning("Zip: .ZIP specification version %d implementationis needed to extract the data.",
-             version_needed);
-    d->status = FileNotSupported;
+/*!
+ *   Fetch the contents of the entry at \a index and return the uncompressed bytes.
+ *
+ *   \sa indexOf()
+ */
+QByteArray ZipReader::fileData(int index) const
+{
+  d->scanFiles();
+  if(index < 0 || index >= d->fileHeaders.size())
     return QByteArray();
-  }
-
-  ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
-  int compressed_size = readUInt(header.h.compressed_size);
-  int uncompressed_size = readUInt(header.h.uncompressed_size);
-  int start = readUInt(header.h.offset_local_header);
-  // qDebug("uncompressing file %d: local header at %d", i, start);
 
-  d->device->seek(start);
-  LocalFileHeader lh;
-  d->device->read((char *)&lh, sizeof(LocalFileHeader));
-  uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
-  d->device->seek(d->device->pos() + skip);
-
-  int compression_method = readUShort(lh.compression_method);
-  // qDebug("file=%s: compressed_size=%d, uncompressed_size=%d", fileName.toLocal8Bit().data(), compressed_size, uncompressed_size);
-
-  if((general_purpose_bits & Encrypted) != 0)
-  {
-    qWarning("Zip: Unsupported encryption method is needed to extract the data.");
-    d->status = FileEncryptionMethodNotSupported;
+  const char *data;
+  int compressed_size, uncompressed_size, compression_method;
+  QByteArray compressed;
+  if(!d->rawEntryData(index, data, compressed_size, uncompressed_size, compression_method, compressed))
     return QByteArray();
-  }
 
-  // qDebug("file at %lld", d->device->pos());
-  QByteArray compressed = d->device->read(compressed_size);
   if(compression_method == CompressionMethodStored)
   {
     // no compression
+    if(data != compressed.constData())
+      // Copy from mapped file
+      return QByteArray(data, std::min(compressed_size, uncompressed_size));
+
     compressed.truncate(uncompressed_size);
     return compressed;
   }
-  else if(compression_method == CompressionMethodDeflated)
+  else
   {
     // Deflate
-    // qDebug("compressed=%d", compressed.size());
-    compressed.truncate(compressed_size);
     QByteArray baunzip;
     ulong len = qMax(uncompressed_size, 1);
     int res;
     do
     {
       baunzip.resize(len);
-      res = inflate((uchar *)baunzip.data(), &len,
-                    (const uchar *)compressed.constData(), compressed_size);
+      res = inflate((uchar *)baunzip.data(), &len, (const uchar *)data, compressed_size);
 
       switch(res)
       {
@@ -1105,10 +1342,129 @@ QByteArray ZipReader::fileData(const QString& fileName) const
     } while(res == Z_BUF_ERROR);
     return baunzip;
   }
+}
+
+/*!
+ *   Decompress the entry at \a index into the caller provided \a buffer of \a bufferSize bytes.
+ *   Avoids allocations when reading many entries into the same buffer.
+ *
+ *   Returns the number of bytes written or -1 on error or if the buffer is too small.
+ *   The needed size is given by FileInfo::size.
+ *
+ *   \sa entryInfoAt()
+ */
+qint64 ZipReader::fileData(int index, char *buffer, qint64 bufferSize) const
+{
+  d->scanFiles();
+  if(index < 0 || index >= d->fileHeaders.size())
+    return -1;
+
+  const char *data;
+  int compressed_size, uncompressed_size, compression_method;
+  QByteArray compressed;
+  if(!d->rawEntryData(index, data, compressed_size, uncompressed_size, compression_method, compressed))
+    return -1;
 
-  qWarning("Zip: Unsupported compression method %d is needed to extract the data.", compression_method);
-  d->status = FileEncryptionMethodNotSupported;
-  return QByteArray();
+  if(uncompressed_size > bufferSize)
+    return -1;
+
+  if(compression_method == CompressionMethodStored)
+  {
+    qint64 size = std::min(compressed_size, uncompressed_size);
+    memcpy(buffer, data, static_cast<size_t>(size));
+    return size;
+  }
+  else
+  {
+    ulong len = static_cast<ulong>(bufferSize);
+    int res = inflate(reinterpret_cast<Bytef *>(buffer), &len, reinterpret_cast<const Bytef *>(data), compressed_size);
+    if(res == Z_OK)
+      return static_cast<qint64>(len);
+
+    if(res == Z_MEM_ERROR)
+      d->status = MemoryError;
+    else if(res == Z_DATA_ERROR)
+      d->status = FileCorrupted;
+    return -1;
+  }
+}
+
+/*!
+ *   Returns the contents of the entry at \a index without copying if the archive is mapped
+ *   and the entry is stored without compression. The returned array points into the mapped
+ *   file and is valid until close() is called or the reader is deleted.
+ *
+ *   Compressed entries or entries of archives which are not mapped are returned like fileData().
+ *
+ *   \sa map()
+ */
+QByteArray ZipReader::fileDataNoCopy(int index) const
+{
+  d->scanFiles();
+  if(index < 0 || index >= d->fileHeaders.size())
+    return QByteArray();
+
+  if(d->mappedData != nullptr &&
+     readUShort(d->fileHeaders.at(index).h.compression_method) == CompressionMethodStored)
+  {
+    const char *data;
+    int compressed_size, uncompressed_size, compression_method;
+    QByteArray buffer;
+    if(!d->rawEntryData(index, data, compressed_size, uncompressed_size, compression_method, buffer))
+      return QByteArray();
+
+    if(compression_method == CompressionMethodStored)
+      return QByteArray::fromRawData(data, std::min(compressed_size, uncompressed_size));
+  }
+  return fileData(index);
+}
+
+/*!
+ *   Returns the index of the entry with \a fileName or -1 if not found.
+ *   Uses a hash which is built when reading the directory.
+ */
+int ZipReader::indexOf(const QString& fileName) const
+{
+  d->scanFiles();
+  return d->nameIndex.value(fileName, -1);
+}
+
+/*!
+ *   Maps the archive file into memory. Entries are then decompressed directly from the mapping
+ *   without seeking and reading the device, and stored entries can be accessed without copying
+ *   using fileDataNoCopy().
+ *
+ *   Returns \c false if the device is not an open file or if mapping failed. The reader falls back
+ *   to reading the device in this case.
+ */
+bool ZipReader::map()
+{
+  if(d->mappedData != nullptr)
+    return true;
+
+  QFile *file = qobject_cast<QFile *>(d->device);
+  if(file == nullptr || !file->isOpen() || file->size() <= 0)
+    return false;
+
+  uchar *data = file->map(0, file->size());
+  if(data == nullptr)
+  {
+    qWarning() << "Zip: Cannot map" << file->fileName() << file->errorString();
+    return false;
+  }
+
+  d->mappedData = reinterpret_cast<const char *>(data);
+  d->mappedSize = file->size();
+  return true;
+}
+
+/*!
+ *   Returns \c true if the archive file is mapped into memory.
+ *   \sa map()
+ */
+bool ZipReader::isMapped() const
+{
+  return d->mappedData != nullptr;
 }
 
 /*!
@@ -1201,6 +1557,9 @@ ZipReader::Status ZipReader::status() const
  */
 void ZipReader::close()
 {
+  // Closing the file removes the mapping
+  d->mappedData = nullptr;
+  d->mappedSize = 0;
   d->device->close();
 }
 
@@ -1344,6 +1703,59 @@ ZipWriter::CompressionPolicy ZipWriter::compressionPolicy() const
   return d->compressionPolicy;
 }
 
+/*!
+ *   Sets the deflate \a level for newly added files. Ranges from 0 (no compression)
+ *   to 9 (best compression). -1 uses the zlib default which is 6.
+ *
+ *   Lower levels are considerably faster for large files like logbook or userdata exports.
+ *
+ *   \sa compressionLevel()
+ *   \sa setCompressionPolicy()
+ */
+void ZipWriter::setCompressionLevel(int level)
+{
+  d->compressionLevel = qBound(-1, level, 9);
+}
+
+/*!
+ *    Returns the currently set compression level.
+ *   \sa setCompressionLevel()
+ */
+int ZipWriter::compressionLevel() const
+{
+  return d->compressionLevel;
+}
+
+/*!
+ *   Sets the number of threads used to compress files. 1 compresses in the calling thread
+ *   which is the default. 0 uses one thread per core.
+ *
+ *   With more than one thread addFile() only queues the file and returns. Files larger than
+ *   one megabyte are split into blocks which are compressed independently. Blocks are joined
+ *   to one deflate stream, so the archive can be read by any unzip tool. Local headers and the
+ *   central directory are written in the order the files were added.
+ *
+ *   Memory usage is limited by blocking in addFile() if too many files are waiting for compression.
+ *   Change this before adding the first file.
+ *
+ *   \sa threadCount()
+ */
+void ZipWriter::setThreadCount(int numThreads)
+{
+  d->writePendingEntries(true);
+  d->threadCount = numThreads <= 0 ? QThread::idealThreadCount() : numThreads;
+  d->threadPool.setMaxThreadCount(d->threadCount);
+}
+
+/*!
+ *    Returns the number of threads used to compress files.
+ *   \sa setThreadCount()
+ */
+int ZipWriter::threadCount() const
+{
+  return d->threadCount;
+}
+
 /*!
  *   Sets the permissions that will be used for newly added files.
  *
@@ -1445,6 +1857,9 @@ void ZipWriter::close()
     return;
   }
 
+  // Wait for all files queued for compression
+  d->writePendingEntries(true);
+
   // qDebug("Zip::close writing directory, %d entries", d->fileHeaders.size());
   d->device->seek(d->start_of_directory);
   // write new directory
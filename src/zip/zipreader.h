@@ -85,7 +85,15 @@ public:
   int count() const;
 
   FileInfo entryInfoAt(int index) const;
+  int indexOf(const QString& fileName) const;
+
   QByteArray fileData(const QString& fileName) const;
+  QByteArray fileData(int index) const;
+  qint64 fileData(int index, char *buffer, qint64 bufferSize) const;
+  QByteArray fileDataNoCopy(int index) const;
+
+  bool map();
+  bool isMapped() const;
   bool extractAll(const QString& destinationDir) const;
 
   enum Status
@@ -77,6 +77,12 @@ public:
   void setCompressionPolicy(CompressionPolicy policy);
   CompressionPolicy compressionPolicy() const;
 
+  void setCompressionLevel(int level);
+  int compressionLevel() const;
+
+  void setThreadCount(int numThreads);
+  int threadCount() const;
+
   void setCreationPermissions(QFile::Permissions permissions);
   QFile::Permissions creationPermissions() const;
 